@@ -10,11 +10,33 @@
 
 #include <common/macros.hpp>
 
+#include <lttng/channel.h>
+
 struct lttng_channel_extended {
 	uint64_t discarded_events;
 	uint64_t lost_packets;
 	uint64_t monitor_timer_interval;
 	int64_t blocking_timeout;
+	/* enum lttng_channel_writeback_policy */
+	uint8_t writeback_policy;
+	/* Bytes, only used by LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW. */
+	uint64_t writeback_window_size;
+	/* 0 is equivalent to 1. */
+	uint32_t drain_max_subbuffers;
+	/* Bytes, 0 for no limit. */
+	uint64_t drain_max_bytes;
+	/* Microseconds. */
+	uint64_t consumption_latency_histogram[LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT];
+	/* Bytes. */
+	uint64_t consumption_size_histogram[LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT];
+	/* Bytes, 0 when the channel's streams are not spliced. */
+	uint64_t splice_pipe_size;
+	/* Bytes. */
+	uint64_t relayd_spilled_size;
+	/* enum lttng_channel_buffer_page_size */
+	uint8_t buffer_page_size;
+	/* Bytes, only set for the listed channels. */
+	uint64_t effective_buffer_page_size;
 } LTTNG_PACKED;
 
 struct lttng_channel_comm {
@@ -38,6 +60,16 @@ struct lttng_channel_comm {
 	uint64_t lost_packets;
 	uint64_t monitor_timer_interval;
 	int64_t blocking_timeout;
+	uint8_t writeback_policy;
+	uint64_t writeback_window_size;
+	uint32_t drain_max_subbuffers;
+	uint64_t drain_max_bytes;
+	uint64_t consumption_latency_histogram[LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT];
+	uint64_t consumption_size_histogram[LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT];
+	uint64_t splice_pipe_size;
+	uint64_t relayd_spilled_size;
+	uint8_t buffer_page_size;
+	uint64_t effective_buffer_page_size;
 } LTTNG_PACKED;
 
 struct lttng_channel *lttng_channel_create_internal();
@@ -18,6 +18,39 @@
 extern "C" {
 #endif
 
+/*
+ * Number of buckets of the consumption histograms of a channel.
+ *
+ * Bucket `i` of a histogram counts the sub-buffers for which the measured
+ * value is within [2^i, 2^(i+1)). Bucket 0 also counts the value 0 and the
+ * last bucket also counts any larger value.
+ */
+#define LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT 32
+
+/*
+ * Policy used by the consumer daemon to bound the amount of trace data of a
+ * channel that is written to the page cache of local trace files but not yet
+ * written back to disk.
+ */
+enum lttng_channel_writeback_policy {
+	/* Wait for the writeback of the previous sub-buffer after each write. */
+	LTTNG_CHANNEL_WRITEBACK_POLICY_SYNC = 0,
+	/* Only wait once the data pending writeback exceeds a window size. */
+	LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW = 1,
+	/* Leave the writeback to the kernel. */
+	LTTNG_CHANNEL_WRITEBACK_POLICY_NONE = 2,
+};
+
+/*
+ * Size of the pages on which the ring buffers of a channel are allocated.
+ */
+enum lttng_channel_buffer_page_size {
+	/* Base pages of the system. */
+	LTTNG_CHANNEL_BUFFER_PAGE_SIZE_BASE = 0,
+	/* Transparent huge pages. Only supported by the user space domain. */
+	LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE = 1,
+};
+
 /*
  * Tracer channel attributes. For both kernel and user-space.
  *
@@ -135,6 +168,145 @@ LTTNG_EXPORT extern int lttng_channel_get_blocking_timeout(struct lttng_channel
 LTTNG_EXPORT extern int lttng_channel_set_blocking_timeout(struct lttng_channel *chan,
 							   int64_t blocking_timeout);
 
+/*
+ * Get the writeback policy of a channel and, for the
+ * LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW policy, its window size in
+ * bytes.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int
+lttng_channel_get_writeback_policy(struct lttng_channel *chan,
+				   enum lttng_channel_writeback_policy *policy,
+				   uint64_t *window_size);
+
+/*
+ * Set the writeback policy of a channel. The window size, in bytes, must be
+ * greater than 0 for the LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW policy
+ * and is ignored otherwise.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int
+lttng_channel_set_writeback_policy(struct lttng_channel *chan,
+				   enum lttng_channel_writeback_policy policy,
+				   uint64_t window_size);
+
+/*
+ * Get the maximum number of sub-buffers and the maximum number of bytes the
+ * consumer daemon consumes from a stream of a channel each time the stream is
+ * found ready, before going back to waiting for data. A maximum byte count of
+ * 0 means that only the sub-buffer count is bounded.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_get_drain_batch(struct lttng_channel *chan,
+						      uint32_t *max_subbuffers,
+						      uint64_t *max_bytes);
+
+/*
+ * Set the maximum number of sub-buffers, which must be greater than 0, and the
+ * maximum number of bytes (0 for no limit) the consumer daemon consumes from a
+ * stream of a channel each time the stream is found ready.
+ *
+ * The default, one sub-buffer, lets the consumer daemon go back to waiting for
+ * data after each sub-buffer. Larger batches save wakeups under sustained
+ * load at the expense of fairness between streams.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_set_drain_batch(struct lttng_channel *chan,
+						      uint32_t max_subbuffers,
+						      uint64_t max_bytes);
+
+/*
+ * Get the histogram of the latency, in microseconds, between the moment the
+ * consumer daemon is woken up by a sub-buffer of a channel becoming ready and
+ * the moment this sub-buffer is written to its trace file or sent to the relay
+ * daemon.
+ *
+ * `buckets` must point to LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT
+ * elements. Only the channels returned by lttng_list_channels() hold
+ * consumption histograms.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int
+lttng_channel_get_consumption_latency_histogram(struct lttng_channel *chan, uint64_t *buckets);
+
+/*
+ * Get the histogram of the number of bytes written or sent by the consumer
+ * daemon for each consumed sub-buffer of a channel.
+ *
+ * `buckets` must point to LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT
+ * elements. Only the channels returned by lttng_list_channels() hold
+ * consumption histograms.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_get_consumption_size_histogram(struct lttng_channel *chan,
+								     uint64_t *buckets);
+
+/*
+ * Get the capacity, in bytes, of the pipes through which the kernel consumer
+ * daemon splices the sub-buffers of a channel to its trace files or to the
+ * relay daemon.
+ *
+ * The consumer daemon grows each pipe to hold a full sub-buffer when allowed
+ * to; `size` is the smallest pipe of the channel's streams. It is 0 when the
+ * channel's output is not "splice" or the session was not started. Only the
+ * channels returned by lttng_list_channels() hold this value.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_get_splice_pipe_size(struct lttng_channel *chan,
+							   uint64_t *size);
+
+/*
+ * Get the number of bytes of the packets of a channel which the consumer
+ * daemon appended to a local spill file, rather than blocking, because their
+ * relay daemon data connection was congested. They are sent to the relay
+ * daemon once the connection drains.
+ *
+ * Spilling is enabled by the LTTNG_CONSUMERD_RELAYD_SPILL_DIR environment
+ * variable of the consumer daemon. Only the channels returned by
+ * lttng_list_channels() hold this value.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int lttng_channel_get_relayd_spilled_size(struct lttng_channel *chan,
+							      uint64_t *size);
+
+/*
+ * Get the page size on which the ring buffers of a channel are allocated and,
+ * for the channels returned by lttng_list_channels(), its effective value in
+ * bytes. `size` is 0 for the other channels.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int
+lttng_channel_get_buffer_page_size(struct lttng_channel *chan,
+				   enum lttng_channel_buffer_page_size *page_size,
+				   uint64_t *size);
+
+/*
+ * Set the page size on which the ring buffers of a channel are allocated.
+ *
+ * With LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE, the sub-buffer size of the channel
+ * must be at least the transparent huge page size of the system. The consumer
+ * daemon allocates the buffers as shared memory for which it requests
+ * transparent huge pages: the kernel only provides them when its shared memory
+ * huge page policy allows it
+ * (`/sys/kernel/mm/transparent_hugepage/shmem_enabled`, or the `huge` mount
+ * option of the file system of the session's shared memory path) and falls
+ * back to base pages otherwise.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+LTTNG_EXPORT extern int
+lttng_channel_set_buffer_page_size(struct lttng_channel *chan,
+				   enum lttng_channel_buffer_page_size page_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -52,16 +52,19 @@ struct lttng_evaluation_buffer_usage {
 	struct lttng_evaluation parent;
 	uint64_t buffer_use;
 	uint64_t buffer_capacity;
+	uint64_t writeback_bytes_in_flight;
 };
 
 struct lttng_evaluation_buffer_usage_comm {
 	uint64_t buffer_use;
 	uint64_t buffer_capacity;
+	uint64_t writeback_bytes_in_flight;
 } LTTNG_PACKED;
 
 struct lttng_evaluation *lttng_evaluation_buffer_usage_create(enum lttng_condition_type type,
 							      uint64_t use,
-							      uint64_t capacity);
+							      uint64_t capacity,
+							      uint64_t writeback_bytes_in_flight);
 
 ssize_t lttng_condition_buffer_usage_low_create_from_payload(struct lttng_payload_view *view,
 							     struct lttng_condition **condition);
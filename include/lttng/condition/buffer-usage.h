@@ -217,9 +217,11 @@ lttng_condition_buffer_usage_set_domain_type(struct lttng_condition *condition,
  * allow users to query a number of properties resulting from the evaluation
  * of a condition which evaluated to true.
  *
- * The evaluation of a buffer usage condition yields two different results:
+ * The evaluation of a buffer usage condition yields three different results:
  *   - the usage ratio of the channel buffers at the time of the evaluation,
- *   - the usage, in bytes, of the channel buffers at the time of evaluation.
+ *   - the usage, in bytes, of the channel buffers at the time of evaluation,
+ *   - the bytes written to the trace files of the channel which the kernel
+ *     has yet to write back to storage at the time of evaluation.
  */
 
 /*
@@ -243,6 +245,19 @@ LTTNG_EXPORT extern enum lttng_evaluation_status
 lttng_evaluation_buffer_usage_get_usage(const struct lttng_evaluation *evaluation,
 					uint64_t *usage_bytes);
 
+/*
+ * Get the write-back bytes in flight property of a buffer usage evaluation:
+ * the bytes written to the trace files of the channel which the kernel has yet
+ * to write back to storage. It is 0 for the channels which don't keep a
+ * window of write-back in flight.
+ *
+ * Returns LTTNG_EVALUATION_STATUS_OK on success and a size in bytes, or
+ * LTTNG_EVALUATION_STATUS_INVALID if an invalid parameter is passed.
+ */
+LTTNG_EXPORT extern enum lttng_evaluation_status
+lttng_evaluation_buffer_usage_get_writeback_bytes_in_flight(
+	const struct lttng_evaluation *evaluation, uint64_t *bytes);
+
 #ifdef __cplusplus
 }
 #endif
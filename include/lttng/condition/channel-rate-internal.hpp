@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_CONDITION_CHANNEL_RATE_INTERNAL_H
+#define LTTNG_CONDITION_CHANNEL_RATE_INTERNAL_H
+
+#include <common/macros.hpp>
+
+#include <lttng/condition/channel-rate.h>
+#include <lttng/condition/condition-internal.hpp>
+#include <lttng/condition/evaluation-internal.hpp>
+#include <lttng/domain.h>
+
+struct lttng_condition_channel_rate {
+	struct lttng_condition parent;
+	struct {
+		bool set;
+		enum lttng_condition_channel_rate_statistic value;
+	} statistic;
+	struct {
+		bool set;
+		uint64_t value;
+	} threshold_per_second;
+	struct {
+		bool set;
+		uint64_t value;
+	} window_us;
+	char *session_name;
+	char *channel_name;
+	struct {
+		bool set;
+		enum lttng_domain_type type;
+	} domain;
+};
+
+struct lttng_condition_channel_rate_comm {
+	/* enum lttng_condition_channel_rate_statistic */
+	uint8_t statistic;
+	uint64_t threshold_per_second;
+	uint64_t window_us;
+	/* Both lengths include the trailing \0. */
+	uint32_t session_name_len;
+	uint32_t channel_name_len;
+	/* enum lttng_domain_type */
+	int8_t domain_type;
+	/* session and channel names. */
+	char names[];
+} LTTNG_PACKED;
+
+struct lttng_evaluation_channel_rate {
+	struct lttng_evaluation parent;
+	uint64_t rate_per_second;
+};
+
+struct lttng_evaluation_channel_rate_comm {
+	uint64_t rate_per_second;
+} LTTNG_PACKED;
+
+struct lttng_evaluation *lttng_evaluation_channel_rate_create(enum lttng_condition_type type,
+							      uint64_t rate_per_second);
+
+ssize_t lttng_condition_channel_rate_low_create_from_payload(struct lttng_payload_view *view,
+							     struct lttng_condition **condition);
+
+ssize_t lttng_condition_channel_rate_high_create_from_payload(struct lttng_payload_view *view,
+							      struct lttng_condition **condition);
+
+ssize_t lttng_evaluation_channel_rate_low_create_from_payload(struct lttng_payload_view *view,
+							      struct lttng_evaluation **evaluation);
+
+ssize_t
+lttng_evaluation_channel_rate_high_create_from_payload(struct lttng_payload_view *view,
+						       struct lttng_evaluation **evaluation);
+
+const char *
+lttng_condition_channel_rate_statistic_str(enum lttng_condition_channel_rate_statistic statistic);
+
+#endif /* LTTNG_CONDITION_CHANNEL_RATE_INTERNAL_H */
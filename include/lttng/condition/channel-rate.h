@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_CONDITION_CHANNEL_RATE_H
+#define LTTNG_CONDITION_CHANNEL_RATE_H
+
+#include <lttng/condition/condition.h>
+#include <lttng/condition/evaluation.h>
+#include <lttng/domain.h>
+#include <lttng/lttng-export.h>
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Channel rate conditions allow an action to be taken whenever the rate, per
+ * second, at which a statistic of a channel grows crosses a set threshold.
+ *
+ * The rate is computed over a sliding window from the statistics sampled by
+ * the channels' monitor timer: it is the growth of the statistic between the
+ * latest sample and the latest sample taken at least a window earlier,
+ * divided by the time elapsed between those samples. No rate is available,
+ * and the condition can't evaluate to true, until the samples of a channel
+ * span a whole window.
+ *
+ * As the buffer usage conditions, these conditions don't imply any
+ * hysteresis-loop mechanism: an upper-bound condition evaluates to true
+ * every time the rate goes from a value lower than the threshold to a value
+ * higher than or equal to the threshold.
+ *
+ * Channel rate conditions have the following properties:
+ *   - the exact name of the session in which the channel to be monitored is
+ *     defined,
+ *   - the domain of the channel to be monitored,
+ *   - the exact name of the channel to be monitored,
+ *   - the statistic of the channel whose rate is monitored,
+ *   - a rate threshold, expressed in units of the statistic per second,
+ *   - the duration of the sliding window over which the rate is computed.
+ *
+ * Wildcards, regular expressions or other globbing mechanisms are not supported
+ * in channel rate condition properties.
+ */
+
+enum lttng_condition_channel_rate_statistic {
+	/* Bytes consumed from the channel's buffers. */
+	LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_CONSUMED_BYTES = 0,
+	/* Events discarded because the channel's buffers were full. */
+	LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_DISCARDED_EVENTS = 1,
+	/* Packets overwritten before being consumed (overwrite mode). */
+	LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_LOST_PACKETS = 2,
+};
+
+/*
+ * Create a newly allocated lower-bound channel rate condition.
+ *
+ * A lower-bound channel rate condition evaluates to true whenever the rate of
+ * the statistic transitions from a value higher than the threshold to a value
+ * lower than or equal to the threshold, for instance when the consumption
+ * throughput of a channel drops.
+ *
+ * Returns a new condition on success, NULL on failure. This condition must be
+ * destroyed using lttng_condition_destroy().
+ */
+LTTNG_EXPORT extern struct lttng_condition *lttng_condition_channel_rate_low_create(void);
+
+/*
+ * Create a newly allocated upper-bound channel rate condition.
+ *
+ * An upper-bound channel rate condition evaluates to true whenever the rate
+ * of the statistic transitions from a value lower than the threshold to a
+ * value higher than or equal to the threshold, for instance when a channel
+ * starts discarding events.
+ *
+ * Returns a new condition on success, NULL on failure. This condition must be
+ * destroyed using lttng_condition_destroy().
+ */
+LTTNG_EXPORT extern struct lttng_condition *lttng_condition_channel_rate_high_create(void);
+
+/*
+ * Get the statistic of a channel rate condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success,
+ * LTTNG_CONDITION_STATUS_INVALID if an invalid parameter is passed, or
+ * LTTNG_CONDITION_STATUS_UNSET if a statistic was not set prior to this call.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_get_statistic(const struct lttng_condition *condition,
+					   enum lttng_condition_channel_rate_statistic *statistic);
+
+/*
+ * Set the statistic of a channel rate condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success, LTTNG_CONDITION_STATUS_INVALID
+ * if invalid parameters are passed.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_set_statistic(struct lttng_condition *condition,
+					   enum lttng_condition_channel_rate_statistic statistic);
+
+/*
+ * Get the rate threshold, in units of the statistic per second, of a channel
+ * rate condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success,
+ * LTTNG_CONDITION_STATUS_INVALID if an invalid parameter is passed, or
+ * LTTNG_CONDITION_STATUS_UNSET if a threshold was not set prior to this call.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_get_threshold(const struct lttng_condition *condition,
+					   uint64_t *threshold_per_second);
+
+/*
+ * Set the rate threshold, in units of the statistic per second, of a channel
+ * rate condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success, LTTNG_CONDITION_STATUS_INVALID
+ * if invalid parameters are passed.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_set_threshold(struct lttng_condition *condition,
+					   uint64_t threshold_per_second);
+
+/*
+ * Get the duration, in microseconds, of the sliding window over which the
+ * rate of a channel rate condition is computed.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success,
+ * LTTNG_CONDITION_STATUS_INVALID if an invalid parameter is passed, or
+ * LTTNG_CONDITION_STATUS_UNSET if a window was not set prior to this call.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_get_window(const struct lttng_condition *condition,
+					uint64_t *window_us);
+
+/*
+ * Set the duration, in microseconds, of the sliding window over which the
+ * rate of a channel rate condition is computed.
+ *
+ * The window should span several periods of the channel's monitor timer. It
+ * must not be 0.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success, LTTNG_CONDITION_STATUS_INVALID
+ * if invalid parameters are passed.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_set_window(struct lttng_condition *condition, uint64_t window_us);
+
+/*
+ * Get the session name property of a channel rate condition.
+ *
+ * The caller does not assume the ownership of the returned session name. The
+ * session name shall only be used for the duration of the condition's
+ * lifetime, or before a different session name is set.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK and a pointer to the condition's session
+ * name on success, LTTNG_CONDITION_STATUS_INVALID if an invalid
+ * parameter is passed, or LTTNG_CONDITION_STATUS_UNSET if a session name
+ * was not set prior to this call.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_get_session_name(const struct lttng_condition *condition,
+					      const char **session_name);
+
+/*
+ * Set the session name property of a channel rate condition.
+ *
+ * The passed session name parameter will be copied to the condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success, LTTNG_CONDITION_STATUS_INVALID
+ * if invalid parameters are passed.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_set_session_name(struct lttng_condition *condition,
+					      const char *session_name);
+
+/*
+ * Get the channel name property of a channel rate condition.
+ *
+ * The caller does not assume the ownership of the returned channel name. The
+ * channel name shall only be used for the duration of the condition's
+ * lifetime, or before a different channel name is set.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK and a pointer to the condition's channel
+ * name on success, LTTNG_CONDITION_STATUS_INVALID if an invalid
+ * parameter is passed, or LTTNG_CONDITION_STATUS_UNSET if a channel name
+ * was not set prior to this call.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_get_channel_name(const struct lttng_condition *condition,
+					      const char **channel_name);
+
+/*
+ * Set the channel name property of a channel rate condition.
+ *
+ * The passed channel name parameter will be copied to the condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success, LTTNG_CONDITION_STATUS_INVALID
+ * if invalid parameters are passed.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_set_channel_name(struct lttng_condition *condition,
+					      const char *channel_name);
+
+/*
+ * Get the domain type property of a channel rate condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK and sets the domain type output parameter
+ * on success, LTTNG_CONDITION_STATUS_INVALID if an invalid parameter is passed,
+ * or LTTNG_CONDITION_STATUS_UNSET if a domain type was not set prior to this
+ * call.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_get_domain_type(const struct lttng_condition *condition,
+					     enum lttng_domain_type *type);
+
+/*
+ * Set the domain type property of a channel rate condition.
+ *
+ * Returns LTTNG_CONDITION_STATUS_OK on success, LTTNG_CONDITION_STATUS_INVALID
+ * if invalid parameters are passed.
+ */
+LTTNG_EXPORT extern enum lttng_condition_status
+lttng_condition_channel_rate_set_domain_type(struct lttng_condition *condition,
+					     enum lttng_domain_type type);
+
+/**
+ * lttng_evaluation_channel_rate is specialised lttng_evaluation which
+ * allows users to query a number of properties resulting from the evaluation
+ * of a condition which evaluated to true.
+ */
+
+/*
+ * Get the rate, in units of the statistic per second, of a channel rate
+ * evaluation.
+ *
+ * Returns LTTNG_EVALUATION_STATUS_OK on success and the rate computed over the
+ * window of the condition, or LTTNG_EVALUATION_STATUS_INVALID if an invalid
+ * parameter is passed.
+ */
+LTTNG_EXPORT extern enum lttng_evaluation_status
+lttng_evaluation_channel_rate_get_rate(const struct lttng_evaluation *evaluation,
+				       uint64_t *rate_per_second);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LTTNG_CONDITION_CHANNEL_RATE_H */
@@ -43,6 +43,13 @@ struct lttng_condition {
 	condition_equal_cb equal;
 	condition_destroy_cb destroy;
 	condition_mi_serialize_cb mi_serialize;
+	/*
+	 * Hash of the condition, cached by the session daemon the first time
+	 * it hashes the condition (see lttng_condition_hash()). A condition
+	 * must not be modified once it is hashed.
+	 */
+	unsigned long hash;
+	bool hash_is_set;
 };
 
 struct lttng_condition_comm {
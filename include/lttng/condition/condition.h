@@ -24,6 +24,8 @@ enum lttng_condition_type {
 	LTTNG_CONDITION_TYPE_SESSION_ROTATION_ONGOING = 103,
 	LTTNG_CONDITION_TYPE_SESSION_ROTATION_COMPLETED = 104,
 	LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES = 105,
+	LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH = 106,
+	LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW = 107,
 };
 
 enum lttng_condition_status {
@@ -17,6 +17,9 @@
 #include <lttng/condition/evaluation-internal.hpp>
 #include <lttng/event-field-value.h>
 
+struct msgpack_object;
+struct msgpack_zone;
+
 struct lttng_capture_descriptor {
 	struct lttng_event_expr *event_expression;
 	struct lttng_bytecode *bytecode;
@@ -48,8 +51,21 @@ struct lttng_evaluation_event_rule_matches {
 	 *
 	 * This is a cache: it's not serialized/deserialized in
 	 * communications from/to the library and the session daemon.
+	 * It is built on demand from `captured_objects` below.
 	 */
 	struct lttng_event_field_value *captured_values;
+
+	/*
+	 * MessagePack objects of the captured values, one per capture
+	 * descriptor, decoded from `capture_payload` when the evaluation is
+	 * received by the library.
+	 *
+	 * They are all allocated in the `capture_zone` arena and their
+	 * strings point into `capture_payload`. Also not serialized.
+	 */
+	struct msgpack_zone *capture_zone;
+	const struct msgpack_object *captured_objects;
+	unsigned int captured_object_count;
 };
 
 ssize_t lttng_condition_event_rule_matches_create_from_payload(struct lttng_payload_view *view,
@@ -10,9 +10,13 @@
 
 #include <lttng/condition/condition.h>
 #include <lttng/condition/evaluation.h>
+#include <lttng/event-field-value.h>
 #include <lttng/event-rule/event-rule.h>
 #include <lttng/lttng-export.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -86,15 +90,190 @@ lttng_condition_event_rule_matches_get_rule(const struct lttng_condition *condit
  *     * The type of the condition of `evaluation` is not
  *       `LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES`.
  *     * `field_val` is `NULL`.
+ *     * Memory error.
  *
  * `LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_NONE`:
  *     * The condition of `evaluation` has no capture descriptors.
+ *
+ * The event field values are created on the first call. The functions
+ * below read the captured values of `evaluation` without creating them.
  */
 LTTNG_EXPORT extern enum lttng_evaluation_event_rule_matches_status
 lttng_evaluation_event_rule_matches_get_captured_values(
 	const struct lttng_evaluation *evaluation,
 	const struct lttng_event_field_value **field_val);
 
+/*
+ * Sets `*count` to the number of captured values of the Event Rule Matches
+ * condition evaluation `evaluation`, one per capture descriptor of its
+ * condition.
+ *
+ * Returns:
+ *
+ * `LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_OK`:
+ *     Success.
+ *
+ * `LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_INVALID`:
+ *     * `evaluation` is `NULL`.
+ *     * The type of the condition of `evaluation` is not
+ *       `LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES`.
+ *     * `count` is `NULL`.
+ *
+ * `LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_NONE`:
+ *     * The condition of `evaluation` has no capture descriptors.
+ */
+LTTNG_EXPORT extern enum lttng_evaluation_event_rule_matches_status
+lttng_evaluation_event_rule_matches_get_captured_value_count(
+	const struct lttng_evaluation *evaluation, unsigned int *count);
+
+/*
+ * Sets `*type` to the type of the captured value at index `index` of the
+ * Event Rule Matches condition evaluation `evaluation`, as the type of the
+ * corresponding element of its captured values would be returned by
+ * lttng_event_field_value_get_type().
+ *
+ * The elements of the array and enumeration captured values can only be
+ * read with lttng_evaluation_event_rule_matches_get_captured_values().
+ *
+ * Returns:
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_OK`:
+ *     Success.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_UNAVAILABLE`:
+ *     The captured value is not available.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID`:
+ *     * `evaluation` is `NULL`.
+ *     * The type of the condition of `evaluation` is not
+ *       `LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES`.
+ *     * `index` is greater than or equal to the captured value count of
+ *       `evaluation`, as returned by
+ *       lttng_evaluation_event_rule_matches_get_captured_value_count().
+ *     * `type` is `NULL`.
+ */
+LTTNG_EXPORT extern enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_value_type_at_index(
+	const struct lttng_evaluation *evaluation,
+	unsigned int index,
+	enum lttng_event_field_value_type *type);
+
+/*
+ * Sets `*val` to the value of the unsigned integer, or unsigned
+ * enumeration, captured value at index `index` of the Event Rule Matches
+ * condition evaluation `evaluation`.
+ *
+ * Returns:
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_OK`:
+ *     Success.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_UNAVAILABLE`:
+ *     The captured value is not available.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID`:
+ *     * `evaluation` is `NULL`.
+ *     * The type of the condition of `evaluation` is not
+ *       `LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES`.
+ *     * `index` is greater than or equal to the captured value count of
+ *       `evaluation`.
+ *     * The type of the captured value is not
+ *       `LTTNG_EVENT_FIELD_VALUE_TYPE_UNSIGNED_INT` or
+ *       `LTTNG_EVENT_FIELD_VALUE_TYPE_UNSIGNED_ENUM`.
+ *     * `val` is `NULL`.
+ */
+LTTNG_EXPORT extern enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_unsigned_int_at_index(
+	const struct lttng_evaluation *evaluation, unsigned int index, uint64_t *val);
+
+/*
+ * Sets `*val` to the value of the signed integer, or signed enumeration,
+ * captured value at index `index` of the Event Rule Matches condition
+ * evaluation `evaluation`.
+ *
+ * Returns:
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_OK`:
+ *     Success.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_UNAVAILABLE`:
+ *     The captured value is not available.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID`:
+ *     * `evaluation` is `NULL`.
+ *     * The type of the condition of `evaluation` is not
+ *       `LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES`.
+ *     * `index` is greater than or equal to the captured value count of
+ *       `evaluation`.
+ *     * The type of the captured value is not
+ *       `LTTNG_EVENT_FIELD_VALUE_TYPE_SIGNED_INT` or
+ *       `LTTNG_EVENT_FIELD_VALUE_TYPE_SIGNED_ENUM`.
+ *     * `val` is `NULL`.
+ */
+LTTNG_EXPORT extern enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_signed_int_at_index(
+	const struct lttng_evaluation *evaluation, unsigned int index, int64_t *val);
+
+/*
+ * Sets `*val` to the value of the real captured value at index `index` of
+ * the Event Rule Matches condition evaluation `evaluation`.
+ *
+ * Returns:
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_OK`:
+ *     Success.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_UNAVAILABLE`:
+ *     The captured value is not available.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID`:
+ *     * `evaluation` is `NULL`.
+ *     * The type of the condition of `evaluation` is not
+ *       `LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES`.
+ *     * `index` is greater than or equal to the captured value count of
+ *       `evaluation`.
+ *     * The type of the captured value is not
+ *       `LTTNG_EVENT_FIELD_VALUE_TYPE_REAL`.
+ *     * `val` is `NULL`.
+ */
+LTTNG_EXPORT extern enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_real_at_index(
+	const struct lttng_evaluation *evaluation, unsigned int index, double *val);
+
+/*
+ * Sets `*val` and `*len` to the characters, and their number, of the
+ * string captured value at index `index` of the Event Rule Matches
+ * condition evaluation `evaluation`.
+ *
+ * `*val` is NOT null-terminated: it points into the captured payload of
+ * `evaluation` and remains valid until `evaluation` is destroyed.
+ *
+ * Returns:
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_OK`:
+ *     Success.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_UNAVAILABLE`:
+ *     The captured value is not available.
+ *
+ * `LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID`:
+ *     * `evaluation` is `NULL`.
+ *     * The type of the condition of `evaluation` is not
+ *       `LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES`.
+ *     * `index` is greater than or equal to the captured value count of
+ *       `evaluation`.
+ *     * The type of the captured value is not
+ *       `LTTNG_EVENT_FIELD_VALUE_TYPE_STRING`.
+ *     * `val` is `NULL`.
+ *     * `len` is `NULL`.
+ */
+LTTNG_EXPORT extern enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_string_at_index(
+	const struct lttng_evaluation *evaluation,
+	unsigned int index,
+	const char **val,
+	size_t *len);
+
 /*
  * Appends (transfering the ownership) the capture descriptor `expr` to
  * the Event Rule Matches condition `condition`.
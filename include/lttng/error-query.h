@@ -91,6 +91,24 @@ lttng_error_query_execute(const struct lttng_error_query *query,
 			  const struct lttng_endpoint *endpoint,
 			  struct lttng_error_query_results **results);
 
+/*
+ * Run error queries against an endpoint with a single command.
+ *
+ * On success, `results[i]` is set to the result set of `queries[i]`, which
+ * must be destroyed using lttng_error_query_results_destroy(). On error, no
+ * result set is returned.
+ *
+ * Currently, only the `lttng_session_daemon_command_endpoint` is supported,
+ * see `lttng/endpoint.h`.
+ *
+ * Returns LTTNG_ERR_UND if the session daemon doesn't support this command.
+ */
+LTTNG_EXPORT extern enum lttng_error_code
+lttng_error_queries_execute(const struct lttng_error_query *const *queries,
+			    unsigned int count,
+			    const struct lttng_endpoint *endpoint,
+			    struct lttng_error_query_results **results);
+
 /* Get the number of results in a result set. */
 LTTNG_EXPORT LTTNG_EXPORT extern enum lttng_error_query_results_status
 lttng_error_query_results_get_count(const struct lttng_error_query_results *results,
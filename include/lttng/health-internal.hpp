@@ -15,7 +15,9 @@
 #include <lttng/health.h>
 
 #include <pthread.h>
+#include <urcu/arch.h>
 #include <urcu/list.h>
+#include <urcu/system.h>
 #include <urcu/tls-compat.h>
 #include <urcu/uatomic.h>
 
@@ -36,21 +38,25 @@ enum health_flags {
 
 struct health_state {
 	/*
-	 * last counter and last_time are only read and updated by the health_check
-	 * thread (single updater).
+	 * current is only updated by the thread owning the state, and flags is
+	 * updated atomically. They are read concurrently by the health check
+	 * thread.
 	 */
-	unsigned long last;
-	struct timespec last_time;
+	unsigned long current; /* progress counter */
+	enum health_flags flags; /* other flags, updated atomically */
+	int type; /* Indicates the nature of the thread. */
 
 	/*
-	 * current and flags are updated by multiple threads concurrently.
+	 * last counter and last_time are only read and updated by the health_check
+	 * thread (single updater). They are kept, with the node which the other
+	 * threads update as they register and unregister, on their own cache
+	 * line so that the owner thread's progress updates don't share it.
 	 */
-	unsigned long current; /* progress counter, updated atomically */
-	enum health_flags flags; /* other flags, updated atomically */
-	int type; /* Indicates the nature of the thread. */
+	unsigned long last __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
+	struct timespec last_time;
 	/* Node of the global TLS state list. */
 	struct cds_list_head node;
-};
+} __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
 
 enum health_cmd {
 	HEALTH_CMD_CHECK = 0,
@@ -75,9 +81,9 @@ extern thread_local struct health_state health_state;
 static inline void health_poll_entry()
 {
 	/* Code MUST be in code execution state which is an even number. */
-	LTTNG_ASSERT(!(uatomic_read(&health_state.current) & HEALTH_POLL_VALUE));
+	LTTNG_ASSERT(!(health_state.current & HEALTH_POLL_VALUE));
 
-	uatomic_add(&health_state.current, HEALTH_POLL_VALUE);
+	CMM_STORE_SHARED(health_state.current, health_state.current + HEALTH_POLL_VALUE);
 }
 
 /*
@@ -88,18 +94,21 @@ static inline void health_poll_entry()
 static inline void health_poll_exit()
 {
 	/* Code MUST be in poll execution state which is an odd number. */
-	LTTNG_ASSERT(uatomic_read(&health_state.current) & HEALTH_POLL_VALUE);
+	LTTNG_ASSERT(health_state.current & HEALTH_POLL_VALUE);
 
-	uatomic_add(&health_state.current, HEALTH_POLL_VALUE);
+	CMM_STORE_SHARED(health_state.current, health_state.current + HEALTH_POLL_VALUE);
 }
 
 /*
  * Update current counter by 2 indicates progress in execution of a
  * thread.
+ *
+ * Only the owner thread updates its counter: a plain store, rather than an
+ * atomic read-modify-write, is enough for the health check thread to read it.
  */
 static inline void health_code_update()
 {
-	uatomic_add(&health_state.current, HEALTH_CODE_VALUE);
+	CMM_STORE_SHARED(health_state.current, health_state.current + HEALTH_CODE_VALUE);
 }
 
 /*
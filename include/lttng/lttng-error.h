@@ -207,6 +207,7 @@ enum lttng_error_code {
 								 accounting full. */
 	LTTNG_ERR_INVALID_ERROR_QUERY_TARGET = 169, /* Invalid error query target. */
 	LTTNG_ERR_BUFFER_FLUSH_FAILED = 170, /* Buffer flush failed */
+	LTTNG_ERR_HUGE_PAGES_UNAVAILABLE = 171, /* Transparent huge pages are unavailable */
 
 	/* MUST be last element of the manually-assigned section of the enum */
 	LTTNG_ERR_NR,
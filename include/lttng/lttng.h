@@ -29,6 +29,7 @@
 #include <lttng/clear-handle.h>
 #include <lttng/clear.h>
 #include <lttng/condition/buffer-usage.h>
+#include <lttng/condition/channel-rate.h>
 #include <lttng/condition/condition.h>
 #include <lttng/condition/evaluation.h>
 #include <lttng/condition/event-rule-matches.h>
@@ -63,6 +64,7 @@
 #include <lttng/notification/notification.h>
 #include <lttng/rotation.h>
 #include <lttng/save.h>
+#include <lttng/session-description.h>
 #include <lttng/session-descriptor.h>
 #include <lttng/session.h>
 #include <lttng/snapshot.h>
@@ -98,6 +100,25 @@ struct lttng_calibrate {
  */
 LTTNG_EXPORT extern int lttng_session_daemon_alive(void);
 
+/*
+ * Send the commands of the following calls of the *current* flow of
+ * execution over a single connection to the session daemon, which it keeps
+ * open, rather than connecting to the session daemon for each command.
+ *
+ * The connection is established again if the session daemon closes it.
+ *
+ * On success, returns 0. Returns -LTTNG_ERR_NO_SESSIOND if no session daemon
+ * is available, -LTTNG_ERR_UND if the session daemon doesn't support
+ * persistent connections, or another negative LTTng error code.
+ */
+LTTNG_EXPORT extern int lttng_session_daemon_connection_open(void);
+
+/*
+ * Close the connection opened by lttng_session_daemon_connection_open(): the
+ * following calls connect to the session daemon for each command again.
+ */
+LTTNG_EXPORT extern void lttng_session_daemon_connection_close(void);
+
 /*
  * Set the tracing group for the *current* flow of execution.
  *
@@ -28,9 +28,11 @@
  *   - New condition type "LTTNG_CONDITION_TYPE_SESSION_CONSUMED_SIZE" added,
  *   - New condition type "LTTNG_CONDITION_TYPE_SESSION_ROTATION_ONGOING" added,
  *   - New condition type "LTTNG_CONDITION_TYPE_SESSION_ROTATION_COMPLETED" added,
+ * - v1.2
+ *   - New message type "SUBSCRIBE_WITH_OVERFLOW_POLICY" added,
  */
 #define LTTNG_NOTIFICATION_CHANNEL_VERSION_MAJOR 1
-#define LTTNG_NOTIFICATION_CHANNEL_VERSION_MINOR 1
+#define LTTNG_NOTIFICATION_CHANNEL_VERSION_MINOR 2
 
 enum lttng_notification_channel_message_type {
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNKNOWN = -1,
@@ -40,8 +42,12 @@ enum lttng_notification_channel_message_type {
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_COMMAND_REPLY = 3,
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION = 4,
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION_DROPPED = 5,
+	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_WITH_OVERFLOW_POLICY = 6,
 };
 
+/* Maximal number of notifications kept aside by a subscription on overflow. */
+#define LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_QUEUE_MAX_SIZE 1024
+
 struct lttng_notification_channel_message {
 	/* enum lttng_notification_channel_message_type */
 	int8_t type;
@@ -57,6 +63,13 @@ struct lttng_notification_channel_command_handshake {
 	uint8_t minor;
 } LTTNG_PACKED;
 
+/* Followed by the serialized condition. */
+struct lttng_notification_channel_command_subscribe_overflow_policy {
+	/* enum lttng_notification_channel_overflow_policy */
+	uint8_t policy;
+	uint32_t queue_size;
+} LTTNG_PACKED;
+
 struct lttng_notification_channel_command_reply {
 	/* enum lttng_notification_channel_status */
 	int8_t status;
@@ -99,6 +112,15 @@ struct lttng_notification_channel {
 		struct cds_list_head list;
 	} pending_notifications;
 	struct lttng_payload reception_payload;
+	/*
+	 * Complete messages, without file descriptors, received from the
+	 * socket ahead of their consumption.
+	 */
+	struct {
+		struct lttng_dynamic_buffer buffer;
+		/* Offset of the next message to consume. */
+		size_t offset;
+	} read_ahead;
 	/* Sessiond notification protocol version. */
 	struct {
 		bool set;
@@ -34,6 +34,29 @@ enum lttng_notification_channel_status {
 	LTTNG_NOTIFICATION_CHANNEL_STATUS_UNSUPPORTED_VERSION = -6,
 };
 
+/*
+ * Policy applied to the notifications of a subscription which are emitted
+ * while the client is not consuming the previous notifications fast enough.
+ */
+enum lttng_notification_channel_overflow_policy {
+	/*
+	 * Queue the notifications after a "notifications dropped" indication,
+	 * regardless of how many notifications are already queued.
+	 */
+	LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP = 0,
+	/*
+	 * Keep only the latest notification of the subscription until the
+	 * client catches up, replacing the one already kept.
+	 */
+	LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_COALESCE = 1,
+	/*
+	 * Keep the latest notifications of the subscription until the client
+	 * catches up, up to a number of notifications, dropping the oldest
+	 * ones.
+	 */
+	LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP_OLDEST = 2,
+};
+
 /**
  * A notification channel is used to receive notifications from various
  * LTTng components.
@@ -126,6 +149,33 @@ LTTNG_EXPORT extern enum lttng_notification_channel_status
 lttng_notification_channel_subscribe(struct lttng_notification_channel *channel,
 				     const struct lttng_condition *condition);
 
+/*
+ * Subscribe to notifications of a condition through a notification channel,
+ * applying an overflow policy to its notifications.
+ *
+ * This is equivalent to lttng_notification_channel_subscribe() when the
+ * policy is LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP. With the other
+ * policies, the notifications of the condition emitted while the client has
+ * notifications left to receive are kept aside and sent once it caught up.
+ * Every notification discarded to make room for a newer one results in
+ * LTTNG_NOTIFICATION_CHANNEL_STATUS_NOTIFICATIONS_DROPPED being reported by
+ * lttng_notification_channel_get_next_notification().
+ *
+ * `queue_size` is the maximal number of notifications kept aside with the
+ * LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP_OLDEST policy, in the range
+ * [1, 1024]. It is ignored for the other policies.
+ *
+ * Returns the same status codes as lttng_notification_channel_subscribe(), or
+ * LTTNG_NOTIFICATION_CHANNEL_STATUS_UNSUPPORTED_VERSION if the endpoint doesn't
+ * support overflow policies.
+ */
+LTTNG_EXPORT extern enum lttng_notification_channel_status
+lttng_notification_channel_subscribe_with_overflow_policy(
+	struct lttng_notification_channel *channel,
+	const struct lttng_condition *condition,
+	enum lttng_notification_channel_overflow_policy policy,
+	unsigned int queue_size);
+
 /*
  * Unsubscribe to notifications of a condition through a notification channel.
  *
@@ -17,6 +17,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/* Number of values of enum lttng_rotation_phase. */
+#define LTTNG_ROTATION_PHASE_COUNT 4
+
 /*
  * Object returned by the rotate session API.
  * This is opaque to the public library.
@@ -35,6 +38,12 @@ struct lttng_rotation_handle {
 	 * rotation is completed.
 	 */
 	struct lttng_trace_archive_location *archive_location;
+	/*
+	 * Durations of the phases of the rotation, in microseconds, cached
+	 * when the rotation is completed.
+	 */
+	bool phase_durations_set;
+	uint64_t phase_durations_us[LTTNG_ROTATION_PHASE_COUNT];
 };
 
 struct lttng_rotation_schedule {
@@ -102,6 +111,11 @@ struct lttng_rotation_get_info_return {
 			char relative_path[LTTNG_PATH_MAX];
 		} LTTNG_PACKED relay;
 	} location;
+	/*
+	 * Durations of the phases of the rotation, in microseconds, valid when
+	 * completed. Indexed by the values of enum lttng_rotation_phase.
+	 */
+	uint64_t phase_durations_us[LTTNG_ROTATION_PHASE_COUNT];
 } LTTNG_PACKED;
 
 /* For the LTTNG_SESSION_LIST_SCHEDULES command. */
@@ -66,6 +66,23 @@ enum lttng_rotation_status {
 	LTTNG_ROTATION_STATUS_SCHEDULE_NOT_SET = -3,
 };
 
+/*
+ * Phases of a session rotation, timed by the session daemon.
+ */
+enum lttng_rotation_phase {
+	/* Creation of the new trace chunk on the consumer and relay daemons. */
+	LTTNG_ROTATION_PHASE_CREATE_TRACE_CHUNK = 0,
+	/* Flush of the buffers and rotation of the streams by the consumers. */
+	LTTNG_ROTATION_PHASE_ROTATE_STREAMS = 1,
+	/* Close, and rename, of the archived trace chunk. */
+	LTTNG_ROTATION_PHASE_CLOSE_TRACE_CHUNK = 2,
+	/*
+	 * Wait for the consumer daemons to consume the data of the archived
+	 * trace chunk and for the relay daemons to receive it.
+	 */
+	LTTNG_ROTATION_PHASE_WAIT_DATA = 3,
+};
+
 enum lttng_rotation_schedule_type {
 	LTTNG_ROTATION_SCHEDULE_TYPE_UNKNOWN = -1,
 	LTTNG_ROTATION_SCHEDULE_TYPE_SIZE_THRESHOLD = 0,
@@ -120,6 +137,19 @@ LTTNG_EXPORT extern enum lttng_rotation_status
 lttng_rotation_handle_get_archive_location(struct lttng_rotation_handle *rotation_handle,
 					   const struct lttng_trace_archive_location **location);
 
+/*
+ * Get the duration, in microseconds, of a phase of the rotation.
+ *
+ * The rotation must be completed in order for this call to succeed.
+ *
+ * Returns LTTNG_ROTATION_STATUS_UNAVAILABLE if the rotation is not completed
+ * or if the session rotation handle has expired.
+ */
+LTTNG_EXPORT extern enum lttng_rotation_status
+lttng_rotation_handle_get_phase_duration(struct lttng_rotation_handle *rotation_handle,
+					 enum lttng_rotation_phase phase,
+					 uint64_t *duration_us);
+
 /*
  * Destroy an lttng_rotate_session handle.
  */
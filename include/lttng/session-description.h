@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_SESSION_DESCRIPTION_H
+#define LTTNG_SESSION_DESCRIPTION_H
+
+#include <lttng/domain.h>
+#include <lttng/lttng-export.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct lttng_channel;
+struct lttng_event;
+
+/*
+ * Description of the domains, channels and recording event rules of a
+ * tracing session, retrieved from the session daemon at once.
+ */
+struct lttng_session_description;
+
+/*
+ * Ask the session daemon for the description of a session.
+ *
+ * This is equivalent to calling lttng_list_domains(), then
+ * lttng_list_channels() for each domain and lttng_list_events() for each
+ * channel, with a single command.
+ *
+ * Return 0 on success else a negative LTTng error code. The returned
+ * description is owned by the caller and must be destroyed using
+ * lttng_session_description_destroy().
+ *
+ * Returns -LTTNG_ERR_UND if the session daemon doesn't support this command.
+ */
+LTTNG_EXPORT extern int lttng_describe_session(const char *session_name,
+					       struct lttng_session_description **description);
+
+/*
+ * Get the domains of a session description.
+ *
+ * The domains are owned by the description.
+ *
+ * Return the number of domains, or a negative LTTng error code.
+ */
+LTTNG_EXPORT extern int
+lttng_session_description_get_domains(const struct lttng_session_description *description,
+				      struct lttng_domain **domains);
+
+/*
+ * Get the channels of a domain of a session description, as listed by
+ * lttng_list_channels().
+ *
+ * The channels are owned by the description.
+ *
+ * Return the number of channels, or a negative LTTng error code.
+ */
+LTTNG_EXPORT extern int
+lttng_session_description_get_channels(const struct lttng_session_description *description,
+				       enum lttng_domain_type domain,
+				       struct lttng_channel **channels);
+
+/*
+ * Get the events of a channel of a domain of a session description, as
+ * listed by lttng_list_events(). The channel name is ignored for the agent
+ * domains (JUL, log4j and Python).
+ *
+ * The events are owned by the description.
+ *
+ * Return the number of events, or a negative LTTng error code.
+ */
+LTTNG_EXPORT extern int
+lttng_session_description_get_events(const struct lttng_session_description *description,
+				     enum lttng_domain_type domain,
+				     const char *channel_name,
+				     struct lttng_event **events);
+
+/*
+ * Destroy a session description.
+ */
+LTTNG_EXPORT extern void
+lttng_session_description_destroy(struct lttng_session_description *description);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LTTNG_SESSION_DESCRIPTION_H */
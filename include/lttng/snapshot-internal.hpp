@@ -9,6 +9,7 @@
 #define LTTNG_SNAPSHOT_INTERNAL_ABI_H
 
 #include <common/macros.hpp>
+#include <common/optional.hpp>
 
 #include <lttng/constant.h>
 
@@ -36,6 +37,17 @@ struct lttng_snapshot_output {
 	char ctrl_url[PATH_MAX];
 	/* Destination of the output. See lttng(1) for URL format. */
 	char data_url[PATH_MAX];
+	/*
+	 * Only record the packets produced since the previous snapshot of the
+	 * session. Boolean.
+	 */
+	uint8_t incremental;
+	/*
+	 * File descriptor receiving the snapshot in place of a URL. Only
+	 * meaningful to the client: the session daemon receives its own copy
+	 * of the file descriptor along with the command.
+	 */
+	LTTNG_OPTIONAL_COMM(int32_t) LTTNG_PACKED fd;
 } LTTNG_PACKED;
 
 /*
@@ -55,6 +55,9 @@ lttng_snapshot_output_get_ctrl_url(const struct lttng_snapshot_output *output);
 /* Return snapshot data URL in a text format. */
 LTTNG_EXPORT extern const char *
 lttng_snapshot_output_get_data_url(const struct lttng_snapshot_output *output);
+/* Return 1 if the snapshot output is incremental, 0 otherwise. */
+LTTNG_EXPORT extern int
+lttng_snapshot_output_is_incremental(const struct lttng_snapshot_output *output);
 
 /*
  * Snapshot output setter family functions.
@@ -73,6 +76,22 @@ LTTNG_EXPORT extern int lttng_snapshot_output_set_size(uint64_t size,
 LTTNG_EXPORT extern int lttng_snapshot_output_set_name(const char *name,
 						       struct lttng_snapshot_output *output);
 
+/*
+ * Only record, for each stream, the packets produced since the previous
+ * snapshot of the session rather than the whole content of its ring buffer.
+ * Metadata is always recorded in full so that every snapshot is a readable
+ * trace on its own; the data streams of consecutive incremental snapshots can
+ * be concatenated.
+ *
+ * Packets overwritten in the ring buffer before being recorded are lost.
+ *
+ * Such an output can only be used to record a snapshot with
+ * lttng_snapshot_record() or a snapshot-session action; it can't be added to a
+ * session.
+ */
+LTTNG_EXPORT extern int lttng_snapshot_output_set_incremental(int incremental,
+							      struct lttng_snapshot_output *output);
+
 /*
  * Set the output destination to be a path on the local filesystem.
  *
@@ -107,6 +126,26 @@ LTTNG_EXPORT extern int lttng_snapshot_output_set_network_url(const char *url,
 LTTNG_EXPORT extern int lttng_snapshot_output_set_network_urls(
 	const char *ctrl_url, const char *data_url, struct lttng_snapshot_output *output);
 
+/*
+ * Set the output destination to be a file descriptor, for instance a memfd or
+ * a pipe, to which the snapshot is written without going through the
+ * filesystem. Such an output can only be used to record a snapshot with
+ * lttng_snapshot_record(); it can't be added to a session.
+ *
+ * The file descriptor must remain open until lttng_snapshot_record() returns.
+ * The snapshot is written as a sequence of records, each made of:
+ *
+ *   - a header of three host-endian integers: a 32-bit magic number,
+ *     0x4c545352, the 32-bit length of the path that follows and the 64-bit
+ *     length of the payload;
+ *   - the path of a trace file relative to the root of the trace, such as
+ *     `ust/uid/1000/64-bit/channel0_0`, without a null terminator;
+ *   - the payload: a packet to append to that trace file.
+ *
+ * Return 0 on success or else a negative LTTNG_ERR code.
+ */
+LTTNG_EXPORT extern int lttng_snapshot_output_set_fd(int fd, struct lttng_snapshot_output *output);
+
 /* Set the control URL. Local and remote URL are supported. */
 LTTNG_EXPORT extern int lttng_snapshot_output_set_ctrl_url(const char *url,
 							   struct lttng_snapshot_output *output);
@@ -447,6 +447,100 @@ lttng_process_attr_virtual_group_id_tracker_handle_remove_group_name(
 	const struct lttng_process_attr_tracker_handle *group_id_tracker,
 	const char *virtual_group_name);
 
+/*
+ * Add or remove a set of numerical values to/from the inclusion set of a
+ * process attribute tracker.
+ *
+ * The values are sent to the session daemon in bulk, which is considerably
+ * faster than adding or removing the values one by one when tracking large
+ * sets of values (for instance, all the IDs mapped to a container). The
+ * session daemon also updates the user space applications once for the whole
+ * set.
+ *
+ * The values are processed in order and processing stops at the first value
+ * that can't be added (or removed); the values that precede it remain added
+ * (or removed).
+ *
+ * Returns LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_OK on success,
+ * LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_EXISTS if a value was already
+ * present in the inclusion set (on addition),
+ * LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_MISSING if a value was not present
+ * in the inclusion set (on removal), and
+ * LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_INVALID if an invalid tracker or
+ * values argument was provided.
+ */
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_process_id_tracker_handle_add_pids(
+	const struct lttng_process_attr_tracker_handle *process_id_tracker,
+	const pid_t *pids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_process_id_tracker_handle_remove_pids(
+	const struct lttng_process_attr_tracker_handle *process_id_tracker,
+	const pid_t *pids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_virtual_process_id_tracker_handle_add_pids(
+	const struct lttng_process_attr_tracker_handle *process_id_tracker,
+	const pid_t *vpids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_virtual_process_id_tracker_handle_remove_pids(
+	const struct lttng_process_attr_tracker_handle *process_id_tracker,
+	const pid_t *vpids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_user_id_tracker_handle_add_uids(
+	const struct lttng_process_attr_tracker_handle *user_id_tracker,
+	const uid_t *uids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_user_id_tracker_handle_remove_uids(
+	const struct lttng_process_attr_tracker_handle *user_id_tracker,
+	const uid_t *uids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_virtual_user_id_tracker_handle_add_uids(
+	const struct lttng_process_attr_tracker_handle *user_id_tracker,
+	const uid_t *vuids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_virtual_user_id_tracker_handle_remove_uids(
+	const struct lttng_process_attr_tracker_handle *user_id_tracker,
+	const uid_t *vuids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_group_id_tracker_handle_add_gids(
+	const struct lttng_process_attr_tracker_handle *group_id_tracker,
+	const gid_t *gids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_group_id_tracker_handle_remove_gids(
+	const struct lttng_process_attr_tracker_handle *group_id_tracker,
+	const gid_t *gids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_virtual_group_id_tracker_handle_add_gids(
+	const struct lttng_process_attr_tracker_handle *group_id_tracker,
+	const gid_t *vgids,
+	unsigned int count);
+
+LTTNG_EXPORT extern enum lttng_process_attr_tracker_handle_status
+lttng_process_attr_virtual_group_id_tracker_handle_remove_gids(
+	const struct lttng_process_attr_tracker_handle *group_id_tracker,
+	const gid_t *vgids,
+	unsigned int count);
+
 /*
  * Get the process attribute values that are part of a tracker's inclusion set.
  *
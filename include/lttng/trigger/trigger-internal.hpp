@@ -227,6 +227,12 @@ struct lttng_trigger *lttng_trigger_copy(const struct lttng_trigger *trigger);
  */
 bool lttng_trigger_needs_tracer_notifier(const struct lttng_trigger *trigger);
 
+/*
+ * Whether the action of a trigger is a notify action, or a list which
+ * contains one.
+ */
+bool lttng_trigger_has_notify_action(const struct lttng_trigger *trigger);
+
 void lttng_trigger_set_as_registered(struct lttng_trigger *trigger);
 
 void lttng_trigger_set_as_unregistered(struct lttng_trigger *trigger);
@@ -254,6 +260,15 @@ enum lttng_trigger_status
 lttng_trigger_condition_add_error_results(const struct lttng_trigger *trigger,
 					  struct lttng_error_query_results *results);
 
+/*
+ * Same as lttng_trigger_condition_add_error_results(), the count of messages
+ * discarded by the tracer being already known.
+ */
+enum lttng_trigger_status
+lttng_trigger_condition_add_error_results_with_count(const struct lttng_trigger *trigger,
+						     uint64_t discarded_tracer_messages_count,
+						     struct lttng_error_query_results *results);
+
 enum lttng_trigger_status
 lttng_trigger_add_action_error_query_results(struct lttng_trigger *trigger,
 					     struct lttng_error_query_results *results);
@@ -157,6 +157,23 @@ lttng_register_trigger_with_name(struct lttng_trigger *trigger, const char *name
 LTTNG_EXPORT extern enum lttng_error_code
 lttng_register_trigger_with_automatic_name(struct lttng_trigger *trigger);
 
+/*
+ * Register triggers to the session daemon with a single command, generating
+ * a unique name for each of them.
+ *
+ * All the triggers must have the same underlying domain and none of them can
+ * have a name. Either all of them are registered, or none is.
+ *
+ * The triggers can be destroyed after this call.
+ * On success, this function will set the name of each trigger to its
+ * generated name.
+ *
+ * Returns an LTTng status code.
+ */
+LTTNG_EXPORT extern enum lttng_error_code
+lttng_register_triggers_with_automatic_name(struct lttng_trigger *const *triggers,
+					    unsigned int count);
+
 /*
  * Unregister a trigger from the session daemon.
  *
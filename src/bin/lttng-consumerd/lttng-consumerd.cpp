@@ -10,15 +10,25 @@
 #include "health-consumerd.hpp"
 #include "lttng-consumerd.hpp"
 
+#include <common/alloc-stats.hpp>
+#include <common/async-log.hpp>
 #include <common/common.hpp>
 #include <common/compat/getenv.hpp>
 #include <common/compat/poll.hpp>
+#include <common/consumer/consumer-compression.hpp>
+#include <common/consumer/consumer-packet-filter.hpp>
+#include <common/consumer/consumer-relayd-spill.hpp>
+#include <common/consumer/consumer-snapshot.hpp>
+#include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/consumer/consumer.hpp>
 #include <common/defaults.hpp>
+#include <common/io-hint.hpp>
+#include <common/numa.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/utils.hpp>
 
+#include <ctype.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <grp.h>
@@ -43,9 +53,9 @@
 
 /* threads (channel handling, poll, metadata, sessiond) */
 
-static pthread_t channel_thread, data_thread, metadata_thread, sessiond_thread,
-	metadata_timer_thread, health_thread;
-static bool metadata_timer_thread_online;
+static pthread_t channel_thread, metadata_thread, sessiond_thread, metadata_timer_thread,
+	health_thread, relayd_spill_thread;
+static bool metadata_timer_thread_online, relayd_spill_thread_online;
 
 /* to count the number of times the user pressed ctrl+c */
 static int sigintcount = 0;
@@ -60,6 +70,11 @@ static const char *progname;
 static char command_sock_path[PATH_MAX]; /* Global command socket path */
 static char error_sock_path[PATH_MAX]; /* Global error path */
 static enum lttng_consumer_type opt_type = LTTNG_CONSUMER_KERNEL;
+static unsigned int opt_data_thread_count = DEFAULT_CONSUMERD_DATA_THREAD_COUNT;
+static bool opt_numa_placement;
+
+/* NUMA topology used by the data workers when NUMA placement is enabled. */
+static lttng::numa::topology numa_topology;
 
 /* the liblttngconsumerd context */
 static struct lttng_consumer_local_data *the_consumer_context;
@@ -185,6 +200,10 @@ static void usage(FILE *fp)
 	fprintf(fp,
 		"  -g, --group NAME                   "
 		"Specify the tracing group name. (default: tracing)\n");
+	fprintf(fp,
+		"  -t, --data-threads COUNT           "
+		"Number of data stream poll threads. (default: %d)\n",
+		DEFAULT_CONSUMERD_DATA_THREAD_COUNT);
 	fprintf(fp,
 		"  -k, --kernel                       "
 		"Consumer kernel buffers (default).\n");
@@ -199,6 +218,226 @@ static void usage(FILE *fp)
 	);
 }
 
+/*
+ * Parse a data thread count from the command line or the environment.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int parse_data_thread_count(const char *arg, const char *source)
+{
+	unsigned long v;
+
+	errno = 0;
+	v = strtoul(arg, nullptr, 0);
+	if (errno != 0 || !isdigit(arg[0])) {
+		ERR("Wrong value in %s: %s", source, arg);
+		return -1;
+	}
+
+	if (v == 0 || v > DEFAULT_CONSUMERD_DATA_THREAD_COUNT_MAX) {
+		ERR("Value out of range in %s: %s (expected 1 to %d)",
+		    source,
+		    arg,
+		    DEFAULT_CONSUMERD_DATA_THREAD_COUNT_MAX);
+		return -1;
+	}
+
+	opt_data_thread_count = (unsigned int) v;
+	DBG3("Data thread count set to %u", opt_data_thread_count);
+	return 0;
+}
+
+/*
+ * Parse the number of threads recording a channel snapshot from the environment.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int parse_snapshot_thread_count(const char *arg)
+{
+	unsigned long v;
+
+	errno = 0;
+	v = strtoul(arg, nullptr, 0);
+	if (errno != 0 || !isdigit(arg[0])) {
+		ERR("Wrong value in %s: %s", DEFAULT_CONSUMERD_SNAPSHOT_THREADS_ENV, arg);
+		return -1;
+	}
+
+	if (v == 0 || v > DEFAULT_CONSUMERD_SNAPSHOT_THREAD_COUNT_MAX) {
+		ERR("Value out of range in %s: %s (expected 1 to %d)",
+		    DEFAULT_CONSUMERD_SNAPSHOT_THREADS_ENV,
+		    arg,
+		    DEFAULT_CONSUMERD_SNAPSHOT_THREAD_COUNT_MAX);
+		return -1;
+	}
+
+	consumer_snapshot_set_thread_count((unsigned int) v);
+	DBG3("Snapshot thread count set to %lu", v);
+	return 0;
+}
+
+/*
+ * Parse the relayd index batching settings from the environment.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int parse_relayd_index_batching(const char *size_arg, const char *latency_arg)
+{
+	unsigned long size = DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE;
+	unsigned long long latency = DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY;
+
+	if (size_arg) {
+		errno = 0;
+		size = strtoul(size_arg, nullptr, 0);
+		if (errno != 0 || !isdigit(size_arg[0])) {
+			ERR("Wrong value in %s: %s",
+			    DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_ENV,
+			    size_arg);
+			return -1;
+		}
+
+		if (size == 0 || size > DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_MAX) {
+			ERR("Value out of range in %s: %s (expected 1 to %d)",
+			    DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_ENV,
+			    size_arg,
+			    DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_MAX);
+			return -1;
+		}
+	}
+
+	if (latency_arg) {
+		errno = 0;
+		latency = strtoull(latency_arg, nullptr, 0);
+		if (errno != 0 || !isdigit(latency_arg[0])) {
+			ERR("Wrong value in %s: %s",
+			    DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY_ENV,
+			    latency_arg);
+			return -1;
+		}
+	}
+
+	consumer_set_relayd_index_batching((unsigned int) size, (uint64_t) latency);
+	DBG3("Relayd index batching set to %lu indexes, %llu us", size, latency);
+	return 0;
+}
+
+/*
+ * Parse the environment variables. Command line arguments take precedence.
+ */
+static int parse_env_options()
+{
+	const char *value;
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_DATA_THREADS_ENV);
+	if (value && parse_data_thread_count(value, DEFAULT_CONSUMERD_DATA_THREADS_ENV)) {
+		return -1;
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_SNAPSHOT_THREADS_ENV);
+	if (value && parse_snapshot_thread_count(value)) {
+		return -1;
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_IO_URING_ENV);
+	if (value && !strcmp(value, "1")) {
+		lttng::io::set_async_flush_backend_enabled(true);
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_NUMA_ENV);
+	if (value && !strcmp(value, "1")) {
+		opt_numa_placement = true;
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_COMPRESSION_ENV);
+	if (value && consumer_compression_set_algorithm(value)) {
+		ERR("Invalid value for environment variable %s: `%s`",
+		    DEFAULT_CONSUMERD_COMPRESSION_ENV,
+		    value);
+		return -1;
+	}
+
+	if (consumer_compression_get_algorithm() != CONSUMER_COMPRESSION_ALGORITHM_NONE) {
+		WARN("Data packets are compressed: the traces must be decompressed before they can be read");
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_PACKET_SAMPLING_ENV);
+	if (value && consumer_packet_filter_set_policy(value)) {
+		ERR("Invalid value for environment variable %s: `%s`",
+		    DEFAULT_CONSUMERD_PACKET_SAMPLING_ENV,
+		    value);
+		return -1;
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_PACKET_SAMPLING_EXEMPT_ENV);
+	if (value && consumer_packet_filter_set_exempt_channels(value)) {
+		return -1;
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_RELAYD_SPILL_MAX_SIZE_ENV);
+	if (value && consumer_relayd_spill_set_max_size(value)) {
+		ERR("Invalid value for environment variable %s: `%s`",
+		    DEFAULT_CONSUMERD_RELAYD_SPILL_MAX_SIZE_ENV,
+		    value);
+		return -1;
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_PREALLOCATION_SIZE_ENV);
+	if (value) {
+		uint64_t size;
+
+		if (utils_parse_size_suffix(value, &size)) {
+			ERR("Invalid value for environment variable %s: `%s`",
+			    DEFAULT_CONSUMERD_PREALLOCATION_SIZE_ENV,
+			    value);
+			return -1;
+		}
+
+		consumer_stream_set_preallocation_size(size);
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_MONITOR_SAMPLE_DELTA_ENV);
+	if (value) {
+		uint64_t delta;
+
+		if (utils_parse_size_suffix(value, &delta)) {
+			ERR("Invalid value for environment variable %s: `%s`",
+			    DEFAULT_CONSUMERD_MONITOR_SAMPLE_DELTA_ENV,
+			    value);
+			return -1;
+		}
+
+		consumer_timer_set_monitor_sample_delta(delta);
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_CHUNK_MANIFEST_ENV);
+	if (value && !strcmp(value, "1")) {
+		consumer_stream_set_chunk_manifest_enabled(true);
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_METADATA_LANE_ENV);
+	if (value && !strcmp(value, "1")) {
+		consumer_stream_set_metadata_lane_enabled(true);
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_PACKET_CHECKSUM_ENV);
+	if (value && !strcmp(value, "1")) {
+		consumer_stream_set_packet_checksum_enabled(true);
+	}
+
+	value = lttng_secure_getenv(DEFAULT_CONSUMERD_RELAYD_SPILL_DIR_ENV);
+	if (value && *value && consumer_relayd_spill_set_directory(value)) {
+		return -1;
+	}
+
+	if (parse_relayd_index_batching(
+		    lttng_secure_getenv(DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_ENV),
+		    lttng_secure_getenv(DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY_ENV))) {
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * daemon argument parsing
  */
@@ -215,6 +454,7 @@ static int parse_args(int argc, char **argv)
 						{ "verbose", 0, nullptr, 'v' },
 						{ "version", 0, nullptr, 'V' },
 						{ "kernel", 0, nullptr, 'k' },
+						{ "data-threads", 1, nullptr, 't' },
 #ifdef HAVE_LIBLTTNG_UST_CTL
 						{ "ust", 0, nullptr, 'u' },
 #endif
@@ -225,7 +465,7 @@ static int parse_args(int argc, char **argv)
 		c = getopt_long(argc,
 				argv,
 				"dhqvVku"
-				"c:e:g:",
+				"c:e:g:t:",
 				long_options,
 				&option_index);
 		if (c == -1) {
@@ -283,6 +523,12 @@ static int parse_args(int argc, char **argv)
 		case 'k':
 			opt_type = LTTNG_CONSUMER_KERNEL;
 			break;
+		case 't':
+			if (parse_data_thread_count(optarg, "-t, --data-threads")) {
+				ret = -1;
+				goto end;
+			}
+			break;
 #ifdef HAVE_LIBLTTNG_UST_CTL
 		case 'u':
 #if (CAA_BITS_PER_LONG == 64)
@@ -329,6 +575,7 @@ static void set_ulimit()
 int main(int argc, char **argv)
 {
 	int ret = 0, retval = 0;
+	unsigned int data_thread_index = 0;
 	void *status;
 	struct lttng_consumer_local_data *tmp_ctx;
 
@@ -343,8 +590,13 @@ int main(int argc, char **argv)
 		goto exit_set_signal_handler;
 	}
 
-	/* Parse arguments */
+	/* Parse environment variables and arguments */
 	progname = argv[0];
+	if (parse_env_options()) {
+		retval = -1;
+		goto exit_options;
+	}
+
 	if (parse_args(argc, argv)) {
 		retval = -1;
 		goto exit_options;
@@ -380,6 +632,11 @@ int main(int argc, char **argv)
 	 * lttng_daemonize due to RCU.
 	 */
 
+	if (lttng_async_log_init_from_env()) {
+		retval = -1;
+		goto exit_health_consumerd_cleanup;
+	}
+
 	health_consumerd = health_app_create(NR_HEALTH_CONSUMERD_TYPES);
 	if (!health_consumerd) {
 		retval = -1;
@@ -446,12 +703,22 @@ int main(int argc, char **argv)
 						     lttng_consumer_read_subbuffer,
 						     nullptr,
 						     lttng_consumer_on_recv_stream,
-						     nullptr);
+						     nullptr,
+						     opt_data_thread_count);
 	if (!the_consumer_context) {
 		retval = -1;
 		goto exit_init_data;
 	}
 
+	if (opt_numa_placement) {
+		numa_topology = lttng::numa::topology::from_sysfs();
+		if (numa_topology.node_count() > 1) {
+			lttng_consumer_set_numa_topology(the_consumer_context, &numa_topology);
+		} else {
+			DBG("Single NUMA node system, NUMA placement of data workers disabled");
+		}
+	}
+
 	lttng_consumer_set_command_sock_path(the_consumer_context, command_sock_path);
 	if (*error_sock_path == '\0') {
 		switch (opt_type) {
@@ -505,10 +772,10 @@ int main(int argc, char **argv)
 	lttng_consumer_set_error_sock(the_consumer_context, ret);
 
 	/*
-	 * Block RT signals used for UST periodical metadata flush and the live
-	 * timer in main, and create a dedicated thread to handle these signals.
+	 * Create the timerfd used by the dedicated thread which runs the UST
+	 * periodical metadata flush, live and monitoring timers.
 	 */
-	if (consumer_signal_init()) {
+	if (consumer_timer_init()) {
 		retval = -1;
 		goto exit_init_data;
 	}
@@ -557,6 +824,21 @@ int main(int argc, char **argv)
 	}
 	metadata_timer_thread_online = true;
 
+	/* Create the thread replaying the relayd spill queues, if enabled. */
+	if (consumer_relayd_spill_is_enabled()) {
+		ret = pthread_create(&relayd_spill_thread,
+				     default_pthread_attr(),
+				     consumer_relayd_spill_thread,
+				     (void *) the_consumer_context);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create");
+			retval = -1;
+			goto exit_relayd_spill_thread;
+		}
+		relayd_spill_thread_online = true;
+	}
+
 	/* Create thread to manage channels */
 	ret = pthread_create(&channel_thread,
 			     default_pthread_attr(),
@@ -581,16 +863,28 @@ int main(int argc, char **argv)
 		goto exit_metadata_thread;
 	}
 
-	/* Create thread to manage the polling/writing of trace data */
-	ret = pthread_create(&data_thread,
-			     default_pthread_attr(),
-			     consumer_thread_data_poll,
-			     (void *) the_consumer_context);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_create");
-		retval = -1;
-		goto exit_data_thread;
+	/* Create threads to manage the polling/writing of trace data */
+	for (data_thread_index = 0; data_thread_index < the_consumer_context->data_worker_count;
+	     data_thread_index++) {
+		struct lttng_consumer_data_worker *worker =
+			&the_consumer_context->data_workers[data_thread_index];
+
+		/*
+		 * Accounted before the thread is launched since the last data
+		 * thread to exit wakes up the metadata thread.
+		 */
+		uatomic_inc(&the_consumer_context->data_worker_online_count);
+		ret = pthread_create(&worker->thread,
+				     default_pthread_attr(),
+				     consumer_thread_data_poll,
+				     (void *) worker);
+		if (ret) {
+			uatomic_dec(&the_consumer_context->data_worker_online_count);
+			errno = ret;
+			PERROR("pthread_create");
+			retval = -1;
+			goto exit_data_thread;
+		}
 	}
 
 	/* Create the thread to manage the reception of fds */
@@ -618,13 +912,17 @@ int main(int argc, char **argv)
 	}
 exit_sessiond_thread:
 
-	ret = pthread_join(data_thread, &status);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_join data_thread");
-		retval = -1;
-	}
 exit_data_thread:
+	while (data_thread_index > 0) {
+		data_thread_index--;
+		ret = pthread_join(the_consumer_context->data_workers[data_thread_index].thread,
+				   &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join data_thread");
+			retval = -1;
+		}
+	}
 
 	ret = pthread_join(metadata_thread, &status);
 	if (ret) {
@@ -642,6 +940,8 @@ exit_metadata_thread:
 	}
 exit_channel_thread:
 
+exit_relayd_spill_thread:
+
 exit_metadata_timer_thread:
 
 	ret = pthread_join(health_thread, &status);
@@ -656,6 +956,18 @@ exit_health_thread:
 exit_health_pipe:
 
 exit_init_data:
+	/* The relayd spill thread uses the relayd hash table. */
+	if (relayd_spill_thread_online) {
+		(void) consumer_relayd_spill_thread_quit();
+		ret = pthread_join(relayd_spill_thread, &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join relayd_spill_thread");
+			retval = -1;
+		}
+		relayd_spill_thread_online = false;
+	}
+
 	/*
 	 * Wait for all pending call_rcu work to complete before tearing
 	 * down data structures. call_rcu worker may be trying to
@@ -675,7 +987,7 @@ exit_init_data:
 		 * threads are gone, because it is required to perform timer
 		 * teardown synchronization.
 		 */
-		kill(getpid(), LTTNG_CONSUMER_SIG_EXIT);
+		(void) consumer_timer_thread_quit();
 		ret = pthread_join(metadata_timer_thread, &status);
 		if (ret) {
 			errno = ret;
@@ -703,10 +1015,12 @@ exit_init_data:
 	rcu_barrier();
 
 	run_as_destroy_worker();
+	lttng::alloc_stats::log_all();
 
 exit_health_consumerd_cleanup:
 exit_options:
 exit_set_signal_handler:
+	lttng_async_log_fini();
 
 	rcu_unregister_thread();
 
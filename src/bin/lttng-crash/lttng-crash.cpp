@@ -8,26 +8,36 @@
 
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
+#include <common/relayd/relayd.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/spawn-viewer.hpp>
+#include <common/trace-chunk.hpp>
+#include <common/uri.hpp>
 #include <common/utils.hpp>
+#include <common/uuid.hpp>
 
 #include <lttng/lttng.h>
 
+#include <algorithm>
 #include <ctype.h>
 #include <dirent.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
+#include <vector>
 #include <version.hpp>
 
 #define COPY_BUFLEN	      4096
@@ -172,14 +182,40 @@ struct lttng_crash_layout {
 	uint64_t num_subbuf; /* Number of sub-buffers for writer */
 	uint32_t mode; /* Buffer mode: 0: overwrite, 1: discard */
 };
+
+/* Relay daemon to which the recovered traces are sent. */
+struct crash_relayd {
+	struct lttcomm_relayd_sock *control;
+	struct lttcomm_relayd_sock *data;
+	/* Trace chunk holding all the recovered traces. */
+	struct lttng_trace_chunk *chunk;
+	/* Protects the sockets, shared by the extraction threads. */
+	pthread_mutex_t lock;
+};
+
+/*
+ * Output of a recovered stream: a file or, when the traces are sent to a relay
+ * daemon, a stream of the relay daemon which is added as its first packet is
+ * sent.
+ */
+struct crash_output {
+	int fd;
+	/* Path of the trace of the stream, relative to the trace chunk. */
+	const char *path;
+	const char *name;
+	uint64_t relayd_stream_id;
+	uint64_t next_net_seq_num;
+};
 } /* namespace */
 
 /* Variables */
 static const char *progname;
 static char *opt_viewer_path = nullptr;
 static char *opt_output_path = nullptr;
+static char *opt_relayd_url = nullptr;
 
 static char *the_input_path;
+static struct crash_relayd *the_relayd;
 
 int lttng_opt_quiet, lttng_opt_verbose, lttng_opt_mi;
 
@@ -191,8 +227,8 @@ enum {
 static struct option long_options[] = {
 	{ "version", 0, nullptr, 'V' }, { "help", 0, nullptr, 'h' },
 	{ "verbose", 0, nullptr, 'v' }, { "viewer", 1, nullptr, 'e' },
-	{ "extract", 1, nullptr, 'x' }, { "list-options", 0, nullptr, OPT_DUMP_OPTIONS },
-	{ nullptr, 0, nullptr, 0 },
+	{ "extract", 1, nullptr, 'x' }, { "relayd", 1, nullptr, 'r' },
+	{ "list-options", 0, nullptr, OPT_DUMP_OPTIONS }, { nullptr, 0, nullptr, 0 },
 };
 
 static void usage()
@@ -253,7 +289,7 @@ static int parse_args(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
-	while ((opt = getopt_long(argc, argv, "+Vhve:x:", long_options, nullptr)) != -1) {
+	while ((opt = getopt_long(argc, argv, "+Vhve:x:r:", long_options, nullptr)) != -1) {
 		switch (opt) {
 		case 'V':
 			version(stdout);
@@ -277,6 +313,10 @@ static int parse_args(int argc, char **argv)
 			free(opt_output_path);
 			opt_output_path = strdup(optarg);
 			break;
+		case 'r':
+			free(opt_relayd_url);
+			opt_relayd_url = strdup(optarg);
+			break;
 		case OPT_DUMP_OPTIONS:
 			list_options(stdout);
 			ret = 1;
@@ -293,6 +333,11 @@ static int parse_args(int argc, char **argv)
 		goto error;
 	}
 
+	if (opt_relayd_url && (opt_output_path || opt_viewer_path)) {
+		ERR("Command-line error: --relayd can't be used with --extract or --viewer");
+		goto error;
+	}
+
 	the_input_path = argv[optind];
 end:
 	return ret;
@@ -618,13 +663,389 @@ static inline uint64_t subbuffer_id_get_index(uint32_t mode, uint64_t id, unsign
 		return id;
 }
 
-static int
-copy_crash_subbuf(const struct lttng_crash_layout *layout, int fd_dest, char *buf, uint64_t offset)
+/*
+ * Close the connection to the relay daemon: the relay daemon ends the session
+ * of the recovered traces as its connections close.
+ */
+static void disconnect_relayd()
+{
+	if (!the_relayd) {
+		return;
+	}
+
+	if (the_relayd->data) {
+		(void) relayd_close(the_relayd->data);
+		free(the_relayd->data);
+	}
+
+	if (the_relayd->control) {
+		(void) relayd_close(the_relayd->control);
+		free(the_relayd->control);
+	}
+
+	lttng_trace_chunk_put(the_relayd->chunk);
+	pthread_mutex_destroy(&the_relayd->lock);
+	free(the_relayd);
+	the_relayd = nullptr;
+}
+
+/*
+ * Connect to the relay daemon at `url` and create the session, and its trace
+ * chunk, to which the recovered traces are sent.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int connect_relayd(const char *url)
+{
+	int ret;
+	ssize_t uri_count;
+	struct lttng_uri *uris = nullptr;
+	uint64_t session_id;
+	lttng_uuid uuid;
+	char hostname[LTTNG_HOST_NAME_MAX] = {};
+	char output_path[LTTNG_PATH_MAX] = {};
+	const time_t creation_time = time(nullptr);
+
+	uri_count = uri_parse_str_urls(url, nullptr, &uris);
+	if (uri_count != 2 || uris[0].dtype == LTTNG_DST_PATH) {
+		ERR("Invalid relay daemon URL: %s", url);
+		free(uris);
+		return -1;
+	}
+
+	the_relayd = zmalloc<crash_relayd>();
+	if (!the_relayd) {
+		PERROR("Failed to allocate relay daemon connection");
+		free(uris);
+		return -1;
+	}
+
+	pthread_mutex_init(&the_relayd->lock, nullptr);
+	the_relayd->control = lttcomm_alloc_relayd_sock(
+		&uris[0], RELAYD_VERSION_COMM_MAJOR, RELAYD_VERSION_COMM_MINOR);
+	the_relayd->data = lttcomm_alloc_relayd_sock(
+		&uris[1], RELAYD_VERSION_COMM_MAJOR, RELAYD_VERSION_COMM_MINOR);
+	free(uris);
+	if (!the_relayd->control || !the_relayd->data) {
+		goto error;
+	}
+
+	if (relayd_connect(the_relayd->control) < 0 || relayd_connect(the_relayd->data) < 0) {
+		ERR("Unable to reach lttng-relayd: %s", url);
+		goto error;
+	}
+
+	ret = relayd_version_check(the_relayd->control);
+	if (ret || (the_relayd->control->major == 2 && the_relayd->control->minor < 11)) {
+		ERR("Incompatible lttng-relayd: trace chunks are not supported: %s", url);
+		goto error;
+	}
+
+	the_relayd->data->major = the_relayd->control->major;
+	the_relayd->data->minor = the_relayd->control->minor;
+
+	if (gethostname(hostname, sizeof(hostname) - 1)) {
+		PERROR("gethostname");
+		goto error;
+	}
+
+	if (lttng_uuid_generate(uuid)) {
+		ERR("Failed to generate the session UUID");
+		goto error;
+	}
+
+	ret = relayd_create_session(the_relayd->control,
+				    &session_id,
+				    "lttng-crash",
+				    hostname,
+				    "",
+				    0,
+				    0,
+				    1,
+				    uuid,
+				    nullptr,
+				    creation_time,
+				    false,
+				    output_path);
+	if (ret < 0) {
+		ERR("Failed to create the session of the recovered traces on lttng-relayd");
+		goto error;
+	}
+
+	the_relayd->chunk = lttng_trace_chunk_create(0, creation_time, nullptr);
+	if (!the_relayd->chunk) {
+		goto error;
+	}
+
+	ret = relayd_create_trace_chunk(the_relayd->control, the_relayd->chunk);
+	if (ret < 0) {
+		ERR("Failed to create the trace chunk of the recovered traces on lttng-relayd");
+		goto error;
+	}
+
+	DBG("Sending the recovered traces to lttng-relayd: session id = %" PRIu64
+	    ", output path = '%s'",
+	    session_id,
+	    output_path);
+	return 0;
+
+error:
+	disconnect_relayd();
+	return -1;
+}
+
+/*
+ * Add the relay daemon stream of `output` if it is not added yet. Called with
+ * the relay daemon lock held.
+ */
+static int add_relayd_stream(struct crash_output *output)
+{
+	int ret;
+
+	if (output->relayd_stream_id != -1ULL) {
+		return 0;
+	}
+
+	/* The streams are sent in the trace chunk, relative to its directory. */
+	ret = relayd_add_stream(the_relayd->control,
+				output->name,
+				"",
+				output->path + strspn(output->path, "/"),
+				&output->relayd_stream_id,
+				0,
+				0,
+				the_relayd->chunk);
+	if (ret < 0) {
+		ERR("Failed to add stream '%s/%s' to lttng-relayd", output->path, output->name);
+		output->relayd_stream_id = -1ULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Send a packet of a data stream to the relay daemon. */
+static int send_relayd_packet(struct crash_output *output, const char *data, uint64_t length)
+{
+	int ret;
+	ssize_t send_ret;
+	struct lttcomm_relayd_data_hdr header = {};
+
+	pthread_mutex_lock(&the_relayd->lock);
+	ret = add_relayd_stream(output);
+	if (ret) {
+		goto end;
+	}
+
+	header.stream_id = htobe64(output->relayd_stream_id);
+	header.net_seq_num = htobe64(output->next_net_seq_num);
+	header.data_size = htobe32((uint32_t) length);
+	ret = relayd_send_data_hdr(the_relayd->data, &header, sizeof(header));
+	if (ret < 0) {
+		goto end;
+	}
+
+	send_ret = the_relayd->data->sock.ops->sendmsg(&the_relayd->data->sock, data, length, 0);
+	if (send_ret < (ssize_t) length) {
+		ERR("Failed to send packet of stream '%s/%s' to lttng-relayd",
+		    output->path,
+		    output->name);
+		ret = -1;
+		goto end;
+	}
+
+	output->next_net_seq_num++;
+	ret = 0;
+end:
+	pthread_mutex_unlock(&the_relayd->lock);
+	return ret;
+}
+
+/* Send metadata of a trace to the relay daemon. */
+static int send_relayd_metadata(struct crash_output *output, const char *data, size_t length)
+{
+	int ret;
+	ssize_t send_ret;
+	struct lttcomm_relayd_metadata_payload header = {};
+
+	pthread_mutex_lock(&the_relayd->lock);
+	ret = add_relayd_stream(output);
+	if (ret) {
+		goto end;
+	}
+
+	ret = relayd_send_metadata(the_relayd->control, sizeof(header) + length);
+	if (ret < 0) {
+		goto end;
+	}
+
+	header.stream_id = htobe64(output->relayd_stream_id);
+	send_ret = the_relayd->control->sock.ops->sendmsg(
+		&the_relayd->control->sock, &header, sizeof(header), 0);
+	if (send_ret < (ssize_t) sizeof(header)) {
+		ret = -1;
+		goto end;
+	}
+
+	send_ret = the_relayd->control->sock.ops->sendmsg(
+		&the_relayd->control->sock, data, length, 0);
+	if (send_ret < (ssize_t) length) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = 0;
+end:
+	pthread_mutex_unlock(&the_relayd->lock);
+	if (ret) {
+		ERR("Failed to send metadata of '%s' to lttng-relayd", output->path);
+	}
+	return ret;
+}
+
+/* Close the relay daemon stream of `output`, if it was added. */
+static int close_relayd_stream(struct crash_output *output)
+{
+	int ret;
+
+	if (output->relayd_stream_id == -1ULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&the_relayd->lock);
+	ret = relayd_send_close_stream(
+		the_relayd->control, output->relayd_stream_id, output->next_net_seq_num - 1);
+	pthread_mutex_unlock(&the_relayd->lock);
+	if (ret < 0) {
+		ERR("Failed to close stream '%s/%s' on lttng-relayd", output->path, output->name);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Send the metadata file `file_src` of the trace at `path` to the relay daemon. */
+static int send_metadata_file(const char *path, const char *file_src)
+{
+	int fd_src, ret = 0;
+	ssize_t readlen;
+	char buf[COPY_BUFLEN];
+	struct crash_output output = { -1, path, DEFAULT_METADATA_NAME, -1ULL, 0 };
+
+	DBG("Send metadata file '%s' to lttng-relayd", file_src);
+
+	fd_src = open(file_src, O_RDONLY);
+	if (fd_src < 0) {
+		PERROR("Error opening %s for reading", file_src);
+		return -errno;
+	}
+
+	for (;;) {
+		readlen = lttng_read(fd_src, buf, COPY_BUFLEN);
+		if (readlen < 0) {
+			PERROR("Error reading input file");
+			ret = -1;
+			break;
+		}
+		if (!readlen) {
+			break;
+		}
+
+		ret = send_relayd_metadata(&output, buf, readlen);
+		if (ret) {
+			break;
+		}
+	}
+
+	if (close_relayd_stream(&output)) {
+		ret = -1;
+	}
+
+	if (close(fd_src) < 0) {
+		PERROR("Error closing %s", file_src);
+	}
+	return ret;
+}
+
+/*
+ * Write `length` bytes of crash data to `fd_dest`.
+ *
+ * If `src_offset` is not negative, `data` is also found at that offset in the
+ * file `fd_src`: the kernel then copies it between the files, when it
+ * supports copying between them, to spare writing it from the mapped file.
+ */
+static int write_crash_data(
+	int fd_dest, int fd_src, off_t src_offset, const char *data, uint64_t length)
+{
+	ssize_t writelen;
+
+#ifdef HAVE_COPY_FILE_RANGE
+	while (src_offset >= 0 && length > 0) {
+		loff_t copy_offset = src_offset;
+		const ssize_t copied =
+			copy_file_range(fd_src, &copy_offset, fd_dest, nullptr, length, 0);
+
+		if (copied < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+			    errno == EOPNOTSUPP) {
+				/* Write the rest of the data instead. */
+				break;
+			}
+
+			PERROR("Error copying data to output file");
+			return -1;
+		}
+
+		if (copied == 0) {
+			break;
+		}
+
+		src_offset += copied;
+		data += copied;
+		length -= copied;
+	}
+#else /* HAVE_COPY_FILE_RANGE */
+	(void) fd_src;
+	(void) src_offset;
+#endif /* HAVE_COPY_FILE_RANGE */
+
+	if (length == 0) {
+		return 0;
+	}
+
+	writelen = lttng_write(fd_dest, data, length);
+	if (writelen < length) {
+		PERROR("Error writing to output file");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Copy the sub-buffer at `offset` of the ring buffer `buf` to `output`.
+ *
+ * If `buf_mapped` is true, `buf` maps the input file `fd_src` from its start.
+ * Only the headers of the ring buffer are read to find whether a sub-buffer
+ * holds any data: the pages of the sub-buffers without data of a mapped crash
+ * file are not read.
+ */
+static int copy_crash_subbuf(const struct lttng_crash_layout *layout,
+			     struct crash_output *output,
+			     int fd_src,
+			     char *buf,
+			     bool buf_mapped,
+			     uint64_t offset)
 {
 	uint64_t buf_size, subbuf_size, num_subbuf, sbidx, id, sb_bindex, rpages_offset, p_offset,
 		seq_cc, committed, commit_count_mask, consumed_cur, packet_size;
 	char *subbuf_ptr;
-	ssize_t writelen;
+	bool patched = false;
+	int ret;
 
 	/*
 	 * Get the current subbuffer by applying the proper mask to
@@ -730,14 +1151,23 @@ copy_crash_subbuf(const struct lttng_crash_layout *layout, int fd_dest, char *bu
 			       layout->length.packet_size);
 		}
 		packet_size = committed;
+		patched = true;
 	}
 
 	/*
-	 * Copy packet into fd_dest.
+	 * Copy packet into the output. A patched packet only differs from the
+	 * input file in its private mapping.
 	 */
-	writelen = lttng_write(fd_dest, subbuf_ptr, packet_size);
-	if (writelen < packet_size) {
-		PERROR("Error writing to output file");
+	if (the_relayd) {
+		ret = send_relayd_packet(output, subbuf_ptr, packet_size);
+	} else {
+		ret = write_crash_data(output->fd,
+				       fd_src,
+				       buf_mapped && !patched ? (off_t) p_offset : -1,
+				       subbuf_ptr,
+				       packet_size);
+	}
+	if (ret) {
 		return -1;
 	}
 	DBG("Copied %" PRIu64 " bytes of data", packet_size);
@@ -747,9 +1177,11 @@ nodata:
 	return -ENODATA;
 }
 
-static int copy_crash_data(const struct lttng_crash_layout *layout, int fd_dest, int fd_src)
+static int
+copy_crash_data(const struct lttng_crash_layout *layout, struct crash_output *output, int fd_src)
 {
 	char *buf;
+	bool buf_mapped = false;
 	int ret = 0, has_data = 0;
 	struct stat statbuf;
 	size_t src_file_len;
@@ -762,15 +1194,32 @@ static int copy_crash_data(const struct lttng_crash_layout *layout, int fd_dest,
 		return ret;
 	}
 	src_file_len = layout->mmap_length;
-	buf = calloc<char>(src_file_len);
-	if (!buf) {
-		return -1;
-	}
-	readlen = lttng_read(fd_src, buf, src_file_len);
-	if (readlen < 0) {
-		PERROR("Error reading input file");
-		ret = -1;
-		goto end;
+
+	/*
+	 * Map the ring buffer privately since the headers of the partially
+	 * committed sub-buffers are patched in memory. A truncated file is
+	 * read in a zeroed buffer instead, to not fault past its end.
+	 */
+	if ((uint64_t) statbuf.st_size >= src_file_len) {
+		buf = (char *) mmap(
+			nullptr, src_file_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd_src, 0);
+		if (buf == MAP_FAILED) {
+			PERROR("Error mapping input file");
+			return -1;
+		}
+
+		buf_mapped = true;
+	} else {
+		buf = calloc<char>(src_file_len);
+		if (!buf) {
+			return -1;
+		}
+		readlen = lttng_read(fd_src, buf, src_file_len);
+		if (readlen < 0) {
+			PERROR("Error reading input file");
+			ret = -1;
+			goto end;
+		}
 	}
 
 	prod_offset = crash_get_field(layout, buf, prod_offset);
@@ -780,7 +1229,7 @@ static int copy_crash_data(const struct lttng_crash_layout *layout, int fd_dest,
 	subbuf_size = layout->subbuf_size;
 
 	for (offset = consumed_offset; offset < prod_offset; offset += subbuf_size) {
-		ret = copy_crash_subbuf(layout, fd_dest, buf, offset);
+		ret = copy_crash_subbuf(layout, output, fd_src, buf, buf_mapped, offset);
 		if (!ret) {
 			has_data = 1;
 		}
@@ -789,7 +1238,13 @@ static int copy_crash_data(const struct lttng_crash_layout *layout, int fd_dest,
 		}
 	}
 end:
-	free(buf);
+	if (buf_mapped) {
+		if (munmap(buf, src_file_len)) {
+			PERROR("munmap");
+		}
+	} else {
+		free(buf);
+	}
 	if (ret && ret != -ENODATA) {
 		return ret;
 	}
@@ -800,11 +1255,20 @@ end:
 	}
 }
 
-static int
-extract_file(int output_dir_fd, const char *output_file, int input_dir_fd, const char *input_file)
+/*
+ * Extract the stream file `input_file` as `output_file`, in the directory
+ * `output_dir_fd` or, when sending the traces to a relay daemon, as a stream of
+ * the trace at `output_path`.
+ */
+static int extract_file(const char *output_path,
+			int output_dir_fd,
+			const char *output_file,
+			int input_dir_fd,
+			const char *input_file)
 {
-	int fd_dest, fd_src, ret = 0, closeret;
+	int fd_src, ret = 0, closeret;
 	struct lttng_crash_layout layout;
+	struct crash_output output = { -1, output_path, output_file, -1ULL, 0 };
 
 	layout.reverse_byte_order = 0; /* For reading magic number */
 
@@ -822,23 +1286,32 @@ extract_file(int output_dir_fd, const char *output_file, int input_dir_fd, const
 		goto close_src;
 	}
 
-	fd_dest = openat(output_dir_fd,
-			 output_file,
-			 O_RDWR | O_CREAT | O_EXCL,
-			 S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
-	if (fd_dest < 0) {
+	if (the_relayd) {
+		ret = copy_crash_data(&layout, &output, fd_src);
+		if (close_relayd_stream(&output) && (!ret || ret == -ENODATA)) {
+			ret = -1;
+		}
+
+		goto close_src;
+	}
+
+	output.fd = openat(output_dir_fd,
+			   output_file,
+			   O_RDWR | O_CREAT | O_EXCL,
+			   S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+	if (output.fd < 0) {
 		PERROR("Error opening '%s' for writing", output_file);
 		ret = -1;
 		goto close_src;
 	}
 
-	ret = copy_crash_data(&layout, fd_dest, fd_src);
+	ret = copy_crash_data(&layout, &output, fd_src);
 	if (ret) {
 		goto close_dest;
 	}
 
 close_dest:
-	closeret = close(fd_dest);
+	closeret = close(output.fd);
 	if (closeret) {
 		PERROR("close");
 	}
@@ -857,11 +1330,73 @@ end:
 	return ret;
 }
 
+namespace {
+/* Files of a trace directory shared by the extraction threads. */
+struct extraction_queue {
+	const char *output_path = nullptr;
+	int input_dir_fd = -1;
+	/* -1 when sending the traces to a relay daemon. */
+	int output_dir_fd = -1;
+	std::vector<std::string> files;
+	/* Index of the next file to extract. */
+	size_t next_file = 0;
+	/* First extraction error. */
+	int ret = 0;
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+};
+} /* namespace */
+
+/*
+ * Extract the files of `queue` until they are all extracted or the extraction
+ * of one of them fails.
+ */
+static void *extraction_thread(void *data)
+{
+	auto *queue = (struct extraction_queue *) data;
+
+	for (;;) {
+		const char *file;
+		int ret;
+
+		pthread_mutex_lock(&queue->lock);
+		if (queue->ret < 0 || queue->next_file == queue->files.size()) {
+			pthread_mutex_unlock(&queue->lock);
+			break;
+		}
+
+		file = queue->files[queue->next_file++].c_str();
+		pthread_mutex_unlock(&queue->lock);
+
+		ret = extract_file(
+			queue->output_path, queue->output_dir_fd, file, queue->input_dir_fd, file);
+		if (ret == -ENODATA) {
+			DBG("No data in file '%s', skipping", file);
+		} else if (ret < 0) {
+			pthread_mutex_lock(&queue->lock);
+			if (!queue->ret) {
+				queue->ret = ret;
+			}
+			pthread_mutex_unlock(&queue->lock);
+		} else if (ret > 0) {
+			DBG("Skipping file '%s'", file);
+		}
+	}
+
+	return nullptr;
+}
+
+/*
+ * Extract the files of a trace directory, one per online CPU at a time: each
+ * file holds the ring buffer of a stream.
+ */
 static int extract_all_files(const char *output_path, const char *input_path)
 {
-	DIR *input_dir, *output_dir;
-	int input_dir_fd, output_dir_fd, ret = 0, closeret;
+	DIR *input_dir, *output_dir = nullptr;
+	int ret = 0, closeret;
 	struct dirent *entry; /* input */
+	struct extraction_queue queue;
+	std::vector<pthread_t> threads;
+	long thread_count;
 
 	/* Open input directory */
 	input_dir = opendir(input_path);
@@ -869,43 +1404,64 @@ static int extract_all_files(const char *output_path, const char *input_path)
 		PERROR("Cannot open '%s' path", input_path);
 		return -1;
 	}
-	input_dir_fd = dirfd(input_dir);
-	if (input_dir_fd < 0) {
+	queue.input_dir_fd = dirfd(input_dir);
+	if (queue.input_dir_fd < 0) {
 		PERROR("dirfd");
 		return -1;
 	}
 
+	queue.output_path = output_path;
+
 	/* Open output directory */
-	output_dir = opendir(output_path);
-	if (!output_dir) {
-		PERROR("Cannot open '%s' path", output_path);
-		return -1;
-	}
-	output_dir_fd = dirfd(output_dir);
-	if (output_dir_fd < 0) {
-		PERROR("dirfd");
-		return -1;
+	if (!the_relayd) {
+		output_dir = opendir(output_path);
+		if (!output_dir) {
+			PERROR("Cannot open '%s' path", output_path);
+			return -1;
+		}
+		queue.output_dir_fd = dirfd(output_dir);
+		if (queue.output_dir_fd < 0) {
+			PERROR("dirfd");
+			return -1;
+		}
 	}
 
-	while ((entry = readdir(input_dir))) {
-		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
-			continue;
-		ret = extract_file(output_dir_fd, entry->d_name, input_dir_fd, entry->d_name);
-		if (ret == -ENODATA) {
-			DBG("No data in file '%s', skipping", entry->d_name);
-			ret = 0;
-			continue;
-		} else if (ret < 0) {
-			break;
-		} else if (ret > 0) {
-			DBG("Skipping file '%s'", entry->d_name);
-			ret = 0;
-			continue;
+	try {
+		while ((entry = readdir(input_dir))) {
+			if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+				continue;
+			queue.files.emplace_back(entry->d_name);
+		}
+
+		thread_count = std::min<long>(sysconf(_SC_NPROCESSORS_ONLN), queue.files.size());
+		for (long i = 1; i < thread_count; i++) {
+			pthread_t thread;
+
+			if (pthread_create(&thread, nullptr, extraction_thread, &queue)) {
+				DBG("Failed to create extraction thread: thread count = %zu",
+				    threads.size() + 1);
+				break;
+			}
+
+			threads.push_back(thread);
 		}
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate the list of files of '%s'", input_path);
+		queue.ret = -1;
 	}
-	closeret = closedir(output_dir);
-	if (closeret) {
-		PERROR("closedir");
+
+	/* The current thread extracts files too. */
+	(void) extraction_thread(&queue);
+	for (const auto thread : threads) {
+		(void) pthread_join(thread, nullptr);
+	}
+
+	ret = queue.ret;
+	if (output_dir) {
+		closeret = closedir(output_dir);
+		if (closeret) {
+			PERROR("closedir");
+		}
 	}
 	closeret = closedir(input_dir);
 	if (closeret) {
@@ -930,7 +1486,11 @@ static int extract_one_trace(const char *output_path, const char *input_path)
 	src[PATH_MAX - 1] = '\0';
 	strncat(src, "/metadata", PATH_MAX - strlen(dest) - 1);
 
-	ret = copy_file(dest, src);
+	if (the_relayd) {
+		ret = send_metadata_file(output_path, src);
+	} else {
+		ret = copy_file(dest, src);
+	}
 	if (ret) {
 		return ret;
 	}
@@ -1002,11 +1562,14 @@ static int extract_trace_recursive(const char *output_path, const char *input_pa
 				entry->d_name,
 				sizeof(output_subpath) - strlen(output_subpath) - 1);
 
-			ret = mkdir(output_subpath, S_IRWXU | S_IRWXG);
-			if (ret) {
-				PERROR("mkdir");
-				has_warning = 1;
-				goto end;
+			/* The relay daemon creates the directories of the streams. */
+			if (!the_relayd) {
+				ret = mkdir(output_subpath, S_IRWXU | S_IRWXG);
+				if (ret) {
+					PERROR("mkdir");
+					has_warning = 1;
+					goto end;
+				}
 			}
 
 			strncpy(input_subpath, input_path, sizeof(input_subpath));
@@ -1191,7 +1754,15 @@ int main(int argc, char *argv[])
 		goto end;
 	}
 
-	if (opt_output_path) {
+	if (opt_relayd_url) {
+		/* The output path is relative to the trace chunk. */
+		output_path = "";
+		ret = connect_relayd(opt_relayd_url);
+		if (ret) {
+			has_warning = true;
+			goto end;
+		}
+	} else if (opt_output_path) {
 		output_path = opt_output_path;
 		ret = mkdir(output_path, S_IRWXU | S_IRWXG);
 		if (ret) {
@@ -1209,6 +1780,7 @@ int main(int argc, char *argv[])
 	}
 
 	ret = extract_trace_recursive(output_path, the_input_path);
+	disconnect_relayd();
 	if (ret < 0) {
 		has_warning = true;
 		goto end;
@@ -1216,7 +1788,7 @@ int main(int argc, char *argv[])
 		/* extract_trace_recursive reported a warning. */
 		has_warning = true;
 	}
-	if (!opt_output_path) {
+	if (!opt_output_path && !opt_relayd_url) {
 		/* View trace */
 		ret = view_trace(output_path, opt_viewer_path);
 		if (ret) {
@@ -0,0 +1,739 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "chunk-migrator.hpp"
+#include "lttng-relayd.hpp"
+#include "token-bucket.hpp"
+#include "utils.hpp"
+
+#include <common/common.hpp>
+#include <common/fd-tracker/utils.hpp>
+#include <common/path.hpp>
+#include <common/readwrite.hpp>
+#include <common/time.hpp>
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <urcu/list.h>
+#include <urcu/uatomic.h>
+
+namespace {
+const unsigned long max_thread_count = 64;
+/* Keeps the tokens of the bucket far from overflowing. */
+const uint64_t max_rate = (uint64_t) INT64_MAX / 2;
+const size_t copy_buffer_size = 256 * 1024;
+/* Longest wait of a thread before checking whether it must quit. */
+const uint64_t max_wait_ns = 100 * NSEC_PER_MSEC;
+
+struct chunk_migration {
+	struct cds_list_head node;
+	/* Relative to the output directory. */
+	char *path;
+};
+
+struct copied_file {
+	const char *src_path;
+	const char *dst_path;
+	mode_t mode;
+};
+
+char *archive_output;
+/* Shell command run on each archived trace chunk, if any. */
+char *archive_command;
+unsigned int thread_count = 1;
+
+pthread_mutex_t migrations_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when a migration is queued or when the threads must quit. */
+pthread_cond_t migration_queued = PTHREAD_COND_INITIALIZER;
+/* Queued chunk_migration, protected by `migrations_lock`. */
+CDS_LIST_HEAD(migrations);
+pthread_t *threads;
+unsigned int started_thread_count;
+bool started;
+bool quit;
+/* Protected by `migrations_lock`, except `copied_bytes` which is atomic. */
+struct chunk_migrator_stats stats;
+
+pthread_mutex_t bucket_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Bytes copied by all the threads, protected by `bucket_lock`. */
+struct token_bucket copy_bucket;
+
+bool must_quit()
+{
+	return CMM_LOAD_SHARED(quit);
+}
+
+/*
+ * Account for `len` bytes about to be copied and wait until the bucket
+ * refilled the overspent tokens, if any.
+ *
+ * Return 0 on success, -1 if the thread must quit.
+ */
+int bucket_consume(uint64_t len)
+{
+	uint64_t delay_ns;
+
+	if (copy_bucket.rate == 0) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&bucket_lock);
+	(void) token_bucket_refill(&copy_bucket);
+	token_bucket_consume(&copy_bucket, len);
+	delay_ns = token_bucket_deficit_ns(&copy_bucket);
+	pthread_mutex_unlock(&bucket_lock);
+
+	while (delay_ns > 0) {
+		const uint64_t wait_ns = std::min(delay_ns, max_wait_ns);
+		struct timespec wait = {};
+
+		if (must_quit()) {
+			return -1;
+		}
+
+		wait.tv_sec = wait_ns / NSEC_PER_SEC;
+		wait.tv_nsec = wait_ns % NSEC_PER_SEC;
+		while (nanosleep(&wait, &wait) && errno == EINTR) {
+		}
+
+		delay_ns -= wait_ns;
+	}
+
+	return 0;
+}
+
+int open_copied_file(void *data, int *out_fds)
+{
+	const struct copied_file *file = (const struct copied_file *) data;
+
+	out_fds[0] = open(file->src_path, O_RDONLY);
+	if (out_fds[0] < 0) {
+		return -errno;
+	}
+
+	/* Never overwrite the data of the archive output. */
+	out_fds[1] = open(file->dst_path, O_WRONLY | O_CREAT | O_EXCL, file->mode);
+	if (out_fds[1] < 0) {
+		const int err = errno;
+
+		(void) close(out_fds[0]);
+		return -err;
+	}
+
+	return 0;
+}
+
+/*
+ * Copy a file to the archive output and fsync the copy so that the source
+ * can be removed.
+ *
+ * Return 0 on success, -1 on error or if the thread must quit.
+ */
+int copy_file(const char *src_path, const char *dst_path, mode_t mode)
+{
+	int ret, fds[2] = { -1, -1 };
+	const char *names[] = { "Migrated trace chunk file", "Archived trace chunk file" };
+	struct copied_file file = { src_path, dst_path, mode };
+	char *buffer;
+
+	buffer = calloc<char>(copy_buffer_size);
+	if (!buffer) {
+		PERROR("Failed to allocate trace chunk copy buffer");
+		return -1;
+	}
+
+	ret = fd_tracker_open_unsuspendable_fd(
+		the_fd_tracker, fds, names, 2, open_copied_file, &file);
+	if (ret < 0) {
+		ERR("Failed to open file \"%s\" to copy it to \"%s\"", src_path, dst_path);
+		ret = -1;
+		goto end;
+	}
+
+	while (true) {
+		ssize_t read_len, write_len;
+
+		if (must_quit()) {
+			ret = -1;
+			goto error;
+		}
+
+		read_len = lttng_read(fds[0], buffer, copy_buffer_size);
+		if (read_len < 0) {
+			PERROR("Failed to read file \"%s\"", src_path);
+			ret = -1;
+			goto error;
+		} else if (read_len == 0) {
+			break;
+		}
+
+		if (bucket_consume(read_len)) {
+			ret = -1;
+			goto error;
+		}
+
+		write_len = lttng_write(fds[1], buffer, read_len);
+		if (write_len != read_len) {
+			PERROR("Failed to write file \"%s\"", dst_path);
+			ret = -1;
+			goto error;
+		}
+
+		uatomic_add(&stats.copied_bytes, (uint64_t) read_len);
+		if ((size_t) read_len < copy_buffer_size) {
+			break;
+		}
+	}
+
+	ret = fsync(fds[1]);
+	if (ret) {
+		PERROR("Failed to sync file \"%s\"", dst_path);
+		ret = -1;
+		goto error;
+	}
+
+	goto end_close;
+
+error:
+	if (unlink(dst_path)) {
+		PERROR("Failed to remove partial copy \"%s\"", dst_path);
+	}
+end_close:
+	if (fd_tracker_close_unsuspendable_fd(
+		    the_fd_tracker, fds, 2, fd_tracker_util_close_fd, nullptr)) {
+		PERROR("Failed to close the files of the copy of \"%s\"", src_path);
+	}
+end:
+	free(buffer);
+	return ret;
+}
+
+/*
+ * Copy a directory to the archive output, removing each file once copied
+ * and then the directory itself.
+ *
+ * Return 0 on success, -1 on error or if the thread must quit.
+ */
+int copy_directory(const char *src_path, const char *dst_path, mode_t mode)
+{
+	int ret = 0;
+	DIR *dir;
+	struct dirent *entry;
+
+	/* The directory exists if a previous migration was interrupted. */
+	if (mkdir(dst_path, mode) && errno != EEXIST) {
+		PERROR("Failed to create directory \"%s\"", dst_path);
+		return -1;
+	}
+
+	dir = opendir(src_path);
+	if (!dir) {
+		PERROR("Failed to open directory \"%s\"", src_path);
+		return -1;
+	}
+
+	while (ret == 0) {
+		char *src_entry_path = nullptr, *dst_entry_path = nullptr;
+		struct stat st;
+
+		errno = 0;
+		entry = readdir(dir);
+		if (!entry) {
+			if (errno) {
+				PERROR("Failed to read directory \"%s\"", src_path);
+				ret = -1;
+			}
+			break;
+		}
+
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+			continue;
+		}
+
+		if (asprintf(&src_entry_path, "%s/%s", src_path, entry->d_name) < 0 ||
+		    asprintf(&dst_entry_path, "%s/%s", dst_path, entry->d_name) < 0) {
+			PERROR("Failed to format the paths of a migrated trace chunk file");
+			free(src_entry_path);
+			ret = -1;
+			break;
+		}
+
+		if (lstat(src_entry_path, &st)) {
+			PERROR("Failed to stat \"%s\"", src_entry_path);
+			ret = -1;
+		} else if (S_ISDIR(st.st_mode)) {
+			ret = copy_directory(src_entry_path, dst_entry_path, st.st_mode & 07777);
+		} else if (S_ISREG(st.st_mode)) {
+			ret = copy_file(src_entry_path, dst_entry_path, st.st_mode & 07777);
+			if (ret == 0 && unlink(src_entry_path)) {
+				PERROR("Failed to remove migrated file \"%s\"", src_entry_path);
+				ret = -1;
+			}
+		} else {
+			ERR("Refusing to migrate \"%s\": not a regular file or directory",
+			    src_entry_path);
+			ret = -1;
+		}
+
+		free(src_entry_path);
+		free(dst_entry_path);
+	}
+
+	if (closedir(dir)) {
+		PERROR("Failed to close directory \"%s\"", src_path);
+	}
+
+	if (ret == 0 && rmdir(src_path)) {
+		PERROR("Failed to remove migrated directory \"%s\"", src_path);
+		ret = -1;
+	}
+
+	return ret;
+}
+
+/* Return 0 on success, -1 on error or if the thread must quit. */
+int migrate_chunk(const char *path)
+{
+	int ret;
+	char *src_path, *dst_path = nullptr, *dst_parent_path = nullptr;
+	struct stat st;
+
+	src_path = create_output_path(path);
+	if (!src_path) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = asprintf(&dst_path, "%s/%s", archive_output, path);
+	if (ret < 0) {
+		PERROR("Failed to format archived trace chunk path");
+		dst_path = nullptr;
+		ret = -1;
+		goto end;
+	}
+
+	dst_parent_path = strdup(dst_path);
+	if (!dst_parent_path) {
+		PERROR("Failed to copy archived trace chunk path");
+		ret = -1;
+		goto end;
+	}
+
+	*strrchr(dst_parent_path, '/') = '\0';
+	ret = utils_mkdir_recursive(dst_parent_path, S_IRWXU | S_IRWXG, -1, -1);
+	if (ret) {
+		ERR("Failed to create archive output directory \"%s\"", dst_parent_path);
+		ret = -1;
+		goto end;
+	}
+
+	DBG("Migrating trace chunk \"%s\" to \"%s\"", src_path, dst_path);
+	ret = rename(src_path, dst_path);
+	if (ret == 0) {
+		goto end;
+	} else if (errno != EXDEV) {
+		PERROR("Failed to rename trace chunk \"%s\" to \"%s\"", src_path, dst_path);
+		ret = -1;
+		goto end;
+	}
+
+	/* The archive output is on another file system. */
+	ret = lstat(src_path, &st);
+	if (ret) {
+		PERROR("Failed to stat trace chunk \"%s\"", src_path);
+		ret = -1;
+		goto end;
+	}
+
+	ret = copy_directory(src_path, dst_path, st.st_mode & 07777);
+	if (ret && must_quit()) {
+		WARN("Trace chunk migration interrupted: \"%s\" is left partially migrated "
+		     "to \"%s\"",
+		     src_path,
+		     dst_path);
+	}
+end:
+	free(src_path);
+	free(dst_path);
+	free(dst_parent_path);
+	return ret;
+}
+
+/*
+ * Run the archive command on the trace chunk found at `path` and wait for it
+ * to exit. The command receives the path as its first positional parameter;
+ * it is terminated if the thread must quit.
+ *
+ * Return 0 if the command succeeded, -1 otherwise.
+ */
+int run_archive_command(const char *path)
+{
+	int status;
+	pid_t pid;
+
+	DBG("Running archive command on trace chunk \"%s\": `%s`", path, archive_command);
+	pid = fork();
+	if (pid < 0) {
+		PERROR("Failed to fork the archive command of trace chunk \"%s\"", path);
+		return -1;
+	} else if (pid == 0) {
+		/* Child: `$1` is the path of the trace chunk. */
+		(void) execl("/bin/sh", "sh", "-c", archive_command, "sh", path, (char *) nullptr);
+		_exit(127);
+	}
+
+	while (true) {
+		const pid_t wait_ret = waitpid(pid, &status, WNOHANG);
+
+		if (wait_ret == pid) {
+			break;
+		} else if (wait_ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			PERROR("Failed to wait for the archive command of trace chunk \"%s\"",
+			       path);
+			return -1;
+		}
+
+		if (must_quit()) {
+			WARN("Interrupting the archive command of trace chunk \"%s\"", path);
+			(void) kill(pid, SIGTERM);
+			while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+			}
+			return -1;
+		}
+
+		{
+			struct timespec wait = {};
+
+			wait.tv_nsec = max_wait_ns;
+			(void) nanosleep(&wait, nullptr);
+		}
+	}
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		if (WIFEXITED(status)) {
+			ERR("Archive command of trace chunk \"%s\" exited with status %d",
+			    path,
+			    WEXITSTATUS(status));
+		} else {
+			ERR("Archive command of trace chunk \"%s\" was terminated by signal %d",
+			    path,
+			    WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+		}
+
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Migrate a trace chunk, if an archive output is set, and run the archive
+ * command on it, if any.
+ *
+ * Return 0 on success, -1 on error or if the thread must quit.
+ */
+int archive_chunk(const char *path)
+{
+	int ret;
+	char *archived_path;
+
+	if (archive_output) {
+		ret = migrate_chunk(path);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	if (!archive_command) {
+		return 0;
+	}
+
+	if (archive_output) {
+		if (asprintf(&archived_path, "%s/%s", archive_output, path) < 0) {
+			PERROR("Failed to format archived trace chunk path");
+			return -1;
+		}
+	} else {
+		archived_path = create_output_path(path);
+		if (!archived_path) {
+			return -1;
+		}
+	}
+
+	ret = run_archive_command(archived_path);
+	if (ret) {
+		pthread_mutex_lock(&migrations_lock);
+		stats.failed_commands++;
+		pthread_mutex_unlock(&migrations_lock);
+	}
+
+	free(archived_path);
+	return ret;
+}
+
+void *migrator_thread(void *data)
+{
+	const unsigned int id = (unsigned int) (uintptr_t) data;
+
+	DBG("[thread] Relay trace chunk migrator %u started", id);
+
+	pthread_mutex_lock(&migrations_lock);
+	while (!quit) {
+		struct chunk_migration *migration;
+		int ret;
+
+		if (cds_list_empty(&migrations)) {
+			pthread_cond_wait(&migration_queued, &migrations_lock);
+			continue;
+		}
+
+		migration = cds_list_first_entry(&migrations, struct chunk_migration, node);
+		cds_list_del(&migration->node);
+		pthread_mutex_unlock(&migrations_lock);
+
+		ret = archive_chunk(migration->path);
+
+		pthread_mutex_lock(&migrations_lock);
+		stats.pending_chunks--;
+		if (ret) {
+			stats.failed_chunks++;
+		} else {
+			stats.migrated_chunks++;
+			DBG("Migrated trace chunk \"%s\"", migration->path);
+		}
+
+		free(migration->path);
+		free(migration);
+	}
+	pthread_mutex_unlock(&migrations_lock);
+
+	DBG("Relay trace chunk migrator %u exiting", id);
+	return nullptr;
+}
+} /* namespace */
+
+int chunk_migrator_set_archive_output(const char *path)
+{
+	char *expanded_path;
+
+	if (!path || *path == '\0') {
+		ERR("Invalid archive output: empty path");
+		return -1;
+	}
+
+	expanded_path = utils_expand_path(path);
+	if (!expanded_path) {
+		ERR("Invalid archive output: `%s`", path);
+		return -1;
+	}
+
+	free(archive_output);
+	archive_output = expanded_path;
+	return 0;
+}
+
+int chunk_migrator_set_archive_command(const char *command)
+{
+	if (!command || *command == '\0') {
+		ERR("Invalid archive command: empty command");
+		return -1;
+	}
+
+	free(archive_command);
+	archive_command = strdup(command);
+	if (!archive_command) {
+		PERROR("Failed to copy archive command");
+		return -1;
+	}
+
+	return 0;
+}
+
+int chunk_migrator_set_thread_count(const char *count)
+{
+	unsigned long value;
+	char *end;
+
+	errno = 0;
+	value = strtoul(count, &end, 10);
+	if (errno || !isdigit((unsigned char) count[0]) || *end != '\0' || value == 0 ||
+	    value > max_thread_count) {
+		ERR("Invalid trace chunk migration thread count: `%s` (expecting 1 to %lu)",
+		    count,
+		    max_thread_count);
+		return -1;
+	}
+
+	thread_count = (unsigned int) value;
+	return 0;
+}
+
+int chunk_migrator_set_rate(const char *rate)
+{
+	uint64_t value;
+
+	if (utils_parse_size_suffix(rate, &value) || value > max_rate) {
+		ERR("Invalid trace chunk migration rate: `%s`", rate);
+		return -1;
+	}
+
+	token_bucket_init(&copy_bucket, value);
+	return 0;
+}
+
+bool chunk_migrator_enabled()
+{
+	return archive_output != nullptr || archive_command != nullptr;
+}
+
+int chunk_migrator_start()
+{
+	LTTNG_ASSERT(chunk_migrator_enabled());
+	LTTNG_ASSERT(!threads);
+
+	if (archive_output &&
+	    utils_mkdir_recursive(archive_output, S_IRWXU | S_IRWXG, -1, -1)) {
+		ERR("Failed to create archive output directory \"%s\"", archive_output);
+		return -1;
+	}
+
+	threads = calloc<pthread_t>(thread_count);
+	if (!threads) {
+		PERROR("Failed to allocate trace chunk migration threads");
+		return -1;
+	}
+
+	pthread_mutex_lock(&migrations_lock);
+	started = true;
+	pthread_mutex_unlock(&migrations_lock);
+
+	for (started_thread_count = 0; started_thread_count < thread_count;
+	     started_thread_count++) {
+		const int ret = pthread_create(&threads[started_thread_count],
+					       default_pthread_attr(),
+					       migrator_thread,
+					       (void *) (uintptr_t) started_thread_count);
+
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create trace chunk migrator %u", started_thread_count);
+			return -1;
+		}
+	}
+
+	DBG("Relay trace chunk migration enabled: archive output = \"%s\", archive command = `%s`, "
+	    "thread count = %u, rate = %" PRIu64 " bytes/s",
+	    archive_output ? archive_output : "none",
+	    archive_command ? archive_command : "none",
+	    thread_count,
+	    copy_bucket.rate);
+	return 0;
+}
+
+void chunk_migrator_stop()
+{
+	struct chunk_migration *migration, *tmp;
+
+	if (!threads) {
+		return;
+	}
+
+	pthread_mutex_lock(&migrations_lock);
+	CMM_STORE_SHARED(quit, true);
+	pthread_cond_broadcast(&migration_queued);
+	pthread_mutex_unlock(&migrations_lock);
+
+	for (unsigned int i = 0; i < started_thread_count; i++) {
+		const int ret = pthread_join(threads[i], nullptr);
+
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join trace chunk migrator %u", i);
+		}
+	}
+
+	pthread_mutex_lock(&migrations_lock);
+	cds_list_for_each_entry_safe (migration, tmp, &migrations, node) {
+		WARN("Abandoning the migration of trace chunk \"%s\"", migration->path);
+		cds_list_del(&migration->node);
+		stats.pending_chunks--;
+		free(migration->path);
+		free(migration);
+	}
+	pthread_mutex_unlock(&migrations_lock);
+
+	free(threads);
+	threads = nullptr;
+	started_thread_count = 0;
+}
+
+int chunk_migrator_queue(const char *path)
+{
+	int ret = 0;
+	struct chunk_migration *migration;
+
+	migration = zmalloc<chunk_migration>();
+	if (!migration) {
+		PERROR("Failed to allocate trace chunk migration");
+		return -1;
+	}
+
+	migration->path = strdup(path);
+	if (!migration->path) {
+		PERROR("Failed to copy migrated trace chunk path");
+		free(migration);
+		return -1;
+	}
+
+	pthread_mutex_lock(&migrations_lock);
+	if (!started || quit) {
+		WARN("Not migrating trace chunk \"%s\": the migration threads are not running",
+		     path);
+		ret = -1;
+		goto end_unlock;
+	}
+
+	cds_list_add_tail(&migration->node, &migrations);
+	migration = nullptr;
+	stats.pending_chunks++;
+	pthread_cond_signal(&migration_queued);
+	DBG("Queued the migration of trace chunk \"%s\"", path);
+
+end_unlock:
+	pthread_mutex_unlock(&migrations_lock);
+	if (migration) {
+		free(migration->path);
+		free(migration);
+	}
+	return ret;
+}
+
+void chunk_migrator_get_stats(struct chunk_migrator_stats *stats_out)
+{
+	pthread_mutex_lock(&migrations_lock);
+	*stats_out = stats;
+	pthread_mutex_unlock(&migrations_lock);
+	stats_out->copied_bytes = uatomic_read(&stats.copied_bytes);
+}
@@ -0,0 +1,101 @@
+#ifndef _CHUNK_MIGRATOR_H
+#define _CHUNK_MIGRATOR_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdint.h>
+
+/*
+ * Migration of the closed trace chunks to an archive output.
+ *
+ * When an archive output is set, the trace chunks are written to the
+ * output directory of the relay daemon, typically on fast local storage,
+ * and each closed trace chunk is migrated to the same relative path under
+ * the archive output once the last reference to it is released, that is
+ * once its close command, if any, was performed and all its files are
+ * closed.
+ *
+ * Dedicated threads migrate one trace chunk at a time each. A trace chunk
+ * is renamed when the archive output is on the same file system as the
+ * output directory. Otherwise, its files are copied, at a rate optionally
+ * limited for all the threads, and each file is removed from the output
+ * directory once copied.
+ *
+ * When an archive command is set, the threads run it on each closed trace
+ * chunk once migrated, or once closed without an archive output, to
+ * compress or upload it, for instance. The relay daemon doesn't touch the
+ * trace chunk afterwards.
+ */
+struct chunk_migrator_stats {
+	/* Trace chunks queued or being migrated. */
+	uint64_t pending_chunks;
+	uint64_t migrated_chunks;
+	uint64_t failed_chunks;
+	/* Bytes copied to the archive output. */
+	uint64_t copied_bytes;
+	/* Archive commands which failed or were interrupted. */
+	uint64_t failed_commands;
+};
+
+/*
+ * Set the archive output to which the closed trace chunks are migrated.
+ *
+ * Return 0 on success, -1 if the path is invalid.
+ */
+int chunk_migrator_set_archive_output(const char *path);
+
+/*
+ * Set the shell command run on each closed trace chunk, its path being
+ * passed as the first positional parameter.
+ *
+ * Return 0 on success, -1 if the command is invalid.
+ */
+int chunk_migrator_set_archive_command(const char *command);
+
+/*
+ * Set the number of migration threads.
+ *
+ * Return 0 on success, -1 if the count is invalid.
+ */
+int chunk_migrator_set_thread_count(const char *count);
+
+/*
+ * Set the maximal rate, in bytes per second, at which the migration
+ * threads copy data from a size with an optional `k`, `M` or `G` suffix.
+ *
+ * Return 0 on success, -1 if the rate is invalid.
+ */
+int chunk_migrator_set_rate(const char *rate);
+
+bool chunk_migrator_enabled();
+
+/*
+ * Start the migration threads.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int chunk_migrator_start();
+
+/*
+ * Stop the migration threads. The migrations in progress are interrupted
+ * and the queued ones are abandoned; their trace chunks stay in the output
+ * directory.
+ */
+void chunk_migrator_stop();
+
+/*
+ * Queue the migration of the trace chunk found at `path`, relative to the
+ * output directory.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int chunk_migrator_queue(const char *path);
+
+void chunk_migrator_get_stats(struct chunk_migrator_stats *stats);
+
+#endif /* _CHUNK_MIGRATOR_H */
@@ -9,12 +9,19 @@
 
 #define _LGPL_SOURCE
 #include "connection.hpp"
+#include "forwarder.hpp"
+#include "lttng-relayd.hpp"
+#include "memory-budget.hpp"
+#include "stream-writer.hpp"
 #include "stream.hpp"
 #include "viewer-session.hpp"
 
 #include <common/common.hpp>
+#include <common/fd-tracker/utils.hpp>
 #include <common/urcu.hpp>
 
+#include <string.h>
+#include <unistd.h>
 #include <urcu/rculist.h>
 
 bool connection_get(struct relay_connection *conn)
@@ -81,6 +88,15 @@ end:
 	return ret;
 }
 
+static void viewer_file_range_destroy(void *ptr)
+{
+	const auto *range = (struct viewer_file_range *) ptr;
+
+	if (range->fd >= 0 && close(range->fd)) {
+		PERROR("Failed to close stream file of viewer connection");
+	}
+}
+
 struct relay_connection *connection_create(struct lttcomm_sock *sock, enum connection_type type)
 {
 	struct relay_connection *conn;
@@ -96,6 +112,18 @@ struct relay_connection *connection_create(struct lttcomm_sock *sock, enum conne
 	lttng_ht_node_init_ulong(&conn->sock_n, (unsigned long) conn->sock->fd);
 	if (conn->type == RELAY_CONTROL) {
 		lttng_dynamic_buffer_init(&conn->protocol.ctrl.reception_buffer);
+	} else if (conn->type == RELAY_DATA) {
+		conn->protocol.data.splice_pipe[0] = -1;
+		conn->protocol.data.splice_pipe[1] = -1;
+		lttng_dynamic_buffer_init(&conn->protocol.data.reception_buffer);
+	} else if (conn->type == RELAY_CONNECTION_UNKNOWN) {
+		/* Live viewer connection, typed by its LTTNG_VIEWER_CONNECT command. */
+		lttng_dynamic_buffer_init(&conn->protocol.viewer.output);
+		lttng_dynamic_array_init(&conn->protocol.viewer.file_ranges,
+					 sizeof(struct viewer_file_range),
+					 viewer_file_range_destroy);
+		CDS_INIT_LIST_HEAD(&conn->protocol.viewer.index_wait.waiter.node);
+		conn->protocol.viewer.index_wait.waiter.wakeup_fd = -1;
 	}
 	connection_reset_protocol_state(conn);
 end:
@@ -114,6 +142,15 @@ static void rcu_free_connection(struct rcu_head *head)
 	}
 	if (conn->type == RELAY_CONTROL) {
 		lttng_dynamic_buffer_reset(&conn->protocol.ctrl.reception_buffer);
+	} else if (conn->type == RELAY_DATA) {
+		memory_budget_release(MEMORY_BUDGET_RECEIVE_BUFFER,
+				      conn->protocol.data.reception_buffer.size);
+		lttng_dynamic_buffer_reset(&conn->protocol.data.reception_buffer);
+	} else {
+		memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER,
+				      conn->protocol.viewer.output.size);
+		lttng_dynamic_buffer_reset(&conn->protocol.viewer.output);
+		lttng_dynamic_array_reset(&conn->protocol.viewer.file_ranges);
 	}
 	free(conn);
 }
@@ -136,6 +173,15 @@ static void connection_release(struct urcu_ref *ref)
 		LTTNG_ASSERT(!ret);
 	}
 
+	if (conn->type == RELAY_DATA) {
+		for (auto& entry : conn->protocol.data.stream_cache) {
+			if (entry.stream) {
+				stream_put(entry.stream);
+				entry.stream = nullptr;
+			}
+		}
+	}
+
 	if (conn->session) {
 		if (session_close(conn->session)) {
 			ERR("session_close");
@@ -145,6 +191,27 @@ static void connection_release(struct urcu_ref *ref)
 	if (conn->viewer_session) {
 		viewer_session_close(conn->viewer_session);
 	}
+	if (conn->type == RELAY_DATA) {
+		const uint64_t receive_calls = conn->protocol.data.receive_calls;
+
+		DBG("Data connection statistics: sock = %d, received bytes = %" PRIu64
+		    ", receive calls = %" PRIu64 ", bytes per receive call = %" PRIu64,
+		    conn->sock->fd,
+		    conn->protocol.data.received_bytes,
+		    receive_calls,
+		    receive_calls ? conn->protocol.data.received_bytes / receive_calls : 0);
+		if (conn->protocol.data.splice_pipe[0] >= 0) {
+			(void) fd_tracker_util_pipe_close(the_fd_tracker,
+							  conn->protocol.data.splice_pipe);
+		}
+		if (conn->protocol.data.state_id == DATA_CONNECTION_STATE_RECEIVE_PAYLOAD) {
+			/* Partially received packet. */
+			stream_write_packet_destroy(
+				conn->protocol.data.state.receive_payload.packet);
+			forwarder_packet_destroy(
+				conn->protocol.data.state.receive_payload.forward);
+		}
+	}
 	destroy_connection(conn);
 }
 
@@ -184,3 +251,55 @@ int connection_set_session(struct relay_connection *conn, struct relay_session *
 	}
 	return ret;
 }
+
+struct relay_stream *connection_get_stream_by_id(struct relay_connection *conn, uint64_t stream_id)
+{
+	struct data_connection_cached_stream *cache = conn->protocol.data.stream_cache;
+	struct relay_stream *stream = nullptr;
+	unsigned int i;
+
+	LTTNG_ASSERT(conn->type == RELAY_DATA);
+
+	for (i = 0; i < RELAY_CONNECTION_STREAM_CACHE_SIZE && cache[i].stream; i++) {
+		if (cache[i].stream_id == stream_id) {
+			stream = cache[i].stream;
+			break;
+		}
+	}
+
+	if (stream && !CMM_LOAD_SHARED(stream->in_stream_ht)) {
+		/* The stream was closed since it was cached: evict it. */
+		stream_put(stream);
+		memmove(&cache[i],
+			&cache[i + 1],
+			(RELAY_CONNECTION_STREAM_CACHE_SIZE - i - 1) * sizeof(*cache));
+		cache[RELAY_CONNECTION_STREAM_CACHE_SIZE - 1].stream = nullptr;
+		stream = nullptr;
+	}
+
+	if (!stream) {
+		stream = stream_get_by_id(stream_id);
+		if (!stream) {
+			return nullptr;
+		}
+
+		/* Evict the least recently used stream, if the cache is full. */
+		for (i = 0; i < RELAY_CONNECTION_STREAM_CACHE_SIZE - 1 && cache[i].stream; i++) {
+		}
+		if (cache[i].stream) {
+			stream_put(cache[i].stream);
+		}
+	}
+
+	/* Move the stream to the front of the cache, which owns a reference to it. */
+	memmove(&cache[1], &cache[0], i * sizeof(*cache));
+	cache[0].stream_id = stream_id;
+	cache[0].stream = stream;
+
+	/* Reference owned by the caller. */
+	lttng::urcu::read_lock_guard read_lock;
+	const bool reference_acquired = stream_get(stream);
+
+	LTTNG_ASSERT(reference_acquired);
+	return stream;
+}
@@ -11,7 +11,9 @@
  */
 
 #include "session.hpp"
+#include "stream.hpp"
 
+#include <common/dynamic-array.hpp>
 #include <common/dynamic-buffer.hpp>
 #include <common/hashtable/hashtable.hpp>
 #include <common/sessiond-comm/relayd.hpp>
@@ -20,6 +22,7 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
+#include <sys/types.h>
 #include <urcu.h>
 #include <urcu/list.h>
 #include <urcu/wfcqueue.h>
@@ -42,15 +45,48 @@ enum ctrl_connection_state {
 	CTRL_CONNECTION_STATE_RECEIVE_PAYLOAD = 1,
 };
 
+/* Number of streams cached by a data connection. */
+#define RELAY_CONNECTION_STREAM_CACHE_SIZE 4
+
 struct data_connection_state_receive_header {
 	uint64_t received, left_to_receive;
 	char header_reception_buffer[sizeof(struct lttcomm_relayd_data_hdr)];
 };
 
+struct relay_stream;
+struct stream_write_packet;
+struct forward_event;
+struct viewer_idle_timer;
+struct viewer_subscription;
+
+/* Range of a stream file queued on the output of a viewer connection. */
+struct viewer_file_range {
+	/* Bytes of the output sent before the range. */
+	size_t output_pos;
+	/* Owned by the connection, -1 once the range is sent. */
+	int fd;
+	off_t offset;
+	size_t len;
+};
+
+struct data_connection_cached_stream {
+	uint64_t stream_id;
+	/* Owns a reference to the stream. */
+	struct relay_stream *stream;
+};
+
 struct data_connection_state_receive_payload {
 	uint64_t received, left_to_receive;
 	struct lttcomm_relayd_data_hdr header;
 	bool rotate_index;
+	/* Set when the packet is a duplicate which is received without being written. */
+	bool discard;
+	/* Checksum of the payload received so far, when the header carries one. */
+	uint32_t checksum;
+	/* Packet received for the writer thread of the stream, if any. */
+	struct stream_write_packet *packet;
+	/* Forward of the packet to the upstream relay daemons, if any. */
+	struct forward_event *forward;
 };
 
 struct ctrl_connection_state_receive_header {
@@ -71,7 +107,8 @@ struct ctrl_connection_state_receive_payload {
  * from the live worker thread.
  *
  * The connections between the consumerd/sessiond and the relayd are only
- * handled by the "main" worker thread (as in, the worker thread in main.c).
+ * handled by the "main" worker thread to which they are dispatched (as in, a
+ * worker thread in main.c).
  *
  * This is why there are no back references to connections from the
  * sessions and session list.
@@ -117,6 +154,35 @@ struct relay_connection {
 				struct data_connection_state_receive_header receive_header;
 				struct data_connection_state_receive_payload receive_payload;
 			} state;
+			/*
+			 * Pipe through which the payloads are spliced from
+			 * the socket to the stream files, created on the
+			 * first payload. -1 if it couldn't be created, in
+			 * which case the payloads are copied.
+			 */
+			int splice_pipe[2];
+			bool splice_pipe_init_done;
+			/* Capacity of the splice pipe, in bytes. */
+			size_t splice_pipe_size;
+			/* Set once the splice pipe can't grow anymore. */
+			bool splice_pipe_size_max_reached;
+			/*
+			 * Buffer into which the payloads that are copied are
+			 * received. It grows up to the size of the packets of
+			 * the connection, within the configured limit.
+			 */
+			struct lttng_dynamic_buffer reception_buffer;
+			/* Payload bytes received and receive calls issued. */
+			uint64_t received_bytes;
+			uint64_t receive_calls;
+			/*
+			 * Streams of the last data headers received, most
+			 * recently used first. Most connections interleave the
+			 * packets of a handful of streams, which are then found
+			 * without a lookup of the stream hash table.
+			 */
+			struct data_connection_cached_stream
+				stream_cache[RELAY_CONNECTION_STREAM_CACHE_SIZE];
 		} data;
 		struct {
 			enum ctrl_connection_state state_id;
@@ -126,6 +192,40 @@ struct relay_connection {
 			} state;
 			struct lttng_dynamic_buffer reception_buffer;
 		} ctrl;
+		struct {
+			/*
+			 * Replies queued for the viewer, sent by the live
+			 * worker thread as the socket accepts them.
+			 */
+			struct lttng_dynamic_buffer output;
+			/* Bytes of the output already sent. */
+			size_t output_sent;
+			/* struct viewer_file_range, in the order of the output. */
+			struct lttng_dynamic_array file_ranges;
+			/* Ranges of stream files already sent. */
+			size_t file_ranges_sent;
+			/* Set once sendfile() failed to send the stream files. */
+			bool file_copy;
+			/* Events of the connection socket polled by its worker thread. */
+			uint32_t polled_events;
+			/* LTTNG_VIEWER_CAPABILITY_* negotiated on connect. */
+			uint64_t capabilities;
+			/*
+			 * Pending LTTNG_VIEWER_WAIT_NEXT_INDEX request, of which
+			 * the viewer stream is held until it is answered; null
+			 * when there is none.
+			 */
+			struct {
+				struct relay_viewer_stream *vstream;
+				/* Monotonic time at which the request times out. */
+				uint64_t deadline_ns;
+				struct relay_index_waiter waiter;
+			} index_wait;
+			/* Null until the first activity if an idle timeout is set. */
+			struct viewer_idle_timer *idle_timer;
+			/* Streams pushed to the viewer in push mode, null otherwise. */
+			struct viewer_subscription *subscription;
+		} viewer;
 	} protocol;
 };
 
@@ -137,4 +237,12 @@ void connection_put(struct relay_connection *connection);
 void connection_ht_add(struct lttng_ht *relay_connections_ht, struct relay_connection *conn);
 int connection_set_session(struct relay_connection *conn, struct relay_session *session);
 
+/*
+ * Get a stream by id through the stream cache of a data connection. A stream
+ * reference is taken when a stream is returned. stream_put() must be called
+ * on that stream.
+ */
+struct relay_stream *connection_get_stream_by_id(struct relay_connection *conn,
+						 uint64_t stream_id);
+
 #endif /* _CONNECTION_H */
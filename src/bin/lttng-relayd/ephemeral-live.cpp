@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "ephemeral-live.hpp"
+#include "session.hpp"
+
+#include <common/common.hpp>
+#include <common/utils.hpp>
+
+namespace {
+/*
+ * Stream files of the ring of a data stream: the viewers keep reading the
+ * older files of the window while the newest one is written.
+ */
+constexpr uint64_t window_file_count = 4;
+
+/* 0 when disabled. */
+uint64_t window_size;
+} /* namespace */
+
+int ephemeral_live_set_window(const char *size)
+{
+	uint64_t value;
+
+#ifndef HAVE_MEMFD_CREATE
+	ERR("Ephemeral live sessions are not supported on this platform");
+	return -1;
+#endif /* HAVE_MEMFD_CREATE */
+
+	if (utils_parse_size_suffix(size, &value) || value < window_file_count) {
+		ERR("Invalid ephemeral live window: `%s`", size);
+		return -1;
+	}
+
+	window_size = value;
+	return 0;
+}
+
+bool ephemeral_live_enabled()
+{
+	return window_size > 0;
+}
+
+bool ephemeral_live_session(const struct relay_session *session)
+{
+	return ephemeral_live_enabled() && session->live_timer > 0 && !session->snapshot;
+}
+
+void ephemeral_live_bound_stream_files(uint64_t *tracefile_size, uint64_t *tracefile_count)
+{
+	if (*tracefile_size > 0 && *tracefile_count > 0 &&
+	    *tracefile_size <= window_size / *tracefile_count) {
+		return;
+	}
+
+	*tracefile_size = window_size / window_file_count;
+	*tracefile_count = window_file_count;
+}
@@ -0,0 +1,47 @@
+#ifndef _EPHEMERAL_LIVE_H
+#define _EPHEMERAL_LIVE_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdint.h>
+
+struct relay_session;
+
+/*
+ * Ephemeral live sessions.
+ *
+ * When an ephemeral live window is set, the live sessions are streamed to
+ * their viewers without being stored: the files of their trace chunks are
+ * kept in memory rather than in the output directory, and each data stream
+ * only keeps its most recent packets and indexes, up to the size of the
+ * window, in a ring of stream files. The viewers read these files like the
+ * stored ones, the viewers which lag behind the window skipping the packets
+ * which were overwritten. The metadata streams are kept in full.
+ */
+
+/*
+ * Set the maximal size, in bytes, of the stream files of each data stream
+ * of the live sessions from a size with an optional `k`, `M` or `G` suffix.
+ *
+ * Return 0 on success, -1 if the size is invalid or if memory files are not
+ * supported.
+ */
+int ephemeral_live_set_window(const char *size);
+
+bool ephemeral_live_enabled();
+
+/* Return true if the files of the trace chunks of the session are kept in memory. */
+bool ephemeral_live_session(const struct relay_session *session);
+
+/*
+ * Bound the ring of stream files of a data stream of an ephemeral live
+ * session to the window, unless the ring requested by the peer is smaller.
+ */
+void ephemeral_live_bound_stream_files(uint64_t *tracefile_size, uint64_t *tracefile_count);
+
+#endif /* _EPHEMERAL_LIVE_H */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "fd-prefetcher.hpp"
+#include "lttng-relayd.hpp"
+
+#include <common/common.hpp>
+#include <common/defaults.hpp>
+#include <common/fd-tracker/fd-tracker.hpp>
+#include <common/time.hpp>
+
+#include <algorithm>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <urcu/system.h>
+
+namespace {
+/* Longest wait of the thread before checking whether it must quit. */
+const uint64_t max_wait_ns = 100 * NSEC_PER_MSEC;
+
+/* 0 when disabled. */
+uint64_t interval_ns;
+pthread_t thread;
+bool started;
+bool quit;
+
+/*
+ * Wait for an interval.
+ *
+ * Return 0 once elapsed, -1 if the thread must quit.
+ */
+int wait_interval()
+{
+	uint64_t delay_ns = interval_ns;
+
+	while (delay_ns > 0) {
+		const uint64_t wait_ns = std::min(delay_ns, max_wait_ns);
+		struct timespec wait = {};
+
+		if (CMM_LOAD_SHARED(quit)) {
+			return -1;
+		}
+
+		wait.tv_sec = wait_ns / NSEC_PER_SEC;
+		wait.tv_nsec = wait_ns % NSEC_PER_SEC;
+		while (nanosleep(&wait, &wait) && errno == EINTR) {
+		}
+
+		delay_ns -= wait_ns;
+	}
+
+	return CMM_LOAD_SHARED(quit) ? -1 : 0;
+}
+
+void *prefetcher_thread(void *data __attribute__((unused)))
+{
+	DBG("[thread] Relay fd prefetcher started");
+
+	while (!wait_interval()) {
+		(void) fd_tracker_prefetch_handles(the_fd_tracker,
+						   DEFAULT_RELAYD_FD_PREFETCH_BATCH,
+						   DEFAULT_RELAYD_FD_PREFETCH_MAX_IDLE_MS *
+							   NSEC_PER_MSEC);
+	}
+
+	DBG("Relay fd prefetcher exiting");
+	return nullptr;
+}
+} /* namespace */
+
+int fd_prefetcher_set_interval(const char *interval)
+{
+	unsigned long value;
+	char *end;
+
+	errno = 0;
+	value = strtoul(interval, &end, 10);
+	if (errno || end == interval || *end != '\0' || !isdigit((unsigned char) interval[0]) ||
+	    value == 0 || value > DEFAULT_RELAYD_MAX_FD_PREFETCH_INTERVAL_MS) {
+		ERR("Invalid fd prefetch interval: `%s` (expecting 1 to %d ms)",
+		    interval,
+		    DEFAULT_RELAYD_MAX_FD_PREFETCH_INTERVAL_MS);
+		return -1;
+	}
+
+	interval_ns = (uint64_t) value * NSEC_PER_MSEC;
+	return 0;
+}
+
+bool fd_prefetcher_enabled()
+{
+	return interval_ns > 0;
+}
+
+int fd_prefetcher_start()
+{
+	int ret;
+
+	LTTNG_ASSERT(fd_prefetcher_enabled());
+	LTTNG_ASSERT(!started);
+
+	ret = pthread_create(&thread, default_pthread_attr(), prefetcher_thread, nullptr);
+	if (ret) {
+		errno = ret;
+		PERROR("pthread_create fd prefetcher");
+		return -1;
+	}
+
+	started = true;
+	DBG("Relay fd prefetch enabled: interval = %" PRIu64 " ms",
+	    (uint64_t) (interval_ns / NSEC_PER_MSEC));
+	return 0;
+}
+
+void fd_prefetcher_stop()
+{
+	int ret;
+
+	if (!started) {
+		return;
+	}
+
+	CMM_STORE_SHARED(quit, true);
+	ret = pthread_join(thread, nullptr);
+	if (ret) {
+		errno = ret;
+		PERROR("pthread_join fd prefetcher");
+	}
+
+	started = false;
+}
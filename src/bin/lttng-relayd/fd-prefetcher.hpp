@@ -0,0 +1,41 @@
+#ifndef _FD_PREFETCHER_H
+#define _FD_PREFETCHER_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Prefetch of the suspended file descriptors of the relay daemon.
+ *
+ * When the file descriptor pool is exhausted, the fd tracker suspends the
+ * file descriptors of the streams which received no data for the longest
+ * time, and the next write to such a stream reopens its file. When a
+ * prefetch interval is set, a dedicated thread restores, at each interval
+ * and within the capacity left unused, the suspended file descriptors of
+ * the streams which received data recently, so that their next write
+ * doesn't have to.
+ */
+
+/*
+ * Set the prefetch interval, in milliseconds.
+ *
+ * Return 0 on success, -1 if the interval is invalid.
+ */
+int fd_prefetcher_set_interval(const char *interval);
+
+bool fd_prefetcher_enabled();
+
+/*
+ * Start the prefetch thread.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int fd_prefetcher_start();
+
+void fd_prefetcher_stop();
+
+#endif /* _FD_PREFETCHER_H */
@@ -0,0 +1,1242 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "ctf-trace.hpp"
+#include "forwarder.hpp"
+#include "lttng-relayd.hpp"
+
+#include <common/common.hpp>
+#include <common/compat/endian.hpp>
+#include <common/defaults.hpp>
+#include <common/fd-tracker/fd-tracker.hpp>
+#include <common/index/ctf-index.hpp>
+#include <common/optional.hpp>
+#include <common/relayd/relayd.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/uri.hpp>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <new>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <urcu.h>
+#include <urcu/list.h>
+#include <urcu/ref.h>
+
+namespace {
+enum forward_event_type {
+	FORWARD_EVENT_CREATE_SESSION,
+	FORWARD_EVENT_DESTROY_SESSION,
+	FORWARD_EVENT_CREATE_TRACE_CHUNK,
+	FORWARD_EVENT_CLOSE_TRACE_CHUNK,
+	FORWARD_EVENT_ADD_STREAM,
+	FORWARD_EVENT_STREAMS_SENT,
+	FORWARD_EVENT_CLOSE_STREAM,
+	FORWARD_EVENT_RESET_METADATA,
+	FORWARD_EVENT_ROTATE_STREAMS,
+	FORWARD_EVENT_INDEX,
+	FORWARD_EVENT_METADATA,
+	FORWARD_EVENT_PACKET,
+};
+} /* namespace */
+
+/* Link of an event in the queue of an output. */
+struct forward_link {
+	struct cds_list_head node;
+	struct forward_event *event;
+};
+
+/* Command, packet or index forwarded to the outputs, shared by their queues. */
+struct forward_event {
+	struct urcu_ref ref;
+	enum forward_event_type type;
+	/* Local ids of the session and, for the stream events, of the stream. */
+	uint64_t session_id;
+	uint64_t stream_id;
+	/* Size charged to the queue of each output, that of `data`. */
+	size_t size;
+	/* Outputs for which the event is reserved, one bit per output. */
+	unsigned int reserved_outputs;
+	struct forward_link links[DEFAULT_RELAYD_MAX_FORWARD_OUTPUTS];
+	union {
+		struct {
+			char session_name[LTTNG_NAME_MAX];
+			char hostname[LTTNG_HOST_NAME_MAX];
+			char base_path[LTTNG_PATH_MAX];
+			uint32_t live_timer;
+			bool snapshot;
+			uint64_t id_sessiond;
+			lttng_uuid sessiond_uuid;
+			LTTNG_OPTIONAL(uint64_t) current_chunk_id;
+			time_t creation_time;
+			bool session_name_contains_creation_time;
+		} create_session;
+		struct {
+			uint64_t chunk_id;
+			/* Creation timestamp, or close timestamp on close. */
+			time_t timestamp;
+			LTTNG_OPTIONAL(enum lttng_trace_chunk_command_type) close_command;
+		} chunk;
+		struct {
+			uint64_t tracefile_size;
+			uint64_t tracefile_count;
+			uint64_t chunk_id;
+		} add_stream;
+		uint64_t last_net_seq_num;
+		uint64_t metadata_version;
+		struct {
+			LTTNG_OPTIONAL(uint64_t) new_chunk_id;
+			unsigned int stream_count;
+		} rotate;
+		struct {
+			uint64_t net_seq_num;
+			/* Big endian, as sent to the upstream relay daemon. */
+			struct ctf_packet_index index;
+		} index;
+		struct {
+			uint64_t net_seq_num;
+			uint32_t padding_size;
+		} packet;
+	} u;
+	/* Trace chunk name override, stream path and channel names. */
+	char *name;
+	char *path_name;
+	/* Positions of the streams of a rotation, in host byte order. */
+	struct lttcomm_relayd_stream_rotation_position *positions;
+	/* Payload of the packet and metadata events. */
+	char *data;
+};
+
+namespace {
+/* Session forwarded by an output, only accessed by its thread. */
+struct upstream_session {
+	struct lttcomm_relayd_sock *control;
+	struct lttcomm_relayd_sock *data;
+	uint64_t id;
+	/* Upstream ids of the streams, by local id. */
+	std::unordered_map<uint64_t, uint64_t> streams;
+};
+
+struct forward_output {
+	unsigned int index;
+	char *url;
+	/* Control and data URIs of the upstream relay daemon. */
+	struct lttng_uri *uris;
+	pthread_t thread;
+	bool started;
+
+	pthread_mutex_t lock;
+	/* Signaled when an event is queued or when the thread must quit. */
+	pthread_cond_t event_queued;
+	/* Queued forward_link, protected by `lock`. */
+	struct cds_list_head events;
+	/* Size of the events reserved and queued, protected by `lock`. */
+	uint64_t queued_size;
+	/*
+	 * Sessions which are no longer forwarded, until their destruction,
+	 * protected by `lock`.
+	 */
+	std::unordered_set<uint64_t> abandoned_sessions;
+	/* Events are reserved while set, protected by `lock`. */
+	bool accepting_events;
+	bool quit;
+
+	/* Sessions forwarded, by local id. Only accessed by the thread. */
+	std::unordered_map<uint64_t, upstream_session> sessions;
+};
+
+struct forward_output outputs[DEFAULT_RELAYD_MAX_FORWARD_OUTPUTS];
+unsigned int output_count;
+uint64_t queue_size = DEFAULT_RELAYD_FORWARD_QUEUE_SIZE;
+
+void release_event(struct urcu_ref *ref)
+{
+	struct forward_event *event = lttng::utils::container_of(ref, &forward_event::ref);
+
+	free(event->name);
+	free(event->path_name);
+	free(event->positions);
+	free(event->data);
+	free(event);
+}
+
+void put_event(struct forward_event *event)
+{
+	urcu_ref_put(&event->ref, release_event);
+}
+
+bool session_forwarded(const struct relay_session *session)
+{
+	return output_count > 0 && !(session->major == 2 && session->minor < 11);
+}
+
+struct forward_event *
+create_event(enum forward_event_type type, uint64_t session_id, uint64_t stream_id)
+{
+	struct forward_event *event = zmalloc<forward_event>();
+
+	if (!event) {
+		PERROR("Failed to allocate forward event");
+		return nullptr;
+	}
+
+	urcu_ref_init(&event->ref);
+	event->type = type;
+	event->session_id = session_id;
+	event->stream_id = stream_id;
+	for (unsigned int i = 0; i < output_count; i++) {
+		CDS_INIT_LIST_HEAD(&event->links[i].node);
+		event->links[i].event = event;
+	}
+
+	return event;
+}
+
+/* Called with the lock of the output held. */
+void abandon_session(struct forward_output *output, uint64_t session_id, const char *reason)
+{
+	try {
+		if (!output->abandoned_sessions.insert(session_id).second) {
+			return;
+		}
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate abandoned session of forward output: url = %s",
+		    output->url);
+		return;
+	}
+
+	WARN("Session no longer forwarded: url = %s, session id = %" PRIu64 ", reason = %s",
+	     output->url,
+	     session_id,
+	     reason);
+}
+
+/*
+ * Reserve the outputs which forward an event, charging its size to their
+ * queue; the session of the event is abandoned by the outputs it doesn't
+ * fit in. The destruction of a session is reserved for all the outputs.
+ *
+ * Return true if at least one output is reserved.
+ */
+bool reserve_outputs(struct forward_event *event)
+{
+	for (unsigned int i = 0; i < output_count; i++) {
+		struct forward_output *output = &outputs[i];
+
+		pthread_mutex_lock(&output->lock);
+		if (!output->accepting_events) {
+			goto next;
+		}
+
+		if (event->type != FORWARD_EVENT_DESTROY_SESSION) {
+			if (output->abandoned_sessions.count(event->session_id)) {
+				goto next;
+			}
+
+			if (output->queued_size + event->size > queue_size) {
+				abandon_session(output, event->session_id, "queue is full");
+				goto next;
+			}
+		}
+
+		output->queued_size += event->size;
+		event->reserved_outputs |= 1U << i;
+	next:
+		pthread_mutex_unlock(&output->lock);
+	}
+
+	return event->reserved_outputs != 0;
+}
+
+/* Release the reservations of an event which isn't queued. */
+void unreserve_outputs(struct forward_event *event)
+{
+	for (unsigned int i = 0; i < output_count; i++) {
+		struct forward_output *output = &outputs[i];
+
+		if (!(event->reserved_outputs & (1U << i))) {
+			continue;
+		}
+
+		pthread_mutex_lock(&output->lock);
+		output->queued_size -= event->size;
+		pthread_mutex_unlock(&output->lock);
+	}
+
+	event->reserved_outputs = 0;
+}
+
+/* Queue a reserved event to its outputs. Ownership of the event is transferred. */
+void queue_event(struct forward_event *event)
+{
+	for (unsigned int i = 0; i < output_count; i++) {
+		struct forward_output *output = &outputs[i];
+
+		if (!(event->reserved_outputs & (1U << i))) {
+			continue;
+		}
+
+		pthread_mutex_lock(&output->lock);
+		if (output->accepting_events) {
+			urcu_ref_get(&event->ref);
+			cds_list_add_tail(&event->links[i].node, &output->events);
+			pthread_cond_signal(&output->event_queued);
+		} else {
+			output->queued_size -= event->size;
+		}
+		pthread_mutex_unlock(&output->lock);
+	}
+
+	put_event(event);
+}
+
+/* Reserve and queue an event. Ownership of the event is transferred. */
+void submit_event(struct forward_event *event)
+{
+	if (!event) {
+		return;
+	}
+
+	if (!reserve_outputs(event)) {
+		put_event(event);
+		return;
+	}
+
+	queue_event(event);
+}
+
+int open_upstream_sock(void *data, int *out_fd)
+{
+	int ret;
+	struct lttcomm_sock *sock = (lttcomm_sock *) data;
+
+	ret = lttcomm_create_sock(sock);
+	if (ret < 0) {
+		return ret;
+	}
+
+	*out_fd = sock->fd;
+	return 0;
+}
+
+int close_upstream_sock(void *data, int *in_fd __attribute__((unused)))
+{
+	return relayd_close((lttcomm_relayd_sock *) data);
+}
+
+/* The socket of a failed connection is already closed. */
+int untrack_upstream_sock(void *data __attribute__((unused)), int *in_fd __attribute__((unused)))
+{
+	return 0;
+}
+
+void destroy_upstream_sock(struct lttcomm_relayd_sock *rsock)
+{
+	int fd;
+
+	if (!rsock) {
+		return;
+	}
+
+	fd = rsock->sock.fd;
+	if (fd_tracker_close_unsuspendable_fd(the_fd_tracker, &fd, 1, close_upstream_sock, rsock)) {
+		ERR("Failed to close forward output socket");
+	}
+
+	free(rsock);
+}
+
+/*
+ * Connect to the upstream relay daemon at `uri` and negotiate the protocol
+ * version.
+ *
+ * Return the connected socket, NULL on error.
+ */
+struct lttcomm_relayd_sock *connect_upstream_sock(const struct forward_output *output,
+						  struct lttng_uri *uri,
+						  const char *name)
+{
+	int ret, fd;
+	struct lttcomm_sock *tmp_sock;
+	struct lttcomm_relayd_sock *rsock = zmalloc<lttcomm_relayd_sock>();
+
+	if (!rsock) {
+		PERROR("Failed to allocate forward output socket");
+		return nullptr;
+	}
+
+	tmp_sock = lttcomm_alloc_sock_from_uri(uri);
+	if (!tmp_sock) {
+		free(rsock);
+		return nullptr;
+	}
+
+	lttcomm_copy_sock(&rsock->sock, tmp_sock);
+	lttcomm_destroy_sock(tmp_sock);
+	rsock->major = RELAYD_VERSION_COMM_MAJOR;
+	rsock->minor = RELAYD_VERSION_COMM_MINOR;
+
+	ret = fd_tracker_open_unsuspendable_fd(
+		the_fd_tracker, &fd, &name, 1, open_upstream_sock, &rsock->sock);
+	if (ret) {
+		ERR("Failed to create forward output socket: url = %s", output->url);
+		free(rsock);
+		return nullptr;
+	}
+
+	ret = relayd_connect(rsock);
+	if (ret < 0) {
+		ERR("Failed to connect to forward output: url = %s", output->url);
+		(void) fd_tracker_close_unsuspendable_fd(
+			the_fd_tracker, &fd, 1, untrack_upstream_sock, nullptr);
+		free(rsock);
+		return nullptr;
+	}
+
+	ret = relayd_version_check(rsock);
+	if (ret || (rsock->major == 2 && rsock->minor < 11)) {
+		ERR("Incompatible relay daemon at forward output: url = %s", output->url);
+		destroy_upstream_sock(rsock);
+		return nullptr;
+	}
+
+	return rsock;
+}
+
+void close_upstream_session(struct forward_output *output, uint64_t session_id)
+{
+	const auto it = output->sessions.find(session_id);
+
+	if (it == output->sessions.end()) {
+		return;
+	}
+
+	DBG("Closing forwarded session: url = %s, session id = %" PRIu64
+	    ", upstream session id = %" PRIu64,
+	    output->url,
+	    session_id,
+	    it->second.id);
+	destroy_upstream_sock(it->second.data);
+	destroy_upstream_sock(it->second.control);
+	output->sessions.erase(it);
+}
+
+int create_upstream_session(struct forward_output *output, const struct forward_event *event)
+{
+	int ret;
+	struct upstream_session session = {};
+	char output_path[LTTNG_PATH_MAX] = {};
+
+	session.control = connect_upstream_sock(output, &output->uris[0], "Forward control socket");
+	if (!session.control) {
+		goto error;
+	}
+
+	session.data = connect_upstream_sock(output, &output->uris[1], "Forward data socket");
+	if (!session.data) {
+		goto error;
+	}
+
+	ret = relayd_create_session(
+		session.control,
+		&session.id,
+		event->u.create_session.session_name,
+		event->u.create_session.hostname,
+		event->u.create_session.base_path,
+		event->u.create_session.live_timer,
+		event->u.create_session.snapshot,
+		event->u.create_session.id_sessiond,
+		event->u.create_session.sessiond_uuid,
+		event->u.create_session.current_chunk_id.is_set ?
+			&event->u.create_session.current_chunk_id.value :
+			nullptr,
+		event->u.create_session.creation_time,
+		event->u.create_session.session_name_contains_creation_time,
+		output_path);
+	if (ret < 0) {
+		goto error;
+	}
+
+	DBG("Forwarding session: url = %s, session id = %" PRIu64
+	    ", upstream session id = %" PRIu64,
+	    output->url,
+	    event->session_id,
+	    session.id);
+
+	try {
+		output->sessions.emplace(event->session_id, std::move(session));
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate forwarded session");
+		goto error;
+	}
+
+	return 0;
+
+error:
+	destroy_upstream_sock(session.data);
+	destroy_upstream_sock(session.control);
+	return -1;
+}
+
+/* Return the upstream id of a stream, -1ULL if it isn't forwarded. */
+uint64_t get_upstream_stream_id(const struct upstream_session *session, uint64_t stream_id)
+{
+	const auto it = session->streams.find(stream_id);
+
+	return it == session->streams.end() ? -1ULL : it->second;
+}
+
+int add_upstream_stream(struct upstream_session *session, const struct forward_event *event)
+{
+	int ret;
+	uint64_t upstream_stream_id;
+	struct lttng_trace_chunk *chunk;
+
+	/* Only the id of the trace chunk is sent. */
+	chunk = lttng_trace_chunk_create(event->u.add_stream.chunk_id, 0, nullptr);
+	if (!chunk) {
+		return -1;
+	}
+
+	/* The path of the stream is sent as is. */
+	ret = relayd_add_stream(session->control,
+				event->name,
+				event->path_name,
+				"",
+				&upstream_stream_id,
+				event->u.add_stream.tracefile_size,
+				event->u.add_stream.tracefile_count,
+				chunk);
+	lttng_trace_chunk_put(chunk);
+	if (ret < 0) {
+		return -1;
+	}
+
+	try {
+		session->streams[event->stream_id] = upstream_stream_id;
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate forwarded stream");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Trace chunks are created, with the mode left unset, to describe the
+ * commands: their close command is a no-op once they are released.
+ */
+int create_upstream_trace_chunk(struct upstream_session *session,
+				const struct forward_event *event)
+{
+	int ret = -1;
+	struct lttng_trace_chunk *chunk;
+
+	chunk = lttng_trace_chunk_create(
+		event->u.chunk.chunk_id, event->u.chunk.timestamp, nullptr);
+	if (!chunk) {
+		return -1;
+	}
+
+	if (event->name &&
+	    lttng_trace_chunk_override_name(chunk, event->name) != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		goto end;
+	}
+
+	ret = relayd_create_trace_chunk(session->control, chunk);
+end:
+	lttng_trace_chunk_put(chunk);
+	return ret;
+}
+
+int close_upstream_trace_chunk(struct upstream_session *session,
+			       const struct forward_event *event)
+{
+	int ret = -1;
+	struct lttng_trace_chunk *chunk;
+	char path[LTTNG_PATH_MAX];
+
+	chunk = lttng_trace_chunk_create(
+		event->u.chunk.chunk_id, event->u.chunk.timestamp, nullptr);
+	if (!chunk) {
+		return -1;
+	}
+
+	if (lttng_trace_chunk_set_close_timestamp(chunk, event->u.chunk.timestamp) !=
+	    LTTNG_TRACE_CHUNK_STATUS_OK) {
+		goto end;
+	}
+
+	if (event->u.chunk.close_command.is_set &&
+	    lttng_trace_chunk_set_close_command(chunk, event->u.chunk.close_command.value) !=
+		    LTTNG_TRACE_CHUNK_STATUS_OK) {
+		goto end;
+	}
+
+	ret = relayd_close_trace_chunk(session->control, chunk, path);
+end:
+	lttng_trace_chunk_put(chunk);
+	return ret;
+}
+
+int rotate_upstream_streams(struct upstream_session *session, const struct forward_event *event)
+{
+	int ret;
+	unsigned int i, count = 0;
+	struct relayd_stream_rotation_position *positions;
+
+	positions = calloc<relayd_stream_rotation_position>(
+		std::max(event->u.rotate.stream_count, 1U));
+	if (!positions) {
+		PERROR("Failed to allocate forwarded stream rotation positions");
+		return -1;
+	}
+
+	for (i = 0; i < event->u.rotate.stream_count; i++) {
+		const uint64_t stream_id =
+			get_upstream_stream_id(session, event->positions[i].stream_id);
+
+		if (stream_id == -1ULL) {
+			continue;
+		}
+
+		positions[count].stream_id = stream_id;
+		positions[count].rotate_at_seq_num = event->positions[i].rotate_at_seq_num;
+		count++;
+	}
+
+	ret = relayd_rotate_streams(session->control,
+				    count,
+				    event->u.rotate.new_chunk_id.is_set ?
+					    &event->u.rotate.new_chunk_id.value :
+					    nullptr,
+				    positions);
+	free(positions);
+	return ret;
+}
+
+int send_upstream_metadata(struct upstream_session *session,
+			   const struct forward_event *event,
+			   uint64_t stream_id)
+{
+	int ret;
+	ssize_t send_ret;
+	struct lttcomm_relayd_metadata_payload header = {};
+
+	ret = relayd_send_metadata(session->control, sizeof(header) + event->size);
+	if (ret < 0) {
+		return -1;
+	}
+
+	header.stream_id = htobe64(stream_id);
+	header.padding_size = htobe32(event->u.packet.padding_size);
+	send_ret = session->control->sock.ops->sendmsg(
+		&session->control->sock, &header, sizeof(header), 0);
+	if (send_ret < (ssize_t) sizeof(header)) {
+		return -1;
+	}
+
+	if (event->size) {
+		send_ret = session->control->sock.ops->sendmsg(
+			&session->control->sock, event->data, event->size, 0);
+		if (send_ret < (ssize_t) event->size) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int send_upstream_packet(struct upstream_session *session,
+			 const struct forward_event *event,
+			 uint64_t stream_id)
+{
+	int ret;
+	ssize_t send_ret;
+	struct lttcomm_relayd_data_hdr header = {};
+
+	header.stream_id = htobe64(stream_id);
+	header.net_seq_num = htobe64(event->u.packet.net_seq_num);
+	header.data_size = htobe32((uint32_t) event->size);
+	header.padding_size = htobe32(event->u.packet.padding_size);
+	ret = relayd_send_data_hdr(session->data, &header, sizeof(header));
+	if (ret < 0) {
+		return -1;
+	}
+
+	if (event->size) {
+		send_ret = session->data->sock.ops->sendmsg(
+			&session->data->sock, event->data, event->size, 0);
+		if (send_ret < (ssize_t) event->size) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Forward an event to the upstream relay daemon of an output. The events of
+ * the sessions which are not forwarded are ignored.
+ *
+ * Return 0 on success, -1 if the session must be abandoned.
+ */
+int forward_to_upstream(struct forward_output *output, const struct forward_event *event)
+{
+	int ret;
+	struct upstream_session *session;
+	uint64_t stream_id = -1ULL;
+	struct ctf_packet_index index;
+
+	if (event->type == FORWARD_EVENT_CREATE_SESSION) {
+		return create_upstream_session(output, event);
+	}
+
+	{
+		const auto it = output->sessions.find(event->session_id);
+
+		if (it == output->sessions.end()) {
+			return 0;
+		}
+
+		session = &it->second;
+	}
+
+	switch (event->type) {
+	case FORWARD_EVENT_CLOSE_STREAM:
+	case FORWARD_EVENT_RESET_METADATA:
+	case FORWARD_EVENT_INDEX:
+	case FORWARD_EVENT_METADATA:
+	case FORWARD_EVENT_PACKET:
+		stream_id = get_upstream_stream_id(session, event->stream_id);
+		if (stream_id == -1ULL) {
+			return 0;
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch (event->type) {
+	case FORWARD_EVENT_CREATE_TRACE_CHUNK:
+		ret = create_upstream_trace_chunk(session, event);
+		break;
+	case FORWARD_EVENT_CLOSE_TRACE_CHUNK:
+		ret = close_upstream_trace_chunk(session, event);
+		break;
+	case FORWARD_EVENT_ADD_STREAM:
+		ret = add_upstream_stream(session, event);
+		break;
+	case FORWARD_EVENT_STREAMS_SENT:
+		ret = relayd_streams_sent(session->control);
+		break;
+	case FORWARD_EVENT_CLOSE_STREAM:
+		ret = relayd_send_close_stream(
+			session->control, stream_id, event->u.last_net_seq_num);
+		break;
+	case FORWARD_EVENT_RESET_METADATA:
+		ret = relayd_reset_metadata(session->control, stream_id, event->u.metadata_version);
+		break;
+	case FORWARD_EVENT_ROTATE_STREAMS:
+		ret = rotate_upstream_streams(session, event);
+		break;
+	case FORWARD_EVENT_INDEX:
+		index = event->u.index.index;
+		ret = relayd_send_index(
+			session->control, &index, stream_id, event->u.index.net_seq_num);
+		break;
+	case FORWARD_EVENT_METADATA:
+		ret = send_upstream_metadata(session, event, stream_id);
+		break;
+	case FORWARD_EVENT_PACKET:
+		ret = send_upstream_packet(session, event, stream_id);
+		break;
+	default:
+		abort();
+	}
+
+	return ret < 0 ? -1 : 0;
+}
+
+void *forward_output_thread(void *data)
+{
+	struct forward_output *output = (forward_output *) data;
+
+	DBG("[thread] Relay forward output %u started: url = %s", output->index, output->url);
+
+	rcu_register_thread();
+
+	pthread_mutex_lock(&output->lock);
+	while (true) {
+		struct forward_link *link;
+		struct forward_event *event;
+		bool abandoned;
+		const char *reason = nullptr;
+
+		if (cds_list_empty(&output->events)) {
+			if (output->quit) {
+				break;
+			}
+
+			pthread_cond_wait(&output->event_queued, &output->lock);
+			continue;
+		}
+
+		link = cds_list_first_entry(&output->events, struct forward_link, node);
+		cds_list_del(&link->node);
+		event = link->event;
+		abandoned = output->abandoned_sessions.count(event->session_id);
+		if (event->type == FORWARD_EVENT_DESTROY_SESSION) {
+			output->abandoned_sessions.erase(event->session_id);
+		}
+		pthread_mutex_unlock(&output->lock);
+
+		if (event->type == FORWARD_EVENT_DESTROY_SESSION || abandoned) {
+			close_upstream_session(output, event->session_id);
+		} else if (forward_to_upstream(output, event)) {
+			reason = "upstream relay daemon error";
+			close_upstream_session(output, event->session_id);
+		}
+
+		pthread_mutex_lock(&output->lock);
+		if (reason) {
+			abandon_session(output, event->session_id, reason);
+		}
+
+		output->queued_size -= event->size;
+		put_event(event);
+	}
+	pthread_mutex_unlock(&output->lock);
+
+	while (!output->sessions.empty()) {
+		close_upstream_session(output, output->sessions.begin()->first);
+	}
+
+	DBG("Relay forward output %u exiting", output->index);
+	rcu_unregister_thread();
+	return nullptr;
+}
+
+/* Forward an event of a stream. The session of the stream is immutable. */
+struct forward_event *create_stream_event(enum forward_event_type type,
+					  const struct relay_stream *stream)
+{
+	const struct relay_session *session = stream->trace->session;
+
+	if (!session_forwarded(session)) {
+		return nullptr;
+	}
+
+	return create_event(type, session->id, stream->stream_handle);
+}
+} /* namespace */
+
+int forwarder_add_output(const char *url)
+{
+	ssize_t uri_count;
+	struct lttng_uri *uris = nullptr;
+	struct forward_output *output;
+
+	if (output_count == DEFAULT_RELAYD_MAX_FORWARD_OUTPUTS) {
+		ERR("Too many forward outputs: maximum is %d", DEFAULT_RELAYD_MAX_FORWARD_OUTPUTS);
+		return -1;
+	}
+
+	uri_count = uri_parse_str_urls(url, nullptr, &uris);
+	if (uri_count != 2 || uris[0].dtype == LTTNG_DST_PATH) {
+		ERR("Invalid forward output URL: `%s` (expecting a network URL)", url);
+		free(uris);
+		return -1;
+	}
+
+	output = &outputs[output_count];
+	output->url = strdup(url);
+	if (!output->url) {
+		PERROR("Failed to allocate forward output URL");
+		free(uris);
+		return -1;
+	}
+
+	output->index = output_count;
+	output->uris = uris;
+	pthread_mutex_init(&output->lock, nullptr);
+	pthread_cond_init(&output->event_queued, nullptr);
+	CDS_INIT_LIST_HEAD(&output->events);
+	output_count++;
+	return 0;
+}
+
+void forwarder_set_queue_size(uint64_t size)
+{
+	queue_size = size;
+}
+
+bool forwarder_enabled()
+{
+	return output_count > 0;
+}
+
+int forwarder_start()
+{
+	LTTNG_ASSERT(forwarder_enabled());
+
+	for (unsigned int i = 0; i < output_count; i++) {
+		struct forward_output *output = &outputs[i];
+		int ret;
+
+		LTTNG_ASSERT(!output->started);
+
+		pthread_mutex_lock(&output->lock);
+		output->accepting_events = true;
+		pthread_mutex_unlock(&output->lock);
+
+		ret = pthread_create(
+			&output->thread, default_pthread_attr(), forward_output_thread, output);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create forward output %u", i);
+			pthread_mutex_lock(&output->lock);
+			output->accepting_events = false;
+			pthread_mutex_unlock(&output->lock);
+			return -1;
+		}
+
+		output->started = true;
+		DBG("Relay forward output enabled: url = %s, queue size = %" PRIu64,
+		    output->url,
+		    queue_size);
+	}
+
+	return 0;
+}
+
+void forwarder_stop()
+{
+	for (unsigned int i = 0; i < output_count; i++) {
+		struct forward_output *output = &outputs[i];
+		struct forward_link *link, *tmp;
+		int ret;
+
+		if (!output->started) {
+			continue;
+		}
+
+		pthread_mutex_lock(&output->lock);
+		output->accepting_events = false;
+		output->quit = true;
+		cds_list_for_each_entry_safe (link, tmp, &output->events, node) {
+			cds_list_del(&link->node);
+			output->queued_size -= link->event->size;
+			put_event(link->event);
+		}
+		pthread_cond_broadcast(&output->event_queued);
+		pthread_mutex_unlock(&output->lock);
+
+		ret = pthread_join(output->thread, nullptr);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join forward output %u", i);
+		}
+
+		output->started = false;
+	}
+}
+
+void forwarder_create_session(const struct relay_session *session,
+			      const uint64_t *current_chunk_id)
+{
+	struct forward_event *event;
+
+	if (!session_forwarded(session)) {
+		return;
+	}
+
+	event = create_event(FORWARD_EVENT_CREATE_SESSION, session->id, -1ULL);
+	if (!event) {
+		return;
+	}
+
+	memcpy(event->u.create_session.session_name,
+	       session->session_name,
+	       sizeof(session->session_name));
+	memcpy(event->u.create_session.hostname, session->hostname, sizeof(session->hostname));
+	memcpy(event->u.create_session.base_path, session->base_path, sizeof(session->base_path));
+	event->u.create_session.live_timer = session->live_timer;
+	event->u.create_session.snapshot = session->snapshot;
+	event->u.create_session.id_sessiond = LTTNG_OPTIONAL_GET(session->id_sessiond);
+	event->u.create_session.sessiond_uuid = session->sessiond_uuid;
+	if (current_chunk_id) {
+		LTTNG_OPTIONAL_SET(&event->u.create_session.current_chunk_id, *current_chunk_id);
+	}
+	event->u.create_session.creation_time = LTTNG_OPTIONAL_GET(session->creation_time);
+	event->u.create_session.session_name_contains_creation_time =
+		session->session_name_contains_creation_time;
+	submit_event(event);
+}
+
+void forwarder_destroy_session(const struct relay_session *session)
+{
+	if (!session_forwarded(session)) {
+		return;
+	}
+
+	submit_event(create_event(FORWARD_EVENT_DESTROY_SESSION, session->id, -1ULL));
+}
+
+void forwarder_create_trace_chunk(const struct relay_session *session,
+				  uint64_t chunk_id,
+				  time_t creation_timestamp,
+				  const char *override_name)
+{
+	struct forward_event *event;
+
+	if (!session_forwarded(session)) {
+		return;
+	}
+
+	event = create_event(FORWARD_EVENT_CREATE_TRACE_CHUNK, session->id, -1ULL);
+	if (!event) {
+		return;
+	}
+
+	event->u.chunk.chunk_id = chunk_id;
+	event->u.chunk.timestamp = creation_timestamp;
+	if (override_name) {
+		event->name = strdup(override_name);
+		if (!event->name) {
+			PERROR("Failed to allocate forwarded trace chunk name");
+			put_event(event);
+			return;
+		}
+	}
+
+	submit_event(event);
+}
+
+void forwarder_close_trace_chunk(const struct relay_session *session,
+				 uint64_t chunk_id,
+				 time_t close_timestamp,
+				 const enum lttng_trace_chunk_command_type *close_command)
+{
+	struct forward_event *event;
+
+	if (!session_forwarded(session)) {
+		return;
+	}
+
+	event = create_event(FORWARD_EVENT_CLOSE_TRACE_CHUNK, session->id, -1ULL);
+	if (!event) {
+		return;
+	}
+
+	event->u.chunk.chunk_id = chunk_id;
+	event->u.chunk.timestamp = close_timestamp;
+	if (close_command) {
+		LTTNG_OPTIONAL_SET(&event->u.chunk.close_command, *close_command);
+	}
+
+	submit_event(event);
+}
+
+void forwarder_add_stream(const struct relay_stream *stream, uint64_t chunk_id)
+{
+	struct forward_event *event = create_stream_event(FORWARD_EVENT_ADD_STREAM, stream);
+
+	if (!event) {
+		return;
+	}
+
+	event->u.add_stream.tracefile_size = stream->tracefile_size;
+	event->u.add_stream.tracefile_count = stream->tracefile_count;
+	event->u.add_stream.chunk_id = chunk_id;
+	event->name = strdup(stream->channel_name);
+	event->path_name = strdup(stream->path_name);
+	if (!event->name || !event->path_name) {
+		PERROR("Failed to allocate forwarded stream names");
+		put_event(event);
+		return;
+	}
+
+	submit_event(event);
+}
+
+void forwarder_streams_sent(const struct relay_session *session)
+{
+	if (!session_forwarded(session)) {
+		return;
+	}
+
+	submit_event(create_event(FORWARD_EVENT_STREAMS_SENT, session->id, -1ULL));
+}
+
+void forwarder_close_stream(const struct relay_stream *stream, uint64_t last_net_seq_num)
+{
+	struct forward_event *event = create_stream_event(FORWARD_EVENT_CLOSE_STREAM, stream);
+
+	if (!event) {
+		return;
+	}
+
+	event->u.last_net_seq_num = last_net_seq_num;
+	submit_event(event);
+}
+
+void forwarder_reset_metadata(const struct relay_stream *stream, uint64_t version)
+{
+	struct forward_event *event = create_stream_event(FORWARD_EVENT_RESET_METADATA, stream);
+
+	if (!event) {
+		return;
+	}
+
+	event->u.metadata_version = version;
+	submit_event(event);
+}
+
+void forwarder_rotate_streams(const struct relay_session *session,
+			      const uint64_t *new_chunk_id,
+			      unsigned int stream_count,
+			      const struct lttcomm_relayd_stream_rotation_position *positions)
+{
+	struct forward_event *event;
+
+	if (!session_forwarded(session)) {
+		return;
+	}
+
+	event = create_event(FORWARD_EVENT_ROTATE_STREAMS, session->id, -1ULL);
+	if (!event) {
+		return;
+	}
+
+	if (new_chunk_id) {
+		LTTNG_OPTIONAL_SET(&event->u.rotate.new_chunk_id, *new_chunk_id);
+	}
+
+	if (stream_count) {
+		event->positions = calloc<lttcomm_relayd_stream_rotation_position>(stream_count);
+		if (!event->positions) {
+			PERROR("Failed to allocate forwarded stream rotation positions");
+			put_event(event);
+			return;
+		}
+
+		for (unsigned int i = 0; i < stream_count; i++) {
+			event->positions[i].stream_id = be64toh(positions[i].stream_id);
+			event->positions[i].rotate_at_seq_num =
+				be64toh(positions[i].rotate_at_seq_num);
+		}
+	}
+
+	event->u.rotate.stream_count = stream_count;
+	submit_event(event);
+}
+
+void forwarder_add_index(const struct relay_stream *stream,
+			 const struct lttcomm_relayd_index *index)
+{
+	struct forward_event *event = create_stream_event(FORWARD_EVENT_INDEX, stream);
+
+	if (!event) {
+		return;
+	}
+
+	event->u.index.net_seq_num = index->net_seq_num;
+	event->u.index.index.packet_size = htobe64(index->packet_size);
+	event->u.index.index.content_size = htobe64(index->content_size);
+	event->u.index.index.timestamp_begin = htobe64(index->timestamp_begin);
+	event->u.index.index.timestamp_end = htobe64(index->timestamp_end);
+	event->u.index.index.events_discarded = htobe64(index->events_discarded);
+	event->u.index.index.stream_id = htobe64(index->stream_id);
+	event->u.index.index.stream_instance_id = htobe64(index->stream_instance_id);
+	event->u.index.index.packet_seq_num = htobe64(index->packet_seq_num);
+	submit_event(event);
+}
+
+void forwarder_send_metadata(const struct relay_stream *stream,
+			     const struct lttng_buffer_view *metadata,
+			     uint32_t padding_size)
+{
+	struct forward_event *event = create_stream_event(FORWARD_EVENT_METADATA, stream);
+
+	if (!event) {
+		return;
+	}
+
+	event->size = metadata->size;
+	event->u.packet.padding_size = padding_size;
+	if (!reserve_outputs(event)) {
+		put_event(event);
+		return;
+	}
+
+	if (metadata->size) {
+		event->data = zmalloc<char>(metadata->size);
+		if (!event->data) {
+			PERROR("Failed to allocate forwarded metadata");
+			unreserve_outputs(event);
+			put_event(event);
+			return;
+		}
+
+		memcpy(event->data, metadata->data, metadata->size);
+	}
+
+	queue_event(event);
+}
+
+struct forward_event *forwarder_packet_create(const struct relay_stream *stream,
+					      const struct lttcomm_relayd_data_hdr *header)
+{
+	struct forward_event *event = create_stream_event(FORWARD_EVENT_PACKET, stream);
+
+	if (!event) {
+		return nullptr;
+	}
+
+	event->size = header->data_size;
+	event->u.packet.net_seq_num = header->net_seq_num;
+	event->u.packet.padding_size = header->padding_size;
+	if (!reserve_outputs(event)) {
+		put_event(event);
+		return nullptr;
+	}
+
+	event->data = zmalloc<char>(std::max<size_t>(header->data_size, 1));
+	if (!event->data) {
+		PERROR("Failed to allocate forwarded packet");
+		forwarder_packet_destroy(event);
+		return nullptr;
+	}
+
+	return event;
+}
+
+char *forwarder_packet_data(struct forward_event *packet)
+{
+	return packet->data;
+}
+
+void forwarder_packet_queue(struct forward_event *packet)
+{
+	queue_event(packet);
+}
+
+void forwarder_packet_destroy(struct forward_event *packet)
+{
+	if (!packet) {
+		return;
+	}
+
+	unreserve_outputs(packet);
+	put_event(packet);
+}
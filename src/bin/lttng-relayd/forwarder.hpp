@@ -0,0 +1,114 @@
+#ifndef _FORWARDER_H
+#define _FORWARDER_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include "session.hpp"
+#include "stream.hpp"
+
+#include <common/buffer-view.hpp>
+#include <common/sessiond-comm/relayd.hpp>
+#include <common/trace-chunk.hpp>
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Forwarding of the sessions of the relay daemon to upstream relay daemons.
+ *
+ * Each forward output is an upstream relay daemon to which the relay daemon
+ * forwards the sessions it receives from 2.11+ peers, in addition to writing
+ * them locally: it replays the commands, the packets and the indexes of the
+ * sessions to the upstream relay daemon through the client of the consumer
+ * daemons.
+ *
+ * Each output has its own thread and its own queue. The packets and the
+ * metadata are kept in the buffers they were received in until all the
+ * outputs sent them; the queue of an output is bounded by the size of the
+ * packets it holds. When an output can't keep up, or when its upstream relay
+ * daemon fails, the output stops forwarding the sessions concerned rather
+ * than slowing down their local writes.
+ */
+
+struct forward_event;
+
+/*
+ * Add an output forwarding the sessions to the relay daemon at `url`, a
+ * network URL (net://HOST[:CTRLPORT[:DATAPORT]]).
+ *
+ * Return 0 on success, -1 if the URL is invalid or too many outputs are set.
+ */
+int forwarder_add_output(const char *url);
+
+/* Set the maximal size, in bytes, of the packets queued to each output. */
+void forwarder_set_queue_size(uint64_t size);
+
+bool forwarder_enabled();
+
+/*
+ * Start the threads of the outputs.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int forwarder_start();
+
+/* Stop the threads, dropping the queued commands, and close the upstream sessions. */
+void forwarder_stop();
+
+/*
+ * Command hooks, called once the command was performed locally. The forward
+ * of a command is best effort: it might be dropped, independently for each
+ * output, without affecting the local session.
+ */
+void forwarder_create_session(const struct relay_session *session,
+			      const uint64_t *current_chunk_id);
+void forwarder_destroy_session(const struct relay_session *session);
+void forwarder_create_trace_chunk(const struct relay_session *session,
+				  uint64_t chunk_id,
+				  time_t creation_timestamp,
+				  const char *override_name);
+void forwarder_close_trace_chunk(const struct relay_session *session,
+				 uint64_t chunk_id,
+				 time_t close_timestamp,
+				 const enum lttng_trace_chunk_command_type *close_command);
+void forwarder_add_stream(const struct relay_stream *stream, uint64_t chunk_id);
+void forwarder_streams_sent(const struct relay_session *session);
+void forwarder_close_stream(const struct relay_stream *stream, uint64_t last_net_seq_num);
+void forwarder_reset_metadata(const struct relay_stream *stream, uint64_t version);
+/* `positions` is an array of `stream_count` positions, in big endian as received. */
+void forwarder_rotate_streams(const struct relay_session *session,
+			      const uint64_t *new_chunk_id,
+			      unsigned int stream_count,
+			      const struct lttcomm_relayd_stream_rotation_position *positions);
+/* `index` is in host byte order. */
+void forwarder_add_index(const struct relay_stream *stream,
+			 const struct lttcomm_relayd_index *index);
+void forwarder_send_metadata(const struct relay_stream *stream,
+			     const struct lttng_buffer_view *metadata,
+			     uint32_t padding_size);
+
+/*
+ * Reserve the forward of a data packet, of which `header` is in host byte
+ * order, before its reception.
+ *
+ * Return the packet into which the payload must be received, or NULL if it
+ * isn't forwarded.
+ */
+struct forward_event *forwarder_packet_create(const struct relay_stream *stream,
+					      const struct lttcomm_relayd_data_hdr *header);
+
+/* Buffer of `header->data_size` bytes into which the payload is received. */
+char *forwarder_packet_data(struct forward_event *packet);
+
+/* Queue a received packet to its outputs. Ownership of the packet is transferred. */
+void forwarder_packet_queue(struct forward_event *packet);
+
+/* Release a packet which isn't queued. `packet` may be NULL. */
+void forwarder_packet_destroy(struct forward_event *packet);
+
+#endif /* _FORWARDER_H */
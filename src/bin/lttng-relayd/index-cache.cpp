@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "index-cache.hpp"
+
+#include <common/common.hpp>
+#include <common/time.hpp>
+#include <common/utils.hpp>
+
+#include <ctype.h>
+#include <limits.h>
+
+namespace {
+/* Entries per stream, 0 when disabled. */
+unsigned int max_count;
+uint64_t grace_period_ns = 10 * NSEC_PER_SEC;
+
+void empty_cache(struct index_cache *cache)
+{
+	free(cache->entries);
+	cache->entries = nullptr;
+	cache->size = 0;
+	cache->head = 0;
+}
+} /* namespace */
+
+int index_cache_set_count(const char *count)
+{
+	unsigned long value;
+	char *end;
+
+	errno = 0;
+	value = strtoul(count, &end, 0);
+	if (errno != 0 || !isdigit((unsigned char) count[0]) || *end != '\0' || value == 0 ||
+	    value > UINT_MAX) {
+		ERR("Invalid index cache count: `%s`", count);
+		return -1;
+	}
+
+	max_count = (unsigned int) value;
+	return 0;
+}
+
+int index_cache_set_grace_period(const char *timeout)
+{
+	uint64_t value_us;
+
+	if (utils_parse_time_suffix(timeout, &value_us) || value_us < USEC_PER_MSEC) {
+		ERR("Invalid index cache grace period: `%s`", timeout);
+		return -1;
+	}
+
+	grace_period_ns = value_us * NSEC_PER_USEC;
+	return 0;
+}
+
+bool index_cache_enabled()
+{
+	return max_count > 0;
+}
+
+void index_cache_init(struct index_cache *cache)
+{
+	cache->entries = nullptr;
+	cache->size = 0;
+	cache->head = 0;
+	cache->rotation_count = 0;
+	cache->closed_ns = 0;
+}
+
+void index_cache_fini(struct index_cache *cache)
+{
+	empty_cache(cache);
+}
+
+void index_cache_add(struct index_cache *cache,
+		     uint64_t seq,
+		     uint64_t rotation_count,
+		     const struct ctf_packet_index *index)
+{
+	struct index_cache_entry *entry;
+
+	if (!index_cache_enabled()) {
+		return;
+	}
+
+	if (cache->rotation_count != rotation_count) {
+		/* The entries of the previous trace chunk are past. */
+		cache->size = 0;
+		cache->head = 0;
+		cache->rotation_count = rotation_count;
+	}
+
+	if (!cache->entries) {
+		cache->entries = calloc<index_cache_entry>(max_count);
+		if (!cache->entries) {
+			/* The viewers read the index entries from the index file. */
+			PERROR("Failed to allocate index cache of %u entries", max_count);
+			return;
+		}
+	}
+
+	if (cache->size < max_count) {
+		entry = &cache->entries[(cache->head + cache->size) % max_count];
+		cache->size++;
+	} else {
+		/* Replace the oldest entry. */
+		entry = &cache->entries[cache->head];
+		cache->head = (cache->head + 1) % max_count;
+	}
+
+	entry->seq = seq;
+	entry->index = *index;
+}
+
+void index_cache_close(struct index_cache *cache)
+{
+	if (!index_cache_enabled()) {
+		return;
+	}
+
+	cache->closed_ns = lttng_thread_clock_now_ns();
+}
+
+bool index_cache_lookup(struct index_cache *cache,
+			uint64_t seq,
+			uint64_t rotation_count,
+			struct ctf_packet_index *index)
+{
+	if (!cache->entries || cache->closed_ns == 0) {
+		return false;
+	}
+
+	if (lttng_thread_clock_now_ns() - cache->closed_ns > grace_period_ns) {
+		DBG("Index cache grace period expired, emptying the cache");
+		empty_cache(cache);
+		return false;
+	}
+
+	if (rotation_count != cache->rotation_count) {
+		return false;
+	}
+
+	/* The viewers catching up mostly read the oldest entries. */
+	for (unsigned int i = 0; i < cache->size; i++) {
+		const struct index_cache_entry *entry =
+			&cache->entries[(cache->head + i) % max_count];
+
+		if (entry->seq == seq) {
+			*index = entry->index;
+			return true;
+		}
+	}
+
+	return false;
+}
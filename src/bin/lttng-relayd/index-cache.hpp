@@ -0,0 +1,95 @@
+#ifndef _INDEX_CACHE_H
+#define _INDEX_CACHE_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/index/ctf-index.hpp>
+
+#include <stdint.h>
+
+/*
+ * Cache of the most recent index entries of the data streams, from which the
+ * live viewers catching up on a closed stream are sent its last indexes.
+ *
+ * When an index cache count is set, each index entry written to the index
+ * file of a stream is also kept in the cache of the stream, which holds its
+ * `count` most recent entries. Once the stream is closed, the live viewers
+ * which didn't open its index file yet are sent the entries found in the
+ * cache rather than opening and reading the index file, until the grace
+ * period which follows the close of the stream expires and the cache is
+ * emptied. The short-lived streams of the per-process buffers are closed by
+ * the thousands, often before their lagging viewers read their last indexes.
+ *
+ * The entries are identified by their sequence number in the stream, see
+ * relay_stream::index_received_seqcount, and by the rotation of the stream
+ * which produced them. The cache of a stream is protected by the stream lock.
+ */
+struct index_cache_entry {
+	uint64_t seq;
+	/* As written to the index file, in big endian. */
+	struct ctf_packet_index index;
+};
+
+struct index_cache {
+	/* Ring of `count` entries, allocated with the first entry. */
+	struct index_cache_entry *entries;
+	/* Number of cached entries and position of the oldest one in the ring. */
+	unsigned int size;
+	unsigned int head;
+	/* Value of relay_stream::completed_rotation_count of the cached entries. */
+	uint64_t rotation_count;
+	/* Time at which the stream was closed, in nanoseconds, 0 while it is open. */
+	uint64_t closed_ns;
+};
+
+/*
+ * Set the number of most recent index entries cached for each data stream.
+ *
+ * Return 0 on success, -1 if the count is invalid.
+ */
+int index_cache_set_count(const char *count);
+
+/*
+ * Set the time during which the index entries of a closed stream are kept,
+ * from a timeout with an optional `ms`, `s`, `m` or `h` suffix.
+ *
+ * Return 0 on success, -1 if the timeout is invalid.
+ */
+int index_cache_set_grace_period(const char *timeout);
+
+bool index_cache_enabled();
+
+void index_cache_init(struct index_cache *cache);
+void index_cache_fini(struct index_cache *cache);
+
+/*
+ * Cache the index entry of sequence number `seq`, produced during the
+ * rotation `rotation_count` of the stream, forgetting the entries of the
+ * previous rotations.
+ */
+void index_cache_add(struct index_cache *cache,
+		     uint64_t seq,
+		     uint64_t rotation_count,
+		     const struct ctf_packet_index *index);
+
+/* Start the grace period of the cache of a stream which was closed. */
+void index_cache_close(struct index_cache *cache);
+
+/*
+ * Look up the index entry of sequence number `seq`, produced during the
+ * rotation `rotation_count`, of a closed stream. The cache is emptied once
+ * its grace period expired.
+ *
+ * Return true and copy the entry to `index` if it is cached.
+ */
+bool index_cache_lookup(struct index_cache *cache,
+			uint64_t seq,
+			uint64_t rotation_count,
+			struct ctf_packet_index *index);
+
+#endif /* _INDEX_CACHE_H */
@@ -16,9 +16,14 @@
 
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
+#include <common/self-tracing/self-tracing.hpp>
+#include <common/slab-allocator.hpp>
 #include <common/urcu.hpp>
 #include <common/utils.hpp>
 
+/* Indexes which don't fit in the index ring of their stream. */
+static lttng::slab_allocator index_allocator("relay_index", sizeof(struct relay_index));
+
 /*
  * Allocate a new relay index object. Pass the stream in which it is
  * contained as parameter. The sequence number will be used as the hash
@@ -35,14 +40,14 @@ static struct relay_index *relay_index_create(struct relay_stream *stream, uint6
 	     stream->stream_handle,
 	     net_seq_num);
 
-	index = zmalloc<relay_index>();
+	index = index_allocator.zalloc<relay_index>();
 	if (!index) {
 		PERROR("Relay index zmalloc");
 		goto end;
 	}
 	if (!stream_get(stream)) {
 		ERR("Cannot get stream");
-		free(index);
+		index_allocator.free(index);
 		index = nullptr;
 		goto end;
 	}
@@ -56,6 +61,95 @@ end:
 	return index;
 }
 
+/*
+ * Allocate the index ring of a stream. The slots are allocated once, with the
+ * first index of the stream, and reused for the lifetime of the stream.
+ *
+ * Called with stream mutex held.
+ * Return 0 on success, -1 on error.
+ */
+static int relay_index_create_ring(struct relay_stream *stream)
+{
+	stream->index_ring = calloc<relay_index>(RELAY_INDEX_RING_SIZE);
+	if (!stream->index_ring) {
+		PERROR("Relay index ring zmalloc");
+		return -1;
+	}
+
+	for (unsigned int i = 0; i < RELAY_INDEX_RING_SIZE; i++) {
+		pthread_mutex_init(&stream->index_ring[i].lock, nullptr);
+	}
+
+	return 0;
+}
+
+/*
+ * Take the slot of the index ring of a stream for the given sequence
+ * number, if it is free.
+ *
+ * Called with stream mutex held.
+ * Return the index object or else NULL if the slot is in use.
+ */
+static struct relay_index *relay_index_ring_acquire(struct relay_stream *stream,
+						    uint64_t net_seq_num)
+{
+	struct relay_index *index;
+
+	if (!stream->index_ring && relay_index_create_ring(stream)) {
+		return nullptr;
+	}
+
+	index = &stream->index_ring[net_seq_num % RELAY_INDEX_RING_SIZE];
+	if (index->in_ring) {
+		DBG2("Index ring slot of stream id %" PRIu64 " and seqnum %" PRIu64
+		     " held by seqnum %" PRIu64,
+		     stream->stream_handle,
+		     net_seq_num,
+		     index->index_n.key);
+		return nullptr;
+	}
+
+	if (!stream_get(stream)) {
+		ERR("Cannot get stream");
+		return nullptr;
+	}
+
+	index->stream = stream;
+	index->index_file = nullptr;
+	index->index_data = {};
+	index->total_size = 0;
+	index->has_index_data = false;
+	index->flushed = false;
+	index->in_hash_table = false;
+	index->in_ring = true;
+	lttng_ht_node_init_u64(&index->index_n, net_seq_num);
+	urcu_ref_init(&index->ref);
+	return index;
+}
+
+/*
+ * Return the index of the given sequence number which is held in the index
+ * ring of a stream, if any.
+ *
+ * Called with stream mutex held.
+ */
+static struct relay_index *relay_index_ring_lookup(struct relay_stream *stream,
+						   uint64_t net_seq_num)
+{
+	struct relay_index *index;
+
+	if (!stream->index_ring) {
+		return nullptr;
+	}
+
+	index = &stream->index_ring[net_seq_num % RELAY_INDEX_RING_SIZE];
+	if (!index->in_ring || index->index_n.key != net_seq_num) {
+		return nullptr;
+	}
+
+	return index;
+}
+
 /*
  * Add unique relay index to the given hash table. In case of a collision, the
  * already existing object is put in the given _index variable.
@@ -110,21 +204,34 @@ static bool relay_index_get(struct relay_index *index)
  * Return index object or else NULL on error.
  */
 struct relay_index *relay_index_get_by_id_or_create(struct relay_stream *stream,
-						    uint64_t net_seq_num)
+						    uint64_t net_seq_num,
+						    enum memory_budget_type memory_budget_type)
 {
 	struct lttng_ht_node_u64 *node;
 	struct lttng_ht_iter iter;
 	struct relay_index *index = nullptr;
+	lttng::urcu::read_lock_guard read_lock;
 
 	DBG3("Finding index for stream id %" PRIu64 " and seq_num %" PRIu64,
 	     stream->stream_handle,
 	     net_seq_num);
 
-	lttng::urcu::read_lock_guard read_lock;
+	/*
+	 * The data and index messages of a packet are usually received close
+	 * to each other: the index is found in, or added to, the ring. The
+	 * hash table only holds the indexes whose slot was in use.
+	 */
+	index = relay_index_ring_lookup(stream, net_seq_num);
+	if (index) {
+		goto end;
+	}
+
 	lttng_ht_lookup(stream->indexes_ht, &net_seq_num, &iter);
 	node = lttng_ht_iter_get_node_u64(&iter);
 	if (node) {
 		index = lttng::utils::container_of(node, &relay_index::index_n);
+	} else if ((index = relay_index_ring_acquire(stream, net_seq_num))) {
+		stream->indexes_in_flight++;
 	} else {
 		struct relay_index *oldindex;
 
@@ -146,6 +253,9 @@ struct relay_index *relay_index_get_by_id_or_create(struct relay_stream *stream,
 		} else {
 			stream->indexes_in_flight++;
 			index->in_hash_table = true;
+			/* Bounded by the back-pressure of the worker threads. */
+			index->memory_budget_type = memory_budget_type;
+			memory_budget_charge(memory_budget_type, sizeof(*index));
 		}
 	}
 end:
@@ -199,7 +309,7 @@ end:
 
 static void index_destroy(struct relay_index *index)
 {
-	free(index);
+	index_allocator.free(index);
 }
 
 static void index_destroy_rcu(struct rcu_head *rcu_head)
@@ -221,12 +331,21 @@ static void index_release(struct urcu_ref *ref)
 		lttng_index_file_put(index->index_file);
 		index->index_file = nullptr;
 	}
+	if (index->in_ring) {
+		/* The slot can be reused as soon as the stream is put. */
+		index->in_ring = false;
+		index->stream = nullptr;
+		stream->indexes_in_flight--;
+		stream_put(stream);
+		return;
+	}
 	if (index->in_hash_table) {
 		/* Delete index from hash table. */
 		iter.iter.node = &index->index_n.node;
 		ret = lttng_ht_del(stream->indexes_ht, &iter);
 		LTTNG_ASSERT(!ret);
 		stream->indexes_in_flight--;
+		memory_budget_release(index->memory_budget_type, sizeof(*index));
 	}
 
 	stream_put(index->stream);
@@ -285,7 +404,9 @@ int relay_index_try_flush(struct relay_index *index)
 	     index->index_n.key);
 	flushed = true;
 	index->flushed = true;
-	ret = lttng_index_file_write(index->index_file, &index->index_data);
+	ret = stream_write_index(index->stream, index->index_file, &index->index_data);
+	self_tracepoint(
+		relayd_index_flush, index->stream->stream_handle, index->index_n.key, ret);
 skip:
 	pthread_mutex_unlock(&index->lock);
 
@@ -307,12 +428,37 @@ void relay_index_close_all(struct relay_stream *stream)
 
 	lttng::urcu::read_lock_guard read_lock;
 
+	for (unsigned int i = 0; stream->index_ring && i < RELAY_INDEX_RING_SIZE; i++) {
+		if (stream->index_ring[i].in_ring) {
+			/* Put self-ref from index. */
+			relay_index_put(&stream->index_ring[i]);
+		}
+	}
+
 	cds_lfht_for_each_entry (stream->indexes_ht->ht, &iter.iter, index, index_n.node) {
 		/* Put self-ref from index. */
 		relay_index_put(index);
 	}
 }
 
+/*
+ * Free the index ring of a stream once all its indexes are released.
+ */
+void relay_index_destroy_ring(struct relay_stream *stream)
+{
+	if (!stream->index_ring) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < RELAY_INDEX_RING_SIZE; i++) {
+		LTTNG_ASSERT(!stream->index_ring[i].in_ring);
+		pthread_mutex_destroy(&stream->index_ring[i].lock);
+	}
+
+	free(stream->index_ring);
+	stream->index_ring = nullptr;
+}
+
 void relay_index_close_partial_fd(struct relay_stream *stream)
 {
 	struct lttng_ht_iter iter;
@@ -320,6 +466,14 @@ void relay_index_close_partial_fd(struct relay_stream *stream)
 
 	lttng::urcu::read_lock_guard read_lock;
 
+	for (unsigned int i = 0; stream->index_ring && i < RELAY_INDEX_RING_SIZE; i++) {
+		index = &stream->index_ring[i];
+		if (index->in_ring && index->index_file) {
+			/* Partial index, see below. Put self-ref from index. */
+			relay_index_put(index);
+		}
+	}
+
 	cds_lfht_for_each_entry (stream->indexes_ht->ht, &iter.iter, index, index_n.node) {
 		if (!index->index_file) {
 			continue;
@@ -341,6 +495,13 @@ uint64_t relay_index_find_last(struct relay_stream *stream)
 
 	lttng::urcu::read_lock_guard read_lock;
 
+	for (unsigned int i = 0; stream->index_ring && i < RELAY_INDEX_RING_SIZE; i++) {
+		index = &stream->index_ring[i];
+		if (index->in_ring && (net_seq_num == -1ULL || index->index_n.key > net_seq_num)) {
+			net_seq_num = index->index_n.key;
+		}
+	}
+
 	cds_lfht_for_each_entry (stream->indexes_ht->ht, &iter.iter, index, index_n.node) {
 		if (net_seq_num == -1ULL || index->index_n.key > net_seq_num) {
 			net_seq_num = index->index_n.key;
@@ -392,6 +553,19 @@ int relay_index_switch_all_files(struct relay_stream *stream)
 
 	lttng::urcu::read_lock_guard read_lock;
 
+	for (unsigned int i = 0; stream->index_ring && i < RELAY_INDEX_RING_SIZE; i++) {
+		if (!stream->index_ring[i].in_ring) {
+			continue;
+		}
+
+		ret = relay_index_switch_file(&stream->index_ring[i],
+					      stream->index_file,
+					      stream->pos_after_last_complete_data_index);
+		if (ret) {
+			return ret;
+		}
+	}
+
 	cds_lfht_for_each_entry (stream->indexes_ht->ht, &iter.iter, index, index_n.node) {
 		ret = relay_index_switch_file(
 			index, stream->index_file, stream->pos_after_last_complete_data_index);
@@ -10,12 +10,21 @@
  *
  */
 
+#include "memory-budget.hpp"
+
 #include <common/hashtable/hashtable.hpp>
 #include <common/index/index.hpp>
 
 #include <inttypes.h>
 #include <pthread.h>
 
+/*
+ * Number of slots of the index ring of a stream. The index of a packet is
+ * kept in the slot `net_seq_num % RELAY_INDEX_RING_SIZE` when it is free, else
+ * in the indexes_ht of the stream.
+ */
+#define RELAY_INDEX_RING_SIZE 64
+
 struct relay_stream;
 struct relay_connection;
 struct lttcomm_relayd_index;
@@ -42,18 +51,27 @@ struct relay_index {
 	bool has_index_data;
 	bool flushed;
 	bool in_hash_table;
+	/* Budget to which an index of the hash table is charged. */
+	enum memory_budget_type memory_budget_type;
+	/* Set while this slot of the index ring of the stream is in use. */
+	bool in_ring;
 
 	/*
 	 * Node within indexes_ht that corresponds to this struct
 	 * relay_index. Indexed by net_seq_num, which is unique for this
-	 * index across the stream.
+	 * index across the stream. The key is also set for ring slots.
 	 */
 	struct lttng_ht_node_u64 index_n;
 	struct rcu_head rcu_node; /* For call_rcu teardown. */
 };
 
+/*
+ * `memory_budget_type` is the budget to which the index is charged if it is
+ * created in the hash table of the stream.
+ */
 struct relay_index *relay_index_get_by_id_or_create(struct relay_stream *stream,
-						    uint64_t net_seq_num);
+						    uint64_t net_seq_num,
+						    enum memory_budget_type memory_budget_type);
 void relay_index_put(struct relay_index *index);
 int relay_index_set_file(struct relay_index *index,
 			 struct lttng_index_file *index_file,
@@ -62,6 +80,7 @@ int relay_index_set_data(struct relay_index *index, const struct ctf_packet_inde
 int relay_index_try_flush(struct relay_index *index);
 
 void relay_index_close_all(struct relay_stream *stream);
+void relay_index_destroy_ring(struct relay_stream *stream);
 void relay_index_close_partial_fd(struct relay_stream *stream);
 uint64_t relay_index_find_last(struct relay_stream *stream);
 int relay_index_switch_all_files(struct relay_stream *stream);
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "ingest-limiter.hpp"
+
+#include <common/common.hpp>
+#include <common/time.hpp>
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+const unsigned long max_weight = 1000;
+/* Keeps rate * weight far from overflowing the tokens of a bucket. */
+const uint64_t max_rate = (uint64_t) INT64_MAX / max_weight / 2;
+
+/* Bytes per second received from each session, 0 when unlimited. */
+uint64_t session_rate;
+/* Bytes received from each session per round, 0 when unlimited. */
+uint64_t session_round_budget;
+std::vector<std::pair<std::string, unsigned int>> host_weights;
+} /* namespace */
+
+int ingest_limiter_set_rate(const char *rate)
+{
+	uint64_t value;
+
+	if (utils_parse_size_suffix(rate, &value) || value > max_rate) {
+		ERR("Invalid session ingestion rate: `%s`", rate);
+		return -1;
+	}
+
+	session_rate = value;
+	return 0;
+}
+
+int ingest_limiter_set_round_budget(const char *size)
+{
+	uint64_t value;
+
+	if (utils_parse_size_suffix(size, &value) || value > max_rate) {
+		ERR("Invalid session round budget: `%s`", size);
+		return -1;
+	}
+
+	session_round_budget = value;
+	return 0;
+}
+
+int ingest_limiter_add_host_weight(const char *spec)
+{
+	const char *separator = strrchr(spec, ':');
+	const char *weight_str;
+	char *end;
+	unsigned long weight;
+
+	if (!separator || separator == spec) {
+		goto invalid;
+	}
+
+	weight_str = separator + 1;
+	errno = 0;
+	weight = strtoul(weight_str, &end, 10);
+	if (errno || end == weight_str || *end != '\0' || *weight_str == '-' || weight == 0 ||
+	    weight > max_weight) {
+		goto invalid;
+	}
+
+	try {
+		host_weights.emplace_back(std::string(spec, separator - spec),
+					  (unsigned int) weight);
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate host weight");
+		return -1;
+	}
+
+	return 0;
+
+invalid:
+	ERR("Invalid host weight specification: `%s` (expecting HOSTNAME:WEIGHT, WEIGHT <= %lu)",
+	    spec,
+	    max_weight);
+	return -1;
+}
+
+bool ingest_limiter_rate_enabled()
+{
+	return session_rate > 0;
+}
+
+bool ingest_limiter_round_budget_enabled()
+{
+	return session_round_budget > 0;
+}
+
+void ingest_bucket_init(struct relay_ingest_bucket *bucket, const char *hostname)
+{
+	pthread_mutex_init(&bucket->lock, nullptr);
+	bucket->weight = 1;
+
+	for (const auto& host_weight : host_weights) {
+		if (host_weight.first == hostname) {
+			bucket->weight = host_weight.second;
+			break;
+		}
+	}
+
+	token_bucket_init(&bucket->bytes, session_rate * bucket->weight);
+}
+
+void ingest_bucket_charge(struct relay_ingest_bucket *bucket, uint64_t len)
+{
+	if (!ingest_limiter_rate_enabled() || len == 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&bucket->lock);
+	token_bucket_consume(&bucket->bytes, len);
+	pthread_mutex_unlock(&bucket->lock);
+}
+
+int ingest_bucket_delay_ms(struct relay_ingest_bucket *bucket)
+{
+	int64_t deficit;
+	const uint64_t rate = bucket->bytes.rate;
+
+	if (!ingest_limiter_rate_enabled()) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&bucket->lock);
+	(void) token_bucket_refill(&bucket->bytes);
+	/* No data is received until the bucket holds at least one token. */
+	deficit = bucket->bytes.tokens > 0 ? 0 : 1 - bucket->bytes.tokens;
+	pthread_mutex_unlock(&bucket->lock);
+
+	if (deficit == 0) {
+		return 0;
+	}
+
+	/* Round up so that the bucket has refilled once the delay expires. */
+	return (int) std::min<uint64_t>((deficit * MSEC_PER_SEC + rate - 1) / rate, MSEC_PER_SEC);
+}
+
+uint64_t ingest_bucket_round_budget(const struct relay_ingest_bucket *bucket)
+{
+	return session_round_budget * bucket->weight;
+}
@@ -0,0 +1,86 @@
+#ifndef _INGEST_LIMITER_H
+#define _INGEST_LIMITER_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include "token-bucket.hpp"
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+ * Ingestion limits of the data connections of the sessions.
+ *
+ * Two independent limits may be enabled:
+ *
+ * - A token bucket per session limits the rate at which the worker threads
+ *   receive the data connections of the session. A worker thread stops
+ *   polling the data connections of a session which spent its tokens until
+ *   the bucket refills, so that TCP back-pressure slows down its consumer
+ *   daemon.
+ *
+ * - A byte budget per session and per scheduling round of a worker thread,
+ *   each round handling the data connections which are ready at once. A
+ *   session which spent its budget gets no more data received until the
+ *   next round, so that a session with many busy connections can't hold
+ *   up the other sessions of the worker thread.
+ *
+ * The weight of a session, selected by its hostname, multiplies both its
+ * rate and its budget.
+ */
+struct relay_ingest_bucket {
+	pthread_mutex_t lock;
+	unsigned int weight;
+	/* Bytes which may be received, protected by `lock`. */
+	struct token_bucket bytes;
+};
+
+struct relay_session;
+
+/*
+ * Set the maximal rate, in bytes per second, at which the data of each
+ * session is received from a size with an optional `k`, `M` or `G` suffix.
+ *
+ * Return 0 on success, -1 if the rate is invalid.
+ */
+int ingest_limiter_set_rate(const char *rate);
+
+/*
+ * Set the budget of each session per scheduling round from a size with an
+ * optional `k`, `M` or `G` suffix.
+ *
+ * Return 0 on success, -1 if the size is invalid.
+ */
+int ingest_limiter_set_round_budget(const char *size);
+
+/*
+ * Set the weight of the sessions of a host from a specification of the
+ * form `HOSTNAME:WEIGHT`.
+ *
+ * Return 0 on success, -1 if the specification is invalid.
+ */
+int ingest_limiter_add_host_weight(const char *spec);
+
+bool ingest_limiter_rate_enabled();
+bool ingest_limiter_round_budget_enabled();
+
+void ingest_bucket_init(struct relay_ingest_bucket *bucket, const char *hostname);
+
+/* Account for `len` bytes received from a data connection of the session. */
+void ingest_bucket_charge(struct relay_ingest_bucket *bucket, uint64_t len);
+
+/*
+ * Return the delay, in milliseconds, until the session may receive data
+ * again, 0 if it may receive data now.
+ */
+int ingest_bucket_delay_ms(struct relay_ingest_bucket *bucket);
+
+/* Return the budget of the session per scheduling round, in bytes. */
+uint64_t ingest_bucket_round_budget(const struct relay_ingest_bucket *bucket);
+
+#endif /* _INGEST_LIMITER_H */
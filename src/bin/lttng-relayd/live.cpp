@@ -12,12 +12,18 @@
 #include "connection.hpp"
 #include "ctf-trace.hpp"
 #include "health-relayd.hpp"
+#include "index-cache.hpp"
 #include "live.hpp"
 #include "lttng-relayd.hpp"
+#include "memory-budget.hpp"
+#include "metrics.hpp"
+#include "packet-cache.hpp"
 #include "session.hpp"
 #include "stream.hpp"
+#include "tcp_keep_alive.hpp"
 #include "testpoint.hpp"
 #include "utils.hpp"
+#include "viewer-idle.hpp"
 #include "viewer-session.hpp"
 #include "viewer-stream.hpp"
 
@@ -25,14 +31,19 @@
 #include <common/compat/endian.hpp>
 #include <common/compat/poll.hpp>
 #include <common/compat/socket.hpp>
+#include <common/compat/string.hpp>
 #include <common/defaults.hpp>
+#include <common/dynamic-array.hpp>
 #include <common/fd-tracker/utils.hpp>
 #include <common/fs-handle.hpp>
 #include <common/futex.hpp>
 #include <common/index/index.hpp>
+#include <common/make-unique-wrapper.hpp>
+#include <common/self-tracing/self-tracing.hpp>
 #include <common/sessiond-comm/inet.hpp>
 #include <common/sessiond-comm/relayd.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/time.hpp>
 #include <common/urcu.hpp>
 #include <common/uri.hpp>
 #include <common/utils.hpp>
@@ -53,6 +64,7 @@
 #include <sys/mman.h>
 #include <sys/mount.h>
 #include <sys/resource.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -62,22 +74,48 @@
 #include <urcu/rculist.h>
 #include <urcu/uatomic.h>
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif /* HAVE_LIBZSTD */
+
 #define SESSION_BUF_DEFAULT_COUNT 16
+/* Packets are copied through this buffer when sendfile() can't send them. */
+#define VIEWER_PACKET_COPY_BUFFER_SIZE 65536
+/* Longest wait of a LTTNG_VIEWER_WAIT_NEXT_INDEX request. */
+#define VIEWER_MAX_INDEX_WAIT_MS 60000
+/* Most indexes returned by a LTTNG_VIEWER_GET_NEXT_PACKETS request. */
+#define VIEWER_MAX_NEXT_PACKETS 64
 
 static struct lttng_uri *live_uri;
 
 /*
- * This pipe is used to inform the worker thread that a command is queued and
- * ready to be processed.
+ * A live worker thread handles the viewer connections it receives from the
+ * dispatcher thread through its connection pipe, each worker using its own
+ * poll set.
  */
-static int live_conn_pipe[2] = { -1, -1 };
+struct live_worker {
+	unsigned int id;
+	pthread_t thread;
+	/*
+	 * This pipe is used to inform the worker thread that a connection is
+	 * queued and ready to be processed.
+	 */
+	int conn_pipe[2];
+	/*
+	 * Non-blocking pipe through which the streams wake up the worker
+	 * thread when one of its viewers waits for their next index.
+	 */
+	int wakeup_pipe[2];
+};
+
+static struct live_worker *live_workers;
+static unsigned int live_worker_count = DEFAULT_RELAYD_LIVE_WORKER_THREAD_COUNT;
 
 /* Shared between threads */
 static int live_dispatch_thread_exit;
 
 static pthread_t live_listener_thread;
 static pthread_t live_dispatcher_thread;
-static pthread_t live_worker_thread;
 
 /*
  * Relay command queue.
@@ -111,6 +149,24 @@ static const char *lttng_viewer_command_str(lttng_viewer_command cmd)
 		return "CREATE_SESSION";
 	case LTTNG_VIEWER_DETACH_SESSION:
 		return "DETACH_SESSION";
+	case LTTNG_VIEWER_GET_NEXT_INDEXES:
+		return "GET_NEXT_INDEXES";
+	case LTTNG_VIEWER_WAIT_NEXT_INDEX:
+		return "WAIT_NEXT_INDEX";
+	case LTTNG_VIEWER_GET_NEXT_PACKETS:
+		return "GET_NEXT_PACKETS";
+	case LTTNG_VIEWER_GET_COMPRESSED_METADATA:
+		return "GET_COMPRESSED_METADATA";
+	case LTTNG_VIEWER_SET_CHANNEL_FILTER:
+		return "SET_CHANNEL_FILTER";
+	case LTTNG_VIEWER_LIST_SESSIONS_FILTERED:
+		return "LIST_SESSIONS_FILTERED";
+	case LTTNG_VIEWER_GET_NEXT_MERGED_INDEX:
+		return "GET_NEXT_MERGED_INDEX";
+	case LTTNG_VIEWER_SUBSCRIBE:
+		return "SUBSCRIBE";
+	case LTTNG_VIEWER_ADD_CREDIT:
+		return "ADD_CREDIT";
 	default:
 		abort();
 	}
@@ -182,6 +238,8 @@ static void cleanup_relayd_live()
 	DBG("Cleaning up");
 
 	free(live_uri);
+	free(live_workers);
+	live_workers = nullptr;
 }
 
 /*
@@ -210,24 +268,210 @@ static ssize_t recv_request(struct lttcomm_sock *sock, void *buf, size_t size)
 }
 
 /*
- * Send a response buffer using a given socket, source allocated buffer of
- * length size.
+ * Queue a response buffer on the output of a viewer connection, source
+ * allocated buffer of length size. The output is sent by the live worker
+ * thread once the request is processed, see flush_viewer_output().
  *
- * Return the size of the sent message or else a negative value on error with
- * errno being set by sendmsg() syscall.
+ * Return the size of the queued response or else a negative value on error.
  */
-static ssize_t send_response(struct lttcomm_sock *sock, void *buf, size_t size)
+static ssize_t send_response(struct relay_connection *conn, const void *buf, size_t size)
 {
-	ssize_t ret;
+	auto *viewer = &conn->protocol.viewer;
 
-	ret = sock->ops->sendmsg(sock, buf, size, 0);
-	if (ret < 0) {
-		ERR("Relayd failed to send response.");
+	if (lttng_dynamic_buffer_append(&viewer->output, buf, size)) {
+		ERR("Relayd failed to queue response of %zu bytes.", size);
+		return -1;
+	}
+
+	memory_budget_charge(MEMORY_BUDGET_VIEWER_BUFFER, size);
+	return size;
+}
+
+/*
+ * Queue `len` bytes of the stream file `fd`, from `offset`, on the output of
+ * a viewer connection, after the responses queued so far. The connection
+ * takes ownership of `fd`, even on error.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int send_stream_file_range(struct relay_connection *conn, int fd, off_t offset, size_t len)
+{
+	auto *viewer = &conn->protocol.viewer;
+	struct viewer_file_range range = {};
+
+	range.output_pos = viewer->output.size;
+	range.fd = fd;
+	range.offset = offset;
+	range.len = len;
+	if (lttng_dynamic_array_add_element(&viewer->file_ranges, &range)) {
+		ERR("Relayd failed to queue stream file range of %zu bytes.", len);
+		if (close(fd)) {
+			PERROR("Failed to close duplicated file descriptor of viewer stream");
+		}
+
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Send a queued range of a stream file to the socket of a viewer
+ * connection, as much of it as the socket accepts without blocking. The
+ * file is sent without copying it through user space, unless sendfile()
+ * doesn't support it. The file offset of the file descriptor is left
+ * unchanged.
+ *
+ * Return 1 once the range is sent, 0 if some of it is left, -1 on error.
+ */
+static int flush_stream_file_range(struct relay_connection *conn, struct viewer_file_range *range)
+{
+	auto *viewer = &conn->protocol.viewer;
+	const int sock = conn->sock->fd;
+	int ret = 1, flags;
+
+	/* sendfile() has no flags: the socket is non-blocking while it sends. */
+	flags = fcntl(sock, F_GETFL);
+	if (flags < 0 || fcntl(sock, F_SETFL, flags | O_NONBLOCK)) {
+		PERROR("Failed to make viewer socket %d non-blocking", sock);
+		return -1;
+	}
+
+	while (range->len > 0) {
+		ssize_t sent;
+
+		health_code_update();
+		if (!viewer->file_copy) {
+			sent = sendfile(sock, range->fd, &range->offset, range->len);
+			if (sent < 0 && (errno == EINVAL || errno == ENOSYS)) {
+				DBG("Falling back to copying the stream files to viewer socket %d",
+				    sock);
+				viewer->file_copy = true;
+				continue;
+			}
+		} else {
+			char buffer[VIEWER_PACKET_COPY_BUFFER_SIZE];
+
+			/* What the socket doesn't accept is read again on the next flush. */
+			sent = pread(range->fd,
+				     buffer,
+				     std::min(range->len, sizeof(buffer)),
+				     range->offset);
+			if (sent > 0) {
+				sent = send(sock, buffer, sent, MSG_NOSIGNAL);
+				if (sent > 0) {
+					range->offset += sent;
+				}
+			}
+		}
+
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				ret = 0;
+				break;
+			}
+
+			PERROR("Failed to send stream file to viewer socket %d", sock);
+			ret = -1;
+			break;
+		} else if (sent == 0) {
+			ERR("Unexpected end of stream file while sending it to viewer socket %d",
+			    sock);
+			ret = -1;
+			break;
+		}
+
+		relay_metrics_count_viewer_sent_bytes(sent);
+		range->len -= sent;
+	}
+
+	if (fcntl(sock, F_SETFL, flags)) {
+		PERROR("Failed to make viewer socket %d blocking", sock);
+		ret = -1;
+	}
+
+	if (ret == 1) {
+		if (close(range->fd)) {
+			PERROR("Failed to close duplicated file descriptor of viewer stream");
+		}
+
+		range->fd = -1;
 	}
 
 	return ret;
 }
 
+/*
+ * Send the queued output of a viewer connection, as much of it as its
+ * socket accepts without blocking. The ranges of stream files are sent
+ * between the responses, at the position they were queued at.
+ *
+ * Return 1 once the output is sent, 0 if some of it is left, -1 on error.
+ */
+static int flush_viewer_output(struct relay_connection *conn)
+{
+	auto *viewer = &conn->protocol.viewer;
+	const int sock = conn->sock->fd;
+
+	while (true) {
+		const size_t ranges_count = lttng_dynamic_array_get_count(&viewer->file_ranges);
+		struct viewer_file_range *range = nullptr;
+		size_t output_end = viewer->output.size;
+		int ret;
+
+		if (viewer->file_ranges_sent < ranges_count) {
+			range = (struct viewer_file_range *) lttng_dynamic_array_get_element(
+				&viewer->file_ranges, viewer->file_ranges_sent);
+			output_end = range->output_pos;
+		}
+
+		while (viewer->output_sent < output_end) {
+			const ssize_t sent = send(sock,
+						  viewer->output.data + viewer->output_sent,
+						  output_end - viewer->output_sent,
+						  MSG_DONTWAIT | MSG_NOSIGNAL);
+
+			health_code_update();
+			if (sent < 0) {
+				if (errno == EINTR) {
+					continue;
+				} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					return 0;
+				}
+
+				PERROR("Failed to send response to viewer socket %d", sock);
+				return -1;
+			}
+
+			relay_metrics_count_viewer_sent_bytes(sent);
+			viewer->output_sent += sent;
+		}
+
+		if (!range) {
+			break;
+		}
+
+		ret = flush_stream_file_range(conn, range);
+		if (ret <= 0) {
+			return ret;
+		}
+
+		viewer->file_ranges_sent++;
+	}
+
+	if (viewer->output.size > 0) {
+		memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, viewer->output.size);
+		(void) lttng_dynamic_buffer_set_size(&viewer->output, 0);
+		viewer->output_sent = 0;
+	}
+
+	lttng_dynamic_array_clear(&viewer->file_ranges);
+	viewer->file_ranges_sent = 0;
+	return 1;
+}
+
 /*
  * Atomically check if new streams got added in one of the sessions attached
  * and reset the flag to 0.
@@ -266,23 +510,24 @@ end:
 }
 
 /*
- * Send viewer streams to the given socket. The ignore_sent_flag indicates if
+ * Send viewer streams to the given connection. The ignore_sent_flag indicates if
  * this function should ignore the sent flag or not.
  *
  * Return 0 on success or else a negative value.
  */
 static ssize_t
-send_viewer_streams(struct lttcomm_sock *sock, uint64_t session_id, unsigned int ignore_sent_flag)
+send_viewer_streams(struct relay_connection *conn,
+		    struct relay_session *session,
+		    unsigned int ignore_sent_flag)
 {
 	ssize_t ret;
-	struct lttng_ht_iter iter;
 	struct relay_viewer_stream *vstream;
 
 	{
 		lttng::urcu::read_lock_guard read_lock;
 
-		cds_lfht_for_each_entry (
-			viewer_streams_ht->ht, &iter.iter, vstream, stream_n.node) {
+		cds_list_for_each_entry_rcu(vstream, &session->viewer_streams, session_node)
+		{
 			struct ctf_trace *ctf_trace;
 			struct lttng_viewer_stream send_stream = {};
 
@@ -293,9 +538,7 @@ send_viewer_streams(struct lttcomm_sock *sock, uint64_t session_id, unsigned int
 			}
 
 			pthread_mutex_lock(&vstream->stream->lock);
-			/* Ignore if not the same session. */
-			if (vstream->stream->trace->session->id != session_id ||
-			    (!ignore_sent_flag && vstream->sent_flag)) {
+			if (!ignore_sent_flag && vstream->sent_flag) {
 				pthread_mutex_unlock(&vstream->stream->lock);
 				viewer_stream_put(vstream);
 				continue;
@@ -326,7 +569,7 @@ send_viewer_streams(struct lttcomm_sock *sock, uint64_t session_id, unsigned int
 			vstream->sent_flag = true;
 			pthread_mutex_unlock(&vstream->stream->lock);
 
-			ret = send_response(sock, &send_stream, sizeof(send_stream));
+			ret = send_response(conn, &send_stream, sizeof(send_stream));
 			viewer_stream_put(vstream);
 			if (ret < 0) {
 				goto end;
@@ -342,7 +585,8 @@ end:
 
 /*
  * Create every viewer stream possible for the given session with the seek
- * type. Three counters *can* be return which are in order the total amount of
+ * type and, for LTTNG_VIEWER_SEEK_TIMESTAMP, the seek timestamp. Three
+ * counters *can* be return which are in order the total amount of
  * viewer stream of the session, the number of unsent stream and the number of
  * stream created. Those counters can be NULL and thus will be ignored.
  *
@@ -354,6 +598,7 @@ end:
 static int make_viewer_streams(struct relay_session *relay_session,
 			       struct relay_viewer_session *viewer_session,
 			       enum lttng_viewer_seek seek_t,
+			       uint64_t seek_timestamp,
 			       uint32_t *nb_total,
 			       uint32_t *nb_unsent,
 			       uint32_t *nb_created,
@@ -436,6 +681,11 @@ static int make_viewer_streams(struct relay_session *relay_session,
 				if (!relay_stream->published) {
 					goto next;
 				}
+				if (!relay_stream->is_metadata &&
+				    !viewer_session_accepts_stream(viewer_session,
+								   relay_stream->channel_name)) {
+					goto next;
+				}
 				viewer_stream =
 					viewer_stream_get_by_id(relay_stream->stream_handle);
 				if (!viewer_stream) {
@@ -511,8 +761,11 @@ static int make_viewer_streams(struct relay_session *relay_session,
 						}
 					}
 
-					viewer_stream = viewer_stream_create(
-						relay_stream, viewer_stream_trace_chunk, seek_t);
+					viewer_stream =
+						viewer_stream_create(relay_stream,
+								     viewer_stream_trace_chunk,
+								     seek_t,
+								     seek_timestamp);
 					lttng_trace_chunk_put(viewer_stream_trace_chunk);
 					viewer_stream_trace_chunk = nullptr;
 					if (!viewer_stream) {
@@ -808,6 +1061,17 @@ static void *thread_listener(void *data __attribute__((unused)))
 					lttcomm_destroy_sock(newsock);
 					goto error;
 				}
+
+				/* Lets TCP detect the viewers which vanished while idle. */
+				ret = socket_apply_keep_alive_config(newsock->fd);
+				if (ret < 0) {
+					ERR("Failed to apply TCP keep-alive configuration "
+					    "on socket (%i)",
+					    newsock->fd);
+					lttcomm_destroy_sock(newsock);
+					goto error;
+				}
+
 				new_conn = connection_create(newsock, RELAY_CONNECTION_UNKNOWN);
 				if (!new_conn) {
 					lttcomm_destroy_sock(newsock);
@@ -877,6 +1141,8 @@ static void *thread_dispatcher(void *data __attribute__((unused)))
 	ssize_t ret;
 	struct cds_wfcq_node *node;
 	struct relay_connection *conn = nullptr;
+	unsigned int next_worker = 0;
+	struct live_worker *worker;
 
 	DBG("[thread] Live viewer relay dispatcher started");
 
@@ -911,7 +1177,14 @@ static void *thread_dispatcher(void *data __attribute__((unused)))
 				break;
 			}
 			conn = lttng::utils::container_of(node, &relay_connection::qnode);
-			DBG("Dispatching viewer request waiting on sock %d", conn->sock->fd);
+
+			/* Spread the viewers across the workers in a round-robin fashion. */
+			worker = &live_workers[next_worker];
+			next_worker = (next_worker + 1) % live_worker_count;
+
+			DBG("Dispatching viewer request waiting on sock %d to live worker %u",
+			    conn->sock->fd,
+			    worker->id);
 
 			/*
 			 * Inform worker thread of the new request. This
@@ -919,9 +1192,9 @@ static void *thread_dispatcher(void *data __attribute__((unused)))
 			 * the data will be read at some point in time
 			 * or wait to the end of the world :)
 			 */
-			ret = lttng_write(live_conn_pipe[1], &conn, sizeof(conn)); /* NOLINT sizeof
-										      used on a
-										      pointer. */
+			ret = lttng_write(worker->conn_pipe[1],
+					  &conn,
+					  sizeof(conn)); /* NOLINT sizeof used on a pointer. */
 			if (ret < 0) {
 				PERROR("write conn pipe");
 				connection_put(conn);
@@ -952,15 +1225,78 @@ error_testpoint:
 	return nullptr;
 }
 
+#ifdef HAVE_LIBZSTD
+static void zstd_free_cctx(ZSTD_CCtx *cctx)
+{
+	(void) ZSTD_freeCCtx(cctx);
+}
+
+/* Compression context of the live worker thread, created on first use. */
+static thread_local auto zstd_cctx = lttng::make_unique_wrapper<ZSTD_CCtx, zstd_free_cctx>();
+
+/*
+ * Compress `len` bytes into `compressed`, replacing its content.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int compress_zstd(const char *data, uint64_t len, struct lttng_dynamic_buffer *compressed)
+{
+	size_t compressed_size;
+
+	if (!zstd_cctx) {
+		zstd_cctx.reset(ZSTD_createCCtx());
+		if (!zstd_cctx) {
+			ERR("Failed to create zstd compression context");
+			return -1;
+		}
+	}
+
+	if (lttng_dynamic_buffer_set_size(compressed, ZSTD_compressBound(len))) {
+		ERR("Failed to allocate compression buffer: size = %zu", ZSTD_compressBound(len));
+		return -1;
+	}
+
+	compressed_size = ZSTD_compressCCtx(zstd_cctx.get(),
+					    compressed->data,
+					    compressed->size,
+					    data,
+					    len,
+					    ZSTD_CLEVEL_DEFAULT);
+	if (ZSTD_isError(compressed_size)) {
+		ERR("Failed to compress live data: len = %" PRIu64 ", error = %s",
+		    len,
+		    ZSTD_getErrorName(compressed_size));
+		return -1;
+	}
+
+	(void) lttng_dynamic_buffer_set_size(compressed, compressed_size);
+	return 0;
+}
+#endif /* HAVE_LIBZSTD */
+
+/*
+ * Return the LTTNG_VIEWER_CAPABILITY_* supported by this build.
+ */
+static uint64_t viewer_supported_capabilities()
+{
+#ifdef HAVE_LIBZSTD
+	return LTTNG_VIEWER_CAPABILITY_PACKET_ZSTD;
+#else
+	return 0;
+#endif /* HAVE_LIBZSTD */
+}
+
 /*
  * Establish connection with the viewer and check the versions.
  *
  * Return 0 on success or else negative value.
  */
-static int viewer_connect(struct relay_connection *conn)
+static int viewer_connect(struct relay_connection *conn, uint64_t data_size)
 {
 	int ret;
 	struct lttng_viewer_connect reply, msg;
+	struct lttng_viewer_connect_capabilities capabilities;
+	const bool has_capabilities = data_size >= sizeof(msg) + sizeof(capabilities);
 
 	conn->version_check_done = true;
 
@@ -971,6 +1307,13 @@ static int viewer_connect(struct relay_connection *conn)
 		goto end;
 	}
 
+	if (has_capabilities) {
+		ret = recv_request(conn->sock, &capabilities, sizeof(capabilities));
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
 	health_code_update();
 
 	memset(&reply, 0, sizeof(reply));
@@ -1004,6 +1347,14 @@ static int viewer_connect(struct relay_connection *conn)
 		goto end;
 	}
 
+	if (has_capabilities) {
+		conn->protocol.viewer.capabilities =
+			conn->minor >= LTTNG_VIEWER_CAPABILITIES_MINOR ?
+			be64toh(capabilities.capabilities) & viewer_supported_capabilities() :
+			0;
+		capabilities.capabilities = htobe64(conn->protocol.viewer.capabilities);
+	}
+
 	reply.major = htobe32(reply.major);
 	reply.minor = htobe32(reply.minor);
 	if (conn->type == RELAY_VIEWER_COMMAND) {
@@ -1020,20 +1371,62 @@ static int viewer_connect(struct relay_connection *conn)
 
 	health_code_update();
 
-	ret = send_response(conn->sock, &reply, sizeof(reply));
+	ret = send_response(conn, &reply, sizeof(reply));
 	if (ret < 0) {
 		goto end;
 	}
 
+	if (has_capabilities) {
+		ret = send_response(conn, &capabilities, sizeof(capabilities));
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
 	health_code_update();
 
-	DBG("Version check done using protocol %u.%u", conn->major, conn->minor);
+	DBG("Version check done using protocol %u.%u, capabilities = %#" PRIx64,
+	    conn->major,
+	    conn->minor,
+	    conn->protocol.viewer.capabilities);
 	ret = 0;
 
 end:
 	return ret;
 }
 
+/*
+ * Fill the listing record of a session.
+ *
+ * Called with the session lock held.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int fill_viewer_session(struct lttng_viewer_session *send_session,
+			       const struct relay_session *session)
+{
+	ASSERT_LOCKED(session->lock);
+
+	if (lttng_strncpy(send_session->session_name,
+			  session->session_name,
+			  sizeof(send_session->session_name))) {
+		return -1;
+	}
+	if (lttng_strncpy(
+		    send_session->hostname, session->hostname, sizeof(send_session->hostname))) {
+		return -1;
+	}
+	send_session->id = htobe64(session->id);
+	send_session->live_timer = htobe32(session->live_timer);
+	if (session->viewer_attached) {
+		send_session->clients = htobe32(1);
+	} else {
+		send_session->clients = htobe32(0);
+	}
+	send_session->streams = htobe32(session->stream_count);
+	return 0;
+}
+
 /*
  * Send the viewer the list of current sessions.
  * We need to create a copy of the hash table content because otherwise
@@ -1086,26 +1479,10 @@ static int viewer_list_sessions(struct relay_connection *conn)
 				buf_count = new_buf_count;
 			}
 			send_session = &send_session_buf[count];
-			if (lttng_strncpy(send_session->session_name,
-					  session->session_name,
-					  sizeof(send_session->session_name))) {
-				ret = -1;
-				goto break_loop;
-			}
-			if (lttng_strncpy(send_session->hostname,
-					  session->hostname,
-					  sizeof(send_session->hostname))) {
-				ret = -1;
+			ret = fill_viewer_session(send_session, session);
+			if (ret < 0) {
 				goto break_loop;
 			}
-			send_session->id = htobe64(session->id);
-			send_session->live_timer = htobe32(session->live_timer);
-			if (session->viewer_attached) {
-				send_session->clients = htobe32(1);
-			} else {
-				send_session->clients = htobe32(0);
-			}
-			send_session->streams = htobe32(session->stream_count);
 			count++;
 		next_session:
 			pthread_mutex_unlock(&session->lock);
@@ -1124,14 +1501,14 @@ static int viewer_list_sessions(struct relay_connection *conn)
 
 	health_code_update();
 
-	ret = send_response(conn->sock, &session_list, sizeof(session_list));
+	ret = send_response(conn, &session_list, sizeof(session_list));
 	if (ret < 0) {
 		goto end_free;
 	}
 
 	health_code_update();
 
-	ret = send_response(conn->sock, send_session_buf, count * sizeof(*send_session_buf));
+	ret = send_response(conn, send_session_buf, count * sizeof(*send_session_buf));
 	if (ret < 0) {
 		goto end_free;
 	}
@@ -1144,56 +1521,252 @@ end_free:
 }
 
 /*
- * Send the viewer the list of current streams.
+ * Append the listing record of a session changed since `since_generation`,
+ * or its id if it is closed, if it matches the filters.
+ *
+ * Return 0 on success or else a negative value.
  */
-static int viewer_get_new_streams(struct relay_connection *conn)
+static int list_filtered_session(struct relay_session *session,
+				 uint64_t since_generation,
+				 bool live_only,
+				 const char *session_name_prefix,
+				 struct lttng_dynamic_buffer *sessions,
+				 struct lttng_dynamic_buffer *closed_ids)
 {
-	int ret, send_streams = 0;
-	uint32_t nb_created = 0, nb_unsent = 0, nb_streams = 0, nb_total = 0;
-	struct lttng_viewer_new_streams_request request;
-	struct lttng_viewer_new_streams_response response;
-	struct relay_session *session = nullptr;
-	uint64_t session_id;
-	bool closed = false;
+	int ret = 0;
+
+	/* The live timer and the name of a session don't change. */
+	if (uatomic_read(&session->generation) <= since_generation ||
+	    (live_only && session->live_timer == 0) ||
+	    strncmp(session->session_name, session_name_prefix, strlen(session_name_prefix))) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&session->lock);
+	if (session->connection_closed) {
+		/* A full listing leaves out the closed sessions. */
+		if (since_generation > 0) {
+			const uint64_t id = htobe64(session->id);
+
+			ret = lttng_dynamic_buffer_append(closed_ids, &id, sizeof(id));
+		}
+	} else {
+		struct lttng_viewer_session send_session = {};
+
+		ret = fill_viewer_session(&send_session, session);
+		if (!ret) {
+			ret = lttng_dynamic_buffer_append(
+				sessions, &send_session, sizeof(send_session));
+		}
+	}
+	pthread_mutex_unlock(&session->lock);
+
+	return ret;
+}
+
+/*
+ * List the sessions matching the filters of a list_sessions_filtered request,
+ * using the index of the sessions by hostname when one is requested.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int list_filtered_sessions(const struct lttng_viewer_list_sessions_filtered_request *request,
+				  uint64_t since_generation,
+				  struct lttng_dynamic_buffer *sessions,
+				  struct lttng_dynamic_buffer *closed_ids)
+{
+	int ret = 0;
+	const bool live_only = be32toh(request->flags) & LTTNG_VIEWER_LIST_SESSIONS_FLAG_LIVE_ONLY;
+	struct relay_session *session;
+	lttng::urcu::read_lock_guard read_lock;
+
+	if (request->hostname[0] == '\0') {
+		struct lttng_ht_iter iter;
+
+		cds_lfht_for_each_entry (sessions_ht->ht, &iter.iter, session, session_n.node) {
+			health_code_update();
+			ret = list_filtered_session(session,
+						    since_generation,
+						    live_only,
+						    request->session_name_prefix,
+						    sessions,
+						    closed_ids);
+			if (ret < 0) {
+				break;
+			}
+		}
+	} else {
+		struct cds_list_head *host_sessions = session_get_host_sessions(request->hostname);
+
+		if (!host_sessions) {
+			return 0;
+		}
+
+		cds_list_for_each_entry_rcu(session, host_sessions, host_node)
+		{
+			health_code_update();
+			ret = list_filtered_session(session,
+						    since_generation,
+						    live_only,
+						    request->session_name_prefix,
+						    sessions,
+						    closed_ids);
+			if (ret < 0) {
+				break;
+			}
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * Send the viewer the sessions matching its filters, all of them or only
+ * those changed since the generation of its previous listing.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_list_sessions_filtered(struct relay_connection *conn)
+{
+	int ret;
+	uint64_t since_generation;
+	struct lttng_viewer_list_sessions_filtered_request request;
+	struct lttng_viewer_list_sessions_filtered_response response;
+	struct lttng_dynamic_buffer sessions, closed_ids;
 
 	LTTNG_ASSERT(conn);
 
 	health_code_update();
 
-	/* Receive the request from the connected client. */
 	ret = recv_request(conn->sock, &request, sizeof(request));
 	if (ret < 0) {
-		goto error;
+		return ret;
 	}
-	session_id = be64toh(request.session_id);
-
 	health_code_update();
 
+	request.hostname[sizeof(request.hostname) - 1] = '\0';
+	request.session_name_prefix[sizeof(request.session_name_prefix) - 1] = '\0';
+	lttng_dynamic_buffer_init(&sessions);
+	lttng_dynamic_buffer_init(&closed_ids);
 	memset(&response, 0, sizeof(response));
 
-	session = session_get_by_id(session_id);
-	if (!session) {
-		DBG("Relay session %" PRIu64 " not found", session_id);
-		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_ERR);
-		goto send_reply;
+	/*
+	 * The generation is sampled before listing: the sessions changed while
+	 * they are listed are listed again by the next request.
+	 */
+	const uint64_t generation = session_get_generation();
+
+	since_generation = be64toh(request.since_generation);
+	if (since_generation > generation) {
+		/* The viewer listed the sessions of a previous relay daemon. */
+		since_generation = 0;
 	}
 
-	if (!viewer_session_is_attached(conn->viewer_session, session)) {
-		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_ERR);
-		goto send_reply;
+	ret = list_filtered_sessions(&request, since_generation, &sessions, &closed_ids);
+	if (!ret && since_generation > 0 &&
+	    since_generation < session_get_destroyed_generation()) {
+		/*
+		 * A session changed since the generation was destroyed, maybe
+		 * before being listed as closed: list all the sessions.
+		 */
+		since_generation = 0;
+		(void) lttng_dynamic_buffer_set_size(&sessions, 0);
+		(void) lttng_dynamic_buffer_set_size(&closed_ids, 0);
+		ret = list_filtered_sessions(&request, since_generation, &sessions, &closed_ids);
+	}
+	if (ret < 0) {
+		goto end;
 	}
 
-	/*
-	 * For any new stream, create it with LTTNG_VIEWER_SEEK_BEGINNING since
-	 * that at this point the client is already attached to the session.Aany
-	 * initial stream will have been created with the seek type at attach
-	 * time (for now most readers use the LTTNG_VIEWER_SEEK_LAST on attach).
-	 * Otherwise any event happening in a new stream between the attach and
-	 * a call to viewer_get_new_streams will be "lost" (never received) from
-	 * the viewer's point of view.
-	 */
-	pthread_mutex_lock(&session->lock);
-	/*
+	response.generation = htobe64(generation);
+	if (since_generation == 0) {
+		response.flags = htobe32(LTTNG_VIEWER_LIST_SESSIONS_FLAG_FULL);
+	}
+	response.sessions_count = htobe32(sessions.size / sizeof(struct lttng_viewer_session));
+	response.closed_count = htobe32(closed_ids.size / sizeof(uint64_t));
+
+	health_code_update();
+	ret = send_response(conn, &response, sizeof(response));
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = send_response(conn, sessions.data, sessions.size);
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = send_response(conn, closed_ids.data, closed_ids.size);
+	if (ret < 0) {
+		goto end;
+	}
+	health_code_update();
+
+	DBG("Listed %zu sessions and %zu closed sessions since generation %" PRIu64
+	    " for viewer on connection %d",
+	    sessions.size / sizeof(struct lttng_viewer_session),
+	    closed_ids.size / sizeof(uint64_t),
+	    since_generation,
+	    conn->sock->fd);
+	ret = 0;
+
+end:
+	lttng_dynamic_buffer_reset(&sessions);
+	lttng_dynamic_buffer_reset(&closed_ids);
+	return ret;
+}
+
+/*
+ * Send the viewer the list of current streams.
+ */
+static int viewer_get_new_streams(struct relay_connection *conn)
+{
+	int ret, send_streams = 0;
+	uint32_t nb_created = 0, nb_unsent = 0, nb_streams = 0, nb_total = 0;
+	struct lttng_viewer_new_streams_request request;
+	struct lttng_viewer_new_streams_response response;
+	struct relay_session *session = nullptr;
+	uint64_t session_id;
+	bool closed = false;
+
+	LTTNG_ASSERT(conn);
+
+	health_code_update();
+
+	/* Receive the request from the connected client. */
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		goto error;
+	}
+	session_id = be64toh(request.session_id);
+
+	health_code_update();
+
+	memset(&response, 0, sizeof(response));
+
+	session = session_get_by_id(session_id);
+	if (!session) {
+		DBG("Relay session %" PRIu64 " not found", session_id);
+		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_ERR);
+		goto send_reply;
+	}
+
+	if (!viewer_session_is_attached(conn->viewer_session, session)) {
+		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_ERR);
+		goto send_reply;
+	}
+
+	/*
+	 * For any new stream, create it with LTTNG_VIEWER_SEEK_BEGINNING since
+	 * that at this point the client is already attached to the session.Aany
+	 * initial stream will have been created with the seek type at attach
+	 * time (for now most readers use the LTTNG_VIEWER_SEEK_LAST on attach).
+	 * Otherwise any event happening in a new stream between the attach and
+	 * a call to viewer_get_new_streams will be "lost" (never received) from
+	 * the viewer's point of view.
+	 */
+	pthread_mutex_lock(&session->lock);
+	/*
 	 * If a session rotation is ongoing, do not attempt to open any
 	 * stream, because the chunk can be in an intermediate state
 	 * due to directory renaming.
@@ -1206,6 +1779,7 @@ static int viewer_get_new_streams(struct relay_connection *conn)
 	ret = make_viewer_streams(session,
 				  conn->viewer_session,
 				  LTTNG_VIEWER_SEEK_BEGINNING,
+				  0,
 				  &nb_total,
 				  &nb_unsent,
 				  &nb_created,
@@ -1240,7 +1814,7 @@ send_reply_unlock:
 
 send_reply:
 	health_code_update();
-	ret = send_response(conn->sock, &response, sizeof(response));
+	ret = send_response(conn, &response, sizeof(response));
 	if (ret < 0) {
 		goto end_put_session;
 	}
@@ -1260,7 +1834,7 @@ send_reply:
 	 * streams that were not sent from that point will be sent to
 	 * the viewer.
 	 */
-	ret = send_viewer_streams(conn->sock, session_id, 0);
+	ret = send_viewer_streams(conn, session, 0);
 	if (ret < 0) {
 		goto end_put_session;
 	}
@@ -1273,6 +1847,23 @@ error:
 	return ret;
 }
 
+/*
+ * Return true if a seek type of an attach request is supported by the
+ * protocol version of the viewer.
+ */
+static bool viewer_seek_supported(const struct relay_connection *conn, uint32_t seek)
+{
+	switch (seek) {
+	case LTTNG_VIEWER_SEEK_BEGINNING:
+	case LTTNG_VIEWER_SEEK_LAST:
+		return true;
+	case LTTNG_VIEWER_SEEK_TIMESTAMP:
+		return conn->minor >= LTTNG_VIEWER_SEEK_TIMESTAMP_MINOR;
+	default:
+		return false;
+	}
+}
+
 /*
  * Send the viewer the list of current sessions.
  */
@@ -1340,13 +1931,7 @@ static int viewer_attach_session(struct relay_connection *conn)
 		goto send_reply;
 	}
 
-	switch (be32toh(request.seek)) {
-	case LTTNG_VIEWER_SEEK_BEGINNING:
-	case LTTNG_VIEWER_SEEK_LAST:
-		viewer_attach_status = LTTNG_VIEWER_ATTACH_OK;
-		seek_type = (lttng_viewer_seek) be32toh(request.seek);
-		break;
-	default:
+	if (!viewer_seek_supported(conn, be32toh(request.seek))) {
 		ERR("Wrong seek parameter for relay session %" PRIu64 ", returning status=%s",
 		    session_id,
 		    lttng_viewer_attach_return_code_str(viewer_attach_status));
@@ -1354,6 +1939,8 @@ static int viewer_attach_session(struct relay_connection *conn)
 		send_streams = 0;
 		goto send_reply;
 	}
+	viewer_attach_status = LTTNG_VIEWER_ATTACH_OK;
+	seek_type = (lttng_viewer_seek) be32toh(request.seek);
 
 	/*
 	 * If a session rotation is ongoing, do not attempt to open any
@@ -1366,8 +1953,14 @@ static int viewer_attach_session(struct relay_connection *conn)
 		goto send_reply;
 	}
 
-	ret = make_viewer_streams(
-		session, conn->viewer_session, seek_type, &nb_streams, nullptr, nullptr, &closed);
+	ret = make_viewer_streams(session,
+				  conn->viewer_session,
+				  seek_type,
+				  be64toh(request.offset),
+				  &nb_streams,
+				  nullptr,
+				  nullptr,
+				  &closed);
 	if (ret < 0) {
 		goto end_put_session;
 	}
@@ -1397,7 +1990,7 @@ send_reply:
 
 	response.status = htobe32((uint32_t) viewer_attach_status);
 
-	ret = send_response(conn->sock, &response, sizeof(response));
+	ret = send_response(conn, &response, sizeof(response));
 	if (ret < 0) {
 		goto end_put_session;
 	}
@@ -1413,7 +2006,7 @@ send_reply:
 	}
 
 	/* Send stream and ignore the sent flag. */
-	ret = send_viewer_streams(conn->sock, session_id, 1);
+	ret = send_viewer_streams(conn, session, 1);
 	if (ret < 0) {
 		goto end_put_session;
 	}
@@ -1472,6 +2065,23 @@ static int try_open_index(struct relay_viewer_stream *vstream, struct relay_stre
 		} else {
 			ret = -1;
 		}
+		goto end;
+	}
+
+	if (vstream->pending_index_position > 0) {
+		const off_t offset = sizeof(struct ctf_packet_index_file_hdr) +
+			vstream->pending_index_position * vstream->index_file->element_len;
+
+		if (fs_handle_seek(vstream->index_file->file, offset, SEEK_SET) < 0) {
+			PERROR("Failed to seek index file of viewer stream %" PRIu64,
+			       rstream->stream_handle);
+			lttng_index_file_put(vstream->index_file);
+			vstream->index_file = nullptr;
+			ret = -1;
+			goto end;
+		}
+
+		vstream->pending_index_position = 0;
 	}
 
 end:
@@ -1644,42 +2254,40 @@ static void viewer_stream_rotate_to_trace_chunk(struct relay_viewer_stream *vstr
 }
 
 /*
- * Send the next index for a stream.
+ * Get the next index of a viewer stream. The reply to the viewer is
+ * populated in network byte order in `viewer_index`, even when its status
+ * is an error.
  *
- * Return 0 on success or else a negative value.
+ * Return 0 on success or else a negative value on an internal error, in
+ * which case the connection must be closed.
  */
-static int viewer_get_next_index(struct relay_connection *conn)
+static int get_next_index(struct relay_connection *conn,
+			  uint64_t stream_id,
+			  struct lttng_viewer_index *viewer_index)
 {
 	int ret;
-	struct lttng_viewer_get_next_index request_index;
-	struct lttng_viewer_index viewer_index;
 	struct ctf_packet_index packet_index;
 	struct relay_viewer_stream *vstream = nullptr;
 	struct relay_stream *rstream = nullptr;
 	struct ctf_trace *ctf_trace = nullptr;
 	struct relay_viewer_stream *metadata_viewer_stream = nullptr;
 	bool viewer_stream_and_session_in_same_chunk, viewer_stream_one_rotation_behind;
+	bool index_cached;
 	uint64_t stream_file_chunk_id = -1ULL, viewer_session_chunk_id = -1ULL;
 	enum lttng_trace_chunk_status status;
 
 	LTTNG_ASSERT(conn);
 
-	memset(&viewer_index, 0, sizeof(viewer_index));
-	health_code_update();
-
-	ret = recv_request(conn->sock, &request_index, sizeof(request_index));
-	if (ret < 0) {
-		goto end;
-	}
+	memset(viewer_index, 0, sizeof(*viewer_index));
 	health_code_update();
 
-	vstream = viewer_stream_get_by_id(be64toh(request_index.stream_id));
+	vstream = viewer_stream_get_by_id(stream_id);
 	if (!vstream) {
-		viewer_index.status = LTTNG_VIEWER_INDEX_ERR;
+		viewer_index->status = LTTNG_VIEWER_INDEX_ERR;
 		DBG("Client requested index of unknown stream id %" PRIu64 ", returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		goto send_reply;
 	}
 
@@ -1703,34 +2311,34 @@ static int viewer_get_next_index(struct relay_connection *conn)
 	 * The viewer should not ask for index on metadata stream.
 	 */
 	if (rstream->is_metadata) {
-		viewer_index.status = LTTNG_VIEWER_INDEX_HUP;
+		viewer_index->status = LTTNG_VIEWER_INDEX_HUP;
 		DBG("Client requested index of a metadata stream id %" PRIu64
 		    ", returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		goto send_reply;
 	}
 
 	if (rstream->ongoing_rotation.is_set) {
 		/* Rotation is ongoing, try again later. */
-		viewer_index.status = LTTNG_VIEWER_INDEX_RETRY;
+		viewer_index->status = LTTNG_VIEWER_INDEX_RETRY;
 		DBG("Client requested index for stream id %" PRIu64
 		    " while a stream rotation is ongoing, returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		goto send_reply;
 	}
 
 	if (session_has_ongoing_rotation(rstream->trace->session)) {
 		/* Rotation is ongoing, try again later. */
-		viewer_index.status = LTTNG_VIEWER_INDEX_RETRY;
+		viewer_index->status = LTTNG_VIEWER_INDEX_RETRY;
 		DBG("Client requested index for stream id %" PRIu64
 		    " while a session rotation is ongoing, returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		goto send_reply;
 	}
 
@@ -1744,12 +2352,13 @@ static int viewer_get_next_index(struct relay_connection *conn)
 		ret = viewer_session_set_trace_chunk_copy(conn->viewer_session,
 							  rstream->trace_chunk);
 		if (ret) {
-			viewer_index.status = LTTNG_VIEWER_INDEX_ERR;
+			viewer_index->status = LTTNG_VIEWER_INDEX_ERR;
 			ERR("Error copying trace chunk for stream id %" PRIu64
 			    ", returning status=%s",
-			    (uint64_t) be64toh(request_index.stream_id),
+			    stream_id,
 			    lttng_viewer_next_index_return_code_str(
-				    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+				    (enum lttng_viewer_next_index_return_code)
+					    viewer_index->status));
 			goto send_reply;
 		}
 	}
@@ -1811,7 +2420,13 @@ static int viewer_get_next_index(struct relay_connection *conn)
 		vstream->last_seen_rotation_count = rstream->completed_rotation_count;
 	}
 
-	ret = check_index_status(vstream, rstream, ctf_trace, &viewer_index);
+	/* The viewer reads the index entries from the index file. */
+	ret = stream_flush_index_buffer(rstream);
+	if (ret) {
+		goto error_put;
+	}
+
+	ret = check_index_status(vstream, rstream, ctf_trace, viewer_index);
 	if (ret < 0) {
 		goto error_put;
 	} else if (ret == 1) {
@@ -1824,32 +2439,44 @@ static int viewer_get_next_index(struct relay_connection *conn)
 	/* At this point, ret is 0 thus we will be able to read the index. */
 	LTTNG_ASSERT(!ret);
 
+	/*
+	 * The last index entries of a closed stream are sent from its index
+	 * cache to the viewers which didn't open its index file yet.
+	 */
+	index_cached = rstream->closed && !vstream->index_file &&
+		index_cache_lookup(&rstream->index_cache,
+				   vstream->index_sent_seqcount,
+				   vstream->last_seen_rotation_count,
+				   &packet_index);
+
 	/* Try to open an index if one is needed for that stream. */
-	ret = try_open_index(vstream, rstream);
+	ret = index_cached ? 0 : try_open_index(vstream, rstream);
 	if (ret == -ENOENT) {
 		if (rstream->closed) {
-			viewer_index.status = LTTNG_VIEWER_INDEX_HUP;
+			viewer_index->status = LTTNG_VIEWER_INDEX_HUP;
 			DBG("Cannot open index for stream id %" PRIu64
 			    "stream is closed, returning status=%s",
-			    (uint64_t) be64toh(request_index.stream_id),
+			    stream_id,
 			    lttng_viewer_next_index_return_code_str(
-				    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+				    (enum lttng_viewer_next_index_return_code)
+					    viewer_index->status));
 			goto send_reply;
 		} else {
-			viewer_index.status = LTTNG_VIEWER_INDEX_RETRY;
+			viewer_index->status = LTTNG_VIEWER_INDEX_RETRY;
 			DBG("Cannot open index for stream id %" PRIu64 ", returning status=%s",
-			    (uint64_t) be64toh(request_index.stream_id),
+			    stream_id,
 			    lttng_viewer_next_index_return_code_str(
-				    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+				    (enum lttng_viewer_next_index_return_code)
+					    viewer_index->status));
 			goto send_reply;
 		}
 	}
 	if (ret < 0) {
-		viewer_index.status = LTTNG_VIEWER_INDEX_ERR;
+		viewer_index->status = LTTNG_VIEWER_INDEX_ERR;
 		ERR("Error opening index for stream id %" PRIu64 ", returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		goto send_reply;
 	}
 
@@ -1884,13 +2511,13 @@ static int viewer_get_next_index(struct relay_connection *conn)
 			vstream->stream_file.trace_chunk, file_path, O_RDONLY, 0, &fs_handle, true);
 		if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
 			if (status == LTTNG_TRACE_CHUNK_STATUS_NO_FILE && rstream->closed) {
-				viewer_index.status = LTTNG_VIEWER_INDEX_HUP;
+				viewer_index->status = LTTNG_VIEWER_INDEX_HUP;
 				DBG("Cannot find trace chunk file and stream is closed for stream id %" PRIu64
 				    ", returning status=%s",
-				    (uint64_t) be64toh(request_index.stream_id),
+				    stream_id,
 				    lttng_viewer_next_index_return_code_str(
 					    (enum lttng_viewer_next_index_return_code)
-						    viewer_index.status));
+						    viewer_index->status));
 				goto send_reply;
 			}
 			PERROR("Failed to open trace file for viewer stream");
@@ -1901,31 +2528,37 @@ static int viewer_get_next_index(struct relay_connection *conn)
 
 	ret = check_new_streams(conn);
 	if (ret < 0) {
-		viewer_index.status = LTTNG_VIEWER_INDEX_ERR;
+		viewer_index->status = LTTNG_VIEWER_INDEX_ERR;
 		ERR("Error checking for new streams before sending new index to stream id %" PRIu64
 		    ", returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		goto send_reply;
 	} else if (ret == 1) {
-		viewer_index.flags |= LTTNG_VIEWER_FLAG_NEW_STREAM;
+		viewer_index->flags |= LTTNG_VIEWER_FLAG_NEW_STREAM;
 	}
 
-	ret = lttng_index_file_read(vstream->index_file, &packet_index);
+	if (index_cached) {
+		/* The index file is opened past the entries sent from the cache. */
+		vstream->pending_index_position++;
+		ret = 0;
+	} else {
+		ret = lttng_index_file_read(vstream->index_file, &packet_index);
+	}
 	if (ret) {
-		viewer_index.status = LTTNG_VIEWER_INDEX_ERR;
+		viewer_index->status = LTTNG_VIEWER_INDEX_ERR;
 		ERR("Relay error reading index file for stream id %" PRIu64 ", returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		goto send_reply;
 	} else {
-		viewer_index.status = LTTNG_VIEWER_INDEX_OK;
+		viewer_index->status = LTTNG_VIEWER_INDEX_OK;
 		DBG("Read index file for stream id %" PRIu64 ", returning status=%s",
-		    (uint64_t) be64toh(request_index.stream_id),
+		    stream_id,
 		    lttng_viewer_next_index_return_code_str(
-			    (enum lttng_viewer_next_index_return_code) viewer_index.status));
+			    (enum lttng_viewer_next_index_return_code) viewer_index->status));
 		vstream->index_sent_seqcount++;
 	}
 
@@ -1935,13 +2568,13 @@ static int viewer_get_next_index(struct relay_connection *conn)
 	DBG("Sending viewer index for stream %" PRIu64 " offset %" PRIu64,
 	    rstream->stream_handle,
 	    (uint64_t) be64toh(packet_index.offset));
-	viewer_index.offset = packet_index.offset;
-	viewer_index.packet_size = packet_index.packet_size;
-	viewer_index.content_size = packet_index.content_size;
-	viewer_index.timestamp_begin = packet_index.timestamp_begin;
-	viewer_index.timestamp_end = packet_index.timestamp_end;
-	viewer_index.events_discarded = packet_index.events_discarded;
-	viewer_index.stream_id = packet_index.stream_id;
+	viewer_index->offset = packet_index.offset;
+	viewer_index->packet_size = packet_index.packet_size;
+	viewer_index->content_size = packet_index.content_size;
+	viewer_index->timestamp_begin = packet_index.timestamp_begin;
+	viewer_index->timestamp_end = packet_index.timestamp_end;
+	viewer_index->events_discarded = packet_index.events_discarded;
+	viewer_index->stream_id = packet_index.stream_id;
 
 send_reply:
 	if (rstream) {
@@ -1957,27 +2590,22 @@ send_reply:
 		if (!metadata_viewer_stream->stream->metadata_received ||
 		    metadata_viewer_stream->stream->metadata_received >
 			    metadata_viewer_stream->metadata_sent) {
-			viewer_index.flags |= LTTNG_VIEWER_FLAG_NEW_METADATA;
+			viewer_index->flags |= LTTNG_VIEWER_FLAG_NEW_METADATA;
 		}
 		pthread_mutex_unlock(&metadata_viewer_stream->stream->lock);
 	}
 
-	viewer_index.flags = htobe32(viewer_index.flags);
-	viewer_index.status = htobe32(viewer_index.status);
-	health_code_update();
-
-	ret = send_response(conn->sock, &viewer_index, sizeof(viewer_index));
-	if (ret < 0) {
-		goto end;
-	}
+	viewer_index->flags = htobe32(viewer_index->flags);
+	viewer_index->status = htobe32(viewer_index->status);
 	health_code_update();
 
 	if (vstream) {
-		DBG("Index %" PRIu64 " for stream %" PRIu64 " sent",
+		DBG("Index %" PRIu64 " for stream %" PRIu64 " ready",
 		    vstream->index_sent_seqcount,
 		    vstream->stream->stream_handle);
 	}
-end:
+
+	ret = 0;
 	if (metadata_viewer_stream) {
 		viewer_stream_put(metadata_viewer_stream);
 	}
@@ -1997,173 +2625,995 @@ error_put:
 }
 
 /*
- * Send the next index for a stream
+ * Send the next index for a stream.
  *
  * Return 0 on success or else a negative value.
  */
-static int viewer_get_packet(struct relay_connection *conn)
+static int viewer_get_next_index(struct relay_connection *conn)
 {
 	int ret;
-	off_t lseek_ret;
-	char *reply = nullptr;
-	struct lttng_viewer_get_packet get_packet_info;
-	struct lttng_viewer_trace_packet reply_header;
-	struct relay_viewer_stream *vstream = nullptr;
-	uint32_t reply_size = sizeof(reply_header);
-	uint32_t packet_data_len = 0;
-	ssize_t read_len;
-	uint64_t stream_id;
-	enum lttng_viewer_get_packet_return_code get_packet_status;
+	struct lttng_viewer_get_next_index request_index;
+	struct lttng_viewer_index viewer_index;
+
+	LTTNG_ASSERT(conn);
 
 	health_code_update();
 
-	ret = recv_request(conn->sock, &get_packet_info, sizeof(get_packet_info));
+	ret = recv_request(conn->sock, &request_index, sizeof(request_index));
 	if (ret < 0) {
-		goto end;
+		return ret;
 	}
 	health_code_update();
 
-	/* From this point on, the error label can be reached. */
-	memset(&reply_header, 0, sizeof(reply_header));
-	stream_id = (uint64_t) be64toh(get_packet_info.stream_id);
-
-	vstream = viewer_stream_get_by_id(stream_id);
-	if (!vstream) {
-		get_packet_status = LTTNG_VIEWER_GET_PACKET_ERR;
-		DBG("Client requested packet of unknown stream id %" PRIu64 ", returning status=%s",
-		    stream_id,
-		    lttng_viewer_get_packet_return_code_str(get_packet_status));
-		goto send_reply_nolock;
-	} else {
-		packet_data_len = be32toh(get_packet_info.len);
-		reply_size += packet_data_len;
+	ret = get_next_index(conn, be64toh(request_index.stream_id), &viewer_index);
+	if (ret < 0) {
+		return ret;
 	}
 
-	reply = zmalloc<char>(reply_size);
-	if (!reply) {
-		get_packet_status = LTTNG_VIEWER_GET_PACKET_ERR;
-		PERROR("Falled to allocate reply, returning status=%s",
-		       lttng_viewer_get_packet_return_code_str(get_packet_status));
-		goto error;
+	ret = send_response(conn, &viewer_index, sizeof(viewer_index));
+	if (ret < 0) {
+		return ret;
 	}
 
-	pthread_mutex_lock(&vstream->stream->lock);
-	lseek_ret = fs_handle_seek(
-		vstream->stream_file.handle, be64toh(get_packet_info.offset), SEEK_SET);
-	if (lseek_ret < 0) {
-		get_packet_status = LTTNG_VIEWER_GET_PACKET_ERR;
-		PERROR("Failed to seek file system handle of viewer stream %" PRIu64
-		       " to offset %" PRIu64 ", returning status=%s",
-		       stream_id,
-		       (uint64_t) be64toh(get_packet_info.offset),
-		       lttng_viewer_get_packet_return_code_str(get_packet_status));
-		goto error;
+	health_code_update();
+	return 0;
+}
+
+/*
+ * Send the next index of every data stream of a session which was sent to
+ * the viewer, in one reply.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_get_next_indexes(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_get_next_indexes request;
+	struct lttng_viewer_next_indexes_response response = {};
+	struct relay_session *session = nullptr;
+	struct relay_viewer_stream *vstream;
+	struct lttng_dynamic_array stream_ids;
+	struct lttng_dynamic_buffer indexes;
+	uint64_t session_id;
+	uint32_t flags, indexes_count = 0;
+
+	LTTNG_ASSERT(conn);
+
+	lttng_dynamic_array_init(&stream_ids, sizeof(uint64_t), nullptr);
+	lttng_dynamic_buffer_init(&indexes);
+	health_code_update();
+
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		goto end;
 	}
-	read_len = fs_handle_read(
-		vstream->stream_file.handle, reply + sizeof(reply_header), packet_data_len);
-	if (read_len < packet_data_len) {
-		get_packet_status = LTTNG_VIEWER_GET_PACKET_ERR;
-		PERROR("Failed to read from file system handle of viewer stream id %" PRIu64
-		       ", offset: %" PRIu64 ", returning status=%s",
-		       stream_id,
-		       (uint64_t) be64toh(get_packet_info.offset),
-		       lttng_viewer_get_packet_return_code_str(get_packet_status));
-		goto error;
+	session_id = be64toh(request.session_id);
+	flags = be32toh(request.flags);
+
+	health_code_update();
+
+	session = session_get_by_id(session_id);
+	if (!session || !viewer_session_is_attached(conn->viewer_session, session)) {
+		DBG("Client requested the next indexes of unknown or unattached session %" PRIu64,
+		    session_id);
+		response.status = htobe32(LTTNG_VIEWER_GET_NEXT_INDEXES_UNK);
+		goto send_reply;
 	}
 
-	get_packet_status = LTTNG_VIEWER_GET_PACKET_OK;
-	reply_header.len = htobe32(packet_data_len);
-	goto send_reply;
+	/*
+	 * The identifiers are collected first: getting the next index of a
+	 * stream takes the session and stream locks.
+	 */
+	{
+		lttng::urcu::read_lock_guard read_lock;
 
-error:
-	/* No payload to send on error. */
-	reply_size = sizeof(reply_header);
+		cds_list_for_each_entry_rcu(vstream, &session->viewer_streams, session_node)
+		{
+			bool sent;
+			uint64_t stream_id;
 
-send_reply:
-	if (vstream) {
-		pthread_mutex_unlock(&vstream->stream->lock);
+			if (!viewer_stream_get(vstream)) {
+				continue;
+			}
+
+			pthread_mutex_lock(&vstream->stream->lock);
+			sent = vstream->sent_flag && !vstream->stream->is_metadata;
+			stream_id = vstream->stream->stream_handle;
+			pthread_mutex_unlock(&vstream->stream->lock);
+			viewer_stream_put(vstream);
+
+			if (sent && lttng_dynamic_array_add_element(&stream_ids, &stream_id)) {
+				ERR("Failed to list the viewer streams of session %" PRIu64,
+				    session_id);
+				response.status = htobe32(LTTNG_VIEWER_GET_NEXT_INDEXES_ERR);
+				goto send_reply;
+			}
+		}
 	}
-send_reply_nolock:
 
-	health_code_update();
+	for (size_t i = 0; i < lttng_dynamic_array_get_count(&stream_ids); i++) {
+		const uint64_t stream_id =
+			*(uint64_t *) lttng_dynamic_array_get_element(&stream_ids, i);
+		struct lttng_viewer_index viewer_index;
 
-	reply_header.status = htobe32(get_packet_status);
-	if (reply) {
-		memcpy(reply, &reply_header, sizeof(reply_header));
-		ret = send_response(conn->sock, reply, reply_size);
-	} else {
-		/* No reply to send. */
-		ret = send_response(conn->sock, &reply_header, reply_size);
+		ret = get_next_index(conn, stream_id, &viewer_index);
+		if (ret < 0) {
+			goto end;
+		}
+
+		if ((flags & LTTNG_VIEWER_GET_NEXT_INDEXES_FLAG_SKIP_RETRY) &&
+		    be32toh(viewer_index.status) == LTTNG_VIEWER_INDEX_RETRY) {
+			continue;
+		}
+
+		if (lttng_dynamic_buffer_append(&indexes, &viewer_index, sizeof(viewer_index))) {
+			ERR("Failed to allocate the next indexes of session %" PRIu64, session_id);
+			ret = -1;
+			goto end;
+		}
+
+		indexes_count++;
 	}
 
+	DBG("Sending %" PRIu32 " next indexes of session %" PRIu64, indexes_count, session_id);
+	response.status = htobe32(LTTNG_VIEWER_GET_NEXT_INDEXES_OK);
+	response.indexes_count = htobe32(indexes_count);
+
+send_reply:
 	health_code_update();
+	ret = send_response(conn, &response, sizeof(response));
 	if (ret < 0) {
-		PERROR("sendmsg of packet data failed");
-		goto end_free;
+		goto end;
 	}
 
-	DBG("Sent %u bytes for stream %" PRIu64, reply_size, stream_id);
+	if (indexes.size > 0) {
+		ret = send_response(conn, indexes.data, indexes.size);
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
+	health_code_update();
+	ret = 0;
 
-end_free:
-	free(reply);
 end:
-	if (vstream) {
-		viewer_stream_put(vstream);
+	if (session) {
+		session_put(session);
 	}
+	lttng_dynamic_array_reset(&stream_ids);
+	lttng_dynamic_buffer_reset(&indexes);
 	return ret;
 }
 
 /*
- * Send the session's metadata
+ * Collect the data streams of the sessions attached to a merged viewer
+ * session which were sent to the viewer and have no head in the merge.
  *
- * Return 0 on success else a negative value.
+ * Return 0 on success, -1 on allocation error.
  */
-static int viewer_get_metadata(struct relay_connection *conn)
+static int collect_merged_streams(struct relay_viewer_session *vsession,
+				  struct lttng_dynamic_array *stream_ids,
+				  bool *sessions_open)
 {
-	int ret = 0;
-	int fd = -1;
-	ssize_t read_len;
-	uint64_t len = 0;
-	char *data = nullptr;
-	struct lttng_viewer_get_metadata request;
-	struct lttng_viewer_metadata_packet reply;
-	struct relay_viewer_stream *vstream = nullptr;
+	struct relay_session *session;
+	lttng::urcu::read_lock_guard read_lock;
+
+	*sessions_open = false;
+	cds_list_for_each_entry_rcu(session, &vsession->session_list, viewer_session_node)
+	{
+		struct relay_viewer_stream *vstream;
+
+		pthread_mutex_lock(&session->lock);
+		if (!session->connection_closed) {
+			*sessions_open = true;
+		}
+		pthread_mutex_unlock(&session->lock);
+
+		cds_list_for_each_entry_rcu(vstream, &session->viewer_streams, session_node)
+		{
+			bool sent;
+			uint64_t stream_id;
+
+			if (!viewer_stream_get(vstream)) {
+				continue;
+			}
+
+			pthread_mutex_lock(&vstream->stream->lock);
+			sent = vstream->sent_flag && !vstream->stream->is_metadata;
+			stream_id = vstream->stream->stream_handle;
+			pthread_mutex_unlock(&vstream->stream->lock);
+			viewer_stream_put(vstream);
+
+			if (!sent || viewer_merge_has_head(&vsession->merge, stream_id)) {
+				continue;
+			}
+
+			if (lttng_dynamic_array_add_element(stream_ids, &stream_id)) {
+				ERR("Failed to list the viewer streams of session %" PRIu64,
+				    session->id);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Send the next index of the merged data streams of the viewer session.
+ *
+ * The next index of each data stream which has no head in the merge is
+ * taken first. The head which begins first is only sent once no data
+ * stream can still receive an index which begins before it.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_get_next_merged_index(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_merged_index reply = {};
+	struct relay_viewer_session *vsession = conn->viewer_session;
+	struct viewer_merge *merge;
+	const struct viewer_merge_head *top;
+	struct lttng_dynamic_array stream_ids;
+	bool sessions_open, blocked = false;
+	uint64_t inactive_until = UINT64_MAX;
+	uint32_t status;
+
+	LTTNG_ASSERT(conn);
+
+	lttng_dynamic_array_init(&stream_ids, sizeof(uint64_t), nullptr);
+	health_code_update();
+
+	if (!vsession || vsession->type != LTTNG_VIEWER_SESSION_TYPE_MERGED) {
+		DBG("Client requested the next merged index without a merged viewer session");
+		reply.index.status = htobe32(LTTNG_VIEWER_INDEX_ERR);
+		goto send_reply;
+	}
+
+	merge = &vsession->merge;
+	if (collect_merged_streams(vsession, &stream_ids, &sessions_open)) {
+		reply.index.status = htobe32(LTTNG_VIEWER_INDEX_ERR);
+		goto send_reply;
+	}
+
+	for (size_t i = 0; i < lttng_dynamic_array_get_count(&stream_ids); i++) {
+		const uint64_t stream_id =
+			*(uint64_t *) lttng_dynamic_array_get_element(&stream_ids, i);
+		struct lttng_viewer_index viewer_index;
+
+		ret = get_next_index(conn, stream_id, &viewer_index);
+		if (ret < 0) {
+			goto end;
+		}
+
+		merge->pending_flags |= be32toh(viewer_index.flags);
+		viewer_index.flags = 0;
+
+		switch (be32toh(viewer_index.status)) {
+		case LTTNG_VIEWER_INDEX_OK:
+			if (viewer_merge_push(merge, stream_id, &viewer_index)) {
+				ret = -1;
+				goto end;
+			}
+			break;
+		case LTTNG_VIEWER_INDEX_INACTIVE:
+			/* The stream has no packet before the end of its beacon. */
+			inactive_until = std::min<uint64_t>(inactive_until,
+							    be64toh(viewer_index.timestamp_end));
+			break;
+		case LTTNG_VIEWER_INDEX_RETRY:
+			blocked = true;
+			break;
+		default:
+			/* The stream has no more packets. */
+			break;
+		}
+	}
+
+	top = viewer_merge_top(merge);
+	if (top && !blocked && be64toh(top->index.timestamp_begin) <= inactive_until) {
+		reply.stream_id = htobe64(top->stream_id);
+		reply.index = top->index;
+		viewer_merge_pop(merge);
+		status = LTTNG_VIEWER_INDEX_OK;
+	} else if (blocked) {
+		status = LTTNG_VIEWER_INDEX_RETRY;
+	} else if (inactive_until != UINT64_MAX) {
+		reply.index.timestamp_end = htobe64(inactive_until);
+		status = LTTNG_VIEWER_INDEX_INACTIVE;
+	} else {
+		/* New streams may still be added to the sessions which are open. */
+		status = sessions_open ? LTTNG_VIEWER_INDEX_RETRY : LTTNG_VIEWER_INDEX_HUP;
+	}
+
+	DBG("Sending next merged index: status=%s",
+	    lttng_viewer_next_index_return_code_str(
+		    (enum lttng_viewer_next_index_return_code) status));
+	reply.index.status = htobe32(status);
+	reply.index.flags = htobe32(merge->pending_flags);
+	merge->pending_flags = 0;
+
+send_reply:
+	health_code_update();
+	ret = send_response(conn, &reply, sizeof(reply));
+	if (ret < 0) {
+		goto end;
+	}
+
+	health_code_update();
+	ret = 0;
+
+end:
+	lttng_dynamic_array_reset(&stream_ids);
+	return ret;
+}
+
+/*
+ * Stop the pending LTTNG_VIEWER_WAIT_NEXT_INDEX request of a viewer, if any.
+ *
+ * Return true if a request was pending.
+ */
+static bool viewer_end_index_wait(struct relay_connection *conn)
+{
+	auto *wait = &conn->protocol.viewer.index_wait;
+
+	if (!wait->vstream) {
+		return false;
+	}
+
+	pthread_mutex_lock(&wait->vstream->stream->lock);
+	stream_remove_index_waiter(wait->vstream->stream, &wait->waiter);
+	pthread_mutex_unlock(&wait->vstream->stream->lock);
+	viewer_stream_put(wait->vstream);
+	wait->vstream = nullptr;
+	return true;
+}
+
+/*
+ * Reply to the pending LTTNG_VIEWER_WAIT_NEXT_INDEX request of a viewer if
+ * its stream has an index to send, if its stream was woken up since the
+ * request, or if the request timed out. Otherwise, wait for the stream to
+ * be woken up.
+ *
+ * Return 1 if the request was answered, 0 if it waits, or else a negative
+ * value on error.
+ */
+static int viewer_check_index_wait(struct relay_connection *conn, bool woken_up)
+{
+	auto *wait = &conn->protocol.viewer.index_wait;
+	struct relay_stream *rstream = wait->vstream->stream;
+	struct lttng_viewer_index viewer_index;
+	int ret;
+
+	while (true) {
+		uint64_t wakeup_count;
+		uint32_t status;
+
+		pthread_mutex_lock(&rstream->lock);
+		wakeup_count = rstream->index_wakeup_count;
+		pthread_mutex_unlock(&rstream->lock);
+
+		ret = get_next_index(conn, rstream->stream_handle, &viewer_index);
+		if (ret < 0) {
+			return ret;
+		}
+
+		/* An inactive stream is only reported once it receives a new beacon. */
+		status = be32toh(viewer_index.status);
+		if ((status != LTTNG_VIEWER_INDEX_RETRY &&
+		     (status != LTTNG_VIEWER_INDEX_INACTIVE || woken_up)) ||
+		    lttng_thread_clock_now_ns() >= wait->deadline_ns) {
+			break;
+		}
+
+		/* The stream may have been woken up since its next index was checked. */
+		pthread_mutex_lock(&rstream->lock);
+		if (rstream->index_wakeup_count == wakeup_count) {
+			stream_add_index_waiter(rstream, &wait->waiter);
+			pthread_mutex_unlock(&rstream->lock);
+			return 0;
+		}
+		pthread_mutex_unlock(&rstream->lock);
+		woken_up = true;
+	}
+
+	viewer_end_index_wait(conn);
+	ret = send_response(conn, &viewer_index, sizeof(viewer_index));
+	if (ret < 0) {
+		return ret;
+	}
+
+	return 1;
+}
+
+/*
+ * Send the next index for a stream once it has one, or once the request
+ * times out.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_wait_next_index(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_wait_next_index request;
+	struct lttng_viewer_index viewer_index = {};
+	auto *wait = &conn->protocol.viewer.index_wait;
+	uint64_t stream_id;
+	uint32_t timeout_ms;
 
 	LTTNG_ASSERT(conn);
+	LTTNG_ASSERT(!wait->vstream);
 
 	health_code_update();
 
 	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+	stream_id = be64toh(request.stream_id);
+	timeout_ms = std::min<uint32_t>(be32toh(request.timeout_ms), VIEWER_MAX_INDEX_WAIT_MS);
+
+	health_code_update();
+
+	wait->vstream = viewer_stream_get_by_id(stream_id);
+	if (!wait->vstream) {
+		DBG("Client waits for the index of unknown stream id %" PRIu64, stream_id);
+		viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_ERR);
+		ret = send_response(conn, &viewer_index, sizeof(viewer_index));
+		return ret < 0 ? ret : 0;
+	}
+
+	wait->deadline_ns = lttng_thread_clock_now_ns() + (uint64_t) timeout_ms * NSEC_PER_MSEC;
+	ret = viewer_check_index_wait(conn, false);
+	return ret < 0 ? ret : 0;
+}
+
+/*
+ * Source of a packet sent to a viewer: the packet cache of its stream, or
+ * else its stream file.
+ */
+struct viewer_packet_source {
+	/* Reference to the cached packet, null when sent from the stream file. */
+	struct packet_cache_entry *cached;
+	/* Duplicated file descriptor of the stream file, -1 when there is none. */
+	int fd;
+};
+
+static void viewer_packet_source_release(struct viewer_packet_source *source)
+{
+	if (source->cached) {
+		packet_cache_entry_put(source->cached);
+		source->cached = nullptr;
+	}
+
+	if (source->fd >= 0 && close(source->fd)) {
+		PERROR("Failed to close duplicated file descriptor of viewer stream");
+	}
+
+	source->fd = -1;
+}
+
+/*
+ * Get the source of the `len` bytes at `offset` of the stream file of a
+ * viewer stream: the packet cache of the stream if it holds them, or else a
+ * duplicate of the file descriptor of the stream file.
+ *
+ * The stream lock is only held to duplicate the file descriptor and to look
+ * up the cache: the duplicate keeps the file open if the viewer stream moves
+ * to another file concurrently, and the packet is sent from it, or from the
+ * cached packet, without holding up the writes to the stream.
+ *
+ * Return 0 on success, the caller releasing `source`, or -1 if the file
+ * can't be duplicated or the range is past its end.
+ */
+static int get_packet_source(struct relay_viewer_stream *vstream,
+			     uint64_t offset,
+			     uint64_t len,
+			     struct viewer_packet_source *source)
+{
+	const uint64_t stream_id = vstream->stream->stream_handle;
+	struct stat packet_file_stat;
+	int fd;
+
+	source->cached = nullptr;
+	source->fd = -1;
+
+	pthread_mutex_lock(&vstream->stream->lock);
+	fd = vstream->stream_file.handle ? fs_handle_get_fd(vstream->stream_file.handle) : -1;
+	if (fd >= 0) {
+		source->fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+		if (source->fd < 0) {
+			PERROR("Failed to duplicate file descriptor of viewer stream %" PRIu64,
+			       stream_id);
+		}
+
+		fs_handle_put_fd(vstream->stream_file.handle);
+	}
+	pthread_mutex_unlock(&vstream->stream->lock);
+
+	if (source->fd < 0) {
+		ERR("Failed to get file of viewer stream %" PRIu64, stream_id);
+		return -1;
+	}
+
+	if (fstat(source->fd, &packet_file_stat)) {
+		PERROR("Failed to stat file of viewer stream %" PRIu64, stream_id);
+		goto error;
+	}
+
+	if (offset > (uint64_t) packet_file_stat.st_size ||
+	    len > (uint64_t) packet_file_stat.st_size - offset) {
+		ERR("Packet of viewer stream id %" PRIu64 " past the end of its file, "
+		    "offset: %" PRIu64 ", len: %" PRIu64,
+		    stream_id,
+		    offset,
+		    len);
+		goto error;
+	}
+
+	if (packet_cache_enabled()) {
+		pthread_mutex_lock(&vstream->stream->lock);
+		source->cached = packet_cache_lookup(&vstream->stream->packet_cache,
+						     packet_file_stat.st_dev,
+						     packet_file_stat.st_ino,
+						     offset,
+						     len);
+		pthread_mutex_unlock(&vstream->stream->lock);
+		if (source->cached && close(source->fd)) {
+			PERROR("Failed to close duplicated file descriptor of viewer stream");
+		}
+
+		if (source->cached) {
+			source->fd = -1;
+		}
+	}
+
+	return 0;
+
+error:
+	viewer_packet_source_release(source);
+	return -1;
+}
+
+/*
+ * Queue the `len` bytes at `offset` of a packet on the output of a viewer
+ * connection, from the source returned by get_packet_source(), which is
+ * released, even on error.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int send_packet(struct relay_connection *conn,
+		       struct viewer_packet_source *source,
+		       uint64_t offset,
+		       uint64_t len)
+{
+	auto *viewer = &conn->protocol.viewer;
+	const struct lttng_dynamic_buffer *data;
+	size_t data_len;
+	int ret;
+
+	if (!source->cached) {
+		/* The packet is sent from the duplicated file descriptor. */
+		ret = send_stream_file_range(conn, source->fd, (off_t) offset, len);
+		source->fd = -1;
+		return ret;
+	}
+
+	data = &source->cached->data;
+	data_len = std::min<uint64_t>(len, data->size);
+	ret = send_response(conn, data->data, data_len) < 0 ? -1 : 0;
+	if (!ret && len > data_len) {
+		/* The padding of the packets isn't cached: it is zeroed. */
+		if (lttng_dynamic_buffer_set_size(&viewer->output,
+						  viewer->output.size + (len - data_len))) {
+			ERR("Relayd failed to queue padding of %" PRIu64 " bytes.",
+			    len - data_len);
+			ret = -1;
+		} else {
+			memory_budget_charge(MEMORY_BUDGET_VIEWER_BUFFER, len - data_len);
+		}
+	}
+
+	viewer_packet_source_release(source);
+	return ret;
+}
+
+#ifdef HAVE_LIBZSTD
+/*
+ * Compress the `len` bytes at `offset` of a packet, its padding included,
+ * into `compressed`, from the source returned by get_packet_source(). The
+ * compressed form of a cached packet is kept with it so that the other
+ * viewers don't compress it again.
+ *
+ * Return true if the packet was compressed, false if it can't be or if the
+ * compression doesn't reduce its size.
+ */
+static bool compress_packet(struct viewer_packet_source *source,
+			    uint64_t offset,
+			    uint64_t len,
+			    struct lttng_dynamic_buffer *compressed)
+{
+	struct lttng_dynamic_buffer packet;
+	struct packet_cache_entry *entry = source->cached;
+	bool packet_compressed = false;
+
+	if (entry) {
+		pthread_mutex_lock(&entry->compressed_lock);
+		if (entry->compressed_len == len) {
+			packet_compressed = entry->compressed.size > 0 &&
+				!lttng_dynamic_buffer_append_buffer(compressed, &entry->compressed);
+			pthread_mutex_unlock(&entry->compressed_lock);
+			return packet_compressed;
+		}
+	}
+
+	lttng_dynamic_buffer_init(&packet);
+	if (!memory_budget_reserve(MEMORY_BUDGET_VIEWER_BUFFER, len)) {
+		/* The packet is sent uncompressed. */
+		goto end_unlock;
+	}
+
+	/* Zeroed, as the padding. */
+	if (lttng_dynamic_buffer_set_size(&packet, len)) {
+		ERR("Failed to allocate packet compression buffer: len = %" PRIu64, len);
+		goto end;
+	}
+
+	if (entry) {
+		memcpy(packet.data, entry->data.data, std::min<uint64_t>(len, entry->data.size));
+	} else if (pread(source->fd, packet.data, len, (off_t) offset) != (ssize_t) len) {
+		PERROR("Failed to read packet to compress: offset = %" PRIu64 ", len = %" PRIu64,
+		       offset,
+		       len);
+		goto end;
+	}
+
+	packet_compressed = !compress_zstd(packet.data, len, compressed) && compressed->size < len;
+	if (entry) {
+		(void) lttng_dynamic_buffer_set_size(&entry->compressed, 0);
+		if (packet_compressed &&
+		    lttng_dynamic_buffer_append_buffer(&entry->compressed, compressed)) {
+			ERR("Failed to cache compressed packet: len = %zu", compressed->size);
+		} else {
+			entry->compressed_len = len;
+		}
+	}
+
+end:
+	memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, len);
+end_unlock:
+	if (entry) {
+		pthread_mutex_unlock(&entry->compressed_lock);
+	}
+
+	lttng_dynamic_buffer_reset(&packet);
+	return packet_compressed;
+}
+#endif /* HAVE_LIBZSTD */
+
+/*
+ * Send the next index for a stream
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_get_packet(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_get_packet get_packet_info;
+	struct lttng_viewer_trace_packet reply_header;
+	struct relay_viewer_stream *vstream = nullptr;
+	struct viewer_packet_source source = { nullptr, -1 };
+	uint32_t packet_data_len = 0, sent_len = 0;
+	uint64_t stream_id, offset;
+	enum lttng_viewer_get_packet_return_code get_packet_status;
+	struct lttng_dynamic_buffer compressed;
+	bool packet_compressed = false;
+
+	lttng_dynamic_buffer_init(&compressed);
+	health_code_update();
+
+	ret = recv_request(conn->sock, &get_packet_info, sizeof(get_packet_info));
 	if (ret < 0) {
 		goto end;
 	}
 	health_code_update();
 
-	memset(&reply, 0, sizeof(reply));
+	/* From this point on, the error label can be reached. */
+	memset(&reply_header, 0, sizeof(reply_header));
+	stream_id = (uint64_t) be64toh(get_packet_info.stream_id);
+	offset = (uint64_t) be64toh(get_packet_info.offset);
 
-	vstream = viewer_stream_get_by_id(be64toh(request.stream_id));
+	vstream = viewer_stream_get_by_id(stream_id);
 	if (!vstream) {
-		/*
-		 * The metadata stream can be closed by a CLOSE command
-		 * just before we attach. It can also be closed by
-		 * per-pid tracing during tracing. Therefore, it is
-		 * possible that we cannot find this viewer stream.
-		 * Reply back to the client with an error if we cannot
-		 * find it.
-		 */
-		DBG("Client requested metadata of unknown stream id %" PRIu64,
-		    (uint64_t) be64toh(request.stream_id));
-		reply.status = htobe32(LTTNG_VIEWER_METADATA_ERR);
+		get_packet_status = LTTNG_VIEWER_GET_PACKET_ERR;
+		DBG("Client requested packet of unknown stream id %" PRIu64 ", returning status=%s",
+		    stream_id,
+		    lttng_viewer_get_packet_return_code_str(get_packet_status));
 		goto send_reply;
 	}
-	pthread_mutex_lock(&vstream->stream->lock);
-	if (!vstream->stream->is_metadata) {
-		ERR("Invalid metadata stream");
-		goto error;
+
+	packet_data_len = be32toh(get_packet_info.len);
+
+	if (get_packet_source(vstream, offset, packet_data_len, &source)) {
+		get_packet_status = LTTNG_VIEWER_GET_PACKET_ERR;
+		ERR("Failed to get packet of viewer stream %" PRIu64 ", returning status=%s",
+		    stream_id,
+		    lttng_viewer_get_packet_return_code_str(get_packet_status));
+		goto send_reply;
 	}
 
-	if (vstream->metadata_sent >= vstream->stream->metadata_received) {
-		/*
+	get_packet_status = LTTNG_VIEWER_GET_PACKET_OK;
+	sent_len = packet_data_len;
+#ifdef HAVE_LIBZSTD
+	if ((conn->protocol.viewer.capabilities & LTTNG_VIEWER_CAPABILITY_PACKET_ZSTD) &&
+	    compress_packet(&source, offset, packet_data_len, &compressed)) {
+		packet_compressed = true;
+		sent_len = compressed.size;
+		reply_header.flags |= htobe32(LTTNG_VIEWER_FLAG_COMPRESSED_ZSTD);
+	}
+#endif /* HAVE_LIBZSTD */
+	reply_header.len = htobe32(sent_len);
+
+send_reply:
+	health_code_update();
+
+	reply_header.status = htobe32(get_packet_status);
+	ret = send_response(conn, &reply_header, sizeof(reply_header));
+	health_code_update();
+	if (ret < 0) {
+		goto end;
+	}
+
+	if (packet_compressed) {
+		ret = send_response(conn, compressed.data, compressed.size);
+		if (ret < 0) {
+			goto end;
+		}
+	} else if (get_packet_status == LTTNG_VIEWER_GET_PACKET_OK) {
+		/* The packet is sent after the header. */
+		ret = send_packet(conn, &source, offset, packet_data_len);
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
+	DBG("Queued %zu bytes for stream %" PRIu64, sizeof(reply_header) + sent_len, stream_id);
+
+end:
+	viewer_packet_source_release(&source);
+	lttng_dynamic_buffer_reset(&compressed);
+	if (vstream) {
+		viewer_stream_put(vstream);
+	}
+	return ret;
+}
+
+/* A next index of a stream and, once its source is found, its packet. */
+struct viewer_next_packet {
+	struct lttng_viewer_index index;
+	/* Released, or left without a source, when there is no packet. */
+	struct viewer_packet_source source;
+};
+
+static void viewer_next_packet_destroy(void *ptr)
+{
+	viewer_packet_source_release(&((struct viewer_next_packet *) ptr)->source);
+}
+
+/*
+ * Send the next indexes of a stream along with their packets.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_get_next_packets(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_get_next_packets request;
+	struct lttng_viewer_next_packets_response response = {};
+	struct relay_viewer_stream *vstream = nullptr;
+	struct lttng_dynamic_array packets;
+	uint64_t stream_id, packets_len = 0;
+	uint32_t max_packets;
+
+	LTTNG_ASSERT(conn);
+
+	lttng_dynamic_array_init(
+		&packets, sizeof(struct viewer_next_packet), viewer_next_packet_destroy);
+	health_code_update();
+
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		goto end;
+	}
+	stream_id = be64toh(request.stream_id);
+	max_packets = std::min<uint32_t>(be32toh(request.max_packets), VIEWER_MAX_NEXT_PACKETS);
+	/* The next index is always returned. */
+	max_packets = std::max<uint32_t>(max_packets, 1);
+
+	health_code_update();
+
+	/* Held to get the packet of each index. */
+	vstream = viewer_stream_get_by_id(stream_id);
+
+	for (uint32_t i = 0; i < max_packets; i++) {
+		struct viewer_next_packet packet = {};
+		uint32_t status, index_flags;
+
+		packet.source.fd = -1;
+		ret = get_next_index(conn, stream_id, &packet.index);
+		if (ret < 0) {
+			goto end;
+		}
+
+		status = be32toh(packet.index.status);
+		index_flags = be32toh(packet.index.flags);
+		if (status == LTTNG_VIEWER_INDEX_OK) {
+			const uint64_t offset = be64toh(packet.index.offset);
+			const uint64_t len = be64toh(packet.index.packet_size) / CHAR_BIT;
+
+			if (!vstream || get_packet_source(vstream, offset, len, &packet.source)) {
+				/* The index was consumed: its packet can't be requested again. */
+				status = LTTNG_VIEWER_INDEX_ERR;
+				packet.index.status = htobe32(status);
+				ERR("Failed to get packet of viewer stream %" PRIu64
+				    ", returning index status=%s",
+				    stream_id,
+				    lttng_viewer_next_index_return_code_str(
+					    (enum lttng_viewer_next_index_return_code) status));
+			} else {
+				packets_len += len;
+			}
+		}
+
+		if (lttng_dynamic_array_add_element(&packets, &packet)) {
+			ERR("Failed to allocate the next packets of viewer stream %" PRIu64,
+			    stream_id);
+			viewer_packet_source_release(&packet.source);
+			ret = -1;
+			goto end;
+		}
+
+		/* The viewer needs the new metadata or streams before reading on. */
+		if (status != LTTNG_VIEWER_INDEX_OK ||
+		    (index_flags &
+		     (LTTNG_VIEWER_FLAG_NEW_METADATA | LTTNG_VIEWER_FLAG_NEW_STREAM))) {
+			break;
+		}
+	}
+
+	health_code_update();
+
+	response.packets_count = htobe32(lttng_dynamic_array_get_count(&packets));
+	ret = send_response(conn, &response, sizeof(response));
+	if (ret < 0) {
+		goto end;
+	}
+
+	for (size_t i = 0; i < lttng_dynamic_array_get_count(&packets); i++) {
+		auto *packet =
+			(struct viewer_next_packet *) lttng_dynamic_array_get_element(&packets, i);
+
+		ret = send_response(conn, &packet->index, sizeof(packet->index));
+		if (ret < 0) {
+			goto end;
+		}
+
+		if (be32toh(packet->index.status) != LTTNG_VIEWER_INDEX_OK) {
+			continue;
+		}
+
+		/* The packet is sent after its index. */
+		ret = send_packet(conn,
+				  &packet->source,
+				  be64toh(packet->index.offset),
+				  be64toh(packet->index.packet_size) / CHAR_BIT);
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
+	DBG("Queued %zu next packets of stream %" PRIu64 ", %" PRIu64 " bytes of packets",
+	    lttng_dynamic_array_get_count(&packets),
+	    stream_id,
+	    packets_len);
+	health_code_update();
+	ret = 0;
+
+end:
+	if (vstream) {
+		viewer_stream_put(vstream);
+	}
+	lttng_dynamic_array_reset(&packets);
+	return ret;
+}
+
+/*
+ * Copy the `len` bytes of metadata following the metadata sent to a viewer
+ * stream from the metadata cache of its relay stream, if it holds them and
+ * was filled from the metadata file opened by the viewer stream, moving the
+ * position of the file past them.
+ *
+ * Called with the relay stream lock held.
+ *
+ * Return true if the metadata was copied, false if it must be read from the
+ * metadata file.
+ */
+static bool read_cached_metadata(struct relay_viewer_stream *vstream, char *data, uint64_t len)
+{
+	const auto *cache = &vstream->stream->metadata_cache;
+	struct stat file_stat;
+	bool same_file;
+	int fd;
+
+	if (!cache->valid || vstream->metadata_sent + len > cache->data.size) {
+		return false;
+	}
+
+	fd = fs_handle_get_fd(vstream->stream_file.handle);
+	if (fd < 0) {
+		return false;
+	}
+
+	same_file = !fstat(fd, &file_stat) && file_stat.st_dev == cache->file_dev &&
+		file_stat.st_ino == cache->file_ino;
+	fs_handle_put_fd(vstream->stream_file.handle);
+	if (!same_file) {
+		return false;
+	}
+
+	/* The position of the file is kept for the next reads from the file. */
+	if (fs_handle_seek(vstream->stream_file.handle, len, SEEK_CUR) < 0) {
+		PERROR("Failed to seek metadata file past cached metadata: len = %" PRIu64, len);
+		return false;
+	}
+
+	memcpy(data, cache->data.data + vstream->metadata_sent, len);
+	return true;
+}
+
+/*
+ * Get the metadata of a viewer metadata stream which wasn't sent yet.
+ *
+ * On success, `*data` holds `*len` bytes of metadata, reserved from the
+ * memory budget; the caller frees them and releases the reservation once
+ * they are sent.
+ *
+ * Return the status of the reply to the viewer.
+ */
+static enum lttng_viewer_get_metadata_return_code
+get_metadata(struct relay_connection *conn, uint64_t stream_id, char **data, uint64_t *len)
+{
+	int ret;
+	int fd = -1;
+	ssize_t read_len;
+	enum lttng_viewer_get_metadata_return_code status;
+	struct relay_viewer_stream *vstream;
+
+	*data = nullptr;
+	*len = 0;
+
+	vstream = viewer_stream_get_by_id(stream_id);
+	if (!vstream) {
+		/*
+		 * The metadata stream can be closed by a CLOSE command
+		 * just before we attach. It can also be closed by
+		 * per-pid tracing during tracing. Therefore, it is
+		 * possible that we cannot find this viewer stream.
+		 * Reply back to the client with an error if we cannot
+		 * find it.
+		 */
+		DBG("Client requested metadata of unknown stream id %" PRIu64, stream_id);
+		return LTTNG_VIEWER_METADATA_ERR;
+	}
+	pthread_mutex_lock(&vstream->stream->lock);
+	if (!vstream->stream->is_metadata) {
+		ERR("Invalid metadata stream");
+		goto error;
+	}
+
+	if (vstream->metadata_sent >= vstream->stream->metadata_received) {
+		/*
 		 * The live viewers expect to receive a NO_NEW_METADATA
 		 * status before a stream disappears, otherwise they abort the
 		 * entire live connection when receiving an error status.
@@ -2171,7 +3621,7 @@ static int viewer_get_metadata(struct relay_connection *conn)
 		 * Clear feature resets the metadata_sent to 0 until the
 		 * same metadata is received again.
 		 */
-		reply.status = htobe32(LTTNG_VIEWER_NO_NEW_METADATA);
+		status = LTTNG_VIEWER_NO_NEW_METADATA;
 		/*
 		 * The live viewer considers a closed 0 byte metadata stream as
 		 * an error.
@@ -2186,204 +3636,889 @@ static int viewer_get_metadata(struct relay_connection *conn)
 				 * viewer_stream_get_by_id() took a reference.
 				 */
 				viewer_stream_put(vstream);
-			}
+			}
+
+			vstream->stream->no_new_metadata_notified = true;
+		}
+		goto end;
+	}
+
+	if (vstream->stream->trace_chunk &&
+	    !lttng_trace_chunk_ids_equal(conn->viewer_session->current_trace_chunk,
+					 vstream->stream->trace_chunk)) {
+		/* A rotation has occurred on the relay stream. */
+		DBG("Metadata relay stream and viewer chunk ids differ");
+
+		ret = viewer_session_set_trace_chunk_copy(conn->viewer_session,
+							  vstream->stream->trace_chunk);
+		if (ret) {
+			goto error;
+		}
+	}
+
+	if (conn->viewer_session->current_trace_chunk &&
+	    !lttng_trace_chunk_ids_equal(conn->viewer_session->current_trace_chunk,
+					 vstream->stream_file.trace_chunk)) {
+		bool acquired_reference;
+
+		DBG("Viewer session and viewer stream chunk differ: "
+		    "vsession chunk %p vstream chunk %p",
+		    conn->viewer_session->current_trace_chunk,
+		    vstream->stream_file.trace_chunk);
+		lttng_trace_chunk_put(vstream->stream_file.trace_chunk);
+		acquired_reference =
+			lttng_trace_chunk_get(conn->viewer_session->current_trace_chunk);
+		LTTNG_ASSERT(acquired_reference);
+		vstream->stream_file.trace_chunk = conn->viewer_session->current_trace_chunk;
+		viewer_stream_close_files(vstream);
+	}
+
+	*len = vstream->stream->metadata_received - vstream->metadata_sent;
+
+	if (!vstream->stream_file.trace_chunk) {
+		status = LTTNG_VIEWER_NO_NEW_METADATA;
+		*len = 0;
+		goto end;
+	} else if (vstream->stream_file.trace_chunk && !vstream->stream_file.handle && *len > 0) {
+		/*
+		 * Either this is the first time the metadata file is read, or a
+		 * rotation of the corresponding relay stream has occurred.
+		 */
+		struct fs_handle *fs_handle;
+		char file_path[LTTNG_PATH_MAX];
+		enum lttng_trace_chunk_status chunk_status;
+		struct relay_stream *rstream = vstream->stream;
+
+		ret = utils_stream_file_path(rstream->path_name,
+					     rstream->channel_name,
+					     rstream->tracefile_size,
+					     vstream->current_tracefile_id,
+					     nullptr,
+					     file_path,
+					     sizeof(file_path));
+		if (ret < 0) {
+			goto error;
+		}
+
+		/*
+		 * It is possible the the metadata file we are trying to open is
+		 * missing if the stream has been closed (application exits with
+		 * per-pid buffers) and a clear command has been performed.
+		 */
+		chunk_status = lttng_trace_chunk_open_fs_handle(
+			vstream->stream_file.trace_chunk, file_path, O_RDONLY, 0, &fs_handle, true);
+		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+			if (chunk_status == LTTNG_TRACE_CHUNK_STATUS_NO_FILE) {
+				status = LTTNG_VIEWER_NO_NEW_METADATA;
+				*len = 0;
+				if (vstream->stream->closed) {
+					viewer_stream_put(vstream);
+				}
+				goto end;
+			}
+			PERROR("Failed to open metadata file for viewer stream");
+			goto error;
+		}
+		vstream->stream_file.handle = fs_handle;
+
+		if (vstream->metadata_sent != 0) {
+			/*
+			 * The client does not expect to receive any metadata
+			 * it has received and metadata files in successive
+			 * chunks must be a strict superset of one another.
+			 *
+			 * Skip the first `metadata_sent` bytes to ensure
+			 * they are not sent a second time to the client.
+			 *
+			 * Baring a block layer error or an internal error,
+			 * this seek should not fail as
+			 * `vstream->stream->metadata_received` is reset when
+			 * a relay stream is rotated. If this is reached, it is
+			 * safe to assume that
+			 * `metadata_received` > `metadata_sent`.
+			 */
+			const off_t seek_ret =
+				fs_handle_seek(fs_handle, vstream->metadata_sent, SEEK_SET);
+
+			if (seek_ret < 0) {
+				PERROR("Failed to seek metadata viewer stream file to `sent` position: pos = %" PRId64,
+				       vstream->metadata_sent);
+				goto error;
+			}
+		}
+	}
+
+	if (!memory_budget_reserve(MEMORY_BUDGET_VIEWER_BUFFER, *len)) {
+		/* Nothing is sent: the viewer asks for the metadata again later. */
+		DBG("Memory budget exceeded by metadata of viewer stream: len = %" PRIu64, *len);
+		status = LTTNG_VIEWER_NO_NEW_METADATA;
+		*len = 0;
+		goto end;
+	}
+
+	*data = zmalloc<char>(*len);
+	if (!*data) {
+		PERROR("viewer metadata zmalloc");
+		goto error_release;
+	}
+
+	if (read_cached_metadata(vstream, *data, *len)) {
+		vstream->metadata_sent += *len;
+		status = LTTNG_VIEWER_METADATA_OK;
+		goto end;
+	}
+
+	fd = fs_handle_get_fd(vstream->stream_file.handle);
+	if (fd < 0) {
+		ERR("Failed to restore viewer stream file system handle");
+		goto error_release;
+	}
+	read_len = lttng_read(fd, *data, *len);
+	fs_handle_put_fd(vstream->stream_file.handle);
+	fd = -1;
+	if (read_len < *len) {
+		if (read_len < 0) {
+			PERROR("Failed to read metadata file");
+			goto error_release;
+		} else {
+			/*
+			 * A clear has been performed which prevents the relay
+			 * from sending `len` bytes of metadata.
+			 *
+			 * It is important not to send any metadata if we
+			 * couldn't read all the available metadata in one shot:
+			 * sending partial metadata can cause the client to
+			 * attempt to parse an incomplete (incoherent) metadata
+			 * stream, which would result in an error.
+			 */
+			const off_t seek_ret =
+				fs_handle_seek(vstream->stream_file.handle, -read_len, SEEK_CUR);
+
+			DBG("Failed to read metadata: requested = %" PRIu64 ", got = %zd",
+			    *len,
+			    read_len);
+			if (seek_ret < 0) {
+				PERROR("Failed to restore metadata file position after partial read");
+				goto error_release;
+			}
+
+			free(*data);
+			*data = nullptr;
+			memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, *len);
+			*len = 0;
+			status = LTTNG_VIEWER_METADATA_OK;
+			goto end;
+		}
+	}
+	vstream->metadata_sent += read_len;
+	status = LTTNG_VIEWER_METADATA_OK;
+	goto end;
+
+error_release:
+	free(*data);
+	*data = nullptr;
+	memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, *len);
+error:
+	*len = 0;
+	status = LTTNG_VIEWER_METADATA_ERR;
+end:
+	pthread_mutex_unlock(&vstream->stream->lock);
+	viewer_stream_put(vstream);
+	return status;
+}
+
+/*
+ * Send the session's metadata
+ *
+ * Return 0 on success else a negative value.
+ */
+static int viewer_get_metadata(struct relay_connection *conn)
+{
+	int ret = 0;
+	uint64_t len;
+	char *data;
+	struct lttng_viewer_get_metadata request;
+	struct lttng_viewer_metadata_packet reply;
+
+	LTTNG_ASSERT(conn);
+
+	health_code_update();
+
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+	health_code_update();
+
+	memset(&reply, 0, sizeof(reply));
+	reply.status = htobe32(get_metadata(conn, be64toh(request.stream_id), &data, &len));
+	reply.len = htobe64(len);
+
+	health_code_update();
+	ret = send_response(conn, &reply, sizeof(reply));
+	if (ret < 0) {
+		goto end;
+	}
+	health_code_update();
+
+	if (len > 0) {
+		ret = send_response(conn, data, len);
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
+	DBG("Sent %" PRIu64 " bytes of metadata for stream %" PRIu64,
+	    len,
+	    (uint64_t) be64toh(request.stream_id));
+
+	DBG("Metadata sent");
+
+end:
+	free(data);
+	memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, len);
+	return ret;
+}
+
+/*
+ * Send the session's metadata, compressed if the viewer supports an algorithm
+ * of this build and the compression reduces its size.
+ *
+ * Return 0 on success else a negative value.
+ */
+static int viewer_get_compressed_metadata(struct relay_connection *conn)
+{
+	int ret = 0;
+	uint64_t len;
+	char *data;
+	const char *payload;
+	uint64_t payload_len;
+	uint32_t compressions;
+	struct lttng_dynamic_buffer compressed;
+	struct lttng_viewer_get_compressed_metadata request;
+	struct lttng_viewer_compressed_metadata_packet reply;
+
+	LTTNG_ASSERT(conn);
+
+	health_code_update();
+
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+	health_code_update();
+
+	lttng_dynamic_buffer_init(&compressed);
+	compressions = be32toh(request.compressions);
+	memset(&reply, 0, sizeof(reply));
+	reply.status = htobe32(get_metadata(conn, be64toh(request.stream_id), &data, &len));
+	reply.uncompressed_len = htobe64(len);
+	reply.compression = htobe32(LTTNG_VIEWER_METADATA_COMPRESSION_NONE);
+	payload = data;
+	payload_len = len;
+
+#ifdef HAVE_LIBZSTD
+	if (len > 0 && (compressions & (1U << LTTNG_VIEWER_METADATA_COMPRESSION_ZSTD)) &&
+	    !compress_zstd(data, len, &compressed) && compressed.size < len) {
+		reply.compression = htobe32(LTTNG_VIEWER_METADATA_COMPRESSION_ZSTD);
+		payload = compressed.data;
+		payload_len = compressed.size;
+	}
+#else
+	(void) compressions;
+#endif /* HAVE_LIBZSTD */
+
+	/* The compression buffer can't be refused: its content replaces the metadata. */
+	memory_budget_charge(MEMORY_BUDGET_VIEWER_BUFFER, compressed.size);
+	reply.len = htobe64(payload_len);
+
+	health_code_update();
+	ret = send_response(conn, &reply, sizeof(reply));
+	if (ret < 0) {
+		goto end;
+	}
+	health_code_update();
+
+	if (payload_len > 0) {
+		ret = send_response(conn, payload, payload_len);
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
+	DBG("Sent %" PRIu64 " bytes of metadata for stream %" PRIu64 ", uncompressed = %" PRIu64,
+	    payload_len,
+	    (uint64_t) be64toh(request.stream_id),
+	    len);
+
+end:
+	memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, compressed.size);
+	lttng_dynamic_buffer_reset(&compressed);
+	free(data);
+	memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, len);
+	return ret;
+}
+
+/* Data stream pushed to a viewer connection in push mode. */
+struct viewer_pushed_stream {
+	/* Reference held until the stream ends or the connection is closed. */
+	struct relay_viewer_stream *vstream;
+	/* Bytes of packets which may be pushed before the viewer adds credit. */
+	uint64_t credit;
+	/* End of the last inactivity beacon pushed. */
+	uint64_t beacon_ts_end;
+	/* Registered while the stream has no index to push. */
+	struct relay_index_waiter waiter;
+	bool waiting;
+};
+
+/* State of a viewer connection in push mode, see LTTNG_VIEWER_SUBSCRIBE. */
+struct viewer_subscription {
+	/* Initial credit of the data streams, in bytes. */
+	uint64_t window;
+	/* struct viewer_pushed_stream * */
+	struct lttng_dynamic_pointer_array streams;
+};
+
+static void viewer_pushed_stream_destroy(void *ptr)
+{
+	auto *pushed = (struct viewer_pushed_stream *) ptr;
+
+	if (pushed->waiting) {
+		pthread_mutex_lock(&pushed->vstream->stream->lock);
+		stream_remove_index_waiter(pushed->vstream->stream, &pushed->waiter);
+		pthread_mutex_unlock(&pushed->vstream->stream->lock);
+	}
+
+	viewer_stream_put(pushed->vstream);
+	free(pushed);
+}
+
+/* Leave the push mode, if the connection is in it. */
+static void viewer_end_subscription(struct relay_connection *conn)
+{
+	auto *subscription = conn->protocol.viewer.subscription;
+
+	if (!subscription) {
+		return;
+	}
+
+	lttng_dynamic_pointer_array_reset(&subscription->streams);
+	free(subscription);
+	conn->protocol.viewer.subscription = nullptr;
+}
+
+static int push_frame(struct relay_connection *conn,
+		      enum lttng_viewer_frame_type type,
+		      uint64_t id,
+		      uint64_t len)
+{
+	struct lttng_viewer_frame frame;
+
+	frame.type = htobe32(type);
+	frame.id = htobe64(id);
+	frame.len = htobe64(len);
+	return send_response(conn, &frame, sizeof(frame)) < 0 ? -1 : 0;
+}
+
+/*
+ * Push the streams of the attached sessions which weren't sent to the
+ * viewer yet, creating the viewer streams of their new relay streams.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int push_new_streams(struct relay_connection *conn)
+{
+	struct relay_session *session;
+	lttng::urcu::read_lock_guard read_lock;
+
+	cds_list_for_each_entry_rcu(
+		session, &conn->viewer_session->session_list, viewer_session_node)
+	{
+		uint32_t nb_created = 0, nb_unsent = 0, nb_total = 0;
+		bool closed = false;
+		int ret = 0;
+
+		if (!session_get(session)) {
+			continue;
+		}
+
+		/* The chunk may be in an intermediate state during a rotation. */
+		pthread_mutex_lock(&session->lock);
+		if (!session_has_ongoing_rotation(session)) {
+			ret = make_viewer_streams(session,
+						  conn->viewer_session,
+						  LTTNG_VIEWER_SEEK_BEGINNING,
+						  0,
+						  &nb_total,
+						  &nb_unsent,
+						  &nb_created,
+						  &closed);
+		}
+		pthread_mutex_unlock(&session->lock);
+
+		if (!ret && nb_created + nb_unsent > 0) {
+			ret = push_frame(conn,
+					 LTTNG_VIEWER_FRAME_NEW_STREAMS,
+					 session->id,
+					 (uint64_t) (nb_created + nb_unsent) *
+						 sizeof(struct lttng_viewer_stream));
+			if (!ret) {
+				ret = send_viewer_streams(conn, session, 0);
+			}
+		}
+
+		session_put(session);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static struct viewer_pushed_stream *
+viewer_subscription_get_stream(const struct viewer_subscription *subscription, size_t i)
+{
+	return (struct viewer_pushed_stream *) lttng_dynamic_pointer_array_get_pointer(
+		&subscription->streams, i);
+}
+
+static bool viewer_subscription_has_stream(const struct viewer_subscription *subscription,
+					   const struct relay_viewer_stream *vstream)
+{
+	for (size_t i = 0; i < lttng_dynamic_pointer_array_get_count(&subscription->streams); i++) {
+		if (viewer_subscription_get_stream(subscription, i)->vstream == vstream) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Add the data streams sent to the viewer to the pushed streams, each one
+ * with the credit of the window.
+ *
+ * Return 0 on success, -1 on allocation error.
+ */
+static int subscribe_sent_streams(struct relay_connection *conn)
+{
+	auto *subscription = conn->protocol.viewer.subscription;
+	struct relay_session *session;
+	lttng::urcu::read_lock_guard read_lock;
+
+	cds_list_for_each_entry_rcu(
+		session, &conn->viewer_session->session_list, viewer_session_node)
+	{
+		struct relay_viewer_stream *vstream;
+
+		cds_list_for_each_entry_rcu(vstream, &session->viewer_streams, session_node)
+		{
+			struct viewer_pushed_stream *pushed;
+			bool sent;
+
+			if (!viewer_stream_get(vstream)) {
+				continue;
+			}
+
+			pthread_mutex_lock(&vstream->stream->lock);
+			sent = vstream->sent_flag && !vstream->stream->is_metadata;
+			pthread_mutex_unlock(&vstream->stream->lock);
+
+			if (!sent || viewer_subscription_has_stream(subscription, vstream)) {
+				viewer_stream_put(vstream);
+				continue;
+			}
+
+			/* The reference of the lookup is kept by the pushed stream. */
+			pushed = zmalloc<viewer_pushed_stream>();
+			if (!pushed) {
+				PERROR("Failed to allocate pushed viewer stream");
+				viewer_stream_put(vstream);
+				return -1;
+			}
+
+			pushed->vstream = vstream;
+			pushed->credit = subscription->window;
+			CDS_INIT_LIST_HEAD(&pushed->waiter.node);
+			pushed->waiter.wakeup_fd =
+				conn->protocol.viewer.index_wait.waiter.wakeup_fd;
+			if (lttng_dynamic_pointer_array_add_pointer(&subscription->streams,
+								    pushed)) {
+				ERR("Failed to subscribe viewer stream %" PRIu64,
+				    vstream->stream->stream_handle);
+				viewer_pushed_stream_destroy(pushed);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Push the metadata received since it was last sent, for each metadata
+ * stream of the attached sessions.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int push_metadata(struct relay_connection *conn)
+{
+	struct lttng_dynamic_array stream_ids;
+	struct relay_session *session;
+	int ret = 0;
+
+	lttng_dynamic_array_init(&stream_ids, sizeof(uint64_t), nullptr);
+
+	/* The identifiers are collected first: getting the metadata takes the stream lock. */
+	{
+		lttng::urcu::read_lock_guard read_lock;
+
+		cds_list_for_each_entry_rcu(
+			session, &conn->viewer_session->session_list, viewer_session_node)
+		{
+			struct relay_viewer_stream *vstream;
+
+			cds_list_for_each_entry_rcu(
+				vstream, &session->viewer_streams, session_node)
+			{
+				bool sent;
+				uint64_t stream_id;
+
+				if (!viewer_stream_get(vstream)) {
+					continue;
+				}
+
+				pthread_mutex_lock(&vstream->stream->lock);
+				sent = vstream->sent_flag && vstream->stream->is_metadata &&
+					vstream->metadata_sent < vstream->stream->metadata_received;
+				stream_id = vstream->stream->stream_handle;
+				pthread_mutex_unlock(&vstream->stream->lock);
+				viewer_stream_put(vstream);
 
-			vstream->stream->no_new_metadata_notified = true;
+				if (sent &&
+				    lttng_dynamic_array_add_element(&stream_ids, &stream_id)) {
+					ERR("Failed to list the metadata streams of the viewer");
+					ret = -1;
+					goto end;
+				}
+			}
 		}
-		goto send_reply;
 	}
 
-	if (vstream->stream->trace_chunk &&
-	    !lttng_trace_chunk_ids_equal(conn->viewer_session->current_trace_chunk,
-					 vstream->stream->trace_chunk)) {
-		/* A rotation has occurred on the relay stream. */
-		DBG("Metadata relay stream and viewer chunk ids differ");
+	for (size_t i = 0; i < lttng_dynamic_array_get_count(&stream_ids); i++) {
+		const uint64_t stream_id =
+			*(uint64_t *) lttng_dynamic_array_get_element(&stream_ids, i);
+		char *data;
+		uint64_t len;
 
-		ret = viewer_session_set_trace_chunk_copy(conn->viewer_session,
-							  vstream->stream->trace_chunk);
+		if (get_metadata(conn, stream_id, &data, &len) == LTTNG_VIEWER_METADATA_OK &&
+		    len > 0) {
+			ret = push_frame(conn, LTTNG_VIEWER_FRAME_METADATA, stream_id, len);
+			if (!ret && send_response(conn, data, len) < 0) {
+				ret = -1;
+			}
+		}
+
+		free(data);
+		memory_budget_release(MEMORY_BUDGET_VIEWER_BUFFER, len);
 		if (ret) {
-			reply.status = htobe32(LTTNG_VIEWER_METADATA_ERR);
-			goto send_reply;
+			goto end;
 		}
 	}
 
-	if (conn->viewer_session->current_trace_chunk &&
-	    !lttng_trace_chunk_ids_equal(conn->viewer_session->current_trace_chunk,
-					 vstream->stream_file.trace_chunk)) {
-		bool acquired_reference;
+end:
+	lttng_dynamic_array_reset(&stream_ids);
+	return ret;
+}
 
-		DBG("Viewer session and viewer stream chunk differ: "
-		    "vsession chunk %p vstream chunk %p",
-		    conn->viewer_session->current_trace_chunk,
-		    vstream->stream_file.trace_chunk);
-		lttng_trace_chunk_put(vstream->stream_file.trace_chunk);
-		acquired_reference =
-			lttng_trace_chunk_get(conn->viewer_session->current_trace_chunk);
-		LTTNG_ASSERT(acquired_reference);
-		vstream->stream_file.trace_chunk = conn->viewer_session->current_trace_chunk;
-		viewer_stream_close_files(vstream);
-	}
+/*
+ * Push the packets of a data stream within its credit, until it has no
+ * index to push, in which case its waiter is registered.
+ *
+ * Return 0 if the stream remains pushed, 1 if it ended, or else a negative
+ * value.
+ */
+static int push_stream(struct relay_connection *conn,
+		       struct viewer_pushed_stream *pushed,
+		       bool *new_streams)
+{
+	struct relay_stream *rstream = pushed->vstream->stream;
+	const uint64_t stream_id = rstream->stream_handle;
+	int ret;
 
-	len = vstream->stream->metadata_received - vstream->metadata_sent;
+	while (pushed->credit > 0) {
+		struct lttng_viewer_index viewer_index;
+		struct viewer_packet_source source;
+		uint64_t wakeup_count, offset, len;
+		uint32_t flags;
 
-	if (!vstream->stream_file.trace_chunk) {
-		reply.status = htobe32(LTTNG_VIEWER_NO_NEW_METADATA);
-		len = 0;
-		goto send_reply;
-	} else if (vstream->stream_file.trace_chunk && !vstream->stream_file.handle && len > 0) {
-		/*
-		 * Either this is the first time the metadata file is read, or a
-		 * rotation of the corresponding relay stream has occurred.
-		 */
-		struct fs_handle *fs_handle;
-		char file_path[LTTNG_PATH_MAX];
-		enum lttng_trace_chunk_status status;
-		struct relay_stream *rstream = vstream->stream;
+		pthread_mutex_lock(&rstream->lock);
+		wakeup_count = rstream->index_wakeup_count;
+		pthread_mutex_unlock(&rstream->lock);
 
-		ret = utils_stream_file_path(rstream->path_name,
-					     rstream->channel_name,
-					     rstream->tracefile_size,
-					     vstream->current_tracefile_id,
-					     nullptr,
-					     file_path,
-					     sizeof(file_path));
+		ret = get_next_index(conn, stream_id, &viewer_index);
 		if (ret < 0) {
-			goto error;
+			return ret;
 		}
 
-		/*
-		 * It is possible the the metadata file we are trying to open is
-		 * missing if the stream has been closed (application exits with
-		 * per-pid buffers) and a clear command has been performed.
-		 */
-		status = lttng_trace_chunk_open_fs_handle(
-			vstream->stream_file.trace_chunk, file_path, O_RDONLY, 0, &fs_handle, true);
-		if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
-			if (status == LTTNG_TRACE_CHUNK_STATUS_NO_FILE) {
-				reply.status = htobe32(LTTNG_VIEWER_NO_NEW_METADATA);
-				len = 0;
-				if (vstream->stream->closed) {
-					viewer_stream_put(vstream);
-				}
-				goto send_reply;
+		flags = be32toh(viewer_index.flags);
+		*new_streams |= !!(flags & LTTNG_VIEWER_FLAG_NEW_STREAM);
+		if (flags & LTTNG_VIEWER_FLAG_NEW_METADATA) {
+			/* The viewer needs the metadata before reading this packet. */
+			ret = push_metadata(conn);
+			if (ret < 0) {
+				return ret;
 			}
-			PERROR("Failed to open metadata file for viewer stream");
-			goto error;
 		}
-		vstream->stream_file.handle = fs_handle;
 
-		if (vstream->metadata_sent != 0) {
-			/*
-			 * The client does not expect to receive any metadata
-			 * it has received and metadata files in successive
-			 * chunks must be a strict superset of one another.
-			 *
-			 * Skip the first `metadata_sent` bytes to ensure
-			 * they are not sent a second time to the client.
-			 *
-			 * Baring a block layer error or an internal error,
-			 * this seek should not fail as
-			 * `vstream->stream->metadata_received` is reset when
-			 * a relay stream is rotated. If this is reached, it is
-			 * safe to assume that
-			 * `metadata_received` > `metadata_sent`.
-			 */
-			const off_t seek_ret =
-				fs_handle_seek(fs_handle, vstream->metadata_sent, SEEK_SET);
+		switch (be32toh(viewer_index.status)) {
+		case LTTNG_VIEWER_INDEX_OK:
+			offset = be64toh(viewer_index.offset);
+			len = be64toh(viewer_index.packet_size) / CHAR_BIT;
+			if (get_packet_source(pushed->vstream, offset, len, &source)) {
+				/* The index was consumed: the stream can't be pushed on. */
+				viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_ERR);
+				break;
+			}
 
-			if (seek_ret < 0) {
-				PERROR("Failed to seek metadata viewer stream file to `sent` position: pos = %" PRId64,
-				       vstream->metadata_sent);
-				reply.status = htobe32(LTTNG_VIEWER_METADATA_ERR);
-				goto send_reply;
+			ret = push_frame(conn,
+					 LTTNG_VIEWER_FRAME_PACKET,
+					 stream_id,
+					 sizeof(viewer_index) + len);
+			if (!ret && send_response(conn, &viewer_index, sizeof(viewer_index)) < 0) {
+				ret = -1;
+			}
+			if (ret) {
+				viewer_packet_source_release(&source);
+				return ret;
+			}
+
+			ret = send_packet(conn, &source, offset, len);
+			if (ret < 0) {
+				return ret;
+			}
+
+			pushed->credit -= std::min(pushed->credit, len);
+			continue;
+		case LTTNG_VIEWER_INDEX_INACTIVE:
+		case LTTNG_VIEWER_INDEX_RETRY:
+			if (be32toh(viewer_index.status) == LTTNG_VIEWER_INDEX_INACTIVE &&
+			    be64toh(viewer_index.timestamp_end) != pushed->beacon_ts_end) {
+				pushed->beacon_ts_end = be64toh(viewer_index.timestamp_end);
+				ret = push_frame(conn,
+						 LTTNG_VIEWER_FRAME_INDEX,
+						 stream_id,
+						 sizeof(viewer_index));
+				if (!ret &&
+				    send_response(conn, &viewer_index, sizeof(viewer_index)) < 0) {
+					ret = -1;
+				}
+				if (ret) {
+					return ret;
+				}
+			}
+
+			/* The stream may have been woken up since its next index was checked. */
+			pthread_mutex_lock(&rstream->lock);
+			if (rstream->index_wakeup_count != wakeup_count) {
+				pthread_mutex_unlock(&rstream->lock);
+				continue;
 			}
+
+			stream_add_index_waiter(rstream, &pushed->waiter);
+			pthread_mutex_unlock(&rstream->lock);
+			pushed->waiting = true;
+			return 0;
+		default:
+			break;
+		}
+
+		/* The viewer is told why the stream ended. */
+		ret = push_frame(conn, LTTNG_VIEWER_FRAME_INDEX, stream_id, sizeof(viewer_index));
+		if (!ret && send_response(conn, &viewer_index, sizeof(viewer_index)) < 0) {
+			ret = -1;
 		}
+
+		return ret < 0 ? ret : 1;
 	}
 
-	reply.len = htobe64(len);
-	data = zmalloc<char>(len);
-	if (!data) {
-		PERROR("viewer metadata zmalloc");
-		goto error;
+	return 0;
+}
+
+/*
+ * Push what the streams of a viewer connection in push mode have for it:
+ * the packets of the streams which have credit and aren't waiting, or were
+ * woken up, along with the metadata and new streams.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int push_subscription(struct relay_connection *conn)
+{
+	auto *subscription = conn->protocol.viewer.subscription;
+	bool new_streams = false;
+	int ret;
+
+	if (check_new_streams(conn) == 1) {
+		ret = push_new_streams(conn);
+		if (!ret) {
+			ret = subscribe_sent_streams(conn);
+		}
+		if (ret < 0) {
+			return ret;
+		}
 	}
 
-	fd = fs_handle_get_fd(vstream->stream_file.handle);
-	if (fd < 0) {
-		ERR("Failed to restore viewer stream file system handle");
-		goto error;
+	ret = push_metadata(conn);
+	if (ret < 0) {
+		return ret;
 	}
-	read_len = lttng_read(fd, data, len);
-	fs_handle_put_fd(vstream->stream_file.handle);
-	fd = -1;
-	if (read_len < len) {
-		if (read_len < 0) {
-			PERROR("Failed to read metadata file");
-			goto error;
-		} else {
-			/*
-			 * A clear has been performed which prevents the relay
-			 * from sending `len` bytes of metadata.
-			 *
-			 * It is important not to send any metadata if we
-			 * couldn't read all the available metadata in one shot:
-			 * sending partial metadata can cause the client to
-			 * attempt to parse an incomplete (incoherent) metadata
-			 * stream, which would result in an error.
-			 */
-			const off_t seek_ret =
-				fs_handle_seek(vstream->stream_file.handle, -read_len, SEEK_CUR);
 
-			DBG("Failed to read metadata: requested = %" PRIu64 ", got = %zd",
-			    len,
-			    read_len);
-			read_len = 0;
-			len = 0;
-			if (seek_ret < 0) {
-				PERROR("Failed to restore metadata file position after partial read");
-				ret = -1;
-				goto error;
+	for (size_t i = lttng_dynamic_pointer_array_get_count(&subscription->streams); i > 0; i--) {
+		auto *pushed = viewer_subscription_get_stream(subscription, i - 1);
+
+		if (pushed->waiting) {
+			if (!CMM_LOAD_SHARED(pushed->waiter.woken_up)) {
+				continue;
 			}
+
+			pthread_mutex_lock(&pushed->vstream->stream->lock);
+			stream_remove_index_waiter(pushed->vstream->stream, &pushed->waiter);
+			pthread_mutex_unlock(&pushed->vstream->stream->lock);
+			pushed->waiting = false;
+		}
+
+		ret = push_stream(conn, pushed, &new_streams);
+		if (ret < 0) {
+			return ret;
+		} else if (ret > 0) {
+			DBG("Viewer stream %" PRIu64 " no longer pushed",
+			    pushed->vstream->stream->stream_handle);
+			(void) lttng_dynamic_pointer_array_remove_pointer(&subscription->streams,
+									  i - 1);
+		}
+	}
+
+	if (new_streams) {
+		/* The new streams are pushed as of the next wake-up or credit. */
+		ret = push_new_streams(conn);
+		if (!ret) {
+			ret = subscribe_sent_streams(conn);
 		}
 	}
-	vstream->metadata_sent += read_len;
-	reply.status = htobe32(LTTNG_VIEWER_METADATA_OK);
 
-	goto send_reply;
+	return ret;
+}
 
-error:
-	reply.status = htobe32(LTTNG_VIEWER_METADATA_ERR);
+/*
+ * Switch the connection to push mode.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_subscribe(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_subscribe_request request;
+	struct lttng_viewer_subscribe_response response = {};
+	struct viewer_subscription *subscription;
+	uint64_t window;
+
+	LTTNG_ASSERT(conn);
 
-send_reply:
 	health_code_update();
-	if (vstream) {
-		pthread_mutex_unlock(&vstream->stream->lock);
-	}
-	ret = send_response(conn->sock, &reply, sizeof(reply));
+
+	ret = recv_request(conn->sock, &request, sizeof(request));
 	if (ret < 0) {
-		goto end_free;
+		return ret;
 	}
+	window = be64toh(request.window);
+
 	health_code_update();
 
-	if (len > 0) {
-		ret = send_response(conn->sock, data, len);
-		if (ret < 0) {
-			goto end_free;
-		}
+	if (!conn->viewer_session || cds_list_empty(&conn->viewer_session->session_list) ||
+	    conn->viewer_session->type != LTTNG_VIEWER_SESSION_TYPE_STREAMS ||
+	    conn->protocol.viewer.subscription || window == 0) {
+		DBG("Viewer can't subscribe without an attached session or with a window of 0");
+		response.status = htobe32(LTTNG_VIEWER_SUBSCRIBE_ERR);
+		ret = send_response(conn, &response, sizeof(response));
+		return ret < 0 ? ret : 0;
 	}
 
-	DBG("Sent %" PRIu64 " bytes of metadata for stream %" PRIu64,
-	    len,
-	    (uint64_t) be64toh(request.stream_id));
+	subscription = zmalloc<viewer_subscription>();
+	if (!subscription) {
+		PERROR("Failed to allocate viewer subscription");
+		return -1;
+	}
 
-	DBG("Metadata sent");
+	subscription->window = window;
+	lttng_dynamic_pointer_array_init(&subscription->streams, viewer_pushed_stream_destroy);
+	conn->protocol.viewer.subscription = subscription;
 
-end_free:
-	free(data);
-end:
-	if (vstream) {
-		viewer_stream_put(vstream);
+	/* The reply precedes the first frame. */
+	response.status = htobe32(LTTNG_VIEWER_SUBSCRIBE_OK);
+	ret = send_response(conn, &response, sizeof(response));
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = push_new_streams(conn);
+	if (!ret) {
+		ret = subscribe_sent_streams(conn);
+	}
+	if (!ret) {
+		ret = push_subscription(conn);
+	}
+	if (ret < 0) {
+		return ret;
+	}
+
+	DBG("Viewer subscribed with a window of %" PRIu64 " bytes", window);
+	health_code_update();
+	return 0;
+}
+
+/*
+ * Add credit to a data stream pushed to the viewer.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_add_credit(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_add_credit request;
+	auto *subscription = conn->protocol.viewer.subscription;
+	uint64_t stream_id, credit;
+
+	LTTNG_ASSERT(conn);
+
+	health_code_update();
+
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+	stream_id = be64toh(request.stream_id);
+	credit = be64toh(request.credit);
+
+	if (!subscription) {
+		ERR("Viewer on connection %d added credit without subscribing", conn->sock->fd);
+		return -1;
+	}
+
+	/* A stream which ended is no longer pushed. */
+	for (size_t i = 0; i < lttng_dynamic_pointer_array_get_count(&subscription->streams);
+	     i++) {
+		auto *pushed = viewer_subscription_get_stream(subscription, i);
+
+		if (pushed->vstream->stream->stream_handle == stream_id) {
+			pushed->credit += std::min(credit, UINT64_MAX - pushed->credit);
+			break;
+		}
 	}
-	return ret;
+
+	health_code_update();
+	return push_subscription(conn);
 }
 
 /*
@@ -2391,14 +4526,31 @@ end:
  *
  * Return 0 on success or else a negative value.
  */
-static int viewer_create_session(struct relay_connection *conn)
+static int viewer_create_session(struct relay_connection *conn, uint64_t data_size)
 {
 	int ret;
+	struct lttng_viewer_create_session_request request = {};
 	struct lttng_viewer_create_session_response resp;
+	uint32_t type = LTTNG_VIEWER_SESSION_TYPE_STREAMS;
+
+	if (conn->minor >= LTTNG_VIEWER_SESSION_TYPE_MINOR && data_size >= sizeof(request)) {
+		ret = recv_request(conn->sock, &request, sizeof(request));
+		if (ret < 0) {
+			goto end;
+		}
+
+		type = be32toh(request.type);
+	}
 
 	memset(&resp, 0, sizeof(resp));
 	resp.status = htobe32(LTTNG_VIEWER_CREATE_SESSION_OK);
-	conn->viewer_session = viewer_session_create();
+	if (type != LTTNG_VIEWER_SESSION_TYPE_STREAMS && type != LTTNG_VIEWER_SESSION_TYPE_MERGED) {
+		ERR("Viewer requested a viewer session of unknown type %" PRIu32, type);
+		resp.status = htobe32(LTTNG_VIEWER_CREATE_SESSION_ERR);
+		goto send_reply;
+	}
+
+	conn->viewer_session = viewer_session_create((enum lttng_viewer_session_type) type);
 	if (!conn->viewer_session) {
 		ERR("Allocation viewer session");
 		resp.status = htobe32(LTTNG_VIEWER_CREATE_SESSION_ERR);
@@ -2407,7 +4559,7 @@ static int viewer_create_session(struct relay_connection *conn)
 
 send_reply:
 	health_code_update();
-	ret = send_response(conn->sock, &resp, sizeof(resp));
+	ret = send_response(conn, &resp, sizeof(resp));
 	if (ret < 0) {
 		goto end;
 	}
@@ -2418,6 +4570,48 @@ end:
 	return ret;
 }
 
+/*
+ * Set the channel filter of the viewer session.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int viewer_set_channel_filter(struct relay_connection *conn)
+{
+	int ret;
+	struct lttng_viewer_set_channel_filter_request request;
+	struct lttng_viewer_set_channel_filter_response response;
+
+	LTTNG_ASSERT(conn);
+
+	health_code_update();
+
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+	health_code_update();
+
+	memset(&response, 0, sizeof(response));
+	response.status = htobe32(LTTNG_VIEWER_SET_CHANNEL_FILTER_OK);
+	if (!conn->viewer_session) {
+		DBG("Client trying to set a channel filter before creating a live viewer session");
+		response.status = htobe32(LTTNG_VIEWER_SET_CHANNEL_FILTER_ERR);
+	} else if (lttng_strnlen(request.channels, sizeof(request.channels)) ==
+			   sizeof(request.channels) ||
+		   viewer_session_set_channel_filter(conn->viewer_session, request.channels)) {
+		response.status = htobe32(LTTNG_VIEWER_SET_CHANNEL_FILTER_ERR);
+	}
+
+	health_code_update();
+	ret = send_response(conn, &response, sizeof(response));
+	if (ret < 0) {
+		return ret;
+	}
+	health_code_update();
+
+	return 0;
+}
+
 /*
  * Detach a viewer session.
  *
@@ -2476,7 +4670,7 @@ send_reply_put:
 
 send_reply:
 	health_code_update();
-	ret = send_response(conn->sock, &response, sizeof(response));
+	ret = send_response(conn, &response, sizeof(response));
 	if (ret < 0) {
 		goto end;
 	}
@@ -2496,7 +4690,35 @@ static void live_relay_unknown_command(struct relay_connection *conn)
 
 	memset(&reply, 0, sizeof(reply));
 	reply.ret_code = htobe32(LTTNG_ERR_UNK);
-	(void) send_response(conn->sock, &reply, sizeof(reply));
+	(void) send_response(conn, &reply, sizeof(reply));
+}
+
+/*
+ * Return the first protocol minor version supporting a viewer command.
+ */
+static uint32_t viewer_command_minor(lttng_viewer_command cmd)
+{
+	switch (cmd) {
+	case LTTNG_VIEWER_GET_NEXT_INDEXES:
+		return LTTNG_VIEWER_GET_NEXT_INDEXES_MINOR;
+	case LTTNG_VIEWER_WAIT_NEXT_INDEX:
+		return LTTNG_VIEWER_WAIT_NEXT_INDEX_MINOR;
+	case LTTNG_VIEWER_GET_NEXT_PACKETS:
+		return LTTNG_VIEWER_GET_NEXT_PACKETS_MINOR;
+	case LTTNG_VIEWER_GET_COMPRESSED_METADATA:
+		return LTTNG_VIEWER_GET_COMPRESSED_METADATA_MINOR;
+	case LTTNG_VIEWER_SET_CHANNEL_FILTER:
+		return LTTNG_VIEWER_SET_CHANNEL_FILTER_MINOR;
+	case LTTNG_VIEWER_LIST_SESSIONS_FILTERED:
+		return LTTNG_VIEWER_LIST_SESSIONS_FILTERED_MINOR;
+	case LTTNG_VIEWER_GET_NEXT_MERGED_INDEX:
+		return LTTNG_VIEWER_GET_NEXT_MERGED_INDEX_MINOR;
+	case LTTNG_VIEWER_SUBSCRIBE:
+	case LTTNG_VIEWER_ADD_CREDIT:
+		return LTTNG_VIEWER_SUBSCRIBE_MINOR;
+	default:
+		return 0;
+	}
 }
 
 /*
@@ -2519,13 +4741,34 @@ static int process_control(struct lttng_viewer_cmd *recv_hdr, struct relay_conne
 		goto end;
 	}
 
+	if (conn->minor < viewer_command_minor(cmd)) {
+		ERR("Viewer on connection %d requested %s command with protocol %u.%u",
+		    conn->sock->fd,
+		    lttng_viewer_command_str(cmd),
+		    conn->major,
+		    conn->minor);
+		live_relay_unknown_command(conn);
+		ret = -1;
+		goto end;
+	}
+
+	/* The replies would be mixed with the frames pushed to the viewer. */
+	if (conn->protocol.viewer.subscription && cmd != LTTNG_VIEWER_ADD_CREDIT) {
+		ERR("Viewer on connection %d requested %s command in push mode",
+		    conn->sock->fd,
+		    lttng_viewer_command_str(cmd));
+		ret = -1;
+		goto end;
+	}
+
 	DBG("Processing %s viewer command from connection %d",
 	    lttng_viewer_command_str(cmd),
 	    conn->sock->fd);
 
+	self_tracepoint(relayd_viewer_command_begin, conn->sock->fd, (unsigned int) cmd);
 	switch (cmd) {
 	case LTTNG_VIEWER_CONNECT:
-		ret = viewer_connect(conn);
+		ret = viewer_connect(conn, be64toh(recv_hdr->data_size));
 		break;
 	case LTTNG_VIEWER_LIST_SESSIONS:
 		ret = viewer_list_sessions(conn);
@@ -2546,11 +4789,38 @@ static int process_control(struct lttng_viewer_cmd *recv_hdr, struct relay_conne
 		ret = viewer_get_new_streams(conn);
 		break;
 	case LTTNG_VIEWER_CREATE_SESSION:
-		ret = viewer_create_session(conn);
+		ret = viewer_create_session(conn, be64toh(recv_hdr->data_size));
 		break;
 	case LTTNG_VIEWER_DETACH_SESSION:
 		ret = viewer_detach_session(conn);
 		break;
+	case LTTNG_VIEWER_GET_NEXT_INDEXES:
+		ret = viewer_get_next_indexes(conn);
+		break;
+	case LTTNG_VIEWER_WAIT_NEXT_INDEX:
+		ret = viewer_wait_next_index(conn);
+		break;
+	case LTTNG_VIEWER_GET_NEXT_PACKETS:
+		ret = viewer_get_next_packets(conn);
+		break;
+	case LTTNG_VIEWER_GET_COMPRESSED_METADATA:
+		ret = viewer_get_compressed_metadata(conn);
+		break;
+	case LTTNG_VIEWER_SET_CHANNEL_FILTER:
+		ret = viewer_set_channel_filter(conn);
+		break;
+	case LTTNG_VIEWER_LIST_SESSIONS_FILTERED:
+		ret = viewer_list_sessions_filtered(conn);
+		break;
+	case LTTNG_VIEWER_GET_NEXT_MERGED_INDEX:
+		ret = viewer_get_next_merged_index(conn);
+		break;
+	case LTTNG_VIEWER_SUBSCRIBE:
+		ret = viewer_subscribe(conn);
+		break;
+	case LTTNG_VIEWER_ADD_CREDIT:
+		ret = viewer_add_credit(conn);
+		break;
 	default:
 		ERR("Received unknown viewer command (%u)", be32toh(recv_hdr->cmd));
 		live_relay_unknown_command(conn);
@@ -2558,6 +4828,7 @@ static int process_control(struct lttng_viewer_cmd *recv_hdr, struct relay_conne
 		goto end;
 	}
 
+	self_tracepoint(relayd_viewer_command_end, conn->sock->fd, (unsigned int) cmd, ret);
 end:
 	return ret;
 }
@@ -2575,20 +4846,266 @@ static void cleanup_connection_pollfd(struct lttng_poll_event *events, int pollf
 	}
 }
 
+/*
+ * Close a viewer connection of a worker thread, which counts the index
+ * waits of its viewers in `nr_index_waits`.
+ */
+static void close_viewer_connection(struct lttng_poll_event *events,
+				    struct viewer_idle_wheel *idle,
+				    struct relay_connection *conn,
+				    unsigned int *nr_index_waits)
+{
+	if (viewer_end_index_wait(conn)) {
+		(*nr_index_waits)--;
+	}
+
+	viewer_end_subscription(conn);
+	viewer_idle_forget(idle, conn);
+
+	cleanup_connection_pollfd(events, conn->sock->fd);
+	/* Put "create" ownership reference. */
+	connection_put(conn);
+}
+
+/*
+ * Send the queued output of a viewer connection and poll what it waits for
+ * next: room to send the rest of its output, its next request, or nothing
+ * but its hang-up while it waits for the next index of a stream.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int update_viewer_connection(struct lttng_poll_event *events,
+				    struct relay_connection *conn)
+{
+	auto *viewer = &conn->protocol.viewer;
+	uint32_t polled_events;
+	int ret;
+
+	ret = flush_viewer_output(conn);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (ret == 0) {
+		polled_events = LPOLLOUT | LPOLLRDHUP;
+	} else if (viewer->index_wait.vstream) {
+		polled_events = LPOLLRDHUP;
+	} else {
+		polled_events = LPOLLIN | LPOLLRDHUP;
+	}
+
+	if (polled_events == viewer->polled_events) {
+		return 0;
+	}
+
+	ret = lttng_poll_mod(events, conn->sock->fd, polled_events);
+	if (ret < 0) {
+		return ret;
+	}
+
+	viewer->polled_events = polled_events;
+	return 0;
+}
+
+/*
+ * Process the next request of a viewer connection of a worker thread.
+ *
+ * Return 0 on success or else a negative value, in which case the connection
+ * must be closed.
+ */
+static int process_viewer_request(struct lttng_poll_event *events,
+				  struct relay_connection *conn,
+				  unsigned int *nr_index_waits)
+{
+	struct lttng_viewer_cmd recv_hdr;
+	int ret;
+
+	ret = conn->sock->ops->recvmsg(conn->sock, &recv_hdr, sizeof(recv_hdr), 0);
+	if (ret <= 0) {
+		/* Connection closed. */
+		DBG("Viewer control conn closed with %d", conn->sock->fd);
+		return -1;
+	}
+
+	ret = process_control(&recv_hdr, conn);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (conn->protocol.viewer.index_wait.vstream) {
+		(*nr_index_waits)++;
+	}
+
+	/* Stop reading requests until the viewer received the replies to this one. */
+	return update_viewer_connection(events, conn);
+}
+
+/*
+ * Answer the LTTNG_VIEWER_WAIT_NEXT_INDEX requests of the viewers of a
+ * worker thread whose stream was woken up or which timed out.
+ *
+ * Return the poll timeout, in milliseconds, until the first remaining
+ * request times out, or -1 if none remains.
+ */
+static int check_index_waits(struct lttng_poll_event *events,
+			     struct viewer_idle_wheel *idle,
+			     struct lttng_ht *viewer_connections_ht,
+			     unsigned int *nr_index_waits)
+{
+	struct lttng_ht_iter iter;
+	struct relay_connection *conn;
+	const uint64_t now = lttng_thread_clock_now_ns();
+	uint64_t first_deadline = UINT64_MAX;
+
+	if (*nr_index_waits == 0) {
+		return -1;
+	}
+
+	{
+		lttng::urcu::read_lock_guard read_lock;
+
+		cds_lfht_for_each_entry (
+			viewer_connections_ht->ht, &iter.iter, conn, sock_n.node) {
+			auto *wait = &conn->protocol.viewer.index_wait;
+			bool woken_up;
+			int ret;
+
+			if (!wait->vstream) {
+				continue;
+			}
+
+			woken_up = CMM_LOAD_SHARED(wait->waiter.woken_up);
+			if (!woken_up && now < wait->deadline_ns) {
+				first_deadline = std::min(first_deadline, wait->deadline_ns);
+				continue;
+			}
+
+			pthread_mutex_lock(&wait->vstream->stream->lock);
+			stream_remove_index_waiter(wait->vstream->stream, &wait->waiter);
+			pthread_mutex_unlock(&wait->vstream->stream->lock);
+
+			ret = viewer_check_index_wait(conn, woken_up);
+			if (ret == 0) {
+				first_deadline = std::min(first_deadline, wait->deadline_ns);
+				continue;
+			} else if (ret > 0) {
+				(*nr_index_waits)--;
+				ret = update_viewer_connection(events, conn);
+			}
+
+			if (ret < 0) {
+				close_viewer_connection(events, idle, conn, nr_index_waits);
+				DBG("Viewer connection closed while waiting for an index");
+			}
+		}
+	}
+
+	if (first_deadline == UINT64_MAX) {
+		return -1;
+	}
+
+	/* Round up so that the request timed out once the poll times out. */
+	return (int) std::min<uint64_t>(
+		(first_deadline - std::min(first_deadline, now) + NSEC_PER_MSEC - 1) /
+			NSEC_PER_MSEC,
+		VIEWER_MAX_INDEX_WAIT_MS);
+}
+
+/*
+ * Push what the woken up streams of the viewer connections in push mode of
+ * a worker thread have for them.
+ */
+static void check_subscriptions(struct lttng_poll_event *events,
+				struct viewer_idle_wheel *idle,
+				struct lttng_ht *viewer_connections_ht,
+				unsigned int *nr_index_waits)
+{
+	struct lttng_ht_iter iter;
+	struct relay_connection *conn;
+	lttng::urcu::read_lock_guard read_lock;
+
+	cds_lfht_for_each_entry (viewer_connections_ht->ht, &iter.iter, conn, sock_n.node) {
+		int ret;
+
+		if (!conn->protocol.viewer.subscription) {
+			continue;
+		}
+
+		ret = push_subscription(conn);
+		if (!ret) {
+			ret = update_viewer_connection(events, conn);
+		}
+
+		if (ret < 0) {
+			close_viewer_connection(events, idle, conn, nr_index_waits);
+			DBG("Viewer connection closed while pushing its streams");
+		}
+	}
+}
+
+/*
+ * Close the viewer connections of a worker thread which were idle for the
+ * idle timeout, releasing their viewer session and viewer streams. The
+ * viewers waiting for the next index of a stream or in push mode are not
+ * idle.
+ *
+ * Return the poll timeout, in milliseconds, until the next idle timer may
+ * expire, or -1 if none is armed.
+ */
+static int check_idle_connections(struct lttng_poll_event *events,
+				  struct viewer_idle_wheel *idle,
+				  unsigned int *nr_index_waits)
+{
+	std::vector<struct relay_connection *> expired;
+
+	viewer_idle_expire(idle, expired);
+	for (auto *conn : expired) {
+		if ((conn->protocol.viewer.index_wait.vstream ||
+		     conn->protocol.viewer.subscription) &&
+		    !viewer_idle_touch(idle, conn)) {
+			continue;
+		}
+
+		WARN("Closing idle viewer connection %d", conn->sock->fd);
+		close_viewer_connection(events, idle, conn, nr_index_waits);
+	}
+
+	return viewer_idle_poll_timeout(idle);
+}
+
+/* Return the earliest of two poll timeouts, -1 meaning none. */
+static int earliest_poll_timeout(int a, int b)
+{
+	if (a < 0) {
+		return b;
+	} else if (b < 0) {
+		return a;
+	}
+
+	return std::min(a, b);
+}
+
 /*
  * This thread does the actual work
  */
-static void *thread_worker(void *data __attribute__((unused)))
+static void *thread_worker(void *data)
 {
 	int ret, err = -1;
 	uint32_t nb_fd;
 	struct lttng_poll_event events;
 	struct lttng_ht *viewer_connections_ht;
 	struct lttng_ht_iter iter;
-	struct lttng_viewer_cmd recv_hdr;
 	struct relay_connection *destroy_conn;
+	struct live_worker *worker = (struct live_worker *) data;
+	int *live_conn_pipe = worker->conn_pipe;
+	/* Pending LTTNG_VIEWER_WAIT_NEXT_INDEX requests of the viewers. */
+	unsigned int nr_index_waits = 0;
+	int poll_timeout = -1;
+	struct viewer_idle_wheel idle;
+	/* Set when the streams woke up the viewers of the worker. */
+	bool woken_up;
 
-	DBG("[thread] Live viewer relay worker started");
+	DBG("[thread] Live viewer relay worker %u started", worker->id);
 
 	rcu_register_thread();
 
@@ -2614,17 +5131,25 @@ static void *thread_worker(void *data __attribute__((unused)))
 		goto error;
 	}
 
+	/* The wake-up pipe is non-blocking and drained on each of its events. */
+	ret = lttng_poll_add(&events, worker->wakeup_pipe[0], LPOLLIN | LPOLLRDHUP | LPOLLET);
+	if (ret < 0) {
+		goto error;
+	}
+
 restart:
 	while (true) {
 		int i;
 
 		health_code_update();
 
-		/* Infinite blocking call, waiting for transmission */
+		/* Blocking call, waiting for transmission or an index wait to time out. */
 		DBG3("Relayd live viewer worker thread polling...");
 		health_poll_entry();
-		ret = lttng_poll_wait(&events, -1);
+		ret = lttng_poll_wait(&events, poll_timeout);
 		health_poll_exit();
+		/* The index waits and idle timers of this iteration use this time. */
+		lttng_thread_clock_refresh();
 		if (ret < 0) {
 			/*
 			 * Restart interrupted system call.
@@ -2636,6 +5161,7 @@ restart:
 		}
 
 		nb_fd = ret;
+		woken_up = false;
 
 		/*
 		 * Process control. The control connection is prioritised so we don't
@@ -2674,8 +5200,15 @@ restart:
 						ERR("Failed to add new live connection file descriptor to poll set");
 						goto error;
 					}
+					conn->protocol.viewer.polled_events = LPOLLIN | LPOLLRDHUP;
+					conn->protocol.viewer.index_wait.waiter.wakeup_fd =
+						worker->wakeup_pipe[1];
 					connection_ht_add(viewer_connections_ht, conn);
 					DBG("Connection socket %d added to poll", conn->sock->fd);
+					if (viewer_idle_touch(&idle, conn)) {
+						close_viewer_connection(
+							&events, &idle, conn, &nr_index_waits);
+					}
 				} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
 					ERR("Relay live pipe error");
 					goto error;
@@ -2685,6 +5218,19 @@ restart:
 					    pollfd);
 					goto error;
 				}
+			} else if (pollfd == worker->wakeup_pipe[0]) {
+				/* The index waits are checked once the events are handled. */
+				if (revents & LPOLLIN) {
+					char wakeups[64];
+
+					while (read(pollfd, wakeups, sizeof(wakeups)) > 0) {
+					}
+
+					woken_up = true;
+				} else {
+					ERR("Relay live wake-up pipe error");
+					goto error;
+				}
 			} else {
 				/* Connection activity. */
 				struct relay_connection *conn;
@@ -2695,29 +5241,12 @@ restart:
 				}
 
 				if (revents & LPOLLIN) {
-					ret = conn->sock->ops->recvmsg(
-						conn->sock, &recv_hdr, sizeof(recv_hdr), 0);
-					if (ret <= 0) {
-						/* Connection closed. */
-						cleanup_connection_pollfd(&events, pollfd);
-						/* Put "create" ownership reference. */
-						connection_put(conn);
-						DBG("Viewer control conn closed with %d", pollfd);
-					} else {
-						ret = process_control(&recv_hdr, conn);
-						if (ret < 0) {
-							/* Clear the session on error. */
-							cleanup_connection_pollfd(&events, pollfd);
-							/* Put "create" ownership reference. */
-							connection_put(conn);
-							DBG("Viewer connection closed with %d",
-							    pollfd);
-						}
-					}
+					ret = process_viewer_request(
+						&events, conn, &nr_index_waits);
+				} else if (revents & LPOLLOUT) {
+					ret = update_viewer_connection(&events, conn);
 				} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
-					cleanup_connection_pollfd(&events, pollfd);
-					/* Put "create" ownership reference. */
-					connection_put(conn);
+					ret = -1;
 				} else {
 					ERR("Unexpected poll events %u for sock %d",
 					    revents,
@@ -2725,10 +5254,31 @@ restart:
 					connection_put(conn);
 					goto error;
 				}
+
+				if (ret == 0 && (revents & (LPOLLIN | LPOLLOUT))) {
+					ret = viewer_idle_touch(&idle, conn);
+				}
+
+				if (ret < 0) {
+					close_viewer_connection(
+						&events, &idle, conn, &nr_index_waits);
+					DBG("Viewer connection closed with %d", pollfd);
+				}
+
 				/* Put local "get_by_sock" reference. */
 				connection_put(conn);
 			}
 		}
+
+		if (woken_up) {
+			check_subscriptions(
+				&events, &idle, viewer_connections_ht, &nr_index_waits);
+		}
+
+		poll_timeout =
+			check_index_waits(&events, &idle, viewer_connections_ht, &nr_index_waits);
+		poll_timeout = earliest_poll_timeout(
+			poll_timeout, check_idle_connections(&events, &idle, &nr_index_waits));
 	}
 
 exit:
@@ -2742,6 +5292,10 @@ error:
 		cds_lfht_for_each_entry (
 			viewer_connections_ht->ht, &iter.iter, destroy_conn, sock_n.node) {
 			health_code_update();
+			/* The streams must not wake up the worker once its pipe is closed. */
+			viewer_end_index_wait(destroy_conn);
+			viewer_end_subscription(destroy_conn);
+			viewer_idle_forget(&idle, destroy_conn);
 			connection_put(destroy_conn);
 		}
 	}
@@ -2750,10 +5304,11 @@ error_poll_create:
 viewer_connections_ht_error:
 	/* Close relay conn pipes */
 	(void) fd_tracker_util_pipe_close(the_fd_tracker, live_conn_pipe);
+	(void) fd_tracker_util_pipe_close(the_fd_tracker, worker->wakeup_pipe);
 	if (err) {
-		DBG("Viewer worker thread exited with error");
+		DBG("Viewer worker thread %u exited with error", worker->id);
 	}
-	DBG("Viewer worker thread cleanup complete");
+	DBG("Viewer worker thread %u cleanup complete", worker->id);
 error_testpoint:
 	if (err) {
 		health_error();
@@ -2768,13 +5323,52 @@ error_testpoint:
 }
 
 /*
- * Create the relay command pipe to wake thread_manage_apps.
- * Closed in cleanup().
+ * Allocate the live worker threads and create their connection pipes. The
+ * pipes are closed by the worker threads.
  */
-static int create_conn_pipe()
+static int create_live_workers()
+{
+	live_workers = calloc<live_worker>(live_worker_count);
+	if (!live_workers) {
+		PERROR("Failed to allocate live worker threads");
+		return -1;
+	}
+
+	for (unsigned int i = 0; i < live_worker_count; i++) {
+		live_workers[i].id = i;
+		live_workers[i].conn_pipe[0] = -1;
+		live_workers[i].conn_pipe[1] = -1;
+		live_workers[i].wakeup_pipe[0] = -1;
+		live_workers[i].wakeup_pipe[1] = -1;
+	}
+
+	for (unsigned int i = 0; i < live_worker_count; i++) {
+		int *wakeup_pipe = live_workers[i].wakeup_pipe;
+
+		if (fd_tracker_util_pipe_open_cloexec(
+			    the_fd_tracker, "Live connection pipe", live_workers[i].conn_pipe)) {
+			return -1;
+		}
+
+		if (fd_tracker_util_pipe_open_cloexec(
+			    the_fd_tracker, "Live wake-up pipe", wakeup_pipe)) {
+			return -1;
+		}
+
+		/* The ingest threads wake up the worker without ever blocking. */
+		if (fcntl(wakeup_pipe[0], F_SETFL, O_NONBLOCK) ||
+		    fcntl(wakeup_pipe[1], F_SETFL, O_NONBLOCK)) {
+			PERROR("Failed to make live wake-up pipe non-blocking");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void relayd_live_set_worker_count(unsigned int count)
 {
-	return fd_tracker_util_pipe_open_cloexec(
-		the_fd_tracker, "Live connection pipe", live_conn_pipe);
+	live_worker_count = count;
 }
 
 int relayd_live_join()
@@ -2789,11 +5383,13 @@ int relayd_live_join()
 		retval = -1;
 	}
 
-	ret = pthread_join(live_worker_thread, &status);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_join live worker");
-		retval = -1;
+	for (unsigned int i = 0; i < live_worker_count; i++) {
+		ret = pthread_join(live_workers[i].thread, &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join live worker %u", i);
+			retval = -1;
+		}
 	}
 
 	ret = pthread_join(live_dispatcher_thread, &status);
@@ -2816,6 +5412,7 @@ int relayd_live_create(struct lttng_uri *uri)
 	int ret = 0, retval = 0;
 	void *status;
 	int is_root;
+	unsigned int worker_thread_count = 0;
 
 	if (!uri) {
 		retval = -1;
@@ -2834,8 +5431,8 @@ int relayd_live_create(struct lttng_uri *uri)
 		}
 	}
 
-	/* Setup the thread apps communication pipe. */
-	if (create_conn_pipe()) {
+	/* Setup the connection pipes of the worker threads. */
+	if (create_live_workers()) {
 		retval = -1;
 		goto exit_init_data;
 	}
@@ -2861,13 +5458,30 @@ int relayd_live_create(struct lttng_uri *uri)
 		goto exit_dispatcher_thread;
 	}
 
-	/* Setup the worker thread */
-	ret = pthread_create(&live_worker_thread, default_pthread_attr(), thread_worker, nullptr);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_create viewer worker");
-		retval = -1;
-		goto exit_worker_thread;
+	/* Setup the worker threads */
+	for (worker_thread_count = 0; worker_thread_count < live_worker_count;
+	     worker_thread_count++) {
+		struct live_worker *worker = &live_workers[worker_thread_count];
+
+		ret = pthread_create(
+			&worker->thread, default_pthread_attr(), thread_worker, worker);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create viewer worker %u", worker->id);
+			retval = -1;
+
+			/* Close the pipes of the workers which will never run. */
+			for (unsigned int i = worker_thread_count; i < live_worker_count; i++) {
+				(void) fd_tracker_util_pipe_close(the_fd_tracker,
+								  live_workers[i].conn_pipe);
+				(void) fd_tracker_util_pipe_close(the_fd_tracker,
+								  live_workers[i].wakeup_pipe);
+			}
+
+			/* Stop the workers which were already started. */
+			lttng_relay_stop_threads();
+			goto exit_worker_thread;
+		}
 	}
 
 	/* Setup the listener thread */
@@ -2891,14 +5505,15 @@ int relayd_live_create(struct lttng_uri *uri)
 	 */
 
 exit_listener_thread:
-
-	ret = pthread_join(live_worker_thread, &status);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_join live worker");
-		retval = -1;
-	}
 exit_worker_thread:
+	for (unsigned int i = 0; i < worker_thread_count; i++) {
+		ret = pthread_join(live_workers[i].thread, &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join live worker %u", i);
+			retval = -1;
+		}
+	}
 
 	ret = pthread_join(live_dispatcher_thread, &status);
 	if (ret) {
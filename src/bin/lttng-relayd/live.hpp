@@ -18,4 +18,7 @@ int relayd_live_create(struct lttng_uri *live_uri);
 int relayd_live_stop(void);
 int relayd_live_join(void);
 
+/* Set the number of live worker threads, before relayd_live_create(). */
+void relayd_live_set_worker_count(unsigned int count);
+
 #endif /* LTTNG_RELAYD_LIVE_H */
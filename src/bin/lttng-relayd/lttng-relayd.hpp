@@ -49,6 +49,9 @@ extern char *opt_output_path;
 extern const char *tracing_group_name;
 extern const char *const config_section_name;
 extern enum relay_group_output_by opt_group_output_by;
+extern unsigned int opt_index_buffer_count;
+extern uint64_t opt_preallocation_size;
+extern bool opt_deduplicate_packets;
 
 extern struct fd_tracker *the_fd_tracker;
 
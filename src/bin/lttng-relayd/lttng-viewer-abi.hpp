@@ -18,12 +18,43 @@
 #define LTTNG_VIEWER_NAME_MAX	   255
 #define LTTNG_VIEWER_HOST_NAME_MAX 64
 
+/* First protocol minor version supporting LTTNG_VIEWER_GET_NEXT_INDEXES. */
+#define LTTNG_VIEWER_GET_NEXT_INDEXES_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_WAIT_NEXT_INDEX. */
+#define LTTNG_VIEWER_WAIT_NEXT_INDEX_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_GET_NEXT_PACKETS. */
+#define LTTNG_VIEWER_GET_NEXT_PACKETS_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_GET_COMPRESSED_METADATA. */
+#define LTTNG_VIEWER_GET_COMPRESSED_METADATA_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_SEEK_TIMESTAMP. */
+#define LTTNG_VIEWER_SEEK_TIMESTAMP_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_SET_CHANNEL_FILTER. */
+#define LTTNG_VIEWER_SET_CHANNEL_FILTER_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_LIST_SESSIONS_FILTERED. */
+#define LTTNG_VIEWER_LIST_SESSIONS_FILTERED_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_GET_NEXT_MERGED_INDEX. */
+#define LTTNG_VIEWER_GET_NEXT_MERGED_INDEX_MINOR 14
+/* First protocol minor version supporting struct lttng_viewer_create_session_request. */
+#define LTTNG_VIEWER_SESSION_TYPE_MINOR 14
+/* First protocol minor version supporting LTTNG_VIEWER_SUBSCRIBE and LTTNG_VIEWER_ADD_CREDIT. */
+#define LTTNG_VIEWER_SUBSCRIBE_MINOR 14
+/* First protocol minor version supporting struct lttng_viewer_connect_capabilities. */
+#define LTTNG_VIEWER_CAPABILITIES_MINOR 14
+
 /* Flags in reply to get_next_index and get_packet. */
 enum {
 	/* New metadata is required to read this packet. */
 	LTTNG_VIEWER_FLAG_NEW_METADATA = (1 << 0),
 	/* New stream got added to the trace. */
 	LTTNG_VIEWER_FLAG_NEW_STREAM = (1 << 1),
+	/* The packet of the reply is compressed with zstd, `len` being its compressed size. */
+	LTTNG_VIEWER_FLAG_COMPRESSED_ZSTD = (1 << 2),
+};
+
+/* Capabilities negotiated by struct lttng_viewer_connect_capabilities. */
+enum {
+	/* The LTTNG_VIEWER_GET_PACKET replies may be compressed with zstd. */
+	LTTNG_VIEWER_CAPABILITY_PACKET_ZSTD = (1 << 0),
 };
 
 enum lttng_viewer_command {
@@ -36,6 +67,15 @@ enum lttng_viewer_command {
 	LTTNG_VIEWER_GET_NEW_STREAMS = 7,
 	LTTNG_VIEWER_CREATE_SESSION = 8,
 	LTTNG_VIEWER_DETACH_SESSION = 9,
+	LTTNG_VIEWER_GET_NEXT_INDEXES = 10,
+	LTTNG_VIEWER_WAIT_NEXT_INDEX = 11,
+	LTTNG_VIEWER_GET_NEXT_PACKETS = 12,
+	LTTNG_VIEWER_GET_COMPRESSED_METADATA = 13,
+	LTTNG_VIEWER_SET_CHANNEL_FILTER = 14,
+	LTTNG_VIEWER_LIST_SESSIONS_FILTERED = 15,
+	LTTNG_VIEWER_GET_NEXT_MERGED_INDEX = 16,
+	LTTNG_VIEWER_SUBSCRIBE = 17,
+	LTTNG_VIEWER_ADD_CREDIT = 18,
 };
 
 enum lttng_viewer_attach_return_code {
@@ -69,6 +109,11 @@ enum lttng_viewer_get_metadata_return_code {
 	LTTNG_VIEWER_METADATA_ERR = 3,
 };
 
+enum lttng_viewer_metadata_compression {
+	LTTNG_VIEWER_METADATA_COMPRESSION_NONE = 0,
+	LTTNG_VIEWER_METADATA_COMPRESSION_ZSTD = 1,
+};
+
 enum lttng_viewer_connection_type {
 	LTTNG_VIEWER_CLIENT_COMMAND = 1,
 	LTTNG_VIEWER_CLIENT_NOTIFICATION = 2,
@@ -79,6 +124,11 @@ enum lttng_viewer_seek {
 	LTTNG_VIEWER_SEEK_BEGINNING = 1,
 	/* Receive the trace packets from now. */
 	LTTNG_VIEWER_SEEK_LAST = 2,
+	/*
+	 * Receive the trace packets from the first one which ends at or
+	 * after the timestamp given in the attach request.
+	 */
+	LTTNG_VIEWER_SEEK_TIMESTAMP = 3,
 };
 
 enum lttng_viewer_new_streams_return_code {
@@ -88,6 +138,39 @@ enum lttng_viewer_new_streams_return_code {
 	LTTNG_VIEWER_NEW_STREAMS_HUP = 4, /* Session closed. */
 };
 
+enum lttng_viewer_session_type {
+	/* The viewer reads each stream on its own, merging them if needed. */
+	LTTNG_VIEWER_SESSION_TYPE_STREAMS = 0,
+	/*
+	 * The relay daemon merges the data streams of the attached sessions
+	 * into a single sequence of packets ordered by their beginning
+	 * timestamp. See LTTNG_VIEWER_GET_NEXT_MERGED_INDEX.
+	 */
+	LTTNG_VIEWER_SESSION_TYPE_MERGED = 1,
+};
+
+enum lttng_viewer_subscribe_return_code {
+	LTTNG_VIEWER_SUBSCRIBE_OK = 1,
+	/* No session is attached, the connection is subscribed, or the window is 0. */
+	LTTNG_VIEWER_SUBSCRIBE_ERR = 2,
+};
+
+/* Type of the frames pushed to a subscribed viewer, see LTTNG_VIEWER_SUBSCRIBE. */
+enum lttng_viewer_frame_type {
+	/* A struct lttng_viewer_index with the OK status, followed by its packet. */
+	LTTNG_VIEWER_FRAME_PACKET = 1,
+	/*
+	 * A struct lttng_viewer_index with another status: a new inactivity
+	 * beacon of the stream, or the end of the stream, which is no longer
+	 * pushed, with the HUP or ERR status.
+	 */
+	LTTNG_VIEWER_FRAME_INDEX = 2,
+	/* Metadata following the metadata already sent for the stream. */
+	LTTNG_VIEWER_FRAME_METADATA = 3,
+	/* struct lttng_viewer_stream of the new streams of the session `id`. */
+	LTTNG_VIEWER_FRAME_NEW_STREAMS = 4,
+};
+
 enum lttng_viewer_create_session_return_code {
 	LTTNG_VIEWER_CREATE_SESSION_OK = 1,
 	LTTNG_VIEWER_CREATE_SESSION_ERR = 2,
@@ -99,6 +182,35 @@ enum lttng_viewer_detach_session_return_code {
 	LTTNG_VIEWER_DETACH_SESSION_ERR = 3,
 };
 
+enum lttng_viewer_set_channel_filter_return_code {
+	LTTNG_VIEWER_SET_CHANNEL_FILTER_OK = 1,
+	LTTNG_VIEWER_SET_CHANNEL_FILTER_ERR = 2, /* Invalid filter or no viewer session. */
+};
+
+enum lttng_viewer_get_next_indexes_return_code {
+	LTTNG_VIEWER_GET_NEXT_INDEXES_OK = 1,
+	LTTNG_VIEWER_GET_NEXT_INDEXES_UNK = 2, /* The session is unknown or not attached. */
+	LTTNG_VIEWER_GET_NEXT_INDEXES_ERR = 3,
+};
+
+/* Flags of get_next_indexes requests. */
+enum {
+	/* Leave out the streams whose next index is not yet available. */
+	LTTNG_VIEWER_GET_NEXT_INDEXES_FLAG_SKIP_RETRY = (1 << 0),
+};
+
+/* Flags of list_sessions_filtered requests. */
+enum {
+	/* Leave out the sessions which are not in live mode. */
+	LTTNG_VIEWER_LIST_SESSIONS_FLAG_LIVE_ONLY = (1 << 0),
+};
+
+/* Flags in reply to list_sessions_filtered. */
+enum {
+	/* The reply lists all the sessions rather than those changed since the generation. */
+	LTTNG_VIEWER_LIST_SESSIONS_FLAG_FULL = (1 << 0),
+};
+
 struct lttng_viewer_session {
 	uint64_t id;
 	uint32_t live_timer;
@@ -133,6 +245,17 @@ struct lttng_viewer_connect {
 	uint32_t type; /* enum lttng_viewer_connection_type */
 } LTTNG_PACKED;
 
+/*
+ * Optionally appended to struct lttng_viewer_connect by the viewers of
+ * protocol 2.14 or later, the `data_size` of the command header including
+ * it, with the LTTNG_VIEWER_CAPABILITY_* which the viewer supports. The relay
+ * daemon then appends it to its reply too, with the capabilities which it
+ * supports among them and which apply to the connection.
+ */
+struct lttng_viewer_connect_capabilities {
+	uint64_t capabilities;
+} LTTNG_PACKED;
+
 /*
  * LTTNG_VIEWER_LIST_SESSIONS payload.
  */
@@ -141,12 +264,41 @@ struct lttng_viewer_list_sessions {
 	char session_list[]; /* struct lttng_viewer_session */
 } LTTNG_PACKED;
 
+/*
+ * LTTNG_VIEWER_LIST_SESSIONS_FILTERED payload.
+ *
+ * List the sessions of `hostname`, or of all the hostnames if it is empty,
+ * whose name starts with `session_name_prefix`. Unless `since_generation` is
+ * 0, only the sessions changed since that generation, as returned by a
+ * previous reply with the same filters, are listed, and the sessions which
+ * were closed since then are listed by id. The reply has the
+ * LTTNG_VIEWER_LIST_SESSIONS_FLAG_FULL flag when it lists all the sessions
+ * instead, replacing the sessions which the viewer knows.
+ */
+struct lttng_viewer_list_sessions_filtered_request {
+	uint64_t since_generation;
+	uint32_t flags; /* LTTNG_VIEWER_LIST_SESSIONS_FLAG_LIVE_ONLY */
+	char hostname[LTTNG_VIEWER_HOST_NAME_MAX]; /* Null-terminated. */
+	char session_name_prefix[LTTNG_VIEWER_NAME_MAX]; /* Null-terminated. */
+} LTTNG_PACKED;
+
+struct lttng_viewer_list_sessions_filtered_response {
+	/* Generation of the listing, to send as `since_generation` to get the next changes. */
+	uint64_t generation;
+	uint32_t flags; /* LTTNG_VIEWER_LIST_SESSIONS_FLAG_FULL */
+	uint32_t sessions_count;
+	uint32_t closed_count;
+	/* `sessions_count` struct lttng_viewer_session, then `closed_count` session ids. */
+	char data[];
+} LTTNG_PACKED;
+
 /*
  * LTTNG_VIEWER_ATTACH_SESSION payload.
  */
 struct lttng_viewer_attach_session_request {
 	uint64_t session_id;
-	uint64_t offset; /* unused for now */
+	/* Timestamp of LTTNG_VIEWER_SEEK_TIMESTAMP, in cycles, unused otherwise. */
+	uint64_t offset;
 	uint32_t seek; /* enum lttng_viewer_seek */
 } LTTNG_PACKED;
 
@@ -177,6 +329,124 @@ struct lttng_viewer_index {
 	uint32_t flags; /* LTTNG_VIEWER_FLAG_* */
 } __attribute__((__packed__));
 
+/*
+ * Reply to LTTNG_VIEWER_GET_NEXT_MERGED_INDEX, which has no payload.
+ *
+ * The next index of the merged data streams of a viewer session of type
+ * LTTNG_VIEWER_SESSION_TYPE_MERGED, whose packet the viewer gets with
+ * LTTNG_VIEWER_GET_PACKET. The indexes are sent by increasing beginning
+ * timestamp: LTTNG_VIEWER_INDEX_OK is only replied once every data stream
+ * has its next index or is inactive since a later timestamp. Otherwise,
+ * `index` has the status LTTNG_VIEWER_INDEX_RETRY, LTTNG_VIEWER_INDEX_INACTIVE
+ * with the earliest timestamp at which a data stream can resume in
+ * `timestamp_end`, or LTTNG_VIEWER_INDEX_HUP once all the data streams are
+ * closed and their indexes sent.
+ */
+struct lttng_viewer_merged_index {
+	/* Stream of the index, valid if its status is LTTNG_VIEWER_INDEX_OK. */
+	uint64_t stream_id;
+	struct lttng_viewer_index index;
+} __attribute__((__packed__));
+
+/*
+ * LTTNG_VIEWER_SUBSCRIBE payload.
+ *
+ * Switch the connection to push mode: rather than answering requests, the
+ * relay daemon pushes a struct lttng_viewer_frame, followed by its payload,
+ * whenever the streams of the sessions attached to the viewer session have
+ * something new for the viewer: the metadata, the new streams, and the
+ * packets of each data stream as they are received, along with their index.
+ *
+ * Each data stream has a credit of `window` bytes of packets, which each
+ * packet pushed consumes, a packet larger than the remaining credit using
+ * it up. A stream whose credit is used up is not pushed until the viewer
+ * replenishes it with LTTNG_VIEWER_ADD_CREDIT, the only command accepted
+ * in push mode. The reply is a struct lttng_viewer_subscribe_response,
+ * sent before any frame.
+ */
+struct lttng_viewer_subscribe_request {
+	uint64_t window;
+} LTTNG_PACKED;
+
+struct lttng_viewer_subscribe_response {
+	/* enum lttng_viewer_subscribe_return_code */
+	uint32_t status;
+} LTTNG_PACKED;
+
+/*
+ * LTTNG_VIEWER_ADD_CREDIT payload, which has no reply.
+ *
+ * Let the relay daemon push `credit` more bytes of packets of a data stream.
+ */
+struct lttng_viewer_add_credit {
+	uint64_t stream_id;
+	uint64_t credit;
+} LTTNG_PACKED;
+
+struct lttng_viewer_frame {
+	/* enum lttng_viewer_frame_type */
+	uint32_t type;
+	/* Stream of the frame, or session of a LTTNG_VIEWER_FRAME_NEW_STREAMS frame. */
+	uint64_t id;
+	/* Bytes of the payload following the frame. */
+	uint64_t len;
+} LTTNG_PACKED;
+
+/*
+ * LTTNG_VIEWER_WAIT_NEXT_INDEX payload.
+ *
+ * As LTTNG_VIEWER_GET_NEXT_INDEX, except that rather than replying
+ * LTTNG_VIEWER_INDEX_RETRY or LTTNG_VIEWER_INDEX_INACTIVE right away, the
+ * relay daemon replies once the stream receives a new index or live beacon,
+ * or once `timeout_ms` expired. The reply is a struct lttng_viewer_index.
+ */
+struct lttng_viewer_wait_next_index {
+	uint64_t stream_id;
+	uint32_t timeout_ms;
+} LTTNG_PACKED;
+
+/*
+ * LTTNG_VIEWER_GET_NEXT_INDEXES payload.
+ *
+ * The reply holds the next index of every data stream of the session which
+ * was sent to the viewer, as LTTNG_VIEWER_GET_NEXT_INDEX would for each of
+ * them, in one round trip.
+ */
+struct lttng_viewer_get_next_indexes {
+	uint64_t session_id;
+	uint32_t flags; /* LTTNG_VIEWER_GET_NEXT_INDEXES_FLAG_* */
+} LTTNG_PACKED;
+
+struct lttng_viewer_next_indexes_response {
+	/* enum lttng_viewer_get_next_indexes_return_code */
+	uint32_t status;
+	uint32_t indexes_count;
+	/* struct lttng_viewer_index */
+	char index_list[];
+} LTTNG_PACKED;
+
+/*
+ * LTTNG_VIEWER_GET_NEXT_PACKETS payload.
+ *
+ * The reply holds up to `max_packets` next indexes of a data stream, as
+ * LTTNG_VIEWER_GET_NEXT_INDEX would return them one after the other, each
+ * index with the LTTNG_VIEWER_INDEX_OK status being followed by its packet,
+ * that is `packet_size` bits of the stream file from `offset`, in one round
+ * trip. The reply ends with the first index which doesn't have the
+ * LTTNG_VIEWER_INDEX_OK status, or with the index which has the
+ * LTTNG_VIEWER_FLAG_NEW_METADATA or LTTNG_VIEWER_FLAG_NEW_STREAM flag.
+ */
+struct lttng_viewer_get_next_packets {
+	uint64_t stream_id;
+	uint32_t max_packets;
+} LTTNG_PACKED;
+
+struct lttng_viewer_next_packets_response {
+	uint32_t packets_count; /* Count of indexes. */
+	/* struct lttng_viewer_index, each one followed by its packet, if any */
+	char packet_list[];
+} LTTNG_PACKED;
+
 /*
  * LTTNG_VIEWER_GET_PACKET payload.
  */
@@ -206,6 +476,30 @@ struct lttng_viewer_metadata_packet {
 	char data[];
 } LTTNG_PACKED;
 
+/*
+ * LTTNG_VIEWER_GET_COMPRESSED_METADATA payload.
+ *
+ * Same as LTTNG_VIEWER_GET_METADATA, except that the metadata may be sent
+ * compressed with one of the algorithms supported by the viewer. The relay
+ * daemon sends it uncompressed if it supports none of them or if the
+ * compression doesn't reduce its size.
+ */
+struct lttng_viewer_get_compressed_metadata {
+	uint64_t stream_id;
+	/* Mask of (1 << enum lttng_viewer_metadata_compression). */
+	uint32_t compressions;
+} LTTNG_PACKED;
+
+struct lttng_viewer_compressed_metadata_packet {
+	/* Size of `data`. */
+	uint64_t len;
+	/* Size of the metadata once decompressed. */
+	uint64_t uncompressed_len;
+	uint32_t status; /* enum lttng_viewer_get_metadata_return_code */
+	uint32_t compression; /* enum lttng_viewer_metadata_compression */
+	char data[];
+} LTTNG_PACKED;
+
 /*
  * LTTNG_VIEWER_GET_NEW_STREAMS payload.
  */
@@ -221,6 +515,15 @@ struct lttng_viewer_new_streams_response {
 	char stream_list[];
 } LTTNG_PACKED;
 
+/*
+ * Optional LTTNG_VIEWER_CREATE_SESSION payload, a viewer session of type
+ * LTTNG_VIEWER_SESSION_TYPE_STREAMS being created without it.
+ */
+struct lttng_viewer_create_session_request {
+	/* enum lttng_viewer_session_type */
+	uint32_t type;
+} LTTNG_PACKED;
+
 struct lttng_viewer_create_session_response {
 	/* enum lttng_viewer_create_session_return_code */
 	uint32_t status;
@@ -238,4 +541,22 @@ struct lttng_viewer_detach_session_response {
 	uint32_t status;
 } LTTNG_PACKED;
 
+/*
+ * LTTNG_VIEWER_SET_CHANNEL_FILTER payload.
+ *
+ * Restrict the data streams which are sent to the viewer session, when it
+ * attaches to a session or gets its new streams from then on, to those whose
+ * name (the channel name followed by the CPU number, e.g. `my_chan_0`)
+ * matches one of the comma-separated globbing patterns of `channels`. The
+ * metadata streams are always sent. An empty list removes the filter.
+ */
+struct lttng_viewer_set_channel_filter_request {
+	char channels[LTTNG_VIEWER_PATH_MAX]; /* Null-terminated. */
+} LTTNG_PACKED;
+
+struct lttng_viewer_set_channel_filter_response {
+	/* enum lttng_viewer_set_channel_filter_return_code */
+	uint32_t status;
+} LTTNG_PACKED;
+
 #endif /* LTTNG_VIEWER_ABI_H */
@@ -10,30 +10,46 @@
 
 #define _LGPL_SOURCE
 #include "backward-compatibility-group-by.hpp"
+#include "chunk-migrator.hpp"
 #include "cmd.hpp"
 #include "connection.hpp"
 #include "ctf-trace.hpp"
+#include "ephemeral-live.hpp"
+#include "fd-prefetcher.hpp"
+#include "forwarder.hpp"
 #include "health-relayd.hpp"
+#include "index-cache.hpp"
 #include "index.hpp"
+#include "ingest-limiter.hpp"
 #include "live.hpp"
+#include "metrics.hpp"
 #include "lttng-relayd.hpp"
+#include "memory-budget.hpp"
+#include "packet-cache.hpp"
+#include "rotation-worker.hpp"
 #include "session.hpp"
 #include "sessiond-trace-chunks.hpp"
+#include "stream-writer.hpp"
 #include "stream.hpp"
 #include "tcp_keep_alive.hpp"
 #include "testpoint.hpp"
 #include "tracefile-array.hpp"
 #include "utils.hpp"
 #include "version.hpp"
+#include "viewer-idle.hpp"
 #include "viewer-stream.hpp"
+#include "write-scheduler.hpp"
 
 #include <common/align.hpp>
+#include <common/alloc-stats.hpp>
+#include <common/async-log.hpp>
 #include <common/buffer-view.hpp>
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
 #include <common/compat/getenv.hpp>
 #include <common/compat/poll.hpp>
 #include <common/compat/socket.hpp>
+#include <common/crc32c.hpp>
 #include <common/daemonize.hpp>
 #include <common/defaults.hpp>
 #include <common/dynamic-buffer.hpp>
@@ -42,9 +58,11 @@
 #include <common/futex.hpp>
 #include <common/ini-config/ini-config.hpp>
 #include <common/path.hpp>
+#include <common/self-tracing/self-tracing.hpp>
 #include <common/sessiond-comm/inet.hpp>
 #include <common/sessiond-comm/relayd.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/slab-allocator.hpp>
 #include <common/string-utils/format.hpp>
 #include <common/urcu.hpp>
 #include <common/uri.hpp>
@@ -53,6 +71,7 @@
 #include <lttng/lttng.h>
 
 #include <algorithm>
+#include <vector>
 #include <ctype.h>
 #include <fcntl.h>
 #include <getopt.h>
@@ -65,6 +84,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/mount.h>
 #include <sys/resource.h>
@@ -110,7 +130,7 @@ int lttng_opt_mi; /* not static in error.h */
 #define NR_LTTNG_RELAY_READY 3
 static int lttng_relay_ready = NR_LTTNG_RELAY_READY;
 
-/* Size of receive buffer. */
+/* Initial size of the receive buffer of the data connections. */
 #define RECV_DATA_BUFFER_SIZE 65536
 
 static int recv_child_signal; /* Set to 1 when a SIGUSR1 signal is received. */
@@ -128,18 +148,29 @@ static int tracing_group_name_override;
 const char *const config_section_name = "relayd";
 
 /*
- * This pipe is used to inform the worker thread that a command is queued and
- * ready to be processed.
+ * A worker thread handles the connections it receives from the dispatcher
+ * thread through its connection pipe, each worker using its own poll set.
  */
-static int relay_conn_pipe[2] = { -1, -1 };
+struct relay_worker {
+	unsigned int id;
+	pthread_t thread;
+	/*
+	 * This pipe is used to inform the worker thread that a connection is
+	 * queued and ready to be processed.
+	 */
+	int conn_pipe[2];
+};
+
+static struct relay_worker *relay_workers;
+static unsigned int relay_worker_count = DEFAULT_RELAYD_WORKER_THREAD_COUNT;
 
 /* Shared between threads */
 static int dispatch_thread_exit;
 
 static pthread_t listener_thread;
 static pthread_t dispatcher_thread;
-static pthread_t worker_thread;
 static pthread_t health_thread;
+static pthread_t metrics_thread;
 
 /*
  * last_relay_stream_id_lock protects last_relay_stream_id increment
@@ -159,6 +190,26 @@ static struct relay_conn_queue relay_conn_queue;
 /* Cap of file desriptors to be in simultaneous use by the relay daemon. */
 static unsigned int lttng_opt_fd_pool_size = -1;
 
+/* Maximal size of the receive buffer, or splice pipe, of a data connection. */
+static uint64_t opt_data_recv_buffer_max_size = DEFAULT_RELAYD_DATA_RECV_BUFFER_MAX_SIZE;
+
+/* Size of the socket receive buffer (SO_RCVBUF) of the data connections, 0 for the default. */
+static int opt_data_socket_buffer_size;
+
+/* Writer threads of the data streams, see stream-writer.hpp. */
+static unsigned int opt_writer_thread_count = DEFAULT_RELAYD_WRITER_THREAD_COUNT;
+static uint64_t opt_writer_queue_size = DEFAULT_RELAYD_WRITER_QUEUE_SIZE;
+static unsigned int opt_rotation_thread_count = DEFAULT_RELAYD_ROTATION_THREAD_COUNT;
+
+/* Number of index entries of a stream written at once, see stream_write_index(). */
+unsigned int opt_index_buffer_count = DEFAULT_RELAYD_INDEX_BUFFER_COUNT;
+
+/* Bytes reserved at once ahead of the writes to the stream files, 0 when disabled. */
+uint64_t opt_preallocation_size;
+
+/* Skip the data packets and indexes received more than once, see stream_accept_packet(). */
+bool opt_deduplicate_packets;
+
 /* Global relay stream hash table. */
 struct lttng_ht *relay_streams_ht;
 
@@ -219,6 +270,180 @@ static struct option long_options[] = {
 		nullptr,
 		'\0',
 	},
+	{
+		"worker-threads",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"live-worker-threads",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"data-recv-buffer-size",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"data-socket-buffer-size",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"writer-threads",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"writer-queue-size",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"rotation-threads",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"fd-prefetch-interval",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"index-buffer-count",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"preallocation-size",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"deduplicate-packets",
+		0,
+		nullptr,
+		'\0',
+	},
+	{
+		"forward-url",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"forward-queue-size",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"session-rate-limit",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"session-round-budget",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"host-weight",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"memory-budget",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"live-packet-cache-size",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"live-index-cache-count",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"live-index-cache-grace-period",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"ephemeral-live",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"live-idle-timeout",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"max-throughput",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"max-write-iops",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"metrics-socket",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"archive-output",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"archive-command",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"archive-threads",
+		1,
+		nullptr,
+		'\0',
+	},
+	{
+		"archive-rate-limit",
+		1,
+		nullptr,
+		'\0',
+	},
 	{
 		"help",
 		0,
@@ -315,6 +540,242 @@ static int set_option(int opt, const char *arg, const char *optname)
 				goto end;
 			}
 			lttng_opt_fd_pool_size = (unsigned int) v;
+		} else if (!strcmp(optname, "worker-threads")) {
+			unsigned long v;
+
+			errno = 0;
+			v = strtoul(arg, nullptr, 0);
+			if (errno != 0 || !isdigit((unsigned char) arg[0]) || v == 0 ||
+			    v > DEFAULT_RELAYD_MAX_WORKER_THREAD_COUNT) {
+				ERR("Wrong value in --worker-threads parameter: %s "
+				    "(expecting 1 to %d)",
+				    arg,
+				    DEFAULT_RELAYD_MAX_WORKER_THREAD_COUNT);
+				ret = -1;
+				goto end;
+			}
+			relay_worker_count = (unsigned int) v;
+		} else if (!strcmp(optname, "live-worker-threads")) {
+			unsigned long v;
+
+			errno = 0;
+			v = strtoul(arg, nullptr, 0);
+			if (errno != 0 || !isdigit((unsigned char) arg[0]) || v == 0 ||
+			    v > DEFAULT_RELAYD_MAX_LIVE_WORKER_THREAD_COUNT) {
+				ERR("Wrong value in --live-worker-threads parameter: %s "
+				    "(expecting 1 to %d)",
+				    arg,
+				    DEFAULT_RELAYD_MAX_LIVE_WORKER_THREAD_COUNT);
+				ret = -1;
+				goto end;
+			}
+			relayd_live_set_worker_count((unsigned int) v);
+		} else if (!strcmp(optname, "data-recv-buffer-size")) {
+			uint64_t size;
+
+			if (utils_parse_size_suffix(arg, &size) || size < RECV_DATA_BUFFER_SIZE ||
+			    size > INT_MAX) {
+				ERR("Wrong value in --data-recv-buffer-size parameter: %s "
+				    "(expecting %d to %d bytes)",
+				    arg,
+				    RECV_DATA_BUFFER_SIZE,
+				    INT_MAX);
+				ret = -1;
+				goto end;
+			}
+			opt_data_recv_buffer_max_size = size;
+		} else if (!strcmp(optname, "data-socket-buffer-size")) {
+			uint64_t size;
+
+			if (utils_parse_size_suffix(arg, &size) || size == 0 || size > INT_MAX) {
+				ERR("Wrong value in --data-socket-buffer-size parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+			opt_data_socket_buffer_size = (int) size;
+		} else if (!strcmp(optname, "writer-threads")) {
+			unsigned long v;
+
+			errno = 0;
+			v = strtoul(arg, nullptr, 0);
+			if (errno != 0 || !isdigit((unsigned char) arg[0]) ||
+			    v > DEFAULT_RELAYD_MAX_WRITER_THREAD_COUNT) {
+				ERR("Wrong value in --writer-threads parameter: %s "
+				    "(expecting 0 to %d)",
+				    arg,
+				    DEFAULT_RELAYD_MAX_WRITER_THREAD_COUNT);
+				ret = -1;
+				goto end;
+			}
+			opt_writer_thread_count = (unsigned int) v;
+		} else if (!strcmp(optname, "writer-queue-size")) {
+			uint64_t size;
+
+			if (utils_parse_size_suffix(arg, &size) || size == 0) {
+				ERR("Wrong value in --writer-queue-size parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+			opt_writer_queue_size = size;
+		} else if (!strcmp(optname, "rotation-threads")) {
+			unsigned long v;
+
+			errno = 0;
+			v = strtoul(arg, nullptr, 0);
+			if (errno != 0 || !isdigit((unsigned char) arg[0]) ||
+			    v > DEFAULT_RELAYD_MAX_ROTATION_THREAD_COUNT) {
+				ERR("Wrong value in --rotation-threads parameter: %s "
+				    "(expecting 0 to %d)",
+				    arg,
+				    DEFAULT_RELAYD_MAX_ROTATION_THREAD_COUNT);
+				ret = -1;
+				goto end;
+			}
+			opt_rotation_thread_count = (unsigned int) v;
+		} else if (!strcmp(optname, "fd-prefetch-interval")) {
+			if (fd_prefetcher_set_interval(arg)) {
+				ERR("Wrong value in --fd-prefetch-interval parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "index-buffer-count")) {
+			unsigned long v;
+
+			errno = 0;
+			v = strtoul(arg, nullptr, 0);
+			if (errno != 0 || !isdigit((unsigned char) arg[0]) || v == 0 ||
+			    v > DEFAULT_RELAYD_MAX_INDEX_BUFFER_COUNT) {
+				ERR("Wrong value in --index-buffer-count parameter: %s "
+				    "(expecting 1 to %d)",
+				    arg,
+				    DEFAULT_RELAYD_MAX_INDEX_BUFFER_COUNT);
+				ret = -1;
+				goto end;
+			}
+			opt_index_buffer_count = (unsigned int) v;
+		} else if (!strcmp(optname, "preallocation-size")) {
+			uint64_t size;
+
+			if (utils_parse_size_suffix(arg, &size)) {
+				ERR("Wrong value in --preallocation-size parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+			opt_preallocation_size = size;
+		} else if (!strcmp(optname, "deduplicate-packets")) {
+			opt_deduplicate_packets = true;
+		} else if (!strcmp(optname, "forward-url")) {
+			if (forwarder_add_output(arg)) {
+				ERR("Wrong value in --forward-url parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "forward-queue-size")) {
+			uint64_t size;
+
+			if (utils_parse_size_suffix(arg, &size) || size == 0) {
+				ERR("Wrong value in --forward-queue-size parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+			forwarder_set_queue_size(size);
+		} else if (!strcmp(optname, "session-rate-limit")) {
+			if (ingest_limiter_set_rate(arg)) {
+				ERR("Wrong value in --session-rate-limit parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "session-round-budget")) {
+			if (ingest_limiter_set_round_budget(arg)) {
+				ERR("Wrong value in --session-round-budget parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "host-weight")) {
+			if (ingest_limiter_add_host_weight(arg)) {
+				ERR("Wrong value in --host-weight parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "memory-budget")) {
+			if (memory_budget_set_size(arg)) {
+				ERR("Wrong value in --memory-budget parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "live-packet-cache-size")) {
+			if (packet_cache_set_size(arg)) {
+				ERR("Wrong value in --live-packet-cache-size parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "live-index-cache-count")) {
+			if (index_cache_set_count(arg)) {
+				ERR("Wrong value in --live-index-cache-count parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "live-index-cache-grace-period")) {
+			if (index_cache_set_grace_period(arg)) {
+				ERR("Wrong value in --live-index-cache-grace-period parameter: %s",
+				    arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "ephemeral-live")) {
+			if (ephemeral_live_set_window(arg)) {
+				ERR("Wrong value in --ephemeral-live parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "live-idle-timeout")) {
+			if (viewer_idle_set_timeout(arg)) {
+				ERR("Wrong value in --live-idle-timeout parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "max-throughput")) {
+			if (write_scheduler_set_max_throughput(arg)) {
+				ERR("Wrong value in --max-throughput parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "max-write-iops")) {
+			if (write_scheduler_set_max_iops(arg)) {
+				ERR("Wrong value in --max-write-iops parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "metrics-socket")) {
+			if (relay_metrics_set_socket_path(arg)) {
+				ERR("Wrong value in --metrics-socket parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "archive-output")) {
+			if (chunk_migrator_set_archive_output(arg)) {
+				ERR("Wrong value in --archive-output parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "archive-command")) {
+			if (chunk_migrator_set_archive_command(arg)) {
+				ERR("Wrong value in --archive-command parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "archive-threads")) {
+			if (chunk_migrator_set_thread_count(arg)) {
+				ERR("Wrong value in --archive-threads parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "archive-rate-limit")) {
+			if (chunk_migrator_set_rate(arg)) {
+				ERR("Wrong value in --archive-rate-limit parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
 		} else {
 			fprintf(stderr, "unknown option %s", optname);
 			if (arg) {
@@ -768,6 +1229,8 @@ static void untrack_stdio()
 static void relayd_cleanup()
 {
 	print_global_objects();
+	lttng::slab_allocator::log_all_stats();
+	lttng::alloc_stats::log_all();
 
 	DBG("Cleaning up");
 
@@ -777,9 +1240,11 @@ static void relayd_cleanup()
 		lttng_ht_destroy(relay_streams_ht);
 	if (sessions_ht)
 		lttng_ht_destroy(sessions_ht);
+	session_hosts_fini();
 
 	free(opt_output_path);
 	free(opt_working_directory);
+	free(relay_workers);
 
 	if (health_relayd) {
 		health_app_destroy(health_relayd);
@@ -808,6 +1273,8 @@ static void relayd_cleanup()
 	if (tracing_group_name_override) {
 		free((void *) tracing_group_name);
 	}
+
+	lttng_async_log_fini();
 }
 
 static int notify_health_quit_pipe(int *pipe)
@@ -1096,6 +1563,20 @@ static void *relay_thread_listener(void *data __attribute__((unused)))
 		goto error_sock_relay;
 	}
 
+	/*
+	 * The accepted data connections inherit the receive buffer size of the
+	 * listening socket, which also determines their TCP window scale.
+	 */
+	if (opt_data_socket_buffer_size &&
+	    setsockopt(data_sock->fd,
+		       SOL_SOCKET,
+		       SO_RCVBUF,
+		       &opt_data_socket_buffer_size,
+		       sizeof(opt_data_socket_buffer_size))) {
+		PERROR("Failed to set the receive buffer size of the data socket: size = %d",
+		       opt_data_socket_buffer_size);
+	}
+
 	/*
 	 * Pass 3 as size here for the thread quit pipe, control and
 	 * data socket.
@@ -1279,6 +1760,8 @@ static void *relay_thread_dispatcher(void *data __attribute__((unused)))
 	ssize_t ret;
 	struct cds_wfcq_node *node;
 	struct relay_connection *new_conn = nullptr;
+	unsigned int next_worker = 0;
+	struct relay_worker *worker;
 
 	DBG("[thread] Relay dispatcher started");
 
@@ -1313,7 +1796,17 @@ static void *relay_thread_dispatcher(void *data __attribute__((unused)))
 			}
 			new_conn = lttng::utils::container_of(node, &relay_connection::qnode);
 
-			DBG("Dispatching request waiting on sock %d", new_conn->sock->fd);
+			/*
+			 * The session of a connection is only known once it
+			 * issued its first commands: spread the connections
+			 * across the workers in a round-robin fashion.
+			 */
+			worker = &relay_workers[next_worker];
+			next_worker = (next_worker + 1) % relay_worker_count;
+
+			DBG("Dispatching request waiting on sock %d to worker %u",
+			    new_conn->sock->fd,
+			    worker->id);
 
 			/*
 			 * Inform worker thread of the new request. This
@@ -1321,13 +1814,9 @@ static void *relay_thread_dispatcher(void *data __attribute__((unused)))
 			 * the data will be read at some point in time
 			 * or wait to the end of the world :)
 			 */
-			ret = lttng_write(
-				relay_conn_pipe[1], &new_conn, sizeof(new_conn)); /* NOLINT
-										     sizeof
-										     used
-										     on a
-										     pointer.
-										   */
+			ret = lttng_write(worker->conn_pipe[1],
+					  &new_conn,
+					  sizeof(new_conn)); /* NOLINT sizeof used on a pointer. */
 			if (ret < 0) {
 				PERROR("write connection pipe");
 				connection_put(new_conn);
@@ -1356,11 +1845,6 @@ error_testpoint:
 	return nullptr;
 }
 
-static bool session_streams_have_index(const struct relay_session *session)
-{
-	return session->minor >= 4 && !session->snapshot;
-}
-
 /*
  * Handle the RELAYD_CREATE_SESSION command.
  *
@@ -1451,6 +1935,8 @@ static int relay_create_session(const struct lttcomm_relayd_hdr *recv_hdr __attr
 	LTTNG_ASSERT(!conn->session);
 	conn->session = session;
 	DBG("Created session %" PRIu64, session->id);
+	forwarder_create_session(session,
+				 current_chunk_id.is_set ? &current_chunk_id.value : nullptr);
 
 	reply.generic.session_id = htobe64(session->id);
 
@@ -1679,6 +2165,10 @@ static int relay_add_stream(const struct lttcomm_relayd_hdr *recv_hdr __attribut
 	 */
 	ctf_trace_put(trace);
 
+	if (stream && stream_chunk_id.is_set) {
+		forwarder_add_stream(stream, stream_chunk_id.value);
+	}
+
 send_reply:
 	memset(&reply, 0, sizeof(reply));
 	reply.handle = htobe64(stream_handle);
@@ -1747,6 +2237,7 @@ static int relay_close_stream(const struct lttcomm_relayd_hdr *recv_hdr __attrib
 	pthread_mutex_lock(&stream->lock);
 	stream->last_net_seq_num = stream_info.last_net_seq_num;
 	pthread_mutex_unlock(&stream->lock);
+	forwarder_close_stream(stream, stream_info.last_net_seq_num);
 
 	/*
 	 * This is one of the conditions which may trigger a stream close
@@ -1838,6 +2329,8 @@ static int relay_reset_metadata(const struct lttcomm_relayd_hdr *recv_hdr __attr
 		    stream->channel_name);
 		goto end_unlock;
 	}
+
+	forwarder_reset_metadata(stream, stream_info.version);
 end_unlock:
 	pthread_mutex_unlock(&stream->lock);
 	stream_put(stream);
@@ -1958,6 +2451,9 @@ static int relay_recv_metadata(const struct lttcomm_relayd_hdr *recv_hdr,
 		ret = -1;
 		goto end_put;
 	}
+
+	forwarder_send_metadata(
+		metadata_stream, &packet_view, metadata_payload_header.padding_size);
 end_put:
 	stream_put(metadata_stream);
 end:
@@ -2027,12 +2523,157 @@ static int relay_send_version(const struct lttcomm_relayd_hdr *recv_hdr __attrib
 		goto end;
 	}
 
+	/* See relayd_version_check(). */
+	(void) lttcomm_sock_set_low_latency(conn->sock);
+
 	DBG("Version check done using protocol %u.%u", conn->major, conn->minor);
 
 end:
 	return ret;
 }
 
+/*
+ * Sequence number up to which the data of a stream, and its index when the
+ * session has indexes, has been received.
+ *
+ * The stream lock must be held by the caller.
+ */
+static uint64_t stream_received_seq(const struct relay_session *session,
+				    const struct relay_stream *stream)
+{
+	if (session_streams_have_index(session)) {
+		/*
+		 * Ensure that both the index and stream data have been
+		 * flushed up to the requested point.
+		 */
+		return std::min(stream->prev_data_seq, stream->prev_index_seq);
+	}
+
+	return stream->prev_data_seq;
+}
+
+/*
+ * Check whether the data of a stream is pending, that is, whether it was not
+ * received up to `last_net_seq_num`, the sequence number of the last packet
+ * sent by the consumer.
+ *
+ * Return 1 if data is pending, 0 if not, or a negative value on error.
+ */
+static int stream_check_data_pending(const struct relay_session *session,
+				     struct relay_stream *stream,
+				     uint64_t last_net_seq_num)
+{
+	int ret;
+	uint64_t stream_seq;
+
+	pthread_mutex_lock(&stream->lock);
+	stream_seq = stream_received_seq(session, stream);
+	DBG("Data pending for stream id %" PRIu64 ": prev_data_seq %" PRIu64
+	    ", prev_index_seq %" PRIu64 ", and last_seq %" PRIu64,
+	    stream->stream_handle,
+	    stream->prev_data_seq,
+	    stream->prev_index_seq,
+	    last_net_seq_num);
+
+	/* Avoid wrapping issue */
+	if (((int64_t) (stream_seq - last_net_seq_num)) >= 0) {
+		/* Data has in fact been written and is NOT pending */
+		ret = stream_flush_index_buffer(stream) ? -1 : 0;
+	} else {
+		/* Data still being streamed thus pending */
+		ret = 1;
+	}
+
+	stream->data_pending_check_done = true;
+	pthread_mutex_unlock(&stream->lock);
+	return ret;
+}
+
+/*
+ * Mark a metadata stream as checked: every command and data received on the
+ * control socket before the check has been handled.
+ */
+static void stream_set_quiescent(struct relay_stream *stream)
+{
+	pthread_mutex_lock(&stream->lock);
+	stream->data_pending_check_done = true;
+	(void) stream_flush_index_buffer(stream);
+	pthread_mutex_unlock(&stream->lock);
+}
+
+/*
+ * Clear the data_pending_check_done flag of all the streams of a session.
+ *
+ * For now, the streams are indexed by stream handle so we have to iterate over
+ * all streams to find the ones associated with the right session_id.
+ */
+static void session_begin_data_pending(uint64_t session_id)
+{
+	struct lttng_ht_iter iter;
+	struct relay_stream *stream;
+	lttng::urcu::read_lock_guard read_lock;
+
+	cds_lfht_for_each_entry (relay_streams_ht->ht, &iter.iter, stream, node.node) {
+		if (!stream_get(stream)) {
+			continue;
+		}
+
+		if (stream->trace->session->id == session_id) {
+			pthread_mutex_lock(&stream->lock);
+			stream->data_pending_check_done = false;
+			pthread_mutex_unlock(&stream->lock);
+			DBG("Set begin data pending flag to stream %" PRIu64,
+			    stream->stream_handle);
+		}
+
+		stream_put(stream);
+	}
+}
+
+/*
+ * Check whether a stream of a session which was not checked since
+ * session_begin_data_pending() still has data in flight: the consumer lost
+ * track of the stream but its data is still being streamed.
+ */
+static bool session_has_data_inflight(const struct relay_session *session, uint64_t session_id)
+{
+	struct lttng_ht_iter iter;
+	struct relay_stream *stream;
+	bool is_data_inflight = false;
+	lttng::urcu::read_lock_guard read_lock;
+
+	cds_lfht_for_each_entry (relay_streams_ht->ht, &iter.iter, stream, node.node) {
+		if (!stream_get(stream)) {
+			continue;
+		}
+
+		if (stream->trace->session->id != session_id) {
+			stream_put(stream);
+			continue;
+		}
+
+		pthread_mutex_lock(&stream->lock);
+		if (!stream->data_pending_check_done) {
+			const uint64_t stream_seq = stream_received_seq(session, stream);
+
+			if (!stream->closed ||
+			    !(((int64_t) (stream_seq - stream->last_net_seq_num)) >= 0)) {
+				is_data_inflight = true;
+				DBG("Data is still in flight for stream %" PRIu64,
+				    stream->stream_handle);
+			}
+		}
+
+		pthread_mutex_unlock(&stream->lock);
+		stream_put(stream);
+		if (is_data_inflight) {
+			break;
+		}
+	}
+
+	return is_data_inflight;
+}
+
 /*
  * Check for data pending for a given stream id from the session daemon.
  */
@@ -2046,7 +2687,6 @@ static int relay_data_pending(const struct lttcomm_relayd_hdr *recv_hdr __attrib
 	struct relay_stream *stream;
 	ssize_t send_ret;
 	int ret;
-	uint64_t stream_seq;
 
 	DBG("Data pending command received");
 
@@ -2073,36 +2713,7 @@ static int relay_data_pending(const struct lttcomm_relayd_hdr *recv_hdr __attrib
 		goto end;
 	}
 
-	pthread_mutex_lock(&stream->lock);
-
-	if (session_streams_have_index(session)) {
-		/*
-		 * Ensure that both the index and stream data have been
-		 * flushed up to the requested point.
-		 */
-		stream_seq = std::min(stream->prev_data_seq, stream->prev_index_seq);
-	} else {
-		stream_seq = stream->prev_data_seq;
-	}
-	DBG("Data pending for stream id %" PRIu64 ": prev_data_seq %" PRIu64
-	    ", prev_index_seq %" PRIu64 ", and last_seq %" PRIu64,
-	    msg.stream_id,
-	    stream->prev_data_seq,
-	    stream->prev_index_seq,
-	    msg.last_net_seq_num);
-
-	/* Avoid wrapping issue */
-	if (((int64_t) (stream_seq - msg.last_net_seq_num)) >= 0) {
-		/* Data has in fact been written and is NOT pending */
-		ret = 0;
-	} else {
-		/* Data still being streamed thus pending */
-		ret = 1;
-	}
-
-	stream->data_pending_check_done = true;
-	pthread_mutex_unlock(&stream->lock);
-
+	ret = stream_check_data_pending(session, stream, msg.last_net_seq_num);
 	stream_put(stream);
 end:
 
@@ -2159,9 +2770,7 @@ static int relay_quiescent_control(const struct lttcomm_relayd_hdr *recv_hdr
 	if (!stream) {
 		goto reply;
 	}
-	pthread_mutex_lock(&stream->lock);
-	stream->data_pending_check_done = true;
-	pthread_mutex_unlock(&stream->lock);
+	stream_set_quiescent(stream);
 
 	DBG("Relay quiescent control pending flag set to %" PRIu64, msg.stream_id);
 	stream_put(stream);
@@ -2193,10 +2802,8 @@ static int relay_begin_data_pending(const struct lttcomm_relayd_hdr *recv_hdr,
 {
 	int ret;
 	ssize_t send_ret;
-	struct lttng_ht_iter iter;
 	struct lttcomm_relayd_begin_data_pending msg;
 	struct lttcomm_relayd_generic_reply reply;
-	struct relay_stream *stream;
 
 	LTTNG_ASSERT(recv_hdr);
 	LTTNG_ASSERT(conn);
@@ -2219,31 +2826,7 @@ static int relay_begin_data_pending(const struct lttcomm_relayd_hdr *recv_hdr,
 	memcpy(&msg, payload->data, sizeof(msg));
 	msg.session_id = be64toh(msg.session_id);
 
-	/*
-	 * Iterate over all streams to set the begin data pending flag.
-	 * For now, the streams are indexed by stream handle so we have
-	 * to iterate over all streams to find the one associated with
-	 * the right session_id.
-	 */
-	{
-		lttng::urcu::read_lock_guard read_lock;
-
-		cds_lfht_for_each_entry (relay_streams_ht->ht, &iter.iter, stream, node.node) {
-			if (!stream_get(stream)) {
-				continue;
-			}
-
-			if (stream->trace->session->id == msg.session_id) {
-				pthread_mutex_lock(&stream->lock);
-				stream->data_pending_check_done = false;
-				pthread_mutex_unlock(&stream->lock);
-				DBG("Set begin data pending flag to stream %" PRIu64,
-				    stream->stream_handle);
-			}
-
-			stream_put(stream);
-		}
-	}
+	session_begin_data_pending(msg.session_id);
 
 	memset(&reply, 0, sizeof(reply));
 	/* All good, send back reply. */
@@ -2276,94 +2859,185 @@ static int relay_end_data_pending(const struct lttcomm_relayd_hdr *recv_hdr __at
 {
 	int ret;
 	ssize_t send_ret;
-	struct lttng_ht_iter iter;
 	struct lttcomm_relayd_end_data_pending msg;
 	struct lttcomm_relayd_generic_reply reply;
-	struct relay_stream *stream;
-	uint32_t is_data_inflight = 0;
+	uint32_t is_data_inflight;
+
+	DBG("End data pending command");
+
+	if (!conn->session || !conn->version_check_done) {
+		ERR("Trying to check for data before version check");
+		ret = -1;
+		goto end_no_session;
+	}
+
+	if (payload->size < sizeof(msg)) {
+		ERR("Unexpected payload size in \"relay_end_data_pending\": expected >= %zu bytes, got %zu bytes",
+		    sizeof(msg),
+		    payload->size);
+		ret = -1;
+		goto end_no_session;
+	}
+	memcpy(&msg, payload->data, sizeof(msg));
+	msg.session_id = be64toh(msg.session_id);
+
+	is_data_inflight = session_has_data_inflight(conn->session, msg.session_id) ? 1 : 0;
+
+	memset(&reply, 0, sizeof(reply));
+	/* All good, send back reply. */
+	reply.ret_code = htobe32(is_data_inflight);
+
+	send_ret = conn->sock->ops->sendmsg(conn->sock, &reply, sizeof(reply), 0);
+	if (send_ret < (ssize_t) sizeof(reply)) {
+		ERR("Failed to send \"end data pending\" command reply (ret = %zd)", send_ret);
+		ret = -1;
+	} else {
+		ret = 0;
+	}
+
+end_no_session:
+	return ret;
+}
+
+/*
+ * Check for data pending for all the streams of a session in a single command
+ * (2.14+): the begin data pending, data pending or quiescent control of each
+ * stream, and end data pending sequence of the older peers.
+ *
+ * Return to the client 1 if data is pending, 0 if not, or a negative value on
+ * error with a ret_code.
+ */
+static int relay_session_data_pending(const struct lttcomm_relayd_hdr *recv_hdr
+				      __attribute__((unused)),
+				      struct relay_connection *conn,
+				      const struct lttng_buffer_view *payload)
+{
+	int ret;
+	int32_t data_pending = 0;
+	ssize_t send_ret;
+	uint32_t i, stream_count;
+	uint64_t session_id;
+	struct relay_session *session = conn->session;
+	struct lttcomm_relayd_generic_reply reply = {};
+	struct lttng_buffer_view header_view, streams_view;
+	const struct lttcomm_relayd_session_data_pending *header;
+
+	DBG("Session data pending command received");
+
+	if (!session || !conn->version_check_done) {
+		ERR("Trying to check for data before version check");
+		ret = -1;
+		goto end_no_reply;
+	}
 
-	DBG("End data pending command");
+	if (session->major == 2 && session->minor < 14) {
+		ERR("Unsupported feature before 2.14");
+		ret = -1;
+		goto end_no_reply;
+	}
 
-	if (!conn->session || !conn->version_check_done) {
-		ERR("Trying to check for data before version check");
+	header_view = lttng_buffer_view_from_view(
+		payload, 0, sizeof(struct lttcomm_relayd_session_data_pending));
+	if (!lttng_buffer_view_is_valid(&header_view)) {
+		ERR("Failed to receive payload of \"session data pending\" command");
 		ret = -1;
-		goto end_no_session;
+		goto end_no_reply;
 	}
 
-	if (payload->size < sizeof(msg)) {
-		ERR("Unexpected payload size in \"relay_end_data_pending\": expected >= %zu bytes, got %zu bytes",
-		    sizeof(msg),
-		    payload->size);
+	header = (const struct lttcomm_relayd_session_data_pending *) header_view.data;
+	session_id = be64toh(header->session_id);
+	stream_count = be32toh(header->stream_count);
+	streams_view = lttng_buffer_view_from_view(payload, header_view.size, -1);
+	if (stream_count > 0 &&
+	    (!streams_view.data ||
+	     streams_view.size <
+		     (uint64_t) stream_count *
+			     sizeof(struct lttcomm_relayd_session_data_pending_stream))) {
+		ERR("Unexpected payload size in \"relay_session_data_pending\": %" PRIu32
+		    " streams in %zu bytes",
+		    stream_count,
+		    (size_t) streams_view.size);
 		ret = -1;
-		goto end_no_session;
+		goto end_no_reply;
 	}
-	memcpy(&msg, payload->data, sizeof(msg));
-	msg.session_id = be64toh(msg.session_id);
 
-	/*
-	 * Iterate over all streams to see if the begin data pending
-	 * flag is set.
-	 */
-	{
-		lttng::urcu::read_lock_guard read_lock;
+	session_begin_data_pending(session_id);
 
-		cds_lfht_for_each_entry (relay_streams_ht->ht, &iter.iter, stream, node.node) {
-			if (!stream_get(stream)) {
-				continue;
-			}
+	for (i = 0; i < stream_count; i++) {
+		struct lttcomm_relayd_session_data_pending_stream stream_info;
+		struct relay_stream *stream;
 
-			if (stream->trace->session->id != msg.session_id) {
+		memcpy(&stream_info,
+		       streams_view.data + i * sizeof(stream_info),
+		       sizeof(stream_info));
+		stream = stream_get_by_id(be64toh(stream_info.stream_id));
+		if (stream_info.is_metadata) {
+			if (stream) {
+				stream_set_quiescent(stream);
 				stream_put(stream);
-				continue;
 			}
 
-			pthread_mutex_lock(&stream->lock);
-			if (!stream->data_pending_check_done) {
-				uint64_t stream_seq;
-
-				if (session_streams_have_index(conn->session)) {
-					/*
-					 * Ensure that both the index and stream data have been
-					 * flushed up to the requested point.
-					 */
-					stream_seq = std::min(stream->prev_data_seq,
-							      stream->prev_index_seq);
-				} else {
-					stream_seq = stream->prev_data_seq;
-				}
+			continue;
+		}
 
-				if (!stream->closed ||
-				    !(((int64_t) (stream_seq - stream->last_net_seq_num)) >= 0)) {
-					is_data_inflight = 1;
-					DBG("Data is still in flight for stream %" PRIu64,
-					    stream->stream_handle);
-					pthread_mutex_unlock(&stream->lock);
-					stream_put(stream);
-					break;
-				}
-			}
+		if (!stream) {
+			data_pending = -1;
+			goto reply;
+		}
 
-			pthread_mutex_unlock(&stream->lock);
-			stream_put(stream);
+		data_pending = stream_check_data_pending(
+			session, stream, be64toh(stream_info.last_net_seq_num));
+		stream_put(stream);
+		if (data_pending != 0) {
+			goto reply;
 		}
 	}
 
-	memset(&reply, 0, sizeof(reply));
-	/* All good, send back reply. */
-	reply.ret_code = htobe32(is_data_inflight);
-
+	data_pending = session_has_data_inflight(session, session_id) ? 1 : 0;
+reply:
+	DBG("Session data pending: session id = %" PRIu64 ", stream count = %" PRIu32
+	    ", data pending = %" PRId32,
+	    session_id,
+	    stream_count,
+	    data_pending);
+	reply.ret_code = htobe32((uint32_t) data_pending);
 	send_ret = conn->sock->ops->sendmsg(conn->sock, &reply, sizeof(reply), 0);
 	if (send_ret < (ssize_t) sizeof(reply)) {
-		ERR("Failed to send \"end data pending\" command reply (ret = %zd)", send_ret);
+		ERR("Failed to send \"session data pending\" command reply (ret = %zd)",
+		    send_ret);
 		ret = -1;
 	} else {
 		ret = 0;
 	}
 
-end_no_session:
+end_no_reply:
 	return ret;
 }
 
+/*
+ * Convert an index received from the consumer to host byte order.
+ */
+static void relay_index_info_to_host(const struct relay_connection *conn,
+				     struct lttcomm_relayd_index *index_info)
+{
+	index_info->relay_stream_id = be64toh(index_info->relay_stream_id);
+	index_info->net_seq_num = be64toh(index_info->net_seq_num);
+	index_info->packet_size = be64toh(index_info->packet_size);
+	index_info->content_size = be64toh(index_info->content_size);
+	index_info->timestamp_begin = be64toh(index_info->timestamp_begin);
+	index_info->timestamp_end = be64toh(index_info->timestamp_end);
+	index_info->events_discarded = be64toh(index_info->events_discarded);
+	index_info->stream_id = be64toh(index_info->stream_id);
+
+	if (conn->minor >= 8) {
+		index_info->stream_instance_id = be64toh(index_info->stream_instance_id);
+		index_info->packet_seq_num = be64toh(index_info->packet_seq_num);
+	} else {
+		index_info->stream_instance_id = -1ULL;
+		index_info->packet_seq_num = -1ULL;
+	}
+}
+
 /*
  * Receive an index for a specific stream.
  *
@@ -2401,22 +3075,7 @@ static int relay_recv_index(const struct lttcomm_relayd_hdr *recv_hdr __attribut
 		goto end_no_session;
 	}
 	memcpy(&index_info, payload->data, msg_len);
-	index_info.relay_stream_id = be64toh(index_info.relay_stream_id);
-	index_info.net_seq_num = be64toh(index_info.net_seq_num);
-	index_info.packet_size = be64toh(index_info.packet_size);
-	index_info.content_size = be64toh(index_info.content_size);
-	index_info.timestamp_begin = be64toh(index_info.timestamp_begin);
-	index_info.timestamp_end = be64toh(index_info.timestamp_end);
-	index_info.events_discarded = be64toh(index_info.events_discarded);
-	index_info.stream_id = be64toh(index_info.stream_id);
-
-	if (conn->minor >= 8) {
-		index_info.stream_instance_id = be64toh(index_info.stream_instance_id);
-		index_info.packet_seq_num = be64toh(index_info.packet_seq_num);
-	} else {
-		index_info.stream_instance_id = -1ULL;
-		index_info.packet_seq_num = -1ULL;
-	}
+	relay_index_info_to_host(conn, &index_info);
 
 	stream = stream_get_by_id(index_info.relay_stream_id);
 	if (!stream) {
@@ -2432,6 +3091,8 @@ static int relay_recv_index(const struct lttcomm_relayd_hdr *recv_hdr __attribut
 		goto end_stream_put;
 	}
 
+	forwarder_add_index(stream, &index_info);
+
 end_stream_put:
 	stream_put(stream);
 end:
@@ -2451,6 +3112,109 @@ end_no_session:
 	return ret;
 }
 
+/*
+ * Receive a batch of indexes, possibly of different streams (2.14+).
+ *
+ * Return 0 on success else a negative value.
+ */
+static int relay_recv_indexes(const struct lttcomm_relayd_hdr *recv_hdr __attribute__((unused)),
+			      struct relay_connection *conn,
+			      const struct lttng_buffer_view *payload)
+{
+	int ret = 0;
+	uint32_t i, index_count;
+	ssize_t send_ret;
+	enum lttng_error_code reply_code = LTTNG_ERR_UNK;
+	struct relay_session *session = conn->session;
+	struct lttcomm_relayd_generic_reply reply = {};
+	struct lttng_buffer_view header_view, indexes_view;
+
+	if (!session || !conn->version_check_done) {
+		ERR("Trying to send indexes before version check");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	if (session->major == 2 && session->minor < 14) {
+		ERR("Unsupported feature before 2.14");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	header_view = lttng_buffer_view_from_view(
+		payload, 0, sizeof(struct lttcomm_relayd_send_indexes));
+	if (!lttng_buffer_view_is_valid(&header_view)) {
+		ERR("Failed to receive payload of \"send indexes\" command");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	index_count = be32toh(((const struct lttcomm_relayd_send_indexes *) header_view.data)
+				      ->index_count);
+	indexes_view = lttng_buffer_view_from_view(payload, header_view.size, -1);
+	if (!indexes_view.data ||
+	    indexes_view.size < (uint64_t) index_count * sizeof(struct lttcomm_relayd_index)) {
+		reply_code = LTTNG_ERR_INVALID_PROTOCOL;
+		ret = -1;
+		goto end;
+	}
+
+	DBG("Relay receiving %" PRIu32 " indexes", index_count);
+
+	for (i = 0; i < index_count; i++) {
+		struct lttcomm_relayd_index index_info;
+		struct relay_stream *stream;
+
+		memcpy(&index_info,
+		       indexes_view.data + i * sizeof(index_info),
+		       sizeof(index_info));
+		relay_index_info_to_host(conn, &index_info);
+
+		stream = stream_get_by_id(index_info.relay_stream_id);
+		if (!stream) {
+			ERR("stream_get_by_id not found");
+			reply_code = LTTNG_ERR_INVALID;
+			ret = -1;
+			goto end;
+		}
+
+		pthread_mutex_lock(&stream->lock);
+		/*
+		 * Batched live beacons are sent after the consumer sampled its
+		 * streams: drop the ones overtaken by an index of the stream.
+		 */
+		if (index_info.packet_size == 0 && stream->prev_index_seq != -1ULL &&
+		    (index_info.net_seq_num == -1ULL ||
+		     index_info.net_seq_num < stream->prev_index_seq)) {
+			DBG("Dropping stale live beacon for stream %" PRIu64,
+			    stream->stream_handle);
+			ret = 0;
+		} else {
+			ret = stream_add_index(stream, &index_info);
+			if (!ret) {
+				forwarder_add_index(stream, &index_info);
+			}
+		}
+		pthread_mutex_unlock(&stream->lock);
+		stream_put(stream);
+		if (ret) {
+			goto end;
+		}
+	}
+
+	reply_code = LTTNG_OK;
+	ret = 0;
+end:
+	reply.ret_code = htobe32((uint32_t) reply_code);
+	send_ret = conn->sock->ops->sendmsg(conn->sock, &reply, sizeof(reply), 0);
+	if (send_ret < (ssize_t) sizeof(reply)) {
+		ERR("Failed to send \"send indexes\" command reply (ret = %zd)", send_ret);
+		ret = -1;
+	}
+end_no_reply:
+	return ret;
+}
+
 /*
  * Receive the streams_sent message.
  *
@@ -2479,6 +3243,7 @@ static int relay_streams_sent(const struct lttcomm_relayd_hdr *recv_hdr __attrib
 	 * now ready to be used by the viewer.
 	 */
 	publish_connection_local_streams(conn);
+	forwarder_streams_sent(conn->session);
 
 	memset(&reply, 0, sizeof(reply));
 	reply.ret_code = htobe32(LTTNG_OK);
@@ -2633,6 +3398,7 @@ static int relay_rotate_session_streams(const struct lttcomm_relayd_hdr *recv_hd
 	char chunk_id_buf[MAX_INT_DEC_LEN(uint64_t)];
 	const char *chunk_id_str = "none";
 	ssize_t header_len;
+	uint64_t rotation_begin_ns, new_chunk_id;
 
 	if (!session || !conn->version_check_done) {
 		ERR("Trying to rotate a stream before version check");
@@ -2703,6 +3469,7 @@ static int relay_rotate_session_streams(const struct lttcomm_relayd_hdr *recv_hd
 		goto end;
 	}
 
+	rotation_begin_ns = relay_metrics_begin_duration();
 	for (i = 0; i < rotate_streams.stream_count; i++) {
 		struct lttcomm_relayd_stream_rotation_position *position_comm =
 			&((typeof(position_comm)) stream_positions.data)[i];
@@ -2730,6 +3497,13 @@ static int relay_rotate_session_streams(const struct lttcomm_relayd_hdr *recv_hd
 		stream = nullptr;
 	}
 
+	relay_metrics_record_duration(RELAY_METRICS_DURATION_ROTATION, rotation_begin_ns);
+	new_chunk_id = rotate_streams.new_chunk_id.value;
+	forwarder_rotate_streams(session,
+				 rotate_streams.new_chunk_id.is_set ? &new_chunk_id : nullptr,
+				 rotate_streams.stream_count,
+				 (const struct lttcomm_relayd_stream_rotation_position *)
+					 stream_positions.data);
 	reply_code = LTTNG_OK;
 	ret = 0;
 end:
@@ -2823,6 +3597,13 @@ static int relay_create_trace_chunk(const struct lttcomm_relayd_hdr *recv_hdr
 		goto end;
 	}
 	lttng_trace_chunk_set_fd_tracker(chunk, the_fd_tracker);
+	if (ephemeral_live_session(session) &&
+	    lttng_trace_chunk_set_memory_files(chunk) != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		ERR("Failed to keep the files of an ephemeral live trace chunk in memory");
+		ret = -1;
+		reply_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
 
 	if (msg->override_name_length) {
 		const char *name;
@@ -2912,6 +3693,12 @@ static int relay_create_trace_chunk(const struct lttcomm_relayd_hdr *recv_hdr
 	if (!conn->session->pending_closure_trace_chunk) {
 		session->ongoing_rotation = false;
 	}
+
+	forwarder_create_trace_chunk(session,
+				     msg->chunk_id,
+				     msg->creation_timestamp,
+				     msg->override_name_length ? payload->data + sizeof(*msg) :
+								 nullptr);
 end:
 	pthread_mutex_unlock(&conn->session->lock);
 	reply.ret_code = htobe32((uint32_t) reply_code);
@@ -2930,6 +3717,23 @@ end_no_reply:
 /*
  * relay_close_trace_chunk: close a trace chunk
  */
+/*
+ * Release callback of the closed trace chunks, queuing their migration to
+ * the archive output.
+ */
+static void migrate_closed_trace_chunk(bool close_command_succeeded, void *data)
+{
+	char *path = (char *) data;
+
+	if (close_command_succeeded) {
+		(void) chunk_migrator_queue(path);
+	} else {
+		ERR("Not migrating trace chunk \"%s\": its close command failed", path);
+	}
+
+	free(path);
+}
+
 static int relay_close_trace_chunk(const struct lttcomm_relayd_hdr *recv_hdr
 				   __attribute__((unused)),
 				   struct relay_connection *conn,
@@ -3129,6 +3933,42 @@ static int relay_close_trace_chunk(const struct lttcomm_relayd_hdr *recv_hdr
 		goto end_unlock_session;
 	}
 
+	if (chunk_migrator_enabled() &&
+	    (!close_command.is_set ||
+	     close_command.value != LTTNG_TRACE_CHUNK_COMMAND_TYPE_DELETE)) {
+		char *migrated_path;
+		int fmt_ret;
+
+		/* Path at which the trace chunk is found once released. */
+		if (close_command.is_set &&
+		    close_command.value == LTTNG_TRACE_CHUNK_COMMAND_TYPE_MOVE_TO_COMPLETED) {
+			fmt_ret = asprintf(&migrated_path,
+					   "%s/" DEFAULT_ARCHIVED_TRACE_CHUNKS_DIRECTORY "/%s",
+					   session->output_path,
+					   chunk_name);
+		} else if (session->has_rotated || session->snapshot) {
+			fmt_ret = asprintf(
+				&migrated_path, "%s/%s", session->output_path, chunk_name);
+		} else {
+			fmt_ret = asprintf(&migrated_path, "%s", session->output_path);
+		}
+		if (fmt_ret < 0) {
+			PERROR("Failed to format migrated trace chunk path");
+			reply_code = LTTNG_ERR_NOMEM;
+			ret = -1;
+			goto end_unlock_session;
+		}
+
+		chunk_status = lttng_trace_chunk_set_release_callback(
+			chunk, migrate_closed_trace_chunk, migrated_path);
+		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+			free(migrated_path);
+			reply_code = LTTNG_ERR_UNK;
+			ret = -1;
+			goto end_unlock_session;
+		}
+	}
+
 	if (session->current_trace_chunk == chunk) {
 		/*
 		 * After a trace chunk close command, no new streams
@@ -3138,11 +3978,15 @@ static int relay_close_trace_chunk(const struct lttcomm_relayd_hdr *recv_hdr
 		 * is released in order to allow it to be reclaimed when
 		 * the last stream releases its reference to it.
 		 */
-		lttng_trace_chunk_put(session->current_trace_chunk);
+		rotation_workers_put_trace_chunk(session->current_trace_chunk);
 		session->current_trace_chunk = nullptr;
 	}
-	lttng_trace_chunk_put(session->pending_closure_trace_chunk);
+	rotation_workers_put_trace_chunk(session->pending_closure_trace_chunk);
 	session->pending_closure_trace_chunk = nullptr;
+	forwarder_close_trace_chunk(session,
+				    chunk_id,
+				    close_timestamp,
+				    close_command.is_set ? &close_command.value : nullptr);
 end_unlock_session:
 	pthread_mutex_unlock(&session->lock);
 
@@ -3173,7 +4017,8 @@ end:
 		goto end_no_reply;
 	}
 end_no_reply:
-	lttng_trace_chunk_put(chunk);
+	/* The last reference performs the close command of the trace chunk. */
+	rotation_workers_put_trace_chunk(chunk);
 	lttng_dynamic_buffer_reset(&reply_payload);
 	return ret;
 }
@@ -3330,9 +4175,15 @@ static int relay_process_control_command(struct relay_connection *conn,
 	case RELAYD_END_DATA_PENDING:
 		ret = relay_end_data_pending(header, conn, payload);
 		break;
+	case RELAYD_SESSION_DATA_PENDING:
+		ret = relay_session_data_pending(header, conn, payload);
+		break;
 	case RELAYD_SEND_INDEX:
 		ret = relay_recv_index(header, conn, payload);
 		break;
+	case RELAYD_SEND_INDEXES:
+		ret = relay_recv_indexes(header, conn, payload);
+		break;
 	case RELAYD_STREAMS_SENT:
 		ret = relay_streams_sent(header, conn, payload);
 		break;
@@ -3625,6 +4476,10 @@ static enum relay_connection_status relay_process_data_receive_header(struct rel
 	conn->protocol.data.state.receive_payload.left_to_receive = header.data_size;
 	conn->protocol.data.state.receive_payload.received = 0;
 	conn->protocol.data.state.receive_payload.rotate_index = false;
+	conn->protocol.data.state.receive_payload.discard = false;
+	conn->protocol.data.state.receive_payload.checksum = 0;
+	conn->protocol.data.state.receive_payload.packet = nullptr;
+	conn->protocol.data.state.receive_payload.forward = nullptr;
 
 	DBG("Received data connection header on fd %i: circuit_id = %" PRIu64
 	    ", stream_id = %" PRIu64 ", data_size = %" PRIu32 ", net_seq_num = %" PRIu64
@@ -3636,7 +4491,7 @@ static enum relay_connection_status relay_process_data_receive_header(struct rel
 	    header.net_seq_num,
 	    header.padding_size);
 
-	stream = stream_get_by_id(header.stream_id);
+	stream = connection_get_stream_by_id(conn, header.stream_id);
 	if (!stream) {
 		DBG("relay_process_data_receive_payload: Cannot find stream %" PRIu64,
 		    header.stream_id);
@@ -3645,6 +4500,47 @@ static enum relay_connection_status relay_process_data_receive_header(struct rel
 		goto end;
 	}
 
+	if (opt_deduplicate_packets) {
+		bool accepted;
+
+		pthread_mutex_lock(&stream->lock);
+		accepted = stream_accept_packet(stream, header.net_seq_num);
+		pthread_mutex_unlock(&stream->lock);
+		if (!accepted) {
+			conn->protocol.data.state.receive_payload.discard = true;
+			goto end_stream_unlock;
+		}
+	}
+
+	conn->protocol.data.state.receive_payload.forward =
+		forwarder_packet_create(stream, &header);
+
+	if (stream_writers_enabled()) {
+		struct stream_write_packet *packet;
+
+		pthread_mutex_lock(&stream->lock);
+		ret = conn->session ? 0 : connection_set_session(conn, stream->trace->session);
+		pthread_mutex_unlock(&stream->lock);
+		if (ret) {
+			status = RELAY_CONNECTION_STATUS_ERROR;
+			goto end_stream_unlock;
+		}
+
+		/*
+		 * The writer thread of the stream prepares the stream for the
+		 * packet once the packets queued before it are written.
+		 */
+		packet = stream_write_packet_create(stream, &header);
+		if (!packet) {
+			status = RELAY_CONNECTION_STATUS_ERROR;
+			goto end_stream_unlock;
+		}
+
+		/* The packet owns the reference to the stream. */
+		conn->protocol.data.state.receive_payload.packet = packet;
+		goto end;
+	}
+
 	pthread_mutex_lock(&stream->lock);
 	/* Prepare stream for the reception of a new packet. */
 	ret = stream_init_packet(
@@ -3662,6 +4558,176 @@ end:
 	return status;
 }
 
+static bool relay_data_packet_has_checksum(const struct lttcomm_relayd_data_hdr *header)
+{
+	return header->circuit_id & LTTCOMM_RELAYD_DATA_HDR_CHECKSUM;
+}
+
+/*
+ * Check the checksum of a data packet, computed as its payload was received,
+ * against the checksum computed by the consumer daemon. A corrupted packet is
+ * reported and kept.
+ */
+static void
+relay_data_packet_check_checksum(const struct data_connection_state_receive_payload *state)
+{
+	uint32_t checksum;
+
+	if (!relay_data_packet_has_checksum(&state->header)) {
+		return;
+	}
+
+	/* The checksum accounts for the zero padding written after the payload. */
+	checksum = lttng_crc32c_update_zeroes(state->checksum, state->header.padding_size);
+	if (checksum != (uint32_t) state->header.circuit_id) {
+		ERR("Data packet checksum mismatch: stream_id = %" PRIu64 ", net_seq_num = %" PRIu64
+		    ", expected = %08" PRIx32 ", computed = %08" PRIx32,
+		    state->header.stream_id,
+		    state->header.net_seq_num,
+		    (uint32_t) state->header.circuit_id,
+		    checksum);
+	}
+}
+
+/*
+ * Create the splice pipe of a data connection on its first payload.
+ *
+ * Return true if the payloads of the connection can be spliced.
+ */
+static bool relay_data_connection_can_splice(struct relay_connection *conn)
+{
+	int *splice_pipe = conn->protocol.data.splice_pipe;
+
+	if (!conn->protocol.data.splice_pipe_init_done) {
+		conn->protocol.data.splice_pipe_init_done = true;
+		if (fd_tracker_util_pipe_open_cloexec(
+			    the_fd_tracker, "Relayd data connection splice pipe", splice_pipe)) {
+			WARN("Failed to create data connection splice pipe, copying its payloads: "
+			     "sock = %d",
+			     conn->sock->fd);
+			splice_pipe[0] = -1;
+			splice_pipe[1] = -1;
+		} else {
+			const int size = fcntl(splice_pipe[1], F_GETPIPE_SZ);
+
+			conn->protocol.data.splice_pipe_size = size > 0 ? size : 0;
+		}
+	}
+
+	return splice_pipe[0] >= 0;
+}
+
+/*
+ * Grow the splice pipe, or the receive buffer, of a data connection to fit a
+ * payload of `payload_size` bytes, within the configured limit.
+ *
+ * Return the maximal number of bytes received at once, 0 on error.
+ */
+static size_t relay_data_connection_fit_payload(struct relay_connection *conn,
+						bool splice_payload,
+						uint64_t payload_size)
+{
+	const size_t size = std::max<uint64_t>(
+		RECV_DATA_BUFFER_SIZE, std::min(payload_size, opt_data_recv_buffer_max_size));
+
+	if (splice_payload) {
+		int ret;
+
+		if (conn->protocol.data.splice_pipe_size >= size ||
+		    conn->protocol.data.splice_pipe_size_max_reached) {
+			goto end_splice;
+		}
+
+		ret = fcntl(conn->protocol.data.splice_pipe[1], F_SETPIPE_SZ, (int) size);
+		if (ret < 0) {
+			/* Typically bounded by the `fs.pipe-max-size` sysctl. */
+			DBG("Failed to grow data connection splice pipe: sock = %d, size = %zu",
+			    conn->sock->fd,
+			    size);
+			conn->protocol.data.splice_pipe_size_max_reached = true;
+			goto end_splice;
+		}
+
+		conn->protocol.data.splice_pipe_size = ret;
+	end_splice:
+		return conn->protocol.data.splice_pipe_size;
+	}
+
+	if (conn->protocol.data.reception_buffer.size < size) {
+		const size_t current_size = conn->protocol.data.reception_buffer.size;
+		const size_t min_size = std::max<size_t>(current_size, RECV_DATA_BUFFER_SIZE);
+		size_t new_size = size;
+
+		/* The smallest buffer is always allowed, its growth past it is reserved. */
+		memory_budget_charge(MEMORY_BUDGET_RECEIVE_BUFFER, min_size - current_size);
+		if (!memory_budget_reserve(MEMORY_BUDGET_RECEIVE_BUFFER, size - min_size)) {
+			new_size = min_size;
+			DBG3("Memory budget exceeded, limiting data connection receive buffer: "
+			     "sock = %d, size = %zu",
+			     conn->sock->fd,
+			     new_size);
+		}
+
+		if (new_size > current_size &&
+		    lttng_dynamic_buffer_set_size(&conn->protocol.data.reception_buffer,
+						  new_size)) {
+			ERR("Failed to grow data connection receive buffer: sock = %d, size = %zu",
+			    conn->sock->fd,
+			    new_size);
+			memory_budget_release(MEMORY_BUDGET_RECEIVE_BUFFER,
+					      new_size - current_size);
+		}
+	}
+
+	return conn->protocol.data.reception_buffer.size;
+}
+
+/*
+ * Splice up to `len` bytes immediately available on the socket of a data
+ * connection to its splice pipe.
+ *
+ * A socket splice only returns once it moved the requested length or the
+ * pipe is full, so the length is bounded by the bytes queued on the socket
+ * to never block the worker thread.
+ *
+ * Return the number of bytes spliced, 0 on orderly shutdown, else -1 with
+ * errno set (EAGAIN when no data is available).
+ */
+static ssize_t relay_data_connection_splice_recv(struct relay_connection *conn, size_t len)
+{
+	const int sock_fd = conn->sock->fd;
+
+	for (;;) {
+		int available;
+		ssize_t ret;
+		char byte;
+
+		if (ioctl(sock_fd, FIONREAD, &available) < 0) {
+			return -1;
+		}
+
+		if (available > 0) {
+			do {
+				ret = splice(sock_fd,
+					     nullptr,
+					     conn->protocol.data.splice_pipe[1],
+					     nullptr,
+					     std::min<size_t>(len, available),
+					     SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+			} while (ret < 0 && errno == EINTR);
+			return ret;
+		}
+
+		/* Tell an orderly shutdown apart from the absence of data. */
+		ret = recv(sock_fd, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+		if (ret <= 0) {
+			return ret;
+		}
+
+		/* Data was received in the meantime. */
+	}
+}
+
 static enum relay_connection_status
 relay_process_data_receive_payload(struct relay_connection *conn)
 {
@@ -3670,12 +4736,13 @@ relay_process_data_receive_payload(struct relay_connection *conn)
 	struct relay_stream *stream;
 	struct data_connection_state_receive_payload *state =
 		&conn->protocol.data.state.receive_payload;
-	const size_t chunk_size = RECV_DATA_BUFFER_SIZE;
-	char data_buffer[chunk_size];
+	size_t chunk_size;
+	char *data_buffer;
 	bool partial_recv = false;
-	bool new_stream = false, close_requested = false, index_flushed = false;
+	bool new_stream = false, close_requested = false;
 	uint64_t left_to_receive = state->left_to_receive;
 	struct relay_session *session;
+	bool splice_payload;
 
 	DBG3("Receiving data for stream id %" PRIu64 " seqnum %" PRIu64 ", %" PRIu64
 	     " bytes received, %" PRIu64 " bytes left to receive",
@@ -3684,7 +4751,7 @@ relay_process_data_receive_payload(struct relay_connection *conn)
 	     state->received,
 	     left_to_receive);
 
-	stream = stream_get_by_id(state->header.stream_id);
+	stream = connection_get_stream_by_id(conn, state->header.stream_id);
 	if (!stream) {
 		/* Protocol error. */
 		ERR("relay_process_data_receive_payload: cannot find stream %" PRIu64,
@@ -3703,17 +4770,54 @@ relay_process_data_receive_payload(struct relay_connection *conn)
 		}
 	}
 
+	if (state->forward) {
+		/*
+		 * The payload of a forwarded packet is received in its forward
+		 * buffer, from which it is both written and forwarded.
+		 */
+		splice_payload = false;
+		chunk_size = left_to_receive;
+	} else {
+		/*
+		 * The relay daemon doesn't inspect the contents of the data
+		 * packets: move them from the socket to the stream file through
+		 * a pipe rather than copying them through user space. The
+		 * metadata is copied since its reception is accounted to notify
+		 * the live viewers, and so are the packets which are cached or
+		 * whose checksum is verified as they are received.
+		 */
+		splice_payload = !stream->is_metadata && !packet_cache_enabled() &&
+			!relay_data_packet_has_checksum(&state->header) &&
+			relay_data_connection_can_splice(conn);
+		chunk_size =
+			relay_data_connection_fit_payload(conn, splice_payload, left_to_receive);
+		if (chunk_size == 0) {
+			status = RELAY_CONNECTION_STATUS_ERROR;
+			goto end_stream_unlock;
+		}
+	}
+
 	/*
 	 * The size of the "chunk" received on any iteration is bounded by:
 	 *   - the data left to receive,
 	 *   - the data immediately available on the socket,
-	 *   - the on-stack data buffer
+	 *   - the receive buffer, or the capacity of the splice pipe
 	 */
 	while (left_to_receive > 0 && !partial_recv) {
 		size_t recv_size = std::min<uint64_t>(left_to_receive, chunk_size);
 		struct lttng_buffer_view packet_chunk;
 
-		ret = conn->sock->ops->recvmsg(conn->sock, data_buffer, recv_size, MSG_DONTWAIT);
+		data_buffer = state->forward ?
+			forwarder_packet_data(state->forward) + state->received :
+			conn->protocol.data.reception_buffer.data;
+
+		if (splice_payload) {
+			ret = relay_data_connection_splice_recv(conn, recv_size);
+		} else {
+			ret = conn->sock->ops->recvmsg(
+				conn->sock, data_buffer, recv_size, MSG_DONTWAIT);
+		}
+
 		if (ret < 0) {
 			DIAGNOSTIC_PUSH
 			DIAGNOSTIC_IGNORE_LOGICAL_OP
@@ -3732,16 +4836,36 @@ relay_process_data_receive_payload(struct relay_connection *conn)
 		} else if (ret < (int) recv_size) {
 			/*
 			 * All the data available on the socket has been
-			 * consumed.
+			 * consumed, unless the splice pipe is full: the next
+			 * splice tells.
 			 */
-			partial_recv = true;
+			partial_recv = !splice_payload;
 			recv_size = ret;
 		}
 
-		packet_chunk = lttng_buffer_view_init(data_buffer, 0, recv_size);
-		LTTNG_ASSERT(packet_chunk.data);
+		conn->protocol.data.received_bytes += recv_size;
+		conn->protocol.data.receive_calls++;
+		relay_metrics_count_received_bytes(stream, recv_size);
+		self_tracepoint(relayd_data_receive,
+				state->header.stream_id,
+				state->header.net_seq_num,
+				recv_size);
+
+		if (splice_payload) {
+			ret = stream_splice(stream, conn->protocol.data.splice_pipe[0], recv_size);
+		} else {
+			packet_chunk = lttng_buffer_view_init(data_buffer, 0, recv_size);
+			LTTNG_ASSERT(packet_chunk.data);
+
+			if (relay_data_packet_has_checksum(&state->header)) {
+				state->checksum = lttng_crc32c_update(
+					state->checksum, packet_chunk.data, packet_chunk.size);
+			}
+
+			ret = stream_write(stream, &packet_chunk, 0);
+		}
 
-		ret = stream_write(stream, &packet_chunk, 0);
+		self_tracepoint(relayd_data_write, state->header.stream_id, recv_size, ret);
 		if (ret) {
 			ERR("Relay error writing data to file");
 			status = RELAY_CONNECTION_STATUS_ERROR;
@@ -3766,41 +4890,20 @@ relay_process_data_receive_payload(struct relay_connection *conn)
 		goto end_stream_unlock;
 	}
 
-	ret = stream_write(stream, nullptr, state->header.padding_size);
+	relay_data_packet_check_checksum(state);
+	ret = stream_commit_packet(stream,
+				   state->header.net_seq_num,
+				   state->header.data_size,
+				   state->header.padding_size,
+				   state->rotate_index,
+				   &new_stream);
 	if (ret) {
 		status = RELAY_CONNECTION_STATUS_ERROR;
 		goto end_stream_unlock;
 	}
 
-	if (session_streams_have_index(session)) {
-		ret = stream_update_index(stream,
-					  state->header.net_seq_num,
-					  state->rotate_index,
-					  &index_flushed,
-					  state->header.data_size + state->header.padding_size);
-		if (ret < 0) {
-			ERR("Failed to update index: stream %" PRIu64 " net_seq_num %" PRIu64
-			    " ret %d",
-			    stream->stream_handle,
-			    state->header.net_seq_num,
-			    ret);
-			status = RELAY_CONNECTION_STATUS_ERROR;
-			goto end_stream_unlock;
-		}
-	}
-
-	if (stream->prev_data_seq == -1ULL) {
-		new_stream = true;
-	}
-
-	ret = stream_complete_packet(stream,
-				     state->header.data_size + state->header.padding_size,
-				     state->header.net_seq_num,
-				     index_flushed);
-	if (ret) {
-		status = RELAY_CONNECTION_STATUS_ERROR;
-		goto end_stream_unlock;
-	}
+	forwarder_packet_queue(state->forward);
+	state->forward = nullptr;
 
 	/*
 	 * Resetting the protocol state (to RECEIVE_HEADER) will trash the
@@ -3828,9 +4931,139 @@ end:
 	return status;
 }
 
+/*
+ * Receive the payload of a data packet into its buffer, then queue it to the
+ * writer thread of its stream.
+ */
+static enum relay_connection_status
+relay_process_data_receive_queued_payload(struct relay_connection *conn)
+{
+	ssize_t ret;
+	struct data_connection_state_receive_payload *state =
+		&conn->protocol.data.state.receive_payload;
+	struct stream_write_packet *packet = state->packet;
+	struct forward_event *forward;
+
+	while (state->left_to_receive > 0) {
+		ret = conn->sock->ops->recvmsg(conn->sock,
+					       packet->data.data + state->received,
+					       state->left_to_receive,
+					       MSG_DONTWAIT);
+		if (ret < 0) {
+			DIAGNOSTIC_PUSH
+			DIAGNOSTIC_IGNORE_LOGICAL_OP
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				DIAGNOSTIC_POP
+				PERROR("Socket %d error", conn->sock->fd);
+				return RELAY_CONNECTION_STATUS_ERROR;
+			}
+
+			/* Wait for more data to become available on the socket. */
+			return RELAY_CONNECTION_STATUS_OK;
+		} else if (ret == 0) {
+			DBG3("No more data ready on data socket of stream id %" PRIu64,
+			     state->header.stream_id);
+			return RELAY_CONNECTION_STATUS_CLOSED;
+		}
+
+		conn->protocol.data.received_bytes += ret;
+		conn->protocol.data.receive_calls++;
+		relay_metrics_count_received_bytes(state->packet->stream, ret);
+		if (relay_data_packet_has_checksum(&state->header)) {
+			state->checksum = lttng_crc32c_update(
+				state->checksum, packet->data.data + state->received, ret);
+		}
+
+		state->received += ret;
+		state->left_to_receive -= ret;
+	}
+
+	relay_data_packet_check_checksum(state);
+
+	/*
+	 * Resetting the protocol state (to RECEIVE_HEADER) will trash the
+	 * contents of *state which are aliased (union) to the same location as
+	 * the new state. Don't use it beyond this point.
+	 */
+	forward = state->forward;
+	state->packet = nullptr;
+	state->forward = nullptr;
+	connection_reset_protocol_state(conn);
+	state = nullptr;
+
+	if (forward) {
+		memcpy(forwarder_packet_data(forward), packet->data.data, packet->data.size);
+		forwarder_packet_queue(forward);
+	}
+
+	if (stream_writers_queue(packet)) {
+		return RELAY_CONNECTION_STATUS_ERROR;
+	}
+
+	return RELAY_CONNECTION_STATUS_OK;
+}
+
+/*
+ * Receive the payload of a duplicate data packet and drop it.
+ */
+static enum relay_connection_status
+relay_process_data_discard_payload(struct relay_connection *conn)
+{
+	ssize_t ret;
+	struct data_connection_state_receive_payload *state =
+		&conn->protocol.data.state.receive_payload;
+	const size_t chunk_size =
+		relay_data_connection_fit_payload(conn, false, state->left_to_receive);
+
+	if (chunk_size == 0) {
+		return RELAY_CONNECTION_STATUS_ERROR;
+	}
+
+	while (state->left_to_receive > 0) {
+		const size_t recv_size = std::min<uint64_t>(state->left_to_receive, chunk_size);
+
+		ret = conn->sock->ops->recvmsg(conn->sock,
+					       conn->protocol.data.reception_buffer.data,
+					       recv_size,
+					       MSG_DONTWAIT);
+		if (ret < 0) {
+			DIAGNOSTIC_PUSH
+			DIAGNOSTIC_IGNORE_LOGICAL_OP
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				DIAGNOSTIC_POP
+				PERROR("Socket %d error", conn->sock->fd);
+				return RELAY_CONNECTION_STATUS_ERROR;
+			}
+
+			/* Wait for more data to become available on the socket. */
+			return RELAY_CONNECTION_STATUS_OK;
+		} else if (ret == 0) {
+			DBG3("No more data ready on data socket of stream id %" PRIu64,
+			     state->header.stream_id);
+			return RELAY_CONNECTION_STATUS_CLOSED;
+		}
+
+		conn->protocol.data.received_bytes += ret;
+		conn->protocol.data.receive_calls++;
+		state->received += ret;
+		state->left_to_receive -= ret;
+	}
+
+	connection_reset_protocol_state(conn);
+	return RELAY_CONNECTION_STATUS_OK;
+}
+
 /*
  * relay_process_data: Process the data received on the data socket
  */
+/* Return whether data is queued on the socket of a connection. */
+static bool relay_connection_has_queued_data(const struct relay_connection *conn)
+{
+	int queued;
+
+	return ioctl(conn->sock->fd, FIONREAD, &queued) == 0 && queued > 0;
+}
+
 static enum relay_connection_status relay_process_data(struct relay_connection *conn)
 {
 	enum relay_connection_status status;
@@ -3840,7 +5073,13 @@ static enum relay_connection_status relay_process_data(struct relay_connection *
 		status = relay_process_data_receive_header(conn);
 		break;
 	case DATA_CONNECTION_STATE_RECEIVE_PAYLOAD:
-		status = relay_process_data_receive_payload(conn);
+		if (conn->protocol.data.state.receive_payload.discard) {
+			status = relay_process_data_discard_payload(conn);
+		} else if (conn->protocol.data.state.receive_payload.packet) {
+			status = relay_process_data_receive_queued_payload(conn);
+		} else {
+			status = relay_process_data_receive_payload(conn);
+		}
 		break;
 	default:
 		ERR("Unexpected data connection communication state.");
@@ -3890,10 +5129,229 @@ static void relay_thread_close_connection(struct lttng_poll_event *events,
 	DBG("%s connection closed with %d", type_str, pollfd);
 }
 
+/* Bytes received from the data connections of a session during a round. */
+struct relay_worker_round_usage {
+	uint64_t session_id;
+	uint64_t received_bytes;
+};
+
+/*
+ * Re-enable the polling of the throttled data connections whose session may
+ * receive data again.
+ *
+ * Return the poll timeout until the next throttled connection may be
+ * re-enabled, -1 when there are none.
+ */
+static int relay_worker_resume_throttled_connections(struct lttng_poll_event *events,
+						     struct lttng_ht *relay_connections_ht,
+						     std::vector<int>& throttled_fds)
+{
+	int timeout = -1;
+	auto it = throttled_fds.begin();
+
+	while (it != throttled_fds.end()) {
+		struct relay_connection *conn;
+		int delay_ms = 0;
+
+		/* A closed connection is no longer in the hash table. */
+		conn = connection_get_by_sock(relay_connections_ht, *it);
+		if (conn) {
+			if (conn->session) {
+				delay_ms = ingest_bucket_delay_ms(&conn->session->ingest);
+			}
+
+			delay_ms = std::max(delay_ms, write_scheduler_delay_ms());
+			if (memory_budget_throttles_data()) {
+				delay_ms = std::max(delay_ms,
+						    DEFAULT_RELAYD_MEMORY_BUDGET_BACKOFF_MS);
+			}
+
+			if (delay_ms == 0 && lttng_poll_mod(events, *it, LPOLLIN | LPOLLRDHUP)) {
+				/* Retry on the next round. */
+				ERR("Failed to resume polling of data connection socket %d", *it);
+				delay_ms = 1;
+			}
+
+			connection_put(conn);
+		}
+
+		if (delay_ms == 0) {
+			DBG3("Resuming polling of data connection socket %d", *it);
+			it = throttled_fds.erase(it);
+			continue;
+		}
+
+		timeout = timeout < 0 ? delay_ms : std::min(timeout, delay_ms);
+		++it;
+	}
+
+	return timeout;
+}
+
+static struct relay_worker_round_usage *
+relay_worker_get_round_usage(std::vector<relay_worker_round_usage>& round_usage,
+			     const struct relay_session *session)
+{
+	for (auto& usage : round_usage) {
+		if (usage.session_id == session->id) {
+			return &usage;
+		}
+	}
+
+	try {
+		round_usage.push_back({ session->id, 0 });
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+
+	return &round_usage.back();
+}
+
+/*
+ * Return true if the data of a connection must not be received during this
+ * round because its session exceeded its ingestion limits or because the
+ * write or memory budget of the relay daemon is exceeded. The polling of
+ * such a connection is suspended, except for hang ups, until
+ * relay_worker_resume_throttled_connections() resumes it.
+ */
+static bool relay_worker_defer_data_connection(struct lttng_poll_event *events,
+					       struct relay_connection *conn,
+					       std::vector<int>& throttled_fds,
+					       std::vector<relay_worker_round_usage>& round_usage)
+{
+	struct relay_session *session = conn->session;
+	bool write_budget_overspent = false, memory_budget_exceeded = false;
+
+	/* The session of a connection is known once its first header is received. */
+	if (session && ingest_limiter_round_budget_enabled()) {
+		const struct relay_worker_round_usage *usage =
+			relay_worker_get_round_usage(round_usage, session);
+
+		if (usage &&
+		    usage->received_bytes >= ingest_bucket_round_budget(&session->ingest)) {
+			DBG3("Session %" PRIu64 " spent its round budget, deferring data socket %d",
+			     session->id,
+			     conn->sock->fd);
+			return true;
+		}
+	}
+
+	if (!session || ingest_bucket_delay_ms(&session->ingest) == 0) {
+		write_budget_overspent = write_scheduler_delay_ms() > 0;
+		memory_budget_exceeded = memory_budget_throttles_data();
+		if (!write_budget_overspent && !memory_budget_exceeded) {
+			return false;
+		}
+	}
+
+	try {
+		throttled_fds.push_back(conn->sock->fd);
+	} catch (const std::bad_alloc&) {
+		/* Not throttling is the lesser evil. */
+		return false;
+	}
+
+	if (lttng_poll_mod(events, conn->sock->fd, LPOLLRDHUP)) {
+		ERR("Failed to suspend polling of data connection socket %d", conn->sock->fd);
+		throttled_fds.pop_back();
+		return false;
+	}
+
+	if (write_budget_overspent) {
+		write_scheduler_count_paced_write();
+		DBG3("Write budget overspent, suspending data socket %d", conn->sock->fd);
+	} else if (memory_budget_exceeded) {
+		DBG3("Memory budget exceeded, suspending data socket %d", conn->sock->fd);
+	} else {
+		DBG3("Session %" PRIu64 " exceeded its ingestion rate, suspending data socket %d",
+		     session->id,
+		     conn->sock->fd);
+	}
+
+	return true;
+}
+
+/*
+ * Suspend the polling of a control connection, except for hang ups, during
+ * the next round of the worker thread so that its data connections are
+ * read first.
+ */
+static void relay_worker_yield_control_connection(struct lttng_poll_event *events,
+						  struct relay_connection *conn,
+						  std::vector<int>& yielded_fds)
+{
+	try {
+		yielded_fds.push_back(conn->sock->fd);
+	} catch (const std::bad_alloc&) {
+		/* Not yielding is the lesser evil. */
+		return;
+	}
+
+	if (lttng_poll_mod(events, conn->sock->fd, LPOLLRDHUP)) {
+		ERR("Failed to suspend polling of control connection socket %d", conn->sock->fd);
+		yielded_fds.pop_back();
+		return;
+	}
+
+	DBG3("Memory budget exceeded, control socket %d yields to the data connections",
+	     conn->sock->fd);
+}
+
+/* Resume the polling of the control connections which yielded during the last round. */
+static void relay_worker_resume_yielded_connections(struct lttng_poll_event *events,
+						    struct lttng_ht *relay_connections_ht,
+						    std::vector<int>& yielded_fds)
+{
+	auto it = yielded_fds.begin();
+
+	while (it != yielded_fds.end()) {
+		/* A closed connection is no longer in the hash table. */
+		struct relay_connection *conn = connection_get_by_sock(relay_connections_ht, *it);
+
+		if (conn) {
+			const int ret = lttng_poll_mod(events, *it, LPOLLIN | LPOLLRDHUP);
+
+			connection_put(conn);
+			if (ret) {
+				/* Retry on the next round. */
+				ERR("Failed to resume polling of control connection socket %d",
+				    *it);
+				++it;
+				continue;
+			}
+		}
+
+		it = yielded_fds.erase(it);
+	}
+}
+
+/* Account for the bytes received from a data connection. */
+static void relay_worker_charge_data_connection(struct relay_connection *conn,
+						uint64_t received_bytes,
+						std::vector<relay_worker_round_usage>& round_usage)
+{
+	struct relay_session *session = conn->session;
+	struct relay_worker_round_usage *usage;
+
+	if (!session || received_bytes == 0) {
+		return;
+	}
+
+	ingest_bucket_charge(&session->ingest, received_bytes);
+	if (!ingest_limiter_round_budget_enabled()) {
+		return;
+	}
+
+	usage = relay_worker_get_round_usage(round_usage, session);
+	if (usage) {
+		usage->received_bytes += received_bytes;
+	}
+}
+
 /*
  * This thread does the actual work
  */
-static void *relay_thread_worker(void *data __attribute__((unused)))
+static void *relay_thread_worker(void *data)
 {
 	int ret, err = -1, last_seen_data_fd = -1;
 	uint32_t nb_fd;
@@ -3901,8 +5359,14 @@ static void *relay_thread_worker(void *data __attribute__((unused)))
 	struct lttng_ht *relay_connections_ht;
 	struct lttng_ht_iter iter;
 	struct relay_connection *destroy_conn = nullptr;
+	struct relay_worker *worker = (struct relay_worker *) data;
+	int *relay_conn_pipe = worker->conn_pipe;
+	/* Data connections not polled until their session may receive data again. */
+	std::vector<int> throttled_data_fds;
+	std::vector<int> yielded_control_fds;
+	std::vector<relay_worker_round_usage> round_usage;
 
-	DBG("[thread] Relay worker started");
+	DBG("[thread] Relay worker %u started", worker->id);
 
 	rcu_register_thread();
 
@@ -3932,14 +5396,22 @@ static void *relay_thread_worker(void *data __attribute__((unused)))
 
 restart:
 	while (true) {
-		int idx = -1, i, seen_control = 0, last_notdel_data_fd = -1;
+		int idx = -1, i, seen_control = 0, last_notdel_data_fd = -1, timeout;
 
 		health_code_update();
 
-		/* Infinite blocking call, waiting for transmission */
+		timeout = relay_worker_resume_throttled_connections(
+			&events, relay_connections_ht, throttled_data_fds);
+		if (!yielded_control_fds.empty()) {
+			const int backoff_ms = DEFAULT_RELAYD_MEMORY_BUDGET_BACKOFF_MS;
+
+			timeout = timeout < 0 ? backoff_ms : std::min(timeout, backoff_ms);
+		}
+
+		/* Blocking call, until throttled connections may be resumed, if any. */
 		DBG3("Relayd worker thread polling...");
 		health_poll_entry();
-		ret = lttng_poll_wait(&events, -1);
+		ret = lttng_poll_wait(&events, timeout);
 		health_poll_exit();
 		if (ret < 0) {
 			/*
@@ -3953,6 +5425,10 @@ restart:
 
 		nb_fd = ret;
 
+		/* The yielded control connections are polled again on the next round. */
+		relay_worker_resume_yielded_connections(
+			&events, relay_connections_ht, yielded_control_fds);
+
 		/*
 		 * Process control. The control connection is
 		 * prioritized so we don't starve it with high
@@ -4049,6 +5525,9 @@ restart:
 						/* Clear the connection on error or close. */
 						relay_thread_close_connection(
 							&events, pollfd, ctrl_conn);
+					} else if (memory_budget_throttles_control()) {
+						relay_worker_yield_control_connection(
+							&events, ctrl_conn, yielded_control_fds);
 					}
 					seen_control = 1;
 				} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
@@ -4090,6 +5569,7 @@ restart:
 		}
 
 		/* Process data connection. */
+		round_usage.clear();
 		for (i = idx + 1; i < nb_fd; i++) {
 			/* Fetch the poll data. */
 			uint32_t revents = LTTNG_POLL_GETEV(&events, i);
@@ -4119,9 +5599,41 @@ restart:
 			LTTNG_ASSERT(data_conn->type == RELAY_DATA);
 
 			if (revents & LPOLLIN) {
-				enum relay_connection_status status;
+				enum relay_connection_status status = RELAY_CONNECTION_STATUS_OK;
+				uint64_t drained_bytes = 0;
+				bool processed = false;
+
+				/*
+				 * Keep receiving while data is queued on the socket
+				 * rather than polling it again after each partial
+				 * reception, within a budget which keeps the other
+				 * connections served.
+				 */
+				while (!relay_worker_defer_data_connection(
+					&events, data_conn, throttled_data_fds, round_usage)) {
+					const uint64_t received_bytes =
+						data_conn->protocol.data.received_bytes;
+
+					status = relay_process_data(data_conn);
+					processed = true;
+					relay_worker_charge_data_connection(
+						data_conn,
+						data_conn->protocol.data.received_bytes -
+							received_bytes,
+						round_usage);
+					drained_bytes += data_conn->protocol.data.received_bytes -
+						received_bytes;
+					if (status != RELAY_CONNECTION_STATUS_OK ||
+					    drained_bytes >= DEFAULT_RELAYD_DATA_DRAIN_MAX_SIZE ||
+					    !relay_connection_has_queued_data(data_conn)) {
+						break;
+					}
+				}
+
+				if (!processed) {
+					goto put_data_connection;
+				}
 
-				status = relay_process_data(data_conn);
 				/* Connection closed or error. */
 				if (status != RELAY_CONNECTION_STATUS_OK) {
 					/*
@@ -4212,13 +5724,32 @@ error_testpoint:
 }
 
 /*
- * Create the relay command pipe to wake thread_manage_apps.
- * Closed in cleanup().
+ * Allocate the worker threads and create their connection pipes. The pipes
+ * are closed by the worker threads.
  */
-static int create_relay_conn_pipe()
+static int create_relay_workers()
 {
-	return fd_tracker_util_pipe_open_cloexec(
-		the_fd_tracker, "Relayd connection pipe", relay_conn_pipe);
+	relay_workers = calloc<relay_worker>(relay_worker_count);
+	if (!relay_workers) {
+		PERROR("Failed to allocate relay worker threads");
+		return -1;
+	}
+
+	for (unsigned int i = 0; i < relay_worker_count; i++) {
+		relay_workers[i].id = i;
+		relay_workers[i].conn_pipe[0] = -1;
+		relay_workers[i].conn_pipe[1] = -1;
+	}
+
+	for (unsigned int i = 0; i < relay_worker_count; i++) {
+		if (fd_tracker_util_pipe_open_cloexec(the_fd_tracker,
+						      "Relayd connection pipe",
+						      relay_workers[i].conn_pipe)) {
+			return -1;
+		}
+	}
+
+	return 0;
 }
 
 static int stdio_open(void *data __attribute__((unused)), int *fds)
@@ -4245,6 +5776,7 @@ int main(int argc, char **argv)
 	int ret = 0, retval = 0;
 	void *status;
 	char *unlinked_file_directory_path = nullptr, *output_path = nullptr;
+	unsigned int worker_thread_count = 0;
 
 	/* Parse environment variables */
 	ret = parse_env_options();
@@ -4333,6 +5865,11 @@ int main(int argc, char **argv)
 	rcu_register_thread();
 	thread_is_rcu_registered = true;
 
+	if (lttng_async_log_init_from_env()) {
+		retval = -1;
+		goto exit_options;
+	}
+
 	output_path = create_output_path("");
 	if (!output_path) {
 		ERR("Failed to get output path");
@@ -4376,8 +5913,8 @@ int main(int argc, char **argv)
 		goto exit_options;
 	}
 
-	/* Setup the thread apps communication pipe. */
-	if (create_relay_conn_pipe()) {
+	/* Setup the worker threads communication pipes. */
+	if (create_relay_workers()) {
 		retval = -1;
 		goto exit_options;
 	}
@@ -4396,6 +5933,12 @@ int main(int argc, char **argv)
 		goto exit_options;
 	}
 
+	/* tables of the sessions of each hostname indexed by hostname */
+	if (session_hosts_init()) {
+		retval = -1;
+		goto exit_options;
+	}
+
 	/* tables of streams indexed by stream ID */
 	relay_streams_ht = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
 	if (!relay_streams_ht) {
@@ -4428,6 +5971,57 @@ int main(int argc, char **argv)
 		goto exit_options;
 	}
 
+	/* Setup the metrics thread, if enabled */
+	if (relay_metrics_enabled()) {
+		ret = pthread_create(&metrics_thread,
+				     default_pthread_attr(),
+				     thread_manage_metrics,
+				     (void *) nullptr);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create metrics");
+			retval = -1;
+			lttng_relay_stop_threads();
+			goto exit_metrics_thread;
+		}
+	}
+
+	/* Setup the trace chunk migration threads before any trace chunk is closed. */
+	if (chunk_migrator_enabled() && chunk_migrator_start()) {
+		retval = -1;
+		lttng_relay_stop_threads();
+		goto exit_dispatcher_thread;
+	}
+
+	/* Setup the fd prefetch thread, if enabled. */
+	if (fd_prefetcher_enabled() && fd_prefetcher_start()) {
+		retval = -1;
+		lttng_relay_stop_threads();
+		goto exit_dispatcher_thread;
+	}
+
+	/* Setup the rotation threads, if any, before any stream is rotated or closed. */
+	if (opt_rotation_thread_count && rotation_workers_create(opt_rotation_thread_count)) {
+		retval = -1;
+		lttng_relay_stop_threads();
+		goto exit_dispatcher_thread;
+	}
+
+	/* Setup the forward outputs, if any, before any session is created. */
+	if (forwarder_enabled() && forwarder_start()) {
+		retval = -1;
+		lttng_relay_stop_threads();
+		goto exit_dispatcher_thread;
+	}
+
+	/* Setup the writer threads, if any, before the worker threads queue packets. */
+	if (opt_writer_thread_count &&
+	    stream_writers_create(opt_writer_thread_count, opt_writer_queue_size)) {
+		retval = -1;
+		lttng_relay_stop_threads();
+		goto exit_dispatcher_thread;
+	}
+
 	/* Setup the dispatcher thread */
 	ret = pthread_create(&dispatcher_thread,
 			     default_pthread_attr(),
@@ -4440,13 +6034,28 @@ int main(int argc, char **argv)
 		goto exit_dispatcher_thread;
 	}
 
-	/* Setup the worker thread */
-	ret = pthread_create(&worker_thread, default_pthread_attr(), relay_thread_worker, nullptr);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_create worker");
-		retval = -1;
-		goto exit_worker_thread;
+	/* Setup the worker threads */
+	for (worker_thread_count = 0; worker_thread_count < relay_worker_count;
+	     worker_thread_count++) {
+		struct relay_worker *worker = &relay_workers[worker_thread_count];
+
+		ret = pthread_create(
+			&worker->thread, default_pthread_attr(), relay_thread_worker, worker);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create worker %u", worker->id);
+			retval = -1;
+
+			/* Close the pipes of the workers which will never run. */
+			for (unsigned int i = worker_thread_count; i < relay_worker_count; i++) {
+				(void) fd_tracker_util_pipe_close(the_fd_tracker,
+								  relay_workers[i].conn_pipe);
+			}
+
+			/* Stop the workers which were already started. */
+			lttng_relay_stop_threads();
+			goto exit_listener_thread;
+		}
 	}
 
 	/* Setup the listener thread */
@@ -4485,14 +6094,15 @@ exit_live:
 	}
 
 exit_listener_thread:
-	ret = pthread_join(worker_thread, &status);
-	if (ret) {
-		errno = ret;
-		PERROR("pthread_join worker_thread");
-		retval = -1;
+	for (unsigned int i = 0; i < worker_thread_count; i++) {
+		ret = pthread_join(relay_workers[i].thread, &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join worker thread %u", i);
+			retval = -1;
+		}
 	}
 
-exit_worker_thread:
 	ret = pthread_join(dispatcher_thread, &status);
 	if (ret) {
 		errno = ret;
@@ -4500,7 +6110,24 @@ exit_worker_thread:
 		retval = -1;
 	}
 exit_dispatcher_thread:
-
+	/* Write the packets queued by the worker threads, without holding them back. */
+	write_scheduler_stop();
+	stream_writers_destroy();
+	forwarder_stop();
+	/* Close the files and the trace chunks left behind before migrating them. */
+	rotation_workers_destroy();
+	chunk_migrator_stop();
+	fd_prefetcher_stop();
+
+	if (relay_metrics_enabled()) {
+		ret = pthread_join(metrics_thread, &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join metrics_thread");
+			retval = -1;
+		}
+	}
+exit_metrics_thread:
 	ret = pthread_join(health_thread, &status);
 	if (ret) {
 		errno = ret;
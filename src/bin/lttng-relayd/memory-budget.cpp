@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "memory-budget.hpp"
+
+#include <common/common.hpp>
+#include <common/utils.hpp>
+
+#include <urcu/uatomic.h>
+
+namespace {
+/* 0 when disabled. */
+uint64_t budget;
+/* Bytes accounted for, all types included. */
+uint64_t total_used;
+/* Updated atomically. */
+struct memory_budget_stats stats;
+
+uint64_t type_used(enum memory_budget_type type)
+{
+	return uatomic_read(&stats.used[type]);
+}
+
+bool budget_exceeded()
+{
+	return memory_budget_enabled() && uatomic_read(&total_used) >= budget;
+}
+} /* namespace */
+
+int memory_budget_set_size(const char *size)
+{
+	uint64_t value;
+
+	if (utils_parse_size_suffix(size, &value) || value == 0) {
+		ERR("Invalid memory budget: `%s`", size);
+		return -1;
+	}
+
+	budget = value;
+	return 0;
+}
+
+bool memory_budget_enabled()
+{
+	return budget > 0;
+}
+
+bool memory_budget_reserve(enum memory_budget_type type, uint64_t size)
+{
+	uint64_t used;
+
+	if (!memory_budget_enabled() || size == 0) {
+		return true;
+	}
+
+	used = uatomic_read(&total_used);
+	while (true) {
+		uint64_t previous;
+
+		if (size > budget || used > budget - size) {
+			uatomic_inc(&stats.refused_reservations);
+			return false;
+		}
+
+		previous = uatomic_cmpxchg(&total_used, used, used + size);
+		if (previous == used) {
+			break;
+		}
+
+		used = previous;
+	}
+
+	uatomic_add(&stats.used[type], size);
+	return true;
+}
+
+void memory_budget_charge(enum memory_budget_type type, uint64_t size)
+{
+	if (!memory_budget_enabled()) {
+		return;
+	}
+
+	uatomic_add(&total_used, size);
+	uatomic_add(&stats.used[type], size);
+}
+
+void memory_budget_release(enum memory_budget_type type, uint64_t size)
+{
+	if (!memory_budget_enabled()) {
+		return;
+	}
+
+	LTTNG_ASSERT(type_used(type) >= size);
+	uatomic_sub(&total_used, size);
+	uatomic_sub(&stats.used[type], size);
+}
+
+bool memory_budget_throttles_data()
+{
+	return budget_exceeded() && type_used(MEMORY_BUDGET_INDEX_AWAITING_PACKET) <=
+		type_used(MEMORY_BUDGET_INDEX_AWAITING_INDEX);
+}
+
+bool memory_budget_throttles_control()
+{
+	/* Yielding lets the data connections release the indexes waiting for their packet. */
+	return budget_exceeded() && type_used(MEMORY_BUDGET_INDEX_AWAITING_PACKET) >
+		type_used(MEMORY_BUDGET_INDEX_AWAITING_INDEX);
+}
+
+void memory_budget_get_stats(struct memory_budget_stats *stats_out)
+{
+	for (unsigned int i = 0; i < NR_MEMORY_BUDGET_TYPES; i++) {
+		stats_out->used[i] = uatomic_read(&stats.used[i]);
+	}
+
+	stats_out->refused_reservations = uatomic_read(&stats.refused_reservations);
+}
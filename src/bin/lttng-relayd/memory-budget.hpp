@@ -0,0 +1,82 @@
+#ifndef _MEMORY_BUDGET_H
+#define _MEMORY_BUDGET_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdint.h>
+
+/*
+ * Memory budget of the relay daemon.
+ *
+ * When a memory budget is set, the memory which grows with the traffic of
+ * the relay daemon rather than with its count of streams is accounted for:
+ * the indexes which overflow the index ring of their stream, the growth of
+ * the receive buffers of the data connections, and the replies to the
+ * live viewers until they are sent; the packets are sent to the viewers
+ * from the stream files.
+ *
+ * Once the budget is exceeded, the relay daemon applies back-pressure
+ * rather than allocating more:
+ *   - the receive buffers of the data connections stop growing,
+ *   - the live viewers are asked to retry their metadata requests later,
+ *   - the worker threads stop reading the data connections for a while,
+ *     unless most of the budget is held by indexes waiting for their
+ *     packet, in which case the control connections yield to the data
+ *     connections after each message instead.
+ */
+enum memory_budget_type {
+	/* Indexes received before their packet. */
+	MEMORY_BUDGET_INDEX_AWAITING_PACKET = 0,
+	/* Packets received before their index. */
+	MEMORY_BUDGET_INDEX_AWAITING_INDEX = 1,
+	/* Receive buffers of the data connections. */
+	MEMORY_BUDGET_RECEIVE_BUFFER = 2,
+	/* Replies to the live viewers, until they are sent. */
+	MEMORY_BUDGET_VIEWER_BUFFER = 3,
+
+	NR_MEMORY_BUDGET_TYPES,
+};
+
+struct memory_budget_stats {
+	/* Bytes accounted for, per type. */
+	uint64_t used[NR_MEMORY_BUDGET_TYPES];
+	/* Reservations refused because they would exceed the budget. */
+	uint64_t refused_reservations;
+};
+
+/*
+ * Set the memory budget, in bytes, from a size with an optional `k`, `M`
+ * or `G` suffix.
+ *
+ * Return 0 on success, -1 if the size is invalid.
+ */
+int memory_budget_set_size(const char *size);
+
+bool memory_budget_enabled();
+
+/*
+ * Reserve `size` bytes of the budget.
+ *
+ * Return true on success, false if the reservation would exceed the budget.
+ */
+bool memory_budget_reserve(enum memory_budget_type type, uint64_t size);
+
+/* Account for `size` bytes which can't be refused, even if they exceed the budget. */
+void memory_budget_charge(enum memory_budget_type type, uint64_t size);
+
+void memory_budget_release(enum memory_budget_type type, uint64_t size);
+
+/* Return true if the worker threads must stop reading the data connections. */
+bool memory_budget_throttles_data();
+
+/* Return true if the control connections must yield to the data connections. */
+bool memory_budget_throttles_control();
+
+void memory_budget_get_stats(struct memory_budget_stats *stats);
+
+#endif /* _MEMORY_BUDGET_H */
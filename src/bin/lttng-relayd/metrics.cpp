@@ -0,0 +1,745 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "chunk-migrator.hpp"
+#include "ctf-trace.hpp"
+#include "lttng-relayd.hpp"
+#include "memory-budget.hpp"
+#include "metrics.hpp"
+#include "packet-cache.hpp"
+#include "session.hpp"
+#include "stream.hpp"
+#include "write-scheduler.hpp"
+
+#include <common/common.hpp>
+#include <common/compat/poll.hpp>
+#include <common/fd-tracker/utils.hpp>
+#include <common/readwrite.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/time.hpp>
+#include <common/urcu.hpp>
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+/* Buckets of 1 µs to 2^20 µs (about one second), followed by +Inf. */
+const unsigned int nr_duration_buckets = 21;
+/* Time given to a client to send its request, if any. */
+const int request_timeout_ms = 100;
+
+struct duration_histogram {
+	const char *name;
+	const char *help;
+	uint64_t buckets[nr_duration_buckets + 1];
+	uint64_t sum_ns;
+	uint64_t count;
+};
+
+std::string socket_path;
+uint64_t viewer_sent_bytes;
+struct duration_histogram durations[NR_RELAY_METRICS_DURATIONS] = {
+	{ "lttng_relayd_stream_write_duration_seconds",
+	  "Duration of the writes of received data to the stream files",
+	  {},
+	  0,
+	  0 },
+	{ "lttng_relayd_rotation_duration_seconds",
+	  "Duration of the rotations of the streams of a session",
+	  {},
+	  0,
+	  0 },
+};
+
+void count_stream(struct relay_stream *stream,
+		  uint64_t received_bytes,
+		  uint64_t packets,
+		  uint64_t indexes)
+{
+	struct relay_stream_metrics *metrics[] = {
+		&stream->metrics,
+		&stream->trace->session->metrics,
+	};
+
+	for (auto *counters : metrics) {
+		uatomic_add(&counters->received_bytes, received_bytes);
+		uatomic_add(&counters->received_packets, packets);
+		uatomic_add(&counters->received_indexes, indexes);
+	}
+}
+
+void count_stream_counter(struct relay_stream *stream,
+			  uint64_t relay_stream_metrics::*counter,
+			  uint64_t value)
+{
+	uatomic_add(&(stream->metrics.*counter), value);
+	uatomic_add(&(stream->trace->session->metrics.*counter), value);
+}
+
+void append(std::string& out, const char *fmt, ...) ATTR_FORMAT_PRINTF(2, 3);
+void append(std::string& out, const char *fmt, ...)
+{
+	char buf[512];
+	va_list args;
+	int ret;
+
+	va_start(args, fmt);
+	ret = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if (ret < 0) {
+		return;
+	}
+
+	out.append(buf, std::min<size_t>(ret, sizeof(buf) - 1));
+}
+
+/* Append a label value escaped as the text exposition format requires. */
+void append_label_value(std::string& out, const char *value)
+{
+	for (const char *c = value; *c; c++) {
+		switch (*c) {
+		case '\\':
+			out += "\\\\";
+			break;
+		case '"':
+			out += "\\\"";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		default:
+			out += *c;
+			break;
+		}
+	}
+}
+
+void append_header(std::string& out, const char *name, const char *type, const char *help)
+{
+	append(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void append_session_labels(std::string& out, const struct relay_session *session)
+{
+	append(out, "session_id=\"%" PRIu64 "\",session=\"", session->id);
+	append_label_value(out, session->session_name);
+	out += "\",hostname=\"";
+	append_label_value(out, session->hostname);
+	out += "\"";
+}
+
+void append_counters(std::string& out,
+		     const char *name,
+		     const char *help,
+		     bool streams,
+		     uint64_t relay_stream_metrics::*counter)
+{
+	struct lttng_ht_iter iter;
+	lttng::urcu::read_lock_guard read_lock;
+
+	append_header(out, name, "counter", help);
+	if (!streams) {
+		struct relay_session *session;
+
+		cds_lfht_for_each_entry (sessions_ht->ht, &iter.iter, session, session_n.node) {
+			append(out, "%s{", name);
+			append_session_labels(out, session);
+			append(out, "} %" PRIu64 "\n", uatomic_read(&(session->metrics.*counter)));
+		}
+
+		return;
+	}
+
+	struct relay_stream *stream;
+
+	cds_lfht_for_each_entry (relay_streams_ht->ht, &iter.iter, stream, node.node) {
+		if (!stream_get(stream)) {
+			continue;
+		}
+
+		append(out, "%s{stream_id=\"%" PRIu64 "\",channel=\"", name, stream->stream_handle);
+		append_label_value(out, stream->channel_name);
+		out += "\",";
+		append_session_labels(out, stream->trace->session);
+		append(out, "} %" PRIu64 "\n", uatomic_read(&(stream->metrics.*counter)));
+		stream_put(stream);
+	}
+}
+
+void append_histogram(std::string& out, struct duration_histogram *histogram)
+{
+	uint64_t cumulative_count = 0;
+
+	append_header(out, histogram->name, "histogram", histogram->help);
+	for (unsigned int i = 0; i < nr_duration_buckets; i++) {
+		cumulative_count += uatomic_read(&histogram->buckets[i]);
+		append(out,
+		       "%s_bucket{le=\"%.6f\"} %" PRIu64 "\n",
+		       histogram->name,
+		       (double) (1ULL << i) / USEC_PER_SEC,
+		       cumulative_count);
+	}
+
+	cumulative_count += uatomic_read(&histogram->buckets[nr_duration_buckets]);
+	append(out, "%s_bucket{le=\"+Inf\"} %" PRIu64 "\n", histogram->name, cumulative_count);
+	append(out,
+	       "%s_sum %.9f\n%s_count %" PRIu64 "\n",
+	       histogram->name,
+	       (double) uatomic_read(&histogram->sum_ns) / NSEC_PER_SEC,
+	       histogram->name,
+	       uatomic_read(&histogram->count));
+}
+
+void append_value(
+	std::string& out, const char *name, const char *type, const char *help, uint64_t value)
+{
+	append_header(out, name, type, help);
+	append(out, "%s %" PRIu64 "\n", name, value);
+}
+
+int format_metrics(std::string& out)
+{
+	struct fd_tracker_stats fd_stats;
+	struct chunk_migrator_stats migrator_stats;
+	struct write_scheduler_stats scheduler_stats;
+	struct memory_budget_stats budget_stats;
+	struct packet_cache_stats cache_stats;
+
+	try {
+		append_counters(out,
+				"lttng_relayd_session_received_bytes_total",
+				"Trace data bytes received for the session",
+				false,
+				&relay_stream_metrics::received_bytes);
+		append_counters(out,
+				"lttng_relayd_session_received_packets_total",
+				"Packets received for the session",
+				false,
+				&relay_stream_metrics::received_packets);
+		append_counters(out,
+				"lttng_relayd_session_received_indexes_total",
+				"Indexes received for the session",
+				false,
+				&relay_stream_metrics::received_indexes);
+		append_counters(out,
+				"lttng_relayd_stream_received_bytes_total",
+				"Trace data bytes received for the stream",
+				true,
+				&relay_stream_metrics::received_bytes);
+		append_counters(out,
+				"lttng_relayd_stream_received_packets_total",
+				"Packets received for the stream",
+				true,
+				&relay_stream_metrics::received_packets);
+		append_counters(out,
+				"lttng_relayd_stream_received_indexes_total",
+				"Indexes received for the stream",
+				true,
+				&relay_stream_metrics::received_indexes);
+
+		if (opt_deduplicate_packets) {
+			append_counters(out,
+					"lttng_relayd_stream_duplicate_packets_total",
+					"Data packets of the stream skipped as duplicates",
+					true,
+					&relay_stream_metrics::duplicate_packets);
+			append_counters(out,
+					"lttng_relayd_stream_duplicate_indexes_total",
+					"Indexes of the stream skipped as duplicates",
+					true,
+					&relay_stream_metrics::duplicate_indexes);
+			append_counters(out,
+					"lttng_relayd_stream_missing_packets_total",
+					"Data packets of the stream never received",
+					true,
+					&relay_stream_metrics::missing_packets);
+			append_counters(out,
+					"lttng_relayd_stream_missing_packet_seq_nums_total",
+					"Packet sequence numbers missing from the stream indexes",
+					true,
+					&relay_stream_metrics::missing_packet_seq_nums);
+		}
+
+		for (auto& histogram : durations) {
+			append_histogram(out, &histogram);
+		}
+
+		fd_tracker_get_stats(the_fd_tracker, &fd_stats);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_suspensions_total",
+			     "counter",
+			     "File descriptors suspended to stay under the file descriptor limit",
+			     fd_stats.suspensions);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_misses_total",
+			     "counter",
+			     "Uses of suspended file descriptors which had to be restored",
+			     fd_stats.misses);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_errors_total",
+			     "counter",
+			     "File descriptor suspension and restoration errors",
+			     fd_stats.errors);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_prefetches_total",
+			     "counter",
+			     "Suspended file descriptors restored ahead of their use",
+			     fd_stats.prefetches);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_prefetch_hits_total",
+			     "counter",
+			     "Uses of file descriptors restored ahead of their use",
+			     fd_stats.prefetch_hits);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_lru_idle_seconds",
+			     "gauge",
+			     "Time since the last use of the next file descriptor to suspend",
+			     fd_stats.lru_idle_ns / NSEC_PER_SEC);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_active_fds",
+			     "gauge",
+			     "Open file descriptors tracked by the relay daemon",
+			     fd_stats.active);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_suspended_fds",
+			     "gauge",
+			     "Suspended file descriptors tracked by the relay daemon",
+			     fd_stats.suspended);
+		append_value(out,
+			     "lttng_relayd_fd_tracker_capacity_fds",
+			     "gauge",
+			     "Maximal number of file descriptors tracked by the relay daemon",
+			     fd_stats.capacity);
+		append_value(out,
+			     "lttng_relayd_viewer_sent_bytes_total",
+			     "counter",
+			     "Bytes sent to the live viewers",
+			     uatomic_read(&viewer_sent_bytes));
+
+		if (memory_budget_enabled()) {
+			memory_budget_get_stats(&budget_stats);
+			append_value(out,
+				     "lttng_relayd_memory_budget_indexes_awaiting_packet_bytes",
+				     "gauge",
+				     "Memory held by the indexes received before their packet",
+				     budget_stats.used[MEMORY_BUDGET_INDEX_AWAITING_PACKET]);
+			append_value(out,
+				     "lttng_relayd_memory_budget_indexes_awaiting_index_bytes",
+				     "gauge",
+				     "Memory held by the indexes of packets received before them",
+				     budget_stats.used[MEMORY_BUDGET_INDEX_AWAITING_INDEX]);
+			append_value(out,
+				     "lttng_relayd_memory_budget_receive_buffer_bytes",
+				     "gauge",
+				     "Memory held by the receive buffers of the data connections",
+				     budget_stats.used[MEMORY_BUDGET_RECEIVE_BUFFER]);
+			append_value(out,
+				     "lttng_relayd_memory_budget_viewer_buffer_bytes",
+				     "gauge",
+				     "Memory held by the replies to the live viewers",
+				     budget_stats.used[MEMORY_BUDGET_VIEWER_BUFFER]);
+			append_value(out,
+				     "lttng_relayd_memory_budget_refused_reservations_total",
+				     "counter",
+				     "Allocations refused by the memory budget",
+				     budget_stats.refused_reservations);
+		}
+
+		if (packet_cache_enabled()) {
+			packet_cache_get_stats(&cache_stats);
+			append_value(out,
+				     "lttng_relayd_packet_cache_hits_total",
+				     "counter",
+				     "Packets sent to the live viewers from the packet caches",
+				     cache_stats.hits);
+			append_value(out,
+				     "lttng_relayd_packet_cache_misses_total",
+				     "counter",
+				     "Packets sent to the live viewers from the stream files",
+				     cache_stats.misses);
+			append_value(out,
+				     "lttng_relayd_packet_cache_bytes",
+				     "gauge",
+				     "Memory held by the cached packets",
+				     cache_stats.cached_bytes);
+			append_value(out,
+				     "lttng_relayd_packet_cache_evictions_total",
+				     "counter",
+				     "Packets evicted from the packet caches",
+				     cache_stats.evictions);
+		}
+
+		if (write_scheduler_enabled()) {
+			write_scheduler_get_stats(&scheduler_stats);
+			append_value(out,
+				     "lttng_relayd_write_scheduler_charged_bytes_total",
+				     "counter",
+				     "Bytes written under the write budget",
+				     scheduler_stats.charged_bytes);
+			append_value(out,
+				     "lttng_relayd_write_scheduler_charged_writes_total",
+				     "counter",
+				     "Writes to the stream and index files under the budget",
+				     scheduler_stats.charged_writes);
+			append_value(out,
+				     "lttng_relayd_write_scheduler_paced_writes_total",
+				     "counter",
+				     "Receptions and writes held back by the write budget",
+				     scheduler_stats.paced_writes);
+			append_value(out,
+				     "lttng_relayd_write_scheduler_pacing_delay_seconds_total",
+				     "counter",
+				     "Time during which the writes were held back",
+				     scheduler_stats.pacing_delay_ns / NSEC_PER_SEC);
+		}
+
+		if (chunk_migrator_enabled()) {
+			chunk_migrator_get_stats(&migrator_stats);
+			append_value(out,
+				     "lttng_relayd_archive_pending_chunks",
+				     "gauge",
+				     "Trace chunks queued or being migrated to the archive output",
+				     migrator_stats.pending_chunks);
+			append_value(out,
+				     "lttng_relayd_archive_migrated_chunks_total",
+				     "counter",
+				     "Trace chunks migrated to the archive output",
+				     migrator_stats.migrated_chunks);
+			append_value(out,
+				     "lttng_relayd_archive_failed_chunks_total",
+				     "counter",
+				     "Trace chunks which failed to migrate to the archive output",
+				     migrator_stats.failed_chunks);
+			append_value(out,
+				     "lttng_relayd_archive_copied_bytes_total",
+				     "counter",
+				     "Bytes copied to the archive output",
+				     migrator_stats.copied_bytes);
+			append_value(out,
+				     "lttng_relayd_archive_failed_commands_total",
+				     "counter",
+				     "Archive commands which failed or were interrupted",
+				     migrator_stats.failed_commands);
+		}
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate metrics report");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Wait shortly for the request of a client. Return true if it sent an HTTP
+ * request, false if it sent nothing or anything else.
+ */
+bool client_sent_http_request(int sock)
+{
+	struct pollfd pollfd = {};
+	char request[16];
+	ssize_t ret;
+
+	pollfd.fd = sock;
+	pollfd.events = POLLIN;
+	do {
+		ret = poll(&pollfd, 1, request_timeout_ms);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret <= 0 || !(pollfd.revents & POLLIN)) {
+		return false;
+	}
+
+	do {
+		ret = recv(sock, request, sizeof(request), MSG_DONTWAIT);
+	} while (ret < 0 && errno == EINTR);
+
+	/* The rest of the request is left unread. */
+	return ret >= 4 && !strncmp(request, "GET ", 4);
+}
+
+void serve_client(int sock)
+{
+	const char http_header[] = "HTTP/1.0 200 OK\r\n"
+				   "Content-Type: text/plain; version=0.0.4\r\n"
+				   "Connection: close\r\n\r\n";
+	std::string report;
+	ssize_t ret;
+
+	if (client_sent_http_request(sock)) {
+		ret = lttng_write(sock, http_header, sizeof(http_header) - 1);
+		if (ret != sizeof(http_header) - 1) {
+			PERROR("Failed to send metrics HTTP header");
+			return;
+		}
+	}
+
+	if (format_metrics(report)) {
+		return;
+	}
+
+	ret = lttng_write(sock, report.data(), report.size());
+	if (ret < 0 || (size_t) ret != report.size()) {
+		PERROR("Failed to send metrics");
+	}
+}
+
+int open_unix_socket(void *data, int *out_fd)
+{
+	const int ret = lttcomm_create_unix_sock((const char *) data);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	*out_fd = ret;
+	return 0;
+}
+
+int accept_unix_socket(void *data, int *out_fd)
+{
+	const int ret = lttcomm_accept_unix_sock(*((int *) data));
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	*out_fd = ret;
+	return 0;
+}
+} /* namespace */
+
+bool relay_metrics_enabled()
+{
+	return !socket_path.empty();
+}
+
+int relay_metrics_set_socket_path(const char *path)
+{
+	if (strlen(path) >= sizeof(((struct sockaddr_un *) nullptr)->sun_path)) {
+		ERR("Metrics socket path is too long: `%s`", path);
+		return -1;
+	}
+
+	try {
+		socket_path = path;
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate metrics socket path");
+		return -1;
+	}
+
+	return 0;
+}
+
+uint64_t relay_metrics_begin_duration()
+{
+	return relay_metrics_enabled() ? lttng_monotonic_now_ns() : 0;
+}
+
+void relay_metrics_record_duration(enum relay_metrics_duration duration, uint64_t begin_ns)
+{
+	struct duration_histogram *histogram;
+	uint64_t elapsed_ns, elapsed_us, end_ns;
+	unsigned int bucket = 0;
+
+	if (!relay_metrics_enabled() || begin_ns == 0) {
+		return;
+	}
+
+	end_ns = lttng_monotonic_now_ns();
+	elapsed_ns = end_ns > begin_ns ? end_ns - begin_ns : 0;
+	elapsed_us = elapsed_ns / NSEC_PER_USEC;
+	while (bucket < nr_duration_buckets && elapsed_us > (1ULL << bucket)) {
+		bucket++;
+	}
+
+	histogram = &durations[duration];
+	uatomic_inc(&histogram->buckets[bucket]);
+	uatomic_add(&histogram->sum_ns, elapsed_ns);
+	uatomic_inc(&histogram->count);
+}
+
+void relay_metrics_count_received_bytes(struct relay_stream *stream, uint64_t len)
+{
+	if (relay_metrics_enabled()) {
+		count_stream(stream, len, 0, 0);
+	}
+}
+
+void relay_metrics_count_received_packet(struct relay_stream *stream)
+{
+	if (relay_metrics_enabled()) {
+		count_stream(stream, 0, 1, 0);
+	}
+}
+
+void relay_metrics_count_received_index(struct relay_stream *stream)
+{
+	if (relay_metrics_enabled()) {
+		count_stream(stream, 0, 0, 1);
+	}
+}
+
+void relay_metrics_count_duplicate_packet(struct relay_stream *stream)
+{
+	if (relay_metrics_enabled()) {
+		count_stream_counter(stream, &relay_stream_metrics::duplicate_packets, 1);
+	}
+}
+
+void relay_metrics_count_duplicate_index(struct relay_stream *stream)
+{
+	if (relay_metrics_enabled()) {
+		count_stream_counter(stream, &relay_stream_metrics::duplicate_indexes, 1);
+	}
+}
+
+void relay_metrics_count_missing_packets(struct relay_stream *stream, uint64_t count)
+{
+	if (relay_metrics_enabled()) {
+		count_stream_counter(stream, &relay_stream_metrics::missing_packets, count);
+	}
+}
+
+void relay_metrics_count_missing_packet_seq_nums(struct relay_stream *stream, uint64_t count)
+{
+	if (relay_metrics_enabled()) {
+		count_stream_counter(stream, &relay_stream_metrics::missing_packet_seq_nums, count);
+	}
+}
+
+void relay_metrics_count_viewer_sent_bytes(uint64_t len)
+{
+	if (relay_metrics_enabled()) {
+		uatomic_add(&viewer_sent_bytes, len);
+	}
+}
+
+void *thread_manage_metrics(void *data __attribute__((unused)))
+{
+	int sock = -1, ret, err = -1;
+	struct lttng_poll_event events;
+	const char *sock_name = "Metrics Unix socket";
+	char *path = (char *) socket_path.c_str();
+
+	DBG("[thread] Manage metrics started");
+
+	rcu_register_thread();
+
+	/* We might hit an error path before this is created. */
+	lttng_poll_init(&events);
+
+	/* A socket left by a previous relay daemon would prevent the bind. */
+	(void) unlink(path);
+	ret = fd_tracker_open_unsuspendable_fd(
+		the_fd_tracker, &sock, &sock_name, 1, open_unix_socket, path);
+	if (ret < 0) {
+		ERR("Unable to create metrics Unix socket @ %s", path);
+		goto error;
+	}
+
+	(void) utils_set_fd_cloexec(sock);
+
+	ret = lttcomm_listen_unix_sock(sock);
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = create_named_thread_poll_set(&events, 2, "Metrics thread epoll");
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = lttng_poll_add(&events, sock, LPOLLIN | LPOLLPRI);
+	if (ret < 0) {
+		goto error;
+	}
+
+	while (true) {
+		const char *client_name = "Metrics client socket";
+		int client_sock = -1;
+		bool accept_client = false;
+
+	restart:
+		ret = lttng_poll_wait(&events, -1);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				goto restart;
+			}
+			goto error;
+		}
+
+		for (int i = 0; i < ret; i++) {
+			const auto revents = LTTNG_POLL_GETEV(&events, i);
+			const auto pollfd = LTTNG_POLL_GETFD(&events, i);
+
+			if (relayd_is_thread_quit_pipe(pollfd)) {
+				DBG("Activity on thread quit pipe");
+				err = 0;
+				goto exit;
+			}
+
+			if (revents & LPOLLIN) {
+				accept_client = true;
+			} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
+				ERR("Metrics socket poll error");
+				goto error;
+			} else {
+				ERR("Unexpected poll events %u for sock %d", revents, pollfd);
+				goto error;
+			}
+		}
+
+		if (!accept_client) {
+			continue;
+		}
+
+		ret = fd_tracker_open_unsuspendable_fd(
+			the_fd_tracker, &client_sock, &client_name, 1, accept_unix_socket, &sock);
+		if (ret < 0) {
+			continue;
+		}
+
+		(void) utils_set_fd_cloexec(client_sock);
+		serve_client(client_sock);
+
+		ret = fd_tracker_close_unsuspendable_fd(
+			the_fd_tracker, &client_sock, 1, fd_tracker_util_close_fd, nullptr);
+		if (ret) {
+			PERROR("close");
+		}
+	}
+
+error:
+	lttng_relay_stop_threads();
+exit:
+	if (err) {
+		ERR("Metrics error occurred in %s", __func__);
+	}
+	DBG("Metrics thread dying");
+	if (sock >= 0) {
+		(void) unlink(path);
+		ret = fd_tracker_close_unsuspendable_fd(
+			the_fd_tracker, &sock, 1, fd_tracker_util_close_fd, nullptr);
+		if (ret) {
+			PERROR("close");
+		}
+	}
+
+	(void) fd_tracker_util_poll_clean(the_fd_tracker, &events);
+
+	rcu_unregister_thread();
+	return nullptr;
+}
@@ -0,0 +1,86 @@
+#ifndef _RELAY_METRICS_H
+#define _RELAY_METRICS_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdint.h>
+
+/*
+ * Ingestion and disk throughput metrics of the relay daemon.
+ *
+ * When a metrics socket path is set, a dedicated thread serves the metrics
+ * in the Prometheus text exposition format to each client connecting to
+ * this UNIX socket. A client sending an HTTP request receives an HTTP
+ * response, any other client receives the metrics alone.
+ *
+ * The counters are updated atomically by the threads which handle the data,
+ * without locks, and are only updated when the metrics are enabled.
+ */
+
+/* Counters of a session or a stream. */
+struct relay_stream_metrics {
+	/* Trace data bytes received from the data connections. */
+	uint64_t received_bytes;
+	uint64_t received_packets;
+	/* Index messages received from the control connections. */
+	uint64_t received_indexes;
+	/* Packets and indexes skipped as duplicates, see --deduplicate-packets. */
+	uint64_t duplicate_packets;
+	uint64_t duplicate_indexes;
+	/* Gaps in the network sequence numbers of the data packets. */
+	uint64_t missing_packets;
+	/* Gaps in the packet sequence numbers of the indexes. */
+	uint64_t missing_packet_seq_nums;
+};
+
+enum relay_metrics_duration {
+	/* Writes, or splices, of received data to the stream files. */
+	RELAY_METRICS_DURATION_STREAM_WRITE = 0,
+	/* Rotations of the streams of a session to a new trace chunk. */
+	RELAY_METRICS_DURATION_ROTATION = 1,
+
+	NR_RELAY_METRICS_DURATIONS,
+};
+
+struct relay_stream;
+
+bool relay_metrics_enabled();
+
+/*
+ * Enable the metrics by setting the path of the UNIX socket on which they
+ * are served.
+ *
+ * Return 0 on success, -1 if the path is invalid.
+ */
+int relay_metrics_set_socket_path(const char *path);
+
+/* Return the monotonic time to pass to relay_metrics_record_duration(), if enabled. */
+uint64_t relay_metrics_begin_duration();
+void relay_metrics_record_duration(enum relay_metrics_duration duration, uint64_t begin_ns);
+
+/* Account for data received from a data connection for a stream and its session. */
+void relay_metrics_count_received_bytes(struct relay_stream *stream, uint64_t len);
+void relay_metrics_count_received_packet(struct relay_stream *stream);
+void relay_metrics_count_received_index(struct relay_stream *stream);
+
+/* Account for the duplicates and the gaps found by the packet deduplication. */
+void relay_metrics_count_duplicate_packet(struct relay_stream *stream);
+void relay_metrics_count_duplicate_index(struct relay_stream *stream);
+void relay_metrics_count_missing_packets(struct relay_stream *stream, uint64_t count);
+void relay_metrics_count_missing_packet_seq_nums(struct relay_stream *stream, uint64_t count);
+
+/* Account for data sent to the live viewers. */
+void relay_metrics_count_viewer_sent_bytes(uint64_t len);
+
+/*
+ * Thread serving the metrics on the metrics socket until the relay daemon
+ * threads are stopped.
+ */
+void *thread_manage_metrics(void *data);
+
+#endif /* _RELAY_METRICS_H */
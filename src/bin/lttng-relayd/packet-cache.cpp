@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "packet-cache.hpp"
+
+#include <common/common.hpp>
+#include <common/utils.hpp>
+
+#include <sys/stat.h>
+#include <urcu/uatomic.h>
+
+namespace {
+/* Per stream, 0 when disabled. */
+uint64_t max_size;
+/* Updated atomically. */
+struct packet_cache_stats stats;
+
+void entry_release(struct urcu_ref *ref)
+{
+	auto *entry = lttng::utils::container_of(ref, &packet_cache_entry::ref);
+
+	lttng_dynamic_buffer_reset(&entry->data);
+	lttng_dynamic_buffer_reset(&entry->compressed);
+	pthread_mutex_destroy(&entry->compressed_lock);
+	free(entry);
+}
+
+void evict(struct packet_cache *cache, struct packet_cache_entry *entry)
+{
+	cds_list_del(&entry->node);
+	cache->size -= entry->data.size;
+	uatomic_sub(&stats.cached_bytes, entry->data.size);
+	uatomic_inc(&stats.evictions);
+	packet_cache_entry_put(entry);
+}
+
+void skip_packet(struct packet_cache *cache)
+{
+	(void) lttng_dynamic_buffer_set_size(&cache->pending, 0);
+	cache->pending_skipped = true;
+}
+} /* namespace */
+
+int packet_cache_set_size(const char *size)
+{
+	uint64_t value;
+
+	if (utils_parse_size_suffix(size, &value) || value == 0) {
+		ERR("Invalid packet cache size: `%s`", size);
+		return -1;
+	}
+
+	max_size = value;
+	return 0;
+}
+
+bool packet_cache_enabled()
+{
+	return max_size > 0;
+}
+
+void packet_cache_init(struct packet_cache *cache)
+{
+	CDS_INIT_LIST_HEAD(&cache->entries);
+	cache->size = 0;
+	cache->file_known = false;
+	lttng_dynamic_buffer_init(&cache->pending);
+	cache->pending_skipped = false;
+}
+
+void packet_cache_fini(struct packet_cache *cache)
+{
+	struct packet_cache_entry *entry, *tmp;
+
+	cds_list_for_each_entry_safe (entry, tmp, &cache->entries, node) {
+		evict(cache, entry);
+	}
+
+	lttng_dynamic_buffer_reset(&cache->pending);
+}
+
+void packet_cache_set_file(struct packet_cache *cache, int fd)
+{
+	struct packet_cache_entry *entry, *tmp;
+	struct stat file_stat;
+
+	if (!packet_cache_enabled()) {
+		return;
+	}
+
+	if (fd < 0 || fstat(fd, &file_stat)) {
+		ERR("Failed to identify stream file, not caching its packets");
+		cache->file_known = false;
+		return;
+	}
+
+	/* The identity of a removed stream file may be reused by the new one. */
+	cds_list_for_each_entry_safe (entry, tmp, &cache->entries, node) {
+		if (entry->file_dev == file_stat.st_dev && entry->file_ino == file_stat.st_ino) {
+			evict(cache, entry);
+		}
+	}
+
+	cache->file_dev = file_stat.st_dev;
+	cache->file_ino = file_stat.st_ino;
+	cache->file_known = true;
+}
+
+void packet_cache_begin_packet(struct packet_cache *cache, size_t data_size)
+{
+	if (!packet_cache_enabled()) {
+		return;
+	}
+
+	(void) lttng_dynamic_buffer_set_size(&cache->pending, 0);
+	cache->pending_skipped = !cache->file_known || data_size > max_size ||
+		lttng_dynamic_buffer_set_capacity(&cache->pending, data_size);
+}
+
+void packet_cache_append(struct packet_cache *cache, const void *data, size_t len)
+{
+	if (!packet_cache_enabled() || cache->pending_skipped) {
+		return;
+	}
+
+	if (lttng_dynamic_buffer_append(&cache->pending, data, len)) {
+		/* The packet isn't cached, the viewers read it from the stream file. */
+		skip_packet(cache);
+	}
+}
+
+void packet_cache_commit_packet(struct packet_cache *cache, uint64_t offset, uint64_t packet_size)
+{
+	struct packet_cache_entry *entry;
+
+	if (!packet_cache_enabled() || cache->pending_skipped || cache->pending.size == 0) {
+		return;
+	}
+
+	entry = zmalloc<packet_cache_entry>();
+	if (!entry) {
+		PERROR("Failed to allocate cached packet");
+		return;
+	}
+
+	urcu_ref_init(&entry->ref);
+	entry->file_dev = cache->file_dev;
+	entry->file_ino = cache->file_ino;
+	entry->offset = offset;
+	entry->packet_size = packet_size;
+	pthread_mutex_init(&entry->compressed_lock, nullptr);
+	lttng_dynamic_buffer_init(&entry->compressed);
+	/* The received data moves to the cache: the next packet is received in a new buffer. */
+	entry->data = cache->pending;
+	lttng_dynamic_buffer_init(&cache->pending);
+
+	cds_list_add_tail(&entry->node, &cache->entries);
+	cache->size += entry->data.size;
+	uatomic_add(&stats.cached_bytes, entry->data.size);
+
+	while (cache->size > max_size) {
+		evict(cache,
+		      cds_list_first_entry(&cache->entries, struct packet_cache_entry, node));
+	}
+}
+
+struct packet_cache_entry *packet_cache_lookup(
+	struct packet_cache *cache, dev_t file_dev, ino_t file_ino, uint64_t offset, uint64_t len)
+{
+	struct packet_cache_entry *entry;
+
+	if (!packet_cache_enabled()) {
+		return nullptr;
+	}
+
+	/* The viewers mostly read the most recent packets. */
+	cds_list_for_each_entry_reverse (entry, &cache->entries, node) {
+		if (entry->offset == offset && entry->file_ino == file_ino &&
+		    entry->file_dev == file_dev && len <= entry->packet_size) {
+			urcu_ref_get(&entry->ref);
+			uatomic_inc(&stats.hits);
+			return entry;
+		}
+	}
+
+	uatomic_inc(&stats.misses);
+	return nullptr;
+}
+
+void packet_cache_entry_put(struct packet_cache_entry *entry)
+{
+	urcu_ref_put(&entry->ref, entry_release);
+}
+
+void packet_cache_get_stats(struct packet_cache_stats *stats_out)
+{
+	stats_out->hits = uatomic_read(&stats.hits);
+	stats_out->misses = uatomic_read(&stats.misses);
+	stats_out->cached_bytes = uatomic_read(&stats.cached_bytes);
+	stats_out->evictions = uatomic_read(&stats.evictions);
+}
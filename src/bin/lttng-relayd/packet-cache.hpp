@@ -0,0 +1,136 @@
+#ifndef _PACKET_CACHE_H
+#define _PACKET_CACHE_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/dynamic-buffer.hpp>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <urcu/list.h>
+#include <urcu/ref.h>
+
+/*
+ * Cache of the most recent packets of the data streams, shared by their
+ * live viewers.
+ *
+ * When a packet cache size is set, the data of each packet received into
+ * user space is copied into the cache of its stream as it is written to the
+ * stream file. Once the cached packets of a stream exceed the size, its
+ * oldest packets are evicted. The packets which the live viewers find in the
+ * cache of their stream are sent from it rather than read from the stream
+ * file, so that the viewers of a session don't read the same recent packets
+ * from the disk.
+ *
+ * The packets are identified by their stream file, which may be replaced
+ * while the viewers read it, and their offset in it. The packets of the
+ * metadata streams are not cached. The packets of the data streams are
+ * received into user space, rather than spliced to the stream files, while
+ * the cache is enabled.
+ *
+ * The cache of a stream is protected by the stream lock. A cached packet is
+ * immutable, except for its compressed form which has its own lock, and holds
+ * a reference which lets the viewers send it without holding the stream lock.
+ */
+struct packet_cache_entry {
+	struct urcu_ref ref;
+	/* Stream file of the packet. */
+	dev_t file_dev;
+	ino_t file_ino;
+	uint64_t offset;
+	/* Size of the packet, padding included. */
+	uint64_t packet_size;
+	/* Data of the packet, without its padding. */
+	struct lttng_dynamic_buffer data;
+	/*
+	 * Packet compressed with zstd for the live viewers which support it,
+	 * computed by the first one and not accounted for in the size of the
+	 * cache. Empty if the compression doesn't reduce the size of the packet.
+	 */
+	pthread_mutex_t compressed_lock;
+	struct lttng_dynamic_buffer compressed;
+	/* Bytes of the packet, padding included, which were compressed, 0 until then. */
+	uint64_t compressed_len;
+	struct cds_list_head node;
+};
+
+struct packet_cache {
+	/* struct packet_cache_entry, oldest first. */
+	struct cds_list_head entries;
+	/* Bytes of data of the cached packets. */
+	uint64_t size;
+	/* Stream file being written, unknown if `file_known` is false. */
+	dev_t file_dev;
+	ino_t file_ino;
+	bool file_known;
+	/* Data of the packet being received. */
+	struct lttng_dynamic_buffer pending;
+	/* Set if the packet being received can't be cached. */
+	bool pending_skipped;
+};
+
+struct packet_cache_stats {
+	/* Packets requested by the live viewers, found or not in the caches. */
+	uint64_t hits;
+	uint64_t misses;
+	/* Bytes of data of the cached packets. */
+	uint64_t cached_bytes;
+	/* Packets evicted from the caches. */
+	uint64_t evictions;
+};
+
+/*
+ * Set the maximal size, in bytes, of the cached packets of each stream from
+ * a size with an optional `k`, `M` or `G` suffix.
+ *
+ * Return 0 on success, -1 if the size is invalid.
+ */
+int packet_cache_set_size(const char *size);
+
+bool packet_cache_enabled();
+
+void packet_cache_init(struct packet_cache *cache);
+/* Evict all the cached packets. */
+void packet_cache_fini(struct packet_cache *cache);
+
+/*
+ * Set the stream file written from now on, evicting the packets of a
+ * previous file which had the same identity. The packets of the file
+ * aren't cached if `fd` is -1.
+ */
+void packet_cache_set_file(struct packet_cache *cache, int fd);
+
+/* Start the reception of a packet of `data_size` bytes, padding excluded. */
+void packet_cache_begin_packet(struct packet_cache *cache, size_t data_size);
+
+/* Copy received data of the packet being received. */
+void packet_cache_append(struct packet_cache *cache, const void *data, size_t len);
+
+/*
+ * Cache the packet which was received, of `packet_size` bytes, padding
+ * included, at `offset` of the current stream file.
+ */
+void packet_cache_commit_packet(struct packet_cache *cache, uint64_t offset, uint64_t packet_size);
+
+/*
+ * Look up the packet of at least `len` bytes at `offset` of the stream file
+ * identified by `file_dev` and `file_ino`, accounting for the hit or the
+ * miss.
+ *
+ * Return a reference to the cached packet, to release with
+ * packet_cache_entry_put(), or null if it isn't cached.
+ */
+struct packet_cache_entry *packet_cache_lookup(
+	struct packet_cache *cache, dev_t file_dev, ino_t file_ino, uint64_t offset, uint64_t len);
+
+void packet_cache_entry_put(struct packet_cache_entry *entry);
+
+void packet_cache_get_stats(struct packet_cache_stats *stats);
+
+#endif /* _PACKET_CACHE_H */
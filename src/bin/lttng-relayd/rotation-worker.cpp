@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "rotation-worker.hpp"
+
+#include <common/common.hpp>
+#include <common/defaults.hpp>
+#include <common/thread-pool.hpp>
+#include <common/urcu.hpp>
+
+#include <urcu.h>
+
+namespace {
+/* Objects left behind by a stream, released in the order of the fields. */
+struct rotation_job {
+	struct lttng_thread_pool_work work;
+	struct fs_handle *file;
+	bool trim_preallocation;
+	struct lttng_index_file *index_file;
+	struct lttng_trace_chunk *chunk;
+};
+
+/* Set while the rotation threads run, read under the RCU read lock. */
+struct lttng_thread_pool *rotation_pool;
+
+void run_job(struct rotation_job *job)
+{
+	if (job->file) {
+		if (job->trim_preallocation && fs_handle_trim_preallocation(job->file)) {
+			PERROR("Failed to release the preallocated blocks of a stream file");
+		}
+
+		if (fs_handle_close(job->file)) {
+			PERROR("Failed to close a stream file");
+		}
+	}
+
+	if (job->index_file) {
+		lttng_index_file_put(job->index_file);
+	}
+
+	lttng_trace_chunk_put(job->chunk);
+}
+
+void run_queued_job(struct lttng_thread_pool_work *work)
+{
+	struct rotation_job *job = lttng::utils::container_of(work, &rotation_job::work);
+
+	run_job(job);
+	free(job);
+}
+
+/*
+ * Queue a job to the rotation threads, or run it when they are stopped.
+ * Ownership of the job is transferred.
+ */
+void queue_job(struct rotation_job *job)
+{
+	if (!rotation_workers_submit(&job->work)) {
+		run_queued_job(&job->work);
+	}
+}
+
+void release_inline(struct fs_handle *file,
+		    bool trim_preallocation,
+		    struct lttng_index_file *index_file,
+		    struct lttng_trace_chunk *chunk)
+{
+	struct rotation_job job = {};
+
+	job.file = file;
+	job.trim_preallocation = trim_preallocation;
+	job.index_file = index_file;
+	job.chunk = chunk;
+	run_job(&job);
+}
+
+/* Take ownership of the objects and release them from a rotation thread. */
+void release(struct fs_handle *file,
+	     bool trim_preallocation,
+	     struct lttng_index_file *index_file,
+	     struct lttng_trace_chunk *chunk)
+{
+	struct rotation_job *job;
+
+	if (!rotation_workers_enabled()) {
+		release_inline(file, trim_preallocation, index_file, chunk);
+		return;
+	}
+
+	job = zmalloc<rotation_job>();
+	if (!job) {
+		PERROR("Failed to allocate rotation job");
+		release_inline(file, trim_preallocation, index_file, chunk);
+		return;
+	}
+
+	job->work.run = run_queued_job;
+	job->file = file;
+	job->trim_preallocation = trim_preallocation;
+	job->index_file = index_file;
+	job->chunk = chunk;
+	queue_job(job);
+}
+} /* namespace */
+
+int rotation_workers_create(unsigned int count)
+{
+	struct lttng_thread_pool_attr attr = {};
+	struct lttng_thread_pool *pool;
+
+	LTTNG_ASSERT(!rotation_pool);
+	LTTNG_ASSERT(count > 0);
+
+	attr.name = "Rotation";
+	attr.thread_count = count;
+	pool = lttng_thread_pool_create(&attr);
+	if (!pool) {
+		ERR("Failed to create the relay rotation workers");
+		return -1;
+	}
+
+	rcu_assign_pointer(rotation_pool, pool);
+	DBG("Relay rotation workers enabled: count = %u", count);
+	return 0;
+}
+
+void rotation_workers_destroy()
+{
+	struct lttng_thread_pool *pool = rcu_xchg_pointer(&rotation_pool, nullptr);
+
+	if (!pool) {
+		return;
+	}
+
+	/* Wait for the threads queueing jobs to the pool as it is unpublished. */
+	synchronize_rcu();
+	lttng_thread_pool_destroy(pool);
+}
+
+bool rotation_workers_enabled()
+{
+	return uatomic_read(&rotation_pool) != nullptr;
+}
+
+void rotation_workers_close_file(struct fs_handle *file,
+				 bool trim_preallocation,
+				 struct lttng_trace_chunk *chunk)
+{
+	if (!file) {
+		return;
+	}
+
+	if (chunk) {
+		const bool reference_acquired = lttng_trace_chunk_get(chunk);
+
+		LTTNG_ASSERT(reference_acquired);
+	}
+
+	release(file, trim_preallocation, nullptr, chunk);
+}
+
+void rotation_workers_put_index_file(struct lttng_index_file *index_file)
+{
+	if (!index_file) {
+		return;
+	}
+
+	release(nullptr, false, index_file, nullptr);
+}
+
+bool rotation_workers_submit(struct lttng_thread_pool_work *work)
+{
+	const lttng::urcu::read_lock_guard read_lock;
+	struct lttng_thread_pool *pool = rcu_dereference(rotation_pool);
+
+	return pool && lttng_thread_pool_submit(pool, work);
+}
+
+void rotation_workers_put_trace_chunk(struct lttng_trace_chunk *chunk)
+{
+	if (!chunk) {
+		return;
+	}
+
+	release(nullptr, false, nullptr, chunk);
+}
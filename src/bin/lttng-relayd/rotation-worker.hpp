@@ -0,0 +1,72 @@
+#ifndef _ROTATION_WORKER_H
+#define _ROTATION_WORKER_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/fs-handle.hpp>
+#include <common/index/index.hpp>
+#include <common/thread-pool.hpp>
+#include <common/trace-chunk.hpp>
+
+/*
+ * Rotation threads of the relay daemon.
+ *
+ * When enabled, the threads rotating or closing the streams only switch
+ * them to their new files and trace chunk. The files and the trace chunks
+ * they leave behind are queued to the rotation threads which close the
+ * files and release the trace chunks. The release of the last reference to
+ * a trace chunk performs its close command, if any, such as the rename of
+ * its directory to the archived trace chunks.
+ *
+ * The rotation threads keep a reference to the trace chunk of each file
+ * until the file is closed; a trace chunk is thus never released before
+ * the files it contains are closed.
+ *
+ * When disabled, or when the rotation threads are stopped, the files are
+ * closed and the trace chunks released by the caller.
+ *
+ * The rotation threads also open the next trace files of the streams ahead
+ * of their rotation, see stream_init_packet().
+ */
+
+/*
+ * Start `count` rotation threads.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int rotation_workers_create(unsigned int count);
+
+/* Handle the queued files and trace chunks and stop the rotation threads. */
+void rotation_workers_destroy();
+
+bool rotation_workers_enabled();
+
+/*
+ * Close `file`, created in `chunk`, after releasing its preallocated blocks
+ * if `trim_preallocation` is set. Ownership of the file is transferred; the
+ * caller keeps its reference to `chunk`, if any.
+ */
+void rotation_workers_close_file(struct fs_handle *file,
+				 bool trim_preallocation,
+				 struct lttng_trace_chunk *chunk);
+
+/* Release a reference to an index file. `index_file` may be NULL. */
+void rotation_workers_put_index_file(struct lttng_index_file *index_file);
+
+/*
+ * Run `work` on a rotation thread, transferring its ownership.
+ *
+ * Return false, keeping the ownership with the caller, when the rotation
+ * threads are disabled or stopped.
+ */
+bool rotation_workers_submit(struct lttng_thread_pool_work *work);
+
+/* Release a reference to a trace chunk. `chunk` may be NULL. */
+void rotation_workers_put_trace_chunk(struct lttng_trace_chunk *chunk);
+
+#endif /* _ROTATION_WORKER_H */
@@ -9,6 +9,8 @@
 
 #define _LGPL_SOURCE
 #include "ctf-trace.hpp"
+#include "ephemeral-live.hpp"
+#include "forwarder.hpp"
 #include "lttng-relayd.hpp"
 #include "session.hpp"
 #include "sessiond-trace-chunks.hpp"
@@ -24,13 +26,155 @@
 #include <common/utils.hpp>
 #include <common/uuid.hpp>
 
+#include <algorithm>
 #include <sys/stat.h>
 #include <urcu/rculist.h>
+#include <urcu/uatomic.h>
 
 /* Global session id used in the session creation. */
 static uint64_t last_relay_session_id;
 static pthread_mutex_t last_relay_session_id_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Generation of the last change of a session and greatest generation of the
+ * destroyed sessions. Protected by the generation lock so that the sessions
+ * changed at a generation have their `generation` set once it is read.
+ */
+static uint64_t last_session_generation;
+static uint64_t destroyed_session_generation;
+static pthread_mutex_t session_generation_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Sessions of a hostname. Kept until the relay daemon exits. */
+struct relay_session_host {
+	struct lttng_ht_node_str node;
+	char hostname[LTTNG_HOST_NAME_MAX];
+	struct cds_list_head sessions; /* RCU list of struct relay_session. */
+};
+
+/* Hosts indexed by hostname. */
+static struct lttng_ht *session_hosts_ht;
+/* Protects the addition of the hosts and the updates of their session list. */
+static pthread_mutex_t session_hosts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Should be called with RCU read-side lock held. */
+static struct relay_session_host *session_host_lookup(const char *hostname)
+{
+	struct lttng_ht_node_str *node;
+	struct lttng_ht_iter iter;
+
+	lttng_ht_lookup(session_hosts_ht, hostname, &iter);
+	node = lttng_ht_iter_get_node_str(&iter);
+	if (!node) {
+		return nullptr;
+	}
+
+	return lttng::utils::container_of(node, &relay_session_host::node);
+}
+
+static int session_host_add(struct relay_session *session)
+{
+	int ret = 0;
+	struct relay_session_host *host;
+	lttng::urcu::read_lock_guard read_lock;
+
+	pthread_mutex_lock(&session_hosts_lock);
+	host = session_host_lookup(session->hostname);
+	if (!host) {
+		host = zmalloc<relay_session_host>();
+		if (!host) {
+			PERROR("Failed to allocate session host");
+			ret = -1;
+			goto end;
+		}
+
+		memcpy(host->hostname, session->hostname, sizeof(host->hostname));
+		CDS_INIT_LIST_HEAD(&host->sessions);
+		lttng_ht_node_init_str(&host->node, host->hostname);
+		lttng_ht_add_unique_str(session_hosts_ht, &host->node);
+	}
+
+	cds_list_add_rcu(&session->host_node, &host->sessions);
+end:
+	pthread_mutex_unlock(&session_hosts_lock);
+	return ret;
+}
+
+static void session_host_remove(struct relay_session *session)
+{
+	pthread_mutex_lock(&session_hosts_lock);
+	cds_list_del_rcu(&session->host_node);
+	pthread_mutex_unlock(&session_hosts_lock);
+}
+
+int session_hosts_init()
+{
+	session_hosts_ht = lttng_ht_new(0, LTTNG_HT_TYPE_STRING);
+	return session_hosts_ht ? 0 : -1;
+}
+
+void session_hosts_fini()
+{
+	struct lttng_ht_iter iter;
+	struct relay_session_host *host;
+
+	if (!session_hosts_ht) {
+		return;
+	}
+
+	{
+		lttng::urcu::read_lock_guard read_lock;
+
+		cds_lfht_for_each_entry (session_hosts_ht->ht, &iter.iter, host, node.node) {
+			const int ret = lttng_ht_del(session_hosts_ht, &iter);
+
+			LTTNG_ASSERT(!ret);
+			/* No session remains once the relay daemon exits. */
+			LTTNG_ASSERT(cds_list_empty(&host->sessions));
+			free(host);
+		}
+	}
+
+	lttng_ht_destroy(session_hosts_ht);
+	session_hosts_ht = nullptr;
+}
+
+struct cds_list_head *session_get_host_sessions(const char *hostname)
+{
+	struct relay_session_host *host;
+
+	ASSERT_RCU_READ_LOCKED();
+
+	host = session_host_lookup(hostname);
+	return host ? &host->sessions : nullptr;
+}
+
+void session_mark_changed(struct relay_session *session)
+{
+	pthread_mutex_lock(&session_generation_lock);
+	uatomic_set(&session->generation, ++last_session_generation);
+	pthread_mutex_unlock(&session_generation_lock);
+}
+
+uint64_t session_get_generation()
+{
+	uint64_t generation;
+
+	pthread_mutex_lock(&session_generation_lock);
+	generation = last_session_generation;
+	pthread_mutex_unlock(&session_generation_lock);
+	return generation;
+}
+
+uint64_t session_get_destroyed_generation()
+{
+	uint64_t generation;
+
+	pthread_mutex_lock(&session_generation_lock);
+	generation = destroyed_session_generation;
+	pthread_mutex_unlock(&session_generation_lock);
+	return generation;
+}
+
 static int init_session_output_path_group_by_host(struct relay_session *session)
 {
 	/*
@@ -222,6 +366,14 @@ static int session_set_anonymous_chunk(struct relay_session *session)
 	}
 
 	lttng_trace_chunk_set_fd_tracker(chunk, the_fd_tracker);
+	if (ephemeral_live_session(session)) {
+		status = lttng_trace_chunk_set_memory_files(chunk);
+		if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+			ret = -1;
+			goto end;
+		}
+	}
+
 	status = lttng_trace_chunk_set_credentials_current_user(chunk);
 	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
 		ret = -1;
@@ -326,8 +478,12 @@ struct relay_session *session_create(const char *session_name,
 	lttng_ht_node_init_u64(&session->session_n, session->id);
 	urcu_ref_init(&session->ref);
 	CDS_INIT_LIST_HEAD(&session->recv_list);
+	CDS_INIT_LIST_HEAD(&session->host_node);
 	pthread_mutex_init(&session->lock, nullptr);
 	pthread_mutex_init(&session->recv_list_lock, nullptr);
+	CDS_INIT_LIST_HEAD(&session->viewer_streams);
+	pthread_mutex_init(&session->viewer_streams_lock, nullptr);
+	ingest_bucket_init(&session->ingest, hostname);
 
 	if (lttng_strncpy(session->session_name, session_name, sizeof(session->session_name))) {
 		WARN("Session name exceeds maximal allowed length");
@@ -428,6 +584,11 @@ struct relay_session *session_create(const char *session_name,
 		}
 	}
 
+	if (session_host_add(session)) {
+		goto error;
+	}
+
+	session_mark_changed(session);
 	lttng_ht_add_unique_u64(sessions_ht, &session->session_n);
 	return session;
 
@@ -471,6 +632,11 @@ end:
 	return session;
 }
 
+bool session_streams_have_index(const struct relay_session *session)
+{
+	return session->minor >= 4 && !session->snapshot;
+}
+
 /*
  * Check if any of the relay sessions originating from the same
  * session daemon session have the 'ongoing_rotation' state set.
@@ -588,8 +754,15 @@ static void destroy_session(struct relay_session *session)
 {
 	int ret;
 
+	/* All the data of the session was received once it is destroyed. */
+	forwarder_destroy_session(session);
 	ret = session_delete(session);
 	LTTNG_ASSERT(!ret);
+	session_host_remove(session);
+	/* The generation of the session is set with the generation lock held. */
+	pthread_mutex_lock(&session_generation_lock);
+	destroyed_session_generation = std::max(destroyed_session_generation, session->generation);
+	pthread_mutex_unlock(&session_generation_lock);
 	lttng_trace_chunk_put(session->current_trace_chunk);
 	session->current_trace_chunk = nullptr;
 	lttng_trace_chunk_put(session->pending_closure_trace_chunk);
@@ -631,6 +804,7 @@ int session_close(struct relay_session *session)
 	    session->connection_closed);
 	session->connection_closed = true;
 	pthread_mutex_unlock(&session->lock);
+	session_mark_changed(session);
 
 	{
 		lttng::urcu::read_lock_guard read_lock;
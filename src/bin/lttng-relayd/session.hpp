@@ -10,6 +10,9 @@
  *
  */
 
+#include "ingest-limiter.hpp"
+#include "metrics.hpp"
+
 #include <common/hashtable/hashtable.hpp>
 #include <common/optional.hpp>
 #include <common/trace-chunk.hpp>
@@ -112,6 +115,16 @@ struct relay_session {
 	uint32_t stream_count;
 	pthread_mutex_t recv_list_lock;
 
+	/*
+	 * Viewer streams of the streams of the session, so that the live
+	 * viewers don't walk the viewer streams of all the sessions.
+	 *
+	 * Updates are protected by the viewer_streams_lock.
+	 * Traversals are protected by RCU.
+	 */
+	struct cds_list_head viewer_streams; /* RCU list. */
+	pthread_mutex_t viewer_streams_lock;
+
 	/*
 	 * Flag checked and exchanged with uatomic_cmpxchg to tell the
 	 * viewer-side if new streams got added since the last check.
@@ -122,6 +135,17 @@ struct relay_session {
 	 * Node in the global session hash table.
 	 */
 	struct lttng_ht_node_u64 session_n;
+	/*
+	 * Member of the session list of the hostname of the session, see
+	 * session_get_host_sessions(). Updates are protected by the lock of
+	 * the session hosts. Traversals are protected by RCU.
+	 */
+	struct cds_list_head host_node;
+	/*
+	 * Generation of the last change of the session which the live viewers
+	 * see in its listing, see session_mark_changed(). Updated atomically.
+	 */
+	uint64_t generation;
 	/*
 	 * Member of the session list in struct relay_viewer_session.
 	 * Updates are protected by the relay_viewer_session
@@ -136,6 +160,10 @@ struct relay_session {
 	 */
 	bool ongoing_rotation;
 	struct lttng_directory_handle *output_directory;
+	/* Ingestion limits of the data connections of the session. */
+	struct relay_ingest_bucket ingest;
+	/* Updated atomically, see metrics.hpp. */
+	struct relay_stream_metrics metrics;
 	struct rcu_head rcu_node; /* For call_rcu teardown. */
 };
 
@@ -158,7 +186,43 @@ void session_put(struct relay_session *session);
 int session_close(struct relay_session *session);
 int session_abort(struct relay_session *session);
 
+/*
+ * Account for a change of the session which the live viewers see in its
+ * listing: its creation, its closure, the attachment of a viewer or a stream
+ * count change.
+ */
+void session_mark_changed(struct relay_session *session);
+
+/*
+ * Return the generation of the last change of a session.
+ *
+ * The sessions changed after a generation are those whose `generation` is
+ * greater than it.
+ */
+uint64_t session_get_generation();
+
+/*
+ * Return the greatest generation of the sessions which were destroyed.
+ *
+ * A live viewer which listed the sessions at an earlier generation may have
+ * missed the closure of a session which no longer exists and must list all
+ * the sessions again.
+ */
+uint64_t session_get_destroyed_generation();
+
+/*
+ * Return the list of the sessions of a hostname, linked by their
+ * `host_node`, or null if no session of the hostname was created.
+ *
+ * Must be called with the RCU read-side lock held.
+ */
+struct cds_list_head *session_get_host_sessions(const char *hostname);
+
+int session_hosts_init();
+void session_hosts_fini();
+
 bool session_has_ongoing_rotation(const struct relay_session *session);
+bool session_streams_have_index(const struct relay_session *session);
 
 void print_sessions(void);
 
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "ctf-trace.hpp"
+#include "health-relayd.hpp"
+#include "session.hpp"
+#include "stream-writer.hpp"
+#include "write-scheduler.hpp"
+
+#include <common/common.hpp>
+#include <common/defaults.hpp>
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <urcu.h>
+#include <urcu/list.h>
+
+namespace {
+struct stream_writer {
+	unsigned int id;
+	pthread_t thread;
+	bool thread_created;
+	pthread_mutex_t lock;
+	/* Signaled when a packet is queued or when the thread must quit. */
+	pthread_cond_t packet_queued;
+	/* Signaled when a queued packet has been handled. */
+	pthread_cond_t packet_written;
+	/* Queued stream_write_packet, protected by `lock`. */
+	struct cds_list_head packets;
+	bool quit;
+};
+
+struct stream_writer *writers;
+unsigned int writer_count;
+uint64_t stream_max_queued_size;
+
+/*
+ * Write a packet to the output file of its stream and complete it, as the
+ * worker threads do when the writer stage is disabled.
+ *
+ * Return 0 on success else a negative value.
+ */
+int write_packet(struct stream_write_packet *packet)
+{
+	int ret;
+	struct relay_stream *stream = packet->stream;
+	struct relay_session *session = stream->trace->session;
+	const struct lttcomm_relayd_data_hdr *header = &packet->header;
+	bool rotate_index = false, new_stream = false, close_requested;
+
+	pthread_mutex_lock(&stream->lock);
+	ret = stream_init_packet(stream, header->data_size, &rotate_index);
+	if (ret) {
+		ERR("Failed to rotate stream output file");
+		goto end_stream_unlock;
+	}
+
+	if (packet->data.size > 0) {
+		const struct lttng_buffer_view packet_view =
+			lttng_buffer_view_from_dynamic_buffer(&packet->data, 0, -1);
+
+		ret = stream_write(stream, &packet_view, 0);
+		if (ret) {
+			ERR("Relay error writing data to file");
+			goto end_stream_unlock;
+		}
+	}
+
+	ret = stream_commit_packet(stream,
+				   header->net_seq_num,
+				   header->data_size,
+				   header->padding_size,
+				   rotate_index,
+				   &new_stream);
+
+end_stream_unlock:
+	close_requested = stream->close_requested;
+	pthread_mutex_unlock(&stream->lock);
+	if (close_requested) {
+		try_stream_close(stream);
+	}
+
+	if (new_stream) {
+		pthread_mutex_lock(&session->lock);
+		uatomic_set(&session->new_streams, 1);
+		pthread_mutex_unlock(&session->lock);
+	}
+
+	return ret;
+}
+
+void *stream_writer_thread(void *data)
+{
+	struct stream_writer *writer = (struct stream_writer *) data;
+
+	DBG("[thread] Relay stream writer %u started", writer->id);
+
+	rcu_register_thread();
+
+	pthread_mutex_lock(&writer->lock);
+	while (true) {
+		struct stream_write_packet *packet;
+		int ret;
+
+		if (cds_list_empty(&writer->packets)) {
+			if (writer->quit) {
+				break;
+			}
+
+			pthread_cond_wait(&writer->packet_queued, &writer->lock);
+			continue;
+		}
+
+		packet = cds_list_first_entry(&writer->packets, struct stream_write_packet, node);
+		cds_list_del(&packet->node);
+		pthread_mutex_unlock(&writer->lock);
+
+		/* Hold back the write, without any lock, while the write budget is overspent. */
+		write_scheduler_wait();
+		ret = write_packet(packet);
+
+		pthread_mutex_lock(&writer->lock);
+		packet->stream->queued_write_size -= packet->data.size;
+		if (ret) {
+			packet->stream->write_error = true;
+		}
+
+		pthread_cond_broadcast(&writer->packet_written);
+		pthread_mutex_unlock(&writer->lock);
+
+		stream_write_packet_destroy(packet);
+		pthread_mutex_lock(&writer->lock);
+	}
+	pthread_mutex_unlock(&writer->lock);
+
+	DBG("Relay stream writer %u exiting", writer->id);
+	rcu_unregister_thread();
+	return nullptr;
+}
+} /* namespace */
+
+int stream_writers_create(unsigned int count, uint64_t max_queued_size)
+{
+	int ret;
+
+	LTTNG_ASSERT(!writers);
+
+	writers = calloc<stream_writer>(count);
+	if (!writers) {
+		PERROR("Failed to allocate relay stream writers");
+		return -1;
+	}
+
+	writer_count = count;
+	stream_max_queued_size = max_queued_size;
+	for (unsigned int i = 0; i < count; i++) {
+		struct stream_writer *writer = &writers[i];
+
+		writer->id = i;
+		pthread_mutex_init(&writer->lock, nullptr);
+		pthread_cond_init(&writer->packet_queued, nullptr);
+		pthread_cond_init(&writer->packet_written, nullptr);
+		CDS_INIT_LIST_HEAD(&writer->packets);
+	}
+
+	for (unsigned int i = 0; i < count; i++) {
+		struct stream_writer *writer = &writers[i];
+
+		ret = pthread_create(
+			&writer->thread, default_pthread_attr(), stream_writer_thread, writer);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create stream writer %u", i);
+			return -1;
+		}
+
+		writer->thread_created = true;
+	}
+
+	DBG("Relay stream writers enabled: count = %u, maximal queued size per stream = %" PRIu64
+	    " bytes",
+	    count,
+	    max_queued_size);
+	return 0;
+}
+
+void stream_writers_destroy()
+{
+	if (!writers) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < writer_count; i++) {
+		struct stream_writer *writer = &writers[i];
+
+		pthread_mutex_lock(&writer->lock);
+		writer->quit = true;
+		pthread_cond_signal(&writer->packet_queued);
+		pthread_mutex_unlock(&writer->lock);
+	}
+
+	for (unsigned int i = 0; i < writer_count; i++) {
+		struct stream_writer *writer = &writers[i];
+
+		if (writer->thread_created) {
+			const int ret = pthread_join(writer->thread, nullptr);
+
+			if (ret) {
+				errno = ret;
+				PERROR("pthread_join stream writer %u", i);
+			}
+		}
+
+		LTTNG_ASSERT(cds_list_empty(&writer->packets));
+		pthread_mutex_destroy(&writer->lock);
+		pthread_cond_destroy(&writer->packet_queued);
+		pthread_cond_destroy(&writer->packet_written);
+	}
+
+	free(writers);
+	writers = nullptr;
+	writer_count = 0;
+}
+
+bool stream_writers_enabled()
+{
+	return writer_count > 0;
+}
+
+struct stream_write_packet *
+stream_write_packet_create(struct relay_stream *stream,
+			   const struct lttcomm_relayd_data_hdr *header)
+{
+	struct stream_write_packet *packet;
+
+	packet = zmalloc<stream_write_packet>();
+	if (!packet) {
+		PERROR("Failed to allocate stream packet");
+		goto error;
+	}
+
+	lttng_dynamic_buffer_init(&packet->data);
+	if (lttng_dynamic_buffer_set_size(&packet->data, header->data_size)) {
+		ERR("Failed to allocate stream packet buffer: stream_id = %" PRIu64
+		    ", size = %" PRIu32,
+		    stream->stream_handle,
+		    header->data_size);
+		lttng_dynamic_buffer_reset(&packet->data);
+		free(packet);
+		goto error;
+	}
+
+	packet->stream = stream;
+	packet->header = *header;
+	CDS_INIT_LIST_HEAD(&packet->node);
+	return packet;
+
+error:
+	return nullptr;
+}
+
+void stream_write_packet_destroy(struct stream_write_packet *packet)
+{
+	if (!packet) {
+		return;
+	}
+
+	stream_put(packet->stream);
+	lttng_dynamic_buffer_reset(&packet->data);
+	free(packet);
+}
+
+int stream_writers_queue(struct stream_write_packet *packet)
+{
+	int ret = 0;
+	struct relay_stream *stream = packet->stream;
+	struct stream_writer *writer = &writers[stream->stream_handle % writer_count];
+
+	pthread_mutex_lock(&writer->lock);
+
+	/* A packet larger than the queue is queued once the queue is empty. */
+	while (!stream->write_error && stream->queued_write_size > 0 &&
+	       stream->queued_write_size + packet->data.size > stream_max_queued_size) {
+		DBG3("Waiting for the writer thread of stream %" PRIu64
+		     ": queued size = %" PRIu64 " bytes",
+		     stream->stream_handle,
+		     stream->queued_write_size);
+		health_poll_entry();
+		pthread_cond_wait(&writer->packet_written, &writer->lock);
+		health_poll_exit();
+	}
+
+	if (stream->write_error) {
+		ERR("Failed to write a previous packet of stream %" PRIu64, stream->stream_handle);
+		ret = -1;
+		goto end_unlock;
+	}
+
+	stream->queued_write_size += packet->data.size;
+	cds_list_add_tail(&packet->node, &writer->packets);
+	packet = nullptr;
+	pthread_cond_signal(&writer->packet_queued);
+
+end_unlock:
+	pthread_mutex_unlock(&writer->lock);
+	stream_write_packet_destroy(packet);
+	return ret;
+}
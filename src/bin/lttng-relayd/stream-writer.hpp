@@ -0,0 +1,70 @@
+#ifndef _STREAM_WRITER_H
+#define _STREAM_WRITER_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include "stream.hpp"
+
+#include <common/dynamic-buffer.hpp>
+#include <common/sessiond-comm/relayd.hpp>
+
+#include <stdint.h>
+#include <urcu/list.h>
+
+/*
+ * Asynchronous writer stage of the data streams.
+ *
+ * When enabled, the worker threads receive the packets of the data
+ * connections into buffers which they queue to writer threads. A writer
+ * thread writes the queued packets to the stream files and completes them,
+ * so that a slow file system only stalls the reception of the streams it
+ * holds up.
+ *
+ * The packets of a stream are always handled by the same writer thread, in
+ * order. The reception of a packet waits for the writer thread only when the
+ * queue of its stream is full.
+ */
+struct stream_write_packet {
+	/* Reference held by the packet. */
+	struct relay_stream *stream;
+	struct lttcomm_relayd_data_hdr header;
+	/* Data of the packet, `header.data_size` bytes. */
+	struct lttng_dynamic_buffer data;
+	struct cds_list_head node;
+};
+
+/*
+ * Start `count` writer threads, each stream queuing at most
+ * `max_queued_size` bytes of packets.
+ */
+int stream_writers_create(unsigned int count, uint64_t max_queued_size);
+
+/* Write the queued packets and stop the writer threads. */
+void stream_writers_destroy();
+
+bool stream_writers_enabled();
+
+/*
+ * Create a packet of `stream` to receive the data of `header` into. The
+ * packet owns the reference of the caller to `stream` on success.
+ */
+struct stream_write_packet *
+stream_write_packet_create(struct relay_stream *stream,
+			   const struct lttcomm_relayd_data_hdr *header);
+void stream_write_packet_destroy(struct stream_write_packet *packet);
+
+/*
+ * Queue a received packet to the writer thread of its stream, waiting while
+ * the queue of the stream is full. Ownership of the packet is transferred.
+ *
+ * Return 0 on success, -1 if a previous packet of the stream could not be
+ * written.
+ */
+int stream_writers_queue(struct stream_write_packet *packet);
+
+#endif /* _STREAM_WRITER_H */
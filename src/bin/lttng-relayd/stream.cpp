@@ -9,14 +9,20 @@
  */
 
 #define _LGPL_SOURCE
+#include "ephemeral-live.hpp"
 #include "index.hpp"
 #include "lttng-relayd.hpp"
+#include "metrics.hpp"
+#include "packet-cache.hpp"
+#include "rotation-worker.hpp"
 #include "stream.hpp"
 #include "viewer-stream.hpp"
+#include "write-scheduler.hpp"
 
 #include <common/common.hpp>
 #include <common/defaults.hpp>
 #include <common/fs-handle.hpp>
+#include <common/hashtable/typed-hashtable.hpp>
 #include <common/sessiond-comm/relayd.hpp>
 #include <common/urcu.hpp>
 #include <common/utils.hpp>
@@ -28,6 +34,8 @@
 #include <urcu/rculist.h>
 
 #define FILE_IO_STACK_BUFFER_SIZE 65536
+/* Largest metadata of a stream kept in memory for the live viewers. */
+#define METADATA_CACHE_MAX_SIZE (16 * 1024 * 1024)
 
 /* Should be called with RCU read-side lock held. */
 bool stream_get(struct relay_stream *stream)
@@ -44,18 +52,15 @@ bool stream_get(struct relay_stream *stream)
  */
 struct relay_stream *stream_get_by_id(uint64_t stream_id)
 {
-	struct lttng_ht_node_u64 *node;
-	struct lttng_ht_iter iter;
-	struct relay_stream *stream = nullptr;
+	struct relay_stream *stream;
 
 	lttng::urcu::read_lock_guard read_lock;
-	lttng_ht_lookup(relay_streams_ht, &stream_id, &iter);
-	node = lttng_ht_iter_get_node_u64(&iter);
-	if (!node) {
+	stream = lttng::ht<lttng_ht_node_u64, relay_stream, &relay_stream::node>(*relay_streams_ht)
+			 .find(stream_id);
+	if (!stream) {
 		DBG("Relay stream %" PRIu64 " not found", stream_id);
 		goto end;
 	}
-	stream = lttng::utils::container_of(node, &relay_stream::node);
 	if (!stream_get(stream)) {
 		stream = nullptr;
 	}
@@ -63,6 +68,48 @@ end:
 	return stream;
 }
 
+/*
+ * Wake up the live viewers waiting for the next index of a stream. Called
+ * with the stream lock held.
+ */
+static void stream_wake_index_waiters(struct relay_stream *stream)
+{
+	struct relay_index_waiter *waiter, *tmp;
+
+	ASSERT_LOCKED(stream->lock);
+
+	stream->index_wakeup_count++;
+	cds_list_for_each_entry_safe (waiter, tmp, &stream->index_waiters, node) {
+		const char wakeup = 0;
+
+		cds_list_del_init(&waiter->node);
+		CMM_STORE_SHARED(waiter->woken_up, true);
+
+		/* A full pipe already wakes up the live worker. */
+		if (write(waiter->wakeup_fd, &wakeup, sizeof(wakeup)) < 0 && errno != EAGAIN) {
+			PERROR("Failed to wake up live viewer of stream %" PRIu64,
+			       stream->stream_handle);
+		}
+	}
+}
+
+void stream_add_index_waiter(struct relay_stream *stream, struct relay_index_waiter *waiter)
+{
+	ASSERT_LOCKED(stream->lock);
+
+	waiter->woken_up = false;
+	cds_list_add_tail(&waiter->node, &stream->index_waiters);
+}
+
+void stream_remove_index_waiter(struct relay_stream *stream, struct relay_index_waiter *waiter)
+{
+	ASSERT_LOCKED(stream->lock);
+
+	if (!cds_list_empty(&waiter->node)) {
+		cds_list_del_init(&waiter->node);
+	}
+}
+
 static void stream_complete_rotation(struct relay_stream *stream)
 {
 	DBG("Rotation completed for stream %" PRIu64, stream->stream_handle);
@@ -70,10 +117,88 @@ static void stream_complete_rotation(struct relay_stream *stream)
 		tracefile_array_reset(stream->tfa);
 		tracefile_array_commit_seq(stream->tfa, stream->index_received_seqcount);
 	}
-	lttng_trace_chunk_put(stream->trace_chunk);
+	rotation_workers_put_trace_chunk(stream->trace_chunk);
 	stream->trace_chunk = stream->ongoing_rotation.value.next_trace_chunk;
 	stream->ongoing_rotation = LTTNG_OPTIONAL_INIT_UNSET;
 	stream->completed_rotation_count++;
+	stream_wake_index_waiters(stream);
+}
+
+/*
+ * Empty the metadata cache of a metadata stream, of which `file` is the new
+ * metadata file.
+ */
+static void stream_reset_metadata_cache(struct relay_stream *stream, struct fs_handle *file)
+{
+	const int fd = fs_handle_get_fd(file);
+	struct stat file_stat;
+
+	(void) lttng_dynamic_buffer_set_size(&stream->metadata_cache.data, 0);
+	stream->metadata_cache.valid = false;
+	if (fd < 0) {
+		return;
+	}
+
+	if (fstat(fd, &file_stat)) {
+		PERROR("Failed to stat metadata file, not caching the metadata of stream %" PRIu64,
+		       stream->stream_handle);
+	} else {
+		stream->metadata_cache.file_dev = file_stat.st_dev;
+		stream->metadata_cache.file_ino = file_stat.st_ino;
+		stream->metadata_cache.valid = true;
+	}
+
+	fs_handle_put_fd(file);
+}
+
+/*
+ * Append `len` bytes of metadata written to the metadata file of a metadata
+ * stream to its metadata cache, zeroes if `data` is null.
+ */
+static void stream_append_metadata_cache(struct relay_stream *stream, const char *data, size_t len)
+{
+	auto *cache = &stream->metadata_cache;
+	const size_t size = cache->data.size;
+	int ret;
+
+	if (!cache->valid || len == 0) {
+		return;
+	}
+
+	if (size + len > METADATA_CACHE_MAX_SIZE) {
+		DBG("Metadata of stream %" PRIu64 " exceeds its cache, no longer caching it",
+		    stream->stream_handle);
+		ret = -1;
+	} else {
+		/* The added bytes are zeroed, as the padding is. */
+		ret = lttng_dynamic_buffer_set_size(&cache->data, size + len);
+		if (!ret && data) {
+			memcpy(cache->data.data + size, data, len);
+		}
+	}
+
+	if (ret) {
+		lttng_dynamic_buffer_reset(&cache->data);
+		cache->valid = false;
+	}
+}
+
+/* Reset the state of a stream tied to its output file as it switches to `file`. */
+static void stream_init_data_file(struct relay_stream *stream, struct fs_handle *file)
+{
+	if (stream->is_metadata) {
+		stream_reset_metadata_cache(stream, file);
+	} else if (packet_cache_enabled()) {
+		const int fd = fs_handle_get_fd(file);
+
+		packet_cache_set_file(&stream->packet_cache, fd);
+		if (fd >= 0) {
+			fs_handle_put_fd(file);
+		}
+	}
+
+	stream->data_preallocated_size = 0;
+	stream->data_preallocation_failed = false;
 }
 
 static int stream_create_data_output_file_from_trace_chunk(struct relay_stream *stream,
@@ -131,10 +256,326 @@ static int stream_create_data_output_file_from_trace_chunk(struct relay_stream *
 		ret = -1;
 		goto end;
 	}
+
+	stream_init_data_file(stream, *out_file);
 end:
 	return ret;
 }
 
+/*
+ * Reserve the blocks of the next `len` bytes of the output file of a data
+ * stream, and of the preallocation window past them, if they are not already.
+ * The whole file is reserved at once when its maximal size is known. A
+ * failure only disables the preallocation of this file.
+ *
+ * Called with the stream lock held.
+ */
+static void stream_preallocate_data_file(struct relay_stream *stream, uint64_t len)
+{
+	const uint64_t end = stream->tracefile_size_current + len;
+	uint64_t preallocation_end;
+
+	ASSERT_LOCKED(stream->lock);
+
+	if (!opt_preallocation_size || !stream->file || stream->data_preallocation_failed ||
+	    end <= stream->data_preallocated_size) {
+		return;
+	}
+
+	preallocation_end = end + opt_preallocation_size;
+	if (stream->tracefile_size) {
+		preallocation_end = std::max(end, stream->tracefile_size);
+	}
+
+	if (fs_handle_preallocate(stream->file,
+				  stream->data_preallocated_size,
+				  preallocation_end - stream->data_preallocated_size)) {
+		DBG("Failed to preallocate stream file, disabling its preallocation: "
+		    "stream_id = %" PRIu64 ", error = %s",
+		    stream->stream_handle,
+		    strerror(errno));
+		stream->data_preallocation_failed = true;
+		return;
+	}
+
+	stream->data_preallocated_size = preallocation_end;
+}
+
+/*
+ * Release the blocks preallocated past the end of the output file of a stream,
+ * then close it.
+ *
+ * Return 0 on success else a negative value.
+ */
+static int stream_close_data_file(struct relay_stream *stream)
+{
+	int ret;
+
+	if (stream->data_preallocated_size > 0 && fs_handle_trim_preallocation(stream->file)) {
+		PERROR("Failed to release the preallocated blocks of stream file: "
+		       "stream_id = %" PRIu64,
+		       stream->stream_handle);
+	}
+
+	ret = fs_handle_close(stream->file);
+	stream->file = nullptr;
+	return ret;
+}
+
+/*
+ * Hand the data file of a stream, which is no longer written to, over to the
+ * rotation threads to be closed.
+ */
+static void stream_retire_data_file(struct relay_stream *stream)
+{
+	/* The data file is already in the next trace chunk once the data is rotated. */
+	struct lttng_trace_chunk *chunk =
+		stream->ongoing_rotation.is_set && stream->ongoing_rotation.value.data_rotated ?
+			stream->ongoing_rotation.value.next_trace_chunk :
+			stream->trace_chunk;
+
+	rotation_workers_close_file(stream->file, stream->data_preallocated_size > 0, chunk);
+	stream->file = nullptr;
+}
+
+namespace {
+/* Opening of the next data file of a stream by a rotation thread. */
+struct next_data_file_job {
+	struct lttng_thread_pool_work work;
+	struct relay_stream *stream;
+	struct lttng_trace_chunk *chunk;
+	uint64_t tracefile_index;
+	uint64_t tracefile_size;
+	char *path;
+};
+} /* namespace */
+
+/*
+ * Format the hidden name, in the directory of the stream files, under which the
+ * next file replacing the tracefile `tracefile_index` of a stream is opened.
+ *
+ * Return the name, to free by the caller, or NULL on error.
+ */
+static char *next_data_file_path(const struct relay_stream *stream, uint64_t tracefile_index)
+{
+	int ret;
+	char *path;
+	const char *name;
+	char stream_path[LTTNG_PATH_MAX];
+
+	ret = utils_stream_file_path(stream->path_name,
+				     stream->channel_name,
+				     stream->tracefile_size,
+				     tracefile_index,
+				     nullptr,
+				     stream_path,
+				     sizeof(stream_path));
+	if (ret < 0) {
+		return nullptr;
+	}
+
+	name = strrchr(stream_path, '/');
+	name = name ? name + 1 : stream_path;
+	ret = asprintf(&path, "%.*s.%s.next", (int) (name - stream_path), stream_path, name);
+	return ret < 0 ? nullptr : path;
+}
+
+/* Unlink and close a next data file which won't be used. Takes ownership of all its objects. */
+static void discard_next_data_file(struct fs_handle *file,
+				   struct lttng_trace_chunk *chunk,
+				   char *path)
+{
+	if (lttng_trace_chunk_unlink_file(chunk, path)) {
+		ERR("Failed to unlink unused next stream file \"%s\"", path);
+	}
+
+	rotation_workers_close_file(file, false, chunk);
+	lttng_trace_chunk_put(chunk);
+	free(path);
+}
+
+/* Called with the stream lock held, or on the release of the stream. */
+static void stream_discard_next_data_file(struct relay_stream *stream)
+{
+	if (!stream->next_data_file.file) {
+		return;
+	}
+
+	discard_next_data_file(stream->next_data_file.file,
+			       stream->next_data_file.chunk,
+			       stream->next_data_file.path);
+	stream->next_data_file.file = nullptr;
+	stream->next_data_file.chunk = nullptr;
+	stream->next_data_file.path = nullptr;
+}
+
+static uint64_t stream_get_next_tracefile_index(const struct relay_stream *stream)
+{
+	return (stream->tracefile_current_index + 1) % stream->tracefile_count;
+}
+
+static void run_next_data_file_job(struct lttng_thread_pool_work *work)
+{
+	struct next_data_file_job *job =
+		lttng::utils::container_of(work, &next_data_file_job::work);
+	struct relay_stream *stream = job->stream;
+	const int flags = O_RDWR | O_CREAT | O_TRUNC;
+	const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+	struct fs_handle *file = nullptr;
+	uint64_t preallocated_size = 0;
+	enum lttng_trace_chunk_status status;
+
+	status = lttng_trace_chunk_open_fs_handle(job->chunk, job->path, flags, mode, &file, false);
+	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		ERR("Failed to open next stream file \"%s\"", job->path);
+		file = nullptr;
+	} else if (opt_preallocation_size) {
+		if (fs_handle_preallocate(file, 0, job->tracefile_size)) {
+			DBG("Failed to preallocate next stream file: stream_id = %" PRIu64
+			    ", error = %s",
+			    stream->stream_handle,
+			    strerror(errno));
+		} else {
+			preallocated_size = job->tracefile_size;
+		}
+	}
+
+	pthread_mutex_lock(&stream->lock);
+	stream->next_data_file.pending = false;
+	/* The stream may have closed, changed of trace chunk or rotated meanwhile. */
+	if (file && !stream->closed && !stream->next_data_file.file &&
+	    stream->trace_chunk == job->chunk &&
+	    stream_get_next_tracefile_index(stream) == job->tracefile_index) {
+		stream->next_data_file.file = file;
+		stream->next_data_file.chunk = job->chunk;
+		stream->next_data_file.tracefile_index = job->tracefile_index;
+		stream->next_data_file.preallocated_size = preallocated_size;
+		stream->next_data_file.path = job->path;
+		job->chunk = nullptr;
+		job->path = nullptr;
+	} else if (file) {
+		discard_next_data_file(file, job->chunk, job->path);
+		job->chunk = nullptr;
+		job->path = nullptr;
+	}
+	pthread_mutex_unlock(&stream->lock);
+
+	lttng_trace_chunk_put(job->chunk);
+	free(job->path);
+	stream_put(stream);
+	free(job);
+}
+
+/*
+ * Have a rotation thread open, and preallocate, the next file of the on-disk
+ * ring buffer of a stream, so that the rotation of its tracefile only renames
+ * the file in place, see stream_switch_to_next_data_file().
+ *
+ * Called with the stream lock held.
+ */
+static void stream_preopen_next_data_file(struct relay_stream *stream)
+{
+	bool reference_acquired;
+	struct next_data_file_job *job;
+
+	ASSERT_LOCKED(stream->lock);
+
+	if (stream->next_data_file.file || stream->next_data_file.pending || stream->is_metadata ||
+	    !stream->trace_chunk || !rotation_workers_enabled()) {
+		return;
+	}
+
+	job = zmalloc<next_data_file_job>();
+	if (!job) {
+		PERROR("Failed to allocate next stream file job");
+		return;
+	}
+
+	job->work.run = run_next_data_file_job;
+	job->tracefile_index = stream_get_next_tracefile_index(stream);
+	job->tracefile_size = stream->tracefile_size;
+	job->path = next_data_file_path(stream, job->tracefile_index);
+	if (!job->path) {
+		ERR("Failed to format the path of the next file of stream %" PRIu64,
+		    stream->stream_handle);
+		free(job);
+		return;
+	}
+
+	reference_acquired = stream_get(stream);
+	LTTNG_ASSERT(reference_acquired);
+	job->stream = stream;
+	reference_acquired = lttng_trace_chunk_get(stream->trace_chunk);
+	LTTNG_ASSERT(reference_acquired);
+	job->chunk = stream->trace_chunk;
+
+	stream->next_data_file.pending = true;
+	if (!rotation_workers_submit(&job->work)) {
+		stream->next_data_file.pending = false;
+		lttng_trace_chunk_put(job->chunk);
+		stream_put(stream);
+		free(job->path);
+		free(job);
+	}
+}
+
+/*
+ * Switch a stream to the next file of its on-disk ring buffer, opened ahead of
+ * time, by renaming it in place of the file of its current tracefile.
+ *
+ * Return true on success, or false if the next file isn't available and
+ * must be opened by the caller.
+ *
+ * Called with the stream lock held.
+ */
+static bool stream_switch_to_next_data_file(struct relay_stream *stream)
+{
+	int ret;
+	struct fs_handle *file = stream->next_data_file.file;
+	char stream_path[LTTNG_PATH_MAX];
+
+	ASSERT_LOCKED(stream->lock);
+
+	if (!file || stream->next_data_file.chunk != stream->trace_chunk ||
+	    stream->next_data_file.tracefile_index != stream->tracefile_current_index) {
+		stream_discard_next_data_file(stream);
+		return false;
+	}
+
+	ret = utils_stream_file_path(stream->path_name,
+				     stream->channel_name,
+				     stream->tracefile_size,
+				     stream->tracefile_current_index,
+				     nullptr,
+				     stream_path,
+				     sizeof(stream_path));
+	/*
+	 * Replacing the file keeps its content readable by the live viewers
+	 * which have it open, like unlinking it does.
+	 */
+	if (ret < 0 ||
+	    lttng_trace_chunk_rename_fs_handle(
+		    stream->trace_chunk, file, stream->next_data_file.path, stream_path) !=
+		    LTTNG_TRACE_CHUNK_STATUS_OK) {
+		stream_discard_next_data_file(stream);
+		return false;
+	}
+
+	if (stream->file) {
+		stream_retire_data_file(stream);
+	}
+
+	stream_init_data_file(stream, file);
+	stream->file = file;
+	stream->data_preallocated_size = stream->next_data_file.preallocated_size;
+	lttng_trace_chunk_put(stream->next_data_file.chunk);
+	free(stream->next_data_file.path);
+	stream->next_data_file.file = nullptr;
+	stream->next_data_file.chunk = nullptr;
+	stream->next_data_file.path = nullptr;
+	return true;
+}
+
 static int stream_rotate_data_file(struct relay_stream *stream)
 {
 	int ret = 0;
@@ -144,9 +585,9 @@ static int stream_rotate_data_file(struct relay_stream *stream)
 	    stream->tracefile_size_current);
 
 	if (stream->file) {
-		fs_handle_close(stream->file);
-		stream->file = nullptr;
+		stream_retire_data_file(stream);
 	}
+	stream_discard_next_data_file(stream);
 
 	stream->tracefile_wrapped_around = false;
 	stream->tracefile_current_index = 0;
@@ -424,6 +865,10 @@ static int create_index_file(struct relay_stream *stream, struct lttng_trace_chu
 
 	/* Put ref on previous index_file. */
 	if (stream->index_file) {
+		if (stream_flush_index_buffer(stream)) {
+			ret = -1;
+			goto end;
+		}
 		lttng_index_file_put(stream->index_file);
 		stream->index_file = nullptr;
 	}
@@ -459,6 +904,10 @@ static int create_index_file(struct relay_stream *stream, struct lttng_trace_chu
 		goto end;
 	}
 
+	if (opt_preallocation_size) {
+		lttng_index_file_preallocate(stream->index_file, opt_preallocation_size);
+	}
+
 	ret = 0;
 
 end:
@@ -515,7 +964,11 @@ static int try_rotate_stream_index(struct relay_stream *stream)
 			     stream->ongoing_rotation.value.packet_seq_num);
 		DBG("Rotating stream %" PRIu64 " index file", stream->stream_handle);
 		if (stream->index_file) {
-			lttng_index_file_put(stream->index_file);
+			ret = stream_flush_index_buffer(stream);
+			if (ret < 0) {
+				goto end;
+			}
+			rotation_workers_put_index_file(stream->index_file);
 			stream->index_file = nullptr;
 		}
 		stream->ongoing_rotation.value.index_rotated = true;
@@ -555,8 +1008,7 @@ static int stream_set_trace_chunk(struct relay_stream *stream, struct lttng_trac
 	stream->trace_chunk = chunk;
 
 	if (stream->file) {
-		fs_handle_close(stream->file);
-		stream->file = nullptr;
+		stream_close_data_file(stream);
 	}
 	ret = stream_create_data_output_file_from_trace_chunk(stream, chunk, false, &stream->file);
 end:
@@ -589,12 +1041,25 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 	stream->prev_data_seq = -1ULL;
 	stream->prev_index_seq = -1ULL;
 	stream->last_net_seq_num = -1ULL;
+	stream->accepted_data_seq = -1ULL;
+	stream->accepted_index_seq = -1ULL;
+	stream->accepted_packet_seq_num = -1ULL;
 	stream->ctf_stream_id = -1ULL;
 	stream->tracefile_size = tracefile_size;
 	stream->tracefile_count = tracefile_count;
 	stream->path_name = path_name;
 	stream->channel_name = channel_name;
+	/* Set before the metadata file is created. */
+	stream->is_metadata = !strcmp(stream->channel_name, DEFAULT_METADATA_NAME);
+	if (!stream->is_metadata && ephemeral_live_session(session)) {
+		ephemeral_live_bound_stream_files(&stream->tracefile_size,
+						  &stream->tracefile_count);
+	}
+	lttng_dynamic_buffer_init(&stream->metadata_cache.data);
 	stream->beacon_ts_end = -1ULL;
+	CDS_INIT_LIST_HEAD(&stream->index_waiters);
+	packet_cache_init(&stream->packet_cache);
+	index_cache_init(&stream->index_cache);
 	lttng_ht_node_init_u64(&stream->node, stream->stream_handle);
 	pthread_mutex_init(&stream->lock, nullptr);
 	urcu_ref_init(&stream->ref);
@@ -614,6 +1079,7 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 		goto end;
 	}
 
+	lttng_dynamic_buffer_init(&stream->index_buffer.entries);
 	stream->indexes_ht = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
 	if (!stream->indexes_ht) {
 		ERR("Cannot created indexes_ht");
@@ -637,7 +1103,6 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 		goto end;
 	}
 
-	stream->is_metadata = !strcmp(stream->channel_name, DEFAULT_METADATA_NAME);
 	stream->in_recv_list = true;
 
 	/*
@@ -648,6 +1113,7 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 	cds_list_add_rcu(&stream->recv_node, &session->recv_list);
 	session->stream_count++;
 	pthread_mutex_unlock(&session->recv_list_lock);
+	session_mark_changed(session);
 
 	/*
 	 * Both in the ctf_trace object and the global stream ht since the data
@@ -664,8 +1130,7 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 end:
 	if (ret) {
 		if (stream->file) {
-			fs_handle_close(stream->file);
-			stream->file = nullptr;
+			stream_close_data_file(stream);
 		}
 		stream_put(stream);
 		stream = nullptr;
@@ -705,6 +1170,7 @@ void stream_publish(struct relay_stream *stream)
 		stream->in_recv_list = false;
 	}
 	pthread_mutex_unlock(&session->recv_list_lock);
+	session_mark_changed(session);
 
 	pthread_mutex_lock(&stream->trace->stream_list_lock);
 	cds_list_add_rcu(&stream->stream_node, &stream->trace->stream_list);
@@ -728,7 +1194,8 @@ static void stream_unpublish(struct relay_stream *stream)
 		iter.iter.node = &stream->node.node;
 		ret = lttng_ht_del(relay_streams_ht, &iter);
 		LTTNG_ASSERT(!ret);
-		stream->in_stream_ht = false;
+		/* Checked without the stream lock by the stream caches of the data connections. */
+		CMM_STORE_SHARED(stream->in_stream_ht, false);
 	}
 	if (stream->published) {
 		pthread_mutex_lock(&stream->trace->stream_list_lock);
@@ -740,6 +1207,8 @@ static void stream_unpublish(struct relay_stream *stream)
 
 static void stream_destroy(struct relay_stream *stream)
 {
+	/* The waiters hold a reference on the viewer stream, and thus on the stream. */
+	LTTNG_ASSERT(cds_list_empty(&stream->index_waiters));
 	if (stream->indexes_ht) {
 		/*
 		 * Calling lttng_ht_destroy in call_rcu worker thread so
@@ -748,6 +1217,11 @@ static void stream_destroy(struct relay_stream *stream)
 		 */
 		lttng_ht_destroy(stream->indexes_ht);
 	}
+	relay_index_destroy_ring(stream);
+	lttng_dynamic_buffer_reset(&stream->index_buffer.entries);
+	packet_cache_fini(&stream->packet_cache);
+	index_cache_fini(&stream->index_cache);
+	lttng_dynamic_buffer_reset(&stream->metadata_cache.data);
 	if (stream->tfa) {
 		tracefile_array_destroy(stream->tfa);
 	}
@@ -787,19 +1261,18 @@ static void stream_release(struct urcu_ref *ref)
 	stream_unpublish(stream);
 
 	if (stream->file) {
-		fs_handle_close(stream->file);
-		stream->file = nullptr;
-	}
-	if (stream->index_file) {
-		lttng_index_file_put(stream->index_file);
-		stream->index_file = nullptr;
+		stream_retire_data_file(stream);
 	}
+	stream_discard_next_data_file(stream);
+	(void) stream_flush_index_buffer(stream);
+	rotation_workers_put_index_file(stream->index_file);
+	stream->index_file = nullptr;
 	if (stream->trace) {
 		ctf_trace_put(stream->trace);
 		stream->trace = nullptr;
 	}
 	stream_complete_rotation(stream);
-	lttng_trace_chunk_put(stream->trace_chunk);
+	rotation_workers_put_trace_chunk(stream->trace_chunk);
 	stream->trace_chunk = nullptr;
 
 	call_rcu(&stream->rcu_node, stream_destroy_rcu);
@@ -956,6 +1429,8 @@ void try_stream_close(struct relay_stream *stream)
 	 */
 	stream_unpublish(stream);
 	stream->closed = true;
+	index_cache_close(&stream->index_cache);
+	stream_wake_index_waiters(stream);
 	/* Relay indexes are only used by the "consumer/sessiond" end. */
 	relay_index_close_all(stream);
 
@@ -970,20 +1445,108 @@ void try_stream_close(struct relay_stream *stream)
 
 	/* Put stream fd before put chunk. */
 	if (stream->file) {
-		fs_handle_close(stream->file);
-		stream->file = nullptr;
+		stream_retire_data_file(stream);
 	}
-	if (stream->index_file) {
-		lttng_index_file_put(stream->index_file);
-		stream->index_file = nullptr;
-	}
-	lttng_trace_chunk_put(stream->trace_chunk);
+	stream_discard_next_data_file(stream);
+	(void) stream_flush_index_buffer(stream);
+	rotation_workers_put_index_file(stream->index_file);
+	stream->index_file = nullptr;
+	rotation_workers_put_trace_chunk(stream->trace_chunk);
 	stream->trace_chunk = nullptr;
 	pthread_mutex_unlock(&stream->lock);
 	DBG("Succeeded in closing stream %" PRIu64, stream->stream_handle);
 	stream_put(stream);
 }
 
+/*
+ * The consumer daemon numbers the data packets of a stream, and their
+ * indexes, with consecutive network sequence numbers. A packet or an index
+ * with a sequence number which isn't greater than the last one accepted is
+ * a duplicate, typically resent after a reconnection, which was already
+ * written. The metadata streams are never deduplicated.
+ *
+ * Called with the stream lock held.
+ */
+bool stream_accept_packet(struct relay_stream *stream, uint64_t net_seq_num)
+{
+	ASSERT_LOCKED(stream->lock);
+
+	if (!opt_deduplicate_packets || stream->is_metadata) {
+		return true;
+	}
+
+	if (stream->accepted_data_seq != -1ULL) {
+		const int64_t delta = (int64_t) (net_seq_num - stream->accepted_data_seq);
+
+		if (delta <= 0) {
+			DBG("Skipping duplicate data packet of stream %" PRIu64
+			    ": net_seq_num = %" PRIu64 ", last accepted net_seq_num = %" PRIu64,
+			    stream->stream_handle,
+			    net_seq_num,
+			    stream->accepted_data_seq);
+			relay_metrics_count_duplicate_packet(stream);
+			return false;
+		} else if (delta > 1) {
+			WARN("Missing %" PRIu64 " data packets of stream %" PRIu64
+			     " before net_seq_num %" PRIu64,
+			     (uint64_t) delta - 1,
+			     stream->stream_handle,
+			     net_seq_num);
+			relay_metrics_count_missing_packets(stream, (uint64_t) delta - 1);
+		}
+	}
+
+	stream->accepted_data_seq = net_seq_num;
+	return true;
+}
+
+/*
+ * Same as stream_accept_packet() for an index, which also accounts for the
+ * gaps in the packet sequence numbers, that is for the packets which never
+ * reached the relay daemon.
+ *
+ * Called with the stream lock held.
+ */
+static bool stream_accept_index(struct relay_stream *stream,
+				const struct lttcomm_relayd_index *index_info)
+{
+	if (!opt_deduplicate_packets || stream->is_metadata) {
+		return true;
+	}
+
+	if (stream->accepted_index_seq != -1ULL &&
+	    (int64_t) (index_info->net_seq_num - stream->accepted_index_seq) <= 0) {
+		DBG("Skipping duplicate index of stream %" PRIu64 ": net_seq_num = %" PRIu64
+		    ", last accepted net_seq_num = %" PRIu64,
+		    stream->stream_handle,
+		    index_info->net_seq_num,
+		    stream->accepted_index_seq);
+		relay_metrics_count_duplicate_index(stream);
+		return false;
+	}
+
+	/* Peers prior to 2.8 don't send the packet sequence numbers. */
+	if (index_info->packet_seq_num != -1ULL) {
+		if (stream->accepted_packet_seq_num != -1ULL &&
+		    index_info->packet_seq_num > stream->accepted_packet_seq_num + 1) {
+			const uint64_t missing =
+				index_info->packet_seq_num - stream->accepted_packet_seq_num - 1;
+
+			WARN("Missing %" PRIu64 " packet sequence numbers of stream %" PRIu64
+			     " before packet_seq_num %" PRIu64,
+			     missing,
+			     stream->stream_handle,
+			     index_info->packet_seq_num);
+			relay_metrics_count_missing_packet_seq_nums(stream, missing);
+		}
+
+		stream->accepted_packet_seq_num = index_info->packet_seq_num;
+	}
+
+	stream->accepted_index_seq = index_info->net_seq_num;
+	return true;
+}
+
 int stream_init_packet(struct relay_stream *stream, size_t packet_size, bool *file_rotated)
 {
 	int ret = 0;
@@ -1026,16 +1589,17 @@ int stream_init_packet(struct relay_stream *stream, size_t packet_size, bool *fi
 		tracefile_array_file_rotate(stream->tfa, TRACEFILE_ROTATE_WRITE);
 		stream->tracefile_current_index = new_file_index;
 
-		if (stream->file) {
-			fs_handle_close(stream->file);
-			stream->file = nullptr;
-		}
-		ret = stream_create_data_output_file_from_trace_chunk(
-			stream, stream->trace_chunk, false, &stream->file);
-		if (ret) {
-			ERR("Failed to perform trace file rotation of stream %" PRIu64,
-			    stream->stream_handle);
-			goto end;
+		if (!stream_switch_to_next_data_file(stream)) {
+			if (stream->file) {
+				stream_close_data_file(stream);
+			}
+			ret = stream_create_data_output_file_from_trace_chunk(
+				stream, stream->trace_chunk, false, &stream->file);
+			if (ret) {
+				ERR("Failed to perform trace file rotation of stream %" PRIu64,
+				    stream->stream_handle);
+				goto end;
+			}
 		}
 
 		/*
@@ -1052,6 +1616,13 @@ int stream_init_packet(struct relay_stream *stream, size_t packet_size, bool *fi
 		*file_rotated = false;
 	}
 end:
+	if (!ret) {
+		stream_preallocate_data_file(stream, packet_size);
+		packet_cache_begin_packet(&stream->packet_cache, packet_size);
+		if (stream->tracefile_size) {
+			stream_preopen_next_data_file(stream);
+		}
+	}
 	return ret;
 }
 
@@ -1064,6 +1635,7 @@ int stream_write(struct relay_stream *stream,
 	ssize_t write_ret;
 	size_t padding_to_write = padding_len;
 	char padding_buffer[FILE_IO_STACK_BUFFER_SIZE];
+	const uint64_t begin_ns = relay_metrics_begin_duration();
 
 	ASSERT_LOCKED(stream->lock);
 	memset(padding_buffer, 0, std::min(sizeof(padding_buffer), padding_to_write));
@@ -1085,6 +1657,10 @@ int stream_write(struct relay_stream *stream,
 			ret = -1;
 			goto end;
 		}
+
+		if (!stream->is_metadata) {
+			packet_cache_append(&stream->packet_cache, packet->data, packet->size);
+		}
 	}
 
 	while (padding_to_write > 0) {
@@ -1106,6 +1682,11 @@ int stream_write(struct relay_stream *stream,
 	if (stream->is_metadata) {
 		size_t recv_len;
 
+		if (packet) {
+			stream_append_metadata_cache(stream, packet->data, packet->size);
+		}
+
+		stream_append_metadata_cache(stream, nullptr, padding_len);
 		recv_len = packet ? packet->size : 0;
 		recv_len += padding_len;
 		stream->metadata_received += recv_len;
@@ -1119,6 +1700,76 @@ int stream_write(struct relay_stream *stream,
 	    stream->stream_handle,
 	    packet ? packet->size : (size_t) 0,
 	    padding_len);
+	if (packet || padding_len) {
+		write_scheduler_charge((packet ? packet->size : 0) + padding_len);
+		relay_metrics_record_duration(RELAY_METRICS_DURATION_STREAM_WRITE, begin_ns);
+	}
+end:
+	return ret;
+}
+
+/*
+ * Move the bytes of a pipe to the output file of a data stream without
+ * copying them to user space.
+ *
+ * Called with the stream lock held.
+ *
+ * Return 0 on success else a negative value.
+ */
+int stream_splice(struct relay_stream *stream, int pipe_fd, size_t len)
+{
+	int ret = 0, fd;
+	size_t left_to_splice = len;
+	const uint64_t begin_ns = relay_metrics_begin_duration();
+
+	ASSERT_LOCKED(stream->lock);
+	LTTNG_ASSERT(!stream->is_metadata);
+
+	if (!stream->file || !stream->trace_chunk) {
+		ERR("Protocol error: received a packet for a stream without a current trace chunk: "
+		    "stream_id = %" PRIu64 ", channel_name = %s",
+		    stream->stream_handle,
+		    stream->channel_name);
+		ret = -1;
+		goto end;
+	}
+
+	fd = fs_handle_get_fd(stream->file);
+	if (fd < 0) {
+		ret = -1;
+		goto end;
+	}
+
+	while (left_to_splice > 0) {
+		const ssize_t splice_ret =
+			splice(pipe_fd, nullptr, fd, nullptr, left_to_splice, SPLICE_F_MOVE);
+
+		if (splice_ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			PERROR("Failed to splice to stream file of stream %" PRIu64,
+			       stream->stream_handle);
+			ret = -1;
+			break;
+		} else if (splice_ret == 0) {
+			ERR("Unexpected end of pipe while splicing to file of stream %" PRIu64,
+			    stream->stream_handle);
+			ret = -1;
+			break;
+		}
+
+		left_to_splice -= splice_ret;
+	}
+
+	fs_handle_put_fd(stream->file);
+
+	if (!ret) {
+		DBG("Spliced to stream %" PRIu64 ": data_length = %zu", stream->stream_handle, len);
+		write_scheduler_charge(len);
+		relay_metrics_record_duration(RELAY_METRICS_DURATION_STREAM_WRITE, begin_ns);
+	}
 end:
 	return ret;
 }
@@ -1155,7 +1806,8 @@ int stream_update_index(struct relay_stream *stream,
 	 * number. If it exists, the control thread has already received the
 	 * data for it, thus we need to write it to disk.
 	 */
-	index = relay_index_get_by_id_or_create(stream, net_seq_num);
+	index = relay_index_get_by_id_or_create(
+		stream, net_seq_num, MEMORY_BUDGET_INDEX_AWAITING_INDEX);
 	if (!index) {
 		ret = -1;
 		goto end;
@@ -1185,7 +1837,12 @@ int stream_update_index(struct relay_stream *stream,
 	if (ret == 0) {
 		tracefile_array_file_rotate(stream->tfa, TRACEFILE_ROTATE_READ);
 		tracefile_array_commit_seq(stream->tfa, stream->index_received_seqcount);
+		index_cache_add(&stream->index_cache,
+				stream->index_received_seqcount,
+				stream->completed_rotation_count,
+				&index->index_data);
 		stream->index_received_seqcount++;
+		stream_wake_index_waiters(stream);
 		LTTNG_OPTIONAL_SET(&stream->received_packet_seq_num,
 				   be64toh(index->index_data.packet_seq_num));
 		*flushed = true;
@@ -1233,6 +1890,58 @@ end:
 	return ret;
 }
 
+/*
+ * Write the padding of a data packet whose data was written, update its
+ * index and complete it.
+ *
+ * `new_stream` is set if it is the first packet of the stream.
+ *
+ * Called with the stream lock held.
+ *
+ * Return 0 on success else a negative value.
+ */
+int stream_commit_packet(struct relay_stream *stream,
+			 uint64_t net_seq_num,
+			 size_t data_size,
+			 size_t padding_size,
+			 bool rotate_index,
+			 bool *new_stream)
+{
+	int ret;
+	bool index_flushed = false;
+
+	ASSERT_LOCKED(stream->lock);
+
+	ret = stream_write(stream, nullptr, padding_size);
+	if (ret) {
+		goto end;
+	}
+
+	if (session_streams_have_index(stream->trace->session)) {
+		ret = stream_update_index(stream,
+					  net_seq_num,
+					  rotate_index,
+					  &index_flushed,
+					  data_size + padding_size);
+		if (ret < 0) {
+			ERR("Failed to update index: stream %" PRIu64 " net_seq_num %" PRIu64
+			    " ret %d",
+			    stream->stream_handle,
+			    net_seq_num,
+			    ret);
+			goto end;
+		}
+	}
+
+	*new_stream = stream->prev_data_seq == -1ULL;
+	relay_metrics_count_received_packet(stream);
+	packet_cache_commit_packet(
+		&stream->packet_cache, stream->tracefile_size_current, data_size + padding_size);
+	ret = stream_complete_packet(stream, data_size + padding_size, net_seq_num, index_flushed);
+end:
+	return ret;
+}
+
 int stream_add_index(struct relay_stream *stream, const struct lttcomm_relayd_index *index_info)
 {
 	int ret = 0;
@@ -1252,6 +1961,7 @@ int stream_add_index(struct relay_stream *stream, const struct lttcomm_relayd_in
 		 */
 		if (stream->index_received_seqcount > 0 && stream->indexes_in_flight == 0) {
 			stream->beacon_ts_end = index_info->timestamp_end;
+			stream_wake_index_waiters(stream);
 		}
 		ret = 0;
 		goto end;
@@ -1259,11 +1969,17 @@ int stream_add_index(struct relay_stream *stream, const struct lttcomm_relayd_in
 		stream->beacon_ts_end = -1ULL;
 	}
 
+	relay_metrics_count_received_index(stream);
+	if (!stream_accept_index(stream, index_info)) {
+		goto end;
+	}
+
 	if (stream->ctf_stream_id == -1ULL) {
 		stream->ctf_stream_id = index_info->stream_id;
 	}
 
-	index = relay_index_get_by_id_or_create(stream, index_info->net_seq_num);
+	index = relay_index_get_by_id_or_create(
+		stream, index_info->net_seq_num, MEMORY_BUDGET_INDEX_AWAITING_PACKET);
 	if (!index) {
 		ret = -1;
 		ERR("Failed to get or create index %" PRIu64, index_info->net_seq_num);
@@ -1279,7 +1995,12 @@ int stream_add_index(struct relay_stream *stream, const struct lttcomm_relayd_in
 	if (ret == 0) {
 		tracefile_array_file_rotate(stream->tfa, TRACEFILE_ROTATE_READ);
 		tracefile_array_commit_seq(stream->tfa, stream->index_received_seqcount);
+		index_cache_add(&stream->index_cache,
+				stream->index_received_seqcount,
+				stream->completed_rotation_count,
+				&index->index_data);
 		stream->index_received_seqcount++;
+		stream_wake_index_waiters(stream);
 		stream->pos_after_last_complete_data_index += index->total_size;
 		stream->prev_index_seq = index_info->net_seq_num;
 		LTTNG_OPTIONAL_SET(&stream->received_packet_seq_num, index_info->packet_seq_num);
@@ -1309,11 +2030,111 @@ end:
 	return ret;
 }
 
+/*
+ * Write an index entry to the given index file of a stream. The entries are
+ * buffered and written opt_index_buffer_count at a time. The buffer is
+ * flushed when the entries target another index file, before the index file
+ * of the stream is closed or rotated, when a data pending check finds the
+ * stream complete, and before a live viewer reads the index file.
+ *
+ * Called with the stream lock held.
+ *
+ * Return 0 on success else a negative value.
+ */
+int stream_write_index(struct relay_stream *stream,
+		       struct lttng_index_file *index_file,
+		       const struct ctf_packet_index *element)
+{
+	int ret;
+
+	ASSERT_LOCKED(stream->lock);
+
+	if (opt_index_buffer_count <= 1) {
+		write_scheduler_charge(index_file->element_len);
+		return lttng_index_file_write(index_file, element);
+	}
+
+	if (stream->index_buffer.file != index_file) {
+		ret = stream_flush_index_buffer(stream);
+		if (ret) {
+			return ret;
+		}
+
+		lttng_index_file_get(index_file);
+		stream->index_buffer.file = index_file;
+	}
+
+	ret = lttng_dynamic_buffer_append(
+		&stream->index_buffer.entries, element, index_file->element_len);
+	if (ret) {
+		ERR("Failed to buffer index entry of stream %" PRIu64, stream->stream_handle);
+		return -1;
+	}
+
+	stream->index_buffer.count++;
+	if (stream->index_buffer.count >= opt_index_buffer_count) {
+		return stream_flush_index_buffer(stream);
+	}
+
+	return 0;
+}
+
+/*
+ * Write the buffered index entries of a stream and release their index file.
+ *
+ * Called with the stream lock held, or when the last reference to the stream
+ * is released.
+ *
+ * Return 0 on success else a negative value.
+ */
+int stream_flush_index_buffer(struct relay_stream *stream)
+{
+	int ret = 0;
+
+	if (!stream->index_buffer.file) {
+		goto end;
+	}
+
+	if (stream->index_buffer.count > 0) {
+		DBG2("Writing %u buffered index entries of stream %" PRIu64,
+		     stream->index_buffer.count,
+		     stream->stream_handle);
+		write_scheduler_charge((uint64_t) stream->index_buffer.count *
+				       stream->index_buffer.file->element_len);
+		ret = lttng_index_file_write_elements(stream->index_buffer.file,
+						      stream->index_buffer.entries.data,
+						      stream->index_buffer.count);
+		if (ret) {
+			ERR("Failed to write the buffered index entries of stream %" PRIu64
+			    ": count = %u",
+			    stream->stream_handle,
+			    stream->index_buffer.count);
+		}
+	}
+
+	lttng_index_file_put(stream->index_buffer.file);
+	stream->index_buffer.file = nullptr;
+	stream->index_buffer.count = 0;
+	(void) lttng_dynamic_buffer_set_size(&stream->index_buffer.entries, 0);
+end:
+	return ret;
+}
+
 static void print_stream_indexes(struct relay_stream *stream)
 {
 	struct lttng_ht_iter iter;
 	struct relay_index *index;
 
+	for (unsigned int i = 0; stream->index_ring && i < RELAY_INDEX_RING_SIZE; i++) {
+		index = &stream->index_ring[i];
+		if (index->in_ring) {
+			DBG("index %p net_seq_num %" PRIu64 " in ring slot %u",
+			    index,
+			    index->index_n.key,
+			    i);
+		}
+	}
+
 	{
 		lttng::urcu::read_lock_guard read_lock;
 
@@ -1337,13 +2158,12 @@ int stream_reset_file(struct relay_stream *stream)
 	if (stream->file) {
 		int ret;
 
-		ret = fs_handle_close(stream->file);
+		ret = stream_close_data_file(stream);
 		if (ret) {
 			ERR("Failed to close stream file handle: channel name = \"%s\", id = %" PRIu64,
 			    stream->channel_name,
 			    stream->stream_handle);
 		}
-		stream->file = nullptr;
 	}
 
 	DBG("%s: reset tracefile_size_current for stream %" PRIu64 " was %" PRIu64,
@@ -1355,6 +2175,7 @@ int stream_reset_file(struct relay_stream *stream)
 	stream->prev_index_seq = 0;
 	/* Note that this does not reset the tracefile array. */
 	stream->tracefile_current_index = 0;
+	stream_discard_next_data_file(stream);
 	stream->pos_after_last_complete_data_index = 0;
 
 	return stream_create_data_output_file_from_trace_chunk(
@@ -10,10 +10,14 @@
  *
  */
 
+#include "metrics.hpp"
+#include "index-cache.hpp"
+#include "packet-cache.hpp"
 #include "session.hpp"
 #include "tracefile-array.hpp"
 
 #include <common/buffer-view.hpp>
+#include <common/dynamic-buffer.hpp>
 #include <common/hashtable/hashtable.hpp>
 #include <common/optional.hpp>
 #include <common/trace-chunk.hpp>
@@ -48,6 +52,19 @@ struct relay_stream_rotation {
 /*
  * Represents a stream in the relay
  */
+/*
+ * A live viewer waiting for the next index of a stream. It is linked in the
+ * index waiters of the stream, under the stream lock, until the stream is
+ * woken up or the viewer stops waiting.
+ */
+struct relay_index_waiter {
+	struct cds_list_head node;
+	/* A byte is written to this non-blocking pipe when woken up. */
+	int wakeup_fd;
+	/* Set when woken up, under the stream lock. */
+	bool woken_up;
+};
+
 struct relay_stream {
 	uint64_t stream_handle;
 
@@ -67,8 +84,27 @@ struct relay_stream {
 	uint64_t prev_index_seq;
 	/* seq num to encounter before closing. */
 	uint64_t last_net_seq_num;
+	/*
+	 * Highest network sequence numbers of the data packets and of the
+	 * indexes accepted, and packet sequence number of the last index
+	 * accepted, when the packets are deduplicated. -1ULL until the
+	 * first one.
+	 */
+	uint64_t accepted_data_seq;
+	uint64_t accepted_index_seq;
+	uint64_t accepted_packet_seq_num;
 
 	struct fs_handle *file;
+	/*
+	 * End of the blocks reserved ahead of the writes to `file`, see
+	 * stream_preallocate_data_file().
+	 */
+	uint64_t data_preallocated_size;
+	bool data_preallocation_failed;
+	/* Most recent packets of `file` and of the previous files. */
+	struct packet_cache packet_cache;
+	/* Most recent index entries, sent to the viewers once the stream is closed. */
+	struct index_cache index_cache;
 	/* index file on which to write the index data. */
 	struct lttng_index_file *index_file;
 
@@ -90,6 +126,21 @@ struct relay_stream {
 	 * files shall be unlinked before being opened after this has occurred.
 	 */
 	bool tracefile_wrapped_around;
+	/*
+	 * Next file of the on-disk ring buffer, opened and preallocated under
+	 * a hidden name by a rotation thread ahead of the rotation, see
+	 * stream_preopen_next_data_file(). Protected by the stream lock.
+	 */
+	struct {
+		struct fs_handle *file;
+		/* Chunk in which `file` is created, and index of the tracefile it replaces. */
+		struct lttng_trace_chunk *chunk;
+		uint64_t tracefile_index;
+		uint64_t preallocated_size;
+		char *path;
+		/* Set while a rotation thread opens the next file. */
+		bool pending;
+	} next_data_file;
 
 	/*
 	 * Position in the tracefile where we have the full index also on disk.
@@ -122,12 +173,32 @@ struct relay_stream {
 	bool close_requested; /* Close command has been received. */
 
 	/*
-	 * Counts number of indexes in indexes_ht. Redundant info.
-	 * Protected by stream lock.
+	 * Counts number of indexes in index_ring and indexes_ht. Redundant
+	 * info. Protected by stream lock.
 	 */
 	int indexes_in_flight;
+	/*
+	 * RELAY_INDEX_RING_SIZE slots holding the pending indexes, allocated
+	 * with the first index. Protected by stream lock.
+	 */
+	struct relay_index *index_ring;
+	/* Pending indexes whose slot of index_ring was in use. */
 	struct lttng_ht *indexes_ht;
 
+	/*
+	 * Index entries flushed by relay_index_try_flush() which are not
+	 * written to `file` yet, see stream_write_index(). Protected by
+	 * stream lock.
+	 */
+	struct {
+		struct lttng_index_file *file;
+		struct lttng_dynamic_buffer entries;
+		unsigned int count;
+	} index_buffer;
+
+	/* Updated atomically, see metrics.hpp. */
+	struct relay_stream_metrics metrics;
+
 	/*
 	 * If the stream is inactive, this field is updated with the
 	 * live beacon timestamp end, when it is active, this
@@ -135,6 +206,15 @@ struct relay_stream {
 	 */
 	uint64_t beacon_ts_end;
 
+	/*
+	 * Live viewers waiting for the next index of the stream, woken up
+	 * once a new index or live beacon is received, and once the stream
+	 * rotates or closes, since the index they need may then change.
+	 */
+	struct cds_list_head index_waiters;
+	/* Number of wake-ups of the index waiters. */
+	uint64_t index_wakeup_count;
+
 	/* CTF stream ID, -1ULL when unset (first packet not received yet). */
 	uint64_t ctf_stream_id;
 
@@ -145,6 +225,27 @@ struct relay_stream {
 	bool is_metadata;
 	/* Amount of metadata received (bytes). */
 	uint64_t metadata_received;
+	/*
+	 * Content of the metadata file of a metadata stream, from its
+	 * beginning, which the live viewers are sent rather than reading
+	 * the file. Invalid once it exceeds its maximal size, until the
+	 * next metadata file is created.
+	 */
+	struct {
+		struct lttng_dynamic_buffer data;
+		/* Metadata file of the cached content. */
+		dev_t file_dev;
+		ino_t file_ino;
+		bool valid;
+	} metadata_cache;
+
+	/*
+	 * Size of the packets of the stream queued to its writer thread, and
+	 * whether one of them could not be written. Protected by the lock of
+	 * the writer thread of the stream.
+	 */
+	uint64_t queued_write_size;
+	bool write_error;
 
 	/*
 	 * Member of the stream list in struct ctf_trace.
@@ -201,10 +302,24 @@ int stream_set_pending_rotation(struct relay_stream *stream,
 				uint64_t rotation_sequence_number);
 void try_stream_close(struct relay_stream *stream);
 void stream_publish(struct relay_stream *stream);
+/*
+ * Return false if the data packet of sequence number `net_seq_num` was
+ * already received and must be skipped, when the packets are deduplicated.
+ */
+bool stream_accept_packet(struct relay_stream *stream, uint64_t net_seq_num);
 int stream_init_packet(struct relay_stream *stream, size_t packet_size, bool *file_rotated);
 int stream_write(struct relay_stream *stream,
 		 const struct lttng_buffer_view *packet,
 		 size_t padding_len);
+/* Splice `len` bytes of `pipe_fd` to the output file of a data stream. */
+int stream_splice(struct relay_stream *stream, int pipe_fd, size_t len);
+/* Called once the data of a packet is written to the output file. */
+int stream_commit_packet(struct relay_stream *stream,
+			 uint64_t net_seq_num,
+			 size_t data_size,
+			 size_t padding_size,
+			 bool rotate_index,
+			 bool *new_stream);
 /* Called after the reception of a complete data packet. */
 int stream_update_index(struct relay_stream *stream,
 			uint64_t net_seq_num,
@@ -217,6 +332,18 @@ int stream_complete_packet(struct relay_stream *stream,
 			   bool index_flushed);
 /* Index info is in host endianness. */
 int stream_add_index(struct relay_stream *stream, const struct lttcomm_relayd_index *index_info);
+int stream_write_index(struct relay_stream *stream,
+		       struct lttng_index_file *index_file,
+		       const struct ctf_packet_index *element);
+int stream_flush_index_buffer(struct relay_stream *stream);
+
+/*
+ * Add a waiter to the index waiters of a stream (called with the stream
+ * lock held).
+ */
+void stream_add_index_waiter(struct relay_stream *stream, struct relay_index_waiter *waiter);
+/* Called with the stream lock held. No effect if the waiter was woken up. */
+void stream_remove_index_waiter(struct relay_stream *stream, struct relay_index_waiter *waiter);
 int stream_reset_file(struct relay_stream *stream);
 
 void print_relay_streams(void);
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "token-bucket.hpp"
+
+#include <common/time.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+void token_bucket_init(struct token_bucket *bucket, uint64_t rate)
+{
+	bucket->rate = rate;
+	bucket->tokens = 0;
+	bucket->last_refill_ns = 0;
+	bucket->credit_ns = 0;
+}
+
+uint64_t token_bucket_refill(struct token_bucket *bucket)
+{
+	return token_bucket_refill_at(bucket, lttng_monotonic_coarse_now_ns());
+}
+
+uint64_t token_bucket_refill_at(struct token_bucket *bucket, uint64_t now_ns)
+{
+	uint64_t elapsed_ns, credit_ns, added_tokens;
+
+	if (bucket->last_refill_ns == 0 || now_ns < bucket->last_refill_ns) {
+		bucket->tokens = (int64_t) bucket->rate;
+		bucket->last_refill_ns = now_ns;
+		bucket->credit_ns = 0;
+		return 0;
+	}
+
+	/* The bucket holds at most one second worth of tokens. */
+	elapsed_ns = std::min<uint64_t>(now_ns - bucket->last_refill_ns, NSEC_PER_SEC);
+	bucket->last_refill_ns = now_ns;
+	if (bucket->rate == 0) {
+		return elapsed_ns;
+	}
+
+	/*
+	 * A refill may come sooner than the time one token takes: keep the time
+	 * which has not produced a whole token for the next refills.
+	 */
+	credit_ns = std::min<uint64_t>(bucket->credit_ns + elapsed_ns, NSEC_PER_SEC);
+	added_tokens = (uint64_t) ((double) bucket->rate * credit_ns / NSEC_PER_SEC);
+	bucket->tokens += (int64_t) added_tokens;
+	if (bucket->tokens >= (int64_t) bucket->rate) {
+		bucket->tokens = (int64_t) bucket->rate;
+		bucket->credit_ns = 0;
+	} else {
+		const uint64_t spent_ns =
+			(uint64_t) std::ceil((double) added_tokens * NSEC_PER_SEC / bucket->rate);
+
+		bucket->credit_ns = credit_ns - std::min(spent_ns, credit_ns);
+	}
+
+	return elapsed_ns;
+}
+
+void token_bucket_consume(struct token_bucket *bucket, uint64_t tokens)
+{
+	bucket->tokens -= (int64_t) tokens;
+}
+
+uint64_t token_bucket_deficit_ns(const struct token_bucket *bucket)
+{
+	if (bucket->rate == 0 || bucket->tokens >= 0) {
+		return 0;
+	}
+
+	return (uint64_t) ((double) -bucket->tokens * NSEC_PER_SEC / bucket->rate);
+}
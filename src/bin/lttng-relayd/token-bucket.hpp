@@ -0,0 +1,49 @@
+#ifndef _TOKEN_BUCKET_H
+#define _TOKEN_BUCKET_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdint.h>
+
+/*
+ * Token bucket of the rate limits of the relay daemon, refilled at `rate`
+ * tokens per second and holding at most one second worth of tokens.
+ *
+ * The users of a bucket serialize the accesses to it.
+ */
+struct token_bucket {
+	/* Tokens per second, 0 when unlimited. */
+	uint64_t rate;
+	/* Tokens which may be spent, negative when overspent. */
+	int64_t tokens;
+	/* Monotonic time of the last refill, 0 until the first one. */
+	uint64_t last_refill_ns;
+	/* Time elapsed by the last refills which has not produced a whole token. */
+	uint64_t credit_ns;
+};
+
+void token_bucket_init(struct token_bucket *bucket, uint64_t rate);
+
+/*
+ * Add the tokens produced since the last refill. A bucket starts full on its
+ * first refill.
+ *
+ * Return the time elapsed since the last refill in nanoseconds, at most one
+ * second, 0 on the first refill.
+ */
+uint64_t token_bucket_refill(struct token_bucket *bucket);
+
+/* Same as token_bucket_refill(), as of the monotonic time `now_ns`. */
+uint64_t token_bucket_refill_at(struct token_bucket *bucket, uint64_t now_ns);
+
+void token_bucket_consume(struct token_bucket *bucket, uint64_t tokens);
+
+/* Return the time, in nanoseconds, until the overspent tokens are refilled. */
+uint64_t token_bucket_deficit_ns(const struct token_bucket *bucket);
+
+#endif /* _TOKEN_BUCKET_H */
@@ -155,6 +155,22 @@ uint64_t tracefile_array_get_seq_tail(struct tracefile_array *tfa)
 	return tfa->seq_tail;
 }
 
+void tracefile_array_get_file_seq(struct tracefile_array *tfa,
+				  uint64_t file_index,
+				  uint64_t *seq_tail,
+				  uint64_t *seq_head)
+{
+	if (!tfa->count) {
+		/* Not in tracefile rotation mode; the only file holds all the indexes. */
+		*seq_tail = tfa->seq_tail;
+		*seq_head = tfa->seq_head;
+		return;
+	}
+	LTTNG_ASSERT(file_index < tfa->count);
+	*seq_tail = tfa->tf[file_index].seq_tail;
+	*seq_head = tfa->tf[file_index].seq_head;
+}
+
 bool tracefile_array_seq_in_file(struct tracefile_array *tfa, uint64_t file_index, uint64_t seq)
 {
 	if (!tfa->count) {
@@ -65,6 +65,15 @@ uint64_t tracefile_array_get_file_index_tail(struct tracefile_array *tfa);
 /* May return -1ULL in the case where we have not received any indexes yet. */
 uint64_t tracefile_array_get_seq_tail(struct tracefile_array *tfa);
 
+/*
+ * Get the oldest and newest seqcounts of a file, -1ULL if it holds none. Those
+ * of the entire array are returned when not in tracefile rotation mode.
+ */
+void tracefile_array_get_file_seq(struct tracefile_array *tfa,
+				  uint64_t file_index,
+				  uint64_t *seq_tail,
+				  uint64_t *seq_head);
+
 bool tracefile_array_seq_in_file(struct tracefile_array *tfa, uint64_t file_index, uint64_t seq);
 
 #endif /* _STREAM_H */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "connection.hpp"
+#include "viewer-idle.hpp"
+
+#include <common/common.hpp>
+#include <common/time.hpp>
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <limits.h>
+#include <time.h>
+
+namespace {
+/* Milliseconds, 0 when disabled. */
+uint64_t timeout_ms;
+
+/* The idle timers are handled by the live worker threads. */
+uint64_t now_tick()
+{
+	return lttng_thread_clock_now_ns() / NSEC_PER_MSEC;
+}
+} /* namespace */
+
+viewer_idle_wheel::viewer_idle_wheel() : wheel(now_tick())
+{
+}
+
+int viewer_idle_set_timeout(const char *timeout)
+{
+	uint64_t value_us;
+
+	if (utils_parse_time_suffix(timeout, &value_us) || value_us < USEC_PER_MSEC) {
+		ERR("Invalid viewer idle timeout: `%s`", timeout);
+		return -1;
+	}
+
+	timeout_ms = value_us / USEC_PER_MSEC;
+	return 0;
+}
+
+bool viewer_idle_enabled()
+{
+	return timeout_ms > 0;
+}
+
+int viewer_idle_touch(struct viewer_idle_wheel *idle, struct relay_connection *conn)
+{
+	auto *timer = conn->protocol.viewer.idle_timer;
+
+	if (!viewer_idle_enabled()) {
+		return 0;
+	}
+
+	if (!timer) {
+		timer = new (std::nothrow) viewer_idle_timer;
+		if (!timer) {
+			ERR("Failed to allocate the idle timer of viewer connection %d",
+			    conn->sock->fd);
+			return -1;
+		}
+
+		timer->conn = conn;
+		conn->protocol.viewer.idle_timer = timer;
+	}
+
+	idle->wheel.schedule(timer->entry, now_tick() + timeout_ms);
+	return 0;
+}
+
+void viewer_idle_forget(struct viewer_idle_wheel *idle, struct relay_connection *conn)
+{
+	auto *timer = conn->protocol.viewer.idle_timer;
+
+	if (!timer) {
+		return;
+	}
+
+	idle->wheel.cancel(timer->entry);
+	delete timer;
+	conn->protocol.viewer.idle_timer = nullptr;
+}
+
+void viewer_idle_expire(struct viewer_idle_wheel *idle,
+			std::vector<struct relay_connection *>& expired)
+{
+	std::vector<lttng::timer_wheel::entry *> expired_entries;
+
+	if (idle->wheel.empty()) {
+		return;
+	}
+
+	idle->wheel.advance(now_tick(), expired_entries);
+	for (auto *entry : expired_entries) {
+		expired.push_back(lttng::utils::container_of(entry, &viewer_idle_timer::entry)->conn);
+	}
+}
+
+int viewer_idle_poll_timeout(const struct viewer_idle_wheel *idle)
+{
+	const uint64_t next_tick = idle->wheel.next_tick();
+	const uint64_t now = now_tick();
+
+	if (next_tick == UINT64_MAX) {
+		return -1;
+	}
+
+	return (int) std::min<uint64_t>(next_tick - std::min(next_tick, now), INT_MAX);
+}
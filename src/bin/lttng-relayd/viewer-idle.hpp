@@ -0,0 +1,71 @@
+#ifndef _VIEWER_IDLE_H
+#define _VIEWER_IDLE_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/timer-wheel.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+struct relay_connection;
+
+/*
+ * Idle detection of the live viewer connections.
+ *
+ * When an idle timeout is set, each live worker thread keeps a timer per
+ * viewer connection in a timer wheel counting milliseconds, re-armed
+ * whenever the viewer sends a request or accepts some of its queued
+ * replies. The connections whose timer expires are closed by their worker
+ * thread, which releases their viewer session and viewer streams rather
+ * than keeping them until TCP gives up on an abandoned viewer.
+ */
+struct viewer_idle_timer {
+	lttng::timer_wheel::entry entry;
+	struct relay_connection *conn = nullptr;
+};
+
+/* Idle timers of the viewer connections of a live worker thread. */
+struct viewer_idle_wheel {
+	viewer_idle_wheel();
+
+	lttng::timer_wheel wheel;
+};
+
+/*
+ * Set the idle timeout of the viewer connections from a duration with an
+ * optional `us`, `ms`, `s`, `m` or `h` suffix, microseconds by default.
+ *
+ * Return 0 on success, -1 if the timeout is invalid.
+ */
+int viewer_idle_set_timeout(const char *timeout);
+
+bool viewer_idle_enabled();
+
+/*
+ * Re-arm the idle timer of a connection of the worker thread, creating it
+ * on the first activity of the connection.
+ *
+ * Return 0 on success, -1 on allocation error.
+ */
+int viewer_idle_touch(struct viewer_idle_wheel *idle, struct relay_connection *conn);
+
+/* Cancel and destroy the idle timer of a connection which is closed. */
+void viewer_idle_forget(struct viewer_idle_wheel *idle, struct relay_connection *conn);
+
+/* Append the connections whose idle timer expired, which is no longer armed, to `expired`. */
+void viewer_idle_expire(struct viewer_idle_wheel *idle,
+			std::vector<struct relay_connection *>& expired);
+
+/*
+ * Return the poll timeout, in milliseconds, until the next idle timer may
+ * expire, or -1 if no timer is armed.
+ */
+int viewer_idle_poll_timeout(const struct viewer_idle_wheel *idle);
+
+#endif /* _VIEWER_IDLE_H */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "viewer-merge.hpp"
+
+#include <common/common.hpp>
+#include <common/compat/endian.hpp>
+
+#include <utility>
+
+namespace {
+struct viewer_merge_head *head_at(const struct viewer_merge *merge, size_t i)
+{
+	return (struct viewer_merge_head *) lttng_dynamic_array_get_element(&merge->heads, i);
+}
+
+/* Ties are broken by stream so that the order doesn't depend on the arrival of the indexes. */
+bool head_before(const struct viewer_merge_head *a, const struct viewer_merge_head *b)
+{
+	const uint64_t a_begin = be64toh(a->index.timestamp_begin);
+	const uint64_t b_begin = be64toh(b->index.timestamp_begin);
+
+	return a_begin < b_begin || (a_begin == b_begin && a->stream_id < b->stream_id);
+}
+
+void swap_heads(const struct viewer_merge *merge, size_t i, size_t j)
+{
+	std::swap(*head_at(merge, i), *head_at(merge, j));
+}
+
+void sift_up(struct viewer_merge *merge, size_t i)
+{
+	while (i > 0) {
+		const size_t parent = (i - 1) / 2;
+
+		if (!head_before(head_at(merge, i), head_at(merge, parent))) {
+			break;
+		}
+
+		swap_heads(merge, i, parent);
+		i = parent;
+	}
+}
+
+void sift_down(struct viewer_merge *merge, size_t i)
+{
+	const size_t count = lttng_dynamic_array_get_count(&merge->heads);
+
+	while (true) {
+		const size_t left = 2 * i + 1, right = left + 1;
+		size_t first = i;
+
+		if (left < count && head_before(head_at(merge, left), head_at(merge, first))) {
+			first = left;
+		}
+		if (right < count && head_before(head_at(merge, right), head_at(merge, first))) {
+			first = right;
+		}
+		if (first == i) {
+			break;
+		}
+
+		swap_heads(merge, i, first);
+		i = first;
+	}
+}
+} /* namespace */
+
+void viewer_merge_init(struct viewer_merge *merge)
+{
+	lttng_dynamic_array_init(&merge->heads, sizeof(struct viewer_merge_head), nullptr);
+	merge->pending_flags = 0;
+}
+
+void viewer_merge_fini(struct viewer_merge *merge)
+{
+	lttng_dynamic_array_reset(&merge->heads);
+}
+
+int viewer_merge_push(struct viewer_merge *merge,
+		      uint64_t stream_id,
+		      const struct lttng_viewer_index *index)
+{
+	struct viewer_merge_head head;
+
+	head.stream_id = stream_id;
+	head.index = *index;
+	if (lttng_dynamic_array_add_element(&merge->heads, &head)) {
+		ERR("Failed to allocate the merge head of viewer stream %" PRIu64, stream_id);
+		return -1;
+	}
+
+	sift_up(merge, lttng_dynamic_array_get_count(&merge->heads) - 1);
+	return 0;
+}
+
+const struct viewer_merge_head *viewer_merge_top(const struct viewer_merge *merge)
+{
+	if (lttng_dynamic_array_get_count(&merge->heads) == 0) {
+		return nullptr;
+	}
+
+	return head_at(merge, 0);
+}
+
+void viewer_merge_pop(struct viewer_merge *merge)
+{
+	const size_t count = lttng_dynamic_array_get_count(&merge->heads);
+
+	LTTNG_ASSERT(count > 0);
+	swap_heads(merge, 0, count - 1);
+	/* Removing the last element doesn't fail. */
+	(void) lttng_dynamic_array_remove_element(&merge->heads, count - 1);
+	sift_down(merge, 0);
+}
+
+bool viewer_merge_has_head(const struct viewer_merge *merge, uint64_t stream_id)
+{
+	for (size_t i = 0; i < lttng_dynamic_array_get_count(&merge->heads); i++) {
+		if (head_at(merge, i)->stream_id == stream_id) {
+			return true;
+		}
+	}
+
+	return false;
+}
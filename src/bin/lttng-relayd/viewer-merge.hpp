@@ -0,0 +1,57 @@
+#ifndef _VIEWER_MERGE_H
+#define _VIEWER_MERGE_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include "lttng-viewer-abi.hpp"
+
+#include <common/dynamic-array.hpp>
+
+#include <stdint.h>
+
+/*
+ * Merge of the data streams of a viewer session of type
+ * LTTNG_VIEWER_SESSION_TYPE_MERGED.
+ *
+ * The next index of each data stream, its head, is taken from the stream
+ * and kept in a min-heap by beginning timestamp until the live viewer can
+ * be sent the index which begins first. The merge is only used by the live
+ * worker which serves the connection of its viewer session.
+ */
+struct viewer_merge_head {
+	/* Relay stream handle. */
+	uint64_t stream_id;
+	/* As sent to the viewer, in big endian. */
+	struct lttng_viewer_index index;
+};
+
+struct viewer_merge {
+	/* struct viewer_merge_head, ordered as a min-heap by beginning timestamp. */
+	struct lttng_dynamic_array heads;
+	/* LTTNG_VIEWER_FLAG_* of the streams, to send with the next index. */
+	uint32_t pending_flags;
+};
+
+void viewer_merge_init(struct viewer_merge *merge);
+void viewer_merge_fini(struct viewer_merge *merge);
+
+/* Return 0 on success, -1 on allocation error. */
+int viewer_merge_push(struct viewer_merge *merge,
+		      uint64_t stream_id,
+		      const struct lttng_viewer_index *index);
+
+/* Return the head which begins first, or null if the merge has no head. */
+const struct viewer_merge_head *viewer_merge_top(const struct viewer_merge *merge);
+
+/* Remove the head which begins first. The merge must have a head. */
+void viewer_merge_pop(struct viewer_merge *merge);
+
+/* Return true if the merge has the head of the stream `stream_id`. */
+bool viewer_merge_has_head(const struct viewer_merge *merge, uint64_t stream_id);
+
+#endif /* _VIEWER_MERGE_H */
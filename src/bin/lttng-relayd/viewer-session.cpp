@@ -16,11 +16,13 @@
 #include "viewer-stream.hpp"
 
 #include <common/common.hpp>
+#include <common/string-utils/string-utils.hpp>
 #include <common/urcu.hpp>
 
+#include <fnmatch.h>
 #include <urcu/rculist.h>
 
-struct relay_viewer_session *viewer_session_create()
+struct relay_viewer_session *viewer_session_create(enum lttng_viewer_session_type type)
 {
 	struct relay_viewer_session *vsession;
 
@@ -29,10 +31,56 @@ struct relay_viewer_session *viewer_session_create()
 		goto end;
 	}
 	CDS_INIT_LIST_HEAD(&vsession->session_list);
+	lttng_dynamic_pointer_array_init(&vsession->channel_filter, free);
+	vsession->type = type;
+	viewer_merge_init(&vsession->merge);
 end:
 	return vsession;
 }
 
+int viewer_session_set_channel_filter(struct relay_viewer_session *vsession,
+				      const char *patterns)
+{
+	struct lttng_dynamic_pointer_array new_filter;
+
+	if (patterns[0] == '\0') {
+		lttng_dynamic_pointer_array_clear(&vsession->channel_filter);
+		DBG("Viewer session channel filter removed");
+		return 0;
+	}
+
+	if (strutils_split(patterns, ',', false, &new_filter)) {
+		ERR("Failed to split viewer session channel filter: `%s`", patterns);
+		return -1;
+	}
+
+	lttng_dynamic_pointer_array_reset(&vsession->channel_filter);
+	vsession->channel_filter = new_filter;
+	DBG("Viewer session channel filter set: `%s`", patterns);
+	return 0;
+}
+
+bool viewer_session_accepts_stream(const struct relay_viewer_session *vsession,
+				   const char *stream_name)
+{
+	const size_t count = lttng_dynamic_pointer_array_get_count(&vsession->channel_filter);
+
+	if (count == 0) {
+		return true;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const auto *pattern = static_cast<const char *>(
+			lttng_dynamic_pointer_array_get_pointer(&vsession->channel_filter, i));
+
+		if (fnmatch(pattern, stream_name, 0) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 int viewer_session_set_trace_chunk_copy(struct relay_viewer_session *vsession,
 					struct lttng_trace_chunk *relay_session_trace_chunk)
 {
@@ -78,6 +126,7 @@ enum lttng_viewer_attach_return_code viewer_session_attach(struct relay_viewer_s
 		int ret;
 
 		session->viewer_attached = true;
+		session_mark_changed(session);
 
 		ret = viewer_session_set_trace_chunk_copy(vsession, session->current_trace_chunk);
 		if (ret) {
@@ -117,6 +166,7 @@ static int viewer_session_detach(struct relay_viewer_session *vsession,
 		ret = -1;
 	} else {
 		session->viewer_attached = false;
+		session_mark_changed(session);
 	}
 
 	if (!ret) {
@@ -134,6 +184,8 @@ static int viewer_session_detach(struct relay_viewer_session *vsession,
 void viewer_session_destroy(struct relay_viewer_session *vsession)
 {
 	lttng_trace_chunk_put(vsession->current_trace_chunk);
+	lttng_dynamic_pointer_array_reset(&vsession->channel_filter);
+	viewer_merge_fini(&vsession->merge);
 	free(vsession);
 }
 
@@ -143,25 +195,16 @@ void viewer_session_destroy(struct relay_viewer_session *vsession)
 void viewer_session_close_one_session(struct relay_viewer_session *vsession,
 				      struct relay_session *session)
 {
-	struct lttng_ht_iter iter;
 	struct relay_viewer_stream *vstream;
 
-	/*
-	 * TODO: improvement: create more efficient list of
-	 * vstream per session.
-	 */
 	{
 		lttng::urcu::read_lock_guard read_guard;
 
-		cds_lfht_for_each_entry (
-			viewer_streams_ht->ht, &iter.iter, vstream, stream_n.node) {
+		cds_list_for_each_entry_rcu(vstream, &session->viewer_streams, session_node)
+		{
 			if (!viewer_stream_get(vstream)) {
 				continue;
 			}
-			if (vstream->stream->trace->session != session) {
-				viewer_stream_put(vstream);
-				continue;
-			}
 			/* Put local reference. */
 			viewer_stream_put(vstream);
 			/*
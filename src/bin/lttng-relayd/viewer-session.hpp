@@ -12,7 +12,9 @@
 
 #include "lttng-viewer-abi.hpp"
 #include "session.hpp"
+#include "viewer-merge.hpp"
 
+#include <common/dynamic-array.hpp>
 #include <common/hashtable/hashtable.hpp>
 #include <common/trace-chunk.hpp>
 
@@ -59,9 +61,18 @@ struct relay_viewer_session {
 	 * are created are considered as being a part of their name.
 	 */
 	struct lttng_trace_chunk *current_trace_chunk;
+	/*
+	 * Globbing patterns (char *) of the names of the data streams for
+	 * which viewer streams are created, all of them if empty. See
+	 * LTTNG_VIEWER_SET_CHANNEL_FILTER.
+	 */
+	struct lttng_dynamic_pointer_array channel_filter;
+	enum lttng_viewer_session_type type;
+	/* Merge of the data streams of a LTTNG_VIEWER_SESSION_TYPE_MERGED viewer session. */
+	struct viewer_merge merge;
 };
 
-struct relay_viewer_session *viewer_session_create(void);
+struct relay_viewer_session *viewer_session_create(enum lttng_viewer_session_type type);
 void viewer_session_destroy(struct relay_viewer_session *vsession);
 void viewer_session_close(struct relay_viewer_session *vsession);
 
@@ -74,4 +85,16 @@ void viewer_session_close_one_session(struct relay_viewer_session *vsession,
 int viewer_session_set_trace_chunk_copy(struct relay_viewer_session *vsession,
 					struct lttng_trace_chunk *relay_session_trace_chunk);
 
+/*
+ * Replace the channel filter of a viewer session by a comma-separated list of
+ * globbing patterns, an empty list removing the filter.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int viewer_session_set_channel_filter(struct relay_viewer_session *vsession,
+				      const char *patterns);
+/* Return true if the data stream named `stream_name` passes the channel filter. */
+bool viewer_session_accepts_stream(const struct relay_viewer_session *vsession,
+				   const char *stream_name);
+
 #endif /* _VIEWER_SESSION_H */
@@ -13,6 +13,7 @@
 
 #include <common/common.hpp>
 #include <common/compat/string.hpp>
+#include <common/hashtable/typed-hashtable.hpp>
 #include <common/index/index.hpp>
 #include <common/urcu.hpp>
 #include <common/utils.hpp>
@@ -21,6 +22,7 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <urcu/rculist.h>
 
 static void viewer_stream_release_composite_objects(struct relay_viewer_stream *vstream)
 {
@@ -55,12 +57,232 @@ static void viewer_stream_destroy_rcu(struct rcu_head *head)
 	viewer_stream_destroy(vstream);
 }
 
+/*
+ * Get the seqcounts of the first and last indexes of a stream file which can
+ * be read.
+ *
+ * Return false if the file holds no index yet.
+ */
+static bool tracefile_index_range(struct relay_stream *stream,
+				  uint64_t file_id,
+				  uint64_t *first_seq,
+				  uint64_t *last_seq)
+{
+	uint64_t seq_tail, seq_head;
+
+	tracefile_array_get_file_seq(stream->tfa, file_id, &seq_tail, &seq_head);
+	if (seq_tail == -1ULL || stream->index_received_seqcount == 0) {
+		return false;
+	}
+
+	/* The seqcount committed when a trace chunk rotation completes isn't received yet. */
+	seq_head = std::min(seq_head, stream->index_received_seqcount - 1);
+	if (seq_head < seq_tail) {
+		return false;
+	}
+
+	*first_seq = seq_tail;
+	*last_seq = seq_head;
+	return true;
+}
+
+/*
+ * Get the position, counted from the first index, of the index `seq` in the
+ * index file of a stream file.
+ *
+ * Return 0 if the file holds no index yet.
+ */
+static uint64_t tracefile_index_position(struct relay_stream *stream,
+					 uint64_t file_id,
+					 uint64_t seq)
+{
+	uint64_t seq_tail, seq_head;
+
+	tracefile_array_get_file_seq(stream->tfa, file_id, &seq_tail, &seq_head);
+	if (seq_tail == -1ULL || seq < seq_tail) {
+		return 0;
+	}
+
+	return seq - seq_tail;
+}
+
+/*
+ * Read the index at `position`, counted from the first index, of an index file.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int read_index_at(struct lttng_index_file *index_file,
+			 uint64_t position,
+			 struct ctf_packet_index *index)
+{
+	memset(index, 0, sizeof(*index));
+	return lttng_index_file_read_at(index_file, position, index);
+}
+
+/*
+ * Binary search a stream file for the first of its `count` indexes which ends
+ * at or after `timestamp`, setting `*position` to `count` if they all end
+ * before it.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int search_tracefile_timestamp(struct relay_stream *stream,
+				      struct lttng_trace_chunk *trace_chunk,
+				      uint64_t file_id,
+				      uint64_t count,
+				      uint64_t timestamp,
+				      uint64_t *position)
+{
+	int ret = 0;
+	uint64_t low = 0, high = count;
+	struct lttng_index_file *index_file;
+	enum lttng_trace_chunk_status status;
+	const uint32_t connection_major = stream->trace->session->major;
+	const uint32_t connection_minor = stream->trace->session->minor;
+
+	status = lttng_index_file_create_from_trace_chunk_read_only(
+		trace_chunk,
+		stream->path_name,
+		stream->channel_name,
+		stream->tracefile_size,
+		file_id,
+		lttng_to_index_major(connection_major, connection_minor),
+		lttng_to_index_minor(connection_major, connection_minor),
+		true,
+		&index_file);
+	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		if (status == LTTNG_TRACE_CHUNK_STATUS_NO_FILE) {
+			/* Removed by a clear: the viewer starts from the next file. */
+			*position = count;
+			return 0;
+		}
+
+		return -1;
+	}
+
+	while (low < high) {
+		const uint64_t middle = low + (high - low) / 2;
+		struct ctf_packet_index index;
+
+		ret = read_index_at(index_file, middle, &index);
+		if (ret) {
+			goto end;
+		}
+
+		if (be64toh(index.timestamp_end) >= timestamp) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+
+	*position = low;
+end:
+	lttng_index_file_put(index_file);
+	return ret;
+}
+
+/*
+ * Position a viewer stream on the first index of its relay stream which ends
+ * at or after `timestamp`, or after its last index if they all end before it.
+ * The stream files, ordered from the tail to the read head of the tracefile
+ * array, are binary searched by their last index before the indexes of the
+ * chosen file are.
+ *
+ * Sets `*position` to the position of the index in the index file of the
+ * current tracefile of the viewer stream.
+ *
+ * Relay stream's lock must be held by the caller.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int viewer_stream_seek_timestamp(struct relay_viewer_stream *vstream,
+					uint64_t timestamp,
+					uint64_t *position)
+{
+	struct relay_stream *stream = vstream->stream;
+	const uint64_t file_tail = tracefile_array_get_file_index_tail(stream->tfa);
+	const uint64_t file_head = tracefile_array_get_read_file_index_head(stream->tfa);
+	const uint64_t file_count = stream->tracefile_count ?
+		(file_head + stream->tracefile_count - file_tail) % stream->tracefile_count + 1 :
+		1;
+	uint64_t low = 0, high = file_count - 1;
+	uint64_t file_id, first_seq, last_seq, count;
+
+	*position = 0;
+
+	/* The search reads the index entries from the index files. */
+	if (stream_flush_index_buffer(stream)) {
+		return -1;
+	}
+
+	if (!vstream->stream_file.trace_chunk || !stream->index_file) {
+		/* No index yet: the next packets end after the timestamp. */
+		return 0;
+	}
+
+	while (low < high) {
+		const uint64_t middle = low + (high - low) / 2;
+		uint64_t last_position;
+
+		file_id = stream->tracefile_count ? (file_tail + middle) % stream->tracefile_count :
+						    0;
+		if (!tracefile_index_range(stream, file_id, &first_seq, &last_seq)) {
+			high = middle;
+			continue;
+		}
+
+		count = last_seq - first_seq + 1;
+		if (search_tracefile_timestamp(stream,
+					       vstream->stream_file.trace_chunk,
+					       file_id,
+					       count,
+					       timestamp,
+					       &last_position)) {
+			return -1;
+		}
+
+		if (last_position < count) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+
+	file_id = stream->tracefile_count ? (file_tail + low) % stream->tracefile_count : 0;
+	vstream->current_tracefile_id = file_id;
+	if (!tracefile_index_range(stream, file_id, &first_seq, &last_seq)) {
+		return 0;
+	}
+
+	count = last_seq - first_seq + 1;
+	if (search_tracefile_timestamp(stream,
+				       vstream->stream_file.trace_chunk,
+				       file_id,
+				       count,
+				       timestamp,
+				       position)) {
+		return -1;
+	}
+
+	vstream->index_sent_seqcount = first_seq + *position;
+	DBG("Viewer stream positioned at timestamp: stream id = %" PRIu64
+	    ", timestamp = %" PRIu64 ", tracefile id = %" PRIu64 ", index seqcount = %" PRIu64,
+	    stream->stream_handle,
+	    timestamp,
+	    file_id,
+	    vstream->index_sent_seqcount);
+	return 0;
+}
+
 /* Relay stream's lock must be held by the caller. */
 struct relay_viewer_stream *viewer_stream_create(struct relay_stream *stream,
 						 struct lttng_trace_chunk *trace_chunk,
-						 enum lttng_viewer_seek seek_t)
+						 enum lttng_viewer_seek seek_t,
+						 uint64_t seek_timestamp)
 {
 	struct relay_viewer_stream *vstream = nullptr;
+	uint64_t seek_position = 0;
 
 	ASSERT_LOCKED(stream->lock);
 
@@ -99,8 +321,14 @@ struct relay_viewer_stream *viewer_stream_create(struct relay_stream *stream,
 		goto error;
 	}
 
+	if (seek_t == LTTNG_VIEWER_SEEK_TIMESTAMP && stream->is_metadata) {
+		/* The viewers need all the metadata. */
+		seek_t = LTTNG_VIEWER_SEEK_BEGINNING;
+	}
+
 	switch (seek_t) {
 	case LTTNG_VIEWER_SEEK_BEGINNING:
+	case LTTNG_VIEWER_SEEK_TIMESTAMP:
 	{
 		uint64_t seq_tail = tracefile_array_get_seq_tail(stream->tfa);
 
@@ -114,6 +342,10 @@ struct relay_viewer_stream *viewer_stream_create(struct relay_stream *stream,
 		}
 		vstream->current_tracefile_id = tracefile_array_get_file_index_tail(stream->tfa);
 		vstream->index_sent_seqcount = seq_tail;
+		if (seek_t == LTTNG_VIEWER_SEEK_TIMESTAMP &&
+		    viewer_stream_seek_timestamp(vstream, seek_timestamp, &seek_position)) {
+			goto error;
+		}
 		break;
 	}
 	case LTTNG_VIEWER_SEEK_LAST:
@@ -133,74 +365,18 @@ struct relay_viewer_stream *viewer_stream_create(struct relay_stream *stream,
 	}
 
 	/*
-	 * If we never received an index for the current stream, delay
-	 * the opening of the index, otherwise open it right now.
+	 * The index and stream files are only opened on the first index request
+	 * of the viewer: a viewer attaching to a session creates all of its
+	 * viewer streams at once, most of which may never be read. Record the
+	 * position of the next index to send in the index file of the current
+	 * tracefile to seek to it once the file is opened.
 	 */
-	if (stream->index_file == nullptr) {
-		vstream->index_file = nullptr;
-	} else if (vstream->stream_file.trace_chunk) {
-		const uint32_t connection_major = stream->trace->session->major;
-		const uint32_t connection_minor = stream->trace->session->minor;
-		enum lttng_trace_chunk_status chunk_status;
-
-		chunk_status = lttng_index_file_create_from_trace_chunk_read_only(
-			vstream->stream_file.trace_chunk,
-			stream->path_name,
-			stream->channel_name,
-			stream->tracefile_size,
-			vstream->current_tracefile_id,
-			lttng_to_index_major(connection_major, connection_minor),
-			lttng_to_index_minor(connection_major, connection_minor),
-			true,
-			&vstream->index_file);
-		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
-			if (chunk_status == LTTNG_TRACE_CHUNK_STATUS_NO_FILE) {
-				vstream->index_file = nullptr;
-			} else {
-				goto error;
-			}
-		}
+	if (seek_t == LTTNG_VIEWER_SEEK_LAST) {
+		seek_position = tracefile_index_position(
+			stream, vstream->current_tracefile_id, vstream->index_sent_seqcount);
 	}
+	vstream->pending_index_position = seek_position;
 
-	/*
-	 * If we never received a data file for the current stream, delay the
-	 * opening, otherwise open it right now.
-	 */
-	if (stream->file && vstream->stream_file.trace_chunk) {
-		int ret;
-		char file_path[LTTNG_PATH_MAX];
-		enum lttng_trace_chunk_status status;
-
-		ret = utils_stream_file_path(stream->path_name,
-					     stream->channel_name,
-					     stream->tracefile_size,
-					     vstream->current_tracefile_id,
-					     nullptr,
-					     file_path,
-					     sizeof(file_path));
-		if (ret < 0) {
-			goto error;
-		}
-
-		status = lttng_trace_chunk_open_fs_handle(vstream->stream_file.trace_chunk,
-							  file_path,
-							  O_RDONLY,
-							  0,
-							  &vstream->stream_file.handle,
-							  true);
-		if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
-			goto error;
-		}
-	}
-
-	if (seek_t == LTTNG_VIEWER_SEEK_LAST && vstream->index_file) {
-		off_t lseek_ret;
-
-		lseek_ret = fs_handle_seek(vstream->index_file->file, 0, SEEK_END);
-		if (lseek_ret < 0) {
-			goto error;
-		}
-	}
 	if (stream->is_metadata) {
 		rcu_assign_pointer(stream->trace->viewer_metadata_stream, vstream);
 	}
@@ -211,6 +387,9 @@ struct relay_viewer_stream *viewer_stream_create(struct relay_stream *stream,
 	lttng_ht_node_init_u64(&vstream->stream_n, stream->stream_handle);
 	urcu_ref_init(&vstream->ref);
 	lttng_ht_add_unique_u64(viewer_streams_ht, &vstream->stream_n);
+	pthread_mutex_lock(&stream->trace->session->viewer_streams_lock);
+	cds_list_add_rcu(&vstream->session_node, &stream->trace->session->viewer_streams);
+	pthread_mutex_unlock(&stream->trace->session->viewer_streams_lock);
 
 	return vstream;
 
@@ -227,10 +406,15 @@ static void viewer_stream_unpublish(struct relay_viewer_stream *vstream)
 {
 	int ret;
 	struct lttng_ht_iter iter;
+	struct relay_session *session = vstream->stream->trace->session;
 
 	iter.iter.node = &vstream->stream_n.node;
 	ret = lttng_ht_del(viewer_streams_ht, &iter);
 	LTTNG_ASSERT(!ret);
+
+	pthread_mutex_lock(&session->viewer_streams_lock);
+	cds_list_del_rcu(&vstream->session_node);
+	pthread_mutex_unlock(&session->viewer_streams_lock);
 }
 
 static void viewer_stream_release(struct urcu_ref *ref)
@@ -259,18 +443,16 @@ bool viewer_stream_get(struct relay_viewer_stream *vstream)
  */
 struct relay_viewer_stream *viewer_stream_get_by_id(uint64_t id)
 {
-	struct lttng_ht_node_u64 *node;
-	struct lttng_ht_iter iter;
-	struct relay_viewer_stream *vstream = nullptr;
+	struct relay_viewer_stream *vstream;
 
 	lttng::urcu::read_lock_guard read_lock;
-	lttng_ht_lookup(viewer_streams_ht, &id, &iter);
-	node = lttng_ht_iter_get_node_u64(&iter);
-	if (!node) {
+	vstream = lttng::ht<lttng_ht_node_u64, relay_viewer_stream, &relay_viewer_stream::stream_n>(
+			  *viewer_streams_ht)
+			  .find(id);
+	if (!vstream) {
 		DBG("Relay viewer stream %" PRIu64 " not found", id);
 		goto end;
 	}
-	vstream = lttng::utils::container_of(node, &relay_viewer_stream::stream_n);
 	if (!viewer_stream_get(vstream)) {
 		vstream = nullptr;
 	}
@@ -294,6 +476,9 @@ void viewer_stream_close_files(struct relay_viewer_stream *vstream)
 		fs_handle_close(vstream->stream_file.handle);
 		vstream->stream_file.handle = nullptr;
 	}
+
+	/* The next files are read from their start. */
+	vstream->pending_index_position = 0;
 }
 
 void viewer_stream_sync_tracefile_array_tail(struct relay_viewer_stream *vstream)
@@ -19,6 +19,7 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
+#include <urcu/list.h>
 
 struct relay_stream;
 
@@ -67,6 +68,12 @@ struct relay_viewer_stream {
 	 * updated when catching up with the producer.
 	 */
 	uint64_t index_sent_seqcount;
+	/*
+	 * Position, counted in indexes, at which to seek the index file of the
+	 * current tracefile once it is opened. The files of a viewer stream are
+	 * only opened on its first index request.
+	 */
+	uint64_t pending_index_position;
 
 	/* Indicates if this stream has been sent to a viewer client. */
 	bool sent_flag;
@@ -74,12 +81,15 @@ struct relay_viewer_stream {
 	uint64_t metadata_sent;
 
 	struct lttng_ht_node_u64 stream_n;
+	/* Node in the viewer stream list of the session of the stream. */
+	struct cds_list_head session_node;
 	struct rcu_head rcu_node;
 };
 
 struct relay_viewer_stream *viewer_stream_create(struct relay_stream *stream,
 						 struct lttng_trace_chunk *viewer_trace_chunk,
-						 enum lttng_viewer_seek seek_t);
+						 enum lttng_viewer_seek seek_t,
+						 uint64_t seek_timestamp);
 
 struct relay_viewer_stream *viewer_stream_get_by_id(uint64_t id);
 bool viewer_stream_get(struct relay_viewer_stream *vstream);
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "token-bucket.hpp"
+#include "write-scheduler.hpp"
+
+#include <common/common.hpp>
+#include <common/time.hpp>
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
+
+namespace {
+/* Keeps the tokens of the buckets far from overflowing. */
+const uint64_t max_rate = (uint64_t) INT64_MAX / 2;
+/* Longest wait of a writer thread before checking whether it must stop waiting. */
+const uint64_t max_wait_ns = 100 * NSEC_PER_MSEC;
+
+pthread_mutex_t bucket_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Bytes written. */
+struct token_bucket throughput_bucket;
+/* Writes. */
+struct token_bucket iops_bucket;
+/* Protected by `bucket_lock`, except `paced_writes` which is atomic. */
+struct write_scheduler_stats stats;
+bool stopped;
+
+/* Called with the bucket lock held. */
+uint64_t deficit_ns()
+{
+	return std::max(token_bucket_deficit_ns(&throughput_bucket),
+			token_bucket_deficit_ns(&iops_bucket));
+}
+
+/* Called with the bucket lock held. */
+void refill()
+{
+	const uint64_t deficit = deficit_ns();
+	uint64_t elapsed_ns;
+
+	elapsed_ns = token_bucket_refill(&throughput_bucket);
+	elapsed_ns = std::max(elapsed_ns, token_bucket_refill(&iops_bucket));
+
+	/* The writes were held back until the deficit was refilled. */
+	stats.pacing_delay_ns += std::min(deficit, elapsed_ns);
+}
+
+uint64_t delay_ns()
+{
+	uint64_t delay;
+
+	if (!write_scheduler_enabled() || CMM_LOAD_SHARED(stopped)) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&bucket_lock);
+	refill();
+	delay = deficit_ns();
+	pthread_mutex_unlock(&bucket_lock);
+
+	return delay;
+}
+
+int parse_rate(const char *rate, uint64_t *value)
+{
+	if (utils_parse_size_suffix(rate, value) || *value == 0 || *value > max_rate) {
+		return -1;
+	}
+
+	return 0;
+}
+} /* namespace */
+
+int write_scheduler_set_max_throughput(const char *rate)
+{
+	if (parse_rate(rate, &throughput_bucket.rate)) {
+		ERR("Invalid maximal write throughput: `%s`", rate);
+		return -1;
+	}
+
+	return 0;
+}
+
+int write_scheduler_set_max_iops(const char *rate)
+{
+	unsigned long long value;
+	char *end;
+
+	errno = 0;
+	value = strtoull(rate, &end, 10);
+	if (errno || end == rate || *end != '\0' || !isdigit((unsigned char) rate[0]) ||
+	    value == 0 || value > max_rate) {
+		ERR("Invalid maximal write rate: `%s` (expecting a count of writes per second)",
+		    rate);
+		return -1;
+	}
+
+	iops_bucket.rate = value;
+	return 0;
+}
+
+bool write_scheduler_enabled()
+{
+	return throughput_bucket.rate > 0 || iops_bucket.rate > 0;
+}
+
+void write_scheduler_charge(uint64_t len)
+{
+	if (!write_scheduler_enabled()) {
+		return;
+	}
+
+	pthread_mutex_lock(&bucket_lock);
+	refill();
+	if (throughput_bucket.rate > 0) {
+		token_bucket_consume(&throughput_bucket, std::min(len, max_rate));
+	}
+
+	if (iops_bucket.rate > 0) {
+		token_bucket_consume(&iops_bucket, 1);
+	}
+
+	stats.charged_bytes += len;
+	stats.charged_writes++;
+	pthread_mutex_unlock(&bucket_lock);
+}
+
+int write_scheduler_delay_ms()
+{
+	const uint64_t delay = delay_ns();
+
+	if (delay == 0) {
+		return 0;
+	}
+
+	/* Round up so that the budget has refilled once the delay elapsed. */
+	return (int) std::min<uint64_t>((delay + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC, INT_MAX);
+}
+
+void write_scheduler_count_paced_write()
+{
+	uatomic_inc(&stats.paced_writes);
+}
+
+void write_scheduler_wait()
+{
+	uint64_t delay = delay_ns();
+
+	if (delay == 0) {
+		return;
+	}
+
+	write_scheduler_count_paced_write();
+	while (delay > 0) {
+		const uint64_t wait_ns = std::min(delay, max_wait_ns);
+		struct timespec wait = {};
+
+		wait.tv_sec = wait_ns / NSEC_PER_SEC;
+		wait.tv_nsec = wait_ns % NSEC_PER_SEC;
+		while (nanosleep(&wait, &wait) && errno == EINTR) {
+		}
+
+		/* Other threads may have charged the budget in the meantime. */
+		delay = delay_ns();
+	}
+}
+
+void write_scheduler_stop()
+{
+	CMM_STORE_SHARED(stopped, true);
+}
+
+void write_scheduler_get_stats(struct write_scheduler_stats *stats_out)
+{
+	pthread_mutex_lock(&bucket_lock);
+	*stats_out = stats;
+	pthread_mutex_unlock(&bucket_lock);
+	stats_out->paced_writes = uatomic_read(&stats.paced_writes);
+}
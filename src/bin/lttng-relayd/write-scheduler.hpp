@@ -0,0 +1,79 @@
+#ifndef _WRITE_SCHEDULER_H
+#define _WRITE_SCHEDULER_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdint.h>
+
+/*
+ * Global budget of the disk writes of the relay daemon.
+ *
+ * When a maximal throughput or a maximal write rate is set, every write to
+ * the stream and index files is charged to a global budget, which refills
+ * at the configured rates and holds at most one second worth of writes.
+ *
+ * Once the budget is overspent, the worker threads stop reading the data
+ * connections, so that TCP back-pressure slows down the consumer daemons,
+ * and the writer threads wait before writing their next packet, until the
+ * budget refills. The control connections, and thus the index writes on
+ * which the live viewers depend, are charged but never held back.
+ */
+struct write_scheduler_stats {
+	/* Bytes and writes charged to the budget. */
+	uint64_t charged_bytes;
+	uint64_t charged_writes;
+	/* Time during which the writes were held back. */
+	uint64_t pacing_delay_ns;
+	/* Data connection suspensions and packet write waits of the writer threads. */
+	uint64_t paced_writes;
+};
+
+/*
+ * Set the maximal throughput, in bytes per second, of the writes from a
+ * size with an optional `k`, `M` or `G` suffix.
+ *
+ * Return 0 on success, -1 if the rate is invalid.
+ */
+int write_scheduler_set_max_throughput(const char *rate);
+
+/*
+ * Set the maximal number of writes per second.
+ *
+ * Return 0 on success, -1 if the rate is invalid.
+ */
+int write_scheduler_set_max_iops(const char *rate);
+
+bool write_scheduler_enabled();
+
+/* Account for a write of `len` bytes. Never waits. */
+void write_scheduler_charge(uint64_t len);
+
+/*
+ * Return the time, in milliseconds, until the budget is no longer
+ * overspent, 0 if it isn't.
+ */
+int write_scheduler_delay_ms();
+
+/*
+ * Account for a data connection suspended, or a packet write delayed, until
+ * the budget refills.
+ */
+void write_scheduler_count_paced_write();
+
+/*
+ * Wait until the budget is no longer overspent, or until the scheduler is
+ * stopped.
+ */
+void write_scheduler_wait();
+
+/* Stop holding back the writes, letting the writer threads drain their queues. */
+void write_scheduler_stop();
+
+void write_scheduler_get_stats(struct write_scheduler_stats *stats);
+
+#endif /* _WRITE_SCHEDULER_H */
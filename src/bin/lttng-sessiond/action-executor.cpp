@@ -16,6 +16,8 @@
 #include <common/dynamic-array.hpp>
 #include <common/macros.hpp>
 #include <common/optional.hpp>
+#include <common/slab-allocator.hpp>
+#include <common/time.hpp>
 #include <common/urcu.hpp>
 
 #include <lttng/action/action-internal.hpp>
@@ -37,12 +39,24 @@
 #include <stddef.h>
 #include <urcu/list.h>
 
-#define THREAD_NAME	      "Action Executor"
+#define NOTIFY_LANE_THREAD_NAME	 "Action Executor"
+#define SESSION_LANE_THREAD_NAME "Session Action Executor"
+/* Per lane. */
 #define MAX_QUEUED_WORK_COUNT 8192
 
-struct action_executor {
+enum action_executor_lane_type {
+	/* Work items of the triggers which only have notify actions. */
+	ACTION_EXECUTOR_LANE_NOTIFY,
+	/* Work items of the triggers which have session actions. */
+	ACTION_EXECUTOR_LANE_SESSION,
+	ACTION_EXECUTOR_LANE_COUNT,
+};
+
+/* Queue of work items executed in order by a thread. */
+struct action_executor_lane {
+	const char *name;
+	struct action_executor *executor;
 	struct lttng_thread *thread;
-	struct notification_thread_handle *notification_thread_handle;
 	struct {
 		uint64_t pending_count;
 		struct cds_list_head list;
@@ -50,6 +64,21 @@ struct action_executor {
 		pthread_mutex_t lock;
 	} work;
 	bool should_quit;
+};
+
+struct action_executor {
+	struct notification_thread_handle *notification_thread_handle;
+	/*
+	 * The session actions (start, stop, rotate and snapshot) can take a
+	 * while to execute: the work items of the triggers having such actions
+	 * are executed by their own thread so as not to delay the notifications
+	 * of the other triggers.
+	 *
+	 * All the work items of a trigger are queued on the same lane and are
+	 * thus executed in order. The session actions are serialized by the
+	 * session list lock anyway.
+	 */
+	struct action_executor_lane lanes[ACTION_EXECUTOR_LANE_COUNT];
 	uint64_t next_work_item_id;
 };
 
@@ -102,10 +131,16 @@ struct action_work_item {
 	struct notification_client_list *client_list;
 	LTTNG_OPTIONAL(struct lttng_credentials) object_creds;
 	struct cds_list_head list_node;
+	struct timespec enqueue_time;
 };
 
 struct action_work_subitem {
 	struct lttng_action *action;
+	/*
+	 * Whether the rate policy of the action, evaluated when the work item
+	 * is queued, allows its execution.
+	 */
+	bool should_execute;
 	struct {
 		/* Used by actions targeting a session. */
 		LTTNG_OPTIONAL(uint64_t) session_id;
@@ -113,6 +148,13 @@ struct action_work_subitem {
 };
 } /* namespace */
 
+/*
+ * Work items are allocated by the notification thread and freed by the
+ * executor threads.
+ */
+static lttng::slab_allocator work_item_allocator("action_work_item",
+						 sizeof(struct action_work_item));
+
 /*
  * Only return non-zero on a fatal error that should shut down the action
  * executor.
@@ -627,7 +669,7 @@ static int action_executor_snapshot_session_handler(struct action_executor *exec
 		goto error_unlock_session;
 	}
 
-	cmd_ret = (lttng_error_code) cmd_snapshot_record(session, snapshot_output, 0);
+	cmd_ret = (lttng_error_code) cmd_snapshot_record(session, snapshot_output, 0, -1);
 	switch (cmd_ret) {
 	case LTTNG_OK:
 		DBG("Successfully recorded snapshot of session `%s` on behalf of trigger `%s`",
@@ -671,8 +713,7 @@ static int action_executor_generic_handler(struct action_executor *executor,
 
 	LTTNG_ASSERT(action_type != LTTNG_ACTION_TYPE_UNKNOWN);
 
-	lttng_action_increase_execution_request_count(action);
-	if (!lttng_action_should_execute(action)) {
+	if (!item->should_execute) {
 		DBG("Policy prevented execution of action `%s` of trigger `%s` action work item %" PRIu64,
 		    get_action_name(action),
 		    get_trigger_name(work_item->trigger),
@@ -725,47 +766,59 @@ static void action_work_item_destroy(struct action_work_item *work_item)
 	lttng_evaluation_destroy(work_item->evaluation);
 	notification_client_list_put(work_item->client_list);
 	lttng_dynamic_array_reset(&work_item->subitems);
-	free(work_item);
+	work_item_allocator.free(work_item);
 }
 
 static void *action_executor_thread(void *_data)
 {
-	struct action_executor *executor = (action_executor *) _data;
+	struct action_executor_lane *lane = (action_executor_lane *) _data;
 
-	LTTNG_ASSERT(executor);
+	LTTNG_ASSERT(lane);
 
 	health_register(the_health_sessiond, HEALTH_SESSIOND_TYPE_ACTION_EXECUTOR);
 
 	rcu_register_thread();
 	rcu_thread_online();
 
-	DBG("Entering work execution loop");
-	pthread_mutex_lock(&executor->work.lock);
-	while (!executor->should_quit) {
+	DBG("Entering work execution loop of %s action executor lane", lane->name);
+	pthread_mutex_lock(&lane->work.lock);
+	while (!lane->should_quit) {
 		int ret = 0;
 		struct action_work_item *work_item;
+		struct timespec now;
+		unsigned long queued_ms;
 
 		health_code_update();
-		if (executor->work.pending_count == 0) {
+		if (lane->work.pending_count == 0) {
 			health_poll_entry();
 			DBG("No work items enqueued, entering wait");
-			pthread_cond_wait(&executor->work.cond, &executor->work.lock);
+			pthread_cond_wait(&lane->work.cond, &lane->work.lock);
 			DBG("Woke-up from wait");
 			health_poll_exit();
 			continue;
 		}
 
 		/* Pop item from front of the list with work lock held. */
-		work_item = cds_list_first_entry(
-			&executor->work.list, struct action_work_item, list_node);
+		work_item =
+			cds_list_first_entry(&lane->work.list, struct action_work_item, list_node);
 		cds_list_del(&work_item->list_node);
-		executor->work.pending_count--;
+		lane->work.pending_count--;
+
+		if (!lttng_clock_gettime(CLOCK_MONOTONIC, &now) &&
+		    !timespec_to_ms(timespec_abs_diff(now, work_item->enqueue_time), &queued_ms)) {
+			DBG("Dequeued action work item %" PRIu64
+			    " from %s lane: queued for %lu ms, %" PRIu64 " work items left",
+			    work_item->id,
+			    lane->name,
+			    queued_ms,
+			    lane->work.pending_count);
+		}
 
 		/*
 		 * Work can be performed without holding the work lock,
 		 * allowing new items to be queued.
 		 */
-		pthread_mutex_unlock(&executor->work.lock);
+		pthread_mutex_unlock(&lane->work.lock);
 
 		/* Execute item only if a trigger is registered. */
 		lttng_trigger_lock(work_item->trigger);
@@ -789,7 +842,7 @@ static void *action_executor_thread(void *_data)
 			goto skip_execute;
 		}
 
-		ret = action_work_item_execute(executor, work_item);
+		ret = action_work_item_execute(lane->executor, work_item);
 
 	skip_execute:
 		lttng_trigger_unlock(work_item->trigger);
@@ -800,11 +853,11 @@ static void *action_executor_thread(void *_data)
 		}
 
 		health_code_update();
-		pthread_mutex_lock(&executor->work.lock);
+		pthread_mutex_lock(&lane->work.lock);
 	}
 
-	if (executor->should_quit) {
-		pthread_mutex_unlock(&executor->work.lock);
+	if (lane->should_quit) {
+		pthread_mutex_unlock(&lane->work.lock);
 	}
 	DBG("Left work execution loop");
 
@@ -819,71 +872,124 @@ static void *action_executor_thread(void *_data)
 
 static bool shutdown_action_executor_thread(void *_data)
 {
-	struct action_executor *executor = (action_executor *) _data;
+	struct action_executor_lane *lane = (action_executor_lane *) _data;
 
-	pthread_mutex_lock(&executor->work.lock);
-	executor->should_quit = true;
-	pthread_cond_signal(&executor->work.cond);
-	pthread_mutex_unlock(&executor->work.lock);
+	pthread_mutex_lock(&lane->work.lock);
+	lane->should_quit = true;
+	pthread_cond_signal(&lane->work.cond);
+	pthread_mutex_unlock(&lane->work.lock);
 	return true;
 }
 
-static void clean_up_action_executor_thread(void *_data)
+/*
+ * Shut down the threads of the lanes and discard their remaining work items.
+ */
+static void action_executor_fini(struct action_executor *executor)
 {
-	struct action_executor *executor = (action_executor *) _data;
+	for (auto& lane : executor->lanes) {
+		struct action_work_item *work_item, *tmp;
 
-	LTTNG_ASSERT(cds_list_empty(&executor->work.list));
+		if (lane.thread) {
+			/* TODO Wait for work list to drain? */
+			lttng_thread_shutdown(lane.thread);
+			lttng_thread_put(lane.thread);
+		}
+
+		if (lane.work.pending_count != 0) {
+			WARN("%" PRIu64 " trigger action%s still queued for execution in %s lane "
+			     "and will be discarded",
+			     lane.work.pending_count,
+			     lane.work.pending_count == 1 ? " is" : "s are",
+			     lane.name);
+		}
+
+		cds_list_for_each_entry_safe (work_item, tmp, &lane.work.list, list_node) {
+			WARN("Discarding action work item %" PRIu64 " associated to trigger `%s`",
+			     work_item->id,
+			     get_trigger_name(work_item->trigger));
+			cds_list_del(&work_item->list_node);
+			action_work_item_destroy(work_item);
+		}
+
+		pthread_mutex_destroy(&lane.work.lock);
+		pthread_cond_destroy(&lane.work.cond);
+	}
 
-	pthread_mutex_destroy(&executor->work.lock);
-	pthread_cond_destroy(&executor->work.cond);
 	free(executor);
 }
 
 struct action_executor *action_executor_create(struct notification_thread_handle *handle)
 {
 	struct action_executor *executor = zmalloc<action_executor>();
+	unsigned int i;
 
 	if (!executor) {
-		goto end;
+		return nullptr;
 	}
 
-	CDS_INIT_LIST_HEAD(&executor->work.list);
-	pthread_cond_init(&executor->work.cond, nullptr);
-	pthread_mutex_init(&executor->work.lock, nullptr);
 	executor->notification_thread_handle = handle;
+	executor->lanes[ACTION_EXECUTOR_LANE_NOTIFY].name = "notify";
+	executor->lanes[ACTION_EXECUTOR_LANE_SESSION].name = "session";
+	for (i = 0; i < ACTION_EXECUTOR_LANE_COUNT; i++) {
+		struct action_executor_lane *lane = &executor->lanes[i];
+
+		lane->executor = executor;
+		CDS_INIT_LIST_HEAD(&lane->work.list);
+		pthread_cond_init(&lane->work.cond, nullptr);
+		pthread_mutex_init(&lane->work.lock, nullptr);
+	}
+
+	for (i = 0; i < ACTION_EXECUTOR_LANE_COUNT; i++) {
+		struct action_executor_lane *lane = &executor->lanes[i];
+
+		lane->thread = lttng_thread_create(i == ACTION_EXECUTOR_LANE_NOTIFY ?
+							   NOTIFY_LANE_THREAD_NAME :
+							   SESSION_LANE_THREAD_NAME,
+						   action_executor_thread,
+						   shutdown_action_executor_thread,
+						   nullptr,
+						   lane);
+		if (!lane->thread) {
+			action_executor_fini(executor);
+			return nullptr;
+		}
+	}
 
-	executor->thread = lttng_thread_create(THREAD_NAME,
-					       action_executor_thread,
-					       shutdown_action_executor_thread,
-					       clean_up_action_executor_thread,
-					       executor);
-end:
 	return executor;
 }
 
 void action_executor_destroy(struct action_executor *executor)
 {
-	struct action_work_item *work_item, *tmp;
-
-	/* TODO Wait for work list to drain? */
-	lttng_thread_shutdown(executor->thread);
-	pthread_mutex_lock(&executor->work.lock);
-	if (executor->work.pending_count != 0) {
-		WARN("%" PRIu64
-		     " trigger action%s still queued for execution and will be discarded",
-		     executor->work.pending_count,
-		     executor->work.pending_count == 1 ? " is" : "s are");
-	}
+	action_executor_fini(executor);
+}
 
-	cds_list_for_each_entry_safe (work_item, tmp, &executor->work.list, list_node) {
-		WARN("Discarding action work item %" PRIu64 " associated to trigger `%s`",
-		     work_item->id,
-		     get_trigger_name(work_item->trigger));
-		cds_list_del(&work_item->list_node);
-		action_work_item_destroy(work_item);
+/*
+ * Account for the execution request of the actions of a work item, and
+ * evaluate their rate policy, as the work item is queued.
+ *
+ * The rate policies are evaluated by the notification thread, the only one
+ * which queues work items, rather than by the action executor: the work items
+ * of the notifications which wouldn't execute any action, typically most of
+ * the event rule matches notifications of a trigger with an "every N" or a
+ * "once after N" policy, are discarded without being queued.
+ *
+ * Return whether any action of the work item should be executed.
+ */
+static bool apply_subitem_rate_policies(struct lttng_dynamic_array *subitems)
+{
+	bool any_should_execute = false;
+	size_t i;
+
+	for (i = 0; i < lttng_dynamic_array_get_count(subitems); i++) {
+		struct action_work_subitem *item =
+			(action_work_subitem *) lttng_dynamic_array_get_element(subitems, i);
+
+		lttng_action_increase_execution_request_count(item->action);
+		item->should_execute = lttng_action_should_execute(item->action);
+		any_should_execute |= item->should_execute;
 	}
-	pthread_mutex_unlock(&executor->work.lock);
-	lttng_thread_put(executor->thread);
+
+	return any_should_execute;
 }
 
 /* RCU read-lock must be held by the caller. */
@@ -895,31 +1001,20 @@ action_executor_enqueue_trigger(struct action_executor *executor,
 				struct notification_client_list *client_list)
 {
 	int ret;
-	enum action_executor_status executor_status = ACTION_EXECUTOR_STATUS_OK;
 	const uint64_t work_item_id = executor->next_work_item_id++;
 	struct action_work_item *work_item;
-	bool signal = false;
+	struct action_executor_lane *lane;
+	size_t i;
 
 	LTTNG_ASSERT(trigger);
 	ASSERT_RCU_READ_LOCKED();
 
-	pthread_mutex_lock(&executor->work.lock);
-	/* Check for queue overflow. */
-	if (executor->work.pending_count >= MAX_QUEUED_WORK_COUNT) {
-		/* Most likely spammy, remove if it is the case. */
-		DBG("Refusing to enqueue action for trigger (overflow): trigger name = `%s`, work item id = %" PRIu64,
-		    get_trigger_name(trigger),
-		    work_item_id);
-		executor_status = ACTION_EXECUTOR_STATUS_OVERFLOW;
-		goto error_unlock;
-	}
-
-	work_item = zmalloc<action_work_item>();
+	work_item = work_item_allocator.zalloc<action_work_item>();
 	if (!work_item) {
 		PERROR("Failed to allocate action executor work item: trigger name = `%s`",
 		       get_trigger_name(trigger));
-		executor_status = ACTION_EXECUTOR_STATUS_ERROR;
-		goto error_unlock;
+		lttng_evaluation_destroy(evaluation);
+		return ACTION_EXECUTOR_STATUS_ERROR;
 	}
 
 	lttng_trigger_get(trigger);
@@ -934,7 +1029,6 @@ action_executor_enqueue_trigger(struct action_executor *executor,
 
 	/* Ownership transferred to the work item. */
 	work_item->evaluation = evaluation;
-	evaluation = nullptr;
 
 	work_item->client_list = client_list;
 	work_item->object_creds.is_set = !!object_creds;
@@ -953,25 +1047,56 @@ action_executor_enqueue_trigger(struct action_executor *executor,
 	if (ret) {
 		ERR("Failed to populate work item sub items on behalf of trigger: trigger name = `%s`",
 		    get_trigger_name(trigger));
-		executor_status = ACTION_EXECUTOR_STATUS_ERROR;
-		goto error_unlock;
+		action_work_item_destroy(work_item);
+		return ACTION_EXECUTOR_STATUS_ERROR;
 	}
 
-	cds_list_add_tail(&work_item->list_node, &executor->work.list);
-	executor->work.pending_count++;
-	DBG("Enqueued action for trigger: trigger name = `%s`, work item id = %" PRIu64,
-	    get_trigger_name(trigger),
-	    work_item_id);
-	signal = true;
+	lane = &executor->lanes[ACTION_EXECUTOR_LANE_NOTIFY];
+	for (i = 0; i < lttng_dynamic_array_get_count(&work_item->subitems); i++) {
+		const struct action_work_subitem *item =
+			(const action_work_subitem *) lttng_dynamic_array_get_element(
+				&work_item->subitems, i);
 
-error_unlock:
-	if (signal) {
-		pthread_cond_signal(&executor->work.cond);
+		if (lttng_action_get_type(item->action) != LTTNG_ACTION_TYPE_NOTIFY) {
+			lane = &executor->lanes[ACTION_EXECUTOR_LANE_SESSION];
+			break;
+		}
 	}
 
-	pthread_mutex_unlock(&executor->work.lock);
-	lttng_evaluation_destroy(evaluation);
-	return executor_status;
+	(void) lttng_clock_gettime(CLOCK_MONOTONIC, &work_item->enqueue_time);
+
+	pthread_mutex_lock(&lane->work.lock);
+	/* Check for queue overflow. */
+	if (lane->work.pending_count >= MAX_QUEUED_WORK_COUNT) {
+		pthread_mutex_unlock(&lane->work.lock);
+		/* Most likely spammy, remove if it is the case. */
+		DBG("Refusing to enqueue action for trigger (overflow): trigger name = `%s`, work item id = %" PRIu64,
+		    get_trigger_name(trigger),
+		    work_item_id);
+		action_work_item_destroy(work_item);
+		return ACTION_EXECUTOR_STATUS_OVERFLOW;
+	}
+
+	if (!apply_subitem_rate_policies(&work_item->subitems)) {
+		pthread_mutex_unlock(&lane->work.lock);
+		DBG("Policy prevented execution of all actions of trigger `%s`: work item id = %" PRIu64,
+		    get_trigger_name(trigger),
+		    work_item_id);
+		action_work_item_destroy(work_item);
+		return ACTION_EXECUTOR_STATUS_OK;
+	}
+
+	cds_list_add_tail(&work_item->list_node, &lane->work.list);
+	lane->work.pending_count++;
+	DBG("Enqueued action for trigger: trigger name = `%s`, work item id = %" PRIu64
+	    ", lane = %s, queued work items = %" PRIu64,
+	    get_trigger_name(trigger),
+	    work_item_id,
+	    lane->name,
+	    lane->work.pending_count);
+	pthread_cond_signal(&lane->work.cond);
+	pthread_mutex_unlock(&lane->work.lock);
+	return ACTION_EXECUTOR_STATUS_OK;
 }
 
 static int add_action_to_subitem_array(struct lttng_action *action,
@@ -983,6 +1108,7 @@ static int add_action_to_subitem_array(struct lttng_action *action,
 	enum lttng_action_status status;
 	struct action_work_subitem subitem = {
 		.action = nullptr,
+		.should_execute = false,
 		.context = {
 			.session_id = LTTNG_OPTIONAL_INIT_UNSET,
 		},
@@ -17,7 +17,9 @@
 
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
+#include <common/pipe.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/thread-pool.hpp>
 #include <common/urcu.hpp>
 #include <common/uri.hpp>
 #include <common/utils.hpp>
@@ -39,6 +41,17 @@ struct agent_protocol_version {
 	unsigned int major, minor;
 };
 
+/*
+ * Registration of an accepted agent connection, completed by a registration
+ * worker.
+ */
+struct agent_registration {
+	struct lttng_thread_pool_work work;
+	struct lttcomm_sock *sock;
+	/* Write end of the pipe handing the registered sockets to the thread. */
+	int registered_pipe_fd;
+};
+
 int agent_tracing_enabled = -1;
 
 /*
@@ -245,29 +258,22 @@ static bool is_agent_protocol_version_supported(const struct agent_protocol_vers
 }
 
 /*
- * Handle a new agent connection on the registration socket.
+ * Receive the registration message of a new agent connection.
  *
- * Returns 0 on success, or else a negative errno value.
- * On success, the resulting socket is returned through `agent_app_socket`
- * and the application's reported id is updated through `agent_app_id`.
+ * Returns 0 on success, or else a negative errno value. On error, the
+ * socket is closed and destroyed.
+ * On success, the application's reported id is updated through
+ * `agent_app_id`.
  */
-static int accept_agent_connection(struct lttcomm_sock *reg_sock,
-				   struct agent_app_id *agent_app_id,
-				   struct lttcomm_sock **agent_app_socket)
+static int receive_agent_registration(struct lttcomm_sock *new_sock,
+				      struct agent_app_id *agent_app_id)
 {
 	int ret;
 	struct agent_protocol_version agent_version;
 	ssize_t size;
 	struct agent_register_msg msg;
-	struct lttcomm_sock *new_sock;
-
-	LTTNG_ASSERT(reg_sock);
 
-	new_sock = reg_sock->ops->accept(reg_sock);
-	if (!new_sock) {
-		ret = -ENOTCONN;
-		goto end;
-	}
+	LTTNG_ASSERT(new_sock);
 
 	size = new_sock->ops->recvmsg(new_sock, &msg, sizeof(msg), 0);
 	if (size < sizeof(msg)) {
@@ -305,18 +311,133 @@ static int accept_agent_connection(struct lttcomm_sock *reg_sock,
 	     domain_type_str(agent_app_id->domain),
 	     new_sock->fd);
 
-	*agent_app_socket = new_sock;
-	new_sock = nullptr;
-	ret = 0;
-	goto end;
+	return 0;
 
 error_close_socket:
 	new_sock->ops->close(new_sock);
 	lttcomm_destroy_sock(new_sock);
-end:
 	return ret;
 }
 
+/*
+ * Complete the registration of an agent connection: receive its registration
+ * message, update it with the sessions and publish it. Runs on a registration
+ * worker so that a slow agent only delays its own registration.
+ *
+ * The socket of the registered agent is then handed to the agent management
+ * thread, which monitors its shutdown.
+ */
+static void run_agent_registration(struct lttng_thread_pool_work *work)
+{
+	int ret;
+	struct agent_registration *registration =
+		lttng::utils::container_of(work, &agent_registration::work);
+	struct lttcomm_sock *new_app_socket = registration->sock;
+	const int registered_pipe_fd = registration->registered_pipe_fd;
+	struct agent_app_id new_app_id;
+	struct agent_app *new_app;
+	int new_app_socket_fd;
+	ssize_t size;
+
+	free(registration);
+
+	ret = receive_agent_registration(new_app_socket, &new_app_id);
+	if (ret < 0) {
+		/* Errors are already logged. */
+		return;
+	}
+
+	/* new_app_socket's ownership has been transferred to the new agent app. */
+	new_app = agent_create_app(new_app_id.pid, new_app_id.domain, new_app_socket);
+	if (!new_app) {
+		new_app_socket->ops->close(new_app_socket);
+		lttcomm_destroy_sock(new_app_socket);
+		return;
+	}
+	new_app_socket_fd = new_app_socket->fd;
+
+	/*
+	 * Prevent sessions from being modified while the agent application's
+	 * configuration is updated.
+	 */
+	session_lock_list();
+
+	/* Update the newly registered applications's configuration. */
+	update_agent_app(new_app);
+
+	ret = agent_send_registration_done(new_app);
+	if (ret < 0) {
+		session_unlock_list();
+		agent_destroy_app(new_app);
+		return;
+	}
+
+	/* Publish the new agent app. */
+	agent_add_app(new_app);
+
+	session_unlock_list();
+
+	size = lttng_write(registered_pipe_fd, &new_app_socket_fd, sizeof(new_app_socket_fd));
+	if (size != sizeof(new_app_socket_fd)) {
+		/* The agent management thread is exiting. */
+		DBG("Failed to hand the socket of the registered agent application to the agent management thread: socket fd = %d",
+		    new_app_socket_fd);
+		agent_destroy_app_by_sock(new_app_socket_fd);
+	}
+}
+
+/*
+ * Accept a new agent connection on the registration socket and queue its
+ * registration to the registration workers.
+ */
+static void accept_agent_connection(struct lttcomm_sock *reg_sock,
+				    struct lttng_thread_pool *registration_pool,
+				    int registered_pipe_fd)
+{
+	struct lttcomm_sock *new_sock;
+	struct agent_registration *registration;
+
+	LTTNG_ASSERT(reg_sock);
+
+	new_sock = reg_sock->ops->accept(reg_sock);
+	if (!new_sock) {
+		return;
+	}
+
+	/*
+	 * Bound the time an unresponsive agent can hold a registration
+	 * worker. app_socket_timeout is in seconds, whereas
+	 * lttcomm_setsockopt_rcv_timeout and lttcomm_setsockopt_snd_timeout
+	 * expect msec as parameter.
+	 */
+	if (the_config.app_socket_timeout >= 0) {
+		(void) lttcomm_setsockopt_rcv_timeout(new_sock->fd,
+						      the_config.app_socket_timeout * 1000);
+		(void) lttcomm_setsockopt_snd_timeout(new_sock->fd,
+						      the_config.app_socket_timeout * 1000);
+	}
+
+	registration = zmalloc<agent_registration>();
+	if (!registration) {
+		ERR("Failed to allocate agent registration");
+		goto error;
+	}
+
+	registration->work.run = run_agent_registration;
+	registration->sock = new_sock;
+	registration->registered_pipe_fd = registered_pipe_fd;
+	if (!lttng_thread_pool_submit(registration_pool, &registration->work)) {
+		free(registration);
+		goto error;
+	}
+
+	return;
+
+error:
+	new_sock->ops->close(new_sock);
+	lttcomm_destroy_sock(new_sock);
+}
+
 bool agent_tracing_is_enabled()
 {
 	int enabled;
@@ -358,6 +479,10 @@ static void *thread_agent_management(void *data)
 	struct lttcomm_sock *reg_sock;
 	struct thread_notifiers *notifiers = (thread_notifiers *) data;
 	const auto thread_quit_pipe_fd = lttng_pipe_get_readfd(notifiers->quit_pipe);
+	struct lttng_pipe *registered_pipe = nullptr;
+	struct lttng_thread_pool *registration_pool = nullptr;
+	struct lttng_thread_pool_attr registration_pool_attr = {};
+	int registered_pipe_fd = -1;
 
 	DBG("Manage agent application registration.");
 
@@ -367,8 +492,11 @@ static void *thread_agent_management(void *data)
 	/* Agent initialization call MUST be called before starting the thread. */
 	LTTNG_ASSERT(the_agent_apps_ht_by_sock);
 
-	/* Create pollset with size 2, quit pipe and registration socket. */
-	ret = lttng_poll_create(&events, 2, LTTNG_CLOEXEC);
+	/*
+	 * Create pollset with size 3, quit pipe, registration socket and pipe
+	 * of the sockets of the agents registered by the registration workers.
+	 */
+	ret = lttng_poll_create(&events, 3, LTTNG_CLOEXEC);
 	if (ret < 0) {
 		goto error_poll_create;
 	}
@@ -405,6 +533,26 @@ static void *thread_agent_management(void *data)
 	uatomic_set(&agent_tracing_enabled, 1);
 	mark_thread_as_ready(notifiers);
 
+	registered_pipe = lttng_pipe_open(FD_CLOEXEC);
+	if (!registered_pipe) {
+		ERR("Failed to create the pipe of the registered agent applications");
+		goto error;
+	}
+	registered_pipe_fd = lttng_pipe_get_readfd(registered_pipe);
+
+	ret = lttng_poll_add(&events, registered_pipe_fd, LPOLLIN);
+	if (ret < 0) {
+		goto error;
+	}
+
+	registration_pool_attr.name = "Agent registration";
+	registration_pool_attr.thread_count = the_config.agent_registration_thread_count;
+	registration_pool = lttng_thread_pool_create(&registration_pool_attr);
+	if (!registration_pool) {
+		ERR("Failed to create the agent registration thread pool");
+		goto error;
+	}
+
 	/* Add TCP socket to the poll set. */
 	ret = lttng_poll_add(&events, reg_sock->fd, LPOLLIN | LPOLLRDHUP);
 	if (ret < 0) {
@@ -441,34 +589,22 @@ static void *thread_agent_management(void *data)
 				goto exit;
 			}
 
-			/* Activity on the registration socket. */
-			if (revents & LPOLLIN) {
-				struct agent_app_id new_app_id;
-				struct agent_app *new_app = nullptr;
-				struct lttcomm_sock *new_app_socket;
+			/* Socket of an agent application registered by a worker. */
+			if (pollfd == registered_pipe_fd) {
 				int new_app_socket_fd;
+				ssize_t size;
 
-				LTTNG_ASSERT(pollfd == reg_sock->fd);
-
-				ret = accept_agent_connection(
-					reg_sock, &new_app_id, &new_app_socket);
-				if (ret < 0) {
-					/* Errors are already logged. */
-					continue;
+				if (!(revents & LPOLLIN)) {
+					ERR("Registered agent applications pipe error");
+					goto exit;
 				}
 
-				/*
-				 * new_app_socket's ownership has been
-				 * transferred to the new agent app.
-				 */
-				new_app = agent_create_app(
-					new_app_id.pid, new_app_id.domain, new_app_socket);
-				if (!new_app) {
-					new_app_socket->ops->close(new_app_socket);
-					continue;
+				size = lttng_read(
+					pollfd, &new_app_socket_fd, sizeof(new_app_socket_fd));
+				if (size != sizeof(new_app_socket_fd)) {
+					PERROR("Failed to read from the registered agent applications pipe");
+					goto exit;
 				}
-				new_app_socket_fd = new_app_socket->fd;
-				new_app_socket = nullptr;
 
 				/*
 				 * Since this is a command socket (write then
@@ -477,39 +613,25 @@ static void *thread_agent_management(void *data)
 				 */
 				ret = lttng_poll_add(&events, new_app_socket_fd, LPOLLRDHUP);
 				if (ret < 0) {
-					agent_destroy_app(new_app);
-					continue;
+					agent_destroy_app_by_sock(new_app_socket_fd);
 				}
+				continue;
+			}
 
-				/*
-				 * Prevent sessions from being modified while
-				 * the agent application's configuration is
-				 * updated.
-				 */
-				session_lock_list();
+			/* Activity on the registration socket. */
+			if (revents & LPOLLIN) {
+				LTTNG_ASSERT(pollfd == reg_sock->fd);
 
 				/*
-				 * Update the newly registered applications's
-				 * configuration.
+				 * Only accept the connection: the registration is
+				 * completed by a worker so that an agent slow to
+				 * send its registration message doesn't delay the
+				 * others.
 				 */
-				update_agent_app(new_app);
-
-				ret = agent_send_registration_done(new_app);
-				if (ret < 0) {
-					agent_destroy_app(new_app);
-					/* Removing from the poll set. */
-					ret = lttng_poll_del(&events, new_app_socket_fd);
-					if (ret < 0) {
-						session_unlock_list();
-						goto error;
-					}
-					continue;
-				}
-
-				/* Publish the new agent app. */
-				agent_add_app(new_app);
-
-				session_unlock_list();
+				accept_agent_connection(
+					reg_sock,
+					registration_pool,
+					lttng_pipe_get_writefd(registered_pipe));
 			} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
 				/* Removing from the poll set */
 				ret = lttng_poll_del(&events, pollfd);
@@ -528,6 +650,18 @@ exit:
 	/* Whatever happens, try to delete it and exit. */
 	(void) lttng_poll_del(&events, reg_sock->fd);
 error:
+	if (registered_pipe) {
+		/*
+		 * Close the read end first: the workers still completing a
+		 * registration then fail to hand over its socket and destroy
+		 * the agent application instead of blocking on a full pipe.
+		 */
+		(void) lttng_pipe_read_close(registered_pipe);
+	}
+	if (registration_pool) {
+		lttng_thread_pool_destroy(registration_pool);
+	}
+	lttng_pipe_destroy(registered_pipe);
 	destroy_tcp_socket(reg_sock);
 error_tcp_socket:
 	lttng_poll_clean(&events);
@@ -29,6 +29,14 @@
 
 #include <urcu/rculist.h>
 #include <urcu/uatomic.h>
+#include <vector>
+
+/*
+ * Maximal number of event enable commands sent to an agent application being
+ * updated before their replies are received. It bounds the replies the agent
+ * may have to buffer in its socket while the session daemon sends commands.
+ */
+#define AGENT_UPDATE_MAX_PENDING_REPLIES 64
 
 using event_rule_logging_get_name_pattern =
 	enum lttng_event_rule_status (*)(const struct lttng_event_rule *, const char **);
@@ -390,20 +398,20 @@ error:
 }
 
 /*
- * Internal enable agent event on a agent application. This function
- * communicates with the agent to enable a given event.
+ * Send the command enabling an event to an agent application, without waiting
+ * for its reply, which must be received with recv_enable_event_reply(). The
+ * agents process their commands in order, so that several commands can be
+ * sent before their replies are received.
  *
  * Return LTTNG_OK on success or else a LTTNG_ERR* code.
  */
-static int enable_event(const struct agent_app *app, struct agent_event *event)
+static int send_enable_event(const struct agent_app *app, const struct agent_event *event)
 {
 	int ret;
 	char *bytes_to_send;
 	uint64_t data_size;
 	size_t filter_expression_length;
-	uint32_t reply_ret_code;
 	struct lttcomm_agent_enable_event msg;
-	struct lttcomm_agent_generic_reply reply;
 
 	LTTNG_ASSERT(app);
 	LTTNG_ASSERT(app->sock);
@@ -434,11 +442,6 @@ static int enable_event(const struct agent_app *app, struct agent_event *event)
 	}
 	msg.filter_expression_length = htobe32(filter_expression_length);
 
-	ret = send_header(app->sock, data_size, AGENT_CMD_ENABLE, 0);
-	if (ret < 0) {
-		goto error_io;
-	}
-
 	bytes_to_send = calloc<char>(data_size);
 	if (!bytes_to_send) {
 		ret = LTTNG_ERR_NOMEM;
@@ -452,36 +455,56 @@ static int enable_event(const struct agent_app *app, struct agent_event *event)
 		       filter_expression_length);
 	}
 
+	ret = send_header(app->sock, data_size, AGENT_CMD_ENABLE, 0);
+	if (ret < 0) {
+		free(bytes_to_send);
+		goto error_io;
+	}
+
 	ret = send_payload(app->sock, bytes_to_send, data_size);
 	free(bytes_to_send);
 	if (ret < 0) {
 		goto error_io;
 	}
 
+	return LTTNG_OK;
+
+error_io:
+	ret = LTTNG_ERR_UST_ENABLE_FAIL;
+error:
+	return ret;
+}
+
+/*
+ * Receive the reply of an agent application to the oldest command enabling an
+ * event sent by send_enable_event() which wasn't replied to yet.
+ *
+ * Return LTTNG_OK on success or else a LTTNG_ERR* code.
+ */
+static int recv_enable_event_reply(const struct agent_app *app)
+{
+	int ret;
+	uint32_t reply_ret_code;
+	struct lttcomm_agent_generic_reply reply;
+
+	LTTNG_ASSERT(app);
+	LTTNG_ASSERT(app->sock);
+
 	ret = recv_reply(app->sock, &reply, sizeof(reply));
 	if (ret < 0) {
-		goto error_io;
+		return LTTNG_ERR_UST_ENABLE_FAIL;
 	}
 
 	reply_ret_code = be32toh(reply.ret_code);
 	log_reply_code(reply_ret_code);
 	switch (reply_ret_code) {
 	case AGENT_RET_CODE_SUCCESS:
-		break;
+		return LTTNG_OK;
 	case AGENT_RET_CODE_UNKNOWN_NAME:
-		ret = LTTNG_ERR_UST_EVENT_NOT_FOUND;
-		goto error;
+		return LTTNG_ERR_UST_EVENT_NOT_FOUND;
 	default:
-		ret = LTTNG_ERR_UNK;
-		goto error;
+		return LTTNG_ERR_UNK;
 	}
-
-	return LTTNG_OK;
-
-error_io:
-	ret = LTTNG_ERR_UST_ENABLE_FAIL;
-error:
-	return ret;
 }
 
 /*
@@ -685,19 +708,40 @@ int agent_enable_event(struct agent_event *event, enum lttng_domain_type domain)
 
 	{
 		lttng::urcu::read_lock_guard read_lock;
+		/* Applications to which the command was sent, awaiting their reply. */
+		std::vector<const struct agent_app *> sent_apps;
 
+		/*
+		 * Enable event on agent applications through TCP socket, sending
+		 * the command to every application before waiting for their
+		 * replies.
+		 */
+		ret = LTTNG_OK;
 		cds_lfht_for_each_entry (
 			the_agent_apps_ht_by_sock->ht, &iter.iter, app, node.node) {
 			if (app->domain != domain) {
 				continue;
 			}
 
-			/* Enable event on agent application through TCP socket. */
-			ret = enable_event(app, event);
+			ret = send_enable_event(app, event);
 			if (ret != LTTNG_OK) {
-				goto error;
+				break;
+			}
+
+			sent_apps.push_back(app);
+		}
+
+		for (const auto *sent_app : sent_apps) {
+			const int reply_ret = recv_enable_event_reply(sent_app);
+
+			if (ret == LTTNG_OK) {
+				ret = reply_ret;
 			}
 		}
+
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
 	}
 
 	event->enabled_count++;
@@ -1516,6 +1560,28 @@ void agent_app_ht_clean()
 	lttng_ht_destroy(the_agent_apps_ht_by_sock);
 }
 
+static void log_update_enable_event_error(const struct agent_app *app,
+					  const struct agent_event *event)
+{
+	DBG2("Agent update unable to enable event %s on app pid: %d sock %d",
+	     event->name,
+	     app->pid,
+	     app->sock->fd);
+}
+
+static void recv_update_enable_event_replies(const struct agent_app *app,
+					     const struct agent_event *const *sent_events,
+					     unsigned int sent_count)
+{
+	unsigned int i;
+
+	for (i = 0; i < sent_count; i++) {
+		if (recv_enable_event_reply(app) != LTTNG_OK) {
+			log_update_enable_event_error(app, sent_events[i]);
+		}
+	}
+}
+
 /*
  * Update a agent application (given socket) using the given agent.
  *
@@ -1540,6 +1606,9 @@ void agent_update(const struct agent *agt, const struct agent_app *app)
 	 */
 	{
 		lttng::urcu::read_lock_guard read_lock;
+		/* Events whose enable command was sent, awaiting their reply. */
+		const struct agent_event *sent_events[AGENT_UPDATE_MAX_PENDING_REPLIES];
+		unsigned int sent_count = 0;
 
 		cds_lfht_for_each_entry (agt->events->ht, &iter.iter, event, node.node) {
 			/* Skip event if disabled. */
@@ -1547,17 +1616,22 @@ void agent_update(const struct agent *agt, const struct agent_app *app)
 				continue;
 			}
 
-			ret = enable_event(app, event);
-			if (ret != LTTNG_OK) {
-				DBG2("Agent update unable to enable event %s on app pid: %d sock %d",
-				     event->name,
-				     app->pid,
-				     app->sock->fd);
-				/* Let's try the others here and don't assume the app is dead. */
-				continue;
+			ret = send_enable_event(app, event);
+			if (ret == LTTNG_OK) {
+				sent_events[sent_count++] = event;
+			} else {
+				log_update_enable_event_error(app, event);
+			}
+
+			/* Let's try the others here and don't assume the app is dead. */
+			if (sent_count == AGENT_UPDATE_MAX_PENDING_REPLIES) {
+				recv_update_enable_event_replies(app, sent_events, sent_count);
+				sent_count = 0;
 			}
 		}
 
+		recv_update_enable_event_replies(app, sent_events, sent_count);
+
 		cds_list_for_each_entry_rcu(ctx, &agt->app_ctx_list, list_node)
 		{
 			ret = app_context_op(app, ctx, AGENT_CMD_APP_CTX_ENABLE);
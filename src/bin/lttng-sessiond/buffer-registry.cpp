@@ -33,6 +33,22 @@ static struct lttng_ht *buffer_registry_uid;
  */
 static struct lttng_ht *buffer_registry_pid;
 
+/*
+ * Per PID buffer registry objects of exited applications, along with their
+ * session registry and its channel hash table, reused by the applications
+ * which register next rather than allocated again. Short-lived applications
+ * would otherwise allocate and destroy them at each of their executions.
+ *
+ * Objects are returned to the pool once their grace period has elapsed. The
+ * pool is closed when the registries are destroyed.
+ */
+static struct {
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct cds_list_head objects = CDS_LIST_HEAD_INIT(objects);
+	unsigned int count = 0;
+	bool closed = false;
+} buffer_reg_pid_pool;
+
 /*
  * Match function for the per UID registry hash table. It matches a registry
  * uid object with the triplet <session_id/abi/uid>.
@@ -229,7 +245,57 @@ void buffer_reg_init_pid_registry()
 }
 
 /*
- * Allocate and initialize object. Set regp with the object pointer.
+ * Take a per PID buffer registry object out of the pool. Its session registry
+ * has no domain registry and no channel.
+ *
+ * Return the object or NULL if the pool is empty.
+ */
+static struct buffer_reg_pid *buffer_reg_pid_pool_get()
+{
+	struct buffer_reg_pid *reg = nullptr;
+
+	pthread_mutex_lock(&buffer_reg_pid_pool.lock);
+	if (!cds_list_empty(&buffer_reg_pid_pool.objects)) {
+		reg = cds_list_first_entry(
+			&buffer_reg_pid_pool.objects, struct buffer_reg_pid, pool_node);
+		cds_list_del(&reg->pool_node);
+		buffer_reg_pid_pool.count--;
+	}
+	pthread_mutex_unlock(&buffer_reg_pid_pool.lock);
+
+	if (reg) {
+		reg->root_shm_path[0] = '\0';
+		reg->shm_path[0] = '\0';
+	}
+
+	return reg;
+}
+
+/*
+ * Return a per PID buffer registry object, which no reader can reference
+ * anymore, to the pool.
+ *
+ * Return true on success, false if the pool is closed or full.
+ */
+static bool buffer_reg_pid_pool_put(struct buffer_reg_pid *reg)
+{
+	bool pooled = false;
+
+	pthread_mutex_lock(&buffer_reg_pid_pool.lock);
+	if (!buffer_reg_pid_pool.closed &&
+	    buffer_reg_pid_pool.count < DEFAULT_BUFFER_REG_PID_POOL_SIZE) {
+		cds_list_add(&reg->pool_node, &buffer_reg_pid_pool.objects);
+		buffer_reg_pid_pool.count++;
+		pooled = true;
+	}
+	pthread_mutex_unlock(&buffer_reg_pid_pool.lock);
+
+	return pooled;
+}
+
+/*
+ * Allocate and initialize object, reusing an object of the pool if one is
+ * available. Set regp with the object pointer.
  *
  * Return 0 on success else a negative value and regp is untouched.
  */
@@ -243,6 +309,11 @@ int buffer_reg_pid_create(uint64_t session_id,
 
 	LTTNG_ASSERT(regp);
 
+	reg = buffer_reg_pid_pool_get();
+	if (reg) {
+		goto init;
+	}
+
 	reg = zmalloc<buffer_reg_pid>();
 	if (!reg) {
 		PERROR("zmalloc buffer registry pid");
@@ -257,6 +328,13 @@ int buffer_reg_pid_create(uint64_t session_id,
 		goto error;
 	}
 
+	reg->registry->channels = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
+	if (!reg->registry->channels) {
+		ret = -ENOMEM;
+		goto error_session;
+	}
+
+init:
 	/* A cast is done here so we can use the session ID as a u64 ht node. */
 	reg->session_id = session_id;
 	if (shm_path[0]) {
@@ -268,11 +346,6 @@ int buffer_reg_pid_create(uint64_t session_id,
 		     reg->shm_path,
 		     session_id);
 	}
-	reg->registry->channels = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
-	if (!reg->registry->channels) {
-		ret = -ENOMEM;
-		goto error_session;
-	}
 
 	lttng_ht_node_init_u64(&reg->node, reg->session_id);
 	*regp = reg;
@@ -578,17 +651,16 @@ void buffer_reg_channel_destroy(struct buffer_reg_channel *regp, enum lttng_doma
 }
 
 /*
- * Destroy a buffer registry session with the given domain.
+ * Destroy the channels and the domain registry of a buffer registry session,
+ * keeping its channel hash table.
  */
-static void buffer_reg_session_destroy(struct buffer_reg_session *regp,
-				       enum lttng_domain_type domain)
+static void buffer_reg_session_clear(struct buffer_reg_session *regp,
+				     enum lttng_domain_type domain)
 {
 	int ret;
 	struct lttng_ht_iter iter;
 	struct buffer_reg_channel *reg_chan;
 
-	DBG3("Buffer registry session destroy");
-
 	/* Destroy all channels. */
 	{
 		lttng::urcu::read_lock_guard read_lock;
@@ -600,18 +672,27 @@ static void buffer_reg_session_destroy(struct buffer_reg_session *regp,
 		}
 	}
 
-	lttng_ht_destroy(regp->channels);
-
 	switch (domain) {
 	case LTTNG_DOMAIN_UST:
 		ust_registry_session_destroy(regp->reg.ust);
+		regp->reg.ust = nullptr;
 		break;
 	default:
 		abort();
 	}
+}
+
+/*
+ * Destroy a buffer registry session with the given domain.
+ */
+static void buffer_reg_session_destroy(struct buffer_reg_session *regp,
+				       enum lttng_domain_type domain)
+{
+	DBG3("Buffer registry session destroy");
 
+	buffer_reg_session_clear(regp, domain);
+	lttng_ht_destroy(regp->channels);
 	free(regp);
-	return;
 }
 
 /*
@@ -644,7 +725,13 @@ static void rcu_free_buffer_reg_pid(struct rcu_head *head)
 	struct lttng_ht_node_u64 *node = lttng::utils::container_of(head, &lttng_ht_node_u64::head);
 	struct buffer_reg_pid *reg = lttng::utils::container_of(node, &buffer_reg_pid::node);
 
-	buffer_reg_session_destroy(reg->registry, LTTNG_DOMAIN_UST);
+	buffer_reg_session_clear(reg->registry, LTTNG_DOMAIN_UST);
+	if (buffer_reg_pid_pool_put(reg)) {
+		return;
+	}
+
+	lttng_ht_destroy(reg->registry->channels);
+	free(reg->registry);
 	free(reg);
 }
 
@@ -734,7 +821,19 @@ void buffer_reg_pid_destroy(struct buffer_reg_pid *regp)
  */
 void buffer_reg_destroy_registries()
 {
+	struct buffer_reg_pid *reg, *tmp;
+
 	DBG3("Buffer registry destroy all registry");
 	lttng_ht_destroy(buffer_registry_uid);
 	lttng_ht_destroy(buffer_registry_pid);
+
+	pthread_mutex_lock(&buffer_reg_pid_pool.lock);
+	buffer_reg_pid_pool.closed = true;
+	cds_list_for_each_entry_safe (reg, tmp, &buffer_reg_pid_pool.objects, pool_node) {
+		cds_list_del(&reg->pool_node);
+		buffer_reg_session_destroy(reg->registry, LTTNG_DOMAIN_UST);
+		free(reg);
+	}
+	buffer_reg_pid_pool.count = 0;
+	pthread_mutex_unlock(&buffer_reg_pid_pool.lock);
 }
@@ -95,6 +95,8 @@ struct buffer_reg_pid {
 
 	/* Indexed by session id. */
 	struct lttng_ht_node_u64 node;
+	/* Node of the pool of objects kept for reuse once destroyed. */
+	struct cds_list_head pool_node;
 
 	char root_shm_path[PATH_MAX];
 	char shm_path[PATH_MAX];
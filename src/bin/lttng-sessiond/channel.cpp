@@ -205,6 +205,12 @@ static int channel_validate_kernel(struct lttng_channel *attr)
 	if (((struct lttng_channel_extended *) attr->attr.extended.ptr)->blocking_timeout) {
 		return -1;
 	}
+
+	/* The ring buffers of the kernel tracer are allocated by the kernel tracer. */
+	if (((struct lttng_channel_extended *) attr->attr.extended.ptr)->buffer_page_size !=
+	    LTTNG_CHANNEL_BUFFER_PAGE_SIZE_BASE) {
+		return -1;
+	}
 	return 0;
 }
 
@@ -393,6 +399,34 @@ enum lttng_error_code channel_ust_create(struct ltt_ust_session *usess,
 		goto error;
 	}
 
+	switch (((struct lttng_channel_extended *) attr->attr.extended.ptr)->buffer_page_size) {
+	case LTTNG_CHANNEL_BUFFER_PAGE_SIZE_BASE:
+		break;
+	case LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE:
+		if (the_huge_page_size < 0) {
+			ret_code = LTTNG_ERR_HUGE_PAGES_UNAVAILABLE;
+			goto error;
+		}
+
+		/*
+		 * Both sizes are powers of 2: the sub-buffers then span whole
+		 * huge pages.
+		 */
+		if (attr->attr.subbuf_size < (uint64_t) the_huge_page_size) {
+			ERR("Sub-buffer size of channel `%s` is smaller than the transparent huge page size: subbuf_size = %" PRIu64
+			    ", huge_page_size = %ld",
+			    attr->name,
+			    attr->attr.subbuf_size,
+			    the_huge_page_size);
+			ret_code = LTTNG_ERR_INVALID;
+			goto error;
+		}
+		break;
+	default:
+		ret_code = LTTNG_ERR_INVALID;
+		goto error;
+	}
+
 	if (attr->attr.output != LTTNG_EVENT_MMAP) {
 		ret_code = LTTNG_ERR_NOT_SUPPORTED;
 		goto error;
@@ -452,6 +486,7 @@ enum lttng_error_code channel_ust_create(struct ltt_ust_session *usess,
 	/* Adding the channel to the channel hash table. */
 	if (strncmp(uchan->name, DEFAULT_METADATA_NAME, sizeof(uchan->name)) != 0) {
 		lttng_ht_add_unique_str(usess->domain_global.channels, &uchan->node);
+		trace_ust_invalidate_setup_plan(usess);
 		chan_published = true;
 	} else {
 		/*
@@ -482,6 +517,7 @@ enum lttng_error_code channel_ust_create(struct ltt_ust_session *usess,
 error_remove_chan:
 	if (chan_published) {
 		trace_ust_delete_channel(usess->domain_global.channels, uchan);
+		trace_ust_invalidate_setup_plan(usess);
 	}
 error_free_chan:
 	trace_ust_destroy_channel(uchan);
@@ -536,6 +572,7 @@ error:
 struct lttng_channel *trace_ust_channel_to_lttng_channel(const struct ltt_ust_channel *uchan)
 {
 	struct lttng_channel *channel = nullptr, *ret = nullptr;
+	struct lttng_channel_extended *extended;
 
 	channel = lttng_channel_create_internal();
 	if (!channel) {
@@ -575,6 +612,17 @@ struct lttng_channel *trace_ust_channel_to_lttng_channel(const struct ltt_ust_ch
 
 	lttng_channel_set_blocking_timeout(channel, uchan->attr.u.s.blocking_timeout);
 	lttng_channel_set_monitor_timer_interval(channel, uchan->monitor_timer_interval);
+	lttng_channel_set_writeback_policy(
+		channel, uchan->writeback_policy, uchan->writeback_window_size);
+	lttng_channel_set_drain_batch(
+		channel, uchan->drain_max_subbuffers ?: 1, uchan->drain_max_bytes);
+	lttng_channel_set_buffer_page_size(channel, uchan->buffer_page_size);
+	extended = (struct lttng_channel_extended *) channel->attr.extended.ptr;
+	if (uchan->buffer_page_size == LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE) {
+		extended->effective_buffer_page_size = the_huge_page_size;
+	} else {
+		extended->effective_buffer_page_size = the_page_size;
+	}
 
 	ret = channel;
 	channel = nullptr;
@@ -9,11 +9,15 @@
 #include "clear.hpp"
 #include "cmd.hpp"
 #include "kernel.hpp"
+#include "lttng-sessiond.hpp"
 #include "session.hpp"
+#include "trace-kernel.hpp"
+#include "trace-ust.hpp"
 #include "ust-app.hpp"
 
 #include <common/defaults.hpp>
 #include <common/error.hpp>
+#include <common/urcu.hpp>
 #include <common/utils.hpp>
 
 #include <inttypes.h>
@@ -24,6 +28,52 @@ namespace {
 struct cmd_clear_session_reply_context {
 	int reply_sock_fd;
 };
+
+/*
+ * A session can be cleared by truncating the files of its current trace
+ * chunk in place when it writes its trace locally, none of its channels
+ * spreads the data of its streams over several trace files and its UST
+ * buffers, if any, are per UID. The files of the per PID buffers of the
+ * applications which exited have no stream left to truncate them.
+ */
+bool session_can_be_cleared_in_place(const struct ltt_session *session)
+{
+	if (!the_config.fast_clear || !session->output_traces ||
+	    session->consumer->type != CONSUMER_DST_LOCAL) {
+		return false;
+	}
+
+	if (session->kernel_session) {
+		const struct ltt_kernel_channel *chan;
+
+		cds_list_for_each_entry (chan, &session->kernel_session->channel_list.head, list) {
+			if (chan->channel->attr.tracefile_size) {
+				return false;
+			}
+		}
+	}
+
+	if (session->ust_session) {
+		struct lttng_ht_iter iter;
+		const struct ltt_ust_channel *uchan;
+		const lttng::urcu::read_lock_guard read_lock;
+
+		if (session->ust_session->buffer_type != LTTNG_BUFFER_PER_UID) {
+			return false;
+		}
+
+		cds_lfht_for_each_entry (session->ust_session->domain_global.channels->ht,
+					 &iter.iter,
+					 uchan,
+					 node.node) {
+			if (uchan->tracefile_size) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
 } /* namespace */
 
 static void cmd_clear_session_reply(const struct ltt_session *session, void *_reply_context)
@@ -58,6 +108,7 @@ int cmd_clear_session(struct ltt_session *session, int *sock_fd)
 	int ret = LTTNG_OK;
 	struct cmd_clear_session_reply_context *reply_context = nullptr;
 	bool session_was_active = false;
+	bool clear_in_place;
 	struct ltt_kernel_session *ksession;
 	struct ltt_ust_session *usess;
 
@@ -112,6 +163,11 @@ int cmd_clear_session(struct ltt_session *session, int *sock_fd)
 		goto end;
 	}
 
+	clear_in_place = session_can_be_cleared_in_place(session);
+	DBG("Clearing session \"%s\"%s",
+	    session->name,
+	    clear_in_place ? " by truncating its files in place" : "");
+
 	session_was_active = session->active;
 	if (session_was_active) {
 		ret = stop_kernel_session(ksession);
@@ -120,6 +176,7 @@ int cmd_clear_session(struct ltt_session *session, int *sock_fd)
 		}
 		if (usess && usess->active) {
 			ret = ust_app_stop_trace_all(usess);
+			session_update_ust_active_index(session);
 			if (ret < 0) {
 				ret = LTTNG_ERR_UST_STOP_FAIL;
 				goto end;
@@ -131,19 +188,19 @@ int cmd_clear_session(struct ltt_session *session, int *sock_fd)
 	 * Clear active kernel and UST session buffers.
 	 */
 	if (session->kernel_session) {
-		ret = kernel_clear_session(session);
+		ret = kernel_clear_session(session, clear_in_place);
 		if (ret != LTTNG_OK) {
 			goto end;
 		}
 	}
 	if (session->ust_session) {
-		ret = ust_app_clear_session(session);
+		ret = ust_app_clear_session(session, clear_in_place);
 		if (ret != LTTNG_OK) {
 			goto end;
 		}
 	}
 
-	if (session->output_traces) {
+	if (session->output_traces && !clear_in_place) {
 		/*
 		 * Use rotation to delete local and remote stream files.
 		 */
@@ -184,6 +241,7 @@ int cmd_clear_session(struct ltt_session *session, int *sock_fd)
 		if (usess) {
 			int int_ret = ust_app_start_trace_all(usess);
 
+			session_update_ust_active_index(session);
 			if (int_ret < 0) {
 				ret = LTTNG_ERR_UST_START_FAIL;
 				goto end;
@@ -27,6 +27,7 @@
 #include "manage-consumer.hpp"
 #include "save.hpp"
 #include "testpoint.hpp"
+#include "trigger-store.hpp"
 #include "utils.hpp"
 
 #include <common/compat/getenv.hpp>
@@ -57,6 +58,37 @@ struct thread_state {
 	bool running;
 	int client_sock;
 } thread_state;
+
+/* Connection of a client, handed by the client thread to the command workers. */
+struct client_connection {
+	int sock;
+	/* Set once the client asked to keep the connection open across its commands. */
+	bool persistent;
+	struct cds_list_head node;
+};
+
+/*
+ * Command workers: receive and process the commands of the connections which
+ * the client thread accepts, so that a slow command only delays the commands
+ * which can't run concurrently with it.
+ */
+struct client_workers {
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+	/* struct client_connection, oldest first. */
+	struct cds_list_head connections = CDS_LIST_HEAD_INIT(connections);
+	/* Persistent struct client_connection to poll again for their next command. */
+	struct cds_list_head idle_connections = CDS_LIST_HEAD_INIT(idle_connections);
+	/* Wakes the client thread up when a connection becomes idle. */
+	struct lttng_pipe *idle_pipe = nullptr;
+	bool exit = false;
+	/* Threads of the workers, shut down by the client thread. */
+	struct lttng_thread **threads = nullptr;
+	unsigned int count = 0;
+} client_workers;
+
+/* Serializes the commands which can't run concurrently, see command_is_concurrent(). */
+pthread_mutex_t serialized_command_lock = PTHREAD_MUTEX_INITIALIZER;
 } /* namespace */
 
 static void set_thread_status(bool running)
@@ -610,61 +642,75 @@ static unsigned int lttng_sessions_count(uid_t uid, gid_t gid __attribute__((unu
 	return i;
 }
 
-static enum lttng_error_code receive_lttng_trigger(struct command_ctx *cmd_ctx,
-						   int sock,
-						   int *sock_error,
-						   struct lttng_trigger **_trigger)
+/*
+ * Receive the serialized trigger, or set of triggers, and file descriptors of
+ * a trigger registration command.
+ */
+static enum lttng_error_code receive_trigger_payload(struct command_ctx *cmd_ctx,
+						     int sock,
+						     int *sock_error,
+						     struct lttng_payload *trigger_payload)
 {
 	int ret;
-	size_t trigger_len;
+	const size_t trigger_len = (size_t) cmd_ctx->lsm.u.trigger.length;
 	ssize_t sock_recv_len;
-	enum lttng_error_code ret_code;
-	struct lttng_payload trigger_payload;
-	struct lttng_trigger *trigger = nullptr;
 
-	lttng_payload_init(&trigger_payload);
-	trigger_len = (size_t) cmd_ctx->lsm.u.trigger.length;
-	ret = lttng_dynamic_buffer_set_size(&trigger_payload.buffer, trigger_len);
+	ret = lttng_dynamic_buffer_set_size(&trigger_payload->buffer, trigger_len);
 	if (ret) {
-		ret_code = LTTNG_ERR_NOMEM;
-		goto end;
+		return LTTNG_ERR_NOMEM;
 	}
 
-	sock_recv_len = lttcomm_recv_unix_sock(sock, trigger_payload.buffer.data, trigger_len);
+	sock_recv_len = lttcomm_recv_unix_sock(sock, trigger_payload->buffer.data, trigger_len);
 	if (sock_recv_len < 0 || sock_recv_len != trigger_len) {
 		ERR("Failed to receive trigger in command payload");
 		*sock_error = 1;
-		ret_code = LTTNG_ERR_INVALID_PROTOCOL;
-		goto end;
+		return LTTNG_ERR_INVALID_PROTOCOL;
 	}
 
 	/* Receive fds, if any. */
 	if (cmd_ctx->lsm.fd_count > 0) {
 		sock_recv_len = lttcomm_recv_payload_fds_unix_sock(
-			sock, cmd_ctx->lsm.fd_count, &trigger_payload);
+			sock, cmd_ctx->lsm.fd_count, trigger_payload);
 		if (sock_recv_len > 0 && sock_recv_len != cmd_ctx->lsm.fd_count * sizeof(int)) {
 			ERR("Failed to receive all file descriptors for trigger in command payload: expected fd count = %u, ret = %d",
 			    cmd_ctx->lsm.fd_count,
 			    (int) ret);
-			ret_code = LTTNG_ERR_INVALID_PROTOCOL;
 			*sock_error = 1;
-			goto end;
+			return LTTNG_ERR_INVALID_PROTOCOL;
 		} else if (sock_recv_len <= 0) {
 			ERR("Failed to receive file descriptors for trigger in command payload: expected fd count = %u, ret = %d",
 			    cmd_ctx->lsm.fd_count,
 			    (int) ret);
-			ret_code = LTTNG_ERR_FATAL;
 			*sock_error = 1;
-			goto end;
+			return LTTNG_ERR_FATAL;
 		}
 	}
 
+	return LTTNG_OK;
+}
+
+static enum lttng_error_code receive_lttng_trigger(struct command_ctx *cmd_ctx,
+						   int sock,
+						   int *sock_error,
+						   struct lttng_trigger **_trigger)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_payload trigger_payload;
+	struct lttng_trigger *trigger = nullptr;
+
+	lttng_payload_init(&trigger_payload);
+	ret_code = receive_trigger_payload(cmd_ctx, sock, sock_error, &trigger_payload);
+	if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
 	/* Deserialize trigger. */
 	{
 		struct lttng_payload_view view =
 			lttng_payload_view_from_payload(&trigger_payload, 0, -1);
 
-		if (lttng_trigger_create_from_payload(&view, &trigger) != trigger_len) {
+		if (lttng_trigger_create_from_payload(&view, &trigger) !=
+		    trigger_payload.buffer.size) {
 			ERR("Invalid trigger received as part of command payload");
 			ret_code = LTTNG_ERR_INVALID_TRIGGER;
 			lttng_trigger_put(trigger);
@@ -680,61 +726,112 @@ end:
 	return ret_code;
 }
 
-static enum lttng_error_code receive_lttng_error_query(struct command_ctx *cmd_ctx,
-						       int sock,
-						       int *sock_error,
-						       struct lttng_error_query **_query)
+static enum lttng_error_code receive_lttng_triggers(struct command_ctx *cmd_ctx,
+						    int sock,
+						    int *sock_error,
+						    struct lttng_triggers **_triggers)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_payload triggers_payload;
+	struct lttng_triggers *triggers = nullptr;
+
+	lttng_payload_init(&triggers_payload);
+	ret_code = receive_trigger_payload(cmd_ctx, sock, sock_error, &triggers_payload);
+	if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
+	/* Deserialize the set of triggers. */
+	{
+		struct lttng_payload_view view =
+			lttng_payload_view_from_payload(&triggers_payload, 0, -1);
+
+		if (lttng_triggers_create_from_payload(&view, &triggers) !=
+		    triggers_payload.buffer.size) {
+			ERR("Invalid set of triggers received as part of command payload");
+			ret_code = LTTNG_ERR_INVALID_TRIGGER;
+			lttng_triggers_destroy(triggers);
+			goto end;
+		}
+	}
+
+	*_triggers = triggers;
+	ret_code = LTTNG_OK;
+
+end:
+	lttng_payload_reset(&triggers_payload);
+	return ret_code;
+}
+
+/*
+ * Receive the serialized error query, or error queries, and file descriptors
+ * of an error query command.
+ */
+static enum lttng_error_code receive_error_query_payload(struct command_ctx *cmd_ctx,
+							 int sock,
+							 int *sock_error,
+							 struct lttng_payload *query_payload)
 {
 	int ret;
-	size_t query_len;
+	const size_t query_len = (size_t) cmd_ctx->lsm.u.error_query.length;
 	ssize_t sock_recv_len;
-	enum lttng_error_code ret_code;
-	struct lttng_payload query_payload;
-	struct lttng_error_query *query = nullptr;
 
-	lttng_payload_init(&query_payload);
-	query_len = (size_t) cmd_ctx->lsm.u.error_query.length;
-	ret = lttng_dynamic_buffer_set_size(&query_payload.buffer, query_len);
+	ret = lttng_dynamic_buffer_set_size(&query_payload->buffer, query_len);
 	if (ret) {
-		ret_code = LTTNG_ERR_NOMEM;
-		goto end;
+		return LTTNG_ERR_NOMEM;
 	}
 
-	sock_recv_len = lttcomm_recv_unix_sock(sock, query_payload.buffer.data, query_len);
+	sock_recv_len = lttcomm_recv_unix_sock(sock, query_payload->buffer.data, query_len);
 	if (sock_recv_len < 0 || sock_recv_len != query_len) {
 		ERR("Failed to receive error query in command payload");
 		*sock_error = 1;
-		ret_code = LTTNG_ERR_INVALID_PROTOCOL;
-		goto end;
+		return LTTNG_ERR_INVALID_PROTOCOL;
 	}
 
 	/* Receive fds, if any. */
 	if (cmd_ctx->lsm.fd_count > 0) {
 		sock_recv_len = lttcomm_recv_payload_fds_unix_sock(
-			sock, cmd_ctx->lsm.fd_count, &query_payload);
+			sock, cmd_ctx->lsm.fd_count, query_payload);
 		if (sock_recv_len > 0 && sock_recv_len != cmd_ctx->lsm.fd_count * sizeof(int)) {
 			ERR("Failed to receive all file descriptors for error query in command payload: expected fd count = %u, ret = %d",
 			    cmd_ctx->lsm.fd_count,
 			    (int) ret);
-			ret_code = LTTNG_ERR_INVALID_PROTOCOL;
 			*sock_error = 1;
-			goto end;
+			return LTTNG_ERR_INVALID_PROTOCOL;
 		} else if (sock_recv_len <= 0) {
 			ERR("Failed to receive file descriptors for error query in command payload: expected fd count = %u, ret = %d",
 			    cmd_ctx->lsm.fd_count,
 			    (int) ret);
-			ret_code = LTTNG_ERR_FATAL;
 			*sock_error = 1;
-			goto end;
+			return LTTNG_ERR_FATAL;
 		}
 	}
 
+	return LTTNG_OK;
+}
+
+static enum lttng_error_code receive_lttng_error_query(struct command_ctx *cmd_ctx,
+						       int sock,
+						       int *sock_error,
+						       struct lttng_error_query **_query)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_payload query_payload;
+	struct lttng_error_query *query = nullptr;
+
+	lttng_payload_init(&query_payload);
+	ret_code = receive_error_query_payload(cmd_ctx, sock, sock_error, &query_payload);
+	if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
 	/* Deserialize error query. */
 	{
 		struct lttng_payload_view view =
 			lttng_payload_view_from_payload(&query_payload, 0, -1);
 
-		if (lttng_error_query_create_from_payload(&view, &query) != query_len) {
+		if (lttng_error_query_create_from_payload(&view, &query) !=
+		    query_payload.buffer.size) {
 			ERR("Invalid error query received as part of command payload");
 			ret_code = LTTNG_ERR_INVALID_PROTOCOL;
 			goto end;
@@ -749,6 +846,64 @@ end:
 	return ret_code;
 }
 
+/*
+ * Receive the `lsm.u.error_query.count` error queries of an "execute error
+ * queries" command into `queries`, an array of as many elements.
+ */
+static enum lttng_error_code receive_lttng_error_queries(struct command_ctx *cmd_ctx,
+							 int sock,
+							 int *sock_error,
+							 struct lttng_error_query **queries)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_payload query_payload;
+	const unsigned int count = cmd_ctx->lsm.u.error_query.count;
+	unsigned int i = 0;
+	size_t offset = 0;
+
+	lttng_payload_init(&query_payload);
+	ret_code = receive_error_query_payload(cmd_ctx, sock, sock_error, &query_payload);
+	if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
+	/* Deserialize the error queries, one after the other. */
+	{
+		struct lttng_payload_view view =
+			lttng_payload_view_from_payload(&query_payload, 0, -1);
+
+		for (i = 0; i < count; i++) {
+			struct lttng_payload_view query_view =
+				lttng_payload_view_from_view(&view, offset, -1);
+			const ssize_t query_size =
+				lttng_error_query_create_from_payload(&query_view, &queries[i]);
+
+			if (query_size < 0) {
+				ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+				break;
+			}
+
+			offset += query_size;
+		}
+	}
+
+	if (ret_code == LTTNG_OK && offset != query_payload.buffer.size) {
+		ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+	}
+
+	if (ret_code != LTTNG_OK) {
+		ERR("Invalid error queries received as part of command payload");
+		while (i-- > 0) {
+			lttng_error_query_destroy(queries[i]);
+			queries[i] = nullptr;
+		}
+	}
+
+end:
+	lttng_payload_reset(&query_payload);
+	return ret_code;
+}
+
 static enum lttng_error_code receive_lttng_event(struct command_ctx *cmd_ctx,
 						 int sock,
 						 int *sock_error,
@@ -990,6 +1145,53 @@ end:
  * A command may assume the ownership of the socket, in which case its value
  * should be set to -1.
  */
+/*
+ * Return true if listing the instrumentation points of a domain requires the
+ * session list lock, which serializes the communication with the agent
+ * applications.
+ */
+static bool list_needs_session_list_lock(enum lttng_domain_type domain)
+{
+	return domain != LTTNG_DOMAIN_KERNEL && domain != LTTNG_DOMAIN_UST;
+}
+
+/*
+ * Return true if a command can be processed concurrently with the other
+ * commands.
+ *
+ * The commands of the tracing sessions hold the session list lock during
+ * their whole processing, which the session and tracer code relies on, and
+ * the kernel tracer, the consumer daemons and the agent applications are set
+ * up or used by the commands without further synchronization. Only listing
+ * the instrumentation points of the user space applications or of an
+ * initialized kernel tracer, and listing the triggers, which the
+ * notification thread serves, run concurrently with the other commands, as
+ * does the request to keep a connection open.
+ */
+static bool command_is_concurrent(const struct lttcomm_session_msg *lsm)
+{
+	switch (lsm->cmd_type) {
+	case LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS:
+	case LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION:
+		return true;
+	case LTTCOMM_SESSIOND_COMMAND_LIST_TRACEPOINTS:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_TRACEPOINT_FIELDS:
+	case LTTCOMM_SESSIOND_COMMAND_LIST_SYSCALLS:
+		break;
+	default:
+		return false;
+	}
+
+	switch (lsm->domain.type) {
+	case LTTNG_DOMAIN_UST:
+		return true;
+	case LTTNG_DOMAIN_KERNEL:
+		return kernel_tracer_is_initialized();
+	default:
+		return false;
+	}
+}
+
 static int process_client_msg(struct command_ctx *cmd_ctx, int *sock, int *sock_error)
 {
 	int ret = LTTNG_OK;
@@ -1033,6 +1235,9 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock, int *sock_
 	case LTTCOMM_SESSIOND_COMMAND_CLEAR_SESSION:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
+	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES:
+	case LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION:
+	case LTTCOMM_SESSIOND_COMMAND_DESCRIBE_SESSION:
 		need_domain = false;
 		break;
 	default:
@@ -1042,8 +1247,11 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock, int *sock_
 	/* Needs a functioning consumerd? */
 	switch (cmd_ctx->lsm.cmd_type) {
 	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGER:
+	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_UNREGISTER_TRIGGER:
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
+	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES:
+	case LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION:
 		need_consumerd = false;
 		break;
 	default:
@@ -1084,6 +1292,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock, int *sock_
 	case LTTCOMM_SESSIOND_COMMAND_LIST_DOMAINS:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_CHANNELS:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_EVENTS:
+	case LTTCOMM_SESSIOND_COMMAND_DESCRIBE_SESSION:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_SYSCALLS:
 	case LTTCOMM_SESSIOND_COMMAND_SESSION_LIST_ROTATION_SCHEDULES:
 	case LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_GET_POLICY:
@@ -1092,8 +1301,10 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock, int *sock_
 	case LTTCOMM_SESSIOND_COMMAND_ROTATE_SESSION:
 	case LTTCOMM_SESSIOND_COMMAND_ROTATION_GET_INFO:
 	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGER:
+	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
+	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES:
 		break;
 	default:
 		/* Setup lttng message with no payload */
@@ -1113,9 +1324,12 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock, int *sock_
 	case LTTCOMM_SESSIOND_COMMAND_LIST_TRACEPOINT_FIELDS:
 	case LTTCOMM_SESSIOND_COMMAND_SAVE_SESSION:
 	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGER:
+	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_UNREGISTER_TRIGGER:
 	case LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS:
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
+	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES:
+	case LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION:
 		need_tracing_session = false;
 		break;
 	default:
@@ -1523,6 +1737,104 @@ skip_domain:
 		lttng_dynamic_buffer_reset(&payload);
 		break;
 	}
+	case LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_ADD_INCLUDE_VALUES:
+	case LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_REMOVE_INCLUDE_VALUES:
+	{
+		struct lttng_dynamic_buffer payload;
+		struct lttng_process_attr_values *values;
+		const bool add_values = cmd_ctx->lsm.cmd_type ==
+			LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_ADD_INCLUDE_VALUES;
+		const uint32_t count =
+			cmd_ctx->lsm.u.process_attr_tracker_add_remove_include_values.count;
+		const size_t payload_len = count * sizeof(struct process_attr_integral_value_comm);
+		const enum lttng_domain_type domain_type =
+			(enum lttng_domain_type) cmd_ctx->lsm.domain.type;
+		const enum lttng_process_attr process_attr =
+			(enum lttng_process_attr) cmd_ctx->lsm.u
+				.process_attr_tracker_add_remove_include_values.process_attr;
+		const enum lttng_process_attr_value_type value_type =
+			(enum lttng_process_attr_value_type) cmd_ctx->lsm.u
+				.process_attr_tracker_add_remove_include_values.value_type;
+
+		if (count == 0 || count > LTTCOMM_PROCESS_ATTR_TRACKER_MAX_BULK_VALUES) {
+			ERR("Rejecting process attribute tracker values %s with an invalid count of values: count = %" PRIu32
+			    ", maximal count = %u",
+			    add_values ? "addition" : "removal",
+			    count,
+			    LTTCOMM_PROCESS_ATTR_TRACKER_MAX_BULK_VALUES);
+			ret = LTTNG_ERR_INVALID;
+			goto error;
+		}
+
+		values = lttng_process_attr_values_create();
+		if (!values) {
+			ret = LTTNG_ERR_NOMEM;
+			goto error;
+		}
+
+		lttng_dynamic_buffer_init(&payload);
+		ret = lttng_dynamic_buffer_set_size(&payload, payload_len);
+		if (ret) {
+			ERR("Failed to allocate buffer to receive payload of %s process attribute tracker values argument",
+			    add_values ? "add" : "remove");
+			ret = LTTNG_ERR_NOMEM;
+			goto error_add_remove_tracker_values;
+		}
+
+		ret = lttcomm_recv_unix_sock(*sock, payload.data, payload_len);
+		if (ret <= 0) {
+			ERR("Failed to receive payload of %s process attribute tracker values argument",
+			    add_values ? "add" : "remove");
+			*sock_error = 1;
+			ret = LTTNG_ERR_INVALID_PROTOCOL;
+			goto error_add_remove_tracker_values;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			struct process_attr_integral_value_comm integral_value;
+			struct process_attr_value *value;
+			enum lttng_error_code ret_code;
+
+			memcpy(&integral_value,
+			       payload.data + i * sizeof(integral_value),
+			       sizeof(integral_value));
+
+			/*
+			 * Validate the value type and domains like for a single
+			 * value; name value types are refused since no payload
+			 * is provided for them.
+			 */
+			ret_code = process_attr_value_from_comm(domain_type,
+								process_attr,
+								value_type,
+								&integral_value,
+								nullptr,
+								&value);
+			if (ret_code != LTTNG_OK) {
+				ret = ret_code;
+				goto error_add_remove_tracker_values;
+			}
+
+			ret = lttng_dynamic_pointer_array_add_pointer(&values->array, value);
+			if (ret) {
+				process_attr_value_destroy(value);
+				ret = LTTNG_ERR_NOMEM;
+				goto error_add_remove_tracker_values;
+			}
+		}
+
+		if (add_values) {
+			ret = cmd_process_attr_tracker_inclusion_set_add_values(
+				cmd_ctx->session, domain_type, process_attr, values);
+		} else {
+			ret = cmd_process_attr_tracker_inclusion_set_remove_values(
+				cmd_ctx->session, domain_type, process_attr, values);
+		}
+	error_add_remove_tracker_values:
+		lttng_process_attr_values_destroy(values);
+		lttng_dynamic_buffer_reset(&payload);
+		break;
+	}
 	case LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_GET_POLICY:
 	{
 		enum lttng_tracking_policy tracking_policy;
@@ -1650,9 +1962,13 @@ skip_domain:
 
 		original_payload_size = cmd_ctx->reply_payload.buffer.size;
 
-		session_lock_list();
+		if (list_needs_session_list_lock(cmd_ctx->lsm.domain.type)) {
+			session_lock_list();
+		}
 		ret_code = cmd_list_tracepoints(cmd_ctx->lsm.domain.type, &cmd_ctx->reply_payload);
-		session_unlock_list();
+		if (list_needs_session_list_lock(cmd_ctx->lsm.domain.type)) {
+			session_unlock_list();
+		}
 		if (ret_code != LTTNG_OK) {
 			ret = (int) ret_code;
 			goto error;
@@ -1680,10 +1996,14 @@ skip_domain:
 
 		original_payload_size = cmd_ctx->reply_payload.buffer.size;
 
-		session_lock_list();
+		if (list_needs_session_list_lock(cmd_ctx->lsm.domain.type)) {
+			session_lock_list();
+		}
 		ret_code = cmd_list_tracepoint_fields(cmd_ctx->lsm.domain.type,
 						      &cmd_ctx->reply_payload);
-		session_unlock_list();
+		if (list_needs_session_list_lock(cmd_ctx->lsm.domain.type)) {
+			session_unlock_list();
+		}
 		if (ret_code != LTTNG_OK) {
 			ret = (int) ret_code;
 			goto error;
@@ -1872,6 +2192,34 @@ skip_domain:
 		ret = LTTNG_OK;
 		break;
 	}
+	case LTTCOMM_SESSIOND_COMMAND_DESCRIBE_SESSION:
+	{
+		enum lttng_error_code ret_code;
+		size_t original_payload_size;
+		size_t payload_size;
+		const size_t command_header_size = sizeof(struct lttcomm_list_command_header);
+
+		ret = setup_empty_lttng_msg(cmd_ctx);
+		if (ret) {
+			ret = LTTNG_ERR_NOMEM;
+			goto setup_error;
+		}
+
+		original_payload_size = cmd_ctx->reply_payload.buffer.size;
+
+		ret_code = cmd_describe_session(cmd_ctx->session, &cmd_ctx->reply_payload);
+		if (ret_code != LTTNG_OK) {
+			ret = (int) ret_code;
+			goto error;
+		}
+
+		payload_size = cmd_ctx->reply_payload.buffer.size - command_header_size -
+			original_payload_size;
+		update_lttng_msg(cmd_ctx, command_header_size, payload_size);
+
+		ret = LTTNG_OK;
+		break;
+	}
 	case LTTCOMM_SESSIOND_COMMAND_LIST_SESSIONS:
 	{
 		unsigned int nr_sessions;
@@ -2021,9 +2369,29 @@ skip_domain:
 	case LTTCOMM_SESSIOND_COMMAND_SNAPSHOT_RECORD:
 	{
 		lttng_snapshot_output output = cmd_ctx->lsm.u.snapshot_record.output;
-		ret = cmd_snapshot_record(cmd_ctx->session, &output, 0); // RFC: set to zero since
-									 // it's ignored by
-									 // cmd_snapshot_record
+		int output_fd = -1;
+
+		/* A snapshot recorded to a file descriptor sends it along. */
+		if (cmd_ctx->lsm.fd_count > 1) {
+			ret = LTTNG_ERR_INVALID_PROTOCOL;
+			goto error;
+		} else if (cmd_ctx->lsm.fd_count == 1) {
+			const ssize_t sock_recv_len =
+				lttcomm_recv_fds_unix_sock(*sock, &output_fd, 1);
+
+			if (sock_recv_len != sizeof(output_fd)) {
+				ERR("Failed to receive snapshot output file descriptor");
+				*sock_error = 1;
+				ret = LTTNG_ERR_INVALID_PROTOCOL;
+				goto error;
+			}
+		}
+
+		// RFC: wait set to zero since it's ignored by cmd_snapshot_record
+		ret = cmd_snapshot_record(cmd_ctx->session, &output, 0, output_fd);
+		if (output_fd >= 0 && close(output_fd)) {
+			PERROR("Failed to close snapshot output file descriptor");
+		}
 		break;
 	}
 	case LTTCOMM_SESSIOND_COMMAND_CREATE_SESSION_EXT:
@@ -2110,6 +2478,8 @@ skip_domain:
 			goto error;
 		}
 
+		trigger_store_add(return_trigger);
+
 		ret = lttng_trigger_serialize(return_trigger, &cmd_ctx->reply_payload);
 		lttng_trigger_put(payload_trigger);
 		lttng_trigger_put(return_trigger);
@@ -2127,27 +2497,97 @@ skip_domain:
 		ret = LTTNG_OK;
 		break;
 	}
-	case LTTCOMM_SESSIOND_COMMAND_UNREGISTER_TRIGGER:
+	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGERS:
 	{
-		struct lttng_trigger *payload_trigger;
+		struct lttng_triggers *payload_triggers;
+		size_t original_reply_payload_size;
+		size_t reply_payload_size;
+		unsigned int i, count;
 		const struct lttng_credentials cmd_creds = {
 			.uid = LTTNG_OPTIONAL_INIT_VALUE(cmd_ctx->creds.uid),
 			.gid = LTTNG_OPTIONAL_INIT_VALUE(cmd_ctx->creds.gid),
 		};
 
-		ret = receive_lttng_trigger(cmd_ctx, *sock, sock_error, &payload_trigger);
+		ret = setup_empty_lttng_msg(cmd_ctx);
+		if (ret) {
+			ret = LTTNG_ERR_NOMEM;
+			goto setup_error;
+		}
+
+		ret = receive_lttng_triggers(cmd_ctx, *sock, sock_error, &payload_triggers);
 		if (ret != LTTNG_OK) {
 			goto error;
 		}
 
-		ret = cmd_unregister_trigger(
-			&cmd_creds, payload_trigger, the_notification_thread_handle);
-		lttng_trigger_put(payload_trigger);
-		break;
-	}
-	case LTTCOMM_SESSIOND_COMMAND_ROTATE_SESSION:
-	{
-		struct lttng_rotate_session_return rotate_return;
+		/* The domain of the command was checked for all the triggers. */
+		(void) lttng_triggers_get_count(payload_triggers, &count);
+		for (i = 0; i < count; i++) {
+			const struct lttng_trigger *trigger =
+				lttng_triggers_get_at_index(payload_triggers, i);
+
+			if (lttng_trigger_get_underlying_domain_type_restriction(trigger) !=
+			    cmd_ctx->lsm.domain.type) {
+				lttng_triggers_destroy(payload_triggers);
+				ret = LTTNG_ERR_INVALID_TRIGGER;
+				goto error;
+			}
+		}
+
+		original_reply_payload_size = cmd_ctx->reply_payload.buffer.size;
+
+		ret = cmd_register_triggers(
+			&cmd_creds, payload_triggers, the_notification_thread_handle);
+		if (ret != LTTNG_OK) {
+			lttng_triggers_destroy(payload_triggers);
+			goto error;
+		}
+
+		for (i = 0; i < count; i++) {
+			trigger_store_add(lttng_triggers_get_at_index(payload_triggers, i));
+		}
+
+		/* Reply with the registered triggers, which are named. */
+		ret = lttng_triggers_serialize(payload_triggers, &cmd_ctx->reply_payload);
+		lttng_triggers_destroy(payload_triggers);
+		if (ret) {
+			ERR("Failed to serialize triggers in reply to \"register triggers\" command");
+			ret = LTTNG_ERR_NOMEM;
+			goto error;
+		}
+
+		reply_payload_size =
+			cmd_ctx->reply_payload.buffer.size - original_reply_payload_size;
+
+		update_lttng_msg(cmd_ctx, 0, reply_payload_size);
+
+		ret = LTTNG_OK;
+		break;
+	}
+	case LTTCOMM_SESSIOND_COMMAND_UNREGISTER_TRIGGER:
+	{
+		struct lttng_trigger *payload_trigger;
+		const struct lttng_credentials cmd_creds = {
+			.uid = LTTNG_OPTIONAL_INIT_VALUE(cmd_ctx->creds.uid),
+			.gid = LTTNG_OPTIONAL_INIT_VALUE(cmd_ctx->creds.gid),
+		};
+
+		ret = receive_lttng_trigger(cmd_ctx, *sock, sock_error, &payload_trigger);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+
+		ret = cmd_unregister_trigger(
+			&cmd_creds, payload_trigger, the_notification_thread_handle);
+		if (ret == LTTNG_OK) {
+			trigger_store_remove(payload_trigger);
+		}
+
+		lttng_trigger_put(payload_trigger);
+		break;
+	}
+	case LTTCOMM_SESSIOND_COMMAND_ROTATE_SESSION:
+	{
+		struct lttng_rotate_session_return rotate_return;
 
 		DBG("Client rotate session \"%s\"", cmd_ctx->session->name);
 
@@ -2330,6 +2770,81 @@ skip_domain:
 
 		break;
 	}
+	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES:
+	{
+		const unsigned int count = cmd_ctx->lsm.u.error_query.count;
+		struct lttng_error_query **queries = nullptr;
+		struct lttng_error_query_results **results = nullptr;
+		const struct lttng_credentials cmd_creds = {
+			.uid = LTTNG_OPTIONAL_INIT_VALUE(cmd_ctx->creds.uid),
+			.gid = LTTNG_OPTIONAL_INIT_VALUE(cmd_ctx->creds.gid),
+		};
+		size_t original_payload_size;
+		size_t payload_size;
+		unsigned int i;
+
+		ret = setup_empty_lttng_msg(cmd_ctx);
+		if (ret) {
+			ret = LTTNG_ERR_NOMEM;
+			goto setup_error;
+		}
+
+		if (count == 0) {
+			ret = LTTNG_ERR_INVALID;
+			goto error;
+		}
+
+		queries = calloc<lttng_error_query *>(count);
+		results = calloc<lttng_error_query_results *>(count);
+		if (!queries || !results) {
+			free(queries);
+			free(results);
+			ret = LTTNG_ERR_NOMEM;
+			goto error;
+		}
+
+		original_payload_size = cmd_ctx->reply_payload.buffer.size;
+
+		ret = receive_lttng_error_queries(cmd_ctx, *sock, sock_error, queries);
+		if (ret == LTTNG_OK) {
+			ret = cmd_execute_error_queries(&cmd_creds,
+							queries,
+							count,
+							results,
+							the_notification_thread_handle);
+		}
+
+		/* The results of each query follow those of the previous one. */
+		for (i = 0; i < count; i++) {
+			if (ret == LTTNG_OK &&
+			    lttng_error_query_results_serialize(results[i],
+								&cmd_ctx->reply_payload)) {
+				ERR("Failed to serialize error query result set in reply to `execute error queries` command");
+				ret = LTTNG_ERR_NOMEM;
+			}
+
+			lttng_error_query_destroy(queries[i]);
+			lttng_error_query_results_destroy(results[i]);
+		}
+
+		free(queries);
+		free(results);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+
+		payload_size = cmd_ctx->reply_payload.buffer.size - original_payload_size;
+
+		update_lttng_msg(cmd_ctx, 0, payload_size);
+
+		ret = LTTNG_OK;
+
+		break;
+	}
+	case LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION:
+		/* The client thread keeps the connection open once the reply is sent. */
+		ret = LTTNG_OK;
+		break;
 	default:
 		ret = LTTNG_ERR_UND;
 		break;
@@ -2346,6 +2861,8 @@ error:
 	((struct lttcomm_lttng_msg *) (cmd_ctx->reply_payload.buffer.data))->ret_code = ret;
 setup_error:
 	if (cmd_ctx->session) {
+		/* The command may have changed the listed attributes of the session. */
+		cmd_update_session_summary(cmd_ctx->session);
 		session_unlock(cmd_ctx->session);
 		session_put(cmd_ctx->session);
 		cmd_ctx->session = nullptr;
@@ -2406,24 +2923,414 @@ static void thread_init_cleanup(void *data __attribute__((unused)))
 	set_thread_status(false);
 }
 
+/*
+ * Receive the command of a client, process it and send the reply.
+ *
+ * Return true if the connection is kept open for the next command of the
+ * client, false if it was closed.
+ */
+static bool handle_client_connection(struct command_ctx *cmd_ctx,
+				     struct client_connection *connection)
+{
+	int ret;
+	int sock_error;
+	int sock = connection->sock;
+	bool concurrent;
+	bool keep = false;
+	const struct cmd_completion_handler *cmd_completion_handler;
+
+	cmd_ctx->creds.uid = UINT32_MAX;
+	cmd_ctx->creds.gid = UINT32_MAX;
+	cmd_ctx->creds.pid = 0;
+	cmd_ctx->session = nullptr;
+	lttng_payload_clear(&cmd_ctx->reply_payload);
+	cmd_ctx->lttng_msg_size = 0;
+
+	/*
+	 * Data is received from the lttng client. The struct
+	 * lttcomm_session_msg (lsm) contains the command and data request of
+	 * the client.
+	 */
+	DBG("Receiving data from client ...");
+	ret = lttcomm_recv_creds_unix_sock(
+		sock, &cmd_ctx->lsm, sizeof(struct lttcomm_session_msg), &cmd_ctx->creds);
+	if (ret != sizeof(struct lttcomm_session_msg)) {
+		if (ret != 0 || !connection->persistent) {
+			DBG("Incomplete recv() from client... continuing");
+		}
+		goto end;
+	}
+
+	health_code_update();
+
+	// TODO: Validate cmd_ctx including sanity check for
+	// security purpose.
+
+	concurrent = command_is_concurrent(&cmd_ctx->lsm);
+	if (!concurrent) {
+		pthread_mutex_lock(&serialized_command_lock);
+	}
+
+	rcu_thread_online();
+	/*
+	 * This function dispatch the work to the kernel or userspace tracer
+	 * libs and fill the lttcomm_lttng_msg data structure of all the needed
+	 * informations for the client. The command context struct contains
+	 * everything this function may needs.
+	 */
+	try {
+		ret = process_client_msg(cmd_ctx, &sock, &sock_error);
+	} catch (const std::bad_alloc& ex) {
+		WARN_FMT("Failed to allocate memory while handling client request: {}",
+			 ex.what());
+		ret = LTTNG_ERR_NOMEM;
+	} catch (const lttng::ctl::error& ex) {
+		WARN_FMT("Client request failed: {}", ex.what());
+		ret = ex.code();
+	} catch (const std::exception& ex) {
+		WARN_FMT("Client request failed: {}", ex.what());
+		ret = LTTNG_ERR_UNK;
+	}
+	rcu_thread_offline();
+
+	if (ret < 0) {
+		if (!concurrent) {
+			pthread_mutex_unlock(&serialized_command_lock);
+		}
+		/*
+		 * TODO: Inform client somehow of the fatal error. At
+		 * this point, ret < 0 means that a zmalloc failed
+		 * (ENOMEM). Error detected but still accept
+		 * command, unless a socket error has been
+		 * detected.
+		 */
+		goto end;
+	}
+
+	if (ret < LTTNG_OK || ret >= LTTNG_ERR_NR) {
+		WARN("Command returned an invalid status code, returning unknown error: "
+		     "command type = %s (%d), ret = %d",
+		     lttcomm_sessiond_command_str((lttcomm_sessiond_command) cmd_ctx->lsm.cmd_type),
+		     cmd_ctx->lsm.cmd_type,
+		     ret);
+		ret = LTTNG_ERR_UNK;
+	}
+
+	if (cmd_ctx->lsm.cmd_type == LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION &&
+	    ret == LTTNG_OK) {
+		connection->persistent = true;
+	}
+
+	/* Only the serialized commands set a completion handler. */
+	cmd_completion_handler = concurrent ? nullptr : cmd_pop_completion_handler();
+	if (cmd_completion_handler) {
+		enum lttng_error_code completion_code;
+
+		completion_code = cmd_completion_handler->run(cmd_completion_handler->data);
+		if (completion_code != LTTNG_OK) {
+			pthread_mutex_unlock(&serialized_command_lock);
+			goto end;
+		}
+	}
+
+	if (!concurrent) {
+		pthread_mutex_unlock(&serialized_command_lock);
+	}
+
+	health_code_update();
+
+	if (sock >= 0) {
+		struct lttng_payload_view view =
+			lttng_payload_view_from_payload(&cmd_ctx->reply_payload, 0, -1);
+		struct lttcomm_lttng_msg *llm = (typeof(llm)) cmd_ctx->reply_payload.buffer.data;
+
+		LTTNG_ASSERT(cmd_ctx->reply_payload.buffer.size >= sizeof(*llm));
+		LTTNG_ASSERT(cmd_ctx->lttng_msg_size == cmd_ctx->reply_payload.buffer.size);
+
+		llm->fd_count = lttng_payload_view_get_fd_handle_count(&view);
+
+		DBG("Sending response (size: %d, retcode: %s (%d))",
+		    cmd_ctx->lttng_msg_size,
+		    lttng_strerror(-llm->ret_code),
+		    llm->ret_code);
+		ret = send_unix_sock(sock, &view);
+		if (ret < 0) {
+			ERR("Failed to send data back to client");
+		} else {
+			keep = connection->persistent;
+		}
+	}
+
+end:
+	/* End of transmission */
+	if (sock >= 0 && !keep) {
+		ret = close(sock);
+		if (ret) {
+			PERROR("close");
+		}
+	}
+
+	health_code_update();
+	return keep;
+}
+
+/*
+ * Take the oldest connection accepted by the client thread.
+ *
+ * Return the connection or null once the workers must exit.
+ */
+static struct client_connection *client_workers_dequeue()
+{
+	struct client_connection *connection = nullptr;
+
+	pthread_mutex_lock(&client_workers.lock);
+	while (!client_workers.exit && cds_list_empty(&client_workers.connections)) {
+		health_poll_entry();
+		pthread_cond_wait(&client_workers.cond, &client_workers.lock);
+		health_poll_exit();
+	}
+
+	if (!client_workers.exit) {
+		connection = cds_list_first_entry(
+			&client_workers.connections, struct client_connection, node);
+		cds_list_del(&connection->node);
+	}
+	pthread_mutex_unlock(&client_workers.lock);
+
+	return connection;
+}
+
+/* Hand a connection with a pending command to the command workers. */
+static void client_workers_enqueue(struct client_connection *connection)
+{
+	pthread_mutex_lock(&client_workers.lock);
+	cds_list_add_tail(&connection->node, &client_workers.connections);
+	pthread_cond_signal(&client_workers.cond);
+	pthread_mutex_unlock(&client_workers.lock);
+}
+
+/* Hand a persistent connection back to the client thread to poll it. */
+static void client_workers_release(struct client_connection *connection)
+{
+	pthread_mutex_lock(&client_workers.lock);
+	cds_list_add_tail(&connection->node, &client_workers.idle_connections);
+	pthread_mutex_unlock(&client_workers.lock);
+
+	(void) notify_thread_pipe(lttng_pipe_get_writefd(client_workers.idle_pipe));
+}
+
+static void close_client_connection(struct client_connection *connection)
+{
+	if (close(connection->sock)) {
+		PERROR("close");
+	}
+
+	free(connection);
+}
+
+/*
+ * Receive and process the commands of the connections which the client
+ * thread accepts.
+ */
+static void *thread_client_command_worker(void *data __attribute__((unused)))
+{
+	struct client_connection *connection;
+	struct command_ctx cmd_ctx = {};
+
+	DBG("[thread] Client command worker started");
+
+	lttng_payload_init(&cmd_ctx.reply_payload);
+
+	rcu_register_thread();
+
+	health_register(the_health_sessiond, HEALTH_SESSIOND_TYPE_CMD);
+
+	health_code_update();
+
+	rcu_thread_offline();
+	while ((connection = client_workers_dequeue())) {
+		if (handle_client_connection(&cmd_ctx, connection)) {
+			client_workers_release(connection);
+		} else {
+			free(connection);
+		}
+	}
+	rcu_thread_online();
+
+	health_unregister(the_health_sessiond);
+
+	DBG("Client command worker dying");
+	lttng_payload_reset(&cmd_ctx.reply_payload);
+	rcu_unregister_thread();
+	return nullptr;
+}
+
+static bool shutdown_client_command_worker(void *data __attribute__((unused)))
+{
+	pthread_mutex_lock(&client_workers.lock);
+	client_workers.exit = true;
+	pthread_cond_broadcast(&client_workers.cond);
+	pthread_mutex_unlock(&client_workers.lock);
+	return true;
+}
+
+/*
+ * Launch the command workers.
+ *
+ * Return 0 on success, -1 if no worker could be launched.
+ */
+static int launch_client_command_workers()
+{
+	client_workers.idle_pipe = lttng_pipe_open(FD_CLOEXEC);
+	if (!client_workers.idle_pipe) {
+		return -1;
+	}
+
+	client_workers.threads = calloc<lttng_thread *>(the_config.client_command_thread_count);
+	if (!client_workers.threads) {
+		return -1;
+	}
+
+	for (unsigned int i = 0; i < the_config.client_command_thread_count; i++) {
+		struct lttng_thread *thread;
+
+		thread = lttng_thread_create("Client command worker",
+					     thread_client_command_worker,
+					     shutdown_client_command_worker,
+					     nullptr,
+					     nullptr);
+		if (!thread) {
+			ERR("Failed to launch client command worker %u", i);
+			break;
+		}
+
+		client_workers.threads[client_workers.count++] = thread;
+	}
+
+	return client_workers.count > 0 ? 0 : -1;
+}
+
+/*
+ * Shut down the command workers once they have processed the commands which
+ * they received, closing the connections which none received and the idle
+ * ones.
+ */
+static void shutdown_client_command_workers()
+{
+	struct client_connection *connection, *tmp;
+
+	for (unsigned int i = 0; i < client_workers.count; i++) {
+		lttng_thread_shutdown(client_workers.threads[i]);
+		lttng_thread_put(client_workers.threads[i]);
+	}
+
+	free(client_workers.threads);
+	client_workers.threads = nullptr;
+	client_workers.count = 0;
+
+	cds_list_for_each_entry_safe (connection, tmp, &client_workers.connections, node) {
+		cds_list_del(&connection->node);
+		close_client_connection(connection);
+	}
+
+	cds_list_for_each_entry_safe (connection, tmp, &client_workers.idle_connections, node) {
+		cds_list_del(&connection->node);
+		close_client_connection(connection);
+	}
+
+	lttng_pipe_destroy(client_workers.idle_pipe);
+	client_workers.idle_pipe = nullptr;
+}
+
+/*
+ * Poll the persistent connections which the command workers made idle.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int poll_idle_client_connections(struct lttng_poll_event *events,
+					struct cds_list_head *polled_connections)
+{
+	int ret = 0;
+	char dummy;
+	struct client_connection *connection, *tmp;
+	struct cds_list_head idle_connections;
+
+	(void) lttng_pipe_read(client_workers.idle_pipe, &dummy, sizeof(dummy));
+
+	CDS_INIT_LIST_HEAD(&idle_connections);
+	pthread_mutex_lock(&client_workers.lock);
+	cds_list_splice(&client_workers.idle_connections, &idle_connections);
+	CDS_INIT_LIST_HEAD(&client_workers.idle_connections);
+	pthread_mutex_unlock(&client_workers.lock);
+
+	cds_list_for_each_entry_safe (connection, tmp, &idle_connections, node) {
+		cds_list_del(&connection->node);
+		if (lttng_poll_add(events, connection->sock, LPOLLIN | LPOLLRDHUP)) {
+			close_client_connection(connection);
+			ret = -1;
+			continue;
+		}
+
+		cds_list_add(&connection->node, polled_connections);
+	}
+
+	return ret;
+}
+
+/*
+ * Handle an event of a polled persistent connection, handing it to the
+ * command workers if the client sent its next command.
+ *
+ * Return true if the file descriptor is one of a polled connection.
+ */
+static bool handle_client_connection_event(struct lttng_poll_event *events,
+					   struct cds_list_head *polled_connections,
+					   int pollfd,
+					   uint32_t revents)
+{
+	struct client_connection *connection;
+
+	cds_list_for_each_entry (connection, polled_connections, node) {
+		if (connection->sock != pollfd) {
+			continue;
+		}
+
+		cds_list_del(&connection->node);
+		(void) lttng_poll_del(events, pollfd);
+		if (revents & LPOLLIN) {
+			/* The worker also notices a hang up when receiving the command. */
+			client_workers_enqueue(connection);
+		} else {
+			DBG("Persistent client connection closed (fd = %d)", pollfd);
+			close_client_connection(connection);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
 /*
  * This thread manage all clients request using the unix client socket for
- * communication.
+ * communication. The commands are received and processed by the command
+ * workers, the persistent connections being polled here between their
+ * commands.
  */
 static void *thread_manage_clients(void *data)
 {
 	int sock = -1, ret, i, err = -1;
-	int sock_error;
 	uint32_t nb_fd;
 	struct lttng_poll_event events;
 	const int client_sock = thread_state.client_sock;
 	struct lttng_pipe *quit_pipe = (lttng_pipe *) data;
 	const int thread_quit_pipe_fd = lttng_pipe_get_readfd(quit_pipe);
-	struct command_ctx cmd_ctx = {};
+	struct client_connection *connection, *tmp;
+	struct cds_list_head polled_connections;
 
 	DBG("[thread] Manage client started");
 
-	lttng_payload_init(&cmd_ctx.reply_payload);
+	CDS_INIT_LIST_HEAD(&polled_connections);
 
 	is_root = (getuid() == 0);
 
@@ -2441,10 +3348,11 @@ static void *thread_manage_clients(void *data)
 	}
 
 	/*
-	 * Pass 2 as size here for the thread quit pipe and client_sock. Nothing
-	 * more will be added to this poll set.
+	 * Pass 3 as size here for the thread quit pipe, client_sock and the
+	 * idle connection pipe. The persistent connections are added to this
+	 * poll set between their commands.
 	 */
-	ret = lttng_poll_create(&events, 2, LTTNG_CLOEXEC);
+	ret = lttng_poll_create(&events, 3, LTTNG_CLOEXEC);
 	if (ret < 0) {
 		goto error_create_poll;
 	}
@@ -2461,6 +3369,16 @@ static void *thread_manage_clients(void *data)
 		goto error;
 	}
 
+	ret = launch_client_command_workers();
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = lttng_poll_add(&events, lttng_pipe_get_readfd(client_workers.idle_pipe), LPOLLIN);
+	if (ret < 0) {
+		goto error;
+	}
+
 	/* Set state as running. */
 	set_thread_status(true);
 	pthread_cleanup_pop(0);
@@ -2477,14 +3395,7 @@ static void *thread_manage_clients(void *data)
 	health_code_update();
 
 	while (true) {
-		const struct cmd_completion_handler *cmd_completion_handler;
-
-		cmd_ctx.creds.uid = UINT32_MAX;
-		cmd_ctx.creds.gid = UINT32_MAX;
-		cmd_ctx.creds.pid = 0;
-		cmd_ctx.session = nullptr;
-		lttng_payload_clear(&cmd_ctx.reply_payload);
-		cmd_ctx.lttng_msg_size = 0;
+		bool accept_client = false;
 
 		DBG("Accepting client command ...");
 
@@ -2519,8 +3430,21 @@ static void *thread_manage_clients(void *data)
 				goto exit;
 			}
 
+			if (pollfd == lttng_pipe_get_readfd(client_workers.idle_pipe)) {
+				if (poll_idle_client_connections(&events, &polled_connections)) {
+					goto error;
+				}
+				continue;
+			}
+
+			if (handle_client_connection_event(
+				    &events, &polled_connections, pollfd, revents)) {
+				continue;
+			}
+
 			/* Event on the registration socket */
 			if (revents & LPOLLIN) {
+				accept_client = true;
 				continue;
 			} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
 				ERR("Client socket poll error");
@@ -2531,6 +3455,10 @@ static void *thread_manage_clients(void *data)
 			}
 		}
 
+		if (!accept_client) {
+			continue;
+		}
+
 		DBG("Wait for client response");
 
 		health_code_update();
@@ -2554,117 +3482,15 @@ static void *thread_manage_clients(void *data)
 
 		health_code_update();
 
-		/*
-		 * Data is received from the lttng client. The struct
-		 * lttcomm_session_msg (lsm) contains the command and data request of
-		 * the client.
-		 */
-		DBG("Receiving data from client ...");
-		ret = lttcomm_recv_creds_unix_sock(
-			sock, &cmd_ctx.lsm, sizeof(struct lttcomm_session_msg), &cmd_ctx.creds);
-		if (ret != sizeof(struct lttcomm_session_msg)) {
-			DBG("Incomplete recv() from client... continuing");
-			ret = close(sock);
-			if (ret) {
-				PERROR("close");
-			}
-			sock = -1;
-			continue;
-		}
-
-		health_code_update();
-
-		// TODO: Validate cmd_ctx including sanity check for
-		// security purpose.
-
-		rcu_thread_online();
-		/*
-		 * This function dispatch the work to the kernel or userspace tracer
-		 * libs and fill the lttcomm_lttng_msg data structure of all the needed
-		 * informations for the client. The command context struct contains
-		 * everything this function may needs.
-		 */
-		try {
-			ret = process_client_msg(&cmd_ctx, &sock, &sock_error);
-			rcu_thread_offline();
-			if (ret < 0) {
-				if (sock >= 0) {
-					ret = close(sock);
-					if (ret) {
-						PERROR("close");
-					}
-				}
-				sock = -1;
-				/*
-				 * TODO: Inform client somehow of the fatal error. At
-				 * this point, ret < 0 means that a zmalloc failed
-				 * (ENOMEM). Error detected but still accept
-				 * command, unless a socket error has been
-				 * detected.
-				 */
-				continue;
-			}
-		} catch (const std::bad_alloc& ex) {
-			WARN_FMT("Failed to allocate memory while handling client request: {}",
-				 ex.what());
-			ret = LTTNG_ERR_NOMEM;
-		} catch (const lttng::ctl::error& ex) {
-			WARN_FMT("Client request failed: {}", ex.what());
-			ret = ex.code();
-		} catch (const std::exception& ex) {
-			WARN_FMT("Client request failed: {}", ex.what());
-			ret = LTTNG_ERR_UNK;
-		}
-
-		if (ret < LTTNG_OK || ret >= LTTNG_ERR_NR) {
-			WARN("Command returned an invalid status code, returning unknown error: "
-			     "command type = %s (%d), ret = %d",
-			     lttcomm_sessiond_command_str(
-				     (lttcomm_sessiond_command) cmd_ctx.lsm.cmd_type),
-			     cmd_ctx.lsm.cmd_type,
-			     ret);
-			ret = LTTNG_ERR_UNK;
-		}
-
-		cmd_completion_handler = cmd_pop_completion_handler();
-		if (cmd_completion_handler) {
-			enum lttng_error_code completion_code;
-
-			completion_code = cmd_completion_handler->run(cmd_completion_handler->data);
-			if (completion_code != LTTNG_OK) {
-				continue;
-			}
+		connection = zmalloc<client_connection>();
+		if (!connection) {
+			PERROR("zmalloc client connection");
+			goto error;
 		}
 
-		health_code_update();
-
-		if (sock >= 0) {
-			struct lttng_payload_view view =
-				lttng_payload_view_from_payload(&cmd_ctx.reply_payload, 0, -1);
-			struct lttcomm_lttng_msg *llm =
-				(typeof(llm)) cmd_ctx.reply_payload.buffer.data;
-
-			LTTNG_ASSERT(cmd_ctx.reply_payload.buffer.size >= sizeof(*llm));
-			LTTNG_ASSERT(cmd_ctx.lttng_msg_size == cmd_ctx.reply_payload.buffer.size);
-
-			llm->fd_count = lttng_payload_view_get_fd_handle_count(&view);
-
-			DBG("Sending response (size: %d, retcode: %s (%d))",
-			    cmd_ctx.lttng_msg_size,
-			    lttng_strerror(-llm->ret_code),
-			    llm->ret_code);
-			ret = send_unix_sock(sock, &view);
-			if (ret < 0) {
-				ERR("Failed to send data back to client");
-			}
-
-			/* End of transmission */
-			ret = close(sock);
-			if (ret) {
-				PERROR("close");
-			}
-		}
+		connection->sock = sock;
 		sock = -1;
+		client_workers_enqueue(connection);
 
 		health_code_update();
 	}
@@ -2678,6 +3504,14 @@ error:
 		}
 	}
 
+	/* No command is processed once this thread is shut down. */
+	shutdown_client_command_workers();
+
+	cds_list_for_each_entry_safe (connection, tmp, &polled_connections, node) {
+		cds_list_del(&connection->node);
+		close_client_connection(connection);
+	}
+
 	lttng_poll_clean(&events);
 
 error_listen:
@@ -2696,7 +3530,6 @@ error_create_poll:
 	health_unregister(the_health_sessiond);
 
 	DBG("Client thread dying");
-	lttng_payload_reset(&cmd_ctx.reply_payload);
 	rcu_unregister_thread();
 	return nullptr;
 }
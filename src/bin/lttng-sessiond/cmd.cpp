@@ -37,8 +37,10 @@
 #include <common/payload-view.hpp>
 #include <common/payload.hpp>
 #include <common/relayd/relayd.hpp>
+#include <common/self-tracing/self-tracing.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/string-utils/string-utils.hpp>
+#include <common/time.hpp>
 #include <common/trace-chunk.hpp>
 #include <common/urcu.hpp>
 #include <common/utils.hpp>
@@ -66,8 +68,10 @@
 
 #include <algorithm>
 #include <inttypes.h>
+#include <linux/magic.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <sys/vfs.h>
 #include <urcu/list.h>
 #include <urcu/uatomic.h>
 
@@ -82,6 +86,8 @@ namespace {
 struct cmd_destroy_session_reply_context {
 	int reply_sock_fd;
 	bool implicit_rotation_on_destroy;
+	/* End of the destruction command, to time the wait for its completion. */
+	uint64_t command_end_ns;
 	/*
 	 * Indicates whether or not an error occurred while launching the
 	 * destruction of a session.
@@ -128,6 +134,21 @@ static enum lttng_error_code cmd_enable_channel_internal(struct ltt_session *ses
 							 const struct lttng_channel *_attr,
 							 int wpipe);
 
+/*
+ * End the command phase which began at `*phase_begin_ns` and begin the next
+ * one.
+ *
+ * Returns the duration of the phase, in microseconds.
+ */
+static uint64_t end_command_phase(uint64_t *phase_begin_ns)
+{
+	const uint64_t now_ns = lttng_monotonic_now_ns();
+	const uint64_t duration_us = (now_ns - *phase_begin_ns) / 1000;
+
+	*phase_begin_ns = now_ns;
+	return duration_us;
+}
+
 /*
  * Create a session path used by list_lttng_sessions for the case that the
  * session consumer is on the network.
@@ -212,12 +233,13 @@ error:
 
 /*
  * Get run-time attributes if the session has been started (discarded events,
- * lost packets).
+ * lost packets, consumption statistics).
  */
 static int get_kernel_runtime_stats(struct ltt_session *session,
 				    struct ltt_kernel_channel *kchan,
 				    uint64_t *discarded_events,
-				    uint64_t *lost_packets)
+				    uint64_t *lost_packets,
+				    struct lttcomm_consumer_channel_consumption_stats *stats)
 {
 	int ret;
 
@@ -225,6 +247,7 @@ static int get_kernel_runtime_stats(struct ltt_session *session,
 		ret = 0;
 		*discarded_events = 0;
 		*lost_packets = 0;
+		memset(stats, 0, sizeof(*stats));
 		goto end;
 	}
 
@@ -240,23 +263,30 @@ static int get_kernel_runtime_stats(struct ltt_session *session,
 		goto end;
 	}
 
+	ret = consumer_get_consumption_stats(
+		session->id, kchan->key, session->kernel_session->consumer, stats);
+	if (ret < 0) {
+		goto end;
+	}
+
 end:
 	return ret;
 }
 
 /*
  * Get run-time attributes if the session has been started (discarded events,
- * lost packets).
+ * lost packets, consumption statistics).
  */
 static int get_ust_runtime_stats(struct ltt_session *session,
 				 struct ltt_ust_channel *uchan,
 				 uint64_t *discarded_events,
-				 uint64_t *lost_packets)
+				 uint64_t *lost_packets,
+				 struct lttcomm_consumer_channel_consumption_stats *stats)
 {
 	int ret;
 	struct ltt_ust_session *usess;
 
-	if (!discarded_events || !lost_packets) {
+	if (!discarded_events || !lost_packets || !stats) {
 		ret = -1;
 		goto end;
 	}
@@ -268,6 +298,7 @@ static int get_ust_runtime_stats(struct ltt_session *session,
 	if (!usess || !session->has_been_started) {
 		*discarded_events = 0;
 		*lost_packets = 0;
+		memset(stats, 0, sizeof(*stats));
 		ret = 0;
 		goto end;
 	}
@@ -279,14 +310,16 @@ static int get_ust_runtime_stats(struct ltt_session *session,
 							    uchan->id,
 							    uchan->attr.overwrite,
 							    discarded_events,
-							    lost_packets);
+							    lost_packets,
+							    stats);
 	} else if (usess->buffer_type == LTTNG_BUFFER_PER_PID) {
 		ret = ust_app_pid_get_channel_runtime_stats(usess,
 							    uchan,
 							    usess->consumer,
 							    uchan->attr.overwrite,
 							    discarded_events,
-							    lost_packets);
+							    lost_packets,
+							    stats);
 		if (ret < 0) {
 			goto end;
 		}
@@ -689,6 +722,7 @@ static enum lttng_error_code add_uri_to_consumer(const struct ltt_session *sessi
 	switch (uri->dtype) {
 	case LTTNG_DST_IPV4:
 	case LTTNG_DST_IPV6:
+	case LTTNG_DST_UNIX:
 		DBG2("Setting network URI to consumer");
 
 		if (consumer->type == CONSUMER_DST_NET) {
@@ -985,21 +1019,26 @@ static enum lttng_error_code send_consumer_relayd_sockets(unsigned int session_i
 		}
 	}
 
-	/* Sending data relayd socket. */
+	/*
+	 * Sending data relayd sockets. The consumer spreads its streams across
+	 * the data connections.
+	 */
 	if (!sock->data_sock_sent) {
-		status = send_consumer_relayd_socket(session_id,
-						     &consumer->dst.net.data,
-						     consumer,
-						     sock,
-						     session_name,
-						     hostname,
-						     base_path,
-						     session_live_timer,
-						     current_chunk_id,
-						     session_creation_time,
-						     session_name_contains_creation_time);
-		if (status != LTTNG_OK) {
-			goto error;
+		for (unsigned int i = 0; i < the_config.relayd_data_connection_count; i++) {
+			status = send_consumer_relayd_socket(session_id,
+							     &consumer->dst.net.data,
+							     consumer,
+							     sock,
+							     session_name,
+							     hostname,
+							     base_path,
+							     session_live_timer,
+							     current_chunk_id,
+							     session_creation_time,
+							     session_name_contains_creation_time);
+			if (status != LTTNG_OK) {
+				goto error;
+			}
 		}
 	}
 
@@ -1654,6 +1693,87 @@ end:
 	return ret_code;
 }
 
+/*
+ * The kernel tracer has no interface to track a set of values at once: the
+ * values are tracked one by one. The user space applications are updated once
+ * for the whole set.
+ */
+enum lttng_error_code
+cmd_process_attr_tracker_inclusion_set_add_values(struct ltt_session *session,
+						  enum lttng_domain_type domain,
+						  enum lttng_process_attr process_attr,
+						  const struct lttng_process_attr_values *values)
+{
+	enum lttng_error_code ret_code = LTTNG_OK;
+	const unsigned int count = _lttng_process_attr_values_get_count(values);
+
+	switch (domain) {
+	case LTTNG_DOMAIN_KERNEL:
+		if (!session->kernel_session) {
+			ret_code = LTTNG_ERR_INVALID;
+			goto end;
+		}
+		for (unsigned int i = 0; i < count && ret_code == LTTNG_OK; i++) {
+			ret_code = kernel_process_attr_tracker_inclusion_set_add_value(
+				session->kernel_session,
+				process_attr,
+				lttng_process_attr_tracker_values_get_at_index(values, i));
+		}
+		break;
+	case LTTNG_DOMAIN_UST:
+		if (!session->ust_session) {
+			ret_code = LTTNG_ERR_INVALID;
+			goto end;
+		}
+		ret_code = trace_ust_process_attr_tracker_inclusion_set_add_values(
+			session->ust_session, process_attr, values);
+		break;
+	default:
+		ret_code = LTTNG_ERR_UNSUPPORTED_DOMAIN;
+		break;
+	}
+end:
+	return ret_code;
+}
+
+enum lttng_error_code
+cmd_process_attr_tracker_inclusion_set_remove_values(struct ltt_session *session,
+						     enum lttng_domain_type domain,
+						     enum lttng_process_attr process_attr,
+						     const struct lttng_process_attr_values *values)
+{
+	enum lttng_error_code ret_code = LTTNG_OK;
+	const unsigned int count = _lttng_process_attr_values_get_count(values);
+
+	switch (domain) {
+	case LTTNG_DOMAIN_KERNEL:
+		if (!session->kernel_session) {
+			ret_code = LTTNG_ERR_INVALID;
+			goto end;
+		}
+		for (unsigned int i = 0; i < count && ret_code == LTTNG_OK; i++) {
+			ret_code = kernel_process_attr_tracker_inclusion_set_remove_value(
+				session->kernel_session,
+				process_attr,
+				lttng_process_attr_tracker_values_get_at_index(values, i));
+		}
+		break;
+	case LTTNG_DOMAIN_UST:
+		if (!session->ust_session) {
+			ret_code = LTTNG_ERR_INVALID;
+			goto end;
+		}
+		ret_code = trace_ust_process_attr_tracker_inclusion_set_remove_values(
+			session->ust_session, process_attr, values);
+		break;
+	default:
+		ret_code = LTTNG_ERR_UNSUPPORTED_DOMAIN;
+		break;
+	}
+end:
+	return ret_code;
+}
+
 enum lttng_error_code
 cmd_process_attr_tracker_get_inclusion_set(struct ltt_session *session,
 					   enum lttng_domain_type domain,
@@ -2018,6 +2138,7 @@ error:
 		LTTNG_ASSERT(uchan);
 		/* Remove from the channel list of the session. */
 		trace_ust_delete_channel(session->ust_session->domain_global.channels, uchan);
+		trace_ust_invalidate_setup_plan(session->ust_session);
 		trace_ust_destroy_channel(uchan);
 	}
 end:
@@ -2142,51 +2263,53 @@ static int _cmd_enable_event(struct ltt_session *session,
 		switch (event->type) {
 		case LTTNG_EVENT_ALL:
 		{
-			char *filter_expression_a = nullptr;
-			struct lttng_bytecode *filter_a = nullptr;
+			struct lttng_event tracepoint_event = *event;
+			struct lttng_event syscall_event = *event;
+			struct kernel_event_batch_entry entries[2] = {};
 
 			/*
 			 * We need to duplicate filter_expression and filter,
-			 * because ownership is passed to first enable
-			 * event.
+			 * because ownership is passed to each enabled event.
 			 */
 			if (filter_expression) {
-				filter_expression_a = strdup(filter_expression);
-				if (!filter_expression_a) {
+				entries[1].filter_expression = strdup(filter_expression);
+				if (!entries[1].filter_expression) {
 					ret = LTTNG_ERR_FATAL;
 					goto error;
 				}
 			}
 			if (filter) {
-				filter_a = zmalloc<lttng_bytecode>(sizeof(*filter_a) + filter->len);
-				if (!filter_a) {
-					free(filter_expression_a);
+				entries[1].filter =
+					zmalloc<lttng_bytecode>(sizeof(*filter) + filter->len);
+				if (!entries[1].filter) {
+					free(entries[1].filter_expression);
 					ret = LTTNG_ERR_FATAL;
 					goto error;
 				}
-				memcpy(filter_a, filter, sizeof(*filter_a) + filter->len);
+				memcpy(entries[1].filter, filter, sizeof(*filter) + filter->len);
 			}
-			event->type = LTTNG_EVENT_TRACEPOINT; /* Hack */
-			ret = event_kernel_enable_event(kchan, event, filter_expression, filter);
+
+			tracepoint_event.type = LTTNG_EVENT_TRACEPOINT;
+			entries[0].ev = &tracepoint_event;
+			entries[0].filter_expression = filter_expression;
+			entries[0].filter = filter;
+			syscall_event.type = LTTNG_EVENT_SYSCALL;
+			entries[1].ev = &syscall_event;
+
+			(void) event_kernel_enable_events(kchan, entries, 2);
 			/* We have passed ownership */
 			filter_expression = nullptr;
 			filter = nullptr;
-			if (ret != LTTNG_OK) {
+			if (entries[0].status != LTTNG_OK) {
 				if (channel_created) {
 					/* Let's not leak a useless channel. */
 					kernel_destroy_channel(kchan);
 				}
-				free(filter_expression_a);
-				free(filter_a);
+				ret = entries[0].status;
 				goto error;
 			}
-			event->type = LTTNG_EVENT_SYSCALL; /* Hack */
-			ret = event_kernel_enable_event(
-				kchan, event, filter_expression_a, filter_a);
-			/* We have passed ownership */
-			filter_expression_a = nullptr;
-			filter_a = nullptr;
-			if (ret != LTTNG_OK) {
+			if (entries[1].status != LTTNG_OK) {
+				ret = entries[1].status;
 				goto error;
 			}
 			break;
@@ -2825,6 +2948,7 @@ int cmd_start_trace(struct ltt_session *session)
 	if (usess) {
 		int int_ret = ust_app_start_trace_all(usess);
 
+		session_update_ust_active_index(session);
 		if (int_ret < 0) {
 			ret = LTTNG_ERR_UST_START_FAIL;
 			goto error;
@@ -2903,6 +3027,7 @@ int cmd_stop_trace(struct ltt_session *session)
 
 	if (usess && usess->active) {
 		ret = ust_app_stop_trace_all(usess);
+		session_update_ust_active_index(session);
 		if (ret < 0) {
 			ret = LTTNG_ERR_UST_STOP_FAIL;
 			goto error;
@@ -3214,6 +3339,9 @@ cmd_create_session_from_descriptor(struct lttng_session_descriptor *descriptor,
 		goto end;
 	}
 	new_session->consumer->enabled = true;
+	session_lock(new_session);
+	cmd_update_session_summary(new_session);
+	session_unlock(new_session);
 	ret_code = LTTNG_OK;
 end:
 	/* Release reference provided by the session_create function. */
@@ -3330,7 +3458,11 @@ static void cmd_destroy_session_reply(const struct ltt_session *session, void *_
 		.fd_count = 0,
 	};
 	size_t payload_size_before_location;
+	uint64_t phase_begin_ns = reply_context->command_end_ns;
 
+	DBG("Destruction of session \"%s\" completed: wait for completion = %" PRIu64 " us",
+	    session->name,
+	    end_command_phase(&phase_begin_ns));
 	lttng_dynamic_buffer_init(&payload);
 
 	ret = lttng_dynamic_buffer_append(&payload, &llm, sizeof(llm));
@@ -3402,6 +3534,8 @@ int cmd_destroy_session(struct ltt_session *session, int *sock_fd)
 	int ret;
 	enum lttng_error_code destruction_last_error = LTTNG_OK;
 	struct cmd_destroy_session_reply_context *reply_context = nullptr;
+	uint64_t phase_begin_ns = lttng_monotonic_now_ns();
+	uint64_t stop_duration_us = 0, rotation_duration_us = 0;
 
 	if (sock_fd) {
 		reply_context = zmalloc<cmd_destroy_session_reply_context>();
@@ -3430,6 +3564,7 @@ int cmd_destroy_session(struct ltt_session *session, int *sock_fd)
 		}
 	}
 
+	stop_duration_us = end_command_phase(&phase_begin_ns);
 	if (session->rotation_schedule_timer_enabled) {
 		if (timer_session_rotation_schedule_timer_stop(session)) {
 			ERR("Failed to stop the \"rotation schedule\" timer of session %s",
@@ -3548,6 +3683,13 @@ int cmd_destroy_session(struct ltt_session *session, int *sock_fd)
 		LTTNG_ASSERT(!ret);
 	}
 
+	rotation_duration_us = end_command_phase(&phase_begin_ns);
+	DBG("Destruction of session \"%s\" phase durations: stop = %" PRIu64
+	    " us, final rotation = %" PRIu64 " us",
+	    session->name,
+	    stop_duration_us,
+	    rotation_duration_us);
+
 	/*
 	 * The session is destroyed. However, note that the command context
 	 * still holds a reference to the session, thus delaying its destruction
@@ -3556,6 +3698,7 @@ int cmd_destroy_session(struct ltt_session *session, int *sock_fd)
 	session_destroy(session);
 	if (reply_context) {
 		reply_context->destruction_status = destruction_last_error;
+		reply_context->command_end_ns = phase_begin_ns;
 		ret = session_add_destroy_notifier(
 			session, cmd_destroy_session_reply, (void *) reply_context);
 		if (ret) {
@@ -3762,13 +3905,17 @@ enum lttng_error_code cmd_list_channels(enum lttng_domain_type domain,
 			cds_list_for_each_entry (
 				kchan, &session->kernel_session->channel_list.head, list) {
 				uint64_t discarded_events, lost_packets;
+				struct lttcomm_consumer_channel_consumption_stats consumption_stats;
 				struct lttng_channel_extended *extended;
 
 				extended = (struct lttng_channel_extended *)
 						   kchan->channel->attr.extended.ptr;
 
-				ret = get_kernel_runtime_stats(
-					session, kchan, &discarded_events, &lost_packets);
+				ret = get_kernel_runtime_stats(session,
+							       kchan,
+							       &discarded_events,
+							       &lost_packets,
+							       &consumption_stats);
 				if (ret < 0) {
 					ret_code = LTTNG_ERR_UNK;
 					goto end;
@@ -3780,6 +3927,16 @@ enum lttng_error_code cmd_list_channels(enum lttng_domain_type domain,
 				 */
 				extended->discarded_events = discarded_events;
 				extended->lost_packets = lost_packets;
+				memcpy(extended->consumption_latency_histogram,
+				       consumption_stats.latency_histogram,
+				       sizeof(extended->consumption_latency_histogram));
+				memcpy(extended->consumption_size_histogram,
+				       consumption_stats.size_histogram,
+				       sizeof(extended->consumption_size_histogram));
+				extended->splice_pipe_size = consumption_stats.splice_pipe_size;
+				extended->relayd_spilled_size =
+					consumption_stats.relayd_spilled_bytes;
+				extended->effective_buffer_page_size = the_page_size;
 
 				ret = lttng_channel_serialize(kchan->channel, &payload->buffer);
 				if (ret) {
@@ -3807,6 +3964,7 @@ enum lttng_error_code cmd_list_channels(enum lttng_domain_type domain,
 						 uchan,
 						 node.node) {
 				uint64_t discarded_events = 0, lost_packets = 0;
+				struct lttcomm_consumer_channel_consumption_stats consumption_stats;
 				struct lttng_channel *channel = nullptr;
 				struct lttng_channel_extended *extended;
 
@@ -3819,8 +3977,11 @@ enum lttng_error_code cmd_list_channels(enum lttng_domain_type domain,
 				extended = (struct lttng_channel_extended *)
 						   channel->attr.extended.ptr;
 
-				ret = get_ust_runtime_stats(
-					session, uchan, &discarded_events, &lost_packets);
+				ret = get_ust_runtime_stats(session,
+							    uchan,
+							    &discarded_events,
+							    &lost_packets,
+							    &consumption_stats);
 				if (ret < 0) {
 					lttng_channel_destroy(channel);
 					ret_code = LTTNG_ERR_UNK;
@@ -3829,6 +3990,14 @@ enum lttng_error_code cmd_list_channels(enum lttng_domain_type domain,
 
 				extended->discarded_events = discarded_events;
 				extended->lost_packets = lost_packets;
+				memcpy(extended->consumption_latency_histogram,
+				       consumption_stats.latency_histogram,
+				       sizeof(extended->consumption_latency_histogram));
+				memcpy(extended->consumption_size_histogram,
+				       consumption_stats.size_histogram,
+				       sizeof(extended->consumption_size_histogram));
+				extended->relayd_spilled_size =
+					consumption_stats.relayd_spilled_bytes;
 
 				ret = lttng_channel_serialize(channel, &payload->buffer);
 				if (ret) {
@@ -3950,6 +4119,157 @@ end:
 	return ret_code;
 }
 
+/*
+ * Append the reply of a listing command to the reply of a DESCRIBE_SESSION
+ * command, prefixed by its size.
+ *
+ * The channels of the domain are listed if `channel_name` is NULL, the events
+ * of the channel otherwise.
+ */
+static enum lttng_error_code describe_session_append_list(struct ltt_session *session,
+							  enum lttng_domain_type domain,
+							  char *channel_name,
+							  struct lttng_payload *payload)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct lttcomm_session_description_list_header list_header = {};
+	const size_t list_header_offset = payload->buffer.size;
+
+	ret = lttng_dynamic_buffer_set_size(&payload->buffer,
+					    list_header_offset + sizeof(list_header));
+	if (ret) {
+		return LTTNG_ERR_NOMEM;
+	}
+
+	if (channel_name) {
+		ret_code = cmd_list_events(domain, session, channel_name, payload);
+	} else {
+		ret_code = cmd_list_channels(domain, session, payload);
+	}
+
+	if (ret_code != LTTNG_OK) {
+		return ret_code;
+	}
+
+	list_header.size = payload->buffer.size - list_header_offset - sizeof(list_header);
+	memcpy(payload->buffer.data + list_header_offset, &list_header, sizeof(list_header));
+	return LTTNG_OK;
+}
+
+static enum lttng_error_code describe_session_domain(struct ltt_session *session,
+						     const struct lttng_domain *domain,
+						     struct lttng_payload *payload)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	/* The agent domains have no channels and list their events directly. */
+	char agent_channel_name[] = "";
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer, domain, sizeof(*domain));
+	if (ret) {
+		return LTTNG_ERR_NOMEM;
+	}
+
+	ret_code = describe_session_append_list(session, domain->type, nullptr, payload);
+	if (ret_code != LTTNG_OK) {
+		return ret_code;
+	}
+
+	switch (domain->type) {
+	case LTTNG_DOMAIN_KERNEL:
+	{
+		struct ltt_kernel_channel *kchan;
+
+		/* Same order as cmd_list_channels(). */
+		cds_list_for_each_entry (kchan, &session->kernel_session->channel_list.head, list) {
+			ret_code = describe_session_append_list(
+				session, domain->type, kchan->channel->name, payload);
+			if (ret_code != LTTNG_OK) {
+				return ret_code;
+			}
+		}
+
+		break;
+	}
+	case LTTNG_DOMAIN_UST:
+	{
+		struct lttng_ht_iter iter;
+		struct ltt_ust_channel *uchan;
+		lttng::urcu::read_lock_guard read_lock;
+
+		/*
+		 * Same order as cmd_list_channels(): the channels can't be added
+		 * or removed while the session is locked.
+		 */
+		cds_lfht_for_each_entry (session->ust_session->domain_global.channels->ht,
+					 &iter.iter,
+					 uchan,
+					 node.node) {
+			ret_code = describe_session_append_list(
+				session, domain->type, uchan->name, payload);
+			if (ret_code != LTTNG_OK) {
+				return ret_code;
+			}
+		}
+
+		break;
+	}
+	default:
+		ret_code = describe_session_append_list(
+			session, domain->type, agent_channel_name, payload);
+		break;
+	}
+
+	return ret_code;
+}
+
+/*
+ * Command LTTNG_DESCRIBE_SESSION processed by the client thread.
+ *
+ * Describe the domains, channels and events of a session in a single reply,
+ * sparing the clients a LIST_CHANNELS command per domain and a LIST_EVENTS
+ * command per channel.
+ */
+enum lttng_error_code cmd_describe_session(struct ltt_session *session,
+					   struct lttng_payload *payload)
+{
+	int ret;
+	ssize_t nb_dom, i;
+	struct lttng_domain *domains = nullptr;
+	struct lttcomm_list_command_header cmd_header = {};
+	enum lttng_error_code ret_code = LTTNG_OK;
+
+	LTTNG_ASSERT(session);
+	LTTNG_ASSERT(payload);
+
+	DBG("Describing session %s", session->name);
+
+	nb_dom = cmd_list_domains(session, &domains);
+	if (nb_dom < 0) {
+		/* Return value is a negative lttng_error_code. */
+		return (enum lttng_error_code) -nb_dom;
+	}
+
+	cmd_header.count = (uint32_t) nb_dom;
+	ret = lttng_dynamic_buffer_append(&payload->buffer, &cmd_header, sizeof(cmd_header));
+	if (ret) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	for (i = 0; i < nb_dom; i++) {
+		ret_code = describe_session_domain(session, &domains[i], payload);
+		if (ret_code != LTTNG_OK) {
+			goto end;
+		}
+	}
+
+end:
+	free(domains);
+	return ret_code;
+}
+
 /*
  * Using the session list, filled a lttng_session array to send back to the
  * client for session listing.
@@ -3957,63 +4277,92 @@ end:
  * The session list lock MUST be acquired before calling this function. Use
  * session_lock_list() and session_unlock_list().
  */
+/*
+ * Regenerate the summary of a session, used to list it, from its current
+ * attributes.
+ *
+ * The session lock must be held.
+ */
+void cmd_update_session_summary(struct ltt_session *session)
+{
+	int ret;
+	struct ltt_session_summary *summary;
+	struct ltt_kernel_session *ksess = session->kernel_session;
+	struct ltt_ust_session *usess = session->ust_session;
+
+	summary = zmalloc<ltt_session_summary>();
+	if (!summary) {
+		ERR("Failed to allocate session summary: session name = %s", session->name);
+		return;
+	}
+
+	if (session->consumer->type == CONSUMER_DST_NET ||
+	    (ksess && ksess->consumer->type == CONSUMER_DST_NET) ||
+	    (usess && usess->consumer->type == CONSUMER_DST_NET)) {
+		ret = build_network_session_path(summary->path, sizeof(summary->path), session);
+	} else {
+		ret = snprintf(summary->path,
+			       sizeof(summary->path),
+			       "%s",
+			       session->consumer->dst.session_root_path);
+	}
+	if (ret < 0) {
+		PERROR("snprintf session path");
+		free(summary);
+		return;
+	}
+
+	strncpy(summary->name, session->name, NAME_MAX);
+	summary->name[NAME_MAX - 1] = '\0';
+	summary->active = session->active;
+	summary->snapshot_mode = session->snapshot_mode;
+	summary->live_timer = session->live_timer;
+	summary->creation_time = session->creation_time;
+
+	session_publish_summary(session, summary);
+}
+
 void cmd_list_lttng_sessions(struct lttng_session *sessions,
 			     size_t session_count,
 			     uid_t uid,
 			     gid_t gid)
 {
-	int ret;
 	unsigned int i = 0;
 	struct ltt_session *session;
 	struct ltt_session_list *list = session_get_list();
 	struct lttng_session_extended *extended = (typeof(extended)) (&sessions[session_count]);
+	const lttng::urcu::read_lock_guard read_lock;
 
 	DBG("Getting all available session for UID %d GID %d", uid, gid);
 	/*
 	 * Iterate over session list and append data after the control struct in
-	 * the buffer.
+	 * the buffer. The attributes are read from the published summaries to
+	 * avoid contending with the commands holding the session locks.
 	 */
 	cds_list_for_each_entry (session, &list->head, list) {
-		if (!session_get(session)) {
-			continue;
-		}
+		const struct ltt_session_summary *summary;
+
 		/*
 		 * Only list the sessions the user can control.
 		 */
 		if (!session_access_ok(session, uid) || session->destroyed) {
-			session_put(session);
 			continue;
 		}
 
-		struct ltt_kernel_session *ksess = session->kernel_session;
-		struct ltt_ust_session *usess = session->ust_session;
-
-		if (session->consumer->type == CONSUMER_DST_NET ||
-		    (ksess && ksess->consumer->type == CONSUMER_DST_NET) ||
-		    (usess && usess->consumer->type == CONSUMER_DST_NET)) {
-			ret = build_network_session_path(
-				sessions[i].path, sizeof(sessions[i].path), session);
-		} else {
-			ret = snprintf(sessions[i].path,
-				       sizeof(sessions[i].path),
-				       "%s",
-				       session->consumer->dst.session_root_path);
-		}
-		if (ret < 0) {
-			PERROR("snprintf session path");
-			session_put(session);
+		summary = rcu_dereference(session->summary);
+		if (!summary) {
 			continue;
 		}
 
-		strncpy(sessions[i].name, session->name, NAME_MAX);
+		memcpy(sessions[i].path, summary->path, sizeof(sessions[i].path));
+		strncpy(sessions[i].name, summary->name, NAME_MAX);
 		sessions[i].name[NAME_MAX - 1] = '\0';
-		sessions[i].enabled = session->active;
-		sessions[i].snapshot_mode = session->snapshot_mode;
-		sessions[i].live_timer_interval = session->live_timer;
-		extended[i].creation_time.value = (uint64_t) session->creation_time;
+		sessions[i].enabled = summary->active;
+		sessions[i].snapshot_mode = summary->snapshot_mode;
+		sessions[i].live_timer_interval = summary->live_timer;
+		extended[i].creation_time.value = (uint64_t) summary->creation_time;
 		extended[i].creation_time.is_set = 1;
 		i++;
-		session_put(session);
 	}
 }
 
@@ -4433,55 +4782,30 @@ end:
 	return ret;
 }
 
-static enum lttng_error_code
-synchronize_tracer_notifier_register(struct notification_thread_handle *notification_thread,
-				     struct lttng_trigger *trigger,
-				     const struct lttng_credentials *cmd_creds)
+/*
+ * Register the event notifier of a trigger to its tracer. The event notifier
+ * rules of the user space applications are updated by the caller.
+ *
+ * Must be called with the session list lock held.
+ */
+static enum lttng_error_code register_tracer_notifier(struct lttng_trigger *trigger,
+						      const struct lttng_credentials *cmd_creds)
 {
 	enum lttng_error_code ret_code;
 	const struct lttng_condition *condition = lttng_trigger_get_const_condition(trigger);
-	const char *trigger_name;
-	uid_t trigger_owner;
-	enum lttng_trigger_status trigger_status;
 	const enum lttng_domain_type trigger_domain =
 		lttng_trigger_get_underlying_domain_type_restriction(trigger);
 
-	trigger_status = lttng_trigger_get_owner_uid(trigger, &trigger_owner);
-	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
-
 	LTTNG_ASSERT(condition);
 	LTTNG_ASSERT(lttng_condition_get_type(condition) ==
 		     LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES);
 
-	trigger_status = lttng_trigger_get_name(trigger, &trigger_name);
-	trigger_name = trigger_status == LTTNG_TRIGGER_STATUS_OK ? trigger_name : "(anonymous)";
-
-	session_lock_list();
 	switch (trigger_domain) {
 	case LTTNG_DOMAIN_KERNEL:
-	{
 		ret_code = kernel_register_event_notifier(trigger, cmd_creds);
-		if (ret_code != LTTNG_OK) {
-			enum lttng_error_code notif_thread_unregister_ret;
-
-			notif_thread_unregister_ret =
-				notification_thread_command_unregister_trigger(notification_thread,
-									       trigger);
-
-			if (notif_thread_unregister_ret != LTTNG_OK) {
-				/* Return the original error code. */
-				ERR("Failed to unregister trigger from notification thread during error recovery: trigger name = '%s', trigger owner uid = %d, error code = %d",
-				    trigger_name,
-				    (int) trigger_owner,
-				    ret_code);
-			}
-
-			goto end_unlock_session_list;
-		}
 		break;
-	}
 	case LTTNG_DOMAIN_UST:
-		ust_app_global_update_all_event_notifier_rules();
+		ret_code = LTTNG_OK;
 		break;
 	case LTTNG_DOMAIN_JUL:
 	case LTTNG_DOMAIN_LOG4J:
@@ -4494,17 +4818,13 @@ synchronize_tracer_notifier_register(struct notification_thread_handle *notifica
 			agt = agent_create(trigger_domain);
 			if (!agt) {
 				ret_code = LTTNG_ERR_NOMEM;
-				goto end_unlock_session_list;
+				break;
 			}
 
 			agent_add(agt, the_trigger_agents_ht_by_domain);
 		}
 
 		ret_code = (lttng_error_code) trigger_agent_enable(trigger, agt);
-		if (ret_code != LTTNG_OK) {
-			goto end_unlock_session_list;
-		}
-
 		break;
 	}
 	case LTTNG_DOMAIN_NONE:
@@ -4512,17 +4832,64 @@ synchronize_tracer_notifier_register(struct notification_thread_handle *notifica
 		abort();
 	}
 
-	ret_code = LTTNG_OK;
-end_unlock_session_list:
-	session_unlock_list();
 	return ret_code;
 }
 
-enum lttng_error_code cmd_register_trigger(const struct lttng_credentials *cmd_creds,
-					   struct lttng_trigger *trigger,
-					   bool is_trigger_anonymous,
-					   struct notification_thread_handle *notification_thread,
-					   struct lttng_trigger **return_trigger)
+static enum lttng_error_code
+synchronize_tracer_notifier_register(struct notification_thread_handle *notification_thread,
+				     struct lttng_trigger *trigger,
+				     const struct lttng_credentials *cmd_creds)
+{
+	enum lttng_error_code ret_code;
+	const char *trigger_name;
+	uid_t trigger_owner;
+	enum lttng_trigger_status trigger_status;
+	const enum lttng_domain_type trigger_domain =
+		lttng_trigger_get_underlying_domain_type_restriction(trigger);
+
+	trigger_status = lttng_trigger_get_owner_uid(trigger, &trigger_owner);
+	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
+
+	trigger_status = lttng_trigger_get_name(trigger, &trigger_name);
+	trigger_name = trigger_status == LTTNG_TRIGGER_STATUS_OK ? trigger_name : "(anonymous)";
+
+	session_lock_list();
+	ret_code = register_tracer_notifier(trigger, cmd_creds);
+	if (ret_code != LTTNG_OK) {
+		if (trigger_domain == LTTNG_DOMAIN_KERNEL) {
+			enum lttng_error_code notif_thread_unregister_ret;
+
+			notif_thread_unregister_ret =
+				notification_thread_command_unregister_trigger(notification_thread,
+									       trigger);
+
+			if (notif_thread_unregister_ret != LTTNG_OK) {
+				/* Return the original error code. */
+				ERR("Failed to unregister trigger from notification thread during error recovery: trigger name = '%s', trigger owner uid = %d, error code = %d",
+				    trigger_name,
+				    (int) trigger_owner,
+				    ret_code);
+			}
+		}
+
+		goto end_unlock_session_list;
+	}
+
+	if (trigger_domain == LTTNG_DOMAIN_UST) {
+		ust_app_global_update_all_event_notifier_rules();
+	}
+
+end_unlock_session_list:
+	session_unlock_list();
+	return ret_code;
+}
+
+/*
+ * Validate the credentials of a trigger to register against the command
+ * credentials and generate its bytecode.
+ */
+static enum lttng_error_code prepare_trigger_registration(const struct lttng_credentials *cmd_creds,
+							  struct lttng_trigger *trigger)
 {
 	enum lttng_error_code ret_code;
 	const char *trigger_name;
@@ -4535,11 +4902,6 @@ enum lttng_error_code cmd_register_trigger(const struct lttng_credentials *cmd_c
 	trigger_status = lttng_trigger_get_owner_uid(trigger, &trigger_owner);
 	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
 
-	DBG("Running register trigger command: trigger name = '%s', trigger owner uid = %d, command creds uid = %d",
-	    trigger_name,
-	    (int) trigger_owner,
-	    (int) lttng_credentials_get_uid(cmd_creds));
-
 	/*
 	 * Validate the trigger credentials against the command credentials.
 	 * Only the root user can register a trigger with non-matching
@@ -4551,8 +4913,7 @@ enum lttng_error_code cmd_register_trigger(const struct lttng_credentials *cmd_c
 			    trigger_name,
 			    (int) trigger_owner,
 			    (int) lttng_credentials_get_uid(cmd_creds));
-			ret_code = LTTNG_ERR_INVALID_TRIGGER;
-			goto end;
+			return LTTNG_ERR_INVALID_TRIGGER;
 		}
 	}
 
@@ -4566,6 +4927,35 @@ enum lttng_error_code cmd_register_trigger(const struct lttng_credentials *cmd_c
 		    trigger_name,
 		    (int) trigger_owner,
 		    ret_code);
+	}
+
+	return ret_code;
+}
+
+enum lttng_error_code cmd_register_trigger(const struct lttng_credentials *cmd_creds,
+					   struct lttng_trigger *trigger,
+					   bool is_trigger_anonymous,
+					   struct notification_thread_handle *notification_thread,
+					   struct lttng_trigger **return_trigger)
+{
+	enum lttng_error_code ret_code;
+	const char *trigger_name;
+	uid_t trigger_owner;
+	enum lttng_trigger_status trigger_status;
+
+	trigger_status = lttng_trigger_get_name(trigger, &trigger_name);
+	trigger_name = trigger_status == LTTNG_TRIGGER_STATUS_OK ? trigger_name : "(anonymous)";
+
+	trigger_status = lttng_trigger_get_owner_uid(trigger, &trigger_owner);
+	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
+
+	DBG("Running register trigger command: trigger name = '%s', trigger owner uid = %d, command creds uid = %d",
+	    trigger_name,
+	    (int) trigger_owner,
+	    (int) lttng_credentials_get_uid(cmd_creds));
+
+	ret_code = prepare_trigger_registration(cmd_creds, trigger);
+	if (ret_code != LTTNG_OK) {
 		goto end;
 	}
 
@@ -4621,8 +5011,13 @@ end:
 	return ret_code;
 }
 
-static enum lttng_error_code
-synchronize_tracer_notifier_unregister(const struct lttng_trigger *trigger)
+/*
+ * Unregister the event notifier of a trigger from its tracer. The event
+ * notifier rules of the user space applications are updated by the caller.
+ *
+ * Must be called with the session list lock held.
+ */
+static enum lttng_error_code unregister_tracer_notifier(const struct lttng_trigger *trigger)
 {
 	enum lttng_error_code ret_code;
 	const struct lttng_condition *condition = lttng_trigger_get_const_condition(trigger);
@@ -4633,17 +5028,12 @@ synchronize_tracer_notifier_unregister(const struct lttng_trigger *trigger)
 	LTTNG_ASSERT(lttng_condition_get_type(condition) ==
 		     LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES);
 
-	session_lock_list();
 	switch (trigger_domain) {
 	case LTTNG_DOMAIN_KERNEL:
 		ret_code = kernel_unregister_event_notifier(trigger);
-		if (ret_code != LTTNG_OK) {
-			goto end_unlock_session_list;
-		}
-
 		break;
 	case LTTNG_DOMAIN_UST:
-		ust_app_global_update_all_event_notifier_rules();
+		ret_code = LTTNG_OK;
 		break;
 	case LTTNG_DOMAIN_JUL:
 	case LTTNG_DOMAIN_LOG4J:
@@ -4658,10 +5048,6 @@ synchronize_tracer_notifier_unregister(const struct lttng_trigger *trigger)
 		 */
 		LTTNG_ASSERT(agt);
 		ret_code = (lttng_error_code) trigger_agent_disable(trigger, agt);
-		if (ret_code != LTTNG_OK) {
-			goto end_unlock_session_list;
-		}
-
 		break;
 	}
 	case LTTNG_DOMAIN_NONE:
@@ -4669,9 +5055,21 @@ synchronize_tracer_notifier_unregister(const struct lttng_trigger *trigger)
 		abort();
 	}
 
-	ret_code = LTTNG_OK;
+	return ret_code;
+}
+
+static enum lttng_error_code
+synchronize_tracer_notifier_unregister(const struct lttng_trigger *trigger)
+{
+	enum lttng_error_code ret_code;
+
+	session_lock_list();
+	ret_code = unregister_tracer_notifier(trigger);
+	if (ret_code == LTTNG_OK &&
+	    lttng_trigger_get_underlying_domain_type_restriction(trigger) == LTTNG_DOMAIN_UST) {
+		ust_app_global_update_all_event_notifier_rules();
+	}
 
-end_unlock_session_list:
 	session_unlock_list();
 	return ret_code;
 }
@@ -4764,6 +5162,98 @@ end:
 	return ret_code;
 }
 
+enum lttng_error_code cmd_register_triggers(const struct lttng_credentials *cmd_creds,
+					    struct lttng_triggers *triggers,
+					    struct notification_thread_handle *notification_thread)
+{
+	enum lttng_error_code ret_code;
+	enum lttng_trigger_status trigger_status;
+	unsigned int count, i, synchronized_count;
+	bool has_ust_notifier = false;
+
+	trigger_status = lttng_triggers_get_count(triggers, &count);
+	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
+
+	DBG("Running register triggers command: trigger count = %u, command creds uid = %d",
+	    count,
+	    (int) lttng_credentials_get_uid(cmd_creds));
+
+	for (i = 0; i < count; i++) {
+		ret_code = prepare_trigger_registration(
+			cmd_creds, lttng_triggers_borrow_mutable_at_index(triggers, i));
+		if (ret_code != LTTNG_OK) {
+			goto end;
+		}
+	}
+
+	/*
+	 * The triggers are registered, and their names generated, by a single
+	 * notification thread command. As for a single trigger, the
+	 * notification thread acquires a reference to each of them.
+	 */
+	ret_code = notification_thread_command_register_triggers(notification_thread, triggers);
+	if (ret_code != LTTNG_OK) {
+		DBG("Failed to register triggers to notification thread: trigger count = %u, error code = %d",
+		    count,
+		    ret_code);
+		goto end;
+	}
+
+	/*
+	 * The event notifier rules of the user space applications are only
+	 * updated once, for all the triggers of the set.
+	 */
+	session_lock_list();
+	for (synchronized_count = 0; synchronized_count < count; synchronized_count++) {
+		struct lttng_trigger *trigger =
+			lttng_triggers_borrow_mutable_at_index(triggers, synchronized_count);
+
+		if (!lttng_trigger_needs_tracer_notifier(trigger)) {
+			continue;
+		}
+
+		if (lttng_trigger_get_underlying_domain_type_restriction(trigger) ==
+		    LTTNG_DOMAIN_UST) {
+			has_ust_notifier = true;
+		}
+
+		ret_code = register_tracer_notifier(trigger, cmd_creds);
+		if (ret_code != LTTNG_OK) {
+			ERR("Error registering tracer notifier: %s", lttng_strerror(-ret_code));
+			break;
+		}
+	}
+
+	if (ret_code != LTTNG_OK) {
+		/* Either all the triggers are registered, or none is. */
+		for (i = 0; i < count; i++) {
+			struct lttng_trigger *trigger =
+				lttng_triggers_borrow_mutable_at_index(triggers, i);
+
+			const bool synchronized = i < synchronized_count;
+
+			if (synchronized && lttng_trigger_needs_tracer_notifier(trigger)) {
+				(void) unregister_tracer_notifier(trigger);
+			}
+
+			lttng_trigger_set_as_unregistered(trigger);
+			if (notification_thread_command_unregister_trigger(notification_thread,
+									   trigger) != LTTNG_OK) {
+				ERR("Failed to unregister trigger from notification thread during error recovery: trigger index = %u",
+				    i);
+			}
+		}
+	}
+
+	if (has_ust_notifier) {
+		ust_app_global_update_all_event_notifier_rules();
+	}
+
+	session_unlock_list();
+end:
+	return ret_code;
+}
+
 enum lttng_error_code cmd_list_triggers(struct command_ctx *cmd_ctx,
 					struct notification_thread_handle *notification_thread,
 					struct lttng_triggers **return_triggers)
@@ -4793,20 +5283,22 @@ end:
 	return ret_code;
 }
 
-enum lttng_error_code
-cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
-			const struct lttng_error_query *query,
-			struct lttng_error_query_results **_results,
-			struct notification_thread_handle *notification_thread)
+/*
+ * Get the sessiond-side version of the trigger targeted by an error query,
+ * validating the credentials of the command.
+ */
+static enum lttng_error_code
+get_error_query_target(const struct lttng_credentials *cmd_creds,
+		       const struct lttng_error_query *query,
+		       struct notification_thread_handle *notification_thread,
+		       struct lttng_trigger **_matching_trigger)
 {
 	enum lttng_error_code ret_code;
 	const struct lttng_trigger *query_target_trigger;
-	const struct lttng_action *query_target_action = nullptr;
 	struct lttng_trigger *matching_trigger = nullptr;
 	const char *trigger_name;
 	uid_t trigger_owner;
 	enum lttng_trigger_status trigger_status;
-	struct lttng_error_query_results *results = nullptr;
 
 	switch (lttng_error_query_get_target_type(query)) {
 	case LTTNG_ERROR_QUERY_TARGET_TYPE_TRIGGER:
@@ -4830,26 +5322,11 @@ cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
 		goto end;
 	}
 
-	/* No longer needed. */
-	query_target_trigger = nullptr;
-
-	if (lttng_error_query_get_target_type(query) == LTTNG_ERROR_QUERY_TARGET_TYPE_ACTION) {
-		/* Get the sessiond-side version of the target action. */
-		query_target_action =
-			lttng_error_query_action_borrow_action_target(query, matching_trigger);
-	}
-
 	trigger_status = lttng_trigger_get_name(matching_trigger, &trigger_name);
 	trigger_name = trigger_status == LTTNG_TRIGGER_STATUS_OK ? trigger_name : "(anonymous)";
 	trigger_status = lttng_trigger_get_owner_uid(matching_trigger, &trigger_owner);
 	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
 
-	results = lttng_error_query_results_create();
-	if (!results) {
-		ret_code = LTTNG_ERR_NOMEM;
-		goto end;
-	}
-
 	DBG("Running \"execute error query\" command: trigger name = '%s', trigger owner uid = %d, command creds uid = %d",
 	    trigger_name,
 	    (int) trigger_owner,
@@ -4872,6 +5349,35 @@ cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
 		}
 	}
 
+	*_matching_trigger = matching_trigger;
+	matching_trigger = nullptr;
+	ret_code = LTTNG_OK;
+end:
+	lttng_trigger_put(matching_trigger);
+	return ret_code;
+}
+
+/*
+ * Execute an error query on the sessiond-side version of its target trigger.
+ *
+ * `discarded_tracer_messages_count`, if not null, is the error count of the
+ * event notifier of the trigger of a condition query.
+ */
+static enum lttng_error_code
+execute_error_query(const struct lttng_error_query *query,
+		    struct lttng_trigger *matching_trigger,
+		    const uint64_t *discarded_tracer_messages_count,
+		    struct lttng_error_query_results **_results)
+{
+	enum lttng_error_code ret_code;
+	enum lttng_trigger_status trigger_status;
+	struct lttng_error_query_results *results = lttng_error_query_results_create();
+
+	if (!results) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
 	switch (lttng_error_query_get_target_type(query)) {
 	case LTTNG_ERROR_QUERY_TARGET_TYPE_TRIGGER:
 		trigger_status = lttng_trigger_add_error_results(matching_trigger, results);
@@ -4887,7 +5393,9 @@ cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
 		break;
 	case LTTNG_ERROR_QUERY_TARGET_TYPE_CONDITION:
 	{
-		trigger_status =
+		trigger_status = discarded_tracer_messages_count ?
+			lttng_trigger_condition_add_error_results_with_count(
+				matching_trigger, *discarded_tracer_messages_count, results) :
 			lttng_trigger_condition_add_error_results(matching_trigger, results);
 
 		switch (trigger_status) {
@@ -4902,6 +5410,9 @@ cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
 	}
 	case LTTNG_ERROR_QUERY_TARGET_TYPE_ACTION:
 	{
+		/* Get the sessiond-side version of the target action. */
+		const struct lttng_action *query_target_action =
+			lttng_error_query_action_borrow_action_target(query, matching_trigger);
 		const enum lttng_action_status action_status =
 			lttng_action_add_error_query_results(query_target_action, results);
 
@@ -4924,11 +5435,121 @@ cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
 	results = nullptr;
 	ret_code = LTTNG_OK;
 end:
-	lttng_trigger_put(matching_trigger);
 	lttng_error_query_results_destroy(results);
 	return ret_code;
 }
 
+enum lttng_error_code
+cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
+			const struct lttng_error_query *query,
+			struct lttng_error_query_results **_results,
+			struct notification_thread_handle *notification_thread)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_trigger *matching_trigger = nullptr;
+
+	ret_code = get_error_query_target(cmd_creds, query, notification_thread, &matching_trigger);
+	if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
+	ret_code = execute_error_query(query, matching_trigger, nullptr, _results);
+end:
+	lttng_trigger_put(matching_trigger);
+	return ret_code;
+}
+
+static bool error_query_needs_tracer_error_count(const struct lttng_error_query *query,
+						 const struct lttng_trigger *matching_trigger)
+{
+	const enum lttng_error_query_target_type target_type =
+		lttng_error_query_get_target_type(query);
+
+	return target_type == LTTNG_ERROR_QUERY_TARGET_TYPE_CONDITION &&
+		lttng_trigger_needs_tracer_notifier(matching_trigger);
+}
+
+enum lttng_error_code
+cmd_execute_error_queries(const struct lttng_credentials *cmd_creds,
+			  const struct lttng_error_query *const *queries,
+			  unsigned int count,
+			  struct lttng_error_query_results **results,
+			  struct notification_thread_handle *notification_thread)
+{
+	enum lttng_error_code ret_code;
+	enum event_notifier_error_accounting_status error_accounting_status;
+	unsigned int i, counted_count = 0, executed_count = 0;
+	struct lttng_trigger **matching_triggers = calloc<lttng_trigger *>(count);
+	const struct lttng_trigger **counted_triggers = calloc<const lttng_trigger *>(count);
+	uint64_t *counts = calloc<uint64_t>(count);
+
+	if (!matching_triggers || !counted_triggers || !counts) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret_code = get_error_query_target(
+			cmd_creds, queries[i], notification_thread, &matching_triggers[i]);
+		if (ret_code != LTTNG_OK) {
+			goto end;
+		}
+
+		if (error_query_needs_tracer_error_count(queries[i], matching_triggers[i])) {
+			counted_triggers[counted_count++] = matching_triggers[i];
+		}
+	}
+
+	/* Read the error counters of all the condition queries at once. */
+	if (counted_count > 0) {
+		error_accounting_status = event_notifier_error_accounting_get_counts(
+			counted_triggers, counted_count, counts);
+		if (error_accounting_status != EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK) {
+			ERR("Failed to retrieve tracer discarded messages count of triggers: trigger count = %u",
+			    counted_count);
+			ret_code = LTTNG_ERR_UNK;
+			goto end;
+		}
+	}
+
+	counted_count = 0;
+	for (executed_count = 0; executed_count < count; executed_count++) {
+		const uint64_t *count_ptr = nullptr;
+
+		if (error_query_needs_tracer_error_count(queries[executed_count],
+							 matching_triggers[executed_count])) {
+			count_ptr = &counts[counted_count++];
+		}
+
+		ret_code = execute_error_query(queries[executed_count],
+					       matching_triggers[executed_count],
+					       count_ptr,
+					       &results[executed_count]);
+		if (ret_code != LTTNG_OK) {
+			break;
+		}
+	}
+
+	if (ret_code != LTTNG_OK) {
+		for (i = 0; i < executed_count; i++) {
+			lttng_error_query_results_destroy(results[i]);
+			results[i] = nullptr;
+		}
+	}
+
+end:
+	if (matching_triggers) {
+		for (i = 0; i < count; i++) {
+			lttng_trigger_put(matching_triggers[i]);
+		}
+	}
+
+	free(matching_triggers);
+	free(counted_triggers);
+	free(counts);
+	return ret_code;
+}
+
 /*
  * Send relayd sockets from snapshot output to consumer. Ignore request if the
  * snapshot output is *not* set with a remote destination.
@@ -5143,6 +5764,9 @@ static enum lttng_error_code snapshot_record(struct ltt_session *session,
 	struct consumer_output *original_kernel_consumer_output = nullptr;
 	struct consumer_output *snapshot_ust_consumer_output = nullptr;
 	struct consumer_output *snapshot_kernel_consumer_output = nullptr;
+	uint64_t phase_begin_ns = lttng_monotonic_now_ns();
+	uint64_t setup_duration_us = 0, create_chunk_duration_us = 0;
+	uint64_t kernel_record_duration_us = 0, ust_record_duration_us = 0;
 
 	ret = snprintf(snapshot_chunk_name,
 		       sizeof(snapshot_chunk_name),
@@ -5169,6 +5793,8 @@ static enum lttng_error_code snapshot_record(struct ltt_session *session,
 		original_kernel_consumer_output = session->kernel_session->consumer;
 		snapshot_kernel_consumer_output = consumer_copy_output(snapshot_output->consumer);
 		strcpy(snapshot_kernel_consumer_output->chunk_path, snapshot_chunk_name);
+		snapshot_kernel_consumer_output->snapshot_incremental =
+			snapshot_output->incremental;
 
 		/* Copy the original domain subdir. */
 		strcpy(snapshot_kernel_consumer_output->domain_subdir,
@@ -5192,6 +5818,7 @@ static enum lttng_error_code snapshot_record(struct ltt_session *session,
 		original_ust_consumer_output = session->ust_session->consumer;
 		snapshot_ust_consumer_output = consumer_copy_output(snapshot_output->consumer);
 		strcpy(snapshot_ust_consumer_output->chunk_path, snapshot_chunk_name);
+		snapshot_ust_consumer_output->snapshot_incremental = snapshot_output->incremental;
 
 		/* Copy the original domain subdir. */
 		strcpy(snapshot_ust_consumer_output->domain_subdir,
@@ -5212,6 +5839,7 @@ static enum lttng_error_code snapshot_record(struct ltt_session *session,
 		session->ust_session->consumer = snapshot_ust_consumer_output;
 	}
 
+	setup_duration_us = end_command_phase(&phase_begin_ns);
 	snapshot_trace_chunk = session_create_new_trace_chunk(
 		session,
 		snapshot_kernel_consumer_output ?: snapshot_ust_consumer_output,
@@ -5241,6 +5869,7 @@ static enum lttng_error_code snapshot_record(struct ltt_session *session,
 		goto error_close_trace_chunk;
 	}
 
+	create_chunk_duration_us = end_command_phase(&phase_begin_ns);
 	if (session->kernel_session) {
 		ret_code = record_kernel_snapshot(session->kernel_session,
 						  snapshot_kernel_consumer_output,
@@ -5251,6 +5880,7 @@ static enum lttng_error_code snapshot_record(struct ltt_session *session,
 		}
 	}
 
+	kernel_record_duration_us = end_command_phase(&phase_begin_ns);
 	if (session->ust_session) {
 		ret_code = record_ust_snapshot(session->ust_session,
 					       snapshot_ust_consumer_output,
@@ -5261,6 +5891,7 @@ static enum lttng_error_code snapshot_record(struct ltt_session *session,
 		}
 	}
 
+	ust_record_duration_us = end_command_phase(&phase_begin_ns);
 error_close_trace_chunk:
 	if (session_set_trace_chunk(session, nullptr, &snapshot_trace_chunk)) {
 		ERR("Failed to release the current trace chunk of session \"%s\"", session->name);
@@ -5281,6 +5912,103 @@ error_close_trace_chunk:
 
 	lttng_trace_chunk_put(snapshot_trace_chunk);
 	snapshot_trace_chunk = nullptr;
+	DBG("Snapshot \"%s\" of session \"%s\" phase durations: setup outputs = %" PRIu64
+	    " us, create trace chunk = %" PRIu64 " us, record kernel = %" PRIu64
+	    " us, record user space = %" PRIu64 " us, close trace chunk = %" PRIu64 " us",
+	    snapshot_output->name,
+	    session->name,
+	    setup_duration_us,
+	    create_chunk_duration_us,
+	    kernel_record_duration_us,
+	    ust_record_duration_us,
+	    end_command_phase(&phase_begin_ns));
+error:
+	if (original_ust_consumer_output) {
+		session->ust_session->consumer = original_ust_consumer_output;
+	}
+	if (original_kernel_consumer_output) {
+		session->kernel_session->consumer = original_kernel_consumer_output;
+	}
+	consumer_output_put(snapshot_ust_consumer_output);
+	consumer_output_put(snapshot_kernel_consumer_output);
+	return ret_code;
+}
+
+/*
+ * Record a snapshot of a session to a file descriptor rather than to a
+ * snapshot output. No trace chunk is created: the consumers write the packets
+ * of the streams as records to the file descriptor.
+ */
+static enum lttng_error_code snapshot_record_to_fd(struct ltt_session *session,
+						   uint64_t max_size,
+						   bool incremental,
+						   int output_fd)
+{
+	int64_t nb_packets_per_stream;
+	enum lttng_error_code ret_code = LTTNG_OK;
+	struct consumer_output *original_ust_consumer_output = nullptr;
+	struct consumer_output *original_kernel_consumer_output = nullptr;
+	struct consumer_output *snapshot_ust_consumer_output = nullptr;
+	struct consumer_output *snapshot_kernel_consumer_output = nullptr;
+
+	DBG("Recording snapshot of session \"%s\" to fd %d", session->name, output_fd);
+	if (!session->kernel_session && !session->ust_session) {
+		ERR("Failed to record snapshot as no channels exist");
+		ret_code = LTTNG_ERR_NO_CHANNEL;
+		goto error;
+	}
+
+	if (max_size == (uint64_t) -1ULL) {
+		max_size = 0;
+	}
+
+	nb_packets_per_stream = get_session_nb_packets_per_stream(session, max_size);
+	if (nb_packets_per_stream < 0) {
+		ret_code = LTTNG_ERR_MAX_SIZE_INVALID;
+		goto error;
+	}
+
+	if (session->kernel_session) {
+		original_kernel_consumer_output = session->kernel_session->consumer;
+		snapshot_kernel_consumer_output =
+			consumer_copy_output(original_kernel_consumer_output);
+		if (!snapshot_kernel_consumer_output) {
+			ret_code = LTTNG_ERR_NOMEM;
+			goto error;
+		}
+
+		snapshot_kernel_consumer_output->snapshot_fd = output_fd;
+		snapshot_kernel_consumer_output->snapshot_incremental = incremental;
+		session->kernel_session->consumer = snapshot_kernel_consumer_output;
+		ret_code = record_kernel_snapshot(session->kernel_session,
+						  snapshot_kernel_consumer_output,
+						  session,
+						  nb_packets_per_stream);
+		if (ret_code != LTTNG_OK) {
+			goto error;
+		}
+	}
+
+	if (session->ust_session) {
+		original_ust_consumer_output = session->ust_session->consumer;
+		snapshot_ust_consumer_output = consumer_copy_output(original_ust_consumer_output);
+		if (!snapshot_ust_consumer_output) {
+			ret_code = LTTNG_ERR_NOMEM;
+			goto error;
+		}
+
+		snapshot_ust_consumer_output->snapshot_fd = output_fd;
+		snapshot_ust_consumer_output->snapshot_incremental = incremental;
+		session->ust_session->consumer = snapshot_ust_consumer_output;
+		ret_code = record_ust_snapshot(session->ust_session,
+					       snapshot_ust_consumer_output,
+					       session,
+					       nb_packets_per_stream);
+		if (ret_code != LTTNG_OK) {
+			goto error;
+		}
+	}
+
 error:
 	if (original_ust_consumer_output) {
 		session->ust_session->consumer = original_ust_consumer_output;
@@ -5303,7 +6031,8 @@ error:
  */
 int cmd_snapshot_record(struct ltt_session *session,
 			const struct lttng_snapshot_output *output,
-			int wait __attribute__((unused)))
+			int wait __attribute__((unused)),
+			int output_fd)
 {
 	enum lttng_error_code cmd_ret = LTTNG_OK;
 	int ret;
@@ -5338,8 +6067,21 @@ int cmd_snapshot_record(struct ltt_session *session,
 		goto error;
 	}
 
-	/* Use temporary output for the session. */
-	if (*output->ctrl_url != '\0') {
+	if (output_fd >= 0) {
+		/* The file descriptor replaces the outputs of the session. */
+		if (*output->ctrl_url != '\0' || *output->data_url != '\0') {
+			cmd_ret = LTTNG_ERR_INVALID;
+			goto error;
+		}
+
+		cmd_ret = snapshot_record_to_fd(
+			session, output->max_size, output->incremental, output_fd);
+		if (cmd_ret != LTTNG_OK) {
+			goto error;
+		}
+		snapshot_success = 1;
+	} else if (*output->ctrl_url != '\0') {
+		/* Use temporary output for the session. */
 		tmp_output = snapshot_output_alloc();
 		if (!tmp_output) {
 			cmd_ret = LTTNG_ERR_NOMEM;
@@ -5364,6 +6106,7 @@ int cmd_snapshot_record(struct ltt_session *session,
 		}
 		/* Use the global session count for the temporary snapshot. */
 		tmp_output->nb_snapshot = session->snapshot.nb_snapshot;
+		tmp_output->incremental = output->incremental;
 
 		/* Use the global datetime */
 		memcpy(tmp_output->datetime, datetime, sizeof(datetime));
@@ -5394,6 +6137,7 @@ int cmd_snapshot_record(struct ltt_session *session,
 			}
 
 			output_copy.nb_snapshot = session->snapshot.nb_snapshot;
+			output_copy.incremental = output->incremental;
 			memcpy(output_copy.datetime, datetime, sizeof(datetime));
 
 			/* Use temporary name. */
@@ -5432,6 +6176,28 @@ error:
 /*
  * Command LTTNG_SET_SESSION_SHM_PATH processed by the client thread.
  */
+/*
+ * Check whether the nearest existing directory of a shared memory path, which
+ * is only created with the buffers, is on a hugetlbfs file system.
+ */
+static bool shm_path_is_on_hugetlbfs(const char *shm_path)
+{
+	std::string path(shm_path);
+	struct statfs fs_info;
+
+	while (statfs(path.c_str(), &fs_info) < 0) {
+		const auto last_separator = path.find_last_of('/');
+
+		if (errno != ENOENT || last_separator == std::string::npos || path == "/") {
+			return false;
+		}
+
+		path.resize(last_separator ?: 1);
+	}
+
+	return fs_info.f_type == HUGETLBFS_MAGIC;
+}
+
 int cmd_set_session_shm_path(struct ltt_session *session, const char *shm_path)
 {
 	/* Safety net */
@@ -5444,6 +6210,18 @@ int cmd_set_session_shm_path(struct ltt_session *session, const char *shm_path)
 		return LTTNG_ERR_SESSION_STARTED;
 	}
 
+	/*
+	 * The tracer zero-fills the buffer files with write(), which hugetlbfs
+	 * doesn't support: the channels of the session would fail to be
+	 * created. Huge pages are requested per channel instead.
+	 */
+	if (shm_path_is_on_hugetlbfs(shm_path)) {
+		ERR("Shared memory path of session \"%s\" is on a hugetlbfs file system: shm_path = `%s`",
+		    session->name,
+		    shm_path);
+		return LTTNG_ERR_INVALID;
+	}
+
 	strncpy(session->shm_path, shm_path, sizeof(session->shm_path));
 	session->shm_path[sizeof(session->shm_path) - 1] = '\0';
 
@@ -5465,6 +6243,8 @@ int cmd_rotate_session(struct ltt_session *session,
 {
 	int ret;
 	uint64_t ongoing_rotation_chunk_id;
+	uint64_t phase_begin_ns;
+	uint64_t phase_durations_us[LTTNG_ROTATION_PHASE_COUNT] = {};
 	enum lttng_error_code cmd_ret = LTTNG_OK;
 	struct lttng_trace_chunk *chunk_being_archived = nullptr;
 	struct lttng_trace_chunk *new_trace_chunk = nullptr;
@@ -5473,6 +6253,7 @@ int cmd_rotate_session(struct ltt_session *session,
 	enum lttng_error_code rotation_fail_code = LTTNG_OK;
 
 	LTTNG_ASSERT(session);
+	self_tracepoint(sessiond_rotation_begin, session->id);
 
 	if (!session->has_been_started) {
 		cmd_ret = LTTNG_ERR_START_SESSION_ONCE;
@@ -5533,6 +6314,7 @@ int cmd_rotate_session(struct ltt_session *session,
 		goto end;
 	}
 
+	phase_begin_ns = lttng_monotonic_now_ns();
 	if (session->active) {
 		new_trace_chunk =
 			session_create_new_trace_chunk(session, nullptr, nullptr, nullptr);
@@ -5555,6 +6337,8 @@ int cmd_rotate_session(struct ltt_session *session,
 		goto error;
 	}
 
+	phase_durations_us[LTTNG_ROTATION_PHASE_CREATE_TRACE_CHUNK] =
+		end_command_phase(&phase_begin_ns);
 	if (session->kernel_session) {
 		cmd_ret = kernel_rotate_session(session);
 		if (cmd_ret != LTTNG_OK) {
@@ -5570,6 +6354,8 @@ int cmd_rotate_session(struct ltt_session *session,
 		}
 	}
 
+	phase_durations_us[LTTNG_ROTATION_PHASE_ROTATE_STREAMS] =
+		end_command_phase(&phase_begin_ns);
 	if (!session->active) {
 		session->rotated_after_last_stop = true;
 	}
@@ -5596,11 +6382,25 @@ int cmd_rotate_session(struct ltt_session *session,
 		goto error;
 	}
 
+	phase_durations_us[LTTNG_ROTATION_PHASE_CLOSE_TRACE_CHUNK] =
+		end_command_phase(&phase_begin_ns);
 	if (failed_to_rotate) {
 		cmd_ret = rotation_fail_code;
 		goto error;
 	}
 
+	/* The rotation thread times the wait for the data on completion. */
+	memcpy(session->rotation_phase_durations_us,
+	       phase_durations_us,
+	       sizeof(session->rotation_phase_durations_us));
+	session->rotation_wait_data_begin_ns = phase_begin_ns;
+	DBG("Rotation of session \"%s\" phase durations: create trace chunk = %" PRIu64
+	    " us, rotate streams = %" PRIu64 " us, close trace chunk = %" PRIu64 " us",
+	    session->name,
+	    phase_durations_us[LTTNG_ROTATION_PHASE_CREATE_TRACE_CHUNK],
+	    phase_durations_us[LTTNG_ROTATION_PHASE_ROTATE_STREAMS],
+	    phase_durations_us[LTTNG_ROTATION_PHASE_CLOSE_TRACE_CHUNK]);
+
 	session->quiet_rotation = quiet_rotation;
 	ret = timer_session_rotation_pending_check_start(session, DEFAULT_ROTATE_PENDING_TIMER);
 	if (ret) {
@@ -5627,6 +6427,7 @@ int cmd_rotate_session(struct ltt_session *session,
 	DBG("Cmd rotate session %s, archive_id %" PRIu64 " sent",
 	    session->name,
 	    ongoing_rotation_chunk_id);
+	self_tracepoint(sessiond_rotation_ongoing, session->id, ongoing_rotation_chunk_id);
 end:
 	lttng_trace_chunk_put(new_trace_chunk);
 	lttng_trace_chunk_put(chunk_being_archived);
@@ -5701,6 +6502,9 @@ int cmd_rotate_get_info(struct ltt_session *session,
 		DBG("Reporting that rotation id %" PRIu64 " of session \"%s\" is completed",
 		    rotation_id,
 		    session->name);
+		memcpy(info_return->phase_durations_us,
+		       session->rotation_phase_durations_us,
+		       sizeof(info_return->phase_durations_us));
 
 		switch (session_get_consumer_destination_type(session)) {
 		case CONSUMER_DST_LOCAL:
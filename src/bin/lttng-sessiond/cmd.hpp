@@ -72,6 +72,17 @@ cmd_process_attr_tracker_inclusion_set_remove_value(struct ltt_session *session,
 						    enum lttng_process_attr process_attr,
 						    const struct process_attr_value *value);
 enum lttng_error_code
+cmd_process_attr_tracker_inclusion_set_add_values(struct ltt_session *session,
+						  enum lttng_domain_type domain,
+						  enum lttng_process_attr process_attr,
+						  const struct lttng_process_attr_values *values);
+enum lttng_error_code
+cmd_process_attr_tracker_inclusion_set_remove_values(
+	struct ltt_session *session,
+	enum lttng_domain_type domain,
+	enum lttng_process_attr process_attr,
+	const struct lttng_process_attr_values *values);
+enum lttng_error_code
 cmd_process_attr_tracker_get_inclusion_set(struct ltt_session *session,
 					   enum lttng_domain_type domain,
 					   enum lttng_process_attr process_attr,
@@ -119,6 +130,9 @@ enum lttng_error_code cmd_list_events(enum lttng_domain_type domain,
 enum lttng_error_code cmd_list_channels(enum lttng_domain_type domain,
 					struct ltt_session *session,
 					struct lttng_payload *payload);
+enum lttng_error_code cmd_describe_session(struct ltt_session *session,
+					   struct lttng_payload *payload);
+void cmd_update_session_summary(struct ltt_session *session);
 void cmd_list_lttng_sessions(struct lttng_session *sessions,
 			     size_t session_count,
 			     uid_t uid,
@@ -141,7 +155,8 @@ int cmd_snapshot_del_output(struct ltt_session *session,
 			    const struct lttng_snapshot_output *output);
 int cmd_snapshot_record(struct ltt_session *session,
 			const struct lttng_snapshot_output *output,
-			int wait);
+			int wait,
+			int output_fd);
 
 int cmd_set_session_shm_path(struct ltt_session *session, const char *shm_path);
 int cmd_regenerate_metadata(struct ltt_session *session);
@@ -153,6 +168,14 @@ cmd_register_trigger(const struct lttng_credentials *cmd_creds,
 		     bool is_anonymous_trigger,
 		     struct notification_thread_handle *notification_thread_handle,
 		     struct lttng_trigger **return_trigger);
+/*
+ * Register a set of triggers with generated names: either all of them are
+ * registered, or none is.
+ */
+enum lttng_error_code
+cmd_register_triggers(const struct lttng_credentials *cmd_creds,
+		      struct lttng_triggers *triggers,
+		      struct notification_thread_handle *notification_thread_handle);
 enum lttng_error_code
 cmd_unregister_trigger(const struct lttng_credentials *cmd_creds,
 		       const struct lttng_trigger *trigger,
@@ -168,6 +191,17 @@ cmd_execute_error_query(const struct lttng_credentials *cmd_creds,
 			struct lttng_error_query_results **_results,
 			struct notification_thread_handle *notification_thread);
 
+/*
+ * Execute a set of error queries, `results[i]` being set to the results of
+ * `queries[i]` on success.
+ */
+enum lttng_error_code
+cmd_execute_error_queries(const struct lttng_credentials *cmd_creds,
+			  const struct lttng_error_query *const *queries,
+			  unsigned int count,
+			  struct lttng_error_query_results **results,
+			  struct notification_thread_handle *notification_thread);
+
 int cmd_rotate_session(struct ltt_session *session,
 		       struct lttng_rotate_session_return *rotate_return,
 		       bool quiet_rotation,
@@ -11,6 +11,7 @@
 #include <common/hashtable/utils.hpp>
 
 #include <lttng/condition/buffer-usage-internal.hpp>
+#include <lttng/condition/channel-rate-internal.hpp>
 #include <lttng/condition/condition-internal.hpp>
 #include <lttng/condition/condition.h>
 #include <lttng/condition/event-rule-matches-internal.hpp>
@@ -19,6 +20,9 @@
 #include <lttng/condition/session-rotation-internal.hpp>
 #include <lttng/event-rule/event-rule-internal.hpp>
 
+#include <urcu/arch.h>
+#include <urcu/system.h>
+
 static unsigned long lttng_condition_buffer_usage_hash(const struct lttng_condition *_condition)
 {
 	unsigned long hash;
@@ -49,6 +53,37 @@ static unsigned long lttng_condition_buffer_usage_hash(const struct lttng_condit
 	return hash;
 }
 
+static unsigned long lttng_condition_channel_rate_hash(const struct lttng_condition *_condition)
+{
+	unsigned long hash;
+	unsigned long condition_type;
+	struct lttng_condition_channel_rate *condition;
+
+	condition = lttng::utils::container_of(_condition, &lttng_condition_channel_rate::parent);
+
+	condition_type = (unsigned long) condition->parent.type;
+	hash = hash_key_ulong((void *) condition_type, lttng_ht_seed);
+	if (condition->session_name) {
+		hash ^= hash_key_str(condition->session_name, lttng_ht_seed);
+	}
+	if (condition->channel_name) {
+		hash ^= hash_key_str(condition->channel_name, lttng_ht_seed);
+	}
+	if (condition->domain.set) {
+		hash ^= hash_key_ulong((void *) condition->domain.type, lttng_ht_seed);
+	}
+	if (condition->statistic.set) {
+		hash ^= hash_key_ulong((void *) condition->statistic.value, lttng_ht_seed);
+	}
+	if (condition->threshold_per_second.set) {
+		hash ^= hash_key_u64(&condition->threshold_per_second.value, lttng_ht_seed);
+	}
+	if (condition->window_us.set) {
+		hash ^= hash_key_u64(&condition->window_us.value, lttng_ht_seed);
+	}
+	return hash;
+}
+
 static unsigned long
 lttng_condition_session_consumed_size_hash(const struct lttng_condition *_condition)
 {
@@ -98,17 +133,15 @@ lttng_condition_event_rule_matches_hash(const struct lttng_condition *condition)
 	return hash ^ lttng_event_rule_hash(event_rule);
 }
 
-/*
- * The lttng_condition hashing code is kept in this file (rather than
- * condition.c) since it makes use of GPLv2 code (hashtable utils), which we
- * don't want to link in liblttng-ctl.
- */
-unsigned long lttng_condition_hash(const struct lttng_condition *condition)
+static unsigned long compute_condition_hash(const struct lttng_condition *condition)
 {
 	switch (condition->type) {
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_LOW:
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_HIGH:
 		return lttng_condition_buffer_usage_hash(condition);
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		return lttng_condition_channel_rate_hash(condition);
 	case LTTNG_CONDITION_TYPE_SESSION_CONSUMED_SIZE:
 		return lttng_condition_session_consumed_size_hash(condition);
 	case LTTNG_CONDITION_TYPE_SESSION_ROTATION_ONGOING:
@@ -121,6 +154,33 @@ unsigned long lttng_condition_hash(const struct lttng_condition *condition)
 	}
 }
 
+/*
+ * The lttng_condition hashing code is kept in this file (rather than
+ * condition.c) since it makes use of GPLv2 code (hashtable utils), which we
+ * don't want to link in liblttng-ctl.
+ *
+ * The hash is computed once and cached in the condition, which is then also
+ * used by lttng_condition_is_equal() to skip the comparison of conditions of
+ * different hashes. The threads sharing a condition compute the same hash,
+ * making concurrent caching harmless.
+ */
+unsigned long lttng_condition_hash(const struct lttng_condition *condition)
+{
+	auto *cached_condition = const_cast<struct lttng_condition *>(condition);
+	unsigned long hash;
+
+	if (CMM_LOAD_SHARED(condition->hash_is_set)) {
+		cmm_smp_rmb();
+		return condition->hash;
+	}
+
+	hash = compute_condition_hash(condition);
+	cached_condition->hash = hash;
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(cached_condition->hash_is_set, true);
+	return hash;
+}
+
 struct lttng_condition *lttng_condition_copy(const struct lttng_condition *condition)
 {
 	int ret;
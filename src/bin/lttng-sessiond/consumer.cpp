@@ -520,6 +520,7 @@ struct consumer_output *consumer_create_output(enum consumer_dst_type type)
 	output->enabled = true;
 	output->type = type;
 	output->net_seq_index = (uint64_t) -1ULL;
+	output->snapshot_fd = -1;
 	urcu_ref_init(&output->ref);
 
 	output->socks = lttng_ht_new(0, LTTNG_HT_TYPE_ULONG);
@@ -606,6 +607,8 @@ struct consumer_output *consumer_copy_output(struct consumer_output *src)
 	output->net_seq_index = src->net_seq_index;
 	memcpy(output->domain_subdir, src->domain_subdir, sizeof(output->domain_subdir));
 	output->snapshot = src->snapshot;
+	output->snapshot_fd = src->snapshot_fd;
+	output->snapshot_incremental = src->snapshot_incremental;
 	output->relay_major_version = src->relay_major_version;
 	output->relay_minor_version = src->relay_minor_version;
 	output->relay_allows_clear = src->relay_allows_clear;
@@ -922,6 +925,11 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 					unsigned int monitor,
 					uint32_t ust_app_uid,
 					int64_t blocking_timeout,
+					enum lttng_channel_writeback_policy writeback_policy,
+					uint64_t writeback_window_size,
+					uint32_t drain_max_subbuffers,
+					uint64_t drain_max_bytes,
+					enum lttng_channel_buffer_page_size buffer_page_size,
 					const char *root_shm_path,
 					const char *shm_path,
 					struct lttng_trace_chunk *trace_chunk,
@@ -966,6 +974,11 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 	msg->u.ask_channel.monitor = monitor;
 	msg->u.ask_channel.ust_app_uid = ust_app_uid;
 	msg->u.ask_channel.blocking_timeout = blocking_timeout;
+	msg->u.ask_channel.writeback_policy = (uint8_t) writeback_policy;
+	msg->u.ask_channel.writeback_window_size = writeback_window_size;
+	msg->u.ask_channel.drain_max_subbuffers = drain_max_subbuffers;
+	msg->u.ask_channel.drain_max_bytes = drain_max_bytes;
+	msg->u.ask_channel.buffer_page_size = (uint8_t) buffer_page_size;
 
 	std::copy(uuid.begin(), uuid.end(), msg->u.ask_channel.uuid);
 
@@ -1008,6 +1021,10 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 					unsigned int live_timer_interval,
 					bool is_in_live_session,
 					unsigned int monitor_timer_interval,
+					enum lttng_channel_writeback_policy writeback_policy,
+					uint64_t writeback_window_size,
+					uint32_t drain_max_subbuffers,
+					uint64_t drain_max_bytes,
 					struct lttng_trace_chunk *trace_chunk)
 {
 	LTTNG_ASSERT(msg);
@@ -1038,6 +1055,10 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 	msg->u.channel.live_timer_interval = live_timer_interval;
 	msg->u.channel.is_live = is_in_live_session;
 	msg->u.channel.monitor_timer_interval = monitor_timer_interval;
+	msg->u.channel.writeback_policy = (uint8_t) writeback_policy;
+	msg->u.channel.writeback_window_size = writeback_window_size;
+	msg->u.channel.drain_max_subbuffers = drain_max_subbuffers;
+	msg->u.channel.drain_max_bytes = drain_max_bytes;
 
 	strncpy(msg->u.channel.pathname, pathname, sizeof(msg->u.channel.pathname));
 	msg->u.channel.pathname[sizeof(msg->u.channel.pathname) - 1] = '\0';
@@ -1108,6 +1129,56 @@ error:
 	return ret;
 }
 
+/*
+ * Send the streams of a channel, along with their fds, to the consumer as a
+ * single LTTNG_CONSUMER_ADD_STREAMS command.
+ *
+ * This takes two round trips with the consumer and as few sendmsg() calls as
+ * the SCM_RIGHTS limit allows, rather than two round trips per stream.
+ *
+ * The consumer socket lock must be held by the caller.
+ */
+int consumer_send_streams(struct consumer_socket *sock,
+			  uint64_t channel_key,
+			  const struct lttcomm_consumer_stream_desc *descriptors,
+			  const int *fds,
+			  size_t count)
+{
+	int ret;
+	ssize_t ret_send;
+	struct lttcomm_consumer_msg msg;
+
+	LTTNG_ASSERT(sock);
+	LTTNG_ASSERT(descriptors);
+	LTTNG_ASSERT(fds);
+	LTTNG_ASSERT(count > 0);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_ADD_STREAMS;
+	msg.u.streams.channel_key = channel_key;
+	msg.u.streams.stream_count = count;
+
+	ret = consumer_send_msg(sock, &msg);
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret_send = lttcomm_send_fd_batch_unix_sock(
+		*sock->fd_ptr, descriptors, sizeof(*descriptors), fds, count);
+	if (ret_send < 0) {
+		/* The above call will print a PERROR on error. */
+		DBG("Error when sending the fds of %zu streams on consumer sock %d",
+		    count,
+		    *sock->fd_ptr);
+		ret = -1;
+		goto error;
+	}
+
+	ret = consumer_recv_status_reply(sock);
+error:
+	return ret;
+}
+
 /*
  * Send relayd socket to consumer associated with a session name.
  *
@@ -1215,6 +1286,10 @@ consumer_send_pipe(struct consumer_socket *consumer_sock, enum lttng_consumer_co
 		pipe_name = "channel monitor";
 		command_name = "SET_CHANNEL_MONITOR_PIPE";
 		break;
+	case LTTNG_CONSUMER_SET_ROTATION_EVENT_PIPE:
+		pipe_name = "rotation event";
+		command_name = "SET_ROTATION_EVENT_PIPE";
+		break;
 	default:
 		ERR("Unexpected command received in %s (cmd = %d)", __func__, (int) cmd);
 		abort();
@@ -1249,6 +1324,11 @@ int consumer_send_channel_monitor_pipe(struct consumer_socket *consumer_sock, in
 	return consumer_send_pipe(consumer_sock, LTTNG_CONSUMER_SET_CHANNEL_MONITOR_PIPE, pipe);
 }
 
+int consumer_send_rotation_event_pipe(struct consumer_socket *consumer_sock, int pipe)
+{
+	return consumer_send_pipe(consumer_sock, LTTNG_CONSUMER_SET_ROTATION_EVENT_PIPE, pipe);
+}
+
 /*
  * Ask the consumer if the data is pending for the specific session id.
  * Returns 1 if data is pending, 0 otherwise, or < 0 on error.
@@ -1518,8 +1598,12 @@ enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 	msg.u.snapshot_channel.key = key;
 	msg.u.snapshot_channel.nb_packets_per_stream = nb_packets_per_stream;
 	msg.u.snapshot_channel.metadata = metadata;
+	msg.u.snapshot_channel.incremental = output->snapshot_incremental;
 
-	if (output->type == CONSUMER_DST_NET) {
+	if (output->snapshot_fd >= 0) {
+		msg.u.snapshot_channel.relayd_id = (uint64_t) -1ULL;
+		msg.u.snapshot_channel.use_fd_output = 1;
+	} else if (output->type == CONSUMER_DST_NET) {
 		msg.u.snapshot_channel.relayd_id = output->net_seq_index;
 		msg.u.snapshot_channel.use_relayd = 1;
 	} else {
@@ -1540,6 +1624,13 @@ enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 	health_code_update();
 	pthread_mutex_lock(socket->lock);
 	ret = consumer_send_msg(socket, &msg);
+	if (ret >= 0 && output->snapshot_fd >= 0) {
+		/* The consumer acknowledged the command and now expects the fd. */
+		ret = consumer_send_fds(socket, &output->snapshot_fd, 1);
+		if (ret >= 0) {
+			ret = consumer_recv_status_reply(socket);
+		}
+	}
 	pthread_mutex_unlock(socket->lock);
 	if (ret < 0) {
 		switch (-ret) {
@@ -1679,6 +1770,79 @@ end:
 	return ret;
 }
 
+/*
+ * Ask the consumers the consumption latency and size histograms of a channel.
+ * The histograms of all consumers are summed.
+ */
+int consumer_get_consumption_stats(uint64_t session_id,
+				   uint64_t channel_key,
+				   struct consumer_output *consumer,
+				   struct lttcomm_consumer_channel_consumption_stats *stats)
+{
+	int ret;
+	struct consumer_socket *socket;
+	struct lttng_ht_iter iter;
+	struct lttcomm_consumer_msg msg;
+
+	LTTNG_ASSERT(consumer);
+	LTTNG_ASSERT(stats);
+
+	DBG3("Consumer consumption stats id %" PRIu64, session_id);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_CHANNEL_CONSUMPTION_STATS;
+	msg.u.consumption_stats.session_id = session_id;
+	msg.u.consumption_stats.channel_key = channel_key;
+
+	memset(stats, 0, sizeof(*stats));
+
+	/* Send command for each consumer. */
+	{
+		lttng::urcu::read_lock_guard read_lock;
+
+		cds_lfht_for_each_entry (consumer->socks->ht, &iter.iter, socket, node.node) {
+			struct lttcomm_consumer_channel_consumption_stats consumer_stats;
+			unsigned int i;
+
+			pthread_mutex_lock(socket->lock);
+			ret = consumer_socket_send(socket, &msg, sizeof(msg));
+			if (ret < 0) {
+				pthread_mutex_unlock(socket->lock);
+				goto end;
+			}
+
+			/*
+			 * No need for a recv reply status because the answer to the
+			 * command is the reply status message.
+			 */
+			ret = consumer_socket_recv(socket, &consumer_stats, sizeof(consumer_stats));
+			if (ret < 0) {
+				ERR("get consumption stats");
+				pthread_mutex_unlock(socket->lock);
+				goto end;
+			}
+			pthread_mutex_unlock(socket->lock);
+
+			for (i = 0; i < LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT; i++) {
+				stats->latency_histogram[i] += consumer_stats.latency_histogram[i];
+				stats->size_histogram[i] += consumer_stats.size_histogram[i];
+			}
+
+			stats->relayd_spilled_bytes += consumer_stats.relayd_spilled_bytes;
+
+			/* Only the kernel consumer splices, report the size it uses. */
+			if (consumer_stats.splice_pipe_size > stats->splice_pipe_size) {
+				stats->splice_pipe_size = consumer_stats.splice_pipe_size;
+			}
+		}
+	}
+
+	ret = 0;
+
+end:
+	return ret;
+}
+
 /*
  * Ask the consumer to rotate a channel.
  *
@@ -1756,18 +1920,21 @@ error_socket:
 	return ret;
 }
 
-int consumer_clear_channel(struct consumer_socket *socket, uint64_t key)
+int consumer_clear_channel(struct consumer_socket *socket, uint64_t key, bool truncate_output)
 {
 	int ret;
 	struct lttcomm_consumer_msg msg;
 
 	LTTNG_ASSERT(socket);
 
-	DBG("Consumer clear channel %" PRIu64, key);
+	DBG("Consumer clear channel %" PRIu64 ", truncate output = %s",
+	    key,
+	    truncate_output ? "true" : "false");
 
 	memset(&msg, 0, sizeof(msg));
 	msg.cmd_type = LTTNG_CONSUMER_CLEAR_CHANNEL;
 	msg.u.clear_channel.key = key;
+	msg.u.clear_channel.truncate_output = truncate_output;
 
 	health_code_update();
 
@@ -95,6 +95,11 @@ struct consumer_data {
 	 * consumer.
 	 */
 	int channel_monitor_pipe = -1;
+	/*
+	 * Write-end of the rotation event pipe, shared by the consumers
+	 * and owned by the main thread, to be passed to the consumer.
+	 */
+	int rotation_event_pipe = -1;
 	/*
 	 * The metadata socket object is handled differently and only created
 	 * locally in this object thus it's the only reference available in the
@@ -182,6 +187,18 @@ struct consumer_output {
 	/* Tell if this output is used for snapshot. */
 	unsigned int snapshot:1;
 
+	/*
+	 * File descriptor receiving the snapshot recorded through this output
+	 * in place of its destination; -1 otherwise. Not owned by the output.
+	 */
+	int snapshot_fd;
+
+	/*
+	 * Only record the packets of the data streams produced since the
+	 * previous snapshot recorded through any output.
+	 */
+	bool snapshot_incremental;
+
 	union {
 		char session_root_path[LTTNG_PATH_MAX];
 		struct consumer_net net;
@@ -220,6 +237,11 @@ int consumer_send_stream(struct consumer_socket *sock,
 			 struct lttcomm_consumer_msg *msg,
 			 const int *fds,
 			 size_t nb_fd);
+int consumer_send_streams(struct consumer_socket *sock,
+			  uint64_t channel_key,
+			  const struct lttcomm_consumer_stream_desc *descriptors,
+			  const int *fds,
+			  size_t count);
 int consumer_send_channel(struct consumer_socket *sock, struct lttcomm_consumer_msg *msg);
 int consumer_send_relayd_socket(struct consumer_socket *consumer_sock,
 				struct lttcomm_relayd_sock *rsock,
@@ -234,6 +256,7 @@ int consumer_send_relayd_socket(struct consumer_socket *consumer_sock,
 				time_t session_creation_time,
 				bool session_name_contains_creation_time);
 int consumer_send_channel_monitor_pipe(struct consumer_socket *consumer_sock, int pipe);
+int consumer_send_rotation_event_pipe(struct consumer_socket *consumer_sock, int pipe);
 int consumer_send_destroy_relayd(struct consumer_socket *sock, struct consumer_output *consumer);
 int consumer_recv_status_reply(struct consumer_socket *sock);
 int consumer_recv_status_channel(struct consumer_socket *sock,
@@ -266,6 +289,11 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 					unsigned int monitor,
 					uint32_t ust_app_uid,
 					int64_t blocking_timeout,
+					enum lttng_channel_writeback_policy writeback_policy,
+					uint64_t writeback_window_size,
+					uint32_t drain_max_subbuffers,
+					uint64_t drain_max_bytes,
+					enum lttng_channel_buffer_page_size buffer_page_size,
 					const char *root_shm_path,
 					const char *shm_path,
 					struct lttng_trace_chunk *trace_chunk,
@@ -293,6 +321,10 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 					unsigned int live_timer_interval,
 					bool is_in_live_session,
 					unsigned int monitor_timer_interval,
+					enum lttng_channel_writeback_policy writeback_policy,
+					uint64_t writeback_window_size,
+					uint32_t drain_max_subbuffers,
+					uint64_t drain_max_bytes,
 					struct lttng_trace_chunk *trace_chunk);
 int consumer_is_data_pending(uint64_t session_id, struct consumer_output *consumer);
 int consumer_close_metadata(struct consumer_socket *socket, uint64_t metadata_key);
@@ -313,6 +345,10 @@ int consumer_get_lost_packets(uint64_t session_id,
 			      uint64_t channel_key,
 			      struct consumer_output *consumer,
 			      uint64_t *lost);
+int consumer_get_consumption_stats(uint64_t session_id,
+				   uint64_t channel_key,
+				   struct consumer_output *consumer,
+				   struct lttcomm_consumer_channel_consumption_stats *stats);
 
 /* Snapshot command. */
 enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
@@ -351,6 +387,6 @@ char *setup_channel_trace_path(struct consumer_output *consumer,
 			       size_t *consumer_path_offset);
 
 /* Clear command */
-int consumer_clear_channel(struct consumer_socket *socket, uint64_t key);
+int consumer_clear_channel(struct consumer_socket *socket, uint64_t key, bool truncate_output);
 
 #endif /* _CONSUMER_H */
@@ -12,54 +12,254 @@
 #include <common/exception.hpp>
 #include <common/format.hpp>
 
-#include <vendor/nlohmann/json.hpp>
-
 #include <algorithm>
+#include <iterator>
+#include <string.h>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace lsc = lttng::sessiond::ctf2;
 namespace lst = lttng::sessiond::trace;
 
-namespace json = nlohmann;
-
 namespace {
 const unsigned int spaces_per_indent = 2;
 const std::string record_separator = "\x1e";
 
-json::json make_json_fragment(const char *type)
-{
-	return { { "type", type } };
-}
+/*
+ * Serializes JSON values to the end of a string as they are produced, without
+ * building a document first.
+ *
+ * The layout is the one of nlohmann::json::dump(spaces_per_indent), except that
+ * the members of an object are serialized in the order in which they are
+ * written.
+ */
+class json_writer {
+public:
+	explicit json_writer(std::string& output) : _output(output)
+	{
+	}
 
-json::json to_json(const lst::field_location& location)
-{
-	json::json location_array;
+	void begin_object()
+	{
+		_begin_container('{');
+	}
+
+	void end_object()
+	{
+		_end_container('}');
+	}
+
+	void begin_array()
+	{
+		_begin_container('[');
+	}
+
+	void end_array()
+	{
+		_end_container(']');
+	}
+
+	/* The next value written is the value of the member `name`. */
+	void key(const char *name)
+	{
+		_begin_value();
+		_append_string(name, strlen(name));
+		_output.append(": ");
+		_after_key = true;
+	}
+
+	void key(const std::string& name)
+	{
+		_begin_value();
+		_append_string(name.data(), name.size());
+		_output.append(": ");
+		_after_key = true;
+	}
+
+	void value(const char *string)
+	{
+		_begin_value();
+		_append_string(string, strlen(string));
+	}
+
+	void value(const std::string& string)
+	{
+		_begin_value();
+		_append_string(string.data(), string.size());
+	}
+
+	template <class IntegerType,
+		  typename std::enable_if<std::is_integral<IntegerType>::value, int>::type = 0>
+	void value(IntegerType integer)
+	{
+		_begin_value();
+		fmt::format_to(std::back_inserter(_output), "{}", integer);
+	}
+
+	template <class ValueType>
+	void member(const char *name, const ValueType& member_value)
+	{
+		key(name);
+		value(member_value);
+	}
+
+private:
+	void _begin_value()
+	{
+		if (_after_key) {
+			_after_key = false;
+			return;
+		}
+
+		if (_depth == 0) {
+			return;
+		}
+
+		if (!_first_in_container) {
+			_output.push_back(',');
+		}
+
+		_first_in_container = false;
+		_append_new_line();
+	}
+
+	void _begin_container(char opening)
+	{
+		_begin_value();
+		_output.push_back(opening);
+		_depth++;
+		_first_in_container = true;
+	}
+
+	void _end_container(char closing)
+	{
+		LTTNG_ASSERT(_depth > 0);
+
+		_depth--;
+		/* Empty containers are serialized on a single line. */
+		if (!_first_in_container) {
+			_append_new_line();
+		}
+
+		_output.push_back(closing);
+		_first_in_container = false;
+	}
+
+	void _append_new_line()
+	{
+		_output.push_back('\n');
+		_output.append(_depth * spaces_per_indent, ' ');
+	}
+
+	void _append_string(const char *string, std::size_t length)
+	{
+		static const char hex_digits[] = "0123456789abcdef";
+		std::size_t unescaped_begin = 0;
+
+		_output.push_back('"');
+		for (std::size_t i = 0; i < length; i++) {
+			const auto c = (unsigned char) string[i];
+			const char *escape_sequence;
+
+			switch (c) {
+			case '"':
+				escape_sequence = "\\\"";
+				break;
+			case '\\':
+				escape_sequence = "\\\\";
+				break;
+			case '\b':
+				escape_sequence = "\\b";
+				break;
+			case '\f':
+				escape_sequence = "\\f";
+				break;
+			case '\n':
+				escape_sequence = "\\n";
+				break;
+			case '\r':
+				escape_sequence = "\\r";
+				break;
+			case '\t':
+				escape_sequence = "\\t";
+				break;
+			default:
+				if (c >= 0x20) {
+					/* UTF-8 sequences are copied as is. */
+					continue;
+				}
+
+				escape_sequence = nullptr;
+				break;
+			}
+
+			_output.append(string + unescaped_begin, i - unescaped_begin);
+			unescaped_begin = i + 1;
+			if (escape_sequence) {
+				_output.append(escape_sequence);
+			} else {
+				/* Other control characters. */
+				_output.append("\\u00");
+				_output.push_back(hex_digits[c >> 4]);
+				_output.push_back(hex_digits[c & 0xf]);
+			}
+		}
+
+		_output.append(string + unescaped_begin, length - unescaped_begin);
+		_output.push_back('"');
+	}
+
+	std::string& _output;
+	unsigned int _depth = 0;
+	bool _first_in_container = false;
+	bool _after_key = false;
+};
 
-	switch (location.root_) {
+const char *get_root_name(lst::field_location::root root)
+{
+	switch (root) {
 	case lst::field_location::root::PACKET_HEADER:
-		location_array.push_back("packet-header");
-		break;
+		return "packet-header";
 	case lst::field_location::root::PACKET_CONTEXT:
-		location_array.push_back("packet-context");
-		break;
+		return "packet-context";
 	case lst::field_location::root::EVENT_RECORD_HEADER:
-		location_array.push_back("event-record-header");
-		break;
+		return "event-record-header";
 	case lst::field_location::root::EVENT_RECORD_COMMON_CONTEXT:
-		location_array.push_back("event-record-common-context");
-		break;
+		return "event-record-common-context";
 	case lst::field_location::root::EVENT_RECORD_SPECIFIC_CONTEXT:
-		location_array.push_back("event-record-specific-context");
-		break;
+		return "event-record-specific-context";
 	case lst::field_location::root::EVENT_RECORD_PAYLOAD:
-		location_array.push_back("event-record-payload");
-		break;
+		return "event-record-payload";
+	default:
+		abort();
+	}
+}
+
+void write_field_location(json_writer& writer, const lst::field_location& location)
+{
+	writer.begin_array();
+	writer.value(get_root_name(location.root_));
+	for (const auto& element : location.elements_) {
+		writer.value(element);
+	}
+
+	writer.end_array();
+}
+
+void write_uuid(json_writer& writer, const lttng_uuid& uuid)
+{
+	writer.begin_array();
+	for (const auto byte : uuid) {
+		writer.value(byte);
 	}
 
-	std::copy(location.elements_.begin(),
-		  location.elements_.end(),
-		  std::back_inserter(location_array));
-	return location_array;
+	writer.end_array();
+}
+
+const char *get_byte_order_name(lst::byte_order byte_order)
+{
+	return byte_order == lst::byte_order::BIG_ENDIAN_ ? "big-endian" : "little-endian";
 }
 
 const char *get_role_name(lst::integer_type::role role)
@@ -103,8 +303,9 @@ const char *get_role_name(lst::static_length_blob_type::role role)
 namespace ctf2 {
 class trace_environment_visitor : public lst::trace_class_environment_visitor {
 public:
-	trace_environment_visitor() = default; /* NOLINT clang-tidy 14 identifies this as a move
-						  constructor. */
+	explicit trace_environment_visitor(json_writer& writer) : _writer(writer)
+	{
+	}
 
 	void visit(const lst::environment_field<int64_t>& field) override
 	{
@@ -116,121 +317,125 @@ public:
 		_visit(field);
 	}
 
-	/* Only call once. */
-	json::json move_fragment()
-	{
-		return std::move(_environment);
-	}
-
 private:
 	template <class FieldType>
 	void _visit(const FieldType& field)
 	{
-		_environment[field.name] = field.value;
+		_writer.member(field.name, field.value);
 	}
 
-	json::json _environment;
+	json_writer& _writer;
 };
 
 class field_visitor : public lttng::sessiond::trace::field_visitor,
 		      public lttng::sessiond::trace::type_visitor {
 public:
-	field_visitor() = default; /* NOLINT clang-tidy 14 identifies this as a move constructor. */
-
-	/* Only call once. */
-	json::json move_fragment()
+	explicit field_visitor(json_writer& writer) : _writer(writer)
 	{
-		return std::move(_fragment);
 	}
 
 private:
 	void visit(const lst::field& field) final
 	{
-		field_visitor field_type_visitor;
-		field.get_type().accept(field_type_visitor);
-
-		_fragment["name"] = field.name;
-		_fragment["field-class"] = field_type_visitor.move_fragment();
+		_writer.begin_object();
+		_writer.member("name", field.name);
+		_writer.key("field-class");
+		field.get_type().accept(*this);
+		_writer.end_object();
 	}
 
 	void visit(const lst::integer_type& type) final
 	{
-		_fragment["type"] = type.signedness_ == lst::integer_type::signedness::SIGNED ?
-			"fixed-length-signed-integer" :
-			"fixed-length-unsigned-integer";
-		_fragment["length"] = type.size;
-		_fragment["byte-order"] = type.byte_order == lst::byte_order::BIG_ENDIAN_ ?
-			"big-endian" :
-			"little-endian";
-		_fragment["alignment"] = type.alignment;
-		_fragment["preferred-display-base"] = (unsigned int) type.base_;
-
-		if (type.roles_.size() > 0) {
-			json::json role_array = json::json::array();
-
-			for (const auto role : type.roles_) {
-				role_array.push_back(get_role_name(role));
-			}
-
-			_fragment["roles"] = std::move(role_array);
-		}
+		_writer.begin_object();
+		_writer.member("type",
+			       type.signedness_ == lst::integer_type::signedness::SIGNED ?
+				       "fixed-length-signed-integer" :
+				       "fixed-length-unsigned-integer");
+		_writer.member("length", type.size);
+		_writer.member("byte-order", get_byte_order_name(type.byte_order));
+		_writer.member("alignment", type.alignment);
+		_writer.member("preferred-display-base", (unsigned int) type.base_);
+		_write_roles(type.roles_);
+		_writer.end_object();
 	}
 
 	void visit(const lst::floating_point_type& type) final
 	{
-		_fragment["type"] = "fixed-length-floating-point-number";
-		_fragment["length"] = type.exponent_digits + type.mantissa_digits;
-		_fragment["byte-order"] = type.byte_order == lst::byte_order::BIG_ENDIAN_ ?
-			"big-endian" :
-			"little-endian";
-		_fragment["alignment"] = type.alignment;
+		_writer.begin_object();
+		_writer.member("type", "fixed-length-floating-point-number");
+		_writer.member("length", type.exponent_digits + type.mantissa_digits);
+		_writer.member("byte-order", get_byte_order_name(type.byte_order));
+		_writer.member("alignment", type.alignment);
+		_writer.end_object();
 	}
 
 	template <class EnumerationType>
 	void visit_enumeration(const EnumerationType& type)
 	{
-		_fragment["type"] =
-			std::is_signed<
-				typename EnumerationType::mapping::range_t::range_integer_t>::value ?
+		using mapping_t = typename EnumerationType::mapping;
+		const char *const type_name =
+			std::is_signed<typename mapping_t::range_t::range_integer_t>::value ?
 			"fixed-length-signed-enumeration" :
 			"fixed-length-unsigned-enumeration";
-		_fragment["length"] = type.size;
-		_fragment["byte-order"] = type.byte_order == lst::byte_order::BIG_ENDIAN_ ?
-			"big-endian" :
-			"little-endian";
-		_fragment["alignment"] = type.alignment;
-		_fragment["preferred-display-base"] = (unsigned int) type.base_;
-
-		if (type.roles_.size() > 0) {
-			if (std::is_signed<typename EnumerationType::mapping::range_t::
-						   range_integer_t>::value) {
-				LTTNG_THROW_ERROR(
-					lttng::format("Failed to serialize {}: unexpected role",
-						      _fragment["type"]));
-			}
-
-			auto role_array = json::json::array();
-
-			for (const auto role : type.roles_) {
-				role_array.push_back(get_role_name(role));
-			}
 
-			_fragment["roles"] = std::move(role_array);
+		if (type.roles_.size() > 0 &&
+		    std::is_signed<typename mapping_t::range_t::range_integer_t>::value) {
+			LTTNG_THROW_ERROR(lttng::format("Failed to serialize {}: unexpected role",
+							type_name));
 		}
 
 		if (type.mappings_->size() < 1) {
 			LTTNG_THROW_ERROR(lttng::format(
 				"Failed to serialize {}: enumeration must have at least one mapping",
-				_fragment["type"]));
+				type_name));
 		}
 
-		json::json mappings_value;
+		_writer.begin_object();
+		_writer.member("type", type_name);
+		_writer.member("length", type.size);
+		_writer.member("byte-order", get_byte_order_name(type.byte_order));
+		_writer.member("alignment", type.alignment);
+		_writer.member("preferred-display-base", (unsigned int) type.base_);
+		_write_roles(type.roles_);
+
+		/*
+		 * The ranges of the mappings sharing a name are the ranges of a
+		 * single CTF 2 mapping: serialize the mappings by name.
+		 */
+		std::vector<const mapping_t *> sorted_mappings;
+
+		sorted_mappings.reserve(type.mappings_->size());
 		for (const auto& mapping : *type.mappings_) {
-			mappings_value[mapping.name] = { { mapping.range.begin,
-							   mapping.range.end } };
+			sorted_mappings.emplace_back(&mapping);
+		}
+
+		std::stable_sort(sorted_mappings.begin(),
+				 sorted_mappings.end(),
+				 [](const mapping_t *a, const mapping_t *b) {
+					 return a->name < b->name;
+				 });
+
+		_writer.key("mappings");
+		_writer.begin_object();
+		for (auto it = sorted_mappings.begin(); it != sorted_mappings.end(); it++) {
+			if (it == sorted_mappings.begin() || (*it)->name != (*(it - 1))->name) {
+				if (it != sorted_mappings.begin()) {
+					_writer.end_array();
+				}
+
+				_writer.key((*it)->name);
+				_writer.begin_array();
+			}
+
+			_writer.begin_array();
+			_writer.value((*it)->range.begin);
+			_writer.value((*it)->range.end);
+			_writer.end_array();
 		}
 
-		_fragment["mappings"] = std::move(mappings_value);
+		_writer.end_array();
+		_writer.end_object();
+		_writer.end_object();
 	}
 
 	void visit(const lst::signed_enumeration_type& type) final
@@ -245,101 +450,106 @@ private:
 
 	void visit(const lst::static_length_array_type& type) final
 	{
-		_fragment["type"] = "static-length-array";
-
-		::ctf2::field_visitor element_visitor;
-		type.element_type->accept(element_visitor);
-		_fragment["element-field-class"] = element_visitor.move_fragment();
+		_writer.begin_object();
+		_writer.member("type", "static-length-array");
+		_writer.key("element-field-class");
+		type.element_type->accept(*this);
 
 		if (type.alignment != 0) {
-			_fragment["minimum-alignment"] = type.alignment;
+			_writer.member("minimum-alignment", type.alignment);
 		}
 
-		_fragment["length"] = type.length;
+		_writer.member("length", type.length);
+		_writer.end_object();
 	}
 
 	void visit(const lst::dynamic_length_array_type& type) final
 	{
-		_fragment["type"] = "dynamic-length-array";
-
-		::ctf2::field_visitor element_visitor;
-		type.element_type->accept(element_visitor);
-		_fragment["element-field-class"] = element_visitor.move_fragment();
+		_writer.begin_object();
+		_writer.member("type", "dynamic-length-array");
+		_writer.key("element-field-class");
+		type.element_type->accept(*this);
 
 		if (type.alignment != 0) {
-			_fragment["minimum-alignment"] = type.alignment;
+			_writer.member("minimum-alignment", type.alignment);
 		}
 
-		_fragment["length-field-location"] = to_json(type.length_field_location);
+		_writer.key("length-field-location");
+		write_field_location(_writer, type.length_field_location);
+		_writer.end_object();
 	}
 
 	void visit(const lst::static_length_blob_type& type) final
 	{
-		_fragment["type"] = "static-length-blob";
-		_fragment["length"] = type.length_bytes;
-
-		if (type.roles_.size() > 0) {
-			auto role_array = json::json::array();
-
-			for (const auto role : type.roles_) {
-				role_array.push_back(get_role_name(role));
-			}
-
-			_fragment["roles"] = std::move(role_array);
-		}
+		_writer.begin_object();
+		_writer.member("type", "static-length-blob");
+		_writer.member("length", type.length_bytes);
+		_write_roles(type.roles_);
+		_writer.end_object();
 	}
 
 	void visit(const lst::dynamic_length_blob_type& type) final
 	{
-		_fragment["type"] = "dynamic-length-blob";
-		_fragment["length-field-location"] = to_json(type.length_field_location);
+		_writer.begin_object();
+		_writer.member("type", "dynamic-length-blob");
+		_writer.key("length-field-location");
+		write_field_location(_writer, type.length_field_location);
+		_writer.end_object();
 	}
 
 	void visit(const lst::null_terminated_string_type& type __attribute__((unused))) final
 	{
-		_fragment["type"] = "null-terminated-string";
+		_writer.begin_object();
+		_writer.member("type", "null-terminated-string");
+		_writer.end_object();
 	}
 
 	void visit(const lst::structure_type& type) final
 	{
-		_fragment["type"] = "structure";
+		_writer.begin_object();
+		_writer.member("type", "structure");
 
 		if (type.alignment != 0) {
-			_fragment["minimum-alignment"] = type.alignment;
+			_writer.member("minimum-alignment", type.alignment);
 		}
 
-		auto member_classes_value = json::json::array();
+		_writer.key("member-classes");
+		_writer.begin_array();
 		for (const auto& field : type.fields_) {
-			::ctf2::field_visitor member_visitor;
-			json::json member_class;
-
-			field->accept(member_visitor);
-			member_classes_value.emplace_back(member_visitor.move_fragment());
+			field->accept(*this);
 		}
 
-		_fragment["member-classes"] = std::move(member_classes_value);
+		_writer.end_array();
+		_writer.end_object();
 	}
 
 	template <class MappingIntegerType>
 	void visit_variant(const lst::variant_type<MappingIntegerType>& type)
 	{
-		_fragment["type"] = "variant";
-		_fragment["selector-field-location"] = to_json(type.selector_field_location);
+		_writer.begin_object();
+		_writer.member("type", "variant");
+		_writer.key("selector-field-location");
+		write_field_location(_writer, type.selector_field_location);
 
-		auto options_value = json::json::array();
+		_writer.key("options");
+		_writer.begin_array();
 		for (const auto& option : type.choices_) {
-			::ctf2::field_visitor option_visitor;
-			json::json member_class;
-
+			_writer.begin_object();
 			/* TODO missing selector-field-range. */
-			member_class["selector-field-ranges"] = { { option.first.range.begin,
-								    option.first.range.end } };
-			option.second->accept(option_visitor);
-			member_class["field-class"] = option_visitor.move_fragment();
-			options_value.emplace_back(std::move(member_class));
+			_writer.key("selector-field-ranges");
+			_writer.begin_array();
+			_writer.begin_array();
+			_writer.value(option.first.range.begin);
+			_writer.value(option.first.range.end);
+			_writer.end_array();
+			_writer.end_array();
+			_writer.key("field-class");
+			option.second->accept(*this);
+			_writer.end_object();
 		}
 
-		_fragment["options"] = std::move(options_value);
+		_writer.end_array();
+		_writer.end_object();
 	}
 
 	void visit(const lst::variant_type<int64_t>& type) final
@@ -354,17 +564,38 @@ private:
 
 	void visit(const lst::static_length_string_type& type) final
 	{
-		_fragment["type"] = "static-length-string";
-		_fragment["length"] = type.length;
+		_writer.begin_object();
+		_writer.member("type", "static-length-string");
+		_writer.member("length", type.length);
+		_writer.end_object();
 	}
 
 	void visit(const lst::dynamic_length_string_type& type) final
 	{
-		_fragment["type"] = "dynamic-length-string";
-		_fragment["length-field-location"] = to_json(type.length_field_location);
+		_writer.begin_object();
+		_writer.member("type", "dynamic-length-string");
+		_writer.key("length-field-location");
+		write_field_location(_writer, type.length_field_location);
+		_writer.end_object();
+	}
+
+	template <class RolesType>
+	void _write_roles(const RolesType& roles)
+	{
+		if (roles.size() == 0) {
+			return;
+		}
+
+		_writer.key("roles");
+		_writer.begin_array();
+		for (const auto role : roles) {
+			_writer.value(get_role_name(role));
+		}
+
+		_writer.end_array();
 	}
 
-	json::json _fragment;
+	json_writer& _writer;
 };
 } /* namespace ctf2 */
 
@@ -379,107 +610,121 @@ lsc::trace_class_visitor::trace_class_visitor(
 void lsc::trace_class_visitor::visit(const lst::trace_class& trace_class)
 {
 	{
-		auto preamble_fragment = make_json_fragment("preamble");
+		auto preamble_fragment = record_separator;
+		json_writer writer(preamble_fragment);
 
-		preamble_fragment["version"] = 2;
-		preamble_fragment["uuid"] = trace_class.uuid;
-		append_metadata_fragment(preamble_fragment);
+		writer.begin_object();
+		writer.member("type", "preamble");
+		writer.member("version", 2);
+		writer.key("uuid");
+		write_uuid(writer, trace_class.uuid);
+		writer.end_object();
+		_append_metadata_fragment(preamble_fragment);
 	}
 
-	auto trace_class_fragment = make_json_fragment("trace-class");
+	auto trace_class_fragment = record_separator;
+	json_writer writer(trace_class_fragment);
+
+	writer.begin_object();
+	writer.member("type", "trace-class");
 
-	::ctf2::trace_environment_visitor environment_visitor;
+	writer.key("environment");
+	writer.begin_object();
+	::ctf2::trace_environment_visitor environment_visitor(writer);
 	trace_class.accept(environment_visitor);
-	trace_class_fragment["environment"] = environment_visitor.move_fragment();
+	writer.end_object();
 
 	const auto packet_header = trace_class.packet_header();
 	if (packet_header) {
-		::ctf2::field_visitor field_visitor;
+		::ctf2::field_visitor field_visitor(writer);
 
+		writer.key("packet-header-field-class");
 		packet_header->accept(field_visitor);
-		trace_class_fragment["packet-header-field-class"] = field_visitor.move_fragment();
 	}
 
-	append_metadata_fragment(trace_class_fragment);
+	writer.end_object();
+	_append_metadata_fragment(trace_class_fragment);
 }
 
 void lsc::trace_class_visitor::visit(const lst::clock_class& clock_class)
 {
-	auto clock_class_fragment = make_json_fragment("clock-class");
+	auto clock_class_fragment = record_separator;
+	json_writer writer(clock_class_fragment);
 
-	json::json offset;
-	offset.update({ { "seconds", clock_class.offset / clock_class.frequency },
-			{ "cycles", clock_class.offset % clock_class.frequency } });
+	writer.begin_object();
+	writer.member("type", "clock-class");
+	writer.member("name", clock_class.name);
+	writer.member("description", clock_class.description);
+	writer.member("frequency", clock_class.frequency);
 
-	clock_class_fragment.update({ { "name", clock_class.name },
-				      { "description", clock_class.description },
-				      { "frequency", clock_class.frequency },
-				      { "offset", std::move(offset) } });
+	writer.key("offset");
+	writer.begin_object();
+	writer.member("seconds", clock_class.offset / clock_class.frequency);
+	writer.member("cycles", clock_class.offset % clock_class.frequency);
+	writer.end_object();
 
 	if (clock_class.uuid) {
-		clock_class_fragment["uuid"] = *clock_class.uuid;
+		writer.key("uuid");
+		write_uuid(writer, *clock_class.uuid);
 	}
 
-	append_metadata_fragment(clock_class_fragment);
+	writer.end_object();
+	_append_metadata_fragment(clock_class_fragment);
 }
 
 void lsc::trace_class_visitor::visit(const lst::stream_class& stream_class)
 {
-	auto stream_class_fragment = make_json_fragment("data-stream-class");
+	auto stream_class_fragment = record_separator;
+	json_writer writer(stream_class_fragment);
+	::ctf2::field_visitor field_visitor(writer);
 
-	stream_class_fragment["id"] = stream_class.id;
+	writer.begin_object();
+	writer.member("type", "data-stream-class");
+	writer.member("id", stream_class.id);
 	if (stream_class.default_clock_class_name) {
-		stream_class_fragment["default-clock-class-name"] =
-			*stream_class.default_clock_class_name;
+		writer.member("default-clock-class-name", *stream_class.default_clock_class_name);
 	}
 
 	const auto packet_context = stream_class.packet_context();
 	if (packet_context) {
-		::ctf2::field_visitor visitor;
-
-		packet_context->accept(visitor);
-		stream_class_fragment["packet-context-field-class"] = visitor.move_fragment();
+		writer.key("packet-context-field-class");
+		packet_context->accept(field_visitor);
 	}
 
 	const auto event_header = stream_class.event_header();
 	if (event_header) {
-		::ctf2::field_visitor visitor;
-
-		event_header->accept(visitor);
-		stream_class_fragment["event-record-header-field-class"] = visitor.move_fragment();
+		writer.key("event-record-header-field-class");
+		event_header->accept(field_visitor);
 	}
 
 	const auto event_context = stream_class.event_context();
 	if (event_context) {
-		::ctf2::field_visitor visitor;
-
-		event_context->accept(visitor);
-		stream_class_fragment["event-record-common-context-field-class"] =
-			visitor.move_fragment();
+		writer.key("event-record-common-context-field-class");
+		event_context->accept(field_visitor);
 	}
 
-	append_metadata_fragment(stream_class_fragment);
+	writer.end_object();
+	_append_metadata_fragment(stream_class_fragment);
 }
 
 void lsc::trace_class_visitor::visit(const lst::event_class& event_class)
 {
-	auto event_class_fragment = make_json_fragment("event-record-class");
+	auto event_class_fragment = record_separator;
+	json_writer writer(event_class_fragment);
 
-	event_class_fragment["id"] = event_class.id;
-	event_class_fragment["data-stream-class-id"] = event_class.stream_class_id;
-	event_class_fragment["name"] = event_class.name;
+	writer.begin_object();
+	writer.member("type", "event-record-class");
+	writer.member("id", event_class.id);
+	writer.member("data-stream-class-id", event_class.stream_class_id);
+	writer.member("name", event_class.name);
 
 	if (event_class.payload) {
-		::ctf2::field_visitor visitor;
+		::ctf2::field_visitor field_visitor(writer);
 
-		event_class.payload->accept(visitor);
-		event_class_fragment["payload-field-class"] = visitor.move_fragment();
+		writer.key("payload-field-class");
+		event_class.payload->accept(field_visitor);
 	}
 
-	append_metadata_fragment(event_class_fragment);
-}
-
-void lsc::trace_class_visitor::append_metadata_fragment(const nlohmann::json& fragment) const
-{
-	_append_metadata_fragment(record_separator + fragment.dump(spaces_per_indent).c_str());
+	writer.end_object();
+	_append_metadata_fragment(event_class_fragment);
 }
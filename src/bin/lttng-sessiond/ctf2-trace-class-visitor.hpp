@@ -12,7 +12,6 @@
 #include "stream-class.hpp"
 #include "trace-class.hpp"
 
-#include <vendor/nlohmann/json.hpp>
 #include <vendor/optional.hpp>
 
 #include <functional>
@@ -33,8 +32,6 @@ public:
 	virtual void visit(const lttng::sessiond::trace::event_class& event_class) override final;
 
 private:
-	void append_metadata_fragment(const nlohmann::json& fragment) const;
-
 	const append_metadata_fragment_function _append_metadata_fragment;
 };
 
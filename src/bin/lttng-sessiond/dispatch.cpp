@@ -15,8 +15,10 @@
 #include "thread.hpp"
 #include "ust-app.hpp"
 
+#include <common/dynamic-array.hpp>
 #include <common/futex.hpp>
 #include <common/macros.hpp>
+#include <common/self-tracing/self-tracing.hpp>
 #include <common/urcu.hpp>
 
 #include <stddef.h>
@@ -24,22 +26,87 @@
 #include <urcu.h>
 
 namespace {
-struct thread_notifiers {
-	struct ust_cmd_queue *ust_cmd_queue;
+/*
+ * Registration worker: completes the registration of the applications which
+ * the dispatch thread hands to it, concurrently with the other workers.
+ */
+struct registration_worker {
+	/* Queue of struct ust_app_registration. */
+	int32_t futex;
+	struct cds_wfcq_head head;
+	struct cds_wfcq_tail tail;
 	int apps_cmd_pipe_write_fd;
 	int apps_cmd_notify_pipe_write_fd;
+	int worker_thread_exit;
+};
+
+struct ust_app_registration {
+	struct ust_app *app;
+	struct cds_wfcq_node node;
+};
+
+struct thread_notifiers {
+	struct ust_cmd_queue *ust_cmd_queue;
 	int dispatch_thread_exit;
+	/* Registration workers, owned by their thread. */
+	struct registration_worker **workers;
+	unsigned int worker_count;
+	/* Worker to which the next application is handed. */
+	unsigned int next_worker;
 };
 } /* namespace */
 
 /*
- * For each tracing session, update newly registered apps. The session list
- * lock MUST be acquired before calling this.
+ * Get a reference to each tracing session whose user space session is active,
+ * the only ones which apply to a newly registered app, to update it without
+ * holding the session list lock. The session list lock MUST be acquired before
+ * calling this.
+ *
+ * Return 0 on success, -1 on allocation error.
  */
-static void update_ust_app(int app_sock)
+static int get_sessions(struct lttng_dynamic_pointer_array *sessions)
 {
 	struct ltt_session *sess, *stmp;
 	const struct ltt_session_list *session_list = session_get_list();
+
+	cds_list_for_each_entry_safe (sess, stmp, &session_list->ust_active_head, ust_active_list) {
+		if (!session_get(sess)) {
+			continue;
+		}
+
+		if (lttng_dynamic_pointer_array_add_pointer(sessions, sess)) {
+			session_put(sess);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Release the references taken by get_sessions(). The session list lock MUST
+ * be acquired before calling this.
+ */
+static void put_sessions(struct lttng_dynamic_pointer_array *sessions)
+{
+	const auto count = lttng_dynamic_pointer_array_get_count(sessions);
+
+	for (size_t i = 0; i < count; i++) {
+		session_put((ltt_session *) lttng_dynamic_pointer_array_get_pointer(sessions, i));
+	}
+
+	lttng_dynamic_pointer_array_clear(sessions);
+}
+
+/*
+ * For each tracing session, update newly registered apps. Each session is
+ * locked in turn so that the registration workers update their apps
+ * concurrently; the sessions created afterwards see the app in the global
+ * hash table.
+ */
+static void update_ust_app(int app_sock, const struct lttng_dynamic_pointer_array *sessions)
+{
+	const auto count = lttng_dynamic_pointer_array_get_count(sessions);
 	struct ust_app *app;
 
 	/* Consumer is in an ERROR state. Stop any application update. */
@@ -61,14 +128,11 @@ static void update_ust_app(int app_sock)
 		return;
 	}
 
-	/* Update all event notifiers for the app. */
-	ust_app_global_update_event_notifier_rules(app);
-
 	/* For all tracing session(s) */
-	cds_list_for_each_entry_safe (sess, stmp, &session_list->head, list) {
-		if (!session_get(sess)) {
-			continue;
-		}
+	for (size_t i = 0; i < count; i++) {
+		auto *sess = (ltt_session *) lttng_dynamic_pointer_array_get_pointer(sessions, i);
+
+		health_code_update();
 		session_lock(sess);
 		if (!sess->active || !sess->ust_session || !sess->ust_session->active) {
 			goto unlock_session;
@@ -77,7 +141,6 @@ static void update_ust_app(int app_sock)
 		ust_app_global_update(sess->ust_session, app);
 	unlock_session:
 		session_unlock(sess);
-		session_put(sess);
 	}
 }
 
@@ -210,14 +273,231 @@ error:
 	return (int) ret;
 }
 
-static void cleanup_ust_dispatch_thread(void *data)
+/*
+ * Complete the registration of an application which has both its sockets.
+ *
+ * Return 0 on success, a negative value if the application management
+ * threads are gone.
+ */
+static int register_ust_app(const struct registration_worker *worker, struct ust_app *app)
+{
+	int ret;
+	struct lttng_dynamic_pointer_array sessions;
+
+	lttng_dynamic_pointer_array_init(&sessions, nullptr);
+	self_tracepoint(sessiond_app_register_begin, app->pid, app->sock);
+
+	/*
+	 * @session_lock_list
+	 *
+	 * Lock the global session list so that no session is added or removed
+	 * while the application is published and its event notifiers set.
+	 */
+	session_lock_list();
+	{
+		lttng::urcu::read_lock_guard read_lock;
+
+		/*
+		 * Add application to the global hash table. This needs to be
+		 * done before the update to the UST registry can locate the
+		 * application.
+		 */
+		ust_app_add(app);
+
+		/* Set app version. This call will print an error if needed. */
+		(void) ust_app_version(app);
+
+		(void) ust_app_setup_event_notifier_group(app);
+
+		/* Send notify socket through the notify pipe. */
+		ret = send_socket_to_thread(worker->apps_cmd_notify_pipe_write_fd,
+					    app->notify_sock);
+		if (ret < 0) {
+			session_unlock_list();
+			goto end;
+		}
+
+		/* Update all event notifiers for the app. */
+		ust_app_global_update_event_notifier_rules(app);
+
+		if (get_sessions(&sessions)) {
+			ERR("Failed to list the sessions to update app: pid = %d", app->pid);
+			put_sessions(&sessions);
+		}
+	}
+	session_unlock_list();
+	self_tracepoint(sessiond_app_register_published, app->pid);
+
+	/*
+	 * Update newly registered application with the tracing
+	 * registry info already enabled information.
+	 */
+	update_ust_app(app->sock, &sessions);
+	self_tracepoint(sessiond_app_register_sessions_updated, app->pid);
+
+	session_lock_list();
+	put_sessions(&sessions);
+	session_unlock_list();
+
+	/*
+	 * Don't care about return value. Let the manage apps threads
+	 * handle app unregistration upon socket close.
+	 */
+	(void) ust_app_register_done(app);
+	self_tracepoint(sessiond_app_register_end, app->pid);
+
+	/*
+	 * Even if the application socket has been closed, send the app
+	 * to the thread and unregistration will take place at that
+	 * place.
+	 */
+	ret = send_socket_to_thread(worker->apps_cmd_pipe_write_fd, app->sock);
+
+end:
+	lttng_dynamic_pointer_array_reset(&sessions);
+	return ret;
+}
+
+static void cleanup_ust_registration_worker(void *data)
 {
 	free(data);
 }
 
 /*
- * Dispatch request from the registration threads to the application
- * communication thread.
+ * Complete the registration of the applications handed by the dispatch
+ * thread.
+ */
+static void *thread_ust_registration_worker(void *data)
+{
+	int ret, err = -1;
+	struct cds_wfcq_node *node;
+	struct registration_worker *worker = (registration_worker *) data;
+
+	rcu_register_thread();
+
+	health_register(the_health_sessiond, HEALTH_SESSIOND_TYPE_APP_REG_DISPATCH);
+
+	health_code_update();
+
+	DBG("[thread] UST registration worker started");
+
+	for (;;) {
+		health_code_update();
+
+		/* Atomically prepare the queue futex */
+		futex_nto1_prepare(&worker->futex);
+
+		if (CMM_LOAD_SHARED(worker->worker_thread_exit)) {
+			break;
+		}
+
+		for (;;) {
+			struct ust_app_registration *registration;
+			struct ust_app *app;
+
+			node = cds_wfcq_dequeue_blocking(&worker->head, &worker->tail);
+			if (node == nullptr) {
+				break;
+			}
+
+			registration = lttng::utils::container_of(node,
+								  &ust_app_registration::node);
+			app = registration->app;
+			free(registration);
+
+			DBG("Registering UST app: pid = %d, sock = %d", app->pid, app->sock);
+			ret = register_ust_app(worker, app);
+			if (ret < 0) {
+				/*
+				 * No apps. or notify thread, stop the UST tracing.
+				 * However, this is not an internal error of the this
+				 * thread thus setting the health error code to a
+				 * normal exit.
+				 */
+				err = 0;
+				goto error;
+			}
+		}
+
+		health_poll_entry();
+		/* Futex wait on queue. Blocking call on futex() */
+		futex_nto1_wait(&worker->futex);
+		health_poll_exit();
+	}
+	/* Normal exit, no error */
+	err = 0;
+
+error:
+	/* Empty the queue: these applications were never published. */
+	for (;;) {
+		struct ust_app_registration *registration;
+
+		node = cds_wfcq_dequeue_blocking(&worker->head, &worker->tail);
+		if (node == nullptr) {
+			break;
+		}
+
+		registration = lttng::utils::container_of(node, &ust_app_registration::node);
+		ust_app_put(registration->app);
+		free(registration);
+	}
+
+	DBG("UST registration worker dying");
+	if (err) {
+		health_error();
+		ERR("Health error occurred in %s", __func__);
+	}
+	health_unregister(the_health_sessiond);
+	rcu_unregister_thread();
+	return nullptr;
+}
+
+static bool shutdown_ust_registration_worker(void *data)
+{
+	struct registration_worker *worker = (registration_worker *) data;
+
+	CMM_STORE_SHARED(worker->worker_thread_exit, 1);
+	futex_nto1_wake(&worker->futex);
+	return true;
+}
+
+/*
+ * Hand an application which has both its sockets to the next registration
+ * worker.
+ */
+static void queue_ust_app(struct thread_notifiers *notifiers, struct ust_app *app)
+{
+	struct registration_worker *worker;
+	struct ust_app_registration *registration;
+
+	registration = zmalloc<ust_app_registration>();
+	if (!registration) {
+		PERROR("zmalloc ust app registration");
+		ust_app_put(app);
+		return;
+	}
+
+	registration->app = app;
+	cds_wfcq_node_init(&registration->node);
+
+	worker = notifiers->workers[notifiers->next_worker];
+	notifiers->next_worker = (notifiers->next_worker + 1) % notifiers->worker_count;
+
+	cds_wfcq_enqueue(&worker->head, &worker->tail, &registration->node);
+	futex_nto1_wake(&worker->futex);
+}
+
+static void cleanup_ust_dispatch_thread(void *data)
+{
+	struct thread_notifiers *notifiers = (thread_notifiers *) data;
+
+	free(notifiers->workers);
+	free(notifiers);
+}
+
+/*
+ * Dispatch request from the registration threads to the registration
+ * workers, once both sockets of an application are received.
  */
 static void *thread_dispatch_ust_registration(void *data)
 {
@@ -371,73 +651,7 @@ static void *thread_dispatch_ust_registration(void *data)
 			}
 
 			if (app) {
-				/*
-				 * @session_lock_list
-				 *
-				 * Lock the global session list so from the register up to the
-				 * registration done message, no thread can see the application
-				 * and change its state.
-				 */
-				session_lock_list();
-				lttng::urcu::read_lock_guard read_lock;
-
-				/*
-				 * Add application to the global hash table. This needs to be
-				 * done before the update to the UST registry can locate the
-				 * application.
-				 */
-				ust_app_add(app);
-
-				/* Set app version. This call will print an error if needed. */
-				(void) ust_app_version(app);
-
-				(void) ust_app_setup_event_notifier_group(app);
-
-				/* Send notify socket through the notify pipe. */
-				ret = send_socket_to_thread(
-					notifiers->apps_cmd_notify_pipe_write_fd, app->notify_sock);
-				if (ret < 0) {
-					session_unlock_list();
-					/*
-					 * No notify thread, stop the UST tracing. However, this is
-					 * not an internal error of the this thread thus setting
-					 * the health error code to a normal exit.
-					 */
-					err = 0;
-					goto error;
-				}
-
-				/*
-				 * Update newly registered application with the tracing
-				 * registry info already enabled information.
-				 */
-				update_ust_app(app->sock);
-
-				/*
-				 * Don't care about return value. Let the manage apps threads
-				 * handle app unregistration upon socket close.
-				 */
-				(void) ust_app_register_done(app);
-
-				/*
-				 * Even if the application socket has been closed, send the app
-				 * to the thread and unregistration will take place at that
-				 * place.
-				 */
-				ret = send_socket_to_thread(notifiers->apps_cmd_pipe_write_fd,
-							    app->sock);
-				if (ret < 0) {
-					session_unlock_list();
-					/*
-					 * No apps. thread, stop the UST tracing. However, this is
-					 * not an internal error of the this thread thus setting
-					 * the health error code to a normal exit.
-					 */
-					err = 0;
-					goto error;
-				}
-
-				session_unlock_list();
+				queue_ust_app(notifiers, app);
 			}
 		} while (node != nullptr);
 
@@ -494,6 +708,40 @@ static bool shutdown_ust_dispatch_thread(void *data)
 	return true;
 }
 
+/*
+ * Launch a registration worker.
+ *
+ * Return the worker, owned by its thread, or null on error.
+ */
+static struct registration_worker *launch_ust_registration_worker(
+	int apps_cmd_pipe_write_fd, int apps_cmd_notify_pipe_write_fd)
+{
+	struct lttng_thread *thread;
+	struct registration_worker *worker;
+
+	worker = zmalloc<registration_worker>();
+	if (!worker) {
+		return nullptr;
+	}
+
+	cds_wfcq_init(&worker->head, &worker->tail);
+	worker->apps_cmd_pipe_write_fd = apps_cmd_pipe_write_fd;
+	worker->apps_cmd_notify_pipe_write_fd = apps_cmd_notify_pipe_write_fd;
+
+	thread = lttng_thread_create("UST registration worker",
+				     thread_ust_registration_worker,
+				     shutdown_ust_registration_worker,
+				     cleanup_ust_registration_worker,
+				     worker);
+	if (!thread) {
+		free(worker);
+		return nullptr;
+	}
+
+	lttng_thread_put(thread);
+	return worker;
+}
+
 bool launch_ust_dispatch_thread(struct ust_cmd_queue *cmd_queue,
 				int apps_cmd_pipe_write_fd,
 				int apps_cmd_notify_pipe_write_fd)
@@ -506,8 +754,32 @@ bool launch_ust_dispatch_thread(struct ust_cmd_queue *cmd_queue,
 		goto error;
 	}
 	notifiers->ust_cmd_queue = cmd_queue;
-	notifiers->apps_cmd_pipe_write_fd = apps_cmd_pipe_write_fd;
-	notifiers->apps_cmd_notify_pipe_write_fd = apps_cmd_notify_pipe_write_fd;
+
+	notifiers->workers =
+		calloc<registration_worker *>(the_config.app_registration_thread_count);
+	if (!notifiers->workers) {
+		goto error;
+	}
+
+	/*
+	 * The workers are launched first so that they are shut down after
+	 * the dispatch thread which hands them the applications.
+	 */
+	for (unsigned int i = 0; i < the_config.app_registration_thread_count; i++) {
+		auto *worker = launch_ust_registration_worker(apps_cmd_pipe_write_fd,
+							      apps_cmd_notify_pipe_write_fd);
+
+		if (!worker) {
+			ERR("Failed to launch UST registration worker %u", i);
+			break;
+		}
+
+		notifiers->workers[notifiers->worker_count++] = worker;
+	}
+
+	if (notifiers->worker_count == 0) {
+		goto error;
+	}
 
 	thread = lttng_thread_create("UST registration dispatch",
 				     thread_dispatch_ust_registration,
@@ -520,6 +792,9 @@ bool launch_ust_dispatch_thread(struct ust_cmd_queue *cmd_queue,
 	lttng_thread_put(thread);
 	return true;
 error:
+	if (notifiers) {
+		free(notifiers->workers);
+	}
 	free(notifiers);
 	return false;
 }
@@ -37,7 +37,8 @@ public:
 	const int log_level;
 	const std::string name;
 	const nonstd::optional<std::string> model_emf_uri;
-	const lttng::sessiond::trace::type::cuptr payload;
+	/* Shared with the identical event classes of other trace classes. */
+	const std::shared_ptr<const lttng::sessiond::trace::type> payload;
 
 protected:
 	event_class(unsigned int id,
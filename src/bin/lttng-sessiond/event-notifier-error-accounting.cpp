@@ -785,34 +785,51 @@ end:
 	return status;
 }
 
+/*
+ * Get the error counts of user space triggers, `counts[i]` being the count of
+ * `triggers[i]`.
+ *
+ * The counters of the UID entries are aggregated in a single pass for all
+ * the triggers, rather than iterating on the UID entries for each trigger.
+ */
 static enum event_notifier_error_accounting_status
-event_notifier_error_accounting_ust_get_count(const struct lttng_trigger *trigger, uint64_t *count)
+event_notifier_error_accounting_ust_get_counts(const struct lttng_trigger *const *triggers,
+					       unsigned int count,
+					       uint64_t *counts)
 {
 	struct lttng_ht_iter iter;
 	struct ust_error_accounting_entry *uid_entry;
-	uint64_t error_counter_index, global_sum = 0;
 	enum event_notifier_error_accounting_status status;
-	size_t dimension_indexes[1];
-	const uint64_t tracer_token = lttng_trigger_get_tracer_token(trigger);
 	uid_t trigger_owner_uid;
 	const char *trigger_name;
+	unsigned int i;
+	uint64_t *error_counter_indexes = calloc<uint64_t>(count);
 
 	lttng::urcu::read_lock_guard read_lock;
 
-	get_trigger_info_for_log(trigger, &trigger_name, &trigger_owner_uid);
-
-	status = get_error_counter_index_for_token(&ust_state, tracer_token, &error_counter_index);
-	if (status != EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK) {
-		ERR("Failed to retrieve index for tracer token: token = %" PRIu64
-		    ", trigger name = '%s', trigger owner uid = %d, status = %s",
-		    tracer_token,
-		    trigger_name,
-		    (int) trigger_owner_uid,
-		    error_accounting_status_str(status));
+	if (!error_counter_indexes) {
+		status = EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_NOMEM;
 		goto end;
 	}
 
-	dimension_indexes[0] = error_counter_index;
+	for (i = 0; i < count; i++) {
+		const uint64_t tracer_token = lttng_trigger_get_tracer_token(triggers[i]);
+
+		status = get_error_counter_index_for_token(
+			&ust_state, tracer_token, &error_counter_indexes[i]);
+		if (status != EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK) {
+			get_trigger_info_for_log(triggers[i], &trigger_name, &trigger_owner_uid);
+			ERR("Failed to retrieve index for tracer token: token = %" PRIu64
+			    ", trigger name = '%s', trigger owner uid = %d, status = %s",
+			    tracer_token,
+			    trigger_name,
+			    (int) trigger_owner_uid,
+			    error_accounting_status_str(status));
+			goto end;
+		}
+
+		counts[i] = 0;
+	}
 
 	/*
 	 * Iterate over all the UID entries.
@@ -822,44 +839,55 @@ event_notifier_error_accounting_ust_get_count(const struct lttng_trigger *trigge
 	 * notifier on all apps that this sessiond is aware of.
 	 */
 	cds_lfht_for_each_entry (error_counter_uid_ht->ht, &iter.iter, uid_entry, node.node) {
-		int ret;
-		int64_t local_value = 0;
-		bool overflow = false, underflow = false;
-
-		ret = lttng_ust_ctl_counter_aggregate(uid_entry->daemon_counter,
-						      dimension_indexes,
-						      &local_value,
-						      &overflow,
-						      &underflow);
-		if (ret || local_value < 0) {
-			if (ret) {
-				ERR("Failed to aggregate event notifier error counter values of trigger: trigger name = '%s', trigger owner uid = %d",
-				    trigger_name,
-				    (int) trigger_owner_uid);
-			} else if (local_value < 0) {
-				ERR("Negative event notifier error counter value encountered during aggregation: trigger name = '%s', trigger owner uid = %d, value = %" PRId64,
-				    trigger_name,
-				    (int) trigger_owner_uid,
-				    local_value);
-			} else {
-				abort();
+		for (i = 0; i < count; i++) {
+			int ret;
+			int64_t local_value = 0;
+			bool overflow = false, underflow = false;
+			size_t dimension_indexes[1] = { error_counter_indexes[i] };
+
+			ret = lttng_ust_ctl_counter_aggregate(uid_entry->daemon_counter,
+							      dimension_indexes,
+							      &local_value,
+							      &overflow,
+							      &underflow);
+			if (ret || local_value < 0) {
+				get_trigger_info_for_log(
+					triggers[i], &trigger_name, &trigger_owner_uid);
+				if (ret) {
+					ERR("Failed to aggregate event notifier error counter values of trigger: trigger name = '%s', trigger owner uid = %d",
+					    trigger_name,
+					    (int) trigger_owner_uid);
+				} else if (local_value < 0) {
+					ERR("Negative event notifier error counter value encountered during aggregation: trigger name = '%s', trigger owner uid = %d, value = %" PRId64,
+					    trigger_name,
+					    (int) trigger_owner_uid,
+					    local_value);
+				} else {
+					abort();
+				}
+
+				status = EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_ERR;
+				goto end;
 			}
 
-			status = EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_ERR;
-			goto end;
+			/* Cast is safe as negative values are checked-for above. */
+			counts[i] += (uint64_t) local_value;
 		}
-
-		/* Cast is safe as negative values are checked-for above. */
-		global_sum += (uint64_t) local_value;
 	}
 
-	*count = global_sum;
 	status = EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK;
 
 end:
+	free(error_counter_indexes);
 	return status;
 }
 
+static enum event_notifier_error_accounting_status
+event_notifier_error_accounting_ust_get_count(const struct lttng_trigger *trigger, uint64_t *count)
+{
+	return event_notifier_error_accounting_ust_get_counts(&trigger, 1, count);
+}
+
 static enum event_notifier_error_accounting_status
 event_notifier_error_accounting_ust_clear(const struct lttng_trigger *trigger)
 {
@@ -1226,6 +1254,79 @@ event_notifier_error_accounting_get_count(const struct lttng_trigger *trigger, u
 	}
 }
 
+enum event_notifier_error_accounting_status
+event_notifier_error_accounting_get_counts(const struct lttng_trigger *const *triggers,
+					   unsigned int count,
+					   uint64_t *counts)
+{
+	enum event_notifier_error_accounting_status status =
+		EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK;
+	unsigned int i, ust_count = 0;
+	const struct lttng_trigger **ust_triggers = nullptr;
+	uint64_t *ust_counts = nullptr;
+
+	/* The kernel counters are read one by one. */
+	for (i = 0; i < count; i++) {
+		if (lttng_trigger_get_underlying_domain_type_restriction(triggers[i]) !=
+		    LTTNG_DOMAIN_KERNEL) {
+			ust_count++;
+			continue;
+		}
+
+		status = event_notifier_error_accounting_kernel_get_count(triggers[i], &counts[i]);
+		if (status != EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK) {
+			goto end;
+		}
+	}
+
+	if (ust_count == 0) {
+		goto end;
+	}
+
+#ifdef HAVE_LIBLTTNG_UST_CTL
+	ust_triggers = calloc<const struct lttng_trigger *>(ust_count);
+	ust_counts = calloc<uint64_t>(ust_count);
+	if (!ust_triggers || !ust_counts) {
+		status = EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_NOMEM;
+		goto end;
+	}
+
+	ust_count = 0;
+	for (i = 0; i < count; i++) {
+		if (lttng_trigger_get_underlying_domain_type_restriction(triggers[i]) !=
+		    LTTNG_DOMAIN_KERNEL) {
+			ust_triggers[ust_count++] = triggers[i];
+		}
+	}
+
+	status = event_notifier_error_accounting_ust_get_counts(
+		ust_triggers, ust_count, ust_counts);
+	if (status != EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK) {
+		goto end;
+	}
+
+	ust_count = 0;
+	for (i = 0; i < count; i++) {
+		if (lttng_trigger_get_underlying_domain_type_restriction(triggers[i]) !=
+		    LTTNG_DOMAIN_KERNEL) {
+			counts[i] = ust_counts[ust_count++];
+		}
+	}
+#else
+	for (i = 0; i < count; i++) {
+		if (lttng_trigger_get_underlying_domain_type_restriction(triggers[i]) !=
+		    LTTNG_DOMAIN_KERNEL) {
+			counts[i] = 0;
+		}
+	}
+#endif /* HAVE_LIBLTTNG_UST_CTL */
+
+end:
+	free(ust_triggers);
+	free(ust_counts);
+	return status;
+}
+
 static enum event_notifier_error_accounting_status
 event_notifier_error_accounting_clear(const struct lttng_trigger *trigger)
 {
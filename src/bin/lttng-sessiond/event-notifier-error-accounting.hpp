@@ -80,6 +80,16 @@ event_notifier_error_accounting_register_event_notifier(const struct lttng_trigg
 enum event_notifier_error_accounting_status
 event_notifier_error_accounting_get_count(const struct lttng_trigger *trigger, uint64_t *count);
 
+/*
+ * Get the error counts of a set of triggers, `counts[i]` being the count of
+ * `triggers[i]`, aggregating the counters of the user space applications in
+ * a single pass.
+ */
+enum event_notifier_error_accounting_status
+event_notifier_error_accounting_get_counts(const struct lttng_trigger *const *triggers,
+					   unsigned int count,
+					   uint64_t *counts);
+
 void event_notifier_error_accounting_unregister_event_notifier(const struct lttng_trigger *trigger);
 
 void event_notifier_error_accounting_fini(void);
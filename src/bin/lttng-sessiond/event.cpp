@@ -148,6 +148,91 @@ end:
 	return ret;
 }
 
+/*
+ * Enable kernel events for a channel from the kernel session, creating those
+ * which don't exist yet in a single kernel_create_events() batch. The status
+ * of each entry is set.
+ *
+ * Return LTTNG_OK, or the status of the first entry which failed.
+ * We own the filter expressions and filters of the entries.
+ */
+int event_kernel_enable_events(struct ltt_kernel_channel *kchan,
+			       struct kernel_event_batch_entry *entries,
+			       unsigned int count)
+{
+	int ret = LTTNG_OK;
+	unsigned int i, create_count = 0;
+	struct kernel_event_batch_entry *to_create;
+	unsigned int *to_create_indexes;
+
+	LTTNG_ASSERT(kchan);
+
+	to_create = calloc<kernel_event_batch_entry>(count);
+	to_create_indexes = calloc<unsigned int>(count);
+	if (count > 0 && (!to_create || !to_create_indexes)) {
+		for (i = 0; i < count; i++) {
+			free(entries[i].filter_expression);
+			free(entries[i].filter);
+			entries[i].filter_expression = nullptr;
+			entries[i].filter = nullptr;
+			entries[i].status = LTTNG_ERR_NOMEM;
+		}
+
+		ret = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		struct kernel_event_batch_entry *entry = &entries[i];
+		struct ltt_kernel_event *kevent;
+
+		LTTNG_ASSERT(entry->ev);
+
+		kevent = trace_kernel_find_event(
+			entry->ev->name, kchan, entry->ev->type, entry->filter);
+		if (kevent == nullptr) {
+			to_create_indexes[create_count] = i;
+			/* We pass ownership */
+			to_create[create_count++] = *entry;
+			entry->filter_expression = nullptr;
+			entry->filter = nullptr;
+			continue;
+		}
+
+		if (!kevent->enabled) {
+			entry->status = LTTNG_OK;
+			if (kernel_enable_event(kevent) < 0) {
+				entry->status = LTTNG_ERR_KERN_ENABLE_FAIL;
+			}
+		} else {
+			/* At this point, the event is considered enabled */
+			entry->status = LTTNG_ERR_KERN_EVENT_EXIST;
+		}
+
+		free(entry->filter_expression);
+		free(entry->filter);
+		entry->filter_expression = nullptr;
+		entry->filter = nullptr;
+	}
+
+	(void) kernel_create_events(kchan, to_create, create_count);
+	for (i = 0; i < create_count; i++) {
+		entries[to_create_indexes[i]].status = to_create[i].status;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (entries[i].status != LTTNG_OK) {
+			ret = entries[i].status;
+			break;
+		}
+	}
+
+end:
+	free(to_create_indexes);
+	free(to_create);
+	return ret;
+}
+
 /*
  * ============================
  * UST : The Ultimate Frontier!
@@ -207,6 +292,7 @@ int event_ust_enable_tracepoint(struct ltt_ust_session *usess,
 	if (to_create) {
 		/* Add ltt ust event to channel */
 		add_unique_ust_event(uchan->events, uevent);
+		trace_ust_invalidate_setup_plan(usess);
 	}
 
 	if (!usess->active) {
@@ -11,6 +11,7 @@
 #include "trace-kernel.hpp"
 
 struct agent;
+struct kernel_event_batch_entry;
 
 int event_kernel_disable_event(struct ltt_kernel_channel *kchan,
 			       const char *event_name,
@@ -21,6 +22,10 @@ int event_kernel_enable_event(struct ltt_kernel_channel *kchan,
 			      char *filter_expression,
 			      struct lttng_bytecode *filter);
 
+int event_kernel_enable_events(struct ltt_kernel_channel *kchan,
+			       struct kernel_event_batch_entry *entries,
+			       unsigned int count);
+
 int event_ust_enable_tracepoint(struct ltt_ust_session *usess,
 				struct ltt_ust_channel *uchan,
 				struct lttng_event *event,
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "filter-bytecode-cache.hpp"
+
+#include <common/bytecode/bytecode.hpp>
+#include <common/error.hpp>
+#include <common/hashtable/utils.hpp>
+#include <common/macros.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+#include <unordered_map>
+
+namespace {
+size_t bytecode_size(const struct lttng_bytecode *bytecode)
+{
+	return sizeof(*bytecode) + bytecode->len;
+}
+
+/* Shared bytecodes are identified by their content, header included. */
+struct bytecode_hash {
+	size_t operator()(const struct lttng_bytecode *bytecode) const
+	{
+		return hash_buffer(bytecode, bytecode_size(bytecode), 0);
+	}
+};
+
+struct bytecode_equal {
+	bool operator()(const struct lttng_bytecode *a, const struct lttng_bytecode *b) const
+	{
+		return a->len == b->len && memcmp(a, b, bytecode_size(a)) == 0;
+	}
+};
+
+pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Reference count of each shared bytecode, protected by `cache_lock`. */
+std::unordered_map<const struct lttng_bytecode *, unsigned int, bytecode_hash, bytecode_equal>
+	cache;
+} /* namespace */
+
+struct lttng_bytecode *filter_bytecode_acquire(const struct lttng_bytecode *bytecode)
+{
+	struct lttng_bytecode *shared_bytecode = nullptr;
+
+	LTTNG_ASSERT(bytecode);
+
+	pthread_mutex_lock(&cache_lock);
+	const auto it = cache.find(bytecode);
+	if (it != cache.end()) {
+		it->second++;
+		shared_bytecode = const_cast<struct lttng_bytecode *>(it->first);
+		goto end;
+	}
+
+	shared_bytecode = lttng_bytecode_copy(bytecode);
+	if (!shared_bytecode) {
+		PERROR("Failed to allocate filter bytecode: length = %" PRIu32, bytecode->len);
+		goto end;
+	}
+
+	try {
+		cache.emplace(shared_bytecode, 1);
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to add filter bytecode to the cache: length = %" PRIu32,
+		    bytecode->len);
+		free(shared_bytecode);
+		shared_bytecode = nullptr;
+		goto end;
+	}
+
+	DBG3("Filter bytecode cached: length = %" PRIu32 ", cached bytecodes = %zu",
+	     bytecode->len,
+	     cache.size());
+end:
+	pthread_mutex_unlock(&cache_lock);
+	return shared_bytecode;
+}
+
+struct lttng_bytecode *filter_bytecode_get(struct lttng_bytecode *bytecode)
+{
+	LTTNG_ASSERT(bytecode);
+
+	pthread_mutex_lock(&cache_lock);
+	const auto it = cache.find(bytecode);
+	LTTNG_ASSERT(it != cache.end() && it->first == bytecode);
+	it->second++;
+	pthread_mutex_unlock(&cache_lock);
+
+	return bytecode;
+}
+
+void filter_bytecode_put(struct lttng_bytecode *bytecode)
+{
+	if (!bytecode) {
+		return;
+	}
+
+	pthread_mutex_lock(&cache_lock);
+	const auto it = cache.find(bytecode);
+	LTTNG_ASSERT(it != cache.end() && it->first == bytecode);
+	if (--it->second == 0) {
+		cache.erase(it);
+		free(bytecode);
+	}
+	pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,29 @@
+#ifndef _LTTNG_FILTER_BYTECODE_CACHE_H
+#define _LTTNG_FILTER_BYTECODE_CACHE_H
+
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+struct lttng_bytecode;
+
+/*
+ * Filter bytecodes shared, read-only, by the events which use the same
+ * filter, and by their copies of each application, rather than copied for
+ * each of them.
+ *
+ * Return a reference to the shared bytecode of the same content as
+ * `bytecode`, which remains owned by the caller, or NULL on error.
+ */
+struct lttng_bytecode *filter_bytecode_acquire(const struct lttng_bytecode *bytecode);
+
+/* Take another reference to a shared bytecode, which is returned. */
+struct lttng_bytecode *filter_bytecode_get(struct lttng_bytecode *bytecode);
+
+/* Release a reference to a shared bytecode. NULL is accepted. */
+void filter_bytecode_put(struct lttng_bytecode *bytecode);
+
+#endif /* _LTTNG_FILTER_BYTECODE_CACHE_H */
@@ -17,6 +17,7 @@ int the_ust_consumerd64_fd = -1;
 int the_ust_consumerd32_fd = -1;
 
 long the_page_size;
+long the_huge_page_size = -1;
 
 struct health_app *the_health_sessiond;
 
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <vector>
 
 static char *create_channel_path(struct consumer_output *consumer, size_t *consumer_path_offset)
 {
@@ -156,6 +157,11 @@ static int kernel_consumer_add_channel(struct consumer_socket *sock,
 					   channel->channel->attr.live_timer_interval,
 					   ksession->is_live_session,
 					   channel_attr_extended->monitor_timer_interval,
+					   (enum lttng_channel_writeback_policy)
+						   channel_attr_extended->writeback_policy,
+					   channel_attr_extended->writeback_window_size,
+					   channel_attr_extended->drain_max_subbuffers,
+					   channel_attr_extended->drain_max_bytes,
 					   ksession->current_trace_chunk);
 
 	health_code_update();
@@ -234,6 +240,10 @@ int kernel_consumer_add_metadata(struct consumer_socket *sock,
 					   ksession->metadata->conf->attr.live_timer_interval,
 					   ksession->is_live_session,
 					   0,
+					   LTTNG_CHANNEL_WRITEBACK_POLICY_SYNC,
+					   0,
+					   1,
+					   0,
 					   ksession->current_trace_chunk);
 
 	health_code_update();
@@ -265,48 +275,6 @@ error:
 	return ret;
 }
 
-/*
- * Sending a single stream to the consumer with command ADD_STREAM.
- */
-static int kernel_consumer_add_stream(struct consumer_socket *sock,
-				      struct ltt_kernel_channel *channel,
-				      struct ltt_kernel_stream *stream,
-				      struct ltt_kernel_session *session)
-{
-	int ret;
-	struct lttcomm_consumer_msg lkm;
-	struct consumer_output *consumer;
-
-	LTTNG_ASSERT(channel);
-	LTTNG_ASSERT(stream);
-	LTTNG_ASSERT(session);
-	LTTNG_ASSERT(session->consumer);
-	LTTNG_ASSERT(sock);
-
-	DBG("Sending stream %d of channel %s to kernel consumer",
-	    stream->fd,
-	    channel->channel->name);
-
-	/* Get consumer output pointer */
-	consumer = session->consumer;
-
-	/* Prep stream consumer message */
-	consumer_init_add_stream_comm_msg(&lkm, channel->key, stream->fd, stream->cpu);
-
-	health_code_update();
-
-	/* Send stream and file descriptor */
-	ret = consumer_send_stream(sock, consumer, &lkm, &stream->fd, 1);
-	if (ret < 0) {
-		goto error;
-	}
-
-	health_code_update();
-
-error:
-	return ret;
-}
-
 /*
  * Sending the notification that all streams were sent with STREAMS_SENT.
  */
@@ -378,18 +346,53 @@ int kernel_consumer_send_channel_streams(struct consumer_socket *sock,
 		channel->sent_to_consumer = true;
 	}
 
-	/* Send streams */
-	cds_list_for_each_entry (stream, &channel->stream_list.head, list) {
-		if (!stream->fd || stream->sent_to_consumer) {
-			continue;
+	/* Send the streams which were not sent yet as a single batch. */
+	{
+		std::vector<lttcomm_consumer_stream_desc> descriptors;
+		std::vector<int> fds;
+
+		try {
+			descriptors.reserve(channel->stream_count);
+			fds.reserve(channel->stream_count);
+			cds_list_for_each_entry (stream, &channel->stream_list.head, list) {
+				if (!stream->fd || stream->sent_to_consumer) {
+					continue;
+				}
+
+				descriptors.push_back({ .cpu = stream->cpu });
+				fds.push_back(stream->fd);
+			}
+		} catch (const std::bad_alloc&) {
+			ERR("Failed to allocate the descriptors of the streams of channel %s",
+			    channel->channel->name);
+			ret = -1;
+			goto error;
+		}
+
+		if (fds.empty()) {
+			goto error;
 		}
 
-		/* Add stream on the kernel consumer side. */
-		ret = kernel_consumer_add_stream(sock, channel, stream, ksession);
+		DBG("Sending %zu streams of channel %s to kernel consumer",
+		    fds.size(),
+		    channel->channel->name);
+
+		health_code_update();
+
+		/* Add the streams on the kernel consumer side. */
+		ret = consumer_send_streams(
+			sock, channel->key, descriptors.data(), fds.data(), fds.size());
 		if (ret < 0) {
 			goto error;
 		}
-		stream->sent_to_consumer = true;
+
+		health_code_update();
+	}
+
+	cds_list_for_each_entry (stream, &channel->stream_list.head, list) {
+		if (stream->fd) {
+			stream->sent_to_consumer = true;
+		}
 	}
 
 error:
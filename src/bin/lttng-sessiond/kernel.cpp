@@ -24,6 +24,7 @@
 #include <common/hashtable/utils.hpp>
 #include <common/kernel-ctl/kernel-ctl.hpp>
 #include <common/kernel-ctl/kernel-ioctl.hpp>
+#include <common/pthread-lock.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/trace-chunk.hpp>
 #include <common/tracker.hpp>
@@ -38,6 +39,7 @@
 #include <lttng/event.h>
 #include <lttng/lttng-error.h>
 #include <lttng/tracker.h>
+#include <lttng/trigger/trigger-internal.hpp>
 #include <lttng/userspace-probe-internal.hpp>
 #include <lttng/userspace-probe.h>
 
@@ -86,6 +88,38 @@ static inline uint64_t sanitize_uprobe_offset(uint64_t raw_offset)
 	return raw_offset;
 }
 #endif
+
+/* Protects probe_modules_loaded. */
+pthread_mutex_t probe_modules_lock = PTHREAD_MUTEX_INITIALIZER;
+bool probe_modules_loaded;
+
+/*
+ * Load the probe modules unless they are loaded already.
+ *
+ * When the probe modules are loaded lazily, this is done by the first command
+ * which needs them rather than when the kernel tracer is initialized.
+ *
+ * Return 0 on success or else a negative value.
+ */
+int load_probe_modules()
+{
+	int ret;
+	const lttng::pthread::lock_guard lock(probe_modules_lock);
+
+	if (probe_modules_loaded) {
+		return 0;
+	}
+
+	DBG("Loading kernel probe modules");
+	ret = modprobe_lttng_data();
+	if (ret < 0) {
+		ERR("Failed to load kernel probe modules");
+		return ret;
+	}
+
+	probe_modules_loaded = true;
+	return 0;
+}
 } /* namespace */
 
 /*
@@ -138,10 +172,15 @@ error:
 int kernel_create_session(struct ltt_session *session)
 {
 	int ret;
-	struct ltt_kernel_session *lks;
+	struct ltt_kernel_session *lks = nullptr;
 
 	LTTNG_ASSERT(session);
 
+	ret = load_probe_modules();
+	if (ret < 0) {
+		goto error;
+	}
+
 	/* Allocate data structure */
 	lks = trace_kernel_create_session();
 	if (lks == nullptr) {
@@ -588,49 +627,36 @@ end:
 	return ret;
 }
 
+namespace {
+enum lttng_error_code create_event_error_code(int err, const struct lttng_event *ev)
+{
+	switch (-err) {
+	case EEXIST:
+		return LTTNG_ERR_KERN_EVENT_EXIST;
+	case ENOSYS:
+		WARN("Event type not implemented");
+		return LTTNG_ERR_KERN_EVENT_ENOSYS;
+	case ENOENT:
+		WARN("Event %s not found!", ev->name);
+		return LTTNG_ERR_KERN_ENABLE_FAIL;
+	default:
+		errno = -err;
+		PERROR("create event ioctl");
+		return LTTNG_ERR_KERN_ENABLE_FAIL;
+	}
+}
+
 /*
- * Create a kernel event, enable it to the kernel tracer and add it to the
- * channel event list of the kernel session.
- * We own filter_expression and filter.
+ * Set up and enable a kernel event created by the kernel tracer, then add it
+ * to the event list of its channel. The event is freed on error.
  */
-int kernel_create_event(struct lttng_event *ev,
-			struct ltt_kernel_channel *channel,
-			char *filter_expression,
-			struct lttng_bytecode *filter)
+enum lttng_error_code enable_created_event(struct lttng_event *ev,
+					   struct ltt_kernel_channel *channel,
+					   struct ltt_kernel_event *event,
+					   int fd)
 {
-	int err, fd;
+	int err;
 	enum lttng_error_code ret;
-	struct ltt_kernel_event *event;
-
-	LTTNG_ASSERT(ev);
-	LTTNG_ASSERT(channel);
-
-	/* We pass ownership of filter_expression and filter */
-	ret = trace_kernel_create_event(ev, filter_expression, filter, &event);
-	if (ret != LTTNG_OK) {
-		goto error;
-	}
-
-	fd = kernctl_create_event(channel->fd, event->event);
-	if (fd < 0) {
-		switch (-fd) {
-		case EEXIST:
-			ret = LTTNG_ERR_KERN_EVENT_EXIST;
-			break;
-		case ENOSYS:
-			WARN("Event type not implemented");
-			ret = LTTNG_ERR_KERN_EVENT_ENOSYS;
-			break;
-		case ENOENT:
-			WARN("Event %s not found!", ev->name);
-			ret = LTTNG_ERR_KERN_ENABLE_FAIL;
-			break;
-		default:
-			ret = LTTNG_ERR_KERN_ENABLE_FAIL;
-			PERROR("create event ioctl");
-		}
-		goto free_event;
-	}
 
 	event->type = ev->type;
 	event->fd = fd;
@@ -640,8 +666,8 @@ int kernel_create_event(struct lttng_event *ev,
 		PERROR("fcntl session fd");
 	}
 
-	if (filter) {
-		err = kernctl_filter(event->fd, filter);
+	if (event->filter) {
+		err = kernctl_filter(event->fd, event->filter);
 		if (err < 0) {
 			switch (-err) {
 			case ENOMEM:
@@ -651,7 +677,7 @@ int kernel_create_event(struct lttng_event *ev,
 				ret = LTTNG_ERR_FILTER_INVAL;
 				break;
 			}
-			goto filter_error;
+			goto error;
 		}
 	}
 
@@ -659,7 +685,7 @@ int kernel_create_event(struct lttng_event *ev,
 		ret = (lttng_error_code) userspace_probe_event_add_callsites(
 			ev, channel->session, event->fd);
 		if (ret) {
-			goto add_callsite_error;
+			goto error;
 		}
 	}
 
@@ -674,7 +700,7 @@ int kernel_create_event(struct lttng_event *ev,
 			ret = LTTNG_ERR_KERN_ENABLE_FAIL;
 			break;
 		}
-		goto enable_error;
+		goto error;
 	}
 
 	/* Add event to event list */
@@ -683,11 +709,9 @@ int kernel_create_event(struct lttng_event *ev,
 
 	DBG("Event %s created (fd: %d)", ev->name, event->fd);
 
-	return 0;
+	return LTTNG_OK;
 
-add_callsite_error:
-enable_error:
-filter_error:
+error:
 {
 	int closeret;
 
@@ -696,11 +720,120 @@ filter_error:
 		PERROR("close event fd");
 	}
 }
-free_event:
 	free(event);
-error:
 	return ret;
 }
+} /* namespace */
+
+/*
+ * Create a kernel event, enable it to the kernel tracer and add it to the
+ * channel event list of the kernel session.
+ * We own filter_expression and filter.
+ */
+int kernel_create_event(struct lttng_event *ev,
+			struct ltt_kernel_channel *channel,
+			char *filter_expression,
+			struct lttng_bytecode *filter)
+{
+	struct kernel_event_batch_entry entry = {};
+
+	LTTNG_ASSERT(ev);
+
+	entry.ev = ev;
+	entry.filter_expression = filter_expression;
+	entry.filter = filter;
+
+	/* We pass ownership of filter_expression and filter */
+	(void) kernel_create_events(channel, &entry, 1);
+	return entry.status == LTTNG_OK ? 0 : entry.status;
+}
+
+/*
+ * Create kernel events, enable them to the kernel tracer and add them to the
+ * channel event list of the kernel session, in one pass: the event objects
+ * are created first, then all the events are created by the kernel tracer,
+ * then they are all set up and enabled.
+ */
+unsigned int kernel_create_events(struct ltt_kernel_channel *channel,
+				  struct kernel_event_batch_entry *entries,
+				  unsigned int count)
+{
+	unsigned int i, descriptor_count = 0, failed_count = 0;
+	struct ltt_kernel_event **events = nullptr;
+	struct lttng_kernel_abi_event **descriptors = nullptr;
+	int *fds = nullptr;
+
+	LTTNG_ASSERT(channel);
+	LTTNG_ASSERT(entries || count == 0);
+
+	events = calloc<ltt_kernel_event *>(count);
+	descriptors = calloc<lttng_kernel_abi_event *>(count);
+	fds = calloc<int>(count);
+	if (count > 0 && (!events || !descriptors || !fds)) {
+		for (i = 0; i < count; i++) {
+			free(entries[i].filter_expression);
+			free(entries[i].filter);
+			entries[i].filter_expression = nullptr;
+			entries[i].filter = nullptr;
+			entries[i].status = LTTNG_ERR_NOMEM;
+		}
+
+		failed_count = count;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		struct kernel_event_batch_entry *entry = &entries[i];
+
+		LTTNG_ASSERT(entry->ev);
+
+		/* We pass ownership of filter_expression and filter */
+		entry->status = trace_kernel_create_event(
+			entry->ev, entry->filter_expression, entry->filter, &events[i]);
+		entry->filter_expression = nullptr;
+		entry->filter = nullptr;
+		if (entry->status != LTTNG_OK) {
+			events[i] = nullptr;
+			failed_count++;
+			continue;
+		}
+
+		descriptors[descriptor_count++] = events[i]->event;
+	}
+
+	DBG("Creating %u kernel events in channel %s",
+	    descriptor_count,
+	    channel->channel->name);
+	(void) kernctl_create_events(channel->fd, descriptors, fds, descriptor_count);
+
+	descriptor_count = 0;
+	for (i = 0; i < count; i++) {
+		struct kernel_event_batch_entry *entry = &entries[i];
+		int fd;
+
+		if (!events[i]) {
+			continue;
+		}
+
+		fd = fds[descriptor_count++];
+		if (fd < 0) {
+			entry->status = create_event_error_code(fd, entry->ev);
+			free(events[i]);
+		} else {
+			entry->status = enable_created_event(entry->ev, channel, events[i], fd);
+		}
+
+		if (entry->status != LTTNG_OK) {
+			failed_count++;
+		}
+	}
+
+end:
+	free(fds);
+	free(descriptors);
+	free(events);
+	return failed_count;
+}
 
 /*
  * Disable a kernel channel.
@@ -1436,6 +1569,10 @@ ssize_t kernel_list_events(struct lttng_event **events)
 
 	LTTNG_ASSERT(events);
 
+	if (load_probe_modules() < 0) {
+		goto error;
+	}
+
 	fd = kernctl_tracepoint_list(kernel_tracer_fd);
 	if (fd < 0) {
 		PERROR("kernel tracepoint list");
@@ -1976,9 +2113,11 @@ int init_kernel_tracer()
 		goto error_version;
 	}
 
-	ret = modprobe_lttng_data();
-	if (ret < 0) {
-		goto error_modules;
+	if (!the_config.kmod_probes_lazy) {
+		ret = load_probe_modules();
+		if (ret < 0) {
+			goto error_modules;
+		}
 	}
 
 	ret = kernel_supports_ring_buffer_snapshot_sample_positions();
@@ -2136,7 +2275,7 @@ void cleanup_kernel_tracer()
 		kernel_tracer_fd = -1;
 	}
 
-	free(syscall_table);
+	syscall_fini_table();
 }
 
 bool kernel_tracer_is_initialized()
@@ -2145,11 +2284,12 @@ bool kernel_tracer_is_initialized()
 }
 
 /*
- *  Clear a kernel session.
+ *  Clear a kernel session. When `truncate_output` is set, the consumer also
+ *  truncates the local output files of the streams in place.
  *
  * Return LTTNG_OK on success or else an LTTng error code.
  */
-enum lttng_error_code kernel_clear_session(struct ltt_session *session)
+enum lttng_error_code kernel_clear_session(struct ltt_session *session, bool truncate_output)
 {
 	int ret;
 	enum lttng_error_code status = LTTNG_OK;
@@ -2184,7 +2324,7 @@ enum lttng_error_code kernel_clear_session(struct ltt_session *session)
 				DBG("Clear kernel channel %" PRIu64 ", session %s",
 				    chan->key,
 				    session->name);
-				ret = consumer_clear_channel(socket, chan->key);
+				ret = consumer_clear_channel(socket, chan->key, truncate_output);
 				if (ret < 0) {
 					goto error;
 				}
@@ -2204,7 +2344,7 @@ enum lttng_error_code kernel_clear_session(struct ltt_session *session)
 			 * Metadata channel is not cleared per se but we still need to
 			 * perform a rotation operation on it behind the scene.
 			 */
-			ret = consumer_clear_channel(socket, ksess->metadata->key);
+			ret = consumer_clear_channel(socket, ksess->metadata->key, truncate_output);
 			if (ret < 0) {
 				goto error;
 			}
@@ -2414,10 +2554,15 @@ static enum lttng_error_code kernel_create_event_notifier_rule(
 		}
 	}
 
-	/* Set the capture bytecode if any. */
-	cond_status = lttng_condition_event_rule_matches_get_capture_descriptor_count(
-		condition, &capture_bytecode_count);
-	LTTNG_ASSERT(cond_status == LTTNG_CONDITION_STATUS_OK);
+	/*
+	 * Set the capture bytecode if any, and if they are sent to clients by a
+	 * notify action of the trigger.
+	 */
+	if (lttng_trigger_has_notify_action(trigger)) {
+		cond_status = lttng_condition_event_rule_matches_get_capture_descriptor_count(
+			condition, &capture_bytecode_count);
+		LTTNG_ASSERT(cond_status == LTTNG_CONDITION_STATUS_OK);
+	}
 
 	for (i = 0; i < capture_bytecode_count; i++) {
 		const struct lttng_bytecode *capture_bytecode =
@@ -2505,6 +2650,10 @@ enum lttng_error_code kernel_register_event_notifier(struct lttng_trigger *trigg
 	domain_type = lttng_event_rule_get_domain_type(event_rule);
 	LTTNG_ASSERT(domain_type == LTTNG_DOMAIN_KERNEL);
 
+	if (load_probe_modules() < 0) {
+		return LTTNG_ERR_KERN_NA;
+	}
+
 	ret = kernel_create_event_notifier_rule(trigger, cmd_creds, token);
 	if (ret != LTTNG_OK) {
 		ERR("Failed to create kernel event notifier rule");
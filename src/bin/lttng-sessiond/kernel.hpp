@@ -23,6 +23,16 @@
  */
 #define KERNEL_EVENT_INIT_LIST_SIZE 64
 
+/* Event to create with kernel_create_events(). */
+struct kernel_event_batch_entry {
+	struct lttng_event *ev;
+	/* Ownership is passed to kernel_create_events(). */
+	char *filter_expression;
+	struct lttng_bytecode *filter;
+	/* Outcome of the creation of the event, set by kernel_create_events(). */
+	enum lttng_error_code status;
+};
+
 int kernel_add_channel_context(struct ltt_kernel_channel *chan, struct ltt_kernel_context *ctx);
 int kernel_create_session(struct ltt_session *session);
 int kernel_create_channel(struct ltt_kernel_session *session, struct lttng_channel *chan);
@@ -30,6 +40,13 @@ int kernel_create_event(struct lttng_event *ev,
 			struct ltt_kernel_channel *channel,
 			char *filter_expression,
 			struct lttng_bytecode *filter);
+/*
+ * Create a batch of events in a channel, setting the status of each entry.
+ * Return the number of entries whose event could not be created.
+ */
+unsigned int kernel_create_events(struct ltt_kernel_channel *channel,
+				  struct kernel_event_batch_entry *entries,
+				  unsigned int count);
 int kernel_disable_channel(struct ltt_kernel_channel *chan);
 int kernel_disable_event(struct ltt_kernel_event *event);
 int kernel_enable_event(struct ltt_kernel_event *event);
@@ -68,7 +85,7 @@ enum lttng_error_code kernel_snapshot_record(struct ltt_kernel_session *ksess,
 					     uint64_t nb_packets_per_stream);
 int kernel_syscall_mask(int chan_fd, char **syscall_mask, uint32_t *nr_bits);
 enum lttng_error_code kernel_rotate_session(struct ltt_session *session);
-enum lttng_error_code kernel_clear_session(struct ltt_session *session);
+enum lttng_error_code kernel_clear_session(struct ltt_session *session, bool truncate_output);
 
 int init_kernel_workarounds(void);
 int kernel_supports_ring_buffer_snapshot_sample_positions(void);
@@ -127,6 +127,12 @@ extern int the_kernel_poll_pipe[2];
  */
 extern long the_page_size;
 
+/*
+ * Size of the transparent huge pages of the system, or -1 if they are not
+ * available. Set in main().
+ */
+extern long the_huge_page_size;
+
 /* Application health monitoring */
 extern struct health_app *the_health_sessiond;
 
@@ -23,6 +23,16 @@ struct syscall *syscall_table;
 /* Number of entry in the syscall table. */
 static size_t syscall_table_nb_entry;
 
+/*
+ * Listing of the syscall table built once it is populated: one event per
+ * syscall name, in the order of the table, flagged with the bitnesses of the
+ * syscall.
+ */
+static struct lttng_event *syscall_events;
+static size_t syscall_events_nb_entry;
+
+static ssize_t create_syscall_events(struct lttng_event **_events);
+
 /*
  * Populate the system call table using the kernel tracer.
  *
@@ -127,6 +137,18 @@ int syscall_init_table(int tracer_fd)
 		syscall_table_nb_entry = index + 1;
 	}
 
+	{
+		const ssize_t nb_events = create_syscall_events(&syscall_events);
+
+		if (nb_events < 0) {
+			ERR("Failed to index the syscall table");
+			ret = (int) nb_events;
+			goto error;
+		}
+
+		syscall_events_nb_entry = nb_events;
+	}
+
 	ret = 0;
 
 error:
@@ -272,12 +294,13 @@ error:
 }
 
 /*
- * List syscalls present in the kernel syscall global array, allocate and
- * populate the events structure with them. Skip the empty syscall name.
+ * Create the listing of the syscalls present in the kernel syscall global
+ * array, allocate and populate the events structure with them. Skip the empty
+ * syscall name.
  *
  * Return the number of entries in the array else a negative value.
  */
-ssize_t syscall_table_list(struct lttng_event **_events)
+static ssize_t create_syscall_events(struct lttng_event **_events)
 {
 	int i, index = 0;
 	ssize_t ret;
@@ -287,8 +310,6 @@ ssize_t syscall_table_list(struct lttng_event **_events)
 
 	LTTNG_ASSERT(_events);
 
-	DBG("Syscall table listing.");
-
 	/*
 	 * Allocate at least the number of total syscall we have even if some of
 	 * them might not be valid. The count below will make sure to return the
@@ -346,3 +367,41 @@ error:
 	free(events);
 	return ret;
 }
+
+/*
+ * List syscalls present in the kernel syscall global array, allocate and
+ * populate the events structure with them.
+ *
+ * Return the number of entries in the array else a negative value.
+ */
+ssize_t syscall_table_list(struct lttng_event **_events)
+{
+	struct lttng_event *events;
+
+	LTTNG_ASSERT(_events);
+
+	DBG("Syscall table listing.");
+
+	events = calloc<lttng_event>(syscall_events_nb_entry);
+	if (!events) {
+		PERROR("syscall table list zmalloc");
+		return -LTTNG_ERR_NOMEM;
+	}
+
+	if (syscall_events_nb_entry > 0) {
+		memcpy(events, syscall_events, syscall_events_nb_entry * sizeof(*events));
+	}
+
+	*_events = events;
+	return syscall_events_nb_entry;
+}
+
+void syscall_fini_table()
+{
+	free(syscall_events);
+	syscall_events = nullptr;
+	syscall_events_nb_entry = 0;
+	free(syscall_table);
+	syscall_table = nullptr;
+	syscall_table_nb_entry = 0;
+}
@@ -44,5 +44,6 @@ extern struct syscall *syscall_table;
 /* Use to list kernel system calls. */
 int syscall_init_table(int tracer_fd);
 ssize_t syscall_table_list(struct lttng_event **events);
+void syscall_fini_table(void);
 
 #endif /* LTTNG_SYSCALL_H */
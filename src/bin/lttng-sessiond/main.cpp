@@ -38,10 +38,13 @@
 #include "testpoint.hpp"
 #include "thread.hpp"
 #include "timer.hpp"
+#include "trigger-store.hpp"
 #include "ust-consumer.hpp"
 #include "ust-sigbus.hpp"
 #include "utils.hpp"
 
+#include <common/alloc-stats.hpp>
+#include <common/async-log.hpp>
 #include <common/common.hpp>
 #include <common/compat/getenv.hpp>
 #include <common/compat/socket.hpp>
@@ -55,6 +58,7 @@
 #include <common/logging-utils.hpp>
 #include <common/path.hpp>
 #include <common/relayd/relayd.hpp>
+#include <common/slab-allocator.hpp>
 #include <common/utils.hpp>
 
 #include <lttng/event-internal.hpp>
@@ -347,6 +351,9 @@ static void sessiond_cleanup()
 		cleanup_kernel_tracer();
 	}
 
+	lttng::slab_allocator::log_all_stats();
+	lttng::alloc_stats::log_all();
+
 	/*
 	 * We do NOT rmdir rundir because there are other processes
 	 * using it, for instance lttng-relayd, which can start in
@@ -364,6 +371,7 @@ static void sessiond_cleanup_options()
 	sessiond_config_fini(&the_config);
 
 	run_as_destroy_worker();
+	lttng_async_log_fini();
 }
 
 static int string_match(const char *str1, const char *str2)
@@ -1245,6 +1253,33 @@ static void set_ulimit()
 	}
 }
 
+/*
+ * Get the size of the transparent huge pages of the system, or -1 if the
+ * kernel doesn't support them.
+ */
+static long get_huge_page_size()
+{
+	FILE *fp;
+	long huge_page_size = -1;
+
+	fp = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+	if (!fp) {
+		DBG("Transparent huge pages are not supported by the kernel");
+		goto end;
+	}
+
+	if (fscanf(fp, "%ld", &huge_page_size) != 1 || huge_page_size <= 0) {
+		WARN("Failed to read the transparent huge page size");
+		huge_page_size = -1;
+	}
+
+	if (fclose(fp)) {
+		PERROR("fclose");
+	}
+end:
+	return huge_page_size;
+}
+
 static int write_pidfile()
 {
 	return utils_create_pid_file(getpid(), the_config.pid_file_path.value);
@@ -1410,6 +1445,7 @@ static int _main(int argc, char **argv)
 	struct lttng_pipe *ust32_channel_monitor_pipe = nullptr,
 			  *ust64_channel_monitor_pipe = nullptr,
 			  *kernel_channel_monitor_pipe = nullptr;
+	struct lttng_pipe *rotation_event_pipe = nullptr;
 	struct timer_thread_parameters timer_thread_parameters;
 	/* Queue of rotation jobs populated by the sessiond-timer. */
 	lttng::sessiond::rotation_thread_timer_queue *rotation_timer_queue = nullptr;
@@ -1417,6 +1453,7 @@ static int _main(int argc, char **argv)
 	struct lttng_thread *notification_thread = nullptr;
 	struct lttng_thread *register_apps_thread = nullptr;
 	enum event_notifier_error_accounting_status event_notifier_error_accounting_status;
+	bool persistent_connection;
 
 	logger_set_thread_name("Main", false);
 	init_kernel_workarounds();
@@ -1440,6 +1477,8 @@ static int _main(int argc, char **argv)
 		WARN("Fallback page size to %ld", the_page_size);
 	}
 
+	the_huge_page_size = get_huge_page_size();
+
 	ret = sessiond_config_init(&the_config);
 	if (ret) {
 		retval = -1;
@@ -1540,6 +1579,11 @@ static int _main(int argc, char **argv)
 	 * lttng_daemonize due to RCU.
 	 */
 
+	if (lttng_async_log_init_from_env()) {
+		retval = -1;
+		goto exit_create_run_as_worker_cleanup;
+	}
+
 	/*
 	 * Initialize the health check subsystem. This call should set the
 	 * appropriate time values.
@@ -1605,6 +1649,21 @@ static int _main(int argc, char **argv)
 	}
 	timer_thread_parameters.rotation_thread_job_queue = rotation_timer_queue;
 
+	/*
+	 * The consumers share the pipe on which they announce the release of
+	 * the closed trace chunks and the sizes they consume to the rotation
+	 * thread.
+	 */
+	rotation_event_pipe = lttng_pipe_open(FD_CLOEXEC | O_NONBLOCK);
+	if (!rotation_event_pipe) {
+		ERR("Failed to create rotation event pipe");
+		retval = -1;
+		goto stop_threads;
+	}
+	the_kconsumer_data.rotation_event_pipe = lttng_pipe_get_writefd(rotation_event_pipe);
+	the_ustconsumer32_data.rotation_event_pipe = lttng_pipe_get_writefd(rotation_event_pipe);
+	the_ustconsumer64_data.rotation_event_pipe = lttng_pipe_get_writefd(rotation_event_pipe);
+
 	ust64_channel_monitor_pipe = lttng_pipe_open(0);
 	if (!ust64_channel_monitor_pipe) {
 		ERR("Failed to create 64-bit user space consumer channel monitor pipe");
@@ -1771,7 +1830,9 @@ static int _main(int argc, char **argv)
 
 	try {
 		the_rotation_thread_handle = lttng::make_unique<lttng::sessiond::rotation_thread>(
-			*rotation_timer_queue, *the_notification_thread_handle);
+			*rotation_timer_queue,
+			*the_notification_thread_handle,
+			*rotation_event_pipe);
 	} catch (const std::exception& e) {
 		retval = -1;
 		ERR("Failed to create rotation thread: %s", e.what());
@@ -1786,6 +1847,12 @@ static int _main(int argc, char **argv)
 		goto stop_threads;
 	}
 
+	/* Register the stored triggers before the clients and applications connect. */
+	if (trigger_store_init()) {
+		retval = -1;
+		goto stop_threads;
+	}
+
 	/* Create thread to manage the client socket */
 	client_thread = launch_client_thread();
 	if (!client_thread) {
@@ -1850,8 +1917,13 @@ static int _main(int argc, char **argv)
 		}
 	}
 
-	/* Load sessions. */
+	/* Load sessions, replaying their commands over a single client connection. */
+	persistent_connection = lttng_session_daemon_connection_open() == 0;
 	ret = config_load_session(the_config.load_session_path.value, nullptr, 1, 1, nullptr);
+	if (persistent_connection) {
+		lttng_session_daemon_connection_close();
+	}
+
 	if (ret) {
 		ERR("Session load failed: %s", error_get_str(ret));
 		retval = -1;
@@ -1889,6 +1961,7 @@ stop_threads:
 	 * running/rotating) and clients can't connect to the session daemon
 	 * anymore. Unregister all triggers.
 	 */
+	trigger_store_fini();
 	unregister_all_triggers();
 
 	if (register_apps_thread) {
@@ -1959,6 +2032,7 @@ stop_threads:
 	lttng_pipe_destroy(ust32_channel_monitor_pipe);
 	lttng_pipe_destroy(ust64_channel_monitor_pipe);
 	lttng_pipe_destroy(kernel_channel_monitor_pipe);
+	lttng_pipe_destroy(rotation_event_pipe);
 
 	if (the_health_sessiond) {
 		health_app_destroy(the_health_sessiond);
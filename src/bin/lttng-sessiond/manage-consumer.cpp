@@ -255,6 +255,13 @@ static void *thread_consumer_management(void *data)
 		goto error;
 	}
 
+	ret = consumer_send_rotation_event_pipe(cmd_socket_wrapper,
+						     consumer_data->rotation_event_pipe);
+	if (ret) {
+		mark_thread_intialization_as_failed(notifiers);
+		goto error;
+	}
+
 	/* Discard the socket wrapper as it is no longer needed. */
 	consumer_destroy_socket(cmd_socket_wrapper);
 	cmd_socket_wrapper = nullptr;
@@ -21,9 +21,12 @@
 #include <common/common.hpp>
 #include <common/utils.hpp>
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/wait.h>
+#include <urcu/uatomic.h>
+#include <vector>
 
 /* LTTng kernel tracer mandatory core modules list */
 struct kern_modules_param kern_modules_control_core[] = {
@@ -356,6 +359,46 @@ error:
 	return ret;
 }
 
+/**
+ * @brief Loads the kernel module \p module
+ *
+ * @param ctx		libkmod context
+ * @param module	Module to load
+ *
+ * @returns		\c 0 on success or if an optional module failed to load
+ * 			\c < 0 on error
+ */
+static int modprobe_lttng_module(struct kmod_ctx *ctx, struct kern_modules_param *module)
+{
+	int ret;
+	struct kmod_module *mod = nullptr;
+
+	ret = kmod_module_new_from_name(ctx, module->name, &mod);
+	if (ret < 0) {
+		PERROR("Failed to create kmod module for %s", module->name);
+		return ret;
+	}
+
+	ret = kmod_module_probe_insert_module(mod, 0, nullptr, nullptr, nullptr, nullptr);
+	if (ret == -EEXIST) {
+		DBG("Module %s is already loaded", module->name);
+		ret = 0;
+	} else if (ret < 0) {
+		if (module->load_policy == KERNEL_MODULE_PROPERTY_LOAD_POLICY_REQUIRED) {
+			ERR("Unable to load required module %s", module->name);
+		} else {
+			DBG("Unable to load optional module %s; continuing", module->name);
+			ret = 0;
+		}
+	} else {
+		DBG("Modprobe successfully %s", module->name);
+		module->loaded = true;
+	}
+
+	kmod_module_unref(mod);
+	return ret;
+}
+
 /**
  * @brief Loads the kernel modules in \p modules
  *
@@ -379,40 +422,131 @@ static int modprobe_lttng(struct kern_modules_param *modules, int entries)
 	}
 
 	for (i = 0; i < entries; i++) {
-		struct kmod_module *mod = nullptr;
-
-		ret = kmod_module_new_from_name(ctx, modules[i].name, &mod);
+		ret = modprobe_lttng_module(ctx, &modules[i]);
 		if (ret < 0) {
-			PERROR("Failed to create kmod module for %s", modules[i].name);
 			goto error;
 		}
+	}
 
-		ret = kmod_module_probe_insert_module(mod, 0, nullptr, nullptr, nullptr, nullptr);
-		if (ret == -EEXIST) {
-			DBG("Module %s is already loaded", modules[i].name);
-			ret = 0;
-		} else if (ret < 0) {
-			if (modules[i].load_policy == KERNEL_MODULE_PROPERTY_LOAD_POLICY_REQUIRED) {
-				ERR("Unable to load required module %s", modules[i].name);
-				goto error;
-			} else {
-				DBG("Unable to load optional module %s; continuing",
-				    modules[i].name);
-				ret = 0;
-			}
-		} else {
-			DBG("Modprobe successfully %s", modules[i].name);
-			modules[i].loaded = true;
+error:
+	if (ctx) {
+		kmod_unref(ctx);
+	}
+	return ret;
+}
+
+namespace {
+/* Modules loaded by several threads, each taking the next module to load. */
+struct modprobe_job {
+	struct kern_modules_param *modules;
+	int entries;
+	/* Updated atomically. */
+	int next_module;
+	/* First error, updated atomically. */
+	int ret;
+};
+
+void run_modprobe_job(struct modprobe_job *job)
+{
+	int ret;
+	struct kmod_ctx *ctx;
+
+	/* libkmod contexts can't be shared between threads. */
+	ret = setup_kmod_ctx(&ctx);
+	if (ret < 0) {
+		goto end;
+	}
+
+	while (!uatomic_read(&job->ret)) {
+		const int i = uatomic_add_return(&job->next_module, 1) - 1;
+
+		if (i >= job->entries) {
+			break;
 		}
 
-		kmod_module_unref(mod);
+		ret = modprobe_lttng_module(ctx, &job->modules[i]);
+		if (ret < 0) {
+			break;
+		}
 	}
 
-error:
+end:
 	if (ctx) {
 		kmod_unref(ctx);
 	}
-	return ret;
+	if (ret < 0) {
+		(void) uatomic_cmpxchg(&job->ret, 0, ret);
+	}
+}
+
+void *modprobe_worker(void *data)
+{
+	run_modprobe_job((struct modprobe_job *) data);
+	return nullptr;
+}
+} /* namespace */
+
+/**
+ * @brief Loads the kernel modules in \p modules using up to
+ * \p thread_count threads
+ *
+ * The modules are loaded in no particular order. If a required module
+ * fails to load, the modules which are not being loaded yet are not
+ * loaded.
+ *
+ * @returns		\c 0 on success
+ * 			\c < 0 on error
+ */
+static int modprobe_lttng_concurrently(struct kern_modules_param *modules,
+				       int entries,
+				       unsigned int thread_count)
+{
+	struct modprobe_job job = {};
+	std::vector<pthread_t> workers;
+	unsigned int worker_count;
+
+	if (entries <= 1 || thread_count <= 1) {
+		return modprobe_lttng(modules, entries);
+	}
+
+	worker_count = std::min<unsigned int>(thread_count, entries) - 1;
+	job.modules = modules;
+	job.entries = entries;
+
+	try {
+		workers.reserve(worker_count);
+	} catch (const std::bad_alloc&) {
+		return modprobe_lttng(modules, entries);
+	}
+
+	for (unsigned int i = 0; i < worker_count; i++) {
+		pthread_t worker;
+		const int create_ret =
+			pthread_create(&worker, default_pthread_attr(), modprobe_worker, &job);
+
+		if (create_ret) {
+			/* Carry on with the threads launched so far. */
+			errno = create_ret;
+			PERROR("Failed to launch module loading thread");
+			break;
+		}
+
+		workers.push_back(worker);
+	}
+
+	/* The calling thread loads modules too. */
+	run_modprobe_job(&job);
+
+	for (const auto worker : workers) {
+		const int join_ret = pthread_join(worker, nullptr);
+
+		if (join_ret) {
+			errno = join_ret;
+			PERROR("Failed to join module loading thread");
+		}
+	}
+
+	return job.ret;
 }
 
 /**
@@ -556,6 +690,14 @@ error:
 	return ret;
 }
 
+/* modprobe(8) is launched with system(3), which can't be used by several threads. */
+static int modprobe_lttng_concurrently(struct kern_modules_param *modules,
+				       int entries,
+				       unsigned int thread_count __attribute__((unused)))
+{
+	return modprobe_lttng(modules, entries);
+}
+
 static void modprobe_remove_lttng(const struct kern_modules_param *modules, int entries)
 {
 	int ret = 0, i;
@@ -821,7 +963,8 @@ int modprobe_lttng_data()
 	/*
 	 * Load probes modules now.
 	 */
-	ret = modprobe_lttng(probes, nr_probes);
+	ret = modprobe_lttng_concurrently(
+		probes, nr_probes, the_config.kmod_probes_load_thread_count);
 	if (ret) {
 		goto error;
 	}
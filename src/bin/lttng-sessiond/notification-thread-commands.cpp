@@ -137,6 +137,30 @@ end:
 	return ret_code;
 }
 
+enum lttng_error_code
+notification_thread_command_register_triggers(struct notification_thread_handle *handle,
+					      const struct lttng_triggers *triggers)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	notification_thread_command cmd;
+
+	LTTNG_ASSERT(triggers);
+	init_notification_thread_command(&cmd);
+
+	cmd.type = NOTIFICATION_COMMAND_TYPE_REGISTER_TRIGGERS;
+	cmd.parameters.register_triggers.triggers = triggers;
+
+	ret = run_command_wait(handle, &cmd);
+	if (ret) {
+		ret_code = LTTNG_ERR_UNK;
+		goto end;
+	}
+	ret_code = cmd.reply_code;
+end:
+	return ret_code;
+}
+
 enum lttng_error_code
 notification_thread_command_unregister_trigger(struct notification_thread_handle *handle,
 					       const struct lttng_trigger *trigger)
@@ -450,40 +474,3 @@ notification_thread_command_get_trigger(struct notification_thread_handle *handl
 end:
 	return ret_code;
 }
-
-/*
- * Takes ownership of the payload if present.
- */
-struct lttng_event_notifier_notification *lttng_event_notifier_notification_create(
-	uint64_t tracer_token, enum lttng_domain_type domain, char *payload, size_t payload_size)
-{
-	struct lttng_event_notifier_notification *notification = nullptr;
-
-	LTTNG_ASSERT(domain != LTTNG_DOMAIN_NONE);
-	LTTNG_ASSERT((payload && payload_size) || (!payload && !payload_size));
-
-	notification = zmalloc<lttng_event_notifier_notification>();
-	if (notification == nullptr) {
-		ERR("Error allocating notification");
-		goto end;
-	}
-
-	notification->tracer_token = tracer_token;
-	notification->type = domain;
-	notification->capture_buffer = payload;
-	notification->capture_buf_size = payload_size;
-
-end:
-	return notification;
-}
-
-void lttng_event_notifier_notification_destroy(
-	struct lttng_event_notifier_notification *notification)
-{
-	if (!notification) {
-		return;
-	}
-
-	free(notification->capture_buffer);
-	free(notification);
-}
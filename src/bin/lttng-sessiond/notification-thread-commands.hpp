@@ -40,6 +40,7 @@ enum notification_thread_command_type {
 	NOTIFICATION_COMMAND_TYPE_QUIT,
 	NOTIFICATION_COMMAND_TYPE_CLIENT_COMMUNICATION_UPDATE,
 	NOTIFICATION_COMMAND_TYPE_GET_TRIGGER,
+	NOTIFICATION_COMMAND_TYPE_REGISTER_TRIGGERS,
 };
 
 struct notification_thread_command {
@@ -52,6 +53,10 @@ struct notification_thread_command {
 			struct lttng_trigger *trigger;
 			bool is_trigger_anonymous;
 		} register_trigger;
+		/* Register triggers, with generated names. */
+		struct {
+			const struct lttng_triggers *triggers;
+		} register_triggers;
 		/* Unregister trigger. */
 		struct {
 			const struct lttng_trigger *trigger;
@@ -132,6 +137,14 @@ notification_thread_command_register_trigger(struct notification_thread_handle *
 					     struct lttng_trigger *trigger,
 					     bool is_anonymous_trigger);
 
+/*
+ * Register a set of triggers, generating their names: either all of them
+ * are registered, or none is.
+ */
+enum lttng_error_code
+notification_thread_command_register_triggers(struct notification_thread_handle *handle,
+					      const struct lttng_triggers *triggers);
+
 enum lttng_error_code
 notification_thread_command_unregister_trigger(struct notification_thread_handle *handle,
 					       const struct lttng_trigger *trigger);
@@ -24,12 +24,14 @@
 #include <common/macros.hpp>
 #include <common/pthread-lock.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/slab-allocator.hpp>
+#include <common/time.hpp>
 #include <common/unix.hpp>
 #include <common/urcu.hpp>
 
 #include <lttng/action/action-internal.hpp>
-#include <lttng/action/list-internal.hpp>
 #include <lttng/condition/buffer-usage-internal.hpp>
+#include <lttng/condition/channel-rate-internal.hpp>
 #include <lttng/condition/condition-internal.hpp>
 #include <lttng/condition/condition.h>
 #include <lttng/condition/event-rule-matches-internal.hpp>
@@ -42,8 +44,10 @@
 #include <lttng/notification/notification-internal.hpp>
 #include <lttng/trigger/trigger-internal.hpp>
 
+#include <algorithm>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <sys/ioctl.h>
 #include <time.h>
 #include <unistd.h>
 #include <urcu.h>
@@ -55,6 +59,30 @@
 /* The tracers currently limit the capture size to PIPE_BUF (4kb on linux). */
 #define MAX_CAPTURE_SIZE (PIPE_BUF)
 
+/* Notifications queued while the outbound queue of their client is full. */
+static lttng::slab_allocator
+	deferred_notification_allocator("notification_client_deferred_notification",
+					sizeof(struct notification_client_deferred_notification));
+
+/*
+ * Maximal number of event notifier notifications handled for a tracer event
+ * source before going back to the poll set, to let the commands and the other
+ * sources be serviced.
+ */
+#define MAX_EVENT_NOTIFIER_NOTIFICATIONS_PER_WAKEUP 64
+
+/*
+ * Size of the buffer in which the notifications of a tracer event source are
+ * read, as many at a time as it holds.
+ */
+#define EVENT_NOTIFIER_RECEPTION_BUFFER_SIZE (4 * PIPE_BUF)
+
+/*
+ * Maximal number of samples kept per channel to evaluate its channel rate
+ * conditions; the rates of longer windows are measured over the samples kept.
+ */
+#define CHANNEL_RATE_HISTORY_MAX_SAMPLES 4096
+
 enum lttng_object_type {
 	LTTNG_OBJECT_TYPE_UNKNOWN,
 	LTTNG_OBJECT_TYPE_NONE,
@@ -62,10 +90,37 @@ enum lttng_object_type {
 	LTTNG_OBJECT_TYPE_SESSION,
 };
 
+/*
+ * Buffer usage threshold of a trigger applying to a channel, or consumed size
+ * threshold of a trigger applying to a session, in bytes.
+ */
+struct trigger_threshold {
+	uint64_t threshold;
+	struct lttng_trigger *trigger;
+};
+
 struct lttng_channel_trigger_list {
 	struct channel_key channel_key;
 	/* List of struct lttng_trigger_list_element. */
 	struct cds_list_head list;
+	/*
+	 * Thresholds of the high and low buffer usage triggers of the list,
+	 * sorted by increasing threshold to only evaluate the conditions of
+	 * the thresholds crossed by a new sample. Rebuilt when the next sample
+	 * is received once `thresholds_stale` is set.
+	 */
+	struct trigger_threshold *high_thresholds;
+	size_t high_threshold_count;
+	struct trigger_threshold *low_thresholds;
+	size_t low_threshold_count;
+	bool thresholds_stale;
+	/*
+	 * Channel rate triggers of the list, evaluated on every sample, and
+	 * the longest of their windows. Rebuilt with the thresholds.
+	 */
+	struct lttng_trigger **rate_triggers;
+	size_t rate_trigger_count;
+	uint64_t max_rate_window_us;
 	/* Node in the channel_triggers_ht */
 	struct cds_lfht_node channel_triggers_ht_node;
 	/* call_rcu delayed reclaim. */
@@ -85,6 +140,15 @@ struct lttng_session_trigger_list {
 	char *session_name;
 	/* List of struct lttng_trigger_list_element. */
 	struct cds_list_head list;
+	/*
+	 * Thresholds of the consumed size triggers of the list, sorted by
+	 * increasing threshold to only evaluate the conditions of the
+	 * thresholds crossed by a new sample. Rebuilt when the next sample is
+	 * received once `thresholds_stale` is set.
+	 */
+	struct trigger_threshold *consumed_size_thresholds;
+	size_t consumed_size_threshold_count;
+	bool thresholds_stale;
 	/* Node in the session_triggers_ht */
 	struct cds_lfht_node session_triggers_ht_node;
 	/*
@@ -127,17 +191,77 @@ struct lttng_trigger_ht_element {
 
 struct lttng_condition_list_element {
 	struct lttng_condition *condition;
+	enum lttng_notification_channel_overflow_policy overflow_policy;
+	unsigned int overflow_queue_size;
 	struct cds_list_head node;
 };
 
+/*
+ * Cumulative statistics of a channel when one of its monitor samples was
+ * received, to evaluate the channel rate conditions.
+ */
+struct channel_rate_sample {
+	/* Monotonic time of reception, in microseconds. */
+	uint64_t timestamp_us;
+	uint64_t consumed_bytes;
+	uint64_t discarded_events;
+	uint64_t lost_packets;
+};
+
+/*
+ * Samples of a channel, oldest first, covering the longest window of the
+ * channel rate triggers of the channel as of its latest sample.
+ */
+struct channel_rate_history {
+	struct channel_rate_sample *samples;
+	size_t count;
+	size_t capacity;
+};
+
 struct channel_state_sample {
 	struct channel_key key;
 	struct cds_lfht_node channel_state_ht_node;
 	uint64_t highest_usage;
 	uint64_t lowest_usage;
+	/* Sum of the bytes consumed since the first sample. */
+	uint64_t consumed_bytes;
+	/* Bytes written to the trace files which the kernel has yet to write back. */
+	uint64_t writeback_bytes_in_flight;
+	/* Null while no channel rate trigger applies to the channel. */
+	struct channel_rate_history *rate_history;
 	/* call_rcu delayed reclaim. */
 	struct rcu_head rcu_node;
 };
+
+/*
+ * State shared by the event notifier notifications read in a row from a
+ * tracer event source, within a single RCU read-side critical section.
+ */
+struct event_notifier_notification_batch {
+	/*
+	 * Notifications read from the event source, of which those from
+	 * `reception_offset` to `reception_len` are not dispatched yet.
+	 */
+	char reception_buffer[EVENT_NOTIFIER_RECEPTION_BUFFER_SIZE];
+	size_t reception_len;
+	size_t reception_offset;
+	/*
+	 * Capture payload of the notification being dispatched, when it is
+	 * split across two reads of the event source.
+	 */
+	char capture_buffer[MAX_CAPTURE_SIZE];
+	/*
+	 * The trigger of the last dispatched notification, and its client
+	 * list, are reused by the following notifications having the same
+	 * token. The triggers are only unregistered by the notification
+	 * thread, between the batches.
+	 */
+	bool trigger_cached;
+	uint64_t cached_token;
+	/* Null if no trigger has the cached token. */
+	struct notification_trigger_tokens_ht_element *cached_element;
+	struct notification_client_list *cached_client_list;
+};
 } /* namespace */
 
 static unsigned long hash_channel_key(struct channel_key *key);
@@ -183,9 +307,14 @@ static int client_handle_transmission_status(struct notification_client *client,
 					     enum client_transmission_status transmission_status,
 					     struct notification_thread_state *state);
 
+static void event_notifier_notification_batch_init(struct event_notifier_notification_batch *batch);
+static void event_notifier_notification_batch_fini(struct event_notifier_notification_batch *batch);
+static bool event_notifier_notification_batch_has_received(
+	const struct event_notifier_notification_batch *batch);
 static int handle_one_event_notifier_notification(struct notification_thread_state *state,
 						  int pipe,
-						  enum lttng_domain_type domain);
+						  enum lttng_domain_type domain,
+						  struct event_notifier_notification_batch *batch);
 
 static void free_lttng_trigger_ht_element_rcu(struct rcu_head *node);
 
@@ -199,6 +328,18 @@ static int match_client_socket(struct cds_lfht_node *node, const void *key)
 	return client->socket == socket;
 }
 
+static int match_tracer_event_source_fd(struct cds_lfht_node *node, const void *key)
+{
+	/* This double-cast is intended to supress pointer-to-cast warning. */
+	const int fd = (int) (intptr_t) key;
+	const struct notification_event_tracer_event_source_element *element =
+		caa_container_of(node,
+				 struct notification_event_tracer_event_source_element,
+				 tracer_event_sources_ht_node);
+
+	return element->fd == fd;
+}
+
 static int match_client_id(struct cds_lfht_node *node, const void *key)
 {
 	/* This double-cast is intended to supress pointer-to-cast warning. */
@@ -365,6 +506,8 @@ static const char *notification_command_type_str(enum notification_thread_comman
 		return "LIST_TRIGGERS";
 	case NOTIFICATION_COMMAND_TYPE_GET_TRIGGER:
 		return "GET_TRIGGER";
+	case NOTIFICATION_COMMAND_TYPE_REGISTER_TRIGGERS:
+		return "REGISTER_TRIGGERS";
 	case NOTIFICATION_COMMAND_TYPE_QUIT:
 		return "QUIT";
 	case NOTIFICATION_COMMAND_TYPE_CLIENT_COMMUNICATION_UPDATE:
@@ -474,6 +617,8 @@ static enum lttng_object_type get_condition_binding_object(const struct lttng_co
 	switch (lttng_condition_get_type(condition)) {
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_LOW:
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_HIGH:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
 		return LTTNG_OBJECT_TYPE_CHANNEL;
 	case LTTNG_CONDITION_TYPE_SESSION_ROTATION_ONGOING:
 	case LTTNG_CONDITION_TYPE_SESSION_ROTATION_COMPLETED:
@@ -679,20 +824,31 @@ static void notification_client_list_release(struct urcu_ref *list_ref)
 	call_rcu(&list->rcu_node, free_notification_client_list_rcu);
 }
 
-static bool condition_applies_to_client(const struct lttng_condition *condition,
-					struct notification_client *client)
+/* Return the subscription of a client to a condition, or null if it isn't subscribed. */
+static const struct lttng_condition_list_element *
+get_client_subscription(const struct lttng_condition *condition,
+			const struct notification_client *client)
 {
-	bool applies = false;
-	struct lttng_condition_list_element *condition_list_element;
+	const struct lttng_condition_list_element *condition_list_element;
 
 	cds_list_for_each_entry (condition_list_element, &client->condition_list, node) {
-		applies = lttng_condition_is_equal(condition_list_element->condition, condition);
-		if (applies) {
-			break;
+		if (lttng_condition_is_equal(condition_list_element->condition, condition)) {
+			return condition_list_element;
 		}
 	}
 
-	return applies;
+	return nullptr;
+}
+
+static void client_list_element_init(struct notification_client_list_element *client_list_element,
+				     struct notification_client *client,
+				     const struct lttng_condition_list_element *subscription)
+{
+	CDS_INIT_LIST_HEAD(&client_list_element->node);
+	client_list_element->client = client;
+	client_list_element->subscription = subscription;
+	client_list_element->overflow_policy = subscription->overflow_policy;
+	client_list_element->overflow_queue_size = subscription->overflow_queue_size;
 }
 
 static struct notification_client_list *
@@ -733,8 +889,10 @@ notification_client_list_create(struct notification_thread_state *state,
 		cds_lfht_for_each_entry (
 			state->client_socket_ht, &iter, client, client_socket_ht_node) {
 			struct notification_client_list_element *client_list_element;
+			const struct lttng_condition_list_element *subscription =
+				get_client_subscription(condition, client);
 
-			if (!condition_applies_to_client(condition, client)) {
+			if (!subscription) {
 				continue;
 			}
 
@@ -743,8 +901,7 @@ notification_client_list_create(struct notification_thread_state *state,
 				goto error_put_client_list;
 			}
 
-			CDS_INIT_LIST_HEAD(&client_list_element->node);
-			client_list_element->client = client;
+			client_list_element_init(client_list_element, client, subscription);
 			cds_list_add(&client_list_element->node, &client_list->clients_list);
 		}
 	}
@@ -903,6 +1060,10 @@ static const char *get_condition_session_name(const struct lttng_condition *cond
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_HIGH:
 		status = lttng_condition_buffer_usage_get_session_name(condition, &session_name);
 		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		status = lttng_condition_channel_rate_get_session_name(condition, &session_name);
+		break;
 	case LTTNG_CONDITION_TYPE_SESSION_CONSUMED_SIZE:
 		status = lttng_condition_session_consumed_size_get_session_name(condition,
 										&session_name);
@@ -930,15 +1091,20 @@ static bool evaluate_session_rotation_ongoing_condition(const struct lttng_condi
 	return sample->rotation.ongoing;
 }
 
-static bool evaluate_session_consumed_size_condition(const struct lttng_condition *condition,
-						     const struct session_state_sample *sample)
+static uint64_t session_consumed_size_condition_threshold(const struct lttng_condition *condition)
 {
-	uint64_t threshold;
 	const struct lttng_condition_session_consumed_size *size_condition =
 		lttng::utils::container_of(condition,
 					   &lttng_condition_session_consumed_size::parent);
 
-	threshold = size_condition->consumed_threshold_bytes.value;
+	return size_condition->consumed_threshold_bytes.value;
+}
+
+static bool evaluate_session_consumed_size_condition(const struct lttng_condition *condition,
+						     const struct session_state_sample *sample)
+{
+	const uint64_t threshold = session_consumed_size_condition_threshold(condition);
+
 	DBG("Session consumed size condition being evaluated: threshold = %" PRIu64
 	    ", current size = %" PRIu64,
 	    threshold,
@@ -1058,10 +1224,11 @@ end:
 }
 
 static int evaluate_condition_for_client(const struct lttng_trigger *trigger,
-					 const struct lttng_condition *condition,
+					 const struct lttng_condition_list_element *subscription,
 					 struct notification_client *client,
 					 struct notification_thread_state *state)
 {
+	const struct lttng_condition *condition = subscription->condition;
 	int ret;
 	struct lttng_evaluation *evaluation = nullptr;
 	struct notification_client_list client_list = {
@@ -1135,8 +1302,7 @@ static int evaluate_condition_for_client(const struct lttng_trigger *trigger,
 	cds_lfht_node_init(&client_list.notification_trigger_clients_ht_node);
 	CDS_INIT_LIST_HEAD(&client_list.clients_list);
 
-	CDS_INIT_LIST_HEAD(&client_list_element.node);
-	client_list_element.client = client;
+	client_list_element_init(&client_list_element, client, subscription);
 	cds_list_add(&client_list_element.node, &client_list.clients_list);
 
 	/* Send evaluation result to the newly-subscribed client. */
@@ -1148,10 +1314,13 @@ end:
 	return ret;
 }
 
-static int notification_thread_client_subscribe(struct notification_client *client,
-						struct lttng_condition *condition,
-						struct notification_thread_state *state,
-						enum lttng_notification_channel_status *_status)
+static int notification_thread_client_subscribe(
+	struct notification_client *client,
+	struct lttng_condition *condition,
+	enum lttng_notification_channel_overflow_policy overflow_policy,
+	unsigned int overflow_queue_size,
+	struct notification_thread_state *state,
+	enum lttng_notification_channel_status *_status)
 {
 	int ret = 0;
 	struct notification_client_list *client_list = nullptr;
@@ -1187,6 +1356,8 @@ static int notification_thread_client_subscribe(struct notification_client *clie
 	 */
 	CDS_INIT_LIST_HEAD(&condition_list_element->node);
 	condition_list_element->condition = condition;
+	condition_list_element->overflow_policy = overflow_policy;
+	condition_list_element->overflow_queue_size = overflow_queue_size;
 	condition = nullptr;
 	cds_list_add(&condition_list_element->node, &client->condition_list);
 
@@ -1214,10 +1385,8 @@ static int notification_thread_client_subscribe(struct notification_client *clie
 	pthread_mutex_lock(&client_list->lock);
 	cds_list_for_each_entry (
 		trigger_ht_element, &client_list->triggers_list, client_list_trigger_node) {
-		if (evaluate_condition_for_client(trigger_ht_element->trigger,
-						  condition_list_element->condition,
-						  client,
-						  state)) {
+		if (evaluate_condition_for_client(
+			    trigger_ht_element->trigger, condition_list_element, client, state)) {
 			WARN("Evaluation of a condition on client subscription failed, aborting.");
 			ret = -1;
 			free(client_list_element);
@@ -1232,8 +1401,7 @@ static int notification_thread_client_subscribe(struct notification_client *clie
 	 * if a "notification" trigger with a corresponding condition was
 	 * added prior.
 	 */
-	client_list_element->client = client;
-	CDS_INIT_LIST_HEAD(&client_list_element->node);
+	client_list_element_init(client_list_element, client, condition_list_element);
 
 	pthread_mutex_lock(&client_list->lock);
 	cds_list_add(&client_list_element->node, &client_list->clients_list);
@@ -1254,6 +1422,33 @@ error:
 	return ret;
 }
 
+static void
+deferred_notification_destroy(struct notification_client_deferred_notification *deferred)
+{
+	cds_list_del(&deferred->node);
+	lttng_payload_reset(&deferred->message);
+	deferred_notification_allocator.free(deferred);
+}
+
+/*
+ * Discard the deferred notifications of a subscription of a client, or all of
+ * them if `subscription` is null.
+ *
+ * Client lock must be acquired by caller.
+ */
+static void client_discard_deferred_notifications(struct notification_client *client,
+						  const void *subscription)
+{
+	struct notification_client_deferred_notification *deferred, *tmp;
+
+	cds_list_for_each_entry_safe (
+		deferred, tmp, &client->communication.outbound.deferred_notifications, node) {
+		if (!subscription || deferred->subscription == subscription) {
+			deferred_notification_destroy(deferred);
+		}
+	}
+}
+
 static int notification_thread_client_unsubscribe(struct notification_client *client,
 						  struct lttng_condition *condition,
 						  struct notification_thread_state *state,
@@ -1262,6 +1457,7 @@ static int notification_thread_client_unsubscribe(struct notification_client *cl
 	struct notification_client_list *client_list;
 	struct lttng_condition_list_element *condition_list_element, *condition_tmp;
 	struct notification_client_list_element *client_list_element, *client_tmp;
+	const void *subscription = nullptr;
 	bool condition_found = false;
 	enum lttng_notification_channel_status status = LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
 
@@ -1281,6 +1477,7 @@ static int notification_thread_client_unsubscribe(struct notification_client *cl
 		if (condition != condition_list_element->condition) {
 			lttng_condition_destroy(condition_list_element->condition);
 		}
+		subscription = condition_list_element;
 		free(condition_list_element);
 		condition_found = true;
 		break;
@@ -1297,7 +1494,7 @@ static int notification_thread_client_unsubscribe(struct notification_client *cl
 	 */
 	client_list = get_client_list_from_condition(state, condition);
 	if (!client_list) {
-		goto end;
+		goto discard_deferred;
 	}
 
 	pthread_mutex_lock(&client_list->lock);
@@ -1313,6 +1510,15 @@ static int notification_thread_client_unsubscribe(struct notification_client *cl
 	pthread_mutex_unlock(&client_list->lock);
 	notification_client_list_put(client_list);
 	client_list = nullptr;
+
+discard_deferred:
+	/*
+	 * No notification of the subscription can be deferred anymore once the
+	 * client is removed from the client list.
+	 */
+	pthread_mutex_lock(&client->lock);
+	client_discard_deferred_notifications(client, subscription);
+	pthread_mutex_unlock(&client->lock);
 end:
 	lttng_condition_destroy(condition);
 	if (_status) {
@@ -1341,6 +1547,7 @@ static void notification_client_destroy(struct notification_client *client)
 		client->socket = -1;
 	}
 	client->communication.active = false;
+	client_discard_deferred_notifications(client, nullptr);
 	lttng_payload_reset(&client->communication.inbound.payload);
 	lttng_payload_reset(&client->communication.outbound.payload);
 	pthread_mutex_destroy(&client->lock);
@@ -1431,6 +1638,30 @@ fail:
 	return false;
 }
 
+static bool channel_rate_condition_applies_to_channel(const struct lttng_condition *condition,
+						      const struct channel_info *channel_info)
+{
+	enum lttng_condition_status status;
+	enum lttng_domain_type condition_domain;
+	const char *condition_session_name = nullptr;
+	const char *condition_channel_name = nullptr;
+
+	status = lttng_condition_channel_rate_get_domain_type(condition, &condition_domain);
+	LTTNG_ASSERT(status == LTTNG_CONDITION_STATUS_OK);
+	if (channel_info->key.domain != condition_domain) {
+		return false;
+	}
+
+	status = lttng_condition_channel_rate_get_session_name(condition, &condition_session_name);
+	LTTNG_ASSERT((status == LTTNG_CONDITION_STATUS_OK) && condition_session_name);
+
+	status = lttng_condition_channel_rate_get_channel_name(condition, &condition_channel_name);
+	LTTNG_ASSERT((status == LTTNG_CONDITION_STATUS_OK) && condition_channel_name);
+
+	return strcmp(channel_info->session_info->name, condition_session_name) == 0 &&
+		strcmp(channel_info->name, condition_channel_name) == 0;
+}
+
 static bool trigger_applies_to_channel(const struct lttng_trigger *trigger,
 				       const struct channel_info *channel_info)
 {
@@ -1448,6 +1679,11 @@ static bool trigger_applies_to_channel(const struct lttng_trigger *trigger,
 		trigger_applies =
 			buffer_usage_condition_applies_to_channel(condition, channel_info);
 		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		trigger_applies =
+			channel_rate_condition_applies_to_channel(condition, channel_info);
+		break;
 	default:
 		goto fail;
 	}
@@ -1531,6 +1767,7 @@ static void free_session_trigger_list_rcu(struct rcu_head *node)
 		caa_container_of(node, struct lttng_session_trigger_list, rcu_node);
 
 	free(list->session_name);
+	free(list->consumed_size_thresholds);
 	free(list);
 }
 
@@ -1562,6 +1799,7 @@ static int lttng_session_trigger_list_add(struct lttng_session_trigger_list *lis
 	CDS_INIT_LIST_HEAD(&new_element->node);
 	new_element->trigger = trigger;
 	cds_list_add(&new_element->node, &list->list);
+	list->thresholds_stale = true;
 end:
 	return ret;
 }
@@ -1749,6 +1987,7 @@ static int handle_notification_thread_command_add_channel(struct notification_th
 	}
 	channel_trigger_list->channel_key = new_channel_info->key;
 	CDS_INIT_LIST_HEAD(&channel_trigger_list->list);
+	channel_trigger_list->thresholds_stale = true;
 	cds_lfht_node_init(&channel_trigger_list->channel_triggers_ht_node);
 	cds_list_splice(&trigger_list, &channel_trigger_list->list);
 
@@ -1842,12 +2081,32 @@ end:
 
 static void free_channel_trigger_list_rcu(struct rcu_head *node)
 {
-	free(caa_container_of(node, struct lttng_channel_trigger_list, rcu_node));
+	struct lttng_channel_trigger_list *trigger_list =
+		caa_container_of(node, struct lttng_channel_trigger_list, rcu_node);
+
+	free(trigger_list->high_thresholds);
+	free(trigger_list->low_thresholds);
+	free(trigger_list->rate_triggers);
+	free(trigger_list);
+}
+
+static void channel_rate_history_destroy(struct channel_rate_history *history)
+{
+	if (!history) {
+		return;
+	}
+
+	free(history->samples);
+	free(history);
 }
 
 static void free_channel_state_sample_rcu(struct rcu_head *node)
 {
-	free(caa_container_of(node, struct channel_state_sample, rcu_node));
+	struct channel_state_sample *sample =
+		caa_container_of(node, struct channel_state_sample, rcu_node);
+
+	channel_rate_history_destroy(sample->rate_history);
+	free(sample);
 }
 
 static int
@@ -2067,6 +2326,15 @@ handle_notification_thread_command_add_tracer_event_source(struct notification_t
 	element->domain = domain_type;
 
 	cds_list_add(&element->node, &state->tracer_event_sources_list);
+	cds_lfht_node_init(&element->tracer_event_sources_ht_node);
+	{
+		const lttng::urcu::read_lock_guard read_lock;
+
+		cds_lfht_add(state->tracer_event_sources_ht,
+			     hash_key_ulong((void *) (unsigned long) tracer_event_source_fd,
+					    lttng_ht_seed),
+			     &element->tracer_event_sources_ht_node);
+	}
 
 	DBG3("Adding tracer event source fd to poll set: tracer_event_source_fd = %d, domain = '%s'",
 	     tracer_event_source_fd,
@@ -2079,6 +2347,12 @@ handle_notification_thread_command_add_tracer_event_source(struct notification_t
 		    tracer_event_source_fd,
 		    lttng_domain_type_str(element->domain));
 		cds_list_del(&element->node);
+		{
+			const lttng::urcu::read_lock_guard read_lock;
+
+			cds_lfht_del(state->tracer_event_sources_ht,
+				     &element->tracer_event_sources_ht_node);
+		}
 		free(element);
 		goto end;
 	}
@@ -2095,8 +2369,12 @@ static int drain_event_notifier_notification_pipe(struct notification_thread_sta
 						  enum lttng_domain_type domain)
 {
 	struct lttng_poll_event events = {};
+	struct event_notifier_notification_batch batch;
+	const lttng::urcu::read_lock_guard read_lock;
 	int ret;
 
+	event_notifier_notification_batch_init(&batch);
+
 	ret = lttng_poll_create(&events, 1, LTTNG_CLOEXEC);
 	if (ret < 0) {
 		ERR("Error creating lttng_poll_event");
@@ -2120,18 +2398,20 @@ static int drain_event_notifier_notification_pipe(struct notification_thread_sta
 		 * monitored (on Linux, at least) and will be returned when
 		 * the pipe is closed but empty.
 		 */
-		ret = lttng_poll_wait_interruptible(&events, 0);
-		if (ret == 0 || (LTTNG_POLL_GETEV(&events, 0) & LPOLLIN) == 0) {
-			/* No more notification to be read on this pipe. */
-			ret = 0;
-			goto end;
-		} else if (ret < 0) {
-			PERROR("Failed on lttng_poll_wait_interruptible() call");
-			ret = -1;
-			goto end;
+		if (!event_notifier_notification_batch_has_received(&batch)) {
+			ret = lttng_poll_wait_interruptible(&events, 0);
+			if (ret == 0 || (LTTNG_POLL_GETEV(&events, 0) & LPOLLIN) == 0) {
+				/* No more notification to be read on this pipe. */
+				ret = 0;
+				goto end;
+			} else if (ret < 0) {
+				PERROR("Failed on lttng_poll_wait_interruptible() call");
+				ret = -1;
+				goto end;
+			}
 		}
 
-		ret = handle_one_event_notifier_notification(state, pipe, domain);
+		ret = handle_one_event_notifier_notification(state, pipe, domain, &batch);
 		if (ret) {
 			ERR("Error consuming an event notifier notification from pipe: fd = %d",
 			    pipe);
@@ -2139,24 +2419,36 @@ static int drain_event_notifier_notification_pipe(struct notification_thread_sta
 	}
 end:
 	lttng_poll_clean(&events);
+	event_notifier_notification_batch_fini(&batch);
 	return ret;
 }
 
-static struct notification_event_tracer_event_source_element *
-find_tracer_event_source_element(struct notification_thread_state *state,
+struct notification_event_tracer_event_source_element *
+find_tracer_event_source_element(const struct notification_thread_state *state,
 				 int tracer_event_source_fd)
 {
-	struct notification_event_tracer_event_source_element *source_element;
+	struct cds_lfht_iter iter;
+	struct cds_lfht_node *node;
+	const lttng::urcu::read_lock_guard read_lock;
 
-	cds_list_for_each_entry (source_element, &state->tracer_event_sources_list, node) {
-		if (source_element->fd == tracer_event_source_fd) {
-			goto end;
-		}
+	cds_lfht_lookup(state->tracer_event_sources_ht,
+			hash_key_ulong((void *) (unsigned long) tracer_event_source_fd,
+				       lttng_ht_seed),
+			match_tracer_event_source_fd,
+			(void *) (intptr_t) tracer_event_source_fd,
+			&iter);
+	node = cds_lfht_iter_get_node(&iter);
+	if (!node) {
+		return nullptr;
 	}
 
-	source_element = nullptr;
-end:
-	return source_element;
+	/*
+	 * The elements are only added, removed and freed by the notification
+	 * thread.
+	 */
+	return caa_container_of(node,
+				struct notification_event_tracer_event_source_element,
+				tracer_event_sources_ht_node);
 }
 
 static int remove_tracer_event_source_from_pollset(
@@ -2236,6 +2528,12 @@ static int handle_notification_thread_command_remove_tracer_event_source(
 
 	/* Remove the tracer source from the list. */
 	cds_list_del(&source_element->node);
+	{
+		const lttng::urcu::read_lock_guard read_lock;
+
+		cds_lfht_del(state->tracer_event_sources_ht,
+			     &source_element->tracer_event_sources_ht_node);
+	}
 
 	if (!source_element->is_fd_in_poll_set) {
 		/* Skip the poll set removal. */
@@ -2397,6 +2695,20 @@ static bool condition_is_supported(struct lttng_condition *condition)
 		is_supported = kernel_supports_ring_buffer_snapshot_sample_positions() == 1;
 		break;
 	}
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+	{
+		enum lttng_domain_type domain;
+		const enum lttng_condition_status status =
+			lttng_condition_channel_rate_get_domain_type(condition, &domain);
+
+		LTTNG_ASSERT(status == LTTNG_CONDITION_STATUS_OK);
+
+		/* The consumed bytes are sampled like the buffer usage. */
+		is_supported = domain != LTTNG_DOMAIN_KERNEL ||
+			kernel_supports_ring_buffer_snapshot_sample_positions() == 1;
+		break;
+	}
 	case LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES:
 	{
 		const struct lttng_event_rule *event_rule;
@@ -2494,38 +2806,13 @@ static int bind_trigger_to_matching_channels(struct lttng_trigger *trigger,
 		CDS_INIT_LIST_HEAD(&trigger_list_element->node);
 		trigger_list_element->trigger = trigger;
 		cds_list_add(&trigger_list_element->node, &trigger_list->list);
+		trigger_list->thresholds_stale = true;
 		DBG("Newly registered trigger bound to channel \"%s\"", channel->name);
 	}
 end:
 	return ret;
 }
 
-static bool is_trigger_action_notify(const struct lttng_trigger *trigger)
-{
-	bool is_notify = false;
-	const struct lttng_action *action = lttng_trigger_get_const_action(trigger);
-	enum lttng_action_type action_type;
-
-	LTTNG_ASSERT(action);
-	action_type = lttng_action_get_type(action);
-	if (action_type == LTTNG_ACTION_TYPE_NOTIFY) {
-		is_notify = true;
-		goto end;
-	} else if (action_type != LTTNG_ACTION_TYPE_LIST) {
-		goto end;
-	}
-
-	for (auto inner_action : lttng::ctl::const_action_list_view(action)) {
-		if (lttng_action_get_type(inner_action) == LTTNG_ACTION_TYPE_NOTIFY) {
-			is_notify = true;
-			goto end;
-		}
-	}
-
-end:
-	return is_notify;
-}
-
 static bool trigger_name_taken(struct notification_thread_state *state,
 			       const struct lttng_trigger *trigger)
 {
@@ -2771,7 +3058,7 @@ handle_notification_thread_command_register_trigger(struct notification_thread_s
 	 * It is not skipped as this is the only action type currently
 	 * supported.
 	 */
-	if (is_trigger_action_notify(trigger)) {
+	if (lttng_trigger_has_notify_action(trigger)) {
 		/*
 		 * Find or create the client list of this condition. It may
 		 * already be present if another trigger is already registered
@@ -3023,6 +3310,7 @@ remove_trigger_from_session_trigger_list(struct lttng_session_trigger_list *trig
 		DBG("Removed trigger from session_triggers_ht");
 		cds_list_del(&trigger_element->node);
 		free(trigger_element);
+		trigger_list->thresholds_stale = true;
 		/* A trigger can only appear once per session. */
 		found = true;
 		break;
@@ -3090,6 +3378,7 @@ handle_notification_thread_command_unregister_trigger(struct notification_thread
 				DBG("Removed trigger from channel_triggers_ht");
 				cds_list_del(&trigger_element->node);
 				free(trigger_element);
+				trigger_list->thresholds_stale = true;
 				/* A trigger can only appear once per channel */
 				break;
 			}
@@ -3120,7 +3409,7 @@ handle_notification_thread_command_unregister_trigger(struct notification_thread
 		teardown_tracer_notifier(state, trigger);
 	}
 
-	if (is_trigger_action_notify(trigger)) {
+	if (lttng_trigger_has_notify_action(trigger)) {
 		/*
 		 * Remove and release the client list from
 		 * notification_trigger_clients_ht.
@@ -3151,6 +3440,59 @@ end:
 	return 0;
 }
 
+/*
+ * Register a set of triggers, generating their names, as a single command:
+ * if one of them can't be registered, the ones registered before it are
+ * unregistered.
+ */
+static int
+handle_notification_thread_command_register_triggers(struct notification_thread_state *state,
+						     const struct lttng_triggers *triggers,
+						     enum lttng_error_code *cmd_result)
+{
+	int ret = 0;
+	unsigned int count, i, registered_count;
+	const enum lttng_trigger_status trigger_status = lttng_triggers_get_count(triggers, &count);
+
+	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
+
+	*cmd_result = LTTNG_OK;
+	for (registered_count = 0; registered_count < count; registered_count++) {
+		struct lttng_trigger *trigger =
+			lttng_triggers_borrow_mutable_at_index(triggers, registered_count);
+
+		/* Reference owned by the notification thread state once registered. */
+		lttng_trigger_get(trigger);
+		ret = handle_notification_thread_command_register_trigger(
+			state, trigger, false, cmd_result);
+		if (ret || *cmd_result != LTTNG_OK) {
+			break;
+		}
+	}
+
+	if (ret || *cmd_result == LTTNG_OK) {
+		/* Success, or fatal error: the thread is torn down. */
+		goto end;
+	}
+
+	DBG("Failed to register trigger %u of %u, unregistering the previously registered ones",
+	    registered_count + 1,
+	    count);
+	for (i = 0; i < registered_count; i++) {
+		struct lttng_trigger *trigger = lttng_triggers_borrow_mutable_at_index(triggers, i);
+
+		lttng_trigger_set_as_unregistered(trigger);
+		ret = handle_notification_thread_command_unregister_trigger(
+			state, trigger, nullptr);
+		if (ret) {
+			goto end;
+		}
+	}
+
+end:
+	return ret;
+}
+
 static notification_thread_command *pop_cmd_queue(notification_thread_handle *handle)
 {
 	lttng::pthread::lock_guard queue_lock(handle->cmd_queue.lock);
@@ -3197,6 +3539,10 @@ int handle_notification_thread_command(struct notification_thread_handle *handle
 			cmd->parameters.register_trigger.is_trigger_anonymous,
 			&cmd->reply_code);
 		break;
+	case NOTIFICATION_COMMAND_TYPE_REGISTER_TRIGGERS:
+		ret = handle_notification_thread_command_register_triggers(
+			state, cmd->parameters.register_triggers.triggers, &cmd->reply_code);
+		break;
 	case NOTIFICATION_COMMAND_TYPE_UNREGISTER_TRIGGER:
 		ret = handle_notification_thread_command_unregister_trigger(
 			state, cmd->parameters.unregister_trigger.trigger, &cmd->reply_code);
@@ -3394,6 +3740,7 @@ int handle_notification_thread_client_connect(struct notification_thread_state *
 	CDS_INIT_LIST_HEAD(&client->condition_list);
 	lttng_payload_init(&client->communication.inbound.payload);
 	lttng_payload_init(&client->communication.outbound.payload);
+	CDS_INIT_LIST_HEAD(&client->communication.outbound.deferred_notifications);
 	client->communication.inbound.expect_creds = true;
 
 	ret = client_reset_inbound_state(client);
@@ -3634,6 +3981,32 @@ end:
 }
 
 /* Client lock must be acquired by caller. */
+/*
+ * Move the deferred notifications of a client to its outgoing queue.
+ *
+ * Client lock must be acquired by caller.
+ */
+static int client_enqueue_deferred_notifications(struct notification_client *client)
+{
+	struct notification_client_deferred_notification *deferred, *tmp;
+
+	ASSERT_LOCKED(client->lock);
+
+	cds_list_for_each_entry_safe (
+		deferred, tmp, &client->communication.outbound.deferred_notifications, node) {
+		const int ret = lttng_payload_copy(&deferred->message,
+						   &client->communication.outbound.payload);
+
+		if (ret) {
+			return ret;
+		}
+
+		deferred_notification_destroy(deferred);
+	}
+
+	return 0;
+}
+
 static enum client_transmission_status
 client_flush_outgoing_queue(struct notification_client *client)
 {
@@ -3740,6 +4113,15 @@ end:
 		client->communication.outbound.queued_command_reply = false;
 		client->communication.outbound.dropped_notification = false;
 		lttng_payload_clear(&client->communication.outbound.payload);
+
+		if (!cds_list_empty(&client->communication.outbound.deferred_notifications)) {
+			/* The client caught up, send the notifications kept aside. */
+			if (client_enqueue_deferred_notifications(client)) {
+				goto error;
+			}
+
+			status = client_flush_outgoing_queue(client);
+		}
 	}
 
 	return status;
@@ -3747,6 +4129,48 @@ error:
 	return CLIENT_TRANSMISSION_STATUS_ERROR;
 }
 
+/*
+ * Send a message, without file descriptors, to a client which has no data left
+ * to send. The message is sent from the caller's buffer, which can be shared by
+ * the clients, and only the part of it which can't be sent right away is copied
+ * to the outgoing queue of the client.
+ *
+ * Client lock must be acquired by caller.
+ */
+static enum client_transmission_status
+client_send_shared_message(struct notification_client *client, const struct lttng_buffer_view *msg)
+{
+	ssize_t ret;
+
+	ASSERT_LOCKED(client->lock);
+	LTTNG_ASSERT(!client_has_outbound_data_left(client));
+
+	if (!client->communication.active) {
+		return CLIENT_TRANSMISSION_STATUS_FAIL;
+	}
+
+	ret = lttcomm_send_unix_sock_non_block(client->socket, msg->data, msg->size);
+	if (ret < 0) {
+		/* Generic error, disable the client's communication. */
+		ERR("Failed to send message, disconnecting client (socket fd = %i)",
+		    client->socket);
+		client->communication.active = false;
+		return CLIENT_TRANSMISSION_STATUS_FAIL;
+	} else if ((size_t) ret == msg->size) {
+		return CLIENT_TRANSMISSION_STATUS_COMPLETE;
+	}
+
+	DBG("Message to client (socket fd = %i) could not be completely sent, queuing the rest",
+	    client->socket);
+	if (lttng_dynamic_buffer_append(&client->communication.outbound.payload.buffer,
+					msg->data + ret,
+					msg->size - ret)) {
+		return CLIENT_TRANSMISSION_STATUS_ERROR;
+	}
+
+	return CLIENT_TRANSMISSION_STATUS_QUEUED;
+}
+
 /* Client lock must _not_ be held by the caller. */
 static int client_send_command_reply(struct notification_client *client,
 				     struct notification_thread_state *state,
@@ -3781,13 +4205,13 @@ static int client_send_command_reply(struct notification_client *client,
 		goto error_unlock;
 	}
 
+	/*
+	 * Cleared once the queue is emptied, which may be followed by the
+	 * deferred notifications being queued.
+	 */
+	client->communication.outbound.queued_command_reply = true;
 	transmission_status = client_flush_outgoing_queue(client);
 
-	if (client_has_outbound_data_left(client)) {
-		/* Queue could not be emptied. */
-		client->communication.outbound.queued_command_reply = true;
-	}
-
 	pthread_mutex_unlock(&client->lock);
 	ret = client_handle_transmission_status(client, transmission_status, state);
 	if (ret) {
@@ -3827,6 +4251,7 @@ static int client_handle_message_unknown(struct notification_client *client,
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE:
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE:
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_HANDSHAKE:
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_WITH_OVERFLOW_POLICY:
 		break;
 	default:
 		ret = -1;
@@ -3933,8 +4358,10 @@ static int client_handle_message_subscription(struct notification_client *client
 	int ret;
 	struct lttng_condition *condition;
 	enum lttng_notification_channel_status status = LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
-	struct lttng_payload_view condition_view =
-		lttng_payload_view_from_payload(&client->communication.inbound.payload, 0, -1);
+	enum lttng_notification_channel_overflow_policy overflow_policy =
+		LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP;
+	unsigned int overflow_queue_size = 0;
+	size_t condition_offset = 0;
 	size_t expected_condition_size;
 
 	/*
@@ -3942,18 +4369,66 @@ static int client_handle_message_subscription(struct notification_client *client
 	 * other thread accessing clients (action executor) only uses the
 	 * outbound state.
 	 */
-	expected_condition_size = client->communication.inbound.payload.buffer.size;
-	ret = lttng_condition_create_from_payload(&condition_view, &condition);
-	if (ret != expected_condition_size) {
-		ERR("Malformed condition received from client");
-		goto end;
+	if (msg_type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_WITH_OVERFLOW_POLICY) {
+		const struct lttng_notification_channel_command_subscribe_overflow_policy
+			*policy_header;
+		const struct lttng_payload_view policy_view = lttng_payload_view_from_payload(
+			&client->communication.inbound.payload, 0, sizeof(*policy_header));
+
+		if (!lttng_payload_view_is_valid(&policy_view)) {
+			ERR("Malformed overflow policy received from client");
+			ret = -1;
+			goto end;
+		}
+
+		policy_header = (typeof(policy_header)) policy_view.buffer.data;
+		overflow_policy =
+			(enum lttng_notification_channel_overflow_policy) policy_header->policy;
+		overflow_queue_size = policy_header->queue_size;
+		condition_offset = sizeof(*policy_header);
 	}
 
-	/* Ownership of condition is always transferred. */
-	if (msg_type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE) {
-		ret = notification_thread_client_subscribe(client, condition, state, &status);
-	} else {
-		ret = notification_thread_client_unsubscribe(client, condition, state, &status);
+	{
+		struct lttng_payload_view condition_view = lttng_payload_view_from_payload(
+			&client->communication.inbound.payload, condition_offset, -1);
+
+		expected_condition_size =
+			client->communication.inbound.payload.buffer.size - condition_offset;
+		ret = lttng_condition_create_from_payload(&condition_view, &condition);
+		if (ret != expected_condition_size) {
+			ERR("Malformed condition received from client");
+			goto end;
+		}
+	}
+
+	switch (overflow_policy) {
+	case LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP:
+		break;
+	case LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_COALESCE:
+		overflow_queue_size = 1;
+		break;
+	case LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP_OLDEST:
+		if (overflow_queue_size == 0 ||
+		    overflow_queue_size > LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_QUEUE_MAX_SIZE) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+		}
+		break;
+	default:
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+		break;
+	}
+
+	/* Ownership of condition is always transferred. */
+	if (status != LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+		lttng_condition_destroy(condition);
+		ret = 0;
+	} else if (msg_type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE ||
+		   msg_type ==
+			   LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_WITH_OVERFLOW_POLICY) {
+		ret = notification_thread_client_subscribe(
+			client, condition, overflow_policy, overflow_queue_size, state, &status);
+	} else {
+		ret = notification_thread_client_unsubscribe(client, condition, state, &status);
 	}
 
 	if (ret) {
@@ -4005,6 +4480,7 @@ static int client_dispatch_message(struct notification_client *client,
 	}
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE:
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE:
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_WITH_OVERFLOW_POLICY:
 	{
 		ret = client_handle_message_subscription(
 			client, client->communication.inbound.msg_type, state);
@@ -4184,18 +4660,14 @@ end:
 	return ret;
 }
 
-static bool evaluate_buffer_usage_condition(const struct lttng_condition *condition,
-					    const struct channel_state_sample *sample,
-					    uint64_t buffer_capacity)
+static uint64_t buffer_usage_condition_threshold(const struct lttng_condition *condition,
+						 uint64_t buffer_capacity)
 {
-	bool result = false;
-	uint64_t threshold;
-	enum lttng_condition_type condition_type;
 	const struct lttng_condition_buffer_usage *use_condition =
 		lttng::utils::container_of(condition, &lttng_condition_buffer_usage::parent);
 
 	if (use_condition->threshold_bytes.set) {
-		threshold = use_condition->threshold_bytes.value;
+		return use_condition->threshold_bytes.value;
 	} else {
 		/*
 		 * Threshold was expressed as a ratio.
@@ -4209,9 +4681,18 @@ static bool evaluate_buffer_usage_condition(const struct lttng_condition *condit
 		 * condition applies to multiple channels (i.e. don't assume
 		 * that all channels matching my_chann* have the same size...)
 		 */
-		threshold = (uint64_t) (use_condition->threshold_ratio.value *
-					(double) buffer_capacity);
+		return (uint64_t) (use_condition->threshold_ratio.value *
+				   (double) buffer_capacity);
 	}
+}
+
+static bool evaluate_buffer_usage_condition(const struct lttng_condition *condition,
+					    const struct channel_state_sample *sample,
+					    uint64_t buffer_capacity)
+{
+	bool result = false;
+	const uint64_t threshold = buffer_usage_condition_threshold(condition, buffer_capacity);
+	enum lttng_condition_type condition_type;
 
 	condition_type = lttng_condition_get_type(condition);
 	if (condition_type == LTTNG_CONDITION_TYPE_BUFFER_USAGE_LOW) {
@@ -4245,6 +4726,81 @@ static bool evaluate_buffer_usage_condition(const struct lttng_condition *condit
 	return result;
 }
 
+static bool channel_rate_sample_timestamp_less(const channel_rate_sample& a,
+					       const channel_rate_sample& b)
+{
+	return a.timestamp_us < b.timestamp_us;
+}
+
+static uint64_t channel_rate_sample_statistic(const struct channel_rate_sample *sample,
+					      enum lttng_condition_channel_rate_statistic statistic)
+{
+	switch (statistic) {
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_CONSUMED_BYTES:
+		return sample->consumed_bytes;
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_DISCARDED_EVENTS:
+		return sample->discarded_events;
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_LOST_PACKETS:
+		return sample->lost_packets;
+	default:
+		abort();
+	}
+}
+
+/*
+ * Evaluate a channel rate condition against the rate of its statistic over
+ * its window ending at the `end_index`-th sample of `history`, returned in
+ * `rate_per_second`. The rate is measured from the oldest sample within the
+ * window.
+ *
+ * Evaluates to false when no earlier sample is within the window.
+ */
+static bool evaluate_channel_rate_condition(const struct lttng_condition *condition,
+					    const struct channel_rate_history *history,
+					    size_t end_index,
+					    uint64_t *rate_per_second)
+{
+	const struct lttng_condition_channel_rate *rate_condition =
+		lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	const uint64_t window_us = rate_condition->window_us.value;
+	const uint64_t threshold = rate_condition->threshold_per_second.value;
+	const struct channel_rate_sample *end = &history->samples[end_index];
+	const struct channel_rate_sample *start;
+	channel_rate_sample window_start = {};
+	uint64_t start_value, end_value;
+
+	window_start.timestamp_us = end->timestamp_us > window_us ? end->timestamp_us - window_us :
+								   0;
+	start = std::lower_bound((const struct channel_rate_sample *) history->samples,
+				 end,
+				 window_start,
+				 channel_rate_sample_timestamp_less);
+	if (start == end || start->timestamp_us == end->timestamp_us) {
+		return false;
+	}
+
+	start_value = channel_rate_sample_statistic(start, rate_condition->statistic.value);
+	end_value = channel_rate_sample_statistic(end, rate_condition->statistic.value);
+	/* The counters of a channel are reset when it is cleared. */
+	*rate_per_second = end_value < start_value ?
+		0 :
+		(uint64_t) ((double) (end_value - start_value) * (double) USEC_PER_SEC /
+			    (double) (end->timestamp_us - start->timestamp_us));
+
+	DBG("Channel rate condition being evaluated: statistic = %s, threshold = %" PRIu64
+	    "/s, window = %" PRIu64 " us, rate = %" PRIu64 "/s",
+	    lttng_condition_channel_rate_statistic_str(rate_condition->statistic.value),
+	    threshold,
+	    window_us,
+	    *rate_per_second);
+
+	if (lttng_condition_get_type(condition) == LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW) {
+		return *rate_per_second <= threshold;
+	} else {
+		return *rate_per_second >= threshold;
+	}
+}
+
 static int evaluate_buffer_condition(const struct lttng_condition *condition,
 				     struct lttng_evaluation **evaluation,
 				     const struct notification_thread_state *state
@@ -4258,6 +4814,7 @@ static int evaluate_buffer_condition(const struct lttng_condition *condition,
 	const bool previous_sample_available = !!previous_sample;
 	bool previous_sample_result = false;
 	bool latest_sample_result;
+	uint64_t previous_rate, latest_rate = 0;
 
 	condition_type = lttng_condition_get_type(condition);
 
@@ -4271,6 +4828,25 @@ static int evaluate_buffer_condition(const struct lttng_condition *condition,
 		latest_sample_result = evaluate_buffer_usage_condition(
 			condition, latest_sample, channel_info->capacity);
 		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+	{
+		/* The previous sample is the second to last of the history. */
+		const struct channel_rate_history *history = latest_sample->rate_history;
+
+		if (!history || history->count == 0) {
+			latest_sample_result = false;
+			break;
+		}
+
+		if (caa_likely(previous_sample_available) && history->count > 1) {
+			previous_sample_result = evaluate_channel_rate_condition(
+				condition, history, history->count - 2, &previous_rate);
+		}
+		latest_sample_result = evaluate_channel_rate_condition(
+			condition, history, history->count - 1, &latest_rate);
+		break;
+	}
 	default:
 		/* Unknown condition type; internal error. */
 		abort();
@@ -4294,7 +4870,14 @@ static int evaluate_buffer_condition(const struct lttng_condition *condition,
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_LOW:
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_HIGH:
 		*evaluation = lttng_evaluation_buffer_usage_create(
-			condition_type, latest_sample->highest_usage, channel_info->capacity);
+			condition_type,
+			latest_sample->highest_usage,
+			channel_info->capacity,
+			latest_sample->writeback_bytes_in_flight);
+		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		*evaluation = lttng_evaluation_channel_rate_create(condition_type, latest_rate);
 		break;
 	default:
 		abort();
@@ -4340,6 +4923,67 @@ end:
 	return ret;
 }
 
+/*
+ * Keep a notification aside until the outgoing queue of a client is flushed,
+ * applying the overflow policy of its subscription.
+ *
+ * Client lock must be acquired by caller.
+ */
+static int
+client_defer_notification(struct notification_client *client,
+			  const struct notification_client_list_element *client_list_element,
+			  const struct lttng_payload *msg_payload)
+{
+	int ret;
+	unsigned int deferred_count = 0;
+	struct notification_client_deferred_notification *deferred, *oldest = nullptr;
+
+	ASSERT_LOCKED(client->lock);
+
+	cds_list_for_each_entry (
+		deferred, &client->communication.outbound.deferred_notifications, node) {
+		if (deferred->subscription != client_list_element->subscription) {
+			continue;
+		}
+
+		if (!oldest) {
+			oldest = deferred;
+		}
+
+		deferred_count++;
+	}
+
+	if (deferred_count >= client_list_element->overflow_queue_size) {
+		LTTNG_ASSERT(oldest);
+		DBG("Replacing oldest deferred notification of client (socket fd = %i)",
+		    client->socket);
+		deferred_notification_destroy(oldest);
+		ret = client_notification_overflow(client);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	deferred = deferred_notification_allocator
+			   .zalloc<notification_client_deferred_notification>();
+	if (!deferred) {
+		PERROR("Failed to allocate deferred notification");
+		return -1;
+	}
+
+	deferred->subscription = client_list_element->subscription;
+	lttng_payload_init(&deferred->message);
+	ret = lttng_payload_copy(msg_payload, &deferred->message);
+	if (ret) {
+		lttng_payload_reset(&deferred->message);
+		deferred_notification_allocator.free(deferred);
+		return ret;
+	}
+
+	cds_list_add_tail(&deferred->node, &client->communication.outbound.deferred_notifications);
+	return 0;
+}
+
 static int client_handle_transmission_status_wrapper(struct notification_client *client,
 						     enum client_transmission_status status,
 						     void *user_data)
@@ -4417,6 +5061,7 @@ int notification_client_list_send_evaluation(struct notification_client_list *cl
 	};
 	struct lttng_notification_channel_message msg_header;
 	const struct lttng_credentials *trigger_creds = lttng_trigger_get_credentials(trigger);
+	int msg_fd_count;
 
 	lttng_payload_init(&msg_payload);
 
@@ -4445,8 +5090,9 @@ int notification_client_list_send_evaluation(struct notification_client_list *cl
 		const struct lttng_payload_view pv =
 			lttng_payload_view_from_payload(&msg_payload, 0, -1);
 
+		msg_fd_count = lttng_payload_view_get_fd_handle_count(&pv);
 		((struct lttng_notification_channel_message *) msg_payload.buffer.data)->fds =
-			(uint32_t) lttng_payload_view_get_fd_handle_count(&pv);
+			(uint32_t) msg_fd_count;
 	}
 
 	pthread_mutex_lock(&client_list->lock);
@@ -4496,6 +5142,17 @@ int notification_client_list_send_evaluation(struct notification_client_list *cl
 		    client->socket,
 		    msg_payload.buffer.size);
 
+		if (client_has_outbound_data_left(client) &&
+		    client_list_element->overflow_policy !=
+			    LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP) {
+			/*
+			 * The notification is sent once the outgoing queue is
+			 * flushed, which the client is already waiting for.
+			 */
+			ret = client_defer_notification(client, client_list_element, &msg_payload);
+			goto skip_client;
+		}
+
 		if (client_has_outbound_data_left(client)) {
 			/*
 			 * Outgoing data is already buffered for this client;
@@ -4511,13 +5168,23 @@ int notification_client_list_send_evaluation(struct notification_client_list *cl
 			}
 		}
 
-		ret = lttng_payload_copy(&msg_payload, &client->communication.outbound.payload);
-		if (ret) {
-			/* Fatal error. */
-			goto skip_client;
+		if (client_has_outbound_data_left(client) || msg_fd_count != 0) {
+			ret = lttng_payload_copy(&msg_payload,
+						 &client->communication.outbound.payload);
+			if (ret) {
+				/* Fatal error. */
+				goto skip_client;
+			}
+
+			transmission_status = client_flush_outgoing_queue(client);
+		} else {
+			/* The serialized notification is shared by the clients. */
+			const struct lttng_buffer_view msg_view =
+				lttng_buffer_view_from_dynamic_buffer(&msg_payload.buffer, 0, -1);
+
+			transmission_status = client_send_shared_message(client, &msg_view);
 		}
 
-		transmission_status = client_flush_outgoing_queue(client);
 		pthread_mutex_unlock(&client->lock);
 		ret = client_report(client, transmission_status, user_data);
 		if (ret) {
@@ -4543,16 +5210,105 @@ end:
 	return ret;
 }
 
-static struct lttng_event_notifier_notification *
-recv_one_event_notifier_notification(int notification_pipe_read_fd, enum lttng_domain_type domain)
+static void event_notifier_notification_batch_init(struct event_notifier_notification_batch *batch)
+{
+	batch->reception_len = 0;
+	batch->reception_offset = 0;
+	batch->trigger_cached = false;
+	batch->cached_element = nullptr;
+	batch->cached_client_list = nullptr;
+}
+
+/* Release the cached trigger of the batch. */
+static void event_notifier_notification_batch_fini(struct event_notifier_notification_batch *batch)
+{
+	notification_client_list_put(batch->cached_client_list);
+	batch->trigger_cached = false;
+	batch->cached_element = nullptr;
+	batch->cached_client_list = nullptr;
+}
+
+/* Whether notifications were read from the event source but not dispatched yet. */
+static bool event_notifier_notification_batch_has_received(
+	const struct event_notifier_notification_batch *batch)
+{
+	return batch->reception_offset < batch->reception_len;
+}
+
+/*
+ * Receive the next `size` bytes of the notifications of an event source.
+ *
+ * They are read from the event source, with a single read for as many
+ * notifications as the reception buffer holds, once those already read are
+ * consumed. `*data` points to them within the reception buffer or, when they
+ * are split across two reads, to `scratch` in which they are copied.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int
+event_notifier_notification_batch_receive(struct event_notifier_notification_batch *batch,
+					  int fd,
+					  size_t size,
+					  char *scratch,
+					  char **data)
+{
+	size_t received = 0;
+
+	while (true) {
+		char *const buffered = batch->reception_buffer + batch->reception_offset;
+		const size_t available = batch->reception_len - batch->reception_offset;
+		const size_t copy_len = std::min(available, size - received);
+		ssize_t ret;
+
+		if (received == 0 && available >= size) {
+			batch->reception_offset += size;
+			*data = buffered;
+			return 0;
+		}
+
+		memcpy(scratch + received, buffered, copy_len);
+		received += copy_len;
+		batch->reception_offset += copy_len;
+		if (received == size) {
+			*data = scratch;
+			return 0;
+		}
+
+		/*
+		 * The tracers write each notification atomically: the rest of
+		 * a notification which is partially read is available.
+		 */
+		do {
+			ret = read(fd, batch->reception_buffer, sizeof(batch->reception_buffer));
+		} while (ret < 0 && errno == EINTR);
+		if (ret <= 0) {
+			return -1;
+		}
+
+		batch->reception_len = ret;
+		batch->reception_offset = 0;
+	}
+}
+
+/*
+ * Receive a notification from an event notifier notification pipe, its capture
+ * payload remaining in the batch until the next notification is received.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int
+recv_one_event_notifier_notification(int notification_pipe_read_fd,
+				     enum lttng_domain_type domain,
+				     struct event_notifier_notification_batch *batch,
+				     struct lttng_event_notifier_notification *notification)
 {
 	int ret;
 	uint64_t token;
-	struct lttng_event_notifier_notification *notification = nullptr;
-	char *capture_buffer = nullptr;
 	size_t capture_buffer_size;
+	char *capture_buffer = nullptr;
 	void *reception_buffer;
 	size_t reception_size;
+	char *header;
 
 	struct lttng_ust_abi_event_notifier_notification ust_notification;
 	struct lttng_kernel_abi_event_notifier_notification kernel_notification;
@@ -4575,14 +5331,20 @@ recv_one_event_notifier_notification(int notification_pipe_read_fd, enum lttng_d
 	 * The monitoring pipe only holds messages smaller than PIPE_BUF,
 	 * ensuring that read/write of tracer notifications are atomic.
 	 */
-	ret = lttng_read(notification_pipe_read_fd, reception_buffer, reception_size);
-	if (ret != reception_size) {
-		PERROR("Failed to read from event source notification pipe: fd = %d, size to read = %zu, ret = %d",
+	ret = event_notifier_notification_batch_receive(batch,
+							notification_pipe_read_fd,
+							reception_size,
+							(char *) reception_buffer,
+							&header);
+	if (ret) {
+		PERROR("Failed to read from event source notification pipe: fd = %d, size to read = %zu",
 		       notification_pipe_read_fd,
-		       reception_size,
-		       ret);
-		ret = -1;
-		goto end;
+		       reception_size);
+		return -1;
+	}
+
+	if (header != reception_buffer) {
+		memcpy(reception_buffer, header, reception_size);
 	}
 
 	switch (domain) {
@@ -4598,94 +5360,111 @@ recv_one_event_notifier_notification(int notification_pipe_read_fd, enum lttng_d
 		abort();
 	}
 
-	if (capture_buffer_size == 0) {
-		capture_buffer = nullptr;
-		goto skip_capture;
-	}
-
 	if (capture_buffer_size > MAX_CAPTURE_SIZE) {
 		ERR("Event notifier has a capture payload size which exceeds the maximum allowed size: capture_payload_size = %zu bytes, max allowed size = %d bytes",
 		    capture_buffer_size,
 		    MAX_CAPTURE_SIZE);
-		goto end;
+		return -1;
 	}
 
-	capture_buffer = calloc<char>(capture_buffer_size);
-	if (!capture_buffer) {
-		ERR("Failed to allocate capture buffer");
-		goto end;
+	if (capture_buffer_size > 0) {
+		/* Fetch additional payload (capture). */
+		ret = event_notifier_notification_batch_receive(batch,
+								notification_pipe_read_fd,
+								capture_buffer_size,
+								batch->capture_buffer,
+								&capture_buffer);
+		if (ret) {
+			ERR("Failed to read from event source pipe (fd = %i)",
+			    notification_pipe_read_fd);
+			return -1;
+		}
 	}
 
-	/* Fetch additional payload (capture). */
-	ret = lttng_read(notification_pipe_read_fd, capture_buffer, capture_buffer_size);
-	if (ret != capture_buffer_size) {
-		ERR("Failed to read from event source pipe (fd = %i)", notification_pipe_read_fd);
-		goto end;
-	}
+	notification->tracer_token = token;
+	notification->type = domain;
+	notification->capture_buffer = capture_buffer;
+	notification->capture_buf_size = capture_buffer_size;
+	return 0;
+}
 
-skip_capture:
-	notification = lttng_event_notifier_notification_create(
-		token, domain, capture_buffer, capture_buffer_size);
-	if (notification == nullptr) {
-		goto end;
+/*
+ * Look up the trigger of a token, and its client list, unless it is the one
+ * of the previous notification of the batch.
+ *
+ * The RCU read-side lock must be held for the whole batch.
+ */
+static void event_notifier_notification_batch_set_trigger(
+	struct notification_thread_state *state,
+	struct event_notifier_notification_batch *batch,
+	uint64_t token)
+{
+	struct cds_lfht_node *node;
+	struct cds_lfht_iter iter;
+
+	ASSERT_RCU_READ_LOCKED();
+
+	if (batch->trigger_cached && batch->cached_token == token) {
+		return;
 	}
 
-	/*
-	 * Ownership transfered to the lttng_event_notifier_notification object.
-	 */
-	capture_buffer = nullptr;
+	event_notifier_notification_batch_fini(batch);
 
-end:
-	free(capture_buffer);
-	return notification;
+	/* Find triggers associated with this token. */
+	cds_lfht_lookup(state->trigger_tokens_ht,
+			hash_key_u64(&token, lttng_ht_seed),
+			match_trigger_token,
+			&token,
+			&iter);
+	node = cds_lfht_iter_get_node(&iter);
+	if (node) {
+		batch->cached_element =
+			caa_container_of(node, struct notification_trigger_tokens_ht_element, node);
+		batch->cached_client_list = get_client_list_from_condition(
+			state, lttng_trigger_get_const_condition(batch->cached_element->trigger));
+	}
+
+	batch->trigger_cached = true;
+	batch->cached_token = token;
 }
 
 static int
 dispatch_one_event_notifier_notification(struct notification_thread_state *state,
-					 struct lttng_event_notifier_notification *notification)
+					 const lttng_event_notifier_notification *notification,
+					 struct event_notifier_notification_batch *batch)
 {
-	struct cds_lfht_node *node;
-	struct cds_lfht_iter iter;
 	struct notification_trigger_tokens_ht_element *element;
 	struct lttng_evaluation *evaluation = nullptr;
 	enum action_executor_status executor_status;
-	struct notification_client_list *client_list = nullptr;
+	struct notification_client_list *client_list;
 	int ret;
 	unsigned int capture_count = 0;
 
-	/* Find triggers associated with this token. */
-	lttng::urcu::read_lock_guard read_lock;
-	cds_lfht_lookup(state->trigger_tokens_ht,
-			hash_key_u64(&notification->tracer_token, lttng_ht_seed),
-			match_trigger_token,
-			&notification->tracer_token,
-			&iter);
-	node = cds_lfht_iter_get_node(&iter);
-	if (caa_unlikely(!node)) {
+	event_notifier_notification_batch_set_trigger(state, batch, notification->tracer_token);
+	element = batch->cached_element;
+	client_list = batch->cached_client_list;
+	if (caa_unlikely(!element)) {
 		/*
 		 * This is not an error, slow consumption of the tracer
 		 * notifications can lead to situations where a trigger is
 		 * removed but we still get tracer notifications matching a
 		 * trigger that no longer exists.
 		 */
-		ret = 0;
-		goto end_unlock;
+		return 0;
 	}
 
-	element = caa_container_of(node, struct notification_trigger_tokens_ht_element, node);
-
 	if (lttng_condition_event_rule_matches_get_capture_descriptor_count(
 		    lttng_trigger_get_const_condition(element->trigger), &capture_count) !=
 	    LTTNG_CONDITION_STATUS_OK) {
 		ERR("Failed to get capture count");
-		ret = -1;
-		goto end;
+		return -1;
 	}
 
-	if (!notification->capture_buffer && capture_count != 0) {
+	/* The tracers only capture fields for the triggers which have a notify action. */
+	if (!notification->capture_buffer && capture_count != 0 &&
+	    lttng_trigger_has_notify_action(element->trigger)) {
 		ERR("Expected capture but capture buffer is null");
-		ret = -1;
-		goto end;
+		return -1;
 	}
 
 	evaluation = lttng_evaluation_event_rule_matches_create(
@@ -4697,12 +5476,9 @@ dispatch_one_event_notifier_notification(struct notification_thread_state *state
 
 	if (evaluation == nullptr) {
 		ERR("Failed to create event rule matches evaluation while creating and enqueuing action executor job");
-		ret = -1;
-		goto end_unlock;
+		return -1;
 	}
 
-	client_list = get_client_list_from_condition(
-		state, lttng_trigger_get_const_condition(element->trigger));
 	executor_status = action_executor_enqueue_trigger(
 		state->executor, element->trigger, evaluation, nullptr, client_list);
 	switch (executor_status) {
@@ -4759,52 +5535,280 @@ dispatch_one_event_notifier_notification(struct notification_thread_state *state
 		/* Fatal error, shut down everything. */
 		ERR("Fatal error encoutered while enqueuing action to the action executor");
 		ret = -1;
-		goto end_unlock;
+		break;
 	default:
 		/* Unhandled error. */
 		abort();
 	}
 
-end_unlock:
-	notification_client_list_put(client_list);
-end:
 	return ret;
 }
 
 static int handle_one_event_notifier_notification(struct notification_thread_state *state,
 						  int pipe,
-						  enum lttng_domain_type domain)
+						  enum lttng_domain_type domain,
+						  struct event_notifier_notification_batch *batch)
 {
-	int ret = 0;
-	struct lttng_event_notifier_notification *notification = nullptr;
+	int ret;
+	struct lttng_event_notifier_notification notification;
 
-	notification = recv_one_event_notifier_notification(pipe, domain);
-	if (notification == nullptr) {
+	ret = recv_one_event_notifier_notification(pipe, domain, batch, &notification);
+	if (ret) {
 		/* Reception failed, don't consider it fatal. */
 		ERR("Error receiving an event notifier notification from tracer: fd = %i, domain = %s",
 		    pipe,
 		    lttng_domain_type_str(domain));
-		goto end;
+		return 0;
 	}
 
-	ret = dispatch_one_event_notifier_notification(state, notification);
+	ret = dispatch_one_event_notifier_notification(state, &notification, batch);
 	if (ret) {
 		ERR("Error dispatching an event notifier notification from tracer: fd = %i, domain = %s",
 		    pipe,
 		    lttng_domain_type_str(domain));
-		goto end;
 	}
 
-end:
-	lttng_event_notifier_notification_destroy(notification);
 	return ret;
 }
 
+/*
+ * Handle the notifications available on the pipe of a tracer event source, up
+ * to MAX_EVENT_NOTIFIER_NOTIFICATIONS_PER_WAKEUP or as many as were read from
+ * it at once, rather than waiting on the poll set again for each of them. The
+ * consecutive notifications of a trigger share its look-up.
+ */
 int handle_notification_thread_event_notification(struct notification_thread_state *state,
 						  int pipe,
 						  enum lttng_domain_type domain)
 {
-	return handle_one_event_notifier_notification(state, pipe, domain);
+	int ret = 0;
+	unsigned int i;
+	struct event_notifier_notification_batch batch;
+	const lttng::urcu::read_lock_guard read_lock;
+
+	event_notifier_notification_batch_init(&batch);
+
+	for (i = 0;; i++) {
+		int available;
+
+		ret = handle_one_event_notifier_notification(state, pipe, domain, &batch);
+		if (ret) {
+			break;
+		}
+
+		/* The notifications already read are dispatched in any case. */
+		if (event_notifier_notification_batch_has_received(&batch)) {
+			continue;
+		}
+
+		if (i + 1 >= MAX_EVENT_NOTIFIER_NOTIFICATIONS_PER_WAKEUP) {
+			break;
+		}
+
+		/* The tracers write each notification atomically. */
+		if (ioctl(pipe, FIONREAD, &available) < 0 || available == 0) {
+			break;
+		}
+	}
+
+	event_notifier_notification_batch_fini(&batch);
+	return ret;
+}
+
+static bool trigger_threshold_less(const trigger_threshold& a,
+					   const trigger_threshold& b)
+{
+	return a.threshold < b.threshold;
+}
+
+/*
+ * Rebuild the sorted buffer usage thresholds and the channel rate triggers
+ * of the triggers applying to a channel, if the triggers of the channel
+ * changed since they were built.
+ *
+ * Return 0 on success, -1 on allocation error.
+ */
+static int channel_trigger_list_update_thresholds(struct lttng_channel_trigger_list *trigger_list,
+						  uint64_t buffer_capacity)
+{
+	struct lttng_trigger_list_element *trigger_list_element;
+	struct trigger_threshold *high_thresholds = nullptr, *low_thresholds = nullptr;
+	struct lttng_trigger **rate_triggers = nullptr;
+	size_t high_count = 0, low_count = 0, rate_count = 0, trigger_count = 0;
+	uint64_t max_rate_window_us = 0;
+
+	if (!trigger_list->thresholds_stale) {
+		return 0;
+	}
+
+	cds_list_for_each_entry (trigger_list_element, &trigger_list->list, node) {
+		trigger_count++;
+	}
+
+	if (trigger_count > 0) {
+		high_thresholds = calloc<trigger_threshold>(trigger_count);
+		low_thresholds = calloc<trigger_threshold>(trigger_count);
+		rate_triggers = calloc<lttng_trigger *>(trigger_count);
+		if (!high_thresholds || !low_thresholds || !rate_triggers) {
+			ERR("Failed to allocate buffer usage thresholds of channel");
+			free(high_thresholds);
+			free(low_thresholds);
+			free(rate_triggers);
+			return -1;
+		}
+	}
+
+	cds_list_for_each_entry (trigger_list_element, &trigger_list->list, node) {
+		const struct lttng_condition *condition =
+			lttng_trigger_get_const_condition(trigger_list_element->trigger);
+		struct trigger_threshold *entry;
+
+		switch (lttng_condition_get_type(condition)) {
+		case LTTNG_CONDITION_TYPE_BUFFER_USAGE_HIGH:
+			entry = &high_thresholds[high_count++];
+			break;
+		case LTTNG_CONDITION_TYPE_BUFFER_USAGE_LOW:
+			entry = &low_thresholds[low_count++];
+			break;
+		case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+		{
+			const struct lttng_condition_channel_rate *rate_condition =
+				lttng::utils::container_of(condition,
+							   &lttng_condition_channel_rate::parent);
+
+			rate_triggers[rate_count++] = trigger_list_element->trigger;
+			max_rate_window_us =
+				std::max(max_rate_window_us, rate_condition->window_us.value);
+			continue;
+		}
+		default:
+			/* Unknown condition type; internal error. */
+			abort();
+		}
+
+		entry->threshold = buffer_usage_condition_threshold(condition, buffer_capacity);
+		entry->trigger = trigger_list_element->trigger;
+	}
+
+	std::sort(high_thresholds, high_thresholds + high_count, trigger_threshold_less);
+	std::sort(low_thresholds, low_thresholds + low_count, trigger_threshold_less);
+
+	free(trigger_list->high_thresholds);
+	free(trigger_list->low_thresholds);
+	free(trigger_list->rate_triggers);
+	trigger_list->high_thresholds = high_thresholds;
+	trigger_list->high_threshold_count = high_count;
+	trigger_list->low_thresholds = low_thresholds;
+	trigger_list->low_threshold_count = low_count;
+	trigger_list->rate_triggers = rate_triggers;
+	trigger_list->rate_trigger_count = rate_count;
+	trigger_list->max_rate_window_us = max_rate_window_us;
+	trigger_list->thresholds_stale = false;
+	return 0;
+}
+
+/*
+ * Append a sample to the rate history of a channel, first dropping the
+ * samples which were out of `window_us` as of the previous sample: they are
+ * not needed to evaluate the conditions against the previous sample anymore.
+ *
+ * Return 0 on success, -1 on allocation error.
+ */
+static int channel_rate_history_add(struct channel_rate_history *history,
+				    const struct channel_rate_sample *sample,
+				    uint64_t window_us)
+{
+	if (history->count > 0) {
+		const uint64_t previous_timestamp_us =
+			history->samples[history->count - 1].timestamp_us;
+		size_t expired_count = 0;
+
+		while (expired_count < history->count - 1 &&
+		       previous_timestamp_us - history->samples[expired_count].timestamp_us >
+			       window_us) {
+			expired_count++;
+		}
+
+		/* Bound the memory used by very long windows. */
+		if (history->count - expired_count >= CHANNEL_RATE_HISTORY_MAX_SAMPLES) {
+			expired_count = history->count - CHANNEL_RATE_HISTORY_MAX_SAMPLES + 1;
+		}
+
+		memmove(history->samples,
+			history->samples + expired_count,
+			(history->count - expired_count) * sizeof(*history->samples));
+		history->count -= expired_count;
+	}
+
+	if (history->count == history->capacity) {
+		const size_t new_capacity = std::max<size_t>(history->capacity * 2, 8);
+		auto *new_samples = (struct channel_rate_sample *) realloc(
+			history->samples, new_capacity * sizeof(*history->samples));
+
+		if (!new_samples) {
+			PERROR("Failed to grow channel rate history");
+			return -1;
+		}
+
+		history->samples = new_samples;
+		history->capacity = new_capacity;
+	}
+
+	history->samples[history->count++] = *sample;
+	return 0;
+}
+
+/*
+ * Rebuild the sorted consumed size thresholds of the triggers applying to a
+ * session, if the triggers of the session changed since they were built.
+ *
+ * Return 0 on success, -1 on allocation error.
+ */
+static int session_trigger_list_update_thresholds(struct lttng_session_trigger_list *trigger_list)
+{
+	struct lttng_trigger_list_element *trigger_list_element;
+	struct trigger_threshold *thresholds = nullptr;
+	size_t count = 0, trigger_count = 0;
+
+	if (!trigger_list->thresholds_stale) {
+		return 0;
+	}
+
+	cds_list_for_each_entry (trigger_list_element, &trigger_list->list, node) {
+		trigger_count++;
+	}
+
+	if (trigger_count > 0) {
+		thresholds = calloc<trigger_threshold>(trigger_count);
+		if (!thresholds) {
+			ERR("Failed to allocate consumed size thresholds of session");
+			return -1;
+		}
+	}
+
+	cds_list_for_each_entry (trigger_list_element, &trigger_list->list, node) {
+		const struct lttng_condition *condition =
+			lttng_trigger_get_const_condition(trigger_list_element->trigger);
+
+		/* The rotation conditions aren't evaluated on channel samples. */
+		if (lttng_condition_get_type(condition) !=
+		    LTTNG_CONDITION_TYPE_SESSION_CONSUMED_SIZE) {
+			continue;
+		}
+
+		thresholds[count].threshold = session_consumed_size_condition_threshold(condition);
+		thresholds[count].trigger = trigger_list_element->trigger;
+		count++;
+	}
+
+	std::sort(thresholds, thresholds + count, trigger_threshold_less);
+
+	free(trigger_list->consumed_size_thresholds);
+	trigger_list->consumed_size_thresholds = thresholds;
+	trigger_list->consumed_size_threshold_count = count;
+	trigger_list->thresholds_stale = false;
+	return 0;
 }
 
 int handle_notification_thread_channel_sample(struct notification_thread_state *state,
@@ -4818,13 +5822,20 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 	struct cds_lfht_iter iter;
 	struct lttng_channel_trigger_list *channel_trigger_list;
 	struct lttng_session_trigger_list *session_trigger_list;
-	struct lttng_trigger_list_element *trigger_list_element;
 	bool previous_sample_available = false;
 	struct channel_state_sample channel_previous_sample, channel_new_sample;
 	struct session_state_sample session_new_sample;
 	struct lttng_credentials channel_creds = {};
 	struct lttng_credentials session_creds = {};
 	struct session_info *session;
+	const struct trigger_threshold *high_candidates, *low_candidates;
+	const struct trigger_threshold *session_candidates;
+	size_t high_candidate_count, low_candidate_count, candidate_count, session_candidate_count,
+		i;
+	struct channel_state_sample *stored_sample = nullptr;
+	struct timespec reception_time;
+	const bool reception_time_available =
+		lttng_clock_gettime(CLOCK_MONOTONIC, &reception_time) == 0;
 	lttng::urcu::read_lock_guard read_lock;
 
 	/*
@@ -4843,6 +5854,9 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 	channel_new_sample.key.domain = domain;
 	channel_new_sample.highest_usage = sample_msg.highest;
 	channel_new_sample.lowest_usage = sample_msg.lowest;
+	channel_new_sample.consumed_bytes = sample_msg.consumed_since_last_sample;
+	channel_new_sample.writeback_bytes_in_flight = sample_msg.writeback_bytes_in_flight;
+	channel_new_sample.rate_history = nullptr;
 
 	session = get_session_info_by_id(state, sample_msg.session_id);
 	if (!session) {
@@ -4860,7 +5874,32 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 
 	session_trigger_list = get_session_trigger_list(state, session->name);
 	LTTNG_ASSERT(session_trigger_list);
-	cds_list_for_each_entry (trigger_list_element, &session_trigger_list->list, node) {
+	ret = session_trigger_list_update_thresholds(session_trigger_list);
+	if (ret) {
+		goto end_unlock;
+	}
+
+	{
+		/*
+		 * The consumed size of a session only grows: only the
+		 * thresholds in (previous, latest] can have been crossed.
+		 */
+		const trigger_threshold previous = {
+			session->last_state_sample.consumed_data_size, nullptr
+		};
+		const trigger_threshold latest = { session_new_sample.consumed_data_size,
+						   nullptr };
+		const trigger_threshold *begin = session_trigger_list->consumed_size_thresholds;
+		const trigger_threshold *end =
+			begin + session_trigger_list->consumed_size_threshold_count;
+
+		begin = std::upper_bound(begin, end, previous, trigger_threshold_less);
+		end = std::upper_bound(begin, end, latest, trigger_threshold_less);
+		session_candidates = begin;
+		session_candidate_count = end - begin;
+	}
+
+	for (i = 0; i < session_candidate_count; i++) {
 		const struct lttng_condition *condition;
 		struct lttng_trigger *trigger;
 		struct notification_client_list *client_list = nullptr;
@@ -4868,7 +5907,7 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 		enum action_executor_status executor_status;
 
 		ret = 0;
-		trigger = trigger_list_element->trigger;
+		trigger = session_candidates[i].trigger;
 		condition = lttng_trigger_get_const_condition(trigger);
 		LTTNG_ASSERT(condition);
 
@@ -4943,13 +5982,14 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 	channel_info = caa_container_of(node, struct channel_info, channels_ht_node);
 	DBG("Handling channel sample for channel %s (key = %" PRIu64
 	    ") in session %s (highest usage = %" PRIu64 ", lowest usage = %" PRIu64
-	    ", consumed since last sample = %" PRIu64 ")",
+	    ", consumed since last sample = %" PRIu64 ", writeback bytes in flight = %" PRIu64 ")",
 	    channel_info->name,
 	    channel_new_sample.key.key,
 	    channel_info->session_info->name,
 	    channel_new_sample.highest_usage,
 	    channel_new_sample.lowest_usage,
-	    sample_msg.consumed_since_last_sample);
+	    sample_msg.consumed_since_last_sample,
+	    channel_new_sample.writeback_bytes_in_flight);
 
 	/* Retrieve the channel's last sample, if it exists, and update it. */
 	cds_lfht_lookup(state->channel_state_ht,
@@ -4959,8 +5999,6 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 			&iter);
 	node = cds_lfht_iter_get_node(&iter);
 	if (caa_likely(node)) {
-		struct channel_state_sample *stored_sample;
-
 		/* Update the sample stored. */
 		stored_sample =
 			caa_container_of(node, struct channel_state_sample, channel_state_ht_node);
@@ -4968,14 +6006,16 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 		memcpy(&channel_previous_sample, stored_sample, sizeof(channel_previous_sample));
 		stored_sample->highest_usage = channel_new_sample.highest_usage;
 		stored_sample->lowest_usage = channel_new_sample.lowest_usage;
+		stored_sample->consumed_bytes += sample_msg.consumed_since_last_sample;
+		stored_sample->writeback_bytes_in_flight =
+			channel_new_sample.writeback_bytes_in_flight;
+		channel_new_sample.consumed_bytes = stored_sample->consumed_bytes;
 		previous_sample_available = true;
 	} else {
 		/*
 		 * This is the channel's first sample, allocate space for and
 		 * store the new sample.
 		 */
-		struct channel_state_sample *stored_sample;
-
 		stored_sample = zmalloc<channel_state_sample>();
 		if (!stored_sample) {
 			ret = -1;
@@ -5005,7 +6045,84 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 
 	channel_trigger_list =
 		caa_container_of(node, struct lttng_channel_trigger_list, channel_triggers_ht_node);
-	cds_list_for_each_entry (trigger_list_element, &channel_trigger_list->list, node) {
+	ret = channel_trigger_list_update_thresholds(channel_trigger_list, channel_info->capacity);
+	if (ret) {
+		goto end_unlock;
+	}
+
+	/* Only keep the history of the channels having channel rate triggers. */
+	if (channel_trigger_list->rate_trigger_count == 0) {
+		channel_rate_history_destroy(stored_sample->rate_history);
+		stored_sample->rate_history = nullptr;
+	} else if (reception_time_available) {
+		const struct channel_rate_sample rate_sample = {
+			.timestamp_us = (uint64_t) reception_time.tv_sec * USEC_PER_SEC +
+				(uint64_t) reception_time.tv_nsec / NSEC_PER_USEC,
+			.consumed_bytes = stored_sample->consumed_bytes,
+			.discarded_events = sample_msg.discarded_events,
+			.lost_packets = sample_msg.lost_packets,
+		};
+
+		if (!stored_sample->rate_history) {
+			stored_sample->rate_history = zmalloc<channel_rate_history>();
+			if (!stored_sample->rate_history) {
+				ret = -1;
+				goto end_unlock;
+			}
+		}
+
+		ret = channel_rate_history_add(stored_sample->rate_history,
+					       &rate_sample,
+					       channel_trigger_list->max_rate_window_us);
+		if (ret) {
+			goto end_unlock;
+		}
+	}
+	channel_new_sample.rate_history = stored_sample->rate_history;
+
+	{
+		/*
+		 * The conditions only trigger on an evaluation transition: only
+		 * the high thresholds in (previous, latest] and the low
+		 * thresholds in [latest, previous) can have been crossed.
+		 */
+		const trigger_threshold latest = {
+			channel_new_sample.highest_usage, nullptr
+		};
+		const trigger_threshold *high_begin = channel_trigger_list->high_thresholds;
+		const trigger_threshold *high_end =
+			high_begin + channel_trigger_list->high_threshold_count;
+		const trigger_threshold *low_begin = channel_trigger_list->low_thresholds;
+		const trigger_threshold *low_end =
+			low_begin + channel_trigger_list->low_threshold_count;
+
+		if (previous_sample_available) {
+			const trigger_threshold previous = {
+				channel_previous_sample.highest_usage, nullptr
+			};
+
+			high_begin = std::upper_bound(
+				high_begin, high_end, previous, trigger_threshold_less);
+			low_end = std::lower_bound(
+				low_begin, low_end, previous, trigger_threshold_less);
+		}
+
+		high_end = std::upper_bound(
+			high_begin, high_end, latest, trigger_threshold_less);
+		low_begin = std::lower_bound(
+			low_begin, low_end, latest, trigger_threshold_less);
+
+		high_candidates = high_begin;
+		high_candidate_count = high_end - high_begin;
+		low_candidates = low_begin;
+		low_candidate_count = low_end - low_begin;
+	}
+
+	/* The rates are evaluated on every sample. */
+	candidate_count = high_candidate_count + low_candidate_count +
+		channel_trigger_list->rate_trigger_count;
+
+	for (i = 0; i < candidate_count; i++) {
 		const struct lttng_condition *condition;
 		struct lttng_trigger *trigger;
 		struct notification_client_list *client_list = nullptr;
@@ -5013,7 +6130,14 @@ int handle_notification_thread_channel_sample(struct notification_thread_state *
 		enum action_executor_status executor_status;
 
 		ret = 0;
-		trigger = trigger_list_element->trigger;
+		if (i < high_candidate_count) {
+			trigger = high_candidates[i].trigger;
+		} else if (i < high_candidate_count + low_candidate_count) {
+			trigger = low_candidates[i - high_candidate_count].trigger;
+		} else {
+			trigger = channel_trigger_list->rate_triggers[i - high_candidate_count -
+								      low_candidate_count];
+		}
 		condition = lttng_trigger_get_const_condition(trigger);
 		LTTNG_ASSERT(condition);
 
@@ -28,6 +28,10 @@ int handle_notification_thread_client_disconnect_all(struct notification_thread_
 
 int handle_notification_thread_trigger_unregister_all(struct notification_thread_state *state);
 
+struct notification_event_tracer_event_source_element *
+find_tracer_event_source_element(const struct notification_thread_state *state,
+				 int tracer_event_source_fd);
+
 int handle_notification_thread_tracer_event_source_died(struct notification_thread_state *state,
 							int tracer_event_source_fd);
 
@@ -99,6 +99,29 @@ struct lttng_event_notifier_notification {
 
 struct notification_client_list_element {
 	struct notification_client *client;
+	/*
+	 * Identifies the subscription of the client to the condition of the
+	 * list, to which the notifications deferred on overflow belong.
+	 */
+	const void *subscription;
+	/*
+	 * Copied from the subscription. The number of notifications deferred
+	 * on overflow is only meaningful if the policy isn't
+	 * LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP.
+	 */
+	enum lttng_notification_channel_overflow_policy overflow_policy;
+	unsigned int overflow_queue_size;
+	struct cds_list_head node;
+};
+
+/*
+ * Notification which was emitted while the client had outgoing data left,
+ * sent once its outgoing queue is flushed.
+ */
+struct notification_client_deferred_notification {
+	const void *subscription;
+	/* Complete notification message. */
+	struct lttng_payload message;
 	struct cds_list_head node;
 };
 
@@ -222,6 +245,12 @@ struct notification_client {
 			 */
 			bool queued_command_reply;
 			struct lttng_payload payload;
+			/*
+			 * List of struct
+			 * notification_client_deferred_notification, oldest
+			 * first, appended to the payload once it is flushed.
+			 */
+			struct cds_list_head deferred_notifications;
 		} outbound;
 	} communication;
 	/* call_rcu delayed reclaim. */
@@ -258,13 +287,4 @@ int notification_thread_client_communication_update(
 	notification_client_id id,
 	enum client_transmission_status transmission_status);
 
-/*
- * Takes ownership of the payload if present.
- */
-struct lttng_event_notifier_notification *lttng_event_notifier_notification_create(
-	uint64_t tracer_token, enum lttng_domain_type domain, char *payload, size_t payload_size);
-
-void lttng_event_notifier_notification_destroy(
-	struct lttng_event_notifier_notification *event_notifier_notification);
-
 #endif /* NOTIFICATION_THREAD_INTERNAL_H */
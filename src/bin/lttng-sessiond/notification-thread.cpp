@@ -365,6 +365,10 @@ static void fini_thread_state(struct notification_thread_state *state)
 		ret = cds_lfht_destroy(state->trigger_tokens_ht, nullptr);
 		LTTNG_ASSERT(!ret);
 	}
+	if (state->tracer_event_sources_ht) {
+		ret = cds_lfht_destroy(state->tracer_event_sources_ht, nullptr);
+		LTTNG_ASSERT(!ret);
+	}
 	/*
 	 * Must be destroyed after all channels have been destroyed.
 	 * See comment in struct lttng_session_trigger_list.
@@ -489,6 +493,12 @@ static int init_thread_state(struct notification_thread_handle *handle,
 		goto error;
 	}
 
+	state->tracer_event_sources_ht = cds_lfht_new(
+		DEFAULT_HT_SIZE, 1, 0, CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING, nullptr);
+	if (!state->tracer_event_sources_ht) {
+		goto error;
+	}
+
 	CDS_INIT_LIST_HEAD(&state->tracer_event_sources_list);
 
 	state->executor = action_executor_create(handle);
@@ -586,20 +596,17 @@ static bool fd_is_event_notification_source(const struct notification_thread_sta
 					    int fd,
 					    enum lttng_domain_type *domain)
 {
-	struct notification_event_tracer_event_source_element *source_element;
+	const struct notification_event_tracer_event_source_element *source_element;
 
 	LTTNG_ASSERT(domain);
 
-	cds_list_for_each_entry (source_element, &state->tracer_event_sources_list, node) {
-		if (source_element->fd != fd) {
-			continue;
-		}
-
-		*domain = source_element->domain;
-		return true;
+	source_element = find_tracer_event_source_element(state, fd);
+	if (!source_element) {
+		return false;
 	}
 
-	return false;
+	*domain = source_element->domain;
+	return true;
 }
 
 /*
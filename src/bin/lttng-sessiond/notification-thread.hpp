@@ -48,6 +48,8 @@ struct notification_event_tracer_event_source_element {
 	bool is_fd_in_poll_set;
 	enum lttng_domain_type domain;
 	struct cds_list_head node;
+	/* Node in the tracer_event_sources_ht. */
+	struct cds_lfht_node tracer_event_sources_ht_node;
 };
 
 struct notification_trigger_tokens_ht_element {
@@ -155,6 +157,11 @@ struct notification_thread_handle {
  *   - tracer_event_sources_list:
  *             A list of tracer event source (read side fd) of type
  *              struct notification_event_tracer_event_source_element.
+ *   - tracer_event_sources_ht:
+ *             associates a tracer event source fd to its
+ *             struct notification_event_tracer_event_source_element, to
+ *             identify the sources of the poll events. The hash table
+ *             holds no ownership of the elements.
  *
  *
  * The thread reacts to the following internal events:
@@ -288,6 +295,7 @@ struct notification_thread_state {
 	 * response to blocking commands.
 	 */
 	struct cds_list_head tracer_event_sources_list;
+	struct cds_lfht *tracer_event_sources_ht;
 	notification_client_id next_notification_client_id;
 	struct action_executor *executor;
 
@@ -32,6 +32,8 @@
 #include <common/make-unique-wrapper.hpp>
 #include <common/pthread-lock.hpp>
 #include <common/scope-exit.hpp>
+#include <common/self-tracing/self-tracing.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/time.hpp>
 #include <common/urcu.hpp>
 #include <common/utils.hpp>
@@ -44,6 +46,7 @@
 #include <lttng/rotate-internal.hpp>
 #include <lttng/trigger/trigger.h>
 
+#include <algorithm>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <memory>
@@ -266,7 +269,13 @@ int check_session_rotation_pending(ltt_session& session,
 		PERROR("Failed to duplicate archived chunk name");
 	}
 
+	session.rotation_phase_durations_us[LTTNG_ROTATION_PHASE_WAIT_DATA] =
+		(lttng_monotonic_now_ns() - session.rotation_wait_data_begin_ns) / 1000;
+	DBG("Rotation of session \"%s\" completed: wait for data = %" PRIu64 " us",
+	    session.name,
+	    session.rotation_phase_durations_us[LTTNG_ROTATION_PHASE_WAIT_DATA]);
 	session_reset_rotation_state(session, LTTNG_ROTATION_STATE_COMPLETED);
+	self_tracepoint(sessiond_rotation_completed, session.id, chunk_being_archived_id);
 
 	if (!session.quiet_rotation) {
 		location = session_get_trace_archive_location(&session);
@@ -333,6 +342,38 @@ int launch_session_rotation(ltt_session& session)
 	return 0;
 }
 
+/*
+ * Check whether the number of ongoing rotations reached the maximal number
+ * of concurrent rotations, in which case the scheduled rotations wait.
+ *
+ * Call with the session list lock held.
+ */
+bool scheduled_rotation_must_wait()
+{
+	unsigned int ongoing_count = 0;
+	struct ltt_session *session;
+	const struct ltt_session_list *list = session_get_list();
+
+	ASSERT_SESSION_LIST_LOCKED();
+
+	if (!the_config.rotation_max_concurrent) {
+		return false;
+	}
+
+	cds_list_for_each_entry (session, &list->head, list) {
+		/*
+		 * Read without the lock of the session, which can't be taken
+		 * while the rotation thread holds the lock of another: an
+		 * estimate is enough to bound the ongoing rotations.
+		 */
+		if (CMM_LOAD_SHARED(session->rotation_state) == LTTNG_ROTATION_STATE_ONGOING) {
+			ongoing_count++;
+		}
+	}
+
+	return ongoing_count >= the_config.rotation_max_concurrent;
+}
+
 int run_job(const rotation_thread_job& job,
 	    ltt_session& session,
 	    notification_thread_handle& notification_thread_handle)
@@ -395,9 +436,11 @@ void ls::rotation_thread_timer_queue_destroy(struct rotation_thread_timer_queue
 }
 
 ls::rotation_thread::rotation_thread(rotation_thread_timer_queue& rotation_timer_queue,
-				     notification_thread_handle& notification_thread_handle) :
+				     notification_thread_handle& notification_thread_handle,
+				     lttng_pipe& rotation_event_pipe) :
 	_rotation_timer_queue(rotation_timer_queue),
-	_notification_thread_handle(notification_thread_handle)
+	_notification_thread_handle(notification_thread_handle),
+	_rotation_event_pipe_fd(lttng_pipe_get_readfd(&rotation_event_pipe))
 {
 	_quit_pipe.reset([]() {
 		auto raw_pipe = lttng_pipe_open(FD_CLOEXEC);
@@ -422,13 +465,14 @@ ls::rotation_thread::rotation_thread(rotation_thread_timer_queue& rotation_timer
 	lttng_poll_init(&_events);
 
 	/*
-	 * Create pollset with size 4:
+	 * Create pollset with size 5:
 	 *	- rotation thread quit pipe,
 	 *	- rotation thread timer queue pipe,
+	 *	- rotation event pipe,
 	 *	- notification channel sock,
 	 *	- subscribtion change event fd
 	 */
-	if (lttng_poll_create(&_events, 4, LTTNG_CLOEXEC) < 0) {
+	if (lttng_poll_create(&_events, 5, LTTNG_CLOEXEC) < 0) {
 		LTTNG_THROW_ERROR("Failed to create poll object for rotation thread");
 	}
 
@@ -442,6 +486,10 @@ ls::rotation_thread::rotation_thread(rotation_thread_timer_queue& rotation_timer
 		LTTNG_THROW_ERROR("Failed to add rotation timer queue event pipe fd to poll set");
 	}
 
+	if (lttng_poll_add(&_events, _rotation_event_pipe_fd, LPOLLIN) < 0) {
+		LTTNG_THROW_ERROR("Failed to add rotation event pipe fd to poll set");
+	}
+
 	if (lttng_poll_add(&_events,
 			   _notification_channel_subscribtion_change_eventfd.fd(),
 			   LPOLLIN) < 0) {
@@ -546,15 +594,206 @@ void ls::rotation_thread::_handle_job_queue()
 		session_lock(job->session);
 		auto session = ltt_session::locked_ptr(job->session);
 
+		if (job->type == ls::rotation_thread_job_type::SCHEDULED_ROTATION &&
+		    scheduled_rotation_must_wait()) {
+			_defer_scheduled_rotation(*session);
+			continue;
+		}
+
 		if (run_job(*job, *session, _notification_thread_handle)) {
 			return;
 		}
 	}
 }
 
+void ls::rotation_thread::_defer_scheduled_rotation(const ltt_session& session)
+{
+	if (std::find(_deferred_scheduled_rotations.begin(),
+		      _deferred_scheduled_rotations.end(),
+		      session.id) != _deferred_scheduled_rotations.end()) {
+		/* Its next scheduled rotation is already waiting. */
+		return;
+	}
+
+	DBG_FMT("Maximal number of concurrent rotations reached, deferring scheduled rotation: session_name=`{}`, max_concurrent_rotations={}",
+		session.name,
+		the_config.rotation_max_concurrent);
+	_deferred_scheduled_rotations.push_back(session.id);
+}
+
+/*
+ * Launch the deferred scheduled rotations, in order, as long as the number of
+ * ongoing rotations allows it.
+ */
+void ls::rotation_thread::_run_deferred_scheduled_rotations()
+{
+	if (_deferred_scheduled_rotations.empty()) {
+		return;
+	}
+
+	session_lock_list();
+	const auto unlock_list = lttng::make_scope_exit([]() noexcept { session_unlock_list(); });
+
+	while (!_deferred_scheduled_rotations.empty() && !scheduled_rotation_must_wait()) {
+		const auto session_id = _deferred_scheduled_rotations.front();
+
+		_deferred_scheduled_rotations.pop_front();
+
+		const auto session = ls::find_locked_session_by_id(session_id);
+		if (!session || !session->rotation_schedule_timer_enabled) {
+			/* Destroyed or unscheduled since. */
+			continue;
+		}
+
+		(void) launch_session_rotation(*session);
+	}
+}
+
+/*
+ * Check the pending rotation of the session of a trace chunk released by a
+ * consumer rather than waiting for its next pending rotation check.
+ */
+void ls::rotation_thread::_handle_trace_chunk_released(uint64_t session_id, uint64_t chunk_id)
+{
+	uint64_t chunk_being_archived_id;
+
+	session_lock_list();
+	const auto unlock_list = lttng::make_scope_exit([]() noexcept { session_unlock_list(); });
+
+	const auto session = ls::find_locked_session_by_id(session_id);
+	if (!session || !session->chunk_being_archived ||
+	    !session->rotation_pending_check_timer_enabled) {
+		return;
+	}
+
+	const auto chunk_status =
+		lttng_trace_chunk_get_id(session->chunk_being_archived, &chunk_being_archived_id);
+	if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK || chunk_being_archived_id != chunk_id) {
+		return;
+	}
+
+	DBG("Trace chunk being archived released by a consumer: session_id = %" PRIu64
+	    ", chunk_id = %" PRIu64,
+	    session_id,
+	    chunk_id);
+	if (check_session_rotation_pending(*session, _notification_thread_handle)) {
+		ERR("Failed to check pending rotation of session \"%s\"", session->name);
+	}
+}
+
+/*
+ * Perform the size-based rotation of a session as soon as the sizes reported
+ * by its consumers reach its rotation size, rather than waiting for the
+ * notification of its consumed size condition, which is only evaluated on the
+ * periodic samples of its channels.
+ */
+void ls::rotation_thread::_handle_consumed_size_reported(uint64_t session_id, uint64_t size)
+{
+	uint64_t threshold;
+
+	session_lock_list();
+	const auto unlock_list = lttng::make_scope_exit([]() noexcept { session_unlock_list(); });
+
+	const auto session = ls::find_locked_session_by_id(session_id);
+	if (!session || !session->rotate_size || !session->rotate_trigger) {
+		return;
+	}
+
+	session->rotate_size_reported_consumed += size;
+	if (session->rotate_size_reported_consumed < session->rotate_size) {
+		return;
+	}
+
+	/*
+	 * The threshold of the condition is the consumed size of the session at
+	 * its last size-based rotation plus its rotation size.
+	 */
+	const auto condition_status = lttng_condition_session_consumed_size_get_threshold(
+		lttng_trigger_get_const_condition(session->rotate_trigger), &threshold);
+	if (condition_status != LTTNG_CONDITION_STATUS_OK) {
+		LTTNG_THROW_ERROR("Failed to get threshold of size-based rotation condition");
+	}
+
+	DBG_FMT("Consumed size reported by the consumers reached the rotation size: session_name=`{}`, reported_consumed_size={}, rotation_size={}",
+		session->name,
+		session->rotate_size_reported_consumed,
+		session->rotate_size);
+	_rotate_on_consumed_size(*session,
+				 threshold - session->rotate_size +
+					 session->rotate_size_reported_consumed);
+}
+
+void ls::rotation_thread::_handle_rotation_events()
+{
+	for (;;) {
+		struct lttcomm_consumer_rotation_event_msg msg;
+
+		const auto read_ret = lttng_read(_rotation_event_pipe_fd, &msg, sizeof(msg));
+		if (read_ret != sizeof(msg)) {
+			DIAGNOSTIC_PUSH
+			DIAGNOSTIC_IGNORE_LOGICAL_OP
+			if (read_ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				DIAGNOSTIC_POP
+				return;
+			}
+
+			LTTNG_THROW_POSIX(
+				lttng::format("Failed to read from rotation event pipe: fd={}",
+					      _rotation_event_pipe_fd),
+				errno);
+		}
+
+		switch (msg.type) {
+		case LTTCOMM_CONSUMER_ROTATION_EVENT_TRACE_CHUNK_RELEASED:
+			_handle_trace_chunk_released(msg.session_id, msg.value);
+			break;
+		case LTTCOMM_CONSUMER_ROTATION_EVENT_CONSUMED_SIZE:
+			try {
+				_handle_consumed_size_reported(msg.session_id, msg.value);
+			} catch (const lttng::ctl::error& e) {
+				/* Not fatal, as for the consumed size notifications. */
+				DBG_FMT("Control error occurred while handling consumed size report: {}",
+					e.what());
+			}
+			break;
+		default:
+			LTTNG_THROW_ERROR(lttng::format(
+				"Unknown rotation event type received from a consumer: type={}",
+				msg.type));
+		}
+	}
+}
+
+void ls::rotation_thread::_rotate_on_consumed_size(ltt_session& session, uint64_t consumed)
+{
+	int ret;
+
+	unsubscribe_session_consumed_size_rotation(session);
+
+	ret = cmd_rotate_session(
+		&session, nullptr, false, LTTNG_TRACE_CHUNK_COMMAND_TYPE_MOVE_TO_COMPLETED);
+	switch (ret) {
+	case LTTNG_OK:
+		break;
+	case -LTTNG_ERR_ROTATION_PENDING:
+		DBG("Rotate already pending, subscribe to the next threshold value");
+		break;
+	case -LTTNG_ERR_ROTATION_MULTIPLE_AFTER_STOP:
+		DBG("Rotation already happened since last stop, subscribe to the next threshold value");
+		break;
+	case -LTTNG_ERR_ROTATION_AFTER_STOP_CLEAR:
+		DBG("Rotation already happened since last stop and clear, subscribe to the next threshold value");
+		break;
+	default:
+		LTTNG_THROW_CTL("Failed to rotate on consumed size notification",
+				static_cast<lttng_error_code>(-ret));
+	}
+
+	subscribe_session_consumed_size_rotation(session, consumed + session.rotate_size);
+}
+
 void ls::rotation_thread::_handle_notification(const lttng_notification& notification)
 {
-	int ret = 0;
 	const char *condition_session_name = nullptr;
 	enum lttng_condition_status condition_status;
 	enum lttng_evaluation_status evaluation_status;
@@ -613,28 +852,7 @@ void ls::rotation_thread::_handle_notification(const lttng_notification& notific
 		return;
 	}
 
-	unsubscribe_session_consumed_size_rotation(*session);
-
-	ret = cmd_rotate_session(
-		session.get(), nullptr, false, LTTNG_TRACE_CHUNK_COMMAND_TYPE_MOVE_TO_COMPLETED);
-	switch (ret) {
-	case LTTNG_OK:
-		break;
-	case -LTTNG_ERR_ROTATION_PENDING:
-		DBG("Rotate already pending, subscribe to the next threshold value");
-		break;
-	case -LTTNG_ERR_ROTATION_MULTIPLE_AFTER_STOP:
-		DBG("Rotation already happened since last stop, subscribe to the next threshold value");
-		break;
-	case -LTTNG_ERR_ROTATION_AFTER_STOP_CLEAR:
-		DBG("Rotation already happened since last stop and clear, subscribe to the next threshold value");
-		break;
-	default:
-		LTTNG_THROW_CTL("Failed to rotate on consumed size notification",
-				static_cast<lttng_error_code>(-ret));
-	}
-
-	subscribe_session_consumed_size_rotation(*session, consumed + session->rotate_size);
+	_rotate_on_consumed_size(*session, consumed);
 }
 
 void ls::rotation_thread::_handle_notification_channel_activity()
@@ -774,6 +992,8 @@ void ls::rotation_thread::_run()
 					_notification_channel_subscribtion_change_eventfd
 						.decrement();
 				}
+			} else if (fd == _rotation_event_pipe_fd) {
+				_handle_rotation_events();
 			} else {
 				/* Job queue or quit pipe activity. */
 
@@ -800,6 +1020,9 @@ void ls::rotation_thread::_run()
 				}
 			}
 		}
+
+		/* A rotation may have completed or been launched since. */
+		_run_deferred_scheduled_rotations();
 	}
 }
 
@@ -904,6 +1127,7 @@ void ls::rotation_thread::subscribe_session_consumed_size_rotation(ltt_session&
 
 	/* Ownership transferred to the session. */
 	session.rotate_trigger = trigger.release();
+	session.rotate_size_reported_consumed = 0;
 }
 
 void ls::rotation_thread::unsubscribe_session_consumed_size_rotation(ltt_session& session)
@@ -21,6 +21,7 @@
 #include <lttng/domain.h>
 #include <lttng/notification/channel-internal.hpp>
 
+#include <deque>
 #include <memory>
 #include <pthread.h>
 #include <semaphore.h>
@@ -40,7 +41,8 @@ public:
 	using uptr = std::unique_ptr<rotation_thread>;
 
 	rotation_thread(rotation_thread_timer_queue& rotation_timer_queue,
-			notification_thread_handle& notification_thread_handle);
+			notification_thread_handle& notification_thread_handle,
+			lttng_pipe& rotation_event_pipe);
 	rotation_thread(const rotation_thread&) = delete;
 	rotation_thread(rotation_thread&&) = delete;
 	rotation_thread& operator=(const rotation_thread&) = delete;
@@ -62,12 +64,24 @@ private:
 	void _thread_function() noexcept;
 	void _run();
 	void _handle_job_queue();
+	void _defer_scheduled_rotation(const ltt_session& session);
+	void _run_deferred_scheduled_rotations();
+	void _handle_rotation_events();
+	void _handle_trace_chunk_released(uint64_t session_id, uint64_t chunk_id);
+	void _handle_consumed_size_reported(uint64_t session_id, uint64_t size);
+	void _rotate_on_consumed_size(ltt_session& session, uint64_t consumed);
 	void _handle_notification(const lttng_notification& notification);
 	void _handle_notification_channel_activity();
 
 	struct rotation_thread_timer_queue& _rotation_timer_queue;
 	/* Access to the notification thread cmd_queue */
 	notification_thread_handle& _notification_thread_handle;
+	/*
+	 * Read end of the pipe on which the consumers announce the release of
+	 * the closed trace chunks and the sizes they consume, owned by the main
+	 * thread.
+	 */
+	const int _rotation_event_pipe_fd;
 	/* Thread-specific quit pipe. */
 	lttng_pipe::uptr _quit_pipe;
 	lttng_notification_channel::uptr _notification_channel;
@@ -79,6 +93,12 @@ private:
 	 */
 	lttng::eventfd _notification_channel_subscribtion_change_eventfd;
 	lttng_poll_event _events;
+	/*
+	 * IDs of the sessions whose scheduled rotation waits for one of the
+	 * ongoing rotations to complete, in the order they were due, see
+	 * LTTNG_ROTATION_MAX_CONCURRENT.
+	 */
+	std::deque<uint64_t> _deferred_scheduled_rotations;
 };
 
 struct rotation_thread_timer_queue *rotation_thread_timer_queue_create(void);
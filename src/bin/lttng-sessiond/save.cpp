@@ -16,6 +16,7 @@
 #include <common/config/session-config.hpp>
 #include <common/defaults.hpp>
 #include <common/error.hpp>
+#include <common/readwrite.hpp>
 #include <common/runas.hpp>
 #include <common/urcu.hpp>
 #include <common/utils.hpp>
@@ -27,6 +28,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <urcu/uatomic.h>
+#include <vector>
 
 /* Return LTTNG_OK on success else a LTTNG_ERR* code. */
 static int save_kernel_channel_attributes(struct config_writer *writer,
@@ -2493,120 +2495,27 @@ end:
 }
 
 /*
- * Save the given session.
+ * Serialize the configuration of a session to an in-memory writer, leaving
+ * the file I/O to write_session_config() once the session is unlocked.
  *
  * Return LTTNG_OK on success else a LTTNG_ERR* code.
  */
-static int save_session(struct ltt_session *session,
-			struct lttng_save_session_attr *attr,
-			lttng_sock_cred *creds)
+static int serialize_session(struct ltt_session *session,
+			     lttng_sock_cred *creds,
+			     struct config_writer **out_writer)
 {
-	int ret, fd = -1;
-	char config_file_path[LTTNG_PATH_MAX];
-	size_t len;
+	int ret;
 	struct config_writer *writer = nullptr;
-	size_t session_name_len;
-	const char *provided_path;
-	int file_open_flags = O_CREAT | O_WRONLY | O_TRUNC;
 
 	LTTNG_ASSERT(session);
-	LTTNG_ASSERT(attr);
 	LTTNG_ASSERT(creds);
 
-	session_name_len = strlen(session->name);
-	memset(config_file_path, 0, sizeof(config_file_path));
-
 	if (!session_access_ok(session, LTTNG_SOCK_GET_UID_CRED(creds)) || session->destroyed) {
 		ret = LTTNG_ERR_EPERM;
 		goto end;
 	}
 
-	provided_path = lttng_save_session_attr_get_output_url(attr);
-	if (provided_path) {
-		DBG3("Save session in provided path %s", provided_path);
-		len = strlen(provided_path);
-		if (len >= sizeof(config_file_path)) {
-			ret = LTTNG_ERR_SET_URL;
-			goto end;
-		}
-		strncpy(config_file_path, provided_path, sizeof(config_file_path));
-	} else {
-		ssize_t ret_len;
-		char *home_dir = utils_get_user_home_dir(LTTNG_SOCK_GET_UID_CRED(creds));
-		if (!home_dir) {
-			ret = LTTNG_ERR_SET_URL;
-			goto end;
-		}
-
-		ret_len = snprintf(config_file_path,
-				   sizeof(config_file_path),
-				   DEFAULT_SESSION_HOME_CONFIGPATH,
-				   home_dir);
-		free(home_dir);
-		if (ret_len < 0) {
-			PERROR("snprintf save session");
-			ret = LTTNG_ERR_SET_URL;
-			goto end;
-		}
-		len = ret_len;
-	}
-
-	/*
-	 * Check the path fits in the config file path dst including the '/'
-	 * followed by trailing .lttng extension and the NULL terminated string.
-	 */
-	if ((len + session_name_len + 2 + sizeof(DEFAULT_SESSION_CONFIG_FILE_EXTENSION)) >
-	    sizeof(config_file_path)) {
-		ret = LTTNG_ERR_SET_URL;
-		goto end;
-	}
-
-	ret = run_as_mkdir_recursive(config_file_path,
-				     S_IRWXU | S_IRWXG,
-				     LTTNG_SOCK_GET_UID_CRED(creds),
-				     LTTNG_SOCK_GET_GID_CRED(creds));
-	if (ret) {
-		ret = LTTNG_ERR_SET_URL;
-		goto end;
-	}
-
-	/*
-	 * At this point, we know that everything fits in the buffer. Validation
-	 * was done just above.
-	 */
-	config_file_path[len++] = '/';
-	strncpy(config_file_path + len, session->name, sizeof(config_file_path) - len);
-	len += session_name_len;
-	strcpy(config_file_path + len, DEFAULT_SESSION_CONFIG_FILE_EXTENSION);
-	len += sizeof(DEFAULT_SESSION_CONFIG_FILE_EXTENSION);
-	config_file_path[len] = '\0';
-
-	if (!attr->overwrite) {
-		file_open_flags |= O_EXCL;
-	}
-
-	fd = run_as_open(config_file_path,
-			 file_open_flags,
-			 S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP,
-			 LTTNG_SOCK_GET_UID_CRED(creds),
-			 LTTNG_SOCK_GET_GID_CRED(creds));
-	if (fd < 0) {
-		PERROR("Could not create configuration file");
-		switch (errno) {
-		case EEXIST:
-			ret = LTTNG_ERR_SAVE_FILE_EXIST;
-			break;
-		case EACCES:
-			ret = LTTNG_ERR_EPERM;
-			break;
-		default:
-			ret = LTTNG_ERR_SAVE_IO_FAIL;
-			break;
-		}
-		goto end;
-	}
-
-	writer = config_writer_create(fd, 1);
+	writer = config_writer_create_in_memory(1);
 	if (!writer) {
 		ret = LTTNG_ERR_NOMEM;
 		goto end;
@@ -2708,12 +2617,142 @@ static int save_session(struct ltt_session *session,
 		goto end;
 	}
 
+	*out_writer = writer;
+	writer = nullptr;
 	ret = LTTNG_OK;
 end:
-	if (writer && config_writer_destroy(writer)) {
-		/* Preserve the original error code */
-		ret = ret != LTTNG_OK ? ret : LTTNG_ERR_SAVE_IO_FAIL;
+	if (writer) {
+		(void) config_writer_destroy(writer);
+	}
+
+	return ret;
+}
+
+/*
+ * Write the serialized configuration of a session to its configuration file.
+ *
+ * Return LTTNG_OK on success else a LTTNG_ERR* code.
+ */
+static int write_session_config(const char *session_name,
+				struct config_writer *writer,
+				struct lttng_save_session_attr *attr,
+				lttng_sock_cred *creds)
+{
+	int ret, fd = -1;
+	char config_file_path[LTTNG_PATH_MAX];
+	size_t len;
+	size_t session_name_len;
+	const char *provided_path;
+	const char *data;
+	size_t data_size;
+	int file_open_flags = O_CREAT | O_WRONLY | O_TRUNC;
+
+	LTTNG_ASSERT(session_name);
+	LTTNG_ASSERT(writer);
+	LTTNG_ASSERT(attr);
+	LTTNG_ASSERT(creds);
+
+	if (config_writer_get_memory_output(writer, &data, &data_size)) {
+		ret = LTTNG_ERR_SAVE_IO_FAIL;
+		goto end;
 	}
+
+	session_name_len = strlen(session_name);
+	memset(config_file_path, 0, sizeof(config_file_path));
+
+	provided_path = lttng_save_session_attr_get_output_url(attr);
+	if (provided_path) {
+		DBG3("Save session in provided path %s", provided_path);
+		len = strlen(provided_path);
+		if (len >= sizeof(config_file_path)) {
+			ret = LTTNG_ERR_SET_URL;
+			goto end;
+		}
+		strncpy(config_file_path, provided_path, sizeof(config_file_path));
+	} else {
+		ssize_t ret_len;
+		char *home_dir = utils_get_user_home_dir(LTTNG_SOCK_GET_UID_CRED(creds));
+		if (!home_dir) {
+			ret = LTTNG_ERR_SET_URL;
+			goto end;
+		}
+
+		ret_len = snprintf(config_file_path,
+				   sizeof(config_file_path),
+				   DEFAULT_SESSION_HOME_CONFIGPATH,
+				   home_dir);
+		free(home_dir);
+		if (ret_len < 0) {
+			PERROR("snprintf save session");
+			ret = LTTNG_ERR_SET_URL;
+			goto end;
+		}
+		len = ret_len;
+	}
+
+	/*
+	 * Check the path fits in the config file path dst including the '/'
+	 * followed by trailing .lttng extension and the NULL terminated string.
+	 */
+	if ((len + session_name_len + 2 + sizeof(DEFAULT_SESSION_CONFIG_FILE_EXTENSION)) >
+	    sizeof(config_file_path)) {
+		ret = LTTNG_ERR_SET_URL;
+		goto end;
+	}
+
+	ret = run_as_mkdir_recursive(config_file_path,
+				     S_IRWXU | S_IRWXG,
+				     LTTNG_SOCK_GET_UID_CRED(creds),
+				     LTTNG_SOCK_GET_GID_CRED(creds));
+	if (ret) {
+		ret = LTTNG_ERR_SET_URL;
+		goto end;
+	}
+
+	/*
+	 * At this point, we know that everything fits in the buffer. Validation
+	 * was done just above.
+	 */
+	config_file_path[len++] = '/';
+	strncpy(config_file_path + len, session_name, sizeof(config_file_path) - len);
+	len += session_name_len;
+	strcpy(config_file_path + len, DEFAULT_SESSION_CONFIG_FILE_EXTENSION);
+	len += sizeof(DEFAULT_SESSION_CONFIG_FILE_EXTENSION);
+	config_file_path[len] = '\0';
+
+	if (!attr->overwrite) {
+		file_open_flags |= O_EXCL;
+	}
+
+	fd = run_as_open(config_file_path,
+			 file_open_flags,
+			 S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP,
+			 LTTNG_SOCK_GET_UID_CRED(creds),
+			 LTTNG_SOCK_GET_GID_CRED(creds));
+	if (fd < 0) {
+		PERROR("Could not create configuration file");
+		switch (errno) {
+		case EEXIST:
+			ret = LTTNG_ERR_SAVE_FILE_EXIST;
+			break;
+		case EACCES:
+			ret = LTTNG_ERR_EPERM;
+			break;
+		default:
+			ret = LTTNG_ERR_SAVE_IO_FAIL;
+			break;
+		}
+		goto end;
+	}
+
+	if (lttng_write(fd, data, data_size) != data_size) {
+		PERROR("Writing XML session configuration");
+		ret = LTTNG_ERR_SAVE_IO_FAIL;
+		goto end;
+	}
+
+	ret = LTTNG_OK;
+end:
 	if (ret != LTTNG_OK) {
 		/* Delete file in case of error */
 		if ((fd >= 0) && unlink(config_file_path)) {
@@ -2733,11 +2772,50 @@ end:
 	return ret;
 }
 
+namespace {
+struct serialized_session {
+	char name[NAME_MAX];
+	struct config_writer *writer;
+};
+
+/* Serialize a locked session, appending it to `sessions`. */
+int serialize_locked_session(struct ltt_session *session,
+			     lttng_sock_cred *creds,
+			     std::vector<serialized_session>& sessions)
+{
+	serialized_session serialized = {};
+	int ret;
+
+	ret = serialize_session(session, creds, &serialized.writer);
+	if (ret != LTTNG_OK) {
+		return ret;
+	}
+
+	strncpy(serialized.name, session->name, sizeof(serialized.name));
+	serialized.name[sizeof(serialized.name) - 1] = '\0';
+	try {
+		sessions.push_back(serialized);
+	} catch (const std::bad_alloc&) {
+		(void) config_writer_destroy(serialized.writer);
+		return LTTNG_ERR_NOMEM;
+	}
+
+	return LTTNG_OK;
+}
+} /* namespace */
+
+/*
+ * The sessions are serialized in memory while they are locked. Their
+ * configuration files are created and written once the sessions and the
+ * session list are unlocked, so that the other commands don't wait for the
+ * file I/O, done through the run-as worker.
+ */
 int cmd_save_sessions(struct lttng_save_session_attr *attr, lttng_sock_cred *creds)
 {
 	int ret;
 	const char *session_name;
 	struct ltt_session *session;
+	std::vector<serialized_session> sessions;
 
 	session_lock_list();
 
@@ -2746,14 +2824,16 @@ int cmd_save_sessions(struct lttng_save_session_attr *attr, lttng_sock_cred *cre
 		session = session_find_by_name(session_name);
 		if (!session) {
 			ret = LTTNG_ERR_SESS_NOT_FOUND;
+			session_unlock_list();
 			goto end;
 		}
 
 		session_lock(session);
-		ret = save_session(session, attr, creds);
+		ret = serialize_locked_session(session, creds, sessions);
 		session_unlock(session);
 		session_put(session);
 		if (ret != LTTNG_OK) {
+			session_unlock_list();
 			goto end;
 		}
 	} else {
@@ -2764,18 +2844,33 @@ int cmd_save_sessions(struct lttng_save_session_attr *attr, lttng_sock_cred *cre
 				continue;
 			}
 			session_lock(session);
-			ret = save_session(session, attr, creds);
+			ret = serialize_locked_session(session, creds, sessions);
 			session_unlock(session);
 			session_put(session);
 			/* Don't abort if we don't have the required permissions. */
 			if (ret != LTTNG_OK && ret != LTTNG_ERR_EPERM) {
+				session_unlock_list();
 				goto end;
 			}
 		}
 	}
+
+	session_unlock_list();
+
+	for (const auto& serialized : sessions) {
+		ret = write_session_config(serialized.name, serialized.writer, attr, creds);
+		/* As above, only the permission errors of the saved session are reported. */
+		if (ret != LTTNG_OK && (session_name || ret != LTTNG_ERR_EPERM)) {
+			goto end;
+		}
+	}
+
 	ret = LTTNG_OK;
 
 end:
-	session_unlock_list();
+	for (const auto& serialized : sessions) {
+		(void) config_writer_destroy(serialized.writer);
+	}
+
 	return ret;
 }
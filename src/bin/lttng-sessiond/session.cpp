@@ -73,6 +73,7 @@ struct ltt_session_list the_session_list = {
 	.removal_cond = PTHREAD_COND_INITIALIZER,
 	.next_uuid = 0,
 	.head = CDS_LIST_HEAD_INIT(the_session_list.head),
+	.ust_active_head = CDS_LIST_HEAD_INIT(the_session_list.ust_active_head),
 };
 } /* namespace */
 
@@ -133,6 +134,7 @@ static void del_session_list(struct ltt_session *ls)
 	LTTNG_ASSERT(ls);
 
 	cds_list_del(&ls->list);
+	cds_list_del_init(&ls->ust_active_list);
 }
 
 /*
@@ -143,6 +145,55 @@ struct ltt_session_list *session_get_list()
 	return &the_session_list;
 }
 
+/*
+ * Add a session to, or remove it from, the sessions whose user space session
+ * is active according to the state of its user space session.
+ *
+ * The session list lock must be held.
+ */
+void session_update_ust_active_index(struct ltt_session *session)
+{
+	bool ust_active;
+
+	LTTNG_ASSERT(session);
+	ASSERT_LOCKED(the_session_list.lock);
+
+	ust_active = session->ust_session && session->ust_session->active;
+	if (ust_active == !cds_list_empty(&session->ust_active_list)) {
+		return;
+	}
+
+	if (ust_active) {
+		cds_list_add(&session->ust_active_list, &the_session_list.ust_active_head);
+	} else {
+		cds_list_del_init(&session->ust_active_list);
+	}
+}
+
+static void free_session_summary_rcu(struct rcu_head *head)
+{
+	free(lttng::utils::container_of(head, &ltt_session_summary::rcu_head));
+}
+
+/*
+ * Replace the summary of a session, taking ownership of `summary`. The previous
+ * summary is freed once the readers that could access it are done.
+ *
+ * The session lock must be held.
+ */
+void session_publish_summary(struct ltt_session *session, struct ltt_session_summary *summary)
+{
+	struct ltt_session_summary *previous_summary;
+
+	LTTNG_ASSERT(session);
+	ASSERT_LOCKED(session->lock);
+
+	previous_summary = rcu_xchg_pointer(&session->summary, summary);
+	if (previous_summary) {
+		call_rcu(&previous_summary->rcu_head, free_session_summary_rcu);
+	}
+}
+
 /*
  * Returns once the session list is empty.
  */
@@ -220,6 +271,10 @@ const char *session_get_net_consumer_hostname(const struct ltt_session *session)
 	case LTTNG_DST_IPV6:
 		hostname = output->dst.net.control.dst.ipv6;
 		break;
+	case LTTNG_DST_UNIX:
+		/* The relay daemon runs on the same host. */
+		hostname = "localhost";
+		break;
 	default:
 		abort();
 	}
@@ -1008,6 +1063,9 @@ static void session_release(struct urcu_ref *ref)
 	free(session->last_archived_chunk_name);
 	free(session->base_path);
 	lttng_trigger_put(session->rotate_trigger);
+	if (session->summary) {
+		call_rcu(&session->summary->rcu_head, free_session_summary_rcu);
+	}
 	free(session);
 	if (session_published) {
 		/*
@@ -1106,22 +1164,30 @@ int session_add_clear_notifier(struct ltt_session *session,
  */
 struct ltt_session *session_find_by_name(const char *name)
 {
-	struct ltt_session *iter;
+	struct lttng_ht_node_str *node;
+	struct lttng_ht_iter iter;
+	struct ltt_session *ls;
 
 	LTTNG_ASSERT(name);
 	ASSERT_LOCKED(the_session_list.lock);
 
 	DBG2("Trying to find session by name %s", name);
 
-	cds_list_for_each_entry (iter, &the_session_list.head, list) {
-		if (!strncmp(iter->name, name, NAME_MAX) && !iter->destroyed) {
-			goto found;
-		}
+	lttng::urcu::read_lock_guard read_lock;
+
+	if (!ltt_sessions_ht_by_name) {
+		return nullptr;
 	}
 
-	return nullptr;
-found:
-	return session_get(iter) ? iter : nullptr;
+	/* The destroyed sessions are removed from the hash table. */
+	lttng_ht_lookup(ltt_sessions_ht_by_name, name, &iter);
+	node = lttng_ht_iter_get_node_str(&iter);
+	if (node == nullptr) {
+		return nullptr;
+	}
+
+	ls = lttng::utils::container_of(node, &ltt_session::node_by_name);
+	return session_get(ls) ? ls : nullptr;
 }
 
 /*
@@ -1300,6 +1366,8 @@ session_create(const char *name, uid_t uid, gid_t gid, struct ltt_session **out_
 
 	new_session->rotation_state = LTTNG_ROTATION_STATE_NO_ROTATION;
 
+	CDS_INIT_LIST_HEAD(&new_session->ust_active_list);
+
 	/* Add new session to the session list. */
 	new_session->id = add_session_list(new_session);
 
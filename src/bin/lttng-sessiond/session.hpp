@@ -19,6 +19,7 @@
 
 #include <lttng/location.h>
 #include <lttng/lttng-error.h>
+#include <lttng/rotate-internal.hpp>
 #include <lttng/rotation.h>
 
 #include <limits.h>
@@ -69,6 +70,26 @@ struct ltt_session_list {
 
 	/* Linked list head */
 	struct cds_list_head head;
+	/*
+	 * Sessions whose user space session is active, linked by their
+	 * ust_active_list node, to update the newly registered applications
+	 * without going through the sessions which can't apply to them.
+	 */
+	struct cds_list_head ust_active_head;
+};
+
+/*
+ * Immutable copy of the listed attributes of a session, published with RCU
+ * to let readers access them without taking the session's lock.
+ */
+struct ltt_session_summary {
+	char name[NAME_MAX];
+	char path[PATH_MAX];
+	bool active;
+	unsigned int snapshot_mode;
+	unsigned int live_timer;
+	time_t creation_time;
+	struct rcu_head rcu_head;
 };
 
 /*
@@ -101,6 +122,8 @@ struct ltt_session {
 	 */
 	pthread_mutex_t lock;
 	struct cds_list_head list;
+	/* Node of the session list's ust_active_head, self-linked when not in it. */
+	struct cds_list_head ust_active_list;
 	/* session unique identifier */
 	id_t id;
 	/* Indicates if the session has been added to the session list and ht.*/
@@ -201,18 +224,35 @@ struct ltt_session {
 	 * Trigger for size-based rotations.
 	 */
 	struct lttng_trigger *rotate_trigger;
+	/*
+	 * Size consumed from the channels of the session, as reported directly
+	 * by the consumers, since the last size-based rotation.
+	 */
+	uint64_t rotate_size_reported_consumed;
 	LTTNG_OPTIONAL(uint64_t) most_recent_chunk_id;
 	struct lttng_trace_chunk *current_trace_chunk;
 	struct lttng_trace_chunk *chunk_being_archived;
 	/* Current state of a rotation. */
 	enum lttng_rotation_state rotation_state;
 	bool quiet_rotation;
+	/*
+	 * Durations of the phases of the last rotation, in microseconds,
+	 * indexed by the values of enum lttng_rotation_phase, and start of its
+	 * LTTNG_ROTATION_PHASE_WAIT_DATA phase.
+	 */
+	uint64_t rotation_phase_durations_us[LTTNG_ROTATION_PHASE_COUNT];
+	uint64_t rotation_wait_data_begin_ns;
 	char *last_archived_chunk_name;
 	LTTNG_OPTIONAL(uint64_t) last_archived_chunk_id;
 	struct lttng_dynamic_array destroy_notifiers;
 	struct lttng_dynamic_array clear_notifiers;
 	/* Session base path override. Set non-null. */
 	char *base_path;
+	/*
+	 * Summary of the session, regenerated after the commands changing its
+	 * attributes. Read with rcu_dereference() under the RCU read lock.
+	 */
+	struct ltt_session_summary *summary;
 };
 
 enum lttng_error_code
@@ -258,6 +298,8 @@ struct ltt_session *session_find_by_name(const char *name);
 struct ltt_session *session_find_by_id(ltt_session::id_t id);
 
 struct ltt_session_list *session_get_list();
+void session_update_ust_active_index(struct ltt_session *session);
+void session_publish_summary(struct ltt_session *session, struct ltt_session_summary *summary);
 void session_list_wait_empty();
 
 bool session_access_ok(struct ltt_session *session, uid_t uid);
@@ -28,6 +28,20 @@ static struct sessiond_config sessiond_config_build_defaults = {
 	.event_notifier_buffer_size_kernel = DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE,
 	.event_notifier_buffer_size_userspace = DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE,
 	.app_socket_timeout = DEFAULT_APP_SOCKET_RW_TIMEOUT,
+	.relayd_data_connection_count = DEFAULT_RELAYD_DATA_CONNECTION_COUNT,
+	.app_registration_thread_count = DEFAULT_APP_REGISTRATION_THREAD_COUNT,
+	.agent_registration_thread_count = DEFAULT_AGENT_REGISTRATION_THREAD_COUNT,
+	.app_command_thread_count = DEFAULT_APP_COMMAND_THREAD_COUNT,
+	.client_command_thread_count = DEFAULT_CLIENT_COMMAND_THREAD_COUNT,
+	.ust_metadata_push_delay_ms = DEFAULT_UST_METADATA_PUSH_DELAY_MS,
+	.ust_metadata_push_threshold = DEFAULT_UST_METADATA_PUSH_THRESHOLD,
+	.ust_per_pid_shared_metadata = DEFAULT_UST_PER_PID_SHARED_METADATA,
+	.ust_lazy_per_pid_channels = DEFAULT_UST_LAZY_PER_PID_CHANNELS,
+	.ust_tracepoint_list_cache_ms = DEFAULT_UST_TRACEPOINT_LIST_CACHE_MS,
+	.persistent_triggers = DEFAULT_PERSISTENT_TRIGGERS,
+	.fast_clear = DEFAULT_FAST_CLEAR,
+	.rotation_schedule_stagger = DEFAULT_ROTATION_SCHEDULE_STAGGER,
+	.rotation_max_concurrent = DEFAULT_ROTATION_MAX_CONCURRENT,
 
 	.quiet = false,
 
@@ -40,6 +54,8 @@ static struct sessiond_config sessiond_config_build_defaults = {
 
 	.kmod_probes_list = { nullptr, false },
 	.kmod_extra_probes_list = { nullptr, false },
+	.kmod_probes_lazy = DEFAULT_KMOD_PROBES_LAZY,
+	.kmod_probes_load_thread_count = DEFAULT_KMOD_PROBES_LOAD_THREAD_COUNT,
 
 	.rundir = { nullptr, false },
 
@@ -117,6 +133,247 @@ int sessiond_config_apply_env_config(struct sessiond_config *config)
 		config->app_socket_timeout = int_val;
 	}
 
+	env_value = lttng_secure_getenv(DEFAULT_RELAYD_DATA_CONNECTION_COUNT_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value || int_val == 0 ||
+		    int_val > DEFAULT_RELAYD_MAX_DATA_CONNECTION_COUNT) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 1 to %d)",
+			    env_value,
+			    DEFAULT_RELAYD_DATA_CONNECTION_COUNT_ENV,
+			    DEFAULT_RELAYD_MAX_DATA_CONNECTION_COUNT);
+			ret = -1;
+			goto end;
+		}
+
+		config->relayd_data_connection_count = (unsigned int) int_val;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_APP_REGISTRATION_THREAD_COUNT_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value || int_val == 0 ||
+		    int_val > DEFAULT_APP_REGISTRATION_MAX_THREAD_COUNT) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 1 to %d)",
+			    env_value,
+			    DEFAULT_APP_REGISTRATION_THREAD_COUNT_ENV,
+			    DEFAULT_APP_REGISTRATION_MAX_THREAD_COUNT);
+			ret = -1;
+			goto end;
+		}
+
+		config->app_registration_thread_count = (unsigned int) int_val;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_AGENT_REGISTRATION_THREAD_COUNT_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value || int_val == 0 ||
+		    int_val > DEFAULT_AGENT_REGISTRATION_MAX_THREAD_COUNT) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 1 to %d)",
+			    env_value,
+			    DEFAULT_AGENT_REGISTRATION_THREAD_COUNT_ENV,
+			    DEFAULT_AGENT_REGISTRATION_MAX_THREAD_COUNT);
+			ret = -1;
+			goto end;
+		}
+
+		config->agent_registration_thread_count = (unsigned int) int_val;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_APP_COMMAND_THREAD_COUNT_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value || int_val == 0 ||
+		    int_val > DEFAULT_APP_COMMAND_MAX_THREAD_COUNT) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 1 to %d)",
+			    env_value,
+			    DEFAULT_APP_COMMAND_THREAD_COUNT_ENV,
+			    DEFAULT_APP_COMMAND_MAX_THREAD_COUNT);
+			ret = -1;
+			goto end;
+		}
+
+		config->app_command_thread_count = (unsigned int) int_val;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_CLIENT_COMMAND_THREAD_COUNT_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value || int_val == 0 ||
+		    int_val > DEFAULT_CLIENT_COMMAND_MAX_THREAD_COUNT) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 1 to %d)",
+			    env_value,
+			    DEFAULT_CLIENT_COMMAND_THREAD_COUNT_ENV,
+			    DEFAULT_CLIENT_COMMAND_MAX_THREAD_COUNT);
+			ret = -1;
+			goto end;
+		}
+
+		config->client_command_thread_count = (unsigned int) int_val;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_UST_METADATA_PUSH_DELAY_MS_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value ||
+		    int_val > DEFAULT_UST_METADATA_PUSH_MAX_DELAY_MS) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 to %d)",
+			    env_value,
+			    DEFAULT_UST_METADATA_PUSH_DELAY_MS_ENV,
+			    DEFAULT_UST_METADATA_PUSH_MAX_DELAY_MS);
+			ret = -1;
+			goto end;
+		}
+
+		config->ust_metadata_push_delay_ms = (unsigned int) int_val;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_UST_METADATA_PUSH_THRESHOLD_ENV);
+	if (env_value) {
+		uint64_t size;
+
+		if (utils_parse_size_suffix(env_value, &size) ||
+		    size > DEFAULT_UST_METADATA_PUSH_MAX_THRESHOLD) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable",
+			    env_value,
+			    DEFAULT_UST_METADATA_PUSH_THRESHOLD_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->ust_metadata_push_threshold = (unsigned int) size;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_UST_PER_PID_SHARED_METADATA_ENV);
+	if (env_value) {
+		if (strcmp(env_value, "0") && strcmp(env_value, "1")) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 or 1)",
+			    env_value,
+			    DEFAULT_UST_PER_PID_SHARED_METADATA_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->ust_per_pid_shared_metadata = !strcmp(env_value, "1");
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_UST_LAZY_PER_PID_CHANNELS_ENV);
+	if (env_value) {
+		if (strcmp(env_value, "0") && strcmp(env_value, "1")) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 or 1)",
+			    env_value,
+			    DEFAULT_UST_LAZY_PER_PID_CHANNELS_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->ust_lazy_per_pid_channels = !strcmp(env_value, "1");
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_UST_TRACEPOINT_LIST_CACHE_MS_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value ||
+		    int_val > DEFAULT_UST_TRACEPOINT_LIST_CACHE_MAX_MS) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 to %d)",
+			    env_value,
+			    DEFAULT_UST_TRACEPOINT_LIST_CACHE_MS_ENV,
+			    DEFAULT_UST_TRACEPOINT_LIST_CACHE_MAX_MS);
+			ret = -1;
+			goto end;
+		}
+
+		config->ust_tracepoint_list_cache_ms = (unsigned int) int_val;
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_PERSISTENT_TRIGGERS_ENV);
+	if (env_value) {
+		if (strcmp(env_value, "0") && strcmp(env_value, "1")) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 or 1)",
+			    env_value,
+			    DEFAULT_PERSISTENT_TRIGGERS_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->persistent_triggers = !strcmp(env_value, "1");
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_FAST_CLEAR_ENV);
+	if (env_value) {
+		if (strcmp(env_value, "0") && strcmp(env_value, "1")) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 or 1)",
+			    env_value,
+			    DEFAULT_FAST_CLEAR_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->fast_clear = !strcmp(env_value, "1");
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_ROTATION_SCHEDULE_STAGGER_ENV);
+	if (env_value) {
+		if (strcmp(env_value, "0") && strcmp(env_value, "1")) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 or 1)",
+			    env_value,
+			    DEFAULT_ROTATION_SCHEDULE_STAGGER_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->rotation_schedule_stagger = !strcmp(env_value, "1");
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_ROTATION_MAX_CONCURRENT_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value ||
+		    int_val > DEFAULT_ROTATION_MAX_CONCURRENT_MAX) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 to %d)",
+			    env_value,
+			    DEFAULT_ROTATION_MAX_CONCURRENT_ENV,
+			    DEFAULT_ROTATION_MAX_CONCURRENT_MAX);
+			ret = -1;
+			goto end;
+		}
+
+		config->rotation_max_concurrent = (unsigned int) int_val;
+	}
+
 	env_value = lttng_secure_getenv("LTTNG_CONSUMERD32_BIN");
 	if (env_value) {
 		config_string_set_static(&config->consumerd32_bin_path, env_value);
@@ -149,6 +406,39 @@ int sessiond_config_apply_env_config(struct sessiond_config *config)
 	if (env_value) {
 		config_string_set_static(&config->kmod_extra_probes_list, env_value);
 	}
+
+	env_value = lttng_secure_getenv(DEFAULT_KMOD_PROBES_LAZY_ENV);
+	if (env_value) {
+		if (strcmp(env_value, "0") && strcmp(env_value, "1")) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 0 or 1)",
+			    env_value,
+			    DEFAULT_KMOD_PROBES_LAZY_ENV);
+			ret = -1;
+			goto end;
+		}
+
+		config->kmod_probes_lazy = !strcmp(env_value, "1");
+	}
+
+	env_value = lttng_secure_getenv(DEFAULT_KMOD_PROBES_LOAD_THREAD_COUNT_ENV);
+	if (env_value) {
+		char *endptr;
+		unsigned long int_val;
+
+		errno = 0;
+		int_val = strtoul(env_value, &endptr, 0);
+		if (errno != 0 || *endptr != '\0' || endptr == env_value || int_val == 0 ||
+		    int_val > DEFAULT_KMOD_PROBES_LOAD_MAX_THREAD_COUNT) {
+			ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 1 to %d)",
+			    env_value,
+			    DEFAULT_KMOD_PROBES_LOAD_THREAD_COUNT_ENV,
+			    DEFAULT_KMOD_PROBES_LOAD_MAX_THREAD_COUNT);
+			ret = -1;
+			goto end;
+		}
+
+		config->kmod_probes_load_thread_count = (unsigned int) int_val;
+	}
 end:
 	return ret;
 }
@@ -481,6 +771,30 @@ void sessiond_config_log(struct sessiond_config *config)
 			   config->agent_tcp_port.end);
 	}
 	DBG_NO_LOC("\tapplication socket timeout:    %i", config->app_socket_timeout);
+	DBG_NO_LOC("\trelayd data connection count:  %u",
+		   config->relayd_data_connection_count);
+	DBG_NO_LOC("\tapp registration threads:      %u",
+		   config->app_registration_thread_count);
+	DBG_NO_LOC("\tagent registration threads:    %u",
+		   config->agent_registration_thread_count);
+	DBG_NO_LOC("\tapp command threads:           %u", config->app_command_thread_count);
+	DBG_NO_LOC("\tclient command threads:        %u",
+		   config->client_command_thread_count);
+	DBG_NO_LOC("\tmetadata push delay:           %u ms", config->ust_metadata_push_delay_ms);
+	DBG_NO_LOC("\tmetadata push threshold:       %u bytes",
+		   config->ust_metadata_push_threshold);
+	DBG_NO_LOC("\tper-PID shared metadata:       %s",
+		   config->ust_per_pid_shared_metadata ? "True" : "False");
+	DBG_NO_LOC("\tlazy per-PID channels:         %s",
+		   config->ust_lazy_per_pid_channels ? "True" : "False");
+	DBG_NO_LOC("\ttracepoint list cache:         %u ms",
+		   config->ust_tracepoint_list_cache_ms);
+	DBG_NO_LOC("\tpersistent triggers:           %s",
+		   config->persistent_triggers ? "True" : "False");
+	DBG_NO_LOC("\tfast clear:                    %s", config->fast_clear ? "True" : "False");
+	DBG_NO_LOC("\trotation schedule stagger:     %s",
+		   config->rotation_schedule_stagger ? "True" : "False");
+	DBG_NO_LOC("\tmax concurrent rotations:      %u", config->rotation_max_concurrent);
 	DBG_NO_LOC("\tno-kernel:                     %s", config->no_kernel ? "True" : "False");
 	DBG_NO_LOC("\tbackground:                    %s", config->background ? "True" : "False");
 	DBG_NO_LOC("\tdaemonize:                     %s", config->daemonize ? "True" : "False");
@@ -490,6 +804,10 @@ void sessiond_config_log(struct sessiond_config *config)
 	DBG_NO_LOC("\tkmod_probe_list:               %s", config->kmod_probes_list.value ?: "None");
 	DBG_NO_LOC("\tkmod_extra_probe_list:         %s",
 		   config->kmod_extra_probes_list.value ?: "None");
+	DBG_NO_LOC("\tkmod_probes_lazy:              %s",
+		   config->kmod_probes_lazy ? "True" : "False");
+	DBG_NO_LOC("\tkmod_probes_load_threads:      %u",
+		   config->kmod_probes_load_thread_count);
 	DBG_NO_LOC("\trundir:                        %s", config->rundir.value ?: "Unknown");
 	DBG_NO_LOC("\tapplication socket path:       %s",
 		   config->apps_unix_sock_path.value ?: "Unknown");
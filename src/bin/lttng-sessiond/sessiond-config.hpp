@@ -34,6 +34,33 @@ struct sessiond_config {
 	int event_notifier_buffer_size_userspace;
 	/* Socket timeout for receiving and sending (in seconds). */
 	int app_socket_timeout;
+	/* Number of data connections made to a relayd by each consumer. */
+	unsigned int relayd_data_connection_count;
+	/* Number of threads which complete the registration of the applications. */
+	unsigned int app_registration_thread_count;
+	/* Number of threads which complete the registration of the agents. */
+	unsigned int agent_registration_thread_count;
+	/* Number of threads handling the applications for a session command. */
+	unsigned int app_command_thread_count;
+	/* Number of threads processing the commands of the clients. */
+	unsigned int client_command_thread_count;
+	/* Coalescing of the metadata pushes to the consumers, disabled if the delay is 0. */
+	unsigned int ust_metadata_push_delay_ms;
+	unsigned int ust_metadata_push_threshold;
+	/* Share the metadata of identical event classes between per-PID registries. */
+	bool ust_per_pid_shared_metadata;
+	/* Defer the per-PID buffers of the applications which provide no enabled event. */
+	bool ust_lazy_per_pid_channels;
+	/* Caching of the listings of the applications' tracepoints, disabled if 0. */
+	unsigned int ust_tracepoint_list_cache_ms;
+	/* Register the triggers of the trigger store again on start. */
+	bool persistent_triggers;
+	/* Truncate the files of the local sessions in place when clearing them. */
+	bool fast_clear;
+	/* Offset the periodic rotation schedules of the sessions by a phase. */
+	bool rotation_schedule_stagger;
+	/* Maximal number of ongoing scheduled rotations, unlimited if 0. */
+	unsigned int rotation_max_concurrent;
 
 	bool quiet;
 	bool no_kernel;
@@ -45,6 +72,10 @@ struct sessiond_config {
 
 	struct config_string kmod_probes_list;
 	struct config_string kmod_extra_probes_list;
+	/* Load the probe modules on their first use. */
+	bool kmod_probes_lazy;
+	/* Number of threads loading the probe modules. */
+	unsigned int kmod_probes_load_thread_count;
 
 	struct config_string rundir;
 
@@ -25,6 +25,11 @@ struct snapshot_output {
 	uint64_t max_size;
 	/* Number of snapshot taken with that output. */
 	uint64_t nb_snapshot;
+	/*
+	 * Only record the packets produced since the previous snapshot. Set
+	 * from the command recording a snapshot, never kept by an output.
+	 */
+	bool incremental;
 	char name[NAME_MAX];
 	struct consumer_output *consumer;
 	int kernel_sockets_copied;
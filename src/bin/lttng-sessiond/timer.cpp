@@ -8,10 +8,13 @@
 
 #define _LGPL_SOURCE
 #include "health-sessiond.hpp"
+#include "lttng-sessiond.hpp"
 #include "rotation-thread.hpp"
 #include "thread.hpp"
 #include "timer.hpp"
 
+#include <common/hashtable/utils.hpp>
+
 #include <inttypes.h>
 #include <signal.h>
 
@@ -132,7 +135,8 @@ static void timer_signal_thread_qs(unsigned int signr)
 
 /*
  * Start a timer on a session that will fire at a given interval
- * (timer_interval_us) and fire a given signal (signal).
+ * (timer_interval_us) and fire a given signal (signal). Its first expiration
+ * is `timer_delay_us` after it starts.
  *
  * Returns a negative value on error, 0 if a timer was created, and
  * a positive value if no timer was created (not an error).
@@ -140,6 +144,7 @@ static void timer_signal_thread_qs(unsigned int signr)
 static int timer_start(timer_t *timer_id,
 		       struct ltt_session *session,
 		       unsigned int timer_interval_us,
+		       unsigned int timer_delay_us,
 		       int signal,
 		       bool one_shot)
 {
@@ -156,14 +161,14 @@ static int timer_start(timer_t *timer_id,
 		goto end;
 	}
 
-	its.it_value.tv_sec = timer_interval_us / 1000000;
-	its.it_value.tv_nsec = (timer_interval_us % 1000000) * 1000;
+	its.it_value.tv_sec = timer_delay_us / 1000000;
+	its.it_value.tv_nsec = (timer_delay_us % 1000000) * 1000;
 	if (one_shot) {
 		its.it_interval.tv_sec = 0;
 		its.it_interval.tv_nsec = 0;
 	} else {
-		its.it_interval.tv_sec = its.it_value.tv_sec;
-		its.it_interval.tv_nsec = its.it_value.tv_nsec;
+		its.it_interval.tv_sec = timer_interval_us / 1000000;
+		its.it_interval.tv_nsec = (timer_interval_us % 1000000) * 1000;
 	}
 
 	ret = timer_settime(*timer_id, 0, &its, nullptr);
@@ -221,6 +226,7 @@ int timer_session_rotation_pending_check_start(struct ltt_session *session,
 	ret = timer_start(&session->rotation_pending_check_timer,
 			  session,
 			  interval_us,
+			  interval_us,
 			  LTTNG_SESSIOND_SIG_PENDING_ROTATION_CHECK,
 			  /* one-shot */ true);
 	if (ret == 0) {
@@ -262,18 +268,31 @@ int timer_session_rotation_schedule_timer_start(struct ltt_session *session,
 						unsigned int interval_us)
 {
 	int ret;
+	unsigned int delay_us = interval_us;
 
 	if (!session_get(session)) {
 		ret = -1;
 		goto end;
 	}
-	DBG("Enabling scheduled rotation timer on session \"%s\" (%ui %s)",
+
+	if (the_config.rotation_schedule_stagger) {
+		/*
+		 * The phase only depends on the name of the session to be the
+		 * same from one run of the session daemon to the next.
+		 */
+		delay_us = hash_key_str(session->name, 0) % interval_us ?: interval_us;
+	}
+
+	DBG("Enabling scheduled rotation timer on session \"%s\" (%ui %s, first in %u %s)",
 	    session->name,
 	    interval_us,
+	    USEC_UNIT,
+	    delay_us,
 	    USEC_UNIT);
 	ret = timer_start(&session->rotation_schedule_timer,
 			  session,
 			  interval_us,
+			  delay_us,
 			  LTTNG_SESSIOND_SIG_SCHEDULED_ROTATION,
 			  /* one-shot */ false);
 	if (ret < 0) {
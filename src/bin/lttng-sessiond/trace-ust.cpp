@@ -9,6 +9,7 @@
 #define _LGPL_SOURCE
 #include "agent.hpp"
 #include "buffer-registry.hpp"
+#include "filter-bytecode-cache.hpp"
 #include "trace-ust.hpp"
 #include "ust-app.hpp"
 #include "utils.hpp"
@@ -303,6 +304,7 @@ struct ltt_ust_session *trace_ust_create_session(uint64_t session_id)
 	lus->buffer_type_changed = 0;
 	/* Init it in case it get used after allocation. */
 	CDS_INIT_LIST_HEAD(&lus->buffer_reg_uid_list);
+	pthread_mutex_init(&lus->buffer_reg_uid_list_lock, nullptr);
 
 	/* Alloc UST global domain channels' HT */
 	lus->domain_global.channels = lttng_ht_new(0, LTTNG_HT_TYPE_STRING);
@@ -372,6 +374,16 @@ struct ltt_ust_channel *trace_ust_create_channel(struct lttng_channel *chan,
 		((struct lttng_channel_extended *) chan->attr.extended.ptr)->monitor_timer_interval;
 	luc->attr.u.s.blocking_timeout =
 		((struct lttng_channel_extended *) chan->attr.extended.ptr)->blocking_timeout;
+	luc->writeback_policy = static_cast<lttng_channel_writeback_policy>(
+		((struct lttng_channel_extended *) chan->attr.extended.ptr)->writeback_policy);
+	luc->writeback_window_size =
+		((struct lttng_channel_extended *) chan->attr.extended.ptr)->writeback_window_size;
+	luc->drain_max_subbuffers =
+		((struct lttng_channel_extended *) chan->attr.extended.ptr)->drain_max_subbuffers;
+	luc->drain_max_bytes =
+		((struct lttng_channel_extended *) chan->attr.extended.ptr)->drain_max_bytes;
+	luc->buffer_page_size = static_cast<lttng_channel_buffer_page_size>(
+		((struct lttng_channel_extended *) chan->attr.extended.ptr)->buffer_page_size);
 
 	/* Translate to UST output enum */
 	switch (luc->attr.output) {
@@ -515,9 +527,19 @@ enum lttng_error_code trace_ust_create_event(struct lttng_event *ev,
 		goto error_free_event;
 	}
 
+	if (filter) {
+		/* Events with the same filter share its bytecode. */
+		local_ust_event->filter = filter_bytecode_acquire(filter);
+		if (!local_ust_event->filter) {
+			ret = LTTNG_ERR_NOMEM;
+			goto error_free_event;
+		}
+
+		free(filter);
+	}
+
 	/* Same layout. */
 	local_ust_event->filter_expression = filter_expression;
-	local_ust_event->filter = filter;
 	local_ust_event->exclusion = exclusion;
 
 	/* Init node */
@@ -969,14 +991,19 @@ end:
 	return ret_code;
 }
 
-/* Called with the session lock held. */
-enum lttng_error_code
-trace_ust_process_attr_tracker_inclusion_set_add_value(struct ltt_ust_session *session,
-						       enum lttng_process_attr process_attr,
-						       const struct process_attr_value *value)
+/*
+ * Add a value to a tracker of the session, setting `should_update_apps` if the
+ * applications must be updated to reflect the change.
+ *
+ * Called with the session lock held.
+ */
+static enum lttng_error_code
+add_process_attr_tracker_value(struct ltt_ust_session *session,
+			       enum lttng_process_attr process_attr,
+			       const struct process_attr_value *value,
+			       bool *should_update_apps)
 {
 	enum lttng_error_code ret_code = LTTNG_OK;
-	bool should_update_apps = false;
 	struct ust_id_tracker *id_tracker = get_id_tracker(session, process_attr);
 	struct process_attr_tracker *tracker;
 	int integral_value;
@@ -1062,28 +1089,30 @@ trace_ust_process_attr_tracker_inclusion_set_add_value(struct ltt_ust_session *s
 	case LTTNG_PROCESS_ATTR_VIRTUAL_PROCESS_ID:
 		app = ust_app_find_by_pid(integral_value);
 		if (app) {
-			should_update_apps = true;
+			*should_update_apps = true;
 		}
 		break;
 	default:
-		should_update_apps = true;
+		*should_update_apps = true;
 		break;
 	}
-	if (should_update_apps && session->active) {
-		ust_app_global_update_all(session);
-	}
 end:
 	return ret_code;
 }
 
-/* Called with the session lock held. */
-enum lttng_error_code
-trace_ust_process_attr_tracker_inclusion_set_remove_value(struct ltt_ust_session *session,
-							  enum lttng_process_attr process_attr,
-							  const struct process_attr_value *value)
+/*
+ * Remove a value from a tracker of the session, setting `should_update_apps`
+ * if the applications must be updated to reflect the change.
+ *
+ * Called with the session lock held.
+ */
+static enum lttng_error_code
+remove_process_attr_tracker_value(struct ltt_ust_session *session,
+				  enum lttng_process_attr process_attr,
+				  const struct process_attr_value *value,
+				  bool *should_update_apps)
 {
 	enum lttng_error_code ret_code = LTTNG_OK;
-	bool should_update_apps = false;
 	struct ust_id_tracker *id_tracker = get_id_tracker(session, process_attr);
 	struct process_attr_tracker *tracker;
 	int integral_value;
@@ -1169,17 +1198,112 @@ trace_ust_process_attr_tracker_inclusion_set_remove_value(struct ltt_ust_session
 	case LTTNG_PROCESS_ATTR_VIRTUAL_PROCESS_ID:
 		app = ust_app_find_by_pid(integral_value);
 		if (app) {
-			should_update_apps = true;
+			*should_update_apps = true;
 		}
 		break;
 	default:
-		should_update_apps = true;
+		*should_update_apps = true;
 		break;
 	}
+end:
+	return ret_code;
+}
+
+/* Called with the session lock held. */
+enum lttng_error_code
+trace_ust_process_attr_tracker_inclusion_set_add_value(struct ltt_ust_session *session,
+						       enum lttng_process_attr process_attr,
+						       const struct process_attr_value *value)
+{
+	bool should_update_apps = false;
+	const enum lttng_error_code ret_code =
+		add_process_attr_tracker_value(session, process_attr, value, &should_update_apps);
+
 	if (should_update_apps && session->active) {
 		ust_app_global_update_all(session);
 	}
-end:
+
+	return ret_code;
+}
+
+/* Called with the session lock held. */
+enum lttng_error_code
+trace_ust_process_attr_tracker_inclusion_set_remove_value(struct ltt_ust_session *session,
+							  enum lttng_process_attr process_attr,
+							  const struct process_attr_value *value)
+{
+	bool should_update_apps = false;
+	const enum lttng_error_code ret_code = remove_process_attr_tracker_value(
+		session, process_attr, value, &should_update_apps);
+
+	if (should_update_apps && session->active) {
+		ust_app_global_update_all(session);
+	}
+
+	return ret_code;
+}
+
+/*
+ * Add a set of values to a tracker of the session, stopping at the first value
+ * that can't be added. The applications are updated once, after all the values
+ * are added.
+ *
+ * Called with the session lock held.
+ */
+enum lttng_error_code
+trace_ust_process_attr_tracker_inclusion_set_add_values(
+	struct ltt_ust_session *session,
+	enum lttng_process_attr process_attr,
+	const struct lttng_process_attr_values *values)
+{
+	enum lttng_error_code ret_code = LTTNG_OK;
+	bool should_update_apps = false;
+	const unsigned int count = _lttng_process_attr_values_get_count(values);
+
+	for (unsigned int i = 0; i < count && ret_code == LTTNG_OK; i++) {
+		ret_code = add_process_attr_tracker_value(
+			session,
+			process_attr,
+			lttng_process_attr_tracker_values_get_at_index(values, i),
+			&should_update_apps);
+	}
+
+	if (should_update_apps && session->active) {
+		ust_app_global_update_all(session);
+	}
+
+	return ret_code;
+}
+
+/*
+ * Remove a set of values from a tracker of the session, stopping at the first
+ * value that can't be removed. The applications are updated once, after all the
+ * values are removed.
+ *
+ * Called with the session lock held.
+ */
+enum lttng_error_code
+trace_ust_process_attr_tracker_inclusion_set_remove_values(
+	struct ltt_ust_session *session,
+	enum lttng_process_attr process_attr,
+	const struct lttng_process_attr_values *values)
+{
+	enum lttng_error_code ret_code = LTTNG_OK;
+	bool should_update_apps = false;
+	const unsigned int count = _lttng_process_attr_values_get_count(values);
+
+	for (unsigned int i = 0; i < count && ret_code == LTTNG_OK; i++) {
+		ret_code = remove_process_attr_tracker_value(
+			session,
+			process_attr,
+			lttng_process_attr_tracker_values_get_at_index(values, i),
+			&should_update_apps);
+	}
+
+	if (should_update_apps && session->active) {
+		ust_app_global_update_all(session);
+	}
+
 	return ret_code;
 }
 
@@ -1234,7 +1358,7 @@ void trace_ust_destroy_event(struct ltt_ust_event *event)
 
 	DBG2("Trace destroy UST event %s", event->attr.name);
 	free(event->filter_expression);
-	free(event->filter);
+	filter_bytecode_put(event->filter);
 	free(event->exclusion);
 	free(event);
 }
@@ -1339,6 +1463,94 @@ void trace_ust_delete_channel(struct lttng_ht *ht, struct ltt_ust_channel *chann
 	LTTNG_ASSERT(!ret);
 }
 
+static void setup_plan_channel_fini(void *element)
+{
+	auto *channel = (ltt_ust_setup_plan_channel *) element;
+
+	lttng_dynamic_pointer_array_reset(&channel->events);
+}
+
+static void destroy_setup_plan(struct ltt_ust_setup_plan *plan)
+{
+	if (!plan) {
+		return;
+	}
+
+	lttng_dynamic_array_reset(&plan->channels);
+	free(plan);
+}
+
+static struct ltt_ust_setup_plan *create_setup_plan(struct ltt_ust_session *usess)
+{
+	struct ltt_ust_setup_plan *plan;
+	struct lttng_ht_iter chan_iter;
+	struct ltt_ust_channel *uchan;
+
+	plan = zmalloc<ltt_ust_setup_plan>();
+	if (!plan) {
+		PERROR("Failed to allocate UST session setup plan");
+		return nullptr;
+	}
+
+	lttng_dynamic_array_init(
+		&plan->channels, sizeof(ltt_ust_setup_plan_channel), setup_plan_channel_fini);
+
+	lttng::urcu::read_lock_guard read_lock;
+
+	cds_lfht_for_each_entry (
+		usess->domain_global.channels->ht, &chan_iter.iter, uchan, node.node) {
+		struct ltt_ust_setup_plan_channel channel;
+		struct lttng_ht_iter event_iter;
+		struct ltt_ust_event *uevent;
+
+		channel.uchan = uchan;
+		lttng_dynamic_pointer_array_init(&channel.events, nullptr);
+
+		cds_lfht_for_each_entry (uchan->events->ht, &event_iter.iter, uevent, node.node) {
+			if (lttng_dynamic_pointer_array_add_pointer(&channel.events, uevent)) {
+				goto error_channel;
+			}
+		}
+
+		/* The plan owns the events array from then on. */
+		if (lttng_dynamic_array_add_element(&plan->channels, &channel)) {
+			goto error_channel;
+		}
+
+		continue;
+
+	error_channel:
+		lttng_dynamic_pointer_array_reset(&channel.events);
+		ERR("Failed to build the setup plan of UST session %" PRIu64, usess->id);
+		destroy_setup_plan(plan);
+		return nullptr;
+	}
+
+	DBG2("Built setup plan of UST session %" PRIu64 ": %zu channels",
+	     usess->id,
+	     lttng_dynamic_array_get_count(&plan->channels));
+	return plan;
+}
+
+const struct ltt_ust_setup_plan *trace_ust_get_setup_plan(struct ltt_ust_session *usess)
+{
+	LTTNG_ASSERT(usess);
+
+	if (!usess->setup_plan) {
+		usess->setup_plan = create_setup_plan(usess);
+	}
+
+	return usess->setup_plan;
+}
+
+void trace_ust_invalidate_setup_plan(struct ltt_ust_session *usess)
+{
+	LTTNG_ASSERT(usess);
+
+	destroy_setup_plan(usess->setup_plan);
+	usess->setup_plan = nullptr;
+}
+
 int trace_ust_regenerate_metadata(struct ltt_ust_session *usess)
 {
 	int ret = 0;
@@ -1414,6 +1626,9 @@ void trace_ust_destroy_session(struct ltt_ust_session *session)
 
 	DBG2("Trace UST destroy session %" PRIu64, session->id);
 
+	/* The plan refers to the channels and events of the domain. */
+	trace_ust_invalidate_setup_plan(session);
+
 	/* Cleaning up UST domain */
 	destroy_domain_global(&session->domain_global);
 
@@ -1451,5 +1666,6 @@ void trace_ust_destroy_session(struct ltt_ust_session *session)
 void trace_ust_free_session(struct ltt_ust_session *session)
 {
 	consumer_output_put(session->consumer);
+	pthread_mutex_destroy(&session->buffer_reg_uid_list_lock);
 	free(session);
 }
@@ -13,12 +13,14 @@
 #include "lttng-ust-ctl.hpp"
 
 #include <common/defaults.hpp>
+#include <common/dynamic-array.hpp>
 #include <common/hashtable/hashtable.hpp>
 #include <common/tracker.hpp>
 
 #include <lttng/lttng.h>
 
 #include <limits.h>
+#include <pthread.h>
 #include <urcu/list.h>
 
 struct agent;
@@ -75,6 +77,11 @@ struct ltt_ust_channel {
 	uint64_t per_pid_closed_app_discarded;
 	uint64_t per_pid_closed_app_lost;
 	uint64_t monitor_timer_interval;
+	enum lttng_channel_writeback_policy writeback_policy;
+	uint64_t writeback_window_size;
+	uint32_t drain_max_subbuffers;
+	uint64_t drain_max_bytes;
+	enum lttng_channel_buffer_page_size buffer_page_size;
 };
 
 /* UST domain global (LTTNG_DOMAIN_UST) */
@@ -92,9 +99,32 @@ struct ust_id_tracker {
 };
 
 /* UST session */
+/*
+ * Channels and events of a UST session to set up in the newly registered
+ * applications, flattened from the hash tables of the session so that each
+ * registration replays them rather than walking the tables.
+ *
+ * The plan is built on first use and dropped whenever a channel or an event
+ * is added to or removed from the session. Enabling or disabling them
+ * doesn't change the plan: their state is read as the plan is replayed. The
+ * plan is protected by the session lock.
+ */
+struct ltt_ust_setup_plan_channel {
+	struct ltt_ust_channel *uchan;
+	/* struct ltt_ust_event of the channel. */
+	struct lttng_dynamic_pointer_array events;
+};
+
+struct ltt_ust_setup_plan {
+	/* struct ltt_ust_setup_plan_channel, metadata channel excluded. */
+	struct lttng_dynamic_array channels;
+};
+
 struct ltt_ust_session {
 	uint64_t id; /* Unique identifier of session */
 	struct ltt_ust_domain_global domain_global;
+	/* Null until first used or once invalidated. */
+	struct ltt_ust_setup_plan *setup_plan;
 	/* Hash table of agent indexed by agent domain. */
 	struct lttng_ht *agents;
 	/* UID/GID of the user owning the session */
@@ -111,6 +141,11 @@ struct ltt_ust_session {
 	int buffer_type_changed;
 	/* For per UID buffer, every buffer reg object is kept of this session */
 	struct cds_list_head buffer_reg_uid_list;
+	/*
+	 * Serializes the creation of the per UID buffer registries, which the
+	 * threads updating the applications of the session do concurrently.
+	 */
+	pthread_mutex_t buffer_reg_uid_list_lock;
 	/* Next channel ID available for a newly registered channel. */
 	uint64_t next_event_container_id;
 	/* Once this value reaches UINT64_MAX, no more id can be allocated. */
@@ -209,6 +244,20 @@ int trace_ust_match_context(const struct ltt_ust_context *uctx,
 			    const struct lttng_event_context *ctx);
 void trace_ust_delete_channel(struct lttng_ht *ht, struct ltt_ust_channel *channel);
 
+/*
+ * Get the setup plan of a session, building it if needed. Called with the
+ * session lock held.
+ *
+ * Return the plan, owned by the session, or null on allocation error.
+ */
+const struct ltt_ust_setup_plan *trace_ust_get_setup_plan(struct ltt_ust_session *usess);
+
+/*
+ * Drop the setup plan of a session after a channel or an event is added or
+ * removed. Called with the session lock held.
+ */
+void trace_ust_invalidate_setup_plan(struct ltt_ust_session *usess);
+
 int trace_ust_regenerate_metadata(struct ltt_ust_session *usess);
 
 /*
@@ -236,6 +285,16 @@ enum lttng_error_code
 trace_ust_process_attr_tracker_inclusion_set_remove_value(struct ltt_ust_session *session,
 							  enum lttng_process_attr process_attr,
 							  const struct process_attr_value *value);
+enum lttng_error_code
+trace_ust_process_attr_tracker_inclusion_set_add_values(
+	struct ltt_ust_session *session,
+	enum lttng_process_attr process_attr,
+	const struct lttng_process_attr_values *values);
+enum lttng_error_code
+trace_ust_process_attr_tracker_inclusion_set_remove_values(
+	struct ltt_ust_session *session,
+	enum lttng_process_attr process_attr,
+	const struct lttng_process_attr_values *values);
 const struct process_attr_tracker *
 trace_ust_get_process_attr_tracker(struct ltt_ust_session *session,
 				   enum lttng_process_attr process_attr);
@@ -337,6 +396,12 @@ static inline void trace_ust_delete_channel(struct lttng_ht *ht __attribute__((u
 	return;
 }
 
+static inline void trace_ust_invalidate_setup_plan(struct ltt_ust_session *usess
+						   __attribute__((unused)))
+{
+	return;
+}
+
 static inline int trace_ust_regenerate_metadata(struct ltt_ust_session *usess
 						__attribute__((unused)))
 {
@@ -384,6 +449,22 @@ static inline enum lttng_error_code trace_ust_process_attr_tracker_inclusion_set
 	return LTTNG_OK;
 }
 
+static inline enum lttng_error_code trace_ust_process_attr_tracker_inclusion_set_add_values(
+	struct ltt_ust_session *session __attribute__((unused)),
+	enum lttng_process_attr process_attr __attribute__((unused)),
+	const struct lttng_process_attr_values *values __attribute__((unused)))
+{
+	return LTTNG_OK;
+}
+
+static inline enum lttng_error_code trace_ust_process_attr_tracker_inclusion_set_remove_values(
+	struct ltt_ust_session *session __attribute__((unused)),
+	enum lttng_process_attr process_attr __attribute__((unused)),
+	const struct lttng_process_attr_values *values __attribute__((unused)))
+{
+	return LTTNG_OK;
+}
+
 static inline const struct process_attr_tracker *
 trace_ust_get_process_attr_tracker(struct ltt_ust_session *session __attribute__((unused)),
 				   enum lttng_process_attr process_attr __attribute__((unused)))
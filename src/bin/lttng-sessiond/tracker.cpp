@@ -22,7 +22,11 @@
 #include <lttng/lttng-error.h>
 
 #include <grp.h>
+#include <iterator>
+#include <map>
+#include <new>
 #include <pwd.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <urcu.h>
@@ -30,8 +34,20 @@
 #include <urcu/rculfhash.h>
 
 struct process_attr_tracker {
-	enum lttng_tracking_policy policy;
-	struct cds_lfht *inclusion_set_ht;
+	enum lttng_tracking_policy policy = LTTNG_TRACKING_POLICY_INCLUDE_ALL;
+	/* User and group names of the inclusion set. */
+	struct cds_lfht *inclusion_set_ht = nullptr;
+	/*
+	 * Integral values (PIDs, UIDs or GIDs) of the inclusion set, kept as
+	 * disjoint and non-adjacent ranges mapping their first value to their
+	 * last value. Large sets of contiguous values, such as the IDs mapped
+	 * to a container, only cost a node per range.
+	 *
+	 * A tracker only ever holds integral values of a single type since the
+	 * value types are validated against the process attribute.
+	 */
+	std::map<int64_t, int64_t> inclusion_set_ranges;
+	enum lttng_process_attr_value_type integral_value_type = LTTNG_PROCESS_ATTR_VALUE_TYPE_PID;
 };
 
 namespace {
@@ -50,17 +66,69 @@ static void process_attr_tracker_value_node_rcu_free(struct rcu_head *rcu_head)
 	free(node);
 }
 
+static bool process_attr_value_is_integral(const struct process_attr_value *value)
+{
+	switch (value->type) {
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_PID:
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_UID:
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_GID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int64_t process_attr_value_get_integral(const struct process_attr_value *value)
+{
+	switch (value->type) {
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_PID:
+		return (int64_t) value->value.pid;
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_UID:
+		return (int64_t) value->value.uid;
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_GID:
+		return (int64_t) value->value.gid;
+	default:
+		abort();
+	}
+}
+
+static struct process_attr_value *
+process_attr_value_create_integral(enum lttng_process_attr_value_type type, int64_t integral)
+{
+	struct process_attr_value *value = zmalloc<process_attr_value>();
+
+	if (!value) {
+		return nullptr;
+	}
+
+	value->type = type;
+	switch (type) {
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_PID:
+		value->value.pid = (pid_t) integral;
+		break;
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_UID:
+		value->value.uid = (uid_t) integral;
+		break;
+	case LTTNG_PROCESS_ATTR_VALUE_TYPE_GID:
+		value->value.gid = (gid_t) integral;
+		break;
+	default:
+		abort();
+	}
+
+	return value;
+}
+
 struct process_attr_tracker *process_attr_tracker_create()
 {
 	struct process_attr_tracker *tracker;
 
-	tracker = zmalloc<process_attr_tracker>();
-	if (!tracker) {
+	try {
+		tracker = new process_attr_tracker;
+	} catch (const std::bad_alloc&) {
 		return nullptr;
 	}
 
-	(void) process_attr_tracker_set_tracking_policy(tracker, LTTNG_TRACKING_POLICY_INCLUDE_ALL);
-
 	tracker->inclusion_set_ht = cds_lfht_new(
 		DEFAULT_HT_SIZE, 1, 0, CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING, nullptr);
 	if (!tracker->inclusion_set_ht) {
@@ -88,6 +156,8 @@ static void process_attr_tracker_clear_inclusion_set(struct process_attr_tracker
 	struct lttng_ht_iter iter;
 	struct process_attr_tracker_value_node *value_node;
 
+	tracker->inclusion_set_ranges.clear();
+
 	if (!tracker->inclusion_set_ht) {
 		return;
 	}
@@ -121,7 +191,7 @@ void process_attr_tracker_destroy(struct process_attr_tracker *tracker)
 	}
 
 	process_attr_tracker_clear_inclusion_set(tracker);
-	free(tracker);
+	delete tracker;
 }
 
 enum lttng_tracking_policy
@@ -180,6 +250,106 @@ process_attr_tracker_lookup(const struct process_attr_tracker *tracker,
 		      nullptr;
 }
 
+/*
+ * Returns the range of the inclusion set containing `integral`, or the end of
+ * the ranges if it is not part of the inclusion set.
+ */
+static std::map<int64_t, int64_t>::iterator
+process_attr_tracker_lookup_range(struct process_attr_tracker *tracker, int64_t integral)
+{
+	auto& ranges = tracker->inclusion_set_ranges;
+	auto it = ranges.upper_bound(integral);
+
+	if (it == ranges.begin()) {
+		return ranges.end();
+	}
+
+	--it;
+	return it->second >= integral ? it : ranges.end();
+}
+
+static enum process_attr_tracker_status
+process_attr_tracker_add_integral_value(struct process_attr_tracker *tracker,
+					const struct process_attr_value *value)
+{
+	auto& ranges = tracker->inclusion_set_ranges;
+	const int64_t integral = process_attr_value_get_integral(value);
+
+	LTTNG_ASSERT(ranges.empty() || tracker->integral_value_type == value->type);
+
+	if (process_attr_tracker_lookup_range(tracker, integral) != ranges.end()) {
+		return PROCESS_ATTR_TRACKER_STATUS_EXISTS;
+	}
+
+	tracker->integral_value_type = value->type;
+
+	/* Merge the value with the ranges it is adjacent to, if any. */
+	auto next = ranges.upper_bound(integral);
+	const bool merge_next = next != ranges.end() && next->first - 1 == integral;
+
+	if (next != ranges.begin()) {
+		auto previous = std::prev(next);
+
+		if (previous->second + 1 == integral) {
+			if (merge_next) {
+				previous->second = next->second;
+				ranges.erase(next);
+			} else {
+				previous->second = integral;
+			}
+
+			return PROCESS_ATTR_TRACKER_STATUS_OK;
+		}
+	}
+
+	try {
+		if (merge_next) {
+			const int64_t last = next->second;
+
+			ranges.erase(next);
+			ranges.emplace(integral, last);
+		} else {
+			ranges.emplace(integral, integral);
+		}
+	} catch (const std::bad_alloc&) {
+		return PROCESS_ATTR_TRACKER_STATUS_ERROR;
+	}
+
+	return PROCESS_ATTR_TRACKER_STATUS_OK;
+}
+
+static enum process_attr_tracker_status
+process_attr_tracker_remove_integral_value(struct process_attr_tracker *tracker,
+					   const struct process_attr_value *value)
+{
+	auto& ranges = tracker->inclusion_set_ranges;
+	const int64_t integral = process_attr_value_get_integral(value);
+	const auto range = process_attr_tracker_lookup_range(tracker, integral);
+
+	if (range == ranges.end()) {
+		return PROCESS_ATTR_TRACKER_STATUS_MISSING;
+	}
+
+	const int64_t first = range->first, last = range->second;
+
+	if (integral != last) {
+		/* Split the range, keeping the values following the removed value. */
+		try {
+			ranges.emplace_hint(std::next(range), integral + 1, last);
+		} catch (const std::bad_alloc&) {
+			return PROCESS_ATTR_TRACKER_STATUS_ERROR;
+		}
+	}
+
+	if (integral == first) {
+		ranges.erase(range);
+	} else {
+		range->second = integral - 1;
+	}
+
+	return PROCESS_ATTR_TRACKER_STATUS_OK;
+}
+
 /* Protected by session mutex held by caller. */
 enum process_attr_tracker_status
 process_attr_tracker_inclusion_set_add_value(struct process_attr_tracker *tracker,
@@ -195,6 +365,11 @@ process_attr_tracker_inclusion_set_add_value(struct process_attr_tracker *tracke
 		goto end;
 	}
 
+	if (process_attr_value_is_integral(value)) {
+		status = process_attr_tracker_add_integral_value(tracker, value);
+		goto end;
+	}
+
 	if (process_attr_tracker_lookup(tracker, value)) {
 		status = PROCESS_ATTR_TRACKER_STATUS_EXISTS;
 		goto end;
@@ -242,6 +417,11 @@ process_attr_tracker_inclusion_set_remove_value(struct process_attr_tracker *tra
 		goto end;
 	}
 
+	if (process_attr_value_is_integral(value)) {
+		status = process_attr_tracker_remove_integral_value(tracker, value);
+		goto end;
+	}
+
 	value_node = process_attr_tracker_lookup(tracker, value);
 	if (!value_node) {
 		status = PROCESS_ATTR_TRACKER_STATUS_MISSING;
@@ -274,6 +454,30 @@ process_attr_tracker_get_inclusion_set(const struct process_attr_tracker *tracke
 		goto error;
 	}
 
+	for (const auto& range : tracker->inclusion_set_ranges) {
+		for (int64_t integral = range.first;; integral++) {
+			int ret;
+
+			new_value = process_attr_value_create_integral(
+				tracker->integral_value_type, integral);
+			if (!new_value) {
+				status = PROCESS_ATTR_TRACKER_STATUS_ERROR;
+				goto error;
+			}
+
+			ret = lttng_dynamic_pointer_array_add_pointer(&values->array, new_value);
+			if (ret) {
+				status = PROCESS_ATTR_TRACKER_STATUS_ERROR;
+				goto error;
+			}
+
+			new_value = nullptr;
+			if (integral == range.second) {
+				break;
+			}
+		}
+	}
+
 	{
 		lttng::urcu::read_lock_guard read_lock;
 
@@ -26,7 +26,6 @@ lttng_trigger_condition_add_error_results(const struct lttng_trigger *trigger,
 	enum lttng_trigger_status status;
 	uint64_t discarded_tracer_messages_count;
 	enum event_notifier_error_accounting_status error_accounting_status;
-	struct lttng_error_query_result *discarded_tracer_messages_counter = nullptr;
 	const char *trigger_name;
 	uid_t trigger_owner;
 
@@ -42,8 +41,7 @@ lttng_trigger_condition_add_error_results(const struct lttng_trigger *trigger,
 	 * condition type.
 	 */
 	if (!lttng_trigger_needs_tracer_notifier(trigger)) {
-		status = LTTNG_TRIGGER_STATUS_OK;
-		goto end;
+		return LTTNG_TRIGGER_STATUS_OK;
 	}
 
 	error_accounting_status = event_notifier_error_accounting_get_count(
@@ -52,7 +50,23 @@ lttng_trigger_condition_add_error_results(const struct lttng_trigger *trigger,
 		ERR("Failed to retrieve tracer discarded messages count for trigger: trigger name = '%s', trigger owner uid = %d",
 		    trigger_name,
 		    (int) trigger_owner);
-		status = LTTNG_TRIGGER_STATUS_ERROR;
+		return LTTNG_TRIGGER_STATUS_ERROR;
+	}
+
+	return lttng_trigger_condition_add_error_results_with_count(
+		trigger, discarded_tracer_messages_count, results);
+}
+
+enum lttng_trigger_status
+lttng_trigger_condition_add_error_results_with_count(const struct lttng_trigger *trigger,
+						     uint64_t discarded_tracer_messages_count,
+						     struct lttng_error_query_results *results)
+{
+	enum lttng_trigger_status status;
+	struct lttng_error_query_result *discarded_tracer_messages_counter = nullptr;
+
+	if (!lttng_trigger_needs_tracer_notifier(trigger)) {
+		status = LTTNG_TRIGGER_STATUS_OK;
 		goto end;
 	}
 
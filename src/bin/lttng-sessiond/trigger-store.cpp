@@ -0,0 +1,471 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "cmd.hpp"
+#include "lttng-sessiond.hpp"
+#include "trigger-store.hpp"
+
+#include <common/common.hpp>
+#include <common/defaults.hpp>
+#include <common/dynamic-buffer.hpp>
+#include <common/payload-view.hpp>
+#include <common/payload.hpp>
+#include <common/readwrite.hpp>
+#include <common/utils.hpp>
+
+#include <lttng/trigger/trigger-internal.hpp>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define TRIGGER_STORE_MAGIC   "LTTNGTRG"
+#define TRIGGER_STORE_VERSION 1
+
+namespace {
+struct trigger_store_header {
+	char magic[sizeof(TRIGGER_STORE_MAGIC) - 1];
+	uint32_t version;
+} LTTNG_PACKED;
+
+enum trigger_store_record_type {
+	TRIGGER_STORE_RECORD_REGISTER = 0,
+	TRIGGER_STORE_RECORD_UNREGISTER = 1,
+};
+
+/* Followed by `size` bytes of serialized trigger. */
+struct trigger_store_record {
+	/* enum trigger_store_record_type */
+	uint8_t type;
+	uint32_t size;
+} LTTNG_PACKED;
+
+/* Protects `store_fd`. */
+pthread_mutex_t store_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Journal opened in append mode, -1 when the store is disabled. */
+int store_fd = -1;
+char store_path[PATH_MAX];
+
+/* The named triggers are identified by their owner and name. */
+bool triggers_match(const struct lttng_trigger *a, const struct lttng_trigger *b)
+{
+	const char *name_a, *name_b;
+	uid_t owner_a, owner_b;
+
+	if (lttng_trigger_get_name(a, &name_a) != LTTNG_TRIGGER_STATUS_OK ||
+	    lttng_trigger_get_name(b, &name_b) != LTTNG_TRIGGER_STATUS_OK) {
+		return lttng_trigger_is_equal(a, b);
+	}
+
+	(void) lttng_trigger_get_owner_uid(a, &owner_a);
+	(void) lttng_trigger_get_owner_uid(b, &owner_b);
+	return owner_a == owner_b && !strcmp(name_a, name_b);
+}
+
+/* Return 0 on success, -1 if the trigger can't be serialized or has file descriptors. */
+int serialize_record(struct lttng_payload *payload,
+		     enum trigger_store_record_type type,
+		     const struct lttng_trigger *trigger)
+{
+	struct trigger_store_record record = {};
+	const size_t record_offset = payload->buffer.size;
+
+	if (lttng_dynamic_buffer_append(&payload->buffer, &record, sizeof(record)) ||
+	    lttng_trigger_serialize(trigger, payload)) {
+		return -1;
+	}
+
+	{
+		const struct lttng_payload_view view =
+			lttng_payload_view_from_payload(payload, 0, -1);
+
+		if (lttng_payload_view_get_fd_handle_count(&view) != 0) {
+			return -1;
+		}
+	}
+
+	record.type = (uint8_t) type;
+	record.size = payload->buffer.size - record_offset - sizeof(record);
+	memcpy(payload->buffer.data + record_offset, &record, sizeof(record));
+	return 0;
+}
+
+void record_trigger(enum trigger_store_record_type type, const struct lttng_trigger *trigger)
+{
+	struct lttng_payload payload;
+	ssize_t ret;
+
+	lttng_payload_init(&payload);
+
+	pthread_mutex_lock(&store_lock);
+	if (store_fd < 0) {
+		goto end;
+	}
+
+	if (serialize_record(&payload, type, trigger)) {
+		WARN("Failed to serialize trigger, not recording it in the trigger store");
+		goto end;
+	}
+
+	ret = lttng_write(store_fd, payload.buffer.data, payload.buffer.size);
+	if (ret != payload.buffer.size) {
+		/* A partially written record is dropped when the store is loaded. */
+		PERROR("Failed to write trigger store, no longer recording triggers: path = `%s`",
+		       store_path);
+		if (close(store_fd)) {
+			PERROR("Failed to close trigger store");
+		}
+
+		store_fd = -1;
+	}
+
+end:
+	pthread_mutex_unlock(&store_lock);
+	lttng_payload_reset(&payload);
+}
+
+/* Read the whole store, an absent store being empty. */
+int read_store(struct lttng_dynamic_buffer *contents)
+{
+	int ret = -1, fd;
+	struct stat store_stat;
+
+	fd = open(store_path, O_RDONLY);
+	if (fd < 0) {
+		if (errno == ENOENT) {
+			return 0;
+		}
+
+		PERROR("Failed to open trigger store: path = `%s`", store_path);
+		return -1;
+	}
+
+	if (fstat(fd, &store_stat)) {
+		PERROR("Failed to get size of trigger store: path = `%s`", store_path);
+		goto end;
+	}
+
+	if (lttng_dynamic_buffer_set_size(contents, store_stat.st_size)) {
+		ERR("Failed to allocate trigger store contents: size = %jd",
+		    (intmax_t) store_stat.st_size);
+		goto end;
+	}
+
+	if (lttng_read(fd, contents->data, contents->size) != contents->size) {
+		PERROR("Failed to read trigger store: path = `%s`", store_path);
+		goto end;
+	}
+
+	ret = 0;
+end:
+	if (close(fd)) {
+		PERROR("Failed to close trigger store");
+	}
+
+	return ret;
+}
+
+/*
+ * Replay the records of the store into the set of the triggers which are
+ * still registered, in their order of registration.
+ */
+int replay_store(const struct lttng_dynamic_buffer *contents,
+		 std::vector<struct lttng_trigger *>& triggers)
+{
+	struct trigger_store_header header;
+	size_t offset = sizeof(header);
+
+	if (contents->size == 0) {
+		return 0;
+	}
+
+	if (contents->size < sizeof(header)) {
+		ERR("Invalid trigger store header: path = `%s`", store_path);
+		return -1;
+	}
+
+	memcpy(&header, contents->data, sizeof(header));
+	if (memcmp(header.magic, TRIGGER_STORE_MAGIC, sizeof(header.magic)) != 0 ||
+	    header.version != TRIGGER_STORE_VERSION) {
+		ERR("Invalid trigger store header: path = `%s`", store_path);
+		return -1;
+	}
+
+	while (offset < contents->size) {
+		struct trigger_store_record record;
+		struct lttng_trigger *trigger;
+
+		if (contents->size - offset < sizeof(record)) {
+			break;
+		}
+
+		memcpy(&record, contents->data + offset, sizeof(record));
+		offset += sizeof(record);
+		if (record.size > contents->size - offset) {
+			break;
+		}
+
+		{
+			struct lttng_payload_view view = lttng_payload_view_from_dynamic_buffer(
+				contents, offset, record.size);
+
+			if (lttng_trigger_create_from_payload(&view, &trigger) !=
+			    (ssize_t) record.size) {
+				ERR("Invalid trigger in trigger store: path = `%s`, offset = %zu",
+				    store_path,
+				    offset);
+				return -1;
+			}
+		}
+
+		offset += record.size;
+
+		switch (record.type) {
+		case TRIGGER_STORE_RECORD_REGISTER:
+			triggers.push_back(trigger);
+			break;
+		case TRIGGER_STORE_RECORD_UNREGISTER:
+		{
+			auto it = triggers.begin();
+
+			for (; it != triggers.end(); ++it) {
+				if (triggers_match(*it, trigger)) {
+					break;
+				}
+			}
+
+			if (it != triggers.end()) {
+				lttng_trigger_put(*it);
+				triggers.erase(it);
+			}
+
+			lttng_trigger_put(trigger);
+			break;
+		}
+		default:
+			ERR("Invalid trigger store record type: path = `%s`, type = %d",
+			    store_path,
+			    (int) record.type);
+			lttng_trigger_put(trigger);
+			return -1;
+		}
+	}
+
+	if (offset != contents->size) {
+		WARN("Ignoring truncated record at the end of the trigger store: path = `%s`",
+		     store_path);
+	}
+
+	return 0;
+}
+
+/* Register a trigger of the store, returning the registered trigger or null. */
+struct lttng_trigger *register_stored_trigger(struct lttng_trigger *trigger)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_trigger *registered_trigger = nullptr;
+	const char *trigger_name;
+	uid_t trigger_owner;
+	/* The session daemon's credentials allow the registration for any owner. */
+	const struct lttng_credentials creds = {
+		.uid = LTTNG_OPTIONAL_INIT_VALUE(geteuid()),
+		.gid = LTTNG_OPTIONAL_INIT_VALUE(getegid()),
+	};
+	const bool is_anonymous = lttng_trigger_get_name(trigger, &trigger_name) !=
+		LTTNG_TRIGGER_STATUS_OK;
+
+	ret_code = cmd_register_trigger(
+		&creds, trigger, is_anonymous, the_notification_thread_handle, &registered_trigger);
+	if (ret_code != LTTNG_OK) {
+		(void) lttng_trigger_get_owner_uid(trigger, &trigger_owner);
+		WARN("Failed to register stored trigger, dropping it from the trigger store: trigger name = '%s', trigger owner uid = %d, error: '%s'",
+		     is_anonymous ? "(anonymous)" : trigger_name,
+		     (int) trigger_owner,
+		     lttng_strerror(-ret_code));
+		return nullptr;
+	}
+
+	return registered_trigger;
+}
+
+/*
+ * Replace the store by a journal of the registration of `triggers` and
+ * open it in append mode.
+ */
+int rewrite_store(const std::vector<struct lttng_trigger *>& triggers)
+{
+	int ret = -1, fd = -1;
+	char tmp_path[PATH_MAX];
+	struct lttng_payload payload;
+	struct trigger_store_header header;
+
+	lttng_payload_init(&payload);
+
+	memcpy(header.magic, TRIGGER_STORE_MAGIC, sizeof(header.magic));
+	header.version = TRIGGER_STORE_VERSION;
+	if (lttng_dynamic_buffer_append(&payload.buffer, &header, sizeof(header))) {
+		goto end;
+	}
+
+	for (const auto trigger : triggers) {
+		if (serialize_record(&payload, TRIGGER_STORE_RECORD_REGISTER, trigger)) {
+			ERR("Failed to serialize stored trigger");
+			goto end;
+		}
+	}
+
+	ret = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", store_path);
+	if (ret < 0 || ret >= sizeof(tmp_path)) {
+		ERR("Failed to format temporary trigger store path");
+		ret = -1;
+		goto end;
+	}
+
+	ret = -1;
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		PERROR("Failed to create trigger store: path = `%s`", tmp_path);
+		goto end;
+	}
+
+	if (lttng_write(fd, payload.buffer.data, payload.buffer.size) != payload.buffer.size ||
+	    fsync(fd)) {
+		PERROR("Failed to write trigger store: path = `%s`", tmp_path);
+		goto end;
+	}
+
+	if (rename(tmp_path, store_path)) {
+		PERROR("Failed to replace trigger store: path = `%s`", store_path);
+		goto end;
+	}
+
+	/* The renamed store remains open for writing. */
+	if (fcntl(fd, F_SETFL, O_APPEND)) {
+		PERROR("Failed to open trigger store in append mode: path = `%s`", store_path);
+		goto end;
+	}
+
+	store_fd = fd;
+	fd = -1;
+	ret = 0;
+end:
+	if (fd >= 0 && close(fd)) {
+		PERROR("Failed to close trigger store");
+	}
+
+	lttng_payload_reset(&payload);
+	return ret;
+}
+} /* namespace */
+
+int trigger_store_init()
+{
+	int ret = -1;
+	const char *home_dir;
+	char store_dir[PATH_MAX];
+	struct lttng_dynamic_buffer contents;
+	std::vector<struct lttng_trigger *> stored_triggers, registered_triggers;
+
+	if (!the_config.persistent_triggers) {
+		return 0;
+	}
+
+	lttng_dynamic_buffer_init(&contents);
+
+	home_dir = utils_get_home_dir();
+	if (!home_dir) {
+		ERR("Failed to get home directory of the trigger store");
+		goto end;
+	}
+
+	ret = snprintf(store_dir, sizeof(store_dir), DEFAULT_SESSION_HOME_CONFIGPATH, home_dir);
+	if (ret < 0 || ret >= sizeof(store_dir)) {
+		ERR("Failed to format trigger store directory path");
+		ret = -1;
+		goto end;
+	}
+
+	ret = snprintf(store_path,
+		       sizeof(store_path),
+		       "%s/" DEFAULT_TRIGGER_STORE_FILE,
+		       store_dir);
+	if (ret < 0 || ret >= sizeof(store_path)) {
+		ERR("Failed to format trigger store path");
+		ret = -1;
+		goto end;
+	}
+
+	ret = utils_mkdir_recursive(store_dir, S_IRWXU | S_IRWXG, -1, -1);
+	if (ret) {
+		ERR("Failed to create trigger store directory: path = `%s`", store_dir);
+		goto end;
+	}
+
+	ret = read_store(&contents);
+	if (ret) {
+		goto end;
+	}
+
+	ret = replay_store(&contents, stored_triggers);
+	if (ret) {
+		goto end;
+	}
+
+	DBG("Registering %zu stored triggers: path = `%s`", stored_triggers.size(), store_path);
+
+	/*
+	 * No application is registered yet: registering the triggers doesn't
+	 * involve any tracer.
+	 */
+	for (const auto trigger : stored_triggers) {
+		struct lttng_trigger *registered_trigger = register_stored_trigger(trigger);
+
+		if (registered_trigger) {
+			registered_triggers.push_back(registered_trigger);
+		}
+	}
+
+	ret = rewrite_store(registered_triggers);
+end:
+	for (const auto trigger : stored_triggers) {
+		lttng_trigger_put(trigger);
+	}
+
+	for (const auto trigger : registered_triggers) {
+		lttng_trigger_put(trigger);
+	}
+
+	lttng_dynamic_buffer_reset(&contents);
+	return ret;
+}
+
+void trigger_store_fini()
+{
+	pthread_mutex_lock(&store_lock);
+	if (store_fd >= 0 && close(store_fd)) {
+		PERROR("Failed to close trigger store");
+	}
+
+	store_fd = -1;
+	pthread_mutex_unlock(&store_lock);
+}
+
+void trigger_store_add(const struct lttng_trigger *trigger)
+{
+	record_trigger(TRIGGER_STORE_RECORD_REGISTER, trigger);
+}
+
+void trigger_store_remove(const struct lttng_trigger *trigger)
+{
+	record_trigger(TRIGGER_STORE_RECORD_UNREGISTER, trigger);
+}
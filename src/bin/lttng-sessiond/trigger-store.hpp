@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_SESSIOND_TRIGGER_STORE_H
+#define LTTNG_SESSIOND_TRIGGER_STORE_H
+
+struct lttng_trigger;
+
+/*
+ * Store of the triggers registered by the clients, enabled by the
+ * LTTNG_PERSISTENT_TRIGGERS environment variable.
+ *
+ * The store is a journal of the registrations and unregistrations of
+ * triggers, in their serialized form, kept in the session configuration
+ * directory of the session daemon's user. On start, the triggers which are
+ * still registered according to the journal are registered again and the
+ * journal is rewritten to contain only their registration.
+ */
+
+/*
+ * Register the triggers of the store and open it to record the next
+ * registrations. Must be called before the clients and the applications can
+ * connect to the session daemon.
+ *
+ * The triggers which can't be registered again are dropped from the store.
+ *
+ * Return 0 on success, or if the store is disabled, else -1.
+ */
+int trigger_store_init();
+
+void trigger_store_fini();
+
+/* Record the registration of a trigger, if the store is enabled. */
+void trigger_store_add(const struct lttng_trigger *trigger);
+
+/* Record the unregistration of a trigger, if the store is enabled. */
+void trigger_store_remove(const struct lttng_trigger *trigger);
+
+#endif /* LTTNG_SESSIOND_TRIGGER_STORE_H */
@@ -14,6 +14,7 @@
 #include "event.hpp"
 #include "fd-limit.hpp"
 #include "field.hpp"
+#include "filter-bytecode-cache.hpp"
 #include "health-sessiond.hpp"
 #include "lttng-sessiond.hpp"
 #include "lttng-ust-ctl.hpp"
@@ -28,12 +29,17 @@
 #include <common/bytecode/bytecode.hpp>
 #include <common/common.hpp>
 #include <common/compat/errno.hpp>
+#include <common/dynamic-array.hpp>
 #include <common/exception.hpp>
 #include <common/format.hpp>
+#include <common/hashtable/typed-hashtable.hpp>
 #include <common/hashtable/utils.hpp>
 #include <common/make-unique.hpp>
 #include <common/pthread-lock.hpp>
+#include <common/scope-exit.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/slab-allocator.hpp>
+#include <common/time.hpp>
 #include <common/urcu.hpp>
 
 #include <lttng/condition/condition.h>
@@ -44,8 +50,10 @@
 #include <lttng/event-rule/user-tracepoint.h>
 #include <lttng/trigger/trigger-internal.hpp>
 
+#include <algorithm>
 #include <errno.h>
 #include <fcntl.h>
+#include <fnmatch.h>
 #include <inttypes.h>
 #include <pthread.h>
 #include <signal.h>
@@ -53,6 +61,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -67,6 +76,10 @@ struct lttng_ht *ust_app_ht_by_sock;
 struct lttng_ht *ust_app_ht_by_notify_sock;
 
 static int ust_app_flush_app_session(ust_app& app, ust_app_session& ua_sess);
+static void ust_app_global_update_apps(struct ltt_ust_session *usess);
+static bool ust_app_provides_enabled_tracepoint(struct ltt_ust_session *usess,
+						struct ust_app *app,
+						const struct ltt_ust_event *uevent);
 
 /* Next available channel key. Access under next_channel_key_lock. */
 static uint64_t _next_channel_key;
@@ -76,6 +89,10 @@ static pthread_mutex_t next_channel_key_lock = PTHREAD_MUTEX_INITIALIZER;
 static uint64_t _next_session_id;
 static pthread_mutex_t next_session_id_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/* Streams of the channels of the applications, received from the consumers. */
+static lttng::slab_allocator ust_app_stream_allocator("ust_app_stream",
+						      sizeof(struct ust_app_stream));
+
 namespace {
 
 /*
@@ -344,7 +361,7 @@ static void delete_ust_app_event(int sock, struct ust_app_event *ua_event, struc
 	LTTNG_ASSERT(ua_event);
 	ASSERT_RCU_READ_LOCKED();
 
-	free(ua_event->filter);
+	filter_bytecode_put(ua_event->filter);
 	if (ua_event->exclusion != nullptr)
 		free(ua_event->exclusion);
 	if (ua_event->obj != nullptr) {
@@ -474,7 +491,7 @@ static void delete_ust_app_stream(int sock, struct ust_app_stream *stream, struc
 	ASSERT_RCU_READ_LOCKED();
 
 	(void) release_ust_app_stream(sock, stream, app);
-	free(stream);
+	ust_app_free_stream(stream);
 }
 
 static void delete_ust_app_channel_rcu(struct rcu_head *head)
@@ -675,9 +692,38 @@ int ust_app_release_object(struct ust_app *app, struct lttng_ust_abi_object_data
 	return ret;
 }
 
+/*
+ * Return true if the `len` bytes of metadata not sent to the consumer yet can
+ * be held back, to be pushed along with the metadata which follows them.
+ *
+ * Must be called with the registry lock held.
+ */
+static bool metadata_push_can_be_delayed(const lsu::registry_session::locked_ptr& locked_registry,
+					 size_t len)
+{
+	struct timespec now;
+	unsigned long pending_ms;
+
+	if (the_config.ust_metadata_push_delay_ms == 0 ||
+	    len >= the_config.ust_metadata_push_threshold) {
+		return false;
+	}
+
+	if (lttng_clock_gettime(CLOCK_MONOTONIC, &now) ||
+	    timespec_to_ms(timespec_abs_diff(now, locked_registry->_metadata_pending_since),
+			   &pending_ms)) {
+		return false;
+	}
+
+	return pending_ms < the_config.ust_metadata_push_delay_ms;
+}
+
 /*
  * Push metadata to consumer socket.
  *
+ * If `coalesce` is set, the new metadata is held back, and nothing is pushed,
+ * until it reaches the push threshold or the push delay expires.
+ *
  * RCU read-side lock must be held to guarantee existence of socket.
  * Must be called with the ust app session lock held.
  * Must be called with the registry lock held.
@@ -689,7 +735,8 @@ int ust_app_release_object(struct ust_app *app, struct lttng_ust_abi_object_data
  */
 ssize_t ust_app_push_metadata(const lsu::registry_session::locked_ptr& locked_registry,
 			      struct consumer_socket *socket,
-			      int send_zero_data)
+			      int send_zero_data,
+			      bool coalesce)
 {
 	int ret;
 	char *metadata_str = nullptr;
@@ -715,6 +762,14 @@ ssize_t ust_app_push_metadata(const lsu::registry_session::locked_ptr& locked_re
 	len = locked_registry->_metadata_len - locked_registry->_metadata_len_sent;
 	new_metadata_len_sent = locked_registry->_metadata_len;
 	metadata_version = locked_registry->_metadata_version;
+	if (len > 0 && coalesce && metadata_push_can_be_delayed(locked_registry, len)) {
+		DBG3("Delaying push of %zu bytes of metadata for metadata key %" PRIu64,
+		     len,
+		     metadata_key);
+		len = 0;
+		new_metadata_len_sent = offset;
+	}
+
 	if (len == 0) {
 		DBG3("No metadata to push for metadata key %" PRIu64,
 		     locked_registry->_metadata_key);
@@ -734,7 +789,7 @@ ssize_t ust_app_push_metadata(const lsu::registry_session::locked_ptr& locked_re
 		goto error;
 	}
 	/* Copy what we haven't sent out. */
-	memcpy(metadata_str, locked_registry->_metadata + offset, len);
+	locked_registry->copy_metadata(offset, len, metadata_str);
 
 push_data:
 	pthread_mutex_unlock(&locked_registry->_lock);
@@ -849,7 +904,7 @@ static int push_metadata(const lsu::registry_session::locked_ptr& locked_registr
 		goto error;
 	}
 
-	ret = ust_app_push_metadata(locked_registry, socket, 0);
+	ret = ust_app_push_metadata(locked_registry, socket, 0, false);
 	if (ret < 0) {
 		ret_val = ret;
 		goto error;
@@ -1112,6 +1167,12 @@ static void delete_ust_app(struct ust_app *app)
 	}
 	lttng_fd_put(LTTNG_FD_APPS, 1);
 
+	free(app->tracepoint_cache.elements);
+	free(app->tracepoint_cache.event_names);
+	free(app->tracepoint_field_cache.elements);
+	free(app->tracepoint_field_cache.event_names);
+	pthread_mutex_destroy(&app->listing_cache_lock);
+
 	DBG2("UST app pid %d deleted", app->pid);
 	free(app);
 	session_unlock_list();
@@ -1245,7 +1306,7 @@ struct ust_app_stream *ust_app_alloc_stream()
 {
 	struct ust_app_stream *stream = nullptr;
 
-	stream = zmalloc<ust_app_stream>();
+	stream = ust_app_stream_allocator.zalloc<ust_app_stream>();
 	if (stream == nullptr) {
 		PERROR("zmalloc ust app stream");
 		goto error;
@@ -1258,6 +1319,14 @@ error:
 	return stream;
 }
 
+/*
+ * Free a UST app stream allocated by ust_app_alloc_stream().
+ */
+void ust_app_free_stream(struct ust_app_stream *stream)
+{
+	ust_app_stream_allocator.free(stream);
+}
+
 /*
  * Alloc new UST app event.
  */
@@ -1448,22 +1517,17 @@ error:
  */
 struct ust_app *ust_app_find_by_sock(int sock)
 {
-	struct lttng_ht_node_ulong *node;
-	struct lttng_ht_iter iter;
+	struct ust_app *app;
 
 	ASSERT_RCU_READ_LOCKED();
 
-	lttng_ht_lookup(ust_app_ht_by_sock, (void *) ((unsigned long) sock), &iter);
-	node = lttng_ht_iter_get_node_ulong(&iter);
-	if (node == nullptr) {
+	app = lttng::ht<lttng_ht_node_ulong, ust_app, &ust_app::sock_n>(*ust_app_ht_by_sock)
+		      .find((unsigned long) sock);
+	if (!app) {
 		DBG2("UST app find by sock %d not found", sock);
-		goto error;
 	}
 
-	return lttng::utils::container_of(node, &ust_app::sock_n);
-
-error:
-	return nullptr;
+	return app;
 }
 
 /*
@@ -2298,10 +2362,16 @@ static int create_ust_event_notifier(struct ust_app *app,
 		}
 	}
 
-	/* Set the capture bytecodes. */
-	cond_status = lttng_condition_event_rule_matches_get_capture_descriptor_count(
-		condition, &capture_bytecode_count);
-	LTTNG_ASSERT(cond_status == LTTNG_CONDITION_STATUS_OK);
+	/*
+	 * Set the capture bytecodes. The captured fields are only sent to the
+	 * clients by the notify actions: unless the trigger has one, the
+	 * tracer doesn't need to capture them in its notifications.
+	 */
+	if (lttng_trigger_has_notify_action(ua_event_notifier_rule->trigger)) {
+		cond_status = lttng_condition_event_rule_matches_get_capture_descriptor_count(
+			condition, &capture_bytecode_count);
+		LTTNG_ASSERT(cond_status == LTTNG_CONDITION_STATUS_OK);
+	}
 
 	for (i = 0; i < capture_bytecode_count; i++) {
 		const struct lttng_bytecode *capture_bytecode =
@@ -2362,10 +2432,9 @@ static void shadow_copy_event(struct ust_app_event *ua_event, struct ltt_ust_eve
 	/* Copy event attributes */
 	memcpy(&ua_event->attr, &uevent->attr, sizeof(ua_event->attr));
 
-	/* Copy filter bytecode */
+	/* Share the filter bytecode of the event. */
 	if (uevent->filter) {
-		ua_event->filter = lttng_bytecode_copy(uevent->filter);
-		/* Filter might be NULL here in case of ENONEM. */
+		ua_event->filter = filter_bytecode_get(uevent->filter);
 	}
 
 	/* Copy exclusion data */
@@ -2401,6 +2470,11 @@ static void shadow_copy_channel(struct ust_app_channel *ua_chan, struct ltt_ust_
 	ua_chan->attr.switch_timer_interval = uchan->attr.switch_timer_interval;
 	ua_chan->attr.read_timer_interval = uchan->attr.read_timer_interval;
 	ua_chan->monitor_timer_interval = uchan->monitor_timer_interval;
+	ua_chan->writeback_policy = uchan->writeback_policy;
+	ua_chan->writeback_window_size = uchan->writeback_window_size;
+	ua_chan->drain_max_subbuffers = uchan->drain_max_subbuffers;
+	ua_chan->drain_max_bytes = uchan->drain_max_bytes;
+	ua_chan->buffer_page_size = uchan->buffer_page_size;
 	ua_chan->attr.output = (lttng_ust_abi_output) uchan->attr.output;
 	ua_chan->attr.blocking_timeout = uchan->attr.u.s.blocking_timeout;
 
@@ -2622,6 +2696,9 @@ error:
  * is found, a new one is created, added to the global registry and
  * initialized. If regp is valid, it's set with the newly created object.
  *
+ * Takes the buffer registry list lock of the session since the applications
+ * of different UIDs are set up concurrently.
+ *
  * Return 0 on success or else a negative value.
  */
 static int setup_buffer_reg_uid(struct ltt_ust_session *usess,
@@ -2635,6 +2712,7 @@ static int setup_buffer_reg_uid(struct ltt_ust_session *usess,
 	LTTNG_ASSERT(usess);
 	LTTNG_ASSERT(app);
 
+	const lttng::pthread::lock_guard list_lock(usess->buffer_reg_uid_list_lock);
 	lttng::urcu::read_lock_guard read_lock;
 
 	reg_uid = buffer_reg_uid_find(usess->id, app->abi.bits_per_long, app->uid);
@@ -4115,6 +4193,7 @@ struct ust_app *ust_app_create(struct ust_register_msg *msg, int sock)
 	lta->sock = sock;
 	pthread_mutex_init(&lta->sock_lock, nullptr);
 	lttng_ht_node_init_ulong(&lta->sock_n, (unsigned long) lta->sock);
+	pthread_mutex_init(&lta->listing_cache_lock, nullptr);
 
 	CDS_INIT_LIST_HEAD(&lta->teardown_head);
 	return lta;
@@ -4464,179 +4543,375 @@ void ust_app_unregister_by_socket(int sock_fd)
 	ust_app_put(app);
 }
 
+namespace {
 /*
- * Fill events array with all events name of all registered apps.
+ * Growing array of the tracepoints, or tracepoint fields, listed from the
+ * applications.
  */
-int ust_app_list_events(struct lttng_event **events)
+template <typename ElementType>
+struct app_listing {
+	ElementType *elements;
+	size_t count;
+	size_t nbmem;
+
+	/* Return 0 on success, -ENOMEM on error. */
+	int append(const ElementType *new_elements, size_t new_count)
+	{
+		if (count + new_count > nbmem) {
+			ElementType *new_array;
+			size_t new_nbmem = std::max<size_t>(nbmem, UST_APP_EVENT_LIST_SIZE);
+
+			while (new_nbmem < count + new_count) {
+				new_nbmem <<= 1;
+			}
+
+			DBG2("Reallocating listing from %zu to %zu entries", nbmem, new_nbmem);
+			new_array =
+				(ElementType *) realloc(elements, new_nbmem * sizeof(ElementType));
+			if (new_array == nullptr) {
+				PERROR("realloc ust app listing");
+				return -ENOMEM;
+			}
+
+			/* Zero the new memory */
+			memset(new_array + nbmem, 0, (new_nbmem - nbmem) * sizeof(ElementType));
+			nbmem = new_nbmem;
+			elements = new_array;
+		}
+
+		memcpy(elements + count, new_elements, new_count * sizeof(ElementType));
+		count += new_count;
+		return 0;
+	}
+};
+
+/*
+ * Release a listing handle of an application.
+ *
+ * Called with the application's socket lock held.
+ */
+void release_app_listing_handle(const struct ust_app *app, int handle)
 {
-	int ret, handle;
-	size_t nbmem, count = 0;
-	struct lttng_ht_iter iter;
-	struct ust_app *app;
-	struct lttng_event *tmp_event;
+	const int ret = lttng_ust_ctl_release_handle(app->sock, handle);
 
-	nbmem = UST_APP_EVENT_LIST_SIZE;
-	tmp_event = calloc<lttng_event>(nbmem);
-	if (tmp_event == nullptr) {
-		PERROR("zmalloc ust app events");
-		ret = -ENOMEM;
-		goto error;
+	if (ret < 0) {
+		if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
+			DBG3("Error releasing app handle. Application died: pid = %d, sock = %d",
+			     app->pid,
+			     app->sock);
+		} else if (ret == -EAGAIN) {
+			WARN("Error releasing app handle. Communication time out: pid = %d, sock = %d",
+			     app->pid,
+			     app->sock);
+		} else {
+			ERR("Error releasing app handle with ret %d: pid = %d, sock = %d",
+			    ret,
+			    app->pid,
+			    app->sock);
+		}
 	}
+}
 
-	{
-		lttng::urcu::read_lock_guard read_lock;
+/*
+ * List the tracepoints of an application, appending them to `listing`.
+ *
+ * `complete` is unset if they couldn't all be listed, for example because
+ * the application is exiting.
+ *
+ * Return 0 on success or else a negative value.
+ */
+int list_app_tracepoints(struct ust_app *app, app_listing<lttng_event>& listing, bool& complete)
+{
+	int ret, handle;
+	struct lttng_ust_abi_tracepoint_iter uiter;
+	const lttng::pthread::lock_guard sock_lock(app->sock_lock);
 
-		cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
-			struct lttng_ust_abi_tracepoint_iter uiter;
+	complete = false;
 
-			health_code_update();
+	handle = lttng_ust_ctl_tracepoint_list(app->sock);
+	if (handle < 0) {
+		if (handle != -EPIPE && handle != -LTTNG_UST_ERR_EXITING) {
+			ERR("UST app list events getting handle failed for app pid %d", app->pid);
+		}
+		return 0;
+	}
 
-			if (!app->compatible) {
-				/*
-				 * TODO: In time, we should notice the caller of this error by
-				 * telling him that this is a version error.
-				 */
-				continue;
-			}
+	while ((ret = lttng_ust_ctl_tracepoint_list_get(app->sock, handle, &uiter)) !=
+	       -LTTNG_UST_ERR_NOENT) {
+		struct lttng_event event = {};
 
-			pthread_mutex_lock(&app->sock_lock);
-			handle = lttng_ust_ctl_tracepoint_list(app->sock);
-			if (handle < 0) {
-				if (handle != -EPIPE && handle != -LTTNG_UST_ERR_EXITING) {
-					ERR("UST app list events getting handle failed for app pid %d",
-					    app->pid);
-				}
-				pthread_mutex_unlock(&app->sock_lock);
-				continue;
+		/* Handle ustctl error. */
+		if (ret < 0) {
+			if (ret != -LTTNG_UST_ERR_EXITING && ret != -EPIPE) {
+				ERR("UST app tp list get failed for app %d with ret %d",
+				    app->sock,
+				    ret);
+				release_app_listing_handle(app, handle);
+				return ret;
 			}
 
-			while ((ret = lttng_ust_ctl_tracepoint_list_get(
-					app->sock, handle, &uiter)) != -LTTNG_UST_ERR_NOENT) {
-				/* Handle ustctl error. */
-				if (ret < 0) {
-					int release_ret;
-
-					if (ret != -LTTNG_UST_ERR_EXITING && ret != -EPIPE) {
-						ERR("UST app tp list get failed for app %d with ret %d",
-						    app->sock,
-						    ret);
-					} else {
-						DBG3("UST app tp list get failed. Application is dead");
-						break;
-					}
+			DBG3("UST app tp list get failed. Application is dead");
+			break;
+		}
 
-					free(tmp_event);
-					release_ret =
-						lttng_ust_ctl_release_handle(app->sock, handle);
-					if (release_ret < 0 &&
-					    release_ret != -LTTNG_UST_ERR_EXITING &&
-					    release_ret != -EPIPE) {
-						ERR("Error releasing app handle for app %d with ret %d",
-						    app->sock,
-						    release_ret);
-					}
+		health_code_update();
 
-					pthread_mutex_unlock(&app->sock_lock);
-					goto rcu_error;
-				}
+		memcpy(event.name, uiter.name, LTTNG_UST_ABI_SYM_NAME_LEN);
+		event.loglevel = uiter.loglevel;
+		event.type = (enum lttng_event_type) LTTNG_UST_ABI_TRACEPOINT;
+		event.pid = app->pid;
+		event.enabled = -1;
 
-				health_code_update();
-				if (count >= nbmem) {
-					/* In case the realloc fails, we free the memory */
-					struct lttng_event *new_tmp_event;
-					size_t new_nbmem;
-
-					new_nbmem = nbmem << 1;
-					DBG2("Reallocating event list from %zu to %zu entries",
-					     nbmem,
-					     new_nbmem);
-					new_tmp_event = (lttng_event *) realloc(
-						tmp_event, new_nbmem * sizeof(struct lttng_event));
-					if (new_tmp_event == nullptr) {
-						int release_ret;
-
-						PERROR("realloc ust app events");
-						free(tmp_event);
-						ret = -ENOMEM;
-						release_ret = lttng_ust_ctl_release_handle(
-							app->sock, handle);
-						if (release_ret < 0 &&
-						    release_ret != -LTTNG_UST_ERR_EXITING &&
-						    release_ret != -EPIPE) {
-							ERR("Error releasing app handle for app %d with ret %d",
-							    app->sock,
-							    release_ret);
-						}
-
-						pthread_mutex_unlock(&app->sock_lock);
-						goto rcu_error;
-					}
-					/* Zero the new memory */
-					memset(new_tmp_event + nbmem,
-					       0,
-					       (new_nbmem - nbmem) * sizeof(struct lttng_event));
-					nbmem = new_nbmem;
-					tmp_event = new_tmp_event;
-				}
+		ret = listing.append(&event, 1);
+		if (ret < 0) {
+			release_app_listing_handle(app, handle);
+			return ret;
+		}
+	}
 
-				memcpy(tmp_event[count].name,
-				       uiter.name,
-				       LTTNG_UST_ABI_SYM_NAME_LEN);
-				tmp_event[count].loglevel = uiter.loglevel;
-				tmp_event[count].type =
-					(enum lttng_event_type) LTTNG_UST_ABI_TRACEPOINT;
-				tmp_event[count].pid = app->pid;
-				tmp_event[count].enabled = -1;
-				count++;
-			}
+	complete = ret == -LTTNG_UST_ERR_NOENT;
+	release_app_listing_handle(app, handle);
+	return 0;
+}
 
-			ret = lttng_ust_ctl_release_handle(app->sock, handle);
-			pthread_mutex_unlock(&app->sock_lock);
-			if (ret < 0) {
-				if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
-					DBG3("Error releasing app handle. Application died: pid = %d, sock = %d",
-					     app->pid,
-					     app->sock);
-				} else if (ret == -EAGAIN) {
-					WARN("Error releasing app handle. Communication time out: pid = %d, sock = %d",
-					     app->pid,
-					     app->sock);
-				} else {
-					ERR("Error releasing app handle with ret %d: pid = %d, sock = %d",
-					    ret,
-					    app->pid,
-					    app->sock);
-				}
+/*
+ * List the tracepoint fields of an application, appending them to `listing`.
+ *
+ * `complete` is unset if they couldn't all be listed, for example because
+ * the application is exiting.
+ *
+ * Return 0 on success or else a negative value.
+ */
+int list_app_tracepoint_fields(struct ust_app *app,
+			       app_listing<lttng_event_field>& listing,
+			       bool& complete)
+{
+	int ret, handle;
+	struct lttng_ust_abi_field_iter uiter;
+	const lttng::pthread::lock_guard sock_lock(app->sock_lock);
+
+	complete = false;
+
+	handle = lttng_ust_ctl_tracepoint_field_list(app->sock);
+	if (handle < 0) {
+		if (handle != -EPIPE && handle != -LTTNG_UST_ERR_EXITING) {
+			ERR("UST app list field getting handle failed for app pid %d", app->pid);
+		}
+		return 0;
+	}
+
+	while ((ret = lttng_ust_ctl_tracepoint_field_list_get(app->sock, handle, &uiter)) !=
+	       -LTTNG_UST_ERR_NOENT) {
+		struct lttng_event_field field = {};
+
+		/* Handle ustctl error. */
+		if (ret < 0) {
+			if (ret != -LTTNG_UST_ERR_EXITING && ret != -EPIPE) {
+				ERR("UST app tp list field failed for app %d with ret %d",
+				    app->sock,
+				    ret);
+				release_app_listing_handle(app, handle);
+				return ret;
 			}
+
+			DBG3("UST app tp list field failed. Application is dead");
+			break;
+		}
+
+		health_code_update();
+
+		memcpy(field.field_name, uiter.field_name, LTTNG_UST_ABI_SYM_NAME_LEN);
+		/* Mapping between these enums matches 1 to 1. */
+		field.type = (enum lttng_event_field_type) uiter.type;
+		field.nowrite = uiter.nowrite;
+
+		memcpy(field.event.name, uiter.event_name, LTTNG_UST_ABI_SYM_NAME_LEN);
+		field.event.loglevel = uiter.loglevel;
+		field.event.type = LTTNG_EVENT_TRACEPOINT;
+		field.event.pid = app->pid;
+		field.event.enabled = -1;
+
+		ret = listing.append(&field, 1);
+		if (ret < 0) {
+			release_app_listing_handle(app, handle);
+			return ret;
 		}
 	}
 
-	ret = count;
-	*events = tmp_event;
+	complete = ret == -LTTNG_UST_ERR_NOENT;
+	release_app_listing_handle(app, handle);
+	return 0;
+}
+
+/*
+ * Return true if a cached listing of the tracepoints of an application can
+ * still be served.
+ *
+ * Called with the application's listing cache lock held.
+ */
+template <typename ElementType>
+bool listing_cache_is_fresh(const struct ust_app *app,
+			    const ust_app_listing_cache<ElementType>& cache)
+{
+	struct timespec now;
+	unsigned long age_ms;
+
+	if (!cache.cached || cache.generation != uatomic_read(&app->tracepoint_generation)) {
+		return false;
+	}
+
+	if (lttng_clock_gettime(CLOCK_MONOTONIC, &now) ||
+	    timespec_to_ms(timespec_abs_diff(now, cache.listing_time), &age_ms)) {
+		return false;
+	}
+
+	return age_ms < the_config.ust_tracepoint_list_cache_ms;
+}
 
-	DBG2("UST app list events done (%zu events)", count);
+const char *listed_event_name(const struct lttng_event& event)
+{
+	return event.name;
+}
 
-rcu_error:
-error:
-	health_code_update();
-	return ret;
+const char *listed_event_name(const struct lttng_event_field& field)
+{
+	return field.event.name;
+}
+
+bool listed_event_name_less(const char *name_a, const char *name_b)
+{
+	return strncmp(name_a, name_b, LTTNG_UST_ABI_SYM_NAME_LEN) < 0;
+}
+
+bool listed_event_name_equal(const char *name_a, const char *name_b)
+{
+	return strncmp(name_a, name_b, LTTNG_UST_ABI_SYM_NAME_LEN) == 0;
 }
 
 /*
- * Fill events array with all events name of all registered apps.
+ * Cache a listing of the tracepoints of an application, reflecting its
+ * tracepoint generation `generation`.
+ *
+ * The names of the listed events are indexed so that the event registrations
+ * of the application are checked against the cache without scanning it.
+ *
+ * Called with the application's listing cache lock held.
  */
-int ust_app_list_event_fields(struct lttng_event_field **fields)
+template <typename ElementType>
+void listing_cache_set(ust_app_listing_cache<ElementType>& cache,
+		       const ElementType *elements,
+		       size_t count,
+		       uint64_t generation)
 {
-	int ret, handle;
-	size_t nbmem, count = 0;
+	ElementType *cached_elements = nullptr;
+	const char **event_names = nullptr;
+	size_t event_name_count = 0;
+
+	if (count > 0) {
+		size_t i;
+
+		cached_elements = calloc<ElementType>(count);
+		event_names = calloc<const char *>(count);
+		if (!cached_elements || !event_names) {
+			PERROR("Failed to allocate cached ust app listing");
+			free(cached_elements);
+			free(event_names);
+			return;
+		}
+
+		memcpy(cached_elements, elements, count * sizeof(ElementType));
+
+		for (i = 0; i < count; i++) {
+			event_names[i] = listed_event_name(cached_elements[i]);
+		}
+
+		/* The fields of an event share its name. */
+		std::sort(event_names, event_names + count, listed_event_name_less);
+		event_name_count =
+			std::unique(event_names, event_names + count, listed_event_name_equal) -
+			event_names;
+	}
+
+	free(cache.elements);
+	free(cache.event_names);
+	cache.elements = cached_elements;
+	cache.count = count;
+	cache.event_names = event_names;
+	cache.event_name_count = event_name_count;
+	cache.generation = generation;
+	cache.cached = !lttng_clock_gettime(CLOCK_MONOTONIC, &cache.listing_time);
+}
+
+/*
+ * Append the tracepoints, or tracepoint fields, of an application to
+ * `listing`, from its cache when it is fresh, or listed by `list_app` from
+ * the application, caching them, otherwise.
+ *
+ * Return 0 on success or else a negative value.
+ */
+template <typename ElementType, typename ListAppFunction>
+int list_app_cached(struct ust_app *app,
+		    ust_app_listing_cache<ElementType>& cache,
+		    app_listing<ElementType>& listing,
+		    ListAppFunction list_app)
+{
+	int ret;
+	bool complete;
+	uint64_t generation;
+	const size_t first_element = listing.count;
+
+	if (the_config.ust_tracepoint_list_cache_ms == 0) {
+		return list_app(app, listing, complete);
+	}
+
+	{
+		const lttng::pthread::lock_guard cache_lock(app->listing_cache_lock);
+
+		if (listing_cache_is_fresh(app, cache)) {
+			DBG3("Serving cached listing of app pid %d", app->pid);
+			return listing.append(cache.elements, cache.count);
+		}
+	}
+
+	/* The application may provide new tracepoints while it is listed. */
+	generation = uatomic_read(&app->tracepoint_generation);
+	ret = list_app(app, listing, complete);
+	if (ret < 0 || !complete) {
+		return ret;
+	}
+
+	{
+		const lttng::pthread::lock_guard cache_lock(app->listing_cache_lock);
+
+		listing_cache_set(cache,
+				  listing.elements + first_element,
+				  listing.count - first_element,
+				  generation);
+	}
+
+	return 0;
+}
+
+/*
+ * List the tracepoints, or tracepoint fields, of all the registered
+ * applications into `*elements`.
+ *
+ * Return the number of elements or else a negative value.
+ */
+template <typename ElementType, typename ListAppFunction>
+int list_apps(ElementType **elements,
+	      ust_app_listing_cache<ElementType> ust_app::*cache,
+	      ListAppFunction list_app)
+{
+	int ret;
 	struct lttng_ht_iter iter;
 	struct ust_app *app;
-	struct lttng_event_field *tmp_event;
+	app_listing<ElementType> listing = {};
 
-	nbmem = UST_APP_EVENT_LIST_SIZE;
-	tmp_event = calloc<lttng_event_field>(nbmem);
-	if (tmp_event == nullptr) {
-		PERROR("zmalloc ust app event fields");
+	listing.nbmem = UST_APP_EVENT_LIST_SIZE;
+	listing.elements = calloc<ElementType>(listing.nbmem);
+	if (listing.elements == nullptr) {
+		PERROR("zmalloc ust app listing");
 		ret = -ENOMEM;
 		goto error;
 	}
@@ -4645,8 +4920,6 @@ int ust_app_list_event_fields(struct lttng_event_field **fields)
 		lttng::urcu::read_lock_guard read_lock;
 
 		cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
-			struct lttng_ust_abi_field_iter uiter;
-
 			health_code_update();
 
 			if (!app->compatible) {
@@ -4657,124 +4930,49 @@ int ust_app_list_event_fields(struct lttng_event_field **fields)
 				continue;
 			}
 
-			pthread_mutex_lock(&app->sock_lock);
-			handle = lttng_ust_ctl_tracepoint_field_list(app->sock);
-			if (handle < 0) {
-				if (handle != -EPIPE && handle != -LTTNG_UST_ERR_EXITING) {
-					ERR("UST app list field getting handle failed for app pid %d",
-					    app->pid);
-				}
-				pthread_mutex_unlock(&app->sock_lock);
-				continue;
+			ret = list_app_cached(app, app->*cache, listing, list_app);
+			if (ret < 0) {
+				free(listing.elements);
+				goto error;
 			}
+		}
+	}
 
-			while ((ret = lttng_ust_ctl_tracepoint_field_list_get(
-					app->sock, handle, &uiter)) != -LTTNG_UST_ERR_NOENT) {
-				/* Handle ustctl error. */
-				if (ret < 0) {
-					int release_ret;
-
-					if (ret != -LTTNG_UST_ERR_EXITING && ret != -EPIPE) {
-						ERR("UST app tp list field failed for app %d with ret %d",
-						    app->sock,
-						    ret);
-					} else {
-						DBG3("UST app tp list field failed. Application is dead");
-						break;
-					}
-
-					free(tmp_event);
-					release_ret =
-						lttng_ust_ctl_release_handle(app->sock, handle);
-					pthread_mutex_unlock(&app->sock_lock);
-					if (release_ret < 0 &&
-					    release_ret != -LTTNG_UST_ERR_EXITING &&
-					    release_ret != -EPIPE) {
-						ERR("Error releasing app handle for app %d with ret %d",
-						    app->sock,
-						    release_ret);
-					}
-
-					goto rcu_error;
-				}
+	ret = listing.count;
+	*elements = listing.elements;
 
-				health_code_update();
-				if (count >= nbmem) {
-					/* In case the realloc fails, we free the memory */
-					struct lttng_event_field *new_tmp_event;
-					size_t new_nbmem;
-
-					new_nbmem = nbmem << 1;
-					DBG2("Reallocating event field list from %zu to %zu entries",
-					     nbmem,
-					     new_nbmem);
-					new_tmp_event = (lttng_event_field *) realloc(
-						tmp_event,
-						new_nbmem * sizeof(struct lttng_event_field));
-					if (new_tmp_event == nullptr) {
-						int release_ret;
-
-						PERROR("realloc ust app event fields");
-						free(tmp_event);
-						ret = -ENOMEM;
-						release_ret = lttng_ust_ctl_release_handle(
-							app->sock, handle);
-						pthread_mutex_unlock(&app->sock_lock);
-						if (release_ret &&
-						    release_ret != -LTTNG_UST_ERR_EXITING &&
-						    release_ret != -EPIPE) {
-							ERR("Error releasing app handle for app %d with ret %d",
-							    app->sock,
-							    release_ret);
-						}
-
-						goto rcu_error;
-					}
+error:
+	health_code_update();
+	return ret;
+}
+} /* namespace */
 
-					/* Zero the new memory */
-					memset(new_tmp_event + nbmem,
-					       0,
-					       (new_nbmem - nbmem) *
-						       sizeof(struct lttng_event_field));
-					nbmem = new_nbmem;
-					tmp_event = new_tmp_event;
-				}
+/*
+ * Fill events array with all events name of all registered apps.
+ */
+int ust_app_list_events(struct lttng_event **events)
+{
+	const int ret = list_apps(events, &ust_app::tracepoint_cache, list_app_tracepoints);
 
-				memcpy(tmp_event[count].field_name,
-				       uiter.field_name,
-				       LTTNG_UST_ABI_SYM_NAME_LEN);
-				/* Mapping between these enums matches 1 to 1. */
-				tmp_event[count].type = (enum lttng_event_field_type) uiter.type;
-				tmp_event[count].nowrite = uiter.nowrite;
-
-				memcpy(tmp_event[count].event.name,
-				       uiter.event_name,
-				       LTTNG_UST_ABI_SYM_NAME_LEN);
-				tmp_event[count].event.loglevel = uiter.loglevel;
-				tmp_event[count].event.type = LTTNG_EVENT_TRACEPOINT;
-				tmp_event[count].event.pid = app->pid;
-				tmp_event[count].event.enabled = -1;
-				count++;
-			}
-
-			ret = lttng_ust_ctl_release_handle(app->sock, handle);
-			pthread_mutex_unlock(&app->sock_lock);
-			if (ret < 0 && ret != -LTTNG_UST_ERR_EXITING && ret != -EPIPE) {
-				ERR("Error releasing app handle for app %d with ret %d",
-				    app->sock,
-				    ret);
-			}
-		}
+	if (ret >= 0) {
+		DBG2("UST app list events done (%d events)", ret);
 	}
 
-	ret = count;
-	*fields = tmp_event;
+	return ret;
+}
+
+/*
+ * Fill events array with all events name of all registered apps.
+ */
+int ust_app_list_event_fields(struct lttng_event_field **fields)
+{
+	const int ret =
+		list_apps(fields, &ust_app::tracepoint_field_cache, list_app_tracepoint_fields);
 
-	DBG2("UST app list event fields done (%zu events)", count);
+	if (ret >= 0) {
+		DBG2("UST app list event fields done (%d events)", ret);
+	}
 
-rcu_error:
-error:
-	health_code_update();
 	return ret;
 }
 
@@ -5230,7 +5428,14 @@ int ust_app_create_event_glb(struct ltt_ust_session *usess,
 
 			ua_sess = lookup_session_by_app(usess, app);
 			if (!ua_sess) {
-				/* The application has problem or is probably dead. */
+				if (the_config.ust_lazy_per_pid_channels &&
+				    usess->buffer_type == LTTNG_BUFFER_PER_PID &&
+				    ust_app_provides_enabled_tracepoint(usess, app, uevent)) {
+					/* Create the deferred buffers of the application. */
+					ust_app_global_update(usess, app);
+				}
+
+				/* Otherwise, the application has problem or is probably dead. */
 				continue;
 			}
 
@@ -5268,9 +5473,203 @@ int ust_app_create_event_glb(struct ltt_ust_session *usess,
 	return ret;
 }
 
-/*
- * Start tracing for a specific UST session and app.
- *
+namespace {
+/* Operation applied to an application for a session. */
+using ust_app_op = void (*)(struct ltt_ust_session *usess, struct ust_app *app);
+
+/* Operation applied to the applications of a session by a pool of threads. */
+struct ust_app_fan_out_job {
+	struct ltt_ust_session *usess;
+	ust_app_op op;
+	/* Applications, those which share buffers next to each other. */
+	std::vector<ust_app *> apps;
+	/* Index of the first application of each group sharing buffers. */
+	std::vector<size_t> groups;
+	/* Index of the next group to handle. */
+	unsigned long next_group;
+	/* Duration of the operation, per application. */
+	std::vector<uint64_t> durations_ns;
+};
+
+uint64_t monotonic_ns()
+{
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now)) {
+		return 0;
+	}
+
+	return (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+/* Order of the applications by per-UID buffers. */
+bool ust_app_uid_buffers_less(const ust_app *a, const ust_app *b)
+{
+	if (a->uid != b->uid) {
+		return a->uid < b->uid;
+	}
+
+	return a->abi.bits_per_long < b->abi.bits_per_long;
+}
+
+bool ust_app_uid_buffers_equal(const ust_app *a, const ust_app *b)
+{
+	return a->uid == b->uid && a->abi.bits_per_long == b->abi.bits_per_long;
+}
+
+void run_ust_app_fan_out_job(ust_app_fan_out_job& job)
+{
+	lttng::urcu::read_lock_guard read_lock;
+
+	for (;;) {
+		const unsigned long group = uatomic_add_return(&job.next_group, 1) - 1;
+
+		if (group >= job.groups.size()) {
+			break;
+		}
+
+		const size_t end =
+			group + 1 < job.groups.size() ? job.groups[group + 1] : job.apps.size();
+
+		for (size_t i = job.groups[group]; i < end; i++) {
+			const uint64_t start_ns = monotonic_ns();
+
+			job.op(job.usess, job.apps[i]);
+			job.durations_ns[i] = monotonic_ns() - start_ns;
+		}
+	}
+}
+
+void *ust_app_fan_out_worker(void *data)
+{
+	auto *job = static_cast<ust_app_fan_out_job *>(data);
+
+	rcu_register_thread();
+	run_ust_app_fan_out_job(*job);
+	rcu_unregister_thread();
+	return nullptr;
+}
+} /* namespace */
+
+/*
+ * Apply an operation to all the applications for a session, spreading them
+ * across a pool of threads so that a slow application only holds up its
+ * own thread and the command round trips of the applications overlap. Each
+ * command to an application is bounded by the application socket timeout.
+ *
+ * The applications which share per-UID buffers are handled in order by the
+ * same thread since the first one creates the buffers which the next ones
+ * use; the applications with per-PID buffers are independent. The caller's
+ * RCU read-side lock keeps the applications alive until all threads are
+ * joined.
+ *
+ * The applications which took longer than DEFAULT_APP_COMMAND_SLOW_MS are
+ * reported once all are handled.
+ *
+ * Called with session lock held.
+ */
+static void ust_app_for_each_concurrently(struct ltt_ust_session *usess,
+					  ust_app_op op,
+					  const char *op_name)
+{
+	struct lttng_ht_iter iter;
+	struct ust_app *app;
+	ust_app_fan_out_job job;
+	std::vector<pthread_t> workers;
+	unsigned long worker_count;
+	uint64_t max_duration_ns = 0;
+
+	lttng::urcu::read_lock_guard read_lock;
+
+	job.usess = usess;
+	job.op = op;
+	job.next_group = 0;
+
+	try {
+		cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
+			job.apps.push_back(app);
+		}
+
+		if (usess->buffer_type == LTTNG_BUFFER_PER_UID) {
+			std::stable_sort(
+				job.apps.begin(), job.apps.end(), ust_app_uid_buffers_less);
+		}
+
+		for (size_t i = 0; i < job.apps.size(); i++) {
+			const bool shares_buffers = usess->buffer_type == LTTNG_BUFFER_PER_UID &&
+				i > 0 && ust_app_uid_buffers_equal(job.apps[i], job.apps[i - 1]);
+
+			if (!shares_buffers) {
+				job.groups.push_back(i);
+			}
+		}
+
+		job.durations_ns.resize(job.apps.size());
+		worker_count = std::min<unsigned long>(the_config.app_command_thread_count,
+						       job.groups.size());
+		/* The calling thread handles applications too. */
+		worker_count = worker_count > 0 ? worker_count - 1 : 0;
+		workers.reserve(worker_count);
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate %s of the applications of UST session %" PRIu64,
+		    op_name,
+		    usess->id);
+		return;
+	}
+
+	for (unsigned long i = 0; i < worker_count; i++) {
+		pthread_t worker;
+		const int create_ret = pthread_create(
+			&worker, default_pthread_attr(), ust_app_fan_out_worker, &job);
+
+		if (create_ret) {
+			/* Carry on with the threads launched so far. */
+			errno = create_ret;
+			PERROR("Failed to launch UST app %s thread", op_name);
+			break;
+		}
+
+		workers.push_back(worker);
+	}
+
+	run_ust_app_fan_out_job(job);
+
+	for (const auto worker : workers) {
+		const int join_ret = pthread_join(worker, nullptr);
+
+		if (join_ret) {
+			errno = join_ret;
+			PERROR("Failed to join UST app %s thread", op_name);
+		}
+	}
+
+	for (size_t i = 0; i < job.apps.size(); i++) {
+		const uint64_t duration_ms = job.durations_ns[i] / NSEC_PER_MSEC;
+
+		max_duration_ns = std::max(max_duration_ns, job.durations_ns[i]);
+		if (duration_ms >= DEFAULT_APP_COMMAND_SLOW_MS) {
+			WARN("Slow UST app %s: app = '%s', pid = %d, session_id = %" PRIu64
+			     ", duration = %" PRIu64 " ms",
+			     op_name,
+			     job.apps[i]->name,
+			     job.apps[i]->pid,
+			     usess->id,
+			     duration_ms);
+		}
+	}
+
+	DBG("UST app %s of session %" PRIu64 ": apps = %zu, threads = %zu, max_duration = %" PRIu64
+	    " us",
+	    op_name,
+	    usess->id,
+	    job.apps.size(),
+	    workers.size() + 1,
+	    (uint64_t) (max_duration_ns / NSEC_PER_USEC));
+}
+
+/*
+ * Start tracing for a specific UST session and app.
+ *
  * Called with UST app session lock held.
  *
  */
@@ -5492,6 +5891,12 @@ error_rcu_unlock:
 	return -1;
 }
 
+static void ust_app_stop_trace_op(struct ltt_ust_session *usess, struct ust_app *app)
+{
+	/* Continue with the other applications even on error. */
+	(void) ust_app_stop_trace(usess, app);
+}
+
 static int ust_app_flush_app_session(ust_app& app, ust_app_session& ua_sess)
 {
 	int ret, retval = 0;
@@ -5550,6 +5955,18 @@ end_not_compatible:
 	return retval;
 }
 
+static void ust_app_flush_app_session_op(struct ltt_ust_session *usess, struct ust_app *app)
+{
+	struct ust_app_session *ua_sess;
+
+	ua_sess = lookup_session_by_app(usess, app);
+	if (ua_sess == nullptr) {
+		return;
+	}
+
+	(void) ust_app_flush_app_session(*app, *ua_sess);
+}
+
 /*
  * Flush buffers for all applications for a specific UST session.
  * Called with UST session lock held.
@@ -5602,23 +6019,8 @@ static int ust_app_flush_session(struct ltt_ust_session *usess)
 		break;
 	}
 	case LTTNG_BUFFER_PER_PID:
-	{
-		struct ust_app_session *ua_sess;
-		struct lttng_ht_iter iter;
-		struct ust_app *app;
-		lttng::urcu::read_lock_guard read_lock;
-
-		cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
-			ua_sess = lookup_session_by_app(usess, app);
-			if (ua_sess == nullptr) {
-				continue;
-			}
-
-			(void) ust_app_flush_app_session(*app, *ua_sess);
-		}
-
+		ust_app_for_each_concurrently(usess, ust_app_flush_app_session_op, "flush");
 		break;
-	}
 	default:
 		ret = -1;
 		abort();
@@ -5830,9 +6232,6 @@ end:
  */
 int ust_app_start_trace_all(struct ltt_ust_session *usess)
 {
-	struct lttng_ht_iter iter;
-	struct ust_app *app;
-
 	DBG("Starting all UST traces");
 
 	/*
@@ -5849,13 +6248,7 @@ int ust_app_start_trace_all(struct ltt_ust_session *usess)
 	 */
 	(void) ust_app_clear_quiescent_session(usess);
 
-	{
-		lttng::urcu::read_lock_guard read_lock;
-
-		cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
-			ust_app_global_update(usess, app);
-		}
-	}
+	ust_app_global_update_apps(usess);
 
 	return 0;
 }
@@ -5866,10 +6259,6 @@ int ust_app_start_trace_all(struct ltt_ust_session *usess)
  */
 int ust_app_stop_trace_all(struct ltt_ust_session *usess)
 {
-	int ret = 0;
-	struct lttng_ht_iter iter;
-	struct ust_app *app;
-
 	DBG("Stopping all UST traces");
 
 	/*
@@ -5878,17 +6267,7 @@ int ust_app_stop_trace_all(struct ltt_ust_session *usess)
 	 */
 	usess->active = false;
 
-	{
-		lttng::urcu::read_lock_guard read_lock;
-
-		cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
-			ret = ust_app_stop_trace(usess, app);
-			if (ret < 0) {
-				/* Continue to next apps even on error */
-				continue;
-			}
-		}
-	}
+	ust_app_for_each_concurrently(usess, ust_app_stop_trace_op, "stop");
 
 	(void) ust_app_flush_session(usess);
 
@@ -6123,6 +6502,11 @@ end:
 }
 
 /*
+ * Replay the setup plan of the session in the application.
+ *
+ * The events of the channels created by the replay are created without
+ * looking them up in the application, which doesn't have them yet.
+ *
  * RCU read lock must be held by the caller.
  */
 static void ust_app_synchronize_all_channels(struct ltt_ust_session *usess,
@@ -6130,18 +6514,32 @@ static void ust_app_synchronize_all_channels(struct ltt_ust_session *usess,
 					     struct ust_app *app)
 {
 	int ret = 0;
-	struct cds_lfht_iter uchan_iter;
-	struct ltt_ust_channel *uchan;
+	const struct ltt_ust_setup_plan *plan;
+	size_t channel_count;
 
 	LTTNG_ASSERT(usess);
 	LTTNG_ASSERT(ua_sess);
 	LTTNG_ASSERT(app);
 	ASSERT_RCU_READ_LOCKED();
 
-	cds_lfht_for_each_entry (usess->domain_global.channels->ht, &uchan_iter, uchan, node.node) {
+	plan = trace_ust_get_setup_plan(usess);
+	if (!plan) {
+		ERR("Failed to get setup plan of session: app = '%s', pid = %d, session_id = %"
+		    PRIu64,
+		    app->name,
+		    app->pid,
+		    usess->id);
+		goto end;
+	}
+
+	channel_count = lttng_dynamic_array_get_count(&plan->channels);
+	for (size_t i = 0; i < channel_count; i++) {
+		const auto *channel = (const ltt_ust_setup_plan_channel *)
+			lttng_dynamic_array_get_element(&plan->channels, i);
+		const auto event_count = lttng_dynamic_pointer_array_get_count(&channel->events);
+		struct ltt_ust_channel *uchan = channel->uchan;
 		struct ust_app_channel *ua_chan;
-		struct cds_lfht_iter uevent_iter;
-		struct ltt_ust_event *uevent;
+		bool new_channel;
 
 		/*
 		 * Search for a matching ust_app_channel. If none is found,
@@ -6161,8 +6559,13 @@ static void ust_app_synchronize_all_channels(struct ltt_ust_session *usess,
 			continue;
 		}
 
-		cds_lfht_for_each_entry (uchan->events->ht, &uevent_iter, uevent, node.node) {
-			ret = ust_app_channel_synchronize_event(ua_chan, uevent, app);
+		new_channel = lttng_ht_get_count(ua_chan->events) == 0;
+		for (size_t j = 0; j < event_count; j++) {
+			auto *uevent = (ltt_ust_event *) lttng_dynamic_pointer_array_get_pointer(
+				&channel->events, j);
+
+			ret = new_channel ? create_ust_app_event(ua_chan, uevent, app) :
+					    ust_app_channel_synchronize_event(ua_chan, uevent, app);
 			if (ret) {
 				goto end;
 			}
@@ -6236,6 +6639,173 @@ end:
 	return;
 }
 
+/*
+ * Return true if the event rule may match the tracepoint. The filter of the
+ * event rule is not evaluated.
+ */
+static bool
+ust_app_event_may_match_tracepoint(const struct ltt_ust_event *uevent,
+				   const struct lttng_ust_abi_tracepoint_iter *tracepoint)
+{
+	/* Only `*` is a special character in the name pattern of an event rule. */
+	if (!strpbrk(uevent->attr.name, "?[") &&
+	    fnmatch(uevent->attr.name, tracepoint->name, 0) != 0) {
+		return false;
+	}
+
+	if (uevent->exclusion) {
+		for (uint32_t i = 0; i < uevent->exclusion->count; i++) {
+			const char *excluded =
+				LTTNG_EVENT_EXCLUSION_NAME_AT(uevent->exclusion, i);
+
+			if (!strpbrk(excluded, "?[") &&
+			    fnmatch(excluded, tracepoint->name, 0) == 0) {
+				return false;
+			}
+		}
+	}
+
+	if (uevent->attr.loglevel == -1) {
+		return true;
+	}
+
+	switch (uevent->attr.loglevel_type) {
+	case LTTNG_UST_ABI_LOGLEVEL_RANGE:
+		return tracepoint->loglevel <= uevent->attr.loglevel;
+	case LTTNG_UST_ABI_LOGLEVEL_SINGLE:
+		return tracepoint->loglevel == uevent->attr.loglevel;
+	default:
+		return true;
+	}
+}
+
+/* Return true if an event rule of the setup plan may match the tracepoint. */
+static bool
+ust_app_plan_may_match_tracepoint(const struct ltt_ust_setup_plan *plan,
+				  const struct lttng_ust_abi_tracepoint_iter *tracepoint)
+{
+	const auto channel_count = lttng_dynamic_array_get_count(&plan->channels);
+
+	for (size_t i = 0; i < channel_count; i++) {
+		const auto *channel = (const ltt_ust_setup_plan_channel *)
+			lttng_dynamic_array_get_element(&plan->channels, i);
+		const auto event_count = lttng_dynamic_pointer_array_get_count(&channel->events);
+
+		for (size_t j = 0; j < event_count; j++) {
+			const auto *uevent = (const ltt_ust_event *)
+				lttng_dynamic_pointer_array_get_pointer(&channel->events, j);
+
+			if (ust_app_event_may_match_tracepoint(uevent, tracepoint)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Return true if the application provides a tracepoint which an event rule
+ * of the session, or only `uevent` if it is set, may match. Return true as
+ * well if the tracepoints of the application can't be listed.
+ *
+ * Called with session lock held.
+ * Called with RCU read-side lock held.
+ */
+static bool ust_app_provides_enabled_tracepoint(struct ltt_ust_session *usess,
+						struct ust_app *app,
+						const struct ltt_ust_event *uevent)
+{
+	int ret, handle;
+	bool provided = false;
+	const struct ltt_ust_setup_plan *plan;
+	struct lttng_ust_abi_tracepoint_iter tracepoint;
+
+	plan = trace_ust_get_setup_plan(usess);
+	if (!plan) {
+		return true;
+	}
+
+	pthread_mutex_lock(&app->sock_lock);
+	handle = lttng_ust_ctl_tracepoint_list(app->sock);
+	if (handle < 0) {
+		pthread_mutex_unlock(&app->sock_lock);
+		return true;
+	}
+
+	while (!provided &&
+	       (ret = lttng_ust_ctl_tracepoint_list_get(app->sock, handle, &tracepoint)) !=
+		       -LTTNG_UST_ERR_NOENT) {
+		if (ret < 0) {
+			/* Don't defer the buffers of an application which can't be listed. */
+			provided = true;
+			break;
+		}
+
+		if (uevent) {
+			provided = ust_app_event_may_match_tracepoint(uevent, &tracepoint);
+			continue;
+		}
+
+		provided = ust_app_plan_may_match_tracepoint(plan, &tracepoint);
+	}
+
+	ret = lttng_ust_ctl_release_handle(app->sock, handle);
+	pthread_mutex_unlock(&app->sock_lock);
+	if (ret < 0 && ret != -LTTNG_UST_ERR_EXITING && ret != -EPIPE) {
+		ERR("Error releasing app handle for app %d with ret %d", app->sock, ret);
+	}
+
+	return provided;
+}
+
+/*
+ * Return true if the creation of the per-PID buffers of the application for
+ * the session is deferred since it provides no tracepoint which an event rule
+ * of the session may match.
+ *
+ * Called with session lock held.
+ * Called with RCU read-side lock held.
+ */
+static bool ust_app_defers_buffers(struct ltt_ust_session *usess, struct ust_app *app)
+{
+	const struct ltt_ust_setup_plan *plan;
+	uint64_t deferred_size = 0;
+
+	if (!the_config.ust_lazy_per_pid_channels || usess->buffer_type != LTTNG_BUFFER_PER_PID ||
+	    lookup_session_by_app(usess, app)) {
+		return false;
+	}
+
+	if (ust_app_provides_enabled_tracepoint(usess, app, nullptr)) {
+		return false;
+	}
+
+	plan = trace_ust_get_setup_plan(usess);
+	LTTNG_ASSERT(plan);
+	for (size_t i = 0; i < lttng_dynamic_array_get_count(&plan->channels); i++) {
+		const auto *channel = (const ltt_ust_setup_plan_channel *)
+			lttng_dynamic_array_get_element(&plan->channels, i);
+		const uint64_t stream_count =
+			strncmp(channel->uchan->name,
+				DEFAULT_METADATA_NAME,
+				sizeof(channel->uchan->name)) ?
+			lttng_ust_ctl_get_nr_stream_per_channel() :
+			1;
+
+		deferred_size += channel->uchan->attr.subbuf_size *
+			channel->uchan->attr.num_subbuf * stream_count;
+	}
+
+	DBG("Deferring buffers of UST app without enabled tracepoints: app = '%s', pid = %d, "
+	    "session_id = %" PRIu64 ", buffer size = %" PRIu64,
+	    app->name,
+	    app->pid,
+	    usess->id,
+	    deferred_size);
+	return true;
+}
+
 static void ust_app_global_destroy(struct ltt_ust_session *usess, struct ust_app *app)
 {
 	struct ust_app_session *ua_sess;
@@ -6267,6 +6837,10 @@ void ust_app_global_update(struct ltt_ust_session *usess, struct ust_app *app)
 	if (trace_ust_id_tracker_lookup(LTTNG_PROCESS_ATTR_VIRTUAL_PROCESS_ID, usess, app->pid) &&
 	    trace_ust_id_tracker_lookup(LTTNG_PROCESS_ATTR_VIRTUAL_USER_ID, usess, app->uid) &&
 	    trace_ust_id_tracker_lookup(LTTNG_PROCESS_ATTR_VIRTUAL_GROUP_ID, usess, app->gid)) {
+		if (ust_app_defers_buffers(usess, app)) {
+			return;
+		}
+
 		/*
 		 * Synchronize the application's internal tracing configuration
 		 * and start tracing.
@@ -6307,20 +6881,27 @@ void ust_app_global_update_event_notifier_rules(struct ust_app *app)
 }
 
 /*
+ * Update all the applications for a session concurrently.
+ *
+ * The workers only read the setup plan, which the calling thread builds.
+ *
  * Called with session lock held.
  */
-void ust_app_global_update_all(struct ltt_ust_session *usess)
+static void ust_app_global_update_apps(struct ltt_ust_session *usess)
 {
-	struct lttng_ht_iter iter;
-	struct ust_app *app;
+	if (usess->active) {
+		(void) trace_ust_get_setup_plan(usess);
+	}
 
-	{
-		lttng::urcu::read_lock_guard read_lock;
+	ust_app_for_each_concurrently(usess, ust_app_global_update, "update");
+}
 
-		cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
-			ust_app_global_update(usess, app);
-		}
-	}
+/*
+ * Called with session lock held.
+ */
+void ust_app_global_update_all(struct ltt_ust_session *usess)
+{
+	ust_app_global_update_apps(usess);
 }
 
 void ust_app_global_update_all_event_notifier_rules()
@@ -6660,35 +7241,84 @@ reply:
 	return ret;
 }
 
+namespace {
+template <typename Type>
+using free_unique_ptr = std::unique_ptr<
+	Type,
+	typename lttng::memory::create_deleter_class<Type, lttng::free>::deleter>;
+
+/* Event registration received from the notify socket of an application. */
+struct event_registration {
+	int sobjd;
+	int cobjd;
+	char name[LTTNG_UST_ABI_SYM_NAME_LEN];
+	int loglevel_value;
+	free_unique_ptr<char> signature;
+	size_t nr_fields;
+	free_unique_ptr<lttng_ust_ctl_field> fields;
+	free_unique_ptr<char> model_emf_uri;
+	/* Set once the event is added to the channel registry. */
+	uint32_t event_id;
+	int ret_code;
+	/* Unset if the channel or session of the event is being torn down. */
+	bool reply;
+};
+} /* namespace */
+
+/*
+ * Return true if a cached listing of the tracepoints of an application
+ * includes the event `name`.
+ */
+template <typename ElementType>
+static bool listing_cache_includes_event(const ust_app_listing_cache<ElementType>& cache,
+					 const char *name)
+{
+	return std::binary_search(cache.event_names,
+				  cache.event_names + cache.event_name_count,
+				  name,
+				  listed_event_name_less);
+}
+
 /*
- * Add event to the UST channel registry. When the event is added to the
- * registry, the metadata is also created. Once done, this replies to the
- * application with the appropriate error code.
+ * Invalidate the cached listings of the tracepoints of an application when
+ * it registers an event which they don't include: the application loaded a
+ * new tracepoint provider since they were listed.
+ */
+static void invalidate_app_listing_caches(struct ust_app *app,
+					  const std::vector<event_registration>& registrations)
+{
+	const lttng::pthread::lock_guard cache_lock(app->listing_cache_lock);
+
+	for (const auto& registration : registrations) {
+		if ((app->tracepoint_cache.cached &&
+		     !listing_cache_includes_event(app->tracepoint_cache, registration.name)) ||
+		    (app->tracepoint_field_cache.cached &&
+		     !listing_cache_includes_event(app->tracepoint_field_cache,
+						   registration.name))) {
+			DBG3("Invalidating cached listings of app pid %d: new event `%s`",
+			     app->pid,
+			     registration.name);
+			uatomic_inc(&app->tracepoint_generation);
+			return;
+		}
+	}
+}
+
+/*
+ * Add a batch of events to the UST channel registries. When an event is added
+ * to a registry, the metadata is also created. Once done, this replies to the
+ * application with the appropriate error code for each event, in order.
  *
- * The session UST registry lock is acquired in the function.
+ * The session UST registry lock is acquired in the function, once for the
+ * consecutive events of a same session.
  *
  * On success 0 is returned else a negative value.
  */
-static int add_event_ust_registry(int sock,
-				  int sobjd,
-				  int cobjd,
-				  const char *name,
-				  char *raw_signature,
-				  size_t nr_fields,
-				  struct lttng_ust_ctl_field *raw_fields,
-				  int loglevel_value,
-				  char *raw_model_emf_uri)
-{
-	int ret, ret_code;
-	uint32_t event_id = 0;
-	uint64_t chan_reg_key;
+static int add_events_ust_registry(int sock, std::vector<event_registration>& registrations)
+{
+	int ret = 0;
 	struct ust_app *app;
-	struct ust_app_channel *ua_chan;
-	struct ust_app_session *ua_sess;
 	lttng::urcu::read_lock_guard rcu_lock;
-	auto signature = lttng::make_unique_wrapper<char, lttng::free>(raw_signature);
-	auto fields = lttng::make_unique_wrapper<lttng_ust_ctl_field, lttng::free>(raw_fields);
-	auto model_emf_uri = lttng::make_unique_wrapper<char, lttng::free>(raw_model_emf_uri);
 
 	/* Lookup application. If not found, there is a code flow error. */
 	app = find_app_by_notify_sock(sock);
@@ -6697,96 +7327,126 @@ static int add_event_ust_registry(int sock,
 		return -1;
 	}
 
-	/* Lookup channel by UST object descriptor. */
-	ua_chan = find_channel_by_objd(app, cobjd);
-	if (!ua_chan) {
-		DBG("Application channel is being torn down. Abort event notify");
-		return 0;
+	if (the_config.ust_tracepoint_list_cache_ms > 0) {
+		invalidate_app_listing_caches(app, registrations);
 	}
 
-	LTTNG_ASSERT(ua_chan->session);
-	ua_sess = ua_chan->session;
+	{
+		const struct ust_app_session *locked_ua_sess = nullptr;
+		lsu::registry_session::locked_ptr locked_registry;
 
-	if (ua_sess->buffer_type == LTTNG_BUFFER_PER_UID) {
-		chan_reg_key = ua_chan->tracing_channel_id;
-	} else {
-		chan_reg_key = ua_chan->key;
-	}
+		for (auto& registration : registrations) {
+			uint64_t chan_reg_key;
+			struct ust_app_channel *ua_chan;
+			struct ust_app_session *ua_sess;
+
+			registration.event_id = 0;
+			registration.reply = false;
+
+			/* Lookup channel by UST object descriptor. */
+			ua_chan = find_channel_by_objd(app, registration.cobjd);
+			if (!ua_chan) {
+				DBG("Application channel is being torn down. Abort event notify");
+				continue;
+			}
+
+			LTTNG_ASSERT(ua_chan->session);
+			ua_sess = ua_chan->session;
+
+			if (ua_sess->buffer_type == LTTNG_BUFFER_PER_UID) {
+				chan_reg_key = ua_chan->tracing_channel_id;
+			} else {
+				chan_reg_key = ua_chan->key;
+			}
+
+			if (ua_sess != locked_ua_sess) {
+				/* Release the previous session's lock before taking this one. */
+				locked_registry.reset();
+				locked_registry = get_locked_session_registry(ua_sess);
+				locked_ua_sess = ua_sess;
+			}
+
+			if (!locked_registry) {
+				DBG("Application session is being torn down. Abort event notify");
+				continue;
+			}
 
-	{
-		auto locked_registry = get_locked_session_registry(ua_sess);
-		if (locked_registry) {
-			/*
-			 * From this point on, this call acquires the ownership of the signature,
-			 * fields and model_emf_uri meaning any free are done inside it if needed.
-			 * These three variables MUST NOT be read/write after this.
-			 */
 			try {
 				auto& channel = locked_registry->channel(chan_reg_key);
 
 				/* event_id is set on success. */
 				channel.add_event(
-					sobjd,
-					cobjd,
-					name,
-					signature.get(),
+					registration.sobjd,
+					registration.cobjd,
+					registration.name,
+					registration.signature.get(),
 					lsu::create_trace_fields_from_ust_ctl_fields(
 						*locked_registry,
-						fields.get(),
-						nr_fields,
+						registration.fields.get(),
+						registration.nr_fields,
 						lst::field_location::root::EVENT_RECORD_PAYLOAD,
 						lsu::ctl_field_quirks::
 							UNDERSCORE_PREFIXED_VARIANT_TAG_MAPPINGS),
-					loglevel_value,
-					model_emf_uri.get() ?
-						nonstd::optional<std::string>(model_emf_uri.get()) :
+					registration.loglevel_value,
+					registration.model_emf_uri.get() ?
+						nonstd::optional<std::string>(
+							registration.model_emf_uri.get()) :
 						nonstd::nullopt,
 					ua_sess->buffer_type,
 					*app,
-					event_id);
-				ret_code = 0;
+					registration.event_id);
+				registration.ret_code = 0;
 			} catch (const std::exception& ex) {
 				ERR("Failed to add event `%s` to registry session: %s",
-				    name,
+				    registration.name,
 				    ex.what());
 				/* Inform the application of the error; don't return directly. */
-				ret_code = -EINVAL;
+				registration.ret_code = -EINVAL;
 			}
-		} else {
-			DBG("Application session is being torn down. Abort event notify");
-			return 0;
+
+			registration.reply = true;
 		}
 	}
 
-	/*
-	 * The return value is returned to ustctl so in case of an error, the
-	 * application can be notified. In case of an error, it's important not to
-	 * return a negative error or else the application will get closed.
-	 */
-	ret = lttng_ust_ctl_reply_register_event(sock, event_id, ret_code);
-	if (ret < 0) {
-		if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
-			DBG3("UST app reply event failed. Application died: pid = %d, sock = %d.",
-			     app->pid,
-			     app->sock);
-		} else if (ret == -EAGAIN) {
-			WARN("UST app reply event failed. Communication time out: pid = %d, sock = %d",
-			     app->pid,
-			     app->sock);
-		} else {
-			ERR("UST app reply event failed with ret %d: pid = %d, sock = %d",
-			    ret,
-			    app->pid,
-			    app->sock);
+	for (const auto& registration : registrations) {
+		if (!registration.reply) {
+			continue;
 		}
+
 		/*
-		 * No need to wipe the create event since the application socket will
-		 * get close on error hence cleaning up everything by itself.
+		 * The return value is returned to ustctl so in case of an error, the
+		 * application can be notified. In case of an error, it's important not to
+		 * return a negative error or else the application will get closed.
 		 */
-		return ret;
+		ret = lttng_ust_ctl_reply_register_event(
+			sock, registration.event_id, registration.ret_code);
+		if (ret < 0) {
+			if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
+				DBG3("UST app reply event failed. Application died: pid = %d, sock = %d.",
+				     app->pid,
+				     app->sock);
+			} else if (ret == -EAGAIN) {
+				WARN("UST app reply event failed. Communication time out: pid = %d, sock = %d",
+				     app->pid,
+				     app->sock);
+			} else {
+				ERR("UST app reply event failed with ret %d: pid = %d, sock = %d",
+				    ret,
+				    app->pid,
+				    app->sock);
+			}
+			/*
+			 * No need to wipe the create event since the application socket will
+			 * get close on error hence cleaning up everything by itself.
+			 */
+			return ret;
+		}
+
+		DBG3("UST registry event %s with id %" PRId32 " added successfully",
+		     registration.name,
+		     registration.event_id);
 	}
 
-	DBG3("UST registry event %s with id %" PRId32 " added successfully", name, event_id);
 	return ret;
 }
 
@@ -6888,18 +7548,14 @@ static int add_enum_ust_registry(int sock,
 }
 
 /*
- * Handle application notification through the given notify socket.
+ * Receive the command of the next notification of an application.
  *
  * Return 0 on success or else a negative value.
  */
-int ust_app_recv_notify(int sock)
+static int recv_notify_cmd(int sock, enum lttng_ust_ctl_notify_cmd *cmd)
 {
-	int ret;
-	enum lttng_ust_ctl_notify_cmd cmd;
-
-	DBG3("UST app receiving notify from sock %d", sock);
+	const int ret = lttng_ust_ctl_recv_notify(sock, cmd);
 
-	ret = lttng_ust_ctl_recv_notify(sock, &cmd);
 	if (ret < 0) {
 		if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
 			DBG3("UST app recv notify failed. Application died: sock = %d", sock);
@@ -6908,76 +7564,138 @@ int ust_app_recv_notify(int sock)
 		} else {
 			ERR("UST app recv notify failed with ret %d: sock = %d", ret, sock);
 		}
+	}
+
+	return ret;
+}
+
+/*
+ * Receive the event registration following a LTTNG_UST_CTL_NOTIFY_CMD_EVENT
+ * command.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int recv_event_registration(int sock, event_registration& registration)
+{
+	int ret;
+	char *sig, *model_emf_uri;
+	struct lttng_ust_ctl_field *fields;
+
+	DBG2("UST app ustctl register event received");
+
+	ret = lttng_ust_ctl_recv_register_event(sock,
+						&registration.sobjd,
+						&registration.cobjd,
+						registration.name,
+						&registration.loglevel_value,
+						&sig,
+						&registration.nr_fields,
+						&fields,
+						&model_emf_uri);
+	if (ret < 0) {
+		if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
+			DBG3("UST app recv event failed. Application died: sock = %d", sock);
+		} else if (ret == -EAGAIN) {
+			WARN("UST app recv event failed. Communication time out: sock = %d", sock);
+		} else {
+			ERR("UST app recv event failed with ret %d: sock = %d", ret, sock);
+		}
+		return ret;
+	}
+
+	/* The registration owns the signature, fields and model EMF URI from now on. */
+	registration.signature.reset(sig);
+	registration.fields.reset(fields);
+	registration.model_emf_uri.reset(model_emf_uri);
+
+	if ((!fields && registration.nr_fields > 0) || (fields && registration.nr_fields == 0)) {
+		ERR("Invalid return value from lttng_ust_ctl_recv_register_event: fields = %p, nr_fields = %zu",
+		    fields,
+		    registration.nr_fields);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Return true if data, such as another notification, is already queued on
+ * the given notify socket.
+ */
+static bool notify_sock_has_pending_data(int sock)
+{
+	char byte;
+
+	return recv(sock, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT) > 0;
+}
+
+/*
+ * Handle application notification through the given notify socket.
+ *
+ * The event registrations already queued on the socket are handled as a
+ * batch: they are added to the registries under a single hold of the registry
+ * lock and replied to afterwards. A notification of another kind which
+ * follows them is handled once the batch is.
+ *
+ * Return 0 on success or else a negative value.
+ */
+int ust_app_recv_notify(int sock)
+{
+	int ret;
+	enum lttng_ust_ctl_notify_cmd cmd;
+	/* Set when the next command was received while batching event registrations. */
+	bool next_cmd_received;
+
+	DBG3("UST app receiving notify from sock %d", sock);
+
+	ret = recv_notify_cmd(sock, &cmd);
+	if (ret < 0) {
 		goto error;
 	}
 
+handle_cmd:
+	next_cmd_received = false;
+
 	switch (cmd) {
 	case LTTNG_UST_CTL_NOTIFY_CMD_EVENT:
 	{
-		int sobjd, cobjd, loglevel_value;
-		char name[LTTNG_UST_ABI_SYM_NAME_LEN], *sig, *model_emf_uri;
-		size_t nr_fields;
-		struct lttng_ust_ctl_field *fields;
-
-		DBG2("UST app ustctl register event received");
-
-		ret = lttng_ust_ctl_recv_register_event(sock,
-							&sobjd,
-							&cobjd,
-							name,
-							&loglevel_value,
-							&sig,
-							&nr_fields,
-							&fields,
-							&model_emf_uri);
-		if (ret < 0) {
-			if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
-				DBG3("UST app recv event failed. Application died: sock = %d",
-				     sock);
-			} else if (ret == -EAGAIN) {
-				WARN("UST app recv event failed. Communication time out: sock = %d",
-				     sock);
-			} else {
-				ERR("UST app recv event failed with ret %d: sock = %d", ret, sock);
-			}
-			goto error;
-		}
+		std::vector<event_registration> registrations;
 
-		{
-			lttng::urcu::read_lock_guard rcu_lock;
-			const struct ust_app *app = find_app_by_notify_sock(sock);
-			if (!app) {
-				DBG("Application socket %d is being torn down. Abort event notify",
-				    sock);
+		do {
+			try {
+				registrations.emplace_back();
+			} catch (const std::bad_alloc&) {
+				ERR("Failed to allocate event registration: sock = %d", sock);
 				ret = -1;
 				goto error;
 			}
-		}
 
-		if ((!fields && nr_fields > 0) || (fields && nr_fields == 0)) {
-			ERR("Invalid return value from lttng_ust_ctl_recv_register_event: fields = %p, nr_fields = %zu",
-			    fields,
-			    nr_fields);
-			ret = -1;
-			free(fields);
-			goto error;
-		}
+			ret = recv_event_registration(sock, registrations.back());
+			if (ret < 0) {
+				goto error;
+			}
+
+			next_cmd_received = false;
+			if (registrations.size() >= DEFAULT_APP_EVENT_REGISTRATION_BATCH ||
+			    !notify_sock_has_pending_data(sock)) {
+				break;
+			}
+
+			ret = recv_notify_cmd(sock, &cmd);
+			if (ret < 0) {
+				goto error;
+			}
+
+			next_cmd_received = true;
+		} while (cmd == LTTNG_UST_CTL_NOTIFY_CMD_EVENT);
+
+		DBG3("UST app registering %zu events: sock = %d", registrations.size(), sock);
 
 		/*
-		 * Add event to the UST registry coming from the notify socket. This
-		 * call will free if needed the sig, fields and model_emf_uri. This
-		 * code path loses the ownsership of these variables and transfer them
-		 * to the this function.
+		 * Add the events to the UST registry coming from the notify socket. This
+		 * call will free if needed the signatures, fields and model_emf_uris.
 		 */
-		ret = add_event_ust_registry(sock,
-					     sobjd,
-					     cobjd,
-					     name,
-					     sig,
-					     nr_fields,
-					     fields,
-					     loglevel_value,
-					     model_emf_uri);
+		ret = add_events_ust_registry(sock, registrations);
 		if (ret < 0) {
 			goto error;
 		}
@@ -7057,6 +7775,10 @@ int ust_app_recv_notify(int sock)
 		abort();
 	}
 
+	if (next_cmd_received) {
+		goto handle_cmd;
+	}
+
 error:
 	return ret;
 }
@@ -7408,13 +8130,15 @@ int ust_app_uid_get_channel_runtime_stats(uint64_t ust_session_id,
 					  uint64_t uchan_id,
 					  int overwrite,
 					  uint64_t *discarded,
-					  uint64_t *lost)
+					  uint64_t *lost,
+					  struct lttcomm_consumer_channel_consumption_stats *stats)
 {
 	int ret;
 	uint64_t consumer_chan_key;
 
 	*discarded = 0;
 	*lost = 0;
+	memset(stats, 0, sizeof(*stats));
 
 	ret = buffer_reg_uid_consumer_channel_key(
 		buffer_reg_uid_list, uchan_id, &consumer_chan_key);
@@ -7430,6 +8154,11 @@ int ust_app_uid_get_channel_runtime_stats(uint64_t ust_session_id,
 		ret = consumer_get_discarded_events(
 			ust_session_id, consumer_chan_key, consumer, discarded);
 	}
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = consumer_get_consumption_stats(ust_session_id, consumer_chan_key, consumer, stats);
 
 end:
 	return ret;
@@ -7440,7 +8169,8 @@ int ust_app_pid_get_channel_runtime_stats(struct ltt_ust_session *usess,
 					  struct consumer_output *consumer,
 					  int overwrite,
 					  uint64_t *discarded,
-					  uint64_t *lost)
+					  uint64_t *lost,
+					  struct lttcomm_consumer_channel_consumption_stats *stats)
 {
 	int ret = 0;
 	struct lttng_ht_iter iter;
@@ -7451,6 +8181,7 @@ int ust_app_pid_get_channel_runtime_stats(struct ltt_ust_session *usess,
 
 	*discarded = 0;
 	*lost = 0;
+	memset(stats, 0, sizeof(*stats));
 
 	/*
 	 * Iterate over every registered applications. Sum counters for
@@ -7460,6 +8191,8 @@ int ust_app_pid_get_channel_runtime_stats(struct ltt_ust_session *usess,
 
 	cds_lfht_for_each_entry (ust_app_ht->ht, &iter.iter, app, pid_n.node) {
 		struct lttng_ht_iter uiter;
+		struct lttcomm_consumer_channel_consumption_stats app_stats;
+		unsigned int i;
 
 		ua_sess = lookup_session_by_app(usess, app);
 		if (ua_sess == nullptr) {
@@ -7492,6 +8225,16 @@ int ust_app_pid_get_channel_runtime_stats(struct ltt_ust_session *usess,
 			}
 			(*discarded) += _discarded;
 		}
+
+		ret = consumer_get_consumption_stats(usess->id, ua_chan->key, consumer, &app_stats);
+		if (ret < 0) {
+			break;
+		}
+
+		for (i = 0; i < LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT; i++) {
+			stats->latency_histogram[i] += app_stats.latency_histogram[i];
+			stats->size_histogram[i] += app_stats.size_histogram[i];
+		}
 	}
 
 	return ret;
@@ -7715,16 +8458,46 @@ error:
 	return cmd_ret;
 }
 
+/*
+ * Add a path to the subdirectories to create, taking its ownership.
+ */
+static int add_subdirectory_path(struct lttng_dynamic_pointer_array *paths, char *path)
+{
+	int ret;
+
+	if (!path) {
+		ERR("Failed to allocate subdirectory path");
+		return -1;
+	}
+
+	ret = lttng_dynamic_pointer_array_add_pointer(paths, path);
+	if (ret) {
+		ERR("Failed to add \"%s\" to the subdirectories to create", path);
+		free(path);
+	}
+
+	return ret;
+}
+
 enum lttng_error_code ust_app_create_channel_subdirectories(const struct ltt_ust_session *usess)
 {
 	enum lttng_error_code ret = LTTNG_OK;
 	struct lttng_ht_iter iter;
 	enum lttng_trace_chunk_status chunk_status;
+	struct lttng_dynamic_pointer_array paths;
 	char *pathname_index;
 	int fmt_ret;
 
 	LTTNG_ASSERT(usess->current_trace_chunk);
 
+	/*
+	 * Gather the paths to create them all with a single request to the
+	 * run-as worker rather than one per channel directory.
+	 */
+	lttng_dynamic_pointer_array_init(&paths, free);
+	const auto reset_paths = lttng::make_scope_exit(
+		[&paths]() noexcept { lttng_dynamic_pointer_array_reset(&paths); });
+
 	switch (usess->buffer_type) {
 	case LTTNG_BUFFER_PER_UID:
 	{
@@ -7747,10 +8520,7 @@ enum lttng_error_code ust_app_create_channel_subdirectories(const struct ltt_ust
 			 * Create the index subdirectory which will take care
 			 * of implicitly creating the channel's path.
 			 */
-			chunk_status = lttng_trace_chunk_create_subdirectory(
-				usess->current_trace_chunk, pathname_index);
-			free(pathname_index);
-			if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+			if (add_subdirectory_path(&paths, pathname_index)) {
 				ret = LTTNG_ERR_CREATE_DIR_FAIL;
 				goto error;
 			}
@@ -7765,9 +8535,7 @@ enum lttng_error_code ust_app_create_channel_subdirectories(const struct ltt_ust
 		/*
 		 * Create the toplevel ust/ directory in case no apps are running.
 		 */
-		chunk_status = lttng_trace_chunk_create_subdirectory(usess->current_trace_chunk,
-								     DEFAULT_UST_TRACE_DIR);
-		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		if (add_subdirectory_path(&paths, strdup(DEFAULT_UST_TRACE_DIR))) {
 			ret = LTTNG_ERR_CREATE_DIR_FAIL;
 			goto error;
 		}
@@ -7796,14 +8564,12 @@ enum lttng_error_code ust_app_create_channel_subdirectories(const struct ltt_ust
 				ret = LTTNG_ERR_CREATE_DIR_FAIL;
 				goto error;
 			}
+
 			/*
 			 * Create the index subdirectory which will take care
 			 * of implicitly creating the channel's path.
 			 */
-			chunk_status = lttng_trace_chunk_create_subdirectory(
-				usess->current_trace_chunk, pathname_index);
-			free(pathname_index);
-			if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+			if (add_subdirectory_path(&paths, pathname_index)) {
 				ret = LTTNG_ERR_CREATE_DIR_FAIL;
 				goto error;
 			}
@@ -7814,17 +8580,27 @@ enum lttng_error_code ust_app_create_channel_subdirectories(const struct ltt_ust
 		abort();
 	}
 
+	chunk_status = lttng_trace_chunk_create_subdirectories(
+		usess->current_trace_chunk,
+		(const char *const *) paths.array.buffer.data,
+		lttng_dynamic_pointer_array_get_count(&paths));
+	if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		ret = LTTNG_ERR_CREATE_DIR_FAIL;
+		goto error;
+	}
+
 	ret = LTTNG_OK;
 error:
 	return ret;
 }
 
 /*
- * Clear all the channels of a session.
+ * Clear all the channels of a session. When `truncate_output` is set, the
+ * consumers also truncate the local output files of the streams in place.
  *
  * Return LTTNG_OK on success or else an LTTng error code.
  */
-enum lttng_error_code ust_app_clear_session(struct ltt_session *session)
+enum lttng_error_code ust_app_clear_session(struct ltt_session *session, bool truncate_output)
 {
 	int ret;
 	enum lttng_error_code cmd_ret = LTTNG_OK;
@@ -7861,7 +8637,8 @@ enum lttng_error_code ust_app_clear_session(struct ltt_session *session)
 			/* Clear the data channels. */
 			cds_lfht_for_each_entry (
 				reg->registry->channels->ht, &iter.iter, buf_reg_chan, node.node) {
-				ret = consumer_clear_channel(socket, buf_reg_chan->consumer_key);
+				ret = consumer_clear_channel(
+					socket, buf_reg_chan->consumer_key, truncate_output);
 				if (ret < 0) {
 					goto error;
 				}
@@ -7877,7 +8654,8 @@ enum lttng_error_code ust_app_clear_session(struct ltt_session *session)
 			 * Metadata channel is not cleared per se but we still need to
 			 * perform a rotation operation on it behind the scene.
 			 */
-			ret = consumer_clear_channel(socket, reg->registry->reg.ust->_metadata_key);
+			ret = consumer_clear_channel(
+				socket, reg->registry->reg.ust->_metadata_key, truncate_output);
 			if (ret < 0) {
 				goto error;
 			}
@@ -7918,7 +8696,7 @@ enum lttng_error_code ust_app_clear_session(struct ltt_session *session)
 			/* Clear the data channels. */
 			cds_lfht_for_each_entry (
 				ua_sess->channels->ht, &chan_iter.iter, ua_chan, node.node) {
-				ret = consumer_clear_channel(socket, ua_chan->key);
+				ret = consumer_clear_channel(socket, ua_chan->key, truncate_output);
 				if (ret < 0) {
 					/* Per-PID buffer and application going away. */
 					if (ret == -LTTNG_ERR_CHAN_NOT_FOUND) {
@@ -7938,7 +8716,8 @@ enum lttng_error_code ust_app_clear_session(struct ltt_session *session)
 			 * Metadata channel is not cleared per se but we still need to
 			 * perform rotation operation on it behind the scene.
 			 */
-			ret = consumer_clear_channel(socket, registry->_metadata_key);
+			ret = consumer_clear_channel(
+				socket, registry->_metadata_key, truncate_output);
 			if (ret < 0) {
 				/* Per-PID buffer and application going away. */
 				if (ret == -LTTNG_ERR_CHAN_NOT_FOUND) {
@@ -176,6 +176,11 @@ struct ust_app_channel {
 	uint64_t tracefile_size;
 	uint64_t tracefile_count;
 	uint64_t monitor_timer_interval;
+	enum lttng_channel_writeback_policy writeback_policy;
+	uint64_t writeback_window_size;
+	uint32_t drain_max_subbuffers;
+	uint64_t drain_max_bytes;
+	enum lttng_channel_buffer_page_size buffer_page_size;
 	/*
 	 * Node indexed by channel name in the channels' hash table of a session.
 	 */
@@ -245,6 +250,25 @@ struct ust_app_session {
 	char shm_path[PATH_MAX];
 };
 
+/*
+ * Tracepoints, or tracepoint fields, listed from an application and cached to
+ * serve the following listing commands.
+ */
+template <typename ElementType>
+struct ust_app_listing_cache {
+	/* Owned by the cache, null if it is empty. */
+	ElementType *elements;
+	size_t count;
+	/* Sorted distinct names of the events of the elements, owned by the cache. */
+	const char **event_names;
+	size_t event_name_count;
+	bool cached;
+	/* Monotonic time at which the elements were listed. */
+	struct timespec listing_time;
+	/* Tracepoint generation of the application which the elements reflect. */
+	uint64_t generation;
+};
+
 /*
  * Registered traceable applications. Libust registers to the session daemon
  * and a linked list is kept of all running traceable app.
@@ -336,6 +360,16 @@ struct ust_app {
 	 */
 	struct lttng_ht *token_to_event_notifier_rule_ht;
 
+	/*
+	 * Incremented, atomically, when the application may provide new
+	 * tracepoints, which invalidates the cached listings of its tracepoints.
+	 */
+	uint64_t tracepoint_generation;
+	/* Protects the cached listings. */
+	pthread_mutex_t listing_cache_lock;
+	ust_app_listing_cache<struct lttng_event> tracepoint_cache;
+	ust_app_listing_cache<struct lttng_event_field> tracepoint_field_cache;
+
 	lttng::sessiond::ust::ctl_field_quirks ctl_field_quirks() const;
 };
 
@@ -398,6 +432,7 @@ void ust_app_clean_list();
 int ust_app_ht_alloc();
 struct ust_app *ust_app_find_by_pid(pid_t pid);
 struct ust_app_stream *ust_app_alloc_stream();
+void ust_app_free_stream(struct ust_app_stream *stream);
 int ust_app_recv_registration(int sock, struct ust_register_msg *msg);
 int ust_app_recv_notify(int sock);
 void ust_app_add(struct ust_app *app);
@@ -405,7 +440,8 @@ struct ust_app *ust_app_create(struct ust_register_msg *msg, int sock);
 void ust_app_notify_sock_unregister(int sock);
 ssize_t ust_app_push_metadata(const lttng::sessiond::ust::registry_session::locked_ptr& registry,
 			      struct consumer_socket *socket,
-			      int send_zero_data);
+			      int send_zero_data,
+			      bool coalesce);
 enum lttng_error_code ust_app_snapshot_record(const struct ltt_ust_session *usess,
 					      const struct consumer_output *output,
 					      uint64_t nb_packets_per_stream);
@@ -418,18 +454,20 @@ int ust_app_uid_get_channel_runtime_stats(uint64_t ust_session_id,
 					  uint64_t uchan_id,
 					  int overwrite,
 					  uint64_t *discarded,
-					  uint64_t *lost);
+					  uint64_t *lost,
+					  struct lttcomm_consumer_channel_consumption_stats *stats);
 int ust_app_pid_get_channel_runtime_stats(struct ltt_ust_session *usess,
 					  struct ltt_ust_channel *uchan,
 					  struct consumer_output *consumer,
 					  int overwrite,
 					  uint64_t *discarded,
-					  uint64_t *lost);
+					  uint64_t *lost,
+					  struct lttcomm_consumer_channel_consumption_stats *stats);
 int ust_app_regenerate_statedump_all(struct ltt_ust_session *usess);
 enum lttng_error_code ust_app_rotate_session(struct ltt_session *session);
 enum lttng_error_code ust_app_create_channel_subdirectories(const struct ltt_ust_session *session);
 int ust_app_release_object(struct ust_app *app, struct lttng_ust_abi_object_data *data);
-enum lttng_error_code ust_app_clear_session(struct ltt_session *session);
+enum lttng_error_code ust_app_clear_session(struct ltt_session *session, bool truncate_output);
 enum lttng_error_code ust_app_open_packets(struct ltt_session *session);
 
 int ust_app_setup_event_notifier_group(struct ust_app *app);
@@ -616,7 +654,8 @@ static inline void ust_app_notify_sock_unregister(int sock __attribute__((unused
 static inline ssize_t ust_app_push_metadata(lttng::sessiond::ust::registry_session *registry
 					    __attribute__((unused)),
 					    struct consumer_socket *socket __attribute__((unused)),
-					    int send_zero_data __attribute__((unused)))
+					    int send_zero_data __attribute__((unused)),
+					    bool coalesce __attribute__((unused)))
 {
 	return 0;
 }
@@ -683,7 +722,9 @@ static inline int ust_app_uid_get_channel_runtime_stats(uint64_t ust_session_id
 							int overwrite __attribute__((unused)),
 							uint64_t uchan_id __attribute__((unused)),
 							uint64_t *discarded __attribute__((unused)),
-							uint64_t *lost __attribute__((unused)))
+							uint64_t *lost __attribute__((unused)),
+							struct lttcomm_consumer_channel_consumption_stats
+								*stats __attribute__((unused)))
 {
 	return 0;
 }
@@ -694,7 +735,9 @@ ust_app_pid_get_channel_runtime_stats(struct ltt_ust_session *usess __attribute_
 				      struct consumer_output *consumer __attribute__((unused)),
 				      int overwrite __attribute__((unused)),
 				      uint64_t *discarded __attribute__((unused)),
-				      uint64_t *lost __attribute__((unused)))
+				      uint64_t *lost __attribute__((unused)),
+				      struct lttcomm_consumer_channel_consumption_stats *stats
+				      __attribute__((unused)))
 {
 	return 0;
 }
@@ -725,6 +768,8 @@ static inline int ust_app_release_object(struct ust_app *app __attribute__((unus
 }
 
 static inline enum lttng_error_code ust_app_clear_session(struct ltt_session *session
+							  __attribute__((unused)),
+							  bool truncate_output
 							  __attribute__((unused)))
 {
 	return LTTNG_ERR_UNK;
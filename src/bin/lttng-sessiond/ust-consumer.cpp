@@ -152,6 +152,11 @@ static int ask_channel_creation(struct ust_app_session *ua_sess,
 					   ua_sess->output_traces,
 					   lttng_credentials_get_uid(&ua_sess->real_credentials),
 					   ua_chan->attr.blocking_timeout,
+					   ua_chan->writeback_policy,
+					   ua_chan->writeback_window_size,
+					   ua_chan->drain_max_subbuffers,
+					   ua_chan->drain_max_bytes,
+					   ua_chan->buffer_page_size,
 					   root_shm_path,
 					   shm_path,
 					   trace_chunk,
@@ -279,7 +284,7 @@ int ust_consumer_get_channel(struct consumer_socket *socket, struct ust_app_chan
 		/* Stream object is populated by this call if successful. */
 		ret = lttng_ust_ctl_recv_stream_from_consumer(*socket->fd_ptr, &stream->obj);
 		if (ret < 0) {
-			free(stream);
+			ust_app_free_stream(stream);
 			if (ret == -LTTNG_UST_ERR_NOENT) {
 				DBG3("UST app consumer has no more stream available");
 				break;
@@ -506,7 +511,11 @@ int ust_consumer_metadata_request(struct consumer_socket *socket)
 
 	{
 		auto locked_ust_reg = ust_reg->lock();
-		ret_push = ust_app_push_metadata(locked_ust_reg, socket, 1);
+		/*
+		 * The periodic requests can go without the latest metadata, unlike the
+		 * ones made to synchronize the metadata before the data is consumed.
+		 */
+		ret_push = ust_app_push_metadata(locked_ust_reg, socket, 1, request.periodic);
 	}
 	if (ret_push == -EPIPE) {
 		DBG("Application or relay closed while pushing metadata");
@@ -5,6 +5,7 @@
  *
  */
 
+#include "lttng-sessiond.hpp"
 #include "ust-app.hpp"
 #include "ust-registry-session-pid.hpp"
 
@@ -29,6 +30,10 @@ lsu::registry_session_per_pid::registry_session_per_pid(const struct ust_app& ap
 	_app_creation_time{ app.registration_time }
 {
 	lttng::pthread::lock_guard registry_lock(_lock);
+	if (the_config.ust_per_pid_shared_metadata) {
+		_share_event_class_metadata();
+	}
+
 	_generate_metadata();
 }
 
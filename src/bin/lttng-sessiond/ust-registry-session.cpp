@@ -28,12 +28,14 @@
 #include <common/time.hpp>
 #include <common/urcu.hpp>
 
+#include <algorithm>
 #include <fcntl.h>
 #include <functional>
 #include <initializer_list>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 namespace ls = lttng::sessiond;
 namespace lst = lttng::sessiond::trace;
@@ -51,18 +53,77 @@ lttng_uuid generate_uuid_or_throw()
 	return new_uuid;
 }
 
-int get_count_order(unsigned int count)
-{
-	int order;
+/*
+ * Pool of the metadata fragments generated by the registry sessions.
+ *
+ * The fragments which have the same text, such as the descriptions of the
+ * event classes of the per-PID registry sessions of the instances of an
+ * application, are stored once and shared by the registry sessions which
+ * generated them. A fragment leaves the pool once no registry session
+ * refers to it anymore.
+ */
+class metadata_fragment_pool {
+public:
+	static std::shared_ptr<const std::string> intern(const std::string& text)
+	{
+		const auto hash = std::hash<std::string>()(text);
+		const std::lock_guard<std::mutex> guard(_lock);
+		const auto range = _fragments.equal_range(hash);
+
+		/*
+		 * The text of the fragments in the pool remains valid while the
+		 * lock is held since a released fragment is deleted after leaving
+		 * the pool. Only a fragment which is returned is referenced here:
+		 * releasing one with the lock held would deadlock.
+		 */
+		for (auto it = range.first; it != range.second; ++it) {
+			if (*it->second.text != text) {
+				continue;
+			}
 
-	order = lttng_fls(count) - 1;
-	if (count & (count - 1)) {
-		order++;
+			auto fragment = it->second.ref.lock();
+			if (fragment) {
+				return fragment;
+			}
+		}
+
+		const std::shared_ptr<const std::string> fragment(
+			new std::string(text), [hash](const std::string *released) {
+				_remove(hash, released);
+				delete released;
+			});
+
+		_fragments.emplace(hash, entry{ fragment.get(), fragment });
+		return fragment;
 	}
 
-	LTTNG_ASSERT(order >= 0);
-	return order;
-}
+private:
+	struct entry {
+		/* Identifies the fragment once it has expired. */
+		const std::string *text;
+		std::weak_ptr<const std::string> ref;
+	};
+
+	static void _remove(std::size_t hash, const std::string *released)
+	{
+		const std::lock_guard<std::mutex> guard(_lock);
+		const auto range = _fragments.equal_range(hash);
+
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second.text == released) {
+				_fragments.erase(it);
+				return;
+			}
+		}
+	}
+
+	static std::mutex _lock;
+	static std::unordered_multimap<std::size_t, entry> _fragments;
+};
+
+std::mutex metadata_fragment_pool::_lock;
+std::unordered_multimap<std::size_t, metadata_fragment_pool::entry>
+	metadata_fragment_pool::_fragments;
 
 void clear_metadata_file(int fd)
 {
@@ -224,6 +285,188 @@ unsigned long ht_hash_enum(void *_key, unsigned long seed)
 }
 } /* namespace */
 
+namespace lttng {
+namespace sessiond {
+namespace ust {
+/*
+ * Metadata generated for the event classes of the registry sessions of a
+ * recording session which share it, such as the per-PID registry sessions of
+ * the instances of an application.
+ *
+ * The description of an event class is generated by the first registry
+ * session which declares it and reused by the ones which declare an
+ * identical event class, with the same ABI, name, IDs, log level, model EMF
+ * URI and payload. The cache of a recording session is released with the
+ * last registry session which shares it.
+ */
+class event_class_metadata_cache {
+public:
+	static std::shared_ptr<event_class_metadata_cache> get(uint64_t tracing_id)
+	{
+		const std::lock_guard<std::mutex> guard(_caches_lock);
+		auto it = _caches.find(tracing_id);
+
+		/* An expired cache is only replaced here, its deleter doesn't take it out. */
+		if (it != _caches.end()) {
+			auto cache = it->second.ref.lock();
+			if (cache) {
+				return cache;
+			}
+		}
+
+		const std::shared_ptr<event_class_metadata_cache> cache(
+			new event_class_metadata_cache(),
+			[tracing_id](event_class_metadata_cache *released) {
+				_remove(tracing_id, released);
+				delete released;
+			});
+
+		_caches[tracing_id] = cache_ref{ cache.get(), cache };
+		return cache;
+	}
+
+	/* Return the description of an identical event class, or null. */
+	std::shared_ptr<const std::string> find(const lst::abi& abi,
+						const lst::event_class& event_class) const
+	{
+		const std::lock_guard<std::mutex> guard(_lock);
+		const auto range = _entries.equal_range(_hash(event_class));
+
+		for (auto it = range.first; it != range.second; ++it) {
+			const auto& entry = it->second;
+
+			if (_abi_equals(entry.abi, abi) && entry.id == event_class.id &&
+			    entry.stream_class_id == event_class.stream_class_id &&
+			    entry.log_level == event_class.log_level &&
+			    entry.name == event_class.name &&
+			    entry.model_emf_uri == event_class.model_emf_uri &&
+			    *entry.payload == *event_class.payload) {
+				return entry.description;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void add(const lst::abi& abi,
+		 const lst::event_class& event_class,
+		 std::shared_ptr<const std::string> description)
+	{
+		const std::lock_guard<std::mutex> guard(_lock);
+
+		_entries.emplace(_hash(event_class),
+				 entry{ abi,
+					event_class.id,
+					event_class.stream_class_id,
+					event_class.log_level,
+					event_class.name,
+					event_class.model_emf_uri,
+					event_class.payload,
+					std::move(description) });
+	}
+
+private:
+	struct entry {
+		lst::abi abi;
+		unsigned int id;
+		unsigned int stream_class_id;
+		int log_level;
+		std::string name;
+		nonstd::optional<std::string> model_emf_uri;
+		std::shared_ptr<const lst::type> payload;
+		std::shared_ptr<const std::string> description;
+	};
+
+	struct cache_ref {
+		/* Identifies the cache once it has expired. */
+		const event_class_metadata_cache *cache;
+		std::weak_ptr<event_class_metadata_cache> ref;
+	};
+
+	event_class_metadata_cache() = default;
+
+	static std::size_t _hash(const lst::event_class& event_class)
+	{
+		return std::hash<std::string>()(event_class.name) ^ event_class.id;
+	}
+
+	static bool _abi_equals(const lst::abi& a, const lst::abi& b)
+	{
+		return a.bits_per_long == b.bits_per_long &&
+			a.long_alignment == b.long_alignment &&
+			a.uint8_t_alignment == b.uint8_t_alignment &&
+			a.uint16_t_alignment == b.uint16_t_alignment &&
+			a.uint32_t_alignment == b.uint32_t_alignment &&
+			a.uint64_t_alignment == b.uint64_t_alignment &&
+			a.byte_order == b.byte_order;
+	}
+
+	static void _remove(uint64_t tracing_id, const event_class_metadata_cache *released)
+	{
+		const std::lock_guard<std::mutex> guard(_caches_lock);
+		const auto it = _caches.find(tracing_id);
+
+		if (it != _caches.end() && it->second.cache == released) {
+			_caches.erase(it);
+		}
+	}
+
+	mutable std::mutex _lock;
+	std::unordered_multimap<std::size_t, entry> _entries;
+
+	static std::mutex _caches_lock;
+	static std::unordered_map<uint64_t, cache_ref> _caches;
+};
+
+std::mutex event_class_metadata_cache::_caches_lock;
+std::unordered_map<uint64_t, event_class_metadata_cache::cache_ref>
+	event_class_metadata_cache::_caches;
+
+/*
+ * Generates the metadata of a registry session, reusing the descriptions of
+ * the event classes which it shares.
+ */
+class event_class_sharing_visitor : public lst::trace_class_visitor {
+public:
+	explicit event_class_sharing_visitor(registry_session& session) :
+		_session(session),
+		_generating_visitor(lttng::make_unique<ls::tsdl::trace_class_visitor>(
+			session.abi,
+			[&session](const std::string& fragment) {
+				session._append_metadata_fragment(fragment);
+			}))
+	{
+	}
+
+	void visit(const lst::trace_class& trace_class) override
+	{
+		_generating_visitor->visit(trace_class);
+	}
+
+	void visit(const lst::clock_class& clock_class) override
+	{
+		_generating_visitor->visit(clock_class);
+	}
+
+	void visit(const lst::stream_class& stream_class) override
+	{
+		/* The event classes of the stream class are visited through this visitor. */
+		_generating_visitor->visit(stream_class);
+	}
+
+	void visit(const lst::event_class& event_class) override
+	{
+		_session._append_event_class_metadata(event_class, *_generating_visitor);
+	}
+
+private:
+	registry_session& _session;
+	const lst::trace_class_visitor::cuptr _generating_visitor;
+};
+} /* namespace ust */
+} /* namespace sessiond */
+} /* namespace lttng */
+
 void lsu::details::locked_registry_session_release(lsu::registry_session *session)
 {
 	pthread_mutex_unlock(&session->_lock);
@@ -247,9 +490,7 @@ lsu::registry_session::registry_session(const struct lst::abi& in_abi,
 	_app_tracer_version{ .major = major, .minor = minor },
 	_tracing_id{ tracing_id },
 	_clock{ lttng::make_unique<lsu::clock_class>() },
-	_metadata_generating_visitor{ lttng::make_unique<ls::tsdl::trace_class_visitor>(
-		abi,
-		[this](const std::string& fragment) { _append_metadata_fragment(fragment); }) },
+	_metadata_generating_visitor{ lttng::make_unique<lsu::event_class_sharing_visitor>(*this) },
 	_packet_header{ _create_packet_header() }
 {
 	pthread_mutex_init(&_lock, nullptr);
@@ -397,7 +638,6 @@ lsu::registry_session::~registry_session()
 		DIAGNOSTIC_POP
 	}
 
-	free(_metadata);
 	if (_metadata_fd >= 0) {
 		ret = close(_metadata_fd);
 		if (ret) {
@@ -608,64 +848,101 @@ uint32_t lsu::registry_session::_get_next_channel_id()
 	return _next_channel_id++;
 }
 
-void lsu::registry_session::_increase_metadata_size(size_t reservation_length)
+void lsu::registry_session::_append_metadata_fragment(const std::string& fragment)
 {
-	const auto new_len = _metadata_len + reservation_length;
-	auto new_alloc_len = new_len;
-	const auto old_alloc_len = _metadata_alloc_len;
+	_append_metadata_fragment(metadata_fragment_pool::intern(fragment));
+}
 
-	/* Rounding the new allocation length to the next power of 2 would overflow. */
-	if (new_alloc_len > (UINT32_MAX >> 1)) {
+void lsu::registry_session::_append_metadata_fragment(std::shared_ptr<const std::string> fragment)
+{
+	const auto new_len = _metadata_len + fragment->size();
+
+	/* Keep the metadata within the length which the consumer daemons expect. */
+	if (new_len > (UINT32_MAX >> 1)) {
 		LTTNG_THROW_ERROR(
 			"Failed to reserve trace metadata storage as the new size would overflow");
 	}
 
-	/* The current allocation length is already the largest we can afford. */
-	if ((old_alloc_len << 1) > (UINT32_MAX >> 1)) {
-		LTTNG_THROW_ERROR(
-			"Failed to reserve trace metadata storage as the max size was already reached");
+	_metadata_fragments.emplace_back(fragment);
+	try {
+		_metadata_fragment_ends.push_back(new_len);
+	} catch (...) {
+		_metadata_fragments.pop_back();
+		throw;
 	}
 
-	if (new_alloc_len > old_alloc_len) {
-		new_alloc_len =
-			std::max<size_t>(1U << get_count_order(new_alloc_len), old_alloc_len << 1);
+	if (_metadata_len == _metadata_len_sent) {
+		(void) lttng_clock_gettime(CLOCK_MONOTONIC, &_metadata_pending_since);
+	}
 
-		auto newptr = (char *) realloc(_metadata, new_alloc_len);
-		if (!newptr) {
-			LTTNG_THROW_POSIX("Failed to allocate trace metadata storage", errno);
-		}
+	_metadata_len = new_len;
 
-		_metadata = newptr;
+	if (_metadata_fd >= 0) {
+		const auto bytes_written =
+			lttng_write(_metadata_fd, fragment->c_str(), fragment->size());
 
-		/* We zero directly the memory from start of allocation. */
-		memset(&_metadata[old_alloc_len], 0, new_alloc_len - old_alloc_len);
-		_metadata_alloc_len = new_alloc_len;
+		if (bytes_written != fragment->size()) {
+			LTTNG_THROW_POSIX("Failed to write trace metadata fragment to file", errno);
+		}
 	}
-
-	_metadata_len += reservation_length;
 }
 
-void lsu::registry_session::_append_metadata_fragment(const std::string& fragment)
+void lsu::registry_session::_append_event_class_metadata(
+	const lst::event_class& event_class, lst::trace_class_visitor& generating_visitor)
 {
-	const auto offset = _metadata_len;
+	if (!_event_class_metadata_cache) {
+		event_class.accept(generating_visitor);
+		return;
+	}
+
+	auto description = _event_class_metadata_cache->find(abi, event_class);
+	if (description) {
+		_append_metadata_fragment(std::move(description));
+		return;
+	}
 
-	_increase_metadata_size(fragment.size());
-	memcpy(&_metadata[offset], fragment.c_str(), fragment.size());
+	const auto fragment_count = _metadata_fragments.size();
 
-	if (_metadata_fd >= 0) {
-		const auto bytes_written =
-			lttng_write(_metadata_fd, fragment.c_str(), fragment.size());
+	event_class.accept(generating_visitor);
 
-		if (bytes_written != fragment.size()) {
-			LTTNG_THROW_POSIX("Failed to write trace metadata fragment to file", errno);
-		}
+	/* The description of an event class is a single fragment. */
+	if (_metadata_fragments.size() == fragment_count + 1) {
+		_event_class_metadata_cache->add(abi, event_class, _metadata_fragments.back());
+	}
+}
+
+void lsu::registry_session::_share_event_class_metadata()
+{
+	_event_class_metadata_cache = lsu::event_class_metadata_cache::get(_tracing_id);
+}
+
+void lsu::registry_session::copy_metadata(size_t offset, size_t len, char *dest) const
+{
+	LTTNG_ASSERT(offset + len <= _metadata_len);
+
+	/* First fragment which ends after `offset`. */
+	const auto& ends = _metadata_fragment_ends;
+	auto index = std::upper_bound(ends.begin(), ends.end(), offset) - ends.begin();
+
+	while (len > 0) {
+		const auto& fragment = *_metadata_fragments[index];
+		const auto fragment_begin = _metadata_fragment_ends[index] - fragment.size();
+		const auto fragment_offset = offset - fragment_begin;
+		const auto copy_len = std::min(len, fragment.size() - fragment_offset);
+
+		memcpy(dest, fragment.data() + fragment_offset, copy_len);
+		dest += copy_len;
+		offset += copy_len;
+		len -= copy_len;
+		index++;
 	}
 }
 
 void lsu::registry_session::_reset_metadata()
 {
 	_metadata_len_sent = 0;
-	memset(_metadata, 0, _metadata_alloc_len);
+	_metadata_fragments.clear();
+	_metadata_fragment_ends.clear();
 	_metadata_len = 0;
 
 	if (_metadata_fd > 0) {
@@ -679,12 +956,52 @@ void lsu::registry_session::_generate_metadata()
 	trace_class::accept(*_metadata_generating_visitor);
 }
 
+namespace {
+/*
+ * Check whether a resampled clock describes the same clock as the current one,
+ * its offset being within the regeneration tolerance.
+ */
+bool clock_class_is_equivalent(const lst::clock_class& current, const lst::clock_class& resampled)
+{
+	if (current.name != resampled.name || current.description != resampled.description ||
+	    current.uuid != resampled.uuid || current.frequency != resampled.frequency ||
+	    current.frequency == 0) {
+		return false;
+	}
+
+	const auto offset_delta = current.offset > resampled.offset ?
+		(uint64_t) (current.offset - resampled.offset) :
+		(uint64_t) (resampled.offset - current.offset);
+
+	/* Compare in cycles to avoid overflowing the conversion to nanoseconds. */
+	const uint64_t tolerance = DEFAULT_UST_METADATA_REGENERATION_CLOCK_OFFSET_TOLERANCE_NS *
+		current.frequency / NSEC_PER_SEC;
+
+	return offset_delta <= tolerance;
+}
+} /* namespace */
+
 void lsu::registry_session::regenerate_metadata()
 {
 	lttng::pthread::lock_guard registry_lock(_lock);
 
 	/* Resample the clock */
-	_clock = lttng::make_unique<lsu::clock_class>();
+	auto resampled_clock = lttng::make_unique<lsu::clock_class>();
+
+	/*
+	 * The clock offset is the only part of the metadata which a
+	 * regeneration can change. Resetting the metadata makes the consumers,
+	 * relay daemons and viewers fetch and parse all of it again, which
+	 * is wasted when the offset didn't move.
+	 */
+	if (clock_class_is_equivalent(*_clock, *resampled_clock)) {
+		DBG_FMT("Skipping metadata regeneration of registry session, clock offset unchanged: offset={}, resampled_offset={}",
+			_clock->offset,
+			resampled_clock->offset);
+		return;
+	}
+
+	_clock = std::move(resampled_clock);
 
 	_metadata_version++;
 	_reset_metadata();
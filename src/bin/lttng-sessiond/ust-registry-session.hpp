@@ -21,13 +21,17 @@
 
 #include <cstdint>
 #include <ctime>
+#include <memory>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 namespace lttng {
 namespace sessiond {
 namespace ust {
 
+class event_class_metadata_cache;
+class event_class_sharing_visitor;
 class registry_enum;
 class registry_session;
 
@@ -63,6 +67,9 @@ public:
 
 	void regenerate_metadata();
 
+	/* Copy `len` bytes of the generated metadata, starting at `offset`. */
+	void copy_metadata(size_t offset, size_t len, char *dest) const;
+
 	~registry_session() override;
 	registry_session(const registry_session&) = delete;
 	registry_session(registry_session&&) = delete;
@@ -82,11 +89,19 @@ public:
 	 */
 	mutable pthread_mutex_t _lock;
 
-	/* Generated metadata, not null-terminated. */
-	char *_metadata = nullptr; /*  */
+	/*
+	 * Generated metadata, not null-terminated, as a sequence of fragments
+	 * shared with the other registry sessions which generated the same
+	 * ones.
+	 */
+	std::vector<std::shared_ptr<const std::string>> _metadata_fragments;
+	/* Offset of the end of each fragment in the metadata. */
+	std::vector<size_t> _metadata_fragment_ends;
 	size_t _metadata_len = 0;
 	/* Length of bytes sent to the consumer. */
 	size_t _metadata_len_sent = 0;
+	/* Generation time of the oldest metadata not sent to the consumer. */
+	struct timespec _metadata_pending_since = {};
 	/* Current version of the metadata. */
 	uint64_t _metadata_version = 0;
 
@@ -113,11 +128,21 @@ protected:
 			 uint64_t tracing_id);
 	void accept(trace::trace_class_environment_visitor& environment_visitor) const override;
 	void _generate_metadata();
+	/*
+	 * Reuse the metadata generated for the identical event classes of the
+	 * other registry sessions of the same recording session which share it.
+	 */
+	void _share_event_class_metadata();
 
 private:
+	friend event_class_sharing_visitor;
+
 	uint32_t _get_next_channel_id();
-	void _increase_metadata_size(size_t reservation_length);
 	void _append_metadata_fragment(const std::string& fragment);
+	void _append_metadata_fragment(std::shared_ptr<const std::string> fragment);
+	void _append_event_class_metadata(
+		const lttng::sessiond::trace::event_class& event_class,
+		lttng::sessiond::trace::trace_class_visitor& generating_visitor);
 	void _reset_metadata();
 	void _destroy_enum(registry_enum *reg_enum) noexcept;
 	registry_enum *_lookup_enum(const registry_enum *target_enum) const;
@@ -137,8 +162,6 @@ private:
 	/* Next enumeration ID available. */
 	uint64_t _next_enum_id = 0;
 
-	size_t _metadata_alloc_len = 0;
-
 	/*
 	 * Those fields are only used when a session is created with
 	 * the --shm-path option. In this case, the metadata is output
@@ -198,6 +221,8 @@ private:
 	const ltt_session::id_t _tracing_id;
 
 	lttng::sessiond::ust::clock_class::cuptr _clock;
+	/* Null unless the metadata of the event classes is shared. */
+	std::shared_ptr<event_class_metadata_cache> _event_class_metadata_cache;
 	const lttng::sessiond::trace::trace_class_visitor::cuptr _metadata_generating_visitor;
 	lttng::sessiond::trace::type::cuptr _packet_header;
 };
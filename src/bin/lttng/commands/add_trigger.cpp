@@ -63,6 +63,7 @@ enum {
 	OPT_CTRL_URL,
 	OPT_URL,
 	OPT_PATH,
+	OPT_INCREMENTAL,
 
 	OPT_CAPTURE,
 };
@@ -1728,6 +1729,7 @@ static const struct argpar_opt_descr snapshot_action_opt_descrs[] = {
 	{ OPT_DATA_URL, '\0', "data-url", true },
 	{ OPT_URL, '\0', "url", true },
 	{ OPT_PATH, '\0', "path", true },
+	{ OPT_INCREMENTAL, '\0', "incremental", false },
 	{ OPT_RATE_POLICY, '\0', "rate-policy", true },
 	ARGPAR_OPT_DESCR_SENTINEL
 };
@@ -1751,6 +1753,7 @@ handle_action_snapshot_session(int *argc, const char ***argv, int argc_offset)
 	struct lttng_rate_policy *policy = nullptr;
 	int ret;
 	unsigned int locations_specified = 0;
+	bool incremental = false;
 
 	argpar_iter = argpar_iter_create(*argc, *argv, snapshot_action_opt_descrs);
 	if (!argpar_iter) {
@@ -1817,6 +1820,9 @@ handle_action_snapshot_session(int *argc, const char ***argv, int argc_offset)
 					goto error;
 				}
 
+				break;
+			case OPT_INCREMENTAL:
+				incremental = true;
 				break;
 			case OPT_RATE_POLICY:
 			{
@@ -1911,6 +1917,19 @@ handle_action_snapshot_session(int *argc, const char ***argv, int argc_offset)
 		}
 	}
 
+	if (incremental) {
+		if (!snapshot_output) {
+			ERR("Can't take incremental snapshots without a snapshot output destination.");
+			goto error;
+		}
+
+		ret = lttng_snapshot_output_set_incremental(1, snapshot_output);
+		if (ret != 0) {
+			ERR("Failed to make snapshot output incremental.");
+			goto error;
+		}
+	}
+
 	if (max_size_arg) {
 		uint64_t max_size;
 
@@ -17,6 +17,7 @@
 
 #include <lttng/lttng.h>
 
+#include <algorithm>
 #include <popt.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -80,6 +81,8 @@ cmd_error_code destroy_session(const lttng_session& session)
 
 	const auto session_was_already_stopped = ret == -LTTNG_ERR_TRACE_ALREADY_STOPPED;
 	if (!opt_no_wait) {
+		unsigned int wait_time_us = DEFAULT_DATA_AVAILABILITY_MIN_WAIT_TIME_US;
+
 		do {
 			ret = lttng_data_pending(session.name);
 			if (ret < 0) {
@@ -103,7 +106,9 @@ cmd_error_code destroy_session(const lttng_session& session)
 					fflush(stdout);
 				}
 
-				usleep(DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US);
+				usleep(wait_time_us);
+				wait_time_us = std::min<unsigned int>(
+					wait_time_us * 2, DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US);
 				_MSG(".");
 				fflush(stdout);
 			}
@@ -41,6 +41,20 @@ static struct {
 	bool set;
 	int64_t value;
 } opt_blocking_timeout;
+static struct {
+	bool set;
+	enum lttng_channel_writeback_policy policy;
+	uint64_t window_size;
+} opt_writeback;
+static struct {
+	bool set;
+	uint32_t max_subbuffers;
+	uint64_t max_bytes;
+} opt_drain_batch;
+static struct {
+	bool set;
+	enum lttng_channel_buffer_page_size page_size;
+} opt_buffer_page_size;
 
 static struct mi_writer *writer;
 
@@ -64,6 +78,9 @@ enum {
 	OPT_TRACEFILE_SIZE,
 	OPT_TRACEFILE_COUNT,
 	OPT_BLOCKING_TIMEOUT,
+	OPT_WRITEBACK,
+	OPT_DRAIN_BATCH,
+	OPT_BUFFER_PAGE_SIZE,
 };
 
 static struct lttng_handle *handle;
@@ -92,6 +109,9 @@ static struct poptOption long_options[] = {
 	{ "tracefile-size", 'C', POPT_ARG_INT, nullptr, OPT_TRACEFILE_SIZE, nullptr, nullptr },
 	{ "tracefile-count", 'W', POPT_ARG_INT, nullptr, OPT_TRACEFILE_COUNT, nullptr, nullptr },
 	{ "blocking-timeout", 0, POPT_ARG_INT, nullptr, OPT_BLOCKING_TIMEOUT, nullptr, nullptr },
+	{ "writeback", 0, POPT_ARG_STRING, nullptr, OPT_WRITEBACK, nullptr, nullptr },
+	{ "drain-batch", 0, POPT_ARG_STRING, nullptr, OPT_DRAIN_BATCH, nullptr, nullptr },
+	{ "buffer-page-size", 0, POPT_ARG_STRING, nullptr, OPT_BUFFER_PAGE_SIZE, nullptr, nullptr },
 	{ nullptr, 0, 0, nullptr, 0, nullptr, nullptr }
 };
 
@@ -153,6 +173,12 @@ static int enable_channel(char *session_name, char *channel_list)
 			ret = CMD_ERROR;
 			goto error;
 		}
+		if (opt_buffer_page_size.set &&
+		    opt_buffer_page_size.page_size != LTTNG_CHANNEL_BUFFER_PAGE_SIZE_BASE) {
+			ERR("Huge buffer pages not supported for kernel domain (-k)");
+			ret = CMD_ERROR;
+			goto error;
+		}
 	}
 
 	/* Create lttng domain */
@@ -278,6 +304,33 @@ static int enable_channel(char *session_name, char *channel_list)
 				goto error;
 			}
 		}
+		if (opt_writeback.set) {
+			ret = lttng_channel_set_writeback_policy(
+				channel, opt_writeback.policy, opt_writeback.window_size);
+			if (ret) {
+				ERR("Failed to set the channel's writeback policy");
+				error = 1;
+				goto error;
+			}
+		}
+		if (opt_drain_batch.set) {
+			ret = lttng_channel_set_drain_batch(
+				channel, opt_drain_batch.max_subbuffers, opt_drain_batch.max_bytes);
+			if (ret) {
+				ERR("Failed to set the channel's drain batch");
+				error = 1;
+				goto error;
+			}
+		}
+		if (opt_buffer_page_size.set) {
+			ret = lttng_channel_set_buffer_page_size(channel,
+								 opt_buffer_page_size.page_size);
+			if (ret) {
+				ERR("Failed to set the channel's buffer page size");
+				error = 1;
+				goto error;
+			}
+		}
 
 		DBG("Enabling channel %s", channel_name);
 
@@ -619,6 +672,88 @@ int cmd_enable_channels(int argc, const char **argv)
 			    opt_blocking_timeout.value == 0 ? " (non-blocking)" : "");
 			break;
 		}
+		case OPT_WRITEBACK:
+		{
+			const char *const async_prefix = "async:";
+
+			opt_arg = poptGetOptArg(pc);
+			if (!strcmp(opt_arg, "sync")) {
+				opt_writeback.policy = LTTNG_CHANNEL_WRITEBACK_POLICY_SYNC;
+				opt_writeback.window_size = 0;
+			} else if (!strcmp(opt_arg, "none")) {
+				opt_writeback.policy = LTTNG_CHANNEL_WRITEBACK_POLICY_NONE;
+				opt_writeback.window_size = 0;
+			} else if (!strncmp(opt_arg, async_prefix, strlen(async_prefix))) {
+				if (utils_parse_size_suffix(opt_arg + strlen(async_prefix),
+							    &opt_writeback.window_size) < 0 ||
+				    opt_writeback.window_size == 0) {
+					ERR("Wrong window size in --writeback parameter: %s",
+					    opt_arg);
+					ret = CMD_ERROR;
+					goto end;
+				}
+				opt_writeback.policy = LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW;
+			} else {
+				ERR("Wrong value in --writeback parameter: %s. Possible values are: %s",
+				    opt_arg,
+				    "sync, none, async:SIZE");
+				ret = CMD_ERROR;
+				goto end;
+			}
+
+			opt_writeback.set = true;
+			DBG("Channel writeback policy set to %s", opt_arg);
+			break;
+		}
+		case OPT_DRAIN_BATCH:
+		{
+			char *end;
+			unsigned long long max_subbuffers;
+
+			errno = 0;
+			opt_arg = poptGetOptArg(pc);
+			max_subbuffers = strtoull(opt_arg, &end, 10);
+			if (errno != 0 || !isdigit(opt_arg[0]) || max_subbuffers == 0 ||
+			    max_subbuffers > UINT32_MAX || (*end != '\0' && *end != ':')) {
+				ERR("Wrong value in --drain-batch parameter: %s", opt_arg);
+				ret = CMD_ERROR;
+				goto end;
+			}
+
+			opt_drain_batch.max_subbuffers = (uint32_t) max_subbuffers;
+			opt_drain_batch.max_bytes = 0;
+			if (*end == ':' &&
+			    utils_parse_size_suffix(end + 1, &opt_drain_batch.max_bytes) < 0) {
+				ERR("Wrong size in --drain-batch parameter: %s", opt_arg);
+				ret = CMD_ERROR;
+				goto end;
+			}
+
+			opt_drain_batch.set = true;
+			DBG("Channel drain batch set to %" PRIu32 " sub-buffers, %" PRIu64 " bytes",
+			    opt_drain_batch.max_subbuffers,
+			    opt_drain_batch.max_bytes);
+			break;
+		}
+		case OPT_BUFFER_PAGE_SIZE:
+			opt_arg = poptGetOptArg(pc);
+			if (!strcmp(opt_arg, "base")) {
+				opt_buffer_page_size.page_size =
+					LTTNG_CHANNEL_BUFFER_PAGE_SIZE_BASE;
+			} else if (!strcmp(opt_arg, "huge")) {
+				opt_buffer_page_size.page_size =
+					LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE;
+			} else {
+				ERR("Wrong value in --buffer-page-size parameter: %s. Possible values are: %s",
+				    opt_arg,
+				    "base, huge");
+				ret = CMD_ERROR;
+				goto end;
+			}
+
+			opt_buffer_page_size.set = true;
+			DBG("Channel buffer page size set to %s", opt_arg);
+			break;
 		case OPT_USERSPACE:
 			opt_userspace = 1;
 			break;
@@ -32,6 +32,7 @@ static char *opt_channel;
 static int opt_domain;
 static int opt_fields;
 static int opt_syscall;
+static int opt_stats;
 
 const char *indent4 = "    ";
 const char *indent6 = "      ";
@@ -55,6 +56,12 @@ static struct mi_writer *the_writer;
 /* Only set when listing a single session. */
 static struct lttng_session the_listed_session;
 
+/*
+ * Description of the listed session, only set when listing all its domains
+ * from a session daemon which can describe it with a single command.
+ */
+static struct lttng_session_description *the_description;
+
 static struct poptOption long_options[] = {
 	/* longName, shortName, argInfo, argPtr, value, descrip, argDesc */
 	{ "help", 'h', POPT_ARG_NONE, nullptr, OPT_HELP, nullptr, nullptr },
@@ -67,6 +74,7 @@ static struct poptOption long_options[] = {
 	{ "domain", 'd', POPT_ARG_VAL, &opt_domain, 1, nullptr, nullptr },
 	{ "fields", 'f', POPT_ARG_VAL, &opt_fields, 1, nullptr, nullptr },
 	{ "syscall", 'S', POPT_ARG_VAL, &opt_syscall, 1, nullptr, nullptr },
+	{ "stats", 0, POPT_ARG_VAL, &opt_stats, 1, nullptr, nullptr },
 	{ "list-options", 0, POPT_ARG_NONE, nullptr, OPT_LIST_OPTIONS, nullptr, nullptr },
 	{ nullptr, 0, 0, nullptr, 0, nullptr, nullptr }
 };
@@ -519,6 +527,12 @@ mi_list_agent_ust_events(struct lttng_event *events, int count, struct lttng_dom
 					goto end;
 				}
 				pid_element_open = 0;
+
+				/* Emit the complete pid element. */
+				ret = mi_lttng_writer_flush(the_writer);
+				if (ret) {
+					goto end;
+				}
 			}
 
 			cur_pid = events[i].pid;
@@ -764,6 +778,12 @@ mi_list_ust_event_fields(struct lttng_event_field *fields, int count, struct ltt
 					goto end;
 				}
 				pid_element_open = 0;
+
+				/* Emit the complete pid element. */
+				ret = mi_lttng_writer_flush(the_writer);
+				if (ret) {
+					goto end;
+				}
 			}
 
 			cur_pid = fields[i].event.pid;
@@ -1084,6 +1104,42 @@ error:
 	return ret;
 }
 
+/*
+ * List the events of a channel of the domain of the handle, from the
+ * description of the session if it was retrieved.
+ *
+ * The events must be freed by the caller if `*owned` is set.
+ */
+static int get_events(const char *channel_name, struct lttng_event **events, bool *owned)
+{
+	if (the_description) {
+		*owned = false;
+		return lttng_session_description_get_events(
+			the_description, the_handle->domain.type, channel_name, events);
+	}
+
+	*owned = true;
+	return lttng_list_events(the_handle, channel_name, events);
+}
+
+/*
+ * List the channels of the domain of the handle, from the description of
+ * the session if it was retrieved.
+ *
+ * The channels must be freed by the caller if `*owned` is set.
+ */
+static int get_channels(struct lttng_channel **channels, bool *owned)
+{
+	if (the_description) {
+		*owned = false;
+		return lttng_session_description_get_channels(
+			the_description, the_handle->domain.type, channels);
+	}
+
+	*owned = true;
+	return lttng_list_channels(the_handle, channels);
+}
+
 /*
  * Machine Interface
  * Print a list of agent events
@@ -1121,8 +1177,9 @@ static int list_session_agent_events()
 {
 	int ret = CMD_SUCCESS, count, i;
 	struct lttng_event *events = nullptr;
+	bool events_owned;
 
-	count = lttng_list_events(the_handle, "", &events);
+	count = get_events("", &events, &events_owned);
 	if (count < 0) {
 		ret = CMD_ERROR;
 		ERR("%s", lttng_strerror(count));
@@ -1181,7 +1238,9 @@ static int list_session_agent_events()
 	}
 
 end:
-	free(events);
+	if (events_owned) {
+		free(events);
+	}
 error:
 	return ret;
 }
@@ -1221,8 +1280,9 @@ static int list_events(const char *channel_name)
 {
 	int ret = CMD_SUCCESS, count, i;
 	struct lttng_event *events = nullptr;
+	bool events_owned;
 
-	count = lttng_list_events(the_handle, channel_name, &events);
+	count = get_events(channel_name, &events, &events_owned);
 	if (count < 0) {
 		ret = CMD_ERROR;
 		ERR("%s", lttng_strerror(count));
@@ -1251,7 +1311,9 @@ static int list_events(const char *channel_name)
 		MSG("");
 	}
 end:
-	free(events);
+	if (events_owned) {
+		free(events);
+	}
 error:
 	return ret;
 }
@@ -1272,14 +1334,44 @@ static void print_timer(const char *timer_name, uint32_t space_count, int64_t va
 	}
 }
 
+/*
+ * Pretty print the non-empty buckets of a consumption histogram.
+ */
+static void
+print_consumption_histogram(const char *title, const char *unit, const uint64_t *buckets)
+{
+	unsigned int i;
+	bool empty = true;
+
+	MSG("%s%s:", indent6, title);
+	for (i = 0; i < LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT; i++) {
+		if (buckets[i] == 0) {
+			continue;
+		}
+
+		MSG("%s[%" PRIu64 ", %" PRIu64 ") %s: %" PRIu64,
+		    indent8,
+		    i == 0 ? 0 : UINT64_C(1) << i,
+		    UINT64_C(1) << (i + 1),
+		    unit,
+		    buckets[i]);
+		empty = false;
+	}
+
+	if (empty) {
+		MSG("%sNone", indent8);
+	}
+}
+
 /*
  * Pretty print channel
  */
 static void print_channel(struct lttng_channel *channel)
 {
 	int ret;
-	uint64_t discarded_events, lost_packets, monitor_timer_interval;
+	uint64_t discarded_events, lost_packets, monitor_timer_interval, buffer_page_size;
 	int64_t blocking_timeout;
+	enum lttng_channel_buffer_page_size buffer_page_size_type;
 
 	ret = lttng_channel_get_discarded_event_count(channel, &discarded_events);
 	if (ret) {
@@ -1305,11 +1397,22 @@ static void print_channel(struct lttng_channel *channel)
 		return;
 	}
 
+	ret = lttng_channel_get_buffer_page_size(
+		channel, &buffer_page_size_type, &buffer_page_size);
+	if (ret) {
+		ERR("Failed to retrieve buffer page size of channel");
+		return;
+	}
+
 	MSG("- %s:%s\n", channel->name, enabled_string(channel->enabled));
 	MSG("%sAttributes:", indent4);
 	MSG("%sEvent-loss mode:  %s", indent6, channel->attr.overwrite ? "overwrite" : "discard");
 	MSG("%sSub-buffer size:  %" PRIu64 " bytes", indent6, channel->attr.subbuf_size);
 	MSG("%sSub-buffer count: %" PRIu64, indent6, channel->attr.num_subbuf);
+	MSG("%sPage size:        %" PRIu64 " bytes (%s)",
+	    indent6,
+	    buffer_page_size,
+	    buffer_page_size_type == LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE ? "huge" : "base");
 
 	print_timer("Switch timer", 5, channel->attr.switch_timer_interval);
 	print_timer("Read timer", 7, channel->attr.read_timer_interval);
@@ -1367,6 +1470,51 @@ static void print_channel(struct lttng_channel *channel)
 	} else {
 		MSG("%sLost packets:     %" PRIu64, indent6, lost_packets);
 	}
+
+	if (opt_stats) {
+		uint64_t buckets[LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT];
+		uint64_t spilled_size;
+
+		ret = lttng_channel_get_consumption_latency_histogram(channel, buckets);
+		if (ret) {
+			ERR("Failed to retrieve consumption latency histogram of channel");
+			return;
+		}
+
+		print_consumption_histogram("Consumption latency", USEC_UNIT, buckets);
+
+		ret = lttng_channel_get_consumption_size_histogram(channel, buckets);
+		if (ret) {
+			ERR("Failed to retrieve consumption size histogram of channel");
+			return;
+		}
+
+		print_consumption_histogram("Consumed sub-buffer size", "bytes", buckets);
+
+		if (channel->attr.output == LTTNG_EVENT_SPLICE) {
+			uint64_t splice_pipe_size;
+
+			ret = lttng_channel_get_splice_pipe_size(channel, &splice_pipe_size);
+			if (ret) {
+				ERR("Failed to retrieve splice pipe size of channel");
+				return;
+			}
+
+			MSG("%sSplice pipe size: %" PRIu64 " bytes", indent6, splice_pipe_size);
+		}
+
+		ret = lttng_channel_get_relayd_spilled_size(channel, &spilled_size);
+		if (ret) {
+			ERR("Failed to retrieve relay daemon spilled size of channel");
+			return;
+		}
+
+		if (spilled_size) {
+			MSG("%sSpilled while the relay daemon was congested: %" PRIu64 " bytes",
+			    indent6,
+			    spilled_size);
+		}
+	}
 skip_stats_printing:
 	return;
 }
@@ -1414,6 +1562,15 @@ static int mi_list_channels(struct lttng_channel *channels, int count, const cha
 			goto error;
 		}
 
+		/*
+		 * Emit the channel and its events before retrieving the events of
+		 * the next one.
+		 */
+		ret = mi_lttng_writer_flush(the_writer);
+		if (ret) {
+			goto error;
+		}
+
 		if (chan_found) {
 			break;
 		}
@@ -1439,10 +1596,11 @@ static int list_channels(const char *channel_name)
 	int count, i, ret = CMD_SUCCESS;
 	unsigned int chan_found = 0;
 	struct lttng_channel *channels = nullptr;
+	bool channels_owned;
 
 	DBG("Listing channel(s) (%s)", channel_name ?: "<all>");
 
-	count = lttng_list_channels(the_handle, &channels);
+	count = get_channels(&channels, &channels_owned);
 	if (count < 0) {
 		switch (-count) {
 		case LTTNG_ERR_KERN_CHAN_NOT_FOUND:
@@ -1505,7 +1663,9 @@ static int list_channels(const char *channel_name)
 		}
 	}
 error:
-	free(channels);
+	if (channels_owned) {
+		free(channels);
+	}
 
 error_channels:
 	return ret;
@@ -2255,6 +2415,7 @@ int cmd_list(int argc, const char **argv)
 	static poptContext pc;
 	struct lttng_domain domain;
 	struct lttng_domain *domains = nullptr;
+	bool persistent_connection = false;
 
 	memset(&domain, 0, sizeof(domain));
 
@@ -2337,6 +2498,15 @@ int cmd_list(int argc, const char **argv)
 		goto end;
 	}
 
+	/*
+	 * Besides the session description, listing a session takes tracker and
+	 * rotation schedule queries, and a query per domain and per channel
+	 * without the description: send them over a single connection to the
+	 * session daemon rather than connecting for each of them. Without
+	 * support for persistent connections, each query connects on its own.
+	 */
+	persistent_connection = lttng_session_daemon_connection_open() == 0;
+
 	if (opt_kernel || opt_userspace || opt_jul || opt_log4j || opt_python) {
 		the_handle = lttng_create_handle(arg_session_name, &domain);
 		if (the_handle == nullptr) {
@@ -2449,9 +2619,24 @@ int cmd_list(int argc, const char **argv)
 
 		} else {
 			int i, nb_domain;
+			struct lttng_domain *listed_domains;
+
+			/*
+			 * We want all domain(s): describe the session with a single
+			 * command, or list its domains, channels and events one by one
+			 * if the session daemon doesn't support it.
+			 */
+			ret = lttng_describe_session(arg_session_name, &the_description);
+			if (ret == 0) {
+				nb_domain = lttng_session_description_get_domains(the_description,
+										  &listed_domains);
+			} else if (ret == -LTTNG_ERR_UND) {
+				nb_domain = lttng_list_domains(arg_session_name, &domains);
+				listed_domains = domains;
+			} else {
+				nb_domain = ret;
+			}
 
-			/* We want all domain(s) */
-			nb_domain = lttng_list_domains(arg_session_name, &domains);
 			if (nb_domain < 0) {
 				ret = CMD_ERROR;
 				ERR("%s", lttng_strerror(nb_domain));
@@ -2467,14 +2652,14 @@ int cmd_list(int argc, const char **argv)
 			}
 
 			for (i = 0; i < nb_domain; i++) {
-				switch (domains[i].type) {
+				switch (listed_domains[i].type) {
 				case LTTNG_DOMAIN_KERNEL:
 					MSG("=== Domain: Linux kernel ===\n");
 					break;
 				case LTTNG_DOMAIN_UST:
 					MSG("=== Domain: User space ===\n");
 					MSG("Buffering scheme: %s\n",
-					    domains[i].buf_type == LTTNG_BUFFER_PER_PID ?
+					    listed_domains[i].buf_type == LTTNG_BUFFER_PER_PID ?
 						    "per-process" :
 						    "per-user");
 					break;
@@ -2493,7 +2678,7 @@ int cmd_list(int argc, const char **argv)
 				}
 
 				if (lttng_opt_mi) {
-					ret = mi_lttng_domain(the_writer, &domains[i], 1);
+					ret = mi_lttng_domain(the_writer, &listed_domains[i], 1);
 					if (ret) {
 						ret = CMD_ERROR;
 						goto end;
@@ -2505,15 +2690,16 @@ int cmd_list(int argc, const char **argv)
 					lttng_destroy_handle(the_handle);
 				}
 
-				the_handle = lttng_create_handle(arg_session_name, &domains[i]);
+				the_handle =
+					lttng_create_handle(arg_session_name, &listed_domains[i]);
 				if (the_handle == nullptr) {
 					ret = CMD_FATAL;
 					goto end;
 				}
 
-				if (domains[i].type == LTTNG_DOMAIN_JUL ||
-				    domains[i].type == LTTNG_DOMAIN_LOG4J ||
-				    domains[i].type == LTTNG_DOMAIN_PYTHON) {
+				if (listed_domains[i].type == LTTNG_DOMAIN_JUL ||
+				    listed_domains[i].type == LTTNG_DOMAIN_LOG4J ||
+				    listed_domains[i].type == LTTNG_DOMAIN_PYTHON) {
 					ret = list_session_agent_events();
 					if (ret) {
 						goto end;
@@ -2522,10 +2708,10 @@ int cmd_list(int argc, const char **argv)
 					goto next_domain;
 				}
 
-				switch (domains[i].type) {
+				switch (listed_domains[i].type) {
 				case LTTNG_DOMAIN_KERNEL:
 				case LTTNG_DOMAIN_UST:
-					ret = list_trackers(&domains[i]);
+					ret = list_trackers(&listed_domains[i]);
 					if (ret) {
 						goto end;
 					}
@@ -2584,10 +2770,15 @@ end:
 	}
 
 	free(domains);
+	lttng_session_description_destroy(the_description);
 	if (the_handle) {
 		lttng_destroy_handle(the_handle);
 	}
 
+	if (persistent_connection) {
+		lttng_session_daemon_connection_close();
+	}
+
 	poptFreeContext(pc);
 	return ret;
 }
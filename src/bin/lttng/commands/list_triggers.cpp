@@ -11,6 +11,7 @@
 #include "common/dynamic-array.hpp"
 #include "common/mi-lttng.hpp"
 #include "lttng/action/list-internal.hpp"
+#include "lttng/condition/channel-rate-internal.hpp"
 
 /* For lttng_condition_type_str(). */
 #include "lttng/condition/condition-internal.hpp"
@@ -105,6 +106,40 @@ static void print_condition_buffer_usage(const struct lttng_condition *condition
 	}
 }
 
+static void print_condition_channel_rate(const struct lttng_condition *condition)
+{
+	enum lttng_condition_status condition_status;
+	const char *session_name, *channel_name;
+	enum lttng_domain_type domain_type;
+	enum lttng_condition_channel_rate_statistic statistic;
+	uint64_t threshold, window_us;
+
+	condition_status = lttng_condition_channel_rate_get_session_name(condition, &session_name);
+	LTTNG_ASSERT(condition_status == LTTNG_CONDITION_STATUS_OK);
+
+	condition_status = lttng_condition_channel_rate_get_channel_name(condition, &channel_name);
+	LTTNG_ASSERT(condition_status == LTTNG_CONDITION_STATUS_OK);
+
+	condition_status = lttng_condition_channel_rate_get_domain_type(condition, &domain_type);
+	LTTNG_ASSERT(condition_status == LTTNG_CONDITION_STATUS_OK);
+
+	condition_status = lttng_condition_channel_rate_get_statistic(condition, &statistic);
+	LTTNG_ASSERT(condition_status == LTTNG_CONDITION_STATUS_OK);
+
+	condition_status = lttng_condition_channel_rate_get_threshold(condition, &threshold);
+	LTTNG_ASSERT(condition_status == LTTNG_CONDITION_STATUS_OK);
+
+	condition_status = lttng_condition_channel_rate_get_window(condition, &window_us);
+	LTTNG_ASSERT(condition_status == LTTNG_CONDITION_STATUS_OK);
+
+	MSG("    session name: %s", session_name);
+	MSG("    channel name: %s", channel_name);
+	MSG("    domain: %s", lttng_domain_type_str(domain_type));
+	MSG("    statistic: %s", lttng_condition_channel_rate_statistic_str(statistic));
+	MSG("    threshold (per second): %" PRIu64, threshold);
+	MSG("    window (us): %" PRIu64, window_us);
+}
+
 static void print_condition_session_rotation(const struct lttng_condition *condition)
 {
 	enum lttng_condition_status condition_status;
@@ -600,7 +635,7 @@ static void print_indentation(unsigned int indentation_level)
 	}
 }
 
-static void print_error_query_results(struct lttng_error_query_results *results,
+static void print_error_query_results(const struct lttng_error_query_results *results,
 				      unsigned int base_indentation_level)
 {
 	unsigned int i, count, printed_errors_count = 0;
@@ -933,15 +968,26 @@ end:
 	lttng_error_query_results_destroy(results);
 }
 
-static void print_condition_errors(const struct lttng_trigger *trigger)
+/*
+ * Print the errors of the condition of a trigger, querying them unless
+ * `results`, the result set of a previous condition error query, is set.
+ */
+static void print_condition_errors(const struct lttng_trigger *trigger,
+				   const struct lttng_error_query_results *results)
 {
 	enum lttng_error_code error_query_ret;
-	struct lttng_error_query_results *results = nullptr;
+	struct lttng_error_query_results *queried_results = nullptr;
 	enum lttng_trigger_status trigger_status;
 	const char *trigger_name;
 	uid_t trigger_uid;
-	struct lttng_error_query *query = lttng_error_query_condition_create(trigger);
+	struct lttng_error_query *query = nullptr;
 
+	if (results) {
+		print_error_query_results(results, 2);
+		goto end;
+	}
+
+	query = lttng_error_query_condition_create(trigger);
 	LTTNG_ASSERT(query);
 	/*
 	 * Anonymous triggers are not listed; this would be an internal error.
@@ -952,8 +998,8 @@ static void print_condition_errors(const struct lttng_trigger *trigger)
 	trigger_status = lttng_trigger_get_owner_uid(trigger, &trigger_uid);
 	LTTNG_ASSERT(trigger_status == LTTNG_TRIGGER_STATUS_OK);
 
-	error_query_ret =
-		lttng_error_query_execute(query, lttng_session_daemon_command_endpoint, &results);
+	error_query_ret = lttng_error_query_execute(
+		query, lttng_session_daemon_command_endpoint, &queried_results);
 	if (error_query_ret != LTTNG_OK) {
 		ERR("Failed to query errors of condition of trigger '%s' (owner uid: %d): %s",
 		    trigger_name,
@@ -962,15 +1008,16 @@ static void print_condition_errors(const struct lttng_trigger *trigger)
 		goto end;
 	}
 
-	print_error_query_results(results, 2);
+	print_error_query_results(queried_results, 2);
 
 end:
 	MSG("");
 	lttng_error_query_destroy(query);
-	lttng_error_query_results_destroy(results);
+	lttng_error_query_results_destroy(queried_results);
 }
 
-static void print_one_trigger(const struct lttng_trigger *trigger)
+static void print_one_trigger(const struct lttng_trigger *trigger,
+			      const struct lttng_error_query_results *condition_error_results)
 {
 	const struct lttng_condition *condition;
 	enum lttng_condition_type condition_type;
@@ -1008,6 +1055,10 @@ static void print_one_trigger(const struct lttng_trigger *trigger)
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_LOW:
 		print_condition_buffer_usage(condition);
 		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+		print_condition_channel_rate(condition);
+		break;
 	case LTTNG_CONDITION_TYPE_SESSION_ROTATION_ONGOING:
 	case LTTNG_CONDITION_TYPE_SESSION_ROTATION_COMPLETED:
 		print_condition_session_rotation(condition);
@@ -1019,7 +1070,7 @@ static void print_one_trigger(const struct lttng_trigger *trigger)
 		abort();
 	}
 
-	print_condition_errors(trigger);
+	print_condition_errors(trigger, condition_error_results);
 
 	action = lttng_trigger_get_const_action(trigger);
 	action_type = lttng_action_get_type(action);
@@ -1059,6 +1110,63 @@ static int compare_triggers_by_name(const void *a, const void *b)
 	return strcmp(name_a, name_b);
 }
 
+/*
+ * Query the errors of the conditions of triggers with a single command.
+ *
+ * Return the result sets, one per trigger, or NULL if they can't be queried
+ * at once, in which case the errors of each condition are queried when
+ * printing it.
+ */
+static struct lttng_error_query_results **
+query_condition_errors(const struct lttng_dynamic_pointer_array *triggers)
+{
+	enum lttng_error_code error_query_ret;
+	const unsigned int count = lttng_dynamic_pointer_array_get_count(triggers);
+	struct lttng_error_query **queries = nullptr;
+	struct lttng_error_query_results **results = nullptr;
+	unsigned int i;
+
+	if (count == 0) {
+		goto end;
+	}
+
+	queries = calloc<lttng_error_query *>(count);
+	results = calloc<lttng_error_query_results *>(count);
+	if (!queries || !results) {
+		goto error;
+	}
+
+	for (i = 0; i < count; i++) {
+		queries[i] = lttng_error_query_condition_create(
+			(const struct lttng_trigger *) lttng_dynamic_pointer_array_get_pointer(
+				triggers, i));
+		if (!queries[i]) {
+			goto error;
+		}
+	}
+
+	error_query_ret = lttng_error_queries_execute(
+		queries, count, lttng_session_daemon_command_endpoint, results);
+	if (error_query_ret != LTTNG_OK) {
+		goto error;
+	}
+
+	goto end;
+
+error:
+	free(results);
+	results = nullptr;
+end:
+	if (queries) {
+		for (i = 0; i < count; i++) {
+			lttng_error_query_destroy(queries[i]);
+		}
+	}
+
+	free(queries);
+	return results;
+}
+
 static int print_sorted_triggers(const struct lttng_triggers *triggers)
 {
 	int ret;
@@ -1066,6 +1174,7 @@ static int print_sorted_triggers(const struct lttng_triggers *triggers)
 	struct lttng_dynamic_pointer_array sorted_triggers;
 	enum lttng_trigger_status trigger_status;
 	unsigned int num_triggers;
+	struct lttng_error_query_results **condition_error_results = nullptr;
 
 	lttng_dynamic_pointer_array_init(&sorted_triggers, nullptr);
 
@@ -1104,12 +1213,15 @@ static int print_sorted_triggers(const struct lttng_triggers *triggers)
 	      sizeof(struct lttng_trigger *),
 	      compare_triggers_by_name);
 
+	condition_error_results = query_condition_errors(&sorted_triggers);
+
 	for (i = 0; i < lttng_dynamic_pointer_array_get_count(&sorted_triggers); i++) {
 		const struct lttng_trigger *trigger_to_print =
 			(const struct lttng_trigger *) lttng_dynamic_pointer_array_get_pointer(
 				&sorted_triggers, i);
 
-		print_one_trigger(trigger_to_print);
+		print_one_trigger(trigger_to_print,
+				  condition_error_results ? condition_error_results[i] : nullptr);
 	}
 
 	ret = 0;
@@ -1118,6 +1230,14 @@ error:
 	ret = 1;
 
 end:
+	if (condition_error_results) {
+		for (i = 0; i < lttng_dynamic_pointer_array_get_count(&sorted_triggers); i++) {
+			lttng_error_query_results_destroy(condition_error_results[i]);
+		}
+
+		free(condition_error_results);
+	}
+
 	lttng_dynamic_pointer_array_reset(&sorted_triggers);
 	return ret;
 }
@@ -12,6 +12,7 @@
 #include <common/sessiond-comm/sessiond-comm.hpp>
 
 #include <lttng/lttng.h>
+#include <lttng/rotate-internal.hpp>
 
 #include <ctype.h>
 #include <inttypes.h>
@@ -45,6 +46,37 @@ static struct poptOption long_options[] = {
 	{ nullptr, 0, 0, nullptr, 0, nullptr, nullptr }
 };
 
+/*
+ * Get the durations of the phases of a completed rotation.
+ *
+ * Returns true if they are available.
+ */
+static bool get_phase_durations(struct lttng_rotation_handle *handle,
+				uint64_t phase_durations_us[LTTNG_ROTATION_PHASE_COUNT])
+{
+	for (int phase = 0; phase < LTTNG_ROTATION_PHASE_COUNT; phase++) {
+		const auto status = lttng_rotation_handle_get_phase_duration(
+			handle, (enum lttng_rotation_phase) phase, &phase_durations_us[phase]);
+
+		if (status != LTTNG_ROTATION_STATUS_OK) {
+			DBG("Failed to get the duration of rotation phase %d", phase);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void print_phase_durations(const uint64_t phase_durations_us[LTTNG_ROTATION_PHASE_COUNT])
+{
+	MSG("Rotation phase durations: create trace chunk %" PRIu64 " us, rotate streams %" PRIu64
+	    " us, close trace chunk %" PRIu64 " us, wait for data %" PRIu64 " us",
+	    phase_durations_us[LTTNG_ROTATION_PHASE_CREATE_TRACE_CHUNK],
+	    phase_durations_us[LTTNG_ROTATION_PHASE_ROTATE_STREAMS],
+	    phase_durations_us[LTTNG_ROTATION_PHASE_CLOSE_TRACE_CHUNK],
+	    phase_durations_us[LTTNG_ROTATION_PHASE_WAIT_DATA]);
+}
+
 static int rotate_tracing(char *session_name)
 {
 	int ret;
@@ -54,6 +86,8 @@ static int rotate_tracing(char *session_name)
 	enum lttng_rotation_state rotation_state = LTTNG_ROTATION_STATE_ONGOING;
 	const struct lttng_trace_archive_location *location = nullptr;
 	bool print_location = true;
+	uint64_t phase_durations_us[LTTNG_ROTATION_PHASE_COUNT];
+	bool has_phase_durations = false;
 
 	DBG("Rotating the output files of session %s", session_name);
 
@@ -115,6 +149,8 @@ skip_wait:
 			ERR("Failed to retrieve the rotation's completed chunk archive location.");
 			cmd_ret = CMD_ERROR;
 		}
+
+		has_phase_durations = get_phase_durations(handle, phase_durations_us);
 		break;
 	case LTTNG_ROTATION_STATE_EXPIRED:
 		break;
@@ -132,8 +168,15 @@ skip_wait:
 
 	if (!lttng_opt_mi && print_location) {
 		ret = print_trace_archive_location(location, session_name);
+		if (has_phase_durations && lttng_opt_verbose) {
+			print_phase_durations(phase_durations_us);
+		}
 	} else if (lttng_opt_mi) {
-		ret = mi_lttng_rotate(writer, session_name, rotation_state, location);
+		ret = mi_lttng_rotate(writer,
+				      session_name,
+				      rotation_state,
+				      location,
+				      has_phase_durations ? phase_durations_us : nullptr);
 	}
 
 	if (ret < 0) {
@@ -28,6 +28,7 @@ static const char *opt_data_url;
 static const char *opt_ctrl_url;
 static const char *current_session_name;
 static uint64_t opt_max_size;
+static int opt_incremental;
 
 /* Stub for the cmd struct actions. */
 static int cmd_add_output(int argc, const char **argv);
@@ -60,6 +61,7 @@ static struct poptOption snapshot_opts[] = {
 	{ "data-url", 'D', POPT_ARG_STRING, &opt_data_url, 0, nullptr, nullptr },
 	{ "name", 'n', POPT_ARG_STRING, &opt_output_name, 0, nullptr, nullptr },
 	{ "max-size", 'm', POPT_ARG_STRING, nullptr, OPT_MAX_SIZE, nullptr, nullptr },
+	{ "incremental", 0, POPT_ARG_VAL, &opt_incremental, 1, nullptr, nullptr },
 	{ "list-options", 0, POPT_ARG_NONE, nullptr, OPT_LIST_OPTIONS, nullptr, nullptr },
 	{ "list-commands", 0, POPT_ARG_NONE, nullptr, OPT_LIST_COMMANDS, nullptr, nullptr },
 	{ nullptr, 0, 0, nullptr, 0, nullptr, nullptr }
@@ -413,6 +415,11 @@ static int record(const char *url)
 		goto error;
 	}
 
+	ret = lttng_snapshot_output_set_incremental(opt_incremental, output);
+	if (ret < 0) {
+		goto error;
+	}
+
 	ret = lttng_snapshot_record(current_session_name, output, 0);
 	if (ret < 0) {
 		if (ret == -LTTNG_ERR_MAX_SIZE_INVALID) {
@@ -29,16 +29,20 @@ enum {
 	OPT_LIST_OPTIONS,
 };
 
+static int opt_stats;
+
 static struct poptOption long_options[] = {
 	/* longName, shortName, argInfo, argPtr, value, descrip, argDesc */
 	{ "help", 'h', POPT_ARG_NONE, nullptr, OPT_HELP, nullptr, nullptr },
+	{ "stats", 0, POPT_ARG_VAL, &opt_stats, 1, nullptr, nullptr },
 	{ "list-options", 0, POPT_ARG_NONE, nullptr, OPT_LIST_OPTIONS, nullptr, nullptr },
 	{ nullptr, 0, 0, nullptr, 0, nullptr, nullptr }
 };
 
 static int status()
 {
-	const char *argv[2];
+	const char *argv[3];
+	int argc = 0;
 	int ret = CMD_SUCCESS;
 	char *session_name = nullptr;
 
@@ -48,9 +52,13 @@ static int status()
 		goto end;
 	}
 
-	argv[0] = "list";
-	argv[1] = session_name;
-	ret = cmd_list(2, argv);
+	argv[argc++] = "list";
+	argv[argc++] = session_name;
+	if (opt_stats) {
+		argv[argc++] = "--stats";
+	}
+
+	ret = cmd_list(argc, argv);
 end:
 	free(session_name);
 	return ret;
@@ -13,6 +13,7 @@
 #include <common/mi-lttng.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
 
+#include <algorithm>
 #include <popt.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -96,6 +97,8 @@ cmd_error_code stop_tracing(const char *session_name)
 	}
 
 	if (!opt_no_wait) {
+		unsigned int wait_time_us = DEFAULT_DATA_AVAILABILITY_MIN_WAIT_TIME_US;
+
 		_MSG("Waiting for data availability");
 		fflush(stdout);
 		do {
@@ -113,7 +116,9 @@ cmd_error_code stop_tracing(const char *session_name)
 			 * returned value indicates availability.
 			 */
 			if (ret) {
-				usleep(DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US);
+				usleep(wait_time_us);
+				wait_time_us = std::min<unsigned int>(
+					wait_time_us * 2, DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US);
 				_MSG(".");
 				fflush(stdout);
 			}
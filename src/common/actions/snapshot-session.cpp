@@ -523,7 +523,8 @@ lttng_action_snapshot_session_set_output(struct lttng_action *action,
 	struct lttng_action_snapshot_session *action_snapshot_session;
 	enum lttng_action_status status;
 
-	if (!action || !IS_SNAPSHOT_SESSION_ACTION(action) || !output) {
+	/* A file descriptor can't outlive the registration of the action. */
+	if (!action || !IS_SNAPSHOT_SESSION_ACTION(action) || !output || output->fd.is_set) {
 		status = LTTNG_ACTION_STATUS_INVALID;
 		goto end;
 	}
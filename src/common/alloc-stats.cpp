@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include "alloc-stats.hpp"
+
+#include <common/error.hpp>
+
+#include <inttypes.h>
+#include <string.h>
+
+#ifdef LTTNG_ALLOC_STATS
+namespace {
+/* Registered sites, most recently constructed first. */
+lttng::alloc_stats::site *sites;
+
+/*
+ * Print the name of the type of a type site rather than the whole signature
+ * of type_site<>() given by __PRETTY_FUNCTION__.
+ */
+void get_printable_name(const char *name, const char **printable_name, int *length)
+{
+	static const char type_prefix[] = "AllocatedType = ";
+	const char *type = strstr(name, type_prefix);
+	size_t type_length;
+
+	if (!type) {
+		*printable_name = name;
+		*length = (int) strlen(name);
+		return;
+	}
+
+	type += sizeof(type_prefix) - 1;
+	type_length = strcspn(type, ";]");
+	*printable_name = type;
+	*length = (int) type_length;
+}
+} /* namespace */
+
+lttng::alloc_stats::site::site(const char *name) noexcept : _name(name)
+{
+	site *head = uatomic_read(&sites);
+
+	while (true) {
+		_next = head;
+
+		site *const previous_head = uatomic_cmpxchg(&sites, head, this);
+
+		if (previous_head == head) {
+			break;
+		}
+
+		head = previous_head;
+	}
+}
+
+void lttng::alloc_stats::log_all() noexcept
+{
+	for (const site *site = uatomic_read(&sites); site; site = site->next()) {
+		const char *name;
+		int name_length;
+
+		if (site->allocations() == 0) {
+			continue;
+		}
+
+		get_printable_name(site->name(), &name, &name_length);
+		DBG("Allocation site `%.*s`: allocations = %" PRIu64 ", bytes = %" PRIu64,
+		    name_length,
+		    name,
+		    site->allocations(),
+		    site->bytes());
+	}
+}
+#else /* LTTNG_ALLOC_STATS */
+void lttng::alloc_stats::log_all() noexcept
+{
+}
+#endif /* LTTNG_ALLOC_STATS */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_ALLOC_STATS_HPP
+#define LTTNG_ALLOC_STATS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef LTTNG_ALLOC_STATS
+#include <urcu/uatomic.h>
+#endif
+
+/*
+ * Allocation counters, built when configured with `--enable-alloc-stats`.
+ *
+ * The zmalloc(), calloc() and malloc() wrappers of macros.hpp count the
+ * allocations, and their size, per allocated type. Other hot allocation paths
+ * (e.g. the growth of the dynamic buffers used to serialize the payloads)
+ * count them in a named site of their own with LTTNG_ALLOC_STATS_COUNT().
+ *
+ * log_all() logs the counters of all the sites which allocated at least once;
+ * the daemons call it as they tear down, along with the statistics of the slab
+ * allocators. Without `--enable-alloc-stats`, nothing is counted and log_all()
+ * does nothing.
+ */
+namespace lttng {
+namespace alloc_stats {
+
+#ifdef LTTNG_ALLOC_STATS
+class site {
+public:
+	/* Sites are meant to be static objects, registered as they are constructed. */
+	explicit site(const char *name) noexcept;
+
+	void count(size_t size) noexcept
+	{
+		uatomic_inc(&_allocations);
+		uatomic_add(&_bytes, size);
+	}
+
+	const char *name() const noexcept
+	{
+		return _name;
+	}
+
+	uint64_t allocations() const noexcept
+	{
+		return uatomic_read(&_allocations);
+	}
+
+	uint64_t bytes() const noexcept
+	{
+		return uatomic_read(&_bytes);
+	}
+
+	site *next() const noexcept
+	{
+		return _next;
+	}
+
+private:
+	const char *const _name;
+	uint64_t _allocations = 0;
+	uint64_t _bytes = 0;
+	site *_next = nullptr;
+};
+
+/* Site of the allocations of an object type, named after the type. */
+template <typename AllocatedType>
+site& type_site() noexcept
+{
+	static site type_site(__PRETTY_FUNCTION__);
+
+	return type_site;
+}
+
+template <typename AllocatedType>
+void count(size_t size) noexcept
+{
+	type_site<AllocatedType>().count(size);
+}
+
+#define LTTNG_ALLOC_STATS_COUNT(_name, _size)                        \
+	do {                                                         \
+		static lttng::alloc_stats::site _alloc_stats_site(_name); \
+		_alloc_stats_site.count(_size);                      \
+	} while (0)
+#else /* LTTNG_ALLOC_STATS */
+template <typename AllocatedType>
+void count(size_t size __attribute__((unused))) noexcept
+{
+}
+
+#define LTTNG_ALLOC_STATS_COUNT(_name, _size) \
+	do {                                  \
+	} while (0)
+#endif /* LTTNG_ALLOC_STATS */
+
+void log_all() noexcept;
+
+} /* namespace alloc_stats */
+} /* namespace lttng */
+
+#endif /* LTTNG_ALLOC_STATS_HPP */
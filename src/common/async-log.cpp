@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "async-log.hpp"
+
+#include <common/compat/getenv.hpp>
+#include <common/defaults.hpp>
+#include <common/error.hpp>
+#include <common/macros.hpp>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <urcu/arch.h>
+#include <urcu/list.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
+
+int lttng_async_log_active;
+
+namespace {
+/* Capacity of the ring buffer of a thread, a power of two. */
+constexpr size_t ring_capacity = 256 * 1024;
+/* Messages longer than this are written synchronously. */
+constexpr size_t max_message_size = 4096;
+/* Period at which the writer thread looks for messages when it is idle. */
+constexpr int writer_idle_period_ms = 5;
+
+/*
+ * Ring buffer of the formatted messages of a thread. `head` is only written by
+ * the thread, `tail` only by the writer thread; they are free-running
+ * positions.
+ */
+struct log_ring {
+	uint64_t head;
+	uint64_t tail;
+	/* Set when the thread exits; the writer thread frees the ring once empty. */
+	int orphaned;
+	/* Node of `rings`, protected by `rings_lock`. */
+	struct cds_list_head node;
+	char data[ring_capacity];
+};
+
+pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+CDS_LIST_HEAD(rings);
+thread_local log_ring *thread_ring;
+/* Marks the ring of a thread as orphaned when it exits. */
+pthread_key_t ring_key;
+pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+pthread_t writer_thread;
+int writer_quit;
+uint64_t dropped_count;
+
+void orphan_ring(void *ring)
+{
+	/* Messages logged from now on by the exiting thread go to a new ring. */
+	thread_ring = nullptr;
+	uatomic_set(&static_cast<log_ring *>(ring)->orphaned, 1);
+}
+
+/* The child processes have no writer thread. */
+void disable_in_child()
+{
+	lttng_async_log_active = 0;
+	thread_ring = nullptr;
+}
+
+void init_once_cb()
+{
+	if (pthread_key_create(&ring_key, orphan_ring)) {
+		abort();
+	}
+
+	(void) pthread_atfork(nullptr, nullptr, disable_in_child);
+}
+
+log_ring *get_thread_ring()
+{
+	log_ring *ring = thread_ring;
+
+	if (caa_likely(ring)) {
+		return ring;
+	}
+
+	ring = zmalloc<log_ring>();
+	if (!ring) {
+		return nullptr;
+	}
+
+	if (pthread_setspecific(ring_key, ring)) {
+		free(ring);
+		return nullptr;
+	}
+
+	pthread_mutex_lock(&rings_lock);
+	cds_list_add_tail(&ring->node, &rings);
+	pthread_mutex_unlock(&rings_lock);
+
+	thread_ring = ring;
+	return ring;
+}
+
+/* Write the pending messages of a ring. Return the number of bytes written. */
+size_t drain_ring(log_ring *ring)
+{
+	const uint64_t head = CMM_LOAD_SHARED(ring->head);
+	const uint64_t tail = ring->tail;
+	const size_t len = head - tail;
+	const size_t offset = tail & (ring_capacity - 1);
+	const size_t first_len = std::min(len, ring_capacity - offset);
+
+	if (len == 0) {
+		return 0;
+	}
+
+	/* Read the messages after their publication by the thread. */
+	cmm_smp_rmb();
+	(void) fwrite(ring->data + offset, 1, first_len, stderr);
+	if (first_len < len) {
+		(void) fwrite(ring->data, 1, len - first_len, stderr);
+	}
+
+	/* Done reading the messages before the thread overwrites them. */
+	cmm_smp_mb();
+	CMM_STORE_SHARED(ring->tail, head);
+	return len;
+}
+
+/* Write the pending messages of all the rings. Return the number of bytes written. */
+size_t drain_rings()
+{
+	log_ring *ring, *tmp;
+	size_t written = 0;
+
+	pthread_mutex_lock(&rings_lock);
+	cds_list_for_each_entry_safe (ring, tmp, &rings, node) {
+		/* Read before draining: an orphaned ring receives no more messages. */
+		const bool orphaned = uatomic_read(&ring->orphaned);
+
+		cmm_smp_rmb();
+		written += drain_ring(ring);
+		if (orphaned) {
+			cds_list_del(&ring->node);
+			free(ring);
+		}
+	}
+	pthread_mutex_unlock(&rings_lock);
+
+	if (written) {
+		(void) fflush(stderr);
+	}
+
+	return written;
+}
+
+void report_dropped_messages(uint64_t *reported_count)
+{
+	const uint64_t count = uatomic_read(&dropped_count);
+
+	if (count == *reported_count) {
+		return;
+	}
+
+	fprintf(stderr,
+		"Warning: %" PRIu64 " debug messages dropped by the asynchronous logger\n",
+		count - *reported_count);
+	*reported_count = count;
+}
+
+void *writer_thread_func(void *)
+{
+	uint64_t reported_dropped_count = 0;
+
+	while (!uatomic_read(&writer_quit)) {
+		if (drain_rings() == 0) {
+			report_dropped_messages(&reported_dropped_count);
+			(void) poll(nullptr, 0, writer_idle_period_ms);
+		}
+	}
+
+	(void) drain_rings();
+	report_dropped_messages(&reported_dropped_count);
+	return nullptr;
+}
+} /* namespace */
+
+void lttng_async_log_printf(const char *fmt, ...)
+{
+	char message[max_message_size];
+	va_list args;
+	int len;
+	log_ring *ring;
+	uint64_t head, tail;
+	size_t offset, first_len;
+
+	va_start(args, fmt);
+	len = vsnprintf(message, sizeof(message), fmt, args);
+	va_end(args);
+	if (len < 0) {
+		return;
+	}
+
+	ring = get_thread_ring();
+	if ((size_t) len >= sizeof(message) || !ring) {
+		/* Too long for a ring buffer (or none): write it synchronously. */
+		va_start(args, fmt);
+		(void) vfprintf(stderr, fmt, args);
+		va_end(args);
+		return;
+	}
+
+	head = ring->head;
+	tail = CMM_LOAD_SHARED(ring->tail);
+	if (ring_capacity - (head - tail) < (size_t) len) {
+		uatomic_inc(&dropped_count);
+		return;
+	}
+
+	/* Read the tail before overwriting the messages it frees. */
+	cmm_smp_mb();
+	offset = head & (ring_capacity - 1);
+	first_len = std::min((size_t) len, ring_capacity - offset);
+	memcpy(ring->data + offset, message, first_len);
+	memcpy(ring->data, message + first_len, len - first_len);
+
+	/* Publish the message after writing it. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(ring->head, head + len);
+}
+
+int lttng_async_log_init_from_env()
+{
+	const char *value = lttng_secure_getenv(DEFAULT_ASYNC_LOG_ENV);
+
+	if (!value || strcmp(value, "1") != 0) {
+		return 0;
+	}
+
+	LTTNG_ASSERT(!uatomic_read(&lttng_async_log_active));
+	(void) pthread_once(&init_once, init_once_cb);
+
+	uatomic_set(&writer_quit, 0);
+	if (pthread_create(&writer_thread, nullptr, writer_thread_func, nullptr)) {
+		PERROR("Failed to create the asynchronous logger thread");
+		return -1;
+	}
+
+	uatomic_set(&lttng_async_log_active, 1);
+	DBG("Writing the debug messages asynchronously");
+	return 0;
+}
+
+void lttng_async_log_fini()
+{
+	if (!uatomic_read(&lttng_async_log_active)) {
+		return;
+	}
+
+	/*
+	 * The messages being logged concurrently to this call can be lost: the
+	 * threads are expected to be joined at this point.
+	 */
+	uatomic_set(&lttng_async_log_active, 0);
+	cmm_smp_mb();
+	uatomic_set(&writer_quit, 1);
+	if (pthread_join(writer_thread, nullptr)) {
+		PERROR("Failed to join the asynchronous logger thread");
+	}
+}
+
+uint64_t lttng_async_log_get_dropped_count()
+{
+	return uatomic_read(&dropped_count);
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_ASYNC_LOG_HPP
+#define LTTNG_ASYNC_LOG_HPP
+
+#include <stdint.h>
+
+/*
+ * Asynchronous writing of the debug messages (DBG, DBG2 and DBG3) of a daemon.
+ *
+ * While it is active, the threads format their debug messages into a ring
+ * buffer of their own, without locking, and a writer thread writes them to
+ * stderr. A message which doesn't fit in the ring buffer of its thread is
+ * dropped and counted; the writer thread reports the number of dropped
+ * messages. The errors, warnings and other messages are still written
+ * synchronously, so that they are never lost, which means that they can
+ * appear before debug messages logged earlier.
+ *
+ * The processes forked by the daemon, such as the run-as workers, log
+ * synchronously.
+ */
+
+/*
+ * Start the asynchronous writing of the debug messages if the
+ * LTTNG_ASYNC_LOG environment variable is set to 1.
+ *
+ * Return 0 on success (including when it is not enabled), or -1 on error.
+ */
+int lttng_async_log_init_from_env();
+
+/* Write the pending debug messages and go back to writing them synchronously. */
+void lttng_async_log_fini();
+
+/* Number of debug messages dropped so far because a ring buffer was full. */
+uint64_t lttng_async_log_get_dropped_count();
+
+#endif /* LTTNG_ASYNC_LOG_HPP */
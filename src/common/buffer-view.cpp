@@ -118,3 +118,21 @@ bool lttng_buffer_view_contains_string(const struct lttng_buffer_view *buf,
 end:
 	return ret;
 }
+
+const char *lttng_buffer_view_borrow_string(const struct lttng_buffer_view *buf,
+					    size_t offset,
+					    size_t len_with_null_terminator)
+{
+	const char *str;
+
+	if (offset > buf->size || len_with_null_terminator > buf->size - offset) {
+		return nullptr;
+	}
+
+	str = buf->data + offset;
+	if (!lttng_buffer_view_contains_string(buf, str, len_with_null_terminator)) {
+		return nullptr;
+	}
+
+	return str;
+}
@@ -90,4 +90,24 @@ bool lttng_buffer_view_contains_string(const struct lttng_buffer_view *buf,
 				       const char *str,
 				       size_t len_with_null_terminator);
 
+/**
+ * Borrow the string of length `len_with_null_terminator` found at `offset`
+ * within `buf`, without copying it.
+ *
+ * Return the start of the string, or NULL if `buf` does not contain a
+ * NULL-terminated string of that length at `offset`.
+ *
+ * The returned string references the memory of `buf`: it is only valid for as
+ * long as the memory referenced by `buf` (typically, the payload a message was
+ * received in) is neither reset nor resized.
+ *
+ * @buf				The buffer view
+ * @offset			Offset of the string within the buffer view
+ * @len_with_null_terminator	Expected length of the string, including the
+ * 				NULL terminator.
+ */
+const char *lttng_buffer_view_borrow_string(const struct lttng_buffer_view *buf,
+					    size_t offset,
+					    size_t len_with_null_terminator);
+
 #endif /* LTTNG_BUFFER_VIEW_H */
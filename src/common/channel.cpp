@@ -171,6 +171,20 @@ ssize_t lttng_channel_create_from_buffer(const struct lttng_buffer_view *view,
 	extended->lost_packets = channel_comm->lost_packets;
 	extended->monitor_timer_interval = channel_comm->monitor_timer_interval;
 	extended->blocking_timeout = channel_comm->blocking_timeout;
+	extended->writeback_policy = channel_comm->writeback_policy;
+	extended->writeback_window_size = channel_comm->writeback_window_size;
+	extended->drain_max_subbuffers = channel_comm->drain_max_subbuffers;
+	extended->drain_max_bytes = channel_comm->drain_max_bytes;
+	memcpy(extended->consumption_latency_histogram,
+	       channel_comm->consumption_latency_histogram,
+	       sizeof(extended->consumption_latency_histogram));
+	memcpy(extended->consumption_size_histogram,
+	       channel_comm->consumption_size_histogram,
+	       sizeof(extended->consumption_size_histogram));
+	extended->splice_pipe_size = channel_comm->splice_pipe_size;
+	extended->relayd_spilled_size = channel_comm->relayd_spilled_size;
+	extended->buffer_page_size = channel_comm->buffer_page_size;
+	extended->effective_buffer_page_size = channel_comm->effective_buffer_page_size;
 
 	*channel = local_channel;
 	local_channel = nullptr;
@@ -223,6 +237,20 @@ int lttng_channel_serialize(struct lttng_channel *channel, struct lttng_dynamic_
 	channel_comm.lost_packets = extended->lost_packets;
 	channel_comm.monitor_timer_interval = extended->monitor_timer_interval;
 	channel_comm.blocking_timeout = extended->blocking_timeout;
+	channel_comm.writeback_policy = extended->writeback_policy;
+	channel_comm.writeback_window_size = extended->writeback_window_size;
+	channel_comm.drain_max_subbuffers = extended->drain_max_subbuffers;
+	channel_comm.drain_max_bytes = extended->drain_max_bytes;
+	memcpy(channel_comm.consumption_latency_histogram,
+	       extended->consumption_latency_histogram,
+	       sizeof(channel_comm.consumption_latency_histogram));
+	memcpy(channel_comm.consumption_size_histogram,
+	       extended->consumption_size_histogram,
+	       sizeof(channel_comm.consumption_size_histogram));
+	channel_comm.splice_pipe_size = extended->splice_pipe_size;
+	channel_comm.relayd_spilled_size = extended->relayd_spilled_size;
+	channel_comm.buffer_page_size = extended->buffer_page_size;
+	channel_comm.effective_buffer_page_size = extended->effective_buffer_page_size;
 
 	/* Header */
 	ret = lttng_dynamic_buffer_append(buf, &channel_comm, sizeof(channel_comm));
@@ -38,6 +38,12 @@ static int _run_as_mkdir_recursive(const struct lttng_directory_handle *handle,
 				   mode_t mode,
 				   uid_t uid,
 				   gid_t gid);
+static int _run_as_mkdir_recursive_batch(const struct lttng_directory_handle *handle,
+					 const char *const *paths,
+					 size_t count,
+					 mode_t mode,
+					 uid_t uid,
+					 gid_t gid);
 static int lttng_directory_handle_open(const struct lttng_directory_handle *handle,
 				       const char *filename,
 				       int flags,
@@ -296,6 +302,16 @@ static int _run_as_mkdir_recursive(const struct lttng_directory_handle *handle,
 	return run_as_mkdirat_recursive(handle->dirfd, path, mode, uid, gid);
 }
 
+static int _run_as_mkdir_recursive_batch(const struct lttng_directory_handle *handle,
+					 const char *const *paths,
+					 size_t count,
+					 mode_t mode,
+					 uid_t uid,
+					 gid_t gid)
+{
+	return run_as_mkdirat_recursive_batch(handle->dirfd, paths, count, mode, uid, gid);
+}
+
 static int _lttng_directory_handle_rename(const struct lttng_directory_handle *old_handle,
 					  const char *old_name,
 					  const struct lttng_directory_handle *new_handle,
@@ -743,6 +759,27 @@ end:
 	return ret;
 }
 
+static int _run_as_mkdir_recursive_batch(const struct lttng_directory_handle *handle,
+					 const char *const *paths,
+					 size_t count,
+					 mode_t mode,
+					 uid_t uid,
+					 gid_t gid)
+{
+	int ret = 0;
+	size_t i;
+
+	/* The paths are relative to the handle, which can't be passed to the worker. */
+	for (i = 0; i < count; i++) {
+		ret = _run_as_mkdir_recursive(handle, paths[i], mode, uid, gid);
+		if (ret) {
+			break;
+		}
+	}
+
+	return ret;
+}
+
 static int _lttng_directory_handle_rename(const struct lttng_directory_handle *old_handle,
 					  const char *old_name,
 					  const struct lttng_directory_handle *new_handle,
@@ -1021,6 +1058,36 @@ int lttng_directory_handle_create_subdirectory_recursive_as_user(
 	return ret;
 }
 
+int lttng_directory_handle_create_subdirectories_recursive_as_user(
+	const struct lttng_directory_handle *handle,
+	const char *const *subdirectory_paths,
+	size_t count,
+	mode_t mode,
+	const struct lttng_credentials *creds)
+{
+	int ret = 0;
+	size_t i;
+
+	if (!creds) {
+		/* Run as current user. */
+		for (i = 0; i < count; i++) {
+			ret = create_directory_recursive(handle, subdirectory_paths[i], mode);
+			if (ret) {
+				break;
+			}
+		}
+	} else {
+		ret = _run_as_mkdir_recursive_batch(handle,
+						    subdirectory_paths,
+						    count,
+						    mode,
+						    lttng_credentials_get_uid(creds),
+						    lttng_credentials_get_gid(creds));
+	}
+
+	return ret;
+}
+
 int lttng_directory_handle_create_subdirectory(const struct lttng_directory_handle *handle,
 					       const char *subdirectory,
 					       mode_t mode)
@@ -141,6 +141,22 @@ int lttng_directory_handle_create_subdirectory_recursive_as_user(
 	mode_t mode,
 	const struct lttng_credentials *creds);
 
+/*
+ * Recursively create many directories relative to a directory handle as a
+ * given user, stopping at the first failure.
+ *
+ * Unlike successive calls to
+ * lttng_directory_handle_create_subdirectory_recursive_as_user(), the
+ * directories are created with as few requests to the run-as worker as
+ * possible.
+ */
+int lttng_directory_handle_create_subdirectories_recursive_as_user(
+	const struct lttng_directory_handle *handle,
+	const char *const *subdirectory_paths,
+	size_t count,
+	mode_t mode,
+	const struct lttng_credentials *creds);
+
 /*
  * Open a file descriptor to a path relative to a directory handle.
  */
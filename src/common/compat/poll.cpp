@@ -14,6 +14,7 @@
 #include <common/macros.hpp>
 #include <common/utils.hpp>
 
+#include <algorithm>
 #include <stdbool.h>
 #include <stdlib.h>
 
@@ -37,6 +38,12 @@
  */
 static unsigned int poll_max_size;
 
+/*
+ * Minimal number of events of the array of an epoll set, so that the sets of
+ * a few fds never need to be resized.
+ */
+#define COMPAT_EPOLL_MIN_EVENT_COUNT 64
+
 /*
  * Resize the epoll events structure of the new size.
  *
@@ -97,6 +104,8 @@ int compat_epoll_create(struct lttng_poll_event *events, int count, int flags)
 
 	events->epfd = ret;
 
+	count = std::max(count, COMPAT_EPOLL_MIN_EVENT_COUNT);
+
 	/* This *must* be freed by using lttng_poll_free() */
 	events->events = calloc<epoll_event>(count);
 	if (events->events == nullptr) {
@@ -263,9 +272,13 @@ int compat_epoll_wait(struct lttng_poll_event *events, int timeout, bool interru
 	 * shrink it down. It's important to note that after this step, we are
 	 * ensured that the events argument of the epoll_wait call will be large
 	 * enough to hold every possible returned events.
+	 *
+	 * The array is only shrunk once it is four times larger than needed,
+	 * so that a set whose size oscillates around a power of two is not
+	 * reallocated on every wait.
 	 */
-	new_size = 1U << utils_get_count_order_u32(events->nb_fd);
-	if (new_size != events->alloc_size && new_size >= events->init_size) {
+	new_size = std::max(1U << utils_get_count_order_u32(events->nb_fd), events->init_size);
+	if (new_size > events->alloc_size || new_size * 4 <= events->alloc_size) {
 		ret = resize_poll_event(events, new_size);
 		if (ret < 0) {
 			/* ENOMEM problem at this point. */
@@ -47,6 +47,11 @@ enum {
 	LPOLLHUP = EPOLLHUP,
 	LPOLLNVAL = EPOLLHUP,
 	LPOLLRDHUP = EPOLLRDHUP,
+	/*
+	 * Edge-triggered notification: the fd is only reported once until it
+	 * becomes ready again, hence its users must consume it until EAGAIN.
+	 */
+	LPOLLET = EPOLLET,
 /* Close on exec feature of epoll */
 #if defined(HAVE_EPOLL_CREATE1) && defined(EPOLL_CLOEXEC)
 	LTTNG_CLOEXEC = EPOLL_CLOEXEC,
@@ -220,6 +225,11 @@ enum {
 #endif /* __USE_GNU */
 	LPOLLERR = POLLERR,
 	LPOLLHUP = POLLHUP | POLLNVAL,
+	/*
+	 * poll(2) is level-triggered only, which is compatible with the users
+	 * of edge-triggered notifications.
+	 */
+	LPOLLET = 0,
 	/* Close on exec feature does not exist for poll(2) */
 	LTTNG_CLOEXEC = 0xdead,
 };
@@ -483,8 +483,8 @@ static struct lttng_evaluation *create_evaluation_from_payload(enum lttng_condit
 		goto end;
 	}
 
-	evaluation =
-		lttng_evaluation_buffer_usage_create(type, comm->buffer_use, comm->buffer_capacity);
+	evaluation = lttng_evaluation_buffer_usage_create(
+		type, comm->buffer_use, comm->buffer_capacity, comm->writeback_bytes_in_flight);
 end:
 	return evaluation;
 }
@@ -778,6 +778,7 @@ static int lttng_evaluation_buffer_usage_serialize(const struct lttng_evaluation
 	usage = lttng::utils::container_of(evaluation, &lttng_evaluation_buffer_usage::parent);
 	comm.buffer_use = usage->buffer_use;
 	comm.buffer_capacity = usage->buffer_capacity;
+	comm.writeback_bytes_in_flight = usage->writeback_bytes_in_flight;
 
 	return lttng_dynamic_buffer_append(&payload->buffer, &comm, sizeof(comm));
 }
@@ -792,7 +793,8 @@ static void lttng_evaluation_buffer_usage_destroy(struct lttng_evaluation *evalu
 
 struct lttng_evaluation *lttng_evaluation_buffer_usage_create(enum lttng_condition_type type,
 							      uint64_t use,
-							      uint64_t capacity)
+							      uint64_t capacity,
+							      uint64_t writeback_bytes_in_flight)
 {
 	struct lttng_evaluation_buffer_usage *usage;
 
@@ -804,6 +806,7 @@ struct lttng_evaluation *lttng_evaluation_buffer_usage_create(enum lttng_conditi
 	usage->parent.type = type;
 	usage->buffer_use = use;
 	usage->buffer_capacity = capacity;
+	usage->writeback_bytes_in_flight = writeback_bytes_in_flight;
 	usage->parent.serialize = lttng_evaluation_buffer_usage_serialize;
 	usage->parent.destroy = lttng_evaluation_buffer_usage_destroy;
 end:
@@ -849,3 +852,21 @@ lttng_evaluation_buffer_usage_get_usage(const struct lttng_evaluation *evaluatio
 end:
 	return status;
 }
+
+enum lttng_evaluation_status
+lttng_evaluation_buffer_usage_get_writeback_bytes_in_flight(
+	const struct lttng_evaluation *evaluation, uint64_t *bytes)
+{
+	struct lttng_evaluation_buffer_usage *usage;
+	enum lttng_evaluation_status status = LTTNG_EVALUATION_STATUS_OK;
+
+	if (!evaluation || !is_usage_evaluation(evaluation) || !bytes) {
+		status = LTTNG_EVALUATION_STATUS_INVALID;
+		goto end;
+	}
+
+	usage = lttng::utils::container_of(evaluation, &lttng_evaluation_buffer_usage::parent);
+	*bytes = usage->writeback_bytes_in_flight;
+end:
+	return status;
+}
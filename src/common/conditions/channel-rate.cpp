@@ -0,0 +1,877 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include <common/error.hpp>
+#include <common/macros.hpp>
+#include <common/mi-lttng.hpp>
+
+#include <lttng/condition/channel-rate-internal.hpp>
+#include <lttng/condition/condition-internal.hpp>
+
+#define IS_RATE_CONDITION(condition)                                                     \
+	(lttng_condition_get_type(condition) == LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW || \
+	 lttng_condition_get_type(condition) == LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH)
+
+static bool is_rate_evaluation(const struct lttng_evaluation *evaluation)
+{
+	enum lttng_condition_type type = lttng_evaluation_get_type(evaluation);
+
+	return type == LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW ||
+		type == LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH;
+}
+
+static bool is_valid_statistic(int statistic)
+{
+	switch (statistic) {
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_CONSUMED_BYTES:
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_DISCARDED_EVENTS:
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_LOST_PACKETS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static const char *
+statistic_mi_str(enum lttng_condition_channel_rate_statistic statistic)
+{
+	switch (statistic) {
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_CONSUMED_BYTES:
+		return mi_lttng_condition_channel_rate_statistic_consumed_bytes;
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_DISCARDED_EVENTS:
+		return mi_lttng_condition_channel_rate_statistic_discarded_events;
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_LOST_PACKETS:
+		return mi_lttng_condition_channel_rate_statistic_lost_packets;
+	default:
+		abort();
+	}
+}
+
+const char *
+lttng_condition_channel_rate_statistic_str(enum lttng_condition_channel_rate_statistic statistic)
+{
+	switch (statistic) {
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_CONSUMED_BYTES:
+		return "consumed bytes";
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_DISCARDED_EVENTS:
+		return "discarded events";
+	case LTTNG_CONDITION_CHANNEL_RATE_STATISTIC_LOST_PACKETS:
+		return "lost packets";
+	default:
+		return "???";
+	}
+}
+
+static void lttng_condition_channel_rate_destroy(struct lttng_condition *condition)
+{
+	struct lttng_condition_channel_rate *rate;
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+
+	free(rate->session_name);
+	free(rate->channel_name);
+	free(rate);
+}
+
+static bool lttng_condition_channel_rate_validate(const struct lttng_condition *condition)
+{
+	bool valid = false;
+	struct lttng_condition_channel_rate *rate;
+
+	if (!condition) {
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	if (!rate->session_name) {
+		ERR("Invalid channel rate condition: a target session name must be set.");
+		goto end;
+	}
+	if (!rate->channel_name) {
+		ERR("Invalid channel rate condition: a target channel name must be set.");
+		goto end;
+	}
+	if (!rate->domain.set) {
+		ERR("Invalid channel rate condition: a domain must be set.");
+		goto end;
+	}
+	if (!rate->statistic.set) {
+		ERR("Invalid channel rate condition: a statistic must be set.");
+		goto end;
+	}
+	if (!rate->threshold_per_second.set) {
+		ERR("Invalid channel rate condition: a threshold must be set.");
+		goto end;
+	}
+	if (!rate->window_us.set) {
+		ERR("Invalid channel rate condition: a window must be set.");
+		goto end;
+	}
+
+	valid = true;
+end:
+	return valid;
+}
+
+static int lttng_condition_channel_rate_serialize(const struct lttng_condition *condition,
+						  struct lttng_payload *payload)
+{
+	int ret;
+	struct lttng_condition_channel_rate *rate;
+	size_t session_name_len, channel_name_len;
+	struct lttng_condition_channel_rate_comm rate_comm = {};
+
+	if (!condition || !IS_RATE_CONDITION(condition)) {
+		ret = -1;
+		goto end;
+	}
+
+	DBG("Serializing channel rate condition");
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+
+	session_name_len = strlen(rate->session_name) + 1;
+	channel_name_len = strlen(rate->channel_name) + 1;
+	if (session_name_len > LTTNG_NAME_MAX || channel_name_len > LTTNG_NAME_MAX) {
+		ret = -1;
+		goto end;
+	}
+
+	rate_comm.statistic = (uint8_t) rate->statistic.value;
+	rate_comm.threshold_per_second = rate->threshold_per_second.value;
+	rate_comm.window_us = rate->window_us.value;
+	rate_comm.session_name_len = session_name_len;
+	rate_comm.channel_name_len = channel_name_len;
+	rate_comm.domain_type = (int8_t) rate->domain.type;
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer, &rate_comm, sizeof(rate_comm));
+	if (ret) {
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer, rate->session_name, session_name_len);
+	if (ret) {
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer, rate->channel_name, channel_name_len);
+	if (ret) {
+		goto end;
+	}
+end:
+	return ret;
+}
+
+static bool lttng_condition_channel_rate_is_equal(const struct lttng_condition *_a,
+						  const struct lttng_condition *_b)
+{
+	bool is_equal = false;
+	struct lttng_condition_channel_rate *a, *b;
+
+	a = lttng::utils::container_of(_a, &lttng_condition_channel_rate::parent);
+	b = lttng::utils::container_of(_b, &lttng_condition_channel_rate::parent);
+
+	/* Condition is not valid if this is not true. */
+	LTTNG_ASSERT(a->statistic.set && b->statistic.set);
+	LTTNG_ASSERT(a->threshold_per_second.set && b->threshold_per_second.set);
+	LTTNG_ASSERT(a->window_us.set && b->window_us.set);
+	if (a->statistic.value != b->statistic.value ||
+	    a->threshold_per_second.value != b->threshold_per_second.value ||
+	    a->window_us.value != b->window_us.value) {
+		goto end;
+	}
+
+	LTTNG_ASSERT(a->session_name);
+	LTTNG_ASSERT(b->session_name);
+	if (strcmp(a->session_name, b->session_name) != 0) {
+		goto end;
+	}
+
+	LTTNG_ASSERT(a->channel_name);
+	LTTNG_ASSERT(b->channel_name);
+	if (strcmp(a->channel_name, b->channel_name) != 0) {
+		goto end;
+	}
+
+	LTTNG_ASSERT(a->domain.set);
+	LTTNG_ASSERT(b->domain.set);
+	if (a->domain.type != b->domain.type) {
+		goto end;
+	}
+	is_equal = true;
+end:
+	return is_equal;
+}
+
+static enum lttng_error_code
+lttng_condition_channel_rate_mi_serialize(const struct lttng_condition *condition,
+					  struct mi_writer *writer)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	const struct lttng_condition_channel_rate *rate;
+	const char *condition_type_str = nullptr;
+
+	LTTNG_ASSERT(condition);
+	LTTNG_ASSERT(IS_RATE_CONDITION(condition));
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+
+	switch (lttng_condition_get_type(condition)) {
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		condition_type_str = mi_lttng_element_condition_channel_rate_high;
+		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+		condition_type_str = mi_lttng_element_condition_channel_rate_low;
+		break;
+	default:
+		abort();
+		break;
+	}
+
+	/* Open the sub type condition element. */
+	ret = mi_lttng_writer_open_element(writer, condition_type_str);
+	if (ret) {
+		goto mi_error;
+	}
+
+	/* Session name. */
+	ret = mi_lttng_writer_write_element_string(
+		writer, mi_lttng_element_session_name, rate->session_name);
+	if (ret) {
+		goto mi_error;
+	}
+
+	/* Channel name. */
+	ret = mi_lttng_writer_write_element_string(
+		writer, mi_lttng_element_condition_channel_name, rate->channel_name);
+	if (ret) {
+		goto mi_error;
+	}
+
+	/* Domain. */
+	ret = mi_lttng_writer_write_element_string(
+		writer, config_element_domain, mi_lttng_domaintype_string(rate->domain.type));
+	if (ret) {
+		goto mi_error;
+	}
+
+	/* Statistic. */
+	ret = mi_lttng_writer_write_element_string(writer,
+						   mi_lttng_element_condition_statistic,
+						   statistic_mi_str(rate->statistic.value));
+	if (ret) {
+		goto mi_error;
+	}
+
+	/* Threshold. */
+	ret = mi_lttng_writer_write_element_unsigned_int(
+		writer,
+		mi_lttng_element_condition_threshold_per_second,
+		rate->threshold_per_second.value);
+	if (ret) {
+		goto mi_error;
+	}
+
+	/* Window. */
+	ret = mi_lttng_writer_write_element_unsigned_int(
+		writer, mi_lttng_element_condition_window_us, rate->window_us.value);
+	if (ret) {
+		goto mi_error;
+	}
+
+	/* Closing sub type condition element. */
+	ret = mi_lttng_writer_close_element(writer);
+	if (ret) {
+		goto mi_error;
+	}
+
+	ret_code = LTTNG_OK;
+	goto end;
+
+mi_error:
+	ret_code = LTTNG_ERR_MI_IO_FAIL;
+end:
+	return ret_code;
+}
+
+static struct lttng_condition *lttng_condition_channel_rate_create(enum lttng_condition_type type)
+{
+	struct lttng_condition_channel_rate *condition;
+
+	condition = zmalloc<lttng_condition_channel_rate>();
+	if (!condition) {
+		return nullptr;
+	}
+
+	lttng_condition_init(&condition->parent, type);
+	condition->parent.validate = lttng_condition_channel_rate_validate;
+	condition->parent.serialize = lttng_condition_channel_rate_serialize;
+	condition->parent.equal = lttng_condition_channel_rate_is_equal;
+	condition->parent.destroy = lttng_condition_channel_rate_destroy;
+	condition->parent.mi_serialize = lttng_condition_channel_rate_mi_serialize;
+	return &condition->parent;
+}
+
+struct lttng_condition *lttng_condition_channel_rate_low_create(void)
+{
+	return lttng_condition_channel_rate_create(LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW);
+}
+
+struct lttng_condition *lttng_condition_channel_rate_high_create(void)
+{
+	return lttng_condition_channel_rate_create(LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH);
+}
+
+static ssize_t init_condition_from_payload(struct lttng_condition *condition,
+					   struct lttng_payload_view *src_view)
+{
+	ssize_t ret, condition_size;
+	enum lttng_condition_status status;
+	const char *session_name, *channel_name;
+	struct lttng_buffer_view names_view;
+	const struct lttng_condition_channel_rate_comm *condition_comm;
+	const struct lttng_payload_view condition_comm_view =
+		lttng_payload_view_from_view(src_view, 0, sizeof(*condition_comm));
+
+	if (!lttng_payload_view_is_valid(&condition_comm_view)) {
+		ERR("Failed to initialize from malformed condition buffer: buffer too short to contain header");
+		ret = -1;
+		goto end;
+	}
+
+	condition_comm = (typeof(condition_comm)) condition_comm_view.buffer.data;
+	names_view = lttng_buffer_view_from_view(&src_view->buffer, sizeof(*condition_comm), -1);
+
+	if (condition_comm->session_name_len == 0 || condition_comm->channel_name_len == 0 ||
+	    condition_comm->session_name_len > LTTNG_NAME_MAX ||
+	    condition_comm->channel_name_len > LTTNG_NAME_MAX) {
+		ERR("Failed to initialize from malformed condition buffer: invalid name length");
+		ret = -1;
+		goto end;
+	}
+
+	if (names_view.size <
+	    (condition_comm->session_name_len + condition_comm->channel_name_len)) {
+		ERR("Failed to initialize from malformed condition buffer: buffer too short to contain element names");
+		ret = -1;
+		goto end;
+	}
+
+	if (!is_valid_statistic(condition_comm->statistic)) {
+		ERR("Invalid channel rate statistic value (%i) found in condition buffer",
+		    (int) condition_comm->statistic);
+		ret = -1;
+		goto end;
+	}
+
+	status = lttng_condition_channel_rate_set_statistic(
+		condition, (enum lttng_condition_channel_rate_statistic) condition_comm->statistic);
+	if (status != LTTNG_CONDITION_STATUS_OK) {
+		ERR("Failed to set channel rate condition statistic");
+		ret = -1;
+		goto end;
+	}
+
+	status = lttng_condition_channel_rate_set_threshold(condition,
+							    condition_comm->threshold_per_second);
+	if (status != LTTNG_CONDITION_STATUS_OK) {
+		ERR("Failed to set channel rate condition threshold");
+		ret = -1;
+		goto end;
+	}
+
+	status = lttng_condition_channel_rate_set_window(condition, condition_comm->window_us);
+	if (status != LTTNG_CONDITION_STATUS_OK) {
+		ERR("Failed to set channel rate condition window");
+		ret = -1;
+		goto end;
+	}
+
+	if (condition_comm->domain_type <= LTTNG_DOMAIN_NONE ||
+	    condition_comm->domain_type > LTTNG_DOMAIN_PYTHON) {
+		/* Invalid domain value. */
+		ERR("Invalid domain type value (%i) found in condition buffer",
+		    (int) condition_comm->domain_type);
+		ret = -1;
+		goto end;
+	}
+
+	status = lttng_condition_channel_rate_set_domain_type(
+		condition, (enum lttng_domain_type) condition_comm->domain_type);
+	if (status != LTTNG_CONDITION_STATUS_OK) {
+		ERR("Failed to set channel rate condition domain");
+		ret = -1;
+		goto end;
+	}
+
+	session_name = names_view.data;
+	if (*(session_name + condition_comm->session_name_len - 1) != '\0') {
+		ERR("Malformed session name encountered in condition buffer");
+		ret = -1;
+		goto end;
+	}
+
+	channel_name = session_name + condition_comm->session_name_len;
+	if (*(channel_name + condition_comm->channel_name_len - 1) != '\0') {
+		ERR("Malformed channel name encountered in condition buffer");
+		ret = -1;
+		goto end;
+	}
+
+	status = lttng_condition_channel_rate_set_session_name(condition, session_name);
+	if (status != LTTNG_CONDITION_STATUS_OK) {
+		ERR("Failed to set channel rate condition session name");
+		ret = -1;
+		goto end;
+	}
+
+	status = lttng_condition_channel_rate_set_channel_name(condition, channel_name);
+	if (status != LTTNG_CONDITION_STATUS_OK) {
+		ERR("Failed to set channel rate condition channel name");
+		ret = -1;
+		goto end;
+	}
+
+	if (!lttng_condition_validate(condition)) {
+		ret = -1;
+		goto end;
+	}
+
+	condition_size = sizeof(*condition_comm) + (ssize_t) condition_comm->session_name_len +
+		(ssize_t) condition_comm->channel_name_len;
+	ret = condition_size;
+end:
+	return ret;
+}
+
+ssize_t lttng_condition_channel_rate_low_create_from_payload(struct lttng_payload_view *view,
+							     struct lttng_condition **_condition)
+{
+	ssize_t ret;
+	struct lttng_condition *condition = lttng_condition_channel_rate_low_create();
+
+	if (!_condition || !condition) {
+		ret = -1;
+		goto error;
+	}
+
+	ret = init_condition_from_payload(condition, view);
+	if (ret < 0) {
+		goto error;
+	}
+
+	*_condition = condition;
+	return ret;
+error:
+	lttng_condition_destroy(condition);
+	return ret;
+}
+
+ssize_t lttng_condition_channel_rate_high_create_from_payload(struct lttng_payload_view *view,
+							      struct lttng_condition **_condition)
+{
+	ssize_t ret;
+	struct lttng_condition *condition = lttng_condition_channel_rate_high_create();
+
+	if (!_condition || !condition) {
+		ret = -1;
+		goto error;
+	}
+
+	ret = init_condition_from_payload(condition, view);
+	if (ret < 0) {
+		goto error;
+	}
+
+	*_condition = condition;
+	return ret;
+error:
+	lttng_condition_destroy(condition);
+	return ret;
+}
+
+static struct lttng_evaluation *create_evaluation_from_payload(enum lttng_condition_type type,
+							       struct lttng_payload_view *view)
+{
+	const struct lttng_evaluation_channel_rate_comm *comm = (typeof(comm)) view->buffer.data;
+	struct lttng_evaluation *evaluation = nullptr;
+
+	if (view->buffer.size < sizeof(*comm)) {
+		goto end;
+	}
+
+	evaluation = lttng_evaluation_channel_rate_create(type, comm->rate_per_second);
+end:
+	return evaluation;
+}
+
+ssize_t lttng_evaluation_channel_rate_low_create_from_payload(struct lttng_payload_view *view,
+							      struct lttng_evaluation **_evaluation)
+{
+	ssize_t ret;
+	struct lttng_evaluation *evaluation = nullptr;
+
+	if (!_evaluation) {
+		ret = -1;
+		goto error;
+	}
+
+	evaluation = create_evaluation_from_payload(LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW, view);
+	if (!evaluation) {
+		ret = -1;
+		goto error;
+	}
+
+	*_evaluation = evaluation;
+	ret = sizeof(struct lttng_evaluation_channel_rate_comm);
+	return ret;
+error:
+	lttng_evaluation_destroy(evaluation);
+	return ret;
+}
+
+ssize_t
+lttng_evaluation_channel_rate_high_create_from_payload(struct lttng_payload_view *view,
+						       struct lttng_evaluation **_evaluation)
+{
+	ssize_t ret;
+	struct lttng_evaluation *evaluation = nullptr;
+
+	if (!_evaluation) {
+		ret = -1;
+		goto error;
+	}
+
+	evaluation = create_evaluation_from_payload(LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH, view);
+	if (!evaluation) {
+		ret = -1;
+		goto error;
+	}
+
+	*_evaluation = evaluation;
+	ret = sizeof(struct lttng_evaluation_channel_rate_comm);
+	return ret;
+error:
+	lttng_evaluation_destroy(evaluation);
+	return ret;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_get_statistic(const struct lttng_condition *condition,
+					   enum lttng_condition_channel_rate_statistic *statistic)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !statistic) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	if (!rate->statistic.set) {
+		status = LTTNG_CONDITION_STATUS_UNSET;
+		goto end;
+	}
+	*statistic = rate->statistic.value;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_set_statistic(struct lttng_condition *condition,
+					   enum lttng_condition_channel_rate_statistic statistic)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !is_valid_statistic(statistic)) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	rate->statistic.set = true;
+	rate->statistic.value = statistic;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_get_threshold(const struct lttng_condition *condition,
+					   uint64_t *threshold_per_second)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !threshold_per_second) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	if (!rate->threshold_per_second.set) {
+		status = LTTNG_CONDITION_STATUS_UNSET;
+		goto end;
+	}
+	*threshold_per_second = rate->threshold_per_second.value;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_set_threshold(struct lttng_condition *condition,
+					   uint64_t threshold_per_second)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition)) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	rate->threshold_per_second.set = true;
+	rate->threshold_per_second.value = threshold_per_second;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_get_window(const struct lttng_condition *condition,
+					uint64_t *window_us)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !window_us) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	if (!rate->window_us.set) {
+		status = LTTNG_CONDITION_STATUS_UNSET;
+		goto end;
+	}
+	*window_us = rate->window_us.value;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_set_window(struct lttng_condition *condition, uint64_t window_us)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || window_us == 0) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	rate->window_us.set = true;
+	rate->window_us.value = window_us;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_get_session_name(const struct lttng_condition *condition,
+					      const char **session_name)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !session_name) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	if (!rate->session_name) {
+		status = LTTNG_CONDITION_STATUS_UNSET;
+		goto end;
+	}
+	*session_name = rate->session_name;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_set_session_name(struct lttng_condition *condition,
+					      const char *session_name)
+{
+	char *session_name_copy;
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !session_name ||
+	    strlen(session_name) == 0) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	session_name_copy = strdup(session_name);
+	if (!session_name_copy) {
+		status = LTTNG_CONDITION_STATUS_ERROR;
+		goto end;
+	}
+
+	free(rate->session_name);
+	rate->session_name = session_name_copy;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_get_channel_name(const struct lttng_condition *condition,
+					      const char **channel_name)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !channel_name) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	if (!rate->channel_name) {
+		status = LTTNG_CONDITION_STATUS_UNSET;
+		goto end;
+	}
+	*channel_name = rate->channel_name;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_set_channel_name(struct lttng_condition *condition,
+					      const char *channel_name)
+{
+	char *channel_name_copy;
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !channel_name ||
+	    strlen(channel_name) == 0) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	channel_name_copy = strdup(channel_name);
+	if (!channel_name_copy) {
+		status = LTTNG_CONDITION_STATUS_ERROR;
+		goto end;
+	}
+
+	free(rate->channel_name);
+	rate->channel_name = channel_name_copy;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_get_domain_type(const struct lttng_condition *condition,
+					     enum lttng_domain_type *type)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || !type) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	if (!rate->domain.set) {
+		status = LTTNG_CONDITION_STATUS_UNSET;
+		goto end;
+	}
+	*type = rate->domain.type;
+end:
+	return status;
+}
+
+enum lttng_condition_status
+lttng_condition_channel_rate_set_domain_type(struct lttng_condition *condition,
+					     enum lttng_domain_type type)
+{
+	struct lttng_condition_channel_rate *rate;
+	enum lttng_condition_status status = LTTNG_CONDITION_STATUS_OK;
+
+	if (!condition || !IS_RATE_CONDITION(condition) || type == LTTNG_DOMAIN_NONE) {
+		status = LTTNG_CONDITION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(condition, &lttng_condition_channel_rate::parent);
+	rate->domain.set = true;
+	rate->domain.type = type;
+end:
+	return status;
+}
+
+static int lttng_evaluation_channel_rate_serialize(const struct lttng_evaluation *evaluation,
+						   struct lttng_payload *payload)
+{
+	struct lttng_evaluation_channel_rate *rate;
+	struct lttng_evaluation_channel_rate_comm comm;
+
+	rate = lttng::utils::container_of(evaluation, &lttng_evaluation_channel_rate::parent);
+	comm.rate_per_second = rate->rate_per_second;
+
+	return lttng_dynamic_buffer_append(&payload->buffer, &comm, sizeof(comm));
+}
+
+static void lttng_evaluation_channel_rate_destroy(struct lttng_evaluation *evaluation)
+{
+	struct lttng_evaluation_channel_rate *rate;
+
+	rate = lttng::utils::container_of(evaluation, &lttng_evaluation_channel_rate::parent);
+	free(rate);
+}
+
+struct lttng_evaluation *lttng_evaluation_channel_rate_create(enum lttng_condition_type type,
+							      uint64_t rate_per_second)
+{
+	struct lttng_evaluation_channel_rate *rate;
+
+	rate = zmalloc<lttng_evaluation_channel_rate>();
+	if (!rate) {
+		return nullptr;
+	}
+
+	rate->parent.type = type;
+	rate->rate_per_second = rate_per_second;
+	rate->parent.serialize = lttng_evaluation_channel_rate_serialize;
+	rate->parent.destroy = lttng_evaluation_channel_rate_destroy;
+	return &rate->parent;
+}
+
+enum lttng_evaluation_status
+lttng_evaluation_channel_rate_get_rate(const struct lttng_evaluation *evaluation,
+				       uint64_t *rate_per_second)
+{
+	struct lttng_evaluation_channel_rate *rate;
+	enum lttng_evaluation_status status = LTTNG_EVALUATION_STATUS_OK;
+
+	if (!evaluation || !is_rate_evaluation(evaluation) || !rate_per_second) {
+		status = LTTNG_EVALUATION_STATUS_INVALID;
+		goto end;
+	}
+
+	rate = lttng::utils::container_of(evaluation, &lttng_evaluation_channel_rate::parent);
+	*rate_per_second = rate->rate_per_second;
+end:
+	return status;
+}
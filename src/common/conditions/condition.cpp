@@ -12,6 +12,7 @@
 #include <common/mi-lttng.hpp>
 
 #include <lttng/condition/buffer-usage-internal.hpp>
+#include <lttng/condition/channel-rate-internal.hpp>
 #include <lttng/condition/condition-internal.hpp>
 #include <lttng/condition/event-rule-matches-internal.hpp>
 #include <lttng/condition/session-consumed-size-internal.hpp>
@@ -19,6 +20,8 @@
 #include <lttng/error-query-internal.hpp>
 
 #include <stdbool.h>
+#include <urcu/arch.h>
+#include <urcu/system.h>
 
 enum lttng_condition_type lttng_condition_get_type(const struct lttng_condition *condition)
 {
@@ -116,6 +119,14 @@ bool lttng_condition_is_equal(const struct lttng_condition *a, const struct lttn
 		goto end;
 	}
 
+	/* Conditions of different hashes can't be equal, skip their comparison. */
+	if (CMM_LOAD_SHARED(a->hash_is_set) && CMM_LOAD_SHARED(b->hash_is_set)) {
+		cmm_smp_rmb();
+		if (a->hash != b->hash) {
+			goto end;
+		}
+	}
+
 	is_equal = a->equal ? a->equal(a, b) : true;
 end:
 	return is_equal;
@@ -165,6 +176,12 @@ ssize_t lttng_condition_create_from_payload(struct lttng_payload_view *view,
 	case LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES:
 		create_from_payload = lttng_condition_event_rule_matches_create_from_payload;
 		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		create_from_payload = lttng_condition_channel_rate_high_create_from_payload;
+		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+		create_from_payload = lttng_condition_channel_rate_low_create_from_payload;
+		break;
 	default:
 		ERR("Attempted to create condition of unknown type (%i)",
 		    (int) condition_comm->condition_type);
@@ -194,6 +211,7 @@ end:
 void lttng_condition_init(struct lttng_condition *condition, enum lttng_condition_type type)
 {
 	condition->type = type;
+	condition->hash_is_set = false;
 	urcu_ref_init(&condition->ref);
 }
 
@@ -221,6 +239,12 @@ const char *lttng_condition_type_str(enum lttng_condition_type type)
 	case LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES:
 		return "event rule matches";
 
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		return "channel rate high";
+
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+		return "channel rate low";
+
 	default:
 		return "???";
 	}
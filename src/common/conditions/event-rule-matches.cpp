@@ -5,6 +5,7 @@
  *
  */
 
+#include <common/bytecode/bytecode.hpp>
 #include <common/error.hpp>
 #include <common/macros.hpp>
 #include <common/mi-lttng.hpp>
@@ -1033,6 +1034,7 @@ static void lttng_evaluation_event_rule_matches_destroy(struct lttng_evaluation
 	hit = lttng::utils::container_of(evaluation, &lttng_evaluation_event_rule_matches::parent);
 	lttng_dynamic_buffer_reset(&hit->capture_payload);
 	lttng_event_field_value_destroy(hit->captured_values);
+	msgpack_zone_free(hit->capture_zone);
 	free(hit);
 }
 
@@ -1200,33 +1202,35 @@ end:
 	return ret;
 }
 
-static struct lttng_event_field_value *
-event_field_value_from_capture_payload(const struct lttng_condition_event_rule_matches *condition,
-				       const char *capture_payload,
-				       size_t capture_payload_size)
+/*
+ * Decode the MessagePack-encoded capture payload of an evaluation, which
+ * must outlive the decoded objects, into its captured objects.
+ *
+ * All the objects are allocated in a single arena.
+ */
+static int unpack_capture_payload(const struct lttng_condition_event_rule_matches *condition,
+				  struct lttng_evaluation_event_rule_matches *hit)
 {
-	struct lttng_event_field_value *ret = nullptr;
+	int ret;
 	msgpack_unpacked unpacked;
 	msgpack_unpack_return unpack_return;
 	const msgpack_object *root_obj;
-	const msgpack_object_array *root_array_obj;
-	size_t i;
 	size_t count;
 
 	LTTNG_ASSERT(condition);
-	LTTNG_ASSERT(capture_payload);
+	LTTNG_ASSERT(hit->capture_payload.size > 0);
 
 	/* Initialize value. */
 	msgpack_unpacked_init(&unpacked);
 
 	/* Decode. */
-	unpack_return =
-		msgpack_unpack_next(&unpacked, capture_payload, capture_payload_size, nullptr);
+	unpack_return = msgpack_unpack_next(
+		&unpacked, hit->capture_payload.data, hit->capture_payload.size, nullptr);
 	if (unpack_return != MSGPACK_UNPACK_SUCCESS) {
 		ERR("msgpack_unpack_next() failed to decode the "
 		    "MessagePack-encoded capture payload: "
 		    "size = %zu, ret = %d",
-		    capture_payload_size,
+		    hit->capture_payload.size,
 		    unpack_return);
 		goto error;
 	}
@@ -1240,7 +1244,39 @@ event_field_value_from_capture_payload(const struct lttng_condition_event_rule_m
 		goto error;
 	}
 
-	root_array_obj = &root_obj->via.array;
+	/* One captured field value MessagePack object per capture descriptor. */
+	count = lttng_dynamic_pointer_array_get_count(&condition->capture_descriptors);
+	LTTNG_ASSERT(count > 0);
+
+	if (root_obj->via.array.size < count) {
+		ERR("Expecting a captured value per capture descriptor: "
+		    "captured value count = %" PRIu32 ", capture descriptor count = %zu",
+		    root_obj->via.array.size,
+		    count);
+		goto error;
+	}
+
+	hit->captured_objects = root_obj->via.array.ptr;
+	hit->captured_object_count = count;
+	hit->capture_zone = msgpack_unpacked_release_zone(&unpacked);
+	ret = 0;
+	goto end;
+
+error:
+	ret = -1;
+
+end:
+	msgpack_unpacked_destroy(&unpacked);
+	return ret;
+}
+
+static struct lttng_event_field_value *
+event_field_value_from_captured_objects(const msgpack_object *objs, unsigned int count)
+{
+	struct lttng_event_field_value *ret = nullptr;
+	unsigned int i;
+
+	LTTNG_ASSERT(objs);
 
 	/* Create an empty root array event field value. */
 	ret = lttng_event_field_value_array_create();
@@ -1249,30 +1285,17 @@ event_field_value_from_capture_payload(const struct lttng_condition_event_rule_m
 	}
 
 	/*
-	 * For each capture descriptor in the condition object:
-	 *
-	 * 1. Get its corresponding captured field value MessagePack
-	 *    object.
+	 * For each captured field value MessagePack object:
 	 *
-	 * 2. Create a corresponding event field value.
+	 * 1. Create a corresponding event field value.
 	 *
-	 * 3. Append it to `ret` (the root array event field value).
+	 * 2. Append it to `ret` (the root array event field value).
 	 */
-	count = lttng_dynamic_pointer_array_get_count(&condition->capture_descriptors);
-	LTTNG_ASSERT(count > 0);
-
 	for (i = 0; i < count; i++) {
-		const struct lttng_capture_descriptor *capture_descriptor =
-			lttng_condition_event_rule_matches_get_internal_capture_descriptor_at_index(
-				&condition->parent, i);
-		const msgpack_object *elem_obj;
 		struct lttng_event_field_value *elem_field_val;
 		int iret;
 
-		LTTNG_ASSERT(capture_descriptor);
-
-		elem_obj = &root_array_obj->ptr[i];
-		iret = event_field_value_from_obj(elem_obj, &elem_field_val);
+		iret = event_field_value_from_obj(&objs[i], &elem_field_val);
 		if (iret) {
 			goto error;
 		}
@@ -1296,7 +1319,6 @@ error:
 	ret = nullptr;
 
 end:
-	msgpack_unpacked_destroy(&unpacked);
 	return ret;
 }
 
@@ -1324,14 +1346,14 @@ struct lttng_evaluation *lttng_evaluation_event_rule_matches_create(
 			goto error;
 		}
 
-		if (decode_capture_payload) {
-			hit->captured_values = event_field_value_from_capture_payload(
-				condition, capture_payload, capture_payload_size);
-			if (!hit->captured_values) {
-				ERR("Failed to decode the capture payload: size = %zu",
-				    capture_payload_size);
-				goto error;
-			}
+		/*
+		 * The event field values of the captured objects are only
+		 * created if they are requested.
+		 */
+		if (decode_capture_payload && unpack_capture_payload(condition, hit)) {
+			ERR("Failed to decode the capture payload: size = %zu",
+			    capture_payload_size);
+			goto error;
 		}
 	}
 
@@ -1364,17 +1386,294 @@ lttng_evaluation_event_rule_matches_get_captured_values(
 	}
 
 	hit = lttng::utils::container_of(evaluation, &lttng_evaluation_event_rule_matches::parent);
-	if (!hit->captured_values) {
+	if (!hit->captured_objects) {
 		status = LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_NONE;
 		goto end;
 	}
 
+	if (!hit->captured_values) {
+		hit->captured_values = event_field_value_from_captured_objects(
+			hit->captured_objects, hit->captured_object_count);
+		if (!hit->captured_values) {
+			ERR("Failed to create the event field values of the captured values");
+			status = LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_INVALID;
+			goto end;
+		}
+	}
+
 	*field_val = hit->captured_values;
 
 end:
 	return status;
 }
 
+enum lttng_evaluation_event_rule_matches_status
+lttng_evaluation_event_rule_matches_get_captured_value_count(
+	const struct lttng_evaluation *evaluation, unsigned int *count)
+{
+	const struct lttng_evaluation_event_rule_matches *hit;
+
+	if (!evaluation || !is_event_rule_matches_evaluation(evaluation) || !count) {
+		return LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_INVALID;
+	}
+
+	hit = lttng::utils::container_of(evaluation, &lttng_evaluation_event_rule_matches::parent);
+	if (!hit->captured_objects) {
+		return LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_NONE;
+	}
+
+	*count = hit->captured_object_count;
+	return LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_OK;
+}
+
+/*
+ * Get the captured MessagePack object at `index` of an evaluation, setting
+ * `*obj` to null if it's unavailable.
+ */
+static enum lttng_event_field_value_status
+get_captured_object_at_index(const struct lttng_evaluation *evaluation,
+			     unsigned int index,
+			     const msgpack_object **obj)
+{
+	const struct lttng_evaluation_event_rule_matches *hit;
+
+	if (!evaluation || !is_event_rule_matches_evaluation(evaluation)) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	hit = lttng::utils::container_of(evaluation, &lttng_evaluation_event_rule_matches::parent);
+	if (index >= hit->captured_object_count) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	*obj = &hit->captured_objects[index];
+	if ((*obj)->type == MSGPACK_OBJECT_NIL) {
+		*obj = nullptr;
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_UNAVAILABLE;
+	}
+
+	return LTTNG_EVENT_FIELD_VALUE_STATUS_OK;
+}
+
+/*
+ * Get the integer value object of a captured enumeration value map object,
+ * or null if it isn't one. See event_field_value_from_obj().
+ */
+static const msgpack_object *get_enum_value_obj(const msgpack_object *obj)
+{
+	const msgpack_object *inner_obj;
+
+	if (obj->type != MSGPACK_OBJECT_MAP) {
+		return nullptr;
+	}
+
+	inner_obj = get_msgpack_map_obj(obj, "type");
+	if (!inner_obj || inner_obj->type != MSGPACK_OBJECT_STR ||
+	    !msgpack_str_is_equal(inner_obj, "enum")) {
+		return nullptr;
+	}
+
+	inner_obj = get_msgpack_map_obj(obj, "value");
+	if (!inner_obj ||
+	    (inner_obj->type != MSGPACK_OBJECT_POSITIVE_INTEGER &&
+	     inner_obj->type != MSGPACK_OBJECT_NEGATIVE_INTEGER)) {
+		return nullptr;
+	}
+
+	return inner_obj;
+}
+
+enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_value_type_at_index(
+	const struct lttng_evaluation *evaluation,
+	unsigned int index,
+	enum lttng_event_field_value_type *type)
+{
+	const msgpack_object *obj, *value_obj;
+	enum lttng_event_field_value_status status;
+
+	if (!type) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	status = get_captured_object_at_index(evaluation, index, &obj);
+	if (status != LTTNG_EVENT_FIELD_VALUE_STATUS_OK) {
+		return status;
+	}
+
+	switch (obj->type) {
+	case MSGPACK_OBJECT_POSITIVE_INTEGER:
+		*type = LTTNG_EVENT_FIELD_VALUE_TYPE_UNSIGNED_INT;
+		break;
+	case MSGPACK_OBJECT_NEGATIVE_INTEGER:
+		*type = LTTNG_EVENT_FIELD_VALUE_TYPE_SIGNED_INT;
+		break;
+	case MSGPACK_OBJECT_FLOAT32:
+	case MSGPACK_OBJECT_FLOAT64:
+		*type = LTTNG_EVENT_FIELD_VALUE_TYPE_REAL;
+		break;
+	case MSGPACK_OBJECT_STR:
+		*type = LTTNG_EVENT_FIELD_VALUE_TYPE_STRING;
+		break;
+	case MSGPACK_OBJECT_ARRAY:
+		*type = LTTNG_EVENT_FIELD_VALUE_TYPE_ARRAY;
+		break;
+	case MSGPACK_OBJECT_MAP:
+		value_obj = get_enum_value_obj(obj);
+		if (!value_obj) {
+			*type = LTTNG_EVENT_FIELD_VALUE_TYPE_UNKNOWN;
+		} else if (value_obj->type == MSGPACK_OBJECT_POSITIVE_INTEGER) {
+			*type = LTTNG_EVENT_FIELD_VALUE_TYPE_UNSIGNED_ENUM;
+		} else {
+			*type = LTTNG_EVENT_FIELD_VALUE_TYPE_SIGNED_ENUM;
+		}
+
+		break;
+	default:
+		*type = LTTNG_EVENT_FIELD_VALUE_TYPE_UNKNOWN;
+		break;
+	}
+
+	return LTTNG_EVENT_FIELD_VALUE_STATUS_OK;
+}
+
+enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_unsigned_int_at_index(
+	const struct lttng_evaluation *evaluation, unsigned int index, uint64_t *val)
+{
+	const msgpack_object *obj;
+	enum lttng_event_field_value_status status;
+
+	if (!val) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	status = get_captured_object_at_index(evaluation, index, &obj);
+	if (status != LTTNG_EVENT_FIELD_VALUE_STATUS_OK) {
+		return status;
+	}
+
+	if (obj->type == MSGPACK_OBJECT_MAP) {
+		obj = get_enum_value_obj(obj);
+		if (!obj) {
+			return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+		}
+	}
+
+	if (obj->type != MSGPACK_OBJECT_POSITIVE_INTEGER) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	*val = obj->via.u64;
+	return LTTNG_EVENT_FIELD_VALUE_STATUS_OK;
+}
+
+enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_signed_int_at_index(
+	const struct lttng_evaluation *evaluation, unsigned int index, int64_t *val)
+{
+	const msgpack_object *obj;
+	enum lttng_event_field_value_status status;
+
+	if (!val) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	status = get_captured_object_at_index(evaluation, index, &obj);
+	if (status != LTTNG_EVENT_FIELD_VALUE_STATUS_OK) {
+		return status;
+	}
+
+	if (obj->type == MSGPACK_OBJECT_MAP) {
+		obj = get_enum_value_obj(obj);
+		if (!obj) {
+			return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+		}
+	}
+
+	if (obj->type != MSGPACK_OBJECT_NEGATIVE_INTEGER) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	*val = obj->via.i64;
+	return LTTNG_EVENT_FIELD_VALUE_STATUS_OK;
+}
+
+enum lttng_event_field_value_status lttng_evaluation_event_rule_matches_get_captured_real_at_index(
+	const struct lttng_evaluation *evaluation, unsigned int index, double *val)
+{
+	const msgpack_object *obj;
+	enum lttng_event_field_value_status status;
+
+	if (!val) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	status = get_captured_object_at_index(evaluation, index, &obj);
+	if (status != LTTNG_EVENT_FIELD_VALUE_STATUS_OK) {
+		return status;
+	}
+
+	if (obj->type != MSGPACK_OBJECT_FLOAT32 && obj->type != MSGPACK_OBJECT_FLOAT64) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	*val = obj->via.f64;
+	return LTTNG_EVENT_FIELD_VALUE_STATUS_OK;
+}
+
+enum lttng_event_field_value_status
+lttng_evaluation_event_rule_matches_get_captured_string_at_index(
+	const struct lttng_evaluation *evaluation,
+	unsigned int index,
+	const char **val,
+	size_t *len)
+{
+	const msgpack_object *obj;
+	enum lttng_event_field_value_status status;
+
+	if (!val || !len) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	status = get_captured_object_at_index(evaluation, index, &obj);
+	if (status != LTTNG_EVENT_FIELD_VALUE_STATUS_OK) {
+		return status;
+	}
+
+	if (obj->type != MSGPACK_OBJECT_STR) {
+		return LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID;
+	}
+
+	*val = obj->via.str.ptr;
+	*len = obj->via.str.size;
+	return LTTNG_EVENT_FIELD_VALUE_STATUS_OK;
+}
+
+/*
+ * Find the first capture descriptor of `expr` among the `count` first
+ * capture descriptors of `condition`.
+ */
+static struct lttng_capture_descriptor *
+find_capture_descriptor(const struct lttng_condition *condition,
+			const struct lttng_event_expr *expr,
+			unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		struct lttng_capture_descriptor *desc =
+			lttng_condition_event_rule_matches_get_internal_capture_descriptor_at_index(
+				condition, i);
+
+		if (lttng_event_expr_is_equal(desc->event_expression, expr)) {
+			return desc;
+		}
+	}
+
+	return nullptr;
+}
+
 enum lttng_error_code lttng_condition_event_rule_matches_generate_capture_descriptor_bytecode(
 	struct lttng_condition *condition)
 {
@@ -1398,6 +1697,7 @@ enum lttng_error_code lttng_condition_event_rule_matches_generate_capture_descri
 		struct lttng_capture_descriptor *local_capture_desc =
 			lttng_condition_event_rule_matches_get_internal_capture_descriptor_at_index(
 				condition, i);
+		struct lttng_capture_descriptor *previous_capture_desc;
 		int bytecode_ret;
 
 		if (local_capture_desc == nullptr) {
@@ -1405,6 +1705,23 @@ enum lttng_error_code lttng_condition_event_rule_matches_generate_capture_descri
 			goto end;
 		}
 
+		/*
+		 * A field captured more than once reuses the bytecode generated
+		 * for its first capture descriptor rather than generating it again.
+		 */
+		previous_capture_desc = find_capture_descriptor(
+			condition, local_capture_desc->event_expression, i);
+		if (previous_capture_desc) {
+			local_capture_desc->bytecode =
+				lttng_bytecode_copy(previous_capture_desc->bytecode);
+			if (!local_capture_desc->bytecode) {
+				ret = LTTNG_ERR_NOMEM;
+				goto end;
+			}
+
+			continue;
+		}
+
 		/* Generate the bytecode. */
 		bytecode_ret = lttng_event_expr_to_bytecode(local_capture_desc->event_expression,
 							    &local_capture_desc->bytecode);
@@ -10,4 +10,7 @@
 
 struct config_writer {
 	xmlTextWriterPtr writer;
+	/* Content of a writer created by config_writer_create_in_memory(). */
+	xmlBufferPtr buffer;
+	bool document_ended;
 };
@@ -290,9 +290,29 @@ end:
 	return out_str;
 }
 
-struct config_writer *config_writer_create(int fd_output, int indent)
+static int init_config_writer_document(struct config_writer *writer, int indent)
 {
 	int ret;
+
+	if (!writer->writer) {
+		return -1;
+	}
+
+	ret = xmlTextWriterStartDocument(writer->writer, nullptr, config_xml_encoding, nullptr);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = xmlTextWriterSetIndentString(writer->writer, BAD_CAST config_xml_indent_string);
+	if (ret) {
+		return ret;
+	}
+
+	return xmlTextWriterSetIndent(writer->writer, indent);
+}
+
+struct config_writer *config_writer_create(int fd_output, int indent)
+{
 	struct config_writer *writer;
 	xmlOutputBufferPtr buffer;
 
@@ -308,18 +328,34 @@ struct config_writer *config_writer_create(int fd_output, int indent)
 	}
 
 	writer->writer = xmlNewTextWriter(buffer);
-	ret = xmlTextWriterStartDocument(writer->writer, nullptr, config_xml_encoding, nullptr);
-	if (ret < 0) {
+	if (init_config_writer_document(writer, indent)) {
 		goto error_destroy;
 	}
 
-	ret = xmlTextWriterSetIndentString(writer->writer, BAD_CAST config_xml_indent_string);
-	if (ret) {
+end:
+	return writer;
+error_destroy:
+	config_writer_destroy(writer);
+	return nullptr;
+}
+
+struct config_writer *config_writer_create_in_memory(int indent)
+{
+	struct config_writer *writer;
+
+	writer = zmalloc<config_writer>();
+	if (!writer) {
+		PERROR("zmalloc config_writer_create_in_memory");
+		goto end;
+	}
+
+	writer->buffer = xmlBufferCreate();
+	if (!writer->buffer) {
 		goto error_destroy;
 	}
 
-	ret = xmlTextWriterSetIndent(writer->writer, indent);
-	if (ret) {
+	writer->writer = xmlNewTextWriterMemory(writer->buffer, 0);
+	if (init_config_writer_document(writer, indent)) {
 		goto error_destroy;
 	}
 
@@ -330,6 +366,38 @@ error_destroy:
 	return nullptr;
 }
 
+int config_writer_get_memory_output(struct config_writer *writer, const char **data, size_t *size)
+{
+	if (!writer || !writer->buffer || !data || !size) {
+		return -EINVAL;
+	}
+
+	if (!writer->document_ended) {
+		writer->document_ended = true;
+		if (xmlTextWriterEndDocument(writer->writer) < 0) {
+			WARN("Could not close XML document");
+			return -EIO;
+		}
+	}
+
+	if (xmlTextWriterFlush(writer->writer) < 0) {
+		return -EIO;
+	}
+
+	*data = (const char *) xmlBufferContent(writer->buffer);
+	*size = (size_t) xmlBufferLength(writer->buffer);
+	return 0;
+}
+
+int config_writer_flush(struct config_writer *writer)
+{
+	if (!writer) {
+		return -EINVAL;
+	}
+
+	return xmlTextWriterFlush(writer->writer) < 0 ? -EIO : 0;
+}
+
 int config_writer_destroy(struct config_writer *writer)
 {
 	int ret = 0;
@@ -339,7 +407,8 @@ int config_writer_destroy(struct config_writer *writer)
 		goto end;
 	}
 
-	if (xmlTextWriterEndDocument(writer->writer) < 0) {
+	if (writer->writer && !writer->document_ended &&
+	    xmlTextWriterEndDocument(writer->writer) < 0) {
 		WARN("Could not close XML document");
 		ret = -EIO;
 	}
@@ -348,6 +417,10 @@ int config_writer_destroy(struct config_writer *writer)
 		xmlFreeTextWriter(writer->writer);
 	}
 
+	if (writer->buffer) {
+		xmlBufferFree(writer->buffer);
+	}
+
 	free(writer);
 end:
 	return ret;
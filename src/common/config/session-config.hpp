@@ -37,6 +37,24 @@ struct config_writer;
  */
 struct config_writer *config_writer_create(int fd_output, int indent);
 
+/*
+ * Create an instance of a configuration writer which keeps the XML content in
+ * memory, see config_writer_get_memory_output().
+ *
+ * Returns an instance of a configuration writer on success, NULL on
+ * error.
+ */
+struct config_writer *config_writer_create_in_memory(int indent);
+
+/*
+ * Close the XML document of a writer created by
+ * config_writer_create_in_memory() and get its content, which remains valid
+ * until the writer is destroyed.
+ *
+ * Returns zero on success. Negative values indicate an error.
+ */
+int config_writer_get_memory_output(struct config_writer *writer, const char **data, size_t *size);
+
 /*
  * Destroy an instance of a configuration writer.
  *
@@ -73,6 +91,16 @@ int config_writer_write_attribute(struct config_writer *writer,
 				  const char *name,
 				  const char *value);
 
+/*
+ * Write the XML content buffered by a writer to its output, so that a reader
+ * gets the elements written so far without waiting for the document to end.
+ *
+ * writer An instance of a configuration writer.
+ *
+ * Returns zero on success. Negative values indicate an error.
+ */
+int config_writer_flush(struct config_writer *writer);
+
 /*
  * Close the current element tag.
  *
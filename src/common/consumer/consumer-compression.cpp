@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "consumer-compression.hpp"
+
+#include <common/common.hpp>
+#include <common/make-unique-wrapper.hpp>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif /* HAVE_LIBZSTD */
+
+namespace {
+enum consumer_compression_algorithm selected_algorithm = CONSUMER_COMPRESSION_ALGORITHM_NONE;
+
+#ifdef HAVE_LIBZSTD
+int zstd_level = ZSTD_CLEVEL_DEFAULT;
+
+void zstd_free_cctx(ZSTD_CCtx *cctx)
+{
+	(void) ZSTD_freeCCtx(cctx);
+}
+
+/*
+ * Compression contexts are not thread-safe; each data worker thread uses its
+ * own.
+ */
+thread_local auto zstd_cctx = lttng::make_unique_wrapper<ZSTD_CCtx, zstd_free_cctx>();
+
+ssize_t zstd_compress(const struct lttng_buffer_view *input, struct lttng_dynamic_buffer *output)
+{
+	int ret;
+	size_t compressed_size;
+
+	if (!zstd_cctx) {
+		zstd_cctx.reset(ZSTD_createCCtx());
+		if (!zstd_cctx) {
+			ERR("Failed to create zstd compression context");
+			return -1;
+		}
+
+		compressed_size =
+			ZSTD_CCtx_setParameter(zstd_cctx.get(), ZSTD_c_compressionLevel, zstd_level);
+		if (ZSTD_isError(compressed_size)) {
+			ERR("Failed to set zstd compression level: level = %d, error = %s",
+			    zstd_level,
+			    ZSTD_getErrorName(compressed_size));
+			zstd_cctx.reset();
+			return -1;
+		}
+	}
+
+	ret = lttng_dynamic_buffer_set_size(output, ZSTD_compressBound(input->size));
+	if (ret) {
+		ERR("Failed to allocate compression buffer: size = %zu",
+		    ZSTD_compressBound(input->size));
+		return -1;
+	}
+
+	compressed_size = ZSTD_compress2(
+		zstd_cctx.get(), output->data, output->size, input->data, input->size);
+	if (ZSTD_isError(compressed_size)) {
+		ERR("Failed to compress sub-buffer: size = %zu, error = %s",
+		    input->size,
+		    ZSTD_getErrorName(compressed_size));
+		return -1;
+	}
+
+	ret = lttng_dynamic_buffer_set_size(output, compressed_size);
+	LTTNG_ASSERT(ret == 0);
+	return (ssize_t) compressed_size;
+}
+#endif /* HAVE_LIBZSTD */
+} /* namespace */
+
+int consumer_compression_set_algorithm(const char *spec)
+{
+	const char *level_str = strchr(spec, ':');
+	const size_t name_len = level_str ? level_str - spec : strlen(spec);
+
+	if (name_len == strlen("none") && !strncmp(spec, "none", name_len) && !level_str) {
+		selected_algorithm = CONSUMER_COMPRESSION_ALGORITHM_NONE;
+		return 0;
+	}
+
+	if (name_len != strlen("zstd") || strncmp(spec, "zstd", name_len) != 0) {
+		ERR("Unknown trace data compression algorithm: `%s`", spec);
+		return -1;
+	}
+
+#ifdef HAVE_LIBZSTD
+	if (level_str) {
+		char *end;
+		long level;
+
+		errno = 0;
+		level = strtol(level_str + 1, &end, 10);
+		if (errno || end == level_str + 1 || *end != '\0' || level < ZSTD_minCLevel() ||
+		    level > ZSTD_maxCLevel()) {
+			ERR("Invalid zstd compression level: `%s`", level_str + 1);
+			return -1;
+		}
+
+		zstd_level = (int) level;
+	}
+
+	selected_algorithm = CONSUMER_COMPRESSION_ALGORITHM_ZSTD;
+	DBG("Trace data compression enabled: algorithm = zstd, level = %d", zstd_level);
+	return 0;
+#else
+	ERR("Trace data compression with zstd is not supported by this build");
+	return -1;
+#endif /* HAVE_LIBZSTD */
+}
+
+enum consumer_compression_algorithm consumer_compression_get_algorithm() noexcept
+{
+	return selected_algorithm;
+}
+
+const char *consumer_compression_get_stream_name_suffix() noexcept
+{
+	switch (selected_algorithm) {
+	case CONSUMER_COMPRESSION_ALGORITHM_ZSTD:
+		return ".zst";
+	default:
+		return "";
+	}
+}
+
+ssize_t consumer_compression_compress(const struct lttng_buffer_view *input,
+				      struct lttng_dynamic_buffer *output)
+{
+	LTTNG_ASSERT(input);
+	LTTNG_ASSERT(output);
+
+	switch (selected_algorithm) {
+#ifdef HAVE_LIBZSTD
+	case CONSUMER_COMPRESSION_ALGORITHM_ZSTD:
+		return zstd_compress(input, output);
+#endif /* HAVE_LIBZSTD */
+	default:
+		abort();
+	}
+}
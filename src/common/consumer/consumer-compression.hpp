@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_CONSUMER_COMPRESSION_H
+#define LTTNG_CONSUMER_COMPRESSION_H
+
+#include <common/buffer-view.hpp>
+#include <common/dynamic-buffer.hpp>
+
+#include <sys/types.h>
+
+enum consumer_compression_algorithm {
+	CONSUMER_COMPRESSION_ALGORITHM_NONE = 0,
+	CONSUMER_COMPRESSION_ALGORITHM_ZSTD = 1,
+};
+
+/*
+ * Select the algorithm used to compress the sub-buffers of data streams from
+ * a specification of the form `ALGORITHM[:LEVEL]` (e.g. `zstd`, `zstd:3`).
+ *
+ * Must be called before any stream is consumed.
+ *
+ * Return 0 on success, -1 if the specification is invalid or if the
+ * algorithm is not supported by this build.
+ */
+int consumer_compression_set_algorithm(const char *spec);
+
+enum consumer_compression_algorithm consumer_compression_get_algorithm() noexcept;
+
+/*
+ * Return the suffix appended to the names of the compressed data streams, and
+ * thus to their stream and index file names, or an empty string when
+ * compression is disabled.
+ */
+const char *consumer_compression_get_stream_name_suffix() noexcept;
+
+/*
+ * Compress the content of `input` into `output`, replacing its content.
+ *
+ * Return the size of the compressed data on success, a negative value on
+ * error.
+ */
+ssize_t consumer_compression_compress(const struct lttng_buffer_view *input,
+				      struct lttng_dynamic_buffer *output);
+
+#endif /* LTTNG_CONSUMER_COMPRESSION_H */
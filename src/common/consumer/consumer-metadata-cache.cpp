@@ -15,6 +15,7 @@
 #include <common/ust-consumer/ust-consumer.hpp>
 #include <common/utils.hpp>
 
+#include <algorithm>
 #include <inttypes.h>
 #include <pthread.h>
 #include <stdlib.h>
@@ -29,14 +30,70 @@ enum metadata_cache_update_version_status {
 
 extern struct lttng_consumer_global_data the_consumer_data;
 
+namespace {
+/* Size of the segments holding the contents of a metadata cache. */
+constexpr size_t metadata_cache_segment_size = 64 * 1024;
+} /* namespace */
+
 /*
- * Reset the metadata cache.
+ * Reset the metadata cache. Its segments are kept to be reused.
  */
 static void metadata_cache_reset(struct consumer_metadata_cache *cache)
 {
-	const int ret = lttng_dynamic_buffer_set_size(&cache->contents, 0);
+	cache->size = 0;
+}
+
+/*
+ * Allocate segments until the cache can hold `size` bytes.
+ *
+ * Return 0 on success, a negative value on error.
+ */
+static int metadata_cache_reserve(struct consumer_metadata_cache *cache, uint64_t size)
+{
+	while (lttng_dynamic_pointer_array_get_count(&cache->segments) *
+		       metadata_cache_segment_size <
+	       size) {
+		int ret;
+		char *segment = calloc<char>(metadata_cache_segment_size);
+
+		if (!segment) {
+			PERROR("Failed to allocate metadata cache segment");
+			return -1;
+		}
 
-	LTTNG_ASSERT(ret == 0);
+		ret = lttng_dynamic_pointer_array_add_pointer(&cache->segments, segment);
+		if (ret) {
+			ERR("Failed to add segment to metadata cache");
+			free(segment);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+struct lttng_buffer_view
+consumer_metadata_cache_get_view(const struct consumer_metadata_cache *cache, uint64_t offset)
+{
+	const char *segment;
+	size_t segment_offset;
+
+	LTTNG_ASSERT(cache);
+	LTTNG_ASSERT(offset <= cache->size);
+
+	if (offset == cache->size) {
+		return lttng_buffer_view_init(nullptr, 0, 0);
+	}
+
+	segment = (const char *) lttng_dynamic_pointer_array_get_pointer(
+		&cache->segments, offset / metadata_cache_segment_size);
+	segment_offset = offset % metadata_cache_segment_size;
+
+	return lttng_buffer_view_init(
+		segment,
+		segment_offset,
+		std::min<uint64_t>(cache->size - offset,
+				   metadata_cache_segment_size - segment_offset));
 }
 
 /*
@@ -82,10 +139,11 @@ consumer_metadata_cache_write(struct consumer_metadata_cache *cache,
 	enum consumer_metadata_cache_write_status status;
 	bool cache_is_invalidated = false;
 	uint64_t original_size;
+	unsigned int copied = 0;
 
 	LTTNG_ASSERT(cache);
 	ASSERT_LOCKED(cache->lock);
-	original_size = cache->contents.size;
+	original_size = cache->size;
 
 	if (metadata_cache_update_version(cache, version) ==
 	    METADATA_CACHE_UPDATE_STATUS_VERSION_UPDATED) {
@@ -94,8 +152,8 @@ consumer_metadata_cache_write(struct consumer_metadata_cache *cache,
 	}
 
 	DBG("Writing %u bytes from offset %u in metadata cache", len, offset);
-	if (offset + len > cache->contents.size) {
-		ret = lttng_dynamic_buffer_set_size(&cache->contents, offset + len);
+	if ((uint64_t) offset + len > cache->size) {
+		ret = metadata_cache_reserve(cache, (uint64_t) offset + len);
 		if (ret) {
 			ERR("Extending metadata cache");
 			status = CONSUMER_METADATA_CACHE_WRITE_STATUS_ERROR;
@@ -103,15 +161,27 @@ consumer_metadata_cache_write(struct consumer_metadata_cache *cache,
 		}
 	}
 
-	memcpy(cache->contents.data + offset, data, len);
+	while (copied < len) {
+		const uint64_t position = (uint64_t) offset + copied;
+		char *segment = (char *) lttng_dynamic_pointer_array_get_pointer(
+			&cache->segments, position / metadata_cache_segment_size);
+		const size_t segment_offset = position % metadata_cache_segment_size;
+		const size_t copy_len = std::min<size_t>(
+			len - copied, metadata_cache_segment_size - segment_offset);
+
+		memcpy(segment + segment_offset, data + copied, copy_len);
+		copied += copy_len;
+	}
+
+	cache->size = std::max<uint64_t>(cache->size, (uint64_t) offset + len);
 
 	if (cache_is_invalidated) {
 		status = CONSUMER_METADATA_CACHE_WRITE_STATUS_INVALIDATED;
-	} else if (cache->contents.size > original_size) {
+	} else if (cache->size > original_size) {
 		status = CONSUMER_METADATA_CACHE_WRITE_STATUS_APPENDED_CONTENT;
 	} else {
 		status = CONSUMER_METADATA_CACHE_WRITE_STATUS_NO_CHANGE;
-		LTTNG_ASSERT(cache->contents.size == original_size);
+		LTTNG_ASSERT(cache->size == original_size);
 	}
 
 end:
@@ -119,7 +189,7 @@ end:
 }
 
 /*
- * Create the metadata cache, original allocated size: max_sb_size
+ * Create the metadata cache. Its first segment is allocated right away.
  *
  * Return 0 on success, a negative value on error.
  */
@@ -141,23 +211,21 @@ int consumer_metadata_cache_allocate(struct lttng_consumer_channel *channel)
 		goto end_free_cache;
 	}
 
-	lttng_dynamic_buffer_init(&channel->metadata_cache->contents);
-	ret = lttng_dynamic_buffer_set_capacity(&channel->metadata_cache->contents,
-						DEFAULT_METADATA_CACHE_SIZE);
+	lttng_dynamic_pointer_array_init(&channel->metadata_cache->segments, free);
+	ret = metadata_cache_reserve(channel->metadata_cache, 1);
 	if (ret) {
-		PERROR("Failed to pre-allocate metadata cache storage of %d bytes on creation",
-		       DEFAULT_METADATA_CACHE_SIZE);
+		ERR("Failed to pre-allocate metadata cache storage on creation");
 		ret = -1;
-		goto end_free_mutex;
+		goto end_free_segments;
 	}
 
-	DBG("Allocated metadata cache: current capacity = %zu",
-	    lttng_dynamic_buffer_get_capacity_left(&channel->metadata_cache->contents));
+	DBG("Allocated metadata cache: segment size = %zu", metadata_cache_segment_size);
 
 	ret = 0;
 	goto end;
 
-end_free_mutex:
+end_free_segments:
+	lttng_dynamic_pointer_array_reset(&channel->metadata_cache->segments);
 	pthread_mutex_destroy(&channel->metadata_cache->lock);
 end_free_cache:
 	free(channel->metadata_cache);
@@ -177,7 +245,7 @@ void consumer_metadata_cache_destroy(struct lttng_consumer_channel *channel)
 	DBG("Destroying metadata cache");
 
 	pthread_mutex_destroy(&channel->metadata_cache->lock);
-	lttng_dynamic_buffer_reset(&channel->metadata_cache->contents);
+	lttng_dynamic_pointer_array_reset(&channel->metadata_cache->segments);
 	free(channel->metadata_cache);
 }
 
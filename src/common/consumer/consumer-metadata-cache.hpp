@@ -9,8 +9,9 @@
 #ifndef CONSUMER_METADATA_CACHE_H
 #define CONSUMER_METADATA_CACHE_H
 
+#include <common/buffer-view.hpp>
 #include <common/consumer/consumer.hpp>
-#include <common/dynamic-buffer.hpp>
+#include <common/dynamic-array.hpp>
 
 enum consumer_metadata_cache_write_status {
 	CONSUMER_METADATA_CACHE_WRITE_STATUS_ERROR = -1,
@@ -37,10 +38,18 @@ struct consumer_metadata_cache {
 	/* Current version of the metadata cache. */
 	uint64_t version;
 	/*
-	 * Size is the upper-limit of data written inside the buffer.
-	 * All cached data is contiguous.
+	 * Size is the upper-limit of data written inside the cache.
+	 * The data is split across the segments: the byte at offset N is
+	 * in segment N / 64 KiB. Only the bytes of a single segment are
+	 * contiguous.
 	 */
-	struct lttng_dynamic_buffer contents;
+	uint64_t size;
+	/*
+	 * Fixed-size segments holding the cached data, in order. Segments are
+	 * never moved or reallocated: views of the cache remain valid as it
+	 * grows and segments are reused when the cache is invalidated.
+	 */
+	struct lttng_dynamic_pointer_array segments;
 	/*
 	 * Lock to update the metadata cache and push into the ring_buffer
 	 * (lttng_ust_ctl_write_metadata_to_channel).
@@ -56,6 +65,14 @@ consumer_metadata_cache_write(struct consumer_metadata_cache *cache,
 			      unsigned int len,
 			      uint64_t version,
 			      const char *data);
+/*
+ * Return a view of the cached data from `offset` up to the end of the segment
+ * holding it, or to the end of the cached data if it comes first. The view is
+ * empty if `offset` is the size of the cache. The metadata cache lock MUST be
+ * held.
+ */
+struct lttng_buffer_view
+consumer_metadata_cache_get_view(const struct consumer_metadata_cache *cache, uint64_t offset);
 int consumer_metadata_cache_allocate(struct lttng_consumer_channel *channel);
 void consumer_metadata_cache_destroy(struct lttng_consumer_channel *channel);
 void consumer_wait_metadata_cache_flushed(struct lttng_consumer_channel *channel,
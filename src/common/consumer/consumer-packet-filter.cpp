@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "consumer-packet-filter.hpp"
+
+#include <common/common.hpp>
+
+#include <algorithm>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+const unsigned long default_backlog_subbuffers = 4;
+
+/* Keep one in `keep_one_in` packets, 0 when sampling is disabled. */
+unsigned int keep_one_in;
+unsigned long backlog_subbuffers = default_backlog_subbuffers;
+std::vector<std::string> exempt_channels;
+
+int parse_ulong(const char *str, char **end, unsigned long max, unsigned long *value)
+{
+	errno = 0;
+	*value = strtoul(str, end, 10);
+	if (errno || *end == str || *str == '-' || *value > max) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Return true if the stream has at least `backlog_subbuffers` sub-buffers ready. */
+bool stream_is_lagging(struct lttng_consumer_stream *stream)
+{
+	int ret;
+	unsigned long produced_pos, consumed_pos;
+
+	ret = lttng_consumer_sample_snapshot_positions(stream);
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = lttng_consumer_get_produced_snapshot(stream, &produced_pos);
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = lttng_consumer_get_consumed_snapshot(stream, &consumed_pos);
+	if (ret < 0) {
+		goto error;
+	}
+
+	/* The sub-buffer being sampled is included in the backlog. */
+	return produced_pos - consumed_pos >= backlog_subbuffers * stream->max_sb_size;
+
+error:
+	/* Never drop a packet without knowing the stream is lagging. */
+	DBG("Failed to sample the positions of stream %" PRIu64 ", keeping packet", stream->key);
+	return false;
+}
+} /* namespace */
+
+int consumer_packet_filter_set_policy(const char *spec)
+{
+	char *end;
+	unsigned long n, backlog = default_backlog_subbuffers;
+
+	if (parse_ulong(spec, &end, UINT_MAX, &n)) {
+		goto invalid;
+	}
+
+	if (*end == ':') {
+		const char *backlog_str = end + 1;
+
+		if (parse_ulong(backlog_str, &end, ULONG_MAX, &backlog) || backlog == 0) {
+			goto invalid;
+		}
+	}
+
+	if (*end != '\0') {
+		goto invalid;
+	}
+
+	keep_one_in = n > 1 ? n : 0;
+	backlog_subbuffers = backlog;
+	if (keep_one_in) {
+		DBG("Packet sampling enabled: keep one in %u packets, backlog = %lu sub-buffers",
+		    keep_one_in,
+		    backlog_subbuffers);
+	}
+
+	return 0;
+
+invalid:
+	ERR("Invalid packet sampling specification: `%s`", spec);
+	return -1;
+}
+
+int consumer_packet_filter_set_exempt_channels(const char *channel_names)
+{
+	try {
+		const char *name = channel_names;
+
+		exempt_channels.clear();
+		while (*name != '\0') {
+			const char *separator = strchr(name, ',');
+			const size_t len = separator ? separator - name : strlen(name);
+
+			if (len > 0) {
+				exempt_channels.emplace_back(name, len);
+			}
+
+			name += len + (separator ? 1 : 0);
+		}
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate the list of channels exempt from packet sampling");
+		return -1;
+	}
+
+	return 0;
+}
+
+bool consumer_packet_filter_applies(const struct lttng_consumer_channel *channel)
+{
+	if (!keep_one_in || channel->type == CONSUMER_CHANNEL_TYPE_METADATA) {
+		return false;
+	}
+
+	return std::find(exempt_channels.begin(), exempt_channels.end(), channel->name) ==
+		exempt_channels.end();
+}
+
+enum filter_subbuffer_verdict
+consumer_packet_filter_sample(struct lttng_consumer_stream *stream,
+			      const struct stream_subbuffer *subbuffer __attribute__((unused)))
+{
+	if (!stream_is_lagging(stream)) {
+		stream->packet_filter.dropped_in_a_row = 0;
+		return FILTER_SUBBUFFER_VERDICT_KEEP;
+	}
+
+	if (stream->packet_filter.dropped_in_a_row + 1 >= keep_one_in) {
+		stream->packet_filter.dropped_in_a_row = 0;
+		return FILTER_SUBBUFFER_VERDICT_KEEP;
+	}
+
+	stream->packet_filter.dropped_in_a_row++;
+	stream->packet_filter.dropped_count++;
+	DBG3("Dropped packet of lagging stream %" PRIu64 ": dropped count = %" PRIu64,
+	     stream->key,
+	     stream->packet_filter.dropped_count);
+	return FILTER_SUBBUFFER_VERDICT_DROP;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_CONSUMER_PACKET_FILTER_H
+#define LTTNG_CONSUMER_PACKET_FILTER_H
+
+#include <common/consumer/consumer.hpp>
+
+/*
+ * Packet sampling stage of the data streams.
+ *
+ * When a data stream lags behind its producers, typically because its output
+ * can't keep up, the consumer daemon keeps only one in N of its packets and
+ * releases the others without consuming them. This bounds the time spent on
+ * each stream so that the tracers don't have to discard packets arbitrarily
+ * because of a full ring buffer.
+ *
+ * The metadata streams and the streams of exempt channels are never sampled.
+ * The dropped packets show up as gaps in the sequence numbers of the packets
+ * and index entries which follow and are accounted as lost packets.
+ */
+
+/*
+ * Enable packet sampling from a specification of the form `N[:BACKLOG]`:
+ * keep one in N packets of each data stream which has at least BACKLOG
+ * sub-buffers ready to be consumed. `0` and `1` disable sampling.
+ *
+ * Must be called before any stream is created.
+ *
+ * Return 0 on success, -1 if the specification is invalid.
+ */
+int consumer_packet_filter_set_policy(const char *spec);
+
+/*
+ * Exempt a comma-separated list of channels from packet sampling.
+ *
+ * Must be called before any stream is created.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int consumer_packet_filter_set_exempt_channels(const char *channel_names);
+
+/* Return true if the packets of the data streams of `channel` are sampled. */
+bool consumer_packet_filter_applies(const struct lttng_consumer_channel *channel);
+
+/*
+ * Sample a sub-buffer of a data stream, see filter_subbuffer_cb.
+ */
+enum filter_subbuffer_verdict
+consumer_packet_filter_sample(struct lttng_consumer_stream *stream,
+			      const struct stream_subbuffer *subbuffer);
+
+#endif /* LTTNG_CONSUMER_PACKET_FILTER_H */
@@ -0,0 +1,433 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "consumer-relayd-spill.hpp"
+
+#include <common/common.hpp>
+#include <common/consumer/consumer.hpp>
+#include <common/defaults.hpp>
+#include <common/pipe.hpp>
+#include <common/readwrite.hpp>
+#include <common/urcu.hpp>
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+/* Period at which the spill thread replays the pending spill queues. */
+const int replay_period_ms = 10;
+const size_t replay_chunk_size = 64 * 1024;
+
+std::string spill_directory;
+uint64_t spill_max_size = DEFAULT_CONSUMERD_RELAYD_SPILL_MAX_SIZE;
+struct lttng_pipe *quit_pipe;
+
+/* Holds the spilled bytes read back before sending them. */
+thread_local std::vector<char> replay_buffer;
+
+size_t iov_total_len(const struct iovec *iov, int iovcnt)
+{
+	size_t len = 0;
+
+	for (int i = 0; i < iovcnt; i++) {
+		len += iov[i].iov_len;
+	}
+
+	return len;
+}
+
+/* Skip the first `len` bytes of an I/O vector. */
+void iov_advance(struct iovec **iov, int *iovcnt, size_t len)
+{
+	while (*iovcnt > 0 && len >= (*iov)->iov_len) {
+		len -= (*iov)->iov_len;
+		(*iov)++;
+		(*iovcnt)--;
+	}
+
+	if (len > 0) {
+		LTTNG_ASSERT(*iovcnt > 0);
+		(*iov)->iov_base = (char *) (*iov)->iov_base + len;
+		(*iov)->iov_len -= len;
+	}
+}
+
+/* Return true if `len` more bytes can be appended to the queue. */
+bool spill_has_room(struct consumer_relayd_spill *spill, size_t len)
+{
+	if (spill->fd < 0) {
+		spill->fd = open(spill_directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+		if (spill->fd < 0) {
+			PERROR("Failed to create relayd spill file: directory = `%s`",
+			       spill_directory.c_str());
+			return false;
+		}
+	}
+
+	return (uint64_t) spill->write_offset + len <= spill_max_size;
+}
+
+int spill_append(struct consumer_relayd_spill *spill, struct iovec *iov, int iovcnt)
+{
+	while (iovcnt > 0) {
+		const ssize_t ret = pwritev(spill->fd, iov, iovcnt, spill->write_offset);
+
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			PERROR("Failed to append to relayd spill file");
+			return -1;
+		}
+
+		spill->write_offset += ret;
+		iov_advance(&iov, &iovcnt, ret);
+	}
+
+	return 0;
+}
+
+void spill_reset(struct consumer_relayd_spill *spill)
+{
+	spill->read_offset = 0;
+	spill->write_offset = 0;
+	if (spill->fd >= 0 && ftruncate(spill->fd, 0)) {
+		PERROR("Failed to truncate relayd spill file");
+	}
+}
+
+/*
+ * Send the pending bytes of the queue. Return 0 once the queue is empty or,
+ * unless `blocking` is set, when the socket is congested. Else, -1 with errno
+ * set.
+ */
+int spill_send(struct consumer_relayd_spill *spill, int sock_fd, bool blocking)
+{
+	const int flags = MSG_NOSIGNAL | (blocking ? 0 : MSG_DONTWAIT);
+
+	try {
+		replay_buffer.resize(replay_chunk_size);
+	} catch (const std::bad_alloc&) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	while (consumer_relayd_spill_is_pending(spill)) {
+		const size_t len = std::min<uint64_t>(replay_chunk_size,
+						      spill->write_offset - spill->read_offset);
+		ssize_t ret;
+
+		ret = pread(spill->fd, replay_buffer.data(), len, spill->read_offset);
+		if (ret <= 0) {
+			if (ret < 0 && errno == EINTR) {
+				continue;
+			}
+
+			if (ret == 0) {
+				errno = EIO;
+			}
+
+			PERROR("Failed to read relayd spill file");
+			return -1;
+		}
+
+		ret = send(sock_fd, replay_buffer.data(), ret, flags);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (!blocking && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				return 0;
+			}
+
+			return -1;
+		}
+
+		spill->read_offset += ret;
+	}
+
+	spill_reset(spill);
+	return 0;
+}
+
+/*
+ * Replay the pending spill queues of the data connections of all relay
+ * daemons. Connections used by the data path are skipped until the next
+ * period.
+ */
+void replay_all_spill_queues()
+{
+	struct lttng_ht_iter iter;
+	struct consumer_relayd_sock_pair *relayd;
+	lttng::urcu::read_lock_guard read_lock;
+
+	if (!the_consumer_data.relayd_ht) {
+		return;
+	}
+
+	cds_lfht_for_each_entry (the_consumer_data.relayd_ht->ht, &iter.iter, relayd, node.node) {
+		unsigned int data_sock_count;
+
+		if (uatomic_read(&relayd->destroyed)) {
+			continue;
+		}
+
+		data_sock_count = uatomic_read(&relayd->data_sock_count);
+		/* Pairs with the barrier in consumer_add_relayd_socket(). */
+		cmm_smp_rmb();
+		for (unsigned int i = 0; i < data_sock_count; i++) {
+			struct consumer_relayd_data_sock *data_sock = &relayd->data_socks[i];
+
+			if (pthread_mutex_trylock(&data_sock->lock)) {
+				continue;
+			}
+
+			if (consumer_relayd_spill_is_pending(&data_sock->spill) &&
+			    consumer_relayd_spill_replay(&data_sock->spill,
+							 data_sock->sock.sock.fd)) {
+				/*
+				 * The data path detects the hang up of the relayd
+				 * on its next packet.
+				 */
+				DBG("Failed to replay relayd spill queue, dropping it: "
+				    "relayd = %" PRIu64 ", data connection = %u",
+				    relayd->net_seq_idx,
+				    i);
+				spill_reset(&data_sock->spill);
+			}
+
+			pthread_mutex_unlock(&data_sock->lock);
+		}
+	}
+}
+} /* namespace */
+
+int consumer_relayd_spill_set_directory(const char *path)
+{
+	try {
+		spill_directory = path;
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate relayd spill directory path");
+		return -1;
+	}
+
+	if (!quit_pipe) {
+		quit_pipe = lttng_pipe_open(FD_CLOEXEC);
+		if (!quit_pipe) {
+			ERR("Failed to create the relayd spill thread quit pipe");
+			spill_directory.clear();
+			return -1;
+		}
+	}
+
+	DBG("Relayd spill queues enabled: directory = `%s`, maximal size = %" PRIu64 " bytes",
+	    path,
+	    spill_max_size);
+	return 0;
+}
+
+int consumer_relayd_spill_set_max_size(const char *size)
+{
+	uint64_t max_size;
+
+	if (utils_parse_size_suffix(size, &max_size) || max_size == 0) {
+		ERR("Invalid relayd spill queue size: `%s`", size);
+		return -1;
+	}
+
+	spill_max_size = max_size;
+	return 0;
+}
+
+bool consumer_relayd_spill_is_enabled() noexcept
+{
+	return !spill_directory.empty();
+}
+
+void consumer_relayd_spill_init(struct consumer_relayd_spill *spill)
+{
+	spill->fd = -1;
+	spill->read_offset = 0;
+	spill->write_offset = 0;
+}
+
+void consumer_relayd_spill_fini(struct consumer_relayd_spill *spill)
+{
+	if (spill->fd >= 0 && close(spill->fd)) {
+		PERROR("Failed to close relayd spill file");
+	}
+
+	consumer_relayd_spill_init(spill);
+}
+
+ssize_t consumer_relayd_spill_sendv(struct consumer_relayd_spill *spill,
+				    int sock_fd,
+				    struct iovec *iov,
+				    int iovcnt,
+				    size_t trailing_len,
+				    size_t *spilled_len)
+{
+	const size_t len = iov_total_len(iov, iovcnt);
+	struct msghdr msg = {};
+	ssize_t ret;
+	size_t sent;
+
+	*spilled_len = 0;
+
+	if (!consumer_relayd_spill_is_enabled()) {
+		return lttng_writev(sock_fd, iov, iovcnt);
+	}
+
+	if (consumer_relayd_spill_is_pending(spill)) {
+		if (consumer_relayd_spill_replay(spill, sock_fd)) {
+			return -1;
+		}
+	}
+
+	if (consumer_relayd_spill_is_pending(spill)) {
+		if (spill_has_room(spill, len + trailing_len)) {
+			goto spill_remaining;
+		}
+
+		/* The queue is full: block until it is sent before this packet. */
+		if (spill_send(spill, sock_fd, true)) {
+			return -1;
+		}
+	}
+
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+	do {
+		ret = sendmsg(sock_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			return -1;
+		}
+
+		ret = 0;
+	}
+
+	sent = ret;
+	if (sent == len) {
+		return len;
+	}
+
+	iov_advance(&iov, &iovcnt, sent);
+	if (!spill_has_room(spill, len - sent + trailing_len)) {
+		ret = lttng_writev(sock_fd, iov, iovcnt);
+		if (ret < 0 || (size_t) ret != len - sent) {
+			return -1;
+		}
+
+		return len;
+	}
+
+spill_remaining:
+	*spilled_len = iov_total_len(iov, iovcnt);
+	if (spill_append(spill, iov, iovcnt)) {
+		errno = EIO;
+		return -1;
+	}
+
+	return len;
+}
+
+ssize_t consumer_relayd_spill_splice(struct consumer_relayd_spill *spill, int pipe_fd, size_t len)
+{
+	loff_t offset = spill->write_offset;
+	size_t spliced = 0;
+
+	LTTNG_ASSERT(consumer_relayd_spill_is_pending(spill));
+
+	while (spliced < len) {
+		const ssize_t ret =
+			splice(pipe_fd, nullptr, spill->fd, &offset, len - spliced, SPLICE_F_MOVE);
+
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			PERROR("Failed to splice to relayd spill file");
+			return -1;
+		} else if (ret == 0) {
+			break;
+		}
+
+		spliced += ret;
+	}
+
+	spill->write_offset = offset;
+	return spliced;
+}
+
+int consumer_relayd_spill_replay(struct consumer_relayd_spill *spill, int sock_fd)
+{
+	return spill_send(spill, sock_fd, false);
+}
+
+void *consumer_relayd_spill_thread(void *data __attribute__((unused)))
+{
+	struct pollfd quit_pollfd = {};
+
+	rcu_register_thread();
+
+	DBG("Relayd spill thread started");
+
+	quit_pollfd.fd = lttng_pipe_get_readfd(quit_pipe);
+	quit_pollfd.events = POLLIN;
+	while (true) {
+		const int ret = poll(&quit_pollfd, 1, replay_period_ms);
+
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			PERROR("Relayd spill thread poll");
+			break;
+		}
+
+		if (ret > 0) {
+			/* Quit requested. */
+			break;
+		}
+
+		replay_all_spill_queues();
+	}
+
+	DBG("Relayd spill thread exiting");
+	rcu_unregister_thread();
+	return nullptr;
+}
+
+int consumer_relayd_spill_thread_quit()
+{
+	const char dummy = 'q';
+	ssize_t ret;
+
+	ret = lttng_pipe_write(quit_pipe, &dummy, sizeof(dummy));
+	if (ret != sizeof(dummy)) {
+		PERROR("write to the relayd spill thread quit pipe");
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_CONSUMER_RELAYD_SPILL_H
+#define LTTNG_CONSUMER_RELAYD_SPILL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/*
+ * Spill queue of a relayd data connection.
+ *
+ * When the socket of a data connection can't accept a packet without
+ * blocking, the bytes which could not be sent are appended to an unlinked
+ * local file instead. As long as the queue is not empty, the following
+ * packets of the connection are appended to it too so that the relayd keeps
+ * receiving the bytes of the connection in order. The queue is replayed on
+ * the socket, without blocking, by the data path and by a dedicated thread.
+ *
+ * A full queue is first replayed by blocking on the socket, which resumes
+ * the back-pressure on the streams of the connection.
+ *
+ * The queue is protected by the lock of its data connection.
+ */
+struct consumer_relayd_spill {
+	/* Unlinked file holding the spilled bytes, -1 until it is needed. */
+	int fd;
+	/* Offset of the next spilled byte to send on the socket. */
+	off_t read_offset;
+	/* Size of the file: the bytes from `read_offset` on are pending. */
+	off_t write_offset;
+};
+
+/*
+ * Enable spilling by setting the directory in which the spill files are
+ * created.
+ *
+ * Must be called before any relayd connection is used.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int consumer_relayd_spill_set_directory(const char *path);
+
+/*
+ * Set the maximal size of the spill file of a data connection from a size
+ * with an optional `k`, `M` or `G` suffix.
+ *
+ * Return 0 on success, -1 if the size is invalid.
+ */
+int consumer_relayd_spill_set_max_size(const char *size);
+
+bool consumer_relayd_spill_is_enabled() noexcept;
+
+void consumer_relayd_spill_init(struct consumer_relayd_spill *spill);
+void consumer_relayd_spill_fini(struct consumer_relayd_spill *spill);
+
+static inline bool consumer_relayd_spill_is_pending(const struct consumer_relayd_spill *spill)
+{
+	return spill->read_offset != spill->write_offset;
+}
+
+/*
+ * Send the bytes of `iov` on `sock_fd`, appending them to the spill queue
+ * rather than blocking when the socket is congested. `iov` is modified.
+ *
+ * `trailing_len` bytes, which the caller appends with
+ * consumer_relayd_spill_splice() when the queue is pending on return, must
+ * follow the bytes of `iov` without being interleaved with other bytes.
+ *
+ * `spilled_len` is set to the number of bytes of `iov` appended to the queue.
+ *
+ * Return the number of bytes of `iov` either sent or spilled on success, else
+ * -1 with errno set.
+ */
+ssize_t consumer_relayd_spill_sendv(struct consumer_relayd_spill *spill,
+				    int sock_fd,
+				    struct iovec *iov,
+				    int iovcnt,
+				    size_t trailing_len,
+				    size_t *spilled_len);
+
+/*
+ * Append `len` bytes of `pipe_fd` to a pending spill queue.
+ *
+ * Return the number of bytes spliced, else -1 with errno set.
+ */
+ssize_t consumer_relayd_spill_splice(struct consumer_relayd_spill *spill, int pipe_fd, size_t len);
+
+/*
+ * Replay a pending spill queue on `sock_fd` until it is empty or the socket
+ * is congested.
+ *
+ * Return 0 on success, else -1 with errno set.
+ */
+int consumer_relayd_spill_replay(struct consumer_relayd_spill *spill, int sock_fd);
+
+/*
+ * Thread replaying the spill queues of all the relayd data connections
+ * periodically, until consumer_relayd_spill_thread_quit() is called.
+ */
+void *consumer_relayd_spill_thread(void *data);
+
+int consumer_relayd_spill_thread_quit();
+
+#endif /* LTTNG_CONSUMER_RELAYD_SPILL_H */
@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "consumer-snapshot.hpp"
+
+#include <common/common.hpp>
+#include <common/defaults.hpp>
+#include <common/readwrite.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/time.hpp>
+
+#include <lttng/health-internal.hpp>
+
+#include <algorithm>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <urcu.h>
+#include <urcu/uatomic.h>
+
+namespace {
+unsigned int snapshot_thread_count = DEFAULT_CONSUMERD_SNAPSHOT_THREAD_COUNT;
+
+/* Outcome of the recording of one stream. */
+struct stream_result {
+	int ret = 0;
+	uint64_t lost_packets = 0;
+	uint64_t packets = 0;
+	uint64_t bytes = 0;
+	uint64_t duration_ns = 0;
+};
+
+/* Work shared by the threads recording the streams of a snapshot. */
+struct snapshot_job {
+	const std::vector<consumer_snapshot_stream> *streams;
+	const struct consumer_snapshot_ops *ops;
+	bool use_relayd;
+	bool incremental;
+	/* Index of the next stream to record. */
+	unsigned long next_stream;
+	std::vector<stream_result> results;
+};
+
+uint64_t monotonic_ns()
+{
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now)) {
+		return 0;
+	}
+
+	return (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+/*
+ * Write the header and path of a record. The lock of the output must be held.
+ *
+ * Return 0 on success, else a negative errno value.
+ */
+int write_record_header(struct consumer_snapshot_fd_output *output,
+			const struct lttng_consumer_stream *stream,
+			uint64_t payload_len)
+{
+	char record[sizeof(struct consumer_snapshot_fd_record_header) + LTTNG_PATH_MAX];
+	struct consumer_snapshot_fd_record_header header = {};
+	const size_t path_len = strlen(output->path);
+	const bool add_separator = path_len > 0 && output->path[path_len - 1] != '/';
+	int ret;
+
+	ret = snprintf(record + sizeof(header),
+		       sizeof(record) - sizeof(header),
+		       "%s%s%s",
+		       output->path,
+		       add_separator ? "/" : "",
+		       stream->name);
+	if (ret < 0 || ret >= sizeof(record) - sizeof(header)) {
+		ERR("Snapshot record path of stream `%s` is too long", stream->name);
+		return -ENAMETOOLONG;
+	}
+
+	header.magic = CONSUMER_SNAPSHOT_FD_RECORD_MAGIC;
+	header.path_len = ret;
+	header.payload_len = payload_len;
+	memcpy(record, &header, sizeof(header));
+
+	if (lttng_write(output->fd, record, sizeof(header) + header.path_len) !=
+	    sizeof(header) + header.path_len) {
+		PERROR("Failed to write snapshot record header of stream `%s`", stream->name);
+		return -errno;
+	}
+
+	return 0;
+}
+
+void record_stream(const consumer_snapshot_stream& snapshot_stream,
+		   const struct consumer_snapshot_ops *ops,
+		   bool use_relayd,
+		   bool incremental,
+		   stream_result& result)
+{
+	struct lttng_consumer_stream *stream = snapshot_stream.stream;
+	unsigned long consumed_pos = snapshot_stream.consumed_pos;
+	const unsigned long produced_pos = snapshot_stream.produced_pos;
+	const uint64_t start_ns = monotonic_ns();
+	int ret = 0;
+
+	/*
+	 * Resume after the packets recorded by the previous snapshot of the
+	 * stream, unless they have since been overwritten.
+	 */
+	if (incremental && stream->has_last_snapshot &&
+	    (long) (stream->last_snapshot_produced_pos - consumed_pos) > 0) {
+		DBG("Incremental snapshot of stream %" PRIu64 " skips %lu bytes already recorded",
+		    stream->key,
+		    stream->last_snapshot_produced_pos - consumed_pos);
+		consumed_pos = stream->last_snapshot_produced_pos;
+	}
+
+	while ((long) (consumed_pos - produced_pos) < 0) {
+		ssize_t read_len;
+		unsigned long len, padded_len, expected_len;
+		const char *subbuf_addr;
+		struct lttng_buffer_view subbuf_view;
+
+		health_code_update();
+		DBG("Consumer taking snapshot of stream %" PRIu64 " at pos %lu",
+		    stream->key,
+		    consumed_pos);
+
+		ret = ops->get_subbuf(stream, &consumed_pos);
+		if (ret < 0) {
+			if (ret != -EAGAIN) {
+				PERROR("Failed to get sub-buffer during snapshot");
+				goto end;
+			}
+			DBG("Consumer get subbuf failed. Skipping it.");
+			consumed_pos += stream->max_sb_size;
+			result.lost_packets++;
+			ret = 0;
+			continue;
+		}
+
+		ret = ops->get_subbuf_size(stream, &len);
+		if (ret < 0) {
+			ERR("Failed to get sub-buffer size during snapshot");
+			goto error_put_subbuf;
+		}
+
+		ret = ops->get_padded_subbuf_size(stream, &padded_len);
+		if (ret < 0) {
+			ERR("Failed to get padded sub-buffer size during snapshot");
+			goto error_put_subbuf;
+		}
+
+		ret = ops->get_subbuf_addr(stream, &subbuf_addr);
+		if (ret) {
+			goto error_put_subbuf;
+		}
+
+		subbuf_view = lttng_buffer_view_init(subbuf_addr, 0, padded_len);
+		read_len = lttng_consumer_on_read_subbuffer_mmap(stream, &subbuf_view, padded_len - len);
+
+		/* The padded len is written in local tracefiles, the data len is sent to a relay. */
+		expected_len = use_relayd ? len : padded_len;
+		if (read_len != expected_len) {
+			if (ops->abort_on_short_write) {
+				ret = -EPERM;
+				goto error_put_subbuf;
+			}
+
+			/* Display the error but continue to try to release the sub-buffer. */
+			ERR("Error %s during snapshot (ret: %zd != len: %lu)",
+			    use_relayd ? "sending to the relay" : "writing to tracefile",
+			    read_len,
+			    expected_len);
+		} else {
+			result.bytes += read_len;
+		}
+
+		ret = ops->put_subbuf(stream);
+		if (ret < 0) {
+			ERR("Failed to put sub-buffer during snapshot");
+			goto end;
+		}
+
+		result.packets++;
+		consumed_pos += stream->max_sb_size;
+	}
+
+	goto end;
+
+error_put_subbuf:
+	if (ops->put_subbuf(stream) < 0) {
+		ERR("Failed to put sub-buffer during snapshot error path");
+	}
+end:
+	result.ret = ret;
+	result.duration_ns = monotonic_ns() - start_ns;
+}
+
+void run_snapshot_job(snapshot_job& job)
+{
+	for (;;) {
+		const unsigned long index = uatomic_add_return(&job.next_stream, 1) - 1;
+
+		if (index >= job.streams->size()) {
+			break;
+		}
+
+		record_stream((*job.streams)[index],
+			      job.ops,
+			      job.use_relayd,
+			      job.incremental,
+			      job.results[index]);
+	}
+}
+
+void *snapshot_worker(void *data)
+{
+	auto *job = static_cast<snapshot_job *>(data);
+
+	rcu_register_thread();
+	run_snapshot_job(*job);
+	rcu_unregister_thread();
+	return nullptr;
+}
+} /* namespace */
+
+int consumer_snapshot_recv_output_fd(int sock, int *fd)
+{
+	ssize_t ret;
+
+	ret = consumer_send_status_msg(sock, LTTCOMM_CONSUMERD_SUCCESS);
+	if (ret < 0) {
+		/* Somehow, the session daemon is not responding anymore. */
+		return -1;
+	}
+
+	ret = lttcomm_recv_fds_unix_sock(sock, fd, 1);
+	if (ret != sizeof(*fd)) {
+		ERR("Failed to receive snapshot output file descriptor");
+		return -1;
+	}
+
+	DBG("Received snapshot output fd (%d)", *fd);
+	return 0;
+}
+
+void consumer_snapshot_fd_output_init(struct consumer_snapshot_fd_output *output,
+				      int fd,
+				      const char *path)
+{
+	output->fd = fd;
+	output->path = path;
+	pthread_mutex_init(&output->lock, nullptr);
+}
+
+void consumer_snapshot_fd_output_fini(struct consumer_snapshot_fd_output *output)
+{
+	if (close(output->fd)) {
+		PERROR("Failed to close snapshot output file descriptor");
+	}
+
+	output->fd = -1;
+	pthread_mutex_destroy(&output->lock);
+}
+
+ssize_t consumer_snapshot_fd_output_write(struct consumer_snapshot_fd_output *output,
+					  const struct lttng_consumer_stream *stream,
+					  const struct lttng_buffer_view *packet)
+{
+	ssize_t ret;
+
+	pthread_mutex_lock(&output->lock);
+	ret = write_record_header(output, stream, packet->size);
+	if (ret < 0) {
+		goto end;
+	}
+
+	/* Written straight from the mapping of the ring buffer. */
+	ret = lttng_write(output->fd, packet->data, packet->size);
+	if (ret != packet->size) {
+		PERROR("Failed to write snapshot record of stream `%s`", stream->name);
+		ret = -errno;
+		goto end;
+	}
+end:
+	pthread_mutex_unlock(&output->lock);
+	return ret;
+}
+
+ssize_t consumer_snapshot_fd_output_splice(struct consumer_snapshot_fd_output *output,
+					   const struct lttng_consumer_stream *stream,
+					   int in_fd,
+					   const int *splice_pipe,
+					   size_t len)
+{
+	ssize_t ret;
+	loff_t offset = 0;
+	size_t left = len;
+
+	pthread_mutex_lock(&output->lock);
+	ret = write_record_header(output, stream, len);
+	if (ret < 0) {
+		goto end;
+	}
+
+	while (left > 0) {
+		ssize_t in_pipe;
+
+		in_pipe = splice(in_fd,
+				 &offset,
+				 splice_pipe[1],
+				 nullptr,
+				 left,
+				 SPLICE_F_MOVE | SPLICE_F_MORE);
+		if (in_pipe <= 0) {
+			PERROR("Failed to splice snapshot record of stream `%s`", stream->name);
+			ret = in_pipe < 0 ? -errno : -EIO;
+			goto end;
+		}
+
+		left -= in_pipe;
+		while (in_pipe > 0) {
+			const ssize_t out = splice(splice_pipe[0],
+						   nullptr,
+						   output->fd,
+						   nullptr,
+						   in_pipe,
+						   SPLICE_F_MOVE | SPLICE_F_MORE);
+
+			if (out <= 0) {
+				PERROR("Failed to splice snapshot record of stream `%s` to output",
+				       stream->name);
+				ret = out < 0 ? -errno : -EIO;
+				goto end;
+			}
+
+			in_pipe -= out;
+		}
+	}
+
+	ret = len;
+end:
+	pthread_mutex_unlock(&output->lock);
+	return ret;
+}
+
+void consumer_snapshot_set_thread_count(unsigned int count)
+{
+	LTTNG_ASSERT(count > 0);
+	snapshot_thread_count = count;
+}
+
+int consumer_snapshot_record_streams(const std::vector<consumer_snapshot_stream>& streams,
+				     const struct consumer_snapshot_ops *ops,
+				     bool use_relayd,
+				     bool incremental)
+{
+	int ret = 0;
+	snapshot_job job;
+	std::vector<pthread_t> workers;
+	unsigned long worker_count;
+
+	if (streams.empty()) {
+		return 0;
+	}
+
+	worker_count = std::min<unsigned long>(snapshot_thread_count, streams.size()) - 1;
+
+	job.streams = &streams;
+	job.ops = ops;
+	job.use_relayd = use_relayd;
+	job.incremental = incremental;
+	job.next_stream = 0;
+
+	try {
+		job.results.resize(streams.size());
+		workers.reserve(worker_count);
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate snapshot job of %zu streams", streams.size());
+		return -ENOMEM;
+	}
+
+	for (unsigned long i = 0; i < worker_count; i++) {
+		pthread_t worker;
+		const int create_ret =
+			pthread_create(&worker, default_pthread_attr(), snapshot_worker, &job);
+
+		if (create_ret) {
+			/* Carry on with the threads launched so far. */
+			errno = create_ret;
+			PERROR("Failed to launch snapshot worker thread");
+			break;
+		}
+
+		workers.push_back(worker);
+	}
+
+	/* The calling thread records streams too. */
+	run_snapshot_job(job);
+
+	for (const auto worker : workers) {
+		const int join_ret = pthread_join(worker, nullptr);
+
+		if (join_ret) {
+			errno = join_ret;
+			PERROR("Failed to join snapshot worker thread");
+		}
+	}
+
+	for (size_t i = 0; i < streams.size(); i++) {
+		struct lttng_consumer_stream *stream = streams[i].stream;
+		const stream_result& result = job.results[i];
+
+		stream->chan->lost_packets += result.lost_packets;
+		DBG("Snapshot of stream %" PRIu64 " recorded %" PRIu64 " packets (%" PRIu64
+		    " bytes, %" PRIu64 " lost) in %" PRIu64 " ns",
+		    stream->key,
+		    result.packets,
+		    result.bytes,
+		    result.lost_packets,
+		    result.duration_ns);
+
+		if (result.ret) {
+			if (!ret) {
+				ret = result.ret;
+			}
+		} else {
+			/* The next incremental snapshot starts where this one ended. */
+			stream->last_snapshot_produced_pos = streams[i].produced_pos;
+			stream->has_last_snapshot = true;
+		}
+	}
+
+	DBG("Snapshot of %zu streams recorded by %zu threads",
+	    streams.size(),
+	    workers.size() + 1);
+	return ret;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_CONSUMER_SNAPSHOT_H
+#define LTTNG_CONSUMER_SNAPSHOT_H
+
+#include <common/buffer-view.hpp>
+#include <common/consumer/consumer.hpp>
+#include <common/macros.hpp>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <vector>
+
+/* "LTSR", see lttng_snapshot_output_set_fd(). */
+#define CONSUMER_SNAPSHOT_FD_RECORD_MAGIC 0x4c545352U
+
+/* Domain-specific accessors to the sub-buffers of a stream being recorded. */
+struct consumer_snapshot_ops {
+	int (*get_subbuf)(struct lttng_consumer_stream *stream, unsigned long *pos);
+	int (*get_subbuf_size)(struct lttng_consumer_stream *stream, unsigned long *len);
+	int (*get_padded_subbuf_size)(struct lttng_consumer_stream *stream, unsigned long *len);
+	int (*get_subbuf_addr)(struct lttng_consumer_stream *stream, const char **addr);
+	int (*put_subbuf)(struct lttng_consumer_stream *stream);
+	/*
+	 * Abort the snapshot of a stream when a sub-buffer is not completely
+	 * written rather than logging the error and carrying on.
+	 */
+	bool abort_on_short_write;
+};
+
+/* Sub-buffers of a stream to record as part of a snapshot. */
+struct consumer_snapshot_stream {
+	struct lttng_consumer_stream *stream;
+	unsigned long consumed_pos;
+	unsigned long produced_pos;
+};
+
+/*
+ * Header of each record written to the file descriptor of a snapshot. It is
+ * followed by the path of the record's stream file, relative to the trace,
+ * and by the payload, a packet to append to that file.
+ */
+struct consumer_snapshot_fd_record_header {
+	uint32_t magic;
+	uint32_t path_len;
+	uint64_t payload_len;
+} LTTNG_PACKED;
+
+/*
+ * File descriptor receiving the streams of a snapshot as a sequence of records
+ * rather than as trace files.
+ */
+struct consumer_snapshot_fd_output {
+	int fd;
+	/* Path of the channel within the trace. */
+	const char *path;
+	/* Serializes the records of the streams recorded concurrently. */
+	pthread_mutex_t lock;
+};
+
+/*
+ * Acknowledge a snapshot command recorded to a file descriptor and receive that
+ * file descriptor from the session daemon.
+ *
+ * Return 0 on success, else a negative value.
+ */
+int consumer_snapshot_recv_output_fd(int sock, int *fd);
+
+/* The output owns `fd` from this point on. */
+void consumer_snapshot_fd_output_init(struct consumer_snapshot_fd_output *output,
+				      int fd,
+				      const char *path);
+
+/* Close the file descriptor of the output. */
+void consumer_snapshot_fd_output_fini(struct consumer_snapshot_fd_output *output);
+
+/*
+ * Write a packet of a stream as one record.
+ *
+ * Return the size of the packet on success, else a negative errno value.
+ */
+ssize_t consumer_snapshot_fd_output_write(struct consumer_snapshot_fd_output *output,
+					  const struct lttng_consumer_stream *stream,
+					  const struct lttng_buffer_view *packet);
+
+/*
+ * Write a packet of a stream as one record, splicing `len` bytes from the
+ * current sub-buffer of `in_fd` through `splice_pipe`.
+ *
+ * Return `len` on success, else a negative errno value.
+ */
+ssize_t consumer_snapshot_fd_output_splice(struct consumer_snapshot_fd_output *output,
+					   const struct lttng_consumer_stream *stream,
+					   int in_fd,
+					   const int *splice_pipe,
+					   size_t len);
+
+/*
+ * Set the maximal number of threads copying the streams of a snapshot
+ * concurrently, including the thread requesting the snapshot.
+ */
+void consumer_snapshot_set_thread_count(unsigned int count);
+
+/*
+ * Record the sub-buffers of a set of streams, from their consumed to their
+ * produced position, to their output. The streams are spread over a pool of
+ * threads and recorded concurrently.
+ *
+ * When `incremental` is set, the sub-buffers of a stream which were already
+ * recorded by its previous snapshot are skipped.
+ *
+ * The streams must be locked, their output must be open and their positions
+ * sampled. The RCU read-side lock and the lock of their channel must be held.
+ *
+ * Return 0 on success, else the first error encountered.
+ */
+int consumer_snapshot_record_streams(const std::vector<consumer_snapshot_stream>& streams,
+				     const struct consumer_snapshot_ops *ops,
+				     bool use_relayd,
+				     bool incremental);
+
+#endif /* LTTNG_CONSUMER_SNAPSHOT_H */
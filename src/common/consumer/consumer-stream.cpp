@@ -11,23 +11,39 @@
 #include "consumer-stream.hpp"
 
 #include <common/common.hpp>
+#include <common/consumer/consumer-compression.hpp>
+#include <common/consumer/consumer-packet-filter.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/consumer/consumer.hpp>
 #include <common/consumer/metadata-bucket.hpp>
+#include <common/crc32c.hpp>
 #include <common/index/index.hpp>
+#include <common/io-hint.hpp>
 #include <common/kernel-consumer/kernel-consumer.hpp>
 #include <common/kernel-ctl/kernel-ctl.hpp>
 #include <common/macros.hpp>
 #include <common/relayd/relayd.hpp>
+#include <common/self-tracing/self-tracing.hpp>
 #include <common/urcu.hpp>
 #include <common/ust-consumer/ust-consumer.hpp>
 #include <common/utils.hpp>
 
+#include <algorithm>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
+/* Bytes reserved at once ahead of the writes to the local output files. */
+static uint64_t output_preallocation_size;
+/* See consumer_stream_set_chunk_manifest_enabled(). */
+static bool chunk_manifest_enabled;
+/* See consumer_stream_set_packet_checksum_enabled(). */
+static bool packet_checksum_enabled;
+/* See consumer_stream_set_metadata_lane_enabled(). */
+static bool metadata_lane_enabled;
+
 /*
  * RCU call to free stream. MUST only be used with call_rcu().
  */
@@ -38,6 +54,8 @@ static void free_stream_rcu(struct rcu_head *head)
 		lttng::utils::container_of(node, &lttng_consumer_stream::node);
 
 	pthread_mutex_destroy(&stream->lock);
+	lttng_dynamic_buffer_reset(&stream->compression.buffer);
+	lttng_dynamic_buffer_reset(&stream->index_batch.buffer);
 	free(stream);
 }
 
@@ -151,6 +169,32 @@ static void ctf_packet_index_populate(struct ctf_packet_index *index,
 	};
 }
 
+/*
+ * Compute the checksum of the packet about to be written or sent, as stored in
+ * its stream file. The relay daemon writes zeroes in place of the padding of
+ * the packets it receives, while the local output files receive it as-is.
+ */
+static void compute_packet_checksum(struct lttng_consumer_stream *stream,
+				    const struct lttng_buffer_view *packet,
+				    unsigned long padding_size)
+{
+	uint32_t checksum;
+
+	if (!packet_checksum_enabled || stream->metadata_flag) {
+		LTTNG_OPTIONAL_UNSET(&stream->packet_checksum);
+		return;
+	}
+
+	if (stream->net_seq_idx == (uint64_t) -1ULL) {
+		checksum = lttng_crc32c_update(0, packet->data, packet->size);
+	} else {
+		checksum = lttng_crc32c_update(0, packet->data, packet->size - padding_size);
+		checksum = lttng_crc32c_update_zeroes(checksum, padding_size);
+	}
+
+	LTTNG_OPTIONAL_SET(&stream->packet_checksum, checksum);
+}
+
 static ssize_t consumer_stream_consume_mmap(struct lttng_consumer_local_data *ctx
 					    __attribute__((unused)),
 					    struct lttng_consumer_stream *stream,
@@ -158,7 +202,10 @@ static ssize_t consumer_stream_consume_mmap(struct lttng_consumer_local_data *ct
 {
 	const unsigned long padding_size =
 		subbuffer->info.data.padded_subbuf_size - subbuffer->info.data.subbuf_size;
-	const ssize_t written_bytes = lttng_consumer_on_read_subbuffer_mmap(
+	ssize_t written_bytes;
+
+	compute_packet_checksum(stream, &subbuffer->buffer.buffer, padding_size);
+	written_bytes = lttng_consumer_on_read_subbuffer_mmap(
 		stream, &subbuffer->buffer.buffer, padding_size);
 
 	if (stream->net_seq_idx == -1ULL) {
@@ -194,6 +241,49 @@ static ssize_t consumer_stream_consume_mmap(struct lttng_consumer_local_data *ct
 	return written_bytes;
 }
 
+/*
+ * Compress the padded sub-buffer and write the result as a zstd frame.
+ *
+ * Both the local trace files and the relay daemon receive the compressed
+ * packet as-is; its index entry records the offset of the frame in the stream
+ * file, and the packet and content sizes of the decompressed packet. The
+ * names of the compressed streams carry the suffix of the algorithm.
+ */
+static ssize_t consumer_stream_consume_mmap_compressed(struct lttng_consumer_local_data *ctx
+						       __attribute__((unused)),
+						       struct lttng_consumer_stream *stream,
+						       const struct stream_subbuffer *subbuffer)
+{
+	ssize_t written_bytes;
+	struct lttng_buffer_view compressed_view;
+	const ssize_t compressed_size =
+		consumer_compression_compress(&subbuffer->buffer.buffer,
+					      &stream->compression.buffer);
+
+	if (compressed_size < 0) {
+		ERR("Failed to compress sub-buffer: stream key = %" PRIu64, stream->key);
+		return -1;
+	}
+
+	compressed_view = lttng_buffer_view_from_dynamic_buffer(
+		&stream->compression.buffer, 0, compressed_size);
+	compute_packet_checksum(stream, &compressed_view, 0);
+	written_bytes = lttng_consumer_on_read_subbuffer_mmap(stream, &compressed_view, 0);
+	if (written_bytes < 0) {
+		ERR("Error reading mmap subbuffer: %zd", written_bytes);
+		return written_bytes;
+	}
+
+	if (written_bytes != compressed_size) {
+		DBG("Failed to write the entire compressed subbuffer (written_bytes: %zd, compressed subbuffer size %zd)",
+		    written_bytes,
+		    compressed_size);
+	}
+
+	stream->compression.packet_size = compressed_size;
+	return written_bytes;
+}
+
 static ssize_t consumer_stream_consume_splice(struct lttng_consumer_local_data *ctx,
 					      struct lttng_consumer_stream *stream,
 					      const struct stream_subbuffer *subbuffer)
@@ -218,25 +308,108 @@ static ssize_t consumer_stream_consume_splice(struct lttng_consumer_local_data *
 	return written_bytes;
 }
 
+/*
+ * Account for a packet written to the local output file of a stream in the
+ * summary of the file.
+ */
+static void manifest_add_packet(struct lttng_consumer_stream *stream,
+				const struct ctf_packet_index *index,
+				uint64_t packet_size)
+{
+	const uint64_t timestamp_begin = be64toh(index->timestamp_begin);
+	const uint64_t discarded_events = be64toh(index->events_discarded);
+
+	if (stream->manifest.packet_count == 0) {
+		stream->manifest.timestamp_begin = timestamp_begin;
+	}
+
+	stream->manifest.packet_count++;
+	stream->manifest.byte_count += packet_size;
+	stream->manifest.timestamp_end = be64toh(index->timestamp_end);
+	/* The discarded events count of the packets is cumulative. */
+	stream->manifest.discarded_events +=
+		discarded_events - stream->manifest.last_discarded_events;
+	stream->manifest.last_discarded_events = discarded_events;
+}
+
 static int consumer_stream_send_index(struct lttng_consumer_stream *stream,
 				      const struct stream_subbuffer *subbuffer,
 				      struct lttng_consumer_local_data *ctx __attribute__((unused)))
 {
 	off_t packet_offset = 0;
 	struct ctf_packet_index index = {};
+	const uint64_t packet_size = stream->compression.packet_size ?:
+		subbuffer->info.data.padded_subbuf_size;
 
 	/*
 	 * This is called after consuming the sub-buffer; substract the
 	 * effect this sub-buffer from the offset.
 	 */
 	if (stream->net_seq_idx == (uint64_t) -1ULL) {
-		packet_offset = stream->out_fd_offset - subbuffer->info.data.padded_subbuf_size;
+		packet_offset = stream->out_fd_offset - packet_size;
 	}
 
 	ctf_packet_index_populate(&index, packet_offset, subbuffer);
+
+	if (stream->packet_checksum.is_set) {
+		/* Only written to the index files of version 1.2. */
+		index.packet_checksum = htobe32(stream->packet_checksum.value);
+	}
+
+	if (stream->net_seq_idx == (uint64_t) -1ULL) {
+		manifest_add_packet(stream, &index, packet_size);
+	}
+
 	return consumer_stream_write_index(stream, &index);
 }
 
+/*
+ * Consume the metadata made available by the synchronization of a metadata
+ * stream from the calling data thread, until none is left.
+ *
+ * The metadata stream lock MUST be acquired and is released. The RCU read side
+ * lock must be held by the caller.
+ *
+ * Return 0 on success else a negative value.
+ */
+static int consume_synced_metadata(struct lttng_consumer_stream *metadata,
+				   struct lttng_consumer_local_data *ctx)
+{
+	ssize_t len = 0;
+	/* Valid as long as the stream is not deleted, which requires its lock. */
+	struct lttng_consumer_channel *channel = metadata->chan;
+
+	ASSERT_RCU_READ_LOCKED();
+
+	/*
+	 * Take the locks of a metadata stream read in order. The channel can't
+	 * be reclaimed before the RCU read side lock is released.
+	 */
+	pthread_mutex_unlock(&metadata->lock);
+	pthread_mutex_lock(&channel->lock);
+	pthread_mutex_lock(&metadata->lock);
+	pthread_mutex_lock(&metadata->metadata_rdv_lock);
+
+	while (!consumer_stream_is_deleted(metadata)) {
+		len = ctx->on_buffer_ready(metadata, ctx, true);
+		if (len <= 0) {
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&metadata->metadata_rdv_lock);
+	pthread_mutex_unlock(&metadata->lock);
+	pthread_mutex_unlock(&channel->lock);
+
+	if (len < 0 && len != -EAGAIN && len != -ENODATA) {
+		ERR("Failed to consume metadata of stream %" PRIu64 " from data thread",
+		    metadata->key);
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Actually do the metadata sync using the given metadata stream.
  *
@@ -322,6 +495,16 @@ static int do_sync_metadata(struct lttng_consumer_stream *metadata,
 			abort();
 		}
 
+		if (metadata_lane_enabled) {
+			/* Don't wait for the metadata thread to consume it. */
+			ret = consume_synced_metadata(metadata, ctx);
+			if (ret < 0) {
+				return ret;
+			}
+
+			continue;
+		}
+
 		/*
 		 * At this point, new metadata have been flushed, so we wait on the
 		 * rendez-vous point for the metadata thread to wake us up when it
@@ -357,7 +540,8 @@ end_unlock_mutex:
  * snapshot so the metadata thread can consume it.
  *
  * This function call is a rendez-vous point between the metadata thread and
- * the data thread.
+ * the data thread, unless the metadata lane is enabled, in which case the data
+ * thread consumes the metadata itself.
  *
  * Return 0 on success or else a negative value.
  */
@@ -661,11 +845,13 @@ struct lttng_consumer_stream *consumer_stream_create(struct lttng_consumer_chann
 	stream->send_node = CDS_LIST_HEAD_INIT(stream->send_node);
 	stream->chan = channel;
 	stream->key = stream_key;
+	stream->cpu = cpu;
 	stream->trace_chunk = trace_chunk;
 	stream->out_fd = -1;
 	stream->out_fd_offset = 0;
 	stream->output_written = 0;
 	stream->net_seq_idx = relayd_id;
+	stream->relayd_data_sock_index = -1;
 	stream->session_id = session_id;
 	stream->monitor = monitor;
 	stream->endpoint_status = CONSUMER_ENDPOINT_ACTIVE;
@@ -676,6 +862,8 @@ struct lttng_consumer_stream *consumer_stream_create(struct lttng_consumer_chann
 	stream->opened_packet_in_current_trace_chunk = true;
 	pthread_mutex_init(&stream->lock, nullptr);
 	pthread_mutex_init(&stream->metadata_timer_lock, nullptr);
+	lttng_dynamic_buffer_init(&stream->compression.buffer);
+	lttng_dynamic_buffer_init(&stream->index_batch.buffer);
 
 	/* If channel is the metadata, flag this stream as metadata. */
 	if (type == CONSUMER_CHANNEL_TYPE_METADATA) {
@@ -686,8 +874,18 @@ struct lttng_consumer_stream *consumer_stream_create(struct lttng_consumer_chann
 		pthread_cond_init(&stream->metadata_rdv, nullptr);
 		pthread_mutex_init(&stream->metadata_rdv_lock, nullptr);
 	} else {
-		/* Format stream name to <channel_name>_<cpu_number> */
-		ret = snprintf(stream->name, sizeof(stream->name), "%s_%d", channel_name, cpu);
+		/*
+		 * Format stream name to <channel_name>_<cpu_number>, followed by
+		 * the suffix of the compression of the stream, if any.
+		 */
+		ret = snprintf(stream->name,
+			       sizeof(stream->name),
+			       "%s_%d%s",
+			       channel_name,
+			       cpu,
+			       channel->output == CONSUMER_CHANNEL_MMAP ?
+				       consumer_compression_get_stream_name_suffix() :
+				       "");
 		if (ret < 0) {
 			PERROR("snprintf stream name");
 			goto error;
@@ -759,10 +957,19 @@ struct lttng_consumer_stream *consumer_stream_create(struct lttng_consumer_chann
 		stream->read_subbuffer_ops.unlock = consumer_stream_data_unlock_all;
 		stream->read_subbuffer_ops.assert_locked = consumer_stream_data_assert_locked_all;
 		stream->read_subbuffer_ops.pre_consume_subbuffer = consumer_stream_update_stats;
+		if (consumer_packet_filter_applies(channel)) {
+			stream->read_subbuffer_ops.filter_subbuffer =
+				consumer_packet_filter_sample;
+		}
 	}
 
 	if (channel->output == CONSUMER_CHANNEL_MMAP) {
-		stream->read_subbuffer_ops.consume_subbuffer = consumer_stream_consume_mmap;
+		stream->read_subbuffer_ops.consume_subbuffer =
+			type != CONSUMER_CHANNEL_TYPE_METADATA &&
+				consumer_compression_get_algorithm() !=
+					CONSUMER_COMPRESSION_ALGORITHM_NONE ?
+			consumer_stream_consume_mmap_compressed :
+			consumer_stream_consume_mmap;
 	} else {
 		stream->read_subbuffer_ops.consume_subbuffer = consumer_stream_consume_splice;
 	}
@@ -780,12 +987,25 @@ end:
 	return nullptr;
 }
 
+struct consumer_relayd_sock_pair *consumer_stream_find_relayd(struct lttng_consumer_stream *stream)
+{
+	struct consumer_relayd_sock_pair *relayd = stream->relayd;
+
+	ASSERT_RCU_READ_LOCKED();
+
+	if (!relayd) {
+		/* Not sent to a relayd (yet). */
+		return consumer_find_relayd(stream->net_seq_idx);
+	}
+
+	return uatomic_read(&relayd->destroyed) ? nullptr : relayd;
+}
+
 /*
  * Close stream on the relayd side. This call can destroy a relayd if the
  * conditions are met.
  *
- * A RCU read side lock MUST be acquired if the relayd object was looked up in
- * a hash table before calling this.
+ * The RCU read side lock MUST be acquired.
  */
 void consumer_stream_relayd_close(struct lttng_consumer_stream *stream,
 				  struct consumer_relayd_sock_pair *relayd)
@@ -794,21 +1014,25 @@ void consumer_stream_relayd_close(struct lttng_consumer_stream *stream,
 
 	LTTNG_ASSERT(stream);
 	LTTNG_ASSERT(relayd);
+	ASSERT_RCU_READ_LOCKED();
 
 	if (stream->sent_to_relayd) {
-		uatomic_dec(&relayd->refcount);
-		LTTNG_ASSERT(uatomic_read(&relayd->refcount) >= 0);
+		consumer_put_relayd(relayd);
 	}
 
-	/* Closing streams requires to lock the control socket. */
-	pthread_mutex_lock(&relayd->ctrl_sock_mutex);
-	ret = relayd_send_close_stream(
-		&relayd->control_sock, stream->relayd_stream_id, stream->next_net_seq_num - 1);
-	pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
-	if (ret < 0) {
-		ERR("Relayd send close stream failed. Cleaning up relayd %" PRIu64 ".",
-		    relayd->net_seq_idx);
-		lttng_consumer_cleanup_relayd(relayd);
+	/* A destroyed relayd is only kept until its streams are closed. */
+	if (!uatomic_read(&relayd->destroyed)) {
+		/* Closing streams requires to lock the control socket. */
+		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		ret = relayd_send_close_stream(&relayd->control_sock,
+					       stream->relayd_stream_id,
+					       stream->next_net_seq_num - 1);
+		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		if (ret < 0) {
+			ERR("Relayd send close stream failed. Cleaning up relayd %" PRIu64 ".",
+			    relayd->net_seq_idx);
+			lttng_consumer_cleanup_relayd(relayd);
+		}
 	}
 
 	/* Both conditions are met, we destroy the relayd. */
@@ -817,6 +1041,7 @@ void consumer_stream_relayd_close(struct lttng_consumer_stream *stream,
 	}
 	stream->net_seq_idx = (uint64_t) -1ULL;
 	stream->sent_to_relayd = 0;
+	stream->relayd = nullptr;
 }
 
 /*
@@ -834,6 +1059,9 @@ void consumer_stream_close_output(struct lttng_consumer_stream *stream)
 
 	/* Close output fd. Could be a socket or local file at this point. */
 	if (stream->out_fd >= 0) {
+		consumer_stream_release_writeback_window(stream);
+		consumer_stream_trim_output_file(stream);
+
 		const auto ret = close(stream->out_fd);
 		if (ret) {
 			PERROR("Failed to close stream output file descriptor");
@@ -847,12 +1075,13 @@ void consumer_stream_close_output(struct lttng_consumer_stream *stream)
 		stream->index_file = nullptr;
 	}
 
+	consumer_stream_write_manifest_entry(stream);
 	lttng_trace_chunk_put(stream->trace_chunk);
 	stream->trace_chunk = nullptr;
 
 	/* Check and cleanup relayd if needed. */
 	lttng::urcu::read_lock_guard read_lock;
-	relayd = consumer_find_relayd(stream->net_seq_idx);
+	relayd = stream->relayd ?: consumer_find_relayd(stream->net_seq_idx);
 	if (relayd != nullptr) {
 		consumer_stream_relayd_close(stream, relayd);
 		stream->net_seq_idx = -1ULL;
@@ -1045,15 +1274,15 @@ void consumer_stream_destroy(struct lttng_consumer_stream *stream, struct lttng_
 			pthread_mutex_lock(&stream->lock);
 			/* Remove every reference of the stream in the consumer. */
 			consumer_stream_delete(stream, ht);
+			consumer_consumption_stats_merge(
+				&stream->chan->retired_streams_consumption_stats,
+				&stream->consumption_stats);
 
 			destroy_close_stream(stream);
 
 			/* Update channel's refcount of the stream. */
 			free_chan = unref_channel(stream);
 
-			/* Indicates that the consumer data state MUST be updated after this. */
-			the_consumer_data.need_update = 1;
-
 			pthread_mutex_unlock(&stream->lock);
 			pthread_mutex_unlock(&stream->chan->lock);
 			pthread_mutex_unlock(&the_consumer_data.lock);
@@ -1096,7 +1325,7 @@ int consumer_stream_write_index(struct lttng_consumer_stream *stream,
 	lttng::urcu::read_lock_guard read_lock;
 	if (stream->net_seq_idx != (uint64_t) -1ULL) {
 		struct consumer_relayd_sock_pair *relayd;
-		relayd = consumer_find_relayd(stream->net_seq_idx);
+		relayd = consumer_stream_find_relayd(stream);
 		if (relayd) {
 			pthread_mutex_lock(&relayd->ctrl_sock_mutex);
 			ret = relayd_send_index(&relayd->control_sock,
@@ -1120,6 +1349,16 @@ int consumer_stream_write_index(struct lttng_consumer_stream *stream,
 			    stream->net_seq_idx);
 			ret = -1;
 		}
+	} else if (stream->index_batch.active) {
+		ret = lttng_dynamic_buffer_append(
+			&stream->index_batch.buffer, element, stream->index_file->element_len);
+		if (ret) {
+			ERR("Failed to append index entry to the drain batch of stream %" PRIu64,
+			    stream->key);
+			ret = -1;
+		} else {
+			stream->index_batch.count++;
+		}
 	} else {
 		if (lttng_index_file_write(stream->index_file, element)) {
 			ret = -1;
@@ -1135,12 +1374,261 @@ error:
 	return ret;
 }
 
+void consumer_stream_begin_index_batch(struct lttng_consumer_stream *stream)
+{
+	LTTNG_ASSERT(stream);
+	LTTNG_ASSERT(!stream->index_batch.active);
+
+	/* Only local index files are batched. */
+	stream->index_batch.active = stream->net_seq_idx == (uint64_t) -1ULL &&
+		stream->index_file;
+}
+
+int consumer_stream_flush_index_batch(struct lttng_consumer_stream *stream)
+{
+	int ret = 0;
+
+	LTTNG_ASSERT(stream);
+
+	if (stream->index_batch.count > 0) {
+		LTTNG_ASSERT(stream->index_file);
+		ret = lttng_index_file_write_elements(stream->index_file,
+						      stream->index_batch.buffer.data,
+						      stream->index_batch.count);
+		self_tracepoint(
+			consumerd_index_flush, stream->key, stream->index_batch.count, ret);
+		if (ret) {
+			ERR("Failed to write the index entries of stream %" PRIu64
+			    ": count = %zu",
+			    stream->key,
+			    stream->index_batch.count);
+		}
+	}
+
+	stream->index_batch.active = false;
+	stream->index_batch.count = 0;
+	(void) lttng_dynamic_buffer_set_size(&stream->index_batch.buffer, 0);
+	return ret;
+}
+
+void consumer_stream_size_splice_pipe(struct lttng_consumer_stream *stream)
+{
+	int ret;
+	unsigned long size = std::min<unsigned long>(stream->max_sb_size, INT_MAX);
+
+	if (stream->output != LTTNG_EVENT_SPLICE) {
+		return;
+	}
+
+	ret = fcntl(stream->splice_pipe[1], F_GETPIPE_SZ);
+	if (ret < 0) {
+		PERROR("Failed to get splice pipe size of stream %" PRIu64, stream->key);
+		return;
+	}
+
+	stream->splice_pipe_size = ret;
+
+	/*
+	 * The pipe size can be limited by fs.pipe-max-size and by the per-user
+	 * pipe buffer quota: halve the requested size until it is accepted or
+	 * until it doesn't exceed the current size anymore.
+	 */
+	while (size > stream->splice_pipe_size) {
+		ret = fcntl(stream->splice_pipe[1], F_SETPIPE_SZ, (int) size);
+		if (ret >= 0) {
+			stream->splice_pipe_size = ret;
+			break;
+		}
+
+		if (errno != EPERM && errno != EBUSY && errno != ENOMEM) {
+			PERROR("Failed to set splice pipe size of stream %" PRIu64 " to %lu bytes",
+			       stream->key,
+			       size);
+			break;
+		}
+
+		size /= 2;
+	}
+
+	DBG("Splice pipe of stream %" PRIu64 " is %lu bytes (max sub-buffer size: %lu bytes)",
+	    stream->key,
+	    stream->splice_pipe_size,
+	    stream->max_sb_size);
+}
+
+void consumer_stream_set_preallocation_size(uint64_t size)
+{
+	output_preallocation_size = size;
+}
+
+void consumer_stream_set_chunk_manifest_enabled(bool enabled)
+{
+	chunk_manifest_enabled = enabled;
+}
+
+void consumer_stream_set_packet_checksum_enabled(bool enabled)
+{
+	packet_checksum_enabled = enabled;
+}
+
+void consumer_stream_set_metadata_lane_enabled(bool enabled)
+{
+	metadata_lane_enabled = enabled;
+}
+
+static void manifest_reset(struct lttng_consumer_stream *stream)
+{
+	stream->manifest.packet_count = 0;
+	stream->manifest.byte_count = 0;
+	stream->manifest.timestamp_begin = 0;
+	stream->manifest.timestamp_end = 0;
+	stream->manifest.discarded_events = 0;
+}
+
+void consumer_stream_write_manifest_entry(struct lttng_consumer_stream *stream)
+{
+	int ret, fd = -1;
+	enum lttng_trace_chunk_status chunk_status;
+	const int flags = O_WRONLY | O_CREAT | O_APPEND;
+	const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+	char stream_path[LTTNG_PATH_MAX];
+	char line[LTTNG_PATH_MAX + 160];
+
+	ASSERT_LOCKED(stream->lock);
+
+	if (!chunk_manifest_enabled || stream->manifest.packet_count == 0 ||
+	    stream->net_seq_idx != (uint64_t) -1ULL || !stream->trace_chunk) {
+		goto end;
+	}
+
+	ret = utils_stream_file_path(stream->chan->pathname,
+				     stream->name,
+				     stream->chan->tracefile_size,
+				     stream->tracefile_count_current,
+				     nullptr,
+				     stream_path,
+				     sizeof(stream_path));
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = snprintf(line,
+		       sizeof(line),
+		       "path=%s packets=%" PRIu64 " bytes=%" PRIu64 " timestamp_begin=%" PRIu64
+		       " timestamp_end=%" PRIu64 " discarded_events=%" PRIu64 "\n",
+		       stream_path,
+		       stream->manifest.packet_count,
+		       stream->manifest.byte_count,
+		       stream->manifest.timestamp_begin,
+		       stream->manifest.timestamp_end,
+		       stream->manifest.discarded_events);
+	if (ret < 0 || ret >= (int) sizeof(line)) {
+		ERR("Failed to format the manifest entry of stream \"%s\"", stream->name);
+		goto end;
+	}
+
+	chunk_status = lttng_trace_chunk_open_file(
+		stream->trace_chunk, DEFAULT_CHUNK_MANIFEST_FILE_NAME, flags, mode, &fd, false);
+	if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		ERR("Failed to open the manifest of the trace chunk of stream \"%s\"",
+		    stream->name);
+		goto end;
+	}
+
+	/*
+	 * A single write to a file opened in append mode keeps the lines
+	 * appended by the other consumers of the session whole.
+	 */
+	if (lttng_write(fd, line, ret) != ret) {
+		PERROR("Failed to append to the manifest of the trace chunk of stream \"%s\"",
+		       stream->name);
+	}
+
+	if (close(fd)) {
+		PERROR("Failed to close the manifest of the trace chunk of stream \"%s\"",
+		       stream->name);
+	}
+end:
+	manifest_reset(stream);
+}
+
+void consumer_stream_preallocate_output_file(struct lttng_consumer_stream *stream, size_t len)
+{
+	const uint64_t end = stream->out_fd_offset + len;
+	uint64_t preallocation_end;
+
+	LTTNG_ASSERT(stream);
+	ASSERT_LOCKED(stream->lock);
+
+	if (!output_preallocation_size || stream->out_fd < 0 || stream->metadata_flag ||
+	    stream->net_seq_idx != (uint64_t) -1ULL || stream->out_fd_preallocation_failed ||
+	    end <= stream->out_fd_preallocated_size) {
+		return;
+	}
+
+	preallocation_end = end + output_preallocation_size;
+	if (stream->chan->tracefile_size) {
+		preallocation_end = std::max(end, stream->chan->tracefile_size);
+	}
+
+	if (lttng::io::preallocate_range(stream->out_fd,
+					 stream->out_fd_preallocated_size,
+					 preallocation_end - stream->out_fd_preallocated_size)) {
+		DBG("Failed to preallocate stream output file, disabling its preallocation: "
+		    "stream key = %" PRIu64 ", error = %s",
+		    stream->key,
+		    strerror(errno));
+		stream->out_fd_preallocation_failed = true;
+		return;
+	}
+
+	stream->out_fd_preallocated_size = preallocation_end;
+}
+
+void consumer_stream_trim_output_file(struct lttng_consumer_stream *stream)
+{
+	LTTNG_ASSERT(stream);
+
+	if (stream->out_fd < 0 || stream->out_fd_preallocated_size == 0) {
+		return;
+	}
+
+	if (lttng::io::trim_preallocation(stream->out_fd)) {
+		PERROR("Failed to release the preallocated blocks of stream output file: "
+		       "stream key = %" PRIu64,
+		       stream->key);
+	}
+
+	stream->out_fd_preallocated_size = 0;
+	stream->out_fd_preallocation_failed = false;
+}
+
+void consumer_stream_release_writeback_window(struct lttng_consumer_stream *stream)
+{
+	LTTNG_ASSERT(stream);
+	ASSERT_LOCKED(stream->lock);
+
+	if (stream->chan->writeback_policy != LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW ||
+	    stream->net_seq_idx != (uint64_t) -1ULL) {
+		return;
+	}
+
+	uatomic_sub(&stream->chan->writeback_bytes_in_flight,
+		    stream->out_fd_offset - stream->writeback_offset);
+	stream->writeback_offset = stream->out_fd_offset;
+}
+
 int consumer_stream_create_output_files(struct lttng_consumer_stream *stream, bool create_index)
 {
 	int ret;
 	enum lttng_trace_chunk_status chunk_status;
 	const int flags = O_WRONLY | O_CREAT | O_TRUNC;
 	const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+	/* The packets of the splice channels have no checksum. */
+	const uint32_t index_minor =
+		packet_checksum_enabled && stream->chan->output == CONSUMER_CHANNEL_MMAP ?
+		CTF_INDEX_CHECKSUM_MINOR :
+		CTF_INDEX_MINOR;
 	char stream_path[LTTNG_PATH_MAX];
 
 	ASSERT_LOCKED(stream->lock);
@@ -1158,6 +1646,9 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream, bo
 	}
 
 	if (stream->out_fd >= 0) {
+		consumer_stream_release_writeback_window(stream);
+		consumer_stream_trim_output_file(stream);
+
 		ret = close(stream->out_fd);
 		if (ret < 0) {
 			PERROR("Failed to close stream file \"%s\"", stream->name);
@@ -1186,18 +1677,28 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream, bo
 								 stream->chan->tracefile_size,
 								 stream->tracefile_count_current,
 								 CTF_INDEX_MAJOR,
-								 CTF_INDEX_MINOR,
+								 index_minor,
 								 false,
 								 &stream->index_file);
 		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
 			ret = -1;
 			goto end;
 		}
+
+		if (output_preallocation_size) {
+			lttng_index_file_preallocate(stream->index_file, output_preallocation_size);
+		}
 	}
 
+	/* The packets of the previous file, if any, were summarized or discarded. */
+	manifest_reset(stream);
+
 	/* Reset current size because we just perform a rotation. */
 	stream->tracefile_size_current = 0;
 	stream->out_fd_offset = 0;
+	stream->writeback_offset = 0;
+	stream->out_fd_preallocated_size = 0;
+	stream->out_fd_preallocation_failed = false;
 end:
 	return ret;
 }
@@ -1206,6 +1707,7 @@ int consumer_stream_rotate_output_files(struct lttng_consumer_stream *stream)
 {
 	int ret;
 
+	consumer_stream_write_manifest_entry(stream);
 	stream->tracefile_count_current++;
 	if (stream->chan->tracefile_count > 0) {
 		stream->tracefile_count_current %= stream->chan->tracefile_count;
@@ -1221,6 +1723,26 @@ end:
 	return ret;
 }
 
+int consumer_stream_truncate_output_files(struct lttng_consumer_stream *stream)
+{
+	ASSERT_LOCKED(stream->lock);
+
+	if (stream->net_seq_idx != (uint64_t) -1ULL || stream->out_fd < 0 ||
+	    !stream->trace_chunk) {
+		/* Nothing was written locally during the current trace chunk. */
+		return 0;
+	}
+
+	if (stream->chan->tracefile_size) {
+		ERR("Can't truncate the output files of stream \"%s\" in place: its data is spread over several trace files",
+		    stream->name);
+		return -1;
+	}
+
+	DBG("Truncating output files of stream \"%s\"", stream->name);
+	return consumer_stream_create_output_files(stream, stream->index_file != nullptr);
+}
+
 bool consumer_stream_is_deleted(struct lttng_consumer_stream *stream)
 {
 	/*
@@ -1338,3 +1860,39 @@ int consumer_stream_flush_buffer(struct lttng_consumer_stream *stream, bool prod
 end:
 	return ret;
 }
+
+int consumer_stream_publish_monitor_sample(struct lttng_consumer_stream *stream)
+{
+	int ret;
+	unsigned long produced, consumed;
+
+	ASSERT_LOCKED(stream->lock);
+
+	ret = lttng_consumer_sample_snapshot_positions(stream);
+	if (ret) {
+		ERR("Failed to take buffer position snapshot for the monitor sample (ret = %d)",
+		    ret);
+		goto end;
+	}
+
+	ret = lttng_consumer_get_consumed_snapshot(stream, &consumed);
+	if (ret) {
+		ERR("Failed to get buffer consumed position for the monitor sample");
+		goto end;
+	}
+
+	ret = lttng_consumer_get_produced_snapshot(stream, &produced);
+	if (ret) {
+		ERR("Failed to get buffer produced position for the monitor sample");
+		goto end;
+	}
+
+	CMM_STORE_SHARED(stream->monitor_usage, produced - consumed);
+	CMM_STORE_SHARED(stream->monitor_output_written, stream->output_written);
+	/* Pairs with the read barrier of the monitor timer. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(stream->monitor_sampled, true);
+end:
+	uatomic_set(&stream->monitor_sample_requested, 0);
+	return ret;
+}
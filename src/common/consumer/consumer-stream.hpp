@@ -42,6 +42,14 @@ struct lttng_consumer_stream *consumer_stream_create(struct lttng_consumer_chann
  */
 void consumer_stream_close_output(struct lttng_consumer_stream *stream);
 
+/*
+ * Return the relayd of a stream, or NULL if it has none or if its relayd was
+ * destroyed. The relayd of a stream sent to a relayd is not looked up.
+ *
+ * The stream lock and the RCU read-side lock MUST be acquired.
+ */
+struct consumer_relayd_sock_pair *consumer_stream_find_relayd(struct lttng_consumer_stream *stream);
+
 /*
  * Close stream on the relayd side. This call can destroy a relayd if the
  * conditions are met.
@@ -87,6 +95,97 @@ int consumer_stream_write_index(struct lttng_consumer_stream *stream,
 
 int consumer_stream_sync_metadata(struct lttng_consumer_local_data *ctx, uint64_t session_id);
 
+/*
+ * Buffer the index entries of a local stream until
+ * consumer_stream_flush_index_batch() is called, so that the entries of the
+ * sub-buffers consumed in a single drain batch are written at once.
+ *
+ * The stream lock MUST be acquired until the batch is flushed.
+ */
+void consumer_stream_begin_index_batch(struct lttng_consumer_stream *stream);
+
+/*
+ * Write the buffered index entries of a stream and stop buffering them. Must be
+ * called before the stream's index file is closed or replaced.
+ *
+ * Return 0 on success, a negative value on error.
+ */
+int consumer_stream_flush_index_batch(struct lttng_consumer_stream *stream);
+
+/*
+ * Stop accounting the data of a stream's output file that is pending
+ * writeback in the writeback window of its channel. Must be called before the
+ * output file is closed.
+ *
+ * The stream lock MUST be acquired.
+ */
+void consumer_stream_release_writeback_window(struct lttng_consumer_stream *stream);
+
+/*
+ * Reserve the blocks of the local output files of the streams ahead of their
+ * writes, `size` bytes at once, or the whole file when the trace file size of
+ * the channel is set. Disabled when `size` is 0, the default.
+ */
+void consumer_stream_set_preallocation_size(uint64_t size);
+
+/*
+ * Append a line to the manifest file of the trace chunk of a local stream
+ * each time one of its output files is done, summarizing it: its path relative
+ * to the chunk, packet count, byte count, timestamps of the beginning of its
+ * first packet and of the end of its last packet, and the count of events
+ * discarded while it was written. Disabled by default.
+ */
+void consumer_stream_set_chunk_manifest_enabled(bool enabled);
+
+/*
+ * Compute the CRC-32C checksum of each data packet of the memory-mapped
+ * channels as it is consumed, while it is hot in the cache. The checksum of
+ * a packet sent to a relay daemon is carried by its data header, which the
+ * relay daemon verifies on reception, and the checksum of a packet written
+ * locally is stored in its index entry, whose indexes are then of version
+ * 1.2. Disabled by default.
+ */
+void consumer_stream_set_packet_checksum_enabled(bool enabled);
+
+/*
+ * Make the data threads consume the metadata of a session themselves, ahead
+ * of the index of a live data packet, instead of waiting for the metadata
+ * thread to consume it. Disabled by default.
+ */
+void consumer_stream_set_metadata_lane_enabled(bool enabled);
+
+/*
+ * Append the summary of the current output file of a stream to the manifest of
+ * its trace chunk, if enabled, and reset it. Must be called before the stream
+ * leaves its trace chunk or moves to its next trace file.
+ *
+ * The stream lock MUST be acquired.
+ */
+void consumer_stream_write_manifest_entry(struct lttng_consumer_stream *stream);
+
+/*
+ * Reserve the blocks of the next `len` bytes written to the local output file
+ * of a stream, see consumer_stream_set_preallocation_size().
+ *
+ * The stream lock MUST be acquired.
+ */
+void consumer_stream_preallocate_output_file(struct lttng_consumer_stream *stream, size_t len);
+
+/*
+ * Release the blocks reserved past the end of the local output file of a
+ * stream. Must be called before the output file is closed.
+ *
+ * The stream lock MUST be acquired.
+ */
+void consumer_stream_trim_output_file(struct lttng_consumer_stream *stream);
+
+/*
+ * Grow the splice pipe of a stream so that a whole sub-buffer fits in it,
+ * falling back to the largest size allowed by the system. Its maximal
+ * sub-buffer size must be known.
+ */
+void consumer_stream_size_splice_pipe(struct lttng_consumer_stream *stream);
+
 /*
  * Create the output files of a local stream.
  *
@@ -103,6 +202,15 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream, bo
  */
 int consumer_stream_rotate_output_files(struct lttng_consumer_stream *stream);
 
+/*
+ * Truncate the output files of a local stream in place, discarding the
+ * packets written to them during the current trace chunk. Only the streams
+ * writing to a single trace file can be truncated.
+ *
+ * This must be called with the channel's and the stream's lock held.
+ */
+int consumer_stream_truncate_output_files(struct lttng_consumer_stream *stream);
+
 /*
  * Indicates whether or not a stream is logically deleted. A deleted stream
  * should no longer be used; its existence is only garanteed by the RCU lock
@@ -149,4 +257,14 @@ consumer_stream_open_packet(struct lttng_consumer_stream *stream);
  */
 int consumer_stream_flush_buffer(struct lttng_consumer_stream *stream, bool producer_active);
 
+/*
+ * Sample the buffer usage of a stream and publish it, along with the amount
+ * of bytes written to its output, for the channel monitor timer.
+ *
+ * The stream lock MUST be acquired.
+ *
+ * Return 0 on success or else a negative value.
+ */
+int consumer_stream_publish_monitor_sample(struct lttng_consumer_stream *stream);
+
 #endif /* LTTNG_CONSUMER_STREAM_H */
@@ -9,64 +9,70 @@
 #define _LGPL_SOURCE
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
+#include <common/compat/poll.hpp>
+#include <common/compat/time.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-testpoint.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/kernel-consumer/kernel-consumer.hpp>
 #include <common/kernel-ctl/kernel-ctl.hpp>
+#include <common/pipe.hpp>
+#include <common/readwrite.hpp>
+#include <common/relayd/relayd.hpp>
+#include <common/time.hpp>
 #include <common/urcu.hpp>
 #include <common/ust-consumer/ust-consumer.hpp>
 
 #include <bin/lttng-consumerd/health-consumerd.hpp>
+#include <algorithm>
+#include <fcntl.h>
 #include <inttypes.h>
-#include <signal.h>
-
-using sample_positions_cb = int (*)(struct lttng_consumer_stream *);
-using get_consumed_cb = int (*)(struct lttng_consumer_stream *, unsigned long *);
-using get_produced_cb = int (*)(struct lttng_consumer_stream *, unsigned long *);
-using flush_index_cb = int (*)(struct lttng_consumer_stream *);
-
-static struct timer_signal_data timer_signal = {
-	.tid = 0,
-	.setup_done = 0,
-	.qs_done = 0,
-	.lock = PTHREAD_MUTEX_INITIALIZER,
+#include <sys/timerfd.h>
+#include <vector>
+
+namespace {
+/* Live beacons of streams sent to the same relay daemon. */
+struct live_beacon_batch {
+	uint64_t net_seq_idx;
+	std::vector<struct relayd_stream_index> indexes;
 };
+} /* namespace */
+
+using live_beacon_batches = std::vector<live_beacon_batch>;
+using flush_index_cb = int (*)(struct lttng_consumer_stream *, live_beacon_batches *);
+
+namespace {
+/* Resolution of the channel timers. */
+constexpr uint64_t timer_tick_ns = NSEC_PER_MSEC;
 
 /*
- * Set custom signal mask to current thread.
+ * All channel timers are kept in a single timer wheel expired by the timer
+ * thread, which is woken up by a timerfd armed at the wheel's next tick.
  */
-static void setmask(sigset_t *mask)
-{
-	int ret;
+struct timer_thread_state {
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	/* Signaled when the timer thread is done running a batch of expiries. */
+	pthread_cond_t dispatch_done = PTHREAD_COND_INITIALIZER;
+	bool dispatching = false;
+	lttng::timer_wheel wheel;
+	/* Tick at which the timerfd is armed, UINT64_MAX when disarmed. */
+	uint64_t armed_tick = UINT64_MAX;
+	/* Monotonic time of tick 0. */
+	uint64_t origin_ns = 0;
+	int timer_fd = -1;
+	struct lttng_pipe *quit_pipe = nullptr;
+};
 
-	ret = sigemptyset(mask);
-	if (ret) {
-		PERROR("sigemptyset");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_SWITCH);
-	if (ret) {
-		PERROR("sigaddset switch");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_TEARDOWN);
-	if (ret) {
-		PERROR("sigaddset teardown");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_LIVE);
-	if (ret) {
-		PERROR("sigaddset live");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_MONITOR);
-	if (ret) {
-		PERROR("sigaddset monitor");
-	}
-	ret = sigaddset(mask, LTTNG_CONSUMER_SIG_EXIT);
-	if (ret) {
-		PERROR("sigaddset exit");
-	}
+struct timer_thread_state the_timer_thread;
+
+uint64_t abs_diff(uint64_t a, uint64_t b)
+{
+	return a > b ? a - b : b - a;
 }
+} /* namespace */
 
 static int the_channel_monitor_pipe = -1;
+static uint64_t the_monitor_sample_delta;
 
 /*
  * Execute action on a timer switch.
@@ -75,12 +81,11 @@ static int the_channel_monitor_pipe = -1;
  * while consumer_timer_switch_stop() is called. It would result in
  * deadlocks.
  */
-static void metadata_switch_timer(struct lttng_consumer_local_data *ctx, siginfo_t *si)
+static void metadata_switch_timer(struct lttng_consumer_local_data *ctx,
+				  struct lttng_consumer_channel *channel)
 {
 	int ret;
-	struct lttng_consumer_channel *channel;
 
-	channel = (lttng_consumer_channel *) si->si_value.sival_ptr;
 	LTTNG_ASSERT(channel);
 
 	if (channel->switch_timer_error) {
@@ -117,7 +122,47 @@ static void metadata_switch_timer(struct lttng_consumer_local_data *ctx, siginfo
 	}
 }
 
-static int send_empty_index(struct lttng_consumer_stream *stream, uint64_t ts, uint64_t stream_id)
+/*
+ * Queue the live beacon of a stream sent to a relay daemon in the batch of
+ * that relay daemon.
+ *
+ * Called with the stream lock held. Returns false if the beacon could not be
+ * queued.
+ */
+static bool queue_live_beacon(live_beacon_batches& batches,
+			      const struct lttng_consumer_stream *stream,
+			      const struct ctf_packet_index& index)
+{
+	const struct relayd_stream_index beacon = {
+		.relay_stream_id = stream->relayd_stream_id,
+		.net_seq_num = stream->next_net_seq_num - 1,
+		.index = index,
+	};
+
+	try {
+		for (auto& batch : batches) {
+			if (batch.net_seq_idx == stream->net_seq_idx) {
+				batch.indexes.push_back(beacon);
+				return true;
+			}
+		}
+
+		batches.push_back({ stream->net_seq_idx, { beacon } });
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Send the empty index of an inactive stream. Beacons of streams sent to a
+ * relay daemon are queued in `batches` when it is provided.
+ */
+static int send_empty_index(struct lttng_consumer_stream *stream,
+			    uint64_t ts,
+			    uint64_t stream_id,
+			    live_beacon_batches *batches)
 {
 	int ret;
 	struct ctf_packet_index index;
@@ -125,6 +170,13 @@ static int send_empty_index(struct lttng_consumer_stream *stream, uint64_t ts, u
 	memset(&index, 0, sizeof(index));
 	index.stream_id = htobe64(stream_id);
 	index.timestamp_end = htobe64(ts);
+
+	if (batches && stream->net_seq_idx != (uint64_t) -1ULL &&
+	    queue_live_beacon(*batches, stream, index)) {
+		ret = 0;
+		goto error;
+	}
+
 	ret = consumer_stream_write_index(stream, &index);
 	if (ret < 0) {
 		goto error;
@@ -134,7 +186,7 @@ error:
 	return ret;
 }
 
-int consumer_flush_kernel_index(struct lttng_consumer_stream *stream)
+static int flush_kernel_index(struct lttng_consumer_stream *stream, live_beacon_batches *batches)
 {
 	uint64_t ts, stream_id;
 	int ret;
@@ -162,7 +214,7 @@ int consumer_flush_kernel_index(struct lttng_consumer_stream *stream)
 			goto end;
 		}
 		DBG("Stream %" PRIu64 " empty, sending beacon", stream->key);
-		ret = send_empty_index(stream, ts, stream_id);
+		ret = send_empty_index(stream, ts, stream_id, batches);
 		if (ret < 0) {
 			goto end;
 		}
@@ -172,7 +224,14 @@ end:
 	return ret;
 }
 
-static int check_stream(struct lttng_consumer_stream *stream, flush_index_cb flush_index)
+int consumer_flush_kernel_index(struct lttng_consumer_stream *stream)
+{
+	return flush_kernel_index(stream, nullptr);
+}
+
+static int check_stream(struct lttng_consumer_stream *stream,
+			flush_index_cb flush_index,
+			live_beacon_batches *batches)
 {
 	int ret;
 
@@ -211,13 +270,13 @@ static int check_stream(struct lttng_consumer_stream *stream, flush_index_cb flu
 		}
 		break;
 	}
-	ret = flush_index(stream);
+	ret = flush_index(stream, batches);
 	pthread_mutex_unlock(&stream->lock);
 end:
 	return ret;
 }
 
-int consumer_flush_ust_index(struct lttng_consumer_stream *stream)
+static int flush_ust_index(struct lttng_consumer_stream *stream, live_beacon_batches *batches)
 {
 	uint64_t ts, stream_id;
 	int ret;
@@ -250,7 +309,7 @@ int consumer_flush_ust_index(struct lttng_consumer_stream *stream)
 			goto end;
 		}
 		DBG("Stream %" PRIu64 " empty, sending beacon", stream->key);
-		ret = send_empty_index(stream, ts, stream_id);
+		ret = send_empty_index(stream, ts, stream_id, batches);
 		if (ret < 0) {
 			goto end;
 		}
@@ -260,31 +319,113 @@ end:
 	return ret;
 }
 
+int consumer_flush_ust_index(struct lttng_consumer_stream *stream)
+{
+	return flush_ust_index(stream, nullptr);
+}
+
+/*
+ * Send the batches of live beacons, one command per relay daemon.
+ */
+static void send_live_beacons(const live_beacon_batches& batches)
+{
+	ASSERT_RCU_READ_LOCKED();
+
+	for (const auto& batch : batches) {
+		int ret;
+		struct consumer_relayd_sock_pair *relayd;
+
+		relayd = consumer_find_relayd(batch.net_seq_idx);
+		if (!relayd) {
+			ERR("Relayd ID %" PRIu64 " unknown. Can't send %zu live beacons.",
+			    batch.net_seq_idx,
+			    batch.indexes.size());
+			continue;
+		}
+
+		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		ret = relayd_send_indexes(
+			&relayd->control_sock, batch.indexes.size(), batch.indexes.data());
+		if (ret < 0) {
+			/*
+			 * Communication error with lttng-relayd,
+			 * perform cleanup now
+			 */
+			ERR("Relayd send indexes failed. Cleaning up relayd %" PRIu64 ".",
+			    relayd->net_seq_idx);
+			lttng_consumer_cleanup_relayd(relayd);
+		}
+		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+	}
+}
+
 /*
- * Execute action on a live timer
+ * Send the indexes batched on the control connections used by the channels
+ * so that an idle stream doesn't hold its last indexes back for more than a
+ * live timer period.
  */
-static void live_timer(struct lttng_consumer_local_data *ctx, siginfo_t *si)
+static void flush_relayd_indexes(const std::vector<struct lttng_consumer_channel *>& channels)
+{
+	std::vector<uint64_t> flushed_relayd_ids;
+
+	ASSERT_RCU_READ_LOCKED();
+
+	for (const auto channel : channels) {
+		int ret;
+		struct consumer_relayd_sock_pair *relayd;
+
+		if (channel->relayd_id == (uint64_t) -1ULL ||
+		    std::find(flushed_relayd_ids.begin(),
+			      flushed_relayd_ids.end(),
+			      channel->relayd_id) != flushed_relayd_ids.end()) {
+			continue;
+		}
+
+		flushed_relayd_ids.push_back(channel->relayd_id);
+		relayd = consumer_find_relayd(channel->relayd_id);
+		if (!relayd) {
+			continue;
+		}
+
+		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		ret = relayd_flush_indexes(&relayd->control_sock);
+		if (ret < 0) {
+			ERR("Relayd send indexes failed. Cleaning up relayd %" PRIu64 ".",
+			    relayd->net_seq_idx);
+			lttng_consumer_cleanup_relayd(relayd);
+		}
+		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+	}
+}
+
+/*
+ * Execute action on the live timers which expired during the same tick. The
+ * streams of all the channels are checked under a single RCU read-side
+ * critical section and the beacons of their inactive streams are sent with
+ * one command per relay daemon.
+ */
+static void live_timer(struct lttng_consumer_local_data *ctx,
+		       const std::vector<struct lttng_consumer_channel *>& channels)
 {
 	int ret;
-	struct lttng_consumer_channel *channel;
 	struct lttng_consumer_stream *stream;
 	struct lttng_ht_iter iter;
 	const struct lttng_ht *ht = the_consumer_data.stream_per_chan_id_ht;
 	const flush_index_cb flush_index = ctx->type == LTTNG_CONSUMER_KERNEL ?
-		consumer_flush_kernel_index :
-		consumer_flush_ust_index;
+		flush_kernel_index :
+		flush_ust_index;
+	live_beacon_batches beacons;
+	lttng::urcu::read_lock_guard read_lock;
 
-	channel = (lttng_consumer_channel *) si->si_value.sival_ptr;
-	LTTNG_ASSERT(channel);
+	for (const auto channel : channels) {
+		LTTNG_ASSERT(channel);
 
-	if (channel->switch_timer_error) {
-		goto error;
-	}
+		if (channel->switch_timer_error) {
+			continue;
+		}
 
-	DBG("Live timer for channel %" PRIu64, channel->key);
+		DBG("Live timer for channel %" PRIu64, channel->key);
 
-	{
-		lttng::urcu::read_lock_guard read_lock;
 		cds_lfht_for_each_entry_duplicate(ht->ht,
 						  ht->hash_fct(&channel->key, lttng_ht_seed),
 						  ht->match_fct,
@@ -293,83 +434,77 @@ static void live_timer(struct lttng_consumer_local_data *ctx, siginfo_t *si)
 						  stream,
 						  node_channel_id.node)
 		{
-			ret = check_stream(stream, flush_index);
+			ret = check_stream(stream, flush_index, &beacons);
 			if (ret < 0) {
-				goto error_unlock;
+				break;
 			}
 		}
 	}
-error_unlock:
 
-error:
-	return;
+	send_live_beacons(beacons);
+	flush_relayd_indexes(channels);
 }
 
-static void consumer_timer_signal_thread_qs(unsigned int signr)
+static uint64_t timer_thread_current_tick()
 {
-	sigset_t pending_set;
+	struct timespec now;
 	int ret;
 
-	/*
-	 * We need to be the only thread interacting with the thread
-	 * that manages signals for teardown synchronization.
-	 */
-	pthread_mutex_lock(&timer_signal.lock);
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &now);
+	LTTNG_ASSERT(ret == 0);
 
-	/* Ensure we don't have any signal queued for this channel. */
-	for (;;) {
-		ret = sigemptyset(&pending_set);
-		if (ret == -1) {
-			PERROR("sigemptyset");
-		}
-		ret = sigpending(&pending_set);
-		if (ret == -1) {
-			PERROR("sigpending");
-		}
-		if (!sigismember(&pending_set, signr)) {
-			break;
-		}
-		caa_cpu_relax();
+	return ((uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec - the_timer_thread.origin_ns) /
+		timer_tick_ns;
+}
+
+/*
+ * Arm the timerfd to wake up the timer thread at the next tick of the wheel,
+ * or disarm it if the wheel is empty.
+ *
+ * Called with the timer thread lock held.
+ */
+static int arm_timer_fd()
+{
+	int ret;
+	const uint64_t next_tick = the_timer_thread.wheel.next_tick();
+	struct itimerspec its = {};
+
+	if (next_tick == the_timer_thread.armed_tick) {
+		ret = 0;
+		goto end;
 	}
 
-	/*
-	 * From this point, no new signal handler will be fired that would try to
-	 * access "chan". However, we still need to wait for any currently
-	 * executing handler to complete.
-	 */
-	cmm_smp_mb();
-	CMM_STORE_SHARED(timer_signal.qs_done, 0);
-	cmm_smp_mb();
+	if (next_tick != UINT64_MAX) {
+		const uint64_t expiry_ns = the_timer_thread.origin_ns + next_tick * timer_tick_ns;
 
-	/*
-	 * Kill with LTTNG_CONSUMER_SIG_TEARDOWN, so signal management thread wakes
-	 * up.
-	 */
-	kill(getpid(), LTTNG_CONSUMER_SIG_TEARDOWN);
+		its.it_value.tv_sec = expiry_ns / NSEC_PER_SEC;
+		its.it_value.tv_nsec = expiry_ns % NSEC_PER_SEC;
+	}
 
-	while (!CMM_LOAD_SHARED(timer_signal.qs_done)) {
-		caa_cpu_relax();
+	ret = timerfd_settime(the_timer_thread.timer_fd, TFD_TIMER_ABSTIME, &its, nullptr);
+	if (ret == -1) {
+		PERROR("timerfd_settime");
+		goto end;
 	}
-	cmm_smp_mb();
 
-	pthread_mutex_unlock(&timer_signal.lock);
+	the_timer_thread.armed_tick = next_tick;
+end:
+	return ret;
 }
 
 /*
- * Start a timer channel timer which will fire at a given interval
- * (timer_interval_us)and fire a given signal (signal).
+ * Start a channel timer which will expire at a given interval
+ * (timer_interval_us).
  *
- * Returns a negative value on error, 0 if a timer was created, and
- * a positive value if no timer was created (not an error).
+ * Returns a negative value on error, 0 if the timer was started, and
+ * a positive value if no timer was started (not an error).
  */
-static int consumer_channel_timer_start(timer_t *timer_id,
+static int consumer_channel_timer_start(struct consumer_channel_timer *timer,
 					struct lttng_consumer_channel *channel,
 					unsigned int timer_interval_us,
-					int signal)
+					enum consumer_channel_timer_type type)
 {
-	int ret = 0, delete_ret;
-	struct sigevent sev = {};
-	struct itimerspec its;
+	int ret = 0;
 
 	LTTNG_ASSERT(channel);
 	LTTNG_ASSERT(channel->key);
@@ -380,49 +515,49 @@ static int consumer_channel_timer_start(timer_t *timer_id,
 		goto end;
 	}
 
-	sev.sigev_notify = SIGEV_SIGNAL;
-	sev.sigev_signo = signal;
-	sev.sigev_value.sival_ptr = channel;
-	ret = timer_create(CLOCKID, &sev, timer_id);
-	if (ret == -1) {
-		PERROR("timer_create");
+	if (the_timer_thread.timer_fd < 0) {
+		ERR("Consumer timer thread is not initialized");
+		ret = -1;
 		goto end;
 	}
 
-	its.it_value.tv_sec = timer_interval_us / 1000000;
-	its.it_value.tv_nsec = (timer_interval_us % 1000000) * 1000;
-	its.it_interval.tv_sec = its.it_value.tv_sec;
-	its.it_interval.tv_nsec = its.it_value.tv_nsec;
+	timer->type = type;
+	timer->channel = channel;
+	/* Round the period up to the next tick. */
+	timer->period_ticks =
+		((uint64_t) timer_interval_us * NSEC_PER_USEC + timer_tick_ns - 1) / timer_tick_ns;
 
-	ret = timer_settime(*timer_id, 0, &its, nullptr);
-	if (ret == -1) {
-		PERROR("timer_settime");
-		goto error_destroy_timer;
+	pthread_mutex_lock(&the_timer_thread.lock);
+	the_timer_thread.wheel.schedule(timer->entry,
+					timer_thread_current_tick() + timer->period_ticks);
+	ret = arm_timer_fd();
+	if (ret) {
+		the_timer_thread.wheel.cancel(timer->entry);
 	}
+	pthread_mutex_unlock(&the_timer_thread.lock);
 end:
 	return ret;
-error_destroy_timer:
-	delete_ret = timer_delete(*timer_id);
-	if (delete_ret == -1) {
-		PERROR("timer_delete");
-	}
-	goto end;
 }
 
-static int consumer_channel_timer_stop(timer_t *timer_id, int signal)
+/*
+ * Stop a channel timer. On return, the timer thread is guaranteed not to be
+ * running an action of the timer.
+ */
+static void consumer_channel_timer_stop(struct consumer_channel_timer *timer)
 {
-	int ret = 0;
+	pthread_mutex_lock(&the_timer_thread.lock);
+	the_timer_thread.wheel.cancel(timer->entry);
 
-	ret = timer_delete(*timer_id);
-	if (ret == -1) {
-		PERROR("timer_delete");
-		goto end;
+	/*
+	 * The timer may have expired as part of the batch being dispatched;
+	 * wait for the timer thread to be done with it.
+	 */
+	while (the_timer_thread.dispatching) {
+		pthread_cond_wait(&the_timer_thread.dispatch_done, &the_timer_thread.lock);
 	}
 
-	consumer_timer_signal_thread_qs(signal);
-	*timer_id = nullptr;
-end:
-	return ret;
+	timer->channel = nullptr;
+	pthread_mutex_unlock(&the_timer_thread.lock);
 }
 
 /*
@@ -439,7 +574,7 @@ void consumer_timer_switch_start(struct lttng_consumer_channel *channel,
 	ret = consumer_channel_timer_start(&channel->switch_timer,
 					   channel,
 					   switch_timer_interval_us,
-					   LTTNG_CONSUMER_SIG_SWITCH);
+					   CONSUMER_CHANNEL_TIMER_TYPE_SWITCH);
 
 	channel->switch_timer_enabled = !!(ret == 0);
 }
@@ -449,15 +584,9 @@ void consumer_timer_switch_start(struct lttng_consumer_channel *channel,
  */
 void consumer_timer_switch_stop(struct lttng_consumer_channel *channel)
 {
-	int ret;
-
 	LTTNG_ASSERT(channel);
 
-	ret = consumer_channel_timer_stop(&channel->switch_timer, LTTNG_CONSUMER_SIG_SWITCH);
-	if (ret == -1) {
-		ERR("Failed to stop switch timer");
-	}
-
+	consumer_channel_timer_stop(&channel->switch_timer);
 	channel->switch_timer_enabled = 0;
 }
 
@@ -472,8 +601,10 @@ void consumer_timer_live_start(struct lttng_consumer_channel *channel,
 	LTTNG_ASSERT(channel);
 	LTTNG_ASSERT(channel->key);
 
-	ret = consumer_channel_timer_start(
-		&channel->live_timer, channel, live_timer_interval_us, LTTNG_CONSUMER_SIG_LIVE);
+	ret = consumer_channel_timer_start(&channel->live_timer,
+					   channel,
+					   live_timer_interval_us,
+					   CONSUMER_CHANNEL_TIMER_TYPE_LIVE);
 
 	channel->live_timer_enabled = !!(ret == 0);
 }
@@ -483,15 +614,9 @@ void consumer_timer_live_start(struct lttng_consumer_channel *channel,
  */
 void consumer_timer_live_stop(struct lttng_consumer_channel *channel)
 {
-	int ret;
-
 	LTTNG_ASSERT(channel);
 
-	ret = consumer_channel_timer_stop(&channel->live_timer, LTTNG_CONSUMER_SIG_LIVE);
-	if (ret == -1) {
-		ERR("Failed to stop live timer");
-	}
-
+	consumer_channel_timer_stop(&channel->live_timer);
 	channel->live_timer_enabled = 0;
 }
 
@@ -513,7 +638,7 @@ int consumer_timer_monitor_start(struct lttng_consumer_channel *channel,
 	ret = consumer_channel_timer_start(&channel->monitor_timer,
 					   channel,
 					   monitor_timer_interval_us,
-					   LTTNG_CONSUMER_SIG_MONITOR);
+					   CONSUMER_CHANNEL_TIMER_TYPE_MONITOR);
 	channel->monitor_timer_enabled = !!(ret == 0);
 	return ret;
 }
@@ -523,54 +648,91 @@ int consumer_timer_monitor_start(struct lttng_consumer_channel *channel,
  */
 int consumer_timer_monitor_stop(struct lttng_consumer_channel *channel)
 {
-	int ret;
-
 	LTTNG_ASSERT(channel);
 	LTTNG_ASSERT(channel->monitor_timer_enabled);
 
-	ret = consumer_channel_timer_stop(&channel->monitor_timer, LTTNG_CONSUMER_SIG_MONITOR);
-	if (ret == -1) {
-		ERR("Failed to stop live timer");
-		goto end;
-	}
-
+	consumer_channel_timer_stop(&channel->monitor_timer);
 	channel->monitor_timer_enabled = 0;
-end:
-	return ret;
+	return 0;
 }
 
 /*
- * Block the RT signals for the entire process. It must be called from the
- * consumer main before creating the threads
+ * Create the timerfd and quit pipe of the timer thread. It must be called from
+ * the consumer main before creating the threads.
  */
-int consumer_signal_init()
+int consumer_timer_init()
 {
 	int ret;
-	sigset_t mask;
+	struct timespec now;
+
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &now);
+	if (ret) {
+		PERROR("clock_gettime");
+		goto error;
+	}
+
+	the_timer_thread.origin_ns = (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+
+	the_timer_thread.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (the_timer_thread.timer_fd < 0) {
+		PERROR("timerfd_create");
+		goto error;
+	}
+
+	the_timer_thread.quit_pipe = lttng_pipe_open(FD_CLOEXEC);
+	if (!the_timer_thread.quit_pipe) {
+		ERR("Failed to create the timer thread quit pipe");
+		goto error_close_timer_fd;
+	}
 
-	/* Block signal for entire process, so only our thread processes it. */
-	setmask(&mask);
-	ret = pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+	return 0;
+
+error_close_timer_fd:
+	ret = close(the_timer_thread.timer_fd);
 	if (ret) {
-		errno = ret;
-		PERROR("pthread_sigmask");
+		PERROR("close timerfd");
+	}
+	the_timer_thread.timer_fd = -1;
+error:
+	return -1;
+}
+
+/*
+ * Notify the timer thread that it must quit.
+ */
+int consumer_timer_thread_quit()
+{
+	const char dummy = 'q';
+	ssize_t ret;
+
+	ret = lttng_pipe_write(the_timer_thread.quit_pipe, &dummy, sizeof(dummy));
+	if (ret != sizeof(dummy)) {
+		PERROR("write to the timer thread quit pipe");
 		return -1;
 	}
+
 	return 0;
 }
 
+/*
+ * Sample the buffer usage of the streams of a channel.
+ *
+ * The streams are sampled only when their lock can be acquired without
+ * waiting: the lock of a stream being consumed is held by the data thread,
+ * which is then asked to publish a sample before it next consumes the stream.
+ * Meanwhile, the last published sample of the stream is used. The streams
+ * which were never sampled are skipped, and the channel isn't sampled if none
+ * of its streams were.
+ */
 static int sample_channel_positions(struct lttng_consumer_channel *channel,
 				    uint64_t *_highest_use,
 				    uint64_t *_lowest_use,
-				    uint64_t *_total_consumed,
-				    sample_positions_cb sample,
-				    get_consumed_cb get_consumed,
-				    get_produced_cb get_produced)
+				    uint64_t *_total_consumed)
 {
 	int ret = 0;
 	struct lttng_ht_iter iter;
 	struct lttng_consumer_stream *stream;
-	bool empty_channel = true;
+	bool empty_channel = true, sampled_stream = false;
 	uint64_t high = 0, low = UINT64_MAX;
 	struct lttng_ht *ht = the_consumer_data.stream_per_chan_id_ht;
 
@@ -586,36 +748,38 @@ static int sample_channel_positions(struct lttng_consumer_channel *channel,
 					  stream,
 					  node_channel_id.node)
 	{
-		unsigned long produced, consumed, usage;
+		unsigned long usage;
 
 		empty_channel = false;
 
-		pthread_mutex_lock(&stream->lock);
 		if (cds_lfht_is_node_deleted(&stream->node.node)) {
-			goto next;
+			continue;
 		}
 
-		ret = sample(stream);
-		if (ret) {
-			ERR("Failed to take buffer position snapshot in monitor timer (ret = %d)",
-			    ret);
-			pthread_mutex_unlock(&stream->lock);
-			goto end;
-		}
-		ret = get_consumed(stream, &consumed);
-		if (ret) {
-			ERR("Failed to get buffer consumed position in monitor timer");
+		if (pthread_mutex_trylock(&stream->lock) == 0) {
+			if (cds_lfht_is_node_deleted(&stream->node.node)) {
+				pthread_mutex_unlock(&stream->lock);
+				continue;
+			}
+
+			ret = consumer_stream_publish_monitor_sample(stream);
 			pthread_mutex_unlock(&stream->lock);
-			goto end;
+			if (ret) {
+				goto end;
+			}
+		} else {
+			uatomic_set(&stream->monitor_sample_requested, 1);
 		}
-		ret = get_produced(stream, &produced);
-		if (ret) {
-			ERR("Failed to get buffer produced position in monitor timer");
-			pthread_mutex_unlock(&stream->lock);
-			goto end;
+
+		/* A busy stream which was never sampled has no usage to report yet. */
+		if (!CMM_LOAD_SHARED(stream->monitor_sampled)) {
+			continue;
 		}
 
-		usage = produced - consumed;
+		/* Pairs with the write barrier of the publication of the sample. */
+		cmm_smp_rmb();
+		sampled_stream = true;
+		usage = CMM_LOAD_SHARED(stream->monitor_usage);
 		high = (usage > high) ? usage : high;
 		low = (usage < low) ? usage : low;
 
@@ -626,15 +790,13 @@ static int sample_channel_positions(struct lttng_consumer_channel *channel,
 		 *  - the consumed position is not the accurate representation of what
 		 *    was extracted from a buffer in overwrite mode.
 		 */
-		*_total_consumed += stream->output_written;
-	next:
-		pthread_mutex_unlock(&stream->lock);
+		*_total_consumed += CMM_LOAD_SHARED(stream->monitor_output_written);
 	}
 
 	*_highest_use = high;
 	*_lowest_use = low;
 end:
-	if (empty_channel) {
+	if (empty_channel || !sampled_stream) {
 		ret = -1;
 	}
 	return ret;
@@ -651,10 +813,10 @@ void sample_and_send_channel_buffer_stats(struct lttng_consumer_channel *channel
 		.lowest = 0,
 		.highest = 0,
 		.consumed_since_last_sample = 0,
+		.writeback_bytes_in_flight = 0,
+		.discarded_events = 0,
+		.lost_packets = 0,
 	};
-	sample_positions_cb sample;
-	get_consumed_cb get_consumed;
-	get_produced_cb get_produced;
 	uint64_t lowest = 0, highest = 0, total_consumed = 0;
 
 	LTTNG_ASSERT(channel);
@@ -663,24 +825,7 @@ void sample_and_send_channel_buffer_stats(struct lttng_consumer_channel *channel
 		return;
 	}
 
-	switch (the_consumer_data.type) {
-	case LTTNG_CONSUMER_KERNEL:
-		sample = lttng_kconsumer_sample_snapshot_positions;
-		get_consumed = lttng_kconsumer_get_consumed_snapshot;
-		get_produced = lttng_kconsumer_get_produced_snapshot;
-		break;
-	case LTTNG_CONSUMER32_UST:
-	case LTTNG_CONSUMER64_UST:
-		sample = lttng_ustconsumer_sample_snapshot_positions;
-		get_consumed = lttng_ustconsumer_get_consumed_snapshot;
-		get_produced = lttng_ustconsumer_get_produced_snapshot;
-		break;
-	default:
-		abort();
-	}
-
-	ret = sample_channel_positions(
-		channel, &highest, &lowest, &total_consumed, sample, get_consumed, get_produced);
+	ret = sample_channel_positions(channel, &highest, &lowest, &total_consumed);
 	if (ret) {
 		return;
 	}
@@ -688,6 +833,26 @@ void sample_and_send_channel_buffer_stats(struct lttng_consumer_channel *channel
 	msg.highest = highest;
 	msg.lowest = lowest;
 	msg.consumed_since_last_sample = total_consumed - channel->last_consumed_size_sample_sent;
+	/* Updated by the data thread, a slightly stale count only delays the evaluation. */
+	msg.discarded_events = uatomic_read(&channel->discarded_events);
+	msg.lost_packets = uatomic_read(&channel->lost_packets);
+
+	/*
+	 * The session daemon keeps the last sample of each channel: skipping
+	 * the samples which barely changed only delays the evaluation of the
+	 * conditions by at most the delta.
+	 */
+	if (the_monitor_sample_delta && channel->monitor_sample_sent &&
+	    abs_diff(highest, channel->last_highest_sample_sent) < the_monitor_sample_delta &&
+	    abs_diff(lowest, channel->last_lowest_sample_sent) < the_monitor_sample_delta &&
+	    msg.consumed_since_last_sample < the_monitor_sample_delta &&
+	    msg.discarded_events == channel->last_discarded_events_sample_sent &&
+	    msg.lost_packets == channel->last_lost_packets_sample_sent) {
+		DBG3("Skipping unchanged channel monitoring sample for channel key %" PRIu64,
+		     channel->key);
+		return;
+	}
+	msg.writeback_bytes_in_flight = uatomic_read(&channel->writeback_bytes_in_flight);
 
 	/*
 	 * Writes performed here are assumed to be atomic which is only
@@ -712,10 +877,20 @@ void sample_and_send_channel_buffer_stats(struct lttng_consumer_channel *channel
 		    channel->key,
 		    msg.highest,
 		    msg.lowest);
-		channel->last_consumed_size_sample_sent = msg.consumed_since_last_sample;
+		channel->last_consumed_size_sample_sent = total_consumed;
+		channel->monitor_sample_sent = true;
+		channel->last_highest_sample_sent = highest;
+		channel->last_lowest_sample_sent = lowest;
+		channel->last_discarded_events_sample_sent = msg.discarded_events;
+		channel->last_lost_packets_sample_sent = msg.lost_packets;
 	}
 }
 
+void consumer_timer_set_monitor_sample_delta(uint64_t delta)
+{
+	the_monitor_sample_delta = delta;
+}
+
 int consumer_timer_thread_get_channel_monitor_pipe()
 {
 	return uatomic_read(&the_channel_monitor_pipe);
@@ -736,16 +911,72 @@ end:
 }
 
 /*
- * This thread is the sighandler for signals LTTNG_CONSUMER_SIG_SWITCH,
- * LTTNG_CONSUMER_SIG_TEARDOWN, LTTNG_CONSUMER_SIG_LIVE, and
- * LTTNG_CONSUMER_SIG_MONITOR, LTTNG_CONSUMER_SIG_EXIT.
+ * Expire the timers of the wheel up to the current tick, reschedule them and
+ * run their actions, batched by type.
+ */
+static void run_expired_timers(struct lttng_consumer_local_data *ctx,
+			       std::vector<lttng::timer_wheel::entry *>& expired)
+{
+	std::vector<struct lttng_consumer_channel *> channels[3];
+	uint64_t now;
+
+	pthread_mutex_lock(&the_timer_thread.lock);
+	now = timer_thread_current_tick();
+	expired.clear();
+	the_timer_thread.wheel.advance(now, expired);
+
+	for (const auto entry : expired) {
+		const auto timer =
+			lttng::utils::container_of(entry, &consumer_channel_timer::entry);
+
+		channels[timer->type].push_back(timer->channel);
+
+		/* Don't try to catch up on missed periods. */
+		the_timer_thread.wheel.schedule(
+			*entry, std::max(entry->expiry_tick + timer->period_ticks, now + 1));
+	}
+
+	/* The timerfd is disarmed when it is read after its expiry. */
+	the_timer_thread.armed_tick = UINT64_MAX;
+	(void) arm_timer_fd();
+
+	the_timer_thread.dispatching = !expired.empty();
+	pthread_mutex_unlock(&the_timer_thread.lock);
+
+	if (expired.empty()) {
+		return;
+	}
+
+	for (const auto channel : channels[CONSUMER_CHANNEL_TIMER_TYPE_SWITCH]) {
+		metadata_switch_timer(ctx, channel);
+	}
+
+	if (!channels[CONSUMER_CHANNEL_TIMER_TYPE_LIVE].empty()) {
+		live_timer(ctx, channels[CONSUMER_CHANNEL_TIMER_TYPE_LIVE]);
+	}
+
+	for (const auto channel : channels[CONSUMER_CHANNEL_TIMER_TYPE_MONITOR]) {
+		sample_and_send_channel_buffer_stats(channel);
+	}
+
+	pthread_mutex_lock(&the_timer_thread.lock);
+	the_timer_thread.dispatching = false;
+	pthread_cond_broadcast(&the_timer_thread.dispatch_done);
+	pthread_mutex_unlock(&the_timer_thread.lock);
+}
+
+/*
+ * This thread runs the switch, live and monitor timers of all channels. It is
+ * woken up by the timerfd armed at the next tick of the timer wheel or by the
+ * quit pipe.
  */
 void *consumer_timer_thread(void *data)
 {
-	int signr;
-	sigset_t mask;
-	siginfo_t info;
+	int ret, i;
+	struct lttng_poll_event events;
 	struct lttng_consumer_local_data *ctx = (lttng_consumer_local_data *) data;
+	const int quit_fd = lttng_pipe_get_readfd(the_timer_thread.quit_pipe);
+	std::vector<lttng::timer_wheel::entry *> expired;
 
 	rcu_register_thread();
 
@@ -757,53 +988,64 @@ void *consumer_timer_thread(void *data)
 
 	health_code_update();
 
-	/* Only self thread will receive signal mask. */
-	setmask(&mask);
-	CMM_STORE_SHARED(timer_signal.tid, pthread_self());
+	ret = lttng_poll_create(&events, 2, LTTNG_CLOEXEC);
+	if (ret < 0) {
+		ERR("Failed to create the timer thread poll set");
+		goto error_testpoint;
+	}
+
+	ret = lttng_poll_add(&events, the_timer_thread.timer_fd, LPOLLIN);
+	if (ret < 0) {
+		goto error_poll;
+	}
+
+	ret = lttng_poll_add(&events, quit_fd, LPOLLIN);
+	if (ret < 0) {
+		goto error_poll;
+	}
 
 	while (true) {
 		health_code_update();
 
 		health_poll_entry();
-		signr = sigwaitinfo(&mask, &info);
+		ret = lttng_poll_wait(&events, -1);
 		health_poll_exit();
-
-		/*
-		 * NOTE: cascading conditions are used instead of a switch case
-		 * since the use of SIGRTMIN in the definition of the signals'
-		 * values prevents the reduction to an integer constant.
-		 */
-		if (signr == -1) {
+		if (ret < 0) {
 			if (errno != EINTR) {
-				PERROR("sigwaitinfo");
+				PERROR("timer thread poll");
 			}
 			continue;
-		} else if (signr == LTTNG_CONSUMER_SIG_SWITCH) {
-			metadata_switch_timer(ctx, &info);
-		} else if (signr == LTTNG_CONSUMER_SIG_TEARDOWN) {
-			cmm_smp_mb();
-			CMM_STORE_SHARED(timer_signal.qs_done, 1);
-			cmm_smp_mb();
-			DBG("Signal timer metadata thread teardown");
-		} else if (signr == LTTNG_CONSUMER_SIG_LIVE) {
-			live_timer(ctx, &info);
-		} else if (signr == LTTNG_CONSUMER_SIG_MONITOR) {
-			struct lttng_consumer_channel *channel;
-
-			channel = (lttng_consumer_channel *) info.si_value.sival_ptr;
-			sample_and_send_channel_buffer_stats(channel);
-		} else if (signr == LTTNG_CONSUMER_SIG_EXIT) {
-			LTTNG_ASSERT(CMM_LOAD_SHARED(consumer_quit));
-			goto end;
-		} else {
-			ERR("Unexpected signal %d\n", info.si_signo);
+		}
+
+		for (i = 0; i < ret; i++) {
+			const int fd = LTTNG_POLL_GETFD(&events, i);
+
+			if (fd == quit_fd) {
+				LTTNG_ASSERT(CMM_LOAD_SHARED(consumer_quit));
+				DBG("Timer thread received quit notification");
+				goto end;
+			} else if (fd == the_timer_thread.timer_fd) {
+				uint64_t expirations;
+
+				/* May fail with EAGAIN if the timerfd was re-armed meanwhile. */
+				(void) lttng_read(the_timer_thread.timer_fd,
+						  &expirations,
+						  sizeof(expirations));
+				run_expired_timers(ctx, expired);
+			}
 		}
 	}
 
+error_poll:
+	ERR("Failed to add file descriptors to the timer thread poll set");
+	lttng_poll_clean(&events);
 error_testpoint:
-	/* Only reached in testpoint error */
+	/* Only reached in error paths */
 	health_error();
+	goto unregister;
 end:
+	lttng_poll_clean(&events);
+unregister:
 	health_unregister(health_consumerd);
 	rcu_unregister_thread();
 	return nullptr;
@@ -12,29 +12,6 @@
 
 #include "consumer.hpp"
 
-#include <pthread.h>
-
-#define LTTNG_CONSUMER_SIG_SWITCH   ((SIGRTMIN + 10))
-#define LTTNG_CONSUMER_SIG_TEARDOWN ((SIGRTMIN + 11))
-#define LTTNG_CONSUMER_SIG_LIVE	    ((SIGRTMIN + 12))
-#define LTTNG_CONSUMER_SIG_MONITOR  ((SIGRTMIN + 13))
-#define LTTNG_CONSUMER_SIG_EXIT	    ((SIGRTMIN + 14))
-
-#define CLOCKID CLOCK_MONOTONIC
-
-/*
- * Handle timer teardown race wrt memory free of private data by consumer
- * signals are handled by a single thread, which permits a synchronization
- * point between handling of each signal. Internal lock ensures mutual
- * exclusion.
- */
-struct timer_signal_data {
-	pthread_t tid; /* thread id managing signals */
-	int setup_done;
-	int qs_done;
-	pthread_mutex_t lock;
-};
-
 void consumer_timer_switch_start(struct lttng_consumer_channel *channel,
 				 unsigned int switch_timer_interval_us);
 void consumer_timer_switch_stop(struct lttng_consumer_channel *channel);
@@ -45,12 +22,15 @@ int consumer_timer_monitor_start(struct lttng_consumer_channel *channel,
 				 unsigned int monitor_timer_interval_us);
 int consumer_timer_monitor_stop(struct lttng_consumer_channel *channel);
 void *consumer_timer_thread(void *data);
-int consumer_signal_init();
+int consumer_timer_init();
+int consumer_timer_thread_quit();
 
 int consumer_flush_kernel_index(struct lttng_consumer_stream *stream);
 int consumer_flush_ust_index(struct lttng_consumer_stream *stream);
 
 int consumer_timer_thread_get_channel_monitor_pipe();
 int consumer_timer_thread_set_channel_monitor_pipe(int fd);
+/* Skip the monitor samples which changed by less than `delta` bytes, 0 to send them all. */
+void consumer_timer_set_monitor_sample_delta(uint64_t delta);
 
 #endif /* CONSUMER_TIMER_H */
@@ -13,17 +13,20 @@
 #include <common/compat/endian.hpp>
 #include <common/compat/poll.hpp>
 #include <common/consumer/consumer-metadata-cache.hpp>
+#include <common/consumer/consumer-snapshot.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-testpoint.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/consumer/consumer.hpp>
 #include <common/dynamic-array.hpp>
+#include <common/hashtable/typed-hashtable.hpp>
 #include <common/index/ctf-index.hpp>
 #include <common/index/index.hpp>
 #include <common/io-hint.hpp>
 #include <common/kernel-consumer/kernel-consumer.hpp>
 #include <common/kernel-ctl/kernel-ctl.hpp>
 #include <common/relayd/relayd.hpp>
+#include <common/self-tracing/self-tracing.hpp>
 #include <common/sessiond-comm/relayd.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
 #include <common/string-utils/format.hpp>
@@ -35,6 +38,7 @@
 #include <common/utils.hpp>
 
 #include <bin/lttng-consumerd/health-consumerd.hpp>
+#include <algorithm>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <poll.h>
@@ -46,6 +50,8 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 lttng_consumer_global_data the_consumer_data;
 
@@ -74,6 +80,48 @@ struct lttng_ht *data_ht;
 /* Flag used to temporarily pause data consumption from testpoints. */
 int data_consumption_paused;
 
+/* Index batching of the relayd control connections, disabled by default. */
+static unsigned int relayd_index_batch_size = DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE;
+static uint64_t relayd_index_batch_latency_us = DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY;
+
+/* Write end of the session daemon's rotation event pipe, -1 until it is received. */
+static int rotation_event_pipe = -1;
+
+/*
+ * Report the size consumed from the data streams of a channel to the session
+ * daemon by steps of DEFAULT_CONSUMERD_CONSUMED_SIZE_REPORT_STEP bytes so that
+ * it performs the size-based rotations of the session without waiting for the
+ * next monitor sample of the channel.
+ */
+static void report_consumed_size(struct lttng_consumer_channel *channel, uint64_t len)
+{
+	struct lttcomm_consumer_rotation_event_msg msg = {};
+	const int pipe = uatomic_read(&rotation_event_pipe);
+
+	if (pipe < 0 ||
+	    uatomic_add_return(&channel->unreported_consumed_size, len) <
+		    DEFAULT_CONSUMERD_CONSUMED_SIZE_REPORT_STEP) {
+		return;
+	}
+
+	/* Concurrent reporters of the channel find nothing left to report. */
+	msg.value = uatomic_xchg(&channel->unreported_consumed_size, 0);
+	if (msg.value == 0) {
+		return;
+	}
+
+	msg.type = LTTCOMM_CONSUMER_ROTATION_EVENT_CONSUMED_SIZE;
+	msg.session_id = channel->session_id;
+
+	/* Not fatal: the session daemon also samples the channels periodically. */
+	if (lttng_write(pipe, &msg, sizeof(msg)) != sizeof(msg)) {
+		DBG("Failed to report the consumed size of channel %" PRIu64
+		    " to the session daemon: size = %" PRIu64,
+		    channel->key,
+		    (uint64_t) msg.value);
+	}
+}
+
 /*
  * Flag to inform the polling thread to quit when all fd hung up. Updated by
  * the consumer_thread_receive_fds when it notices that all fds has hung up.
@@ -111,6 +159,18 @@ static void notify_thread_lttng_pipe(struct lttng_pipe *pipe)
 									     pointer. */
 }
 
+/*
+ * Notify every data worker to poll back again.
+ */
+static void notify_data_workers(struct lttng_consumer_local_data *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctx->data_worker_count; i++) {
+		notify_thread_lttng_pipe(ctx->data_workers[i].consumer_data_pipe);
+	}
+}
+
 static void notify_health_quit_pipe(int *pipe)
 {
 	ssize_t ret;
@@ -194,10 +254,6 @@ static void clean_channel_stream_list(struct lttng_consumer_channel *channel)
  */
 static struct lttng_consumer_stream *find_stream(uint64_t key, struct lttng_ht *ht)
 {
-	struct lttng_ht_iter iter;
-	struct lttng_ht_node_u64 *node;
-	struct lttng_consumer_stream *stream = nullptr;
-
 	LTTNG_ASSERT(ht);
 
 	/* -1ULL keys are lookup failures */
@@ -207,13 +263,9 @@ static struct lttng_consumer_stream *find_stream(uint64_t key, struct lttng_ht *
 
 	lttng::urcu::read_lock_guard read_lock;
 
-	lttng_ht_lookup(ht, &key, &iter);
-	node = lttng_ht_iter_get_node_u64(&iter);
-	if (node != nullptr) {
-		stream = lttng::utils::container_of(node, &lttng_consumer_stream::node);
-	}
-
-	return stream;
+	return lttng::ht<lttng_ht_node_u64, lttng_consumer_stream, &lttng_consumer_stream::node>(
+		       *ht)
+		.find(key);
 }
 
 static void steal_stream_key(uint64_t key, struct lttng_ht *ht)
@@ -325,14 +377,42 @@ static void free_relayd_rcu(struct rcu_head *head)
 	 * there is no one referencing to this relayd object.
 	 */
 	(void) relayd_close(&relayd->control_sock);
-	(void) relayd_close(&relayd->data_sock);
+	for (unsigned int i = 0; i < CONSUMER_RELAYD_MAX_DATA_SOCKS; i++) {
+		if (i < relayd->data_sock_count) {
+			(void) relayd_close(&relayd->data_socks[i].sock);
+		}
+
+		consumer_relayd_spill_fini(&relayd->data_socks[i].spill);
+		pthread_mutex_destroy(&relayd->data_socks[i].lock);
+	}
 
 	pthread_mutex_destroy(&relayd->ctrl_sock_mutex);
 	free(relayd);
 }
 
 /*
- * Destroy and free relayd socket pair object.
+ * Free a relayd socket pair in a RCU call once it is destroyed and no stream
+ * references it anymore. Whichever of the last stream reference release and
+ * the destruction happens last frees it.
+ */
+static void release_relayd(struct consumer_relayd_sock_pair *relayd)
+{
+	if (!uatomic_read(&relayd->destroyed) || uatomic_read(&relayd->refcount) != 0) {
+		return;
+	}
+
+	if (uatomic_cmpxchg(&relayd->freed, 0, 1) != 0) {
+		/* Already freed by a concurrent release. */
+		return;
+	}
+
+	/* RCU free() call */
+	call_rcu(&relayd->node.head, free_relayd_rcu);
+}
+
+/*
+ * Destroy relayd socket pair object: remove it from the relayd hash table and
+ * free it once the streams referencing it are closed.
  */
 void consumer_destroy_relayd(struct consumer_relayd_sock_pair *relayd)
 {
@@ -352,8 +432,22 @@ void consumer_destroy_relayd(struct consumer_relayd_sock_pair *relayd)
 		return;
 	}
 
-	/* RCU free() call */
-	call_rcu(&relayd->node.head, free_relayd_rcu);
+	uatomic_set(&relayd->destroyed, 1);
+	cmm_smp_mb();
+	release_relayd(relayd);
+}
+
+/*
+ * Release the reference a stream holds on a relayd socket pair.
+ *
+ * RCU read side lock MUST be acquired before calling this function.
+ */
+void consumer_put_relayd(struct consumer_relayd_sock_pair *relayd)
+{
+	const int refcount = uatomic_sub_return(&relayd->refcount, 1);
+
+	LTTNG_ASSERT(refcount >= 0);
+	release_relayd(relayd);
 }
 
 /*
@@ -512,7 +606,7 @@ void lttng_consumer_cleanup_relayd(struct consumer_relayd_sock_pair *relayd)
 	 * memory barrier ordering the updates of the end point status from the
 	 * read of this status which happens AFTER receiving this notify.
 	 */
-	notify_thread_lttng_pipe(relayd->ctx->consumer_data_pipe);
+	notify_data_workers(relayd->ctx);
 	notify_thread_lttng_pipe(relayd->ctx->consumer_metadata_pipe);
 }
 
@@ -566,17 +660,70 @@ void consumer_stream_update_channel_attributes(struct lttng_consumer_stream *str
 	stream->channel_read_only_attributes.tracefile_size = channel->tracefile_size;
 }
 
+/*
+ * Select the data worker that will consume a stream.
+ *
+ * Streams are sharded by CPU id so that the per-CPU buffers of a channel are
+ * spread across the workers. Streams for which the CPU id is unknown are
+ * sharded by key.
+ *
+ * When NUMA placement is enabled, the streams of a CPU are sharded among the
+ * workers pinned to the node of that CPU; worker `i` is pinned to node
+ * `i % node_count`.
+ */
+static unsigned int select_stream_data_worker(const struct lttng_consumer_local_data *ctx,
+					      const struct lttng_consumer_stream *stream)
+{
+	const uint64_t shard_key = stream->cpu >= 0 ? (uint64_t) stream->cpu : stream->key;
+
+	if (ctx->numa_topology) {
+		const unsigned int node_count = ctx->numa_topology->node_count();
+		const int node = ctx->numa_topology->cpu_node(stream->cpu);
+
+		if (node >= 0 && (unsigned int) node < ctx->data_worker_count) {
+			const unsigned int node_worker_count =
+				(ctx->data_worker_count - node + node_count - 1) / node_count;
+
+			return node + node_count * (unsigned int) (shard_key % node_worker_count);
+		}
+	}
+
+	return (unsigned int) (shard_key % ctx->data_worker_count);
+}
+
+struct lttng_consumer_data_worker *
+consumer_get_stream_data_worker(struct lttng_consumer_local_data *ctx,
+				const struct lttng_consumer_stream *stream)
+{
+	LTTNG_ASSERT(ctx);
+	LTTNG_ASSERT(stream);
+	LTTNG_ASSERT(!stream->metadata_flag);
+	LTTNG_ASSERT(stream->data_worker_id < ctx->data_worker_count);
+
+	return &ctx->data_workers[stream->data_worker_id];
+}
+
 /*
  * Add a stream to the global list protected by a mutex.
  */
-void consumer_add_data_stream(struct lttng_consumer_stream *stream)
+void consumer_add_data_stream(struct lttng_consumer_stream *stream,
+			      struct lttng_consumer_local_data *ctx)
 {
 	struct lttng_ht *ht = data_ht;
 
 	LTTNG_ASSERT(stream);
 	LTTNG_ASSERT(ht);
+	LTTNG_ASSERT(ctx);
 
-	DBG3("Adding consumer stream %" PRIu64, stream->key);
+	/*
+	 * The worker must be selected before the stream is published since
+	 * workers filter the data stream hash table on this field.
+	 */
+	stream->data_worker_id = select_stream_data_worker(ctx, stream);
+
+	DBG3("Adding consumer stream %" PRIu64 " to data worker %u",
+	     stream->key,
+	     stream->data_worker_id);
 
 	pthread_mutex_lock(&the_consumer_data.lock);
 	pthread_mutex_lock(&stream->chan->lock);
@@ -613,7 +760,6 @@ void consumer_add_data_stream(struct lttng_consumer_stream *stream)
 
 	/* Update consumer data once the node is inserted. */
 	the_consumer_data.stream_count++;
-	the_consumer_data.need_update = 1;
 
 	pthread_mutex_unlock(&stream->lock);
 	pthread_mutex_unlock(&stream->chan->timer_lock);
@@ -666,8 +812,14 @@ static struct consumer_relayd_sock_pair *consumer_allocate_relayd_sock_pair(uint
 	obj->net_seq_idx = net_seq_idx;
 	obj->refcount = 0;
 	obj->destroy_flag = 0;
+	obj->destroyed = 0;
+	obj->freed = 0;
 	obj->control_sock.sock.fd = -1;
-	obj->data_sock.sock.fd = -1;
+	for (unsigned int i = 0; i < CONSUMER_RELAYD_MAX_DATA_SOCKS; i++) {
+		obj->data_socks[i].sock.sock.fd = -1;
+		pthread_mutex_init(&obj->data_socks[i].lock, nullptr);
+		consumer_relayd_spill_init(&obj->data_socks[i].spill);
+	}
 	lttng_ht_node_init_u64(&obj->node, obj->net_seq_idx);
 	pthread_mutex_init(&obj->ctrl_sock_mutex, nullptr);
 
@@ -742,6 +894,15 @@ int consumer_send_relayd_stream(struct lttng_consumer_stream *stream, char *path
 		}
 
 		uatomic_inc(&relayd->refcount);
+		cmm_smp_mb();
+		if (uatomic_read(&relayd->destroyed)) {
+			/* Destroyed concurrently, don't keep a reference to it. */
+			consumer_put_relayd(relayd);
+			ret = -1;
+			goto end;
+		}
+
+		stream->relayd = relayd;
 		stream->sent_to_relayd = 1;
 	} else {
 		ERR("Stream %" PRIu64 " relayd ID %" PRIu64 " unknown. Can't send it.",
@@ -808,16 +969,98 @@ void close_relayd_stream(struct lttng_consumer_stream *stream)
 
 	/* The stream is not metadata. Get relayd reference if exists. */
 	lttng::urcu::read_lock_guard read_lock;
-	relayd = consumer_find_relayd(stream->net_seq_idx);
+	relayd = stream->relayd ?: consumer_find_relayd(stream->net_seq_idx);
 	if (relayd) {
 		consumer_stream_relayd_close(stream, relayd);
 	}
 }
 
+/*
+ * Fill a relayd data header describing the next packet of a data stream.
+ */
+static void init_relayd_data_hdr(const struct lttng_consumer_stream *stream,
+				 size_t data_size,
+				 unsigned long padding,
+				 struct lttcomm_relayd_data_hdr *data_hdr)
+{
+	memset(data_hdr, 0, sizeof(*data_hdr));
+
+	/* Set header with stream information */
+	data_hdr->stream_id = htobe64(stream->relayd_stream_id);
+	data_hdr->data_size = htobe32(data_size);
+	data_hdr->padding_size = htobe32(padding);
+	if (stream->packet_checksum.is_set) {
+		data_hdr->circuit_id = htobe64(LTTCOMM_RELAYD_DATA_HDR_CHECKSUM |
+					       stream->packet_checksum.value);
+	}
+
+	/*
+	 * Note that net_seq_num below is assigned with the *current* value of
+	 * next_net_seq_num and only after that the next_net_seq_num will be
+	 * increment. This is why when issuing a command on the relayd using
+	 * this next value, 1 should always be substracted in order to compare
+	 * the last seen sequence number on the relayd side to the last sent.
+	 */
+	data_hdr->net_seq_num = htobe64(stream->next_net_seq_num);
+	/* Other fields are zeroed previously */
+}
+
+/*
+ * Return the relayd data connection on which the packets of a data stream are
+ * sent, or NULL if the relayd has no data connection.
+ *
+ * The connection is selected from the stream's data worker on the first
+ * packet and never changes afterwards.
+ */
+static struct consumer_relayd_data_sock *
+get_relayd_stream_data_sock(struct consumer_relayd_sock_pair *relayd,
+			    struct lttng_consumer_stream *stream)
+{
+	LTTNG_ASSERT(!stream->metadata_flag);
+
+	if (stream->relayd_data_sock_index < 0) {
+		const unsigned int data_sock_count = uatomic_read(&relayd->data_sock_count);
+
+		if (data_sock_count == 0) {
+			return nullptr;
+		}
+
+		/* Pairs with the barrier in consumer_add_relayd_socket(). */
+		cmm_smp_rmb();
+		stream->relayd_data_sock_index = (int) (stream->data_worker_id % data_sock_count);
+		DBG3("Stream %" PRIu64 " bound to relayd %" PRIu64 " data connection %d",
+		     stream->key,
+		     relayd->net_seq_idx,
+		     stream->relayd_data_sock_index);
+	}
+
+	return &relayd->data_socks[stream->relayd_data_sock_index];
+}
+
+/*
+ * Account for bytes of the packets of a data stream appended to the spill
+ * queue of its relayd data connection.
+ */
+static void data_stream_record_spilled_bytes(struct lttng_consumer_stream *stream, size_t len)
+{
+	auto& stats = stream->consumption_stats;
+
+	if (len == 0) {
+		return;
+	}
+
+	CMM_STORE_SHARED(stats.relayd_spilled_bytes, stats.relayd_spilled_bytes + len);
+}
+
 /*
  * Handle stream for relayd transmission if the stream applies for network
  * streaming where the net sequence index is set.
  *
+ * For data streams, the caller MUST hold the lock of the stream's relayd data
+ * connection. The `data_size` bytes of payload must be appended to the spill
+ * queue of the connection rather than sent on the returned socket if the
+ * queue is pending on return.
+ *
  * Return destination file descriptor or negative value on error.
  */
 static int write_relayd_stream_header(struct lttng_consumer_stream *stream,
@@ -832,9 +1075,6 @@ static int write_relayd_stream_header(struct lttng_consumer_stream *stream,
 	LTTNG_ASSERT(stream);
 	LTTNG_ASSERT(relayd);
 
-	/* Reset data header */
-	memset(&data_hdr, 0, sizeof(data_hdr));
-
 	if (stream->metadata_flag) {
 		/* Caller MUST acquire the relayd control socket lock */
 		ret = relayd_send_metadata(&relayd->control_sock, data_size);
@@ -845,36 +1085,103 @@ static int write_relayd_stream_header(struct lttng_consumer_stream *stream,
 		/* Metadata are always sent on the control socket. */
 		outfd = relayd->control_sock.sock.fd;
 	} else {
-		/* Set header with stream information */
-		data_hdr.stream_id = htobe64(stream->relayd_stream_id);
-		data_hdr.data_size = htobe32(data_size);
-		data_hdr.padding_size = htobe32(padding);
-
-		/*
-		 * Note that net_seq_num below is assigned with the *current* value of
-		 * next_net_seq_num and only after that the next_net_seq_num will be
-		 * increment. This is why when issuing a command on the relayd using
-		 * this next value, 1 should always be substracted in order to compare
-		 * the last seen sequence number on the relayd side to the last sent.
-		 */
-		data_hdr.net_seq_num = htobe64(stream->next_net_seq_num);
-		/* Other fields are zeroed previously */
+		struct consumer_relayd_data_sock *data_sock =
+			get_relayd_stream_data_sock(relayd, stream);
+		struct iovec iov;
+		size_t spilled_len;
+		ssize_t send_ret;
+
+		LTTNG_ASSERT(data_sock);
+		if (data_sock->sock.sock.fd < 0) {
+			ret = -ECONNRESET;
+			goto error;
+		}
 
-		ret = relayd_send_data_hdr(&relayd->data_sock, &data_hdr, sizeof(data_hdr));
-		if (ret < 0) {
+		init_relayd_data_hdr(stream, data_size, padding, &data_hdr);
+
+		iov.iov_base = &data_hdr;
+		iov.iov_len = sizeof(data_hdr);
+		DBG3("Relayd sending data header of size %zu", sizeof(data_hdr));
+		send_ret = consumer_relayd_spill_sendv(&data_sock->spill,
+						       data_sock->sock.sock.fd,
+						       &iov,
+						       1,
+						       data_size,
+						       &spilled_len);
+		if (send_ret != (ssize_t) sizeof(data_hdr)) {
+			ret = send_ret < 0 ? -errno : -EPIPE;
 			goto error;
 		}
 
+		data_stream_record_spilled_bytes(stream, spilled_len);
+
 		++stream->next_net_seq_num;
 
 		/* Set to go on data socket */
-		outfd = relayd->data_sock.sock.fd;
+		outfd = data_sock->sock.sock.fd;
 	}
 
 error:
 	return outfd;
 }
 
+/*
+ * Send the relayd data header and the packet of a data stream on the relayd
+ * data socket with a single gather write rather than one write for each.
+ *
+ * Returns the number of payload bytes written, which is lower than "len" on
+ * a partial write. A negative value is returned, with errno set, if the
+ * header could not be sent entirely.
+ */
+static ssize_t write_relayd_data_packet(struct lttng_consumer_stream *stream,
+					const void *buf,
+					size_t len,
+					unsigned long padding,
+					struct consumer_relayd_sock_pair *relayd)
+{
+	ssize_t ret;
+	struct lttcomm_relayd_data_hdr data_hdr;
+	struct iovec iov[2];
+	struct consumer_relayd_data_sock *data_sock;
+	size_t spilled_len;
+
+	LTTNG_ASSERT(stream);
+	LTTNG_ASSERT(!stream->metadata_flag);
+	LTTNG_ASSERT(relayd);
+
+	data_sock = get_relayd_stream_data_sock(relayd, stream);
+	if (!data_sock || data_sock->sock.sock.fd < 0) {
+		errno = ECONNRESET;
+		return -1;
+	}
+
+	init_relayd_data_hdr(stream, len, padding, &data_hdr);
+
+	iov[0].iov_base = &data_hdr;
+	iov[0].iov_len = sizeof(data_hdr);
+	iov[1].iov_base = (void *) buf;
+	iov[1].iov_len = len;
+
+	DBG3("Relayd sending data header of size %zu and packet of size %zu",
+	     sizeof(data_hdr),
+	     len);
+	pthread_mutex_lock(&data_sock->lock);
+	ret = consumer_relayd_spill_sendv(
+		&data_sock->spill, data_sock->sock.sock.fd, iov, 2, 0, &spilled_len);
+	pthread_mutex_unlock(&data_sock->lock);
+	data_stream_record_spilled_bytes(stream, spilled_len);
+	if (ret < (ssize_t) sizeof(data_hdr)) {
+		if (ret >= 0) {
+			/* Partial header; the relayd can't make sense of anything else. */
+			errno = EPIPE;
+		}
+		return -1;
+	}
+
+	++stream->next_net_seq_num;
+	return ret - sizeof(data_hdr);
+}
+
 /*
  * Write a character on the metadata poll pipe to wake the metadata thread.
  * Returns 0 on success, -1 on error.
@@ -1143,69 +1450,89 @@ int consumer_add_channel(struct lttng_consumer_channel *channel,
 	return 0;
 }
 
+namespace {
+/*
+ * Poll set of a data worker and the data streams registered in it. Only
+ * accessed by the worker's thread.
+ */
+struct data_worker_poll_set {
+	struct lttng_poll_event events = {};
+	/*
+	 * Streams registered in the poll set, indexed by wait fd since the
+	 * compat poll API reports events by fd.
+	 */
+	std::unordered_map<int, struct lttng_consumer_stream *> streams;
+};
+} /* namespace */
+
 /*
- * Allocate the pollfd structure and the local view of the out fds to avoid
- * doing a lookup in the linked list and concurrency issues when writing is
- * needed. Called with consumer_data.lock held.
+ * Register a data stream received on the worker's data pipe in the worker's
+ * poll set.
  *
- * Returns the number of fds in the structures.
+ * A stream with an inactive end point is not polled. It is deleted right
+ * away since it will never be consumed.
+ *
+ * Return 0 on success or else a negative value.
  */
-static int update_poll_array(struct lttng_consumer_local_data *ctx,
-			     struct pollfd **pollfd,
-			     struct lttng_consumer_stream **local_stream,
-			     struct lttng_ht *ht,
-			     int *nb_inactive_fd)
+static int data_poll_set_add_stream(struct data_worker_poll_set *poll_set,
+				    struct lttng_consumer_stream *stream)
 {
-	int i = 0;
-	struct lttng_ht_iter iter;
-	struct lttng_consumer_stream *stream;
-
-	LTTNG_ASSERT(ctx);
-	LTTNG_ASSERT(ht);
-	LTTNG_ASSERT(pollfd);
-	LTTNG_ASSERT(local_stream);
+	int ret;
 
-	DBG("Updating poll fd array");
-	*nb_inactive_fd = 0;
+	LTTNG_ASSERT(poll_set);
+	LTTNG_ASSERT(stream);
 
-	{
-		lttng::urcu::read_lock_guard read_lock;
-		cds_lfht_for_each_entry (ht->ht, &iter.iter, stream, node.node) {
-			/*
-			 * Only active streams with an active end point can be added to the
-			 * poll set and local stream storage of the thread.
-			 *
-			 * There is a potential race here for endpoint_status to be updated
-			 * just after the check. However, this is OK since the stream(s) will
-			 * be deleted once the thread is notified that the end point state has
-			 * changed where this function will be called back again.
-			 *
-			 * We track the number of inactive FDs because they still need to be
-			 * closed by the polling thread after a wakeup on the data_pipe or
-			 * metadata_pipe.
-			 */
-			if (stream->endpoint_status == CONSUMER_ENDPOINT_INACTIVE) {
-				(*nb_inactive_fd)++;
-				continue;
-			}
+	/*
+	 * There is a potential race here for endpoint_status to be updated just
+	 * after the check. However, this is OK since the stream(s) will be
+	 * deleted once the thread is notified that the end point state has
+	 * changed.
+	 */
+	if (stream->endpoint_status == CONSUMER_ENDPOINT_INACTIVE) {
+		DBG("Deleting data stream %" PRIu64 " with an inactive end point", stream->key);
+		consumer_del_stream(stream, data_ht);
+		return 0;
+	}
 
-			(*pollfd)[i].fd = stream->wait_fd;
-			(*pollfd)[i].events = POLLIN | POLLPRI;
-			local_stream[i] = stream;
-			i++;
-		}
+	ret = lttng_poll_add(&poll_set->events, stream->wait_fd, LPOLLIN | LPOLLPRI);
+	if (ret < 0) {
+		ERR("Failed to add data stream %" PRIu64 " to poll set", stream->key);
+		return ret;
 	}
 
-	/*
-	 * Insert the consumer_data_pipe at the end of the array and don't
-	 * increment i so nb_fd is the number of real FD.
-	 */
-	(*pollfd)[i].fd = lttng_pipe_get_readfd(ctx->consumer_data_pipe);
-	(*pollfd)[i].events = POLLIN | POLLPRI;
+	poll_set->streams[stream->wait_fd] = stream;
+	DBG("Data stream %" PRIu64 " added to poll set: wait_fd = %d",
+	    stream->key,
+	    stream->wait_fd);
+	return 0;
+}
+
+/*
+ * Unregister a data stream from the worker's poll set and delete it.
+ */
+static void data_poll_set_del_stream(struct data_worker_poll_set *poll_set,
+				     struct lttng_consumer_stream *stream)
+{
+	LTTNG_ASSERT(poll_set);
+	LTTNG_ASSERT(stream);
+
+	/* Must be done before the stream's wait fd is closed. */
+	(void) lttng_poll_del(&poll_set->events, stream->wait_fd);
+	poll_set->streams.erase(stream->wait_fd);
+	consumer_del_stream(stream, data_ht);
+}
+
+/*
+ * Return the data stream registered in the poll set for the given fd or
+ * NULL if none is found (e.g. it was deleted while handling a previous
+ * event of the same poll pass).
+ */
+static struct lttng_consumer_stream *
+data_poll_set_find_stream(const struct data_worker_poll_set *poll_set, int fd)
+{
+	const auto it = poll_set->streams.find(fd);
 
-	(*pollfd)[i + 1].fd = lttng_pipe_get_readfd(ctx->consumer_wakeup_pipe);
-	(*pollfd)[i + 1].events = POLLIN | POLLPRI;
-	return i;
+	return it != poll_set->streams.end() ? it->second : nullptr;
 }
 
 /*
@@ -1345,19 +1672,72 @@ static void lttng_consumer_sync_trace_file(struct lttng_consumer_stream *stream,
 {
 	int outfd = stream->out_fd;
 
+	switch (stream->chan->writeback_policy) {
+	case LTTNG_CHANNEL_WRITEBACK_POLICY_NONE:
+		/* The writeback is left to the kernel. */
+		return;
+	case LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW:
+	{
+		struct lttng_consumer_channel *channel = stream->chan;
+		uint64_t in_flight;
+		off_t nbytes;
+
+		/*
+		 * The writeback of the data just written was started by the
+		 * caller. Only wait once the channel's window is exceeded, and
+		 * then for all the data of this stream that was not waited for
+		 * yet, which brings the channel back within its window.
+		 */
+		in_flight = uatomic_add_return(&channel->writeback_bytes_in_flight,
+					       stream->out_fd_offset - orig_offset);
+		if (in_flight <= channel->writeback_window_size) {
+			return;
+		}
+
+		nbytes = stream->out_fd_offset - stream->writeback_offset;
+		lttng::io::hint_flush_range_dont_need_sync(outfd, stream->writeback_offset, nbytes);
+		stream->writeback_offset = stream->out_fd_offset;
+		uatomic_sub(&channel->writeback_bytes_in_flight, nbytes);
+		return;
+	}
+	case LTTNG_CHANNEL_WRITEBACK_POLICY_SYNC:
+	default:
+		break;
+	}
+
 	/*
-	 * This does a blocking write-and-wait on any page that belongs to the
-	 * subbuffer prior to the one we just wrote.
+	 * This does a write-and-wait on any page that belongs to the subbuffer
+	 * prior to the one we just wrote. The wait only blocks this thread when
+	 * the asynchronous flush backend is disabled or not available.
 	 * Don't care about error values, as these are just hints and ways to
 	 * limit the amount of page cache used.
 	 */
 	if (orig_offset < stream->max_sb_size) {
 		return;
 	}
-	lttng::io::hint_flush_range_dont_need_sync(
+	lttng::io::hint_flush_range_dont_need_async(
 		outfd, orig_offset - stream->max_sb_size, stream->max_sb_size);
 }
 
+/*
+ * Release the pipes of the data workers of a context and the worker array.
+ * lttng_pipe_destroy() accepts a NULL pipe, which covers partially
+ * initialized workers.
+ */
+static void destroy_data_workers(struct lttng_consumer_local_data *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctx->data_worker_count; i++) {
+		lttng_pipe_destroy(ctx->data_workers[i].consumer_data_pipe);
+		lttng_pipe_destroy(ctx->data_workers[i].consumer_wakeup_pipe);
+	}
+
+	free(ctx->data_workers);
+	ctx->data_workers = nullptr;
+	ctx->data_worker_count = 0;
+}
+
 /*
  * Initialise the necessary environnement :
  * - create a new context
@@ -1379,13 +1759,16 @@ lttng_consumer_create(enum lttng_consumer_type type,
 					      bool locked_by_caller),
 		      int (*recv_channel)(struct lttng_consumer_channel *channel),
 		      int (*recv_stream)(struct lttng_consumer_stream *stream),
-		      int (*update_stream)(uint64_t stream_key, uint32_t state))
+		      int (*update_stream)(uint64_t stream_key, uint32_t state),
+		      unsigned int data_worker_count)
 {
 	int ret;
+	unsigned int i;
 	struct lttng_consumer_local_data *ctx;
 
 	LTTNG_ASSERT(the_consumer_data.type == LTTNG_CONSUMER_UNKNOWN ||
 		     the_consumer_data.type == type);
+	LTTNG_ASSERT(data_worker_count > 0);
 	the_consumer_data.type = type;
 
 	ctx = zmalloc<lttng_consumer_local_data>();
@@ -1403,20 +1786,35 @@ lttng_consumer_create(enum lttng_consumer_type type,
 	ctx->on_recv_stream = recv_stream;
 	ctx->on_update_stream = update_stream;
 
-	ctx->consumer_data_pipe = lttng_pipe_open(0);
-	if (!ctx->consumer_data_pipe) {
+	ctx->data_workers = calloc<lttng_consumer_data_worker>(data_worker_count);
+	if (!ctx->data_workers) {
+		PERROR("allocating data workers");
 		goto error_poll_pipe;
 	}
+	ctx->data_worker_count = data_worker_count;
+
+	for (i = 0; i < data_worker_count; i++) {
+		struct lttng_consumer_data_worker *worker = &ctx->data_workers[i];
+
+		worker->id = i;
+		worker->ctx = ctx;
+		worker->numa_node = -1;
+
+		worker->consumer_data_pipe = lttng_pipe_open(0);
+		if (!worker->consumer_data_pipe) {
+			goto error_data_workers;
+		}
 
-	ctx->consumer_wakeup_pipe = lttng_pipe_open(0);
-	if (!ctx->consumer_wakeup_pipe) {
-		goto error_wakeup_pipe;
+		worker->consumer_wakeup_pipe = lttng_pipe_open(0);
+		if (!worker->consumer_wakeup_pipe) {
+			goto error_data_workers;
+		}
 	}
 
 	ret = pipe(ctx->consumer_should_quit);
 	if (ret < 0) {
 		PERROR("Error creating recv pipe");
-		goto error_quit_pipe;
+		goto error_data_workers;
 	}
 
 	ret = pipe(ctx->consumer_channel_pipe);
@@ -1438,16 +1836,86 @@ error_metadata_pipe:
 	utils_close_pipe(ctx->consumer_channel_pipe);
 error_channel_pipe:
 	utils_close_pipe(ctx->consumer_should_quit);
-error_quit_pipe:
-	lttng_pipe_destroy(ctx->consumer_wakeup_pipe);
-error_wakeup_pipe:
-	lttng_pipe_destroy(ctx->consumer_data_pipe);
+error_data_workers:
+	destroy_data_workers(ctx);
 error_poll_pipe:
 	free(ctx);
 error:
 	return nullptr;
 }
 
+/*
+ * Enable the NUMA-aware placement of the data workers and streams.
+ *
+ * The data workers are spread across the nodes of `topology` and each worker
+ * restricts itself to the CPUs of its node when it starts. Streams are then
+ * assigned to a worker of the node of the CPU producing them. Since workers
+ * allocate their output buffers themselves, first-touch allocation keeps
+ * those buffers node-local.
+ *
+ * Must be called before the data workers are launched; `topology` must
+ * outlive the context.
+ */
+void lttng_consumer_set_numa_topology(struct lttng_consumer_local_data *ctx,
+				      const lttng::numa::topology *topology)
+{
+	unsigned int i;
+
+	LTTNG_ASSERT(ctx);
+	LTTNG_ASSERT(topology);
+	LTTNG_ASSERT(topology->node_count() > 0);
+
+	ctx->numa_topology = topology;
+	for (i = 0; i < ctx->data_worker_count; i++) {
+		ctx->data_workers[i].numa_node = (int) (i % topology->node_count());
+	}
+
+	DBG("NUMA placement of data workers enabled: node count = %u, worker count = %u",
+	    topology->node_count(),
+	    ctx->data_worker_count);
+}
+
+/*
+ * Restrict the calling data worker thread to the CPUs of its NUMA node that
+ * it is allowed to run on. Failures are not fatal.
+ */
+static void data_worker_apply_numa_affinity(const struct lttng_consumer_data_worker *worker)
+{
+	int ret;
+	cpu_set_t allowed_cpus, node_cpus;
+
+	if (worker->numa_node < 0) {
+		return;
+	}
+
+	ret = pthread_getaffinity_np(pthread_self(), sizeof(allowed_cpus), &allowed_cpus);
+	if (ret) {
+		errno = ret;
+		PERROR("Failed to get the CPU affinity of data worker %u", worker->id);
+		return;
+	}
+
+	worker->ctx->numa_topology->node_cpu_set(worker->numa_node, &node_cpus);
+	CPU_AND(&node_cpus, &node_cpus, &allowed_cpus);
+	if (CPU_COUNT(&node_cpus) == 0) {
+		WARN("Data worker %u is not allowed to run on any CPU of NUMA node %d",
+		     worker->id,
+		     worker->numa_node);
+		return;
+	}
+
+	ret = pthread_setaffinity_np(pthread_self(), sizeof(node_cpus), &node_cpus);
+	if (ret) {
+		errno = ret;
+		PERROR("Failed to pin data worker %u to NUMA node %d",
+		       worker->id,
+		       worker->numa_node);
+		return;
+	}
+
+	DBG("Data worker %u pinned to NUMA node %d", worker->id, worker->numa_node);
+}
+
 /*
  * Iterate over all streams of the hashtable and free them properly.
  */
@@ -1526,9 +1994,8 @@ void lttng_consumer_destroy(struct lttng_consumer_local_data *ctx)
 		PERROR("close");
 	}
 	utils_close_pipe(ctx->consumer_channel_pipe);
-	lttng_pipe_destroy(ctx->consumer_data_pipe);
+	destroy_data_workers(ctx);
 	lttng_pipe_destroy(ctx->consumer_metadata_pipe);
-	lttng_pipe_destroy(ctx->consumer_wakeup_pipe);
 	utils_close_pipe(ctx->consumer_should_quit);
 
 	unlink(ctx->consumer_command_sock_path);
@@ -1597,13 +2064,22 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(struct lttng_consumer_stream *stre
 	const size_t subbuf_content_size = buffer->size - padding;
 	size_t write_len;
 
+	if (stream->snapshot_fd_output) {
+		ret = consumer_snapshot_fd_output_write(stream->snapshot_fd_output, stream, buffer);
+		if (ret > 0) {
+			stream->output_written += ret;
+		}
+
+		return ret;
+	}
+
 	/* RCU lock for the relayd pointer */
 	lttng::urcu::read_lock_guard read_lock;
 	LTTNG_ASSERT(stream->net_seq_idx != (uint64_t) -1ULL || stream->trace_chunk);
 
 	/* Flag that the current stream if set for network streaming. */
 	if (stream->net_seq_idx != (uint64_t) -1ULL) {
-		relayd = consumer_find_relayd(stream->net_seq_idx);
+		relayd = consumer_stream_find_relayd(stream);
 		if (relayd == nullptr) {
 			ret = -EPIPE;
 			goto end;
@@ -1634,16 +2110,20 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(struct lttng_consumer_stream *stre
 			netlen += sizeof(struct lttcomm_relayd_metadata_payload);
 		}
 
-		ret = write_relayd_stream_header(stream, netlen, padding, relayd);
-		if (ret < 0) {
-			relayd_hang_up = 1;
-			goto write_error;
-		}
-		/* Use the returned socket. */
-		outfd = ret;
-
-		/* Write metadata stream id before payload */
+		/*
+		 * The header of data stream packets is sent along with the payload
+		 * by write_relayd_data_packet().
+		 */
 		if (stream->metadata_flag) {
+			ret = write_relayd_stream_header(stream, netlen, padding, relayd);
+			if (ret < 0) {
+				relayd_hang_up = 1;
+				goto write_error;
+			}
+			/* Use the returned socket. */
+			outfd = ret;
+
+			/* Write metadata stream id before payload */
 			ret = write_relayd_metadata_id(outfd, stream, padding);
 			if (ret < 0) {
 				relayd_hang_up = 1;
@@ -1676,6 +2156,7 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(struct lttng_consumer_stream *stre
 			outfd = stream->out_fd;
 			orig_offset = 0;
 		}
+		consumer_stream_preallocate_output_file(stream, buffer->size);
 		stream->tracefile_size_current += buffer->size;
 		write_len = buffer->size;
 	}
@@ -1684,7 +2165,11 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(struct lttng_consumer_stream *stre
 	 * This call guarantee that len or less is returned. It's impossible to
 	 * receive a ret value that is bigger than len.
 	 */
-	ret = lttng_write(outfd, buffer->data, write_len);
+	if (relayd && !stream->metadata_flag) {
+		ret = write_relayd_data_packet(stream, buffer->data, write_len, padding, relayd);
+	} else {
+		ret = lttng_write(outfd, buffer->data, write_len);
+	}
 	DBG("Consumer mmap write() ret %zd (len %zu)", ret, write_len);
 	if (ret < 0 || ((size_t) ret != write_len)) {
 		/*
@@ -1759,6 +2244,7 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(struct lttng_consumer_local_data
 	/* Default is on the disk */
 	int outfd = stream->out_fd;
 	struct consumer_relayd_sock_pair *relayd = nullptr;
+	struct consumer_relayd_data_sock *data_sock = nullptr;
 	int *splice_pipe;
 	unsigned int relayd_hang_up = 0;
 
@@ -1779,7 +2265,7 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(struct lttng_consumer_local_data
 
 	/* Flag that the current stream if set for network streaming. */
 	if (stream->net_seq_idx != (uint64_t) -1ULL) {
-		relayd = consumer_find_relayd(stream->net_seq_idx);
+		relayd = consumer_stream_find_relayd(stream);
 		if (relayd == nullptr) {
 			written = -ret;
 			goto end;
@@ -1787,6 +2273,16 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(struct lttng_consumer_local_data
 	}
 	splice_pipe = stream->splice_pipe;
 
+	if (stream->snapshot_fd_output) {
+		written = consumer_snapshot_fd_output_splice(
+			stream->snapshot_fd_output, stream, fd, splice_pipe, len + padding);
+		if (written > 0) {
+			stream->output_written += written;
+		}
+
+		goto end;
+	}
+
 	/* Write metadata stream id before payload */
 	if (relayd) {
 		unsigned long total_len = len;
@@ -1816,6 +2312,19 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(struct lttng_consumer_local_data
 			}
 
 			total_len += sizeof(struct lttcomm_relayd_metadata_payload);
+		} else {
+			/*
+			 * Lock the data connection until the whole packet is
+			 * spliced to it.
+			 */
+			data_sock = get_relayd_stream_data_sock(relayd, stream);
+			if (!data_sock) {
+				written = -ECONNRESET;
+				relayd_hang_up = 1;
+				goto write_error;
+			}
+
+			pthread_mutex_lock(&data_sock->lock);
 		}
 
 		ret = write_relayd_stream_header(stream, total_len, padding, relayd);
@@ -1851,6 +2360,7 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(struct lttng_consumer_local_data
 			outfd = stream->out_fd;
 			orig_offset = 0;
 		}
+		consumer_stream_preallocate_output_file(stream, len);
 		stream->tracefile_size_current += len;
 	}
 
@@ -1886,12 +2396,21 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(struct lttng_consumer_local_data
 		}
 
 		/* Splice data out */
-		ret_splice = splice(splice_pipe[0],
-				    nullptr,
-				    outfd,
-				    nullptr,
-				    ret_splice,
-				    SPLICE_F_MOVE | SPLICE_F_MORE);
+		if (data_sock && consumer_relayd_spill_is_pending(&data_sock->spill)) {
+			/* The header was spilled, the payload must follow it. */
+			ret_splice = consumer_relayd_spill_splice(
+				&data_sock->spill, splice_pipe[0], ret_splice);
+			if (ret_splice > 0) {
+				data_stream_record_spilled_bytes(stream, ret_splice);
+			}
+		} else {
+			ret_splice = splice(splice_pipe[0],
+					    nullptr,
+					    outfd,
+					    nullptr,
+					    ret_splice,
+					    SPLICE_F_MOVE | SPLICE_F_MORE);
+		}
 		DBG("Consumer splice pipe to file (out_fd: %d), ret %zd", outfd, ret_splice);
 		if (ret_splice < 0) {
 			ret = errno;
@@ -1957,6 +2476,10 @@ end:
 		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
 	}
 
+	if (data_sock) {
+		pthread_mutex_unlock(&data_sock->lock);
+	}
+
 	return written;
 }
 
@@ -2219,26 +2742,27 @@ void consumer_add_metadata_stream(struct lttng_consumer_stream *stream)
 }
 
 /*
- * Delete data stream that are flagged for deletion (endpoint_status).
+ * Delete data stream that are flagged for deletion (endpoint_status) and
+ * are registered in the given data worker's poll set.
  */
-static void validate_endpoint_status_data_stream()
+static void validate_endpoint_status_data_stream(struct data_worker_poll_set *poll_set)
 {
-	struct lttng_ht_iter iter;
-	struct lttng_consumer_stream *stream;
+	std::vector<struct lttng_consumer_stream *> inactive_streams;
 
 	DBG("Consumer delete flagged data stream");
 
-	{
-		lttng::urcu::read_lock_guard read_lock;
-
-		cds_lfht_for_each_entry (data_ht->ht, &iter.iter, stream, node.node) {
-			/* Validate delete flag of the stream */
-			if (stream->endpoint_status == CONSUMER_ENDPOINT_ACTIVE) {
-				continue;
-			}
-			/* Delete it right now */
-			consumer_del_stream(stream, data_ht);
+	for (const auto& entry : poll_set->streams) {
+		/* Validate delete flag of the stream */
+		if (entry.second->endpoint_status == CONSUMER_ENDPOINT_ACTIVE) {
+			continue;
 		}
+
+		inactive_streams.push_back(entry.second);
+	}
+
+	/* Delete them right now */
+	for (auto stream : inactive_streams) {
+		data_poll_set_del_stream(poll_set, stream);
 	}
 }
 
@@ -2492,27 +3016,169 @@ error_testpoint:
 	return nullptr;
 }
 
+static uint64_t consumption_histogram_bucket(uint64_t value)
+{
+	/* floor(log2(value)), clamped to the histogram's range. */
+	const int order = value ? utils_get_count_order_u64(value + 1) - 1 : 0;
+
+	return std::min<uint64_t>(order, LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+/*
+ * Account for the consumption of a data stream which was found ready at
+ * `ready_ts_ns`.
+ *
+ * Only the stream's data worker updates its statistics; the stores are
+ * atomic to allow the command thread to read them at any time.
+ */
+static void data_stream_record_consumption_latency(struct lttng_consumer_stream *stream,
+						   uint64_t ready_ts_ns)
+{
+	struct timespec now;
+	uint64_t latency_us = 0;
+
+	if (lttng_clock_gettime(CLOCK_MONOTONIC, &now) == 0) {
+		const uint64_t now_ns = (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+
+		latency_us = now_ns > ready_ts_ns ? (now_ns - ready_ts_ns) / NSEC_PER_USEC : 0;
+	}
+
+	const uint64_t latency_bucket = consumption_histogram_bucket(latency_us);
+	auto& stats = stream->consumption_stats;
+
+	CMM_STORE_SHARED(stats.latency_histogram[latency_bucket],
+			 stats.latency_histogram[latency_bucket] + 1);
+}
+
+/*
+ * Account for a sub-buffer of `len` bytes consumed from a data stream. Same
+ * single-writer rule as data_stream_record_consumption_latency().
+ */
+static void data_stream_record_subbuffer_size(struct lttng_consumer_stream *stream, size_t len)
+{
+	const uint64_t size_bucket = consumption_histogram_bucket(len);
+	auto& stats = stream->consumption_stats;
+
+	CMM_STORE_SHARED(stats.size_histogram[size_bucket], stats.size_histogram[size_bucket] + 1);
+}
+
+/*
+ * Read the available sub-buffers of a data stream of the worker's poll set.
+ *
+ * The stream is deleted on a fatal read error. Otherwise, it is flagged as
+ * having data left to be read if anything was consumed.
+ */
+static void data_poll_set_read_stream(struct data_worker_poll_set *poll_set,
+				      struct lttng_consumer_stream *stream,
+				      struct lttng_consumer_local_data *ctx,
+				      uint64_t ready_ts_ns)
+{
+	ssize_t len;
+
+	len = ctx->on_buffer_ready(stream, ctx, false);
+	/* it's ok to have an unavailable sub-buffer */
+	if (len < 0 && len != -EAGAIN && len != -ENODATA) {
+		/* Clean the stream and free it. */
+		data_poll_set_del_stream(poll_set, stream);
+	} else if (len > 0) {
+		stream->has_data_left_to_be_read_before_teardown = 1;
+		data_stream_record_consumption_latency(stream, ready_ts_ns);
+	}
+}
+
+void consumer_consumption_stats_merge(struct lttcomm_consumer_channel_consumption_stats *dst,
+				      const struct lttcomm_consumer_channel_consumption_stats *src)
+{
+	unsigned int i;
+
+	for (i = 0; i < LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT; i++) {
+		dst->latency_histogram[i] += CMM_LOAD_SHARED(src->latency_histogram[i]);
+		dst->size_histogram[i] += CMM_LOAD_SHARED(src->size_histogram[i]);
+	}
+
+	dst->relayd_spilled_bytes += CMM_LOAD_SHARED(src->relayd_spilled_bytes);
+}
+
+/*
+ * Merge the consumption statistics of all the data streams of a channel,
+ * including the streams that were already destroyed, along with the size of
+ * their smallest splice pipe. The statistics are zeroed if the channel is
+ * unknown.
+ */
+void lttng_consumer_get_channel_consumption_stats(
+	uint64_t session_id,
+	uint64_t channel_key,
+	struct lttcomm_consumer_channel_consumption_stats *stats)
+{
+	struct lttng_ht_iter iter;
+	struct lttng_ht *ht = the_consumer_data.stream_list_ht;
+	struct lttng_consumer_stream *stream;
+	struct lttng_consumer_channel *channel;
+
+	memset(stats, 0, sizeof(*stats));
+
+	lttng::urcu::read_lock_guard read_lock;
+	pthread_mutex_lock(&the_consumer_data.lock);
+	channel = consumer_find_channel(channel_key);
+	if (channel) {
+		pthread_mutex_lock(&channel->lock);
+		consumer_consumption_stats_merge(stats,
+						 &channel->retired_streams_consumption_stats);
+		pthread_mutex_unlock(&channel->lock);
+	}
+
+	cds_lfht_for_each_entry_duplicate(ht->ht,
+					  ht->hash_fct(&session_id, lttng_ht_seed),
+					  ht->match_fct,
+					  &session_id,
+					  &iter.iter,
+					  stream,
+					  node_session_id.node)
+	{
+		if (stream->chan->key != channel_key || stream->metadata_flag) {
+			continue;
+		}
+
+		consumer_consumption_stats_merge(stats, &stream->consumption_stats);
+		if (stream->output == LTTNG_EVENT_SPLICE && stream->splice_pipe_size &&
+		    (!stats->splice_pipe_size ||
+		     stream->splice_pipe_size < stats->splice_pipe_size)) {
+			stats->splice_pipe_size = stream->splice_pipe_size;
+		}
+	}
+	pthread_mutex_unlock(&the_consumer_data.lock);
+}
+
 /*
  * This thread polls the fds in the set to consume the data and write
  * it to tracefile if necessary.
+ *
+ * One instance of this thread runs per data worker and only handles the
+ * streams assigned to its worker (see struct lttng_consumer_data_worker).
+ *
+ * Streams are registered in the worker's poll set when they are received on
+ * its data pipe and unregistered when they are deleted so that the poll set
+ * never needs to be rebuilt.
  */
 void *consumer_thread_data_poll(void *data)
 {
-	int num_rdy, high_prio, ret, i, err = -1;
-	struct pollfd *pollfd = nullptr;
-	/* local view of the streams */
-	struct lttng_consumer_stream **local_stream = nullptr, *new_stream = nullptr;
-	/* local view of consumer_data.fds_count */
-	int nb_fd = 0;
-	/* 2 for the consumer_data_pipe and wake up pipe */
-	const int nb_pipes_fd = 2;
-	/* Number of FDs with CONSUMER_ENDPOINT_INACTIVE but still open. */
-	int nb_inactive_fd = 0;
-	struct lttng_consumer_local_data *ctx = (lttng_consumer_local_data *) data;
-	ssize_t len;
+	int ret, i, high_prio, err = -1;
+	uint32_t revents, nb_fd;
+	struct lttng_consumer_stream *stream = nullptr;
+	struct lttng_consumer_data_worker *worker = (lttng_consumer_data_worker *) data;
+	struct lttng_consumer_local_data *ctx = worker->ctx;
+	struct data_worker_poll_set poll_set;
+	/* Streams flagged with data to be read when the wakeup pipe triggered. */
+	std::vector<struct lttng_consumer_stream *> woken_streams;
+	bool woken_up;
+	/* Time at which the last poll returned; streams found ready are ready since. */
+	uint64_t ready_ts_ns;
 
 	rcu_register_thread();
 
+	/* Before any allocation, for those to be node-local. */
+	data_worker_apply_numa_affinity(worker);
+
 	health_register(health_consumerd, HEALTH_CONSUMERD_TYPE_DATA);
 
 	if (testpoint(consumerd_thread_data)) {
@@ -2521,9 +3187,24 @@ void *consumer_thread_data_poll(void *data)
 
 	health_code_update();
 
-	local_stream = zmalloc<lttng_consumer_stream *>();
-	if (local_stream == nullptr) {
-		PERROR("local_stream malloc");
+	/* 2 for the consumer_data_pipe and wake up pipe */
+	ret = lttng_poll_create(&poll_set.events, 2, LTTNG_CLOEXEC);
+	if (ret < 0) {
+		ERR("Poll set creation failed");
+		goto end_poll;
+	}
+
+	ret = lttng_poll_add(&poll_set.events,
+			     lttng_pipe_get_readfd(worker->consumer_data_pipe),
+			     LPOLLIN | LPOLLPRI);
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = lttng_poll_add(&poll_set.events,
+			     lttng_pipe_get_readfd(worker->consumer_wakeup_pipe),
+			     LPOLLIN | LPOLLPRI);
+	if (ret < 0) {
 		goto end;
 	}
 
@@ -2531,64 +3212,26 @@ void *consumer_thread_data_poll(void *data)
 		health_code_update();
 
 		high_prio = 0;
-
-		/*
-		 * the fds set has been updated, we need to update our
-		 * local array as well
-		 */
-		pthread_mutex_lock(&the_consumer_data.lock);
-		if (the_consumer_data.need_update) {
-			free(pollfd);
-			pollfd = nullptr;
-
-			free(local_stream);
-			local_stream = nullptr;
-
-			/* Allocate for all fds */
-			pollfd =
-				calloc<struct pollfd>(the_consumer_data.stream_count + nb_pipes_fd);
-			if (pollfd == nullptr) {
-				PERROR("pollfd malloc");
-				pthread_mutex_unlock(&the_consumer_data.lock);
-				goto end;
-			}
-
-			local_stream = calloc<lttng_consumer_stream *>(
-				the_consumer_data.stream_count + nb_pipes_fd);
-			if (local_stream == nullptr) {
-				PERROR("local_stream malloc");
-				pthread_mutex_unlock(&the_consumer_data.lock);
-				goto end;
-			}
-			ret = update_poll_array(
-				ctx, &pollfd, local_stream, data_ht, &nb_inactive_fd);
-			if (ret < 0) {
-				ERR("Error in allocating pollfd or local_outfds");
-				lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_POLL_ERROR);
-				pthread_mutex_unlock(&the_consumer_data.lock);
-				goto end;
-			}
-			nb_fd = ret;
-			the_consumer_data.need_update = 0;
-		}
-		pthread_mutex_unlock(&the_consumer_data.lock);
+		woken_up = false;
 
 		/* No FDs and consumer_quit, consumer_cleanup the thread */
-		if (nb_fd == 0 && nb_inactive_fd == 0 && CMM_LOAD_SHARED(consumer_quit) == 1) {
+		if (poll_set.streams.empty() && CMM_LOAD_SHARED(consumer_quit) == 1) {
 			err = 0; /* All is OK */
 			goto end;
 		}
 		/* poll on the array of fds */
 	restart:
-		DBG("polling on %d fd", nb_fd + nb_pipes_fd);
+		DBG("Data worker %u polling on %d fd",
+		    worker->id,
+		    LTTNG_POLL_GETNB(&poll_set.events));
 		if (testpoint(consumerd_thread_data_poll)) {
 			goto end;
 		}
 		health_poll_entry();
-		num_rdy = poll(pollfd, nb_fd + nb_pipes_fd, -1);
+		ret = lttng_poll_wait(&poll_set.events, -1);
 		health_poll_exit();
-		DBG("poll num_rdy : %d", num_rdy);
-		if (num_rdy == -1) {
+		DBG("poll num_rdy : %d", ret);
+		if (ret < 0) {
 			/*
 			 * Restart interrupted system call.
 			 */
@@ -2598,7 +3241,7 @@ void *consumer_thread_data_poll(void *data)
 			PERROR("Poll error");
 			lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_POLL_ERROR);
 			goto end;
-		} else if (num_rdy == 0) {
+		} else if (ret == 0) {
 			DBG("Polling thread timed out");
 			goto end;
 		}
@@ -2609,24 +3252,39 @@ void *consumer_thread_data_poll(void *data)
 			goto restart;
 		}
 
+		nb_fd = ret;
+
+		{
+			struct timespec now = {};
+
+			(void) lttng_clock_gettime(CLOCK_MONOTONIC, &now);
+			ready_ts_ns = (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+		}
+
 		/*
-		 * If the consumer_data_pipe triggered poll go directly to the
-		 * beginning of the loop to update the array. We want to prioritize
-		 * array update over low-priority reads.
+		 * If the consumer_data_pipe triggered poll, register the new stream
+		 * and go directly to the beginning of the loop. We want to
+		 * prioritize poll set updates over low-priority reads.
 		 */
-		if (pollfd[nb_fd].revents & (POLLIN | POLLPRI)) {
+		for (i = 0; i < nb_fd; i++) {
 			ssize_t pipe_readlen;
 
+			revents = LTTNG_POLL_GETEV(&poll_set.events, i);
+			if (LTTNG_POLL_GETFD(&poll_set.events, i) !=
+				    lttng_pipe_get_readfd(worker->consumer_data_pipe) ||
+			    !(revents & (LPOLLIN | LPOLLPRI))) {
+				continue;
+			}
+
 			DBG("consumer_data_pipe wake up");
-			pipe_readlen = lttng_pipe_read(ctx->consumer_data_pipe,
-						       &new_stream,
-						       sizeof(new_stream)); /* NOLINT sizeof used on
-									       a pointer. */
-			if (pipe_readlen < sizeof(new_stream)) { /* NOLINT sizeof used on a pointer.
-								  */
+			pipe_readlen = lttng_pipe_read(worker->consumer_data_pipe,
+						       &stream,
+						       sizeof(stream)); /* NOLINT sizeof used on a
+									   pointer. */
+			if (pipe_readlen < sizeof(stream)) { /* NOLINT sizeof used on a pointer. */
 				PERROR("Consumer data pipe");
 				/* Continue so we can at least handle the current stream(s). */
-				continue;
+				break;
 			}
 
 			/*
@@ -2634,49 +3292,60 @@ void *consumer_thread_data_poll(void *data)
 			 * the sessiond poll thread changed the consumer_quit state and is
 			 * waking us up to test it.
 			 */
-			if (new_stream == nullptr) {
-				validate_endpoint_status_data_stream();
-				continue;
+			if (stream == nullptr) {
+				validate_endpoint_status_data_stream(&poll_set);
+				break;
 			}
 
+			ret = data_poll_set_add_stream(&poll_set, stream);
+			if (ret < 0) {
+				lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_POLL_ERROR);
+				consumer_del_stream(stream, data_ht);
+				goto end;
+			}
+			break;
+		}
+		if (i < nb_fd) {
 			/* Continue to update the local streams and handle prio ones */
 			continue;
 		}
 
-		/* Handle wakeup pipe. */
-		if (pollfd[nb_fd + 1].revents & (POLLIN | POLLPRI)) {
-			char dummy;
-			ssize_t pipe_readlen;
-
-			pipe_readlen =
-				lttng_pipe_read(ctx->consumer_wakeup_pipe, &dummy, sizeof(dummy));
-			if (pipe_readlen < 0) {
-				PERROR("Consumer data wakeup pipe");
-			}
-			/* We've been awakened to handle stream(s). */
-			ctx->has_wakeup = 0;
-		}
-
 		/* Take care of high priority channels first. */
 		for (i = 0; i < nb_fd; i++) {
+			const auto pollfd = LTTNG_POLL_GETFD(&poll_set.events, i);
+
 			health_code_update();
 
-			if (local_stream[i] == nullptr) {
+			revents = LTTNG_POLL_GETEV(&poll_set.events, i);
+
+			/* Handle wakeup pipe. */
+			if (pollfd == lttng_pipe_get_readfd(worker->consumer_wakeup_pipe)) {
+				char dummy;
+				ssize_t pipe_readlen;
+
+				if (!(revents & (LPOLLIN | LPOLLPRI))) {
+					continue;
+				}
+
+				pipe_readlen = lttng_pipe_read(
+					worker->consumer_wakeup_pipe, &dummy, sizeof(dummy));
+				if (pipe_readlen < 0) {
+					PERROR("Consumer data wakeup pipe");
+				}
+				/* We've been awakened to handle stream(s). */
+				worker->has_wakeup = 0;
+				woken_up = true;
+				continue;
+			}
+
+			stream = data_poll_set_find_stream(&poll_set, pollfd);
+			if (stream == nullptr) {
 				continue;
 			}
-			if (pollfd[i].revents & POLLPRI) {
-				DBG("Urgent read on fd %d", pollfd[i].fd);
+			if (revents & LPOLLPRI) {
+				DBG("Urgent read on fd %d", pollfd);
 				high_prio = 1;
-				len = ctx->on_buffer_ready(local_stream[i], ctx, false);
-				/* it's ok to have an unavailable sub-buffer */
-				if (len < 0 && len != -EAGAIN && len != -ENODATA) {
-					/* Clean the stream and free it. */
-					consumer_del_stream(local_stream[i], data_ht);
-					local_stream[i] = nullptr;
-				} else if (len > 0) {
-					local_stream[i]->has_data_left_to_be_read_before_teardown =
-						1;
-				}
+				data_poll_set_read_stream(&poll_set, stream, ctx, ready_ts_ns);
 			}
 		}
 
@@ -2690,43 +3359,62 @@ void *consumer_thread_data_poll(void *data)
 
 		/* Take care of low priority channels. */
 		for (i = 0; i < nb_fd; i++) {
+			const auto pollfd = LTTNG_POLL_GETFD(&poll_set.events, i);
+
 			health_code_update();
 
-			if (local_stream[i] == nullptr) {
+			stream = data_poll_set_find_stream(&poll_set, pollfd);
+			if (stream == nullptr) {
 				continue;
 			}
-			if ((pollfd[i].revents & POLLIN) || local_stream[i]->hangup_flush_done ||
-			    local_stream[i]->has_data) {
-				DBG("Normal read on fd %d", pollfd[i].fd);
-				len = ctx->on_buffer_ready(local_stream[i], ctx, false);
-				/* it's ok to have an unavailable sub-buffer */
-				if (len < 0 && len != -EAGAIN && len != -ENODATA) {
-					/* Clean the stream and free it. */
-					consumer_del_stream(local_stream[i], data_ht);
-					local_stream[i] = nullptr;
-				} else if (len > 0) {
-					local_stream[i]->has_data_left_to_be_read_before_teardown =
-						1;
+			revents = LTTNG_POLL_GETEV(&poll_set.events, i);
+			if ((revents & LPOLLIN) || stream->hangup_flush_done || stream->has_data) {
+				DBG("Normal read on fd %d", pollfd);
+				data_poll_set_read_stream(&poll_set, stream, ctx, ready_ts_ns);
+			}
+		}
+
+		/*
+		 * Streams flagged as having data left to be read do not necessarily
+		 * have a pending poll event. The wakeup pipe is written to every time
+		 * such a flag is set, so they only need to be looked for when it
+		 * triggered.
+		 */
+		if (woken_up) {
+			woken_streams.clear();
+			for (const auto& entry : poll_set.streams) {
+				if (entry.second->has_data) {
+					woken_streams.push_back(entry.second);
 				}
 			}
+
+			for (auto woken_stream : woken_streams) {
+				health_code_update();
+
+				DBG("Normal read on fd %d", woken_stream->wait_fd);
+				data_poll_set_read_stream(
+					&poll_set, woken_stream, ctx, ready_ts_ns);
+			}
 		}
 
 		/* Handle hangup and errors */
 		for (i = 0; i < nb_fd; i++) {
+			const auto pollfd = LTTNG_POLL_GETFD(&poll_set.events, i);
+
 			health_code_update();
 
-			if (local_stream[i] == nullptr) {
+			stream = data_poll_set_find_stream(&poll_set, pollfd);
+			if (stream == nullptr) {
 				continue;
 			}
-			if (!local_stream[i]->hangup_flush_done &&
-			    (pollfd[i].revents & (POLLHUP | POLLERR | POLLNVAL)) &&
+			revents = LTTNG_POLL_GETEV(&poll_set.events, i);
+			if (!stream->hangup_flush_done && (revents & (LPOLLHUP | LPOLLERR)) &&
 			    (the_consumer_data.type == LTTNG_CONSUMER32_UST ||
 			     the_consumer_data.type == LTTNG_CONSUMER64_UST)) {
-				DBG("fd %d is hup|err|nval. Attempting flush and read.",
-				    pollfd[i].fd);
-				lttng_ustconsumer_on_stream_hangup(local_stream[i]);
+				DBG("fd %d is hup|err|nval. Attempting flush and read.", pollfd);
+				lttng_ustconsumer_on_stream_hangup(stream);
 				/* Attempt read again, for the data we just flushed. */
-				local_stream[i]->has_data_left_to_be_read_before_teardown = 1;
+				stream->has_data_left_to_be_read_before_teardown = 1;
 			}
 			/*
 			 * When a stream's pipe dies (hup/err/nval), an "inactive producer" flush is
@@ -2741,37 +3429,29 @@ void *consumer_thread_data_poll(void *data)
 			 * read no data in this pass, we can remove the
 			 * stream from its hash table.
 			 */
-			if ((pollfd[i].revents & POLLHUP)) {
-				DBG("Polling fd %d tells it has hung up.", pollfd[i].fd);
-				if (!local_stream[i]->has_data_left_to_be_read_before_teardown) {
-					consumer_del_stream(local_stream[i], data_ht);
-					local_stream[i] = nullptr;
-				}
-			} else if (pollfd[i].revents & POLLERR) {
-				ERR("Error returned in polling fd %d.", pollfd[i].fd);
-				if (!local_stream[i]->has_data_left_to_be_read_before_teardown) {
-					consumer_del_stream(local_stream[i], data_ht);
-					local_stream[i] = nullptr;
+			if (revents & LPOLLHUP) {
+				DBG("Polling fd %d tells it has hung up.", pollfd);
+				if (!stream->has_data_left_to_be_read_before_teardown) {
+					data_poll_set_del_stream(&poll_set, stream);
+					continue;
 				}
-			} else if (pollfd[i].revents & POLLNVAL) {
-				ERR("Polling fd %d tells fd is not open.", pollfd[i].fd);
-				if (!local_stream[i]->has_data_left_to_be_read_before_teardown) {
-					consumer_del_stream(local_stream[i], data_ht);
-					local_stream[i] = nullptr;
+			} else if (revents & LPOLLERR) {
+				ERR("Error returned in polling fd %d.", pollfd);
+				if (!stream->has_data_left_to_be_read_before_teardown) {
+					data_poll_set_del_stream(&poll_set, stream);
+					continue;
 				}
 			}
-			if (local_stream[i] != nullptr) {
-				local_stream[i]->has_data_left_to_be_read_before_teardown = 0;
-			}
+			stream->has_data_left_to_be_read_before_teardown = 0;
 		}
 	}
 	/* All is OK */
 	err = 0;
 end:
-	DBG("polling thread exiting");
-	free(pollfd);
-	free(local_stream);
+	DBG("Data worker %u polling thread exiting", worker->id);
 
+	lttng_poll_clean(&poll_set.events);
+end_poll:
 	/*
 	 * Close the write side of the pipe so epoll_wait() in
 	 * consumer_thread_metadata_poll can catch it. The thread is monitoring the
@@ -2779,8 +3459,13 @@ end:
 	 * not return and could create a endless wait period if the pipe is the
 	 * only tracked fd in the poll set. The thread will take care of closing
 	 * the read side.
+	 *
+	 * Only the last data worker to exit does so since the metadata thread
+	 * must outlive all data workers.
 	 */
-	(void) lttng_pipe_write_close(ctx->consumer_metadata_pipe);
+	if (uatomic_sub_return(&ctx->data_worker_online_count, 1) == 0) {
+		(void) lttng_pipe_write_close(ctx->consumer_metadata_pipe);
+	}
 
 error_testpoint:
 	if (err) {
@@ -3294,7 +3979,7 @@ end:
 	 * Notify the data poll thread to poll back again and test the
 	 * consumer_quit state that we just set so to quit gracefully.
 	 */
-	notify_thread_lttng_pipe(ctx->consumer_data_pipe);
+	notify_data_workers(ctx);
 
 	notify_channel_pipe(ctx, nullptr, -1, CONSUMER_CHANNEL_QUIT);
 
@@ -3353,8 +4038,11 @@ ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 {
 	ssize_t ret, written_bytes = 0;
 	int rotation_ret;
+	unsigned int subbuffer_count = 0;
 	struct stream_subbuffer subbuffer = {};
 	enum get_next_subbuffer_status get_next_status;
+	const unsigned int max_subbuffers = stream->chan->drain_max_subbuffers ?: 1;
+	const uint64_t max_bytes = stream->chan->drain_max_bytes;
 
 	if (!locked_by_caller) {
 		stream->read_subbuffer_ops.lock(stream);
@@ -3362,6 +4050,14 @@ ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		stream->read_subbuffer_ops.assert_locked(stream);
 	}
 
+	/*
+	 * The monitor timer found the stream busy: publish a fresh sample for
+	 * it before consuming, as the buffer usage is the highest.
+	 */
+	if (uatomic_read(&stream->monitor_sample_requested)) {
+		(void) consumer_stream_publish_monitor_sample(stream);
+	}
+
 	if (stream->read_subbuffer_ops.on_wake_up) {
 		ret = stream->read_subbuffer_ops.on_wake_up(stream);
 		if (ret) {
@@ -3382,81 +4078,146 @@ ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		}
 	}
 
-	get_next_status = stream->read_subbuffer_ops.get_next_subbuffer(stream, &subbuffer);
-	switch (get_next_status) {
-	case GET_NEXT_SUBBUFFER_STATUS_OK:
-		break;
-	case GET_NEXT_SUBBUFFER_STATUS_NO_DATA:
-		/* Not an error. */
-		ret = 0;
-		goto sleep_stream;
-	case GET_NEXT_SUBBUFFER_STATUS_ERROR:
-		ret = -1;
-		goto end;
-	default:
-		abort();
-	}
-
-	ret = stream->read_subbuffer_ops.pre_consume_subbuffer(stream, &subbuffer);
-	if (ret) {
-		goto error_put_subbuf;
-	}
-
-	written_bytes = stream->read_subbuffer_ops.consume_subbuffer(ctx, stream, &subbuffer);
-	if (written_bytes <= 0) {
-		ERR("Error consuming subbuffer: (%zd)", written_bytes);
-		ret = (int) written_bytes;
-		goto error_put_subbuf;
-	}
-
-	ret = stream->read_subbuffer_ops.put_next_subbuffer(stream, &subbuffer);
-	if (ret) {
-		goto end;
-	}
-
-	ret = post_consume(stream, &subbuffer, ctx);
-	if (ret) {
-		goto end;
+	if (max_subbuffers > 1) {
+		consumer_stream_begin_index_batch(stream);
 	}
 
 	/*
-	 * After extracting the packet, we check if the stream is now ready to
-	 * be rotated and perform the action immediately.
-	 *
-	 * Don't overwrite `ret` as callers expect the number of bytes
-	 * consumed to be returned on success.
+	 * Consume up to `max_subbuffers` sub-buffers, or `max_bytes` bytes,
+	 * before going back to sleep.
 	 */
-	rotation_ret = lttng_consumer_stream_is_rotate_ready(stream);
-	if (rotation_ret == 1) {
-		rotation_ret = lttng_consumer_rotate_stream(stream);
-		if (rotation_ret < 0) {
-			ret = rotation_ret;
-			ERR("Stream rotation error after consuming data");
+	do {
+		ssize_t subbuffer_written_bytes;
+
+		subbuffer = {};
+		get_next_status = stream->read_subbuffer_ops.get_next_subbuffer(stream, &subbuffer);
+		switch (get_next_status) {
+		case GET_NEXT_SUBBUFFER_STATUS_OK:
+			break;
+		case GET_NEXT_SUBBUFFER_STATUS_NO_DATA:
+			/* Not an error. */
+			ret = 0;
+			goto sleep_stream;
+		case GET_NEXT_SUBBUFFER_STATUS_ERROR:
+			ret = -1;
 			goto end;
+		default:
+			abort();
 		}
 
-	} else if (rotation_ret < 0) {
-		ret = rotation_ret;
-		ERR("Failed to check if stream was ready to rotate after consuming data");
-		goto end;
-	}
+		ret = stream->read_subbuffer_ops.pre_consume_subbuffer(stream, &subbuffer);
+		if (ret) {
+			goto error_put_subbuf;
+		}
 
-sleep_stream:
-	if (stream->read_subbuffer_ops.on_sleep) {
-		stream->read_subbuffer_ops.on_sleep(stream, ctx);
-	}
+		if (stream->read_subbuffer_ops.filter_subbuffer &&
+		    stream->read_subbuffer_ops.filter_subbuffer(stream, &subbuffer) ==
+			    FILTER_SUBBUFFER_VERDICT_DROP) {
+			/*
+			 * Release the packet without consuming it: the gap in
+			 * the sequence numbers of the packets and index entries
+			 * which follow shows it was lost.
+			 *
+			 * Dropped packets don't count towards the drain batch
+			 * since the filter keeps one in a bounded number of
+			 * packets.
+			 */
+			ret = stream->read_subbuffer_ops.put_next_subbuffer(stream, &subbuffer);
+			if (ret) {
+				goto end;
+			}
 
-	ret = written_bytes;
-end:
-	if (!locked_by_caller) {
-		stream->read_subbuffer_ops.unlock(stream);
-	}
+			stream->chan->lost_packets++;
+		} else {
+			self_tracepoint(consumerd_subbuffer_consume_begin,
+					stream->chan->key,
+					stream->key,
+					subbuffer.info.data.padded_subbuf_size);
+			subbuffer_written_bytes = stream->read_subbuffer_ops.consume_subbuffer(
+				ctx, stream, &subbuffer);
+			self_tracepoint(consumerd_subbuffer_consume_end,
+					stream->key,
+					subbuffer_written_bytes);
+			if (subbuffer_written_bytes <= 0) {
+				ERR("Error consuming subbuffer: (%zd)", subbuffer_written_bytes);
+				ret = (int) subbuffer_written_bytes;
+				goto error_put_subbuf;
+			}
 
-	return ret;
-error_put_subbuf:
-	(void) stream->read_subbuffer_ops.put_next_subbuffer(stream, &subbuffer);
-	goto end;
-}
+			ret = stream->read_subbuffer_ops.put_next_subbuffer(stream, &subbuffer);
+			if (ret) {
+				goto end;
+			}
+
+			ret = post_consume(stream, &subbuffer, ctx);
+			if (ret) {
+				goto end;
+			}
+
+			written_bytes += subbuffer_written_bytes;
+			subbuffer_count++;
+			if (!stream->metadata_flag) {
+				data_stream_record_subbuffer_size(stream, subbuffer_written_bytes);
+			}
+		}
+
+		/*
+		 * After extracting the packet, we check if the stream is now ready to
+		 * be rotated and perform the action immediately.
+		 *
+		 * Don't overwrite `ret` as callers expect the number of bytes
+		 * consumed to be returned on success.
+		 */
+		rotation_ret = lttng_consumer_stream_is_rotate_ready(stream);
+		if (rotation_ret == 1) {
+			/* The index entries belong to the current trace chunk. */
+			rotation_ret = consumer_stream_flush_index_batch(stream);
+			if (rotation_ret < 0) {
+				ret = rotation_ret;
+				goto end;
+			}
+
+			rotation_ret = lttng_consumer_rotate_stream(stream);
+			if (rotation_ret < 0) {
+				ret = rotation_ret;
+				ERR("Stream rotation error after consuming data");
+				goto end;
+			}
+
+			if (max_subbuffers > 1) {
+				consumer_stream_begin_index_batch(stream);
+			}
+		} else if (rotation_ret < 0) {
+			ret = rotation_ret;
+			ERR("Failed to check if stream was ready to rotate after consuming data");
+			goto end;
+		}
+	} while (subbuffer_count < max_subbuffers &&
+		 (max_bytes == 0 || (uint64_t) written_bytes < max_bytes));
+
+sleep_stream:
+	if (stream->read_subbuffer_ops.on_sleep) {
+		stream->read_subbuffer_ops.on_sleep(stream, ctx);
+	}
+
+	ret = written_bytes;
+	if (!stream->metadata_flag && written_bytes > 0) {
+		report_consumed_size(stream->chan, written_bytes);
+	}
+end:
+	if (consumer_stream_flush_index_batch(stream) && ret >= 0) {
+		ret = -1;
+	}
+
+	if (!locked_by_caller) {
+		stream->read_subbuffer_ops.unlock(stream);
+	}
+
+	return ret;
+error_put_subbuf:
+	(void) stream->read_subbuffer_ops.put_next_subbuffer(stream, &subbuffer);
+	goto end;
+}
 
 int lttng_consumer_on_recv_stream(struct lttng_consumer_stream *stream)
 {
@@ -3623,17 +4384,52 @@ void consumer_add_relayd_socket(uint64_t net_seq_idx,
 		relayd->control_sock.major = relayd_version_major;
 		relayd->control_sock.minor = relayd_version_minor;
 
+		if (ret == 0 &&
+		    relayd_enable_index_batching(&relayd->control_sock,
+						 relayd_index_batch_size,
+						 relayd_index_batch_latency_us)) {
+			ret_code = LTTCOMM_CONSUMERD_ENOMEM;
+			goto error;
+		}
+
 		relayd->relayd_session_id = relayd_session_id;
 
 		break;
 	case LTTNG_STREAM_DATA:
+	{
+		/*
+		 * Data sockets are only received on the session daemon command
+		 * thread; workers only read the count.
+		 */
+		const unsigned int data_sock_index = relayd->data_sock_count;
+		struct lttcomm_relayd_sock *data_sock;
+
+		if (data_sock_index >= CONSUMER_RELAYD_MAX_DATA_SOCKS) {
+			ERR("Too many data connections to relayd %" PRIu64 " (maximum: %d)",
+			    relayd->net_seq_idx,
+			    CONSUMER_RELAYD_MAX_DATA_SOCKS);
+			ret_code = LTTCOMM_CONSUMERD_FATAL;
+			goto error;
+		}
+
+		data_sock = &relayd->data_socks[data_sock_index].sock;
+
 		/* Copy received lttcomm socket */
 		ret = lttcomm_populate_sock_from_open_socket(
-			&relayd->data_sock.sock, fd, relayd_socket_protocol);
+			&data_sock->sock, fd, relayd_socket_protocol);
+		if (ret < 0) {
+			break;
+		}
+
 		/* Assign version values. */
-		relayd->data_sock.major = relayd_version_major;
-		relayd->data_sock.minor = relayd_version_minor;
+		data_sock->major = relayd_version_major;
+		data_sock->minor = relayd_version_minor;
+
+		/* Publish the data socket once it is initialized. */
+		cmm_smp_wmb();
+		uatomic_set(&relayd->data_sock_count, data_sock_index + 1);
 		break;
+	}
 	default:
 		ERR("Unknown relayd socket type (%d)", sock_type);
 		ret_code = LTTCOMM_CONSUMERD_FATAL;
@@ -3691,6 +4487,12 @@ error_nosignal:
 	}
 }
 
+void consumer_set_relayd_index_batching(unsigned int max_count, uint64_t max_latency_us)
+{
+	relayd_index_batch_size = max_count;
+	relayd_index_batch_latency_us = max_latency_us;
+}
+
 /*
  * Search for a relayd associated to the session id and return the reference.
  *
@@ -3789,17 +4591,11 @@ int consumer_data_pending(uint64_t id)
 
 	relayd = find_relayd_by_session_id(id);
 	if (relayd) {
-		unsigned int is_data_inflight = 0;
-
-		/* Send init command for data pending. */
-		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
-		ret = relayd_begin_data_pending(&relayd->control_sock, relayd->relayd_session_id);
-		if (ret < 0) {
-			pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
-			/* Communication error thus the relayd so no data pending. */
-			goto data_not_pending;
-		}
+		struct lttng_dynamic_array streams;
 
+		/* Check all the streams of the session in a single command. */
+		lttng_dynamic_array_init(
+			&streams, sizeof(struct relayd_stream_data_pending), nullptr);
 		cds_lfht_for_each_entry_duplicate(ht->ht,
 						  ht->hash_fct(&id, lttng_ht_seed),
 						  ht->match_fct,
@@ -3808,38 +4604,38 @@ int consumer_data_pending(uint64_t id)
 						  stream,
 						  node_session_id.node)
 		{
-			if (stream->metadata_flag) {
-				ret = relayd_quiescent_control(&relayd->control_sock,
-							       stream->relayd_stream_id);
-			} else {
-				ret = relayd_data_pending(&relayd->control_sock,
-							  stream->relayd_stream_id,
-							  stream->next_net_seq_num - 1);
-			}
+			const struct relayd_stream_data_pending stream_data_pending = {
+				.relay_stream_id = stream->relayd_stream_id,
+				.last_net_seq_num = stream->next_net_seq_num - 1,
+				.is_metadata = (bool) stream->metadata_flag,
+			};
 
-			if (ret == 1) {
-				pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+			ret = lttng_dynamic_array_add_element(&streams, &stream_data_pending);
+			if (ret) {
+				ERR("Failed to allocate the streams of the data pending check");
+				lttng_dynamic_array_reset(&streams);
+				/* Report pending data, the check is retried. */
 				goto data_pending;
-			} else if (ret < 0) {
-				ERR("Relayd data pending failed. Cleaning up relayd %" PRIu64 ".",
-				    relayd->net_seq_idx);
-				lttng_consumer_cleanup_relayd(relayd);
-				pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
-				goto data_not_pending;
 			}
 		}
 
-		/* Send end command for data pending. */
-		ret = relayd_end_data_pending(
-			&relayd->control_sock, relayd->relayd_session_id, &is_data_inflight);
-		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+		ret = relayd_session_data_pending(
+			&relayd->control_sock,
+			relayd->relayd_session_id,
+			lttng_dynamic_array_get_count(&streams),
+			(const struct relayd_stream_data_pending *) streams.buffer.data);
+		lttng_dynamic_array_reset(&streams);
 		if (ret < 0) {
-			ERR("Relayd end data pending failed. Cleaning up relayd %" PRIu64 ".",
+			ERR("Relayd data pending failed. Cleaning up relayd %" PRIu64 ".",
 			    relayd->net_seq_idx);
 			lttng_consumer_cleanup_relayd(relayd);
+			pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
 			goto data_not_pending;
 		}
-		if (is_data_inflight) {
+
+		pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+		if (ret == 1) {
 			goto data_pending;
 		}
 	}
@@ -3948,6 +4744,311 @@ end:
 	return ret;
 }
 
+namespace {
+/* Outcome of the sampling of the rotation position of a stream. */
+struct stream_rotation_sample {
+	int ret = 0;
+	/* The stream was already in the trace chunk of its channel. */
+	bool in_channel_trace_chunk = false;
+	/* A packet must be opened in the stream once the channel is rotated. */
+	bool open_packet = false;
+	struct relayd_stream_rotation_position relayd_position = {};
+};
+
+/* Work shared by the threads sampling the rotation positions of a channel. */
+struct rotation_sampling_job {
+	const std::vector<lttng_consumer_stream *> *streams;
+	/* Index of the next stream to sample. */
+	unsigned long next_stream;
+	std::vector<stream_rotation_sample> samples;
+};
+
+/*
+ * Flush the current packet of a stream and sample its rotation position. If
+ * the stream is already at the rotate position (produced == consumed), it is
+ * flagged as ready for rotation.
+ */
+void sample_stream_rotation_position(struct lttng_consumer_stream *stream,
+				     stream_rotation_sample& sample)
+{
+	int ret;
+	enum lttng_trace_chunk_status chunk_status;
+	unsigned long produced_pos = 0, consumed_pos = 0;
+
+	health_code_update();
+
+	/*
+	 * Lock stream because we are about to change its state.
+	 */
+	pthread_mutex_lock(&stream->lock);
+
+	sample.in_channel_trace_chunk = stream->trace_chunk == stream->chan->trace_chunk;
+
+	/*
+	 * Do not flush a packet when rotating from a NULL trace
+	 * chunk. The stream has no means to output data, and the prior
+	 * rotation which rotated to NULL performed that side-effect
+	 * already. No new data can be produced when a stream has no
+	 * associated trace chunk (e.g. a stop followed by a rotate).
+	 */
+	if (stream->trace_chunk) {
+		bool flush_active;
+
+		if (stream->metadata_flag) {
+			/*
+			 * Don't produce an empty metadata packet,
+			 * simply close the current one.
+			 *
+			 * Metadata is regenerated on every trace chunk
+			 * switch; there is no concern that no data was
+			 * produced.
+			 */
+			flush_active = true;
+		} else {
+			/*
+			 * Only flush an empty packet if the "packet
+			 * open" could not be performed on transition
+			 * to a new trace chunk and no packets were
+			 * consumed within the chunk's lifetime.
+			 */
+			if (stream->opened_packet_in_current_trace_chunk) {
+				flush_active = true;
+			} else {
+				/*
+				 * Stream could have been full at the
+				 * time of rotation, but then have had
+				 * no activity at all.
+				 *
+				 * It is important to flush a packet
+				 * to prevent 0-length files from being
+				 * produced as most viewers choke on
+				 * them.
+				 *
+				 * Unfortunately viewers will not be
+				 * able to know that tracing was active
+				 * for this stream during this trace
+				 * chunk's lifetime.
+				 */
+				ret = sample_stream_positions(
+					stream, &produced_pos, &consumed_pos);
+				if (ret) {
+					goto end;
+				}
+
+				/*
+				 * Don't flush an empty packet if data
+				 * was produced; it will be consumed
+				 * before the rotation completes.
+				 */
+				flush_active = produced_pos != consumed_pos;
+				if (!flush_active) {
+					const char *trace_chunk_name;
+					uint64_t trace_chunk_id;
+
+					chunk_status = lttng_trace_chunk_get_name(
+						stream->trace_chunk,
+						&trace_chunk_name,
+						nullptr);
+					if (chunk_status == LTTNG_TRACE_CHUNK_STATUS_NONE) {
+						trace_chunk_name = "none";
+					}
+
+					/*
+					 * Consumer trace chunks are
+					 * never anonymous.
+					 */
+					chunk_status = lttng_trace_chunk_get_id(
+						stream->trace_chunk, &trace_chunk_id);
+					LTTNG_ASSERT(chunk_status ==
+						     LTTNG_TRACE_CHUNK_STATUS_OK);
+
+					DBG("Unable to open packet for stream during trace chunk's lifetime. "
+					    "Flushing an empty packet to prevent an empty file from being created: "
+					    "stream id = %" PRIu64
+					    ", trace chunk name = `%s`, trace chunk id = %" PRIu64,
+					    stream->key,
+					    trace_chunk_name,
+					    trace_chunk_id);
+				}
+			}
+		}
+
+		/*
+		 * Close the current packet before sampling the
+		 * ring buffer positions.
+		 */
+		ret = consumer_stream_flush_buffer(stream, flush_active);
+		if (ret < 0) {
+			ERR("Failed to flush stream %" PRIu64 " during channel rotation",
+			    stream->key);
+			goto end;
+		}
+	}
+
+	ret = lttng_consumer_take_snapshot(stream);
+	if (ret < 0 && ret != -ENODATA && ret != -EAGAIN) {
+		ERR("Failed to sample snapshot position during channel rotation");
+		goto end;
+	}
+	if (!ret) {
+		ret = lttng_consumer_get_produced_snapshot(stream, &produced_pos);
+		if (ret < 0) {
+			ERR("Failed to sample produced position during channel rotation");
+			goto end;
+		}
+
+		ret = lttng_consumer_get_consumed_snapshot(stream, &consumed_pos);
+		if (ret < 0) {
+			ERR("Failed to sample consumed position during channel rotation");
+			goto end;
+		}
+	}
+	/*
+	 * Align produced position on the start-of-packet boundary of the first
+	 * packet going into the next trace chunk.
+	 */
+	produced_pos = lttng_align_floor(produced_pos, stream->max_sb_size);
+	if (consumed_pos == produced_pos) {
+		DBG("Set rotate ready for stream %" PRIu64 " produced = %lu consumed = %lu",
+		    stream->key,
+		    produced_pos,
+		    consumed_pos);
+		stream->rotate_ready = true;
+	} else {
+		DBG("Different consumed and produced positions "
+		    "for stream %" PRIu64 " produced = %lu consumed = %lu",
+		    stream->key,
+		    produced_pos,
+		    consumed_pos);
+	}
+	/*
+	 * The rotation position is based on the packet_seq_num of the
+	 * packet following the last packet that was consumed for this
+	 * stream, incremented by the offset between produced and
+	 * consumed positions. This rotation position is a lower bound
+	 * (inclusive) at which the next trace chunk starts. Since it
+	 * is a lower bound, it is OK if the packet_seq_num does not
+	 * correspond exactly to the same packet identified by the
+	 * consumed_pos, which can happen in overwrite mode.
+	 */
+	if (stream->sequence_number_unavailable) {
+		/*
+		 * Rotation should never be performed on a session which
+		 * interacts with a pre-2.8 lttng-modules, which does
+		 * not implement packet sequence number.
+		 */
+		ERR("Failure to rotate stream %" PRIu64 ": sequence number unavailable",
+		    stream->key);
+		ret = -1;
+		goto end;
+	}
+	stream->rotate_position = stream->last_sequence_number + 1 +
+		((produced_pos - consumed_pos) / stream->max_sb_size);
+	DBG("Set rotation position for stream %" PRIu64 " at position %" PRIu64,
+	    stream->key,
+	    stream->rotate_position);
+
+	/*
+	 * The relay daemon control protocol expects a rotation position as
+	 * "the sequence number of the first packet _after_ the current trace
+	 * chunk".
+	 */
+	sample.relayd_position.stream_id = stream->relayd_stream_id;
+	sample.relayd_position.rotate_at_seq_num = stream->rotate_position;
+
+	stream->opened_packet_in_current_trace_chunk = false;
+
+	/*
+	 * Attempt to open a packet in the new trace chunk once the positions
+	 * of all the streams of the channel are sampled.
+	 */
+	sample.open_packet = !stream->metadata_flag;
+	ret = 0;
+
+end:
+	pthread_mutex_unlock(&stream->lock);
+	sample.ret = ret;
+}
+
+void run_rotation_sampling_job(rotation_sampling_job& job)
+{
+	for (;;) {
+		const unsigned long index = uatomic_add_return(&job.next_stream, 1) - 1;
+
+		if (index >= job.streams->size()) {
+			break;
+		}
+
+		sample_stream_rotation_position((*job.streams)[index], job.samples[index]);
+	}
+}
+
+void *rotation_sampling_worker(void *data)
+{
+	auto *job = static_cast<rotation_sampling_job *>(data);
+
+	rcu_register_thread();
+	run_rotation_sampling_job(*job);
+	rcu_unregister_thread();
+	return nullptr;
+}
+
+/*
+ * Sample the rotation positions of a set of streams. The streams are spread
+ * over a pool of threads when they are numerous enough for the flushes and
+ * samplings to outweigh the launch of the threads.
+ */
+void sample_streams_rotation_positions(rotation_sampling_job& job)
+{
+	std::vector<pthread_t> workers;
+	unsigned long worker_count = 0;
+
+	if (job.streams->size() >= DEFAULT_CONSUMERD_ROTATE_PARALLEL_STREAM_COUNT) {
+		worker_count = std::min<unsigned long>(DEFAULT_CONSUMERD_ROTATE_THREAD_COUNT,
+						       job.streams->size()) -
+			1;
+	}
+
+	try {
+		workers.reserve(worker_count);
+	} catch (const std::bad_alloc&) {
+		/* Sample all the streams from the calling thread. */
+		worker_count = 0;
+	}
+
+	for (unsigned long i = 0; i < worker_count; i++) {
+		pthread_t worker;
+		const int create_ret = pthread_create(
+			&worker, default_pthread_attr(), rotation_sampling_worker, &job);
+
+		if (create_ret) {
+			/* Carry on with the threads launched so far. */
+			errno = create_ret;
+			PERROR("Failed to launch rotation position sampling thread");
+			break;
+		}
+
+		workers.push_back(worker);
+	}
+
+	/* The calling thread samples streams too. */
+	run_rotation_sampling_job(job);
+
+	for (const auto worker : workers) {
+		const int join_ret = pthread_join(worker, nullptr);
+
+		if (join_ret) {
+			errno = join_ret;
+			PERROR("Failed to join rotation position sampling thread");
+		}
+	}
+
+	DBG("Rotation positions of %zu streams sampled by %zu threads",
+	    job.streams->size(),
+	    workers.size() + 1);
+}
+} /* namespace */
+
 /*
  * Sample the rotate position for all the streams of a channel. If a stream
  * is already at the rotate position (produced == consumed), we flag it as
@@ -3955,6 +5056,9 @@ end:
  * replied to the session daemon that we have finished sampling the positions.
  * Must be called with RCU read-side lock held to ensure existence of channel.
  *
+ * The positions of the streams of wide channels are sampled concurrently and
+ * sent to the relay daemon with a single command.
+ *
  * Returns 0 on success, < 0 on error
  */
 int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
@@ -3974,6 +5078,8 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 	/* Array of `struct lttng_consumer_stream *` */
 	struct lttng_dynamic_pointer_array streams_packet_to_open;
 	size_t stream_idx;
+	std::vector<lttng_consumer_stream *> streams;
+	rotation_sampling_job job;
 
 	ASSERT_RCU_READ_LOCKED();
 
@@ -3994,275 +5100,112 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 		goto end_unlock_channel;
 	}
 
-	cds_lfht_for_each_entry_duplicate(ht->ht,
-					  ht->hash_fct(&channel->key, lttng_ht_seed),
-					  ht->match_fct,
-					  &channel->key,
-					  &iter.iter,
-					  stream,
-					  node_channel_id.node)
-	{
-		unsigned long produced_pos = 0, consumed_pos = 0;
-
-		health_code_update();
-
-		/*
-		 * Lock stream because we are about to change its state.
-		 */
-		pthread_mutex_lock(&stream->lock);
-
-		if (stream->trace_chunk == stream->chan->trace_chunk) {
-			rotating_to_new_chunk = false;
+	try {
+		cds_lfht_for_each_entry_duplicate(ht->ht,
+						  ht->hash_fct(&channel->key, lttng_ht_seed),
+						  ht->match_fct,
+						  &channel->key,
+						  &iter.iter,
+						  stream,
+						  node_channel_id.node)
+		{
+			streams.push_back(stream);
 		}
 
-		/*
-		 * Do not flush a packet when rotating from a NULL trace
-		 * chunk. The stream has no means to output data, and the prior
-		 * rotation which rotated to NULL performed that side-effect
-		 * already. No new data can be produced when a stream has no
-		 * associated trace chunk (e.g. a stop followed by a rotate).
-		 */
-		if (stream->trace_chunk) {
-			bool flush_active;
-
-			if (stream->metadata_flag) {
-				/*
-				 * Don't produce an empty metadata packet,
-				 * simply close the current one.
-				 *
-				 * Metadata is regenerated on every trace chunk
-				 * switch; there is no concern that no data was
-				 * produced.
-				 */
-				flush_active = true;
-			} else {
-				/*
-				 * Only flush an empty packet if the "packet
-				 * open" could not be performed on transition
-				 * to a new trace chunk and no packets were
-				 * consumed within the chunk's lifetime.
-				 */
-				if (stream->opened_packet_in_current_trace_chunk) {
-					flush_active = true;
-				} else {
-					/*
-					 * Stream could have been full at the
-					 * time of rotation, but then have had
-					 * no activity at all.
-					 *
-					 * It is important to flush a packet
-					 * to prevent 0-length files from being
-					 * produced as most viewers choke on
-					 * them.
-					 *
-					 * Unfortunately viewers will not be
-					 * able to know that tracing was active
-					 * for this stream during this trace
-					 * chunk's lifetime.
-					 */
-					ret = sample_stream_positions(
-						stream, &produced_pos, &consumed_pos);
-					if (ret) {
-						goto end_unlock_stream;
-					}
-
-					/*
-					 * Don't flush an empty packet if data
-					 * was produced; it will be consumed
-					 * before the rotation completes.
-					 */
-					flush_active = produced_pos != consumed_pos;
-					if (!flush_active) {
-						const char *trace_chunk_name;
-						uint64_t trace_chunk_id;
-
-						chunk_status = lttng_trace_chunk_get_name(
-							stream->trace_chunk,
-							&trace_chunk_name,
-							nullptr);
-						if (chunk_status == LTTNG_TRACE_CHUNK_STATUS_NONE) {
-							trace_chunk_name = "none";
-						}
+		job.samples.resize(streams.size());
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate rotation of the streams of channel %" PRIu64, key);
+		ret = -1;
+		goto end_unlock_channel;
+	}
 
-						/*
-						 * Consumer trace chunks are
-						 * never anonymous.
-						 */
-						chunk_status = lttng_trace_chunk_get_id(
-							stream->trace_chunk, &trace_chunk_id);
-						LTTNG_ASSERT(chunk_status ==
-							     LTTNG_TRACE_CHUNK_STATUS_OK);
-
-						DBG("Unable to open packet for stream during trace chunk's lifetime. "
-						    "Flushing an empty packet to prevent an empty file from being created: "
-						    "stream id = %" PRIu64
-						    ", trace chunk name = `%s`, trace chunk id = %" PRIu64,
-						    stream->key,
-						    trace_chunk_name,
-						    trace_chunk_id);
-					}
-				}
-			}
+	job.streams = &streams;
+	job.next_stream = 0;
+	sample_streams_rotation_positions(job);
 
-			/*
-			 * Close the current packet before sampling the
-			 * ring buffer positions.
-			 */
-			ret = consumer_stream_flush_buffer(stream, flush_active);
-			if (ret < 0) {
-				ERR("Failed to flush stream %" PRIu64 " during channel rotation",
-				    stream->key);
-				goto end_unlock_stream;
-			}
+	for (const auto& sample : job.samples) {
+		if (sample.ret) {
+			ret = sample.ret;
+			goto end_unlock_channel;
 		}
 
-		ret = lttng_consumer_take_snapshot(stream);
-		if (ret < 0 && ret != -ENODATA && ret != -EAGAIN) {
-			ERR("Failed to sample snapshot position during channel rotation");
-			goto end_unlock_stream;
+		if (sample.in_channel_trace_chunk) {
+			rotating_to_new_chunk = false;
 		}
-		if (!ret) {
-			ret = lttng_consumer_get_produced_snapshot(stream, &produced_pos);
-			if (ret < 0) {
-				ERR("Failed to sample produced position during channel rotation");
-				goto end_unlock_stream;
-			}
+	}
 
-			ret = lttng_consumer_get_consumed_snapshot(stream, &consumed_pos);
-			if (ret < 0) {
-				ERR("Failed to sample consumed position during channel rotation");
-				goto end_unlock_stream;
-			}
-		}
-		/*
-		 * Align produced position on the start-of-packet boundary of the first
-		 * packet going into the next trace chunk.
-		 */
-		produced_pos = lttng_align_floor(produced_pos, stream->max_sb_size);
-		if (consumed_pos == produced_pos) {
-			DBG("Set rotate ready for stream %" PRIu64 " produced = %lu consumed = %lu",
-			    stream->key,
-			    produced_pos,
-			    consumed_pos);
-			stream->rotate_ready = true;
-		} else {
-			DBG("Different consumed and produced positions "
-			    "for stream %" PRIu64 " produced = %lu consumed = %lu",
-			    stream->key,
-			    produced_pos,
-			    consumed_pos);
-		}
-		/*
-		 * The rotation position is based on the packet_seq_num of the
-		 * packet following the last packet that was consumed for this
-		 * stream, incremented by the offset between produced and
-		 * consumed positions. This rotation position is a lower bound
-		 * (inclusive) at which the next trace chunk starts. Since it
-		 * is a lower bound, it is OK if the packet_seq_num does not
-		 * correspond exactly to the same packet identified by the
-		 * consumed_pos, which can happen in overwrite mode.
-		 */
-		if (stream->sequence_number_unavailable) {
-			/*
-			 * Rotation should never be performed on a session which
-			 * interacts with a pre-2.8 lttng-modules, which does
-			 * not implement packet sequence number.
-			 */
-			ERR("Failure to rotate stream %" PRIu64 ": sequence number unavailable",
-			    stream->key);
-			ret = -1;
-			goto end_unlock_stream;
-		}
-		stream->rotate_position = stream->last_sequence_number + 1 +
-			((produced_pos - consumed_pos) / stream->max_sb_size);
-		DBG("Set rotation position for stream %" PRIu64 " at position %" PRIu64,
-		    stream->key,
-		    stream->rotate_position);
+	for (stream_idx = 0; stream_idx < streams.size(); stream_idx++) {
+		const stream_rotation_sample& sample = job.samples[stream_idx];
 
 		if (!is_local_trace) {
-			/*
-			 * The relay daemon control protocol expects a rotation
-			 * position as "the sequence number of the first packet
-			 * _after_ the current trace chunk".
-			 */
-			const struct relayd_stream_rotation_position position = {
-				.stream_id = stream->relayd_stream_id,
-				.rotate_at_seq_num = stream->rotate_position,
-			};
-
 			ret = lttng_dynamic_array_add_element(&stream_rotation_positions,
-							      &position);
+							      &sample.relayd_position);
 			if (ret) {
 				ERR("Failed to allocate stream rotation position");
-				goto end_unlock_stream;
+				goto end_unlock_channel;
 			}
 			stream_count++;
 		}
 
-		stream->opened_packet_in_current_trace_chunk = false;
-
-		if (rotating_to_new_chunk && !stream->metadata_flag) {
-			/*
-			 * Attempt to flush an empty packet as close to the
-			 * rotation point as possible. In the event where a
-			 * stream remains inactive after the rotation point,
-			 * this ensures that the new trace chunk has a
-			 * beginning timestamp set at the begining of the
-			 * trace chunk instead of only creating an empty
-			 * packet when the trace chunk is stopped.
-			 *
-			 * This indicates to the viewers that the stream
-			 * was being recorded, but more importantly it
-			 * allows viewers to determine a useable trace
-			 * intersection.
-			 *
-			 * This presents a problem in the case where the
-			 * ring-buffer is completely full.
-			 *
-			 * Consider the following scenario:
-			 *   - The consumption of data is slow (slow network,
-			 *     for instance),
-			 *   - The ring buffer is full,
-			 *   - A rotation is initiated,
-			 *     - The flush below does nothing (no space left to
-			 *       open a new packet),
-			 *   - The other streams rotate very soon, and new
-			 *     data is produced in the new chunk,
-			 *   - This stream completes its rotation long after the
-			 *     rotation was initiated
-			 *   - The session is stopped before any event can be
-			 *     produced	in this stream's buffers.
-			 *
-			 * The resulting trace chunk will have a single packet
-			 * temporaly at the end of the trace chunk for this
-			 * stream making the stream intersection more narrow
-			 * than it should be.
-			 *
-			 * To work-around this, an empty flush is performed
-			 * after the first consumption of a packet during a
-			 * rotation if open_packet fails. The idea is that
-			 * consuming a packet frees enough space to switch
-			 * packets in this scenario and allows the tracer to
-			 * "stamp" the beginning of the new trace chunk at the
-			 * earliest possible point.
-			 *
-			 * The packet open is performed after the channel
-			 * rotation to ensure that no attempt to open a packet
-			 * is performed in a stream that has no active trace
-			 * chunk.
-			 */
+		if (rotating_to_new_chunk && sample.open_packet) {
+		/*
+		 * Attempt to flush an empty packet as close to the
+		 * rotation point as possible. In the event where a
+		 * stream remains inactive after the rotation point,
+		 * this ensures that the new trace chunk has a
+		 * beginning timestamp set at the begining of the
+		 * trace chunk instead of only creating an empty
+		 * packet when the trace chunk is stopped.
+		 *
+		 * This indicates to the viewers that the stream
+		 * was being recorded, but more importantly it
+		 * allows viewers to determine a useable trace
+		 * intersection.
+		 *
+		 * This presents a problem in the case where the
+		 * ring-buffer is completely full.
+		 *
+		 * Consider the following scenario:
+		 *   - The consumption of data is slow (slow network,
+		 *     for instance),
+		 *   - The ring buffer is full,
+		 *   - A rotation is initiated,
+		 *     - The flush below does nothing (no space left to
+		 *       open a new packet),
+		 *   - The other streams rotate very soon, and new
+		 *     data is produced in the new chunk,
+		 *   - This stream completes its rotation long after the
+		 *     rotation was initiated
+		 *   - The session is stopped before any event can be
+		 *     produced	in this stream's buffers.
+		 *
+		 * The resulting trace chunk will have a single packet
+		 * temporaly at the end of the trace chunk for this
+		 * stream making the stream intersection more narrow
+		 * than it should be.
+		 *
+		 * To work-around this, an empty flush is performed
+		 * after the first consumption of a packet during a
+		 * rotation if open_packet fails. The idea is that
+		 * consuming a packet frees enough space to switch
+		 * packets in this scenario and allows the tracer to
+		 * "stamp" the beginning of the new trace chunk at the
+		 * earliest possible point.
+		 *
+		 * The packet open is performed after the channel
+		 * rotation to ensure that no attempt to open a packet
+		 * is performed in a stream that has no active trace
+		 * chunk.
+		 */
 			ret = lttng_dynamic_pointer_array_add_pointer(&streams_packet_to_open,
-								      stream);
+								      streams[stream_idx]);
 			if (ret) {
 				PERROR("Failed to add a stream pointer to array of streams in which to open a packet");
 				ret = -1;
-				goto end_unlock_stream;
+				goto end_unlock_channel;
 			}
 		}
-
-		pthread_mutex_unlock(&stream->lock);
 	}
-	stream = nullptr;
 
 	if (!is_local_trace) {
 		relayd = consumer_find_relayd(relayd_id);
@@ -4331,8 +5274,6 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 	ret = 0;
 	goto end;
 
-end_unlock_stream:
-	pthread_mutex_unlock(&stream->lock);
 end_unlock_channel:
 	pthread_mutex_unlock(&channel->lock);
 end:
@@ -4520,6 +5461,9 @@ static int rotate_local_stream(struct lttng_consumer_stream *stream)
 	stream->tracefile_count_current = 0;
 
 	if (stream->out_fd >= 0) {
+		consumer_stream_release_writeback_window(stream);
+		consumer_stream_trim_output_file(stream);
+
 		ret = close(stream->out_fd);
 		if (ret) {
 			PERROR("Failed to close stream out_fd of channel \"%s\"",
@@ -4558,6 +5502,7 @@ int lttng_consumer_rotate_stream(struct lttng_consumer_stream *stream)
 	 * Update the stream's 'current' chunk to the session's (channel)
 	 * now-current chunk.
 	 */
+	consumer_stream_write_manifest_entry(stream);
 	lttng_trace_chunk_put(stream->trace_chunk);
 	if (stream->chan->trace_chunk == stream->trace_chunk) {
 		/*
@@ -4885,6 +5830,72 @@ error:
 	return ret_code;
 }
 
+enum lttcomm_return_code lttng_consumer_set_rotation_event_pipe(int fd)
+{
+	const int flags = fcntl(fd, F_GETFL, 0);
+
+	/* Releasing a trace chunk must not block on a full pipe. */
+	if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+		PERROR("Failed to set the rotation event pipe as non-blocking");
+		(void) close(fd);
+		return LTTCOMM_CONSUMERD_FATAL;
+	}
+
+	if (uatomic_cmpxchg(&rotation_event_pipe, -1, fd) != -1) {
+		(void) close(fd);
+		return LTTCOMM_CONSUMERD_ALREADY_SET;
+	}
+
+	return LTTCOMM_CONSUMERD_SUCCESS;
+}
+
+static void announce_trace_chunk_release(bool close_command_succeeded __attribute__((unused)),
+					 void *data)
+{
+	auto *msg = static_cast<lttcomm_consumer_rotation_event_msg *>(data);
+	const int pipe = uatomic_read(&rotation_event_pipe);
+
+	/* Not fatal: the session daemon also checks its pending rotations periodically. */
+	if (lttng_write(pipe, msg, sizeof(*msg)) != sizeof(*msg)) {
+		PERROR("Failed to announce the release of a trace chunk to the session daemon: session_id = %" PRIu64
+		       ", chunk_id = %" PRIu64,
+		       msg->session_id,
+		       msg->value);
+	}
+
+	free(msg);
+}
+
+/*
+ * Announce the release of the last reference to a closed trace chunk to the
+ * session daemon, which completes the rotations without waiting for its next
+ * check of the chunks that still exist in the consumers.
+ */
+static void announce_trace_chunk_release_on_put(struct lttng_trace_chunk *chunk,
+						uint64_t session_id,
+						uint64_t chunk_id)
+{
+	struct lttcomm_consumer_rotation_event_msg *msg;
+
+	if (uatomic_read(&rotation_event_pipe) < 0) {
+		return;
+	}
+
+	msg = zmalloc<lttcomm_consumer_rotation_event_msg>();
+	if (!msg) {
+		PERROR("Failed to allocate trace chunk release message");
+		return;
+	}
+
+	msg->type = LTTCOMM_CONSUMER_ROTATION_EVENT_TRACE_CHUNK_RELEASED;
+	msg->session_id = session_id;
+	msg->value = chunk_id;
+	if (lttng_trace_chunk_set_release_callback(chunk, announce_trace_chunk_release, msg) !=
+	    LTTNG_TRACE_CHUNK_STATUS_OK) {
+		free(msg);
+	}
+}
+
 enum lttcomm_return_code
 lttng_consumer_close_trace_chunk(const uint64_t *relayd_id,
 				 uint64_t session_id,
@@ -4948,6 +5959,8 @@ lttng_consumer_close_trace_chunk(const uint64_t *relayd_id,
 		}
 	}
 
+	announce_trace_chunk_release_on_put(chunk, session_id, chunk_id);
+
 	/*
 	 * chunk is now invalid to access as we no longer hold a reference to
 	 * it; it is only kept around to compare it (by address) to the
@@ -5077,7 +6090,8 @@ end:
 	return ret_code;
 }
 
-static int consumer_clear_monitored_channel(struct lttng_consumer_channel *channel)
+static int consumer_clear_monitored_channel(struct lttng_consumer_channel *channel,
+					    bool truncate_output)
 {
 	struct lttng_ht *ht;
 	struct lttng_consumer_stream *stream;
@@ -5087,6 +6101,11 @@ static int consumer_clear_monitored_channel(struct lttng_consumer_channel *chann
 	ht = the_consumer_data.stream_per_chan_id_ht;
 
 	lttng::urcu::read_lock_guard read_lock;
+	if (truncate_output) {
+		/* Protects the path of the channel while its files are truncated. */
+		pthread_mutex_lock(&channel->lock);
+	}
+
 	cds_lfht_for_each_entry_duplicate(ht->ht,
 					  ht->hash_fct(&channel->key, lttng_ht_seed),
 					  ht->match_fct,
@@ -5106,21 +6125,37 @@ static int consumer_clear_monitored_channel(struct lttng_consumer_channel *chann
 		if (ret) {
 			goto error_unlock;
 		}
+
+		if (truncate_output && consumer_stream_truncate_output_files(stream)) {
+			ERR("Failed to truncate the output files of stream %" PRIu64
+			    " during channel clear",
+			    stream->key);
+			ret = LTTCOMM_CONSUMERD_FATAL;
+			goto error_unlock;
+		}
 	next:
 		pthread_mutex_unlock(&stream->lock);
 	}
-	return LTTCOMM_CONSUMERD_SUCCESS;
+	ret = LTTCOMM_CONSUMERD_SUCCESS;
+	goto end;
 
 error_unlock:
 	pthread_mutex_unlock(&stream->lock);
+end:
+	if (truncate_output) {
+		pthread_mutex_unlock(&channel->lock);
+	}
+
 	return ret;
 }
 
-int lttng_consumer_clear_channel(struct lttng_consumer_channel *channel)
+int lttng_consumer_clear_channel(struct lttng_consumer_channel *channel, bool truncate_output)
 {
 	int ret;
 
-	DBG("Consumer clear channel %" PRIu64, channel->key);
+	DBG("Consumer clear channel %" PRIu64 ", truncate output = %s",
+	    channel->key,
+	    truncate_output ? "true" : "false");
 
 	if (channel->type == CONSUMER_CHANNEL_TYPE_METADATA) {
 		/*
@@ -5136,7 +6171,7 @@ int lttng_consumer_clear_channel(struct lttng_consumer_channel *channel)
 	if (!channel->monitor) {
 		ret = consumer_clear_unmonitored_channel(channel);
 	} else {
-		ret = consumer_clear_monitored_channel(channel);
+		ret = consumer_clear_monitored_channel(channel, truncate_output);
 	}
 end:
 	return ret;
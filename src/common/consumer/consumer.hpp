@@ -12,12 +12,17 @@
 #define LIB_CONSUMER_H
 
 #include <common/buffer-view.hpp>
+#include <common/consumer/consumer-relayd-spill.hpp>
 #include <common/credentials.hpp>
+#include <common/defaults.hpp>
 #include <common/dynamic-array.hpp>
+#include <common/dynamic-buffer.hpp>
 #include <common/hashtable/hashtable.hpp>
 #include <common/index/ctf-index.hpp>
+#include <common/numa.hpp>
 #include <common/pipe.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/timer-wheel.hpp>
 #include <common/trace-chunk-registry.hpp>
 #include <common/uuid.hpp>
 #include <common/waiter.hpp>
@@ -67,6 +72,10 @@ enum lttng_consumer_command {
 	LTTNG_CONSUMER_TRACE_CHUNK_EXISTS,
 	LTTNG_CONSUMER_CLEAR_CHANNEL,
 	LTTNG_CONSUMER_OPEN_CHANNEL_PACKETS,
+	LTTNG_CONSUMER_CHANNEL_CONSUMPTION_STATS,
+	LTTNG_CONSUMER_SET_ROTATION_EVENT_PIPE,
+	/* Add streams of a channel, sent with their fds as a batch. */
+	LTTNG_CONSUMER_ADD_STREAMS,
 };
 
 enum lttng_consumer_type {
@@ -97,6 +106,12 @@ enum sync_metadata_status {
 	SYNC_METADATA_STATUS_ERROR,
 };
 
+enum consumer_channel_timer_type {
+	CONSUMER_CHANNEL_TIMER_TYPE_SWITCH,
+	CONSUMER_CHANNEL_TIMER_TYPE_LIVE,
+	CONSUMER_CHANNEL_TIMER_TYPE_MONITOR,
+};
+
 extern struct lttng_consumer_global_data the_consumer_data;
 
 struct stream_list {
@@ -106,6 +121,18 @@ struct stream_list {
 
 /* Stub. */
 struct consumer_metadata_cache;
+struct consumer_snapshot_fd_output;
+
+/*
+ * Periodic timer of a channel, expired by the consumer timer thread. Protected
+ * by the timer thread's lock.
+ */
+struct consumer_channel_timer {
+	lttng::timer_wheel::entry entry;
+	enum consumer_channel_timer_type type = CONSUMER_CHANNEL_TIMER_TYPE_SWITCH;
+	uint64_t period_ticks = 0;
+	struct lttng_consumer_channel *channel = nullptr;
+};
 
 struct lttng_consumer_channel {
 	/* Is the channel published in the channel hash tables? */
@@ -192,23 +219,44 @@ struct lttng_consumer_channel {
 
 	/* For UST metadata periodical flush */
 	int switch_timer_enabled = 0;
-	timer_t switch_timer = {};
+	struct consumer_channel_timer switch_timer;
 	int switch_timer_error = 0;
 
 	/* For the live mode */
 	int live_timer_enabled = 0;
-	timer_t live_timer = {};
+	struct consumer_channel_timer live_timer;
 	int live_timer_error = 0;
 	/* Channel is part of a live session ? */
 	bool is_live = false;
 
 	/* For channel monitoring timer. */
 	int monitor_timer_enabled = 0;
-	timer_t monitor_timer = {};
+	struct consumer_channel_timer monitor_timer;
 
 	/* On-disk circular buffer */
 	uint64_t tracefile_size = 0;
 	uint64_t tracefile_count = 0;
+
+	/*
+	 * Bounds of the sub-buffers consumed from a stream each time it is found
+	 * ready. A maximum byte count of 0 means no byte limit.
+	 */
+	uint32_t drain_max_subbuffers = 1;
+	uint64_t drain_max_bytes = 0;
+
+	/* Page size on which the ring buffers are allocated (UST only). */
+	enum lttng_channel_buffer_page_size buffer_page_size = LTTNG_CHANNEL_BUFFER_PAGE_SIZE_BASE;
+
+	/* Page cache writeback policy of the local trace files. */
+	enum lttng_channel_writeback_policy writeback_policy = LTTNG_CHANNEL_WRITEBACK_POLICY_SYNC;
+	/* Bytes, for LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW. */
+	uint64_t writeback_window_size = 0;
+	/*
+	 * Sum of the bytes written to the trace files of the channel's streams
+	 * which were not waited for yet. Updated atomically since the streams of
+	 * a channel can be consumed by different threads.
+	 */
+	uint64_t writeback_bytes_in_flight = 0;
 	/*
 	 * Monitor or not the streams of this channel meaning this indicates if the
 	 * streams should be sent to the data/metadata thread or added to the no
@@ -256,9 +304,26 @@ struct lttng_consumer_channel {
 	uint64_t discarded_events = 0;
 	/* Total number of missed packets due to overwriting (overwrite). */
 	uint64_t lost_packets = 0;
+	/*
+	 * Consumption statistics of the channel's data streams that were
+	 * destroyed. Protected by the consumer data lock and the channel lock.
+	 */
+	struct lttcomm_consumer_channel_consumption_stats retired_streams_consumption_stats = {};
 
 	bool streams_sent_to_relayd = false;
 	uint64_t last_consumed_size_sample_sent = false;
+	/* Buffer usage of the last monitor sample sent, if any. */
+	bool monitor_sample_sent = false;
+	uint64_t last_highest_sample_sent = 0;
+	uint64_t last_lowest_sample_sent = 0;
+	/* Discarded events and lost packets of the last monitor sample sent. */
+	uint64_t last_discarded_events_sample_sent = 0;
+	uint64_t last_lost_packets_sample_sent = 0;
+	/*
+	 * Bytes written by the data streams of the channel which were not
+	 * reported to the session daemon yet. Updated atomically.
+	 */
+	uint64_t unreported_consumed_size = 0;
 };
 
 struct stream_subbuffer {
@@ -312,6 +377,11 @@ enum get_next_subbuffer_status {
 	GET_NEXT_SUBBUFFER_STATUS_ERROR,
 };
 
+enum filter_subbuffer_verdict {
+	FILTER_SUBBUFFER_VERDICT_KEEP,
+	FILTER_SUBBUFFER_VERDICT_DROP,
+};
+
 /*
  * Perform any operation required to acknowledge
  * the wake-up of a consumer stream (e.g. consume a byte on a wake-up pipe).
@@ -353,6 +423,15 @@ using extract_subbuffer_info_cb = int (*)(struct lttng_consumer_stream *,
 using pre_consume_subbuffer_cb = int (*)(struct lttng_consumer_stream *,
 					 const struct stream_subbuffer *);
 
+/*
+ * Decide whether a subbuffer is consumed or released without being
+ * consumed. Optional: every subbuffer is consumed when unset.
+ *
+ * Stream and channel locks are acquired during this call.
+ */
+using filter_subbuffer_cb = enum filter_subbuffer_verdict (*)(struct lttng_consumer_stream *,
+							       const struct stream_subbuffer *);
+
 /*
  * Consume subbuffer contents.
  *
@@ -450,8 +529,42 @@ struct lttng_consumer_stream {
 	int out_fd; /* output file to write the data */
 	/* Write position in the output file descriptor */
 	off_t out_fd_offset;
+	/*
+	 * End of the blocks reserved ahead of the writes to the local output
+	 * file, see consumer_stream_preallocate_output_file().
+	 */
+	uint64_t out_fd_preallocated_size;
+	bool out_fd_preallocation_failed;
+	/*
+	 * Output receiving the packets of the stream, in place of `out_fd`, while
+	 * a snapshot is recorded to a file descriptor; NULL otherwise.
+	 */
+	struct consumer_snapshot_fd_output *snapshot_fd_output;
+	/*
+	 * Produced position of the stream when its last snapshot was recorded,
+	 * from which an incremental snapshot starts.
+	 */
+	unsigned long last_snapshot_produced_pos;
+	bool has_last_snapshot;
+	/*
+	 * Offset of the output file up to which the page cache writeback was
+	 * waited for. Only used by LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW.
+	 */
+	off_t writeback_offset;
 	/* Amount of bytes written to the output */
 	uint64_t output_written;
+	/*
+	 * Buffer usage and output_written last published for the channel
+	 * monitor timer, under the stream lock. The timer reads them without
+	 * the lock when the stream is busy rather than waiting for the data
+	 * thread, and sets monitor_sample_requested to have the data thread
+	 * publish a new sample before it consumes the stream again. The timer
+	 * skips the streams which were never sampled.
+	 */
+	unsigned long monitor_usage;
+	uint64_t monitor_output_written;
+	int monitor_sample_requested;
+	bool monitor_sampled;
 	int shm_fd_is_copy;
 	/*
 	 * When a stream's pipe is hung up, a final flush is performed (see hangup_flush_done). This
@@ -521,6 +634,13 @@ struct lttng_consumer_stream {
 	 * unbalanced state.
 	 */
 	unsigned int sent_to_relayd;
+	/*
+	 * Relayd to which the stream was sent, set along with `sent_to_relayd`.
+	 * The reference the stream holds on it keeps it allocated so that the
+	 * data path uses it without looking it up for every sub-buffer. Only
+	 * used with the stream lock and the RCU read-side lock held.
+	 */
+	struct consumer_relayd_sock_pair *relayd;
 
 	/* Identify if the stream is the metadata */
 	unsigned int metadata_flag;
@@ -600,6 +720,12 @@ struct lttng_consumer_stream {
 	uint64_t last_discarded_events;
 	/* Copy of the sequence number of the last packet extracted. */
 	uint64_t last_sequence_number;
+	/*
+	 * Consumption statistics of a data stream. Only updated by the stream's
+	 * data worker and read, with the consumer data lock held, when
+	 * the session daemon asks for them.
+	 */
+	struct lttcomm_consumer_channel_consumption_stats consumption_stats;
 	/*
 	 * Index file object of the index file for this stream.
 	 */
@@ -609,6 +735,8 @@ struct lttng_consumer_stream {
 	 * Local pipe to extract data when using splice.
 	 */
 	int splice_pipe[2];
+	/* Capacity of the splice pipe in bytes, see consumer_stream_size_splice_pipe(). */
+	unsigned long splice_pipe_size;
 
 	/*
 	 * Rendez-vous point between data and metadata stream in live mode.
@@ -643,6 +771,19 @@ struct lttng_consumer_stream {
 	 */
 	bool rotate_ready;
 
+	/* CPU id of the ring buffer backing the stream, -1 if unknown. */
+	int cpu;
+	/*
+	 * Index of the data worker consuming this stream. Set once when the
+	 * stream is added to the data stream hash table.
+	 */
+	unsigned int data_worker_id;
+	/*
+	 * Index of the relayd data connection on which the stream's packets are
+	 * sent, -1 until it is selected on the first packet sent.
+	 */
+	int relayd_data_sock_index;
+
 	/* Indicate if the stream still has some data to be read. */
 	unsigned int has_data:1;
 	/*
@@ -660,6 +801,7 @@ struct lttng_consumer_stream {
 		get_next_subbuffer_cb get_next_subbuffer;
 		extract_subbuffer_info_cb extract_subbuffer_info;
 		pre_consume_subbuffer_cb pre_consume_subbuffer;
+		filter_subbuffer_cb filter_subbuffer;
 		reset_metadata_cb reset_metadata;
 		consume_subbuffer_cb consume_subbuffer;
 		put_next_subbuffer_cb put_next_subbuffer;
@@ -670,6 +812,74 @@ struct lttng_consumer_stream {
 		assert_locked_cb assert_locked;
 	} read_subbuffer_ops;
 	struct metadata_bucket *metadata_bucket;
+	/*
+	 * Compression stage of data streams, only used when trace data
+	 * compression is enabled.
+	 */
+	struct {
+		/* Compressed form of the sub-buffer being consumed. */
+		struct lttng_dynamic_buffer buffer;
+		/*
+		 * Size of the last packet written, once compressed. Used in
+		 * place of the packet's size to locate it in the stream file.
+		 */
+		uint64_t packet_size;
+	} compression;
+	/*
+	 * Checksum of the packet being consumed, set when packet checksums
+	 * are enabled, see consumer_stream_set_packet_checksum_enabled().
+	 */
+	LTTNG_OPTIONAL(uint32_t) packet_checksum;
+	/* State of the packet sampling stage, see consumer-packet-filter.hpp. */
+	struct {
+		/* Packets dropped since the last one kept while lagging. */
+		unsigned int dropped_in_a_row;
+		uint64_t dropped_count;
+	} packet_filter;
+	/*
+	 * Index entries of the sub-buffers consumed during the current drain
+	 * batch which were not written to the local index file yet.
+	 */
+	struct {
+		bool active;
+		size_t count;
+		struct lttng_dynamic_buffer buffer;
+	} index_batch;
+	/*
+	 * Summary of the packets written to the current local output file,
+	 * see consumer_stream_set_chunk_manifest_enabled().
+	 */
+	struct {
+		uint64_t packet_count;
+		uint64_t byte_count;
+		uint64_t timestamp_begin;
+		uint64_t timestamp_end;
+		uint64_t discarded_events;
+		/* Discarded events count of the last packet, across files. */
+		uint64_t last_discarded_events;
+	} manifest;
+};
+
+/* Maximum number of data connections of a relayd socket pair. */
+#define CONSUMER_RELAYD_MAX_DATA_SOCKS DEFAULT_RELAYD_MAX_DATA_CONNECTION_COUNT
+
+/*
+ * Data connection of a relayd socket pair.
+ */
+struct consumer_relayd_data_sock {
+	/*
+	 * Serializes the packets sent on the socket since each packet is made of
+	 * a header and a payload which must not be interleaved with those of
+	 * another packet. Streams are spread across the data connections by
+	 * data worker, which makes this lock uncontended as long as there are
+	 * as many data connections as data workers.
+	 *
+	 * This is nested INSIDE the stream lock.
+	 */
+	pthread_mutex_t lock;
+	struct lttcomm_relayd_sock sock;
+	/* Packets waiting to be sent while the connection is congested. */
+	struct consumer_relayd_spill spill;
 };
 
 /*
@@ -688,6 +898,13 @@ struct consumer_relayd_sock_pair {
 	 */
 	unsigned int destroy_flag;
 
+	/*
+	 * Set once the relayd is removed from the relayd hash table. It is then
+	 * freed as soon as no stream references it anymore.
+	 */
+	unsigned int destroyed;
+	unsigned int freed;
+
 	/*
 	 * Mutex protecting the control socket to avoid out of order packets
 	 * between threads sending data to the relayd. Since metadata data is sent
@@ -703,11 +920,15 @@ struct consumer_relayd_sock_pair {
 	struct lttcomm_relayd_sock control_sock;
 
 	/*
-	 * We don't need a mutex at this point since we only splice or write single
-	 * large chunk of data with a header appended at the begining. Moreover,
-	 * this socket is for now only used in a single thread.
+	 * Data sockets, one for each data connection made by the session daemon
+	 * to the relayd. A data stream sends all its packets on the same data
+	 * connection so that the relayd receives them in order.
+	 *
+	 * data_sock_count is only incremented, once the new data socket is
+	 * initialized, when a data socket is received from the session daemon.
 	 */
-	struct lttcomm_relayd_sock data_sock;
+	struct consumer_relayd_data_sock data_socks[CONSUMER_RELAYD_MAX_DATA_SOCKS];
+	unsigned int data_sock_count;
 	struct lttng_ht_node_u64 node;
 
 	/* Session id on both sides for the sockets. */
@@ -716,6 +937,39 @@ struct consumer_relayd_sock_pair {
 	struct lttng_consumer_local_data *ctx;
 };
 
+/*
+ * Data stream poll worker.
+ *
+ * Each worker runs its own instance of consumer_thread_data_poll() and
+ * consumes a disjoint subset of the data streams published in the data stream
+ * hash table. A stream is assigned to a worker once, when it is added to the
+ * data stream hash table, and is never migrated to another worker.
+ */
+struct lttng_consumer_data_worker {
+	/* Index of this worker in its context's worker array. */
+	unsigned int id;
+	struct lttng_consumer_local_data *ctx;
+	pthread_t thread;
+	/* Data stream poll thread pipe. To transfer data stream to the thread */
+	struct lttng_pipe *consumer_data_pipe;
+	/*
+	 * Data thread use that pipe to catch wakeup from read subbuffer that
+	 * detects that there is still data to be read for the stream encountered.
+	 * Before doing so, the stream is flagged to indicate that there is still
+	 * data to be read.
+	 *
+	 * Both pipes (read/write) are owned and used inside the data thread.
+	 */
+	struct lttng_pipe *consumer_wakeup_pipe;
+	/*
+	 * NUMA node to which the worker thread is pinned, -1 if it may run
+	 * on any CPU. See lttng_consumer_set_numa_topology().
+	 */
+	int numa_node;
+	/* Indicate if the wakeup thread has been notified. */
+	unsigned int has_wakeup:1;
+};
+
 /*
  * UST consumer local data to the program. One or more instance per
  * process.
@@ -780,20 +1034,16 @@ struct lttng_consumer_local_data {
 	char *consumer_command_sock_path;
 	/* communication with splice */
 	int consumer_channel_pipe[2];
-	/* Data stream poll thread pipe. To transfer data stream to the thread */
-	struct lttng_pipe *consumer_data_pipe;
-
+	/* Data stream poll workers; at least one. */
+	struct lttng_consumer_data_worker *data_workers;
+	unsigned int data_worker_count;
 	/*
-	 * Data thread use that pipe to catch wakeup from read subbuffer that
-	 * detects that there is still data to be read for the stream encountered.
-	 * Before doing so, the stream is flagged to indicate that there is still
-	 * data to be read.
-	 *
-	 * Both pipes (read/write) are owned and used inside the data thread.
+	 * Number of data workers that have not exited yet. The last worker to
+	 * exit is responsible for waking-up the metadata thread.
 	 */
-	struct lttng_pipe *consumer_wakeup_pipe;
-	/* Indicate if the wakeup thread has been notified. */
-	unsigned int has_wakeup:1;
+	unsigned int data_worker_online_count;
+	/* NUMA topology used to place data streams, NULL if disabled. */
+	const lttng::numa::topology *numa_topology;
 
 	/* to let the signal handler wake up the fd receiver thread */
 	int consumer_should_quit[2];
@@ -831,11 +1081,6 @@ struct lttng_consumer_global_data {
 	struct lttng_ht *channel_ht = nullptr;
 	/* Channel hash table indexed by session id. */
 	struct lttng_ht *channels_by_session_id_ht = nullptr;
-	/*
-	 * Flag specifying if the local array of FDs needs update in the
-	 * poll function. Protected by consumer_data.lock.
-	 */
-	unsigned int need_update = 1;
 	enum lttng_consumer_type type = LTTNG_CONSUMER_UNKNOWN;
 
 	/*
@@ -994,8 +1239,11 @@ lttng_consumer_create(enum lttng_consumer_type type,
 					      bool locked_by_caller),
 		      int (*recv_channel)(struct lttng_consumer_channel *channel),
 		      int (*recv_stream)(struct lttng_consumer_stream *stream),
-		      int (*update_stream)(uint64_t sessiond_key, uint32_t state));
+		      int (*update_stream)(uint64_t sessiond_key, uint32_t state),
+		      unsigned int data_worker_count);
 void lttng_consumer_destroy(struct lttng_consumer_local_data *ctx);
+void lttng_consumer_set_numa_topology(struct lttng_consumer_local_data *ctx,
+				      const lttng::numa::topology *topology);
 ssize_t lttng_consumer_on_read_subbuffer_mmap(struct lttng_consumer_stream *stream,
 					      const struct lttng_buffer_view *buffer,
 					      unsigned long padding);
@@ -1031,18 +1279,34 @@ void consumer_add_relayd_socket(uint64_t net_seq_idx,
 				uint32_t relayd_version_major,
 				uint32_t relayd_version_minor,
 				enum lttcomm_sock_proto relayd_socket_protocol);
+/*
+ * Batch the indexes sent on the relayd control connections added from now on,
+ * see relayd_enable_index_batching().
+ */
+void consumer_set_relayd_index_batching(unsigned int max_count, uint64_t max_latency_us);
 void consumer_flag_relayd_for_destroy(struct consumer_relayd_sock_pair *relayd);
 int consumer_data_pending(uint64_t id);
 int consumer_send_status_msg(int sock, int ret_code);
 int consumer_send_status_channel(int sock, struct lttng_consumer_channel *channel);
 void notify_thread_del_channel(struct lttng_consumer_local_data *ctx, uint64_t key);
 void consumer_destroy_relayd(struct consumer_relayd_sock_pair *relayd);
+void consumer_put_relayd(struct consumer_relayd_sock_pair *relayd);
 unsigned long consumer_get_consume_start_pos(unsigned long consumed_pos,
 					     unsigned long produced_pos,
 					     uint64_t nb_packets_per_stream,
 					     uint64_t max_sb_size);
-void consumer_add_data_stream(struct lttng_consumer_stream *stream);
+void consumer_add_data_stream(struct lttng_consumer_stream *stream,
+			     struct lttng_consumer_local_data *ctx);
+struct lttng_consumer_data_worker *
+consumer_get_stream_data_worker(struct lttng_consumer_local_data *ctx,
+				const struct lttng_consumer_stream *stream);
 void consumer_del_stream_for_data(struct lttng_consumer_stream *stream);
+void consumer_consumption_stats_merge(struct lttcomm_consumer_channel_consumption_stats *dst,
+				      const struct lttcomm_consumer_channel_consumption_stats *src);
+void lttng_consumer_get_channel_consumption_stats(
+	uint64_t session_id,
+	uint64_t channel_key,
+	struct lttcomm_consumer_channel_consumption_stats *stats);
 void consumer_add_metadata_stream(struct lttng_consumer_stream *stream);
 void consumer_del_stream_for_metadata(struct lttng_consumer_stream *stream);
 int consumer_create_index_file(struct lttng_consumer_stream *stream);
@@ -1061,6 +1325,12 @@ lttng_consumer_create_trace_chunk(const uint64_t *relayd_id,
 				  const char *chunk_override_name,
 				  const struct lttng_credentials *credentials,
 				  struct lttng_directory_handle *chunk_directory_handle);
+/*
+ * Set the write end of the pipe on which the releases of the closed trace
+ * chunks and the sizes consumed from the channels are announced to the
+ * session daemon. Takes ownership of `fd`.
+ */
+enum lttcomm_return_code lttng_consumer_set_rotation_event_pipe(int fd);
 enum lttcomm_return_code
 lttng_consumer_close_trace_chunk(const uint64_t *relayd_id,
 				 uint64_t session_id,
@@ -1074,7 +1344,7 @@ enum lttcomm_return_code lttng_consumer_trace_chunk_exists(const uint64_t *relay
 void lttng_consumer_cleanup_relayd(struct consumer_relayd_sock_pair *relayd);
 enum lttcomm_return_code lttng_consumer_init_command(struct lttng_consumer_local_data *ctx,
 						     const lttng_uuid& sessiond_uuid);
-int lttng_consumer_clear_channel(struct lttng_consumer_channel *channel);
+int lttng_consumer_clear_channel(struct lttng_consumer_channel *channel, bool truncate_output);
 enum lttcomm_return_code
 lttng_consumer_open_channel_packets(struct lttng_consumer_channel *channel);
 int consumer_metadata_wakeup_pipe(const struct lttng_consumer_channel *channel);
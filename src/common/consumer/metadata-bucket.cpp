@@ -55,8 +55,10 @@ void metadata_bucket_destroy(struct metadata_bucket *bucket)
 
 void metadata_bucket_reset(struct metadata_bucket *bucket)
 {
-	lttng_dynamic_buffer_reset(&bucket->content);
-	lttng_dynamic_buffer_init(&bucket->content);
+	/* Keep the bucket's storage to accumulate the next sub-buffers. */
+	const int ret = lttng_dynamic_buffer_set_size(&bucket->content, 0);
+
+	LTTNG_ASSERT(ret == 0);
 	bucket->buffer_count = 0;
 }
 
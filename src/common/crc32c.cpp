@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include <common/crc32c.hpp>
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define LTTNG_CRC32C_HW
+#endif
+
+namespace {
+/* Reversed Castagnoli polynomial. */
+constexpr uint32_t crc32c_polynomial = 0x82F63B78;
+
+struct crc32c_table {
+	crc32c_table()
+	{
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t crc = i;
+
+			for (unsigned int bit = 0; bit < 8; bit++) {
+				crc = (crc >> 1) ^ (crc & 1 ? crc32c_polynomial : 0);
+			}
+
+			entries[i] = crc;
+		}
+	}
+
+	uint32_t entries[256];
+};
+
+uint32_t crc32c_sw(uint32_t crc, const unsigned char *data, size_t len)
+{
+	static const crc32c_table table;
+
+	while (len--) {
+		crc = table.entries[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc;
+}
+
+#ifdef LTTNG_CRC32C_HW
+__attribute__((target("sse4.2"))) uint32_t
+crc32c_hw(uint32_t crc, const unsigned char *data, size_t len)
+{
+#ifdef __x86_64__
+	uint64_t crc64 = crc;
+
+	for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), data += sizeof(uint64_t)) {
+		uint64_t value;
+
+		memcpy(&value, data, sizeof(value));
+		crc64 = _mm_crc32_u64(crc64, value);
+	}
+
+	crc = (uint32_t) crc64;
+#endif /* __x86_64__ */
+	for (; len >= sizeof(uint32_t); len -= sizeof(uint32_t), data += sizeof(uint32_t)) {
+		uint32_t value;
+
+		memcpy(&value, data, sizeof(value));
+		crc = _mm_crc32_u32(crc, value);
+	}
+
+	while (len--) {
+		crc = _mm_crc32_u8(crc, *data++);
+	}
+
+	return crc;
+}
+
+bool cpu_has_crc32c()
+{
+	static const bool supported = __builtin_cpu_supports("sse4.2");
+
+	return supported;
+}
+#endif /* LTTNG_CRC32C_HW */
+} /* namespace */
+
+uint32_t lttng_crc32c_update(uint32_t crc, const void *data, size_t len)
+{
+	const auto *bytes = static_cast<const unsigned char *>(data);
+
+	crc = ~crc;
+#ifdef LTTNG_CRC32C_HW
+	if (cpu_has_crc32c()) {
+		return ~crc32c_hw(crc, bytes, len);
+	}
+#endif /* LTTNG_CRC32C_HW */
+
+	return ~crc32c_sw(crc, bytes, len);
+}
+
+uint32_t lttng_crc32c_update_zeroes(uint32_t crc, size_t len)
+{
+	static const unsigned char zeroes[4096] = {};
+
+	while (len > 0) {
+		const size_t chunk_len = len < sizeof(zeroes) ? len : sizeof(zeroes);
+
+		crc = lttng_crc32c_update(crc, zeroes, chunk_len);
+		len -= chunk_len;
+	}
+
+	return crc;
+}
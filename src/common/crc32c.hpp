@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_CRC32C_H
+#define LTTNG_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CRC-32C (Castagnoli) checksum, computed with the CRC32 instruction of SSE
+ * 4.2 when the CPU implements it.
+ *
+ * `crc` is the checksum of the preceding data, 0 initially, which allows the
+ * checksum of data received in pieces to be updated as each piece arrives.
+ */
+uint32_t lttng_crc32c_update(uint32_t crc, const void *data, size_t len);
+
+/* Update a checksum with `len` zero bytes, such as the padding of a packet. */
+uint32_t lttng_crc32c_update_zeroes(uint32_t crc, size_t len);
+
+#endif /* LTTNG_CRC32C_H */
@@ -117,6 +117,19 @@
 /* Default extra probes list */
 #define DEFAULT_LTTNG_EXTRA_KMOD_PROBES "LTTNG_EXTRA_KMOD_PROBES"
 
+/*
+ * Set to 1 to load the kernel probe modules when the first kernel tracing
+ * session is created, kernel tracepoints are listed or a kernel trigger is
+ * registered rather than when the kernel tracer is initialized.
+ */
+#define DEFAULT_KMOD_PROBES_LAZY     0
+#define DEFAULT_KMOD_PROBES_LAZY_ENV "LTTNG_KMOD_PROBES_LAZY"
+
+/* Number of threads loading the kernel probe modules concurrently. */
+#define DEFAULT_KMOD_PROBES_LOAD_THREAD_COUNT	  4
+#define DEFAULT_KMOD_PROBES_LOAD_THREAD_COUNT_ENV "LTTNG_KMOD_PROBES_LOAD_THREADS"
+#define DEFAULT_KMOD_PROBES_LOAD_MAX_THREAD_COUNT 64
+
 /* Default unix socket path */
 #define DEFAULT_GLOBAL_CLIENT_UNIX_SOCK		      DEFAULT_LTTNG_RUNDIR "/client-lttng-sessiond"
 #define DEFAULT_HOME_CLIENT_UNIX_SOCK		      DEFAULT_LTTNG_HOME_RUNDIR "/client-lttng-sessiond"
@@ -160,6 +173,40 @@
 #define DEFAULT_SESSION_CONFIG_XSD_PATH	      CONFIG_LTTNG_SYSTEM_DATADIR "/xml/lttng/"
 #define DEFAULT_SESSION_CONFIG_XSD_PATH_ENV   "LTTNG_SESSION_CONFIG_XSD_PATH"
 
+/*
+ * Set to 1 to record the registered triggers in a store, in the session
+ * configuration directory of the session daemon's user, and register them
+ * again when the session daemon restarts.
+ */
+#define DEFAULT_PERSISTENT_TRIGGERS	 0
+#define DEFAULT_PERSISTENT_TRIGGERS_ENV	 "LTTNG_PERSISTENT_TRIGGERS"
+#define DEFAULT_TRIGGER_STORE_FILE	 "triggers.store"
+
+/*
+ * Set to 1 to clear the sessions which write their trace locally by
+ * truncating the files of their current trace chunk in place rather than by
+ * rotating to a new trace chunk and deleting the previous one.
+ */
+#define DEFAULT_FAST_CLEAR     0
+#define DEFAULT_FAST_CLEAR_ENV "LTTNG_FAST_CLEAR"
+
+/*
+ * Set to 1 to offset the first expiration of the periodic rotation schedule
+ * of each session by a phase derived from its name, so that the sessions
+ * sharing a rotation period don't all rotate at the same instant.
+ */
+#define DEFAULT_ROTATION_SCHEDULE_STAGGER     0
+#define DEFAULT_ROTATION_SCHEDULE_STAGGER_ENV "LTTNG_ROTATION_SCHEDULE_STAGGER"
+
+/*
+ * Maximal number of scheduled rotations of a session daemon which can be
+ * ongoing at once, the next ones being queued until one completes. A value of
+ * 0 means no limit.
+ */
+#define DEFAULT_ROTATION_MAX_CONCURRENT	    0
+#define DEFAULT_ROTATION_MAX_CONCURRENT_ENV "LTTNG_ROTATION_MAX_CONCURRENT"
+#define DEFAULT_ROTATION_MAX_CONCURRENT_MAX 65535
+
 #define DEFAULT_GLOBAL_APPS_UNIX_SOCK	  DEFAULT_LTTNG_RUNDIR "/" LTTNG_UST_SOCK_FILENAME
 #define DEFAULT_HOME_APPS_UNIX_SOCK	  DEFAULT_LTTNG_HOME_RUNDIR "/" LTTNG_UST_SOCK_FILENAME
 #define DEFAULT_GLOBAL_APPS_WAIT_SHM_PATH "/" LTTNG_UST_WAIT_FILENAME
@@ -296,6 +343,13 @@
  */
 #define DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US 200000 /* usec */
 
+/*
+ * Initial wait period before retrying the lttng_data_pending command. The wait
+ * period doubles on every retry, up to DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US,
+ * so that sessions which drain quickly are not delayed by a full period.
+ */
+#define DEFAULT_DATA_AVAILABILITY_MIN_WAIT_TIME_US 1000 /* usec */
+
 /*
  * Wait period before retrying the lttng_consumer_flushed_cache when
  * the consumer receives metadata.
@@ -320,6 +374,185 @@
 #define DEFAULT_APP_SOCKET_RW_TIMEOUT  CONFIG_DEFAULT_APP_SOCKET_RW_TIMEOUT
 #define DEFAULT_APP_SOCKET_TIMEOUT_ENV "LTTNG_APP_SOCKET_TIMEOUT"
 
+/*
+ * Number of data connections made to a relay daemon for each consumer daemon
+ * streaming to it. The streams of a consumer daemon are spread across its data
+ * connections.
+ */
+#define DEFAULT_RELAYD_DATA_CONNECTION_COUNT	 1
+#define DEFAULT_RELAYD_DATA_CONNECTION_COUNT_ENV "LTTNG_RELAYD_DATA_CONNECTIONS"
+#define DEFAULT_RELAYD_MAX_DATA_CONNECTION_COUNT 16
+
+/*
+ * Number of threads of a session daemon which complete the registration of
+ * the instrumented applications, updating them with the tracing sessions
+ * concurrently.
+ */
+#define DEFAULT_APP_REGISTRATION_THREAD_COUNT	  4
+#define DEFAULT_APP_REGISTRATION_THREAD_COUNT_ENV "LTTNG_APP_REGISTRATION_THREADS"
+#define DEFAULT_APP_REGISTRATION_MAX_THREAD_COUNT 64
+
+/*
+ * Number of threads of a session daemon which complete the registration of
+ * the agents (JUL, log4j, Python), updating them with the tracing sessions
+ * concurrently.
+ */
+#define DEFAULT_AGENT_REGISTRATION_THREAD_COUNT	    4
+#define DEFAULT_AGENT_REGISTRATION_THREAD_COUNT_ENV "LTTNG_AGENT_REGISTRATION_THREADS"
+#define DEFAULT_AGENT_REGISTRATION_MAX_THREAD_COUNT 64
+
+/*
+ * Number of threads among which a session daemon spreads the applications
+ * to update, start, stop or flush for a tracing session.
+ */
+#define DEFAULT_APP_COMMAND_THREAD_COUNT     4
+#define DEFAULT_APP_COMMAND_THREAD_COUNT_ENV "LTTNG_APP_COMMAND_THREADS"
+#define DEFAULT_APP_COMMAND_MAX_THREAD_COUNT 64
+/* Duration above which the handling of an application is reported. */
+#define DEFAULT_APP_COMMAND_SLOW_MS 1000
+
+/*
+ * Number of threads of a session daemon which receive and process the
+ * commands of the clients.
+ */
+#define DEFAULT_CLIENT_COMMAND_THREAD_COUNT	4
+#define DEFAULT_CLIENT_COMMAND_THREAD_COUNT_ENV "LTTNG_CLIENT_COMMAND_THREADS"
+#define DEFAULT_CLIENT_COMMAND_MAX_THREAD_COUNT 64
+
+/*
+ * Maximal number of event registrations already queued on the notify socket
+ * of an application which a session daemon handles under a single hold of
+ * the registry lock.
+ */
+#define DEFAULT_APP_EVENT_REGISTRATION_BATCH 256
+
+/*
+ * Delay, in milliseconds, during which a session daemon holds back the new
+ * metadata of a registry session from the periodic metadata requests of the
+ * consumer daemons, unless it reached the push threshold, in bytes. A delay
+ * of 0 disables the coalescing of the metadata pushes.
+ */
+#define DEFAULT_UST_METADATA_PUSH_DELAY_MS	100
+#define DEFAULT_UST_METADATA_PUSH_DELAY_MS_ENV	"LTTNG_UST_METADATA_PUSH_DELAY_MS"
+#define DEFAULT_UST_METADATA_PUSH_MAX_DELAY_MS	10000
+#define DEFAULT_UST_METADATA_PUSH_THRESHOLD	65536
+#define DEFAULT_UST_METADATA_PUSH_THRESHOLD_ENV	"LTTNG_UST_METADATA_PUSH_THRESHOLD"
+#define DEFAULT_UST_METADATA_PUSH_MAX_THRESHOLD	(UINT32_MAX >> 1)
+
+/*
+ * Largest change, in nanoseconds, of the resampled offset of the clock of a
+ * user space registry session under which a metadata regeneration keeps its
+ * metadata as is rather than resetting the metadata streams.
+ */
+#define DEFAULT_UST_METADATA_REGENERATION_CLOCK_OFFSET_TOLERANCE_NS 1000
+
+/*
+ * Set to 0 to generate the description of the event classes of each per-PID
+ * registry session rather than share it between the identical event classes
+ * of the applications of a tracing session.
+ */
+#define DEFAULT_UST_PER_PID_SHARED_METADATA	1
+#define DEFAULT_UST_PER_PID_SHARED_METADATA_ENV "LTTNG_UST_PER_PID_SHARED_METADATA"
+
+/*
+ * Set to 1 to defer the creation of the per-PID buffers of an application
+ * until it provides a tracepoint which an event rule of the tracing session
+ * may match.
+ */
+#define DEFAULT_UST_LAZY_PER_PID_CHANNELS     0
+#define DEFAULT_UST_LAZY_PER_PID_CHANNELS_ENV "LTTNG_UST_LAZY_PER_PID_CHANNELS"
+
+/*
+ * Time, in milliseconds, during which the tracepoints and tracepoint fields
+ * listed from an application are served from a cache rather than listed from
+ * the application again. A value of 0 disables the cache.
+ */
+#define DEFAULT_UST_TRACEPOINT_LIST_CACHE_MS	 0
+#define DEFAULT_UST_TRACEPOINT_LIST_CACHE_MS_ENV "LTTNG_UST_TRACEPOINT_LIST_CACHE_MS"
+#define DEFAULT_UST_TRACEPOINT_LIST_CACHE_MAX_MS 3600000
+
+/*
+ * Maximal number of per PID buffer registry objects of exited applications
+ * which a session daemon keeps to reuse for the next applications.
+ */
+#define DEFAULT_BUFFER_REG_PID_POOL_SIZE 64
+
+/*
+ * Number of worker threads of a relay daemon. The connections it accepts are
+ * spread across its worker threads.
+ */
+#define DEFAULT_RELAYD_WORKER_THREAD_COUNT     1
+#define DEFAULT_RELAYD_MAX_WORKER_THREAD_COUNT 256
+
+/*
+ * Number of live worker threads of a relay daemon. The live viewer
+ * connections it accepts are spread across its live worker threads.
+ */
+#define DEFAULT_RELAYD_LIVE_WORKER_THREAD_COUNT     1
+#define DEFAULT_RELAYD_MAX_LIVE_WORKER_THREAD_COUNT 256
+
+/*
+ * Maximal size of the receive buffer of a relay daemon data connection. The
+ * buffer of a connection grows up to the size of the largest packet it
+ * receives, within this limit.
+ */
+#define DEFAULT_RELAYD_DATA_RECV_BUFFER_MAX_SIZE (1024 * 1024)
+
+/*
+ * Writer threads of a relay daemon, writing the packets received by its
+ * worker threads to the stream files. When there are none, the worker
+ * threads write the packets they receive.
+ */
+#define DEFAULT_RELAYD_WRITER_THREAD_COUNT     0
+#define DEFAULT_RELAYD_MAX_WRITER_THREAD_COUNT 256
+/* Maximal size of the packets of a stream queued to its writer thread. */
+#define DEFAULT_RELAYD_WRITER_QUEUE_SIZE (16 * 1024 * 1024)
+
+/*
+ * Rotation threads of a relay daemon, closing the files and releasing the
+ * trace chunks left behind by the rotations and the closes of its streams.
+ * When there are none, the threads rotating or closing the streams do it.
+ */
+#define DEFAULT_RELAYD_ROTATION_THREAD_COUNT     0
+#define DEFAULT_RELAYD_MAX_ROTATION_THREAD_COUNT 64
+
+/*
+ * Suspended file descriptors of a relay daemon restored ahead of their use
+ * at each prefetch interval, and time since their last use after which
+ * they are left suspended.
+ */
+#define DEFAULT_RELAYD_MAX_FD_PREFETCH_INTERVAL_MS 60000
+#define DEFAULT_RELAYD_FD_PREFETCH_BATCH	   64
+#define DEFAULT_RELAYD_FD_PREFETCH_MAX_IDLE_MS	   10000
+
+/*
+ * Upstream relay daemons to which a relay daemon forwards its sessions, and
+ * maximal size of the packets queued to each of them.
+ */
+#define DEFAULT_RELAYD_MAX_FORWARD_OUTPUTS 4
+#define DEFAULT_RELAYD_FORWARD_QUEUE_SIZE  (64 * 1024 * 1024)
+
+/*
+ * Number of index entries of a stream which a relay daemon writes to its
+ * index file at once. The entries are written one by one when set to 1.
+ */
+#define DEFAULT_RELAYD_INDEX_BUFFER_COUNT     1
+#define DEFAULT_RELAYD_MAX_INDEX_BUFFER_COUNT 4096
+
+/*
+ * Time during which a relay daemon worker thread stops reading a data
+ * connection, or yields a control connection to the data connections, once
+ * the memory budget of the relay daemon is exceeded.
+ */
+#define DEFAULT_RELAYD_MEMORY_BUDGET_BACKOFF_MS 10
+
+/*
+ * Bytes which a relay daemon worker thread receives at most from a ready
+ * data connection, while data remains queued on its socket, before serving
+ * its other connections.
+ */
+#define DEFAULT_RELAYD_DATA_DRAIN_MAX_SIZE (1024 * 1024)
+
 #define DEFAULT_UST_STREAM_FD_NUM 2 /* Number of fd per UST stream. */
 
 #define DEFAULT_SNAPSHOT_NAME	  "snapshot"
@@ -329,18 +562,169 @@
 #define DEFAULT_INDEX_FILE_SUFFIX ".idx"
 #define DEFAULT_INDEX_DIR	  "index"
 
+/* Manifest of the stream files of a trace chunk, at its root. */
+#define DEFAULT_CHUNK_MANIFEST_FILE_NAME "manifest"
+
 /* Default lttng command live timer value in usec. */
 #define DEFAULT_LTTNG_LIVE_TIMER CONFIG_DEFAULT_LTTNG_LIVE_TIMER
 
+/*
+ * Environment variable which makes the daemons write their debug messages
+ * asynchronously when set to 1.
+ */
+#define DEFAULT_ASYNC_LOG_ENV "LTTNG_ASYNC_LOG"
+
 /* Default runas worker name */
 #define DEFAULT_RUN_AS_WORKER_NAME "lttng-runas"
 
+/*
+ * Default and maximal number of run-as worker processes of a daemon. The
+ * threads of the daemon run their run-as commands on distinct workers
+ * concurrently.
+ */
+#define DEFAULT_RUN_AS_WORKER_COUNT	1
+#define DEFAULT_RUN_AS_WORKER_COUNT_MAX 16
+#define DEFAULT_RUN_AS_WORKERS_ENV	"LTTNG_RUNAS_WORKERS"
+
 /* Default LTTng MI XML namespace. */
 #define DEFAULT_LTTNG_MI_NAMESPACE "https://lttng.org/xml/ns/lttng-mi"
 
 /* Default thread stack size; the default mandated by pthread_create(3) */
 #define DEFAULT_LTTNG_THREAD_STACK_SIZE 2097152
 
+/*
+ * Default and maximal number of data stream poll threads of the consumer
+ * daemon. The default can be overriden through the environment of the
+ * consumer daemon since it is spawned by the session daemon.
+ */
+#define DEFAULT_CONSUMERD_DATA_THREAD_COUNT	1
+#define DEFAULT_CONSUMERD_DATA_THREAD_COUNT_MAX 1024
+#define DEFAULT_CONSUMERD_DATA_THREADS_ENV	"LTTNG_CONSUMERD_DATA_THREADS"
+
+/*
+ * Setting this environment variable to 1 makes the consumer daemon wait for
+ * the page cache writeback of local trace files through io_uring, when
+ * available, instead of blocking its consumption threads.
+ */
+#define DEFAULT_CONSUMERD_IO_URING_ENV "LTTNG_CONSUMERD_IO_URING"
+
+/*
+ * Number of io_uring submission entries of each consumer thread; each
+ * flushed sub-buffer range uses two.
+ */
+#define DEFAULT_IO_URING_FLUSH_QUEUE_DEPTH 64
+
+/*
+ * Setting this environment variable to `zstd[:LEVEL]` makes the consumer
+ * daemon compress each sub-buffer of the data streams of mmap channels before
+ * writing it to the trace files or sending it to the relay daemon. The
+ * names of the compressed streams take the `.zst` suffix, and their stream
+ * files must be decompressed before the trace can be read.
+ */
+#define DEFAULT_CONSUMERD_COMPRESSION_ENV "LTTNG_CONSUMERD_COMPRESSION"
+
+/*
+ * Setting this environment variable to 1 makes the consumer daemon spread its
+ * data threads across the NUMA nodes of the system and consume each stream
+ * from a thread of the node of the CPU producing it.
+ */
+#define DEFAULT_CONSUMERD_NUMA_ENV "LTTNG_CONSUMERD_NUMA"
+
+/*
+ * Default and maximal number of threads recording the streams of a channel
+ * snapshot concurrently, including the thread handling the snapshot command.
+ */
+#define DEFAULT_CONSUMERD_SNAPSHOT_THREAD_COUNT	    4
+#define DEFAULT_CONSUMERD_SNAPSHOT_THREAD_COUNT_MAX 256
+#define DEFAULT_CONSUMERD_SNAPSHOT_THREADS_ENV	    "LTTNG_CONSUMERD_SNAPSHOT_THREADS"
+
+/*
+ * Number of threads flushing and sampling the rotation positions of the
+ * streams of a channel concurrently, including the thread handling the
+ * rotation command, once the channel has at least the given number of streams.
+ */
+#define DEFAULT_CONSUMERD_ROTATE_THREAD_COUNT	       4
+#define DEFAULT_CONSUMERD_ROTATE_PARALLEL_STREAM_COUNT 64
+
+/*
+ * Bytes written by the data streams of a channel after which the consumer
+ * daemon reports them to the session daemon, which performs the size-based
+ * rotations of the sessions from these reports.
+ */
+#define DEFAULT_CONSUMERD_CONSUMED_SIZE_REPORT_STEP (1024 * 1024)
+
+/*
+ * Setting this environment variable to `N[:BACKLOG]` makes the consumer daemon
+ * keep only one in N packets of each data stream lagging by at least BACKLOG
+ * sub-buffers (default: 4) and drop the others.
+ */
+#define DEFAULT_CONSUMERD_PACKET_SAMPLING_ENV "LTTNG_CONSUMERD_PACKET_SAMPLING"
+
+/*
+ * Comma-separated list of the channels of which the consumer daemon never
+ * drops packets when packet sampling is enabled.
+ */
+#define DEFAULT_CONSUMERD_PACKET_SAMPLING_EXEMPT_ENV "LTTNG_CONSUMERD_PACKET_SAMPLING_EXEMPT"
+
+/*
+ * Setting this environment variable to a directory makes the consumer daemon
+ * spill the packets of congested relay daemon data connections to files of
+ * this directory instead of blocking, and send them once the connections
+ * drain.
+ */
+#define DEFAULT_CONSUMERD_RELAYD_SPILL_DIR_ENV "LTTNG_CONSUMERD_RELAYD_SPILL_DIR"
+
+/* Default and environment override of the spill file size of each connection. */
+#define DEFAULT_CONSUMERD_RELAYD_SPILL_MAX_SIZE	     (256 * 1024 * 1024)
+#define DEFAULT_CONSUMERD_RELAYD_SPILL_MAX_SIZE_ENV "LTTNG_CONSUMERD_RELAYD_SPILL_MAX_SIZE"
+
+/*
+ * Number of indexes the consumer daemon sends to a relay daemon in a single
+ * command. Indexes are sent one by one when set to 1.
+ */
+#define DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE	  1
+#define DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_MAX	  4096
+#define DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_ENV "LTTNG_CONSUMERD_RELAYD_INDEX_BATCH_SIZE"
+
+/* Maximal time, in microseconds, during which an index is held back in a batch. */
+#define DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY 10000
+#define DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY_ENV \
+	"LTTNG_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY"
+
+/*
+ * Setting this environment variable to a size makes the consumer daemon
+ * reserve the blocks of the local stream files that many bytes ahead of its
+ * writes, or the whole file when the trace file size of the channel is set.
+ */
+#define DEFAULT_CONSUMERD_PREALLOCATION_SIZE_ENV "LTTNG_CONSUMERD_PREALLOCATION_SIZE"
+
+/*
+ * Setting this environment variable to a size makes the consumer daemon skip
+ * the monitor samples of a channel until its buffer usage or consumed size
+ * changed by at least that many bytes since the last sample it sent.
+ */
+#define DEFAULT_CONSUMERD_MONITOR_SAMPLE_DELTA_ENV "LTTNG_CONSUMERD_MONITOR_SAMPLE_DELTA"
+
+/*
+ * Setting this environment variable to 1 makes the consumer daemon write a
+ * manifest of the local stream files of each trace chunk at its root.
+ */
+#define DEFAULT_CONSUMERD_CHUNK_MANIFEST_ENV "LTTNG_CONSUMERD_CHUNK_MANIFEST"
+
+/*
+ * Setting this environment variable to 1 makes the data threads of the
+ * consumer daemon consume the metadata of a live session themselves before
+ * publishing the index of a packet, rather than waiting for the metadata
+ * thread.
+ */
+#define DEFAULT_CONSUMERD_METADATA_LANE_ENV "LTTNG_CONSUMERD_METADATA_LANE"
+
+/*
+ * Setting this environment variable to 1 makes the consumer daemon compute the
+ * checksum of the data packets it consumes, which the relay daemon verifies.
+ */
+#define DEFAULT_CONSUMERD_PACKET_CHECKSUM_ENV "LTTNG_CONSUMERD_PACKET_CHECKSUM"
+
 /* Default maximal size of message notification channel message payloads. */
 #define DEFAULT_MAX_NOTIFICATION_CLIENT_MESSAGE_PAYLOAD_SIZE 65536
 
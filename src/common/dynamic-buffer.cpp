@@ -9,6 +9,16 @@
 #include <common/dynamic-buffer.hpp>
 #include <common/utils.hpp>
 
+#include <algorithm>
+
+/*
+ * Minimal capacity of a buffer holding data. Most command, trigger and
+ * notification payloads are a few hundred bytes: starting at this capacity
+ * saves the reallocations of growing them through every power of two from
+ * the size of their first append.
+ */
+#define DYNAMIC_BUFFER_MIN_CAPACITY 256
+
 /*
  * Round to (upper) power of two, val is returned if it already is a power of
  * two.
@@ -132,7 +142,12 @@ int lttng_dynamic_buffer_set_capacity(struct lttng_dynamic_buffer *buffer, size_
 {
 	int ret = 0;
 	void *new_buf;
-	size_t new_capacity = demanded_capacity ? round_to_power_of_2(demanded_capacity) : 0;
+	size_t new_capacity = 0;
+
+	if (demanded_capacity) {
+		new_capacity = std::max<size_t>(round_to_power_of_2(demanded_capacity),
+						DYNAMIC_BUFFER_MIN_CAPACITY);
+	}
 
 	if (!buffer || demanded_capacity < buffer->size) {
 		/*
@@ -148,6 +163,7 @@ int lttng_dynamic_buffer_set_capacity(struct lttng_dynamic_buffer *buffer, size_
 	}
 
 	/* Memory is initialized by the size increases. */
+	LTTNG_ALLOC_STATS_COUNT("dynamic buffer growth", new_capacity - buffer->_capacity);
 	new_buf = realloc(buffer->data, new_capacity);
 	if (!new_buf) {
 		ret = -1;
@@ -160,6 +176,19 @@ end:
 	return ret;
 }
 
+int lttng_dynamic_buffer_reserve(struct lttng_dynamic_buffer *buffer, size_t size_hint)
+{
+	if (!buffer || size_hint > SIZE_MAX - buffer->size) {
+		return -1;
+	}
+
+	if (buffer->_capacity - buffer->size >= size_hint) {
+		return 0;
+	}
+
+	return lttng_dynamic_buffer_set_capacity(buffer, buffer->size + size_hint);
+}
+
 /* Release any memory used by the dynamic buffer. */
 void lttng_dynamic_buffer_reset(struct lttng_dynamic_buffer *buffer)
 {
@@ -83,6 +83,15 @@ int lttng_dynamic_buffer_set_size(struct lttng_dynamic_buffer *buffer, size_t ne
  */
 int lttng_dynamic_buffer_set_capacity(struct lttng_dynamic_buffer *buffer, size_t new_capacity);
 
+/*
+ * Set the buffer's capacity to accommodate `size_hint` more bytes past its
+ * current size, allocating memory as necessary. Like
+ * lttng_dynamic_buffer_set_capacity(), this is only an optimization: it is
+ * meant for serializers which know the size of what they are about to append
+ * to avoid the reallocations of growing the buffer one append at a time.
+ */
+int lttng_dynamic_buffer_reserve(struct lttng_dynamic_buffer *buffer, size_t size_hint);
+
 /* Release any memory used by the dynamic buffer. */
 void lttng_dynamic_buffer_reset(struct lttng_dynamic_buffer *buffer);
 
@@ -30,6 +30,16 @@ int lttng_opt_abort_on_error = -1;
 
 /* TLS variable that contains the time of one single log entry. */
 thread_local struct log_time error_log_time;
+
+/*
+ * Local time of the last second at which the thread logged, which saves the
+ * conversion of the time of the entries logged during the same second.
+ */
+thread_local struct {
+	bool valid;
+	time_t time;
+	struct tm tm;
+} log_local_time;
 } /* namespace */
 
 thread_local const char *logger_thread_name;
@@ -37,7 +47,7 @@ thread_local const char *logger_thread_name;
 const char *log_add_time()
 {
 	int ret;
-	struct tm tm, *res;
+	const struct tm *tm;
 	struct timespec tp;
 	time_t now;
 	const int errsv = errno;
@@ -48,18 +58,25 @@ const char *log_add_time()
 	}
 	now = (time_t) tp.tv_sec;
 
-	res = localtime_r(&now, &tm);
-	if (!res) {
-		goto error;
+	if (!log_local_time.valid || log_local_time.time != now) {
+		if (!localtime_r(&now, &log_local_time.tm)) {
+			log_local_time.valid = false;
+			goto error;
+		}
+
+		log_local_time.time = now;
+		log_local_time.valid = true;
 	}
 
+	tm = &log_local_time.tm;
+
 	/* Format time in the TLS variable. */
 	ret = snprintf(error_log_time.str,
 		       sizeof(error_log_time.str),
 		       "%02d:%02d:%02d.%09ld",
-		       tm.tm_hour,
-		       tm.tm_min,
-		       tm.tm_sec,
+		       tm->tm_hour,
+		       tm->tm_min,
+		       tm->tm_sec,
 		       tp.tv_nsec);
 	if (ret < 0) {
 		goto error;
@@ -412,6 +429,8 @@ static const char *lttng_error_code_str(lttng_error_code code)
 		return "Invalid error query target.";
 	case LTTNG_ERR_BUFFER_FLUSH_FAILED:
 		return "Failed to flush stream buffer";
+	case LTTNG_ERR_HUGE_PAGES_UNAVAILABLE:
+		return "Transparent huge pages are unavailable on this system";
 	case LTTNG_ERR_NR:
 		abort();
 	}
@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <urcu/system.h>
 #include <urcu/tls-compat.h>
 
 #ifndef _GNU_SOURCE
@@ -113,6 +114,15 @@ static inline bool __lttng_print_check_opt(enum lttng_error_level type)
 
 C_LINKAGE void lttng_abort_on_error(void);
 
+/* Set while the debug messages are written asynchronously (see async-log.hpp). */
+extern int lttng_async_log_active;
+void lttng_async_log_printf(const char *fmt, ...) ATTR_FORMAT_PRINTF(1, 2);
+
+static inline bool __lttng_print_is_async(enum lttng_error_level type)
+{
+	return type >= PRINT_DBG && caa_unlikely(CMM_LOAD_SHARED(lttng_async_log_active));
+}
+
 static inline void __lttng_print_check_abort(enum lttng_error_level type)
 {
 	switch (type) {
@@ -136,12 +146,16 @@ static inline void __lttng_print_check_abort(enum lttng_error_level type)
  * want any nested msg to show up when printing mi to stdout(if it's the case).
  * All warnings and errors should be printed to stderr as normal.
  */
-#define __lttng_print(type, fmt, args...)                                            \
-	do {                                                                         \
-		if (__lttng_print_check_opt(type)) {                                 \
-			fprintf((type) == PRINT_MSG ? stdout : stderr, fmt, ##args); \
-		}                                                                    \
-		__lttng_print_check_abort(type);                                     \
+#define __lttng_print(type, fmt, args...)                                                    \
+	do {                                                                                 \
+		if (__lttng_print_check_opt(type)) {                                         \
+			if (__lttng_print_is_async(type)) {                                  \
+				lttng_async_log_printf(fmt, ##args);                         \
+			} else {                                                             \
+				fprintf((type) == PRINT_MSG ? stdout : stderr, fmt, ##args); \
+			}                                                                    \
+		}                                                                            \
+		__lttng_print_check_abort(type);                                             \
 	} while (0)
 
 /* Three level of debug. Use -v, -vv or -vvv for the levels */
@@ -9,6 +9,7 @@
 #include <common/macros.hpp>
 
 #include <lttng/condition/buffer-usage-internal.hpp>
+#include <lttng/condition/channel-rate-internal.hpp>
 #include <lttng/condition/condition-internal.hpp>
 #include <lttng/condition/evaluation-internal.hpp>
 #include <lttng/condition/event-rule-matches-internal.hpp>
@@ -124,6 +125,22 @@ ssize_t lttng_evaluation_create_from_payload(const struct lttng_condition *condi
 		}
 		evaluation_size += ret;
 		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+		ret = lttng_evaluation_channel_rate_high_create_from_payload(&evaluation_view,
+									     evaluation);
+		if (ret < 0) {
+			goto end;
+		}
+		evaluation_size += ret;
+		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+		ret = lttng_evaluation_channel_rate_low_create_from_payload(&evaluation_view,
+									    evaluation);
+		if (ret < 0) {
+			goto end;
+		}
+		evaluation_size += ret;
+		break;
 	default:
 		ERR("Attempted to create evaluation of unknown type (%i)",
 		    (int) evaluation_comm->type);
@@ -24,7 +24,8 @@ namespace {
 struct event_list_element {
 	struct lttng_event *event;
 	struct lttng_event_exclusion *exclusions;
-	char *filter_expression;
+	/* Borrowed from the payload the events are deserialized from. */
+	const char *filter_expression;
 };
 } /* namespace */
 
@@ -32,7 +33,6 @@ static void event_list_destructor(void *ptr)
 {
 	struct event_list_element *element = (struct event_list_element *) ptr;
 
-	free(element->filter_expression);
 	free(element->exclusions);
 	lttng_event_destroy(element->event);
 	free(element);
@@ -322,16 +322,24 @@ end:
 	return ret;
 }
 
-ssize_t lttng_event_create_from_payload(struct lttng_payload_view *view,
-					struct lttng_event **out_event,
-					struct lttng_event_exclusion **out_exclusion,
-					char **out_filter_expression,
-					struct lttng_bytecode **out_bytecode)
+/*
+ * Same as lttng_event_create_from_payload(), but the filter expression can also
+ * be borrowed from `view` through `out_borrowed_filter_expression` rather than
+ * copied: it is then only valid for as long as the payload referenced by `view`
+ * is neither reset nor resized.
+ */
+static ssize_t event_create_from_payload(struct lttng_payload_view *view,
+					 struct lttng_event **out_event,
+					 struct lttng_event_exclusion **out_exclusion,
+					 char **out_filter_expression,
+					 const char **out_borrowed_filter_expression,
+					 struct lttng_bytecode **out_bytecode)
 {
 	ssize_t ret, offset = 0;
 	struct lttng_event *local_event = nullptr;
 	struct lttng_event_exclusion *local_exclusions = nullptr;
 	struct lttng_bytecode *local_bytecode = nullptr;
+	const char *filter_expression = nullptr;
 	char *local_filter_expression = nullptr;
 	const struct lttng_event_comm *event_comm;
 	struct lttng_event_function_attr *local_function_attr = nullptr;
@@ -439,37 +447,17 @@ deserialize_filter_expression:
 		goto deserialize_event_type_payload;
 	}
 
-	{
-		const char *filter_expression_buffer;
-		struct lttng_buffer_view filter_expression_view = lttng_buffer_view_from_view(
-			&view->buffer, offset, event_comm->filter_expression_len);
-
-		if (!lttng_buffer_view_is_valid(&filter_expression_view)) {
-			ret = -1;
-			goto end;
-		}
-
-		filter_expression_buffer = filter_expression_view.data;
-
-		if (!lttng_buffer_view_contains_string(&filter_expression_view,
-						       filter_expression_buffer,
-						       event_comm->filter_expression_len)) {
-			ret = -1;
-			goto end;
-		}
-
-		local_filter_expression =
-			lttng_strndup(filter_expression_buffer, event_comm->filter_expression_len);
-		if (!local_filter_expression) {
-			ret = -1;
-			goto end;
-		}
-
-		local_event->filter = 1;
-
-		offset += event_comm->filter_expression_len;
+	/* Only copied if the caller asks for its own copy. */
+	filter_expression = lttng_buffer_view_borrow_string(
+		&view->buffer, offset, event_comm->filter_expression_len);
+	if (!filter_expression) {
+		ret = -1;
+		goto end;
 	}
 
+	local_event->filter = 1;
+	offset += event_comm->filter_expression_len;
+
 	if (event_comm->bytecode_len == 0) {
 		/*
 		 * Filter expression can be present but without bytecode
@@ -631,6 +619,14 @@ deserialize_event_type_payload:
 		break;
 	}
 
+	if (out_filter_expression && filter_expression) {
+		local_filter_expression = strdup(filter_expression);
+		if (!local_filter_expression) {
+			ret = -1;
+			goto end;
+		}
+	}
+
 	/* Transfer ownership to the caller. */
 	*out_event = local_event;
 	local_event = nullptr;
@@ -650,6 +646,10 @@ deserialize_event_type_payload:
 		local_filter_expression = nullptr;
 	}
 
+	if (out_borrowed_filter_expression) {
+		*out_borrowed_filter_expression = filter_expression;
+	}
+
 	ret = offset;
 end:
 	lttng_event_destroy(local_event);
@@ -662,6 +662,16 @@ end:
 	return ret;
 }
 
+ssize_t lttng_event_create_from_payload(struct lttng_payload_view *view,
+					struct lttng_event **out_event,
+					struct lttng_event_exclusion **out_exclusion,
+					char **out_filter_expression,
+					struct lttng_bytecode **out_bytecode)
+{
+	return event_create_from_payload(
+		view, out_event, out_exclusion, out_filter_expression, nullptr, out_bytecode);
+}
+
 int lttng_event_serialize(const struct lttng_event *event,
 			  unsigned int exclusion_count,
 			  const char *const *exclusion_list,
@@ -720,6 +730,24 @@ int lttng_event_serialize(const struct lttng_event *event,
 		event_comm.filter_expression_len = strlen(filter_expression) + 1;
 	}
 
+	/*
+	 * Reserve the space of everything but the event type specific payload,
+	 * bounding the length of the exclusions.
+	 */
+	{
+		const size_t exclusions_size = exclusion_count *
+			(sizeof(struct lttng_event_exclusion_comm) + LTTNG_SYMBOL_NAME_LEN);
+		const size_t bytecode_size = filter_expression && bytecode ? bytecode_len : 0;
+
+		ret = lttng_dynamic_buffer_reserve(&payload->buffer,
+						   sizeof(event_comm) + name_len +
+							   event_comm.filter_expression_len +
+							   exclusions_size + bytecode_size);
+	}
+	if (ret) {
+		goto end;
+	}
+
 	/* Header */
 	ret = lttng_dynamic_buffer_append(&payload->buffer, &event_comm, sizeof(event_comm));
 	if (ret) {
@@ -1658,12 +1686,17 @@ event_list_create_from_payload(struct lttng_payload_view *view,
 		/*
 		 * Bytecode is not transmitted on listing in any case we do not
 		 * care about it.
+		 *
+		 * The filter expression is borrowed from the payload, which
+		 * outlives the list: it is only copied once, when the events
+		 * are flattened.
 		 */
-		event_size = lttng_event_create_from_payload(&event_view,
-							     &element->event,
-							     &element->exclusions,
-							     &element->filter_expression,
-							     nullptr);
+		event_size = event_create_from_payload(&event_view,
+						       &element->event,
+						       &element->exclusions,
+						       nullptr,
+						       &element->filter_expression,
+						       nullptr);
 		if (event_size < 0) {
 			ret_code = LTTNG_ERR_INVALID;
 			goto end;
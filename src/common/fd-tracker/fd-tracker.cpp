@@ -8,6 +8,7 @@
 #include "fd-tracker.hpp"
 #include "inode.hpp"
 
+#include <common/compat/time.hpp>
 #include <common/defaults.hpp>
 #include <common/error.hpp>
 #include <common/fs-handle-internal.hpp>
@@ -15,6 +16,7 @@
 #include <common/hashtable/utils.hpp>
 #include <common/macros.hpp>
 #include <common/optional.hpp>
+#include <common/time.hpp>
 #include <common/urcu.hpp>
 
 #include <fcntl.h>
@@ -60,6 +62,9 @@ struct fd_tracker {
 		uint64_t misses;
 		/* Failures to suspend or restore fs handles. */
 		uint64_t errors;
+		uint64_t suspensions;
+		uint64_t prefetches;
+		uint64_t prefetch_hits;
 	} stats;
 	/*
 	 * The head of the active_handles list is always the least recently
@@ -108,6 +113,10 @@ struct fs_handle_tracked {
 	bool in_use;
 	/* Offset to which the file should be restored. */
 	off_t offset;
+	/* Monotonic time of the last use of the handle, or of its creation. */
+	uint64_t last_use_ns;
+	/* Restored by fd_tracker_prefetch_handles() and not used since. */
+	bool prefetched;
 	struct cds_list_head handles_list_node;
 };
 
@@ -146,6 +155,7 @@ static int fs_handle_tracked_restore(struct fs_handle_tracked *handle);
 static int fs_handle_tracked_get_fd(struct fs_handle *_handle);
 static void fs_handle_tracked_put_fd(struct fs_handle *_handle);
 static int fs_handle_tracked_unlink(struct fs_handle *_handle);
+static int fs_handle_tracked_rename(struct fs_handle *_handle, const char *new_path);
 static int fs_handle_tracked_close(struct fs_handle *_handle);
 
 static void fd_tracker_track(struct fd_tracker *tracker, struct fs_handle_tracked *handle);
@@ -153,6 +163,18 @@ static void fd_tracker_untrack(struct fd_tracker *tracker, struct fs_handle_trac
 static int fd_tracker_suspend_handles(struct fd_tracker *tracker, unsigned int count);
 static int fd_tracker_restore_handle(struct fd_tracker *tracker, struct fs_handle_tracked *handle);
 
+static uint64_t now_ns()
+{
+	struct timespec now;
+
+	if (lttng_clock_gettime(CLOCK_MONOTONIC, &now)) {
+		PERROR("Failed to sample the monotonic clock");
+		return 0;
+	}
+
+	return (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
 /* Match function of the tracker's unsuspendable_fds hash table. */
 static int match_fd(struct cds_lfht_node *node, const void *key)
 {
@@ -267,6 +289,8 @@ static int fs_handle_tracked_suspend(struct fs_handle_tracked *handle)
 	    handle->fd,
 	    handle->offset);
 	handle->fd = -1;
+	handle->prefetched = false;
+	handle->tracker->stats.suspensions++;
 end:
 	if (ret) {
 		handle->tracker->stats.errors++;
@@ -394,6 +418,31 @@ error:
 	return nullptr;
 }
 
+void fd_tracker_get_stats(struct fd_tracker *tracker, struct fd_tracker_stats *stats)
+{
+	pthread_mutex_lock(&tracker->lock);
+	stats->uses = tracker->stats.uses;
+	stats->misses = tracker->stats.misses;
+	stats->errors = tracker->stats.errors;
+	stats->suspensions = tracker->stats.suspensions;
+	stats->prefetches = tracker->stats.prefetches;
+	stats->prefetch_hits = tracker->stats.prefetch_hits;
+	stats->lru_idle_ns = 0;
+	if (!cds_list_empty(&tracker->active_handles)) {
+		const struct fs_handle_tracked *lru_handle = cds_list_first_entry(
+			&tracker->active_handles, struct fs_handle_tracked, handles_list_node);
+		const uint64_t now = now_ns();
+
+		if (now > lru_handle->last_use_ns) {
+			stats->lru_idle_ns = now - lru_handle->last_use_ns;
+		}
+	}
+	stats->active = ACTIVE_COUNT(tracker);
+	stats->suspended = SUSPENDED_COUNT(tracker);
+	stats->capacity = tracker->capacity;
+	pthread_mutex_unlock(&tracker->lock);
+}
+
 void fd_tracker_log(struct fd_tracker *tracker)
 {
 	struct fs_handle_tracked *handle;
@@ -406,6 +455,9 @@ void fd_tracker_log(struct fd_tracker *tracker)
 	DBG_NO_LOC("    uses:            %" PRIu64, tracker->stats.uses);
 	DBG_NO_LOC("    misses:          %" PRIu64, tracker->stats.misses);
 	DBG_NO_LOC("    errors:          %" PRIu64, tracker->stats.errors);
+	DBG_NO_LOC("    suspensions:     %" PRIu64, tracker->stats.suspensions);
+	DBG_NO_LOC("    prefetches:      %" PRIu64, tracker->stats.prefetches);
+	DBG_NO_LOC("    prefetch hits:   %" PRIu64, tracker->stats.prefetch_hits);
 	DBG_NO_LOC("  Tracked:           %u", TRACKED_COUNT(tracker));
 	DBG_NO_LOC("    active:          %u", ACTIVE_COUNT(tracker));
 	DBG_NO_LOC("      suspendable:   %u", SUSPENDABLE_COUNT(tracker));
@@ -522,6 +574,7 @@ struct fs_handle *fd_tracker_open_fs_handle(struct fd_tracker *tracker,
 		.get_fd = fs_handle_tracked_get_fd,
 		.put_fd = fs_handle_tracked_put_fd,
 		.unlink = fs_handle_tracked_unlink,
+		.rename = fs_handle_tracked_rename,
 		.close = fs_handle_tracked_close,
 	};
 
@@ -553,6 +606,7 @@ struct fs_handle *fd_tracker_open_fs_handle(struct fd_tracker *tracker,
 		goto error;
 	}
 	handle->ino = fd_stat.st_ino;
+	handle->last_use_ns = now_ns();
 
 	fd_tracker_track(tracker, handle);
 end:
@@ -775,6 +829,81 @@ static void fd_tracker_untrack(struct fd_tracker *tracker, struct fs_handle_trac
 	cds_list_del(&handle->handles_list_node);
 }
 
+/*
+ * Track a restored handle among the active handles according to its last
+ * use rather than as the most recently used one.
+ *
+ * Caller must have taken the tracker's and handle's locks.
+ */
+static void fd_tracker_track_restored(struct fd_tracker *tracker,
+				      struct fs_handle_tracked *handle)
+{
+	struct fs_handle_tracked *iter;
+
+	LTTNG_ASSERT(handle->fd >= 0);
+	tracker->count.suspendable.active++;
+	cds_list_for_each_entry_reverse (iter, &tracker->active_handles, handles_list_node) {
+		if (iter->last_use_ns <= handle->last_use_ns) {
+			/* Insert after the last handle used before it. */
+			cds_list_add(&handle->handles_list_node, &iter->handles_list_node);
+			return;
+		}
+	}
+
+	cds_list_add(&handle->handles_list_node, &tracker->active_handles);
+}
+
+unsigned int fd_tracker_prefetch_handles(struct fd_tracker *tracker,
+					 unsigned int max_count,
+					 uint64_t max_idle_ns)
+{
+	unsigned int restored_count = 0;
+	struct cds_list_head *node, *prev;
+	const uint64_t now = now_ns();
+
+	pthread_mutex_lock(&tracker->lock);
+	/*
+	 * The least recently used handles being suspended first, the most
+	 * recently suspended handles are the most recently used ones.
+	 */
+	cds_list_for_each_prev_safe (node, prev, &tracker->suspended_handles) {
+		int ret;
+		struct fs_handle_tracked *handle =
+			cds_list_entry(node, struct fs_handle_tracked, handles_list_node);
+
+		if (restored_count == max_count || ACTIVE_COUNT(tracker) >= tracker->capacity) {
+			break;
+		}
+
+		pthread_mutex_lock(&handle->lock);
+		if (now > handle->last_use_ns && now - handle->last_use_ns > max_idle_ns) {
+			/* The handles suspended before were not used more recently. */
+			pthread_mutex_unlock(&handle->lock);
+			break;
+		}
+
+		fd_tracker_untrack(tracker, handle);
+		ret = fs_handle_tracked_restore(handle);
+		if (ret) {
+			tracker->stats.errors++;
+			fd_tracker_track(tracker, handle);
+		} else {
+			handle->prefetched = true;
+			tracker->stats.prefetches++;
+			fd_tracker_track_restored(tracker, handle);
+			restored_count++;
+		}
+		pthread_mutex_unlock(&handle->lock);
+	}
+	pthread_mutex_unlock(&tracker->lock);
+
+	if (restored_count) {
+		DBG("Prefetched %u suspended filesystem handles", restored_count);
+	}
+
+	return restored_count;
+}
+
 /* Caller must have taken the tracker's and handle's locks. */
 static int fd_tracker_restore_handle(struct fd_tracker *tracker, struct fs_handle_tracked *handle)
 {
@@ -815,7 +944,13 @@ static int fs_handle_tracked_get_fd(struct fs_handle *_handle)
 	LTTNG_ASSERT(!handle->in_use);
 
 	handle->tracker->stats.uses++;
+	handle->last_use_ns = now_ns();
 	if (handle->fd >= 0) {
+		if (handle->prefetched) {
+			handle->tracker->stats.prefetch_hits++;
+			handle->prefetched = false;
+		}
+
 		ret = handle->fd;
 		/* Mark as most recently used. */
 		fd_tracker_untrack(handle->tracker, handle);
@@ -859,6 +994,27 @@ static int fs_handle_tracked_unlink(struct fs_handle *_handle)
 	return ret;
 }
 
+static int fs_handle_tracked_rename(struct fs_handle *_handle, const char *new_path)
+{
+	int ret;
+	const char *path;
+	struct lttng_directory_handle *directory_handle;
+	struct fs_handle_tracked *handle =
+		lttng::utils::container_of(_handle, &fs_handle_tracked::parent);
+
+	pthread_mutex_lock(&handle->tracker->lock);
+	pthread_mutex_lock(&handle->lock);
+	/* The inode keeps its location up to date to restore the suspended handles. */
+	directory_handle = lttng_inode_get_location_directory_handle(handle->inode);
+	lttng_inode_borrow_location(handle->inode, nullptr, &path);
+	ret = lttng_inode_rename(
+		handle->inode, directory_handle, path, directory_handle, new_path, true);
+	lttng_directory_handle_put(directory_handle);
+	pthread_mutex_unlock(&handle->lock);
+	pthread_mutex_unlock(&handle->tracker->lock);
+	return ret;
+}
+
 static int fs_handle_tracked_close(struct fs_handle *_handle)
 {
 	int ret = 0;
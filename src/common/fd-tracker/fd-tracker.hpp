@@ -17,6 +17,31 @@
 struct fs_handle;
 struct fd_tracker;
 
+struct fd_tracker_stats {
+	/* Uses of fs handles. */
+	uint64_t uses;
+	/* Uses of fs handles which had to be restored. */
+	uint64_t misses;
+	/* Failures to suspend or restore fs handles. */
+	uint64_t errors;
+	/* Fs handles suspended to stay within the capacity of the tracker. */
+	uint64_t suspensions;
+	/* Fs handles restored ahead of their use, see fd_tracker_prefetch_handles(). */
+	uint64_t prefetches;
+	/* Uses of fs handles which were prefetched. */
+	uint64_t prefetch_hits;
+	/*
+	 * Time since the last use of the least recently used active fs handle,
+	 * the next one to be suspended, 0 if there is none.
+	 */
+	uint64_t lru_idle_ns;
+	/* Tracked file descriptors currently open. */
+	unsigned int active;
+	/* Fs handles currently suspended. */
+	unsigned int suspended;
+	unsigned int capacity;
+};
+
 /*
  * Callback which returns a file descriptor to track through the fd
  * tracker. This callback must not make use of the fd_tracker as a deadlock
@@ -130,6 +155,27 @@ int fd_tracker_open_unsuspendable_fd(struct fd_tracker *tracker,
 int fd_tracker_close_unsuspendable_fd(
 	struct fd_tracker *tracker, int *fds, unsigned int fd_count, fd_close_cb close, void *data);
 
+/*
+ * Restore, ahead of their next use, up to `max_count` suspended fs handles
+ * which were used within the last `max_idle_ns` nanoseconds, most recently
+ * used first.
+ *
+ * Only the capacity left unused by the tracker is used: no fs handle is
+ * suspended to make room for the restored ones. A restored fs handle keeps
+ * its place in the least recently used order; it is suspended again before
+ * the handles used after it.
+ *
+ * Returns the number of restored fs handles.
+ */
+unsigned int fd_tracker_prefetch_handles(struct fd_tracker *tracker,
+					 unsigned int max_count,
+					 uint64_t max_idle_ns);
+
+/*
+ * Sample the statistics of the fd_tracker.
+ */
+void fd_tracker_get_stats(struct fd_tracker *tracker, struct fd_tracker_stats *stats);
+
 /*
  * Log the contents of the fd_tracker.
  */
@@ -96,6 +96,14 @@ int main(int argc, char **argv)
 			goto parse_error;
 		}
 		printf("done\n");
+
+		printf("Optimizing IR... ");
+		fflush(stdout);
+		ret = filter_visitor_ir_optimize(ctx);
+		if (ret) {
+			goto parse_error;
+		}
+		printf("done\n");
 	}
 	if (generate_bytecode) {
 		printf("Generating bytecode... ");
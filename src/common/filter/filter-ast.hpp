@@ -180,6 +180,7 @@ static inline struct filter_ast *filter_parser_get_ast(struct filter_parser_ctx
 int filter_visitor_print_xml(struct filter_parser_ctx *ctx, FILE *stream, int indent);
 int filter_visitor_ir_generate(struct filter_parser_ctx *ctx);
 void filter_ir_free(struct filter_parser_ctx *ctx);
+void filter_ir_op_free(struct ir_op *op);
 int filter_visitor_bytecode_generate(struct filter_parser_ctx *ctx);
 void filter_bytecode_free(struct filter_parser_ctx *ctx);
 int filter_visitor_ir_check_binary_op_nesting(struct filter_parser_ctx *ctx);
@@ -187,5 +188,6 @@ int filter_visitor_ir_check_binary_comparator(struct filter_parser_ctx *ctx);
 int filter_visitor_ir_validate_string(struct filter_parser_ctx *ctx);
 int filter_visitor_ir_normalize_glob_patterns(struct filter_parser_ctx *ctx);
 int filter_visitor_ir_validate_globbing(struct filter_parser_ctx *ctx);
+int filter_visitor_ir_optimize(struct filter_parser_ctx *ctx);
 
 #endif /* _FILTER_AST_H */
@@ -845,6 +845,11 @@ generate_ir_recursive(struct filter_parser_ctx *ctx, struct filter_node *node, e
 	return 0;
 }
 
+void filter_ir_op_free(struct ir_op *op)
+{
+	filter_free_ir_recursive(op);
+}
+
 void filter_ir_free(struct filter_parser_ctx *ctx)
 {
 	filter_free_ir_recursive(ctx->ir_root);
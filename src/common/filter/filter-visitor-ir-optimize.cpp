@@ -0,0 +1,572 @@
+/*
+ * filter-visitor-ir-optimize.cpp
+ *
+ * LTTng filter IR optimization
+ *
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include "filter-ast.hpp"
+#include "filter-ir.hpp"
+#include "filter-parser.hpp"
+
+#include <common/compat/errno.hpp>
+#include <common/macros.hpp>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <iterator>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/*
+ * The interpreters of the tracers stop evaluating the filter of an event
+ * on the first error (e.g. a string field compared to a number) and discard
+ * the event. The transformations below never drop an operand that the
+ * original expression evaluates, except where a false result would discard
+ * the event anyway, so that the same events are recorded.
+ */
+enum optimize_context {
+	/* The value of the node is used, e.g. as the operand of a comparison. */
+	CONTEXT_VALUE,
+	/* Only the truth value of the node is used, by a logical not. */
+	CONTEXT_TRUTH,
+	/* Operand of a logical operator, which casts it to s64 first. */
+	CONTEXT_LOGICAL_OPERAND,
+	/* Result of the filter: a false result or an error discards the event. */
+	CONTEXT_FILTER_RESULT,
+};
+
+static int optimize_recursive(struct ir_op **op_p, enum optimize_context context);
+
+static bool is_numeric_constant(const struct ir_op *op)
+{
+	return op->op == IR_OP_LOAD && op->data_type == IR_DATA_NUMERIC;
+}
+
+static bool is_constant(const struct ir_op *op)
+{
+	return op->op == IR_OP_LOAD &&
+		(op->data_type == IR_DATA_NUMERIC || op->data_type == IR_DATA_FLOAT);
+}
+
+static double constant_as_double(const struct ir_op *op)
+{
+	return op->data_type == IR_DATA_FLOAT ? op->u.load.u.flt : (double) op->u.load.u.num;
+}
+
+static bool is_comparison(enum op_type type)
+{
+	switch (type) {
+	case AST_OP_EQ:
+	case AST_OP_NE:
+	case AST_OP_GT:
+	case AST_OP_LT:
+	case AST_OP_GE:
+	case AST_OP_LE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Whether the evaluation of a node yields a s64, as a logical operator would. */
+static bool is_s64_valued(const struct ir_op *op)
+{
+	switch (op->op) {
+	case IR_OP_LOAD:
+		return op->data_type == IR_DATA_NUMERIC;
+	case IR_OP_UNARY:
+		return op->u.unary.type == AST_UNARY_NOT;
+	case IR_OP_BINARY:
+	case IR_OP_LOGICAL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Whether a logical operator can be replaced by one of its operands. */
+static bool can_replace_logical_by(const struct ir_op *operand, enum optimize_context context)
+{
+	switch (context) {
+	case CONTEXT_LOGICAL_OPERAND:
+		return true;
+	case CONTEXT_TRUTH:
+	case CONTEXT_FILTER_RESULT:
+		return is_s64_valued(operand);
+	case CONTEXT_VALUE:
+	default:
+		return false;
+	}
+}
+
+/* Free the children of a node and turn it into a constant load. */
+static void set_numeric_constant(struct ir_op *op, int64_t value)
+{
+	switch (op->op) {
+	case IR_OP_UNARY:
+		filter_ir_op_free(op->u.unary.child);
+		break;
+	case IR_OP_BINARY:
+		filter_ir_op_free(op->u.binary.left);
+		filter_ir_op_free(op->u.binary.right);
+		break;
+	case IR_OP_LOGICAL:
+		filter_ir_op_free(op->u.logical.left);
+		filter_ir_op_free(op->u.logical.right);
+		break;
+	default:
+		break;
+	}
+
+	op->op = IR_OP_LOAD;
+	op->data_type = IR_DATA_NUMERIC;
+	op->signedness = IR_SIGNED;
+	memset(&op->u, 0, sizeof(op->u));
+	op->u.load.u.num = value;
+}
+
+/* Replace a node by one of its descendants, detached from it beforehand. */
+static void replace_op(struct ir_op **op_p, struct ir_op *replacement)
+{
+	replacement->side = (*op_p)->side;
+	filter_ir_op_free(*op_p);
+	*op_p = replacement;
+}
+
+static bool load_expressions_equal(const struct ir_load_expression *a,
+				   const struct ir_load_expression *b)
+{
+	const struct ir_load_expression_op *op_a = a->child, *op_b = b->child;
+
+	for (; op_a && op_b; op_a = op_a->next, op_b = op_b->next) {
+		if (op_a->type != op_b->type) {
+			return false;
+		}
+
+		switch (op_a->type) {
+		case IR_LOAD_EXPRESSION_GET_SYMBOL:
+			if (strcmp(op_a->u.symbol, op_b->u.symbol) != 0) {
+				return false;
+			}
+			break;
+		case IR_LOAD_EXPRESSION_GET_INDEX:
+			if (op_a->u.index != op_b->u.index) {
+				return false;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return !op_a && !op_b;
+}
+
+static bool ir_ops_equal(const struct ir_op *a, const struct ir_op *b)
+{
+	if (a->op != b->op || a->data_type != b->data_type) {
+		return false;
+	}
+
+	switch (a->op) {
+	case IR_OP_LOAD:
+		switch (a->data_type) {
+		case IR_DATA_STRING:
+			return a->u.load.u.string.type == b->u.load.u.string.type &&
+				strcmp(a->u.load.u.string.value, b->u.load.u.string.value) == 0;
+		case IR_DATA_NUMERIC:
+			return a->u.load.u.num == b->u.load.u.num;
+		case IR_DATA_FLOAT:
+			return memcmp(&a->u.load.u.flt, &b->u.load.u.flt, sizeof(double)) == 0;
+		case IR_DATA_FIELD_REF:
+		case IR_DATA_GET_CONTEXT_REF:
+			return strcmp(a->u.load.u.ref, b->u.load.u.ref) == 0;
+		case IR_DATA_EXPRESSION:
+			return load_expressions_equal(a->u.load.u.expression,
+						      b->u.load.u.expression);
+		default:
+			return false;
+		}
+	case IR_OP_UNARY:
+		return a->u.unary.type == b->u.unary.type &&
+			ir_ops_equal(a->u.unary.child, b->u.unary.child);
+	case IR_OP_BINARY:
+		return a->u.binary.type == b->u.binary.type &&
+			ir_ops_equal(a->u.binary.left, b->u.binary.left) &&
+			ir_ops_equal(a->u.binary.right, b->u.binary.right);
+	case IR_OP_LOGICAL:
+		return a->u.logical.type == b->u.logical.type &&
+			ir_ops_equal(a->u.logical.left, b->u.logical.left) &&
+			ir_ops_equal(a->u.logical.right, b->u.logical.right);
+	default:
+		return false;
+	}
+}
+
+/*
+ * Rough relative cost of the evaluation of a node by the interpreter: the
+ * string comparisons, and more so the globbing ones, are more expensive than
+ * the integer comparisons, which cost about as much as a field load.
+ */
+static unsigned int evaluation_cost(const struct ir_op *op)
+{
+	switch (op->op) {
+	case IR_OP_LOAD:
+		switch (op->data_type) {
+		case IR_DATA_NUMERIC:
+		case IR_DATA_FLOAT:
+			return 0;
+		case IR_DATA_STRING:
+			return op->u.load.u.string.type == IR_LOAD_STRING_TYPE_GLOB_STAR ? 16 : 8;
+		case IR_DATA_EXPRESSION:
+		{
+			const struct ir_load_expression_op *exp_op = op->u.load.u.expression->child;
+			unsigned int cost = 0;
+
+			/* One instruction per step of the load expression. */
+			for (; exp_op; exp_op = exp_op->next) {
+				cost++;
+			}
+
+			return cost;
+		}
+		default:
+			return 1;
+		}
+	case IR_OP_UNARY:
+		return 1 + evaluation_cost(op->u.unary.child);
+	case IR_OP_BINARY:
+		return 1 + evaluation_cost(op->u.binary.left) + evaluation_cost(op->u.binary.right);
+	case IR_OP_LOGICAL:
+		return 1 + evaluation_cost(op->u.logical.left) +
+			evaluation_cost(op->u.logical.right);
+	default:
+		return 1;
+	}
+}
+
+static int fold_unary(struct ir_op **op_p)
+{
+	struct ir_op *op = *op_p;
+	struct ir_op *child = op->u.unary.child;
+
+	if (op->u.unary.type == AST_UNARY_PLUS) {
+		/* No instruction is generated for a unary plus. */
+		op->u.unary.child = NULL;
+		replace_op(op_p, child);
+		return 0;
+	}
+
+	if (!is_constant(child)) {
+		return 0;
+	}
+
+	switch (op->u.unary.type) {
+	case AST_UNARY_MINUS:
+		if (child->data_type == IR_DATA_FLOAT) {
+			child->u.load.u.flt = -child->u.load.u.flt;
+		} else {
+			/* Wraps around, as the interpreter does. */
+			child->u.load.u.num = (int64_t) (0 - (uint64_t) child->u.load.u.num);
+		}
+
+		op->u.unary.child = NULL;
+		replace_op(op_p, child);
+		break;
+	case AST_UNARY_NOT:
+		set_numeric_constant(op, constant_as_double(child) == 0);
+		break;
+	case AST_UNARY_BIT_NOT:
+		if (child->data_type == IR_DATA_NUMERIC) {
+			set_numeric_constant(op, ~child->u.load.u.num);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static int fold_binary(struct ir_op *op)
+{
+	const struct ir_op *left = op->u.binary.left, *right = op->u.binary.right;
+	int64_t value;
+
+	if (!is_constant(left) || !is_constant(right)) {
+		return 0;
+	}
+
+	if (is_comparison(op->u.binary.type)) {
+		bool result;
+
+		if (is_numeric_constant(left) && is_numeric_constant(right)) {
+			const int64_t l = left->u.load.u.num, r = right->u.load.u.num;
+
+			result = op->u.binary.type == AST_OP_EQ ? l == r :
+				op->u.binary.type == AST_OP_NE	? l != r :
+				op->u.binary.type == AST_OP_GT	? l > r :
+				op->u.binary.type == AST_OP_LT	? l < r :
+				op->u.binary.type == AST_OP_GE	? l >= r :
+									  l <= r;
+		} else {
+			/* The interpreter compares a mix of integers and doubles as doubles. */
+			const double l = constant_as_double(left), r = constant_as_double(right);
+
+			result = op->u.binary.type == AST_OP_EQ ? l == r :
+				op->u.binary.type == AST_OP_NE	? l != r :
+				op->u.binary.type == AST_OP_GT	? l > r :
+				op->u.binary.type == AST_OP_LT	? l < r :
+				op->u.binary.type == AST_OP_GE	? l >= r :
+									  l <= r;
+		}
+
+		set_numeric_constant(op, result);
+		return 0;
+	}
+
+	/* Bitwise operators only apply to integers. */
+	if (!is_numeric_constant(left) || !is_numeric_constant(right)) {
+		return 0;
+	}
+
+	switch (op->u.binary.type) {
+	case AST_OP_BIT_AND:
+		value = left->u.load.u.num & right->u.load.u.num;
+		break;
+	case AST_OP_BIT_OR:
+		value = left->u.load.u.num | right->u.load.u.num;
+		break;
+	case AST_OP_BIT_XOR:
+		value = left->u.load.u.num ^ right->u.load.u.num;
+		break;
+	case AST_OP_BIT_RSHIFT:
+	case AST_OP_BIT_LSHIFT:
+		/* The interpreter fails on such shifts: leave them to it. */
+		if (right->u.load.u.num < 0 || right->u.load.u.num >= 64) {
+			return 0;
+		}
+
+		value = (int64_t) (op->u.binary.type == AST_OP_BIT_RSHIFT ?
+					   (uint64_t) left->u.load.u.num >> right->u.load.u.num :
+					   (uint64_t) left->u.load.u.num << right->u.load.u.num);
+		break;
+	default:
+		return 0;
+	}
+
+	set_numeric_constant(op, value);
+	return 0;
+}
+
+/*
+ * Gather the operands of a chain of logical operators of the same type, e.g.
+ * `a && (b && c) && d`, in evaluation order, along with the operator nodes,
+ * `top` first.
+ */
+static void collect_chain(struct ir_op *op,
+			  enum op_type type,
+			  std::vector<struct ir_op *>& operands,
+			  std::vector<struct ir_op *>& operators)
+{
+	if (op->op != IR_OP_LOGICAL || op->u.logical.type != type) {
+		operands.push_back(op);
+		return;
+	}
+
+	operators.push_back(op);
+	collect_chain(op->u.logical.left, type, operands, operators);
+	collect_chain(op->u.logical.right, type, operands, operators);
+}
+
+/*
+ * Simplify a chain of logical operators:
+ *
+ *   - Remove the operands which are the same as a previous one: the second
+ *     evaluation of an operand yields the same result as the first.
+ *
+ *   - In the result of the filter, evaluate the cheap operands of a chain of
+ *     `&&` first: the event is discarded unless all of them are true and
+ *     none of them fails, whatever the order.
+ *
+ *   - Remove the constants which don't decide the result (true for `&&`,
+ *     false for `||`) and the operands following a constant which does.
+ */
+static int optimize_logical_chain(struct ir_op **op_p, enum optimize_context context)
+{
+	struct ir_op *top = *op_p;
+	const enum op_type type = top->u.logical.type;
+	/* Value of the constants which decide the result of the chain. */
+	const int64_t deciding_value = type == AST_OP_AND ? 0 : 1;
+	std::vector<struct ir_op *> operands, operators, kept;
+
+	collect_chain(top, type, operands, operators);
+
+	for (auto *operand : operands) {
+		const bool duplicate = std::any_of(
+			kept.begin(), kept.end(), [operand](const struct ir_op *kept_operand) {
+				return ir_ops_equal(kept_operand, operand);
+			});
+
+		if (!duplicate) {
+			kept.push_back(operand);
+		}
+	}
+
+	if (context == CONTEXT_FILTER_RESULT && type == AST_OP_AND) {
+		std::stable_sort(kept.begin(),
+				 kept.end(),
+				 [](const struct ir_op *a, const struct ir_op *b) {
+					 return evaluation_cost(a) < evaluation_cost(b);
+				 });
+	}
+
+	for (auto it = kept.begin(); it != kept.end();) {
+		if (!is_numeric_constant(*it)) {
+			it++;
+			continue;
+		}
+
+		if (((*it)->u.load.u.num != 0) != (deciding_value != 0)) {
+			it = kept.erase(it);
+			continue;
+		}
+
+		/* The rest of the chain is never evaluated. */
+		kept.erase(std::next(it), kept.end());
+		break;
+	}
+
+	/*
+	 * An operand alone is only cast to s64, as it is by a logical
+	 * operator, when used as an operand of another one, unless it already
+	 * yields a s64.
+	 */
+	if (kept.size() == 1 && !can_replace_logical_by(kept[0], context)) {
+		return 0;
+	}
+
+	for (auto *operand : operands) {
+		if (std::find(kept.begin(), kept.end(), operand) == kept.end()) {
+			filter_ir_op_free(operand);
+		}
+	}
+
+	for (auto *logical_op : operators) {
+		logical_op->u.logical.left = NULL;
+		logical_op->u.logical.right = NULL;
+	}
+
+	if (kept.empty()) {
+		/* Only constants which don't decide the result: turn the top node into one. */
+		for (auto it = std::next(operators.begin()); it != operators.end(); it++) {
+			filter_ir_op_free(*it);
+		}
+
+		set_numeric_constant(top, !deciding_value);
+		return 0;
+	}
+
+	if (kept.size() == 1) {
+		for (auto it = std::next(operators.begin()); it != operators.end(); it++) {
+			filter_ir_op_free(*it);
+		}
+
+		replace_op(op_p, kept[0]);
+		return 0;
+	}
+
+	/* Rebuild the chain from the left, the top operator node last. */
+	struct ir_op *chain = kept[0];
+
+	for (size_t i = 1; i < kept.size(); i++) {
+		struct ir_op *logical_op = operators[kept.size() - 1 - i];
+
+		logical_op->u.logical.left = chain;
+		logical_op->u.logical.right = kept[i];
+		if (logical_op != top) {
+			logical_op->side = IR_LEFT;
+		}
+
+		chain = logical_op;
+	}
+
+	for (size_t i = kept.size() - 1; i < operators.size(); i++) {
+		filter_ir_op_free(operators[i]);
+	}
+
+	return 0;
+}
+
+static int optimize_recursive(struct ir_op **op_p, enum optimize_context context)
+{
+	struct ir_op *op = *op_p;
+	int ret;
+
+	switch (op->op) {
+	case IR_OP_UNKNOWN:
+	default:
+		fprintf(stderr, "[error] %s: unknown op type\n", __func__);
+		return -EINVAL;
+
+	case IR_OP_ROOT:
+		return optimize_recursive(&op->u.root.child, CONTEXT_FILTER_RESULT);
+	case IR_OP_LOAD:
+		return 0;
+	case IR_OP_UNARY:
+		ret = optimize_recursive(&op->u.unary.child,
+					 op->u.unary.type == AST_UNARY_NOT ? CONTEXT_TRUTH :
+									     CONTEXT_VALUE);
+		if (ret) {
+			return ret;
+		}
+
+		return fold_unary(op_p);
+	case IR_OP_BINARY:
+		ret = optimize_recursive(&op->u.binary.left, CONTEXT_VALUE);
+		if (ret) {
+			return ret;
+		}
+
+		ret = optimize_recursive(&op->u.binary.right, CONTEXT_VALUE);
+		if (ret) {
+			return ret;
+		}
+
+		return fold_binary(op);
+	case IR_OP_LOGICAL:
+		ret = optimize_recursive(&op->u.logical.left, CONTEXT_LOGICAL_OPERAND);
+		if (ret) {
+			return ret;
+		}
+
+		ret = optimize_recursive(&op->u.logical.right, CONTEXT_LOGICAL_OPERAND);
+		if (ret) {
+			return ret;
+		}
+
+		/* The value of a logical operator is only tested for its truth. */
+		if (context == CONTEXT_VALUE) {
+			return 0;
+		}
+
+		return optimize_logical_chain(op_p, context);
+	}
+}
+
+/*
+ * Fold the constant sub-expressions and simplify the logical operators of
+ * the IR, generating the same bytecode instructions as for an equivalent
+ * expression written by hand.
+ */
+int filter_visitor_ir_optimize(struct filter_parser_ctx *ctx)
+{
+	return optimize_recursive(&ctx->ir_root, CONTEXT_VALUE);
+}
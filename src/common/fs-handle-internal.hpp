@@ -21,12 +21,14 @@ struct fs_handle;
 using fs_handle_get_fd_cb = int (*)(struct fs_handle *);
 using fs_handle_put_fd_cb = void (*)(struct fs_handle *);
 using fs_handle_unlink_cb = int (*)(struct fs_handle *);
+using fs_handle_rename_cb = int (*)(struct fs_handle *, const char *);
 using fs_handle_close_cb = int (*)(struct fs_handle *);
 
 struct fs_handle {
 	fs_handle_get_fd_cb get_fd;
 	fs_handle_put_fd_cb put_fd;
 	fs_handle_unlink_cb unlink;
+	fs_handle_rename_cb rename;
 	fs_handle_close_cb close;
 };
 
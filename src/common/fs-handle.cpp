@@ -7,6 +7,7 @@
 
 #include <common/fs-handle-internal.hpp>
 #include <common/fs-handle.hpp>
+#include <common/io-hint.hpp>
 #include <common/readwrite.hpp>
 
 int fs_handle_get_fd(struct fs_handle *handle)
@@ -24,6 +25,11 @@ int fs_handle_unlink(struct fs_handle *handle)
 	return handle->unlink(handle);
 }
 
+int fs_handle_rename(struct fs_handle *handle, const char *new_path)
+{
+	return handle->rename(handle, new_path);
+}
+
 int fs_handle_close(struct fs_handle *handle)
 {
 	return handle->close(handle);
@@ -45,6 +51,22 @@ end:
 	return ret;
 }
 
+ssize_t fs_handle_pread(struct fs_handle *handle, void *buf, size_t count, off_t offset)
+{
+	ssize_t ret;
+	const int fd = fs_handle_get_fd(handle);
+
+	if (fd < 0) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng_pread(fd, buf, count, offset);
+	fs_handle_put_fd(handle);
+end:
+	return ret;
+}
+
 ssize_t fs_handle_write(struct fs_handle *handle, const void *buf, size_t count)
 {
 	ssize_t ret;
@@ -77,6 +99,38 @@ end:
 	return ret;
 }
 
+int fs_handle_preallocate(struct fs_handle *handle, off_t offset, off_t len)
+{
+	int ret;
+	const int fd = fs_handle_get_fd(handle);
+
+	if (fd < 0) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng::io::preallocate_range(fd, offset, len);
+	fs_handle_put_fd(handle);
+end:
+	return ret;
+}
+
+int fs_handle_trim_preallocation(struct fs_handle *handle)
+{
+	int ret;
+	const int fd = fs_handle_get_fd(handle);
+
+	if (fd < 0) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng::io::trim_preallocation(fd);
+	fs_handle_put_fd(handle);
+end:
+	return ret;
+}
+
 off_t fs_handle_seek(struct fs_handle *handle, off_t offset, int whence)
 {
 	off_t ret;
@@ -51,6 +51,15 @@ void fs_handle_put_fd(struct fs_handle *handle);
  */
 int fs_handle_unlink(struct fs_handle *handle);
 
+/*
+ * Rename the file associated to an fs_handle to `new_path`, relative to the
+ * same directory, atomically replacing the file found at `new_path`, if any.
+ *
+ * Returns 0 on success, otherwise a negative value will be returned
+ * if the operation failed.
+ */
+int fs_handle_rename(struct fs_handle *handle, const char *new_path);
+
 /*
  * Frees the handle and discards the underlying fd.
  */
@@ -58,10 +67,25 @@ int fs_handle_close(struct fs_handle *handle);
 
 ssize_t fs_handle_read(struct fs_handle *handle, void *buf, size_t count);
 
+/*
+ * Read `count` bytes at `offset` without using or changing the file offset of
+ * the handle.
+ */
+ssize_t fs_handle_pread(struct fs_handle *handle, void *buf, size_t count, off_t offset);
+
 ssize_t fs_handle_write(struct fs_handle *handle, const void *buf, size_t count);
 
 int fs_handle_truncate(struct fs_handle *handle, off_t offset);
 
+/*
+ * Reserve the blocks of a range of the file without changing its size, see
+ * lttng::io::preallocate_range().
+ */
+int fs_handle_preallocate(struct fs_handle *handle, off_t offset, off_t len);
+
+/* Release the blocks reserved past the end of the file by fs_handle_preallocate(). */
+int fs_handle_trim_preallocation(struct fs_handle *handle);
+
 off_t fs_handle_seek(struct fs_handle *handle, off_t offset, int whence);
 
 #endif /* FS_HANDLE_H */
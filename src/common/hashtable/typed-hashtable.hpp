@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_TYPED_HASHTABLE_H
+#define LTTNG_TYPED_HASHTABLE_H
+
+#include <common/hashtable/hashtable.hpp>
+#include <common/hashtable/utils.hpp>
+#include <common/macros.hpp>
+
+#include <stdint.h>
+#include <urcu/rculfhash.h>
+
+namespace lttng {
+namespace details {
+namespace ht {
+#ifdef LTTNG_HT_FAST_HASH
+/* Inline equivalent of hash_key_u64(). */
+inline unsigned long hash_u64(uint64_t key, unsigned long seed)
+{
+	return (unsigned long) hash_mix_u64(key, seed);
+}
+
+/* Inline equivalent of hash_key_ulong(). */
+inline unsigned long hash_ulong(unsigned long key, unsigned long seed)
+{
+	return hash_u64(key, seed);
+}
+#else /* LTTNG_HT_FAST_HASH */
+inline uint32_t rot(uint32_t x, unsigned int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+/* final() of the hash functions of utils.cpp. */
+inline void final_mix(uint32_t& a, uint32_t& b, uint32_t& c)
+{
+	c ^= b;
+	c -= rot(b, 14);
+	a ^= c;
+	a -= rot(c, 11);
+	b ^= a;
+	b -= rot(a, 25);
+	c ^= b;
+	c -= rot(b, 16);
+	a ^= c;
+	a -= rot(c, 4);
+	b ^= a;
+	b -= rot(a, 14);
+	c ^= b;
+	c -= rot(b, 24);
+}
+
+/* Inline equivalent of hash_key_u64(). */
+inline unsigned long hash_u64(uint64_t key, unsigned long seed)
+{
+	union {
+		uint64_t v64;
+		uint32_t v32[2];
+	} v, k;
+	uint32_t a, b, c;
+
+	v.v64 = (uint64_t) seed;
+	k.v64 = key;
+	a = b = c = 0xdeadbeef + (2 << 2) + v.v32[0];
+	c += v.v32[1];
+	b += k.v32[1];
+	a += k.v32[0];
+	final_mix(a, b, c);
+	v.v32[0] = c;
+	v.v32[1] = b;
+	return v.v64;
+}
+
+/* Inline equivalent of hash_key_ulong(). */
+inline unsigned long hash_ulong(unsigned long key, unsigned long seed)
+{
+#if (CAA_BITS_PER_LONG == 64)
+	return hash_u64(key, seed);
+#else
+	uint32_t a, b, c;
+
+	a = b = c = 0xdeadbeef + (1 << 2) + (uint32_t) seed;
+	a += (uint32_t) key;
+	final_mix(a, b, c);
+	return c;
+#endif /* CAA_BITS_PER_LONG */
+}
+#endif /* LTTNG_HT_FAST_HASH */
+} /* namespace ht */
+} /* namespace details */
+
+/*
+ * Hashing and matching of the keys of the nodes of an lttng_ht, consistent
+ * with the functions which lttng_ht_new() sets for its type.
+ */
+template <typename NodeType>
+struct ht_node_traits;
+
+template <>
+struct ht_node_traits<lttng_ht_node_u64> {
+	using key_type = uint64_t;
+
+	static unsigned long hash(key_type key, unsigned long seed)
+	{
+		return details::ht::hash_u64(key, seed);
+	}
+
+	static const void *lookup_key(const key_type& key)
+	{
+		return &key;
+	}
+
+	static bool match(const lttng_ht_node_u64& node, const void *lookup_key)
+	{
+		return node.key == *static_cast<const uint64_t *>(lookup_key);
+	}
+
+	static bool table_is_compatible(const lttng_ht& table)
+	{
+		return table.hash_fct == hash_key_u64;
+	}
+};
+
+template <>
+struct ht_node_traits<lttng_ht_node_ulong> {
+	using key_type = unsigned long;
+
+	static unsigned long hash(key_type key, unsigned long seed)
+	{
+		return details::ht::hash_ulong(key, seed);
+	}
+
+	/* The ulong tables pass the key itself, not its address. */
+	static const void *lookup_key(const key_type& key)
+	{
+		return (const void *) key;
+	}
+
+	static bool match(const lttng_ht_node_ulong& node, const void *lookup_key)
+	{
+		return node.key == (unsigned long) lookup_key;
+	}
+
+	static bool table_is_compatible(const lttng_ht& table)
+	{
+		return table.hash_fct == hash_key_ulong;
+	}
+};
+
+/*
+ * Typed view of an lttng_ht whose elements of type `ElementType` are linked
+ * by their `node_member` node.
+ *
+ * The lookups hash the key inline and match it against the node directly,
+ * rather than through the hash and match function pointers of the table and
+ * the lttng_ht_iter and container_of() steps of their callers. The elements are
+ * still added and removed through the lttng_ht functions.
+ */
+template <typename NodeType, typename ElementType, NodeType ElementType::*node_member>
+class ht {
+public:
+	using traits = ht_node_traits<NodeType>;
+	using key_type = typename traits::key_type;
+
+	explicit ht(lttng_ht& table) noexcept : _table(table)
+	{
+		LTTNG_ASSERT(_table.ht);
+		LTTNG_ASSERT(traits::table_is_compatible(_table));
+	}
+
+	/*
+	 * Find the element of a key, or nullptr if there is none.
+	 *
+	 * The RCU read-side lock must be held for as long as the returned
+	 * element is used.
+	 */
+	ElementType *find(key_type key) const noexcept
+	{
+		struct cds_lfht_iter iter;
+
+		cds_lfht_lookup(_table.ht,
+				traits::hash(key, lttng_ht_seed),
+				_match,
+				traits::lookup_key(key),
+				&iter);
+
+		const auto lfht_node = cds_lfht_iter_get_node(&iter);
+		return lfht_node ? _element(lfht_node) : nullptr;
+	}
+
+private:
+	static ElementType *_element(struct cds_lfht_node *lfht_node) noexcept
+	{
+		return lttng::utils::container_of(_node(lfht_node), node_member);
+	}
+
+	static NodeType *_node(struct cds_lfht_node *lfht_node) noexcept
+	{
+		return lttng::utils::container_of(lfht_node, &NodeType::node);
+	}
+
+	static int _match(struct cds_lfht_node *lfht_node, const void *lookup_key)
+	{
+		return traits::match(*_node(lfht_node), lookup_key);
+	}
+
+	lttng_ht& _table;
+};
+} /* namespace lttng */
+
+#endif /* LTTNG_TYPED_HASHTABLE_H */
@@ -527,6 +527,7 @@ __attribute__((unused)) static uint32_t hashlittle(const void *key, size_t lengt
 	return c;
 }
 
+#ifndef LTTNG_HT_FAST_HASH
 unsigned long hash_key_u64(const void *_key, unsigned long seed)
 {
 	union {
@@ -575,6 +576,106 @@ unsigned long hash_key_str(const void *key, unsigned long seed)
 	return hashlittle(key, strlen((const char *) key), seed);
 }
 
+/*
+ * Hash function for a buffer of `length` bytes.
+ */
+unsigned long hash_buffer(const void *buffer, size_t length, unsigned long seed)
+{
+	return hashlittle(buffer, length, seed);
+}
+#else /* LTTNG_HT_FAST_HASH */
+unsigned long hash_key_u64(const void *_key, unsigned long seed)
+{
+	return (unsigned long) hash_mix_u64(*(const uint64_t *) _key, seed);
+}
+
+/*
+ * Hash function for number value.
+ * Pass the value itself as the key, not its address.
+ */
+unsigned long hash_key_ulong(const void *_key, unsigned long seed)
+{
+	return (unsigned long) hash_mix_u64((uint64_t) (unsigned long) _key, seed);
+}
+
+/*
+ * Multiply `a` by `b` and fold the 128-bit product into 64 bits.
+ */
+static inline uint64_t hash_mul_fold(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+	const __uint128_t product = (__uint128_t) a * b;
+
+	return (uint64_t) product ^ (uint64_t) (product >> 64);
+#else
+	const uint64_t a_low = (uint32_t) a, a_high = a >> 32;
+	const uint64_t b_low = (uint32_t) b, b_high = b >> 32;
+	const uint64_t low_low = a_low * b_low, low_high = a_low * b_high;
+	const uint64_t high_low = a_high * b_low, high_high = a_high * b_high;
+	const uint64_t middle = (low_low >> 32) + (uint32_t) low_high + (uint32_t) high_low;
+	const uint64_t low = (middle << 32) | (uint32_t) low_low;
+	const uint64_t high = high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32);
+
+	return low ^ high;
+#endif /* __SIZEOF_INT128__ */
+}
+
+/*
+ * Load the last 1 to 8 bytes of a string, of which there are `length`, in a
+ * word, with overlapping fixed-size loads rather than a byte loop.
+ */
+static inline uint64_t hash_load_tail(const char *str, size_t length)
+{
+	uint32_t low, high;
+
+	if (length < 4) {
+		return ((uint64_t) (uint8_t) str[0] << 16) |
+			((uint64_t) (uint8_t) str[length >> 1] << 8) | (uint8_t) str[length - 1];
+	}
+
+	memcpy(&low, str, sizeof(low));
+	memcpy(&high, str + length - sizeof(high), sizeof(high));
+	return ((uint64_t) high << 32) | low;
+}
+
+/*
+ * Hash function for a buffer of `length` bytes.
+ *
+ * Fold the buffer in the hash a word at a time, then mix the hash with the
+ * seed.
+ */
+unsigned long hash_buffer(const void *buffer, size_t length, unsigned long seed)
+{
+	const char *str = (const char *) buffer;
+	uint64_t hash = (uint64_t) length * 0x9e3779b97f4a7c15ULL;
+	uint64_t word;
+
+	while (length > sizeof(word)) {
+		memcpy(&word, str, sizeof(word));
+		hash = hash_mul_fold(hash ^ word, 0xff51afd7ed558ccdULL);
+		str += sizeof(word);
+		length -= sizeof(word);
+	}
+
+	if (length) {
+		hash = hash_mul_fold(hash ^ hash_load_tail(str, length), 0xc4ceb9fe1a85ec53ULL);
+	}
+
+	return (unsigned long) hash_mix_u64(hash, seed);
+}
+
+/*
+ * Hash function for string.
+ *
+ * Find the length of the string with strlen(), which the C library vectorizes,
+ * before hashing it a word at a time.
+ */
+unsigned long hash_key_str(const void *key, unsigned long seed)
+{
+	return hash_buffer(key, strlen((const char *) key), seed);
+}
+#endif /* LTTNG_HT_FAST_HASH */
+
 /*
  * Hash function for two uint64_t.
  */
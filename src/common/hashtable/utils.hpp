@@ -8,12 +8,36 @@
 #ifndef _LTT_HT_UTILS_H
 #define _LTT_HT_UTILS_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#ifdef LTTNG_HT_FAST_HASH
+/*
+ * Multiply-mix of a 64-bit key and a seed: the 64-bit finalizer of
+ * MurmurHash3, over the key xor'ed with the seed. Every bit of the result
+ * depends on every bit of the key.
+ *
+ * Used by the hash functions below when the hash tables are configured with
+ * --enable-fast-hash, and exposed so that typed lookups can hash u64 keys
+ * inline.
+ */
+static inline uint64_t hash_mix_u64(uint64_t key, uint64_t seed)
+{
+	key ^= seed + 0x9e3779b97f4a7c15ULL;
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+#endif /* LTTNG_HT_FAST_HASH */
+
 unsigned long hash_key_ulong(const void *_key, unsigned long seed);
 unsigned long hash_key_u64(const void *_key, unsigned long seed);
 unsigned long hash_key_str(const void *key, unsigned long seed);
 unsigned long hash_key_two_u64(const void *key, unsigned long seed);
+unsigned long hash_buffer(const void *buffer, size_t length, unsigned long seed);
 int hash_match_key_ulong(const void *key1, const void *key2);
 int hash_match_key_u64(const void *key1, const void *key2);
 int hash_match_key_str(const void *key1, const void *key2);
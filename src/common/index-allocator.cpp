@@ -9,27 +9,33 @@
 #include "index-allocator.hpp"
 #include "macros.hpp"
 
+#include <algorithm>
 #include <inttypes.h>
-#include <urcu.h>
-#include <urcu/list.h>
 
+#define INDEX_ALLOCATOR_WORD_BITS 64
+
+/*
+ * The indexes in use are tracked by a bitmap, which is searched from the
+ * lowest word which may hold an unused index. Releasing an index does not
+ * allocate memory and allocating one only scans the words which are full.
+ */
 struct lttng_index_allocator {
-	struct cds_list_head unused_list;
 	uint64_t size;
-	uint64_t position;
 	uint64_t nb_allocated_indexes;
+	/* Word from which the search of an unused index starts. */
+	uint64_t search_word;
+	uint64_t word_count;
+	/*
+	 * Bit set for each index in use. The bits past the last index are set
+	 * so that they are never allocated.
+	 */
+	uint64_t *used_indexes;
 };
 
-namespace {
-struct lttng_index {
-	uint64_t index;
-	struct cds_list_head head;
-};
-} /* namespace */
-
 struct lttng_index_allocator *lttng_index_allocator_create(uint64_t index_count)
 {
 	struct lttng_index_allocator *allocator = nullptr;
+	const unsigned int trailing_bits = index_count % INDEX_ALLOCATOR_WORD_BITS;
 
 	allocator = zmalloc<lttng_index_allocator>();
 	if (!allocator) {
@@ -38,10 +44,25 @@ struct lttng_index_allocator *lttng_index_allocator_create(uint64_t index_count)
 	}
 
 	allocator->size = index_count;
-	allocator->position = 0;
 	allocator->nb_allocated_indexes = 0;
+	allocator->word_count =
+		(index_count + INDEX_ALLOCATOR_WORD_BITS - 1) / INDEX_ALLOCATOR_WORD_BITS;
+	if (allocator->word_count == 0) {
+		goto end;
+	}
+
+	allocator->used_indexes = calloc<uint64_t>(allocator->word_count);
+	if (!allocator->used_indexes) {
+		PERROR("Failed to allocate index allocator bitmap");
+		free(allocator);
+		allocator = nullptr;
+		goto end;
+	}
 
-	CDS_INIT_LIST_HEAD(&allocator->unused_list);
+	if (trailing_bits) {
+		allocator->used_indexes[allocator->word_count - 1] =
+			~((UINT64_C(1) << trailing_bits) - 1);
+	}
 
 end:
 	return allocator;
@@ -55,57 +76,50 @@ uint64_t lttng_index_allocator_get_index_count(struct lttng_index_allocator *all
 enum lttng_index_allocator_status
 lttng_index_allocator_alloc(struct lttng_index_allocator *allocator, uint64_t *allocated_index)
 {
-	enum lttng_index_allocator_status status = LTTNG_INDEX_ALLOCATOR_STATUS_OK;
+	uint64_t word_index;
+
+	if (allocator->nb_allocated_indexes == allocator->size) {
+		/* No indices left. */
+		return LTTNG_INDEX_ALLOCATOR_STATUS_EMPTY;
+	}
 
-	if (cds_list_empty(&allocator->unused_list)) {
-		if (allocator->position >= allocator->size) {
-			/* No indices left. */
-			status = LTTNG_INDEX_ALLOCATOR_STATUS_EMPTY;
-			goto end;
+	/* All the words below the search word are full. */
+	for (word_index = allocator->search_word; word_index < allocator->word_count;
+	     word_index++) {
+		if (allocator->used_indexes[word_index] != UINT64_MAX) {
+			break;
 		}
+	}
 
-		*allocated_index = allocator->position++;
-	} else {
-		struct lttng_index *index;
+	LTTNG_ASSERT(word_index < allocator->word_count);
 
-		index = cds_list_first_entry(&allocator->unused_list, typeof(*index), head);
-		cds_list_del(&index->head);
-		*allocated_index = index->index;
-		free(index);
-	}
+	uint64_t& word = allocator->used_indexes[word_index];
+	const unsigned int bit = __builtin_ctzll(~word);
 
+	word |= UINT64_C(1) << bit;
+	allocator->search_word = word_index;
 	allocator->nb_allocated_indexes++;
-end:
-	return status;
+	*allocated_index = word_index * INDEX_ALLOCATOR_WORD_BITS + bit;
+	return LTTNG_INDEX_ALLOCATOR_STATUS_OK;
 }
 
 enum lttng_index_allocator_status
 lttng_index_allocator_release(struct lttng_index_allocator *allocator, uint64_t idx)
 {
-	struct lttng_index *index = nullptr;
-	enum lttng_index_allocator_status status = LTTNG_INDEX_ALLOCATOR_STATUS_OK;
+	const uint64_t word_index = idx / INDEX_ALLOCATOR_WORD_BITS;
+	const uint64_t bit = UINT64_C(1) << (idx % INDEX_ALLOCATOR_WORD_BITS);
 
 	LTTNG_ASSERT(idx < allocator->size);
+	LTTNG_ASSERT(allocator->used_indexes[word_index] & bit);
 
-	index = zmalloc<lttng_index>();
-	if (!index) {
-		PERROR("Failed to allocate free index queue");
-		status = LTTNG_INDEX_ALLOCATOR_STATUS_ERROR;
-		goto end;
-	}
-
-	index->index = idx;
-	cds_list_add_tail(&index->head, &allocator->unused_list);
+	allocator->used_indexes[word_index] &= ~bit;
+	allocator->search_word = std::min(allocator->search_word, word_index);
 	allocator->nb_allocated_indexes--;
-
-end:
-	return status;
+	return LTTNG_INDEX_ALLOCATOR_STATUS_OK;
 }
 
 void lttng_index_allocator_destroy(struct lttng_index_allocator *allocator)
 {
-	struct lttng_index *index = nullptr, *tmp_index = nullptr;
-
 	if (!allocator) {
 		return;
 	}
@@ -115,10 +129,6 @@ void lttng_index_allocator_destroy(struct lttng_index_allocator *allocator)
 		     lttng_index_allocator_get_index_count(allocator));
 	}
 
-	cds_list_for_each_entry_safe (index, tmp_index, &allocator->unused_list, head) {
-		cds_list_del(&index->head);
-		free(index);
-	}
-
+	free(allocator->used_indexes);
 	free(allocator);
 }
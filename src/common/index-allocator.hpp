@@ -33,7 +33,7 @@ extern "C" LTTNG_EXPORT uint64_t
 lttng_index_allocator_get_index_count(struct lttng_index_allocator *allocator);
 
 /*
- * Allocate (i.e. reserve) a slot.
+ * Allocate (i.e. reserve) a slot: the lowest unused one.
  */
 extern "C" LTTNG_EXPORT enum lttng_index_allocator_status
 lttng_index_allocator_alloc(struct lttng_index_allocator *allocator, uint64_t *index);
@@ -20,6 +20,8 @@
 #define CTF_INDEX_MAGIC 0xC1F1DCC1
 #define CTF_INDEX_MAJOR 1
 #define CTF_INDEX_MINOR 1
+/* Minor version of the indexes which hold the checksum of their packet. */
+#define CTF_INDEX_CHECKSUM_MINOR 2
 
 /*
  * Header at the beginning of each index file.
@@ -48,6 +50,9 @@ struct ctf_packet_index {
 	/* CTF_INDEX 1.0 limit */
 	uint64_t stream_instance_id; /* ID of the channel instance */
 	uint64_t packet_seq_num; /* packet sequence number */
+	/* CTF_INDEX 1.1 limit */
+	/* CRC-32C of the packet, padding included, as stored in the file */
+	uint32_t packet_checksum;
 } __attribute__((__packed__));
 
 static inline size_t ctf_packet_index_len(uint32_t major, uint32_t minor)
@@ -60,6 +65,9 @@ static inline size_t ctf_packet_index_len(uint32_t major, uint32_t minor)
 		case 1:
 			return offsetof(struct ctf_packet_index, packet_seq_num) +
 				member_sizeof(struct ctf_packet_index, packet_seq_num);
+		case 2:
+			return offsetof(struct ctf_packet_index, packet_checksum) +
+				member_sizeof(struct ctf_packet_index, packet_checksum);
 		default:
 			abort();
 		}
@@ -18,8 +18,10 @@
 #include <lttng/constant.h>
 
 #include <fcntl.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #define WRITE_FILE_FLAGS     (O_WRONLY | O_CREAT | O_TRUNC)
 #define READ_ONLY_FILE_FLAGS O_RDONLY
@@ -119,6 +121,7 @@ _lttng_index_file_create_from_trace_chunk(struct lttng_trace_chunk *chunk,
 			goto error;
 		}
 		index_file->element_len = ctf_packet_index_len(index_major, index_minor);
+		index_file->size = sizeof(hdr);
 	} else {
 		uint32_t element_len;
 
@@ -223,12 +226,38 @@ lttng_index_file_create_from_trace_chunk_read_only(struct lttng_trace_chunk *chu
 							 file);
 }
 
+/*
+ * Reserve the blocks of the next `len` bytes of the index file, and of a
+ * window past them, if they are not already. A failure only disables the
+ * preallocation of this file.
+ */
+static void index_file_reserve(struct lttng_index_file *index_file, size_t len)
+{
+	const uint64_t end = index_file->size + len;
+
+	if (!index_file->preallocation_window || end <= index_file->preallocated_size) {
+		return;
+	}
+
+	if (fs_handle_preallocate(index_file->file,
+				  index_file->preallocated_size,
+				  end + index_file->preallocation_window -
+					  index_file->preallocated_size)) {
+		DBG("Failed to preallocate index file, disabling its preallocation: %s",
+		    strerror(errno));
+		index_file->preallocation_window = 0;
+		return;
+	}
+
+	index_file->preallocated_size = end + index_file->preallocation_window;
+}
+
 /*
  * Write index values to the given index file.
  *
  * Return 0 on success, -1 on error.
  */
-int lttng_index_file_write(const struct lttng_index_file *index_file,
+int lttng_index_file_write(struct lttng_index_file *index_file,
 			   const struct ctf_packet_index *element)
 {
 	ssize_t ret;
@@ -242,11 +271,49 @@ int lttng_index_file_write(const struct lttng_index_file *index_file,
 		goto error;
 	}
 
+	index_file_reserve(index_file, len);
 	ret = fs_handle_write(index_file->file, element, len);
 	if (ret < len) {
 		PERROR("writing index file");
 		goto error;
 	}
+
+	index_file->size += len;
+	return 0;
+
+error:
+	return -1;
+}
+
+/*
+ * Write `count` contiguous index values, each `element_len` bytes long, to the
+ * given index file.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int lttng_index_file_write_elements(struct lttng_index_file *index_file,
+				    const void *elements,
+				    size_t count)
+{
+	ssize_t ret;
+
+	LTTNG_ASSERT(index_file);
+	LTTNG_ASSERT(elements);
+
+	const size_t len = index_file->element_len * count;
+
+	if (!index_file->file) {
+		goto error;
+	}
+
+	index_file_reserve(index_file, len);
+	ret = fs_handle_write(index_file->file, elements, len);
+	if (ret < len) {
+		PERROR("writing index file");
+		goto error;
+	}
+
+	index_file->size += len;
 	return 0;
 
 error:
@@ -285,6 +352,47 @@ error:
 	return -1;
 }
 
+int lttng_index_file_read_at(const struct lttng_index_file *index_file,
+			     uint64_t position,
+			     struct ctf_packet_index *element)
+{
+	ssize_t ret;
+	const size_t len = index_file->element_len;
+	const off_t offset = sizeof(struct ctf_packet_index_file_hdr) + position * len;
+
+	LTTNG_ASSERT(element);
+
+	if (!index_file->file) {
+		goto error;
+	}
+
+	ret = fs_handle_pread(index_file->file, element, len, offset);
+	if (ret < 0) {
+		PERROR("read index file: offset = %" PRId64, (int64_t) offset);
+		goto error;
+	}
+	if (ret < len) {
+		ERR("lttng_pread expected %zu, returned %zd", len, ret);
+		goto error;
+	}
+	return 0;
+
+error:
+	return -1;
+}
+
+void lttng_index_file_preallocate(struct lttng_index_file *index_file, uint64_t data_window)
+{
+	const long page_size = sysconf(_SC_PAGE_SIZE);
+
+	if (page_size <= 0 || !index_file->file) {
+		return;
+	}
+
+	/* A packet spans at least one page. */
+	index_file->preallocation_window = data_window / page_size * index_file->element_len;
+}
+
 void lttng_index_file_get(struct lttng_index_file *index_file)
 {
 	urcu_ref_get(&index_file->ref);
@@ -294,6 +402,11 @@ static void lttng_index_file_release(struct urcu_ref *ref)
 {
 	struct lttng_index_file *index_file = caa_container_of(ref, struct lttng_index_file, ref);
 
+	if (index_file->preallocated_size > index_file->size &&
+	    fs_handle_trim_preallocation(index_file->file)) {
+		PERROR("Failed to release the preallocated blocks of index file");
+	}
+
 	if (fs_handle_close(index_file->file)) {
 		PERROR("close index fd");
 	}
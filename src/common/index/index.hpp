@@ -25,6 +25,12 @@ struct lttng_index_file {
 	uint32_t element_len;
 	struct lttng_trace_chunk *trace_chunk;
 	struct urcu_ref ref;
+	/* Bytes written to the file, including its header. */
+	uint64_t size;
+	/* End of the blocks reserved ahead of the writes, see lttng_index_file_preallocate(). */
+	uint64_t preallocated_size;
+	/* Bytes reserved at once ahead of the writes, 0 when disabled. */
+	uint64_t preallocation_window;
 };
 
 /*
@@ -53,11 +59,30 @@ lttng_index_file_create_from_trace_chunk_read_only(struct lttng_trace_chunk *chu
 						   bool expect_no_file,
 						   struct lttng_index_file **file);
 
-int lttng_index_file_write(const struct lttng_index_file *index_file,
+int lttng_index_file_write(struct lttng_index_file *index_file,
 			   const struct ctf_packet_index *element);
+int lttng_index_file_write_elements(struct lttng_index_file *index_file,
+				    const void *elements,
+				    size_t count);
 int lttng_index_file_read(const struct lttng_index_file *index_file,
 			  struct ctf_packet_index *element);
 
+/*
+ * Read the element at `position`, counted from the first element, without
+ * moving the read position of the index file.
+ */
+int lttng_index_file_read_at(const struct lttng_index_file *index_file,
+			     uint64_t position,
+			     struct ctf_packet_index *element);
+
+/*
+ * Reserve the blocks of the index file ahead of its writes, for as many
+ * entries as there are pages in `data_window`, the preallocation window of
+ * the matching data file. The reserved blocks past the last entry are
+ * released when the index file is released.
+ */
+void lttng_index_file_preallocate(struct lttng_index_file *index_file, uint64_t data_window);
+
 void lttng_index_file_get(struct lttng_index_file *index_file);
 void lttng_index_file_put(struct lttng_index_file *index_file);
 
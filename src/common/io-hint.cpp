@@ -5,13 +5,21 @@
  *
  */
 
+#include <common/defaults.hpp>
 #include <common/error.hpp>
 #include <common/io-hint.hpp>
 #include <common/scope-exit.hpp>
 
+#ifdef HAVE_LINUX_IO_URING_H
+#include <common/exception.hpp>
+#include <common/io-uring.hpp>
+#endif /* HAVE_LINUX_IO_URING_H */
+
 #include <cinttypes>
 #include <fcntl.h>
+#include <memory>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 /*
@@ -148,6 +156,78 @@ int hint_dont_need(int fd __attribute__((unused)),
 } /* namespace */
 #endif /* !HAVE_POSIX_FADVISE */
 
+/*
+ * Use io_uring, when available, to perform the "dont need" hints without
+ * blocking the caller.
+ */
+namespace {
+bool async_flush_backend_enabled;
+
+#ifdef HAVE_LINUX_IO_URING_H
+/* Each thread lazily creates its own ring since rings are not thread-safe. */
+thread_local std::unique_ptr<lttng::io::uring> flush_ring;
+thread_local bool flush_ring_unavailable;
+
+lttng::io::uring *get_flush_ring() noexcept
+{
+	if (flush_ring || flush_ring_unavailable) {
+		return flush_ring.get();
+	}
+
+	try {
+		flush_ring.reset(new lttng::io::uring(DEFAULT_IO_URING_FLUSH_QUEUE_DEPTH));
+	} catch (const std::exception& e) {
+		WARN("Failed to create io_uring instance, using synchronous flushes: %s",
+		     e.what());
+		flush_ring_unavailable = true;
+	}
+
+	return flush_ring.get();
+}
+
+bool flush_range_dont_need_uring(int fd, off_t offset, off_t nbytes) noexcept
+{
+	auto *ring = get_flush_ring();
+
+	if (!ring) {
+		return false;
+	}
+
+	try {
+		/*
+		 * Bound the amount of page cache pending writeback by waiting for
+		 * the oldest ranges once the queue is full.
+		 */
+		while (!ring->queue_flush_range_dont_need(fd, offset, nbytes)) {
+			ring->submit_and_reap(2);
+		}
+
+		/* Submit right away, without waiting for any completion. */
+		ring->submit_and_reap();
+	} catch (const std::exception& e) {
+		ERR("Failed to queue asynchronous page cache flush: %s", e.what());
+		flush_ring.reset();
+		flush_ring_unavailable = true;
+		return false;
+	}
+
+	return true;
+}
+#else /* HAVE_LINUX_IO_URING_H */
+bool flush_range_dont_need_uring(int fd __attribute__((unused)),
+				 off_t offset __attribute__((unused)),
+				 off_t nbytes __attribute__((unused))) noexcept
+{
+	return false;
+}
+#endif /* !HAVE_LINUX_IO_URING_H */
+} /* namespace */
+
+void lttng::io::set_async_flush_backend_enabled(bool enabled) noexcept
+{
+	async_flush_backend_enabled = enabled;
+}
+
 /*
  * Give a hint to the kernel that we won't need the data at the specified range
  * so it can be dropped from the page cache and wait for it to be flushed to
@@ -192,3 +272,48 @@ void lttng::io::hint_flush_range_async(int fd, off_t offset, off_t nbytes)
 {
 	flush_range_async(fd, offset, nbytes);
 }
+
+/*
+ * Same as hint_flush_range_dont_need_sync(), but the wait for the page
+ * writeback and the hint are performed asynchronously when the asynchronous
+ * backend is enabled and available.
+ */
+void lttng::io::hint_flush_range_dont_need_async(int fd, off_t offset, off_t nbytes)
+{
+	if (async_flush_backend_enabled && flush_range_dont_need_uring(fd, offset, nbytes)) {
+		return;
+	}
+
+	hint_flush_range_dont_need_sync(fd, offset, nbytes);
+}
+
+int lttng::io::preallocate_range(int fd, off_t offset, off_t nbytes)
+{
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+	int ret;
+
+	do {
+		ret = fallocate(fd, FALLOC_FL_KEEP_SIZE, offset, nbytes);
+	} while (ret && errno == EINTR);
+
+	return ret;
+#else /* HAVE_FALLOCATE && FALLOC_FL_KEEP_SIZE */
+	(void) fd;
+	(void) offset;
+	(void) nbytes;
+	errno = EOPNOTSUPP;
+	return -1;
+#endif /* !(HAVE_FALLOCATE && FALLOC_FL_KEEP_SIZE) */
+}
+
+int lttng::io::trim_preallocation(int fd)
+{
+	struct stat st;
+
+	if (fstat(fd, &st)) {
+		return -1;
+	}
+
+	/* Truncating a file to its own size frees the blocks past its end. */
+	return ftruncate(fd, st.st_size);
+}
@@ -16,6 +16,26 @@ namespace io {
 void hint_flush_range_dont_need_sync(int fd, off_t offset, off_t nbytes);
 void hint_flush_range_sync(int fd, off_t offset, off_t nbytes);
 void hint_flush_range_async(int fd, off_t offset, off_t nbytes);
+void hint_flush_range_dont_need_async(int fd, off_t offset, off_t nbytes);
+
+/*
+ * Reserve the blocks of the specified range of a file without changing its
+ * size, so that a file growing one write at a time is laid out in large
+ * extents.
+ *
+ * Return 0 on success, else -1 with errno set. Fails with EOPNOTSUPP when the
+ * platform or the file system doesn't support it.
+ */
+int preallocate_range(int fd, off_t offset, off_t nbytes);
+
+/* Release the blocks reserved past the end of a file by preallocate_range(). */
+int trim_preallocation(int fd);
+
+/*
+ * Select whether hint_flush_range_dont_need_async() may use io_uring. Must be
+ * set before any thread uses it. Disabled by default.
+ */
+void set_async_flush_backend_enabled(bool enabled) noexcept;
 
 } /* namespace io */
 } /* namespace lttng */
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include "io-uring.hpp"
+
+#include <common/error.hpp>
+#include <common/exception.hpp>
+#include <common/macros.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <urcu/arch.h>
+#include <urcu/system.h>
+
+namespace {
+/* Tags of the operations, stored as the user data of the submissions. */
+enum class operation : std::uint64_t {
+	SYNC_FILE_RANGE = 1,
+	FADVISE = 2,
+};
+
+int io_uring_setup(unsigned int entries, struct io_uring_params *params)
+{
+	return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+int io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+	return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+void *map_ring(int fd, size_t size, off_t offset)
+{
+	void *ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+
+	if (ring == MAP_FAILED) {
+		LTTNG_THROW_POSIX("Failed to map io_uring ring", errno);
+	}
+
+	return ring;
+}
+} /* namespace */
+
+lttng::io::uring::uring(unsigned int entries)
+{
+	const auto raw_fd = io_uring_setup(entries, &_params);
+	if (raw_fd < 0) {
+		LTTNG_THROW_POSIX("Failed to create io_uring instance", errno);
+	}
+
+	/* Take ownership of the fd right away so that it is closed on error. */
+	file_descriptor::operator=(file_descriptor(raw_fd));
+
+	_sq_ring_size = _params.sq_off.array + _params.sq_entries * sizeof(unsigned int);
+	_cq_ring_size = _params.cq_off.cqes + _params.cq_entries * sizeof(struct io_uring_cqe);
+	if (_params.features & IORING_FEAT_SINGLE_MMAP) {
+		_sq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+		_cq_ring_size = _sq_ring_size;
+	}
+
+	try {
+		_sq_ring = map_ring(raw_fd, _sq_ring_size, IORING_OFF_SQ_RING);
+		if (_params.features & IORING_FEAT_SINGLE_MMAP) {
+			_cq_ring = _sq_ring;
+		} else {
+			_cq_ring = map_ring(raw_fd, _cq_ring_size, IORING_OFF_CQ_RING);
+		}
+
+		_sqes = static_cast<struct io_uring_sqe *>(
+			map_ring(raw_fd,
+				 _params.sq_entries * sizeof(struct io_uring_sqe),
+				 IORING_OFF_SQES));
+	} catch (...) {
+		if (_cq_ring && _cq_ring != _sq_ring) {
+			(void) munmap(_cq_ring, _cq_ring_size);
+		}
+
+		if (_sq_ring) {
+			(void) munmap(_sq_ring, _sq_ring_size);
+		}
+
+		throw;
+	}
+
+	char *const sq_ring = static_cast<char *>(_sq_ring);
+	char *const cq_ring = static_cast<char *>(_cq_ring);
+
+	_sq_head = reinterpret_cast<unsigned int *>(sq_ring + _params.sq_off.head);
+	_sq_tail = reinterpret_cast<unsigned int *>(sq_ring + _params.sq_off.tail);
+	_sq_array = reinterpret_cast<unsigned int *>(sq_ring + _params.sq_off.array);
+	_sq_mask = *reinterpret_cast<unsigned int *>(sq_ring + _params.sq_off.ring_mask);
+	_sq_local_tail = *_sq_tail;
+
+	_cq_head = reinterpret_cast<unsigned int *>(cq_ring + _params.cq_off.head);
+	_cq_tail = reinterpret_cast<unsigned int *>(cq_ring + _params.cq_off.tail);
+	_cqes = reinterpret_cast<struct io_uring_cqe *>(cq_ring + _params.cq_off.cqes);
+	_cq_mask = *reinterpret_cast<unsigned int *>(cq_ring + _params.cq_off.ring_mask);
+}
+
+lttng::io::uring::~uring()
+{
+	/* Don't leave hints behind; their completion is cheap to wait for. */
+	try {
+		while (_to_submit > 0 || _in_flight > 0) {
+			submit_and_reap(_in_flight + _to_submit);
+		}
+	} catch (const std::exception& e) {
+		ERR("Failed to wait for io_uring operations to complete: %s", e.what());
+	}
+
+	(void) munmap(_sqes, _params.sq_entries * sizeof(struct io_uring_sqe));
+	if (_cq_ring != _sq_ring) {
+		(void) munmap(_cq_ring, _cq_ring_size);
+	}
+
+	(void) munmap(_sq_ring, _sq_ring_size);
+}
+
+unsigned int lttng::io::uring::sq_space_left() const noexcept
+{
+	/* The kernel advances the head as it consumes submissions. */
+	const unsigned int head = CMM_LOAD_SHARED(*_sq_head);
+
+	cmm_smp_rmb();
+	return _params.sq_entries - (_sq_local_tail - head);
+}
+
+struct io_uring_sqe *lttng::io::uring::_get_sqe() noexcept
+{
+	struct io_uring_sqe *sqe;
+	const unsigned int index = _sq_local_tail & _sq_mask;
+
+	if (sq_space_left() == 0) {
+		return nullptr;
+	}
+
+	sqe = &_sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	_sq_array[index] = index;
+	_sq_local_tail++;
+	_to_submit++;
+	return sqe;
+}
+
+bool lttng::io::uring::queue_flush_range_dont_need(int fd, off_t offset, off_t nbytes) noexcept
+{
+	struct io_uring_sqe *sqe;
+
+	if (sq_space_left() < 2) {
+		return false;
+	}
+
+	sqe = _get_sqe();
+	sqe->opcode = IORING_OP_SYNC_FILE_RANGE;
+	sqe->fd = fd;
+	sqe->off = offset;
+	sqe->len = nbytes;
+	sqe->sync_range_flags =
+		SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+	/* The hint must only be given once the writeback completed. */
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = static_cast<std::uint64_t>(operation::SYNC_FILE_RANGE);
+
+	sqe = _get_sqe();
+	sqe->opcode = IORING_OP_FADVISE;
+	sqe->fd = fd;
+	sqe->off = offset;
+	sqe->len = nbytes;
+	sqe->fadvise_advice = POSIX_FADV_DONTNEED;
+	sqe->user_data = static_cast<std::uint64_t>(operation::FADVISE);
+
+	/* Publish the submissions to the kernel. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(*_sq_tail, _sq_local_tail);
+	return true;
+}
+
+unsigned int lttng::io::uring::_reap() noexcept
+{
+	unsigned int head = *_cq_head, reaped = 0;
+	const unsigned int tail = CMM_LOAD_SHARED(*_cq_tail);
+
+	cmm_smp_rmb();
+	for (; head != tail; head++, reaped++) {
+		const struct io_uring_cqe *cqe = &_cqes[head & _cq_mask];
+
+		/*
+		 * Errors are only logged: these are hints meant to limit the
+		 * amount of page cache used.
+		 */
+		if (cqe->res < 0 && cqe->res != -ECANCELED) {
+			DBG("io_uring %s operation failed: %s",
+			    cqe->user_data == static_cast<std::uint64_t>(operation::FADVISE) ?
+				    "fadvise" :
+				    "sync_file_range",
+			    strerror(-cqe->res));
+		}
+	}
+
+	/* Release the completion entries to the kernel. */
+	cmm_smp_mb();
+	CMM_STORE_SHARED(*_cq_head, head);
+
+	LTTNG_ASSERT(reaped <= _in_flight);
+	_in_flight -= reaped;
+	return reaped;
+}
+
+void lttng::io::uring::submit_and_reap(unsigned int min_completions)
+{
+	unsigned int flags = 0;
+
+	min_completions = std::min(min_completions, _in_flight + _to_submit);
+	if (min_completions > 0) {
+		flags |= IORING_ENTER_GETEVENTS;
+	}
+
+	if (_to_submit > 0 || min_completions > 0) {
+		int ret;
+
+		do {
+			ret = io_uring_enter(fd(), _to_submit, min_completions, flags);
+		} while (ret < 0 && errno == EINTR);
+
+		if (ret < 0) {
+			LTTNG_THROW_POSIX("Failed to submit io_uring operations", errno);
+		}
+
+		LTTNG_ASSERT((unsigned int) ret <= _to_submit);
+		_to_submit -= ret;
+		_in_flight += ret;
+	}
+
+	(void) _reap();
+}
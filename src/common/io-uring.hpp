@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_IO_URING_HPP
+#define LTTNG_IO_URING_HPP
+
+#include <common/file-descriptor.hpp>
+
+#include <linux/io_uring.h>
+#include <sys/types.h>
+
+namespace lttng {
+namespace io {
+
+/*
+ * Minimal io_uring instance used to queue page cache writeback hints without
+ * blocking the submitting thread.
+ *
+ * An instance is not thread-safe: it is meant to be owned by a single
+ * thread which both queues operations and reaps their completion.
+ */
+class uring : public file_descriptor {
+public:
+	/* Throws a posix_error exception on failure to create the underlying resource. */
+	explicit uring(unsigned int entries);
+	uring(const uring&) = delete;
+	uring& operator=(const uring&) = delete;
+	uring(uring&&) = delete;
+	void operator=(uring&&) = delete;
+	~uring();
+
+	/*
+	 * Queue a write-and-wait of the pages of a file range followed by a
+	 * POSIX_FADV_DONTNEED hint on that range, once the writeback completed.
+	 *
+	 * Returns false, without queuing anything, if the submission queue is
+	 * full.
+	 */
+	bool queue_flush_range_dont_need(int fd, off_t offset, off_t nbytes) noexcept;
+
+	/*
+	 * Submit the queued operations and wait for at least `min_completions`
+	 * operations to complete before reaping all available completions.
+	 *
+	 * Throws a posix_error exception on failure.
+	 */
+	void submit_and_reap(unsigned int min_completions = 0);
+
+	/* Number of submitted operations that have not been reaped yet. */
+	unsigned int in_flight() const noexcept
+	{
+		return _in_flight;
+	}
+
+	/* Number of operations that can be queued before a submission is needed. */
+	unsigned int sq_space_left() const noexcept;
+
+private:
+	struct io_uring_sqe *_get_sqe() noexcept;
+	unsigned int _reap() noexcept;
+
+	struct io_uring_params _params = {};
+
+	void *_sq_ring = nullptr;
+	size_t _sq_ring_size = 0;
+	void *_cq_ring = nullptr;
+	size_t _cq_ring_size = 0;
+	struct io_uring_sqe *_sqes = nullptr;
+
+	unsigned int *_sq_head = nullptr;
+	unsigned int *_sq_tail = nullptr;
+	unsigned int *_sq_array = nullptr;
+	unsigned int _sq_mask = 0;
+	/* Local tail of the operations queued since the last submission. */
+	unsigned int _sq_local_tail = 0;
+
+	unsigned int *_cq_head = nullptr;
+	unsigned int *_cq_tail = nullptr;
+	struct io_uring_cqe *_cqes = nullptr;
+	unsigned int _cq_mask = 0;
+
+	unsigned int _to_submit = 0;
+	unsigned int _in_flight = 0;
+};
+
+} /* namespace io */
+} /* namespace lttng */
+
+#endif /* LTTNG_IO_URING_HPP */
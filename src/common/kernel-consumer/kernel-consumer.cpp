@@ -13,6 +13,7 @@
 #include <common/buffer-view.hpp>
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
+#include <common/consumer/consumer-snapshot.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/consumer/consumer.hpp>
@@ -131,21 +132,113 @@ error:
 	return ret;
 }
 
+static int snapshot_get_subbuf(struct lttng_consumer_stream *stream, unsigned long *pos)
+{
+	return kernctl_get_subbuf(stream->wait_fd, pos);
+}
+
+static int snapshot_get_subbuf_size(struct lttng_consumer_stream *stream, unsigned long *len)
+{
+	return kernctl_get_subbuf_size(stream->wait_fd, len);
+}
+
+static int snapshot_get_padded_subbuf_size(struct lttng_consumer_stream *stream,
+					   unsigned long *len)
+{
+	return kernctl_get_padded_subbuf_size(stream->wait_fd, len);
+}
+
+static int snapshot_put_subbuf(struct lttng_consumer_stream *stream)
+{
+	return kernctl_put_subbuf(stream->wait_fd);
+}
+
+static const struct consumer_snapshot_ops kernel_snapshot_ops = {
+	snapshot_get_subbuf,
+	snapshot_get_subbuf_size,
+	snapshot_get_padded_subbuf_size,
+	get_current_subbuf_addr,
+	snapshot_put_subbuf,
+	/* abort_on_short_write */
+	false,
+};
+
+/*
+ * Close the output of the streams of a snapshot and unlock them so they can be
+ * used by the next snapshot.
+ */
+static void snapshot_release_streams(const std::vector<consumer_snapshot_stream>& streams)
+{
+	for (const auto& snapshot_stream : streams) {
+		snapshot_stream.stream->snapshot_fd_output = nullptr;
+		consumer_stream_close_output(snapshot_stream.stream);
+		pthread_mutex_unlock(&snapshot_stream.stream->lock);
+	}
+}
+
+/*
+ * Open the trace file of a stream, or its relay daemon stream, to record it as
+ * part of a snapshot. The stream lock must be held.
+ *
+ * Returns 0 on success, < 0 on error
+ */
+static int open_snapshot_stream_output(struct lttng_consumer_stream *stream,
+				       char *path,
+				       uint64_t relayd_id)
+{
+	int ret;
+
+	LTTNG_ASSERT(stream->chan->trace_chunk);
+	if (!lttng_trace_chunk_get(stream->chan->trace_chunk)) {
+		/*
+		 * Can't happen barring an internal error as the channel
+		 * holds a reference to the trace chunk.
+		 */
+		ERR("Failed to acquire reference to channel's trace chunk");
+		return -1;
+	}
+	LTTNG_ASSERT(!stream->trace_chunk);
+	stream->trace_chunk = stream->chan->trace_chunk;
+
+	if (relayd_id != (uint64_t) -1ULL) {
+		ret = consumer_send_relayd_stream(stream, path);
+		if (ret < 0) {
+			ERR("sending stream to relayd");
+		}
+	} else {
+		ret = consumer_stream_create_output_files(stream, false);
+		DBG("Kernel consumer snapshot stream (%" PRIu64 ")", stream->key);
+	}
+
+	if (ret < 0) {
+		consumer_stream_close_output(stream);
+	}
+
+	return ret;
+}
+
 /*
  * Take a snapshot of all the stream of a channel
  * RCU read-side lock must be held across this function to ensure existence of
  * channel.
  *
+ * The positions of all the streams are sampled before any of them is
+ * recorded so that the snapshot is a consistent cut of the channel; the
+ * streams are then recorded concurrently.
+ *
  * Returns 0 on success, < 0 on error
  */
 static int lttng_kconsumer_snapshot_channel(struct lttng_consumer_channel *channel,
 					    uint64_t key,
 					    char *path,
 					    uint64_t relayd_id,
-					    uint64_t nb_packets_per_stream)
+					    uint64_t nb_packets_per_stream,
+					    bool incremental,
+					    struct consumer_snapshot_fd_output *fd_output)
 {
 	int ret;
 	struct lttng_consumer_stream *stream;
+	std::vector<consumer_snapshot_stream> streams;
 
 	DBG("Kernel consumer snapshot channel %" PRIu64, key);
 
@@ -163,8 +256,6 @@ static int lttng_kconsumer_snapshot_channel(struct lttng_consumer_channel *chann
 	}
 
 	cds_list_for_each_entry (stream, &channel->streams.head, send_node) {
-		unsigned long consumed_pos, produced_pos;
-
 		health_code_update();
 
 		/*
@@ -172,39 +263,36 @@ static int lttng_kconsumer_snapshot_channel(struct lttng_consumer_channel *chann
 		 */
 		pthread_mutex_lock(&stream->lock);
 
-		LTTNG_ASSERT(channel->trace_chunk);
-		if (!lttng_trace_chunk_get(channel->trace_chunk)) {
-			/*
-			 * Can't happen barring an internal error as the channel
-			 * holds a reference to the trace chunk.
-			 */
-			ERR("Failed to acquire reference to channel's trace chunk");
-			ret = -1;
-			goto end_unlock;
-		}
-		LTTNG_ASSERT(!stream->trace_chunk);
-		stream->trace_chunk = channel->trace_chunk;
-
 		/*
 		 * Assign the received relayd ID so we can use it for streaming. The streams
 		 * are not visible to anyone so this is OK to change it.
 		 */
 		stream->net_seq_idx = relayd_id;
+		stream->relayd_data_sock_index = -1;
 		channel->relayd_id = relayd_id;
-		if (relayd_id != (uint64_t) -1ULL) {
-			ret = consumer_send_relayd_stream(stream, path);
-			if (ret < 0) {
-				ERR("sending stream to relayd");
-				goto error_close_stream_output;
-			}
+		if (fd_output) {
+			/* The packets are written as records of the output. */
+			stream->snapshot_fd_output = fd_output;
 		} else {
-			ret = consumer_stream_create_output_files(stream, false);
+			ret = open_snapshot_stream_output(stream, path, relayd_id);
 			if (ret < 0) {
-				goto error_close_stream_output;
+				goto end_unlock;
 			}
-			DBG("Kernel consumer snapshot stream (%" PRIu64 ")", stream->key);
 		}
 
+		try {
+			streams.push_back({ stream, 0, 0 });
+		} catch (const std::bad_alloc&) {
+			ERR("Failed to allocate snapshot stream");
+			ret = -ENOMEM;
+			goto error_close_stream_output;
+		}
+	}
+
+	for (auto& snapshot_stream : streams) {
+		stream = snapshot_stream.stream;
+		health_code_update();
+
 		ret = kernctl_buffer_flush_empty(stream->wait_fd);
 		if (ret < 0) {
 			/*
@@ -217,117 +305,47 @@ static int lttng_kconsumer_snapshot_channel(struct lttng_consumer_channel *chann
 			ret = kernctl_buffer_flush(stream->wait_fd);
 			if (ret < 0) {
 				ERR("Failed to flush kernel stream");
-				goto error_close_stream_output;
+				goto error_release_streams;
 			}
-			goto end_unlock;
 		}
 
 		ret = lttng_kconsumer_take_snapshot(stream);
 		if (ret < 0) {
 			ERR("Taking kernel snapshot");
-			goto error_close_stream_output;
+			goto error_release_streams;
 		}
 
-		ret = lttng_kconsumer_get_produced_snapshot(stream, &produced_pos);
+		ret = lttng_kconsumer_get_produced_snapshot(stream, &snapshot_stream.produced_pos);
 		if (ret < 0) {
 			ERR("Produced kernel snapshot position");
-			goto error_close_stream_output;
+			goto error_release_streams;
 		}
 
-		ret = lttng_kconsumer_get_consumed_snapshot(stream, &consumed_pos);
+		ret = lttng_kconsumer_get_consumed_snapshot(stream, &snapshot_stream.consumed_pos);
 		if (ret < 0) {
 			ERR("Consumerd kernel snapshot position");
-			goto error_close_stream_output;
+			goto error_release_streams;
 		}
 
-		consumed_pos = consumer_get_consume_start_pos(
-			consumed_pos, produced_pos, nb_packets_per_stream, stream->max_sb_size);
-
-		while ((long) (consumed_pos - produced_pos) < 0) {
-			ssize_t read_len;
-			unsigned long len, padded_len;
-			const char *subbuf_addr;
-			struct lttng_buffer_view subbuf_view;
-
-			health_code_update();
-			DBG("Kernel consumer taking snapshot at pos %lu", consumed_pos);
-
-			ret = kernctl_get_subbuf(stream->wait_fd, &consumed_pos);
-			if (ret < 0) {
-				if (ret != -EAGAIN) {
-					PERROR("kernctl_get_subbuf snapshot");
-					goto error_close_stream_output;
-				}
-				DBG("Kernel consumer get subbuf failed. Skipping it.");
-				consumed_pos += stream->max_sb_size;
-				stream->chan->lost_packets++;
-				continue;
-			}
-
-			ret = kernctl_get_subbuf_size(stream->wait_fd, &len);
-			if (ret < 0) {
-				ERR("Snapshot kernctl_get_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = kernctl_get_padded_subbuf_size(stream->wait_fd, &padded_len);
-			if (ret < 0) {
-				ERR("Snapshot kernctl_get_padded_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = get_current_subbuf_addr(stream, &subbuf_addr);
-			if (ret) {
-				goto error_put_subbuf;
-			}
-
-			subbuf_view = lttng_buffer_view_init(subbuf_addr, 0, padded_len);
-			read_len = lttng_consumer_on_read_subbuffer_mmap(
-				stream, &subbuf_view, padded_len - len);
-			/*
-			 * We write the padded len in local tracefiles but the data len
-			 * when using a relay. Display the error but continue processing
-			 * to try to release the subbuffer.
-			 */
-			if (relayd_id != (uint64_t) -1ULL) {
-				if (read_len != len) {
-					ERR("Error sending to the relay (ret: %zd != len: %lu)",
-					    read_len,
-					    len);
-				}
-			} else {
-				if (read_len != padded_len) {
-					ERR("Error writing to tracefile (ret: %zd != len: %lu)",
-					    read_len,
-					    padded_len);
-				}
-			}
-
-			ret = kernctl_put_subbuf(stream->wait_fd);
-			if (ret < 0) {
-				ERR("Snapshot kernctl_put_subbuf");
-				goto error_close_stream_output;
-			}
-			consumed_pos += stream->max_sb_size;
-		}
-
-		consumer_stream_close_output(stream);
-		pthread_mutex_unlock(&stream->lock);
+		snapshot_stream.consumed_pos =
+			consumer_get_consume_start_pos(snapshot_stream.consumed_pos,
+						       snapshot_stream.produced_pos,
+						       nb_packets_per_stream,
+						       stream->max_sb_size);
 	}
 
-	/* All good! */
-	ret = 0;
+	ret = consumer_snapshot_record_streams(
+		streams, &kernel_snapshot_ops, relayd_id != (uint64_t) -1ULL, incremental);
+	snapshot_release_streams(streams);
 	goto end;
 
-error_put_subbuf:
-	ret = kernctl_put_subbuf(stream->wait_fd);
-	if (ret < 0) {
-		ERR("Snapshot kernctl_put_subbuf error path");
-	}
 error_close_stream_output:
+	stream->snapshot_fd_output = nullptr;
 	consumer_stream_close_output(stream);
 end_unlock:
 	pthread_mutex_unlock(&stream->lock);
+error_release_streams:
+	snapshot_release_streams(streams);
 end:
 	pthread_mutex_unlock(&channel->lock);
 	return ret;
@@ -344,6 +362,7 @@ static int lttng_kconsumer_snapshot_metadata(struct lttng_consumer_channel *meta
 					     uint64_t key,
 					     char *path,
 					     uint64_t relayd_id,
+					     struct consumer_snapshot_fd_output *fd_output,
 					     struct lttng_consumer_local_data *ctx)
 {
 	int ret, use_relayd = 0;
@@ -360,15 +379,18 @@ static int lttng_kconsumer_snapshot_metadata(struct lttng_consumer_channel *meta
 	LTTNG_ASSERT(metadata_stream);
 
 	metadata_stream->read_subbuffer_ops.lock(metadata_stream);
-	LTTNG_ASSERT(metadata_channel->trace_chunk);
-	LTTNG_ASSERT(metadata_stream->trace_chunk);
+	/* A snapshot recorded to a file descriptor doesn't use a trace chunk. */
+	LTTNG_ASSERT(fd_output || metadata_channel->trace_chunk);
+	LTTNG_ASSERT(fd_output || metadata_stream->trace_chunk);
 
 	/* Flag once that we have a valid relayd for the stream. */
 	if (relayd_id != (uint64_t) -1ULL) {
 		use_relayd = 1;
 	}
 
-	if (use_relayd) {
+	if (fd_output) {
+		metadata_stream->snapshot_fd_output = fd_output;
+	} else if (use_relayd) {
 		ret = consumer_send_relayd_stream(metadata_stream, path);
 		if (ret < 0) {
 			goto error_snapshot;
@@ -391,7 +413,9 @@ static int lttng_kconsumer_snapshot_metadata(struct lttng_consumer_channel *meta
 		}
 	} while (ret_read > 0);
 
-	if (use_relayd) {
+	if (fd_output) {
+		metadata_stream->snapshot_fd_output = nullptr;
+	} else if (use_relayd) {
 		close_relayd_stream(metadata_stream);
 		metadata_stream->net_seq_idx = (uint64_t) -1ULL;
 	} else {
@@ -412,12 +436,190 @@ static int lttng_kconsumer_snapshot_metadata(struct lttng_consumer_channel *meta
 
 	ret = 0;
 error_snapshot:
+	metadata_stream->snapshot_fd_output = nullptr;
 	metadata_stream->read_subbuffer_ops.unlock(metadata_stream);
 	consumer_stream_destroy(metadata_stream, nullptr);
 	metadata_channel->metadata_stream = nullptr;
 	return ret;
 }
 
+/*
+ * Create the consumer stream of a kernel stream fd received from the session
+ * daemon and hand it over to the data or metadata thread.
+ *
+ * Return 0 on success, else a negative value. The errors are reported
+ * through the error socket.
+ */
+static int add_stream(struct lttng_consumer_local_data *ctx,
+		      struct lttng_consumer_channel *channel,
+		      int fd,
+		      int32_t cpu)
+{
+	struct lttng_pipe *stream_pipe;
+	struct lttng_consumer_stream *new_stream;
+	int alloc_ret = 0;
+	int ret_get_max_subbuf_size;
+	ssize_t ret_pipe_write;
+
+	pthread_mutex_lock(&channel->lock);
+	new_stream = consumer_stream_create(channel,
+					    channel->key,
+					    fd,
+					    channel->name,
+					    channel->relayd_id,
+					    channel->session_id,
+					    channel->trace_chunk,
+					    cpu,
+					    &alloc_ret,
+					    channel->type,
+					    channel->monitor);
+	if (new_stream == nullptr) {
+		switch (alloc_ret) {
+		case -ENOMEM:
+		case -EINVAL:
+		default:
+			lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_OUTFD_ERROR);
+			break;
+		}
+		pthread_mutex_unlock(&channel->lock);
+		return -1;
+	}
+
+	new_stream->wait_fd = fd;
+	ret_get_max_subbuf_size =
+		kernctl_get_max_subbuf_size(new_stream->wait_fd, &new_stream->max_sb_size);
+	if (ret_get_max_subbuf_size < 0) {
+		pthread_mutex_unlock(&channel->lock);
+		ERR("Failed to get kernel maximal subbuffer size");
+		return -1;
+	}
+
+	consumer_stream_size_splice_pipe(new_stream);
+
+	consumer_stream_update_channel_attributes(new_stream, channel);
+
+	/*
+	 * We've just assigned the channel to the stream so increment the
+	 * refcount right now. We don't need to increment the refcount for
+	 * streams in no monitor because we handle manually the cleanup of
+	 * those. It is very important to make sure there is NO prior
+	 * consumer_del_stream() calls or else the refcount will be unbalanced.
+	 */
+	if (channel->monitor) {
+		uatomic_inc(&new_stream->chan->refcount);
+	}
+
+	/*
+	 * The buffer flush is done on the session daemon side for the kernel
+	 * so no need for the stream "hangup_flush_done" variable to be
+	 * tracked. This is important for a kernel stream since we don't rely
+	 * on the flush state of the stream to read data. It's not the case for
+	 * user space tracing.
+	 */
+	new_stream->hangup_flush_done = 0;
+
+	health_code_update();
+
+	pthread_mutex_lock(&new_stream->lock);
+	if (ctx->on_recv_stream) {
+		int ret_recv_stream = ctx->on_recv_stream(new_stream);
+		if (ret_recv_stream < 0) {
+			pthread_mutex_unlock(&new_stream->lock);
+			pthread_mutex_unlock(&channel->lock);
+			consumer_stream_free(new_stream);
+			return -1;
+		}
+	}
+	health_code_update();
+
+	if (new_stream->metadata_flag) {
+		channel->metadata_stream = new_stream;
+	}
+
+	/* Do not monitor this stream. */
+	if (!channel->monitor) {
+		DBG("Kernel consumer add stream %s in no monitor mode with "
+		    "relayd id %" PRIu64,
+		    new_stream->name,
+		    new_stream->net_seq_idx);
+		cds_list_add(&new_stream->send_node, &channel->streams.head);
+		pthread_mutex_unlock(&new_stream->lock);
+		pthread_mutex_unlock(&channel->lock);
+		return 0;
+	}
+
+	/* Send stream to relayd if the stream has an ID. */
+	if (new_stream->net_seq_idx != (uint64_t) -1ULL) {
+		int ret_send_relayd_stream;
+
+		ret_send_relayd_stream =
+			consumer_send_relayd_stream(new_stream, new_stream->chan->pathname);
+		if (ret_send_relayd_stream < 0) {
+			pthread_mutex_unlock(&new_stream->lock);
+			pthread_mutex_unlock(&channel->lock);
+			consumer_stream_free(new_stream);
+			return -1;
+		}
+
+		/*
+		 * If adding an extra stream to an already
+		 * existing channel (e.g. cpu hotplug), we need
+		 * to send the "streams_sent" command to relayd.
+		 */
+		if (channel->streams_sent_to_relayd) {
+			int ret_send_relayd_streams_sent;
+
+			ret_send_relayd_streams_sent =
+				consumer_send_relayd_streams_sent(new_stream->net_seq_idx);
+			if (ret_send_relayd_streams_sent < 0) {
+				pthread_mutex_unlock(&new_stream->lock);
+				pthread_mutex_unlock(&channel->lock);
+				return -1;
+			}
+		}
+	}
+	pthread_mutex_unlock(&new_stream->lock);
+	pthread_mutex_unlock(&channel->lock);
+
+	/* Get the right pipe where the stream will be sent. */
+	if (new_stream->metadata_flag) {
+		consumer_add_metadata_stream(new_stream);
+		stream_pipe = ctx->consumer_metadata_pipe;
+	} else {
+		struct lttng_consumer_data_worker *worker;
+
+		consumer_add_data_stream(new_stream, ctx);
+		worker = consumer_get_stream_data_worker(ctx, new_stream);
+		stream_pipe = worker->consumer_data_pipe;
+	}
+
+	/* Visible to other threads */
+	new_stream->globally_visible = 1;
+
+	health_code_update();
+
+	/* NOLINTNEXTLINE(bugprone-sizeof-expression): sizeof used on a pointer. */
+	ret_pipe_write = lttng_pipe_write(stream_pipe, &new_stream, sizeof(new_stream));
+	if (ret_pipe_write < 0) {
+		ERR("Consumer write %s stream to pipe %d",
+		    new_stream->metadata_flag ? "metadata" : "data",
+		    lttng_pipe_get_writefd(stream_pipe));
+		if (new_stream->metadata_flag) {
+			consumer_del_stream_for_metadata(new_stream);
+		} else {
+			consumer_del_stream_for_data(new_stream);
+		}
+		return -1;
+	}
+
+	DBG("Kernel consumer ADD_STREAM %s (fd: %d) %s with relayd id %" PRIu64,
+	    new_stream->name,
+	    fd,
+	    new_stream->chan->pathname,
+	    new_stream->relayd_stream_id);
+	return 0;
+}
+
 /*
  * Receive command from session daemon and process it.
  *
@@ -516,6 +718,11 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 			goto end_nosignal;
 		}
 		new_channel->nb_init_stream_left = msg.u.channel.nb_init_streams;
+		new_channel->writeback_policy =
+			(enum lttng_channel_writeback_policy) msg.u.channel.writeback_policy;
+		new_channel->writeback_window_size = msg.u.channel.writeback_window_size;
+		new_channel->drain_max_subbuffers = msg.u.channel.drain_max_subbuffers;
+		new_channel->drain_max_bytes = msg.u.channel.drain_max_bytes;
 		switch (msg.u.channel.output) {
 		case LTTNG_EVENT_SPLICE:
 			new_channel->output = CONSUMER_CHANNEL_SPLICE;
@@ -580,12 +787,9 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 	case LTTNG_CONSUMER_ADD_STREAM:
 	{
 		int fd;
-		struct lttng_pipe *stream_pipe;
-		struct lttng_consumer_stream *new_stream;
 		struct lttng_consumer_channel *channel;
-		int alloc_ret = 0;
-		int ret_send_status, ret_poll, ret_get_max_subbuf_size;
-		ssize_t ret_pipe_write, ret_recv;
+		int ret_send_status, ret_poll;
+		ssize_t ret_recv;
 
 		/*
 		 * Get stream's channel reference. Needed when adding the stream to the
@@ -650,166 +854,112 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 
 		health_code_update();
 
-		pthread_mutex_lock(&channel->lock);
-		new_stream = consumer_stream_create(channel,
-						    channel->key,
-						    fd,
-						    channel->name,
-						    channel->relayd_id,
-						    channel->session_id,
-						    channel->trace_chunk,
-						    msg.u.stream.cpu,
-						    &alloc_ret,
-						    channel->type,
-						    channel->monitor);
-		if (new_stream == nullptr) {
-			switch (alloc_ret) {
-			case -ENOMEM:
-			case -EINVAL:
-			default:
-				lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_OUTFD_ERROR);
-				break;
-			}
-			pthread_mutex_unlock(&channel->lock);
+		if (add_stream(ctx, channel, fd, msg.u.stream.cpu)) {
 			goto error_add_stream_nosignal;
 		}
 
-		new_stream->wait_fd = fd;
-		ret_get_max_subbuf_size =
-			kernctl_get_max_subbuf_size(new_stream->wait_fd, &new_stream->max_sb_size);
-		if (ret_get_max_subbuf_size < 0) {
-			pthread_mutex_unlock(&channel->lock);
-			ERR("Failed to get kernel maximal subbuffer size");
-			goto error_add_stream_nosignal;
-		}
-
-		consumer_stream_update_channel_attributes(new_stream, channel);
+		break;
+	error_add_stream_nosignal:
+		goto end_nosignal;
+	error_add_stream_fatal:
+		goto error_fatal;
+	}
+	case LTTNG_CONSUMER_ADD_STREAMS:
+	{
+		const uint32_t stream_count = msg.u.streams.stream_count;
+		std::vector<lttcomm_consumer_stream_desc> descriptors;
+		std::vector<int> fds;
+		struct lttng_consumer_channel *channel;
+		int ret_send_status, ret_poll;
+		ssize_t ret_recv;
+		uint32_t i = 0;
 
-		/*
-		 * We've just assigned the channel to the stream so increment the
-		 * refcount right now. We don't need to increment the refcount for
-		 * streams in no monitor because we handle manually the cleanup of
-		 * those. It is very important to make sure there is NO prior
-		 * consumer_del_stream() calls or else the refcount will be unbalanced.
-		 */
-		if (channel->monitor) {
-			uatomic_inc(&new_stream->chan->refcount);
+		channel = consumer_find_channel(msg.u.streams.channel_key);
+		if (!channel) {
+			/*
+			 * We could not find the channel. Can happen if cpu hotplug
+			 * happens while tearing down.
+			 */
+			ERR("Unable to find channel key %" PRIu64, msg.u.streams.channel_key);
+			ret_code = LTTCOMM_CONSUMERD_CHAN_NOT_FOUND;
+		} else if (stream_count == 0) {
+			ret_code = LTTCOMM_CONSUMERD_INVALID_PARAMETERS;
+		} else {
+			try {
+				descriptors.resize(stream_count);
+				fds.resize(stream_count);
+			} catch (const std::bad_alloc&) {
+				ERR("Failed to allocate the descriptors of %" PRIu32 " streams",
+				    stream_count);
+				ret_code = LTTCOMM_CONSUMERD_ENOMEM;
+			}
 		}
 
-		/*
-		 * The buffer flush is done on the session daemon side for the kernel
-		 * so no need for the stream "hangup_flush_done" variable to be
-		 * tracked. This is important for a kernel stream since we don't rely
-		 * on the flush state of the stream to read data. It's not the case for
-		 * user space tracing.
-		 */
-		new_stream->hangup_flush_done = 0;
-
 		health_code_update();
 
-		pthread_mutex_lock(&new_stream->lock);
-		if (ctx->on_recv_stream) {
-			int ret_recv_stream = ctx->on_recv_stream(new_stream);
-			if (ret_recv_stream < 0) {
-				pthread_mutex_unlock(&new_stream->lock);
-				pthread_mutex_unlock(&channel->lock);
-				consumer_stream_free(new_stream);
-				goto error_add_stream_nosignal;
-			}
+		/* First send a status message before receiving the fds. */
+		ret_send_status = consumer_send_status_msg(sock, ret_code);
+		if (ret_send_status < 0) {
+			/* Somehow, the session daemon is not responding anymore. */
+			goto error_add_streams_fatal;
 		}
+
 		health_code_update();
 
-		if (new_stream->metadata_flag) {
-			channel->metadata_stream = new_stream;
+		if (ret_code != LTTCOMM_CONSUMERD_SUCCESS) {
+			goto error_add_streams_nosignal;
 		}
 
-		/* Do not monitor this stream. */
-		if (!channel->monitor) {
-			DBG("Kernel consumer add stream %s in no monitor mode with "
-			    "relayd id %" PRIu64,
-			    new_stream->name,
-			    new_stream->net_seq_idx);
-			cds_list_add(&new_stream->send_node, &channel->streams.head);
-			pthread_mutex_unlock(&new_stream->lock);
-			pthread_mutex_unlock(&channel->lock);
-			goto end_add_stream;
+		/* Blocking call */
+		health_poll_entry();
+		ret_poll = lttng_consumer_poll_socket(consumer_sockpoll);
+		health_poll_exit();
+		if (ret_poll) {
+			goto error_add_streams_fatal;
 		}
 
-		/* Send stream to relayd if the stream has an ID. */
-		if (new_stream->net_seq_idx != (uint64_t) -1ULL) {
-			int ret_send_relayd_stream;
-
-			ret_send_relayd_stream =
-				consumer_send_relayd_stream(new_stream, new_stream->chan->pathname);
-			if (ret_send_relayd_stream < 0) {
-				pthread_mutex_unlock(&new_stream->lock);
-				pthread_mutex_unlock(&channel->lock);
-				consumer_stream_free(new_stream);
-				goto error_add_stream_nosignal;
-			}
+		health_code_update();
 
-			/*
-			 * If adding an extra stream to an already
-			 * existing channel (e.g. cpu hotplug), we need
-			 * to send the "streams_sent" command to relayd.
-			 */
-			if (channel->streams_sent_to_relayd) {
-				int ret_send_relayd_streams_sent;
-
-				ret_send_relayd_streams_sent =
-					consumer_send_relayd_streams_sent(new_stream->net_seq_idx);
-				if (ret_send_relayd_streams_sent < 0) {
-					pthread_mutex_unlock(&new_stream->lock);
-					pthread_mutex_unlock(&channel->lock);
-					goto error_add_stream_nosignal;
-				}
-			}
+		/* Get the descriptors and file descriptors of all the streams. */
+		ret_recv = lttcomm_recv_fd_batch_unix_sock(
+			sock, descriptors.data(), sizeof(descriptors[0]), fds.data(), stream_count);
+		if (ret_recv != stream_count * sizeof(descriptors[0])) {
+			lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_ERROR_RECV_FD);
+			ret_func = ret_recv;
+			goto end;
 		}
-		pthread_mutex_unlock(&new_stream->lock);
-		pthread_mutex_unlock(&channel->lock);
 
-		/* Get the right pipe where the stream will be sent. */
-		if (new_stream->metadata_flag) {
-			consumer_add_metadata_stream(new_stream);
-			stream_pipe = ctx->consumer_metadata_pipe;
-		} else {
-			consumer_add_data_stream(new_stream);
-			stream_pipe = ctx->consumer_data_pipe;
-		}
+		health_code_update();
 
-		/* Visible to other threads */
-		new_stream->globally_visible = 1;
+		/*
+		 * Send status code to session daemon only if the recv works. If the
+		 * above recv() failed, the session daemon is notified through the
+		 * error socket and the teardown is eventually done.
+		 */
+		ret_send_status = consumer_send_status_msg(sock, ret_code);
+		if (ret_send_status < 0) {
+			/* Somehow, the session daemon is not responding anymore. */
+			goto error_add_streams_close_fds;
+		}
 
 		health_code_update();
 
-		ret_pipe_write =
-			lttng_pipe_write(stream_pipe, &new_stream, sizeof(new_stream)); /* NOLINT
-											   sizeof
-											   used on a
-											   pointer.
-											 */
-		if (ret_pipe_write < 0) {
-			ERR("Consumer write %s stream to pipe %d",
-			    new_stream->metadata_flag ? "metadata" : "data",
-			    lttng_pipe_get_writefd(stream_pipe));
-			if (new_stream->metadata_flag) {
-				consumer_del_stream_for_metadata(new_stream);
-			} else {
-				consumer_del_stream_for_data(new_stream);
+		for (i = 0; i < stream_count; i++) {
+			if (add_stream(ctx, channel, fds[i], descriptors[i].cpu)) {
+				/* The fd of the failed stream is handled as for ADD_STREAM. */
+				i++;
+				goto error_add_streams_close_fds;
 			}
-			goto error_add_stream_nosignal;
 		}
 
-		DBG("Kernel consumer ADD_STREAM %s (fd: %d) %s with relayd id %" PRIu64,
-		    new_stream->name,
-		    fd,
-		    new_stream->chan->pathname,
-		    new_stream->relayd_stream_id);
-	end_add_stream:
 		break;
-	error_add_stream_nosignal:
+	error_add_streams_close_fds:
+		for (; i < stream_count; i++) {
+			(void) close(fds[i]);
+		}
+	error_add_streams_nosignal:
 		goto end_nosignal;
-	error_add_stream_fatal:
+	error_add_streams_fatal:
 		goto error_fatal;
 	}
 	case LTTNG_CONSUMER_STREAMS_SENT:
@@ -942,8 +1092,21 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 	{
 		struct lttng_consumer_channel *channel;
 		uint64_t key = msg.u.snapshot_channel.key;
+		const bool use_fd_output = msg.u.snapshot_channel.use_fd_output;
+		struct consumer_snapshot_fd_output fd_output;
 		int ret_send_status;
 
+		if (use_fd_output) {
+			int output_fd;
+
+			if (consumer_snapshot_recv_output_fd(sock, &output_fd)) {
+				goto error_fatal;
+			}
+
+			consumer_snapshot_fd_output_init(
+				&fd_output, output_fd, msg.u.snapshot_channel.pathname);
+		}
+
 		channel = consumer_find_channel(key);
 		if (!channel) {
 			ERR("Channel %" PRIu64 " not found", key);
@@ -957,6 +1120,7 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 					key,
 					msg.u.snapshot_channel.pathname,
 					msg.u.snapshot_channel.relayd_id,
+					use_fd_output ? &fd_output : nullptr,
 					ctx);
 				if (ret_snapshot < 0) {
 					ERR("Snapshot metadata failed");
@@ -970,13 +1134,20 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 					key,
 					msg.u.snapshot_channel.pathname,
 					msg.u.snapshot_channel.relayd_id,
-					msg.u.snapshot_channel.nb_packets_per_stream);
+					msg.u.snapshot_channel.nb_packets_per_stream,
+					msg.u.snapshot_channel.incremental,
+					use_fd_output ? &fd_output : nullptr);
 				if (ret_snapshot < 0) {
 					ERR("Snapshot channel failed");
 					ret_code = LTTCOMM_CONSUMERD_SNAPSHOT_FAILED;
 				}
 			}
 		}
+
+		if (use_fd_output) {
+			consumer_snapshot_fd_output_fini(&fd_output);
+		}
+
 		health_code_update();
 
 		ret_send_status = consumer_send_status_msg(sock, ret_code);
@@ -1093,6 +1264,31 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 
 		break;
 	}
+	case LTTNG_CONSUMER_CHANNEL_CONSUMPTION_STATS:
+	{
+		ssize_t ret;
+		struct lttcomm_consumer_channel_consumption_stats stats;
+		const uint64_t id = msg.u.consumption_stats.session_id;
+		const uint64_t key = msg.u.consumption_stats.channel_key;
+
+		DBG("Kernel consumer consumption stats command for session id %" PRIu64
+		    ", channel key %" PRIu64,
+		    id,
+		    key);
+
+		lttng_consumer_get_channel_consumption_stats(id, key, &stats);
+
+		health_code_update();
+
+		/* Send back returned value to session daemon */
+		ret = lttcomm_send_unix_sock(sock, &stats, sizeof(stats));
+		if (ret < 0) {
+			PERROR("send consumption stats");
+			goto error_fatal;
+		}
+
+		break;
+	}
 	case LTTNG_CONSUMER_SET_CHANNEL_MONITOR_PIPE:
 	{
 		int channel_monitor_pipe;
@@ -1143,6 +1339,32 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		}
 		break;
 	}
+	case LTTNG_CONSUMER_SET_ROTATION_EVENT_PIPE:
+	{
+		int rotation_event_pipe;
+		int ret_send_status;
+		ssize_t ret_recv;
+
+		/* Successfully received the command's type. */
+		ret_send_status = consumer_send_status_msg(sock, LTTCOMM_CONSUMERD_SUCCESS);
+		if (ret_send_status < 0) {
+			goto error_fatal;
+		}
+
+		ret_recv = lttcomm_recv_fds_unix_sock(sock, &rotation_event_pipe, 1);
+		if (ret_recv != sizeof(rotation_event_pipe)) {
+			ERR("Failed to receive rotation event pipe");
+			goto error_fatal;
+		}
+
+		DBG("Received rotation event pipe (%d)", rotation_event_pipe);
+		ret_code = lttng_consumer_set_rotation_event_pipe(rotation_event_pipe);
+		ret_send_status = consumer_send_status_msg(sock, ret_code);
+		if (ret_send_status < 0) {
+			goto error_fatal;
+		}
+		break;
+	}
 	case LTTNG_CONSUMER_ROTATE_CHANNEL:
 	{
 		struct lttng_consumer_channel *channel;
@@ -1202,7 +1424,8 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		} else {
 			int ret_clear_channel;
 
-			ret_clear_channel = lttng_consumer_clear_channel(channel);
+			ret_clear_channel = lttng_consumer_clear_channel(
+				channel, msg.u.clear_channel.truncate_output);
 			if (ret_clear_channel) {
 				ERR("Clear channel failed");
 				ret_code = (lttcomm_return_code) ret_clear_channel;
@@ -1791,8 +2014,19 @@ int lttng_kconsumer_on_recv_stream(struct lttng_consumer_stream *stream)
 		}
 		stream->mmap_len = (size_t) mmap_len;
 
-		stream->mmap_base =
-			mmap(nullptr, stream->mmap_len, PROT_READ, MAP_PRIVATE, stream->wait_fd, 0);
+		/*
+		 * The ring buffer is mapped once for the lifetime of the stream
+		 * and each sub-buffer is read in place, at the offset given by
+		 * the tracer. Populate the mapping as the stream is set up
+		 * rather than taking a page fault on each page of the first
+		 * packets consumed.
+		 */
+		stream->mmap_base = mmap(nullptr,
+					 stream->mmap_len,
+					 PROT_READ,
+					 MAP_PRIVATE | MAP_POPULATE,
+					 stream->wait_fd,
+					 0);
 		if (stream->mmap_base == MAP_FAILED) {
 			PERROR("Error mmaping");
 			ret = -1;
@@ -404,6 +404,22 @@ int kernctl_create_event(int fd, struct lttng_kernel_abi_event *ev)
 	return LTTNG_IOCTL_NO_CHECK(fd, LTTNG_KERNEL_ABI_EVENT, ev);
 }
 
+size_t
+kernctl_create_events(int fd, struct lttng_kernel_abi_event **events, int *fds, size_t count)
+{
+	size_t i, created = 0;
+
+	/* The kernel tracer creates a single event per ioctl. */
+	for (i = 0; i < count; i++) {
+		fds[i] = kernctl_create_event(fd, events[i]);
+		if (fds[i] >= 0) {
+			created++;
+		}
+	}
+
+	return created;
+}
+
 int kernctl_add_context(int fd, struct lttng_kernel_abi_context *ctx)
 {
 	if (lttng_kernel_abi_use_old_abi) {
@@ -22,6 +22,15 @@ int kernctl_open_metadata(int fd, struct lttng_channel_attr *chops);
 int kernctl_create_channel(int fd, struct lttng_channel_attr *chops);
 int kernctl_create_stream(int fd);
 int kernctl_create_event(int fd, struct lttng_kernel_abi_event *ev);
+/*
+ * Create the `count` events described by `events` in the channel `fd` in one
+ * pass, storing the file descriptor of each event, or a negative errno value
+ * if its creation failed, at the same index of `fds`.
+ *
+ * Return the number of created events.
+ */
+size_t
+kernctl_create_events(int fd, struct lttng_kernel_abi_event **events, int *fds, size_t count);
 int kernctl_add_context(int fd, struct lttng_kernel_abi_context *ctx);
 
 int kernctl_enable(int fd);
@@ -11,18 +11,25 @@
 #include <common/error.hpp>
 #include <common/lttng-elf.hpp>
 #include <common/macros.hpp>
+#include <common/pthread-lock.hpp>
 #include <common/readwrite.hpp>
 
 #include <algorithm>
 #include <elf.h>
 #include <fcntl.h>
+#include <memory>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 #define BUF_LEN				4096
 #define TEXT_SECTION_NAME		".text"
@@ -189,6 +196,20 @@ struct lttng_elf_sym {
 	uint64_t st_value;
 	uint64_t st_size;
 };
+
+/*
+ * Data of a section of a binary, mapped from the file when possible and read
+ * in a buffer otherwise.
+ */
+struct lttng_elf_section_data {
+	const char *data;
+	size_t size;
+	/* Mapping holding `data`, if the section is mapped. */
+	void *mapping;
+	size_t mapping_length;
+	/* Buffer holding `data`, if the section is read. */
+	char *buffer;
+};
 } /* namespace */
 
 struct lttng_elf {
@@ -196,13 +217,66 @@ struct lttng_elf {
 	size_t file_size;
 	uint8_t bitness;
 	uint8_t endianness;
-	/* Offset in bytes to start of section names string table. */
-	off_t section_names_offset;
-	/* Size in bytes of section names string table. */
-	size_t section_names_size;
+	/* Section names string table. */
+	struct lttng_elf_section_data section_names;
 	struct lttng_elf_ehdr *ehdr;
 };
 
+#define ELF_INDEX_CACHE_SIZE 4
+
+namespace {
+/* Location of an SDT probe, as described by its note. */
+struct sdt_probe_note {
+	uint64_t location;
+	uint64_t semaphore_location;
+};
+
+/*
+ * Index of the function symbols and of the SDT probes of a binary, built when
+ * they are first looked up.
+ *
+ * A binary is identified by its device and inode; its size and modification
+ * time tell whether it changed since it was indexed.
+ */
+struct elf_index {
+	dev_t dev = 0;
+	ino_t ino = 0;
+	off_t size = 0;
+	struct timespec mtime = {};
+
+	bool has_text_section = false;
+	struct lttng_elf_shdr text_section_hdr = {};
+
+	bool functions_indexed = false;
+	/* Address of the first function symbol of each name. */
+	std::unordered_map<std::string, uint64_t> function_addresses;
+
+	bool sdt_probes_indexed = false;
+	/* Notes of each provider and probe name pair, in section order. */
+	std::unordered_map<std::string, std::vector<sdt_probe_note>> sdt_probes;
+};
+
+/*
+ * Indexes of the most recently looked up binaries, most recent first.
+ *
+ * The probes of a binary are looked up one enabling at a time, by the same
+ * (long-lived) run-as worker: keeping the index of the binary saves parsing
+ * it again for each of them.
+ */
+std::vector<std::unique_ptr<elf_index>> elf_index_cache;
+pthread_mutex_t elf_index_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+std::string sdt_probe_key(const char *provider_name, const char *probe_name)
+{
+	std::string key(provider_name);
+
+	/* Neither name can contain a null character. */
+	key += '\0';
+	key += probe_name;
+	return key;
+}
+} /* namespace */
+
 static inline int is_elf_32_bit(struct lttng_elf *elf)
 {
 	return elf->bitness == ELFCLASS32;
@@ -341,73 +415,124 @@ error:
  *
  * If no name is found, NULL is returned.
  */
-static char *lttng_elf_get_section_name(struct lttng_elf *elf, off_t offset)
+static const char *lttng_elf_borrow_section_name(struct lttng_elf *elf, uint64_t offset)
 {
-	char *name = nullptr;
-	size_t name_length = 0, to_read; /* name_length does not include \0 */
+	const char *name;
 
 	if (!elf) {
-		goto error;
+		return nullptr;
 	}
 
-	if (offset >= elf->section_names_size) {
-		goto error;
+	if (offset >= elf->section_names.size) {
+		return nullptr;
 	}
 
-	if (lseek(elf->fd, elf->section_names_offset + offset, SEEK_SET) < 0) {
-		PERROR("Error seeking to the beginning of ELF string table section");
-		goto error;
+	name = elf->section_names.data + offset;
+	if (!memchr(name, '\0', elf->section_names.size - offset)) {
+		return nullptr;
 	}
 
-	to_read = elf->section_names_size - offset;
+	return name;
+}
+
+/*
+ * Release the data of a section, unmapping or freeing it.
+ */
+static void lttng_elf_release_section_data(struct lttng_elf_section_data *section_data)
+{
+	if (section_data->mapping && munmap(section_data->mapping, section_data->mapping_length)) {
+		PERROR("Error unmapping ELF section data");
+	}
 
-	/* Find first \0 after or at current location, remember name_length. */
-	for (;;) {
-		char buf[BUF_LEN];
-		ssize_t read_len;
-		size_t i;
+	free(section_data->buffer);
+	*section_data = {};
+}
 
-		if (!to_read) {
-			goto error;
-		}
-		read_len = lttng_read(elf->fd, buf, std::min<size_t>(BUF_LEN, to_read));
-		if (read_len <= 0) {
-			PERROR("Error reading ELF string table section");
-			goto error;
-		}
-		for (i = 0; i < read_len; i++) {
-			if (buf[i] == '\0') {
-				name_length += i;
-				goto end;
+/*
+ * Get the data of a section.
+ *
+ * The data is mapped from the binary, without copying it, when the section lies
+ * within the file; `advice` (see madvise(2)) tells how it is about to be
+ * accessed. Failing that, the data is read in a buffer.
+ *
+ * Returns 0 on success, -1 on failure. Release the data with
+ * lttng_elf_release_section_data().
+ */
+static int lttng_elf_get_section_data(struct lttng_elf *elf,
+				      const struct lttng_elf_shdr *shdr,
+				      int advice,
+				      struct lttng_elf_section_data *section_data)
+{
+	int ret;
+	char *data;
+	size_t max_alloc_size;
+
+	*section_data = {};
+
+	if (!elf || !shdr) {
+		goto error;
+	}
+
+	if (shdr->sh_size > 0 && shdr->sh_offset <= elf->file_size &&
+	    shdr->sh_size <= elf->file_size - shdr->sh_offset) {
+		const uint64_t page_size = (uint64_t) sysconf(_SC_PAGESIZE);
+		const uint64_t mapping_offset = shdr->sh_offset & ~(page_size - 1);
+		const size_t mapping_length = shdr->sh_offset - mapping_offset + shdr->sh_size;
+		void *mapping = mmap(nullptr,
+				     mapping_length,
+				     PROT_READ,
+				     MAP_PRIVATE,
+				     elf->fd,
+				     (off_t) mapping_offset);
+
+		if (mapping != MAP_FAILED) {
+			if (advice != MADV_NORMAL && madvise(mapping, mapping_length, advice)) {
+				DBG("Failed to advise the access pattern of ELF section data: %s",
+				    strerror(errno));
 			}
+
+			section_data->mapping = mapping;
+			section_data->mapping_length = mapping_length;
+			section_data->data =
+				(const char *) mapping + (shdr->sh_offset - mapping_offset);
+			section_data->size = shdr->sh_size;
+			return 0;
 		}
-		name_length += read_len;
-		to_read -= read_len;
+
+		DBG("Failed to map ELF section data, reading it instead: %s", strerror(errno));
 	}
-end:
-	/*
-	 * We found the length of the section name, now seek back to the
-	 * beginning of the name and copy it in the newly allocated buffer.
-	 */
-	name = calloc<char>((name_length + 1)); /* + 1 for \0 */
-	if (!name) {
-		PERROR("Error allocating ELF section name buffer");
+
+	max_alloc_size = std::min<size_t>(MAX_SECTION_DATA_SIZE, elf->file_size);
+
+	if (lseek(elf->fd, shdr->sh_offset, SEEK_SET) < 0) {
+		PERROR("Error seeking to section offset");
 		goto error;
 	}
-	if (lseek(elf->fd, elf->section_names_offset + offset, SEEK_SET) < 0) {
-		PERROR("Error seeking to the offset of the ELF section name");
+
+	if (shdr->sh_size > max_alloc_size) {
+		ERR("ELF section size exceeds maximal allowed size of %zu bytes", max_alloc_size);
 		goto error;
 	}
-	if (lttng_read(elf->fd, name, name_length + 1) < name_length + 1) {
-		PERROR("Error reading the ELF section name");
+	data = calloc<char>(shdr->sh_size);
+	if (!data) {
+		PERROR("Error allocating buffer for ELF section data");
 		goto error;
 	}
+	ret = lttng_read(elf->fd, data, shdr->sh_size);
+	if (ret == -1) {
+		PERROR("Error reading ELF section data");
+		goto free_error;
+	}
 
-	return name;
+	section_data->buffer = data;
+	section_data->data = data;
+	section_data->size = shdr->sh_size;
+	return 0;
 
+free_error:
+	free(data);
 error:
-	free(name);
-	return nullptr;
+	return -1;
 }
 
 static int lttng_elf_validate_and_populate(struct lttng_elf *elf)
@@ -564,12 +689,17 @@ static struct lttng_elf *lttng_elf_create(int fd)
 		goto error;
 	}
 
-	elf->section_names_offset = section_names_shdr.sh_offset;
-	elf->section_names_size = section_names_shdr.sh_size;
+	ret = lttng_elf_get_section_data(
+		elf, &section_names_shdr, MADV_NORMAL, &elf->section_names);
+	if (ret) {
+		goto error;
+	}
+
 	return elf;
 
 error:
 	if (elf) {
+		lttng_elf_release_section_data(&elf->section_names);
 		if (elf->ehdr) {
 			free(elf->ehdr);
 		}
@@ -593,6 +723,7 @@ static void lttng_elf_destroy(struct lttng_elf *elf)
 		return;
 	}
 
+	lttng_elf_release_section_data(&elf->section_names);
 	free(elf->ehdr);
 	if (close(elf->fd)) {
 		PERROR("Error closing file description in error path");
@@ -606,78 +737,34 @@ static int lttng_elf_get_section_hdr_by_name(struct lttng_elf *elf,
 					     struct lttng_elf_shdr *section_hdr)
 {
 	int i;
-	char *curr_section_name;
+	const char *curr_section_name;
 
 	for (i = 0; i < elf->ehdr->e_shnum; ++i) {
-		bool name_equal;
 		int ret = lttng_elf_get_section_hdr(elf, i, section_hdr);
 
 		if (ret) {
 			break;
 		}
-		curr_section_name = lttng_elf_get_section_name(elf, section_hdr->sh_name);
+		curr_section_name = lttng_elf_borrow_section_name(elf, section_hdr->sh_name);
 		if (!curr_section_name) {
 			continue;
 		}
-		name_equal = strcmp(curr_section_name, section_name) == 0;
-		free(curr_section_name);
-		if (name_equal) {
+		if (strcmp(curr_section_name, section_name) == 0) {
 			return 0;
 		}
 	}
 	return LTTNG_ERR_ELF_PARSING;
 }
 
-static char *lttng_elf_get_section_data(struct lttng_elf *elf, struct lttng_elf_shdr *shdr)
-{
-	int ret;
-	off_t section_offset;
-	char *data;
-	size_t max_alloc_size;
-
-	if (!elf || !shdr) {
-		goto error;
-	}
-
-	max_alloc_size = std::min<size_t>(MAX_SECTION_DATA_SIZE, elf->file_size);
-
-	section_offset = shdr->sh_offset;
-	if (lseek(elf->fd, section_offset, SEEK_SET) < 0) {
-		PERROR("Error seeking to section offset");
-		goto error;
-	}
-
-	if (shdr->sh_size > max_alloc_size) {
-		ERR("ELF section size exceeds maximal allowed size of %zu bytes", max_alloc_size);
-		goto error;
-	}
-	data = calloc<char>(shdr->sh_size);
-	if (!data) {
-		PERROR("Error allocating buffer for ELF section data");
-		goto error;
-	}
-	ret = lttng_read(elf->fd, data, shdr->sh_size);
-	if (ret == -1) {
-		PERROR("Error reading ELF section data");
-		goto free_error;
-	}
-
-	return data;
-
-free_error:
-	free(data);
-error:
-	return nullptr;
-}
-
 /*
  * Convert the virtual address in a binary's mapping to the offset of
  * the corresponding instruction in the binary file.
- * This function assumes the address is in the text section.
+ * This function assumes the address is in the text section of the binary
+ * described by `index`.
  *
  * Returns the offset on success or non-zero in case of failure.
  */
-static int lttng_elf_convert_addr_in_text_to_offset(struct lttng_elf *elf_handle,
+static int lttng_elf_convert_addr_in_text_to_offset(const struct elf_index *index,
 						    size_t addr,
 						    uint64_t *offset)
 {
@@ -686,25 +773,16 @@ static int lttng_elf_convert_addr_in_text_to_offset(struct lttng_elf *elf_handle
 	off_t text_section_addr_beg;
 	off_t text_section_addr_end;
 	off_t offset_in_section;
-	struct lttng_elf_shdr text_section_hdr;
-
-	if (!elf_handle) {
-		DBG("Invalid ELF handle.");
-		ret = LTTNG_ERR_ELF_PARSING;
-		goto error;
-	}
 
-	/* Get a pointer to the .text section header. */
-	ret = lttng_elf_get_section_hdr_by_name(elf_handle, TEXT_SECTION_NAME, &text_section_hdr);
-	if (ret) {
+	if (!index->has_text_section) {
 		DBG("Text section not found in binary.");
 		ret = LTTNG_ERR_ELF_PARSING;
 		goto error;
 	}
 
-	text_section_offset = text_section_hdr.sh_offset;
-	text_section_addr_beg = text_section_hdr.sh_addr;
-	text_section_addr_end = text_section_addr_beg + text_section_hdr.sh_size;
+	text_section_offset = index->text_section_hdr.sh_offset;
+	text_section_addr_beg = index->text_section_hdr.sh_addr;
+	text_section_addr_end = text_section_addr_beg + index->text_section_hdr.sh_size;
 
 	/*
 	 * Verify that the address is within the .text section boundaries.
@@ -732,37 +810,90 @@ error:
 }
 
 /*
- * Compute the offset of a symbol from the begining of the ELF binary.
+ * Get the index of the binary open as `fd`, replacing its cached index if the
+ * binary changed since it was indexed. A binary which is not cached gets an
+ * empty index, evicting the least recently used one of a full cache.
  *
- * On success, returns 0 offset parameter is set to the computed value
- * On failure, returns -1.
+ * Called with the cache lock held. Returns NULL if the binary can't be
+ * identified.
  */
-int lttng_elf_get_symbol_offset(int fd, char *symbol, uint64_t *offset)
+static struct elf_index *get_elf_index(int fd)
+{
+	struct stat stat_buf;
+
+	if (fstat(fd, &stat_buf)) {
+		PERROR("Failed to identify ELF binary: fd = %d", fd);
+		return nullptr;
+	}
+
+	for (auto it = elf_index_cache.begin(); it != elf_index_cache.end(); ++it) {
+		const elf_index& index = **it;
+
+		if (index.dev != stat_buf.st_dev || index.ino != stat_buf.st_ino) {
+			continue;
+		}
+
+		if (index.size == stat_buf.st_size &&
+		    index.mtime.tv_sec == stat_buf.st_mtim.tv_sec &&
+		    index.mtime.tv_nsec == stat_buf.st_mtim.tv_nsec) {
+			std::rotate(elf_index_cache.begin(), it, it + 1);
+			return elf_index_cache.front().get();
+		}
+
+		DBG("ELF binary changed since it was indexed: fd = %d", fd);
+		elf_index_cache.erase(it);
+		break;
+	}
+
+	if (elf_index_cache.size() == ELF_INDEX_CACHE_SIZE) {
+		elf_index_cache.pop_back();
+	}
+
+	std::unique_ptr<elf_index> index(new elf_index());
+
+	index->dev = stat_buf.st_dev;
+	index->ino = stat_buf.st_ino;
+	index->size = stat_buf.st_size;
+	index->mtime = stat_buf.st_mtim;
+	elf_index_cache.insert(elf_index_cache.begin(), std::move(index));
+	return elf_index_cache.front().get();
+}
+
+static void index_text_section(struct lttng_elf *elf, struct elf_index *index)
+{
+	const int ret =
+		lttng_elf_get_section_hdr_by_name(elf, TEXT_SECTION_NAME, &index->text_section_hdr);
+
+	index->has_text_section = ret == 0;
+}
+
+/*
+ * Index the function symbols of the binary open as `fd`, along with the header
+ * of its text section.
+ *
+ * Returns 0 on success, non-zero on failure.
+ */
+static int index_function_symbols(int fd, struct elf_index *index)
 {
 	int ret = 0;
-	int sym_found = 0;
 	int sym_count = 0;
 	int sym_idx = 0;
-	uint64_t addr = 0;
-	char *curr_sym_str = nullptr;
-	char *symbol_table_data = nullptr;
-	char *string_table_data = nullptr;
+	const char *curr_sym_str = nullptr;
+	struct lttng_elf_section_data symbol_table_data = {};
+	struct lttng_elf_section_data string_table_data = {};
 	const char *string_table_name = nullptr;
 	struct lttng_elf_shdr symtab_hdr;
 	struct lttng_elf_shdr strtab_hdr;
 	struct lttng_elf *elf = nullptr;
 
-	if (!symbol || !offset) {
-		ret = LTTNG_ERR_ELF_PARSING;
-		goto end;
-	}
-
 	elf = lttng_elf_create(fd);
 	if (!elf) {
 		ret = LTTNG_ERR_ELF_PARSING;
 		goto end;
 	}
 
+	index_text_section(elf, index);
+
 	/*
 	 * The .symtab section might not exist on stripped binaries.
 	 * Try to get the symbol table section header first. If it's absent,
@@ -786,8 +917,8 @@ int lttng_elf_get_symbol_offset(int fd, char *symbol, uint64_t *offset)
 	}
 
 	/* Get the data associated with the symbol table section. */
-	symbol_table_data = lttng_elf_get_section_data(elf, &symtab_hdr);
-	if (symbol_table_data == nullptr) {
+	ret = lttng_elf_get_section_data(elf, &symtab_hdr, MADV_SEQUENTIAL, &symbol_table_data);
+	if (ret) {
 		DBG("Cannot get ELF Symbol Table data.");
 		ret = LTTNG_ERR_ELF_PARSING;
 		goto destroy_elf;
@@ -801,8 +932,8 @@ int lttng_elf_get_symbol_offset(int fd, char *symbol, uint64_t *offset)
 	}
 
 	/* Get the data associated with the string table section. */
-	string_table_data = lttng_elf_get_section_data(elf, &strtab_hdr);
-	if (string_table_data == nullptr) {
+	ret = lttng_elf_get_section_data(elf, &strtab_hdr, MADV_NORMAL, &string_table_data);
+	if (ret) {
 		DBG("Cannot get ELF string table section data.");
 		ret = LTTNG_ERR_ELF_PARSING;
 		goto free_symbol_table_data;
@@ -817,72 +948,67 @@ int lttng_elf_get_symbol_offset(int fd, char *symbol, uint64_t *offset)
 
 	sym_count = symtab_hdr.sh_size / symtab_hdr.sh_entsize;
 
-	/* Loop over all symbol. */
-	for (sym_idx = 0; sym_idx < sym_count; sym_idx++) {
-		struct lttng_elf_sym curr_sym;
-
-		/* Get the symbol at the current index. */
-		if (is_elf_32_bit(elf)) {
-			Elf32_Sym tmp = ((Elf32_Sym *) symbol_table_data)[sym_idx];
-			copy_sym(tmp, curr_sym);
-		} else {
-			Elf64_Sym tmp = ((Elf64_Sym *) symbol_table_data)[sym_idx];
-			copy_sym(tmp, curr_sym);
-		}
+	try {
+		/* Loop over all symbol. */
+		for (sym_idx = 0; sym_idx < sym_count; sym_idx++) {
+			struct lttng_elf_sym curr_sym;
+
+			/* Get the symbol at the current index. */
+			if (is_elf_32_bit(elf)) {
+				Elf32_Sym tmp;
+				const char *sym_data =
+					symbol_table_data.data + sym_idx * sizeof(tmp);
+
+				memcpy(&tmp, sym_data, sizeof(tmp));
+				copy_sym(tmp, curr_sym);
+			} else {
+				Elf64_Sym tmp;
+				const char *sym_data =
+					symbol_table_data.data + sym_idx * sizeof(tmp);
+
+				memcpy(&tmp, sym_data, sizeof(tmp));
+				copy_sym(tmp, curr_sym);
+			}
 
-		/*
-		 * If the st_name field is zero, there is no string name for
-		 * this symbol; skip to the next symbol.
-		 */
-		if (curr_sym.st_name == 0) {
-			continue;
-		}
+			/*
+			 * If the st_name field is zero, there is no string name for
+			 * this symbol; skip to the next symbol.
+			 */
+			if (curr_sym.st_name == 0) {
+				continue;
+			}
 
-		/*
-		 * Use the st_name field in the lttng_elf_sym struct to get offset of
-		 * the symbol's name from the beginning of the string table.
-		 */
-		curr_sym_str = string_table_data + curr_sym.st_name;
+			/*
+			 * Use the st_name field in the lttng_elf_sym struct to get offset
+			 * of the symbol's name from the beginning of the string table.
+			 */
+			curr_sym_str = string_table_data.data + curr_sym.st_name;
 
-		/*
-		 * If the current symbol is not a function; skip to the next symbol.
-		 */
-		/* Both 32bit and 64bit use the same 1 byte field for type. (See elf.h) */
-		if (ELF32_ST_TYPE(curr_sym.st_info) != STT_FUNC) {
-			continue;
-		}
+			/*
+			 * If the current symbol is not a function; skip to the next
+			 * symbol. Both 32bit and 64bit use the same 1 byte field for
+			 * type. (See elf.h)
+			 */
+			if (ELF32_ST_TYPE(curr_sym.st_info) != STT_FUNC) {
+				continue;
+			}
 
-		/*
-		 * Compare with the search symbol. If there is a match set the address
-		 * output parameter and return success.
-		 */
-		if (strcmp(symbol, curr_sym_str) == 0) {
-			sym_found = 1;
-			addr = curr_sym.st_value;
-			break;
+			/* Only the first symbol of a given name is looked up. */
+			index->function_addresses.emplace(curr_sym_str, curr_sym.st_value);
 		}
-	}
-
-	if (!sym_found) {
-		DBG("Symbol not found.");
-		ret = LTTNG_ERR_ELF_PARSING;
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate ELF function symbol index");
+		index->function_addresses.clear();
+		ret = LTTNG_ERR_NOMEM;
 		goto free_string_table_data;
 	}
 
-	/*
-	 * Use the virtual address of the symbol to compute the offset of this
-	 * symbol from the beginning of the executable file.
-	 */
-	ret = lttng_elf_convert_addr_in_text_to_offset(elf, addr, offset);
-	if (ret) {
-		DBG("Cannot convert addr to offset.");
-		goto free_string_table_data;
-	}
+	index->functions_indexed = true;
 
 free_string_table_data:
-	free(string_table_data);
+	lttng_elf_release_section_data(&string_table_data);
 free_symbol_table_data:
-	free(symbol_table_data);
+	lttng_elf_release_section_data(&symbol_table_data);
 destroy_elf:
 	lttng_elf_destroy(elf);
 end:
@@ -890,34 +1016,73 @@ end:
 }
 
 /*
- * Compute the offsets of SDT probes from the begining of the ELF binary.
+ * Compute the offset of a symbol from the begining of the ELF binary.
  *
- * On success, returns 0 and the nb_probes parameter is set to the number of
- * offsets found and the offsets parameter points to an array of offsets where
- * the SDT probes are.
+ * On success, returns 0 offset parameter is set to the computed value
  * On failure, returns -1.
  */
-int lttng_elf_get_sdt_probe_offsets(int fd,
-				    const char *provider_name,
-				    const char *probe_name,
-				    uint64_t **offsets,
-				    uint32_t *nb_probes)
+int lttng_elf_get_symbol_offset(int fd, char *symbol, uint64_t *offset)
+{
+	int ret = 0;
+	struct elf_index *index;
+
+	if (!symbol || !offset) {
+		return LTTNG_ERR_ELF_PARSING;
+	}
+
+	try {
+		const lttng::pthread::lock_guard cache_lock(elf_index_cache_lock);
+
+		index = get_elf_index(fd);
+		if (!index) {
+			return LTTNG_ERR_ELF_PARSING;
+		}
+
+		if (!index->functions_indexed) {
+			ret = index_function_symbols(fd, index);
+			if (ret) {
+				return ret;
+			}
+		}
+
+		const auto function = index->function_addresses.find(symbol);
+		if (function == index->function_addresses.end()) {
+			DBG("Symbol not found.");
+			return LTTNG_ERR_ELF_PARSING;
+		}
+
+		/*
+		 * Use the virtual address of the symbol to compute the offset of
+		 * this symbol from the beginning of the executable file.
+		 */
+		ret = lttng_elf_convert_addr_in_text_to_offset(index, function->second, offset);
+		if (ret) {
+			DBG("Cannot convert addr to offset.");
+		}
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate ELF binary index");
+		ret = LTTNG_ERR_NOMEM;
+	}
+
+	return ret;
+}
+
+/*
+ * Index the SDT probes of the binary open as `fd`, along with the header of its
+ * text section.
+ *
+ * Returns 0 on success, non-zero on failure.
+ */
+static int index_sdt_probes(int fd, struct elf_index *index)
 {
-	int ret = 0, nb_match = 0;
+	int ret = 0;
 	struct lttng_elf_shdr stap_note_section_hdr;
 	struct lttng_elf *elf = nullptr;
-	char *stap_note_section_data = nullptr;
-	char *curr_note_section_begin, *curr_data_ptr, *curr_probe, *curr_provider;
-	char *next_note_ptr;
+	struct lttng_elf_section_data stap_note_section_data = {};
+	const char *curr_note_section_begin, *curr_data_ptr, *curr_probe, *curr_provider;
+	const char *next_note_ptr;
 	uint32_t name_size, desc_size, note_type;
-	uint64_t curr_probe_location, curr_probe_offset, curr_semaphore_location;
-	uint64_t *probe_locs = nullptr, *new_probe_locs = nullptr;
-
-	if (!provider_name || !probe_name || !nb_probes || !offsets) {
-		DBG("Invalid arguments.");
-		ret = LTTNG_ERR_ELF_PARSING;
-		goto error;
-	}
+	uint64_t curr_probe_location, curr_semaphore_location;
 
 	elf = lttng_elf_create(fd);
 	if (!elf) {
@@ -926,6 +1091,8 @@ int lttng_elf_get_sdt_probe_offsets(int fd,
 		goto error;
 	}
 
+	index_text_section(elf, index);
+
 	/* Get the stap note section header. */
 	ret = lttng_elf_get_section_hdr_by_name(
 		elf, NOTE_STAPSDT_SECTION_NAME, &stap_note_section_hdr);
@@ -935,28 +1102,27 @@ int lttng_elf_get_sdt_probe_offsets(int fd,
 	}
 
 	/* Get the data associated with the stap note section. */
-	stap_note_section_data = lttng_elf_get_section_data(elf, &stap_note_section_hdr);
-	if (stap_note_section_data == nullptr) {
+	ret = lttng_elf_get_section_data(
+		elf, &stap_note_section_hdr, MADV_SEQUENTIAL, &stap_note_section_data);
+	if (ret) {
 		DBG("Cannot get ELF stap note section data.");
 		ret = LTTNG_ERR_ELF_PARSING;
 		goto destroy_elf_error;
 	}
 
-	next_note_ptr = stap_note_section_data;
-	curr_note_section_begin = stap_note_section_data;
+	next_note_ptr = stap_note_section_data.data;
+	curr_note_section_begin = stap_note_section_data.data;
 
-	*offsets = nullptr;
 	while (true) {
 		curr_data_ptr = next_note_ptr;
 		/* Check if we have reached the end of the note section. */
 		if (curr_data_ptr >= curr_note_section_begin + stap_note_section_hdr.sh_size) {
-			*nb_probes = nb_match;
-			*offsets = probe_locs;
+			index->sdt_probes_indexed = true;
 			ret = 0;
 			break;
 		}
 		/* Get name size field. */
-		name_size = next_4bytes_boundary(*(uint32_t *) curr_data_ptr);
+		name_size = next_4bytes_boundary(*(const uint32_t *) curr_data_ptr);
 		curr_data_ptr += sizeof(uint32_t);
 
 		/* Sanity check; a zero name_size is reserved. */
@@ -964,15 +1130,15 @@ int lttng_elf_get_sdt_probe_offsets(int fd,
 			DBG("Invalid name size field in SDT probe descriptions"
 			    "section.");
 			ret = -1;
-			goto realloc_error;
+			goto index_error;
 		}
 
 		/* Get description size field. */
-		desc_size = next_4bytes_boundary(*(uint32_t *) curr_data_ptr);
+		desc_size = next_4bytes_boundary(*(const uint32_t *) curr_data_ptr);
 		curr_data_ptr += sizeof(uint32_t);
 
 		/* Get type field. */
-		note_type = *(uint32_t *) curr_data_ptr;
+		note_type = *(const uint32_t *) curr_data_ptr;
 		curr_data_ptr += sizeof(uint32_t);
 
 		/*
@@ -996,14 +1162,14 @@ int lttng_elf_get_sdt_probe_offsets(int fd,
 		curr_data_ptr += name_size;
 
 		/* Get probe location.  */
-		curr_probe_location = *(uint64_t *) curr_data_ptr;
+		curr_probe_location = *(const uint64_t *) curr_data_ptr;
 		curr_data_ptr += sizeof(uint64_t);
 
 		/* Pass over the base. Not needed. */
 		curr_data_ptr += sizeof(uint64_t);
 
 		/* Get semaphore location. */
-		curr_semaphore_location = *(uint64_t *) curr_data_ptr;
+		curr_semaphore_location = *(const uint64_t *) curr_data_ptr;
 		curr_data_ptr += sizeof(uint64_t);
 		/* Get provider name. */
 		curr_provider = curr_data_ptr;
@@ -1012,59 +1178,110 @@ int lttng_elf_get_sdt_probe_offsets(int fd,
 		/* Get probe name. */
 		curr_probe = curr_data_ptr;
 
-		/* Check if the provider and probe name match */
-		if (strcmp(provider_name, curr_provider) == 0 &&
-		    strcmp(probe_name, curr_probe) == 0) {
-			int new_size;
+		try {
+			index->sdt_probes[sdt_probe_key(curr_provider, curr_probe)].push_back(
+				{ curr_probe_location, curr_semaphore_location });
+		} catch (const std::bad_alloc&) {
+			ERR("Failed to allocate ELF SDT probe index");
+			ret = LTTNG_ERR_NOMEM;
+			goto index_error;
+		}
+	}
 
-			/*
-			 * We currently don't support SDT probes with semaphores. Return
-			 * success as we found a matching probe but it's guarded by a
-			 * semaphore.
-			 */
-			if (curr_semaphore_location != 0) {
-				ret = LTTNG_ERR_SDT_PROBE_SEMAPHORE;
-				goto realloc_error;
+end:
+	lttng_elf_release_section_data(&stap_note_section_data);
+destroy_elf_error:
+	lttng_elf_destroy(elf);
+error:
+	return ret;
+index_error:
+	index->sdt_probes.clear();
+	goto end;
+}
+
+/*
+ * Compute the offsets of SDT probes from the begining of the ELF binary.
+ *
+ * On success, returns 0 and the nb_probes parameter is set to the number of
+ * offsets found and the offsets parameter points to an array of offsets where
+ * the SDT probes are.
+ * On failure, returns -1.
+ */
+int lttng_elf_get_sdt_probe_offsets(int fd,
+				    const char *provider_name,
+				    const char *probe_name,
+				    uint64_t **offsets,
+				    uint32_t *nb_probes)
+{
+	int ret = 0;
+	struct elf_index *index;
+	uint64_t *probe_locs = nullptr;
+	uint32_t nb_match = 0;
+
+	if (!provider_name || !probe_name || !nb_probes || !offsets) {
+		DBG("Invalid arguments.");
+		return LTTNG_ERR_ELF_PARSING;
+	}
+
+	try {
+		const lttng::pthread::lock_guard cache_lock(elf_index_cache_lock);
+
+		index = get_elf_index(fd);
+		if (!index) {
+			DBG("Error allocation ELF.");
+			return LTTNG_ERR_ELF_PARSING;
+		}
+
+		if (!index->sdt_probes_indexed) {
+			ret = index_sdt_probes(fd, index);
+			if (ret) {
+				return ret;
 			}
+		}
 
-			new_size = (++nb_match) * sizeof(uint64_t);
+		const auto probes =
+			index->sdt_probes.find(sdt_probe_key(provider_name, probe_name));
+		if (probes != index->sdt_probes.end()) {
+			for (const auto& probe : probes->second) {
+				/*
+				 * We currently don't support SDT probes with
+				 * semaphores.
+				 */
+				if (probe.semaphore_location != 0) {
+					return LTTNG_ERR_SDT_PROBE_SEMAPHORE;
+				}
+			}
 
-			/*
-			 * Found a match with not semaphore, we need to copy the
-			 * probe_location to the output parameter.
-			 */
-			new_probe_locs = (uint64_t *) realloc(probe_locs, new_size);
-			if (!new_probe_locs) {
-				/* Error allocating a larger buffer */
+			probe_locs = calloc<uint64_t>(probes->second.size());
+			if (!probe_locs) {
 				DBG("Allocation error in SDT.");
-				ret = LTTNG_ERR_NOMEM;
-				goto realloc_error;
+				return LTTNG_ERR_NOMEM;
 			}
-			probe_locs = new_probe_locs;
-			new_probe_locs = nullptr;
 
-			/*
-			 * Use the virtual address of the probe to compute the offset of
-			 * this probe from the beginning of the executable file.
-			 */
-			ret = lttng_elf_convert_addr_in_text_to_offset(
-				elf, curr_probe_location, &curr_probe_offset);
-			if (ret) {
-				DBG("Conversion error in SDT.");
-				goto realloc_error;
+			for (const auto& probe : probes->second) {
+				/*
+				 * Use the virtual address of the probe to compute the
+				 * offset of this probe from the beginning of the
+				 * executable file.
+				 */
+				ret = lttng_elf_convert_addr_in_text_to_offset(
+					index, probe.location, &probe_locs[nb_match]);
+				if (ret) {
+					DBG("Conversion error in SDT.");
+					free(probe_locs);
+					return ret;
+				}
+
+				nb_match++;
 			}
-
-			probe_locs[nb_match - 1] = curr_probe_offset;
 		}
+	} catch (const std::bad_alloc&) {
+		ERR("Failed to allocate ELF binary index");
+		free(probe_locs);
+		return LTTNG_ERR_NOMEM;
 	}
 
-end:
-	free(stap_note_section_data);
-destroy_elf_error:
-	lttng_elf_destroy(elf);
-error:
+	*nb_probes = nb_match;
+	*offsets = probe_locs;
 	return ret;
-realloc_error:
-	free(probe_locs);
-	goto end;
 }
@@ -9,6 +9,7 @@
 #ifndef _MACROS_H
 #define _MACROS_H
 
+#include <common/alloc-stats.hpp>
 #include <common/compat/string.hpp>
 
 #include <memory>
@@ -85,6 +86,7 @@ template <typename MallocableType>
 MallocableType *zmalloc()
 {
 	static_assert(can_malloc<MallocableType>::value, "type can be malloc'ed");
+	lttng::alloc_stats::count<MallocableType>(sizeof(MallocableType));
 	return (MallocableType *) zmalloc_internal(sizeof(MallocableType)); /* NOLINT sizeof
 									       potentially used on a
 									       pointer. */
@@ -99,6 +101,7 @@ AllocatedType *zmalloc(size_t size)
 {
 	static_assert(can_malloc<AllocatedType>::value, "type can be malloc'ed");
 	LTTNG_ASSERT(size >= sizeof(AllocatedType));
+	lttng::alloc_stats::count<AllocatedType>(size);
 	return (AllocatedType *) zmalloc_internal(size);
 }
 
@@ -110,6 +113,7 @@ template <typename AllocatedType>
 AllocatedType *calloc(size_t nmemb)
 {
 	static_assert(can_malloc<AllocatedType>::value, "type can be malloc'ed");
+	lttng::alloc_stats::count<AllocatedType>(nmemb * sizeof(AllocatedType));
 	return (AllocatedType *) zmalloc_internal(nmemb * sizeof(AllocatedType)); /* NOLINT sizeof
 										     potentially
 										     used on a
@@ -124,6 +128,7 @@ template <typename AllocatedType>
 AllocatedType *malloc()
 {
 	static_assert(can_malloc<AllocatedType>::value, "type can be malloc'ed");
+	lttng::alloc_stats::count<AllocatedType>(sizeof(AllocatedType));
 	return (AllocatedType *) malloc(sizeof(AllocatedType));
 }
 
@@ -135,6 +140,7 @@ template <typename AllocatedType>
 AllocatedType *malloc(size_t size)
 {
 	static_assert(can_malloc<AllocatedType>::value, "type can be malloc'ed");
+	lttng::alloc_stats::count<AllocatedType>(size);
 	return (AllocatedType *) malloc(size);
 }
 
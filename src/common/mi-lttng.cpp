@@ -15,6 +15,7 @@
 #include <common/tracker.hpp>
 
 #include <lttng/channel.h>
+#include <lttng/rotate-internal.hpp>
 #include <lttng/snapshot-internal.hpp>
 
 #define MI_SCHEMA_MAJOR_VERSION 4
@@ -199,6 +200,7 @@ const char *const mi_lttng_element_rotation_location_relay_control_port = "contr
 const char *const mi_lttng_element_rotation_location_relay_data_port = "data_port";
 const char *const mi_lttng_element_rotation_location_relay_protocol = "protocol";
 const char *const mi_lttng_element_rotation_location_relay_relative_path = "relative_path";
+const char *const mi_lttng_element_rotation_phase_durations = "phase_durations";
 
 /* String related to enum lttng_rotation_state */
 const char *const mi_lttng_rotation_state_str_ongoing = "ONGOING";
@@ -209,6 +211,12 @@ const char *const mi_lttng_rotation_state_str_error = "ERROR";
 /* String related to enum lttng_trace_archive_location_relay_protocol_type */
 const char *const mi_lttng_rotation_location_relay_protocol_str_tcp = "TCP";
 
+/* String related to enum lttng_rotation_phase */
+const char *const mi_lttng_rotation_phase_str_create_trace_chunk = "create_trace_chunk";
+const char *const mi_lttng_rotation_phase_str_rotate_streams = "rotate_streams";
+const char *const mi_lttng_rotation_phase_str_close_trace_chunk = "close_trace_chunk";
+const char *const mi_lttng_rotation_phase_str_wait_data = "wait_data";
+
 /* String related to rate_policy elements */
 const char *const mi_lttng_element_rate_policy = "rate_policy";
 const char *const mi_lttng_element_rate_policy_every_n = "rate_policy_every_n";
@@ -231,6 +239,8 @@ const char *const mi_lttng_element_action_snapshot_session_output = "output";
 const char *const mi_lttng_element_condition = "condition";
 const char *const mi_lttng_element_condition_buffer_usage_high = "condition_buffer_usage_high";
 const char *const mi_lttng_element_condition_buffer_usage_low = "condition_buffer_usage_low";
+const char *const mi_lttng_element_condition_channel_rate_high = "condition_channel_rate_high";
+const char *const mi_lttng_element_condition_channel_rate_low = "condition_channel_rate_low";
 const char *const mi_lttng_element_condition_event_rule_matches = "condition_event_rule_matches";
 const char *const mi_lttng_element_condition_session_consumed_size =
 	"condition_session_consumed_size";
@@ -243,6 +253,13 @@ const char *const mi_lttng_element_condition_session_rotation_ongoing =
 const char *const mi_lttng_element_condition_channel_name = "channel_name";
 const char *const mi_lttng_element_condition_threshold_bytes = "threshold_bytes";
 const char *const mi_lttng_element_condition_threshold_ratio = "threshold_ratio";
+const char *const mi_lttng_element_condition_statistic = "statistic";
+const char *const mi_lttng_element_condition_threshold_per_second = "threshold_per_second";
+const char *const mi_lttng_element_condition_window_us = "window_us";
+const char *const mi_lttng_condition_channel_rate_statistic_consumed_bytes = "CONSUMED_BYTES";
+const char *const mi_lttng_condition_channel_rate_statistic_discarded_events =
+	"DISCARDED_EVENTS";
+const char *const mi_lttng_condition_channel_rate_statistic_lost_packets = "LOST_PACKETS";
 
 /* String related to capture descriptor */
 const char *const mi_lttng_element_capture_descriptor = "capture_descriptor";
@@ -673,6 +690,24 @@ const char *mi_lttng_rotation_state_string(enum lttng_rotation_state value)
 	}
 }
 
+const char *mi_lttng_rotation_phase_string(enum lttng_rotation_phase value)
+{
+	switch (value) {
+	case LTTNG_ROTATION_PHASE_CREATE_TRACE_CHUNK:
+		return mi_lttng_rotation_phase_str_create_trace_chunk;
+	case LTTNG_ROTATION_PHASE_ROTATE_STREAMS:
+		return mi_lttng_rotation_phase_str_rotate_streams;
+	case LTTNG_ROTATION_PHASE_CLOSE_TRACE_CHUNK:
+		return mi_lttng_rotation_phase_str_close_trace_chunk;
+	case LTTNG_ROTATION_PHASE_WAIT_DATA:
+		return mi_lttng_rotation_phase_str_wait_data;
+	default:
+		/* Should not have an unknown rotation phase. */
+		abort();
+		return nullptr;
+	}
+}
+
 const char *mi_lttng_trace_archive_location_relay_protocol_type_string(
 	enum lttng_trace_archive_location_relay_protocol_type value)
 {
@@ -732,6 +767,11 @@ end:
 	return ret;
 }
 
+int mi_lttng_writer_flush(struct mi_writer *writer)
+{
+	return config_writer_flush(writer->writer);
+}
+
 int mi_lttng_writer_command_open(struct mi_writer *writer, const char *command)
 {
 	int ret;
@@ -2489,7 +2529,8 @@ end:
 int mi_lttng_rotate(struct mi_writer *writer,
 		    const char *session_name,
 		    enum lttng_rotation_state rotation_state,
-		    const struct lttng_trace_archive_location *location)
+		    const struct lttng_trace_archive_location *location,
+		    const uint64_t *phase_durations_us)
 {
 	int ret;
 
@@ -2513,7 +2554,7 @@ int mi_lttng_rotate(struct mi_writer *writer,
 
 	if (!location) {
 		/* Not a serialization error. */
-		goto close_rotation;
+		goto write_phase_durations;
 	}
 
 	ret = mi_lttng_writer_open_element(writer, mi_lttng_element_rotation_location);
@@ -2533,6 +2574,33 @@ close_location:
 		goto end;
 	}
 
+write_phase_durations:
+	if (!phase_durations_us) {
+		/* Not a serialization error. */
+		goto close_rotation;
+	}
+
+	ret = mi_lttng_writer_open_element(writer, mi_lttng_element_rotation_phase_durations);
+	if (ret) {
+		goto end;
+	}
+
+	for (int phase = 0; phase < LTTNG_ROTATION_PHASE_COUNT; phase++) {
+		ret = mi_lttng_writer_write_element_unsigned_int(
+			writer,
+			mi_lttng_rotation_phase_string((enum lttng_rotation_phase) phase),
+			phase_durations_us[phase]);
+		if (ret) {
+			goto end;
+		}
+	}
+
+	/* Close phase durations element */
+	ret = mi_lttng_writer_close_element(writer);
+	if (ret) {
+		goto end;
+	}
+
 close_rotation:
 	/* Close rotation element */
 	ret = mi_lttng_writer_close_element(writer);
@@ -221,6 +221,7 @@ extern const char *const mi_lttng_element_rotation_location_relay_control_port;
 extern const char *const mi_lttng_element_rotation_location_relay_data_port;
 extern const char *const mi_lttng_element_rotation_location_relay_protocol;
 extern const char *const mi_lttng_element_rotation_location_relay_relative_path;
+extern const char *const mi_lttng_element_rotation_phase_durations;
 
 /* String related to enum lttng_rotation_state */
 extern const char *const mi_lttng_rotation_state_str_ongoing;
@@ -231,6 +232,12 @@ extern const char *const mi_lttng_rotation_state_str_error;
 /* String related to enum lttng_trace_archive_location_relay_protocol_type */
 extern const char *const mi_lttng_rotation_location_relay_protocol_str_tcp;
 
+/* String related to enum lttng_rotation_phase */
+extern const char *const mi_lttng_rotation_phase_str_create_trace_chunk;
+extern const char *const mi_lttng_rotation_phase_str_rotate_streams;
+extern const char *const mi_lttng_rotation_phase_str_close_trace_chunk;
+extern const char *const mi_lttng_rotation_phase_str_wait_data;
+
 /* String related to rate_policy elements */
 extern const char *const mi_lttng_element_rate_policy;
 extern const char *const mi_lttng_element_rate_policy_every_n;
@@ -253,6 +260,8 @@ extern const char *const mi_lttng_element_action_snapshot_session_output;
 extern const char *const mi_lttng_element_condition;
 extern const char *const mi_lttng_element_condition_buffer_usage_high;
 extern const char *const mi_lttng_element_condition_buffer_usage_low;
+extern const char *const mi_lttng_element_condition_channel_rate_high;
+extern const char *const mi_lttng_element_condition_channel_rate_low;
 extern const char *const mi_lttng_element_condition_event_rule_matches;
 extern const char *const mi_lttng_element_condition_session_consumed_size;
 extern const char *const mi_lttng_element_condition_session_rotation;
@@ -261,6 +270,12 @@ extern const char *const mi_lttng_element_condition_session_rotation_ongoing;
 extern const char *const mi_lttng_element_condition_channel_name;
 extern const char *const mi_lttng_element_condition_threshold_ratio;
 extern const char *const mi_lttng_element_condition_threshold_bytes;
+extern const char *const mi_lttng_element_condition_statistic;
+extern const char *const mi_lttng_element_condition_threshold_per_second;
+extern const char *const mi_lttng_element_condition_window_us;
+extern const char *const mi_lttng_condition_channel_rate_statistic_consumed_bytes;
+extern const char *const mi_lttng_condition_channel_rate_statistic_discarded_events;
+extern const char *const mi_lttng_condition_channel_rate_statistic_lost_packets;
 
 /* String related to capture descriptor */
 extern const char *const mi_lttng_element_capture_descriptor;
@@ -361,6 +376,7 @@ const char *mi_lttng_eventfieldtype_string(enum lttng_event_field_type value);
 const char *mi_lttng_domaintype_string(enum lttng_domain_type value);
 const char *mi_lttng_buffertype_string(enum lttng_buffer_type value);
 const char *mi_lttng_rotation_state_string(enum lttng_rotation_state value);
+const char *mi_lttng_rotation_phase_string(enum lttng_rotation_phase value);
 const char *mi_lttng_trace_archive_location_relay_protocol_type_string(
 	enum lttng_trace_archive_location_relay_protocol_type value);
 
@@ -385,6 +401,17 @@ struct mi_writer *mi_lttng_writer_create(int fd_output, int mi_output_type);
  */
 int mi_lttng_writer_destroy(struct mi_writer *writer);
 
+/*
+ * Write the output buffered by a machine interface writer, e.g. once a part
+ * of a listing is complete, so that the consumer of the output can process it
+ * while the rest is being retrieved.
+ *
+ * writer An instance of a machine interface writer.
+ *
+ * Returns zero on success. Negative values indicate an error.
+ */
+int mi_lttng_writer_flush(struct mi_writer *writer);
+
 /*
  * Open a command tag and add it's name node.
  *
@@ -1050,6 +1077,8 @@ int mi_lttng_rotation_schedule_result(struct mi_writer *writer,
  * - session_name: the session to be rotated.
  * - state: the session rotation state.
  * - location: the location of the completed chunk archive.
+ * - phase_durations: the durations of the phases of the rotation, in
+ *   microseconds.
  *
  * writer: An instance of a machine interface writer.
  *
@@ -1057,6 +1086,9 @@ int mi_lttng_rotation_schedule_result(struct mi_writer *writer,
  *
  * location: A location descriptor object.
  *
+ * phase_durations_us: The durations of the phases of the rotation, indexed by
+ * the values of enum lttng_rotation_phase, or nullptr if unavailable.
+ *
  * success: Whether the sub-command suceeded.
  *
  * Returns zero if the element's value could be written.
@@ -1065,6 +1097,7 @@ int mi_lttng_rotation_schedule_result(struct mi_writer *writer,
 int mi_lttng_rotate(struct mi_writer *writer,
 		    const char *session_name,
 		    enum lttng_rotation_state rotation_state,
-		    const struct lttng_trace_archive_location *location);
+		    const struct lttng_trace_archive_location *location,
+		    const uint64_t *phase_durations_us);
 
 #endif /* _MI_LTTNG_H */
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include "numa.hpp"
+
+#include <common/common.hpp>
+#include <common/format.hpp>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+/*
+ * Read the first line of a sysfs file, without its trailing newline.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int read_sysfs_line(const std::string& path, char *buf, size_t len)
+{
+	int ret = 0;
+	FILE *file = fopen(path.c_str(), "r");
+
+	if (!file) {
+		DBG("Failed to open `%s`: %s", path.c_str(), strerror(errno));
+		return -1;
+	}
+
+	if (!fgets(buf, len, file)) {
+		DBG("Failed to read `%s`", path.c_str());
+		ret = -1;
+		goto end;
+	}
+
+	buf[strcspn(buf, "\n")] = '\0';
+end:
+	fclose(file);
+	return ret;
+}
+} /* namespace */
+
+int lttng::numa::parse_cpu_list(const char *list, std::vector<int>& cpus)
+{
+	const char *cur = list;
+
+	/* An empty list is valid: memory-only nodes have no CPUs. */
+	while (*cur != '\0') {
+		char *end;
+		long first, last;
+
+		errno = 0;
+		first = strtol(cur, &end, 10);
+		if (errno || end == cur || first < 0 || first >= CPU_SETSIZE) {
+			return -1;
+		}
+
+		last = first;
+		cur = end;
+		if (*cur == '-') {
+			cur++;
+			last = strtol(cur, &end, 10);
+			if (errno || end == cur || last < first || last >= CPU_SETSIZE) {
+				return -1;
+			}
+
+			cur = end;
+		}
+
+		for (long cpu = first; cpu <= last; cpu++) {
+			cpus.push_back((int) cpu);
+		}
+
+		if (*cur == ',') {
+			cur++;
+			if (*cur == '\0') {
+				return -1;
+			}
+		} else if (*cur != '\0') {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+lttng::numa::topology lttng::numa::topology::from_sysfs(const char *node_path)
+{
+	topology topo;
+	char line[4096];
+	std::vector<int> node_ids;
+
+	if (read_sysfs_line(fmt::format("{}/online", node_path), line, sizeof(line)) ||
+	    parse_cpu_list(line, node_ids)) {
+		DBG("NUMA topology unavailable from `%s`", node_path);
+		return topology();
+	}
+
+	for (const auto node_id : node_ids) {
+		std::vector<int> cpus;
+
+		if (read_sysfs_line(fmt::format("{}/node{}/cpulist", node_path, node_id),
+				    line,
+				    sizeof(line)) ||
+		    parse_cpu_list(line, cpus)) {
+			WARN("Failed to read the CPU list of NUMA node %d", node_id);
+			return topology();
+		}
+
+		if (cpus.empty()) {
+			continue;
+		}
+
+		topo.add_node(cpus);
+	}
+
+	return topo;
+}
+
+void lttng::numa::topology::add_node(const std::vector<int>& cpus)
+{
+	const int node = (int) _node_cpus.size();
+
+	_node_cpus.push_back(cpus);
+	for (const auto cpu : cpus) {
+		if (cpu >= (int) _cpu_node.size()) {
+			_cpu_node.resize(cpu + 1, -1);
+		}
+
+		_cpu_node[cpu] = node;
+	}
+}
+
+int lttng::numa::topology::cpu_node(int cpu) const noexcept
+{
+	if (cpu < 0 || cpu >= (int) _cpu_node.size()) {
+		return -1;
+	}
+
+	return _cpu_node[cpu];
+}
+
+void lttng::numa::topology::node_cpu_set(unsigned int node, cpu_set_t *cpu_set) const noexcept
+{
+	LTTNG_ASSERT(node < _node_cpus.size());
+
+	CPU_ZERO(cpu_set);
+	for (const auto cpu : _node_cpus[node]) {
+		if (cpu < CPU_SETSIZE) {
+			CPU_SET(cpu, cpu_set);
+		}
+	}
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_NUMA_HPP
+#define LTTNG_NUMA_HPP
+
+#include <sched.h>
+#include <vector>
+
+namespace lttng {
+namespace numa {
+
+#define LTTNG_NUMA_SYSFS_NODE_PATH "/sys/devices/system/node"
+
+/*
+ * Parse a kernel CPU list (e.g. `0-3,8,10-11`) and append the CPUs it
+ * contains to `cpus`.
+ *
+ * Return 0 on success, -1 if the list is malformed.
+ */
+int parse_cpu_list(const char *list, std::vector<int>& cpus);
+
+/*
+ * Mapping between the NUMA nodes of the system and their CPUs.
+ *
+ * Nodes are identified by their dense index, in increasing order of kernel
+ * node id, among the nodes that have at least one CPU.
+ */
+class topology {
+public:
+	/*
+	 * Read the topology from a sysfs node directory. An empty topology is
+	 * returned if it can't be read (e.g. kernel without NUMA support).
+	 */
+	static topology from_sysfs(const char *node_path = LTTNG_NUMA_SYSFS_NODE_PATH);
+
+	unsigned int node_count() const noexcept
+	{
+		return _node_cpus.size();
+	}
+
+	/* Return the node of a CPU, -1 if unknown. */
+	int cpu_node(int cpu) const noexcept;
+
+	/* Set `cpu_set` to the CPUs of a node. */
+	void node_cpu_set(unsigned int node, cpu_set_t *cpu_set) const noexcept;
+
+	/* Add the CPUs of a node to the topology. */
+	void add_node(const std::vector<int>& cpus);
+
+private:
+	std::vector<std::vector<int>> _node_cpus;
+	/* Indexed by CPU id. */
+	std::vector<int> _cpu_node;
+};
+
+} /* namespace numa */
+} /* namespace lttng */
+
+#endif /* LTTNG_NUMA_HPP */
@@ -11,6 +11,7 @@
 #include <common/compat/errno.hpp>
 
 #include <limits.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 /*
@@ -58,6 +59,39 @@ error:
 	}
 }
 
+ssize_t lttng_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	size_t i = 0;
+	ssize_t ret;
+
+	LTTNG_ASSERT(buf);
+
+	if (count > SSIZE_MAX) {
+		return -EINVAL;
+	}
+
+	do {
+		ret = pread(fd, (char *) buf + i, count - i, offset + i);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue; /* retry operation */
+			} else {
+				goto error;
+			}
+		}
+		i += ret;
+		LTTNG_ASSERT(i <= count);
+	} while (count - i > 0 && ret > 0);
+	return i;
+
+error:
+	if (i == 0) {
+		return -1;
+	} else {
+		return i;
+	}
+}
+
 ssize_t lttng_write(int fd, const void *buf, size_t count)
 {
 	size_t i = 0;
@@ -94,3 +128,64 @@ error:
 		return i;
 	}
 }
+
+/*
+ * lttng_writev takes care of EINTR and partial writes like lttng_write but
+ * gathers the output from the "iovcnt" buffers described by "iov".
+ *
+ * The iovec array is used as scratch space to resume partial writes; its
+ * content is undefined once the function returns.
+ *
+ * Upon success, the sum of the lengths of the buffers is returned.
+ */
+ssize_t lttng_writev(int fd, struct iovec *iov, int iovcnt)
+{
+	size_t i = 0, count = 0;
+	ssize_t ret;
+	int iov_idx;
+
+	LTTNG_ASSERT(iov);
+	LTTNG_ASSERT(iovcnt >= 0);
+
+	for (iov_idx = 0; iov_idx < iovcnt; iov_idx++) {
+		count += iov[iov_idx].iov_len;
+		/* Same as lttng_write, an overflow value is never returned. */
+		if (count > SSIZE_MAX) {
+			return -EINVAL;
+		}
+	}
+
+	iov_idx = 0;
+	while (count - i > 0) {
+		ret = writev(fd, &iov[iov_idx], iovcnt - iov_idx);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue; /* retry operation */
+			} else {
+				goto error;
+			}
+		} else if (ret == 0) {
+			break;
+		}
+		i += ret;
+		LTTNG_ASSERT(i <= count);
+
+		/* Skip the buffers that were completely written. */
+		while (iov_idx < iovcnt && (size_t) ret >= iov[iov_idx].iov_len) {
+			ret -= iov[iov_idx].iov_len;
+			iov_idx++;
+		}
+		if (ret > 0) {
+			iov[iov_idx].iov_base = (char *) iov[iov_idx].iov_base + ret;
+			iov[iov_idx].iov_len -= ret;
+		}
+	}
+	return i;
+
+error:
+	if (i == 0) {
+		return -1;
+	} else {
+		return i;
+	}
+}
@@ -10,6 +10,7 @@
 
 #include <common/macros.hpp>
 
+#include <sys/uio.h>
 #include <unistd.h>
 
 /*
@@ -23,4 +24,15 @@
 ssize_t lttng_read(int fd, void *buf, size_t count);
 ssize_t lttng_write(int fd, const void *buf, size_t count);
 
+/*
+ * Positional version of lttng_read, leaving the file offset of `fd` unchanged.
+ */
+ssize_t lttng_pread(int fd, void *buf, size_t count, off_t offset);
+
+/*
+ * Gather version of lttng_write. The iovec array may be modified to resume
+ * partial writes.
+ */
+ssize_t lttng_writev(int fd, struct iovec *iov, int iovcnt);
+
 #endif /* LTTNG_COMMON_READWRITE_H */
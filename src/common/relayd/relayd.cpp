@@ -15,6 +15,7 @@
 #include <common/index/ctf-index.hpp>
 #include <common/sessiond-comm/relayd.hpp>
 #include <common/string-utils/format.hpp>
+#include <common/time.hpp>
 #include <common/trace-chunk.hpp>
 
 #include <inttypes.h>
@@ -43,6 +44,49 @@ static bool relayd_supports_get_configuration(const struct lttcomm_relayd_sock *
 	return false;
 }
 
+static bool relayd_supports_send_indexes(const struct lttcomm_relayd_sock *sock)
+{
+	if (sock->major > 2) {
+		return true;
+	} else if (sock->major == 2 && sock->minor >= 14) {
+		return true;
+	}
+	return false;
+}
+
+static bool relayd_supports_session_data_pending(const struct lttcomm_relayd_sock *sock)
+{
+	if (sock->major > 2) {
+		return true;
+	} else if (sock->major == 2 && sock->minor >= 14) {
+		return true;
+	}
+	return false;
+}
+
+struct relayd_index_batch {
+	/* Array of relayd_stream_index. */
+	struct lttng_dynamic_array indexes;
+	unsigned int max_count;
+	uint64_t max_latency_us;
+	/* Monotonic time at which the oldest pending index was queued. */
+	uint64_t oldest_index_time_us;
+	/* Set while the pending indexes are being sent. */
+	bool flushing;
+};
+
+static uint64_t index_batch_now_us()
+{
+	struct timespec now;
+
+	if (lttng_clock_gettime(CLOCK_MONOTONIC, &now)) {
+		/* Flush right away rather than holding indexes back. */
+		return UINT64_MAX;
+	}
+
+	return (uint64_t) now.tv_sec * USEC_PER_SEC + now.tv_nsec / NSEC_PER_USEC;
+}
+
 /*
  * Send command. Fill up the header and append the data.
  */
@@ -61,6 +105,14 @@ static int send_command(struct lttcomm_relayd_sock *rsock,
 		return -ECONNRESET;
 	}
 
+	/* The relayd receives the indexes before the commands sent after them. */
+	if (rsock->index_batch && !rsock->index_batch->flushing) {
+		ret = relayd_flush_indexes(rsock);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
 	if (data) {
 		buf_size += size;
 	}
@@ -723,6 +775,12 @@ int relayd_version_check(struct lttcomm_relayd_sock *rsock)
 		rsock->minor = msg.minor;
 	}
 
+	/*
+	 * The control connection carries the small commands and replies which
+	 * must not be delayed by the trace data sent on the data connection.
+	 */
+	(void) lttcomm_sock_set_low_latency(&rsock->sock);
+
 	/* Version number compatible */
 	DBG2("Relayd version is compatible, using protocol version %u.%u",
 	     rsock->major,
@@ -805,6 +863,18 @@ int relayd_close(struct lttcomm_relayd_sock *rsock)
 	/* Code flow error. Safety net. */
 	LTTNG_ASSERT(rsock);
 
+	if (rsock->index_batch) {
+		/* Best effort: the connection may already be broken. */
+		if (rsock->sock.fd >= 0 && relayd_flush_indexes(rsock) < 0) {
+			WARN("Failed to send pending indexes before closing relayd socket %d",
+			     rsock->sock.fd);
+		}
+
+		lttng_dynamic_array_reset(&rsock->index_batch->indexes);
+		free(rsock->index_batch);
+		rsock->index_batch = nullptr;
+	}
+
 	/* An invalid fd is fine, return success. */
 	if (rsock->sock.fd < 0) {
 		ret = 0;
@@ -1106,6 +1176,140 @@ error:
 	return ret;
 }
 
+/*
+ * Run the data pending check of a session with one command per stream, for the
+ * relayd peers which don't support the session data pending command.
+ */
+static int relayd_session_data_pending_per_stream(struct lttcomm_relayd_sock *rsock,
+						  uint64_t id,
+						  unsigned int stream_count,
+						  const struct relayd_stream_data_pending *streams)
+{
+	int ret;
+	unsigned int i, is_data_inflight = 0;
+
+	ret = relayd_begin_data_pending(rsock, id);
+	if (ret < 0) {
+		goto end;
+	}
+
+	for (i = 0; i < stream_count; i++) {
+		if (streams[i].is_metadata) {
+			ret = relayd_quiescent_control(rsock, streams[i].relay_stream_id);
+		} else {
+			ret = relayd_data_pending(
+				rsock, streams[i].relay_stream_id, streams[i].last_net_seq_num);
+		}
+
+		if (ret != 0) {
+			goto end;
+		}
+	}
+
+	ret = relayd_end_data_pending(rsock, id, &is_data_inflight);
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = is_data_inflight ? 1 : 0;
+end:
+	return ret;
+}
+
+int relayd_session_data_pending(struct lttcomm_relayd_sock *rsock,
+				uint64_t id,
+				unsigned int stream_count,
+				const struct relayd_stream_data_pending *streams)
+{
+	int ret, recv_ret;
+	unsigned int i;
+	struct lttng_dynamic_buffer payload;
+	struct lttcomm_relayd_generic_reply reply = {};
+	const struct lttcomm_relayd_session_data_pending msg = {
+		.session_id = htobe64(id),
+		.stream_count = htobe32((uint32_t) stream_count),
+	};
+
+	/* Code flow error. Safety net. */
+	LTTNG_ASSERT(rsock);
+
+	lttng_dynamic_buffer_init(&payload);
+
+	if (!relayd_supports_session_data_pending(rsock)) {
+		ret = relayd_session_data_pending_per_stream(rsock, id, stream_count, streams);
+		goto end;
+	}
+
+	DBG("Relayd session data pending: session id = %" PRIu64 ", stream count = %u",
+	    id,
+	    stream_count);
+
+	ret = lttng_dynamic_buffer_append(&payload, &msg, sizeof(msg));
+	if (ret) {
+		ERR("Failed to allocate \"session data pending\" command payload");
+		ret = -1;
+		goto end;
+	}
+
+	for (i = 0; i < stream_count; i++) {
+		const struct lttcomm_relayd_session_data_pending_stream comm_stream = {
+			.stream_id = htobe64(streams[i].relay_stream_id),
+			.last_net_seq_num = htobe64(streams[i].last_net_seq_num),
+			.is_metadata = (uint8_t) streams[i].is_metadata,
+		};
+
+		ret = lttng_dynamic_buffer_append(&payload, &comm_stream, sizeof(comm_stream));
+		if (ret) {
+			ERR("Failed to allocate \"session data pending\" command payload");
+			ret = -1;
+			goto end;
+		}
+	}
+
+	ret = send_command(rsock, RELAYD_SESSION_DATA_PENDING, payload.data, payload.size, 0);
+	if (ret < 0) {
+		ERR("Failed to send \"session data pending\" command");
+		goto end;
+	}
+
+	ret = recv_reply(rsock, &reply, sizeof(reply));
+	if (ret < 0) {
+		ERR("Failed to receive \"session data pending\" command reply");
+		goto end;
+	}
+
+	recv_ret = (int32_t) be32toh(reply.ret_code);
+	DBG("Relayd session data pending: data pending = %d", recv_ret);
+	ret = recv_ret;
+end:
+	lttng_dynamic_buffer_reset(&payload);
+	return ret;
+}
+
+static void relayd_index_to_comm(const struct lttcomm_relayd_sock *rsock,
+				 const struct ctf_packet_index *index,
+				 uint64_t relay_stream_id,
+				 uint64_t net_seq_num,
+				 struct lttcomm_relayd_index *msg)
+{
+	memset(msg, 0, sizeof(*msg));
+	msg->relay_stream_id = htobe64(relay_stream_id);
+	msg->net_seq_num = htobe64(net_seq_num);
+
+	/* The index is already in big endian. */
+	msg->packet_size = index->packet_size;
+	msg->content_size = index->content_size;
+	msg->timestamp_begin = index->timestamp_begin;
+	msg->timestamp_end = index->timestamp_end;
+	msg->events_discarded = index->events_discarded;
+	msg->stream_id = index->stream_id;
+
+	if (rsock->minor >= 8) {
+		msg->stream_instance_id = index->stream_instance_id;
+		msg->packet_seq_num = index->packet_seq_num;
+	}
+}
+
 /*
  * Send index to the relayd.
  */
@@ -1127,25 +1331,41 @@ int relayd_send_index(struct lttcomm_relayd_sock *rsock,
 		goto error;
 	}
 
-	DBG("Relayd sending index for stream ID %" PRIu64, relay_stream_id);
+	if (rsock->index_batch) {
+		struct relayd_index_batch *batch = rsock->index_batch;
+		const struct relayd_stream_index pending_index = {
+			.relay_stream_id = relay_stream_id,
+			.net_seq_num = net_seq_num,
+			.index = *index,
+		};
+		const uint64_t now_us = index_batch_now_us();
 
-	memset(&msg, 0, sizeof(msg));
-	msg.relay_stream_id = htobe64(relay_stream_id);
-	msg.net_seq_num = htobe64(net_seq_num);
+		ret = lttng_dynamic_array_add_element(&batch->indexes, &pending_index);
+		if (ret) {
+			ERR("Failed to queue index of stream ID %" PRIu64, relay_stream_id);
+			ret = -1;
+			goto error;
+		}
 
-	/* The index is already in big endian. */
-	msg.packet_size = index->packet_size;
-	msg.content_size = index->content_size;
-	msg.timestamp_begin = index->timestamp_begin;
-	msg.timestamp_end = index->timestamp_end;
-	msg.events_discarded = index->events_discarded;
-	msg.stream_id = index->stream_id;
+		if (lttng_dynamic_array_get_count(&batch->indexes) == 1) {
+			batch->oldest_index_time_us = now_us;
+		}
 
-	if (rsock->minor >= 8) {
-		msg.stream_instance_id = index->stream_instance_id;
-		msg.packet_seq_num = index->packet_seq_num;
+		if (lttng_dynamic_array_get_count(&batch->indexes) < batch->max_count &&
+		    now_us - batch->oldest_index_time_us < batch->max_latency_us) {
+			DBG3("Relayd queued index for stream ID %" PRIu64, relay_stream_id);
+			ret = 0;
+			goto error;
+		}
+
+		ret = relayd_flush_indexes(rsock);
+		goto error;
 	}
 
+	DBG("Relayd sending index for stream ID %" PRIu64, relay_stream_id);
+
+	relayd_index_to_comm(rsock, index, relay_stream_id, net_seq_num, &msg);
+
 	/* Send command */
 	ret = send_command(
 		rsock,
@@ -1179,6 +1399,158 @@ error:
 	return ret;
 }
 
+/*
+ * Queue the indexes sent on this socket until max_count of them are queued or
+ * the oldest one was queued max_latency_us ago. Batching is left disabled for
+ * relay daemons which don't support batches of indexes.
+ */
+int relayd_enable_index_batching(struct lttcomm_relayd_sock *rsock,
+				 unsigned int max_count,
+				 uint64_t max_latency_us)
+{
+	struct relayd_index_batch *batch;
+
+	if (max_count <= 1 || rsock->index_batch) {
+		return 0;
+	}
+
+	if (!relayd_supports_send_indexes(rsock)) {
+		DBG("Not batching indexes: relayd does not support batches of indexes");
+		return 0;
+	}
+
+	batch = zmalloc<relayd_index_batch>();
+	if (!batch) {
+		PERROR("Failed to allocate relayd index batch");
+		return -1;
+	}
+
+	lttng_dynamic_array_init(&batch->indexes, sizeof(struct relayd_stream_index), nullptr);
+	batch->max_count = max_count;
+	batch->max_latency_us = max_latency_us;
+	rsock->index_batch = batch;
+
+	DBG("Relayd index batching enabled: socket = %d, maximal count = %u, "
+	    "maximal latency = %" PRIu64
+	    " us",
+	    rsock->sock.fd,
+	    max_count,
+	    max_latency_us);
+	return 0;
+}
+
+/*
+ * Send the indexes queued on this socket, if any.
+ */
+int relayd_flush_indexes(struct lttcomm_relayd_sock *rsock)
+{
+	int ret;
+	struct relayd_index_batch *batch = rsock->index_batch;
+
+	if (!batch || lttng_dynamic_array_get_count(&batch->indexes) == 0) {
+		return 0;
+	}
+
+	batch->flushing = true;
+	ret = relayd_send_indexes(
+		rsock,
+		lttng_dynamic_array_get_count(&batch->indexes),
+		(const struct relayd_stream_index *) batch->indexes.buffer.data);
+	batch->flushing = false;
+
+	/* On error, the relayd connection is torn down: drop the indexes. */
+	lttng_dynamic_array_clear(&batch->indexes);
+	return ret;
+}
+
+/*
+ * Send a batch of indexes to the relayd in a single command. Fall back to one
+ * command per index for relay daemons which don't support batches.
+ */
+int relayd_send_indexes(struct lttcomm_relayd_sock *rsock,
+			unsigned int index_count,
+			const struct relayd_stream_index *indexes)
+{
+	int ret;
+	unsigned int i;
+	struct lttng_dynamic_buffer payload;
+	struct lttcomm_relayd_generic_reply reply = {};
+	const struct lttcomm_relayd_send_indexes msg = {
+		.index_count = htobe32((uint32_t) index_count),
+	};
+
+	/* Code flow error. Safety net. */
+	LTTNG_ASSERT(rsock);
+
+	lttng_dynamic_buffer_init(&payload);
+
+	if (index_count == 0) {
+		ret = 0;
+		goto end;
+	}
+
+	if (!relayd_supports_send_indexes(rsock)) {
+		for (i = 0; i < index_count; i++) {
+			struct ctf_packet_index index = indexes[i].index;
+
+			ret = relayd_send_index(
+				rsock, &index, indexes[i].relay_stream_id, indexes[i].net_seq_num);
+			if (ret < 0) {
+				goto end;
+			}
+		}
+
+		ret = 0;
+		goto end;
+	}
+
+	DBG("Relayd sending %u indexes", index_count);
+
+	ret = lttng_dynamic_buffer_append(&payload, &msg, sizeof(msg));
+	if (ret) {
+		ERR("Failed to allocate \"send indexes\" command payload");
+		goto end;
+	}
+
+	for (i = 0; i < index_count; i++) {
+		struct lttcomm_relayd_index comm_index;
+
+		relayd_index_to_comm(rsock,
+				     &indexes[i].index,
+				     indexes[i].relay_stream_id,
+				     indexes[i].net_seq_num,
+				     &comm_index);
+		ret = lttng_dynamic_buffer_append(&payload, &comm_index, sizeof(comm_index));
+		if (ret) {
+			ERR("Failed to allocate \"send indexes\" command payload");
+			goto end;
+		}
+	}
+
+	ret = send_command(rsock, RELAYD_SEND_INDEXES, payload.data, payload.size, 0);
+	if (ret < 0) {
+		ERR("Failed to send \"send indexes\" command");
+		goto end;
+	}
+
+	ret = recv_reply(rsock, &reply, sizeof(reply));
+	if (ret < 0) {
+		ERR("Failed to receive \"send indexes\" command reply");
+		goto end;
+	}
+
+	reply.ret_code = be32toh(reply.ret_code);
+	if (reply.ret_code != LTTNG_OK) {
+		ret = -1;
+		ERR("Relayd send indexes replied error %d", reply.ret_code);
+	} else {
+		ret = 0;
+	}
+end:
+	lttng_dynamic_buffer_reset(&payload);
+	return ret;
+}
+
 /*
  * Ask the relay to reset the metadata trace file (regeneration).
  */
@@ -27,6 +27,20 @@ struct relayd_stream_rotation_position {
 	uint64_t rotate_at_seq_num;
 };
 
+struct relayd_stream_data_pending {
+	uint64_t relay_stream_id;
+	/* Sequence number of the last packet sent, ignored for metadata streams. */
+	uint64_t last_net_seq_num;
+	bool is_metadata;
+};
+
+struct relayd_stream_index {
+	uint64_t relay_stream_id;
+	uint64_t net_seq_num;
+	/* Big endian, as written in the index files. */
+	struct ctf_packet_index index;
+};
+
 int relayd_connect(struct lttcomm_relayd_sock *sock);
 int relayd_close(struct lttcomm_relayd_sock *sock);
 int relayd_create_session(struct lttcomm_relayd_sock *rsock,
@@ -68,10 +82,35 @@ int relayd_begin_data_pending(struct lttcomm_relayd_sock *sock, uint64_t id);
 int relayd_end_data_pending(struct lttcomm_relayd_sock *sock,
 			    uint64_t id,
 			    unsigned int *is_data_inflight);
+/*
+ * Check for data pending for the `stream_count` streams of a session, in
+ * `streams`, in a single command when the relayd supports it.
+ *
+ * Return 1 if data is pending, 0 if not, or a negative value on error.
+ */
+int relayd_session_data_pending(struct lttcomm_relayd_sock *sock,
+				uint64_t id,
+				unsigned int stream_count,
+				const struct relayd_stream_data_pending *streams);
 int relayd_send_index(struct lttcomm_relayd_sock *rsock,
 		      struct ctf_packet_index *index,
 		      uint64_t relay_stream_id,
 		      uint64_t net_seq_num);
+/* `indexes` is an array of `index_count` relayd_stream_index. */
+int relayd_send_indexes(struct lttcomm_relayd_sock *rsock,
+			unsigned int index_count,
+			const struct relayd_stream_index *indexes);
+/*
+ * Make relayd_send_index() accumulate the indexes sent on a control socket
+ * and send them in batches of `max_count` indexes, or once the oldest one is
+ * pending for `max_latency_us` microseconds. The pending indexes are sent
+ * before any other command and when the socket is closed.
+ */
+int relayd_enable_index_batching(struct lttcomm_relayd_sock *rsock,
+				 unsigned int max_count,
+				 uint64_t max_latency_us);
+/* Send the indexes pending on a control socket, if any. */
+int relayd_flush_indexes(struct lttcomm_relayd_sock *rsock);
 int relayd_reset_metadata(struct lttcomm_relayd_sock *rsock, uint64_t stream_id, uint64_t version);
 /* `positions` is an array of `stream_count` relayd_stream_rotation_position. */
 int relayd_rotate_streams(struct lttcomm_relayd_sock *sock,
@@ -60,6 +60,8 @@ enum run_as_cmd {
 	RUN_AS_EXTRACT_ELF_SYMBOL_OFFSET,
 	RUN_AS_EXTRACT_SDT_PROBE_OFFSETS,
 	RUN_AS_GENERATE_FILTER_BYTECODE,
+	RUN_AS_MKDIR_RECURSIVE_BATCH,
+	RUN_AS_MKDIRAT_RECURSIVE_BATCH,
 };
 
 namespace {
@@ -67,6 +69,10 @@ struct run_as_data;
 struct run_as_ret;
 using run_as_fct = int (*)(struct run_as_data *, struct run_as_ret *);
 
+/*
+ * For the batch commands, `path` holds consecutive null-terminated paths,
+ * terminated by an empty path when they don't fill it.
+ */
 struct run_as_mkdir_data {
 	int dirfd;
 	char path[LTTNG_PATH_MAX];
@@ -330,18 +336,41 @@ const struct run_as_command_properties command_properties[] = {
 		.out_fd_count = 0,
 		.use_cwd_fd = false,
 	},
+	{
+		.in_fds_offset = offsetof(struct run_as_data, u.mkdir.dirfd),
+		.out_fds_offset = -1,
+		.in_fd_count = 1,
+		.out_fd_count = 0,
+		.use_cwd_fd = true,
+	},
+	{
+		.in_fds_offset = offsetof(struct run_as_data, u.mkdir.dirfd),
+		.out_fds_offset = -1,
+		.in_fd_count = 1,
+		.out_fd_count = 0,
+		.use_cwd_fd = false,
+	},
 };
 
 struct run_as_worker_data {
 	pid_t pid; /* Worker PID. */
 	int sockpair[2];
 	char *procname;
+	/* Running a command for a thread of the master, protected by worker_lock. */
+	bool busy;
 };
 
-/* Single global worker per process (for now). */
-run_as_worker_data *global_worker;
-/* Lock protecting the worker. */
+/*
+ * Workers of the process. A thread runs a command on an idle worker, so that
+ * the commands of concurrent threads don't wait for one another when there
+ * are several workers. A slot is empty when its worker failed to restart.
+ */
+run_as_worker_data *workers[DEFAULT_RUN_AS_WORKER_COUNT_MAX];
+unsigned int worker_count;
+/* Lock protecting the workers. */
 pthread_mutex_t worker_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled, with worker_lock held, when a worker becomes idle. */
+pthread_cond_t worker_idle_cond = PTHREAD_COND_INITIALIZER;
 } /* namespace */
 
 #ifdef VALGRIND
@@ -386,6 +415,46 @@ end:
 	return ret_value->u.ret;
 }
 
+/*
+ * Create recursively each of the directories of a batch, stopping at the first
+ * failure.
+ */
+static int _mkdirat_recursive_batch(struct run_as_data *data, struct run_as_ret *ret_value)
+{
+	const char *path;
+	const char *const paths_end = data->u.mkdir.path + sizeof(data->u.mkdir.path);
+	mode_t mode;
+	struct lttng_directory_handle *handle;
+
+	mode = data->u.mkdir.mode;
+
+	handle = lttng_directory_handle_create_from_dirfd(data->u.mkdir.dirfd);
+	if (!handle) {
+		ret_value->_errno = errno;
+		ret_value->_error = true;
+		ret_value->u.ret = -1;
+		goto end;
+	}
+	/* Ownership of dirfd is transferred to the handle. */
+	data->u.mkdir.dirfd = -1;
+	ret_value->u.ret = 0;
+	ret_value->_errno = 0;
+	for (path = data->u.mkdir.path; path < paths_end && *path;
+	     path += strnlen(path, paths_end - path) + 1) {
+		/* Safe to call as we have transitioned to the requested uid/gid. */
+		ret_value->u.ret =
+			lttng_directory_handle_create_subdirectory_recursive(handle, path, mode);
+		if (ret_value->u.ret) {
+			ret_value->_errno = errno;
+			break;
+		}
+	}
+	ret_value->_error = (ret_value->u.ret) != 0;
+	lttng_directory_handle_put(handle);
+end:
+	return ret_value->u.ret;
+}
+
 static int _mkdirat(struct run_as_data *data, struct run_as_ret *ret_value)
 {
 	const char *path;
@@ -672,6 +741,9 @@ static run_as_fct run_as_enum_to_fct(enum run_as_cmd cmd)
 	case RUN_AS_MKDIR_RECURSIVE:
 	case RUN_AS_MKDIRAT_RECURSIVE:
 		return _mkdirat_recursive;
+	case RUN_AS_MKDIR_RECURSIVE_BATCH:
+	case RUN_AS_MKDIRAT_RECURSIVE_BATCH:
+		return _mkdirat_recursive_batch;
 	case RUN_AS_OPEN:
 	case RUN_AS_OPENAT:
 		return _open;
@@ -1385,9 +1457,10 @@ end:
 	return ret;
 }
 
-static int run_as_create_worker_no_lock(const char *procname,
-					post_fork_cleanup_cb clean_up_func,
-					void *clean_up_user_data)
+static int create_worker(const char *procname,
+			 post_fork_cleanup_cb clean_up_func,
+			 void *clean_up_user_data,
+			 run_as_worker_data **out_worker)
 {
 	pid_t pid;
 	int i, ret = 0;
@@ -1395,19 +1468,9 @@ static int run_as_create_worker_no_lock(const char *procname,
 	struct run_as_ret recvret;
 	run_as_worker_data *worker;
 
-	LTTNG_ASSERT(!global_worker);
-	if (!use_clone()) {
-		/*
-		 * Don't initialize a worker, all run_as tasks will be performed
-		 * in the current process.
-		 */
-		ret = 0;
-		goto end;
-	}
 	worker = zmalloc<run_as_worker_data>();
 	if (!worker) {
-		ret = -ENOMEM;
-		goto end;
+		return -ENOMEM;
 	}
 	worker->procname = strdup(procname);
 	if (!worker->procname) {
@@ -1450,7 +1513,8 @@ static int run_as_create_worker_no_lock(const char *procname,
 
 		/*
 		 * Close all FDs aside from STDIN, STDOUT, STDERR and sockpair[1]
-		 * Sockpair[1] is used as a control channel with the master
+		 * Sockpair[1] is used as a control channel with the master. This
+		 * includes the sockets of the other workers.
 		 */
 		for (i = 3; i < sysconf(_SC_OPEN_MAX); i++) {
 			if (i != worker->sockpair[1]) {
@@ -1488,9 +1552,9 @@ static int run_as_create_worker_no_lock(const char *procname,
 			ret = -1;
 			goto error_fork;
 		}
-		global_worker = worker;
+		*out_worker = worker;
 	}
-end:
+
 	return ret;
 
 	/* Error handling. */
@@ -1511,14 +1575,9 @@ error_procname_alloc:
 	return ret;
 }
 
-static void run_as_destroy_worker_no_lock()
+static void destroy_worker(run_as_worker_data *worker)
 {
-	run_as_worker_data *worker = global_worker;
-
 	DBG("Destroying run_as worker");
-	if (!worker) {
-		return;
-	}
 	/* Close unix socket */
 	DBG("Closing run_as worker socket");
 	if (lttcomm_close_unix_sock(worker->sockpair[0])) {
@@ -1552,65 +1611,206 @@ static void run_as_destroy_worker_no_lock()
 	}
 	free(worker->procname);
 	free(worker);
-	global_worker = nullptr;
 }
 
-static int run_as_restart_worker(run_as_worker_data *worker)
+/*
+ * Number of workers to create, from the environment. Return 0 if it is
+ * invalid.
+ */
+static unsigned int get_configured_worker_count()
+{
+	const char *env_value = lttng_secure_getenv(DEFAULT_RUN_AS_WORKERS_ENV);
+	char *endptr;
+	unsigned long int_val;
+
+	if (!env_value) {
+		return DEFAULT_RUN_AS_WORKER_COUNT;
+	}
+
+	errno = 0;
+	int_val = strtoul(env_value, &endptr, 0);
+	if (errno != 0 || *endptr != '\0' || endptr == env_value || int_val == 0 ||
+	    int_val > DEFAULT_RUN_AS_WORKER_COUNT_MAX) {
+		ERR("Invalid value \"%s\" used for \"%s\" environment variable (expecting 1 to %d)",
+		    env_value,
+		    DEFAULT_RUN_AS_WORKERS_ENV,
+		    DEFAULT_RUN_AS_WORKER_COUNT_MAX);
+		return 0;
+	}
+
+	return (unsigned int) int_val;
+}
+
+static void run_as_destroy_worker_no_lock()
+{
+	unsigned int i;
+
+	for (i = 0; i < worker_count; i++) {
+		if (!workers[i]) {
+			continue;
+		}
+
+		LTTNG_ASSERT(!workers[i]->busy);
+		destroy_worker(workers[i]);
+		workers[i] = nullptr;
+	}
+
+	worker_count = 0;
+}
+
+static int run_as_create_worker_no_lock(const char *procname,
+					post_fork_cleanup_cb clean_up_func,
+					void *clean_up_user_data)
 {
 	int ret = 0;
-	char *procname = nullptr;
+	unsigned int count, i;
+
+	LTTNG_ASSERT(worker_count == 0);
+	if (!use_clone()) {
+		/*
+		 * Don't initialize a worker, all run_as tasks will be performed
+		 * in the current process.
+		 */
+		goto end;
+	}
+
+	count = get_configured_worker_count();
+	if (count == 0) {
+		ret = -1;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = create_worker(procname, clean_up_func, clean_up_user_data, &workers[i]);
+		if (ret < 0) {
+			run_as_destroy_worker_no_lock();
+			goto end;
+		}
+
+		worker_count++;
+	}
+
+	DBG("Created %u run_as worker(s)", worker_count);
+end:
+	return ret;
+}
+
+/*
+ * Replace the worker of a slot, which crashed, by a new one. The slot is left
+ * empty if the new worker can't be created.
+ */
+static int run_as_restart_worker(unsigned int index)
+{
+	int ret;
+	char *procname;
 
-	procname = worker->procname;
+	/* The worker's process name is freed along with it. */
+	procname = strdup(workers[index]->procname);
+	if (!procname) {
+		PERROR("Failed to copy the process name of the run_as worker");
+	}
 
 	/* Close socket to run_as worker process and clean up the zombie process */
-	run_as_destroy_worker_no_lock();
+	destroy_worker(workers[index]);
+	workers[index] = nullptr;
+
+	if (!procname) {
+		ret = -1;
+		goto end;
+	}
 
 	/* Create a new run_as worker process*/
-	ret = run_as_create_worker_no_lock(procname, nullptr, nullptr);
+	ret = create_worker(procname, nullptr, nullptr, &workers[index]);
 	if (ret < 0) {
 		ERR("Restarting the worker process failed");
 		ret = -1;
-		goto err;
+		goto end;
 	}
-err:
+end:
+	free(procname);
 	return ret;
 }
 
+/*
+ * Wait for a worker to be idle and reserve it. Return its slot, or -1 if
+ * there is no worker left.
+ */
+static int acquire_worker_no_lock()
+{
+	for (;;) {
+		unsigned int i;
+		bool has_worker = false;
+
+		for (i = 0; i < worker_count; i++) {
+			if (!workers[i]) {
+				continue;
+			}
+
+			has_worker = true;
+			if (!workers[i]->busy) {
+				workers[i]->busy = true;
+				return (int) i;
+			}
+		}
+
+		if (!has_worker) {
+			return -1;
+		}
+
+		pthread_cond_wait(&worker_idle_cond, &worker_lock);
+	}
+}
+
 static int run_as(enum run_as_cmd cmd,
 		  struct run_as_data *data,
 		  struct run_as_ret *ret_value,
 		  uid_t uid,
 		  gid_t gid)
 {
-	int ret, saved_errno;
+	int ret, saved_errno, worker_index;
 
 	pthread_mutex_lock(&worker_lock);
-	if (use_clone()) {
-		DBG("Using run_as worker");
+	if (!use_clone()) {
+		DBG("Using run_as without worker");
+		ret = run_as_noworker(cmd, data, ret_value, uid, gid);
+		goto end;
+	}
 
-		LTTNG_ASSERT(global_worker);
+	DBG("Using run_as worker");
+	worker_index = acquire_worker_no_lock();
+	if (worker_index < 0) {
+		ERR("No run_as worker is available");
+		ret = -1;
+		ret_value->_errno = EIO;
+		goto end;
+	}
 
-		ret = run_as_cmd(global_worker, cmd, data, ret_value, uid, gid);
-		saved_errno = ret_value->_errno;
+	/* Other threads can use the other workers during the command. */
+	pthread_mutex_unlock(&worker_lock);
+	ret = run_as_cmd(workers[worker_index], cmd, data, ret_value, uid, gid);
+	saved_errno = ret_value->_errno;
+	pthread_mutex_lock(&worker_lock);
 
-		/*
-		 * If the worker thread crashed the errno is set to EIO. we log
-		 * the error and  start a new worker process.
-		 */
-		if (ret == -1 && saved_errno == EIO) {
-			DBG("Socket closed unexpectedly... "
-			    "Restarting the worker process");
-			ret = run_as_restart_worker(global_worker);
-			if (ret == -1) {
-				ERR("Failed to restart worker process.");
-				goto err;
-			}
+	/*
+	 * If the worker thread crashed the errno is set to EIO. we log
+	 * the error and  start a new worker process.
+	 */
+	if (ret == -1 && saved_errno == EIO) {
+		DBG("Socket closed unexpectedly... "
+		    "Restarting the worker process");
+		ret = run_as_restart_worker(worker_index);
+		if (ret == -1) {
+			ERR("Failed to restart worker process.");
 		}
-	} else {
-		DBG("Using run_as without worker");
-		ret = run_as_noworker(cmd, data, ret_value, uid, gid);
 	}
-err:
+
+	if (workers[worker_index]) {
+		workers[worker_index]->busy = false;
+	}
+
+	/* Also wakes up the waiters when the worker failed to restart. */
+	pthread_cond_broadcast(&worker_idle_cond);
+end:
 	pthread_mutex_unlock(&worker_lock);
 	return ret;
 }
@@ -1652,6 +1852,61 @@ error:
 	return ret;
 }
 
+int run_as_mkdirat_recursive_batch(
+	int dirfd, const char *const *paths, size_t count, mode_t mode, uid_t uid, gid_t gid)
+{
+	int ret = 0;
+	size_t i = 0;
+
+	DBG3("mkdirat() recursive batch fd = %d%s, count = %zu, mode = %d, uid = %d, gid = %d",
+	     dirfd,
+	     dirfd == AT_FDCWD ? " (AT_FDCWD)" : "",
+	     count,
+	     (int) mode,
+	     (int) uid,
+	     (int) gid);
+	while (i < count) {
+		struct run_as_data data = {};
+		struct run_as_ret run_as_ret = {};
+		size_t used = 0;
+
+		/* Pack as many paths as the command can hold. */
+		for (; i < count; i++) {
+			const size_t path_size = strlen(paths[i]) + 1;
+
+			if (path_size > sizeof(data.u.mkdir.path)) {
+				ERR("Failed to copy path argument of mkdirat recursive batch command: path = %s",
+				    paths[i]);
+				errno = ENAMETOOLONG;
+				ret = -1;
+				goto error;
+			}
+			if (used + path_size > sizeof(data.u.mkdir.path)) {
+				break;
+			}
+
+			memcpy(data.u.mkdir.path + used, paths[i], path_size);
+			used += path_size;
+		}
+
+		data.u.mkdir.mode = mode;
+		data.u.mkdir.dirfd = dirfd;
+		run_as(dirfd == AT_FDCWD ? RUN_AS_MKDIR_RECURSIVE_BATCH :
+					   RUN_AS_MKDIRAT_RECURSIVE_BATCH,
+		       &data,
+		       &run_as_ret,
+		       uid,
+		       gid);
+		errno = run_as_ret._errno;
+		ret = run_as_ret.u.ret;
+		if (ret) {
+			goto error;
+		}
+	}
+error:
+	return ret;
+}
+
 int run_as_mkdir(const char *path, mode_t mode, uid_t uid, gid_t gid)
 {
 	return run_as_mkdirat(AT_FDCWD, path, mode, uid, gid);
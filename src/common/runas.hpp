@@ -33,6 +33,12 @@ using post_fork_cleanup_cb = int (*)(void *);
 
 int run_as_mkdir_recursive(const char *path, mode_t mode, uid_t uid, gid_t gid);
 int run_as_mkdirat_recursive(int dirfd, const char *path, mode_t mode, uid_t uid, gid_t gid);
+/*
+ * Recursively create many directories relative to `dirfd` with as few requests
+ * to the run-as worker as possible, stopping at the first failure.
+ */
+int run_as_mkdirat_recursive_batch(
+	int dirfd, const char *const *paths, size_t count, mode_t mode, uid_t uid, gid_t gid);
 int run_as_mkdir(const char *path, mode_t mode, uid_t uid, gid_t gid);
 int run_as_mkdirat(int dirfd, const char *path, mode_t mode, uid_t uid, gid_t gid);
 int run_as_open(const char *path, int flags, mode_t mode, uid_t uid, gid_t gid);
@@ -0,0 +1,16 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Define the self-tracing tracepoints with dynamic linkage: the daemons don't
+ * link on liblttng-ust, which would register them to a session daemon, and
+ * the tracepoints stay disabled unless the probe provider is preloaded.
+ */
+
+#define TRACEPOINT_DEFINE
+#define TRACEPOINT_PROBE_DYNAMIC_LINKAGE
+#include "tp.hpp"
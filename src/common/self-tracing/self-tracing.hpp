@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_SELF_TRACING_H
+#define LTTNG_SELF_TRACING_H
+
+#ifdef LTTNG_SELF_TRACING
+
+#include <common/self-tracing/tp.hpp>
+
+/*
+ * Tracepoint of the `lttng_tools` provider, see tp.hpp. Costs a predicted
+ * branch while the tracepoint is disabled.
+ */
+#define self_tracepoint(name, ...) tracepoint(lttng_tools, name, __VA_ARGS__)
+
+#else /* LTTNG_SELF_TRACING */
+
+/* Compiled out: the arguments are not evaluated. */
+#define self_tracepoint(name, ...)
+
+#endif /* LTTNG_SELF_TRACING */
+
+#endif /* LTTNG_SELF_TRACING_H */
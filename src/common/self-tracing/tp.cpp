@@ -0,0 +1,14 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Probe provider of the self-tracing tracepoints. Built as a separate shared
+ * object which is only loaded, with LD_PRELOAD, to trace the daemons.
+ */
+
+#define TRACEPOINT_CREATE_PROBES
+#include "tp.hpp"
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Tracepoints of the daemons on their own hot paths, compiled in with
+ * --enable-self-tracing. Use self_tracepoint() from self-tracing.hpp rather
+ * than including this file directly.
+ */
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER lttng_tools
+
+#if !defined(LTTNG_SELF_TRACING_TP_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define LTTNG_SELF_TRACING_TP_H
+
+#include <lttng/tracepoint.h>
+
+#include <stdint.h>
+
+/* Consumer daemon: consumption of a sub-buffer. */
+TRACEPOINT_EVENT(lttng_tools,
+		 consumerd_subbuffer_consume_begin,
+		 TP_ARGS(uint64_t, channel_key, uint64_t, stream_key, uint64_t, padded_size),
+		 TP_FIELDS(ctf_integer(uint64_t, channel_key, channel_key)
+			   ctf_integer(uint64_t, stream_key, stream_key)
+			   ctf_integer(uint64_t, padded_size, padded_size)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 consumerd_subbuffer_consume_end,
+		 TP_ARGS(uint64_t, stream_key, int64_t, written_bytes),
+		 TP_FIELDS(ctf_integer(uint64_t, stream_key, stream_key)
+			   ctf_integer(int64_t, written_bytes, written_bytes)))
+
+/* Consumer daemon: write of a batch of index entries. */
+TRACEPOINT_EVENT(lttng_tools,
+		 consumerd_index_flush,
+		 TP_ARGS(uint64_t, stream_key, uint64_t, count, int, ret),
+		 TP_FIELDS(ctf_integer(uint64_t, stream_key, stream_key)
+			   ctf_integer(uint64_t, count, count)
+			   ctf_integer(int, ret, ret)))
+
+/* Relay daemon: reception of a chunk of packet data and its write. */
+TRACEPOINT_EVENT(lttng_tools,
+		 relayd_data_receive,
+		 TP_ARGS(uint64_t, stream_id, uint64_t, net_seq_num, uint64_t, size),
+		 TP_FIELDS(ctf_integer(uint64_t, stream_id, stream_id)
+			   ctf_integer(uint64_t, net_seq_num, net_seq_num)
+			   ctf_integer(uint64_t, size, size)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 relayd_data_write,
+		 TP_ARGS(uint64_t, stream_id, uint64_t, size, int, ret),
+		 TP_FIELDS(ctf_integer(uint64_t, stream_id, stream_id)
+			   ctf_integer(uint64_t, size, size)
+			   ctf_integer(int, ret, ret)))
+
+/* Relay daemon: write of an index entry. */
+TRACEPOINT_EVENT(lttng_tools,
+		 relayd_index_flush,
+		 TP_ARGS(uint64_t, stream_id, uint64_t, net_seq_num, int, ret),
+		 TP_FIELDS(ctf_integer(uint64_t, stream_id, stream_id)
+			   ctf_integer(uint64_t, net_seq_num, net_seq_num)
+			   ctf_integer(int, ret, ret)))
+
+/* Relay daemon: processing of a live viewer command. */
+TRACEPOINT_EVENT(lttng_tools,
+		 relayd_viewer_command_begin,
+		 TP_ARGS(int, fd, unsigned int, cmd),
+		 TP_FIELDS(ctf_integer(int, fd, fd)
+			   ctf_integer(unsigned int, cmd, cmd)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 relayd_viewer_command_end,
+		 TP_ARGS(int, fd, unsigned int, cmd, int, ret),
+		 TP_FIELDS(ctf_integer(int, fd, fd)
+			   ctf_integer(unsigned int, cmd, cmd)
+			   ctf_integer(int, ret, ret)))
+
+/* Session daemon: registration of an application. */
+TRACEPOINT_EVENT(lttng_tools,
+		 sessiond_app_register_begin,
+		 TP_ARGS(int, pid, int, sock),
+		 TP_FIELDS(ctf_integer(int, pid, pid)
+			   ctf_integer(int, sock, sock)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 sessiond_app_register_published,
+		 TP_ARGS(int, pid),
+		 TP_FIELDS(ctf_integer(int, pid, pid)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 sessiond_app_register_sessions_updated,
+		 TP_ARGS(int, pid),
+		 TP_FIELDS(ctf_integer(int, pid, pid)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 sessiond_app_register_end,
+		 TP_ARGS(int, pid),
+		 TP_FIELDS(ctf_integer(int, pid, pid)))
+
+/* Session daemon: rotation of a session. */
+TRACEPOINT_EVENT(lttng_tools,
+		 sessiond_rotation_begin,
+		 TP_ARGS(uint64_t, session_id),
+		 TP_FIELDS(ctf_integer(uint64_t, session_id, session_id)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 sessiond_rotation_ongoing,
+		 TP_ARGS(uint64_t, session_id, uint64_t, chunk_id),
+		 TP_FIELDS(ctf_integer(uint64_t, session_id, session_id)
+			   ctf_integer(uint64_t, chunk_id, chunk_id)))
+
+TRACEPOINT_EVENT(lttng_tools,
+		 sessiond_rotation_completed,
+		 TP_ARGS(uint64_t, session_id, uint64_t, chunk_id),
+		 TP_FIELDS(ctf_integer(uint64_t, session_id, session_id)
+			   ctf_integer(uint64_t, chunk_id, chunk_id)))
+
+#endif /* LTTNG_SELF_TRACING_TP_H */
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "common/self-tracing/tp.hpp"
+
+/* This part must be outside ifdef protection */
+#include <lttng/tracepoint-event.h>
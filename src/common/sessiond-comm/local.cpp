@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "local.hpp"
+
+#include <common/common.hpp>
+#include <common/compat/errno.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * Local stream socket protocol operations.
+ */
+static const struct lttcomm_proto_ops local_ops = {
+	.bind = lttcomm_bind_local_sock,
+	.close = lttcomm_close_local_sock,
+	.connect = lttcomm_connect_local_sock,
+	.accept = lttcomm_accept_local_sock,
+	.listen = lttcomm_listen_local_sock,
+	.recvmsg = lttcomm_recvmsg_local_sock,
+	.sendmsg = lttcomm_sendmsg_local_sock,
+};
+
+static int set_timeouts(int fd)
+{
+	int ret;
+	const unsigned long timeout = lttcomm_get_network_timeout();
+
+	if (!timeout) {
+		return 0;
+	}
+
+	ret = lttcomm_setsockopt_rcv_timeout(fd, timeout);
+	if (ret) {
+		return ret;
+	}
+
+	return lttcomm_setsockopt_snd_timeout(fd, timeout);
+}
+
+/*
+ * Creates a PF_UNIX stream socket. The protocol is ignored since IPPROTO_TCP
+ * is the one of the relayd sockets.
+ */
+int lttcomm_create_local_sock(struct lttcomm_sock *sock,
+			      int type,
+			      int proto __attribute__((unused)))
+{
+	if (type != SOCK_STREAM) {
+		ERR("Only stream local sockets are supported");
+		goto error;
+	}
+
+	/* Create server socket */
+	if ((sock->fd = socket(PF_UNIX, type, 0)) < 0) {
+		PERROR("socket local");
+		goto error;
+	}
+
+	sock->ops = &local_ops;
+
+	if (set_timeouts(sock->fd)) {
+		goto error;
+	}
+
+	return 0;
+
+error:
+	return -1;
+}
+
+/*
+ * Bind socket and return. A socket file left behind by a previous instance
+ * is removed first, in the same way as the other UNIX sockets of the
+ * daemons.
+ */
+int lttcomm_bind_local_sock(struct lttcomm_sock *sock)
+{
+	const struct sockaddr_un sockaddr = sock->sockaddr.addr.sun;
+
+	(void) unlink(sockaddr.sun_path);
+
+	return bind(sock->fd, (struct sockaddr *) &sockaddr, sizeof(sockaddr));
+}
+
+/*
+ * Connect PF_UNIX socket. The connection is immediately established or
+ * refused, the network timeout does not apply.
+ */
+int lttcomm_connect_local_sock(struct lttcomm_sock *sock)
+{
+	int ret, closeret;
+	const struct sockaddr_un sockaddr = sock->sockaddr.addr.sun;
+
+	ret = connect(sock->fd, (struct sockaddr *) &sockaddr, sizeof(sockaddr));
+	if (ret < 0) {
+		PERROR("connect local");
+		goto error_connect;
+	}
+
+	return ret;
+
+error_connect:
+	closeret = close(sock->fd);
+	if (closeret) {
+		PERROR("close local");
+	}
+
+	return ret;
+}
+
+/*
+ * Do an accept(2) on the sock and return the new lttcomm socket. The socket
+ * MUST be bind(2) before.
+ */
+struct lttcomm_sock *lttcomm_accept_local_sock(struct lttcomm_sock *sock)
+{
+	int new_fd;
+	struct lttcomm_sock *new_sock;
+
+	new_sock = lttcomm_alloc_sock(sock->proto);
+	if (new_sock == nullptr) {
+		goto error;
+	}
+
+	/* Blocking call */
+	new_fd = accept(sock->fd, nullptr, nullptr);
+	if (new_fd < 0) {
+		PERROR("accept local");
+		goto error;
+	}
+
+	/* The peer of an unbound socket has no address; keep the listener's. */
+	new_sock->sockaddr = sock->sockaddr;
+	if (set_timeouts(new_fd)) {
+		goto error_close;
+	}
+
+	new_sock->fd = new_fd;
+	new_sock->ops = &local_ops;
+
+	return new_sock;
+
+error_close:
+	if (close(new_fd) < 0) {
+		PERROR("accept local close fd");
+	}
+
+error:
+	free(new_sock);
+	return nullptr;
+}
+
+/*
+ * Make the socket listen using LTTNG_SESSIOND_COMM_MAX_LISTEN.
+ */
+int lttcomm_listen_local_sock(struct lttcomm_sock *sock, int backlog)
+{
+	int ret;
+
+	/* Default listen backlog */
+	if (backlog <= 0) {
+		backlog = LTTNG_SESSIOND_COMM_MAX_LISTEN;
+	}
+
+	ret = listen(sock->fd, backlog);
+	if (ret < 0) {
+		PERROR("listen local");
+	}
+
+	return ret;
+}
+
+/*
+ * Receive data of size len in put that data into the buf param. Using recvmsg
+ * API.
+ *
+ * Return the size of received data.
+ */
+ssize_t lttcomm_recvmsg_local_sock(struct lttcomm_sock *sock, void *buf, size_t len, int flags)
+{
+	struct msghdr msg;
+	struct iovec iov[1];
+	ssize_t ret = -1;
+	size_t len_last;
+
+	memset(&msg, 0, sizeof(msg));
+
+	iov[0].iov_base = buf;
+	iov[0].iov_len = len;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 1;
+
+	do {
+		len_last = iov[0].iov_len;
+		ret = recvmsg(sock->fd, &msg, flags);
+		if (ret > 0) {
+			if (flags & MSG_DONTWAIT) {
+				goto end;
+			}
+			iov[0].iov_base = ((char *) iov[0].iov_base) + ret;
+			iov[0].iov_len -= ret;
+			LTTNG_ASSERT(ret <= len_last);
+		}
+	} while ((ret > 0 && ret < len_last) || (ret < 0 && errno == EINTR));
+
+	if (ret < 0) {
+		if (errno == EAGAIN && flags & MSG_DONTWAIT) {
+			/* See lttcomm_recvmsg_inet_sock(). */
+			goto end;
+		}
+		PERROR("recvmsg local");
+	} else if (ret > 0) {
+		ret = len;
+	}
+	/* Else ret = 0 meaning an orderly shutdown. */
+end:
+	return ret;
+}
+
+/*
+ * Send buf data of size len. Using sendmsg API.
+ *
+ * Return the size of sent data.
+ */
+ssize_t
+lttcomm_sendmsg_local_sock(struct lttcomm_sock *sock, const void *buf, size_t len, int flags)
+{
+	struct msghdr msg;
+	struct iovec iov[1];
+	ssize_t ret = -1;
+
+	memset(&msg, 0, sizeof(msg));
+
+	iov[0].iov_base = (void *) buf;
+	iov[0].iov_len = len;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 1;
+
+	do {
+		ret = sendmsg(sock->fd, &msg, flags);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+		/*
+		 * Only warn about EPIPE when quiet mode is deactivated.
+		 * We consider EPIPE as expected.
+		 */
+		if (errno != EPIPE || !lttng_opt_quiet) {
+			PERROR("sendmsg local");
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * Shutdown cleanly and close.
+ */
+int lttcomm_close_local_sock(struct lttcomm_sock *sock)
+{
+	int ret;
+
+	/* Don't try to close an invalid marked socket */
+	if (sock->fd == -1) {
+		return 0;
+	}
+
+	ret = close(sock->fd);
+	if (ret) {
+		PERROR("close local");
+	}
+
+	/* Mark socket */
+	sock->fd = -1;
+
+	return ret;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef _LTTCOMM_LOCAL_H
+#define _LTTCOMM_LOCAL_H
+
+#include "sessiond-comm.hpp"
+
+#include <limits.h>
+#include <sys/types.h>
+
+/*
+ * Stream sockets bound to a filesystem path, used between the consumer
+ * daemons and a relay daemon running on the same host to avoid the
+ * overhead of the TCP/IP stack on the loopback interface.
+ */
+
+/* Stub */
+struct lttcomm_sock;
+
+/* Net family callback */
+extern int lttcomm_create_local_sock(struct lttcomm_sock *sock, int type, int proto);
+
+extern struct lttcomm_sock *lttcomm_accept_local_sock(struct lttcomm_sock *sock);
+extern int lttcomm_bind_local_sock(struct lttcomm_sock *sock);
+extern int lttcomm_close_local_sock(struct lttcomm_sock *sock);
+extern int lttcomm_connect_local_sock(struct lttcomm_sock *sock);
+extern int lttcomm_listen_local_sock(struct lttcomm_sock *sock, int backlog);
+
+extern ssize_t
+lttcomm_recvmsg_local_sock(struct lttcomm_sock *sock, void *buf, size_t len, int flags);
+extern ssize_t
+lttcomm_sendmsg_local_sock(struct lttcomm_sock *sock, const void *buf, size_t len, int flags);
+
+#endif /* _LTTCOMM_LOCAL_H */
@@ -40,11 +40,18 @@ struct lttcomm_relayd_hdr {
 	uint32_t cmd_version; /* command version */
 } LTTNG_PACKED;
 
+/*
+ * Set in the circuit ID of a data header when its low 32 bits hold the CRC-32C
+ * of the packet, zero padding included. The relay daemons which don't know of
+ * it ignore the circuit ID.
+ */
+#define LTTCOMM_RELAYD_DATA_HDR_CHECKSUM (1ULL << 32)
+
 /*
  * lttng-relayd data header.
  */
 struct lttcomm_relayd_data_hdr {
-	/* Circuit ID not used for now so always ignored */
+	/* Only carries the checksum of the packet, see LTTCOMM_RELAYD_DATA_HDR_CHECKSUM. */
 	uint64_t circuit_id;
 	uint64_t stream_id; /* Stream ID known by the relayd */
 	uint64_t net_seq_num; /* Network sequence number, per stream. */
@@ -183,6 +190,34 @@ static inline size_t lttcomm_relayd_index_len(uint32_t major, uint32_t minor)
 	abort();
 }
 
+/*
+ * Batch of indexes (2.14+). Indexes use the complete lttcomm_relayd_index
+ * layout.
+ */
+struct lttcomm_relayd_send_indexes {
+	uint32_t index_count;
+	/* `index_count` indexes follow. */
+	struct lttcomm_relayd_index indexes[];
+} LTTNG_PACKED;
+
+struct lttcomm_relayd_session_data_pending_stream {
+	uint64_t stream_id;
+	/* Sequence number of the last packet, unused for metadata streams. */
+	uint64_t last_net_seq_num;
+	uint8_t is_metadata;
+} LTTNG_PACKED;
+
+/*
+ * Data pending check of all the streams of a session (2.14+). The return code
+ * of the reply is 1 if data is pending, 0 if not, or negative on error.
+ */
+struct lttcomm_relayd_session_data_pending {
+	uint64_t session_id;
+	uint32_t stream_count;
+	/* `stream_count` streams follow. */
+	struct lttcomm_relayd_session_data_pending_stream streams[];
+} LTTNG_PACKED;
+
 /*
  * Create session in 2.4 adds additionnal parameters for live reading.
  */
@@ -15,6 +15,7 @@
 
 #include <inttypes.h>
 #include <limits.h>
+#include <netinet/tcp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,18 +23,25 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/pkt_sched.h>
+#endif
+
 /* For Unix socket */
 #include <common/unix.hpp>
 /* For Inet socket */
 #include "inet.hpp"
 /* For Inet6 socket */
 #include "inet6.hpp"
+/* For local stream socket */
+#include "local.hpp"
 
 #define NETWORK_TIMEOUT_ENV "LTTNG_NETWORK_SOCKET_TIMEOUT"
 
 static struct lttcomm_net_family net_families[] = {
 	{ LTTCOMM_INET, lttcomm_create_inet_sock },
 	{ LTTCOMM_INET6, lttcomm_create_inet6_sock },
+	{ LTTCOMM_LOCAL, lttcomm_create_local_sock },
 };
 
 /*
@@ -144,7 +152,7 @@ int lttcomm_create_sock(struct lttcomm_sock *sock)
 	LTTNG_ASSERT(sock);
 
 	domain = sock->sockaddr.type;
-	if (domain != LTTCOMM_INET && domain != LTTCOMM_INET6) {
+	if (domain != LTTCOMM_INET && domain != LTTCOMM_INET6 && domain != LTTCOMM_LOCAL) {
 		ERR("Create socket of unknown domain %d", domain);
 		ret = -1;
 		goto error;
@@ -292,6 +300,27 @@ error:
 	return ret;
 }
 
+/*
+ * Init UNIX domain sockaddr structure.
+ */
+int lttcomm_init_local_sockaddr(struct lttcomm_sockaddr *sockaddr, const char *path)
+{
+	LTTNG_ASSERT(sockaddr);
+	LTTNG_ASSERT(path);
+
+	memset(sockaddr, 0, sizeof(struct lttcomm_sockaddr));
+
+	if (strlen(path) >= sizeof(sockaddr->addr.sun.sun_path)) {
+		ERR("Socket path is too long: %s", path);
+		return -1;
+	}
+
+	sockaddr->type = LTTCOMM_LOCAL;
+	sockaddr->addr.sun.sun_family = AF_UNIX;
+	strcpy(sockaddr->addr.sun.sun_path, path);
+	return 0;
+}
+
 /*
  * Return allocated lttcomm socket structure from lttng URI.
  */
@@ -328,6 +357,11 @@ struct lttcomm_sock *lttcomm_alloc_sock_from_uri(struct lttng_uri *uri)
 		if (ret < 0) {
 			goto error;
 		}
+	} else if (uri->dtype == LTTNG_DST_UNIX) {
+		ret = lttcomm_init_local_sockaddr(&sock->sockaddr, uri->dst.path);
+		if (ret < 0) {
+			goto error;
+		}
 	} else {
 		/* Command URI is invalid */
 		ERR("Relayd invalid URI dst type: %d", uri->dtype);
@@ -437,6 +471,48 @@ int lttcomm_setsockopt_snd_timeout(int sock, unsigned int msec)
 	return ret;
 }
 
+/*
+ * Send the small messages of a request/reply connection without waiting to
+ * coalesce them and queue them ahead of the bulk traffic of the host.
+ *
+ * The bulk trace data goes through its own connection. Without this, Nagle's
+ * algorithm can hold a command until the previous segment is acknowledged,
+ * which adds up to a delayed acknowledgement timeout to the latency of the
+ * control commands, on top of the round-trip time of the link.
+ *
+ * Return 0 on success, -1 if the options could not be set. A failure only
+ * affects the latency of the connection.
+ */
+int lttcomm_sock_set_low_latency(struct lttcomm_sock *sock)
+{
+	int ret;
+	int val = 1;
+
+	LTTNG_ASSERT(sock);
+
+	if (sock->sockaddr.type == LTTCOMM_LOCAL || sock->proto != LTTCOMM_SOCK_TCP) {
+		/* Nothing is coalesced. */
+		return 0;
+	}
+
+	ret = setsockopt(sock->fd, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(val));
+	if (ret < 0) {
+		PERROR("setsockopt TCP_NODELAY");
+		return -1;
+	}
+
+#ifdef __linux__
+	val = TC_PRIO_INTERACTIVE;
+	ret = setsockopt(sock->fd, SOL_SOCKET, SO_PRIORITY, &val, sizeof(val));
+	if (ret < 0) {
+		PERROR("setsockopt SO_PRIORITY");
+		return -1;
+	}
+#endif
+
+	return 0;
+}
+
 int lttcomm_sock_get_port(const struct lttcomm_sock *sock, uint16_t *port)
 {
 	LTTNG_ASSERT(sock);
@@ -504,8 +580,8 @@ unsigned long lttcomm_get_network_timeout()
 }
 
 /*
- * Only valid for an ipv4 and ipv6 bound socket that is already connected to its
- * peer.
+ * Only valid for an ipv4, ipv6 or local bound socket that is already connected
+ * to its peer.
  */
 int lttcomm_populate_sock_from_open_socket(struct lttcomm_sock *sock,
 					   int fd,
@@ -543,6 +619,10 @@ int lttcomm_populate_sock_from_open_socket(struct lttcomm_sock *sock,
 		sock->sockaddr.type = LTTCOMM_INET6;
 		memcpy(&sock->sockaddr.addr, &storage, sizeof(struct sockaddr_in6));
 		break;
+	case AF_UNIX:
+		sock->sockaddr.type = LTTCOMM_LOCAL;
+		memcpy(&sock->sockaddr.addr, &storage, sizeof(struct sockaddr_un));
+		break;
 	default:
 		abort();
 		break;
@@ -95,6 +95,16 @@ enum lttcomm_sessiond_command {
 	LTTCOMM_SESSIOND_COMMAND_CLEAR_SESSION,
 	LTTCOMM_SESSIOND_COMMAND_LIST_TRIGGERS,
 	LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY,
+	/* Keep the connection open to send the following commands. */
+	LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION,
+	LTTCOMM_SESSIOND_COMMAND_DESCRIBE_SESSION,
+	/* Register a set of triggers, of the same domain, with generated names. */
+	LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGERS,
+	/* Execute a set of error queries. */
+	LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES,
+	/* Add or remove a set of integral values to/from a process attribute tracker. */
+	LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_ADD_INCLUDE_VALUES,
+	LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_REMOVE_INCLUDE_VALUES,
 	LTTCOMM_SESSIOND_COMMAND_MAX,
 };
 
@@ -192,6 +202,18 @@ static inline const char *lttcomm_sessiond_command_str(enum lttcomm_sessiond_com
 		return "LIST_TRIGGERS";
 	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERY:
 		return "EXECUTE_ERROR_QUERY";
+	case LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION:
+		return "KEEP_CONNECTION";
+	case LTTCOMM_SESSIOND_COMMAND_DESCRIBE_SESSION:
+		return "DESCRIBE_SESSION";
+	case LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGERS:
+		return "REGISTER_TRIGGERS";
+	case LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES:
+		return "EXECUTE_ERROR_QUERIES";
+	case LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_ADD_INCLUDE_VALUES:
+		return "PROCESS_ATTR_TRACKER_ADD_INCLUDE_VALUES";
+	case LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_REMOVE_INCLUDE_VALUES:
+		return "PROCESS_ATTR_TRACKER_REMOVE_INCLUDE_VALUES";
 	default:
 		abort();
 	}
@@ -228,6 +250,10 @@ enum lttcomm_relayd_command {
 	RELAYD_TRACE_CHUNK_EXISTS = 21,
 	/* Get the current configuration of a relayd peer (2.12+) */
 	RELAYD_GET_CONFIGURATION = 22,
+	/* Send a batch of indexes in a single command (2.14+) */
+	RELAYD_SEND_INDEXES = 23,
+	/* Check for data pending for all the streams of a session (2.14+) */
+	RELAYD_SESSION_DATA_PENDING = 24,
 
 	/* Feature branch specific commands start at 10000. */
 };
@@ -279,6 +305,10 @@ static inline const char *lttcomm_relayd_command_str(lttcomm_relayd_command cmd)
 		return "RELAYD_TRACE_CHUNK_EXISTS";
 	case RELAYD_GET_CONFIGURATION:
 		return "RELAYD_GET_CONFIGURATION";
+	case RELAYD_SEND_INDEXES:
+		return "RELAYD_SEND_INDEXES";
+	case RELAYD_SESSION_DATA_PENDING:
+		return "RELAYD_SESSION_DATA_PENDING";
 	default:
 		abort();
 	}
@@ -343,6 +373,7 @@ enum lttcomm_sock_proto {
 enum lttcomm_sock_domain {
 	LTTCOMM_INET = 0,
 	LTTCOMM_INET6 = 1,
+	LTTCOMM_LOCAL = 2,
 };
 
 enum lttcomm_metadata_command {
@@ -362,6 +393,7 @@ struct lttcomm_metadata_request_msg {
 	uint32_t bits_per_long; /* Consumer ABI */
 	uint32_t uid;
 	uint64_t key; /* Metadata channel key. */
+	uint8_t periodic; /* Sent by the switch timer of the metadata channel. */
 } LTTNG_PACKED;
 
 struct lttcomm_sockaddr {
@@ -369,6 +401,7 @@ struct lttcomm_sockaddr {
 	union {
 		struct sockaddr_in sin;
 		struct sockaddr_in6 sin6;
+		struct sockaddr_un sun;
 	} addr;
 };
 
@@ -383,10 +416,14 @@ struct lttcomm_sock {
  * Relayd sock. Adds the protocol version to use for the communications with
  * the relayd.
  */
+struct relayd_index_batch;
+
 struct lttcomm_relayd_sock {
 	struct lttcomm_sock sock;
 	uint32_t major;
 	uint32_t minor;
+	/* Indexes pending on a control socket, see relayd_enable_index_batching(). */
+	struct relayd_index_batch *index_batch;
 };
 
 struct lttcomm_net_family {
@@ -411,6 +448,12 @@ struct process_attr_integral_value_comm {
 	} u;
 } LTTNG_PACKED;
 
+/*
+ * Maximal number of values of a single process attribute tracker bulk
+ * addition or removal command. Larger sets are sent in multiple commands.
+ */
+#define LTTCOMM_PROCESS_ATTR_TRACKER_MAX_BULK_VALUES (1U << 16)
+
 /*
  * Data structure received from lttng client to session daemon.
  */
@@ -484,6 +527,19 @@ struct lttcomm_session_msg {
 			 */
 			uint32_t name_len;
 		} LTTNG_PACKED process_attr_tracker_add_remove_include_value;
+		struct {
+			/* enum lttng_process_attr */
+			int32_t process_attr;
+			/* enum lttng_process_attr_value_type, integral types only. */
+			int32_t value_type;
+			/*
+			 * An array of 'count' struct
+			 * process_attr_integral_value_comm follows.
+			 *
+			 * Bounded by LTTCOMM_PROCESS_ATTR_TRACKER_MAX_BULK_VALUES.
+			 */
+			uint32_t count;
+		} LTTNG_PACKED process_attr_tracker_add_remove_include_values;
 		struct {
 			/* enum lttng_process_attr */
 			int32_t process_attr;
@@ -504,6 +560,8 @@ struct lttcomm_session_msg {
 		} LTTNG_PACKED trigger;
 		struct {
 			uint32_t length;
+			/* Number of serialized queries, for EXECUTE_ERROR_QUERIES. */
+			uint32_t count;
 		} LTTNG_PACKED error_query;
 		struct {
 			uint64_t rotation_id;
@@ -573,6 +631,22 @@ struct lttcomm_list_command_header {
 	uint32_t count;
 } LTTNG_PACKED;
 
+/*
+ * The reply of the DESCRIBE_SESSION command starts with a listing command
+ * header holding the number of domains of the session. Each domain follows,
+ * described by:
+ *   - its struct lttng_domain,
+ *   - the reply of the LIST_CHANNELS command for the domain,
+ *   - the reply of the LIST_EVENTS command for each of its channels, in the
+ *     order of the channels, or for the domain itself if it is an agent domain.
+ *
+ * Each of those replies is prefixed by this header.
+ */
+struct lttcomm_session_description_list_header {
+	/* Size of the reply, including its listing command header. */
+	uint64_t size;
+} LTTNG_PACKED;
+
 /*
  * Event extended info header. This is the structure preceding each
  * extended info data.
@@ -629,6 +703,14 @@ struct lttcomm_lttng_output_id {
 	uint32_t id;
 } LTTNG_PACKED;
 
+/*
+ * Descriptor of a stream of a LTTNG_CONSUMER_ADD_STREAMS command, sent along
+ * with the stream's fd.
+ */
+struct lttcomm_consumer_stream_desc {
+	int32_t cpu; /* On which CPU this stream is assigned. */
+} LTTNG_PACKED;
+
 /*
  * lttcomm_consumer_msg is the message sent from sessiond to consumerd
  * to either add a channel, add a stream, update a stream, or stop
@@ -660,6 +742,10 @@ struct lttcomm_consumer_msg {
 			uint8_t is_live;
 			/* timer to sample a channel's positions (usec). */
 			unsigned int monitor_timer_interval;
+			uint8_t writeback_policy; /* enum lttng_channel_writeback_policy */
+			uint64_t writeback_window_size; /* bytes */
+			uint32_t drain_max_subbuffers;
+			uint64_t drain_max_bytes;
 		} LTTNG_PACKED channel; /* Only used by Kernel. */
 		struct {
 			uint64_t stream_key;
@@ -668,6 +754,14 @@ struct lttcomm_consumer_msg {
 			/* Tells the consumer if the stream should be or not monitored. */
 			uint32_t no_monitor;
 		} LTTNG_PACKED stream; /* Only used by Kernel. */
+		struct {
+			uint64_t channel_key;
+			/*
+			 * Number of lttcomm_consumer_stream_desc sent, along with
+			 * their fd, after the status reply of the consumer.
+			 */
+			uint32_t stream_count;
+		} LTTNG_PACKED streams; /* Only used by Kernel. */
 		struct {
 			uint64_t net_index;
 			enum lttng_stream_type type;
@@ -723,6 +817,11 @@ struct lttcomm_consumer_msg {
 			 */
 			uint32_t ust_app_uid;
 			int64_t blocking_timeout;
+			uint8_t writeback_policy; /* enum lttng_channel_writeback_policy */
+			uint64_t writeback_window_size; /* bytes */
+			uint32_t drain_max_subbuffers;
+			uint64_t drain_max_bytes;
+			uint8_t buffer_page_size; /* enum lttng_channel_buffer_page_size */
 			char root_shm_path[PATH_MAX];
 			char shm_path[PATH_MAX];
 		} LTTNG_PACKED ask_channel;
@@ -755,6 +854,16 @@ struct lttcomm_consumer_msg {
 			/* Indicate if the snapshot goes on the relayd or locally. */
 			uint32_t use_relayd;
 			uint32_t metadata; /* This a metadata snapshot. */
+			/*
+			 * The snapshot goes to a file descriptor sent right after
+			 * the command is acknowledged.
+			 */
+			uint32_t use_fd_output;
+			/*
+			 * Only record the packets produced since the previous
+			 * snapshot of each stream. Ignored for metadata.
+			 */
+			uint32_t incremental;
 			uint64_t relayd_id; /* Relayd id if apply. */
 			uint64_t key;
 			uint64_t nb_packets_per_stream;
@@ -771,6 +880,10 @@ struct lttcomm_consumer_msg {
 			uint64_t session_id;
 			uint64_t channel_key;
 		} LTTNG_PACKED lost_packets;
+		struct {
+			uint64_t session_id;
+			uint64_t channel_key;
+		} LTTNG_PACKED consumption_stats;
 		struct {
 			uint64_t session_id;
 		} LTTNG_PACKED regenerate_metadata;
@@ -828,6 +941,8 @@ struct lttcomm_consumer_msg {
 		} LTTNG_PACKED init;
 		struct {
 			uint64_t key;
+			/* Truncate the local output files of the streams in place. */
+			uint8_t truncate_output;
 		} LTTNG_PACKED clear_channel;
 		struct {
 			uint64_t key;
@@ -852,6 +967,54 @@ struct lttcomm_consumer_channel_monitor_msg {
 	 * Sum of all the consumed positions for a channel.
 	 */
 	uint64_t consumed_since_last_sample;
+	/*
+	 * Bytes written to local trace files and not yet waited for by the
+	 * channel's writeback policy.
+	 */
+	uint64_t writeback_bytes_in_flight;
+	/*
+	 * Total number of discarded events and lost packets of the channel
+	 * at the moment the sample was taken.
+	 */
+	uint64_t discarded_events;
+	uint64_t lost_packets;
+} LTTNG_PACKED;
+
+enum lttcomm_consumer_rotation_event_type {
+	/* A consumer released its last reference to a closed trace chunk. */
+	LTTCOMM_CONSUMER_ROTATION_EVENT_TRACE_CHUNK_RELEASED = 0,
+	/* A consumer consumed data from the channels of a session. */
+	LTTCOMM_CONSUMER_ROTATION_EVENT_CONSUMED_SIZE = 1,
+};
+
+/*
+ * Message sent to the session daemon on the rotation event pipe, on which the
+ * consumers announce the events driving the rotations of the sessions.
+ */
+struct lttcomm_consumer_rotation_event_msg {
+	/* enum lttcomm_consumer_rotation_event_type */
+	uint8_t type;
+	uint64_t session_id;
+	/* Id of the released trace chunk, or size consumed in bytes. */
+	uint64_t value;
+} LTTNG_PACKED;
+
+/*
+ * Consumption histograms of a channel, merged over all its data streams.
+ * Returned to the session daemon in reply to the
+ * LTTNG_CONSUMER_CHANNEL_CONSUMPTION_STATS command.
+ *
+ * See LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT.
+ */
+struct lttcomm_consumer_channel_consumption_stats {
+	/* Wake-up to write latency of the sub-buffers (microseconds). */
+	uint64_t latency_histogram[LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT];
+	/* Size of the consumed sub-buffers (bytes). */
+	uint64_t size_histogram[LTTNG_CHANNEL_CONSUMPTION_HISTOGRAM_BUCKET_COUNT];
+	/* Smallest splice pipe of the data streams (bytes), 0 if none splices. */
+	uint64_t splice_pipe_size;
+	/* Bytes spilled locally while the relayd data connection was congested. */
+	uint64_t relayd_spilled_bytes;
 } LTTNG_PACKED;
 
 /*
@@ -922,6 +1085,7 @@ int lttcomm_init_inet_sockaddr(struct lttcomm_sockaddr *sockaddr,
 int lttcomm_init_inet6_sockaddr(struct lttcomm_sockaddr *sockaddr,
 				const char *ip,
 				unsigned int port);
+int lttcomm_init_local_sockaddr(struct lttcomm_sockaddr *sockaddr, const char *path);
 
 struct lttcomm_sock *lttcomm_alloc_sock(enum lttcomm_sock_proto proto);
 int lttcomm_populate_sock_from_open_socket(struct lttcomm_sock *sock,
@@ -939,6 +1103,7 @@ lttcomm_alloc_relayd_sock(struct lttng_uri *uri, uint32_t major, uint32_t minor)
 
 int lttcomm_setsockopt_rcv_timeout(int sock, unsigned int msec);
 int lttcomm_setsockopt_snd_timeout(int sock, unsigned int msec);
+int lttcomm_sock_set_low_latency(struct lttcomm_sock *sock);
 
 int lttcomm_sock_get_port(const struct lttcomm_sock *sock, uint16_t *port);
 /*
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "slab-allocator.hpp"
+
+#include <common/error.hpp>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <urcu/uatomic.h>
+
+struct lttng::slab_allocator::free_object {
+	struct free_object *next;
+	/* Set on the first object of a batch of the depot. */
+	struct free_object *next_batch;
+	unsigned int batch_object_count;
+};
+
+struct lttng::slab_allocator::thread_cache {
+	struct free_object *head;
+	unsigned int object_count;
+};
+
+namespace {
+/* Allocators with thread caches, indexed by their _index. */
+lttng::slab_allocator *allocators[lttng::slab_allocator::max_allocators];
+unsigned int allocator_count;
+
+unsigned int registered_allocator_count() noexcept
+{
+	const unsigned int count = uatomic_read(&allocator_count);
+
+	return count < lttng::slab_allocator::max_allocators ?
+		count :
+		lttng::slab_allocator::max_allocators;
+}
+} /* namespace */
+
+/* Thread caches of all the allocators, returned to their depot on thread exit. */
+struct lttng::details::slab_thread_caches {
+	~slab_thread_caches()
+	{
+		const unsigned int count = registered_allocator_count();
+
+		for (unsigned int i = 0; i < count; i++) {
+			auto& cache = caches[i];
+
+			if (cache.object_count == 0) {
+				continue;
+			}
+
+			allocators[i]->_flush(cache, cache.object_count);
+		}
+	}
+
+	slab_allocator::thread_cache caches[slab_allocator::max_allocators] = {};
+};
+
+namespace {
+thread_local lttng::details::slab_thread_caches thread_caches;
+} /* namespace */
+
+lttng::slab_allocator::slab_allocator(const char *name,
+				      size_t object_size,
+				      unsigned int batch_size,
+				      unsigned int max_cached_objects) noexcept :
+	_name(name),
+	/* Freed objects hold the links of the caches. */
+	_object_size(std::max(object_size, sizeof(free_object))),
+	_batch_size(batch_size ? batch_size : 1),
+	_max_cached_objects(max_cached_objects)
+{
+	const unsigned int index = uatomic_add_return(&allocator_count, 1) - 1;
+
+	if (index < max_allocators) {
+		allocators[index] = this;
+		_index = (int) index;
+	}
+}
+
+lttng::slab_allocator::thread_cache *lttng::slab_allocator::_thread_cache() noexcept
+{
+	return _index >= 0 ? &thread_caches.caches[_index] : nullptr;
+}
+
+/* Move a batch of objects of the depot to an empty thread cache, if there is one. */
+void lttng::slab_allocator::_refill(thread_cache& cache) noexcept
+{
+	LTTNG_ASSERT(!cache.head);
+
+	pthread_mutex_lock(&_depot_lock);
+	if (_depot) {
+		cache.head = _depot;
+		cache.object_count = _depot->batch_object_count;
+		_depot = _depot->next_batch;
+		_depot_object_count -= cache.object_count;
+	}
+	pthread_mutex_unlock(&_depot_lock);
+}
+
+/*
+ * Move `count` objects of a thread cache to the depot, returning them to the
+ * system allocator if the depot is full.
+ */
+void lttng::slab_allocator::_flush(thread_cache& cache, unsigned int count) noexcept
+{
+	free_object *const batch = cache.head;
+	free_object *last = batch;
+	bool cached = false;
+
+	LTTNG_ASSERT(count > 0 && count <= cache.object_count);
+
+	for (unsigned int i = 1; i < count; i++) {
+		last = last->next;
+	}
+
+	cache.head = last->next;
+	cache.object_count -= count;
+	last->next = nullptr;
+	batch->batch_object_count = count;
+
+	pthread_mutex_lock(&_depot_lock);
+	if (_depot_object_count + count <= _max_cached_objects) {
+		batch->next_batch = _depot;
+		_depot = batch;
+		_depot_object_count += count;
+		cached = true;
+	}
+	pthread_mutex_unlock(&_depot_lock);
+
+	if (!cached) {
+		_release(batch, count);
+	}
+}
+
+/* Return a list of `count` objects to the system allocator. */
+void lttng::slab_allocator::_release(free_object *head, unsigned int count) noexcept
+{
+	while (head) {
+		free_object *const next = head->next;
+
+		::free(head);
+		head = next;
+	}
+
+	uatomic_add(&_stats.system_frees, count);
+}
+
+void *lttng::slab_allocator::zalloc() noexcept
+{
+	thread_cache *const cache = _thread_cache();
+	free_object *object = nullptr;
+
+	uatomic_inc(&_stats.allocations);
+	if (cache) {
+		if (!cache->head) {
+			_refill(*cache);
+		}
+
+		object = cache->head;
+		if (object) {
+			cache->head = object->next;
+			cache->object_count--;
+		}
+	}
+
+	if (!object) {
+		uatomic_inc(&_stats.system_allocations);
+		return zmalloc_internal(_object_size);
+	}
+
+	memset(object, 0, _object_size);
+	return object;
+}
+
+void lttng::slab_allocator::free(void *ptr) noexcept
+{
+	thread_cache *const cache = _thread_cache();
+	free_object *const object = static_cast<free_object *>(ptr);
+
+	if (!object) {
+		return;
+	}
+
+	uatomic_inc(&_stats.frees);
+	if (!cache) {
+		object->next = nullptr;
+		_release(object, 1);
+		return;
+	}
+
+	object->next = cache->head;
+	cache->head = object;
+	cache->object_count++;
+	if (cache->object_count >= 2 * _batch_size) {
+		_flush(*cache, _batch_size);
+	}
+}
+
+lttng::slab_allocator::stats lttng::slab_allocator::get_stats() const noexcept
+{
+	return {
+		.allocations = uatomic_read(&_stats.allocations),
+		.frees = uatomic_read(&_stats.frees),
+		.system_allocations = uatomic_read(&_stats.system_allocations),
+		.system_frees = uatomic_read(&_stats.system_frees),
+	};
+}
+
+void lttng::slab_allocator::log_all_stats() noexcept
+{
+	const unsigned int count = registered_allocator_count();
+
+	for (unsigned int i = 0; i < count; i++) {
+		const auto stats = allocators[i]->get_stats();
+
+		DBG("Slab allocator `%s`: allocations = %" PRIu64 ", frees = %" PRIu64
+		    ", system allocations = %" PRIu64 ", system frees = %" PRIu64,
+		    allocators[i]->name(),
+		    stats.allocations,
+		    stats.frees,
+		    stats.system_allocations,
+		    stats.system_frees);
+	}
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_SLAB_ALLOCATOR_HPP
+#define LTTNG_SLAB_ALLOCATOR_HPP
+
+#include <common/macros.hpp>
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace lttng {
+namespace details {
+struct slab_thread_caches;
+} /* namespace details */
+
+/*
+ * Allocator of fixed-size objects which keeps the freed objects for reuse
+ * instead of returning them to the system allocator.
+ *
+ * Each thread keeps up to twice `batch_size` freed objects of an allocator
+ * in a cache of its own, without locking. The objects in excess move, a batch
+ * at a time, to a depot shared by the threads, from which the threads refill
+ * their empty cache. The depot keeps up to `max_cached_objects` objects; the
+ * objects in excess are returned to the system allocator. This way, objects
+ * allocated by a thread and freed by another one, for instance from an RCU
+ * callback run by the call_rcu thread, flow back to the allocating thread.
+ *
+ * An allocator is meant to be a static object: it is never destroyed and
+ * the objects it caches are never returned to the system allocator, other
+ * than those in excess of its depot. The thread caches of up to
+ * `max_allocators` allocators are kept per thread; the next allocators fall
+ * back to the depot alone.
+ *
+ * The allocator can be used from any thread, including from RCU callbacks.
+ */
+class slab_allocator {
+public:
+	static constexpr unsigned int max_allocators = 32;
+	static constexpr unsigned int default_batch_size = 32;
+	static constexpr unsigned int default_max_cached_objects = 1024;
+
+	struct stats {
+		/* Objects allocated and freed through the allocator. */
+		uint64_t allocations;
+		uint64_t frees;
+		/* Objects allocated from, and freed to, the system allocator. */
+		uint64_t system_allocations;
+		uint64_t system_frees;
+	};
+
+	slab_allocator(const char *name,
+		       size_t object_size,
+		       unsigned int batch_size = default_batch_size,
+		       unsigned int max_cached_objects = default_max_cached_objects) noexcept;
+	slab_allocator(const slab_allocator&) = delete;
+	slab_allocator& operator=(const slab_allocator&) = delete;
+
+	/* Allocate a zeroed object. Return nullptr on allocation failure. */
+	void *zalloc() noexcept;
+
+	/*
+	 * Allocate a zeroed object of type AllocatedType, asserting that it can
+	 * be safely malloc-ed (is trivially constructible).
+	 */
+	template <typename AllocatedType>
+	AllocatedType *zalloc() noexcept
+	{
+		static_assert(can_malloc<AllocatedType>::value, "type can be malloc'ed");
+		LTTNG_ASSERT(sizeof(AllocatedType) <= _object_size);
+		return static_cast<AllocatedType *>(zalloc());
+	}
+
+	/* Free an object allocated by this allocator. Freeing nullptr is a no-op. */
+	void free(void *object) noexcept;
+
+	stats get_stats() const noexcept;
+	const char *name() const noexcept
+	{
+		return _name;
+	}
+
+	/* Log the statistics of all the allocators at the debug level. */
+	static void log_all_stats() noexcept;
+
+private:
+	friend struct details::slab_thread_caches;
+
+	struct free_object;
+	struct thread_cache;
+
+	thread_cache *_thread_cache() noexcept;
+	void _refill(thread_cache& cache) noexcept;
+	void _flush(thread_cache& cache, unsigned int count) noexcept;
+	void _release(free_object *head, unsigned int count) noexcept;
+
+	const char *const _name;
+	const size_t _object_size;
+	const unsigned int _batch_size;
+	const unsigned int _max_cached_objects;
+	/* Index of the thread caches of the allocator, -1 if it has none. */
+	int _index = -1;
+
+	pthread_mutex_t _depot_lock = PTHREAD_MUTEX_INITIALIZER;
+	/* Batches of objects, linked by their first object, protected by _depot_lock. */
+	free_object *_depot = nullptr;
+	unsigned int _depot_object_count = 0;
+
+	/* Updated atomically. */
+	struct stats _stats = {};
+};
+
+} /* namespace lttng */
+
+#endif /* LTTNG_SLAB_ALLOCATOR_HPP */
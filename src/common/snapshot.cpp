@@ -59,6 +59,10 @@ bool lttng_snapshot_output_is_equal(const struct lttng_snapshot_output *a,
 		goto end;
 	}
 
+	if (a->incremental != b->incremental) {
+		goto end;
+	}
+
 	if (strcmp(a->name, b->name) != 0) {
 		goto end;
 	}
@@ -87,6 +91,7 @@ struct lttng_snapshot_output_comm {
 	char name[LTTNG_NAME_MAX];
 	char ctrl_url[PATH_MAX];
 	char data_url[PATH_MAX];
+	uint8_t incremental;
 } LTTNG_PACKED;
 } /* namespace */
 
@@ -98,6 +103,7 @@ int lttng_snapshot_output_serialize(const struct lttng_snapshot_output *output,
 
 	comm.id = output->id;
 	comm.max_size = output->max_size;
+	comm.incremental = output->incremental;
 
 	ret = lttng_strncpy(comm.name, output->name, sizeof(comm.name));
 	if (ret) {
@@ -145,6 +151,7 @@ ssize_t lttng_snapshot_output_create_from_payload(struct lttng_payload_view *vie
 
 	output->id = comm->id;
 	output->max_size = comm->max_size;
+	output->incremental = !!comm->incremental;
 
 	ret = lttng_strncpy(output->name, comm->name, sizeof(output->name));
 	if (ret) {
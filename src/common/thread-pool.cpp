@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "thread-pool.hpp"
+
+#include <common/common.hpp>
+
+#include <lttng/health-internal.hpp>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <urcu.h>
+#include <urcu/uatomic.h>
+
+namespace {
+struct worker {
+	struct lttng_thread_pool *pool;
+	unsigned int index;
+	pthread_t thread;
+	char name[32];
+	pthread_mutex_t lock;
+	/* Queued lttng_thread_pool_work, protected by `lock`. */
+	struct cds_list_head queue;
+	/* Works are queued while set, protected by `lock`. */
+	bool accepting_works;
+};
+
+thread_local struct worker *current_worker;
+} /* namespace */
+
+struct lttng_thread_pool {
+	char *name;
+	struct health_app *health;
+	int health_type;
+	bool pin_threads;
+	cpu_set_t cpus;
+
+	struct worker *workers;
+	unsigned int worker_count;
+	unsigned int started_worker_count;
+	/* Index of the queue of the next work submitted from outside the pool. */
+	unsigned int next_worker;
+
+	pthread_mutex_t idle_lock;
+	/* Signaled when a work is queued while threads are idle, or on quit. */
+	pthread_cond_t work_queued;
+	/* Threads waiting for works, incremented with `idle_lock` held. */
+	unsigned int idle_count;
+	/* Protected by `idle_lock`. */
+	bool quit;
+
+	/*
+	 * Works counted in `queued` before being queued and until a thread takes
+	 * them out of its queue.
+	 */
+	uint64_t queued;
+	uint64_t max_queued;
+	uint64_t submitted;
+	uint64_t completed;
+	uint64_t stolen;
+};
+
+namespace {
+struct lttng_thread_pool_work *dequeue(struct worker *worker)
+{
+	struct lttng_thread_pool_work *work = nullptr;
+
+	pthread_mutex_lock(&worker->lock);
+	if (!cds_list_empty(&worker->queue)) {
+		work = cds_list_first_entry(&worker->queue, struct lttng_thread_pool_work, node);
+		cds_list_del(&work->node);
+	}
+	pthread_mutex_unlock(&worker->lock);
+
+	return work;
+}
+
+/* Take the oldest work of the first other thread which has one. */
+struct lttng_thread_pool_work *steal(struct worker *thief)
+{
+	struct lttng_thread_pool *pool = thief->pool;
+
+	for (unsigned int i = 1; i < pool->worker_count; i++) {
+		struct worker *victim = &pool->workers[(thief->index + i) % pool->worker_count];
+		struct lttng_thread_pool_work *work = dequeue(victim);
+
+		if (work) {
+			uatomic_inc(&pool->stolen);
+			return work;
+		}
+	}
+
+	return nullptr;
+}
+
+/*
+ * Wait for a work to be queued.
+ *
+ * Return false if the pool is quitting and no work is left.
+ */
+bool wait_for_work(struct lttng_thread_pool *pool)
+{
+	bool keep_running = true;
+
+	pthread_mutex_lock(&pool->idle_lock);
+	/*
+	 * Pairs with the barrier between the increment of `queued` and the read
+	 * of `idle_count` in lttng_thread_pool_submit(): either the submitter
+	 * sees this thread idle and signals it, or this thread sees the work.
+	 */
+	(void) uatomic_add_return(&pool->idle_count, 1);
+	if (uatomic_read(&pool->queued) == 0) {
+		if (pool->quit) {
+			keep_running = false;
+		} else {
+			if (pool->health) {
+				health_poll_entry();
+			}
+
+			pthread_cond_wait(&pool->work_queued, &pool->idle_lock);
+			if (pool->health) {
+				health_poll_exit();
+			}
+		}
+	}
+	uatomic_dec(&pool->idle_count);
+	pthread_mutex_unlock(&pool->idle_lock);
+
+	return keep_running;
+}
+
+void pin_thread(struct worker *worker)
+{
+	const int ret = pthread_setaffinity_np(
+		pthread_self(), sizeof(worker->pool->cpus), &worker->pool->cpus);
+
+	if (ret) {
+		errno = ret;
+		PERROR("Failed to set the CPU affinity of thread %s", worker->name);
+	}
+}
+
+void *worker_thread(void *data)
+{
+	struct worker *worker = (struct worker *) data;
+	struct lttng_thread_pool *pool = worker->pool;
+
+	logger_set_thread_name(worker->name, true);
+	DBG("[thread] %s started", worker->name);
+
+	rcu_register_thread();
+	if (pool->health) {
+		health_register(pool->health, pool->health_type);
+	}
+
+	if (pool->pin_threads) {
+		pin_thread(worker);
+	}
+
+	current_worker = worker;
+	do {
+		struct lttng_thread_pool_work *work;
+
+		while ((work = dequeue(worker)) || (work = steal(worker))) {
+			uatomic_dec(&pool->queued);
+			if (pool->health) {
+				health_code_update();
+			}
+
+			work->run(work);
+			uatomic_inc(&pool->completed);
+		}
+	} while (wait_for_work(pool));
+	current_worker = nullptr;
+
+	DBG("%s exiting", worker->name);
+	if (pool->health) {
+		health_unregister(pool->health);
+	}
+
+	rcu_unregister_thread();
+	return nullptr;
+}
+
+void update_max_queued(struct lttng_thread_pool *pool, uint64_t queued)
+{
+	uint64_t max_queued = uatomic_read(&pool->max_queued);
+
+	while (queued > max_queued) {
+		const uint64_t previous = uatomic_cmpxchg(&pool->max_queued, max_queued, queued);
+
+		if (previous == max_queued) {
+			break;
+		}
+
+		max_queued = previous;
+	}
+}
+} /* namespace */
+
+struct lttng_thread_pool *lttng_thread_pool_create(const struct lttng_thread_pool_attr *attr)
+{
+	struct lttng_thread_pool *pool;
+
+	LTTNG_ASSERT(attr);
+	LTTNG_ASSERT(attr->name);
+	LTTNG_ASSERT(attr->thread_count > 0);
+
+	pool = zmalloc<lttng_thread_pool>();
+	if (!pool) {
+		PERROR("Failed to allocate thread pool %s", attr->name);
+		return nullptr;
+	}
+
+	pthread_mutex_init(&pool->idle_lock, nullptr);
+	pthread_cond_init(&pool->work_queued, nullptr);
+	pool->health = attr->health;
+	pool->health_type = attr->health_type;
+	if (attr->cpus) {
+		pool->pin_threads = true;
+		pool->cpus = *attr->cpus;
+	}
+
+	pool->name = strdup(attr->name);
+	pool->workers = calloc<worker>(attr->thread_count);
+	if (!pool->name || !pool->workers) {
+		PERROR("Failed to allocate thread pool %s", attr->name);
+		goto error;
+	}
+
+	pool->worker_count = attr->thread_count;
+	for (unsigned int i = 0; i < pool->worker_count; i++) {
+		struct worker *worker = &pool->workers[i];
+
+		worker->pool = pool;
+		worker->index = i;
+		(void) snprintf(worker->name, sizeof(worker->name), "%s-%u", pool->name, i);
+		pthread_mutex_init(&worker->lock, nullptr);
+		CDS_INIT_LIST_HEAD(&worker->queue);
+		worker->accepting_works = true;
+	}
+
+	for (; pool->started_worker_count < pool->worker_count; pool->started_worker_count++) {
+		struct worker *worker = &pool->workers[pool->started_worker_count];
+		const int ret = pthread_create(
+			&worker->thread, default_pthread_attr(), worker_thread, worker);
+
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create %s", worker->name);
+			goto error;
+		}
+	}
+
+	DBG("Thread pool %s created: thread count = %u", pool->name, pool->worker_count);
+	return pool;
+
+error:
+	lttng_thread_pool_destroy(pool);
+	return nullptr;
+}
+
+void lttng_thread_pool_destroy(struct lttng_thread_pool *pool)
+{
+	if (!pool) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < pool->worker_count; i++) {
+		pthread_mutex_lock(&pool->workers[i].lock);
+		pool->workers[i].accepting_works = false;
+		pthread_mutex_unlock(&pool->workers[i].lock);
+	}
+
+	pthread_mutex_lock(&pool->idle_lock);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->work_queued);
+	pthread_mutex_unlock(&pool->idle_lock);
+
+	/* The threads only quit once the queues are empty. */
+	for (unsigned int i = 0; i < pool->started_worker_count; i++) {
+		const int ret = pthread_join(pool->workers[i].thread, nullptr);
+
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join %s", pool->workers[i].name);
+		}
+	}
+
+	for (unsigned int i = 0; i < pool->worker_count; i++) {
+		LTTNG_ASSERT(cds_list_empty(&pool->workers[i].queue));
+		pthread_mutex_destroy(&pool->workers[i].lock);
+	}
+
+	DBG("Thread pool %s destroyed: submitted = %" PRIu64 ", completed = %" PRIu64
+	    ", stolen = %" PRIu64 ", max queued = %" PRIu64,
+	    pool->name ?: "(null)",
+	    pool->submitted,
+	    pool->completed,
+	    pool->stolen,
+	    pool->max_queued);
+	pthread_cond_destroy(&pool->work_queued);
+	pthread_mutex_destroy(&pool->idle_lock);
+	free(pool->workers);
+	free(pool->name);
+	free(pool);
+}
+
+bool lttng_thread_pool_submit(struct lttng_thread_pool *pool, struct lttng_thread_pool_work *work)
+{
+	struct worker *worker;
+	uint64_t queued;
+	bool accepted;
+
+	LTTNG_ASSERT(pool);
+	LTTNG_ASSERT(work);
+	LTTNG_ASSERT(work->run);
+
+	if (current_worker && current_worker->pool == pool) {
+		worker = current_worker;
+	} else {
+		worker = &pool->workers[uatomic_add_return(&pool->next_worker, 1) %
+					pool->worker_count];
+	}
+
+	/* Counted first so that no thread waits while the work is being queued. */
+	queued = uatomic_add_return(&pool->queued, 1);
+
+	pthread_mutex_lock(&worker->lock);
+	accepted = worker->accepting_works;
+	if (accepted) {
+		cds_list_add_tail(&work->node, &worker->queue);
+	}
+	pthread_mutex_unlock(&worker->lock);
+
+	if (!accepted) {
+		uatomic_dec(&pool->queued);
+		return false;
+	}
+
+	uatomic_inc(&pool->submitted);
+	update_max_queued(pool, queued);
+
+	/* uatomic_add_return() orders the increment of `queued` before this read. */
+	if (uatomic_read(&pool->idle_count) > 0) {
+		pthread_mutex_lock(&pool->idle_lock);
+		pthread_cond_signal(&pool->work_queued);
+		pthread_mutex_unlock(&pool->idle_lock);
+	}
+
+	return true;
+}
+
+void lttng_thread_pool_get_stats(const struct lttng_thread_pool *pool,
+				 struct lttng_thread_pool_stats *stats)
+{
+	LTTNG_ASSERT(pool);
+	LTTNG_ASSERT(stats);
+
+	stats->submitted = uatomic_read(&pool->submitted);
+	stats->completed = uatomic_read(&pool->completed);
+	stats->stolen = uatomic_read(&pool->stolen);
+	stats->queued = uatomic_read(&pool->queued);
+	stats->max_queued = uatomic_read(&pool->max_queued);
+}
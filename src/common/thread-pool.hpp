@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_THREAD_POOL_HPP
+#define LTTNG_THREAD_POOL_HPP
+
+#include <common/macros.hpp>
+
+#include <sched.h>
+#include <stdint.h>
+#include <urcu/list.h>
+
+struct health_app;
+struct lttng_thread_pool;
+
+/*
+ * Unit of work run by a thread of a pool. Meant to be embedded in the
+ * structure holding the state of the work, which `run` retrieves with
+ * container_of() and owns from then on.
+ */
+struct lttng_thread_pool_work {
+	struct cds_list_head node;
+	void (*run)(struct lttng_thread_pool_work *work);
+};
+
+struct lttng_thread_pool_attr {
+	/* Prefix of the thread names, followed by the index of each thread. */
+	const char *name;
+	unsigned int thread_count;
+	/* Health application and thread type to register the threads to, if set. */
+	struct health_app *health;
+	int health_type;
+	/* CPUs to which the threads are pinned, if set. */
+	const cpu_set_t *cpus;
+};
+
+struct lttng_thread_pool_stats {
+	uint64_t submitted;
+	uint64_t completed;
+	/* Works run by another thread than the one they were queued to. */
+	uint64_t stolen;
+	/* Works queued and not yet started, and the highest value it reached. */
+	uint64_t queued;
+	uint64_t max_queued;
+};
+
+/*
+ * Pool of threads running the works submitted to it.
+ *
+ * Each thread has its own queue. The works submitted from outside the pool are
+ * spread over the queues in turn; those submitted from a thread of the pool go
+ * to its own queue. A thread with an empty queue takes the oldest work of the
+ * other queues before waiting for new works, so that a long work doesn't delay
+ * the works queued behind it while other threads are idle.
+ *
+ * The threads are registered to RCU and, when requested, to a health
+ * application: they are reported as polling while they wait for works.
+ *
+ * Return NULL on error.
+ */
+struct lttng_thread_pool *lttng_thread_pool_create(const struct lttng_thread_pool_attr *attr);
+
+/*
+ * Run the works left in the queues, stop the threads and free the pool. The
+ * works submitted afterwards are refused.
+ */
+void lttng_thread_pool_destroy(struct lttng_thread_pool *pool);
+
+/*
+ * Queue a work to the pool, transferring its ownership.
+ *
+ * Return false, keeping the ownership with the caller, if the pool is being
+ * destroyed.
+ */
+bool lttng_thread_pool_submit(struct lttng_thread_pool *pool, struct lttng_thread_pool_work *work);
+
+void lttng_thread_pool_get_stats(const struct lttng_thread_pool *pool,
+				 struct lttng_thread_pool_stats *stats);
+
+#endif /* LTTNG_THREAD_POOL_HPP */
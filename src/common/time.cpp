@@ -57,6 +57,46 @@ struct timespec timespec_abs_diff(struct timespec t1, struct timespec t2)
 	return res;
 }
 
+namespace {
+thread_local uint64_t thread_clock_now_ns;
+
+uint64_t clock_now_ns(clockid_t clock_id)
+{
+	struct timespec now;
+
+	if (lttng_clock_gettime(clock_id, &now)) {
+		PERROR("Failed to sample the monotonic clock");
+		return 0;
+	}
+
+	return (uint64_t) now.tv_sec * NSEC_PER_SEC + (uint64_t) now.tv_nsec;
+}
+} /* namespace */
+
+uint64_t lttng_monotonic_now_ns()
+{
+	return clock_now_ns(CLOCK_MONOTONIC);
+}
+
+uint64_t lttng_monotonic_coarse_now_ns()
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+	return clock_now_ns(CLOCK_MONOTONIC_COARSE);
+#else
+	return clock_now_ns(CLOCK_MONOTONIC);
+#endif
+}
+
+void lttng_thread_clock_refresh()
+{
+	thread_clock_now_ns = lttng_monotonic_coarse_now_ns();
+}
+
+uint64_t lttng_thread_clock_now_ns()
+{
+	return thread_clock_now_ns ? thread_clock_now_ns : lttng_monotonic_coarse_now_ns();
+}
+
 static void __attribute__((constructor)) init_locale_utf8_support()
 {
 	const char *program_locale = setlocale(LC_ALL, nullptr);
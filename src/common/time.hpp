@@ -13,6 +13,7 @@
 
 #include <ctime>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string>
 #include <time.h>
 
@@ -54,6 +55,33 @@ int timespec_to_ms(struct timespec ts, unsigned long *ms);
  */
 struct timespec timespec_abs_diff(struct timespec ts_a, struct timespec ts_b);
 
+/*
+ * Time of the monotonic clock in nanoseconds, 0 if it can't be sampled.
+ */
+uint64_t lttng_monotonic_now_ns();
+
+/*
+ * Time of the coarse monotonic clock in nanoseconds, 0 if it can't be
+ * sampled.
+ *
+ * The coarse clock has the resolution of the kernel tick (1 to 10 ms), but is
+ * cheaper to read as it doesn't access the clock hardware. It is meant for
+ * the bookkeeping of the timeouts and rates on hot paths. The monotonic
+ * clock is used where the coarse one is not available.
+ */
+uint64_t lttng_monotonic_coarse_now_ns();
+
+/*
+ * Coarse monotonic time of the calling thread, in nanoseconds, as of its
+ * last lttng_thread_clock_refresh() call.
+ *
+ * Event loops refresh it once per iteration so that the bookkeeping of the
+ * events which they handle samples the clock once. The coarse monotonic
+ * clock is sampled when the calling thread never refreshed it.
+ */
+void lttng_thread_clock_refresh();
+uint64_t lttng_thread_clock_now_ns();
+
 /*
  * Format a Unix timestamp to an ISO 8601 compatible timestamp of
  * the form "YYYYmmddTHHMMSS+HHMM" in local time. `len` must >= to
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include "timer-wheel.hpp"
+
+#include <common/macros.hpp>
+
+#include <algorithm>
+
+namespace {
+constexpr uint64_t slot_mask = lttng::timer_wheel::slot_count - 1;
+
+unsigned int level_shift(unsigned int level) noexcept
+{
+	return lttng::timer_wheel::slot_bits * level;
+}
+
+uint64_t rotate_right(uint64_t value, unsigned int count) noexcept
+{
+	count &= 63;
+	return count ? (value >> count) | (value << (64 - count)) : value;
+}
+} /* namespace */
+
+lttng::timer_wheel::timer_wheel(uint64_t current_tick) noexcept : _current_tick(current_tick)
+{
+	for (auto& level : _slots) {
+		for (auto& slot : level) {
+			CDS_INIT_LIST_HEAD(&slot);
+		}
+	}
+}
+
+void lttng::timer_wheel::_insert(entry& timer) noexcept
+{
+	/* Expiries of the current tick only occur while cascading. */
+	LTTNG_ASSERT(timer.expiry_tick >= _current_tick);
+
+	const uint64_t delta = timer.expiry_tick - _current_tick;
+	const unsigned int top_level = level_count - 1;
+	uint64_t slot_tick = timer.expiry_tick;
+	unsigned int level = 0;
+
+	while (level < top_level && (delta >> level_shift(level + 1))) {
+		level++;
+	}
+
+	if (level == top_level && (delta >> level_shift(level_count))) {
+		/*
+		 * Beyond the range of the wheel: park the entry in the farthest
+		 * slot, it is placed again when that slot is cascaded.
+		 */
+		slot_tick = _current_tick + (UINT64_C(1) << level_shift(level_count)) - 1;
+	}
+
+	timer.level = level;
+	timer.slot = (slot_tick >> level_shift(level)) & slot_mask;
+	cds_list_add_tail(&timer.node, &_slots[level][timer.slot]);
+	_occupied_slots[level] |= UINT64_C(1) << timer.slot;
+}
+
+void lttng::timer_wheel::_remove(entry& timer) noexcept
+{
+	cds_list_del(&timer.node);
+	if (cds_list_empty(&_slots[timer.level][timer.slot])) {
+		_occupied_slots[timer.level] &= ~(UINT64_C(1) << timer.slot);
+	}
+}
+
+void lttng::timer_wheel::_cascade(unsigned int level)
+{
+	const unsigned int slot = (_current_tick >> level_shift(level)) & slot_mask;
+	struct cds_list_head entries;
+	entry *timer, *tmp;
+
+	if (!(_occupied_slots[level] & (UINT64_C(1) << slot))) {
+		return;
+	}
+
+	/* Entries parked beyond the range may land in this slot again. */
+	CDS_INIT_LIST_HEAD(&entries);
+	cds_list_splice(&_slots[level][slot], &entries);
+	CDS_INIT_LIST_HEAD(&_slots[level][slot]);
+	_occupied_slots[level] &= ~(UINT64_C(1) << slot);
+
+	cds_list_for_each_entry_safe (timer, tmp, &entries, node) {
+		cds_list_del(&timer->node);
+		_insert(*timer);
+	}
+}
+
+void lttng::timer_wheel::schedule(entry& timer, uint64_t expiry_tick) noexcept
+{
+	if (timer.scheduled) {
+		_remove(timer);
+	} else {
+		timer.scheduled = true;
+		_entry_count++;
+	}
+
+	timer.expiry_tick = std::max(expiry_tick, _current_tick + 1);
+	_insert(timer);
+}
+
+void lttng::timer_wheel::cancel(entry& timer) noexcept
+{
+	if (!timer.scheduled) {
+		return;
+	}
+
+	_remove(timer);
+	timer.scheduled = false;
+	_entry_count--;
+}
+
+void lttng::timer_wheel::advance(uint64_t tick, std::vector<entry *>& expired)
+{
+	while (_current_tick < tick) {
+		const uint64_t next = next_tick();
+		struct cds_list_head *slot;
+		entry *timer, *tmp;
+
+		/* Skip the ticks during which nothing happens. */
+		if (next > tick) {
+			_current_tick = tick;
+			break;
+		}
+
+		_current_tick = next;
+		for (unsigned int level = level_count - 1; level > 0; level--) {
+			if (!(_current_tick & ((UINT64_C(1) << level_shift(level)) - 1))) {
+				_cascade(level);
+			}
+		}
+
+		slot = &_slots[0][_current_tick & slot_mask];
+		cds_list_for_each_entry_safe (timer, tmp, slot, node) {
+			LTTNG_ASSERT(timer->expiry_tick == _current_tick);
+			cds_list_del(&timer->node);
+			timer->scheduled = false;
+			_entry_count--;
+			expired.push_back(timer);
+		}
+
+		_occupied_slots[0] &= ~(UINT64_C(1) << (_current_tick & slot_mask));
+	}
+}
+
+uint64_t lttng::timer_wheel::next_tick() const noexcept
+{
+	uint64_t next = UINT64_MAX;
+
+	if (empty()) {
+		return next;
+	}
+
+	for (unsigned int level = 0; level < level_count; level++) {
+		const uint64_t base = _current_tick >> level_shift(level);
+		uint64_t rotated;
+
+		if (!_occupied_slots[level]) {
+			continue;
+		}
+
+		/* Bit i of `rotated` is the slot reached in i + 1 slot periods. */
+		rotated = rotate_right(_occupied_slots[level], (base + 1) & slot_mask);
+		next = std::min(next, (base + __builtin_ctzll(rotated) + 1) << level_shift(level));
+	}
+
+	return next;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_TIMER_WHEEL_HPP
+#define LTTNG_TIMER_WHEEL_HPP
+
+#include <stdint.h>
+#include <urcu/list.h>
+#include <vector>
+
+namespace lttng {
+
+/*
+ * Hierarchical timer wheel counting time in abstract ticks.
+ *
+ * Each of the `level_count` levels has `slot_count` slots; a slot of level L
+ * spans slot_count^L ticks. A timer is placed in the lowest level that can
+ * hold its expiry and is moved down a level ("cascaded") when the wheel
+ * reaches the start of its slot. Scheduling and cancelling a timer are O(1).
+ *
+ * The wheel doesn't own its entries and is not thread-safe.
+ */
+class timer_wheel {
+public:
+	static constexpr unsigned int slot_bits = 6;
+	static constexpr unsigned int slot_count = 1U << slot_bits;
+	static constexpr unsigned int level_count = 6;
+
+	/* A timer, meant to be embedded in its owner's structure. */
+	struct entry {
+		struct cds_list_head node = {};
+		uint64_t expiry_tick = 0;
+		unsigned int level = 0;
+		unsigned int slot = 0;
+		bool scheduled = false;
+	};
+
+	explicit timer_wheel(uint64_t current_tick = 0) noexcept;
+	timer_wheel(const timer_wheel&) = delete;
+	timer_wheel& operator=(const timer_wheel&) = delete;
+
+	/*
+	 * Schedule an entry to expire at `expiry_tick`, rescheduling it if it is
+	 * already scheduled. An expiry which is not in the future is moved to
+	 * the next tick.
+	 */
+	void schedule(entry& timer, uint64_t expiry_tick) noexcept;
+
+	/* Cancel an entry. Cancelling an entry which is not scheduled is a no-op. */
+	void cancel(entry& timer) noexcept;
+
+	/*
+	 * Advance the wheel up to `tick` and append the entries which expired
+	 * in the meantime to `expired`. Expired entries are no longer scheduled.
+	 */
+	void advance(uint64_t tick, std::vector<entry *>& expired);
+
+	/*
+	 * Return the first tick at which the wheel has work to perform, either
+	 * expiring or cascading entries; UINT64_MAX if it is empty. This tick is
+	 * never later than the earliest expiry.
+	 */
+	uint64_t next_tick() const noexcept;
+
+	uint64_t current_tick() const noexcept
+	{
+		return _current_tick;
+	}
+
+	bool empty() const noexcept
+	{
+		return _entry_count == 0;
+	}
+
+private:
+	void _insert(entry& timer) noexcept;
+	void _remove(entry& timer) noexcept;
+	void _cascade(unsigned int level);
+
+	struct cds_list_head _slots[level_count][slot_count];
+	/* Bitmap of the non-empty slots of each level. */
+	uint64_t _occupied_slots[level_count] = {};
+	uint64_t _current_tick;
+	uint64_t _entry_count = 0;
+};
+
+} /* namespace lttng */
+
+#endif /* LTTNG_TIMER_WHEEL_HPP */
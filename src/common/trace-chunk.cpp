@@ -26,10 +26,17 @@
 
 #include <lttng/constant.h>
 
+#include <fcntl.h>
 #include <inttypes.h>
+#include <iterator>
+#include <list>
+#include <new>
 #include <pthread.h>
 #include <stdio.h>
+#include <string>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unordered_map>
 #include <urcu/rculfhash.h>
 #include <urcu/ref.h>
 
@@ -86,11 +93,8 @@ struct lttng_trace_chunk {
 	 * Only used by _owner_ mode chunks.
 	 */
 	struct lttng_dynamic_pointer_array top_level_directories;
-	/*
-	 * All files contained within the trace chunk.
-	 * Array of paths (char *).
-	 */
-	struct lttng_dynamic_pointer_array files;
+	/* All files contained within the trace chunk, null until one is added. */
+	struct trace_chunk_files *files;
 	/* Is contained within an lttng_trace_chunk_registry_element? */
 	bool in_registry_element;
 	bool name_overridden;
@@ -110,6 +114,9 @@ struct lttng_trace_chunk {
 	struct lttng_directory_handle *session_output_directory;
 	struct lttng_directory_handle *chunk_directory;
 	LTTNG_OPTIONAL(enum lttng_trace_chunk_command_type) close_command;
+	/* Invoked on release, after the close command. Not copied. */
+	lttng_trace_chunk_release_cb release_callback;
+	void *release_callback_data;
 	/*
 	 * fd_tracker instance through which file descriptors should be
 	 * created/closed.
@@ -118,6 +125,11 @@ struct lttng_trace_chunk {
 	 * need to perform any reference counting of that object.
 	 */
 	struct fd_tracker *fd_tracker;
+	/*
+	 * Files kept in memory instead of the chunk directory, shared with the
+	 * copies of the chunk. Null when the files are in the chunk directory.
+	 */
+	struct memory_files *memory_files;
 };
 
 namespace {
@@ -148,9 +160,49 @@ struct fs_handle_untracked {
 };
 } /* namespace */
 
+namespace {
+/*
+ * Memory file, a memfd which is reopened through procfs so that its handles
+ * have their own file offset.
+ */
+struct memory_file {
+	/* Relative to the chunk directory. */
+	char *path;
+	int fd;
+};
+} /* namespace */
+
+struct memory_files {
+	struct urcu_ref ref;
+	pthread_mutex_t lock;
+	/* struct memory_file */
+	struct lttng_dynamic_pointer_array files;
+};
+
+/*
+ * Paths of the files of a trace chunk, relative to the chunk directory. Each
+ * path is stored once, as a key of `index`, and `paths` lists them in their
+ * order of addition.
+ */
+struct trace_chunk_files {
+	std::list<const std::string *> paths;
+	/* Position of each path in `paths`. */
+	std::unordered_map<std::string, std::list<const std::string *>::iterator> index;
+};
+
+namespace {
+struct fs_handle_memory {
+	struct fs_handle parent;
+	int fd;
+	struct memory_files *files;
+	char *path;
+};
+} /* namespace */
+
 static int fs_handle_untracked_get_fd(struct fs_handle *handle);
 static void fs_handle_untracked_put_fd(struct fs_handle *handle);
 static int fs_handle_untracked_unlink(struct fs_handle *handle);
+static int fs_handle_untracked_rename(struct fs_handle *handle, const char *new_path);
 static int fs_handle_untracked_close(struct fs_handle *handle);
 
 static const char *lttng_trace_chunk_command_type_str(lttng_trace_chunk_command_type type)
@@ -209,6 +261,7 @@ static struct fs_handle *fs_handle_untracked_create(struct lttng_directory_handl
 		.get_fd = fs_handle_untracked_get_fd,
 		.put_fd = fs_handle_untracked_put_fd,
 		.unlink = fs_handle_untracked_unlink,
+		.rename = fs_handle_untracked_rename,
 		.close = fs_handle_untracked_close,
 	};
 
@@ -246,6 +299,32 @@ static int fs_handle_untracked_unlink(struct fs_handle *_handle)
 						  handle->location.path);
 }
 
+static int fs_handle_untracked_rename(struct fs_handle *_handle, const char *new_path)
+{
+	int ret;
+	struct fs_handle_untracked *handle =
+		lttng::utils::container_of(_handle, &fs_handle_untracked::parent);
+	char *new_path_copy = strdup(new_path);
+
+	if (!new_path_copy) {
+		PERROR("Failed to copy file path while renaming untracked filesystem handle");
+		return -1;
+	}
+
+	ret = lttng_directory_handle_rename(handle->location.directory_handle,
+					    handle->location.path,
+					    handle->location.directory_handle,
+					    new_path);
+	if (ret) {
+		free(new_path_copy);
+		return ret;
+	}
+
+	free(handle->location.path);
+	handle->location.path = new_path_copy;
+	return 0;
+}
+
 static void fs_handle_untracked_destroy(struct fs_handle_untracked *handle)
 {
 	lttng_directory_handle_put(handle->location.directory_handle);
@@ -263,6 +342,304 @@ static int fs_handle_untracked_close(struct fs_handle *_handle)
 	return ret;
 }
 
+static void memory_file_destroy(void *ptr)
+{
+	struct memory_file *file = (struct memory_file *) ptr;
+
+	if (close(file->fd)) {
+		PERROR("Failed to close memory file \"%s\"", file->path);
+	}
+
+	free(file->path);
+	free(file);
+}
+
+static struct memory_files *memory_files_create()
+{
+	struct memory_files *files = zmalloc<memory_files>();
+
+	if (!files) {
+		PERROR("Failed to allocate trace chunk memory files");
+		return nullptr;
+	}
+
+	urcu_ref_init(&files->ref);
+	pthread_mutex_init(&files->lock, nullptr);
+	lttng_dynamic_pointer_array_init(&files->files, memory_file_destroy);
+	return files;
+}
+
+static void memory_files_release(struct urcu_ref *ref)
+{
+	struct memory_files *files = lttng::utils::container_of(ref, &memory_files::ref);
+
+	lttng_dynamic_pointer_array_reset(&files->files);
+	pthread_mutex_destroy(&files->lock);
+	free(files);
+}
+
+static void memory_files_get(struct memory_files *files)
+{
+	urcu_ref_get(&files->ref);
+}
+
+static void memory_files_put(struct memory_files *files)
+{
+	if (!files) {
+		return;
+	}
+
+	urcu_ref_put(&files->ref, memory_files_release);
+}
+
+/* Called with the memory files lock held. */
+static bool memory_files_find(struct memory_files *files, const char *path, size_t *index)
+{
+	const size_t count = lttng_dynamic_pointer_array_get_count(&files->files);
+
+	for (size_t i = 0; i < count; i++) {
+		const struct memory_file *file = (const struct memory_file *)
+			lttng_dynamic_pointer_array_get_pointer(&files->files, i);
+
+		if (!strcmp(file->path, path)) {
+			*index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Called with the memory files lock held. */
+static struct memory_file *memory_files_create_file(struct memory_files *files, const char *path)
+{
+#ifdef HAVE_MEMFD_CREATE
+	const char *name = strrchr(path, '/');
+	struct memory_file *file = zmalloc<memory_file>();
+
+	if (!file) {
+		PERROR("Failed to allocate memory file");
+		return nullptr;
+	}
+
+	file->fd = memfd_create(name ? name + 1 : path, MFD_CLOEXEC);
+	if (file->fd < 0) {
+		PERROR("Failed to create memory file \"%s\"", path);
+		free(file);
+		return nullptr;
+	}
+
+	file->path = strdup(path);
+	if (!file->path || lttng_dynamic_pointer_array_add_pointer(&files->files, file)) {
+		ERR("Failed to add memory file \"%s\"", path);
+		memory_file_destroy(file);
+		return nullptr;
+	}
+
+	return file;
+#else /* HAVE_MEMFD_CREATE */
+	ERR("Memory files are not supported on this platform: refusing to create \"%s\"", path);
+	errno = ENOSYS;
+	return nullptr;
+#endif /* HAVE_MEMFD_CREATE */
+}
+
+/*
+ * Open a memory file with open(2) flags, creating it if `O_CREAT` is set.
+ *
+ * Return the new file descriptor, or -1 with `errno` set on error.
+ */
+static int memory_files_open(struct memory_files *files, const char *path, int flags)
+{
+	int fd = -1;
+	size_t index;
+	struct memory_file *file;
+	char proc_path[sizeof("/proc/self/fd/") + MAX_INT_DEC_LEN(int)];
+
+	pthread_mutex_lock(&files->lock);
+	if (memory_files_find(files, path, &index)) {
+		if ((flags & O_CREAT) && (flags & O_EXCL)) {
+			errno = EEXIST;
+			goto end;
+		}
+
+		file = (struct memory_file *) lttng_dynamic_pointer_array_get_pointer(&files->files,
+										    index);
+	} else if (!(flags & O_CREAT)) {
+		errno = ENOENT;
+		goto end;
+	} else {
+		file = memory_files_create_file(files, path);
+		if (!file) {
+			goto end;
+		}
+	}
+
+	sprintf(proc_path, "/proc/self/fd/%d", file->fd);
+	fd = open(proc_path, (flags & ~(O_CREAT | O_EXCL)) | O_CLOEXEC);
+end:
+	pthread_mutex_unlock(&files->lock);
+	return fd;
+}
+
+/*
+ * Remove a memory file; its memory is released once its handles are closed.
+ *
+ * Return 0 on success, or -1 with `errno` set if the file doesn't exist.
+ */
+static int memory_files_unlink(struct memory_files *files, const char *path)
+{
+	int ret = 0;
+	size_t index;
+
+	pthread_mutex_lock(&files->lock);
+	if (!memory_files_find(files, path, &index)) {
+		errno = ENOENT;
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng_dynamic_pointer_array_remove_pointer(&files->files, index);
+	LTTNG_ASSERT(!ret);
+end:
+	pthread_mutex_unlock(&files->lock);
+	return ret;
+}
+
+/*
+ * Rename a memory file, replacing the file found at `new_path`, if any.
+ *
+ * Return 0 on success, or -1 with `errno` set on error.
+ */
+static int memory_files_rename(struct memory_files *files, const char *path, const char *new_path)
+{
+	int ret = -1;
+	size_t index, replaced_index;
+	struct memory_file *file;
+	char *new_path_copy = strdup(new_path);
+
+	if (!new_path_copy) {
+		return -1;
+	}
+
+	pthread_mutex_lock(&files->lock);
+	if (!memory_files_find(files, path, &index)) {
+		errno = ENOENT;
+		goto end;
+	}
+
+	if (strcmp(path, new_path) && memory_files_find(files, new_path, &replaced_index)) {
+		ret = lttng_dynamic_pointer_array_remove_pointer(&files->files, replaced_index);
+		LTTNG_ASSERT(!ret);
+		if (replaced_index < index) {
+			index--;
+		}
+	}
+
+	file = (struct memory_file *) lttng_dynamic_pointer_array_get_pointer(&files->files, index);
+	free(file->path);
+	/* Ownership is transferred. */
+	file->path = new_path_copy;
+	new_path_copy = nullptr;
+	ret = 0;
+end:
+	pthread_mutex_unlock(&files->lock);
+	free(new_path_copy);
+	return ret;
+}
+
+static int fs_handle_memory_get_fd(struct fs_handle *_handle)
+{
+	struct fs_handle_memory *handle =
+		lttng::utils::container_of(_handle, &fs_handle_memory::parent);
+
+	return handle->fd;
+}
+
+static void fs_handle_memory_put_fd(struct fs_handle *_handle __attribute__((unused)))
+{
+	/* no-op. */
+}
+
+static int fs_handle_memory_unlink(struct fs_handle *_handle)
+{
+	struct fs_handle_memory *handle =
+		lttng::utils::container_of(_handle, &fs_handle_memory::parent);
+
+	return memory_files_unlink(handle->files, handle->path);
+}
+
+static int fs_handle_memory_rename(struct fs_handle *_handle, const char *new_path)
+{
+	struct fs_handle_memory *handle =
+		lttng::utils::container_of(_handle, &fs_handle_memory::parent);
+	char *new_path_copy = strdup(new_path);
+
+	if (!new_path_copy) {
+		PERROR("Failed to copy file path while renaming memory file handle");
+		return -1;
+	}
+
+	if (memory_files_rename(handle->files, handle->path, new_path)) {
+		free(new_path_copy);
+		return -1;
+	}
+
+	free(handle->path);
+	handle->path = new_path_copy;
+	return 0;
+}
+
+static int fs_handle_memory_close(struct fs_handle *_handle)
+{
+	struct fs_handle_memory *handle =
+		lttng::utils::container_of(_handle, &fs_handle_memory::parent);
+	const int ret = close(handle->fd);
+
+	memory_files_put(handle->files);
+	free(handle->path);
+	free(handle);
+	return ret;
+}
+
+/* Takes ownership of `fd`, even on error. */
+static struct fs_handle *
+fs_handle_memory_create(struct memory_files *files, const char *path, int fd)
+{
+	struct fs_handle_memory *handle = zmalloc<fs_handle_memory>();
+
+	if (!handle) {
+		PERROR("Failed to allocate memory file handle");
+		goto error;
+	}
+
+	handle->path = strdup(path);
+	if (!handle->path) {
+		PERROR("Failed to copy file path while creating memory file handle");
+		goto error;
+	}
+
+	handle->parent = (typeof(handle->parent)){
+		.get_fd = fs_handle_memory_get_fd,
+		.put_fd = fs_handle_memory_put_fd,
+		.unlink = fs_handle_memory_unlink,
+		.rename = fs_handle_memory_rename,
+		.close = fs_handle_memory_close,
+	};
+	handle->fd = fd;
+	memory_files_get(files);
+	handle->files = files;
+	return &handle->parent;
+
+error:
+	if (handle) {
+		free(handle->path);
+		free(handle);
+	}
+	(void) close(fd);
+	return nullptr;
+}
+
 static bool
 lttng_trace_chunk_registry_element_equals(const struct lttng_trace_chunk_registry_element *a,
 					  const struct lttng_trace_chunk_registry_element *b)
@@ -347,12 +724,17 @@ error:
 	return nullptr;
 }
 
+static size_t lttng_trace_chunk_file_count(const struct lttng_trace_chunk *chunk)
+{
+	return chunk->files ? chunk->files->paths.size() : 0;
+}
+
 static void lttng_trace_chunk_init(struct lttng_trace_chunk *chunk)
 {
 	urcu_ref_init(&chunk->ref);
 	pthread_mutex_init(&chunk->lock, nullptr);
 	lttng_dynamic_pointer_array_init(&chunk->top_level_directories, free);
-	lttng_dynamic_pointer_array_init(&chunk->files, free);
+	chunk->files = nullptr;
 }
 
 static void lttng_trace_chunk_fini(struct lttng_trace_chunk *chunk)
@@ -370,7 +752,10 @@ static void lttng_trace_chunk_fini(struct lttng_trace_chunk *chunk)
 	free(chunk->path);
 	chunk->path = nullptr;
 	lttng_dynamic_pointer_array_reset(&chunk->top_level_directories);
-	lttng_dynamic_pointer_array_reset(&chunk->files);
+	delete chunk->files;
+	chunk->files = nullptr;
+	memory_files_put(chunk->memory_files);
+	chunk->memory_files = nullptr;
 	pthread_mutex_destroy(&chunk->lock);
 }
 
@@ -460,10 +845,19 @@ void lttng_trace_chunk_set_fd_tracker(struct lttng_trace_chunk *chunk,
 {
 	LTTNG_ASSERT(!chunk->session_output_directory);
 	LTTNG_ASSERT(!chunk->chunk_directory);
-	LTTNG_ASSERT(lttng_dynamic_pointer_array_get_count(&chunk->files) == 0);
+	LTTNG_ASSERT(lttng_trace_chunk_file_count(chunk) == 0);
 	chunk->fd_tracker = fd_tracker;
 }
 
+enum lttng_trace_chunk_status lttng_trace_chunk_set_memory_files(struct lttng_trace_chunk *chunk)
+{
+	LTTNG_ASSERT(!chunk->memory_files);
+	LTTNG_ASSERT(lttng_trace_chunk_file_count(chunk) == 0);
+
+	chunk->memory_files = memory_files_create();
+	return chunk->memory_files ? LTTNG_TRACE_CHUNK_STATUS_OK : LTTNG_TRACE_CHUNK_STATUS_ERROR;
+}
+
 struct lttng_trace_chunk *lttng_trace_chunk_copy(struct lttng_trace_chunk *source_chunk)
 {
 	struct lttng_trace_chunk *new_chunk = lttng_trace_chunk_allocate();
@@ -521,6 +915,10 @@ struct lttng_trace_chunk *lttng_trace_chunk_copy(struct lttng_trace_chunk *sourc
 	}
 	new_chunk->close_command = source_chunk->close_command;
 	new_chunk->fd_tracker = source_chunk->fd_tracker;
+	if (source_chunk->memory_files) {
+		memory_files_get(source_chunk->memory_files);
+		new_chunk->memory_files = source_chunk->memory_files;
+	}
 	pthread_mutex_unlock(&source_chunk->lock);
 end:
 	return new_chunk;
@@ -1204,6 +1602,10 @@ enum lttng_trace_chunk_status lttng_trace_chunk_create_subdirectory(struct lttng
 		status = LTTNG_TRACE_CHUNK_STATUS_INVALID_ARGUMENT;
 		goto end;
 	}
+	if (chunk->memory_files) {
+		/* The paths of the memory files need no directory. */
+		goto end;
+	}
 	ret = lttng_directory_handle_create_subdirectory_recursive_as_user(
 		chunk->chunk_directory,
 		path,
@@ -1225,68 +1627,115 @@ end:
 	return status;
 }
 
-/*
- * TODO: Implement O(1) lookup.
- */
-static bool
-lttng_trace_chunk_find_file(struct lttng_trace_chunk *chunk, const char *path, size_t *index)
+enum lttng_trace_chunk_status
+lttng_trace_chunk_create_subdirectories(struct lttng_trace_chunk *chunk,
+					const char *const *paths,
+					size_t count)
 {
-	size_t i, count;
+	int ret;
+	size_t i;
+	enum lttng_trace_chunk_status status = LTTNG_TRACE_CHUNK_STATUS_OK;
 
-	count = lttng_dynamic_pointer_array_get_count(&chunk->files);
+	DBG("Creating %zu trace chunk subdirectories", count);
+	pthread_mutex_lock(&chunk->lock);
+	if (!chunk->credentials.is_set) {
+		/*
+		 * Fatal error, credentials must be set before a
+		 * directory is created.
+		 */
+		ERR("Credentials of trace chunk are unset: refusing to create subdirectories");
+		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
+		goto end;
+	}
+	if (!chunk->mode.is_set || chunk->mode.value != TRACE_CHUNK_MODE_OWNER) {
+		ERR("Attempted to create trace chunk subdirectories through a non-owner chunk");
+		status = LTTNG_TRACE_CHUNK_STATUS_INVALID_OPERATION;
+		goto end;
+	}
+	if (!chunk->chunk_directory) {
+		ERR("Attempted to create trace chunk subdirectories before setting the chunk output directory");
+		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
+		goto end;
+	}
 	for (i = 0; i < count; i++) {
-		const char *iter_path =
-			(const char *) lttng_dynamic_pointer_array_get_pointer(&chunk->files, i);
-		if (!strcmp(iter_path, path)) {
-			if (index) {
-				*index = i;
-			}
-			return true;
+		if (*paths[i] == '/') {
+			ERR("Refusing to create absolute trace chunk directory \"%s\"", paths[i]);
+			status = LTTNG_TRACE_CHUNK_STATUS_INVALID_ARGUMENT;
+			goto end;
 		}
 	}
-	return false;
+	if (chunk->memory_files) {
+		/* The paths of the memory files need no directory. */
+		goto end;
+	}
+	ret = lttng_directory_handle_create_subdirectories_recursive_as_user(
+		chunk->chunk_directory,
+		paths,
+		count,
+		DIR_CREATION_MODE,
+		chunk->credentials.value.use_current_user ? nullptr :
+							    &chunk->credentials.value.user);
+	if (ret) {
+		PERROR("Failed to create trace chunk subdirectories");
+		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
+		goto end;
+	}
+	for (i = 0; i < count; i++) {
+		ret = add_top_level_directory_unique(chunk, paths[i]);
+		if (ret) {
+			status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
+			goto end;
+		}
+	}
+end:
+	pthread_mutex_unlock(&chunk->lock);
+	return status;
 }
 
 static enum lttng_trace_chunk_status lttng_trace_chunk_add_file(struct lttng_trace_chunk *chunk,
 								const char *path)
 {
-	char *copy;
-	int ret;
-	enum lttng_trace_chunk_status status = LTTNG_TRACE_CHUNK_STATUS_OK;
+	struct trace_chunk_files *files;
 
-	if (lttng_trace_chunk_find_file(chunk, path, nullptr)) {
+	if (chunk->files && chunk->files->index.count(path)) {
 		return LTTNG_TRACE_CHUNK_STATUS_OK;
 	}
 	DBG("Adding new file \"%s\" to trace chunk \"%s\"", path, chunk->name ?: "(unnamed)");
-	copy = strdup(path);
-	if (!copy) {
-		PERROR("Failed to copy path");
-		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
-		goto end;
+	try {
+		if (!chunk->files) {
+			chunk->files = new trace_chunk_files;
+		}
+		files = chunk->files;
+		files->paths.push_back(nullptr);
+	} catch (const std::bad_alloc&) {
+		ERR("Allocation failure while adding file to a trace chunk");
+		return LTTNG_TRACE_CHUNK_STATUS_ERROR;
 	}
-	ret = lttng_dynamic_pointer_array_add_pointer(&chunk->files, copy);
-	if (ret) {
+
+	try {
+		const auto entry = files->index.emplace(path, std::prev(files->paths.end())).first;
+
+		files->paths.back() = &entry->first;
+	} catch (const std::bad_alloc&) {
 		ERR("Allocation failure while adding file to a trace chunk");
-		free(copy);
-		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
-		goto end;
+		files->paths.pop_back();
+		return LTTNG_TRACE_CHUNK_STATUS_ERROR;
 	}
-end:
-	return status;
+	return LTTNG_TRACE_CHUNK_STATUS_OK;
 }
 
 static void lttng_trace_chunk_remove_file(struct lttng_trace_chunk *chunk, const char *path)
 {
-	size_t index;
-	bool found;
-	int ret;
+	if (!chunk->files) {
+		return;
+	}
 
-	found = lttng_trace_chunk_find_file(chunk, path, &index);
-	if (!found) {
+	const auto entry = chunk->files->index.find(path);
+	if (entry == chunk->files->index.end()) {
 		return;
 	}
-	ret = lttng_dynamic_pointer_array_remove_pointer(&chunk->files, index);
-	LTTNG_ASSERT(!ret);
+	chunk->files->paths.erase(entry->second);
+	chunk->files->index.erase(entry);
 }
 
 static enum lttng_trace_chunk_status
@@ -1321,7 +1770,18 @@ _lttng_trace_chunk_open_fs_handle_locked(struct lttng_trace_chunk *chunk,
 	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
 		goto end;
 	}
-	if (chunk->fd_tracker) {
+	if (chunk->memory_files) {
+		/* Memory files are not tracked: they can't be closed and reopened by path. */
+		ret = memory_files_open(chunk->memory_files, file_path, flags);
+		if (ret >= 0) {
+			*out_handle = fs_handle_memory_create(chunk->memory_files, file_path, ret);
+			if (!*out_handle) {
+				lttng_trace_chunk_remove_file(chunk, file_path);
+				status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
+				goto end;
+			}
+		}
+	} else if (chunk->fd_tracker) {
 		LTTNG_ASSERT(chunk->credentials.value.use_current_user);
 		*out_handle = fd_tracker_open_fs_handle(
 			chunk->fd_tracker, chunk->chunk_directory, file_path, flags, &mode);
@@ -1392,6 +1852,7 @@ enum lttng_trace_chunk_status lttng_trace_chunk_open_file(struct lttng_trace_chu
 	 * used since the resulting file descriptor would not be tracked.
 	 */
 	LTTNG_ASSERT(!chunk->fd_tracker);
+	LTTNG_ASSERT(!chunk->memory_files);
 	status = _lttng_trace_chunk_open_fs_handle_locked(
 		chunk, file_path, flags, mode, &fs_handle, expect_no_file);
 	pthread_mutex_unlock(&chunk->lock);
@@ -1431,11 +1892,15 @@ int lttng_trace_chunk_unlink_file(struct lttng_trace_chunk *chunk, const char *f
 		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
 		goto end;
 	}
-	ret = lttng_directory_handle_unlink_file_as_user(chunk->chunk_directory,
-							 file_path,
-							 chunk->credentials.value.use_current_user ?
-								 nullptr :
-								 &chunk->credentials.value.user);
+	if (chunk->memory_files) {
+		ret = memory_files_unlink(chunk->memory_files, file_path);
+	} else {
+		ret = lttng_directory_handle_unlink_file_as_user(
+			chunk->chunk_directory,
+			file_path,
+			chunk->credentials.value.use_current_user ? nullptr :
+								    &chunk->credentials.value.user);
+	}
 	if (ret < 0) {
 		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
 		goto end;
@@ -1446,6 +1911,39 @@ end:
 	return status;
 }
 
+enum lttng_trace_chunk_status lttng_trace_chunk_rename_fs_handle(struct lttng_trace_chunk *chunk,
+								 struct fs_handle *handle,
+								 const char *file_path,
+								 const char *new_file_path)
+{
+	bool replaces_file;
+	enum lttng_trace_chunk_status status;
+
+	DBG("Renaming trace chunk file \"%s\" to \"%s\"", file_path, new_file_path);
+	pthread_mutex_lock(&chunk->lock);
+	replaces_file = chunk->files && chunk->files->index.count(new_file_path);
+	status = lttng_trace_chunk_add_file(chunk, new_file_path);
+	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		goto end;
+	}
+
+	if (fs_handle_rename(handle, new_file_path)) {
+		PERROR("Failed to rename trace chunk file \"%s\" to \"%s\"",
+		       file_path,
+		       new_file_path);
+		if (!replaces_file) {
+			lttng_trace_chunk_remove_file(chunk, new_file_path);
+		}
+		status = LTTNG_TRACE_CHUNK_STATUS_ERROR;
+		goto end;
+	}
+
+	lttng_trace_chunk_remove_file(chunk, file_path);
+end:
+	pthread_mutex_unlock(&chunk->lock);
+	return status;
+}
+
 static int lttng_trace_chunk_remove_subdirectory_recursive(struct lttng_trace_chunk *chunk,
 							   const char *path)
 {
@@ -1589,13 +2087,12 @@ static int lttng_trace_chunk_delete_post_release_user(struct lttng_trace_chunk *
 	DBG("Trace chunk \"delete\" close command post-release (User)");
 
 	/* Unlink all files. */
-	while (lttng_dynamic_pointer_array_get_count(&trace_chunk->files) != 0) {
+	while (lttng_trace_chunk_file_count(trace_chunk) != 0) {
 		enum lttng_trace_chunk_status status;
 		const char *path;
 
 		/* Remove first. */
-		path = (const char *) lttng_dynamic_pointer_array_get_pointer(&trace_chunk->files,
-									      0);
+		path = trace_chunk->files->paths.front()->c_str();
 		DBG("Unlink file: %s", path);
 		status =
 			(lttng_trace_chunk_status) lttng_trace_chunk_unlink_file(trace_chunk, path);
@@ -1747,6 +2244,25 @@ const char *lttng_trace_chunk_command_type_get_name(enum lttng_trace_chunk_comma
 	}
 }
 
+enum lttng_trace_chunk_status lttng_trace_chunk_set_release_callback(
+	struct lttng_trace_chunk *chunk, lttng_trace_chunk_release_cb callback, void *data)
+{
+	enum lttng_trace_chunk_status status = LTTNG_TRACE_CHUNK_STATUS_OK;
+
+	pthread_mutex_lock(&chunk->lock);
+	if (chunk->release_callback) {
+		ERR("Failed to set trace chunk release callback: a callback is already set");
+		status = LTTNG_TRACE_CHUNK_STATUS_INVALID_OPERATION;
+		goto end;
+	}
+
+	chunk->release_callback = callback;
+	chunk->release_callback_data = data;
+end:
+	pthread_mutex_unlock(&chunk->lock);
+	return status;
+}
+
 bool lttng_trace_chunk_ids_equal(const struct lttng_trace_chunk *chunk_a,
 				 const struct lttng_trace_chunk *chunk_b)
 {
@@ -1793,6 +2309,7 @@ static void free_lttng_trace_chunk_registry_element(struct rcu_head *node)
 static void lttng_trace_chunk_release(struct urcu_ref *ref)
 {
 	struct lttng_trace_chunk *chunk = lttng::utils::container_of(ref, &lttng_trace_chunk::ref);
+	bool close_command_succeeded = true;
 
 	if (chunk->close_command.is_set) {
 		chunk_command func =
@@ -1801,9 +2318,16 @@ static void lttng_trace_chunk_release(struct urcu_ref *ref)
 		if (func(chunk)) {
 			ERR("Trace chunk post-release command %s has failed.",
 			    lttng_trace_chunk_command_type_str(chunk->close_command.value));
+			close_command_succeeded = false;
 		}
 	}
 
+	if (chunk->release_callback) {
+		chunk->release_callback(close_command_succeeded, chunk->release_callback_data);
+		chunk->release_callback = nullptr;
+		chunk->release_callback_data = nullptr;
+	}
+
 	if (chunk->in_registry_element) {
 		struct lttng_trace_chunk_registry_element *element;
 
@@ -1909,6 +2433,9 @@ lttng_trace_chunk_registry_element_create_from_chunk(struct lttng_trace_chunk *c
 		element->chunk.chunk_directory = chunk->chunk_directory;
 		chunk->chunk_directory = nullptr;
 	}
+	/* Transferred ownership. */
+	chunk->release_callback = nullptr;
+	chunk->release_callback_data = nullptr;
 	/*
 	 * The original chunk becomes invalid; the name and path attributes are
 	 * transferred to the new chunk instance.
@@ -1916,6 +2443,9 @@ lttng_trace_chunk_registry_element_create_from_chunk(struct lttng_trace_chunk *c
 	chunk->name = nullptr;
 	chunk->path = nullptr;
 	element->chunk.fd_tracker = chunk->fd_tracker;
+	/* Transferred ownership. */
+	element->chunk.memory_files = chunk->memory_files;
+	chunk->memory_files = nullptr;
 	element->chunk.in_registry_element = true;
 end:
 	return element;
@@ -79,6 +79,13 @@ lttng_trace_chunk_create(uint64_t chunk_id, time_t chunk_creation_time, const ch
 void lttng_trace_chunk_set_fd_tracker(struct lttng_trace_chunk *chunk,
 				      struct fd_tracker *fd_tracker);
 
+/*
+ * Keep the files of the chunk and of its copies in memory rather than in the
+ * chunk directory; the subdirectories of the chunk are not created either.
+ * Must be set before any file is opened.
+ */
+enum lttng_trace_chunk_status lttng_trace_chunk_set_memory_files(struct lttng_trace_chunk *chunk);
+
 /*
  * Copy a trace chunk. The copy that is returned is always a _user_
  * mode chunk even if the source chunk was an _owner_ as there can never be
@@ -140,6 +147,15 @@ lttng_trace_chunk_borrow_chunk_directory_handle(struct lttng_trace_chunk *chunk,
 enum lttng_trace_chunk_status lttng_trace_chunk_create_subdirectory(struct lttng_trace_chunk *chunk,
 								    const char *subdirectory_path);
 
+/*
+ * Create many subdirectories at once, which is cheaper than creating them one
+ * by one when the chunk's credentials require the run-as worker.
+ */
+enum lttng_trace_chunk_status
+lttng_trace_chunk_create_subdirectories(struct lttng_trace_chunk *chunk,
+					const char *const *subdirectory_paths,
+					size_t count);
+
 enum lttng_trace_chunk_status lttng_trace_chunk_open_file(struct lttng_trace_chunk *chunk,
 							  const char *filename,
 							  int flags,
@@ -156,6 +172,15 @@ enum lttng_trace_chunk_status lttng_trace_chunk_open_fs_handle(struct lttng_trac
 
 int lttng_trace_chunk_unlink_file(struct lttng_trace_chunk *chunk, const char *filename);
 
+/*
+ * Rename the file `filename` of a chunk, opened as `handle`, to `new_filename`,
+ * replacing the file found at `new_filename`, if any.
+ */
+enum lttng_trace_chunk_status lttng_trace_chunk_rename_fs_handle(struct lttng_trace_chunk *chunk,
+								 struct fs_handle *handle,
+								 const char *filename,
+								 const char *new_filename);
+
 enum lttng_trace_chunk_status
 lttng_trace_chunk_get_close_command(struct lttng_trace_chunk *chunk,
 				    enum lttng_trace_chunk_command_type *command_type);
@@ -166,6 +191,21 @@ lttng_trace_chunk_set_close_command(struct lttng_trace_chunk *chunk,
 
 const char *lttng_trace_chunk_command_type_get_name(enum lttng_trace_chunk_command_type command);
 
+/*
+ * Callback invoked once the last reference to a trace chunk is released,
+ * after its close command, if any, was performed. `close_command_succeeded`
+ * is false if the close command failed.
+ */
+using lttng_trace_chunk_release_cb = void (*)(bool close_command_succeeded, void *data);
+
+/*
+ * Set the callback invoked on the release of a trace chunk. The callback
+ * owns `data` and is invoked exactly once; replacing a callback which was
+ * already set is an invalid operation.
+ */
+enum lttng_trace_chunk_status lttng_trace_chunk_set_release_callback(
+	struct lttng_trace_chunk *chunk, lttng_trace_chunk_release_cb callback, void *data);
+
 bool lttng_trace_chunk_ids_equal(const struct lttng_trace_chunk *chunk_a,
 				 const struct lttng_trace_chunk *chunk_b);
 
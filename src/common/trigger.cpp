@@ -14,7 +14,9 @@
 #include <common/payload.hpp>
 
 #include <lttng/action/action-internal.hpp>
+#include <lttng/action/list-internal.hpp>
 #include <lttng/condition/buffer-usage.h>
+#include <lttng/condition/channel-rate.h>
 #include <lttng/condition/condition-internal.hpp>
 #include <lttng/condition/event-rule-matches-internal.hpp>
 #include <lttng/condition/event-rule-matches.h>
@@ -300,6 +302,11 @@ int lttng_trigger_serialize(const struct lttng_trigger *trigger, struct lttng_pa
 	trigger_comm.is_hidden = lttng_trigger_is_hidden(trigger);
 
 	header_offset = payload->buffer.size;
+	ret = lttng_dynamic_buffer_reserve(&payload->buffer, sizeof(trigger_comm) + size_name);
+	if (ret) {
+		goto end;
+	}
+
 	ret = lttng_dynamic_buffer_append(&payload->buffer, &trigger_comm, sizeof(trigger_comm));
 	if (ret) {
 		goto end;
@@ -631,6 +638,18 @@ int lttng_triggers_serialize(const struct lttng_triggers *triggers, struct lttng
 		if (ret) {
 			goto end;
 		}
+
+		if (i == 0 && count > 1) {
+			/*
+			 * Assume the next triggers are about as large as the first
+			 * one. This is only a hint: a failure to reserve is not an
+			 * error.
+			 */
+			const size_t first_size = payload->buffer.size - size_before_payload;
+
+			(void) lttng_dynamic_buffer_reserve(&payload->buffer,
+							    (size_t) (count - 1) * first_size);
+		}
 	}
 
 	/* Update payload size. */
@@ -801,6 +820,12 @@ lttng_trigger_get_underlying_domain_type_restriction(const struct lttng_trigger
 		c_status = lttng_condition_buffer_usage_get_domain_type(trigger->condition, &type);
 		LTTNG_ASSERT(c_status == LTTNG_CONDITION_STATUS_OK);
 		break;
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
+		/* Return the domain of the channel being monitored. */
+		c_status = lttng_condition_channel_rate_get_domain_type(trigger->condition, &type);
+		LTTNG_ASSERT(c_status == LTTNG_CONDITION_STATUS_OK);
+		break;
 	default:
 		abort();
 	}
@@ -964,6 +989,8 @@ bool lttng_trigger_needs_tracer_notifier(const struct lttng_trigger *trigger)
 	case LTTNG_CONDITION_TYPE_SESSION_CONSUMED_SIZE:
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_HIGH:
 	case LTTNG_CONDITION_TYPE_BUFFER_USAGE_LOW:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_HIGH:
+	case LTTNG_CONDITION_TYPE_CHANNEL_RATE_LOW:
 	case LTTNG_CONDITION_TYPE_SESSION_ROTATION_ONGOING:
 	case LTTNG_CONDITION_TYPE_SESSION_ROTATION_COMPLETED:
 		goto end;
@@ -975,6 +1002,32 @@ end:
 	return needs_tracer_notifier;
 }
 
+bool lttng_trigger_has_notify_action(const struct lttng_trigger *trigger)
+{
+	bool has_notify = false;
+	const struct lttng_action *action = lttng_trigger_get_const_action(trigger);
+	enum lttng_action_type action_type;
+
+	LTTNG_ASSERT(action);
+	action_type = lttng_action_get_type(action);
+	if (action_type == LTTNG_ACTION_TYPE_NOTIFY) {
+		has_notify = true;
+		goto end;
+	} else if (action_type != LTTNG_ACTION_TYPE_LIST) {
+		goto end;
+	}
+
+	for (auto inner_action : lttng::ctl::const_action_list_view(action)) {
+		if (lttng_action_get_type(inner_action) == LTTNG_ACTION_TYPE_NOTIFY) {
+			has_notify = true;
+			goto end;
+		}
+	}
+
+end:
+	return has_notify;
+}
+
 void lttng_trigger_set_as_registered(struct lttng_trigger *trigger)
 {
 	pthread_mutex_lock(&trigger->lock);
@@ -14,6 +14,7 @@
 #include <common/fd-handle.hpp>
 #include <common/sessiond-comm/sessiond-comm.hpp>
 
+#include <algorithm>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -971,6 +972,250 @@ end:
 	return ret;
 }
 
+/*
+ * Send up to LTTCOMM_MAX_SEND_FDS objects of a batch with a single sendmsg(),
+ * their descriptors as data and their fds as ancillary data. The rest of
+ * the descriptors is sent as plain data on partial sends: the fds are
+ * attached to the first byte sent.
+ */
+static ssize_t send_fd_batch_chunk(
+	int sock, const char *descriptors, size_t len, const int *fds, size_t nb_fd)
+{
+	struct msghdr msg;
+	struct cmsghdr *cmptr;
+	struct iovec iov[1];
+	ssize_t ret;
+	const size_t sizeof_fds = nb_fd * sizeof(int);
+	union {
+		char buf[CMSG_SPACE(LTTCOMM_MAX_SEND_FDS * sizeof(int))];
+		struct cmsghdr align;
+	} control;
+
+	LTTNG_ASSERT(nb_fd > 0 && nb_fd <= LTTCOMM_MAX_SEND_FDS);
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&control, 0, sizeof(control));
+
+	msg.msg_control = control.buf;
+	msg.msg_controllen = CMSG_SPACE(sizeof_fds);
+
+	cmptr = CMSG_FIRSTHDR(&msg);
+	cmptr->cmsg_level = SOL_SOCKET;
+	cmptr->cmsg_type = SCM_RIGHTS;
+	cmptr->cmsg_len = CMSG_LEN(sizeof_fds);
+	memcpy(CMSG_DATA(cmptr), fds, sizeof_fds);
+	msg.msg_controllen = cmptr->cmsg_len;
+
+	iov[0].iov_base = (void *) descriptors;
+	iov[0].iov_len = len;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 1;
+
+	do {
+		ret = sendmsg(sock, &msg, 0);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+		/*
+		 * Only warn about EPIPE when quiet mode is deactivated.
+		 * We consider EPIPE as expected.
+		 */
+		if (errno != EPIPE || !lttng_opt_quiet) {
+			PERROR("sendmsg");
+		}
+		return ret;
+	}
+
+	if ((size_t) ret < len) {
+		const ssize_t send_ret = lttcomm_send_unix_sock(sock, descriptors + ret, len - ret);
+
+		if (send_ret < 0) {
+			return send_ret;
+		}
+	}
+
+	return len;
+}
+
+/*
+ * Send a batch of objects, each made of a descriptor of `descriptor_size`
+ * bytes and of a file descriptor, over a unix socket.
+ *
+ * The objects are sent with as few sendmsg() calls as the SCM_RIGHTS limit
+ * allows: each one carries the descriptors of up to LTTCOMM_MAX_SEND_FDS
+ * objects as data and their file descriptors as ancillary data. The batch
+ * must be received with lttcomm_recv_fd_batch_unix_sock().
+ *
+ * Returns the size of the descriptors sent, or negative error value.
+ */
+ssize_t lttcomm_send_fd_batch_unix_sock(
+	int sock, const void *descriptors, size_t descriptor_size, const int *fds, size_t count)
+{
+	const char *next_descriptors = (const char *) descriptors;
+	size_t sent = 0;
+
+	LTTNG_ASSERT(sock);
+	LTTNG_ASSERT(descriptors);
+	LTTNG_ASSERT(descriptor_size > 0);
+	LTTNG_ASSERT(fds);
+	LTTNG_ASSERT(count > 0);
+
+	while (sent < count) {
+		const size_t chunk_count = std::min<size_t>(count - sent, LTTCOMM_MAX_SEND_FDS);
+		const ssize_t ret = send_fd_batch_chunk(sock,
+							next_descriptors,
+							chunk_count * descriptor_size,
+							fds + sent,
+							chunk_count);
+
+		if (ret < 0) {
+			return ret;
+		}
+
+		next_descriptors += chunk_count * descriptor_size;
+		sent += chunk_count;
+	}
+
+	return count * descriptor_size;
+}
+
+/*
+ * Receive the objects of a batch sent by a single sendmsg() of
+ * send_fd_batch_chunk().
+ */
+static ssize_t
+recv_fd_batch_chunk(int sock, char *descriptors, size_t len, int *fds, size_t nb_fd)
+{
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	struct iovec iov[1];
+	ssize_t ret;
+	bool received_fds = false;
+	const size_t sizeof_fds = nb_fd * sizeof(int);
+	union {
+#ifdef __linux__
+		/* Account for the struct ucred cmsg in the buffer size */
+		char buf[CMSG_SPACE(LTTCOMM_MAX_SEND_FDS * sizeof(int)) +
+			 CMSG_SPACE(sizeof(struct ucred))];
+#else
+		char buf[CMSG_SPACE(LTTCOMM_MAX_SEND_FDS * sizeof(int))];
+#endif /* __linux__ */
+		struct cmsghdr align;
+	} control;
+
+	LTTNG_ASSERT(nb_fd > 0 && nb_fd <= LTTCOMM_MAX_SEND_FDS);
+
+	memset(&msg, 0, sizeof(msg));
+
+	iov[0].iov_base = descriptors;
+	iov[0].iov_len = len;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	do {
+		ret = lttng_recvmsg_nosigpipe(sock, &msg);
+	} while (ret < 0 && errno == EINTR);
+	if (ret <= 0) {
+		/* We consider EPIPE and EAGAIN as expected. */
+		if (ret < 0 && !lttng_opt_quiet && (errno != EPIPE && errno != EAGAIN)) {
+			PERROR("recvmsg");
+		}
+		return ret < 0 ? ret : -1;
+	}
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		size_t received_fd_count;
+
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+
+		received_fd_count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		if (received_fd_count != nb_fd || (msg.msg_flags & MSG_CTRUNC)) {
+			ERR("Received %zu file descriptors of a batch, expected %zu",
+			    received_fd_count,
+			    nb_fd);
+
+			/* Don't leak the file descriptors received anyway. */
+			for (size_t i = 0; i < received_fd_count; i++) {
+				int fd;
+
+				memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+				(void) close(fd);
+			}
+
+			return -1;
+		}
+
+		memcpy(fds, CMSG_DATA(cmsg), sizeof_fds);
+		received_fds = true;
+	}
+
+	if (!received_fds) {
+		ERR("Received no file descriptors with the objects of a batch");
+		return -1;
+	}
+
+	if ((size_t) ret < len) {
+		const ssize_t recv_ret = lttcomm_recv_unix_sock(sock, descriptors + ret, len - ret);
+
+		if (recv_ret <= 0) {
+			for (size_t i = 0; i < nb_fd; i++) {
+				(void) close(fds[i]);
+			}
+
+			return -1;
+		}
+	}
+
+	return len;
+}
+
+/*
+ * Receive a batch of `count` objects sent by lttcomm_send_fd_batch_unix_sock(),
+ * storing their descriptors of `descriptor_size` bytes in `descriptors` and
+ * their file descriptors in `fds`.
+ *
+ * On error, the file descriptors received so far are closed.
+ *
+ * Returns the size of the descriptors received, or negative error value.
+ */
+ssize_t lttcomm_recv_fd_batch_unix_sock(
+	int sock, void *descriptors, size_t descriptor_size, int *fds, size_t count)
+{
+	char *next_descriptors = (char *) descriptors;
+	size_t received = 0;
+
+	LTTNG_ASSERT(sock);
+	LTTNG_ASSERT(descriptors);
+	LTTNG_ASSERT(descriptor_size > 0);
+	LTTNG_ASSERT(fds);
+	LTTNG_ASSERT(count > 0);
+
+	while (received < count) {
+		const size_t chunk_count = std::min<size_t>(count - received, LTTCOMM_MAX_SEND_FDS);
+		const ssize_t ret = recv_fd_batch_chunk(sock,
+							next_descriptors,
+							chunk_count * descriptor_size,
+							fds + received,
+							chunk_count);
+
+		if (ret < 0) {
+			for (size_t i = 0; i < received; i++) {
+				(void) close(fds[i]);
+			}
+
+			return ret;
+		}
+
+		next_descriptors += chunk_count * descriptor_size;
+		received += chunk_count;
+	}
+
+	return count * descriptor_size;
+}
+
 /*
  * Send a message with credentials over a unix socket.
  *
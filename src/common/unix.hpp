@@ -37,6 +37,15 @@ ssize_t lttcomm_recv_fds_unix_sock_non_block(int sock, int *fds, size_t nb_fd);
 ssize_t
 lttcomm_recv_payload_fds_unix_sock_non_block(int sock, size_t nb_fd, struct lttng_payload *payload);
 
+/*
+ * Send and receive a batch of objects, each made of a descriptor and a fd, in as
+ * few syscalls as possible.
+ */
+ssize_t lttcomm_send_fd_batch_unix_sock(
+	int sock, const void *descriptors, size_t descriptor_size, const int *fds, size_t count);
+ssize_t lttcomm_recv_fd_batch_unix_sock(
+	int sock, void *descriptors, size_t descriptor_size, int *fds, size_t count);
+
 ssize_t lttcomm_recv_unix_sock(int sock, void *buf, size_t len);
 ssize_t lttcomm_recv_unix_sock_non_block(int sock, void *buf, size_t len);
 ssize_t lttcomm_send_unix_sock(int sock, const void *buf, size_t len);
@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 
 #define LOOPBACK_ADDR_IPV4 "127.0.0.1"
 #define LOOPBACK_ADDR_IPV6 "::1"
@@ -27,6 +28,7 @@ enum uri_proto_code {
 	P_FILE,
 	P_TCP,
 	P_TCP6,
+	P_UNIX,
 };
 
 namespace {
@@ -74,6 +76,11 @@ const struct uri_proto proto_uri[] = { { .name = "file",
 					 .code = P_TCP6,
 					 .type = LTTNG_TCP,
 					 .dtype = LTTNG_DST_IPV6 },
+				       { .name = "unix",
+					 .leading_string = "unix://",
+					 .code = P_UNIX,
+					 .type = LTTNG_TCP,
+					 .dtype = LTTNG_DST_UNIX },
 				       /* Invalid proto marking the end of the array. */
 				       {} };
 } /* namespace */
@@ -197,7 +204,7 @@ error:
 static void set_default_uri_attr(struct lttng_uri *uri, enum lttng_stream_type stype)
 {
 	uri->stype = stype;
-	if (uri->dtype != LTTNG_DST_PATH && uri->port == 0) {
+	if (uri->dtype != LTTNG_DST_PATH && uri->dtype != LTTNG_DST_UNIX && uri->port == 0) {
 		uri->port = (stype == LTTNG_STREAM_CONTROL) ? DEFAULT_NETWORK_CONTROL_PORT :
 							      DEFAULT_NETWORK_DATA_PORT;
 	}
@@ -222,6 +229,10 @@ static int compare_destination(struct lttng_uri *ctrl, struct lttng_uri *data)
 	case LTTNG_DST_IPV6:
 		ret = strncmp(ctrl->dst.ipv6, data->dst.ipv6, sizeof(ctrl->dst.ipv6));
 		break;
+	case LTTNG_DST_UNIX:
+		/* Each stream has its own socket path on the same host. */
+		ret = data->dtype == LTTNG_DST_UNIX ? 0 : -1;
+		break;
 	default:
 		ret = -1;
 		break;
@@ -247,6 +258,11 @@ int uri_to_str_url(struct lttng_uri *uri, char *dst, size_t size)
 		addr = uri->dst.path;
 		(void) snprintf(proto, sizeof(proto), "file");
 		(void) snprintf(port, sizeof(port), "%s", "");
+	} else if (uri->dtype == LTTNG_DST_UNIX) {
+		ipver = 0;
+		addr = uri->dst.path;
+		(void) snprintf(proto, sizeof(proto), "unix");
+		(void) snprintf(port, sizeof(port), "%s", "");
 	} else {
 		ipver = (uri->dtype == LTTNG_DST_IPV4) ? 4 : 6;
 		addr = (ipver == 4) ? uri->dst.ipv4 : uri->dst.ipv6;
@@ -367,6 +383,25 @@ ssize_t uri_parse(const char *str_uri, struct lttng_uri **uris)
 		goto end;
 	}
 
+	if (proto->code == P_UNIX) {
+		const struct sockaddr_un sun = {};
+
+		if (*purl != '/') {
+			ERR("Missing socket full path.");
+			goto free_error;
+		}
+
+		if (strlen(purl) >= sizeof(sun.sun_path)) {
+			ERR("Socket path is too long: %s", purl);
+			goto free_error;
+		}
+
+		strncpy(tmp_uris[0].dst.path, purl, sizeof(tmp_uris[0].dst.path));
+		tmp_uris[0].dst.path[sizeof(tmp_uris[0].dst.path) - 1] = '\0';
+		DBG3("URI UNIX socket destination: %s", purl);
+		goto end;
+	}
+
 	/* Assume we are at the beginning of an address or host of some sort. */
 	addr_b = purl;
 
@@ -19,6 +19,8 @@ enum lttng_dst_type {
 	LTTNG_DST_IPV4 = 1,
 	LTTNG_DST_IPV6 = 2,
 	LTTNG_DST_PATH = 3,
+	/* UNIX domain socket of a co-located relay daemon, in dst.path. */
+	LTTNG_DST_UNIX = 4,
 };
 
 /* Type of lttng URI where it is a final destination or a hop */
@@ -13,6 +13,7 @@
 #include <common/common.hpp>
 #include <common/compat/endian.hpp>
 #include <common/consumer/consumer-metadata-cache.hpp>
+#include <common/consumer/consumer-snapshot.hpp>
 #include <common/consumer/consumer-stream.hpp>
 #include <common/consumer/consumer-timer.hpp>
 #include <common/consumer/consumer.hpp>
@@ -155,8 +156,8 @@ static int send_stream_to_thread(struct lttng_consumer_stream *stream,
 		consumer_add_metadata_stream(stream);
 		stream_pipe = ctx->consumer_metadata_pipe;
 	} else {
-		consumer_add_data_stream(stream);
-		stream_pipe = ctx->consumer_data_pipe;
+		consumer_add_data_stream(stream, ctx);
+		stream_pipe = consumer_get_stream_data_worker(ctx, stream)->consumer_data_pipe;
 	}
 
 	/*
@@ -325,6 +326,24 @@ static int open_ust_stream_fd(struct lttng_consumer_channel *channel,
 	int ret;
 
 	if (!channel->shm_path[0]) {
+#ifdef HAVE_MEMFD_CREATE
+		/*
+		 * The huge page policy of the files of /dev/shm is the one of its
+		 * mount, which seldom allows huge pages, whereas memory files
+		 * follow the system's shared memory huge page policy.
+		 */
+		if (channel->buffer_page_size == LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE) {
+			ret = memfd_create("ust-consumer", MFD_CLOEXEC);
+			if (ret < 0) {
+				PERROR("Failed to create memory file of stream buffer: channel name = `%s`, cpu = %d",
+				       channel->name,
+				       cpu);
+			}
+
+			return ret;
+		}
+#endif /* HAVE_MEMFD_CREATE */
+
 		return shm_create_anonymous("ust-consumer");
 	}
 	ret = get_stream_shm_path(shm_path, channel->shm_path, cpu);
@@ -341,6 +360,52 @@ error_shm_path:
 	return -1;
 }
 
+/*
+ * Request transparent huge pages for the ring buffers of the streams of a
+ * channel, `buffer_size` being the size of the sub-buffers of a stream.
+ *
+ * This is only advice: the kernel keeps base pages when its shared memory huge
+ * page policy doesn't allow huge pages or when none is available.
+ */
+static void advise_ust_streams_huge_pages(struct lttng_consumer_channel *channel,
+					  uint64_t buffer_size)
+{
+	struct lttng_consumer_stream *stream;
+	const uintptr_t page_mask = ~((uintptr_t) sysconf(_SC_PAGE_SIZE) - 1);
+
+	cds_list_for_each_entry (stream, &channel->streams.head, send_node) {
+		const auto base = (uintptr_t) lttng_ust_ctl_get_mmap_base(stream->ustream);
+		/*
+		 * The sub-buffers follow the header of the stream's mapping:
+		 * rounding down to a page stays within the mapping.
+		 */
+		void *const start = (void *) (base & page_mask);
+
+		if (!base) {
+			continue;
+		}
+
+		if (madvise(start, buffer_size, MADV_HUGEPAGE)) {
+			PERROR("Failed to request transparent huge pages for stream buffers: stream name = `%s`",
+			       stream->name);
+			continue;
+		}
+
+#ifdef MADV_COLLAPSE
+		/*
+		 * The tracer zero-filled, and thus populated, the buffers with
+		 * base pages when it allocated them: collapse them now rather
+		 * than leaving it to khugepaged.
+		 */
+		if (madvise(start, buffer_size, MADV_COLLAPSE)) {
+			DBG("Failed to collapse stream buffers into transparent huge pages: stream name = `%s`, errno = %d",
+			    stream->name,
+			    errno);
+		}
+#endif /* MADV_COLLAPSE */
+	}
+}
+
 /*
  * Create an UST channel with the given attributes and send it to the session
  * daemon using the ust ctl API.
@@ -610,6 +675,9 @@ static int ask_channel(struct lttng_consumer_local_data *ctx,
 	/* Open all streams for this channel. */
 	pthread_mutex_lock(&channel->lock);
 	ret = create_ust_streams(channel, ctx);
+	if (!ret && channel->buffer_page_size == LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE) {
+		advise_ust_streams_huge_pages(channel, attr->subbuf_size * attr->num_subbuf);
+	}
 	pthread_mutex_unlock(&channel->lock);
 	if (ret < 0) {
 		goto end;
@@ -948,6 +1016,7 @@ static int snapshot_metadata(struct lttng_consumer_channel *metadata_channel,
 			     uint64_t key,
 			     char *path,
 			     uint64_t relayd_id,
+			     struct consumer_snapshot_fd_output *fd_output,
 			     struct lttng_consumer_local_data *ctx)
 {
 	int ret = 0;
@@ -989,7 +1058,9 @@ static int snapshot_metadata(struct lttng_consumer_channel *metadata_channel,
 	LTTNG_ASSERT(metadata_stream);
 
 	metadata_stream->read_subbuffer_ops.lock(metadata_stream);
-	if (relayd_id != (uint64_t) -1ULL) {
+	if (fd_output) {
+		metadata_stream->snapshot_fd_output = fd_output;
+	} else if (relayd_id != (uint64_t) -1ULL) {
 		metadata_stream->net_seq_idx = relayd_id;
 		ret = consumer_send_relayd_stream(metadata_stream, path);
 	} else {
@@ -1008,6 +1079,7 @@ static int snapshot_metadata(struct lttng_consumer_channel *metadata_channel,
 	} while (ret > 0);
 
 error_stream:
+	metadata_stream->snapshot_fd_output = nullptr;
 	metadata_stream->read_subbuffer_ops.unlock(metadata_stream);
 	/*
 	 * Clean up the stream completely because the next snapshot will use a
@@ -1046,10 +1118,96 @@ error:
 	return ret;
 }
 
+static int snapshot_get_subbuf(struct lttng_consumer_stream *stream, unsigned long *pos)
+{
+	return lttng_ust_ctl_get_subbuf(stream->ustream, pos);
+}
+
+static int snapshot_get_subbuf_size(struct lttng_consumer_stream *stream, unsigned long *len)
+{
+	return lttng_ust_ctl_get_subbuf_size(stream->ustream, len);
+}
+
+static int snapshot_get_padded_subbuf_size(struct lttng_consumer_stream *stream,
+					   unsigned long *len)
+{
+	return lttng_ust_ctl_get_padded_subbuf_size(stream->ustream, len);
+}
+
+static int snapshot_put_subbuf(struct lttng_consumer_stream *stream)
+{
+	return lttng_ust_ctl_put_subbuf(stream->ustream);
+}
+
+static const struct consumer_snapshot_ops ust_snapshot_ops = {
+	snapshot_get_subbuf,
+	snapshot_get_subbuf_size,
+	snapshot_get_padded_subbuf_size,
+	get_current_subbuf_addr,
+	snapshot_put_subbuf,
+	/* abort_on_short_write */
+	true,
+};
+
+/*
+ * Open the trace file of a stream, or its relay daemon stream, to record it as
+ * part of a snapshot. The stream lock must be held.
+ *
+ * Returns 0 on success, < 0 on error
+ */
+static int open_snapshot_stream_output(struct lttng_consumer_stream *stream,
+				       char *path,
+				       bool use_relayd)
+{
+	int ret;
+
+	LTTNG_ASSERT(stream->chan->trace_chunk);
+	if (!lttng_trace_chunk_get(stream->chan->trace_chunk)) {
+		/*
+		 * Can't happen barring an internal error as the channel
+		 * holds a reference to the trace chunk.
+		 */
+		ERR("Failed to acquire reference to channel's trace chunk");
+		return -1;
+	}
+	LTTNG_ASSERT(!stream->trace_chunk);
+	stream->trace_chunk = stream->chan->trace_chunk;
+
+	if (use_relayd) {
+		ret = consumer_send_relayd_stream(stream, path);
+	} else {
+		ret = consumer_stream_create_output_files(stream, false);
+		DBG("UST consumer snapshot stream (%" PRIu64 ")", stream->key);
+	}
+
+	if (ret < 0) {
+		consumer_stream_close_output(stream);
+	}
+
+	return ret;
+}
+
+/*
+ * Close the output of the streams of a snapshot and unlock them so they can be
+ * used by the next snapshot.
+ */
+static void snapshot_release_streams(const std::vector<consumer_snapshot_stream>& streams)
+{
+	for (const auto& snapshot_stream : streams) {
+		snapshot_stream.stream->snapshot_fd_output = nullptr;
+		consumer_stream_close_output(snapshot_stream.stream);
+		pthread_mutex_unlock(&snapshot_stream.stream->lock);
+	}
+}
+
 /*
  * Take a snapshot of all the stream of a channel.
  * RCU read-side lock and the channel lock must be held by the caller.
  *
+ * The positions of all the streams are sampled before any of them is
+ * recorded so that the snapshot is a consistent cut of the channel; the
+ * streams are then recorded concurrently.
+ *
  * Returns 0 on success, < 0 on error
  */
 static int snapshot_channel(struct lttng_consumer_channel *channel,
@@ -1057,12 +1215,14 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 			    char *path,
 			    uint64_t relayd_id,
 			    uint64_t nb_packets_per_stream,
+			    bool incremental,
+			    struct consumer_snapshot_fd_output *fd_output,
 			    struct lttng_consumer_local_data *ctx)
 {
 	int ret;
 	unsigned use_relayd = 0;
-	unsigned long consumed_pos, produced_pos;
 	struct lttng_consumer_stream *stream;
+	std::vector<consumer_snapshot_stream> streams;
 
 	LTTNG_ASSERT(path);
 	LTTNG_ASSERT(ctx);
@@ -1082,34 +1242,32 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 
 		/* Lock stream because we are about to change its state. */
 		pthread_mutex_lock(&stream->lock);
-		LTTNG_ASSERT(channel->trace_chunk);
-		if (!lttng_trace_chunk_get(channel->trace_chunk)) {
-			/*
-			 * Can't happen barring an internal error as the channel
-			 * holds a reference to the trace chunk.
-			 */
-			ERR("Failed to acquire reference to channel's trace chunk");
-			ret = -1;
-			goto error_unlock;
-		}
-		LTTNG_ASSERT(!stream->trace_chunk);
-		stream->trace_chunk = channel->trace_chunk;
-
 		stream->net_seq_idx = relayd_id;
+		stream->relayd_data_sock_index = -1;
 
-		if (use_relayd) {
-			ret = consumer_send_relayd_stream(stream, path);
-			if (ret < 0) {
-				goto error_close_stream;
-			}
+		if (fd_output) {
+			/* The packets are written as records of the output. */
+			stream->snapshot_fd_output = fd_output;
 		} else {
-			ret = consumer_stream_create_output_files(stream, false);
+			ret = open_snapshot_stream_output(stream, path, use_relayd);
 			if (ret < 0) {
-				goto error_close_stream;
+				goto error_unlock;
 			}
-			DBG("UST consumer snapshot stream (%" PRIu64 ")", stream->key);
 		}
 
+		try {
+			streams.push_back({ stream, 0, 0 });
+		} catch (const std::bad_alloc&) {
+			ERR("Failed to allocate snapshot stream");
+			ret = -ENOMEM;
+			goto error_close_stream;
+		}
+	}
+
+	for (auto& snapshot_stream : streams) {
+		stream = snapshot_stream.stream;
+		health_code_update();
+
 		/*
 		 * If tracing is active, we want to perform a "full" buffer flush.
 		 * Else, if quiescent, it has already been done by the prior stop.
@@ -1121,26 +1279,28 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 				    ", channel name = '%s'",
 				    channel->key,
 				    channel->name);
-				goto error_unlock;
+				goto error_release_streams;
 			}
 		}
 
 		ret = lttng_ustconsumer_take_snapshot(stream);
 		if (ret < 0) {
 			ERR("Taking UST snapshot");
-			goto error_close_stream;
+			goto error_release_streams;
 		}
 
-		ret = lttng_ustconsumer_get_produced_snapshot(stream, &produced_pos);
+		ret = lttng_ustconsumer_get_produced_snapshot(stream,
+							      &snapshot_stream.produced_pos);
 		if (ret < 0) {
 			ERR("Produced UST snapshot position");
-			goto error_close_stream;
+			goto error_release_streams;
 		}
 
-		ret = lttng_ustconsumer_get_consumed_snapshot(stream, &consumed_pos);
+		ret = lttng_ustconsumer_get_consumed_snapshot(stream,
+							      &snapshot_stream.consumed_pos);
 		if (ret < 0) {
 			ERR("Consumerd UST snapshot position");
-			goto error_close_stream;
+			goto error_release_streams;
 		}
 
 		/*
@@ -1149,86 +1309,26 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 		 * daemon should never send a maximum stream size that is lower than
 		 * subbuffer size.
 		 */
-		consumed_pos = consumer_get_consume_start_pos(
-			consumed_pos, produced_pos, nb_packets_per_stream, stream->max_sb_size);
-
-		while ((long) (consumed_pos - produced_pos) < 0) {
-			ssize_t read_len;
-			unsigned long len, padded_len;
-			const char *subbuf_addr;
-			struct lttng_buffer_view subbuf_view;
-
-			health_code_update();
-
-			DBG("UST consumer taking snapshot at pos %lu", consumed_pos);
-
-			ret = lttng_ust_ctl_get_subbuf(stream->ustream, &consumed_pos);
-			if (ret < 0) {
-				if (ret != -EAGAIN) {
-					PERROR("lttng_ust_ctl_get_subbuf snapshot");
-					goto error_close_stream;
-				}
-				DBG("UST consumer get subbuf failed. Skipping it.");
-				consumed_pos += stream->max_sb_size;
-				stream->chan->lost_packets++;
-				continue;
-			}
-
-			ret = lttng_ust_ctl_get_subbuf_size(stream->ustream, &len);
-			if (ret < 0) {
-				ERR("Snapshot lttng_ust_ctl_get_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = lttng_ust_ctl_get_padded_subbuf_size(stream->ustream, &padded_len);
-			if (ret < 0) {
-				ERR("Snapshot lttng_ust_ctl_get_padded_subbuf_size");
-				goto error_put_subbuf;
-			}
-
-			ret = get_current_subbuf_addr(stream, &subbuf_addr);
-			if (ret) {
-				goto error_put_subbuf;
-			}
-
-			subbuf_view = lttng_buffer_view_init(subbuf_addr, 0, padded_len);
-			read_len = lttng_consumer_on_read_subbuffer_mmap(
-				stream, &subbuf_view, padded_len - len);
-			if (use_relayd) {
-				if (read_len != len) {
-					ret = -EPERM;
-					goto error_put_subbuf;
-				}
-			} else {
-				if (read_len != padded_len) {
-					ret = -EPERM;
-					goto error_put_subbuf;
-				}
-			}
-
-			ret = lttng_ust_ctl_put_subbuf(stream->ustream);
-			if (ret < 0) {
-				ERR("Snapshot lttng_ust_ctl_put_subbuf");
-				goto error_close_stream;
-			}
-			consumed_pos += stream->max_sb_size;
-		}
-
-		/* Simply close the stream so we can use it on the next snapshot. */
-		consumer_stream_close_output(stream);
-		pthread_mutex_unlock(&stream->lock);
+		snapshot_stream.consumed_pos =
+			consumer_get_consume_start_pos(snapshot_stream.consumed_pos,
+						       snapshot_stream.produced_pos,
+						       nb_packets_per_stream,
+						       stream->max_sb_size);
 	}
 
-	return 0;
+	ret = consumer_snapshot_record_streams(streams, &ust_snapshot_ops, use_relayd, incremental);
+
+	/* Simply close the streams so we can use them on the next snapshot. */
+	snapshot_release_streams(streams);
+	return ret;
 
-error_put_subbuf:
-	if (lttng_ust_ctl_put_subbuf(stream->ustream) < 0) {
-		ERR("Snapshot lttng_ust_ctl_put_subbuf");
-	}
 error_close_stream:
+	stream->snapshot_fd_output = nullptr;
 	consumer_stream_close_output(stream);
 error_unlock:
 	pthread_mutex_unlock(&stream->lock);
+error_release_streams:
+	snapshot_release_streams(streams);
 	return ret;
 }
 
@@ -1515,6 +1615,14 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		 */
 		channel->ust_app_uid = msg.u.ask_channel.ust_app_uid;
 
+		channel->writeback_policy =
+			(enum lttng_channel_writeback_policy) msg.u.ask_channel.writeback_policy;
+		channel->writeback_window_size = msg.u.ask_channel.writeback_window_size;
+		channel->drain_max_subbuffers = msg.u.ask_channel.drain_max_subbuffers;
+		channel->drain_max_bytes = msg.u.ask_channel.drain_max_bytes;
+		channel->buffer_page_size =
+			(enum lttng_channel_buffer_page_size) msg.u.ask_channel.buffer_page_size;
+
 		/* Build channel attributes from received message. */
 		attr.subbuf_size = msg.u.ask_channel.subbuf_size;
 		attr.num_subbuf = msg.u.ask_channel.num_subbuf;
@@ -1815,8 +1923,21 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 	{
 		struct lttng_consumer_channel *found_channel;
 		uint64_t key = msg.u.snapshot_channel.key;
+		const bool use_fd_output = msg.u.snapshot_channel.use_fd_output;
+		struct consumer_snapshot_fd_output fd_output;
 		int ret_send;
 
+		if (use_fd_output) {
+			int output_fd;
+
+			if (consumer_snapshot_recv_output_fd(sock, &output_fd)) {
+				goto error_fatal;
+			}
+
+			consumer_snapshot_fd_output_init(
+				&fd_output, output_fd, msg.u.snapshot_channel.pathname);
+		}
+
 		found_channel = consumer_find_channel(key);
 		if (!found_channel) {
 			DBG("UST snapshot channel not found for key %" PRIu64, key);
@@ -1825,11 +1946,13 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 			if (msg.u.snapshot_channel.metadata) {
 				int ret_snapshot;
 
-				ret_snapshot = snapshot_metadata(found_channel,
-								 key,
-								 msg.u.snapshot_channel.pathname,
-								 msg.u.snapshot_channel.relayd_id,
-								 ctx);
+				ret_snapshot = snapshot_metadata(
+					found_channel,
+					key,
+					msg.u.snapshot_channel.pathname,
+					msg.u.snapshot_channel.relayd_id,
+					use_fd_output ? &fd_output : nullptr,
+					ctx);
 				if (ret_snapshot < 0) {
 					ERR("Snapshot metadata failed");
 					ret_code = LTTCOMM_CONSUMERD_SNAPSHOT_FAILED;
@@ -1843,6 +1966,8 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 					msg.u.snapshot_channel.pathname,
 					msg.u.snapshot_channel.relayd_id,
 					msg.u.snapshot_channel.nb_packets_per_stream,
+					msg.u.snapshot_channel.incremental,
+					use_fd_output ? &fd_output : nullptr,
 					ctx);
 				if (ret_snapshot < 0) {
 					ERR("Snapshot channel failed");
@@ -1850,6 +1975,11 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 				}
 			}
 		}
+
+		if (use_fd_output) {
+			consumer_snapshot_fd_output_fini(&fd_output);
+		}
+
 		health_code_update();
 		ret_send = consumer_send_status_msg(sock, ret_code);
 		if (ret_send < 0) {
@@ -1966,6 +2096,31 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 
 		break;
 	}
+	case LTTNG_CONSUMER_CHANNEL_CONSUMPTION_STATS:
+	{
+		int ret;
+		struct lttcomm_consumer_channel_consumption_stats stats;
+		const uint64_t id = msg.u.consumption_stats.session_id;
+		const uint64_t key = msg.u.consumption_stats.channel_key;
+
+		DBG("UST consumer consumption stats command for session id %" PRIu64
+		    ", channel key %" PRIu64,
+		    id,
+		    key);
+
+		lttng_consumer_get_channel_consumption_stats(id, key, &stats);
+
+		health_code_update();
+
+		/* Send back returned value to session daemon */
+		ret = lttcomm_send_unix_sock(sock, &stats, sizeof(stats));
+		if (ret < 0) {
+			PERROR("send consumption stats");
+			goto error_fatal;
+		}
+
+		break;
+	}
 	case LTTNG_CONSUMER_SET_CHANNEL_MONITOR_PIPE:
 	{
 		int channel_monitor_pipe, ret_send, ret_set_channel_monitor_pipe;
@@ -2011,6 +2166,27 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		}
 		goto end_msg_sessiond;
 	}
+	case LTTNG_CONSUMER_SET_ROTATION_EVENT_PIPE:
+	{
+		int rotation_event_pipe, ret_send;
+		ssize_t ret_recv;
+
+		/* Successfully received the command's type. */
+		ret_send = consumer_send_status_msg(sock, LTTCOMM_CONSUMERD_SUCCESS);
+		if (ret_send < 0) {
+			goto error_fatal;
+		}
+
+		ret_recv = lttcomm_recv_fds_unix_sock(sock, &rotation_event_pipe, 1);
+		if (ret_recv != sizeof(rotation_event_pipe)) {
+			ERR("Failed to receive rotation event pipe");
+			goto error_fatal;
+		}
+
+		DBG("Received rotation event pipe (%d)", rotation_event_pipe);
+		ret_code = lttng_consumer_set_rotation_event_pipe(rotation_event_pipe);
+		goto end_msg_sessiond;
+	}
 	case LTTNG_CONSUMER_ROTATE_CHANNEL:
 	{
 		struct lttng_consumer_channel *found_channel;
@@ -2077,7 +2253,8 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		} else {
 			int ret_clear_channel;
 
-			ret_clear_channel = lttng_consumer_clear_channel(found_channel);
+			ret_clear_channel = lttng_consumer_clear_channel(
+				found_channel, msg.u.clear_channel.truncate_output);
 			if (ret_clear_channel) {
 				ERR("Clear channel failed key %" PRIu64, key);
 				ret_code = (lttcomm_return_code) ret_clear_channel;
@@ -2501,9 +2678,10 @@ static int commit_one_metadata_packet(struct lttng_consumer_stream *stream)
 {
 	ssize_t write_len;
 	int ret;
+	struct lttng_buffer_view cached_metadata;
 
 	pthread_mutex_lock(&stream->chan->metadata_cache->lock);
-	if (stream->chan->metadata_cache->contents.size == stream->ust_metadata_pushed) {
+	if (stream->chan->metadata_cache->size == stream->ust_metadata_pushed) {
 		/*
 		 * In the context of a user space metadata channel, a
 		 * change in version can be detected in two ways:
@@ -2538,10 +2716,14 @@ static int commit_one_metadata_packet(struct lttng_consumer_stream *stream)
 		}
 	}
 
+	/*
+	 * The packet is written straight from the cache segment holding the
+	 * next metadata to push; a packet never spans two segments.
+	 */
+	cached_metadata = consumer_metadata_cache_get_view(stream->chan->metadata_cache,
+							   stream->ust_metadata_pushed);
 	write_len = lttng_ust_ctl_write_one_packet_to_channel(
-		stream->chan->uchan,
-		&stream->chan->metadata_cache->contents.data[stream->ust_metadata_pushed],
-		stream->chan->metadata_cache->contents.size - stream->ust_metadata_pushed);
+		stream->chan->uchan, cached_metadata.data, cached_metadata.size);
 	LTTNG_ASSERT(write_len != 0);
 	if (write_len < 0) {
 		ERR("Writing one metadata packet");
@@ -2552,7 +2734,7 @@ static int commit_one_metadata_packet(struct lttng_consumer_stream *stream)
 	stream->ust_metadata_pushed += write_len;
 	stream->chan->metadata_pushed_wait_queue.wake_all();
 
-	LTTNG_ASSERT(stream->chan->metadata_cache->contents.size >= stream->ust_metadata_pushed);
+	LTTNG_ASSERT(stream->chan->metadata_cache->size >= stream->ust_metadata_pushed);
 	ret = write_len;
 
 	/*
@@ -2655,11 +2837,13 @@ static int notify_if_more_data(struct lttng_consumer_stream *stream,
 {
 	int ret;
 	struct lttng_ust_ctl_consumer_stream *ustream;
+	struct lttng_consumer_data_worker *worker;
 
 	LTTNG_ASSERT(stream);
 	LTTNG_ASSERT(ctx);
 
 	ustream = stream->ustream;
+	worker = consumer_get_stream_data_worker(ctx, stream);
 
 	/*
 	 * First, we are going to check if there is a new subbuffer available
@@ -2680,17 +2864,17 @@ static int notify_if_more_data(struct lttng_consumer_stream *stream,
 	/* This stream still has data. Flag it and wake up the data thread. */
 	stream->has_data = 1;
 
-	if (stream->monitor && !stream->hangup_flush_done && !ctx->has_wakeup) {
+	if (stream->monitor && !stream->hangup_flush_done && !worker->has_wakeup) {
 		ssize_t writelen;
 
-		writelen = lttng_pipe_write(ctx->consumer_wakeup_pipe, "!", 1);
+		writelen = lttng_pipe_write(worker->consumer_wakeup_pipe, "!", 1);
 		if (writelen < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
 			ret = writelen;
 			goto end;
 		}
 
 		/* The wake up pipe has been notified. */
-		ctx->has_wakeup = 1;
+		worker->has_wakeup = 1;
 	}
 	ret = 0;
 
@@ -2940,7 +3124,7 @@ get_next_subbuffer_metadata(struct lttng_consumer_stream *stream,
 			}
 		} else {
 			pthread_mutex_lock(&stream->chan->metadata_cache->lock);
-			cache_empty = stream->chan->metadata_cache->contents.size ==
+			cache_empty = stream->chan->metadata_cache->size ==
 				stream->ust_metadata_pushed;
 			pthread_mutex_unlock(&stream->chan->metadata_cache->lock);
 		}
@@ -3100,7 +3284,7 @@ int lttng_ustconsumer_data_pending(struct lttng_consumer_stream *stream)
 
 		/* Ease our life a bit. */
 		pthread_mutex_lock(&stream->chan->metadata_cache->lock);
-		contiguous = stream->chan->metadata_cache->contents.size;
+		contiguous = stream->chan->metadata_cache->size;
 		pthread_mutex_unlock(&stream->chan->metadata_cache->lock);
 		pushed = stream->ust_metadata_pushed;
 
@@ -3274,6 +3458,7 @@ int lttng_ustconsumer_request_metadata(struct lttng_consumer_local_data *ctx,
 	 */
 	request.uid = channel->ust_app_uid;
 	request.key = channel->key;
+	request.periodic = invoked_by_timer;
 
 	DBG("Sending metadata request to sessiond, session id %" PRIu64 ", per-pid %" PRIu64
 	    ", app UID %u and channel key %" PRIu64,
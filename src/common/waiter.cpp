@@ -10,21 +10,33 @@
 #include "macros.hpp"
 #include "waiter.hpp"
 
+#include <algorithm>
 #include <poll.h>
 #include <urcu/futex.h>
 #include <urcu/uatomic.h>
 
 namespace {
-/* Number of busy-loop attempts before waiting on futex. */
-constexpr auto wait_attempt_count = 1000;
+/*
+ * Bounds of the number of busy-loop attempts before waiting on futex. Each
+ * thread adapts its number of attempts: it doubles when the waiter is woken
+ * up while busy-looping and halves when it has to wait on the futex.
+ */
+constexpr unsigned int min_wait_attempt_count = 10;
+constexpr unsigned int max_wait_attempt_count = 8000;
+/* Number of busy-loop attempts before waiting for the teardown. */
+constexpr auto teardown_wait_attempt_count = 1000;
+
+thread_local unsigned int wait_attempt_count = 1000;
 
 enum waiter_state {
-	/* WAITER_WAITING is compared directly (futex compares it). */
+	/* WAITER_WAITING and WAITER_SLEEPING are compared directly (futex compares them). */
 	WAITER_WAITING = 0,
 	/* non-zero are used as masks. */
 	WAITER_WOKEN_UP = (1 << 0),
 	WAITER_RUNNING = (1 << 1),
 	WAITER_TEARDOWN = (1 << 2),
+	/* The waiter waits on the futex: the waker must wake it up. */
+	WAITER_SLEEPING = (1 << 3),
 };
 } /* namespace */
 
@@ -51,22 +63,34 @@ void lttng::synchro::waiter::wait()
 	cmm_smp_rmb();
 	for (unsigned int i = 0; i < wait_attempt_count; i++) {
 		if (uatomic_read(&_state) != WAITER_WAITING) {
+			wait_attempt_count =
+				std::min(wait_attempt_count * 2, max_wait_attempt_count);
 			goto skip_futex_wait;
 		}
 
 		caa_cpu_relax();
 	}
 
-	while (uatomic_read(&_state) == WAITER_WAITING) {
+	wait_attempt_count = std::max(wait_attempt_count / 2, min_wait_attempt_count);
+
+	/*
+	 * Let the waker know that it must wake us up. It doesn't issue a futex
+	 * wake when the waiter is woken up before this point.
+	 */
+	if (uatomic_cmpxchg(&_state, WAITER_WAITING, WAITER_SLEEPING) != WAITER_WAITING) {
+		goto skip_futex_wait;
+	}
+
+	while (uatomic_read(&_state) == WAITER_SLEEPING) {
 		if (!futex_noasync(
-			    &_state, FUTEX_WAIT, WAITER_WAITING, nullptr, nullptr, 0)) {
+			    &_state, FUTEX_WAIT, WAITER_SLEEPING, nullptr, nullptr, 0)) {
 			/*
 			 * Prior queued wakeups queued by unrelated code
 			 * using the same address can cause futex wait to
 			 * return 0 even through the futex value is still
-			 * WAITER_WAITING (spurious wakeups). Check
+			 * WAITER_SLEEPING (spurious wakeups). Check
 			 * the value again in user-space to validate
-			 * whether it really differs from WAITER_WAITING.
+			 * whether it really differs from WAITER_SLEEPING.
 			 */
 			continue;
 		}
@@ -93,7 +117,7 @@ skip_futex_wait:
 	 * Wait until waker thread lets us know it's ok to tear down
 	 * memory allocated for struct lttng_waiter.
 	 */
-	for (unsigned int i = 0; i < wait_attempt_count; i++) {
+	for (unsigned int i = 0; i < teardown_wait_attempt_count; i++) {
 		if (uatomic_read(&_state) & WAITER_TEARDOWN) {
 			break;
 		}
@@ -121,12 +145,12 @@ lttng::synchro::waker lttng::synchro::waiter::get_waker()
  */
 void lttng::synchro::waker::wake()
 {
-	cmm_smp_mb();
+	const auto previous_state = uatomic_xchg(&_state, WAITER_WOKEN_UP);
 
-	LTTNG_ASSERT(uatomic_read(&_state) == WAITER_WAITING);
+	LTTNG_ASSERT(previous_state == WAITER_WAITING || previous_state == WAITER_SLEEPING);
 
-	uatomic_set(&_state, WAITER_WOKEN_UP);
-	if (!(uatomic_read(&_state) & WAITER_RUNNING)) {
+	/* A waiter which is still busy-looping sees the new state by itself. */
+	if (previous_state == WAITER_SLEEPING) {
 		if (futex_noasync(&_state, FUTEX_WAKE, 1, nullptr, nullptr, 0) < 0) {
 			PERROR("futex_noasync");
 			abort();
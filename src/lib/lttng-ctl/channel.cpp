@@ -21,8 +21,122 @@
 #include <lttng/notification/channel-internal.hpp>
 #include <lttng/notification/notification-internal.hpp>
 
+#include <sys/socket.h>
+
+/* Maximal size of the messages received ahead of their consumption. */
+#define READ_AHEAD_MAX_SIZE (64 * 1024)
+
 static int handshake(struct lttng_notification_channel *channel);
 
+static bool read_ahead_has_message(const struct lttng_notification_channel *channel)
+{
+	return channel->read_ahead.offset < channel->read_ahead.buffer.size;
+}
+
+static void read_ahead_clear(struct lttng_notification_channel *channel)
+{
+	(void) lttng_dynamic_buffer_set_size(&channel->read_ahead.buffer, 0);
+	channel->read_ahead.offset = 0;
+}
+
+/*
+ * Receive, without blocking, the complete messages available on the socket,
+ * up to the first one with file descriptors, so that a burst of
+ * notifications is received with a single system call rather than a few per
+ * notification.
+ *
+ * The available data is peeked to only consume complete messages: a partial
+ * message, or one with file descriptors, is left in the socket to be
+ * received message by message.
+ */
+static int read_ahead(struct lttng_notification_channel *channel)
+{
+	ssize_t ret;
+	size_t peeked_size, messages_size = 0;
+
+	LTTNG_ASSERT(!read_ahead_has_message(channel));
+
+	ret = lttng_dynamic_buffer_set_size(&channel->read_ahead.buffer, READ_AHEAD_MAX_SIZE);
+	if (ret) {
+		goto error;
+	}
+
+	channel->read_ahead.offset = 0;
+	do {
+		ret = recv(channel->socket,
+			   channel->read_ahead.buffer.data,
+			   READ_AHEAD_MAX_SIZE,
+			   MSG_PEEK | MSG_DONTWAIT);
+	} while (ret < 0 && errno == EINTR);
+	if (ret <= 0) {
+		/* Nothing available yet, or an error reported by the next reception. */
+		read_ahead_clear(channel);
+		return 0;
+	}
+
+	peeked_size = (size_t) ret;
+	while (peeked_size - messages_size >= sizeof(struct lttng_notification_channel_message)) {
+		struct lttng_notification_channel_message msg;
+
+		memcpy(&msg, channel->read_ahead.buffer.data + messages_size, sizeof(msg));
+		if (msg.fds != 0 || msg.size > DEFAULT_MAX_NOTIFICATION_CLIENT_MESSAGE_PAYLOAD_SIZE) {
+			break;
+		}
+
+		if (peeked_size - messages_size - sizeof(msg) < msg.size) {
+			/* Partially available message. */
+			break;
+		}
+
+		messages_size += sizeof(msg) + msg.size;
+	}
+
+	if (messages_size == 0) {
+		read_ahead_clear(channel);
+		return 0;
+	}
+
+	/* The complete messages were peeked: receiving them doesn't block. */
+	ret = lttcomm_recv_unix_sock(
+		channel->socket, channel->read_ahead.buffer.data, messages_size);
+	if (ret != (ssize_t) messages_size) {
+		goto error;
+	}
+
+	ret = lttng_dynamic_buffer_set_size(&channel->read_ahead.buffer, messages_size);
+	if (ret) {
+		goto error;
+	}
+
+	return 0;
+
+error:
+	read_ahead_clear(channel);
+	return -1;
+}
+
+/* Move the next message received ahead to the reception buffer. */
+static int consume_read_ahead_message(struct lttng_notification_channel *channel)
+{
+	int ret;
+	struct lttng_notification_channel_message msg;
+	const char *msg_data = channel->read_ahead.buffer.data + channel->read_ahead.offset;
+
+	memcpy(&msg, msg_data, sizeof(msg));
+	ret = lttng_dynamic_buffer_append(
+		&channel->reception_payload.buffer, msg_data, sizeof(msg) + msg.size);
+	if (ret) {
+		return -1;
+	}
+
+	channel->read_ahead.offset += sizeof(msg) + msg.size;
+	if (!read_ahead_has_message(channel)) {
+		read_ahead_clear(channel);
+	}
+
+	return 0;
+}
+
 /*
  * Populates the reception buffer with the next complete message.
  * The caller must acquire the channel's lock.
@@ -34,6 +148,22 @@ static int receive_message(struct lttng_notification_channel *channel)
 
 	lttng_payload_clear(&channel->reception_payload);
 
+	if (!read_ahead_has_message(channel)) {
+		ret = read_ahead(channel);
+		if (ret) {
+			goto error;
+		}
+	}
+
+	if (read_ahead_has_message(channel)) {
+		ret = consume_read_ahead_message(channel);
+		if (ret) {
+			goto error;
+		}
+
+		goto end;
+	}
+
 	ret = lttcomm_recv_unix_sock(channel->socket, &msg, sizeof(msg));
 	if (ret <= 0) {
 		ret = -1;
@@ -154,6 +284,7 @@ lttng_notification_channel_create(struct lttng_endpoint *endpoint)
 	channel->socket = -1;
 	pthread_mutex_init(&channel->lock, nullptr);
 	lttng_payload_init(&channel->reception_payload);
+	lttng_dynamic_buffer_init(&channel->read_ahead.buffer);
 	CDS_INIT_LIST_HEAD(&channel->pending_notifications.list);
 
 	is_root = (getuid() == 0);
@@ -216,6 +347,8 @@ lttng_notification_channel_get_next_notification(struct lttng_notification_chann
 	enum lttng_notification_channel_status status = LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
 	struct lttng_poll_event events;
 
+	lttng_poll_init(&events);
+
 	if (!channel || !_notification) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
 		goto end;
@@ -241,6 +374,11 @@ lttng_notification_channel_get_next_notification(struct lttng_notification_chann
 		goto end_unlock;
 	}
 
+	if (read_ahead_has_message(channel)) {
+		/* A message was already received, no need to wait. */
+		goto receive;
+	}
+
 	/*
 	 * Block on interruptible epoll/poll() instead of the message reception
 	 * itself as the recvmsg() wrappers always restart on EINTR. We choose
@@ -271,6 +409,7 @@ lttng_notification_channel_get_next_notification(struct lttng_notification_chann
 		goto end_clean_poll;
 	}
 
+receive:
 	ret = receive_message(channel);
 	if (ret) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
@@ -386,6 +525,8 @@ lttng_notification_channel_has_pending_notification(struct lttng_notification_ch
 	enum lttng_notification_channel_status status = LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
 	struct lttng_poll_event events;
 
+	lttng_poll_init(&events);
+
 	if (!channel || !_notification_pending) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
 		goto end;
@@ -403,6 +544,11 @@ lttng_notification_channel_has_pending_notification(struct lttng_notification_ch
 		goto end_unlock;
 	}
 
+	if (read_ahead_has_message(channel)) {
+		/* A message was already received. */
+		goto receive;
+	}
+
 	/*
 	 * Check, without blocking, if data is available on the channel's
 	 * socket. If there is data available, it is safe to read (blocking)
@@ -441,6 +587,7 @@ lttng_notification_channel_has_pending_notification(struct lttng_notification_ch
 	}
 
 	/* Data available on socket. */
+receive:
 	ret = receive_message(channel);
 	if (ret) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
@@ -589,7 +736,9 @@ end_unlock:
 static enum lttng_notification_channel_status
 send_condition_command(struct lttng_notification_channel *channel,
 		       enum lttng_notification_channel_message_type type,
-		       const struct lttng_condition *condition)
+		       const struct lttng_condition *condition,
+		       const struct lttng_notification_channel_command_subscribe_overflow_policy
+			       *overflow_policy)
 {
 	int socket;
 	ssize_t ret;
@@ -609,7 +758,11 @@ send_condition_command(struct lttng_notification_channel *channel,
 	}
 
 	LTTNG_ASSERT(type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE ||
-		     type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE);
+		     type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE ||
+		     overflow_policy);
+	LTTNG_ASSERT(
+		(type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_WITH_OVERFLOW_POLICY) ==
+		(overflow_policy != nullptr));
 
 	pthread_mutex_lock(&channel->lock);
 	socket = channel->socket;
@@ -619,12 +772,27 @@ send_condition_command(struct lttng_notification_channel *channel,
 		goto end_unlock;
 	}
 
+	if (overflow_policy && channel->version.minor < 2) {
+		/* The overflow policies were introduced in v1.2 of the protocol. */
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_UNSUPPORTED_VERSION;
+		goto end_unlock;
+	}
+
 	ret = lttng_dynamic_buffer_append(&payload.buffer, &cmd_header, sizeof(cmd_header));
 	if (ret) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
 		goto end_unlock;
 	}
 
+	if (overflow_policy) {
+		ret = lttng_dynamic_buffer_append(
+			&payload.buffer, overflow_policy, sizeof(*overflow_policy));
+		if (ret) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+			goto end_unlock;
+		}
+	}
+
 	ret = lttng_condition_serialize(condition, &payload);
 	if (ret) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
@@ -676,7 +844,41 @@ lttng_notification_channel_subscribe(struct lttng_notification_channel *channel,
 				     const struct lttng_condition *condition)
 {
 	return send_condition_command(
-		channel, LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE, condition);
+		channel, LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE, condition, nullptr);
+}
+
+enum lttng_notification_channel_status lttng_notification_channel_subscribe_with_overflow_policy(
+	struct lttng_notification_channel *channel,
+	const struct lttng_condition *condition,
+	enum lttng_notification_channel_overflow_policy policy,
+	unsigned int queue_size)
+{
+	struct lttng_notification_channel_command_subscribe_overflow_policy overflow_policy = {};
+
+	switch (policy) {
+	case LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP:
+		/* Default policy, supported by all the endpoints. */
+		return lttng_notification_channel_subscribe(channel, condition);
+	case LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_COALESCE:
+		queue_size = 1;
+		break;
+	case LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_POLICY_DROP_OLDEST:
+		if (queue_size == 0 ||
+		    queue_size > LTTNG_NOTIFICATION_CHANNEL_OVERFLOW_QUEUE_MAX_SIZE) {
+			return LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+		}
+		break;
+	default:
+		return LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+	}
+
+	overflow_policy.policy = (uint8_t) policy;
+	overflow_policy.queue_size = (uint32_t) queue_size;
+	return send_condition_command(
+		channel,
+		LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_WITH_OVERFLOW_POLICY,
+		condition,
+		&overflow_policy);
 }
 
 enum lttng_notification_channel_status
@@ -684,7 +886,7 @@ lttng_notification_channel_unsubscribe(struct lttng_notification_channel *channe
 				       const struct lttng_condition *condition)
 {
 	return send_condition_command(
-		channel, LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE, condition);
+		channel, LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE, condition, nullptr);
 }
 
 void lttng_notification_channel_destroy(struct lttng_notification_channel *channel)
@@ -698,5 +900,6 @@ void lttng_notification_channel_destroy(struct lttng_notification_channel *chann
 	}
 	pthread_mutex_destroy(&channel->lock);
 	lttng_payload_reset(&channel->reception_payload);
+	lttng_dynamic_buffer_reset(&channel->read_ahead.buffer);
 	free(channel);
 }
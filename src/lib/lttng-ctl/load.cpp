@@ -479,6 +479,7 @@ int lttng_load_session_attr_set_override_url(struct lttng_load_session_attr *att
 		break;
 	case LTTNG_DST_IPV4:
 	case LTTNG_DST_IPV6:
+	case LTTNG_DST_UNIX:
 		if (ret_size != 2) {
 			ret = -LTTNG_ERR_INVALID;
 			goto end;
@@ -592,6 +593,7 @@ int lttng_load_session(struct lttng_load_session_attr *attr)
 {
 	int ret;
 	const char *url, *session_name;
+	bool opened_connection = false;
 
 	if (!attr) {
 		ret = -LTTNG_ERR_INVALID;
@@ -606,8 +608,20 @@ int lttng_load_session(struct lttng_load_session_attr *attr)
 	url = attr->input_url[0] != '\0' ? attr->input_url : nullptr;
 	session_name = attr->session_name[0] != '\0' ? attr->session_name : nullptr;
 
+	/*
+	 * Replay the commands describing the sessions over a single connection.
+	 * Fall back to a connection per command if the session daemon doesn't
+	 * support persistent connections.
+	 */
+	if (!lttng_ctl_has_persistent_connection()) {
+		opened_connection = lttng_session_daemon_connection_open() == 0;
+	}
+
 	ret = config_load_session(url, session_name, attr->overwrite, 0, attr->override_attr);
 
+	if (opened_connection) {
+		lttng_session_daemon_connection_close();
+	}
 end:
 	return ret;
 }
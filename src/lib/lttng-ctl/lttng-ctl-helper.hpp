@@ -73,6 +73,9 @@ static inline int lttng_ctl_ask_sessiond(struct lttcomm_session_msg *lsm, void *
 
 int lttng_check_tracing_group(void);
 
+/* Return true if lttng_session_daemon_connection_open() was called. */
+bool lttng_ctl_has_persistent_connection(void);
+
 int connect_sessiond(void);
 
 #endif /* LTTNG_CTL_HELPER_H */
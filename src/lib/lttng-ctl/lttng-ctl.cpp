@@ -45,11 +45,13 @@
 #include <lttng/trigger/trigger-internal.hpp>
 #include <lttng/userspace-probe-internal.hpp>
 
+#include <algorithm>
 #include <grp.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #define COPY_DOMAIN_PACKED(dst, src)                               \
@@ -67,6 +69,11 @@ static char sessiond_sock_path[PATH_MAX];
 /* Variables */
 static char *tracing_group;
 static int connected;
+/*
+ * Set while the commands are sent over a single connection which the session
+ * daemon keeps open, see lttng_session_daemon_connection_open().
+ */
+static bool persistent_connection;
 
 /* Global */
 
@@ -495,6 +502,98 @@ static int disconnect_sessiond()
 	return ret;
 }
 
+/*
+ * Ask the session daemon to keep the connection open to send the following
+ * commands.
+ *
+ * Return 0 on success or a negative LTTng error code.
+ */
+static int keep_sessiond_connection()
+{
+	int ret;
+	struct lttcomm_session_msg lsm = {};
+	struct lttcomm_lttng_msg llm;
+
+	lsm.cmd_type = LTTCOMM_SESSIOND_COMMAND_KEEP_CONNECTION;
+	ret = send_session_msg(&lsm);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = recv_data_sessiond(&llm, sizeof(llm));
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* A session daemon which doesn't know the command replies LTTNG_ERR_UND. */
+	return llm.ret_code == LTTNG_OK ? 0 : -llm.ret_code;
+}
+
+/*
+ * Return true if the session daemon closed the persistent connection, or sent
+ * data on it while no command is pending.
+ */
+static bool persistent_connection_is_closed()
+{
+	char byte;
+	const ssize_t ret = recv(sessiond_socket, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+
+	return ret >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+}
+
+/*
+ * Connect to the session daemon to send a command, reusing the persistent
+ * connection if it is open.
+ *
+ * Return 0 on success or a negative LTTng error code.
+ */
+static int open_sessiond_connection()
+{
+	int ret;
+
+	if (connected) {
+		if (!persistent_connection_is_closed()) {
+			return 0;
+		}
+
+		/* The session daemon was restarted or closed the connection, connect again. */
+		DBG("Persistent session daemon connection closed, reconnecting");
+		disconnect_sessiond();
+	}
+
+	ret = connect_sessiond();
+	if (ret < 0) {
+		return -LTTNG_ERR_NO_SESSIOND;
+	}
+
+	sessiond_socket = ret;
+	connected = 1;
+
+	if (persistent_connection) {
+		ret = keep_sessiond_connection();
+		if (ret < 0) {
+			disconnect_sessiond();
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Disconnect from the session daemon once the reply of a command was
+ * received, unless the connection is persistent and the reply was entirely
+ * received.
+ */
+static void close_sessiond_connection(bool reply_received)
+{
+	if (persistent_connection && reply_received) {
+		return;
+	}
+
+	disconnect_sessiond();
+}
+
 static int recv_sessiond_optional_data(size_t len, void **user_buf, size_t *user_len)
 {
 	int ret = 0;
@@ -561,14 +660,11 @@ int lttng_ctl_ask_sessiond_fds_varlen(struct lttcomm_session_msg *lsm,
 	int ret;
 	size_t payload_len;
 	struct lttcomm_lttng_msg llm;
+	bool reply_received = false;
 
-	ret = connect_sessiond();
+	ret = open_sessiond_connection();
 	if (ret < 0) {
-		ret = -LTTNG_ERR_NO_SESSIOND;
 		goto end;
-	} else {
-		sessiond_socket = ret;
-		connected = 1;
 	}
 
 	ret = send_session_msg(lsm);
@@ -600,6 +696,8 @@ int lttng_ctl_ask_sessiond_fds_varlen(struct lttcomm_session_msg *lsm,
 	/* Check error code if OK */
 	if (llm.ret_code != LTTNG_OK) {
 		ret = -llm.ret_code;
+		reply_received = llm.cmd_header_size == 0 && llm.data_size == 0 &&
+			llm.fd_count == 0;
 		goto end;
 	}
 
@@ -617,9 +715,10 @@ int lttng_ctl_ask_sessiond_fds_varlen(struct lttcomm_session_msg *lsm,
 	}
 
 	ret = llm.data_size;
+	reply_received = llm.fd_count == 0;
 
 end:
-	disconnect_sessiond();
+	close_sessiond_connection(reply_received);
 	return ret;
 }
 
@@ -628,17 +727,14 @@ int lttng_ctl_ask_sessiond_payload(struct lttng_payload_view *message, struct lt
 	int ret;
 	struct lttcomm_lttng_msg llm;
 	const int fd_count = lttng_payload_view_get_fd_handle_count(message);
+	bool reply_received = false;
 
 	LTTNG_ASSERT(reply->buffer.size == 0);
 	LTTNG_ASSERT(lttng_dynamic_pointer_array_get_count(&reply->_fd_handles) == 0);
 
-	ret = connect_sessiond();
+	ret = open_sessiond_connection();
 	if (ret < 0) {
-		ret = -LTTNG_ERR_NO_SESSIOND;
 		goto end;
-	} else {
-		sessiond_socket = ret;
-		connected = 1;
 	}
 
 	/* Send command to session daemon */
@@ -674,6 +770,8 @@ int lttng_ctl_ask_sessiond_payload(struct lttng_payload_view *message, struct lt
 		} else {
 			ret = -llm.ret_code;
 		}
+		reply_received = llm.cmd_header_size == 0 && llm.data_size == 0 &&
+			llm.fd_count == 0;
 		goto end;
 	}
 
@@ -710,9 +808,10 @@ int lttng_ctl_ask_sessiond_payload(struct lttng_payload_view *message, struct lt
 	}
 
 	ret = reply->buffer.size;
+	reply_received = true;
 
 end:
-	disconnect_sessiond();
+	close_sessiond_connection(reply_received);
 	return ret;
 }
 
@@ -829,6 +928,7 @@ end:
 static int _lttng_stop_tracing(const char *session_name, int wait)
 {
 	int ret, data_ret;
+	unsigned int wait_time_us;
 	struct lttcomm_session_msg lsm;
 
 	if (session_name == nullptr) {
@@ -855,6 +955,7 @@ static int _lttng_stop_tracing(const char *session_name, int wait)
 	}
 
 	/* Check for data availability */
+	wait_time_us = DEFAULT_DATA_AVAILABILITY_MIN_WAIT_TIME_US;
 	do {
 		data_ret = lttng_data_pending(session_name);
 		if (data_ret < 0) {
@@ -868,7 +969,9 @@ static int _lttng_stop_tracing(const char *session_name, int wait)
 		 * call returned value indicates availability.
 		 */
 		if (data_ret) {
-			usleep(DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US);
+			usleep(wait_time_us);
+			wait_time_us = std::min<unsigned int>(
+				wait_time_us * 2, DEFAULT_DATA_AVAILABILITY_WAIT_TIME_US);
 		}
 	} while (data_ret != 0);
 
@@ -2723,6 +2826,237 @@ end:
 	return ret;
 }
 
+int lttng_channel_get_writeback_policy(struct lttng_channel *chan,
+				       enum lttng_channel_writeback_policy *policy,
+				       uint64_t *window_size)
+{
+	int ret = 0;
+	const struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !policy || !window_size) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (!chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (const struct lttng_channel_extended *) chan->attr.extended.ptr;
+	*policy = (enum lttng_channel_writeback_policy) chan_ext->writeback_policy;
+	*window_size = chan_ext->writeback_window_size;
+end:
+	return ret;
+}
+
+static int get_consumption_histogram(struct lttng_channel *chan,
+				     uint64_t *buckets,
+				     bool latency)
+{
+	int ret = 0;
+	const struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !buckets) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (const struct lttng_channel_extended *) chan->attr.extended.ptr;
+	if (!chan_ext) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	memcpy(buckets,
+	       latency ? chan_ext->consumption_latency_histogram :
+			 chan_ext->consumption_size_histogram,
+	       sizeof(chan_ext->consumption_latency_histogram));
+end:
+	return ret;
+}
+
+int lttng_channel_get_consumption_latency_histogram(struct lttng_channel *chan,
+						    uint64_t *buckets)
+{
+	return get_consumption_histogram(chan, buckets, true);
+}
+
+int lttng_channel_get_consumption_size_histogram(struct lttng_channel *chan, uint64_t *buckets)
+{
+	return get_consumption_histogram(chan, buckets, false);
+}
+
+int lttng_channel_get_splice_pipe_size(struct lttng_channel *chan, uint64_t *size)
+{
+	int ret = 0;
+	const struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !size) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (const struct lttng_channel_extended *) chan->attr.extended.ptr;
+	if (!chan_ext) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*size = chan_ext->splice_pipe_size;
+end:
+	return ret;
+}
+
+int lttng_channel_get_relayd_spilled_size(struct lttng_channel *chan, uint64_t *size)
+{
+	int ret = 0;
+	const struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !size) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (const struct lttng_channel_extended *) chan->attr.extended.ptr;
+	if (!chan_ext) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*size = chan_ext->relayd_spilled_size;
+end:
+	return ret;
+}
+
+int lttng_channel_get_buffer_page_size(struct lttng_channel *chan,
+				       enum lttng_channel_buffer_page_size *page_size,
+				       uint64_t *size)
+{
+	int ret = 0;
+	const struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !page_size || !size) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (const struct lttng_channel_extended *) chan->attr.extended.ptr;
+	if (!chan_ext) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*page_size = (enum lttng_channel_buffer_page_size) chan_ext->buffer_page_size;
+	*size = chan_ext->effective_buffer_page_size;
+end:
+	return ret;
+}
+
+int lttng_channel_set_buffer_page_size(struct lttng_channel *chan,
+				       enum lttng_channel_buffer_page_size page_size)
+{
+	int ret = 0;
+	struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	switch (page_size) {
+	case LTTNG_CHANNEL_BUFFER_PAGE_SIZE_BASE:
+	case LTTNG_CHANNEL_BUFFER_PAGE_SIZE_HUGE:
+		break;
+	default:
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (struct lttng_channel_extended *) chan->attr.extended.ptr;
+	chan_ext->buffer_page_size = (uint8_t) page_size;
+end:
+	return ret;
+}
+
+int lttng_channel_set_writeback_policy(struct lttng_channel *chan,
+				       enum lttng_channel_writeback_policy policy,
+				       uint64_t window_size)
+{
+	int ret = 0;
+	struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	switch (policy) {
+	case LTTNG_CHANNEL_WRITEBACK_POLICY_SYNC:
+	case LTTNG_CHANNEL_WRITEBACK_POLICY_NONE:
+		window_size = 0;
+		break;
+	case LTTNG_CHANNEL_WRITEBACK_POLICY_ASYNC_WINDOW:
+		if (window_size == 0) {
+			ret = -LTTNG_ERR_INVALID;
+			goto end;
+		}
+		break;
+	default:
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (struct lttng_channel_extended *) chan->attr.extended.ptr;
+	chan_ext->writeback_policy = (uint8_t) policy;
+	chan_ext->writeback_window_size = window_size;
+end:
+	return ret;
+}
+
+int lttng_channel_get_drain_batch(struct lttng_channel *chan,
+				  uint32_t *max_subbuffers,
+				  uint64_t *max_bytes)
+{
+	int ret = 0;
+	const struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !max_subbuffers || !max_bytes) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (!chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (const struct lttng_channel_extended *) chan->attr.extended.ptr;
+	*max_subbuffers = chan_ext->drain_max_subbuffers ?: 1;
+	*max_bytes = chan_ext->drain_max_bytes;
+end:
+	return ret;
+}
+
+int lttng_channel_set_drain_batch(struct lttng_channel *chan,
+				  uint32_t max_subbuffers,
+				  uint64_t max_bytes)
+{
+	int ret = 0;
+	struct lttng_channel_extended *chan_ext;
+
+	if (!chan || !chan->attr.extended.ptr || max_subbuffers == 0) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	chan_ext = (struct lttng_channel_extended *) chan->attr.extended.ptr;
+	chan_ext->drain_max_subbuffers = max_subbuffers;
+	chan_ext->drain_max_bytes = max_bytes;
+end:
+	return ret;
+}
+
 /*
  * Check if session daemon is alive.
  *
@@ -2757,6 +3091,44 @@ int lttng_session_daemon_alive(void)
 	return 1;
 }
 
+/*
+ * Keep a connection to the session daemon open across the commands.
+ *
+ * Return 0 on success or a negative LTTng error code.
+ */
+int lttng_session_daemon_connection_open(void)
+{
+	int ret;
+
+	if (persistent_connection) {
+		return 0;
+	}
+
+	/* A connection is only left open between commands when it is persistent. */
+	LTTNG_ASSERT(!connected);
+	persistent_connection = true;
+	ret = open_sessiond_connection();
+	if (ret < 0) {
+		persistent_connection = false;
+	}
+
+	return ret;
+}
+
+bool lttng_ctl_has_persistent_connection(void)
+{
+	return persistent_connection;
+}
+
+/*
+ * Close the persistent connection to the session daemon, if any.
+ */
+void lttng_session_daemon_connection_close(void)
+{
+	persistent_connection = false;
+	disconnect_sessiond();
+}
+
 /*
  * Set URL for a consumer for a session and domain.
  *
@@ -3118,6 +3490,148 @@ enum lttng_error_code lttng_register_trigger_with_automatic_name(struct lttng_tr
 	return ret == 0 ? LTTNG_OK : (enum lttng_error_code) - ret;
 }
 
+enum lttng_error_code
+lttng_register_triggers_with_automatic_name(struct lttng_trigger *const *triggers,
+					    unsigned int count)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct lttcomm_session_msg lsm = {
+		.cmd_type = LTTCOMM_SESSIOND_COMMAND_REGISTER_TRIGGERS,
+		.session = {},
+		.domain = {},
+		.u = {},
+		.fd_count = 0,
+	};
+	struct lttcomm_session_msg *message_lsm;
+	struct lttng_payload message;
+	struct lttng_payload reply;
+	struct lttng_triggers *message_triggers = nullptr;
+	struct lttng_triggers *reply_triggers = nullptr;
+	const struct lttng_credentials user_creds = {
+		.uid = LTTNG_OPTIONAL_INIT_VALUE(geteuid()),
+		.gid = LTTNG_OPTIONAL_INIT_UNSET,
+	};
+	unsigned int i, reply_count;
+
+	lttng_payload_init(&message);
+	lttng_payload_init(&reply);
+
+	if (!triggers || count == 0) {
+		ret_code = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	message_triggers = lttng_triggers_create();
+	if (!message_triggers) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		struct lttng_trigger *trigger = triggers[i];
+		const char *unused_trigger_name = nullptr;
+
+		if (!trigger ||
+		    lttng_trigger_get_name(trigger, &unused_trigger_name) !=
+			    LTTNG_TRIGGER_STATUS_UNSET) {
+			/* Re-using already registered trigger. */
+			ret_code = LTTNG_ERR_INVALID;
+			goto end;
+		}
+
+		if (!trigger->creds.uid.is_set) {
+			/* Use the client's credentials as the trigger credentials. */
+			lttng_trigger_set_credentials(trigger, &user_creds);
+		} else if (!lttng_credentials_is_equal_uid(lttng_trigger_get_credentials(trigger),
+							   &user_creds) &&
+			   lttng_credentials_get_uid(&user_creds) != 0) {
+			/* Same "safety" check as lttng_register_trigger_with_name(). */
+			ret_code = LTTNG_ERR_EPERM;
+			goto end;
+		}
+
+		if (!lttng_trigger_validate(trigger)) {
+			ret_code = LTTNG_ERR_INVALID_TRIGGER;
+			goto end;
+		}
+
+		/* The session daemon checks the domain of the command. */
+		if (i == 0) {
+			lsm.domain.type =
+				lttng_trigger_get_underlying_domain_type_restriction(trigger);
+		} else if (lttng_trigger_get_underlying_domain_type_restriction(trigger) !=
+			   lsm.domain.type) {
+			ret_code = LTTNG_ERR_INVALID;
+			goto end;
+		}
+
+		if (lttng_triggers_add(message_triggers, trigger)) {
+			ret_code = LTTNG_ERR_NOMEM;
+			goto end;
+		}
+	}
+
+	ret = lttng_dynamic_buffer_append(&message.buffer, &lsm, sizeof(lsm));
+	if (ret) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	ret = lttng_triggers_serialize(message_triggers, &message);
+	if (ret) {
+		ret_code = LTTNG_ERR_UNK;
+		goto end;
+	}
+
+	message_lsm = (struct lttcomm_session_msg *) message.buffer.data;
+	message_lsm->u.trigger.length = (uint32_t) message.buffer.size - sizeof(lsm);
+
+	{
+		struct lttng_payload_view message_view =
+			lttng_payload_view_from_payload(&message, 0, -1);
+
+		message_lsm->fd_count = lttng_payload_view_get_fd_handle_count(&message_view);
+		ret = lttng_ctl_ask_sessiond_payload(&message_view, &reply);
+		if (ret < 0) {
+			ret_code = (enum lttng_error_code) -ret;
+			goto end;
+		}
+	}
+
+	{
+		struct lttng_payload_view reply_view =
+			lttng_payload_view_from_payload(&reply, 0, reply.buffer.size);
+
+		ret = lttng_triggers_create_from_payload(&reply_view, &reply_triggers);
+		if (ret < 0 ||
+		    lttng_triggers_get_count(reply_triggers, &reply_count) !=
+			    LTTNG_TRIGGER_STATUS_OK ||
+		    reply_count != count) {
+			ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+			goto end;
+		}
+	}
+
+	/* The reply triggers are in the same order as the registered ones. */
+	for (i = 0; i < count; i++) {
+		ret = lttng_trigger_assign_name(triggers[i],
+						lttng_triggers_get_at_index(reply_triggers, i));
+		if (ret < 0) {
+			ret_code = LTTNG_ERR_NOMEM;
+			goto end;
+		}
+	}
+
+	ret_code = LTTNG_OK;
+end:
+	lttng_payload_reset(&message);
+	lttng_payload_reset(&reply);
+	lttng_triggers_destroy(message_triggers);
+	lttng_triggers_destroy(reply_triggers);
+	return ret_code;
+}
+
 enum lttng_error_code lttng_error_query_execute(const struct lttng_error_query *query,
 						const struct lttng_endpoint *endpoint,
 						struct lttng_error_query_results **results)
@@ -3195,6 +3709,108 @@ end:
 	return ret_code;
 }
 
+enum lttng_error_code lttng_error_queries_execute(const struct lttng_error_query *const *queries,
+						  unsigned int count,
+						  const struct lttng_endpoint *endpoint,
+						  struct lttng_error_query_results **results)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct lttcomm_session_msg lsm = {
+		.cmd_type = LTTCOMM_SESSIOND_COMMAND_EXECUTE_ERROR_QUERIES,
+		.session = {},
+		.domain = {},
+		.u = {},
+		.fd_count = 0,
+	};
+	struct lttng_payload message;
+	struct lttng_payload reply;
+	struct lttcomm_session_msg *message_lsm;
+	unsigned int i, created_count = 0;
+
+	lttng_payload_init(&message);
+	lttng_payload_init(&reply);
+
+	if (!queries || count == 0 || !results) {
+		ret_code = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (endpoint != lttng_session_daemon_command_endpoint) {
+		ret_code = LTTNG_ERR_INVALID_ERROR_QUERY_TARGET;
+		goto end;
+	}
+
+	lsm.u.error_query.count = count;
+	ret = lttng_dynamic_buffer_append(&message.buffer, &lsm, sizeof(lsm));
+	if (ret) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!queries[i]) {
+			ret_code = LTTNG_ERR_INVALID;
+			goto end;
+		}
+
+		ret = lttng_error_query_serialize(queries[i], &message);
+		if (ret) {
+			ret_code = LTTNG_ERR_UNK;
+			goto end;
+		}
+	}
+
+	message_lsm = (struct lttcomm_session_msg *) message.buffer.data;
+	message_lsm->u.error_query.length = (uint32_t) message.buffer.size - sizeof(lsm);
+
+	{
+		struct lttng_payload_view message_view =
+			lttng_payload_view_from_payload(&message, 0, -1);
+
+		message_lsm->fd_count = lttng_payload_view_get_fd_handle_count(&message_view);
+		ret = lttng_ctl_ask_sessiond_payload(&message_view, &reply);
+		if (ret < 0) {
+			ret_code = (lttng_error_code) -ret;
+			goto end;
+		}
+	}
+
+	/* The result sets are in the same order as the queries. */
+	{
+		size_t offset = 0;
+		struct lttng_payload_view reply_view =
+			lttng_payload_view_from_payload(&reply, 0, reply.buffer.size);
+
+		for (created_count = 0; created_count < count; created_count++) {
+			struct lttng_payload_view results_view =
+				lttng_payload_view_from_view(&reply_view, offset, -1);
+			const ssize_t results_size = lttng_error_query_results_create_from_payload(
+				&results_view, &results[created_count]);
+
+			if (results_size < 0) {
+				ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+				goto error;
+			}
+
+			offset += results_size;
+		}
+	}
+
+	ret_code = LTTNG_OK;
+	goto end;
+
+error:
+	for (i = 0; i < created_count; i++) {
+		lttng_error_query_results_destroy(results[i]);
+		results[i] = nullptr;
+	}
+end:
+	lttng_payload_reset(&message);
+	lttng_payload_reset(&reply);
+	return ret_code;
+}
+
 int lttng_unregister_trigger(const struct lttng_trigger *trigger)
 {
 	int ret;
@@ -3360,5 +3976,6 @@ static void __attribute__((constructor)) init()
  */
 static void __attribute__((destructor)) lttng_ctl_exit()
 {
+	lttng_session_daemon_connection_close();
 	free(tracing_group);
 }
@@ -77,6 +77,32 @@ create_trace_archive_location_from_get_info(const struct lttng_rotation_get_info
 	return location;
 }
 
+/*
+ * Cache the location and the phase durations of a completed rotation since the
+ * rotation may expire before the user has a chance to query them.
+ */
+static enum lttng_rotation_status
+cache_completed_rotation_info(struct lttng_rotation_handle *rotation_handle,
+			      const struct lttng_rotation_get_info_return *info)
+{
+	if (!rotation_handle->phase_durations_set) {
+		memcpy(rotation_handle->phase_durations_us,
+		       info->phase_durations_us,
+		       sizeof(rotation_handle->phase_durations_us));
+		rotation_handle->phase_durations_set = true;
+	}
+
+	if (!rotation_handle->archive_location) {
+		rotation_handle->archive_location =
+			create_trace_archive_location_from_get_info(info);
+		if (!rotation_handle->archive_location) {
+			return LTTNG_ROTATION_STATUS_ERROR;
+		}
+	}
+
+	return LTTNG_ROTATION_STATUS_OK;
+}
+
 enum lttng_rotation_status
 lttng_rotation_handle_get_state(struct lttng_rotation_handle *rotation_handle,
 				enum lttng_rotation_state *state)
@@ -95,7 +121,7 @@ lttng_rotation_handle_get_state(struct lttng_rotation_handle *rotation_handle,
 	}
 
 	*state = (enum lttng_rotation_state) info->status;
-	if (rotation_handle->archive_location || *state != LTTNG_ROTATION_STATE_COMPLETED) {
+	if (*state != LTTNG_ROTATION_STATE_COMPLETED) {
 		/*
 		 * The path is only provided by the sessiond once
 		 * the session rotation is completed, but not expired.
@@ -103,15 +129,7 @@ lttng_rotation_handle_get_state(struct lttng_rotation_handle *rotation_handle,
 		goto end;
 	}
 
-	/*
-	 * Cache the location since the rotation may expire before the user
-	 * has a chance to query it.
-	 */
-	rotation_handle->archive_location = create_trace_archive_location_from_get_info(info);
-	if (!rotation_handle->archive_location) {
-		status = LTTNG_ROTATION_STATUS_ERROR;
-		goto end;
-	}
+	status = cache_completed_rotation_info(rotation_handle, info);
 end:
 	free(info);
 	return status;
@@ -145,12 +163,51 @@ lttng_rotation_handle_get_archive_location(struct lttng_rotation_handle *rotatio
 		goto end;
 	}
 
-	rotation_handle->archive_location = create_trace_archive_location_from_get_info(info);
-	if (!rotation_handle->archive_location) {
-		status = LTTNG_ROTATION_STATUS_ERROR;
+	status = cache_completed_rotation_info(rotation_handle, info);
+	if (status != LTTNG_ROTATION_STATUS_OK) {
+		goto end;
+	}
+
+	*location = rotation_handle->archive_location;
+end:
+	free(info);
+	return status;
+}
+
+enum lttng_rotation_status
+lttng_rotation_handle_get_phase_duration(struct lttng_rotation_handle *rotation_handle,
+					 enum lttng_rotation_phase phase,
+					 uint64_t *duration_us)
+{
+	enum lttng_rotation_status status = LTTNG_ROTATION_STATUS_OK;
+	struct lttng_rotation_get_info_return *info = nullptr;
+
+	if (!rotation_handle || !duration_us || (int) phase < 0 ||
+	    (int) phase >= LTTNG_ROTATION_PHASE_COUNT) {
+		status = LTTNG_ROTATION_STATUS_INVALID;
+		goto end;
+	}
+
+	if (rotation_handle->phase_durations_set) {
+		goto end;
+	}
+
+	status = ask_rotation_info(rotation_handle, &info);
+	if (status != LTTNG_ROTATION_STATUS_OK) {
+		goto end;
+	}
+
+	if ((enum lttng_rotation_state) info->status != LTTNG_ROTATION_STATE_COMPLETED) {
+		status = LTTNG_ROTATION_STATUS_UNAVAILABLE;
 		goto end;
 	}
+
+	status = cache_completed_rotation_info(rotation_handle, info);
 end:
+	if (status == LTTNG_ROTATION_STATUS_OK) {
+		*duration_us = rotation_handle->phase_durations_us[phase];
+	}
+
 	free(info);
 	return status;
 }
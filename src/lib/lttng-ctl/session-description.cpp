@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include "lttng-ctl-helper.hpp"
+
+#include <common/macros.hpp>
+#include <common/payload-view.hpp>
+#include <common/payload.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+
+#include <lttng/channel-internal.hpp>
+#include <lttng/event-internal.hpp>
+#include <lttng/session-description.h>
+
+#include <limits.h>
+#include <string.h>
+
+namespace {
+struct session_description_events {
+	struct lttng_event *events;
+	unsigned int count;
+};
+
+struct session_description_domain {
+	struct lttng_channel *channels;
+	unsigned int channel_count;
+	/* One per channel, or a single one for the agent domains. */
+	struct session_description_events *event_lists;
+	unsigned int event_list_count;
+};
+} /* namespace */
+
+struct lttng_session_description {
+	/* Contiguous to be returned as is by lttng_session_description_get_domains(). */
+	struct lttng_domain *domains;
+	struct session_description_domain *domain_contents;
+	unsigned int domain_count;
+};
+
+namespace {
+bool domain_is_agent(enum lttng_domain_type domain)
+{
+	return domain == LTTNG_DOMAIN_JUL || domain == LTTNG_DOMAIN_LOG4J ||
+		domain == LTTNG_DOMAIN_PYTHON;
+}
+
+/*
+ * Get the location of the elements of the next listing command reply of a
+ * DESCRIBE_SESSION reply, at `*offset`, and their count, advancing `*offset`
+ * past the listing command reply.
+ */
+enum lttng_error_code next_list(struct lttng_payload_view *reply_view,
+				size_t *offset,
+				size_t *list_offset,
+				size_t *list_size,
+				unsigned int *count)
+{
+	const struct lttcomm_session_description_list_header *list_header;
+	const struct lttcomm_list_command_header *cmd_header;
+	const struct lttng_payload_view list_header_view =
+		lttng_payload_view_from_view(reply_view, *offset, sizeof(*list_header));
+
+	if (!lttng_payload_view_is_valid(&list_header_view)) {
+		return LTTNG_ERR_INVALID_PROTOCOL;
+	}
+
+	list_header = (typeof(list_header)) list_header_view.buffer.data;
+	if (list_header->size < sizeof(*cmd_header) ||
+	    list_header->size > reply_view->buffer.size) {
+		return LTTNG_ERR_INVALID_PROTOCOL;
+	}
+
+	*offset += sizeof(*list_header);
+
+	{
+		const struct lttng_payload_view cmd_header_view =
+			lttng_payload_view_from_view(reply_view, *offset, sizeof(*cmd_header));
+
+		if (!lttng_payload_view_is_valid(&cmd_header_view)) {
+			return LTTNG_ERR_INVALID_PROTOCOL;
+		}
+
+		cmd_header = (typeof(cmd_header)) cmd_header_view.buffer.data;
+		if (cmd_header->count > INT_MAX) {
+			return LTTNG_ERR_OVERFLOW;
+		}
+
+		*count = cmd_header->count;
+	}
+
+	if (*offset + list_header->size > reply_view->buffer.size) {
+		return LTTNG_ERR_INVALID_PROTOCOL;
+	}
+
+	*list_offset = *offset + sizeof(*cmd_header);
+	*list_size = list_header->size - sizeof(*cmd_header);
+	*offset += list_header->size;
+	return LTTNG_OK;
+}
+
+enum lttng_error_code create_domain_contents_from_payload(struct lttng_payload_view *reply_view,
+							  size_t *offset,
+							  enum lttng_domain_type domain,
+							  struct session_description_domain *contents)
+{
+	enum lttng_error_code ret_code;
+	size_t list_offset, list_size;
+	unsigned int i;
+
+	ret_code = next_list(
+		reply_view, offset, &list_offset, &list_size, &contents->channel_count);
+	if (ret_code != LTTNG_OK) {
+		return ret_code;
+	}
+
+	if (contents->channel_count > 0) {
+		const struct lttng_payload_view list_view =
+			lttng_payload_view_from_view(reply_view, list_offset, list_size);
+
+		ret_code = lttng_channels_create_and_flatten_from_buffer(
+			&list_view.buffer, contents->channel_count, &contents->channels);
+		if (ret_code != LTTNG_OK) {
+			contents->channel_count = 0;
+			return ret_code;
+		}
+	}
+
+	contents->event_list_count = domain_is_agent(domain) ? 1 : contents->channel_count;
+	if (contents->event_list_count == 0) {
+		return LTTNG_OK;
+	}
+
+	contents->event_lists = calloc<session_description_events>(contents->event_list_count);
+	if (!contents->event_lists) {
+		contents->event_list_count = 0;
+		return LTTNG_ERR_NOMEM;
+	}
+
+	for (i = 0; i < contents->event_list_count; i++) {
+		struct session_description_events *event_list = &contents->event_lists[i];
+		unsigned int count;
+
+		ret_code = next_list(reply_view, offset, &list_offset, &list_size, &count);
+		if (ret_code != LTTNG_OK) {
+			return ret_code;
+		}
+
+		{
+			struct lttng_payload_view list_view =
+				lttng_payload_view_from_view(reply_view, list_offset, list_size);
+
+			ret_code = lttng_events_create_and_flatten_from_payload(
+				&list_view, count, &event_list->events);
+			if (ret_code != LTTNG_OK) {
+				return ret_code;
+			}
+		}
+
+		event_list->count = count;
+	}
+
+	return LTTNG_OK;
+}
+
+enum lttng_error_code
+session_description_create_from_payload(struct lttng_payload *reply,
+					struct lttng_session_description **description)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_session_description *local_description;
+	struct lttng_payload_view reply_view = lttng_payload_view_from_payload(reply, 0, -1);
+	size_t offset = 0;
+	unsigned int i;
+
+	local_description = zmalloc<lttng_session_description>();
+	if (!local_description) {
+		return LTTNG_ERR_NOMEM;
+	}
+
+	{
+		const struct lttcomm_list_command_header *cmd_header;
+		const struct lttng_payload_view cmd_header_view =
+			lttng_payload_view_from_view(&reply_view, 0, sizeof(*cmd_header));
+
+		if (!lttng_payload_view_is_valid(&cmd_header_view)) {
+			ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+			goto error;
+		}
+
+		cmd_header = (typeof(cmd_header)) cmd_header_view.buffer.data;
+		if (cmd_header->count > INT_MAX) {
+			ret_code = LTTNG_ERR_OVERFLOW;
+			goto error;
+		}
+
+		local_description->domain_count = cmd_header->count;
+		offset += sizeof(*cmd_header);
+	}
+
+	if (local_description->domain_count == 0) {
+		goto end;
+	}
+
+	local_description->domains = calloc<lttng_domain>(local_description->domain_count);
+	local_description->domain_contents =
+		calloc<session_description_domain>(local_description->domain_count);
+	if (!local_description->domains || !local_description->domain_contents) {
+		local_description->domain_count = 0;
+		ret_code = LTTNG_ERR_NOMEM;
+		goto error;
+	}
+
+	for (i = 0; i < local_description->domain_count; i++) {
+		const struct lttng_payload_view domain_view =
+			lttng_payload_view_from_view(&reply_view, offset, sizeof(struct lttng_domain));
+
+		if (!lttng_payload_view_is_valid(&domain_view)) {
+			ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+			goto error;
+		}
+
+		memcpy(&local_description->domains[i],
+		       domain_view.buffer.data,
+		       sizeof(struct lttng_domain));
+		offset += sizeof(struct lttng_domain);
+
+		ret_code = create_domain_contents_from_payload(&reply_view,
+							       &offset,
+							       local_description->domains[i].type,
+							       &local_description->domain_contents[i]);
+		if (ret_code != LTTNG_OK) {
+			goto error;
+		}
+	}
+
+	if (offset != reply_view.buffer.size) {
+		ret_code = LTTNG_ERR_INVALID_PROTOCOL;
+		goto error;
+	}
+
+end:
+	*description = local_description;
+	return LTTNG_OK;
+
+error:
+	lttng_session_description_destroy(local_description);
+	return ret_code;
+}
+
+const struct session_description_domain *
+get_domain_contents(const struct lttng_session_description *description,
+		    enum lttng_domain_type domain)
+{
+	unsigned int i;
+
+	for (i = 0; i < description->domain_count; i++) {
+		if (description->domains[i].type == domain) {
+			return &description->domain_contents[i];
+		}
+	}
+
+	return nullptr;
+}
+} /* namespace */
+
+int lttng_describe_session(const char *session_name,
+			   struct lttng_session_description **description)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct lttcomm_session_msg lsm = {};
+	struct lttng_payload reply;
+	struct lttng_payload_view lsm_view =
+		lttng_payload_view_init_from_buffer((const char *) &lsm, 0, sizeof(lsm));
+
+	lttng_payload_init(&reply);
+
+	if (session_name == nullptr || description == nullptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	lsm.cmd_type = LTTCOMM_SESSIOND_COMMAND_DESCRIBE_SESSION;
+	ret = lttng_strncpy(lsm.session.name, session_name, sizeof(lsm.session.name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	ret = lttng_ctl_ask_sessiond_payload(&lsm_view, &reply);
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret_code = session_description_create_from_payload(&reply, description);
+	ret = ret_code == LTTNG_OK ? 0 : -((int) ret_code);
+end:
+	lttng_payload_reset(&reply);
+	return ret;
+}
+
+int lttng_session_description_get_domains(const struct lttng_session_description *description,
+					  struct lttng_domain **domains)
+{
+	if (description == nullptr || domains == nullptr) {
+		return -LTTNG_ERR_INVALID;
+	}
+
+	*domains = description->domains;
+	return (int) description->domain_count;
+}
+
+int lttng_session_description_get_channels(const struct lttng_session_description *description,
+					   enum lttng_domain_type domain,
+					   struct lttng_channel **channels)
+{
+	const struct session_description_domain *contents;
+
+	if (description == nullptr || channels == nullptr) {
+		return -LTTNG_ERR_INVALID;
+	}
+
+	contents = get_domain_contents(description, domain);
+	if (!contents) {
+		*channels = nullptr;
+		return 0;
+	}
+
+	*channels = contents->channels;
+	return (int) contents->channel_count;
+}
+
+int lttng_session_description_get_events(const struct lttng_session_description *description,
+					 enum lttng_domain_type domain,
+					 const char *channel_name,
+					 struct lttng_event **events)
+{
+	const struct session_description_domain *contents;
+	unsigned int i;
+
+	if (description == nullptr || events == nullptr ||
+	    (channel_name == nullptr && !domain_is_agent(domain))) {
+		return -LTTNG_ERR_INVALID;
+	}
+
+	*events = nullptr;
+	contents = get_domain_contents(description, domain);
+	if (!contents || contents->event_list_count == 0) {
+		return 0;
+	}
+
+	if (domain_is_agent(domain)) {
+		*events = contents->event_lists[0].events;
+		return (int) contents->event_lists[0].count;
+	}
+
+	for (i = 0; i < contents->channel_count; i++) {
+		if (strncmp(contents->channels[i].name, channel_name, LTTNG_SYMBOL_NAME_LEN) ==
+		    0) {
+			*events = contents->event_lists[i].events;
+			return (int) contents->event_lists[i].count;
+		}
+	}
+
+	return -LTTNG_ERR_CHAN_NOT_FOUND;
+}
+
+void lttng_session_description_destroy(struct lttng_session_description *description)
+{
+	unsigned int i, j;
+
+	if (!description) {
+		return;
+	}
+
+	for (i = 0; i < description->domain_count; i++) {
+		struct session_description_domain *contents = &description->domain_contents[i];
+
+		for (j = 0; j < contents->event_list_count; j++) {
+			free(contents->event_lists[j].events);
+		}
+
+		free(contents->event_lists);
+		free(contents->channels);
+	}
+
+	free(description->domain_contents);
+	free(description->domains);
+	free(description);
+}
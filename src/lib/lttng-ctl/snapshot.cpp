@@ -41,6 +41,15 @@ int lttng_snapshot_add_output(const char *session_name, struct lttng_snapshot_ou
 		goto end;
 	}
 
+	/*
+	 * A file descriptor can't outlive the recording of a snapshot and
+	 * incremental recording is requested per snapshot.
+	 */
+	if (output->fd.is_set || output->incremental) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
 	memcpy(&lsm.u.snapshot_output.output, output, sizeof(lsm.u.snapshot_output.output));
 
 	ret = lttng_ctl_ask_sessiond(&lsm, (void **) &reply);
@@ -219,7 +228,15 @@ int lttng_snapshot_record(const char *session_name,
 	}
 
 	/* The wait param is ignored. */
-	ret = lttng_ctl_ask_sessiond(&lsm, nullptr);
+	if (output && output->fd.is_set) {
+		const int fd = output->fd.value;
+
+		lsm.fd_count = 1;
+		ret = lttng_ctl_ask_sessiond_fds_varlen(
+			&lsm, &fd, 1, nullptr, 0, nullptr, nullptr, nullptr);
+	} else {
+		ret = lttng_ctl_ask_sessiond(&lsm, nullptr);
+	}
 end:
 	return ret;
 }
@@ -281,6 +298,11 @@ uint64_t lttng_snapshot_output_get_maxsize(const struct lttng_snapshot_output *o
 	return output->max_size;
 }
 
+int lttng_snapshot_output_is_incremental(const struct lttng_snapshot_output *output)
+{
+	return output->incremental;
+}
+
 /*
  * Setter family functions for snapshot output.
  */
@@ -305,6 +327,16 @@ int lttng_snapshot_output_set_size(uint64_t size, struct lttng_snapshot_output *
 	return 0;
 }
 
+int lttng_snapshot_output_set_incremental(int incremental, struct lttng_snapshot_output *output)
+{
+	if (!output) {
+		return -LTTNG_ERR_INVALID;
+	}
+
+	output->incremental = !!incremental;
+	return 0;
+}
+
 int lttng_snapshot_output_set_name(const char *name, struct lttng_snapshot_output *output)
 {
 	int ret;
@@ -362,6 +394,16 @@ end:
 	return ret;
 }
 
+int lttng_snapshot_output_set_fd(int fd, struct lttng_snapshot_output *output)
+{
+	if (fd < 0 || !output) {
+		return -LTTNG_ERR_INVALID;
+	}
+
+	LTTNG_OPTIONAL_SET(&output->fd, fd);
+	return 0;
+}
+
 int lttng_snapshot_output_set_local_path(const char *path, struct lttng_snapshot_output *output)
 {
 	int ret;
@@ -452,12 +494,14 @@ int lttng_snapshot_output_set_network_urls(const char *ctrl_url,
 		goto end;
 	}
 
-	if (uris[0].dtype != LTTNG_DST_IPV4 && uris[0].dtype != LTTNG_DST_IPV6) {
+	if (uris[0].dtype != LTTNG_DST_IPV4 && uris[0].dtype != LTTNG_DST_IPV6 &&
+	    uris[0].dtype != LTTNG_DST_UNIX) {
 		ret = -LTTNG_ERR_INVALID;
 		goto end;
 	}
 
-	if (uris[1].dtype != LTTNG_DST_IPV4 && uris[1].dtype != LTTNG_DST_IPV6) {
+	if (uris[1].dtype != LTTNG_DST_IPV4 && uris[1].dtype != LTTNG_DST_IPV6 &&
+	    uris[1].dtype != LTTNG_DST_UNIX) {
 		ret = -LTTNG_ERR_INVALID;
 		goto end;
 	}
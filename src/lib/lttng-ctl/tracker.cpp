@@ -14,6 +14,8 @@
 #include <lttng/lttng-error.h>
 #include <lttng/tracker.h>
 
+#include <algorithm>
+#include <string.h>
 #include <type_traits>
 
 struct lttng_process_attr_tracker_handle {
@@ -354,6 +356,145 @@ DEFINE_TRACKER_ADD_REMOVE_STRING_VALUE_FUNC(ADD, add, virtual_group_id, group_na
 DEFINE_TRACKER_ADD_REMOVE_STRING_VALUE_FUNC(
 	REMOVE, remove, virtual_group_id, group_name, GROUP_NAME);
 
+/*
+ * Send the values to add or remove in chunks of at most
+ * LTTCOMM_PROCESS_ATTR_TRACKER_MAX_BULK_VALUES values.
+ */
+template <typename ValueType>
+static enum lttng_process_attr_tracker_handle_status
+add_remove_integral_values(const struct lttng_process_attr_tracker_handle *tracker,
+			   enum lttcomm_sessiond_command command,
+			   enum lttng_process_attr_value_type value_type,
+			   const ValueType *values,
+			   unsigned int count)
+{
+	int ret;
+	enum lttng_process_attr_tracker_handle_status status =
+		LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_OK;
+	struct lttng_dynamic_buffer payload;
+
+	lttng_dynamic_buffer_init(&payload);
+
+	if (!tracker || (!values && count > 0)) {
+		status = LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_INVALID;
+		goto end;
+	}
+
+	for (unsigned int offset = 0; offset < count;) {
+		const unsigned int chunk_count = std::min<unsigned int>(
+			count - offset, LTTCOMM_PROCESS_ATTR_TRACKER_MAX_BULK_VALUES);
+		struct lttcomm_session_msg lsm = {
+			.cmd_type = command,
+			.session = {},
+			.domain = {},
+			.u = {},
+			.fd_count = 0,
+		};
+
+		ret = lttng_strncpy(
+			lsm.session.name, tracker->session_name, sizeof(lsm.session.name));
+		if (ret) {
+			status = LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_INVALID;
+			goto end;
+		}
+
+		lsm.domain.type = tracker->domain;
+		lsm.u.process_attr_tracker_add_remove_include_values.process_attr =
+			(int32_t) tracker->process_attr;
+		lsm.u.process_attr_tracker_add_remove_include_values.value_type =
+			(int32_t) value_type;
+		lsm.u.process_attr_tracker_add_remove_include_values.count = chunk_count;
+
+		ret = lttng_dynamic_buffer_set_size(
+			&payload, chunk_count * sizeof(struct process_attr_integral_value_comm));
+		if (ret) {
+			status = LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_ERROR;
+			goto end;
+		}
+
+		for (unsigned int i = 0; i < chunk_count; i++) {
+			struct process_attr_integral_value_comm integral_value = {};
+
+			if (std::is_signed<ValueType>::value) {
+				integral_value.u._signed = values[offset + i];
+			} else {
+				integral_value.u._unsigned = values[offset + i];
+			}
+
+			memcpy(payload.data + i * sizeof(integral_value),
+			       &integral_value,
+			       sizeof(integral_value));
+		}
+
+		ret = lttng_ctl_ask_sessiond_varlen_no_cmd_header(
+			&lsm, payload.data, payload.size, nullptr);
+		if (ret < 0) {
+			switch (-ret) {
+			case LTTNG_ERR_PROCESS_ATTR_EXISTS:
+				status = LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_EXISTS;
+				break;
+			case LTTNG_ERR_PROCESS_ATTR_MISSING:
+				status = LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_MISSING;
+				break;
+			case LTTNG_ERR_PROCESS_ATTR_TRACKER_INVALID_TRACKING_POLICY:
+				status =
+					LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_INVALID_TRACKING_POLICY;
+				break;
+			default:
+				status = LTTNG_PROCESS_ATTR_TRACKER_HANDLE_STATUS_ERROR;
+			}
+			goto end;
+		}
+
+		offset += chunk_count;
+	}
+end:
+	lttng_dynamic_buffer_reset(&payload);
+	return status;
+}
+
+#define DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(                                                        \
+	command_upper, command_lower, process_attr_name, value_type_name, value_type_c, value_type_enum)       \
+	enum lttng_process_attr_tracker_handle_status                                                          \
+		lttng_process_attr_##process_attr_name##_tracker_handle_##command_lower##_##value_type_name(   \
+			const struct lttng_process_attr_tracker_handle *tracker,                               \
+			const value_type_c *values,                                                            \
+			unsigned int count)                                                                    \
+	{                                                                                                      \
+		return add_remove_integral_values(                                                             \
+			tracker,                                                                               \
+			LTTCOMM_SESSIOND_COMMAND_PROCESS_ATTR_TRACKER_##command_upper##_INCLUDE_VALUES,        \
+			LTTNG_PROCESS_ATTR_VALUE_TYPE_##value_type_enum,                                       \
+			values,                                                                                \
+			count);                                                                                \
+	}
+
+/* PID */
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(ADD, add, process_id, pids, pid_t, PID);
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(REMOVE, remove, process_id, pids, pid_t, PID);
+
+/* VPID */
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(ADD, add, virtual_process_id, pids, pid_t, PID);
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(
+	REMOVE, remove, virtual_process_id, pids, pid_t, PID);
+
+/* UID */
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(ADD, add, user_id, uids, uid_t, UID);
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(REMOVE, remove, user_id, uids, uid_t, UID);
+
+/* VUID */
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(ADD, add, virtual_user_id, uids, uid_t, UID);
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(REMOVE, remove, virtual_user_id, uids, uid_t, UID);
+
+/* GID */
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(ADD, add, group_id, gids, gid_t, GID);
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(REMOVE, remove, group_id, gids, gid_t, GID);
+
+/* VGID */
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(ADD, add, virtual_group_id, gids, gid_t, GID);
+DEFINE_TRACKER_ADD_REMOVE_INTEGRAL_VALUES_FUNC(REMOVE, remove, virtual_group_id, gids, gid_t, GID);
+
+
 enum lttng_process_attr_tracker_handle_status lttng_process_attr_tracker_handle_get_inclusion_set(
 	struct lttng_process_attr_tracker_handle *tracker,
 	const struct lttng_process_attr_values **values)
@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Measure the throughput of the consumer data path: lttng_consumer_read_subbuffer()
+ * consumes the packets of synthetic in-memory ring buffers, standing in for
+ * the tracer buffers, to the stream and index files of a local trace chunk.
+ *
+ * The packets are written to OUTPUT_DIR, which can be on a tmpfs or on a real
+ * disk. With "/dev/null" as OUTPUT_DIR, the packets are written to /dev/null
+ * and the index files to a temporary directory.
+ *
+ * Reports the throughput, the read and write system calls per packet, as
+ * accounted in /proc/self/io, and the latency of the reads of each stream.
+ *
+ * Usage: bench_consumer_read OUTPUT_DIR [STREAMS] [PACKETS] [SUBBUF_SIZE] [SUBBUFFERS_PER_READ]
+ */
+
+#include <common/compat/directory-handle.hpp>
+#include <common/consumer/consumer-stream.hpp>
+#include <common/consumer/consumer.hpp>
+#include <common/macros.hpp>
+#include <common/time.hpp>
+#include <common/trace-chunk.hpp>
+
+#include <bin/lttng-consumerd/health-consumerd.hpp>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <urcu.h>
+#include <vector>
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+/* Defined by lttng-consumerd. */
+struct health_app *health_consumerd;
+int health_quit_pipe[2] = { -1, -1 };
+
+namespace {
+const char *const channel_path = "bench";
+
+/* Synthetic ring buffer of a stream, of which every packet holds the same data. */
+struct bench_stream {
+	struct lttng_consumer_stream *stream;
+	std::vector<char> packet;
+	uint64_t produced;
+	uint64_t consumed;
+	/* Reads of the stream by lttng_consumer_read_subbuffer(). */
+	uint64_t read_count;
+	uint64_t read_total_ns;
+	uint64_t read_max_ns;
+};
+
+struct io_counters {
+	uint64_t syscr;
+	uint64_t syscw;
+};
+
+std::vector<bench_stream> bench_streams;
+
+uint64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+void read_io_counters(struct io_counters *counters)
+{
+	char line[128];
+	FILE *io = fopen("/proc/self/io", "r");
+
+	counters->syscr = 0;
+	counters->syscw = 0;
+	if (!io) {
+		return;
+	}
+
+	while (fgets(line, sizeof(line), io)) {
+		sscanf(line, "syscr: %" SCNu64, &counters->syscr);
+		sscanf(line, "syscw: %" SCNu64, &counters->syscw);
+	}
+
+	fclose(io);
+}
+
+/* The streams are created with their index in `bench_streams` as wait_fd. */
+struct bench_stream& get_bench_stream(const struct lttng_consumer_stream *stream)
+{
+	return bench_streams[stream->wait_fd];
+}
+
+enum get_next_subbuffer_status bench_get_next_subbuffer(struct lttng_consumer_stream *stream,
+							struct stream_subbuffer *subbuffer)
+{
+	struct bench_stream& bench_stream = get_bench_stream(stream);
+	const unsigned long size = bench_stream.packet.size();
+
+	if (bench_stream.consumed == bench_stream.produced) {
+		return GET_NEXT_SUBBUFFER_STATUS_NO_DATA;
+	}
+
+	subbuffer->info.data.subbuf_size = size;
+	subbuffer->info.data.padded_subbuf_size = size;
+	subbuffer->info.data.packet_size = size * CHAR_BIT;
+	subbuffer->info.data.content_size = size * CHAR_BIT;
+	subbuffer->info.data.timestamp_begin = bench_stream.consumed * 1000;
+	subbuffer->info.data.timestamp_end = bench_stream.consumed * 1000 + 999;
+	subbuffer->info.data.events_discarded = 0;
+	LTTNG_OPTIONAL_SET(&subbuffer->info.data.sequence_number, bench_stream.consumed);
+	subbuffer->info.data.stream_id = 0;
+	LTTNG_OPTIONAL_SET(&subbuffer->info.data.stream_instance_id, (uint64_t) stream->cpu);
+	subbuffer->buffer.buffer = lttng_buffer_view_init(bench_stream.packet.data(), 0, size);
+	return GET_NEXT_SUBBUFFER_STATUS_OK;
+}
+
+int bench_put_next_subbuffer(struct lttng_consumer_stream *stream,
+			     struct stream_subbuffer *subbuffer __attribute__((unused)))
+{
+	get_bench_stream(stream).consumed++;
+	return 0;
+}
+
+struct lttng_trace_chunk *create_trace_chunk(const char *path)
+{
+	struct lttng_trace_chunk *chunk = nullptr;
+	struct lttng_directory_handle *output_directory;
+	enum lttng_trace_chunk_status status;
+
+	output_directory = lttng_directory_handle_create(path);
+	if (!output_directory) {
+		return nullptr;
+	}
+
+	chunk = lttng_trace_chunk_create_anonymous();
+	if (!chunk) {
+		goto end;
+	}
+
+	status = lttng_trace_chunk_set_credentials_current_user(chunk);
+	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		goto error;
+	}
+
+	status = lttng_trace_chunk_set_as_owner(chunk, output_directory);
+	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		goto error;
+	}
+
+	status = lttng_trace_chunk_create_subdirectory(chunk, "bench/index");
+	if (status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		goto error;
+	}
+
+end:
+	lttng_directory_handle_put(output_directory);
+	return chunk;
+error:
+	lttng_trace_chunk_put(chunk);
+	chunk = nullptr;
+	goto end;
+}
+
+struct lttng_consumer_stream *create_stream(struct lttng_consumer_channel *channel,
+					    struct lttng_trace_chunk *chunk,
+					    int index,
+					    bool null_output)
+{
+	int ret;
+	struct lttng_consumer_stream *stream;
+
+	stream = consumer_stream_create(channel,
+					channel->key,
+					index,
+					channel->name,
+					-1ULL,
+					channel->session_id,
+					chunk,
+					index,
+					&ret,
+					CONSUMER_CHANNEL_TYPE_DATA,
+					channel->monitor);
+	if (!stream) {
+		return nullptr;
+	}
+
+	stream->wait_fd = index;
+	stream->read_subbuffer_ops.get_next_subbuffer = bench_get_next_subbuffer;
+	stream->read_subbuffer_ops.put_next_subbuffer = bench_put_next_subbuffer;
+
+	pthread_mutex_lock(&stream->lock);
+	ret = consumer_stream_create_output_files(stream, true);
+	if (!ret && null_output) {
+		const int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+		ret = null_fd < 0 ? -1 : dup2(null_fd, stream->out_fd);
+		if (null_fd >= 0) {
+			(void) close(null_fd);
+		}
+	}
+	pthread_mutex_unlock(&stream->lock);
+	if (ret < 0) {
+		fprintf(stderr, "Failed to create the output files of stream %d\n", index);
+		consumer_stream_free(stream);
+		return nullptr;
+	}
+
+	return stream;
+}
+
+void destroy_stream(struct lttng_consumer_stream *stream)
+{
+	pthread_mutex_lock(&stream->lock);
+	consumer_stream_close_output(stream);
+	pthread_mutex_unlock(&stream->lock);
+	consumer_stream_free(stream);
+}
+
+/* Consume all the produced packets, reading the streams in turn. */
+int consume_all(struct lttng_consumer_local_data *ctx)
+{
+	bool consumed;
+
+	do {
+		consumed = false;
+		for (auto& bench_stream : bench_streams) {
+			const uint64_t start = now_ns();
+			const ssize_t ret =
+				lttng_consumer_read_subbuffer(bench_stream.stream, ctx, false);
+			const uint64_t duration = now_ns() - start;
+
+			if (ret < 0) {
+				fprintf(stderr, "Failed to read stream %d\n", bench_stream.stream->cpu);
+				return -1;
+			} else if (ret == 0) {
+				continue;
+			}
+
+			consumed = true;
+			bench_stream.read_count++;
+			bench_stream.read_total_ns += duration;
+			bench_stream.read_max_ns = std::max(bench_stream.read_max_ns, duration);
+		}
+	} while (consumed);
+
+	return 0;
+}
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	int ret = EXIT_FAILURE;
+	const char *output_dir = argc > 1 ? argv[1] : nullptr;
+	const unsigned long stream_count = argc > 2 ? strtoul(argv[2], nullptr, 0) : 4;
+	const unsigned long packets = argc > 3 ? strtoul(argv[3], nullptr, 0) : 100000;
+	const unsigned long subbuf_size = argc > 4 ? strtoul(argv[4], nullptr, 0) : 65536;
+	const unsigned long subbuffers_per_read = argc > 5 ? strtoul(argv[5], nullptr, 0) : 1;
+	const bool null_output = output_dir && strcmp(output_dir, "/dev/null") == 0;
+	char index_dir[] = "/tmp/bench-consumer-read-XXXXXX";
+	struct lttng_consumer_channel *channel = nullptr;
+	struct lttng_trace_chunk *chunk = nullptr;
+	struct io_counters io_start, io_end;
+	uint64_t start, duration, total_packets;
+	double seconds;
+
+	if (!output_dir || !stream_count || !packets || !subbuf_size || !subbuffers_per_read) {
+		fprintf(stderr,
+			"Usage: %s OUTPUT_DIR [STREAMS] [PACKETS] [SUBBUF_SIZE] [SUBBUFFERS_PER_READ]\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (null_output && !mkdtemp(index_dir)) {
+		perror("Failed to create the index directory");
+		return EXIT_FAILURE;
+	}
+
+	rcu_register_thread();
+	if (lttng_consumer_init()) {
+		fprintf(stderr, "Failed to initialize the consumer\n");
+		goto end;
+	}
+
+	chunk = create_trace_chunk(null_output ? index_dir : output_dir);
+	if (!chunk) {
+		fprintf(stderr, "Failed to create the trace chunk\n");
+		goto end_cleanup;
+	}
+
+	channel = consumer_allocate_channel(1,
+					    1,
+					    nullptr,
+					    channel_path,
+					    "channel0",
+					    -1ULL,
+					    LTTNG_EVENT_MMAP,
+					    0,
+					    0,
+					    0,
+					    1,
+					    0,
+					    false,
+					    nullptr,
+					    nullptr);
+	if (!channel) {
+		fprintf(stderr, "Failed to allocate the channel\n");
+		goto end_cleanup;
+	}
+
+	channel->drain_max_subbuffers = subbuffers_per_read;
+
+	bench_streams.resize(stream_count);
+	for (unsigned long i = 0; i < stream_count; i++) {
+		bench_streams[i].packet.assign(subbuf_size, (char) i);
+		bench_streams[i].produced = packets;
+		bench_streams[i].stream = create_stream(channel, chunk, i, null_output);
+		if (!bench_streams[i].stream) {
+			bench_streams.resize(i);
+			goto end_destroy;
+		}
+	}
+
+	read_io_counters(&io_start);
+	start = now_ns();
+	if (consume_all(nullptr)) {
+		goto end_destroy;
+	}
+
+	duration = now_ns() - start;
+	read_io_counters(&io_end);
+
+	total_packets = stream_count * packets;
+	seconds = (double) duration / NSEC_PER_SEC;
+	printf("%" PRIu64 " packets of %lu bytes over %lu stream(s), %lu sub-buffer(s) per read, to %s\n",
+	       total_packets,
+	       subbuf_size,
+	       stream_count,
+	       subbuffers_per_read,
+	       output_dir);
+	printf("throughput: %.2f MB/s, %.0f packets/s\n",
+	       (double) total_packets * subbuf_size / seconds / 1e6,
+	       (double) total_packets / seconds);
+	printf("system calls: %.2f read(s)/packet, %.2f write(s)/packet\n",
+	       (double) (io_end.syscr - io_start.syscr) / total_packets,
+	       (double) (io_end.syscw - io_start.syscw) / total_packets);
+	for (const auto& bench_stream : bench_streams) {
+		printf("stream %d: %" PRIu64 " reads, %.2f us/read, %.2f us max\n",
+		       bench_stream.stream->cpu,
+		       bench_stream.read_count,
+		       (double) bench_stream.read_total_ns / bench_stream.read_count / 1000,
+		       (double) bench_stream.read_max_ns / 1000);
+	}
+
+	ret = EXIT_SUCCESS;
+
+end_destroy:
+	for (auto& bench_stream : bench_streams) {
+		destroy_stream(bench_stream.stream);
+	}
+
+	/* The streams are freed after a grace period. */
+	rcu_barrier();
+	delete channel;
+end_cleanup:
+	lttng_trace_chunk_put(chunk);
+	lttng_consumer_cleanup();
+end:
+	rcu_barrier();
+	rcu_unregister_thread();
+	return ret;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Measure the cost of the hash functions of the hash tables and of the
+ * lookups of u64 and string keyed tables which depend on them, such as the
+ * stream tables of the consumers and the relay daemon and the session and
+ * trigger name tables of the session daemon.
+ *
+ * The hash functions are selected at build time: build with and without
+ * --enable-fast-hash to compare them.
+ *
+ * Usage: bench_ht_hash [LOOKUPS] [ELEMENTS]
+ */
+
+#include <common/hashtable/hashtable.hpp>
+#include <common/hashtable/utils.hpp>
+#include <common/macros.hpp>
+#include <common/time.hpp>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <urcu.h>
+#include <vector>
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+struct bench_u64_element {
+	struct lttng_ht_node_u64 node;
+};
+
+struct bench_str_element {
+	std::string name;
+	struct lttng_ht_node_str node;
+};
+
+uint64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Return the mean duration of an operation, in nanoseconds. */
+template <typename Operation>
+double bench(unsigned long count, Operation operation)
+{
+	uint64_t found = 0;
+	const uint64_t start = now_ns();
+
+	for (unsigned long i = 0; i < count; i++) {
+		rcu_read_lock();
+		found += operation(i);
+		rcu_read_unlock();
+	}
+
+	if (found != count) {
+		fprintf(stderr, "Failed to find %" PRIu64 " keys\n", count - found);
+		exit(EXIT_FAILURE);
+	}
+
+	return (double) (now_ns() - start) / count;
+}
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	const unsigned long lookups = argc > 1 ? strtoul(argv[1], nullptr, 0) : 10000000;
+	const unsigned long element_count = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1024;
+	std::vector<bench_u64_element> u64_elements(element_count);
+	std::vector<bench_str_element> str_elements(element_count);
+	struct lttng_ht *u64_ht, *str_ht;
+	volatile unsigned long hash_sink = 0;
+
+	if (!lookups || !element_count) {
+		fprintf(stderr, "Usage: %s [LOOKUPS] [ELEMENTS]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	rcu_register_thread();
+	u64_ht = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
+	str_ht = lttng_ht_new(0, LTTNG_HT_TYPE_STRING);
+	if (!u64_ht || !str_ht) {
+		fprintf(stderr, "Failed to allocate hash tables\n");
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned long i = 0; i < element_count; i++) {
+		lttng_ht_node_init_u64(&u64_elements[i].node, i);
+		lttng_ht_add_unique_u64(u64_ht, &u64_elements[i].node);
+
+		/* Names shaped like the default session names. */
+		str_elements[i].name = "auto-20261014-" + std::to_string(100000 + i);
+		lttng_ht_node_init_str(&str_elements[i].node, (char *) str_elements[i].name.c_str());
+		lttng_ht_add_unique_str(str_ht, &str_elements[i].node);
+	}
+
+#ifdef LTTNG_HT_FAST_HASH
+	printf("multiply-mix hash functions, ");
+#else
+	printf("lookup3 hash functions, ");
+#endif
+	printf("%lu operations over %lu keys\n", lookups, element_count);
+
+	printf("hash_key_u64:      %.2f ns/key\n", bench(lookups, [&](unsigned long i) {
+		       const uint64_t key = i % element_count;
+
+		       hash_sink = hash_sink + hash_key_u64(&key, lttng_ht_seed);
+		       return true;
+	       }));
+	printf("hash_key_str:      %.2f ns/key\n", bench(lookups, [&](unsigned long i) {
+		       hash_sink = hash_sink +
+			       hash_key_str(str_elements[i % element_count].name.c_str(),
+					    lttng_ht_seed);
+		       return true;
+	       }));
+	printf("u64 table lookup:  %.2f ns/lookup\n", bench(lookups, [&](unsigned long i) {
+		       const uint64_t key = i % element_count;
+		       struct lttng_ht_iter iter;
+
+		       lttng_ht_lookup(u64_ht, &key, &iter);
+		       return lttng_ht_iter_get_node_u64(&iter) != nullptr;
+	       }));
+	printf("str table lookup:  %.2f ns/lookup\n", bench(lookups, [&](unsigned long i) {
+		       struct lttng_ht_iter iter;
+
+		       lttng_ht_lookup(str_ht, str_elements[i % element_count].name.c_str(), &iter);
+		       return lttng_ht_iter_get_node_str(&iter) != nullptr;
+	       }));
+
+	for (unsigned long i = 0; i < element_count; i++) {
+		struct lttng_ht_iter iter;
+
+		iter.iter.node = &u64_elements[i].node.node;
+		(void) lttng_ht_del(u64_ht, &iter);
+		iter.iter.node = &str_elements[i].node.node;
+		(void) lttng_ht_del(str_ht, &iter);
+	}
+
+	lttng_ht_destroy(u64_ht);
+	lttng_ht_destroy(str_ht);
+	rcu_unregister_thread();
+	return EXIT_SUCCESS;
+}
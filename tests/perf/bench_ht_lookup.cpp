@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Compare the cost of finding an element of a u64 hash table by key through
+ * lttng_ht_lookup(), which hashes and matches the key through the function
+ * pointers of the table, against the typed lttng::ht view, which hashes and
+ * matches it inline.
+ *
+ * Usage: bench_ht_lookup [LOOKUPS] [ELEMENTS]
+ */
+
+#include <common/hashtable/hashtable.hpp>
+#include <common/hashtable/typed-hashtable.hpp>
+#include <common/macros.hpp>
+#include <common/time.hpp>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <urcu.h>
+#include <vector>
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+struct bench_element {
+	uint64_t id;
+	struct lttng_ht_node_u64 node;
+};
+
+uint64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+struct bench_element *lookup_element(struct lttng_ht *ht, uint64_t id)
+{
+	struct lttng_ht_iter iter;
+	struct lttng_ht_node_u64 *node;
+
+	lttng_ht_lookup(ht, &id, &iter);
+	node = lttng_ht_iter_get_node_u64(&iter);
+	return node ? lttng::utils::container_of(node, &bench_element::node) : nullptr;
+}
+
+template <typename FindElement>
+double bench(unsigned long lookups, unsigned long element_count, FindElement find_element)
+{
+	uint64_t found = 0;
+	const uint64_t start = now_ns();
+
+	for (unsigned long i = 0; i < lookups; i++) {
+		rcu_read_lock();
+		found += find_element((uint64_t) (i % element_count)) != nullptr;
+		rcu_read_unlock();
+	}
+
+	if (found != lookups) {
+		fprintf(stderr, "Failed to find %" PRIu64 " elements\n", lookups - found);
+		exit(EXIT_FAILURE);
+	}
+
+	return (double) (now_ns() - start) / lookups;
+}
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	const unsigned long lookups = argc > 1 ? strtoul(argv[1], nullptr, 0) : 10000000;
+	const unsigned long element_count = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1024;
+	std::vector<bench_element> elements(element_count);
+	struct lttng_ht *ht;
+
+	if (!lookups || !element_count) {
+		fprintf(stderr, "Usage: %s [LOOKUPS] [ELEMENTS]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	rcu_register_thread();
+	ht = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
+	if (!ht) {
+		fprintf(stderr, "Failed to allocate hash table\n");
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned long i = 0; i < element_count; i++) {
+		elements[i].id = i;
+		lttng_ht_node_init_u64(&elements[i].node, i);
+		lttng_ht_add_unique_u64(ht, &elements[i].node);
+	}
+
+	const lttng::ht<lttng_ht_node_u64, bench_element, &bench_element::node> typed_ht(*ht);
+
+	printf("%lu lookups over %lu elements\n", lookups, element_count);
+	printf("lttng_ht_lookup: %.2f ns/lookup\n",
+	       bench(lookups, element_count, [ht](uint64_t id) { return lookup_element(ht, id); }));
+	printf("lttng::ht::find: %.2f ns/lookup\n",
+	       bench(lookups, element_count, [&typed_ht](uint64_t id) {
+		       return typed_ht.find(id);
+	       }));
+
+	for (auto& element : elements) {
+		struct lttng_ht_iter iter;
+
+		iter.iter.node = &element.node.node;
+		(void) lttng_ht_del(ht, &iter);
+	}
+
+	lttng_ht_destroy(ht);
+	rcu_unregister_thread();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,858 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Measure the throughput and the latency of the notification thread of the
+ * session daemon, which runs in-process with its action executor, from the
+ * tracer inputs to the subscribed lttng-ctl notification channels.
+ *
+ * Registers TRIGGERS triggers with a notify action, split evenly between
+ * buffer usage (one per channel), session consumed size and event rule
+ * matches conditions, the latter capturing an event payload field. CLIENTS
+ * notification channels subscribe to the conditions of all the triggers, as
+ * well as SLOW_CLIENTS notification channels which only consume a
+ * notification every 10 ms and overflow their outgoing queue.
+ *
+ * The channel samples of a consumer daemon are first written to the channel
+ * monitoring pipe, in rounds: the buffer usage of all the channels crosses its
+ * threshold every other round, and the consumed size of every session crosses
+ * its next threshold every round. Then NOTIFICATIONS event
+ * notifier notifications of the event rule matches triggers are written back
+ * to back to an event source pipe, as the tracers do.
+ *
+ * Reports the latency until the action executor executes the notify actions,
+ * sampled from their execution counter, and until the clients receive the
+ * notifications, as well as the throughput of the event notifier
+ * notifications and the notifications dropped for the slow clients.
+ *
+ * Usage: bench_notification [TRIGGERS] [CLIENTS] [SLOW_CLIENTS] [NOTIFICATIONS]
+ */
+
+#include <common/compat/endian.hpp>
+#include <common/credentials.hpp>
+#include <common/defaults.hpp>
+#include <common/macros.hpp>
+#include <common/pipe.hpp>
+#include <common/readwrite.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/time.hpp>
+
+#include <lttng/action/action-internal.hpp>
+#include <lttng/lttng.h>
+#include <lttng/trigger/trigger-internal.hpp>
+
+#include <bin/lttng-sessiond/event-notifier-error-accounting.hpp>
+#include <bin/lttng-sessiond/health-sessiond.hpp>
+#include <bin/lttng-sessiond/notification-thread-commands.hpp>
+#include <bin/lttng-sessiond/notification-thread.hpp>
+#include <bin/lttng-sessiond/thread.hpp>
+#include <bin/lttng-sessiond/ust-abi-internal.hpp>
+#include <algorithm>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <urcu.h>
+#include <urcu/uatomic.h>
+#include <vector>
+
+#ifdef HAVE_LIBLTTNG_UST_CTL
+#include <lttng/lttng-export.h>
+#include <lttng/ust-sigbus.h>
+LTTNG_EXPORT DEFINE_LTTNG_UST_SIGBUS_STATE();
+#endif
+
+namespace {
+const unsigned int channels_per_session = 8;
+const uint64_t channel_capacity = 1024 * 1024;
+/* Consumed size of a session per round of channel samples. */
+const uint64_t consumed_step = 1024 * 1024;
+const unsigned int min_sample_rounds = 16;
+const useconds_t slow_client_delay_us = 10000;
+const uint64_t round_timeout_ns = 10 * NSEC_PER_SEC;
+/* The event notifier notifications are all handled once nothing moves for that long. */
+const uint64_t quiescence_ns = 500 * NSEC_PER_MSEC;
+const char *const session_name_prefix = "bench_notification";
+const char *const channel_name = "channel0";
+
+struct bench_client {
+	pthread_t thread;
+	struct lttng_notification_channel *channel;
+	bool slow;
+	/* Updated by the client thread, read by the main thread. */
+	uint64_t received;
+	uint64_t dropped;
+	/* Time from the start of the round of channel samples to the reception. */
+	std::vector<uint64_t> sample_latencies_ns;
+	/* Time from the write of the event notifier notification to the reception. */
+	std::vector<uint64_t> event_latencies_ns;
+	bool failed;
+};
+
+/* Start of the current round of channel samples. */
+uint64_t round_start_ns;
+/* Set once the measurements are done, to stop the slow clients. */
+int clients_quit;
+/* Write time of the event notifier notifications, by sequence number. */
+std::vector<uint64_t> event_send_ns;
+
+uint64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Print the percentiles of the latencies `samples_ns`, sorting them. */
+void print_latency(const char *name, std::vector<uint64_t>& samples_ns)
+{
+	if (samples_ns.empty()) {
+		printf("%s latency: no samples\n", name);
+		return;
+	}
+
+	std::sort(samples_ns.begin(), samples_ns.end());
+
+	const auto percentile = [&samples_ns](double fraction) {
+		return (double) samples_ns[(size_t) (fraction * (samples_ns.size() - 1))] /
+			NSEC_PER_USEC;
+	};
+
+	printf("%s latency: p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+	       name,
+	       percentile(0.5),
+	       percentile(0.99),
+	       percentile(0.999),
+	       percentile(1));
+}
+
+uint64_t action_execution_count(struct lttng_trigger *trigger)
+{
+	return uatomic_read(&lttng_trigger_get_action(trigger)->execution_counter);
+}
+
+uint64_t action_execution_request_count(struct lttng_trigger *trigger)
+{
+	return uatomic_read(&lttng_trigger_get_action(trigger)->execution_request_counter);
+}
+
+/* Register a trigger of `condition`, with a notify action, owned by the current user. */
+struct lttng_trigger *register_trigger(struct notification_thread_handle *handle,
+				       struct lttng_condition *condition)
+{
+	struct lttng_action *action;
+	struct lttng_trigger *trigger = nullptr;
+	enum lttng_error_code ret_code;
+	const struct lttng_credentials creds = {
+		.uid = LTTNG_OPTIONAL_INIT_VALUE(getuid()),
+		.gid = LTTNG_OPTIONAL_INIT_VALUE(getgid()),
+	};
+
+	if (!condition) {
+		goto end;
+	}
+
+	action = lttng_action_notify_create();
+	if (!action) {
+		goto end;
+	}
+
+	trigger = lttng_trigger_create(condition, action);
+	lttng_action_destroy(action);
+	if (!trigger) {
+		goto end;
+	}
+
+	lttng_trigger_set_credentials(trigger, &creds);
+	ret_code = notification_thread_command_register_trigger(handle, trigger, false);
+	if (ret_code != LTTNG_OK) {
+		fprintf(stderr, "Failed to register trigger: %s\n", lttng_strerror(-ret_code));
+		lttng_trigger_destroy(trigger);
+		trigger = nullptr;
+	}
+
+end:
+	lttng_condition_destroy(condition);
+	return trigger;
+}
+
+struct lttng_condition *create_buffer_usage_condition(const char *session_name)
+{
+	struct lttng_condition *condition = lttng_condition_buffer_usage_high_create();
+
+	if (!condition ||
+	    lttng_condition_buffer_usage_set_threshold_ratio(condition, 0.5) !=
+		    LTTNG_CONDITION_STATUS_OK ||
+	    lttng_condition_buffer_usage_set_session_name(condition, session_name) !=
+		    LTTNG_CONDITION_STATUS_OK ||
+	    lttng_condition_buffer_usage_set_channel_name(condition, channel_name) !=
+		    LTTNG_CONDITION_STATUS_OK ||
+	    lttng_condition_buffer_usage_set_domain_type(condition, LTTNG_DOMAIN_UST) !=
+		    LTTNG_CONDITION_STATUS_OK) {
+		lttng_condition_destroy(condition);
+		return nullptr;
+	}
+
+	return condition;
+}
+
+struct lttng_condition *create_consumed_size_condition(const char *session_name,
+						       uint64_t threshold)
+{
+	struct lttng_condition *condition = lttng_condition_session_consumed_size_create();
+
+	if (!condition ||
+	    lttng_condition_session_consumed_size_set_threshold(condition, threshold) !=
+		    LTTNG_CONDITION_STATUS_OK ||
+	    lttng_condition_session_consumed_size_set_session_name(condition, session_name) !=
+		    LTTNG_CONDITION_STATUS_OK) {
+		lttng_condition_destroy(condition);
+		return nullptr;
+	}
+
+	return condition;
+}
+
+/* Condition of the events `bench_notification:event_INDEX`, capturing their `seq` field. */
+struct lttng_condition *create_event_rule_matches_condition(unsigned long index)
+{
+	char pattern[64];
+	struct lttng_event_rule *rule;
+	struct lttng_event_expr *expr = nullptr;
+	struct lttng_condition *condition = nullptr;
+
+	rule = lttng_event_rule_user_tracepoint_create();
+	if (!rule) {
+		goto end;
+	}
+
+	snprintf(pattern, sizeof(pattern), "%s:event_%lu", session_name_prefix, index);
+	if (lttng_event_rule_user_tracepoint_set_name_pattern(rule, pattern) !=
+	    LTTNG_EVENT_RULE_STATUS_OK) {
+		goto end;
+	}
+
+	condition = lttng_condition_event_rule_matches_create(rule);
+	if (!condition) {
+		goto end;
+	}
+
+	expr = lttng_event_expr_event_payload_field_create("seq");
+	if (!expr ||
+	    lttng_condition_event_rule_matches_append_capture_descriptor(condition, expr) !=
+		    LTTNG_CONDITION_STATUS_OK) {
+		lttng_event_expr_destroy(expr);
+		lttng_condition_destroy(condition);
+		condition = nullptr;
+	}
+
+end:
+	lttng_event_rule_destroy(rule);
+	return condition;
+}
+
+int record_latency(struct bench_client *client,
+		   struct lttng_notification *notification,
+		   uint64_t received_ns)
+{
+	const struct lttng_evaluation *evaluation = lttng_notification_get_evaluation(notification);
+	uint64_t seq;
+
+	try {
+		if (lttng_evaluation_get_type(evaluation) !=
+		    LTTNG_CONDITION_TYPE_EVENT_RULE_MATCHES) {
+			client->sample_latencies_ns.push_back(
+				received_ns - uatomic_read(&round_start_ns));
+			return 0;
+		}
+
+		if (lttng_evaluation_event_rule_matches_get_captured_unsigned_int_at_index(
+			    evaluation, 0, &seq) != LTTNG_EVENT_FIELD_VALUE_STATUS_OK ||
+		    seq >= event_send_ns.size()) {
+			fprintf(stderr, "Unexpected captured value of event notifier notification\n");
+			return -1;
+		}
+
+		client->event_latencies_ns.push_back(received_ns - event_send_ns[seq]);
+	} catch (const std::bad_alloc&) {
+		return -1;
+	}
+
+	return 0;
+}
+
+void *client_thread(void *data)
+{
+	struct bench_client *client = (bench_client *) data;
+
+	for (;;) {
+		struct lttng_notification *notification;
+		uint64_t received_ns;
+
+		switch (lttng_notification_channel_get_next_notification(client->channel,
+									 &notification)) {
+		case LTTNG_NOTIFICATION_CHANNEL_STATUS_OK:
+			break;
+		case LTTNG_NOTIFICATION_CHANNEL_STATUS_NOTIFICATIONS_DROPPED:
+			uatomic_inc(&client->dropped);
+			continue;
+		case LTTNG_NOTIFICATION_CHANNEL_STATUS_CLOSED:
+			/* The notification thread quit. */
+			goto end;
+		default:
+			client->failed = true;
+			goto end;
+		}
+
+		received_ns = now_ns();
+		if (!client->slow && record_latency(client, notification, received_ns)) {
+			client->failed = true;
+			lttng_notification_destroy(notification);
+			goto end;
+		}
+
+		lttng_notification_destroy(notification);
+		uatomic_inc(&client->received);
+		if (uatomic_read(&clients_quit)) {
+			goto end;
+		}
+
+		if (client->slow) {
+			usleep(slow_client_delay_us);
+		}
+	}
+
+end:
+	return nullptr;
+}
+
+/* Return whether every fast client received at least `expected` notifications. */
+bool fast_clients_received(const std::vector<bench_client>& clients, uint64_t expected)
+{
+	for (const auto& client : clients) {
+		if (!client.slow && uatomic_read(&client.received) < expected) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint64_t fast_clients_received_total(const std::vector<bench_client>& clients)
+{
+	uint64_t total = 0;
+
+	for (const auto& client : clients) {
+		if (!client.slow) {
+			total += uatomic_read(&client.received);
+		}
+	}
+
+	return total;
+}
+
+/*
+ * Write rounds of channel samples, waiting for the notifications of a round,
+ * to the action executor and to the fast clients, before the next one.
+ */
+int run_channel_samples(int sample_fd,
+			const std::vector<struct lttng_trigger *>& buffer_usage_triggers,
+			const std::vector<struct lttng_trigger *>& consumed_size_triggers,
+			unsigned long session_count,
+			std::vector<bench_client>& clients,
+			std::vector<uint64_t>& executor_latencies_ns)
+{
+	const unsigned long channel_count = buffer_usage_triggers.size();
+	const unsigned long rounds = std::max<unsigned long>(
+		min_sample_rounds,
+		(consumed_size_triggers.size() + session_count - 1) / session_count);
+	std::vector<struct lttng_trigger *> pending;
+	std::vector<uint64_t> pending_counts;
+	uint64_t expected = 0;
+	unsigned long round, i;
+
+	for (round = 0; round < rounds; round++) {
+		const bool high = round % 2 == 0;
+		uint64_t start_ns;
+
+		/*
+		 * The buffer usage conditions hold on high samples, the consumed
+		 * size thresholds of index `round` are crossed.
+		 */
+		pending.clear();
+		if (high) {
+			pending = buffer_usage_triggers;
+		}
+
+		for (i = round * session_count;
+		     i < std::min<unsigned long>((round + 1) * session_count,
+						 consumed_size_triggers.size());
+		     i++) {
+			pending.push_back(consumed_size_triggers[i]);
+		}
+
+		pending_counts.clear();
+		for (const auto trigger : pending) {
+			pending_counts.push_back(action_execution_count(trigger));
+		}
+
+		expected += pending.size();
+		start_ns = now_ns();
+		uatomic_set(&round_start_ns, start_ns);
+		for (i = 0; i < channel_count; i++) {
+			struct lttcomm_consumer_channel_monitor_msg msg = {};
+
+			msg.key = i + 1;
+			msg.session_id = i / channels_per_session + 1;
+			msg.lowest = high ? channel_capacity : 0;
+			msg.highest = msg.lowest;
+			/* The first channel of a session carries its consumed size. */
+			msg.consumed_since_last_sample = i % channels_per_session == 0 ?
+				consumed_step :
+				0;
+			if (lttng_write(sample_fd, &msg, sizeof(msg)) != sizeof(msg)) {
+				PERROR("Failed to write channel sample");
+				return -1;
+			}
+		}
+
+		while (!pending.empty() || !fast_clients_received(clients, expected)) {
+			const uint64_t poll_ns = now_ns();
+
+			for (i = 0; i < pending.size();) {
+				if (action_execution_count(pending[i]) == pending_counts[i]) {
+					i++;
+					continue;
+				}
+
+				executor_latencies_ns.push_back(poll_ns - start_ns);
+				pending[i] = pending.back();
+				pending.pop_back();
+				pending_counts[i] = pending_counts.back();
+				pending_counts.pop_back();
+			}
+
+			if (poll_ns - start_ns > round_timeout_ns) {
+				fprintf(stderr,
+					"Round %lu of channel samples timed out: %zu actions not executed\n",
+					round,
+					pending.size());
+				return -1;
+			}
+
+			usleep(10);
+		}
+	}
+
+	printf("channel samples: %lu rounds of %lu channels, %" PRIu64
+	       " notifications per client\n",
+	       rounds,
+	       channel_count,
+	       expected);
+	return 0;
+}
+
+/* Write `count` event notifier notifications, capturing their sequence number. */
+int run_event_notifications(int event_fd,
+			    const std::vector<struct lttng_trigger *>& event_triggers,
+			    std::vector<bench_client>& clients,
+			    unsigned long count)
+{
+	uint64_t executed_begin = 0, requested_begin = 0, requested = 0;
+	uint64_t executed, received_begin, received, start_ns, write_end_ns;
+	uint64_t last_change_ns, last_executed_ns;
+	unsigned long i;
+
+	for (const auto trigger : event_triggers) {
+		executed_begin += action_execution_count(trigger);
+		requested_begin += action_execution_request_count(trigger);
+	}
+
+	received_begin = fast_clients_received_total(clients);
+	start_ns = now_ns();
+	for (i = 0; i < count; i++) {
+		struct {
+			struct lttng_ust_abi_event_notifier_notification header;
+			/* MessagePack array of the sequence number, as a uint64. */
+			uint8_t capture[10];
+		} LTTNG_PACKED msg = {};
+		const uint64_t seq_be = htobe64((uint64_t) i);
+		const struct lttng_trigger *trigger = event_triggers[i % event_triggers.size()];
+
+		msg.header.token = lttng_trigger_get_tracer_token(trigger);
+		msg.header.capture_buf_size = sizeof(msg.capture);
+		msg.capture[0] = 0x91;
+		msg.capture[1] = 0xcf;
+		memcpy(&msg.capture[2], &seq_be, sizeof(seq_be));
+
+		event_send_ns[i] = now_ns();
+		if (lttng_write(event_fd, &msg, sizeof(msg)) != sizeof(msg)) {
+			PERROR("Failed to write event notifier notification");
+			return -1;
+		}
+	}
+
+	write_end_ns = now_ns();
+	last_change_ns = write_end_ns;
+	last_executed_ns = write_end_ns;
+	executed = executed_begin;
+	received = fast_clients_received_total(clients);
+	while (now_ns() - last_change_ns < quiescence_ns) {
+		uint64_t new_executed = 0;
+		const uint64_t new_received = fast_clients_received_total(clients);
+
+		for (const auto trigger : event_triggers) {
+			new_executed += action_execution_count(trigger);
+		}
+
+		if (new_executed != executed) {
+			last_executed_ns = now_ns();
+		}
+
+		if (new_executed != executed || new_received != received) {
+			last_change_ns = now_ns();
+		}
+
+		executed = new_executed;
+		received = new_received;
+		usleep(1000);
+	}
+
+	for (const auto trigger : event_triggers) {
+		requested += action_execution_request_count(trigger);
+	}
+
+	executed -= executed_begin;
+	requested -= requested_begin;
+	printf("event notifier notifications: %lu written in %.3f s, %.0f/s\n",
+	       count,
+	       (double) (write_end_ns - start_ns) / NSEC_PER_SEC,
+	       (double) count * NSEC_PER_SEC / (write_end_ns - start_ns));
+	printf("action executor: %" PRIu64 " executed, %" PRIu64
+	       " refused (queue overflow), %.0f/s\n",
+	       executed,
+	       (uint64_t) count - requested,
+	       (double) executed * NSEC_PER_SEC /
+		       std::max<uint64_t>(last_executed_ns - start_ns, 1));
+	printf("fast clients: %" PRIu64 " notifications received\n", received - received_begin);
+	return 0;
+}
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	int ret = EXIT_FAILURE, sample_fd = -1;
+	const unsigned long trigger_count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 3000;
+	const unsigned long client_count = argc > 2 ? strtoul(argv[2], nullptr, 0) : 4;
+	const unsigned long slow_client_count = argc > 3 ? strtoul(argv[3], nullptr, 0) : 1;
+	const unsigned long notification_count =
+		argc > 4 ? strtoul(argv[4], nullptr, 0) : 100000;
+	const unsigned long per_kind = trigger_count / 3;
+	const unsigned long session_count =
+		(per_kind + channels_per_session - 1) / channels_per_session;
+	char home[] = "/tmp/bench_notification.XXXXXX";
+	char rundir[PATH_MAX];
+	struct lttng_pipe *ust32_pipe = nullptr, *ust64_pipe = nullptr, *event_pipe = nullptr;
+	struct notification_thread_handle *handle = nullptr;
+	struct lttng_thread *notification_thread = nullptr;
+	std::vector<struct lttng_trigger *> buffer_usage_triggers, consumed_size_triggers,
+		event_triggers;
+	std::vector<bench_client> clients;
+	std::vector<uint64_t> executor_latencies_ns, sample_latencies_ns, event_latencies_ns;
+	uint64_t slow_received = 0, slow_dropped = 0, fast_dropped = 0, start_ns;
+	unsigned long i, started = 0;
+
+	if (per_kind == 0 || client_count == 0) {
+		fprintf(stderr,
+			"Usage: %s [TRIGGERS] [CLIENTS] [SLOW_CLIENTS] [NOTIFICATIONS]\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* The notification channel socket of root is the one of the system-wide daemon. */
+	if (getuid() == 0) {
+		fprintf(stderr, "Run %s as a non-root user\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* The notification channel socket is created in the run directory of LTTNG_HOME. */
+	if (!mkdtemp(home) || setenv(DEFAULT_LTTNG_HOME_ENV_VAR, home, 1)) {
+		PERROR("Failed to create the home directory");
+		return EXIT_FAILURE;
+	}
+
+	snprintf(rundir, sizeof(rundir), DEFAULT_LTTNG_HOME_RUNDIR, home);
+	if (mkdir(rundir, S_IRWXU)) {
+		PERROR("Failed to create the run directory");
+		goto end_home;
+	}
+
+	rcu_register_thread();
+	the_health_sessiond = health_app_create(NR_HEALTH_SESSIOND_TYPES);
+	if (!the_health_sessiond) {
+		goto end_rcu;
+	}
+
+	if (event_notifier_error_accounting_init(
+		    DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE,
+		    std::max<uint64_t>(per_kind, DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE)) !=
+	    EVENT_NOTIFIER_ERROR_ACCOUNTING_STATUS_OK) {
+		fprintf(stderr, "Failed to initialize the event notifier error accounting\n");
+		goto end_health;
+	}
+
+	ust32_pipe = lttng_pipe_open(FD_CLOEXEC);
+	ust64_pipe = lttng_pipe_open(FD_CLOEXEC);
+	event_pipe = lttng_pipe_open(FD_CLOEXEC);
+	if (!ust32_pipe || !ust64_pipe || !event_pipe) {
+		goto end_pipes;
+	}
+
+	/* The samples of the 64-bit consumer daemon are written to the monitoring pipe. */
+	sample_fd = lttng_pipe_release_writefd(ust64_pipe);
+	handle = notification_thread_handle_create(ust32_pipe, ust64_pipe, nullptr);
+	if (!handle) {
+		goto end_pipes;
+	}
+
+	notification_thread = launch_notification_thread(handle);
+	if (!notification_thread) {
+		goto end_handle;
+	}
+
+	if (notification_thread_command_add_tracer_event_source(
+		    handle, lttng_pipe_get_readfd(event_pipe), LTTNG_DOMAIN_UST) != LTTNG_OK) {
+		fprintf(stderr, "Failed to add the event source\n");
+		goto end_thread;
+	}
+
+	try {
+		for (i = 0; i < session_count; i++) {
+			char session_name[64];
+
+			snprintf(session_name, sizeof(session_name), "%s_%lu", session_name_prefix, i);
+			if (notification_thread_command_add_session(
+				    handle, i + 1, session_name, getuid(), getgid()) != LTTNG_OK) {
+				fprintf(stderr, "Failed to add session %s\n", session_name);
+				goto end_triggers;
+			}
+		}
+
+		start_ns = now_ns();
+		for (i = 0; i < per_kind; i++) {
+			char session_name[64];
+			struct lttng_trigger *trigger;
+
+			snprintf(session_name,
+				 sizeof(session_name),
+				 "%s_%lu",
+				 session_name_prefix,
+				 i / channels_per_session);
+			if (notification_thread_command_add_channel(handle,
+								    i / channels_per_session + 1,
+								    (char *) channel_name,
+								    i + 1,
+								    LTTNG_DOMAIN_UST,
+								    channel_capacity) != LTTNG_OK) {
+				fprintf(stderr, "Failed to add channel %lu\n", i);
+				goto end_triggers;
+			}
+
+			trigger = register_trigger(handle, create_buffer_usage_condition(session_name));
+			if (!trigger) {
+				goto end_triggers;
+			}
+
+			buffer_usage_triggers.push_back(trigger);
+
+			/*
+			 * The thresholds of a session are crossed one per round
+			 * of channel samples.
+			 */
+			snprintf(session_name,
+				 sizeof(session_name),
+				 "%s_%lu",
+				 session_name_prefix,
+				 i % session_count);
+			trigger = register_trigger(
+				handle,
+				create_consumed_size_condition(
+					session_name, (i / session_count + 1) * consumed_step));
+			if (!trigger) {
+				goto end_triggers;
+			}
+
+			consumed_size_triggers.push_back(trigger);
+
+			trigger = register_trigger(handle, create_event_rule_matches_condition(i));
+			if (!trigger) {
+				goto end_triggers;
+			}
+
+			event_triggers.push_back(trigger);
+		}
+
+		printf("trigger registration: %.1f us per trigger\n",
+		       (double) (now_ns() - start_ns) / NSEC_PER_USEC / (per_kind * 3));
+
+		event_send_ns.resize(notification_count);
+		clients.resize(client_count + slow_client_count);
+	} catch (const std::bad_alloc&) {
+		goto end_triggers;
+	}
+
+	start_ns = now_ns();
+	for (i = 0; i < clients.size(); i++) {
+		auto& client = clients[i];
+
+		client.slow = i >= client_count;
+		client.channel =
+			lttng_notification_channel_create(lttng_session_daemon_notification_endpoint);
+		if (!client.channel) {
+			fprintf(stderr, "Failed to create notification channel\n");
+			goto end_clients;
+		}
+
+		for (const auto *triggers :
+		     { &buffer_usage_triggers, &consumed_size_triggers, &event_triggers }) {
+			for (const auto trigger : *triggers) {
+				if (lttng_notification_channel_subscribe(
+					    client.channel,
+					    lttng_trigger_get_const_condition(trigger)) !=
+				    LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+					fprintf(stderr, "Failed to subscribe to condition\n");
+					goto end_clients;
+				}
+			}
+		}
+	}
+
+	printf("subscription: %.1f us per condition\n",
+	       (double) (now_ns() - start_ns) / NSEC_PER_USEC /
+		       (clients.size() * per_kind * 3));
+
+	for (auto& client : clients) {
+		if (pthread_create(&client.thread, nullptr, client_thread, &client)) {
+			fprintf(stderr, "Failed to create client thread\n");
+			goto end_clients;
+		}
+
+		started++;
+	}
+
+	printf("%lu triggers of each condition type, %lu clients, %lu slow clients\n",
+	       per_kind,
+	       client_count,
+	       slow_client_count);
+
+	try {
+		if (run_channel_samples(sample_fd,
+					buffer_usage_triggers,
+					consumed_size_triggers,
+					session_count,
+					clients,
+					executor_latencies_ns)) {
+			goto end_clients;
+		}
+	} catch (const std::bad_alloc&) {
+		goto end_clients;
+	}
+
+	if (run_event_notifications(
+		    lttng_pipe_get_writefd(event_pipe), event_triggers, clients, notification_count)) {
+		goto end_clients;
+	}
+
+	ret = EXIT_SUCCESS;
+
+end_clients:
+	/* Closing the notification channels makes the client threads return. */
+	uatomic_set(&clients_quit, 1);
+	lttng_thread_shutdown(notification_thread);
+	lttng_thread_put(notification_thread);
+	notification_thread = nullptr;
+	for (i = 0; i < started; i++) {
+		(void) pthread_join(clients[i].thread, nullptr);
+	}
+
+	for (auto& client : clients) {
+		lttng_notification_channel_destroy(client.channel);
+		if (client.failed) {
+			fprintf(stderr, "A client failed\n");
+			ret = EXIT_FAILURE;
+		}
+
+		if (client.slow) {
+			slow_received += client.received;
+			slow_dropped += client.dropped;
+			continue;
+		}
+
+		fast_dropped += client.dropped;
+		try {
+			sample_latencies_ns.insert(sample_latencies_ns.end(),
+						   client.sample_latencies_ns.begin(),
+						   client.sample_latencies_ns.end());
+			event_latencies_ns.insert(event_latencies_ns.end(),
+						  client.event_latencies_ns.begin(),
+						  client.event_latencies_ns.end());
+		} catch (const std::bad_alloc&) {
+			ret = EXIT_FAILURE;
+		}
+	}
+
+	if (ret == EXIT_SUCCESS) {
+		print_latency("channel sample to action executor", executor_latencies_ns);
+		print_latency("channel sample to client", sample_latencies_ns);
+		print_latency("event notifier notification to client", event_latencies_ns);
+		printf("fast clients: %" PRIu64 " drop indications\n", fast_dropped);
+		printf("slow clients: %" PRIu64 " notifications received, %" PRIu64
+		       " drop indications\n",
+		       slow_received,
+		       slow_dropped);
+	}
+
+end_triggers:
+	for (const auto *triggers :
+	     { &buffer_usage_triggers, &consumed_size_triggers, &event_triggers }) {
+		for (const auto trigger : *triggers) {
+			lttng_trigger_destroy(trigger);
+		}
+	}
+end_thread:
+	if (notification_thread) {
+		lttng_thread_shutdown(notification_thread);
+		lttng_thread_put(notification_thread);
+	}
+end_handle:
+	notification_thread_handle_destroy(handle);
+end_pipes:
+	if (sample_fd >= 0) {
+		close(sample_fd);
+	}
+
+	lttng_pipe_destroy(ust32_pipe);
+	lttng_pipe_destroy(ust64_pipe);
+	lttng_pipe_destroy(event_pipe);
+	event_notifier_error_accounting_fini();
+end_health:
+	health_app_destroy(the_health_sessiond);
+end_rcu:
+	rcu_unregister_thread();
+	(void) rmdir(rundir);
+end_home:
+	(void) rmdir(home);
+	return ret;
+}
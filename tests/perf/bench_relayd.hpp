@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef BENCH_RELAYD_HPP
+#define BENCH_RELAYD_HPP
+
+/*
+ * Measurement helpers shared by the relay daemon ingest and live viewer
+ * benchmarks.
+ */
+
+#include <common/time.hpp>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace bench_relayd {
+inline uint64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/*
+ * Return the CPU time, user and system, consumed by process `pid` so far, in
+ * nanoseconds, or -1ULL if it can't be read from /proc/PID/stat.
+ */
+inline uint64_t process_cpu_ns(pid_t pid)
+{
+	char path[64], stat[1024];
+	const char *fields;
+	unsigned long utime, stime;
+	FILE *file;
+	size_t len;
+	const long ticks_per_second = sysconf(_SC_CLK_TCK);
+
+	if (pid <= 0 || ticks_per_second <= 0) {
+		return -1ULL;
+	}
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int) pid);
+	file = fopen(path, "r");
+	if (!file) {
+		return -1ULL;
+	}
+
+	len = fread(stat, 1, sizeof(stat) - 1, file);
+	fclose(file);
+	stat[len] = '\0';
+
+	/* The command name, in parentheses, may contain spaces. */
+	fields = strrchr(stat, ')');
+	if (!fields ||
+	    sscanf(fields + 1,
+		   " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+		   &utime,
+		   &stime) != 2) {
+		return -1ULL;
+	}
+
+	return (uint64_t) (utime + stime) * NSEC_PER_SEC / ticks_per_second;
+}
+
+/* Print the percentiles of the latencies `samples_ns`, sorting them. */
+inline void print_latency(const char *name, std::vector<uint64_t>& samples_ns)
+{
+	if (samples_ns.empty()) {
+		printf("%s latency: no samples\n", name);
+		return;
+	}
+
+	std::sort(samples_ns.begin(), samples_ns.end());
+
+	const auto percentile = [&samples_ns](double fraction) {
+		return (double) samples_ns[(size_t) (fraction * (samples_ns.size() - 1))] /
+			NSEC_PER_USEC;
+	};
+
+	printf("%s latency: p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+	       name,
+	       percentile(0.5),
+	       percentile(0.99),
+	       percentile(0.999),
+	       percentile(1));
+}
+
+/*
+ * Print the CPU time which process `pid` consumed since `cpu_begin_ns` per GB
+ * of `bytes`.
+ */
+inline void print_relayd_cpu(pid_t pid, uint64_t cpu_begin_ns, uint64_t bytes)
+{
+	const uint64_t cpu_end_ns = process_cpu_ns(pid);
+
+	if (cpu_begin_ns == -1ULL || cpu_end_ns == -1ULL || bytes == 0) {
+		return;
+	}
+
+	printf("relayd CPU: %.3f s, %.3f s/GB\n",
+	       (double) (cpu_end_ns - cpu_begin_ns) / NSEC_PER_SEC,
+	       (double) (cpu_end_ns - cpu_begin_ns) / NSEC_PER_SEC / ((double) bytes / 1e9));
+}
+} /* namespace bench_relayd */
+
+#endif /* BENCH_RELAYD_HPP */
@@ -0,0 +1,526 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Generate the load of SESSIONS live sessions of STREAMS streams each on the
+ * relay daemon at HOST, speaking the consumer daemon protocol through
+ * librelayd, to size relay daemons without running as many traced hosts.
+ *
+ * Each session has its own control and data connections, like the consumer
+ * daemon of a host, and a metadata stream. Its streams send PACKET_RATE
+ * packets of PACKET_SIZE bytes per second, each followed by its index, for
+ * DURATION seconds, except for the first IDLE_STREAMS streams of each session
+ * which only send the live beacons of inactive streams, once per live timer
+ * period. With a PACKET_RATE of 0, the packets are sent as fast as possible.
+ * As with lttng-consumerd, the indexes are sent in batches when
+ * LTTNG_CONSUMERD_RELAYD_INDEX_BATCH_SIZE is set.
+ *
+ * The timestamps of the indexes are CLOCK_MONOTONIC timestamps, which
+ * bench_relayd_live uses to measure the delivery latency of the packets when
+ * running on the same host.
+ *
+ * Reports the throughput, the latency of sending a packet and its index and,
+ * given the PID of the relay daemon, its CPU time per GB received.
+ *
+ * Usage: bench_relayd_ingest HOST [SESSIONS] [STREAMS] [IDLE_STREAMS] [PACKET_RATE] [PACKET_SIZE] [DURATION] [RELAYD_PID]
+ */
+
+#include "bench_relayd.hpp"
+
+#include <common/common.hpp>
+#include <common/compat/endian.hpp>
+#include <common/defaults.hpp>
+#include <common/index/ctf-index.hpp>
+#include <common/relayd/relayd.hpp>
+#include <common/sessiond-comm/relayd.hpp>
+#include <common/sessiond-comm/sessiond-comm.hpp>
+#include <common/trace-chunk.hpp>
+#include <common/uri.hpp>
+#include <common/uuid.hpp>
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+const uint64_t live_timer_us = 1000000;
+const char *const metadata = "/* CTF 1.8 */\n\ntrace {\n\tmajor = 1;\n\tminor = 8;\n};\n";
+
+struct ingest_stream {
+	uint64_t relayd_stream_id;
+	uint64_t next_net_seq_num;
+	uint64_t last_timestamp;
+	bool idle;
+};
+
+struct ingest_session {
+	unsigned int index;
+	pthread_t thread;
+	struct lttcomm_relayd_sock *control;
+	struct lttcomm_relayd_sock *data;
+	struct lttng_trace_chunk *chunk;
+	uint64_t metadata_stream_id;
+	std::vector<ingest_stream> streams;
+	/* Time to send a packet and its index. */
+	std::vector<uint64_t> latencies_ns;
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t beacons;
+	bool failed;
+};
+
+struct ingest_config {
+	const char *host;
+	unsigned long stream_count;
+	unsigned long idle_stream_count;
+	unsigned long packet_rate;
+	unsigned long packet_size;
+	uint64_t start_ns;
+	uint64_t end_ns;
+};
+
+ingest_config config;
+std::vector<char> packet;
+
+void destroy_session(ingest_session& session)
+{
+	if (session.data) {
+		(void) relayd_close(session.data);
+		free(session.data);
+		session.data = nullptr;
+	}
+
+	if (session.control) {
+		(void) relayd_close(session.control);
+		free(session.control);
+		session.control = nullptr;
+	}
+
+	lttng_trace_chunk_put(session.chunk);
+	session.chunk = nullptr;
+}
+
+int connect_session(ingest_session& session)
+{
+	int ret;
+	ssize_t uri_count;
+	struct lttng_uri *uris = nullptr;
+	uint64_t relayd_session_id;
+	lttng_uuid uuid;
+	char url[256], name[LTTNG_NAME_MAX], hostname[LTTNG_HOST_NAME_MAX] = {};
+	char output_path[LTTNG_PATH_MAX] = {};
+	const time_t creation_time = time(nullptr);
+	const char *batch_size_env = getenv(DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE_ENV);
+	const char *batch_latency_env = getenv(DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY_ENV);
+
+	snprintf(url, sizeof(url), "net://%s", config.host);
+	uri_count = uri_parse_str_urls(url, nullptr, &uris);
+	if (uri_count != 2) {
+		fprintf(stderr, "Invalid relay daemon host: %s\n", config.host);
+		free(uris);
+		return -1;
+	}
+
+	session.control = lttcomm_alloc_relayd_sock(
+		&uris[0], RELAYD_VERSION_COMM_MAJOR, RELAYD_VERSION_COMM_MINOR);
+	session.data = lttcomm_alloc_relayd_sock(
+		&uris[1], RELAYD_VERSION_COMM_MAJOR, RELAYD_VERSION_COMM_MINOR);
+	free(uris);
+	if (!session.control || !session.data) {
+		return -1;
+	}
+
+	if (relayd_connect(session.control) < 0 || relayd_connect(session.data) < 0) {
+		fprintf(stderr, "Unable to reach the relay daemon at %s\n", config.host);
+		return -1;
+	}
+
+	ret = relayd_version_check(session.control);
+	if (ret || (session.control->major == 2 && session.control->minor < 11)) {
+		fprintf(stderr, "Incompatible relay daemon: trace chunks are not supported\n");
+		return -1;
+	}
+
+	session.data->major = session.control->major;
+	session.data->minor = session.control->minor;
+
+	ret = relayd_enable_index_batching(
+		session.control,
+		batch_size_env ? strtoul(batch_size_env, nullptr, 0) :
+				 DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_SIZE,
+		batch_latency_env ? strtoull(batch_latency_env, nullptr, 0) :
+				    DEFAULT_CONSUMERD_RELAYD_INDEX_BATCH_LATENCY);
+	if (ret) {
+		return -1;
+	}
+
+	if (gethostname(hostname, sizeof(hostname) - 1) || lttng_uuid_generate(uuid)) {
+		return -1;
+	}
+
+	snprintf(name, sizeof(name), "bench-ingest-%d-%u", (int) getpid(), session.index);
+	ret = relayd_create_session(session.control,
+				    &relayd_session_id,
+				    name,
+				    hostname,
+				    "",
+				    live_timer_us,
+				    0,
+				    session.index + 1,
+				    uuid,
+				    nullptr,
+				    creation_time,
+				    false,
+				    output_path);
+	if (ret < 0) {
+		fprintf(stderr, "Failed to create session %s\n", name);
+		return -1;
+	}
+
+	session.chunk = lttng_trace_chunk_create(0, creation_time, nullptr);
+	if (!session.chunk || relayd_create_trace_chunk(session.control, session.chunk) < 0) {
+		fprintf(stderr, "Failed to create the trace chunk of session %s\n", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+int add_streams(ingest_session& session)
+{
+	unsigned long i;
+
+	if (relayd_add_stream(session.control,
+			      DEFAULT_METADATA_NAME,
+			      "",
+			      "bench",
+			      &session.metadata_stream_id,
+			      0,
+			      0,
+			      session.chunk) < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < config.stream_count; i++) {
+		char name[LTTNG_SYMBOL_NAME_LEN];
+		ingest_stream stream = {};
+
+		snprintf(name, sizeof(name), "channel0_%lu", i);
+		if (relayd_add_stream(session.control,
+				      name,
+				      "",
+				      "bench",
+				      &stream.relayd_stream_id,
+				      0,
+				      0,
+				      session.chunk) < 0) {
+			return -1;
+		}
+
+		stream.idle = i < config.idle_stream_count;
+		try {
+			session.streams.push_back(stream);
+		} catch (const std::bad_alloc&) {
+			return -1;
+		}
+	}
+
+	return relayd_streams_sent(session.control);
+}
+
+int send_metadata(ingest_session& session)
+{
+	ssize_t send_ret;
+	struct lttcomm_relayd_metadata_payload header = {};
+	const size_t len = strlen(metadata);
+
+	if (relayd_send_metadata(session.control, sizeof(header) + len) < 0) {
+		return -1;
+	}
+
+	header.stream_id = htobe64(session.metadata_stream_id);
+	send_ret = session.control->sock.ops->sendmsg(
+		&session.control->sock, &header, sizeof(header), 0);
+	if (send_ret < (ssize_t) sizeof(header)) {
+		return -1;
+	}
+
+	send_ret = session.control->sock.ops->sendmsg(&session.control->sock, metadata, len, 0);
+	return send_ret < (ssize_t) len ? -1 : 0;
+}
+
+/* Send a packet of `stream` and its index, as the consumer daemon does. */
+int send_packet(ingest_session& session, ingest_stream& stream, unsigned int stream_index)
+{
+	ssize_t send_ret;
+	struct lttcomm_relayd_data_hdr header = {};
+	struct ctf_packet_index index = {};
+	const uint64_t timestamp = bench_relayd::now_ns();
+
+	header.stream_id = htobe64(stream.relayd_stream_id);
+	header.net_seq_num = htobe64(stream.next_net_seq_num);
+	header.data_size = htobe32((uint32_t) packet.size());
+	if (relayd_send_data_hdr(session.data, &header, sizeof(header)) < 0) {
+		return -1;
+	}
+
+	send_ret = session.data->sock.ops->sendmsg(
+		&session.data->sock, packet.data(), packet.size(), 0);
+	if (send_ret < (ssize_t) packet.size()) {
+		return -1;
+	}
+
+	index.packet_size = htobe64((uint64_t) packet.size() * CHAR_BIT);
+	index.content_size = index.packet_size;
+	index.timestamp_begin = htobe64(stream.last_timestamp ?: timestamp);
+	index.timestamp_end = htobe64(timestamp);
+	index.stream_id = htobe64(0);
+	index.stream_instance_id = htobe64(stream_index);
+	index.packet_seq_num = htobe64(stream.next_net_seq_num);
+	if (relayd_send_index(
+		    session.control, &index, stream.relayd_stream_id, stream.next_net_seq_num) <
+	    0) {
+		return -1;
+	}
+
+	stream.next_net_seq_num++;
+	stream.last_timestamp = timestamp;
+	return 0;
+}
+
+/*
+ * Send the live beacons of the idle streams of `session` in a single
+ * command, and the indexes batched so far, as the live timer of the consumer
+ * daemon does.
+ */
+int send_live_beacons(ingest_session& session)
+{
+	std::vector<relayd_stream_index> beacons;
+	const uint64_t timestamp = bench_relayd::now_ns();
+
+	for (unsigned int i = 0; i < session.streams.size(); i++) {
+		const ingest_stream& stream = session.streams[i];
+		relayd_stream_index beacon = {};
+
+		if (!stream.idle) {
+			continue;
+		}
+
+		beacon.relay_stream_id = stream.relayd_stream_id;
+		beacon.net_seq_num = stream.next_net_seq_num - 1;
+		beacon.index.timestamp_end = htobe64(timestamp);
+		beacon.index.stream_id = htobe64(0);
+		beacon.index.stream_instance_id = htobe64(i);
+		beacons.push_back(beacon);
+	}
+
+	if (!beacons.empty() &&
+	    relayd_send_indexes(session.control, beacons.size(), beacons.data()) < 0) {
+		return -1;
+	}
+
+	session.beacons += beacons.size();
+	return relayd_flush_indexes(session.control);
+}
+
+void sleep_until(uint64_t time_ns)
+{
+	struct timespec ts;
+
+	ts.tv_sec = time_ns / NSEC_PER_SEC;
+	ts.tv_nsec = time_ns % NSEC_PER_SEC;
+	(void) clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+}
+
+void *session_thread(void *data)
+{
+	ingest_session& session = *static_cast<ingest_session *>(data);
+	const unsigned long active_stream_count = config.stream_count - config.idle_stream_count;
+	const uint64_t packet_period_ns = config.packet_rate && active_stream_count ?
+		NSEC_PER_SEC / (config.packet_rate * active_stream_count) :
+		0;
+	uint64_t next_packet_ns = config.start_ns;
+	uint64_t next_beacon_ns = config.start_ns + live_timer_us * NSEC_PER_USEC;
+	unsigned int next_stream = config.idle_stream_count;
+
+	try {
+		while (true) {
+			const uint64_t now = bench_relayd::now_ns();
+
+			if (now >= config.end_ns) {
+				break;
+			}
+
+			if (now >= next_beacon_ns) {
+				if (send_live_beacons(session)) {
+					goto error;
+				}
+
+				next_beacon_ns += live_timer_us * NSEC_PER_USEC;
+				continue;
+			}
+
+			if (!active_stream_count || now < next_packet_ns) {
+				sleep_until(std::min(active_stream_count ? next_packet_ns : UINT64_MAX,
+						     std::min(next_beacon_ns, config.end_ns)));
+				continue;
+			}
+
+			if (send_packet(session, session.streams[next_stream], next_stream)) {
+				goto error;
+			}
+
+			session.latencies_ns.push_back(bench_relayd::now_ns() - now);
+			session.packets++;
+			session.bytes += packet.size();
+			next_packet_ns += packet_period_ns;
+			if (++next_stream == session.streams.size()) {
+				next_stream = config.idle_stream_count;
+			}
+		}
+	} catch (const std::bad_alloc&) {
+		goto error;
+	}
+
+	if (relayd_flush_indexes(session.control)) {
+		goto error;
+	}
+
+	for (const auto& stream : session.streams) {
+		if (relayd_send_close_stream(
+			    session.control, stream.relayd_stream_id, stream.next_net_seq_num - 1)) {
+			goto error;
+		}
+	}
+
+	if (relayd_send_close_stream(session.control, session.metadata_stream_id, 0)) {
+		goto error;
+	}
+
+	return nullptr;
+
+error:
+	fprintf(stderr, "Failed to send the data of session %u\n", session.index);
+	session.failed = true;
+	return nullptr;
+}
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	int ret = EXIT_FAILURE;
+	const unsigned long session_count = argc > 2 ? strtoul(argv[2], nullptr, 0) : 4;
+	const unsigned long duration = argc > 7 ? strtoul(argv[7], nullptr, 0) : 10;
+	const pid_t relayd_pid = argc > 8 ? (pid_t) strtol(argv[8], nullptr, 0) : 0;
+	std::vector<ingest_session> sessions;
+	uint64_t relayd_cpu_begin_ns, elapsed_ns, packets = 0, bytes = 0, beacons = 0;
+	std::vector<uint64_t> latencies_ns;
+	unsigned long i;
+
+	config.host = argc > 1 ? argv[1] : nullptr;
+	config.stream_count = argc > 3 ? strtoul(argv[3], nullptr, 0) : 4;
+	config.idle_stream_count = argc > 4 ? strtoul(argv[4], nullptr, 0) : 0;
+	config.packet_rate = argc > 5 ? strtoul(argv[5], nullptr, 0) : 100;
+	config.packet_size = argc > 6 ? strtoul(argv[6], nullptr, 0) : 65536;
+
+	if (!config.host || session_count == 0 || config.stream_count == 0 ||
+	    config.idle_stream_count > config.stream_count || config.packet_size == 0 ||
+	    config.packet_size > UINT32_MAX) {
+		fprintf(stderr,
+			"Usage: %s HOST [SESSIONS] [STREAMS] [IDLE_STREAMS] [PACKET_RATE] [PACKET_SIZE] [DURATION] [RELAYD_PID]\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		packet.assign(config.packet_size, 'x');
+		sessions.resize(session_count);
+	} catch (const std::bad_alloc&) {
+		fprintf(stderr, "Failed to allocate the sessions\n");
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < session_count; i++) {
+		sessions[i].index = i;
+		if (connect_session(sessions[i]) || add_streams(sessions[i]) ||
+		    send_metadata(sessions[i])) {
+			fprintf(stderr, "Failed to set up session %lu\n", i);
+			goto end;
+		}
+	}
+
+	relayd_cpu_begin_ns = bench_relayd::process_cpu_ns(relayd_pid);
+	config.start_ns = bench_relayd::now_ns();
+	config.end_ns = config.start_ns + duration * NSEC_PER_SEC;
+	for (i = 0; i < session_count; i++) {
+		if (pthread_create(&sessions[i].thread, nullptr, session_thread, &sessions[i])) {
+			fprintf(stderr, "Failed to create the thread of session %lu\n", i);
+			sessions[i].failed = true;
+			config.end_ns = 0;
+			break;
+		}
+	}
+
+	for (unsigned long j = 0; j < i; j++) {
+		(void) pthread_join(sessions[j].thread, nullptr);
+	}
+
+	if (i != session_count) {
+		goto end;
+	}
+
+	elapsed_ns = bench_relayd::now_ns() - config.start_ns;
+	try {
+		for (auto& session : sessions) {
+			if (session.failed) {
+				goto end;
+			}
+
+			packets += session.packets;
+			bytes += session.bytes;
+			beacons += session.beacons;
+			latencies_ns.insert(latencies_ns.end(),
+					    session.latencies_ns.begin(),
+					    session.latencies_ns.end());
+		}
+	} catch (const std::bad_alloc&) {
+		goto end;
+	}
+
+	printf("%lu session(s) of %lu stream(s), %lu idle, %lu packets/s of %lu bytes per stream, to %s\n",
+	       session_count,
+	       config.stream_count,
+	       config.idle_stream_count,
+	       config.packet_rate,
+	       config.packet_size,
+	       config.host);
+	printf("throughput: %.2f MB/s, %.0f packets/s, %" PRIu64 " live beacons\n",
+	       (double) bytes / ((double) elapsed_ns / NSEC_PER_SEC) / 1e6,
+	       (double) packets / ((double) elapsed_ns / NSEC_PER_SEC),
+	       beacons);
+	bench_relayd::print_latency("packet and index send", latencies_ns);
+	bench_relayd::print_relayd_cpu(relayd_pid, relayd_cpu_begin_ns, bytes);
+	ret = EXIT_SUCCESS;
+
+end:
+	for (auto& session : sessions) {
+		destroy_session(session);
+	}
+
+	return ret;
+}
@@ -0,0 +1,576 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Replay the live sessions of the relay daemon at HOST to VIEWERS synthetic
+ * live viewers, one per session as the relay daemon allows, for at most
+ * DURATION seconds or until their sessions are destroyed.
+ *
+ * Each viewer attaches to a live session which has no viewer yet and gets the
+ * packets of its streams with GET_NEXT_INDEX and GET_PACKET, as the live
+ * viewers do, and their metadata and new streams when flagged. Once none of
+ * its streams has a new packet, a viewer retries after a millisecond.
+ *
+ * Reports the throughput, the latency of getting the index and the data of a
+ * packet and, given the PID of the relay daemon, its CPU time per GB sent.
+ * The delivery latency of the packets, from the end timestamp of their index
+ * to their reception, is only meaningful for the sessions of
+ * bench_relayd_ingest running on the same host.
+ *
+ * Usage: bench_relayd_live HOST [VIEWERS] [DURATION] [RELAYD_PID]
+ */
+
+#include "bench_relayd.hpp"
+
+#include <common/common.hpp>
+#include <common/compat/endian.hpp>
+#include <common/defaults.hpp>
+
+#include <bin/lttng-relayd/lttng-viewer-abi.hpp>
+#include <algorithm>
+#include <errno.h>
+#include <inttypes.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+const useconds_t retry_delay_us = 1000;
+
+struct live_stream {
+	uint64_t id;
+	bool metadata;
+	bool hup;
+};
+
+struct live_viewer {
+	pthread_t thread;
+	uint64_t session_id;
+	int fd = -1;
+	std::vector<live_stream> streams;
+	std::vector<char> buffer;
+	/* Time to get the index and the data of a packet. */
+	std::vector<uint64_t> latencies_ns;
+	/* Time from the end timestamp of the index of a packet to its reception. */
+	std::vector<uint64_t> delivery_latencies_ns;
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t retries;
+	uint64_t inactive;
+	bool failed;
+};
+
+const char *host;
+uint64_t end_ns;
+
+ssize_t live_recv(int fd, void *buf, size_t len)
+{
+	ssize_t ret;
+	size_t copied = 0;
+
+	do {
+		ret = recv(fd, (char *) buf + copied, len - copied, 0);
+		if (ret > 0) {
+			copied += ret;
+		}
+	} while ((ret > 0 && copied < len) || (ret < 0 && errno == EINTR));
+
+	return ret > 0 ? (ssize_t) copied : -1;
+}
+
+/* Send the header of command `cmd` and its payload in a single message. */
+int live_send_command(int fd, enum lttng_viewer_command cmd, const void *payload, size_t len)
+{
+	char message[sizeof(struct lttng_viewer_cmd) + 64];
+	struct lttng_viewer_cmd header;
+	ssize_t ret;
+
+	LTTNG_ASSERT(len <= sizeof(message) - sizeof(header));
+
+	header.cmd = htobe32(cmd);
+	header.data_size = htobe64(len);
+	header.cmd_version = htobe32(0);
+	memcpy(message, &header, sizeof(header));
+	if (len) {
+		memcpy(message + sizeof(header), payload, len);
+	}
+
+	do {
+		ret = send(fd, message, sizeof(header) + len, MSG_NOSIGNAL);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret == (ssize_t) (sizeof(header) + len) ? 0 : -1;
+}
+
+int live_connect()
+{
+	int fd = -1, one = 1;
+	char port[16];
+	struct addrinfo hints = {}, *result = nullptr;
+	struct lttng_viewer_connect connect_request = {};
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(port, sizeof(port), "%d", DEFAULT_NETWORK_VIEWER_PORT);
+	if (getaddrinfo(host, port, &hints, &result)) {
+		fprintf(stderr, "Failed to resolve %s\n", host);
+		return -1;
+	}
+
+	fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (fd < 0 || connect(fd, result->ai_addr, result->ai_addrlen) ||
+	    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one))) {
+		fprintf(stderr, "Unable to reach the live port of %s\n", host);
+		goto error;
+	}
+
+	connect_request.major = htobe32(VERSION_MAJOR);
+	connect_request.minor = htobe32(VERSION_MINOR);
+	connect_request.type = htobe32(LTTNG_VIEWER_CLIENT_COMMAND);
+	if (live_send_command(fd, LTTNG_VIEWER_CONNECT, &connect_request, sizeof(connect_request)) ||
+	    live_recv(fd, &connect_request, sizeof(connect_request)) < 0) {
+		goto error;
+	}
+
+	freeaddrinfo(result);
+	return fd;
+
+error:
+	if (fd >= 0) {
+		close(fd);
+	}
+
+	freeaddrinfo(result);
+	return -1;
+}
+
+/* Get the IDs of the live sessions which have streams and no viewer. */
+int list_sessions(int fd, std::vector<uint64_t>& session_ids)
+{
+	struct lttng_viewer_list_sessions list;
+
+	if (live_send_command(fd, LTTNG_VIEWER_LIST_SESSIONS, nullptr, 0) ||
+	    live_recv(fd, &list, sizeof(list)) < 0) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < be32toh(list.sessions_count); i++) {
+		struct lttng_viewer_session session;
+
+		if (live_recv(fd, &session, sizeof(session)) < 0) {
+			return -1;
+		}
+
+		if (session.live_timer && session.streams && !session.clients) {
+			session_ids.push_back(be64toh(session.id));
+		}
+	}
+
+	return 0;
+}
+
+int recv_streams(live_viewer& viewer, uint32_t stream_count)
+{
+	for (uint32_t i = 0; i < stream_count; i++) {
+		struct lttng_viewer_stream stream;
+
+		if (live_recv(viewer.fd, &stream, sizeof(stream)) < 0) {
+			return -1;
+		}
+
+		viewer.streams.push_back(
+			{ be64toh(stream.id), be32toh(stream.metadata_flag) != 0, false });
+	}
+
+	return 0;
+}
+
+int attach_session(live_viewer& viewer)
+{
+	struct lttng_viewer_create_session_response create_response;
+	struct lttng_viewer_attach_session_request request = {};
+	struct lttng_viewer_attach_session_response response;
+
+	if (live_send_command(viewer.fd, LTTNG_VIEWER_CREATE_SESSION, nullptr, 0) ||
+	    live_recv(viewer.fd, &create_response, sizeof(create_response)) < 0 ||
+	    be32toh(create_response.status) != LTTNG_VIEWER_CREATE_SESSION_OK) {
+		return -1;
+	}
+
+	request.session_id = htobe64(viewer.session_id);
+	request.seek = htobe32(LTTNG_VIEWER_SEEK_BEGINNING);
+	if (live_send_command(viewer.fd, LTTNG_VIEWER_ATTACH_SESSION, &request, sizeof(request)) ||
+	    live_recv(viewer.fd, &response, sizeof(response)) < 0 ||
+	    be32toh(response.status) != LTTNG_VIEWER_ATTACH_OK) {
+		fprintf(stderr, "Failed to attach to session %" PRIu64 "\n", viewer.session_id);
+		return -1;
+	}
+
+	return recv_streams(viewer, be32toh(response.streams_count));
+}
+
+/* Get the metadata of the session until the relay daemon has no more. */
+int get_metadata(live_viewer& viewer)
+{
+	for (const auto& stream : viewer.streams) {
+		struct lttng_viewer_get_metadata request;
+
+		if (!stream.metadata) {
+			continue;
+		}
+
+		request.stream_id = htobe64(stream.id);
+		while (true) {
+			struct lttng_viewer_metadata_packet response;
+			uint64_t len;
+
+			if (live_send_command(viewer.fd,
+					      LTTNG_VIEWER_GET_METADATA,
+					      &request,
+					      sizeof(request)) ||
+			    live_recv(viewer.fd, &response, sizeof(response)) < 0) {
+				return -1;
+			}
+
+			if (be32toh(response.status) == LTTNG_VIEWER_NO_NEW_METADATA) {
+				break;
+			} else if (be32toh(response.status) != LTTNG_VIEWER_METADATA_OK) {
+				return -1;
+			}
+
+			len = be64toh(response.len);
+			viewer.buffer.resize(std::max<size_t>(viewer.buffer.size(), len));
+			if (len && live_recv(viewer.fd, viewer.buffer.data(), len) < 0) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int get_new_streams(live_viewer& viewer)
+{
+	struct lttng_viewer_new_streams_request request;
+	struct lttng_viewer_new_streams_response response;
+
+	request.session_id = htobe64(viewer.session_id);
+	if (live_send_command(viewer.fd, LTTNG_VIEWER_GET_NEW_STREAMS, &request, sizeof(request)) ||
+	    live_recv(viewer.fd, &response, sizeof(response)) < 0) {
+		return -1;
+	}
+
+	switch (be32toh(response.status)) {
+	case LTTNG_VIEWER_NEW_STREAMS_OK:
+		return recv_streams(viewer, be32toh(response.streams_count));
+	case LTTNG_VIEWER_NEW_STREAMS_NO_NEW:
+	case LTTNG_VIEWER_NEW_STREAMS_HUP:
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int handle_flags(live_viewer& viewer, uint32_t flags)
+{
+	if ((flags & LTTNG_VIEWER_FLAG_NEW_METADATA) && get_metadata(viewer)) {
+		return -1;
+	}
+
+	if ((flags & LTTNG_VIEWER_FLAG_NEW_STREAM) && get_new_streams(viewer)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Get the next packet of the stream at `stream_index`, setting `received`
+ * if there was one.
+ */
+int get_next_packet(live_viewer& viewer, size_t stream_index, bool *received)
+{
+	const uint64_t begin_ns = bench_relayd::now_ns();
+	struct lttng_viewer_get_next_index index_request = {};
+	struct lttng_viewer_index index;
+	struct lttng_viewer_get_packet packet_request = {};
+	uint32_t len;
+
+	*received = false;
+	index_request.stream_id = htobe64(viewer.streams[stream_index].id);
+	if (live_send_command(viewer.fd,
+			      LTTNG_VIEWER_GET_NEXT_INDEX,
+			      &index_request,
+			      sizeof(index_request)) ||
+	    live_recv(viewer.fd, &index, sizeof(index)) < 0) {
+		return -1;
+	}
+
+	if (handle_flags(viewer, be32toh(index.flags))) {
+		return -1;
+	}
+
+	switch (be32toh(index.status)) {
+	case LTTNG_VIEWER_INDEX_OK:
+		break;
+	case LTTNG_VIEWER_INDEX_RETRY:
+		viewer.retries++;
+		return 0;
+	case LTTNG_VIEWER_INDEX_INACTIVE:
+		viewer.inactive++;
+		return 0;
+	case LTTNG_VIEWER_INDEX_HUP:
+		viewer.streams[stream_index].hup = true;
+		return 0;
+	default:
+		return -1;
+	}
+
+	packet_request.stream_id = index_request.stream_id;
+	/* Already in big endian. */
+	packet_request.offset = index.offset;
+	packet_request.len = htobe32((uint32_t) (be64toh(index.packet_size) / CHAR_BIT));
+
+	while (true) {
+		struct lttng_viewer_trace_packet response;
+
+		if (live_send_command(viewer.fd,
+				      LTTNG_VIEWER_GET_PACKET,
+				      &packet_request,
+				      sizeof(packet_request)) ||
+		    live_recv(viewer.fd, &response, sizeof(response)) < 0) {
+			return -1;
+		}
+
+		switch (be32toh(response.status)) {
+		case LTTNG_VIEWER_GET_PACKET_OK:
+			len = be32toh(response.len);
+			break;
+		case LTTNG_VIEWER_GET_PACKET_ERR:
+			if (!(be32toh(response.flags) &
+			      (LTTNG_VIEWER_FLAG_NEW_METADATA | LTTNG_VIEWER_FLAG_NEW_STREAM))) {
+				return -1;
+			}
+
+			/* Get the new metadata or streams first, then the packet again. */
+			if (handle_flags(viewer, be32toh(response.flags))) {
+				return -1;
+			}
+
+			continue;
+		default:
+			return -1;
+		}
+
+		break;
+	}
+
+	viewer.buffer.resize(std::max<size_t>(viewer.buffer.size(), len));
+	if (live_recv(viewer.fd, viewer.buffer.data(), len) < 0) {
+		return -1;
+	}
+
+	const uint64_t received_ns = bench_relayd::now_ns();
+
+	viewer.latencies_ns.push_back(received_ns - begin_ns);
+	if (be64toh(index.timestamp_end) <= received_ns) {
+		viewer.delivery_latencies_ns.push_back(received_ns -
+							be64toh(index.timestamp_end));
+	}
+
+	viewer.packets++;
+	viewer.bytes += len;
+	*received = true;
+	return 0;
+}
+
+void *viewer_thread(void *data)
+{
+	live_viewer& viewer = *static_cast<live_viewer *>(data);
+
+	try {
+		if (attach_session(viewer) || get_metadata(viewer)) {
+			goto error;
+		}
+
+		while (bench_relayd::now_ns() < end_ns) {
+			bool active = false, received_any = false;
+
+			/* New streams may be appended while iterating. */
+			for (size_t i = 0; i < viewer.streams.size(); i++) {
+				bool received;
+
+				if (viewer.streams[i].metadata || viewer.streams[i].hup) {
+					continue;
+				}
+
+				active = true;
+				if (get_next_packet(viewer, i, &received)) {
+					goto error;
+				}
+
+				received_any |= received;
+			}
+
+			if (!active) {
+				break;
+			}
+
+			if (!received_any) {
+				usleep(retry_delay_us);
+			}
+		}
+	} catch (const std::bad_alloc&) {
+		goto error;
+	}
+
+	return nullptr;
+
+error:
+	fprintf(stderr, "Viewer of session %" PRIu64 " failed\n", viewer.session_id);
+	viewer.failed = true;
+	return nullptr;
+}
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	int ret = EXIT_FAILURE, list_fd;
+	unsigned long viewer_count = argc > 2 ? strtoul(argv[2], nullptr, 0) : 0;
+	const unsigned long duration = argc > 3 ? strtoul(argv[3], nullptr, 0) : 10;
+	const pid_t relayd_pid = argc > 4 ? (pid_t) strtol(argv[4], nullptr, 0) : 0;
+	std::vector<uint64_t> session_ids, latencies_ns, delivery_latencies_ns;
+	std::vector<live_viewer> viewers;
+	uint64_t relayd_cpu_begin_ns, start_ns, elapsed_ns;
+	uint64_t packets = 0, bytes = 0, retries = 0, inactive = 0;
+	unsigned long i, started = 0;
+
+	host = argc > 1 ? argv[1] : nullptr;
+	if (!host) {
+		fprintf(stderr, "Usage: %s HOST [VIEWERS] [DURATION] [RELAYD_PID]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	list_fd = live_connect();
+	if (list_fd < 0) {
+		return EXIT_FAILURE;
+	}
+
+	try {
+		if (list_sessions(list_fd, session_ids)) {
+			fprintf(stderr, "Failed to list the sessions of %s\n", host);
+			close(list_fd);
+			return EXIT_FAILURE;
+		}
+	} catch (const std::bad_alloc&) {
+		close(list_fd);
+		return EXIT_FAILURE;
+	}
+
+	close(list_fd);
+	if (viewer_count == 0 || viewer_count > session_ids.size()) {
+		viewer_count = session_ids.size();
+	}
+
+	if (viewer_count == 0) {
+		fprintf(stderr, "No live session without a viewer on %s\n", host);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		viewers.resize(viewer_count);
+	} catch (const std::bad_alloc&) {
+		return EXIT_FAILURE;
+	}
+
+	relayd_cpu_begin_ns = bench_relayd::process_cpu_ns(relayd_pid);
+	start_ns = bench_relayd::now_ns();
+	end_ns = start_ns + duration * NSEC_PER_SEC;
+	for (i = 0; i < viewer_count; i++) {
+		viewers[i].session_id = session_ids[i];
+		viewers[i].fd = live_connect();
+		if (viewers[i].fd < 0) {
+			break;
+		}
+
+		if (pthread_create(&viewers[i].thread, nullptr, viewer_thread, &viewers[i])) {
+			fprintf(stderr, "Failed to create the thread of viewer %lu\n", i);
+			break;
+		}
+
+		started++;
+	}
+
+	if (started != viewer_count) {
+		/* Stop the viewers already started. */
+		end_ns = 0;
+	}
+
+	for (i = 0; i < started; i++) {
+		(void) pthread_join(viewers[i].thread, nullptr);
+	}
+
+	elapsed_ns = bench_relayd::now_ns() - start_ns;
+	if (started != viewer_count) {
+		goto end;
+	}
+
+	try {
+		for (const auto& viewer : viewers) {
+			if (viewer.failed) {
+				goto end;
+			}
+
+			packets += viewer.packets;
+			bytes += viewer.bytes;
+			retries += viewer.retries;
+			inactive += viewer.inactive;
+			latencies_ns.insert(latencies_ns.end(),
+					    viewer.latencies_ns.begin(),
+					    viewer.latencies_ns.end());
+			delivery_latencies_ns.insert(delivery_latencies_ns.end(),
+						     viewer.delivery_latencies_ns.begin(),
+						     viewer.delivery_latencies_ns.end());
+		}
+	} catch (const std::bad_alloc&) {
+		goto end;
+	}
+
+	printf("%lu viewer(s) of %s\n", viewer_count, host);
+	printf("throughput: %.2f MB/s, %.0f packets/s, %" PRIu64 " index retries, %" PRIu64
+	       " inactive streams\n",
+	       (double) bytes / ((double) elapsed_ns / NSEC_PER_SEC) / 1e6,
+	       (double) packets / ((double) elapsed_ns / NSEC_PER_SEC),
+	       retries,
+	       inactive);
+	bench_relayd::print_latency("index and packet get", latencies_ns);
+	bench_relayd::print_latency("packet delivery", delivery_latencies_ns);
+	bench_relayd::print_relayd_cpu(relayd_pid, relayd_cpu_begin_ns, bytes);
+	ret = EXIT_SUCCESS;
+
+end:
+	for (auto& viewer : viewers) {
+		if (viewer.fd >= 0) {
+			close(viewer.fd);
+		}
+	}
+
+	return ret;
+}
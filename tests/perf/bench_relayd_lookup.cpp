@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Compare the per-packet cost of finding the relayd of a stream on the
+ * consumer data path: looking it up by network sequence index in the relayd
+ * hash table, as the data path used to for every sub-buffer, against reading
+ * the relayd reference cached in the stream.
+ *
+ * Usage: bench_relayd_lookup [PACKETS] [RELAYDS]
+ */
+
+#include <common/hashtable/hashtable.hpp>
+#include <common/macros.hpp>
+#include <common/time.hpp>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <urcu.h>
+#include <urcu/uatomic.h>
+#include <vector>
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+const unsigned int streams_per_relayd = 8;
+
+/* Fields of consumer_relayd_sock_pair and lttng_consumer_stream involved. */
+struct bench_relayd {
+	uint64_t net_seq_idx;
+	unsigned int destroyed;
+	struct lttng_ht_node_u64 node;
+};
+
+struct bench_stream {
+	uint64_t net_seq_idx;
+	struct bench_relayd *relayd;
+};
+
+uint64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+struct bench_relayd *lookup_relayd(struct lttng_ht *ht, const struct bench_stream& stream)
+{
+	struct lttng_ht_iter iter;
+	struct lttng_ht_node_u64 *node;
+
+	lttng_ht_lookup(ht, &stream.net_seq_idx, &iter);
+	node = lttng_ht_iter_get_node_u64(&iter);
+	return node ? lttng::utils::container_of(node, &bench_relayd::node) : nullptr;
+}
+
+struct bench_relayd *cached_relayd(const struct bench_stream& stream)
+{
+	return uatomic_read(&stream.relayd->destroyed) ? nullptr : stream.relayd;
+}
+
+template <typename FindRelayd>
+double bench(const std::vector<bench_stream>& streams,
+	     unsigned long packets,
+	     FindRelayd find_relayd)
+{
+	uint64_t found = 0;
+	const uint64_t start = now_ns();
+
+	for (unsigned long i = 0; i < packets; i++) {
+		/* The data path holds the RCU read-side lock for each sub-buffer. */
+		rcu_read_lock();
+		found += find_relayd(streams[i % streams.size()]) != nullptr;
+		rcu_read_unlock();
+	}
+
+	if (found != packets) {
+		fprintf(stderr, "Failed to find the relayd of %" PRIu64 " packets\n", packets - found);
+		exit(EXIT_FAILURE);
+	}
+
+	return (double) (now_ns() - start) / packets;
+}
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	const unsigned long packets = argc > 1 ? strtoul(argv[1], nullptr, 0) : 10000000;
+	const unsigned long relayd_count = argc > 2 ? strtoul(argv[2], nullptr, 0) : 4;
+	std::vector<bench_relayd> relayds(relayd_count);
+	std::vector<bench_stream> streams;
+	struct lttng_ht *ht;
+
+	if (!packets || !relayd_count) {
+		fprintf(stderr, "Usage: %s [PACKETS] [RELAYDS]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	rcu_register_thread();
+	ht = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
+	if (!ht) {
+		fprintf(stderr, "Failed to allocate relayd hash table\n");
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned long i = 0; i < relayd_count; i++) {
+		relayds[i].net_seq_idx = i;
+		relayds[i].destroyed = 0;
+		lttng_ht_node_init_u64(&relayds[i].node, i);
+		lttng_ht_add_unique_u64(ht, &relayds[i].node);
+
+		for (unsigned int j = 0; j < streams_per_relayd; j++) {
+			streams.push_back({ i, &relayds[i] });
+		}
+	}
+
+	printf("%lu packets over %zu streams of %lu relayd(s)\n",
+	       packets,
+	       streams.size(),
+	       relayd_count);
+	printf("hash table lookup: %.2f ns/packet\n",
+	       bench(streams, packets, [ht](const bench_stream& stream) {
+		       return lookup_relayd(ht, stream);
+	       }));
+	printf("cached reference:  %.2f ns/packet\n", bench(streams, packets, cached_relayd));
+
+	for (auto& relayd : relayds) {
+		struct lttng_ht_iter iter;
+
+		iter.iter.node = &relayd.node.node;
+		(void) lttng_ht_del(ht, &iter);
+	}
+
+	lttng_ht_destroy(ht);
+	rcu_unregister_thread();
+	return EXIT_SUCCESS;
+}
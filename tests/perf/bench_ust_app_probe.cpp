@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+/*
+ * Minimal instrumented application of bench_sessiond_apps: the constructor of
+ * liblttng-ust registers it to the session daemon before main() runs, waiting
+ * for the registration to complete as long as LTTNG_UST_REGISTER_TIMEOUT
+ * allows.
+ *
+ * Prints the time elapsed since SPAWN_TIME_US, the CLOCK_REALTIME timestamp
+ * taken by the caller before spawning it (bash's EPOCHREALTIME without the
+ * decimal point), in microseconds. Then stays registered until its standard
+ * input is closed.
+ *
+ * Usage: bench_ust_app_probe SPAWN_TIME_US
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+	struct timespec ts;
+	uint64_t now_us, spawn_us;
+	char buf[64];
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	now_us = (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s SPAWN_TIME_US\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	spawn_us = strtoull(argv[1], nullptr, 10);
+	printf("%" PRIu64 "\n", now_us > spawn_us ? now_us - spawn_us : 0);
+	fflush(stdout);
+
+	while (read(STDIN_FILENO, buf, sizeof(buf)) > 0) {
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -34,7 +34,7 @@
 #define LIVE_TIMER 2000000
 
 /* Number of TAP tests in this file */
-#define NUM_TESTS 11
+#define NUM_TESTS 21
 #define mmap_size 524288
 
 #ifdef HAVE_LIBLTTNG_UST_CTL
@@ -229,6 +229,65 @@ error:
 	return -1;
 }
 
+/*
+ * Send a list_sessions_filtered request for the live sessions changed since
+ * `since_generation`, setting the generation and the flags of the reply.
+ *
+ * Returns the number of sessions listed, or -1 on error.
+ */
+static int list_sessions_filtered(uint64_t since_generation, uint64_t *generation, uint32_t *flags)
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_list_sessions_filtered_request rq;
+	struct lttng_viewer_list_sessions_filtered_response rp;
+	struct lttng_viewer_session lsession;
+	uint64_t closed_id;
+	ssize_t ret_len;
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_LIST_SESSIONS_FILTERED);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+
+	memset(&rq, 0, sizeof(rq));
+	rq.since_generation = htobe64(since_generation);
+	rq.flags = htobe32(LTTNG_VIEWER_LIST_SESSIONS_FLAG_LIVE_ONLY);
+
+	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+	if (ret_len < 0) {
+		diag("[error] Error sending cmd");
+		return -1;
+	}
+	ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+	if (ret_len < 0) {
+		diag("[error] Error sending list sessions filtered request");
+		return -1;
+	}
+	ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+	if (ret_len <= 0) {
+		diag("[error] Error receiving list sessions filtered reply");
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < be32toh(rp.sessions_count); i++) {
+		ret_len = lttng_live_recv(control_sock, &lsession, sizeof(lsession));
+		if (ret_len <= 0) {
+			diag("[error] Error receiving session");
+			return -1;
+		}
+	}
+	for (uint32_t i = 0; i < be32toh(rp.closed_count); i++) {
+		ret_len = lttng_live_recv(control_sock, &closed_id, sizeof(closed_id));
+		if (ret_len <= 0) {
+			diag("[error] Error receiving closed session id");
+			return -1;
+		}
+	}
+
+	*generation = be64toh(rp.generation);
+	*flags = be32toh(rp.flags);
+	return be32toh(rp.sessions_count);
+}
+
 static int create_viewer_session()
 {
 	struct lttng_viewer_cmd cmd;
@@ -267,7 +326,47 @@ error:
 	return -1;
 }
 
-static int attach_session(uint64_t id)
+static int set_channel_filter(const char *channels)
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_set_channel_filter_request rq;
+	struct lttng_viewer_set_channel_filter_response rp;
+	ssize_t ret_len;
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_SET_CHANNEL_FILTER);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+
+	memset(&rq, 0, sizeof(rq));
+	if (lttng_strncpy(rq.channels, channels, sizeof(rq.channels))) {
+		diag("[error] Channel filter too long");
+		return -1;
+	}
+
+	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+	if (ret_len < 0) {
+		diag("[error] Error sending cmd");
+		return -1;
+	}
+	ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+	if (ret_len < 0) {
+		diag("[error] Error sending set channel filter request");
+		return -1;
+	}
+	ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+	if (ret_len <= 0) {
+		diag("[error] Error receiving set channel filter reply");
+		return -1;
+	}
+
+	if (be32toh(rp.status) != LTTNG_VIEWER_SET_CHANNEL_FILTER_OK) {
+		diag("[error] Error setting channel filter");
+		return -1;
+	}
+	return 0;
+}
+
+static int attach_session(uint64_t id, enum lttng_viewer_seek seek, uint64_t timestamp)
 {
 	struct lttng_viewer_cmd cmd;
 	struct lttng_viewer_attach_session_request rq;
@@ -287,7 +386,8 @@ static int attach_session(uint64_t id)
 
 	memset(&rq, 0, sizeof(rq));
 	rq.session_id = htobe64(id);
-	rq.seek = htobe32(LTTNG_VIEWER_SEEK_BEGINNING);
+	rq.offset = htobe64(timestamp);
+	rq.seek = htobe32(seek);
 
 	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
 	if (ret_len < 0) {
@@ -537,6 +637,70 @@ error:
 	return -1;
 }
 
+/*
+ * Returns the number of data streams whose next index ends before
+ * `timestamp`.
+ */
+static int check_next_index_after(uint64_t timestamp)
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_get_next_index rq;
+	struct lttng_viewer_index rp;
+	ssize_t ret_len;
+	int id, early_count = 0;
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_GET_NEXT_INDEX);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+
+	for (id = 0; id < session->stream_count; id++) {
+		if (session->streams[id].metadata_flag) {
+			continue;
+		}
+		memset(&rq, 0, sizeof(rq));
+		rq.stream_id = htobe64(session->streams[id].id);
+
+		ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+		if (ret_len < 0) {
+			diag("Error sending cmd");
+			goto error;
+		}
+		ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+		if (ret_len < 0) {
+			diag("Error sending get_next_index request");
+			goto error;
+		}
+		ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+		if (ret_len <= 0) {
+			diag("Error receiving index response");
+			goto error;
+		}
+
+		switch (be32toh(rp.status)) {
+		case LTTNG_VIEWER_INDEX_OK:
+			break;
+		case LTTNG_VIEWER_INDEX_ERR:
+			diag("Got LTTNG_VIEWER_INDEX_ERR");
+			goto error;
+		default:
+			/* No packet after the timestamp yet. */
+			continue;
+		}
+
+		if (be64toh(rp.timestamp_end) < timestamp) {
+			diag("Stream %d: next packet ends at %" PRIu64 ", before %" PRIu64,
+			     id,
+			     (uint64_t) be64toh(rp.timestamp_end),
+			     timestamp);
+			early_count++;
+		}
+	}
+	return early_count;
+
+error:
+	return -1;
+}
+
 static int get_data_packet(int id, uint64_t offset, uint64_t len)
 {
 	struct lttng_viewer_cmd cmd;
@@ -618,6 +782,226 @@ error:
 	return -1;
 }
 
+/*
+ * Returns the number of indexes received, one per data stream.
+ */
+static int get_next_indexes(uint64_t id)
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_get_next_indexes rq;
+	struct lttng_viewer_next_indexes_response resp;
+	struct lttng_viewer_index rp;
+	ssize_t ret_len;
+	uint32_t indexes_count, data_stream_count = 0;
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_GET_NEXT_INDEXES);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+
+	memset(&rq, 0, sizeof(rq));
+	rq.session_id = htobe64(id);
+
+	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+	if (ret_len < 0) {
+		diag("Error sending cmd");
+		goto error;
+	}
+	ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+	if (ret_len < 0) {
+		diag("Error sending get_next_indexes request");
+		goto error;
+	}
+	ret_len = lttng_live_recv(control_sock, &resp, sizeof(resp));
+	if (ret_len <= 0) {
+		diag("Error receiving next indexes response");
+		goto error;
+	}
+
+	if (be32toh(resp.status) != LTTNG_VIEWER_GET_NEXT_INDEXES_OK) {
+		diag("Got status %u during LTTNG_VIEWER_GET_NEXT_INDEXES", be32toh(resp.status));
+		goto error;
+	}
+
+	indexes_count = be32toh(resp.indexes_count);
+	for (uint32_t i = 0; i < indexes_count; i++) {
+		ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+		if (ret_len <= 0) {
+			diag("Error receiving index %u", i);
+			goto error;
+		}
+
+		if (be32toh(rp.status) == LTTNG_VIEWER_INDEX_ERR) {
+			diag("Got LTTNG_VIEWER_INDEX_ERR for index %u", i);
+			goto error;
+		}
+	}
+
+	for (uint64_t i = 0; i < session->stream_count; i++) {
+		if (!session->streams[i].metadata_flag) {
+			data_stream_count++;
+		}
+	}
+
+	if (indexes_count != data_stream_count) {
+		diag("Got %u indexes for %u data streams", indexes_count, data_stream_count);
+		goto error;
+	}
+
+	return (int) indexes_count;
+
+error:
+	return -1;
+}
+
+/*
+ * Returns the status of the next index of the first data stream, waited
+ * for at most 100 ms.
+ */
+static int wait_next_index()
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_wait_next_index rq;
+	struct lttng_viewer_index rp;
+	ssize_t ret_len;
+	uint64_t id;
+
+	for (id = 0; id < session->stream_count; id++) {
+		if (!session->streams[id].metadata_flag) {
+			break;
+		}
+	}
+
+	if (id == session->stream_count) {
+		diag("No data stream to wait for");
+		goto error;
+	}
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_WAIT_NEXT_INDEX);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+
+	memset(&rq, 0, sizeof(rq));
+	rq.stream_id = htobe64(session->streams[id].id);
+	rq.timeout_ms = htobe32(100);
+
+	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+	if (ret_len < 0) {
+		diag("Error sending cmd");
+		goto error;
+	}
+	ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+	if (ret_len < 0) {
+		diag("Error sending wait_next_index request");
+		goto error;
+	}
+	ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+	if (ret_len <= 0) {
+		diag("Error receiving index response");
+		goto error;
+	}
+
+	if (be32toh(rp.status) == LTTNG_VIEWER_INDEX_ERR) {
+		diag("Got LTTNG_VIEWER_INDEX_ERR");
+		goto error;
+	}
+
+	return (int) be32toh(rp.status);
+
+error:
+	return -1;
+}
+
+/*
+ * Returns the count of next indexes of the first data stream received with
+ * their packets.
+ */
+static int get_next_packets()
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_get_next_packets rq;
+	struct lttng_viewer_next_packets_response rp;
+	char *packet = nullptr;
+	ssize_t ret_len;
+	uint32_t count, i;
+	uint64_t id;
+
+	for (id = 0; id < session->stream_count; id++) {
+		if (!session->streams[id].metadata_flag) {
+			break;
+		}
+	}
+
+	if (id == session->stream_count) {
+		diag("No data stream to get packets from");
+		goto error;
+	}
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_GET_NEXT_PACKETS);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+
+	memset(&rq, 0, sizeof(rq));
+	rq.stream_id = htobe64(session->streams[id].id);
+	rq.max_packets = htobe32(4);
+
+	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+	if (ret_len < 0) {
+		diag("Error sending cmd");
+		goto error;
+	}
+	ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+	if (ret_len < 0) {
+		diag("Error sending get_next_packets request");
+		goto error;
+	}
+	ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+	if (ret_len <= 0) {
+		diag("Error receiving next packets response");
+		goto error;
+	}
+
+	count = be32toh(rp.packets_count);
+	for (i = 0; i < count; i++) {
+		struct lttng_viewer_index index;
+		uint64_t len;
+
+		ret_len = lttng_live_recv(control_sock, &index, sizeof(index));
+		if (ret_len <= 0) {
+			diag("Error receiving index response");
+			goto error;
+		}
+
+		if (be32toh(index.status) == LTTNG_VIEWER_INDEX_ERR) {
+			diag("Got LTTNG_VIEWER_INDEX_ERR");
+			goto error;
+		} else if (be32toh(index.status) != LTTNG_VIEWER_INDEX_OK) {
+			continue;
+		}
+
+		len = be64toh(index.packet_size) / CHAR_BIT;
+		packet = calloc<char>(len);
+		if (!packet) {
+			PERROR("relay data zmalloc");
+			goto error;
+		}
+
+		ret_len = lttng_live_recv(control_sock, packet, len);
+		if (ret_len <= 0) {
+			diag("Error receiving trace packet");
+			goto error;
+		}
+
+		free(packet);
+		packet = nullptr;
+	}
+
+	return (int) count;
+
+error:
+	free(packet);
+	return -1;
+}
+
 static int detach_viewer_session(uint64_t id)
 {
 	struct lttng_viewer_cmd cmd;
@@ -665,10 +1049,164 @@ error:
 	return ret;
 }
 
+/*
+ * Request the metadata which wasn't sent yet, accepting a zstd-compressed
+ * reply.
+ *
+ * Return 0 on success, -1 on error.
+ */
+static int get_compressed_metadata()
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_get_compressed_metadata rq;
+	struct lttng_viewer_compressed_metadata_packet rp;
+	ssize_t ret_len;
+	uint64_t i, len;
+	uint32_t compression;
+	char *data;
+	int metadata_stream_id = -1;
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_GET_COMPRESSED_METADATA);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+
+	for (i = 0; i < session->stream_count; i++) {
+		if (session->streams[i].metadata_flag) {
+			metadata_stream_id = i;
+			break;
+		}
+	}
+
+	if (metadata_stream_id < 0) {
+		diag("No metadata stream found");
+		return -1;
+	}
+
+	rq.stream_id = htobe64(session->streams[metadata_stream_id].id);
+	rq.compressions = htobe32((1U << LTTNG_VIEWER_METADATA_COMPRESSION_NONE) |
+				  (1U << LTTNG_VIEWER_METADATA_COMPRESSION_ZSTD));
+
+	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+	if (ret_len < 0) {
+		diag("Error sending cmd");
+		return -1;
+	}
+	ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+	if (ret_len < 0) {
+		diag("Error sending get_compressed_metadata request");
+		return -1;
+	}
+	ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+	if (ret_len <= 0) {
+		diag("Error receiving compressed metadata response");
+		return -1;
+	}
+
+	if (be32toh(rp.status) == LTTNG_VIEWER_METADATA_ERR) {
+		diag("Got LTTNG_VIEWER_METADATA_ERR:");
+		return -1;
+	}
+
+	len = be64toh(rp.len);
+	compression = be32toh(rp.compression);
+	if ((compression == LTTNG_VIEWER_METADATA_COMPRESSION_NONE &&
+	     len != be64toh(rp.uncompressed_len)) ||
+	    (compression == LTTNG_VIEWER_METADATA_COMPRESSION_ZSTD &&
+	     len >= be64toh(rp.uncompressed_len))) {
+		diag("Got inconsistent compressed metadata lengths");
+		return -1;
+	}
+
+	if (len == 0) {
+		return 0;
+	}
+
+	data = calloc<char>(len);
+	if (!data) {
+		PERROR("relay data zmalloc");
+		return -1;
+	}
+	ret_len = lttng_live_recv(control_sock, data, len);
+	free(data);
+	if (ret_len <= 0) {
+		diag("Error receiving compressed metadata");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Switch the connection to push mode and receive the first frame pushed by
+ * the relay daemon: the data streams are active, so that they have a packet
+ * or an inactivity beacon to push within a live timer period.
+ *
+ * Return the type of the frame, -1 on error.
+ */
+static int subscribe()
+{
+	struct lttng_viewer_cmd cmd;
+	struct lttng_viewer_subscribe_request rq;
+	struct lttng_viewer_subscribe_response rp;
+	struct lttng_viewer_frame frame;
+	ssize_t ret_len;
+	uint64_t len;
+	char *data;
+
+	cmd.cmd = htobe32(LTTNG_VIEWER_SUBSCRIBE);
+	cmd.data_size = htobe64(sizeof(rq));
+	cmd.cmd_version = htobe32(0);
+	rq.window = htobe64(4 * 1024 * 1024);
+
+	ret_len = lttng_live_send(control_sock, &cmd, sizeof(cmd));
+	if (ret_len < 0) {
+		diag("Error sending cmd");
+		return -1;
+	}
+	ret_len = lttng_live_send(control_sock, &rq, sizeof(rq));
+	if (ret_len < 0) {
+		diag("Error sending subscribe request");
+		return -1;
+	}
+	ret_len = lttng_live_recv(control_sock, &rp, sizeof(rp));
+	if (ret_len <= 0) {
+		diag("Error receiving subscribe response");
+		return -1;
+	}
+
+	if (be32toh(rp.status) != LTTNG_VIEWER_SUBSCRIBE_OK) {
+		diag("Got subscribe status %u", be32toh(rp.status));
+		return -1;
+	}
+
+	ret_len = lttng_live_recv(control_sock, &frame, sizeof(frame));
+	if (ret_len <= 0) {
+		diag("Error receiving frame");
+		return -1;
+	}
+
+	len = be64toh(frame.len);
+	data = calloc<char>(len);
+	if (!data) {
+		PERROR("relay frame zmalloc");
+		return -1;
+	}
+	ret_len = len > 0 ? lttng_live_recv(control_sock, data, len) : 0;
+	free(data);
+	if (ret_len < 0 || (len > 0 && ret_len == 0)) {
+		diag("Error receiving frame payload");
+		return -1;
+	}
+
+	return be32toh(frame.type);
+}
+
 int main()
 {
 	int ret;
-	uint64_t session_id;
+	uint64_t session_id, generation, next_generation, seek_timestamp;
+	uint32_t list_flags;
+	struct timespec now;
 
 	plan_tests(NUM_TESTS);
 
@@ -689,15 +1227,48 @@ int main()
 		goto end;
 	}
 
+	ret = list_sessions_filtered(0, &generation, &list_flags);
+	if (ret > 0 && (list_flags & LTTNG_VIEWER_LIST_SESSIONS_FLAG_FULL)) {
+		ret = list_sessions_filtered(generation, &next_generation, &list_flags);
+		if (ret >= 0 && (list_flags & LTTNG_VIEWER_LIST_SESSIONS_FLAG_FULL)) {
+			ret = -1;
+		}
+	} else {
+		ret = -1;
+	}
+	ok(ret >= 0, "List the live sessions, then those changed since then");
+
 	ret = create_viewer_session();
 	ok(ret == 0, "Create viewer session");
 
-	ret = attach_session(session_id);
+	ret = set_channel_filter("*");
+	ok(ret == 0, "Set channel filter");
+
+	/*
+	 * The packets of the default monotonic clock are timestamped in
+	 * nanoseconds. Seek before any other request reads the indexes, so
+	 * that the relay daemon may still buffer some of them.
+	 */
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &now);
+	seek_timestamp = ret == 0 ? (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec : 0;
+	ret = attach_session(session_id, LTTNG_VIEWER_SEEK_TIMESTAMP, seek_timestamp);
+	ok(ret > 0, "Attach to session at the current time, %d stream(s) received", ret);
+
+	ret = check_next_index_after(seek_timestamp);
+	ok(ret == 0, "No stream starts before the current time, %d did", ret);
+
+	ret = detach_viewer_session(session_id);
+	ok(ret == 0, "Detach viewer session");
+
+	ret = attach_session(session_id, LTTNG_VIEWER_SEEK_BEGINNING, 0);
 	ok(ret > 0, "Attach to session, %d stream(s) received", ret);
 
 	ret = get_metadata();
 	ok(ret > 0, "Get metadata, received %d bytes", ret);
 
+	ret = get_compressed_metadata();
+	ok(ret == 0, "Get compressed metadata");
+
 	ret = get_next_index();
 	ok(ret == 0, "Get one index per stream");
 
@@ -714,8 +1285,24 @@ int main()
 	ret = list_sessions(&session_id);
 	ok(ret > 0, "List sessions : %d session(s)", ret);
 
-	ret = attach_session(session_id);
-	ok(ret > 0, "Attach to session, %d streams received", ret);
+	/* All the packets end after the first timestamp. */
+	ret = attach_session(session_id, LTTNG_VIEWER_SEEK_TIMESTAMP, 0);
+	ok(ret > 0, "Attach to session at a timestamp, %d streams received", ret);
+
+	ret = get_next_indexes(session_id);
+	ok(ret > 0, "Get the next index of all streams, %d index(es) received", ret);
+
+	ret = wait_next_index();
+	ok(ret > 0, "Wait for the next index of a stream, status %d", ret);
+
+	ret = get_next_packets();
+	ok(ret > 0, "Get the next packets of a stream, %d index(es) received", ret);
+
+	/* The connection only receives the pushed frames from then on. */
+	ret = subscribe();
+	ok(ret >= LTTNG_VIEWER_FRAME_PACKET && ret <= LTTNG_VIEWER_FRAME_NEW_STREAMS,
+	   "Subscribe to the session, first frame of type %d pushed",
+	   ret);
 end:
 	return exit_status();
 }
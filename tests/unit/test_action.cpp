@@ -23,6 +23,7 @@
 #include <lttng/action/snapshot-session.h>
 #include <lttng/action/start-session.h>
 #include <lttng/action/stop-session.h>
+#include <lttng/snapshot.h>
 
 #include <inttypes.h>
 #include <stdio.h>
@@ -35,7 +36,7 @@ int lttng_opt_quiet = 1;
 int lttng_opt_verbose;
 int lttng_opt_mi;
 
-#define NUM_TESTS 71
+#define NUM_TESTS 73
 
 static void test_action_notify()
 {
@@ -461,6 +462,7 @@ static void test_action_snapshot_session()
 	struct lttng_payload payload;
 	const char *session_name = "my_session_name";
 	const char *get_session_name;
+	struct lttng_snapshot_output *output;
 
 	lttng_payload_init(&payload);
 
@@ -520,6 +522,16 @@ static void test_action_snapshot_session()
 		   "snapshot_session action policy get");
 	}
 
+	/* Set an incremental output. */
+	output = lttng_snapshot_output_create();
+	LTTNG_ASSERT(output);
+	ret = lttng_snapshot_output_set_local_path("/tmp/snapshots", output);
+	LTTNG_ASSERT(ret == 0);
+	ret = lttng_snapshot_output_set_incremental(1, output);
+	LTTNG_ASSERT(ret == 0);
+	status = lttng_action_snapshot_session_set_output(snapshot_session_action, output);
+	ok(status == LTTNG_ACTION_STATUS_OK, "Set incremental snapshot output");
+
 	/* Ser/des tests. */
 	ret = lttng_action_serialize(snapshot_session_action, &payload);
 	ok(ret == 0, "Action snapshot_session serialized");
@@ -535,6 +547,16 @@ static void test_action_snapshot_session()
 	ok(lttng_action_is_equal(snapshot_session_action, snapshot_session_action_from_buffer),
 	   "Serialized and de-serialized snapshot_session action are equal");
 
+	{
+		const struct lttng_snapshot_output *output_from_buffer = nullptr;
+
+		status = lttng_action_snapshot_session_get_output(
+			snapshot_session_action_from_buffer, &output_from_buffer);
+		ok(status == LTTNG_ACTION_STATUS_OK &&
+			   lttng_snapshot_output_is_incremental(output_from_buffer),
+		   "De-serialized snapshot output is incremental");
+	}
+
 	lttng_rate_policy_destroy(default_policy);
 	lttng_rate_policy_destroy(policy);
 	lttng_action_destroy(snapshot_session_action);
@@ -16,6 +16,8 @@
 #include <lttng/condition/event-rule-matches-internal.hpp>
 #include <lttng/condition/event-rule-matches.h>
 #include <lttng/domain.h>
+#include <lttng/event-expr.h>
+#include <lttng/event-field-value.h>
 #include <lttng/event-rule/user-tracepoint.h>
 #include <lttng/event.h>
 #include <lttng/log-level-rule.h>
@@ -31,7 +33,7 @@ int lttng_opt_quiet = 1;
 int lttng_opt_verbose;
 int lttng_opt_mi;
 
-#define NUM_TESTS 13
+#define NUM_TESTS 22
 
 static void test_condition_event_rule()
 {
@@ -104,9 +106,94 @@ static void test_condition_event_rule()
 	lttng_log_level_rule_destroy(log_level_rule_at_least_as_severe);
 }
 
+static void test_evaluation_event_rule_matches_captures()
+{
+	unsigned int i, count = 0;
+	uint64_t uint_val = 0;
+	int64_t int_val = 0;
+	const char *str_val = nullptr;
+	size_t str_len = 0;
+	enum lttng_event_field_value_type type = LTTNG_EVENT_FIELD_VALUE_TYPE_UNKNOWN;
+	struct lttng_event_rule *tracepoint;
+	struct lttng_condition *condition;
+	struct lttng_evaluation *evaluation;
+	const struct lttng_event_field_value *captured_values = nullptr;
+	const struct lttng_event_field_value *captured_value = nullptr;
+	/* MessagePack-encoded [42, -7, "abc", nil, [1]]. */
+	const char capture_payload[] = {
+		'\x95', '\x2a', '\xf9', '\xa3', 'a', 'b', 'c', '\xc0', '\x91', '\x01'
+	};
+	const char *field_names[] = { "uint", "int", "str", "unavailable", "array" };
+
+	tracepoint = lttng_event_rule_user_tracepoint_create();
+	LTTNG_ASSERT(tracepoint);
+	condition = lttng_condition_event_rule_matches_create(tracepoint);
+	LTTNG_ASSERT(condition);
+
+	for (i = 0; i < 5; i++) {
+		struct lttng_event_expr *expr =
+			lttng_event_expr_event_payload_field_create(field_names[i]);
+		const enum lttng_condition_status condition_status =
+			lttng_condition_event_rule_matches_append_capture_descriptor(condition,
+										      expr);
+
+		LTTNG_ASSERT(condition_status == LTTNG_CONDITION_STATUS_OK);
+	}
+
+	evaluation = lttng_evaluation_event_rule_matches_create(
+		lttng::utils::container_of(condition, &lttng_condition_event_rule_matches::parent),
+		capture_payload,
+		sizeof(capture_payload),
+		true);
+	ok(evaluation, "Created event rule matches evaluation with a capture payload");
+
+	ok(lttng_evaluation_event_rule_matches_get_captured_value_count(evaluation, &count) ==
+			   LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_OK &&
+		   count == 5,
+	   "Captured value count is the capture descriptor count");
+	ok(lttng_evaluation_event_rule_matches_get_captured_unsigned_int_at_index(
+		   evaluation, 0, &uint_val) == LTTNG_EVENT_FIELD_VALUE_STATUS_OK &&
+		   uint_val == 42,
+	   "Captured unsigned integer read");
+	ok(lttng_evaluation_event_rule_matches_get_captured_signed_int_at_index(
+		   evaluation, 1, &int_val) == LTTNG_EVENT_FIELD_VALUE_STATUS_OK &&
+		   int_val == -7,
+	   "Captured signed integer read");
+	ok(lttng_evaluation_event_rule_matches_get_captured_string_at_index(
+		   evaluation, 2, &str_val, &str_len) == LTTNG_EVENT_FIELD_VALUE_STATUS_OK &&
+		   str_len == 3 && strncmp(str_val, "abc", str_len) == 0,
+	   "Captured string read");
+	ok(lttng_evaluation_event_rule_matches_get_captured_value_type_at_index(
+		   evaluation, 3, &type) == LTTNG_EVENT_FIELD_VALUE_STATUS_UNAVAILABLE,
+	   "Unavailable captured value reported");
+	ok(lttng_evaluation_event_rule_matches_get_captured_value_type_at_index(
+		   evaluation, 4, &type) == LTTNG_EVENT_FIELD_VALUE_STATUS_OK &&
+		   type == LTTNG_EVENT_FIELD_VALUE_TYPE_ARRAY,
+	   "Captured array type read");
+	ok(lttng_evaluation_event_rule_matches_get_captured_unsigned_int_at_index(
+		   evaluation, 2, &uint_val) == LTTNG_EVENT_FIELD_VALUE_STATUS_INVALID,
+	   "Captured value of another type is not read");
+
+	ok(lttng_evaluation_event_rule_matches_get_captured_values(evaluation,
+								   &captured_values) ==
+			   LTTNG_EVALUATION_EVENT_RULE_MATCHES_STATUS_OK &&
+		   lttng_event_field_value_array_get_element_at_index(
+			   captured_values, 0, &captured_value) ==
+			   LTTNG_EVENT_FIELD_VALUE_STATUS_OK &&
+		   lttng_event_field_value_unsigned_int_get_value(captured_value, &uint_val) ==
+			   LTTNG_EVENT_FIELD_VALUE_STATUS_OK &&
+		   uint_val == 42,
+	   "Captured values event field values created on demand");
+
+	lttng_evaluation_destroy(evaluation);
+	lttng_condition_destroy(condition);
+	lttng_event_rule_destroy(tracepoint);
+}
+
 int main()
 {
 	plan_tests(NUM_TESTS);
 	test_condition_event_rule();
+	test_evaluation_event_rule_matches_captures();
 	return exit_status();
 }
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/crc32c.hpp>
+
+#include <string.h>
+#include <tap/tap.h>
+
+static const int TEST_COUNT = 4;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_crc32c()
+{
+	const char check[] = "123456789";
+	static char zeroes[10000];
+	uint32_t crc;
+
+	ok(lttng_crc32c_update(0, check, strlen(check)) == 0xE3069283,
+	   "Checksum of the check string matches the reference value");
+	ok(lttng_crc32c_update(0, check, 0) == 0, "Checksum of no data is 0");
+
+	crc = lttng_crc32c_update(0, check, 5);
+	crc = lttng_crc32c_update(crc, check + 5, strlen(check) - 5);
+	ok(crc == 0xE3069283, "Checksum updated in two pieces matches the checksum of the whole");
+
+	crc = lttng_crc32c_update(0, check, strlen(check));
+	ok(lttng_crc32c_update_zeroes(crc, sizeof(zeroes)) ==
+		   lttng_crc32c_update(crc, zeroes, sizeof(zeroes)),
+	   "Checksum updated with zeroes matches the checksum of a zeroed buffer");
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	test_crc32c();
+
+	return exit_status();
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2026 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/make-unique.hpp>
+
+#include <vendor/nlohmann/json.hpp>
+
+#include <bin/lttng-sessiond/clock-class.hpp>
+#include <bin/lttng-sessiond/ctf2-trace-class-visitor.hpp>
+#include <bin/lttng-sessiond/event-class.hpp>
+#include <bin/lttng-sessiond/field.hpp>
+#include <string>
+#include <tap/tap.h>
+#include <vector>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 9
+
+#ifdef HAVE_LIBLTTNG_UST_CTL
+#include <lttng/lttng-export.h>
+#include <lttng/ust-sigbus.h>
+LTTNG_EXPORT DEFINE_LTTNG_UST_SIGBUS_STATE();
+#endif
+
+/* For error.hpp */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace lsc = lttng::sessiond::ctf2;
+namespace lst = lttng::sessiond::trace;
+namespace json = nlohmann;
+
+namespace {
+class test_clock_class : public lst::clock_class {
+public:
+	test_clock_class() :
+		lst::clock_class("monotonic",
+				 "Monotonic Clock",
+				 lttng_uuid{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+				 2500000000,
+				 1000000000)
+	{
+	}
+};
+
+class test_event_class : public lst::event_class {
+public:
+	test_event_class(std::string name, lst::type::cuptr payload) :
+		lst::event_class(1, 0, 13, std::move(name), nonstd::nullopt, std::move(payload))
+	{
+	}
+};
+
+lst::type::cuptr make_uint32_type()
+{
+	return lttng::make_unique<lst::integer_type>(8,
+						     lst::byte_order::LITTLE_ENDIAN_,
+						     32,
+						     lst::integer_type::signedness::UNSIGNED,
+						     lst::integer_type::base::HEXADECIMAL);
+}
+
+json::json uint32_type_json()
+{
+	return { { "type", "fixed-length-unsigned-integer" },
+		 { "length", 32 },
+		 { "byte-order", "little-endian" },
+		 { "alignment", 8 },
+		 { "preferred-display-base", 16 } };
+}
+
+json::json field_json(const char *name, json::json field_class)
+{
+	return { { "name", name }, { "field-class", std::move(field_class) } };
+}
+
+/* Serialize with the CTF 2 visitor and parse the fragments back. */
+template <class VisitedType>
+std::vector<std::string> serialize(const VisitedType& visited)
+{
+	std::vector<std::string> fragments;
+	lsc::trace_class_visitor visitor(
+		[&fragments](const std::string& fragment) { fragments.emplace_back(fragment); });
+
+	visitor.visit(visited);
+	return fragments;
+}
+
+bool parse_fragment(const std::string& fragment, json::json& document)
+{
+	if (fragment.empty() || fragment[0] != '\x1e') {
+		return false;
+	}
+
+	try {
+		document = json::json::parse(fragment.begin() + 1, fragment.end());
+	} catch (const json::json::parse_error&) {
+		return false;
+	}
+
+	return true;
+}
+
+void test_clock_class_fragment()
+{
+	const test_clock_class clock_class;
+	const auto fragments = serialize(clock_class);
+	json::json document;
+
+	ok(fragments.size() == 1 && parse_fragment(fragments[0], document),
+	   "Clock class is serialized as a single JSON fragment");
+
+	const json::json expected = {
+		{ "type", "clock-class" },
+		{ "name", "monotonic" },
+		{ "description", "Monotonic Clock" },
+		{ "frequency", 1000000000 },
+		{ "offset", { { "seconds", 2 }, { "cycles", 500000000 } } },
+		{ "uuid", { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 } },
+	};
+	ok(document == expected, "Clock class fragment matches the expected document");
+}
+
+void test_event_class_fragment()
+{
+	using mappings = lst::unsigned_enumeration_type::mappings;
+
+	lst::structure_type::fields fields;
+	lst::variant_type<uint64_t>::choices choices;
+
+	auto enum_mappings = std::make_shared<mappings>();
+	enum_mappings->emplace_back("ZERO", 0);
+	enum_mappings->emplace_back("ONE", 1);
+
+	fields.emplace_back(lttng::make_unique<lst::field>("len", make_uint32_type()));
+	fields.emplace_back(lttng::make_unique<lst::field>(
+		"seq",
+		lttng::make_unique<lst::dynamic_length_array_type>(
+			0,
+			make_uint32_type(),
+			lst::field_location(lst::field_location::root::EVENT_RECORD_PAYLOAD,
+					    { "len" }))));
+	fields.emplace_back(lttng::make_unique<lst::field>(
+		"tag",
+		lttng::make_unique<lst::unsigned_enumeration_type>(
+			8,
+			lst::byte_order::LITTLE_ENDIAN_,
+			8,
+			lst::integer_type::base::DECIMAL,
+			enum_mappings)));
+	choices.emplace_back(lst::variant_type<uint64_t>::choice(
+		lst::unsigned_enumeration_type::mapping("ZERO", 0),
+		lttng::make_unique<lst::null_terminated_string_type>(
+			8, lst::string_type::encoding::UTF8)));
+	choices.emplace_back(lst::variant_type<uint64_t>::choice(
+		lst::unsigned_enumeration_type::mapping("ONE", 1),
+		lttng::make_unique<lst::static_length_array_type>(0, make_uint32_type(), 4)));
+	fields.emplace_back(lttng::make_unique<lst::field>(
+		"value",
+		lttng::make_unique<lst::variant_type<uint64_t>>(
+			0,
+			lst::field_location(lst::field_location::root::EVENT_RECORD_PAYLOAD,
+					    { "tag" }),
+			std::move(choices))));
+
+	const test_event_class event_class(
+		"provider:event",
+		lttng::make_unique<lst::structure_type>(0, std::move(fields)));
+	const auto fragments = serialize(event_class);
+	json::json document;
+
+	ok(fragments.size() == 1 && parse_fragment(fragments[0], document),
+	   "Event class is serialized as a single JSON fragment");
+
+	auto seq_json = json::json::object();
+	seq_json["type"] = "dynamic-length-array";
+	seq_json["element-field-class"] = uint32_type_json();
+	seq_json["length-field-location"] = { "event-record-payload", "len" };
+
+	auto ranges_json = json::json::object();
+	ranges_json["ZERO"] = json::json::array({ json::json::array({ 0, 0 }) });
+	ranges_json["ONE"] = json::json::array({ json::json::array({ 1, 1 }) });
+
+	auto tag_json = json::json::object();
+	tag_json["type"] = "fixed-length-unsigned-enumeration";
+	tag_json["length"] = 8;
+	tag_json["byte-order"] = "little-endian";
+	tag_json["alignment"] = 8;
+	tag_json["preferred-display-base"] = 10;
+	tag_json["mappings"] = std::move(ranges_json);
+
+	auto string_json = json::json::object();
+	string_json["type"] = "null-terminated-string";
+
+	auto array_json = json::json::object();
+	array_json["type"] = "static-length-array";
+	array_json["element-field-class"] = uint32_type_json();
+	array_json["length"] = 4;
+
+	auto zero_option_json = json::json::object();
+	zero_option_json["selector-field-ranges"] =
+		json::json::array({ json::json::array({ 0, 0 }) });
+	zero_option_json["field-class"] = std::move(string_json);
+
+	auto one_option_json = json::json::object();
+	one_option_json["selector-field-ranges"] =
+		json::json::array({ json::json::array({ 1, 1 }) });
+	one_option_json["field-class"] = std::move(array_json);
+
+	auto value_json = json::json::object();
+	value_json["type"] = "variant";
+	value_json["selector-field-location"] = { "event-record-payload", "tag" };
+	value_json["options"] = json::json::array({ zero_option_json, one_option_json });
+
+	auto payload_json = json::json::object();
+	payload_json["type"] = "structure";
+	payload_json["member-classes"] = json::json::array({
+		field_json("len", uint32_type_json()),
+		field_json("seq", std::move(seq_json)),
+		field_json("tag", std::move(tag_json)),
+		field_json("value", std::move(value_json)),
+	});
+
+	auto expected = json::json::object();
+	expected["type"] = "event-record-class";
+	expected["id"] = 1;
+	expected["data-stream-class-id"] = 0;
+	expected["name"] = "provider:event";
+	expected["payload-field-class"] = std::move(payload_json);
+
+	ok(document == expected, "Event class fragment matches the expected document");
+}
+
+void test_string_escaping()
+{
+	const std::string name = "quote\" backslash\\ tab\t new-line\n control\x01 utf-8 \xc3\xa9";
+	lst::structure_type::fields fields;
+
+	fields.emplace_back(lttng::make_unique<lst::field>(name, make_uint32_type()));
+
+	const test_event_class event_class(
+		name, lttng::make_unique<lst::structure_type>(0, std::move(fields)));
+	const auto fragments = serialize(event_class);
+	json::json document;
+
+	ok(fragments.size() == 1 && parse_fragment(fragments[0], document),
+	   "Names requiring escaping are serialized as valid JSON");
+	ok(document["name"] == name &&
+		   document["payload-field-class"]["member-classes"][0]["name"] == name,
+	   "Escaped names are restored when parsed");
+}
+
+void test_enumeration_mappings_sharing_a_name()
+{
+	using mappings = lst::unsigned_enumeration_type::mappings;
+	using range = lst::unsigned_enumeration_type::mapping::range_t;
+
+	auto enum_mappings = std::make_shared<mappings>();
+	enum_mappings->emplace_back("LOW", range(0, 9));
+	enum_mappings->emplace_back("HIGH", range(10, 19));
+	enum_mappings->emplace_back("LOW", range(20, 29));
+
+	lst::structure_type::fields fields;
+	fields.emplace_back(lttng::make_unique<lst::field>(
+		"level",
+		lttng::make_unique<lst::unsigned_enumeration_type>(
+			8,
+			lst::byte_order::LITTLE_ENDIAN_,
+			8,
+			lst::integer_type::base::DECIMAL,
+			enum_mappings)));
+
+	const test_event_class event_class(
+		"enumeration", lttng::make_unique<lst::structure_type>(0, std::move(fields)));
+	const auto fragments = serialize(event_class);
+	json::json document;
+
+	ok(fragments.size() == 1 && parse_fragment(fragments[0], document),
+	   "Enumeration with mappings sharing a name is serialized as valid JSON");
+
+	auto& mappings_json =
+		document["payload-field-class"]["member-classes"][0]["field-class"]["mappings"];
+	const auto expected_low = json::json::array(
+		{ json::json::array({ 0, 9 }), json::json::array({ 20, 29 }) });
+	const auto expected_high = json::json::array({ json::json::array({ 10, 19 }) });
+
+	ok(mappings_json.size() == 2, "Mappings sharing a name are serialized as one mapping");
+	ok(mappings_json["LOW"] == expected_low && mappings_json["HIGH"] == expected_high,
+	   "All the ranges of the mappings are serialized");
+}
+} /* namespace */
+
+int main()
+{
+	plan_tests(NUM_TESTS);
+
+	diag("CTF 2 trace class visitor unit tests");
+
+	test_clock_class_fragment();
+	test_event_class_fragment();
+	test_string_escaping();
+	test_enumeration_mappings_sharing_a_name();
+
+	return exit_status();
+}
@@ -31,7 +31,7 @@ int lttng_opt_verbose;
 int lttng_opt_mi;
 
 /* Number of TAP tests in this file */
-#define NUM_TESTS 61
+#define NUM_TESTS 74
 /* 3 for stdin, stdout, and stderr */
 #define STDIO_FD_COUNT		   3
 #define TRACKER_FD_LIMIT	   50
@@ -724,6 +724,91 @@ end:
 	free(unlinked_files_directory);
 }
 
+/*
+ * Open twice as many files as allowed by the fd tracker's cap, close the
+ * active half, and verify that the suspended half is prefetched within the
+ * freed capacity and then used without being restored again.
+ */
+static void test_suspendable_prefetch()
+{
+	int ret;
+	unsigned int prefetched;
+	const int files_to_create = TRACKER_FD_LIMIT * 2;
+	struct fd_tracker *tracker;
+	struct fd_tracker_stats stats_before, stats_after;
+	char *output_files[files_to_create];
+	struct fs_handle *handles[files_to_create];
+	int handle_index;
+	bool use_success = true;
+	struct lttng_directory_handle *dir_handle = nullptr;
+	int dir_handle_fd_count;
+	char *test_directory = nullptr, *unlinked_files_directory = nullptr;
+
+	memset(output_files, 0, sizeof(output_files));
+	memset(handles, 0, sizeof(handles));
+
+	get_temporary_directories(&test_directory, &unlinked_files_directory);
+
+	tracker = fd_tracker_create(unlinked_files_directory, TRACKER_FD_LIMIT);
+	if (!tracker) {
+		goto end;
+	}
+
+	dir_handle = lttng_directory_handle_create(test_directory);
+	LTTNG_ASSERT(dir_handle);
+	dir_handle_fd_count = !!lttng_directory_handle_uses_fd(dir_handle);
+
+	ret = open_files(tracker, dir_handle, files_to_create, handles, output_files);
+	ok(!ret,
+	   "Created %d files with a limit of %d simultaneously-opened file descriptor",
+	   files_to_create,
+	   TRACKER_FD_LIMIT);
+
+	prefetched = fd_tracker_prefetch_handles(tracker, files_to_create, UINT64_MAX);
+	ok(prefetched == 0, "No handle prefetched while the tracker is at capacity");
+
+	/* Close the most recently opened half, which is active. */
+	for (handle_index = TRACKER_FD_LIMIT; handle_index < files_to_create; handle_index++) {
+		ret = fs_handle_close(handles[handle_index]);
+		LTTNG_ASSERT(!ret);
+		ret = lttng_directory_handle_unlink_file(dir_handle, output_files[handle_index]);
+		LTTNG_ASSERT(!ret);
+		free(output_files[handle_index]);
+	}
+
+	prefetched = fd_tracker_prefetch_handles(tracker, files_to_create, UINT64_MAX);
+	ok(prefetched == TRACKER_FD_LIMIT,
+	   "Prefetched %u suspended handles, expected %d",
+	   prefetched,
+	   TRACKER_FD_LIMIT);
+	check_fd_count(TRACKER_FD_LIMIT + STDIO_FD_COUNT + unknown_fds_count + dir_handle_fd_count);
+
+	fd_tracker_get_stats(tracker, &stats_before);
+	for (handle_index = 0; handle_index < TRACKER_FD_LIMIT; handle_index++) {
+		if (fs_handle_get_fd(handles[handle_index]) < 0) {
+			use_success = false;
+			diag("Failed to use fs_handle to %s", output_files[handle_index]);
+			break;
+		}
+
+		fs_handle_put_fd(handles[handle_index]);
+	}
+	fd_tracker_get_stats(tracker, &stats_after);
+	ok(use_success && stats_after.misses == stats_before.misses &&
+		   stats_after.prefetch_hits - stats_before.prefetch_hits == TRACKER_FD_LIMIT,
+	   "Prefetched handles are used without being restored");
+
+	ret = cleanup_files(tracker, test_directory, TRACKER_FD_LIMIT, handles, output_files);
+	ok(!ret, "Close all opened filesystem handles");
+	ret = rmdir(test_directory);
+	ok(ret == 0, "Test directory is empty");
+	fd_tracker_destroy(tracker);
+	lttng_directory_handle_put(dir_handle);
+end:
+	free(test_directory);
+	free(unlinked_files_directory);
+}
+
 static void test_unlink()
 {
 	int ret;
@@ -854,6 +939,77 @@ end:
 	lttng_directory_handle_put(dir_handle);
 }
 
+static void test_rename()
+{
+	int ret, fd;
+	struct fd_tracker *tracker;
+	struct fs_handle *handle = nullptr, *other_handle = nullptr;
+	struct stat statbuf;
+	struct lttng_directory_handle *dir_handle = nullptr;
+	const char file_name[] = "my_file", new_file_name[] = "my_renamed_file";
+	const char other_file_name[] = "my_other_file";
+	char *test_directory = nullptr, *unlinked_files_directory = nullptr;
+	char read_buf[sizeof(file_contents)];
+
+	get_temporary_directories(&test_directory, &unlinked_files_directory);
+
+	tracker = fd_tracker_create(unlinked_files_directory, 1);
+	if (!tracker) {
+		goto end;
+	}
+
+	dir_handle = lttng_directory_handle_create(test_directory);
+	LTTNG_ASSERT(dir_handle);
+
+	/* The file to replace. */
+	fd = lttng_directory_handle_open_file(
+		dir_handle, new_file_name, O_WRONLY | O_CREAT, S_IWUSR | S_IRUSR);
+	LTTNG_ASSERT(fd >= 0);
+	ret = close(fd);
+	LTTNG_ASSERT(!ret);
+
+	ret = open_same_file(tracker, dir_handle, file_name, 1, &handle);
+	LTTNG_ASSERT(!ret);
+	fd = fs_handle_get_fd(handle);
+	LTTNG_ASSERT(fd >= 0);
+	ret = write(fd, file_contents, sizeof(file_contents));
+	LTTNG_ASSERT(ret == sizeof(file_contents));
+	fs_handle_put_fd(handle);
+
+	ret = fs_handle_rename(handle, new_file_name);
+	ok(!ret, "Renamed %s/%s to %s, replacing it", test_directory, file_name, new_file_name);
+	ok(lttng_directory_handle_stat(dir_handle, file_name, &statbuf) == -1 && errno == ENOENT,
+	   "%s no longer present on file system after rename",
+	   file_name);
+
+	/* Only one file descriptor can be opened at once: the renamed handle is suspended. */
+	ret = open_same_file(tracker, dir_handle, other_file_name, 1, &other_handle);
+	LTTNG_ASSERT(!ret);
+	fd = fs_handle_get_fd(other_handle);
+	LTTNG_ASSERT(fd >= 0);
+	fs_handle_put_fd(other_handle);
+
+	fd = fs_handle_get_fd(handle);
+	ok(fd >= 0, "Restored the renamed handle");
+	ok(fd >= 0 && pread(fd, read_buf, sizeof(read_buf), 0) == sizeof(read_buf) &&
+		   !memcmp(read_buf, file_contents, sizeof(read_buf)),
+	   "Renamed handle is restored to the file found at its new name");
+	if (fd >= 0) {
+		fs_handle_put_fd(handle);
+	}
+
+	ok(!fs_handle_unlink(handle) && !fs_handle_close(handle) &&
+		   !fs_handle_unlink(other_handle) && !fs_handle_close(other_handle),
+	   "Unlinked and closed the handles");
+	ret = rmdir(test_directory);
+	ok(ret == 0, "Test directory is empty");
+end:
+	fd_tracker_destroy(tracker);
+	free(test_directory);
+	free(unlinked_files_directory);
+	lttng_directory_handle_put(dir_handle);
+}
+
 int main()
 {
 	plan_tests(NUM_TESTS);
@@ -879,12 +1035,16 @@ int main()
 	test_suspendable_limit();
 	diag("Suspendable - restoration test");
 	test_suspendable_restore();
+	diag("Suspendable - prefetch test");
+	test_suspendable_prefetch();
 
 	diag("Mixed - check that file descriptor limit is enforced");
 	test_mixed_limit();
 
 	diag("Suspendable - Unlinking test");
 	test_unlink();
+	diag("Suspendable - Renaming test");
+	test_rename();
 
 	rcu_barrier();
 	rcu_unregister_thread();
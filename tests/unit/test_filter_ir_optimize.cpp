@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/bytecode/bytecode.hpp>
+#include <common/filter/filter-ast.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <tap/tap.h>
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+struct expression_pair {
+	const char *expression;
+	/* Hand-simplified version of `expression`. */
+	const char *equivalent;
+	/* Whether the optimizer generates the same bytecode for both. */
+	bool same_bytecode;
+};
+
+const struct expression_pair pairs[] = {
+	/* Constant folding. */
+	{ "1 == 1", "1", true },
+	{ "a == (1 << 4)", "a == 16", true },
+	{ "a == -(2 == 2)", "a == -1", true },
+	{ "a == ((3 | 4) ^ 1)", "a == 6", true },
+	{ "a >= 1.5 && 2 > 1", "a >= 1.5", true },
+	{ "a == (1 << 64)", "a == 0", false },
+	/* Dead branches of the logical operators. */
+	{ "a == 2 && 3 < 2", "0", true },
+	{ "1 || a == 2", "1", true },
+	{ "0 || a == 2", "a == 2", true },
+	{ "a || 1", "1", false },
+	{ "a == 1 && (x || 0 || y)", "a == 1 && (x || y)", true },
+	/* Cheap comparisons first in the filter result. */
+	{ "s == \"x*y\" && a == 2", "a == 2 && s == \"x*y\"", true },
+	{ "s == \"x\" && b == 1 && a < 3", "b == 1 && a < 3 && s == \"x\"", true },
+	{ "s == \"x\" || a == 2", "a == 2 || s == \"x\"", false },
+	{ "!(s == \"x\" && a == 2)", "!(a == 2 && s == \"x\")", false },
+	/* Repeated operands. */
+	{ "a == 2 && b == 1 && a == 2", "a == 2 && b == 1", true },
+	{ "$ctx.vpid == 4 || $ctx.vpid == 4", "$ctx.vpid == 4", true },
+};
+
+bool generate_bytecode(const char *expression, struct filter_parser_ctx **ctx)
+{
+	if (filter_parser_ctx_create_from_filter_expression(expression, ctx)) {
+		diag("Failed to generate the bytecode of `%s`", expression);
+		return false;
+	}
+
+	return true;
+}
+
+void test_expression_pair(const struct expression_pair *pair)
+{
+	struct filter_parser_ctx *ctx = nullptr, *equivalent_ctx = nullptr;
+	bool same_bytecode = false;
+
+	if (generate_bytecode(pair->expression, &ctx) &&
+	    generate_bytecode(pair->equivalent, &equivalent_ctx)) {
+		const uint32_t len = bytecode_get_len(&ctx->bytecode->b);
+
+		same_bytecode = len == bytecode_get_len(&equivalent_ctx->bytecode->b) &&
+			memcmp(ctx->bytecode->b.data, equivalent_ctx->bytecode->b.data, len) == 0;
+	}
+
+	ok(ctx && equivalent_ctx && same_bytecode == pair->same_bytecode,
+	   "`%s` %s the bytecode of `%s`",
+	   pair->expression,
+	   pair->same_bytecode ? "has" : "doesn't have",
+	   pair->equivalent);
+
+	if (ctx) {
+		filter_parser_ctx_free(ctx);
+	}
+
+	if (equivalent_ctx) {
+		filter_parser_ctx_free(equivalent_ctx);
+	}
+}
+} /* namespace */
+
+int main()
+{
+	plan_tests(sizeof(pairs) / sizeof(pairs[0]));
+	diag("Filter IR optimization unit tests");
+
+	for (const auto& pair : pairs) {
+		test_expression_pair(&pair);
+	}
+
+	return exit_status();
+}
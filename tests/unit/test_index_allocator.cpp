@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/index-allocator.hpp>
+
+#include <stdint.h>
+#include <tap/tap.h>
+
+static const int TEST_COUNT = 7;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_exhaustion()
+{
+	const uint64_t index_count = 130;
+	struct lttng_index_allocator *allocator = lttng_index_allocator_create(index_count);
+	bool sequential = true;
+	uint64_t index;
+
+	for (uint64_t i = 0; i < index_count; i++) {
+		if (lttng_index_allocator_alloc(allocator, &index) !=
+			    LTTNG_INDEX_ALLOCATOR_STATUS_OK ||
+		    index != i) {
+			sequential = false;
+		}
+	}
+
+	ok(sequential, "Indexes are allocated from the lowest one");
+	ok(lttng_index_allocator_get_index_count(allocator) == index_count,
+	   "All the indexes are in use");
+	ok(lttng_index_allocator_alloc(allocator, &index) == LTTNG_INDEX_ALLOCATOR_STATUS_EMPTY,
+	   "Allocation fails once all the indexes are in use");
+
+	ok(lttng_index_allocator_release(allocator, 100) == LTTNG_INDEX_ALLOCATOR_STATUS_OK &&
+		   lttng_index_allocator_release(allocator, 3) == LTTNG_INDEX_ALLOCATOR_STATUS_OK,
+	   "Indexes are released");
+	ok(lttng_index_allocator_alloc(allocator, &index) == LTTNG_INDEX_ALLOCATOR_STATUS_OK &&
+		   index == 3,
+	   "The lowest released index is allocated first");
+	ok(lttng_index_allocator_alloc(allocator, &index) == LTTNG_INDEX_ALLOCATOR_STATUS_OK &&
+		   index == 100,
+	   "The other released index is allocated next");
+
+	for (uint64_t i = 0; i < index_count; i++) {
+		(void) lttng_index_allocator_release(allocator, i);
+	}
+
+	lttng_index_allocator_destroy(allocator);
+}
+
+static void test_empty_allocator()
+{
+	struct lttng_index_allocator *allocator = lttng_index_allocator_create(0);
+	uint64_t index;
+
+	ok(allocator &&
+		   lttng_index_allocator_alloc(allocator, &index) ==
+			   LTTNG_INDEX_ALLOCATOR_STATUS_EMPTY,
+	   "Allocator of no index is always empty");
+	lttng_index_allocator_destroy(allocator);
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	test_exhaustion();
+	test_empty_allocator();
+
+	return exit_status();
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/io-uring.hpp>
+#include <common/readwrite.hpp>
+
+#include <exception>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/tap.h>
+#include <unistd.h>
+
+static const int TEST_COUNT = 6;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_flush_range(int fd)
+{
+	char buf[4096];
+	std::unique_ptr<lttng::io::uring> ring;
+
+	memset(buf, 'a', sizeof(buf));
+	if (lttng_write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+		diag("Failed to write to test file");
+		skip(5, "Test requires a test file");
+		return;
+	}
+
+	try {
+		/* Room for a single range. */
+		ring.reset(new lttng::io::uring(2));
+	} catch (const std::exception& e) {
+		diag("Failed to create io_uring instance: %s", e.what());
+		skip(5, "io_uring is not available");
+		return;
+	}
+
+	ok(ring->queue_flush_range_dont_need(fd, 0, sizeof(buf)), "Range is queued");
+	ok(!ring->queue_flush_range_dont_need(fd, 0, sizeof(buf)),
+	   "Range is not queued when the submission queue is full");
+
+	try {
+		ring->submit_and_reap();
+		pass("Queued operations are submitted");
+	} catch (const std::exception& e) {
+		fail("Queued operations are submitted: %s", e.what());
+	}
+
+	try {
+		/* Both linked operations complete once the range is written back. */
+		ring->submit_and_reap(2);
+		ok(ring->in_flight() == 0, "All operations are reaped");
+	} catch (const std::exception& e) {
+		fail("All operations are reaped: %s", e.what());
+	}
+
+	ok(ring->queue_flush_range_dont_need(fd, 0, sizeof(buf)),
+	   "Range is queued once completions are reaped");
+
+	/* The destructor waits for the pending operations. */
+	ring.reset();
+}
+
+int main()
+{
+	char path[] = "/tmp/test_io_uring.XXXXXX";
+	int fd;
+
+	plan_tests(TEST_COUNT);
+
+	fd = mkstemp(path);
+	ok(fd >= 0, "Created test file");
+	if (fd < 0) {
+		skip(5, "Test requires a test file");
+		return exit_status();
+	}
+
+	test_flush_range(fd);
+
+	(void) close(fd);
+	(void) unlink(path);
+	return exit_status();
+}
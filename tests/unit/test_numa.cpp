@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/numa.hpp>
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <tap/tap.h>
+#include <unistd.h>
+#include <vector>
+
+static const int TEST_COUNT = 14;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_parse_cpu_list()
+{
+	std::vector<int> cpus;
+
+	ok(lttng::numa::parse_cpu_list("0-3,8,10-11", cpus) == 0 &&
+		   cpus == std::vector<int>({ 0, 1, 2, 3, 8, 10, 11 }),
+	   "Parse a CPU list made of ranges and single CPUs");
+
+	cpus.clear();
+	ok(lttng::numa::parse_cpu_list("", cpus) == 0 && cpus.empty(), "Parse an empty CPU list");
+
+	cpus.clear();
+	ok(lttng::numa::parse_cpu_list("5", cpus) == 0 && cpus == std::vector<int>({ 5 }),
+	   "Parse a single CPU");
+
+	ok(lttng::numa::parse_cpu_list("3-1", cpus) == -1, "Reject a decreasing range");
+	ok(lttng::numa::parse_cpu_list("1,", cpus) == -1, "Reject a trailing separator");
+	ok(lttng::numa::parse_cpu_list("1-", cpus) == -1, "Reject an unterminated range");
+	ok(lttng::numa::parse_cpu_list("a", cpus) == -1, "Reject a non-numeric list");
+}
+
+static void test_topology()
+{
+	lttng::numa::topology topology;
+	cpu_set_t cpu_set;
+
+	topology.add_node({ 0, 1, 4, 5 });
+	topology.add_node({ 2, 3, 6, 7 });
+
+	ok(topology.node_count() == 2, "Topology has two nodes");
+	ok(topology.cpu_node(4) == 0 && topology.cpu_node(6) == 1, "CPUs map to their node");
+	ok(topology.cpu_node(8) == -1 && topology.cpu_node(-1) == -1,
+	   "Unknown CPUs have no node");
+
+	topology.node_cpu_set(1, &cpu_set);
+	ok(CPU_COUNT(&cpu_set) == 4 && CPU_ISSET(2, &cpu_set) && CPU_ISSET(7, &cpu_set) &&
+		   !CPU_ISSET(0, &cpu_set),
+	   "Node CPU set contains the CPUs of the node");
+}
+
+static bool write_file(const std::string& path, const char *content)
+{
+	FILE *file = fopen(path.c_str(), "w");
+	bool success;
+
+	if (!file) {
+		return false;
+	}
+
+	success = fputs(content, file) >= 0;
+	return fclose(file) == 0 && success;
+}
+
+static void test_topology_from_sysfs()
+{
+	char tmpl[] = "/tmp/test-numa-XXXXXX";
+	const char *root = mkdtemp(tmpl);
+	bool setup_ok;
+
+	if (!root) {
+		diag("Failed to create temporary directory");
+		skip(3, "Test requires a temporary directory");
+		return;
+	}
+
+	const std::string root_path(root);
+
+	/* Node 1 is a memory-only node and has no CPUs. */
+	setup_ok = write_file(root_path + "/online", "0-2\n") &&
+		mkdir((root_path + "/node0").c_str(), 0700) == 0 &&
+		mkdir((root_path + "/node1").c_str(), 0700) == 0 &&
+		mkdir((root_path + "/node2").c_str(), 0700) == 0 &&
+		write_file(root_path + "/node0/cpulist", "0-1\n") &&
+		write_file(root_path + "/node1/cpulist", "\n") &&
+		write_file(root_path + "/node2/cpulist", "2-3\n");
+	if (!setup_ok) {
+		diag("Failed to populate temporary sysfs tree");
+		skip(2, "Test requires a populated sysfs tree");
+	} else {
+		const auto topology = lttng::numa::topology::from_sysfs(root);
+
+		ok(topology.node_count() == 2, "Nodes without CPUs are ignored");
+		ok(topology.cpu_node(1) == 0 && topology.cpu_node(3) == 1,
+		   "CPUs map to the dense index of their node");
+	}
+
+	unlink((root_path + "/node0/cpulist").c_str());
+	unlink((root_path + "/node1/cpulist").c_str());
+	unlink((root_path + "/node2/cpulist").c_str());
+	rmdir((root_path + "/node0").c_str());
+	rmdir((root_path + "/node1").c_str());
+	rmdir((root_path + "/node2").c_str());
+	unlink((root_path + "/online").c_str());
+
+	ok(lttng::numa::topology::from_sysfs(root).node_count() == 0,
+	   "Topology is empty when it can't be read");
+	rmdir(root);
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	diag("NUMA topology unit tests");
+
+	test_parse_cpu_list();
+	test_topology();
+	test_topology_from_sysfs();
+
+	return exit_status();
+}
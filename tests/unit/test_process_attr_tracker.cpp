@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 EfficiOS Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/tracker.hpp>
+
+#include <bin/lttng-sessiond/tracker.hpp>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <tap/tap.h>
+#include <urcu.h>
+#include <vector>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 11
+
+#ifdef HAVE_LIBLTTNG_UST_CTL
+#include <lttng/lttng-export.h>
+#include <lttng/ust-sigbus.h>
+LTTNG_EXPORT DEFINE_LTTNG_UST_SIGBUS_STATE();
+#endif
+
+/* For error.hpp */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+process_attr_tracker_status add_pid(process_attr_tracker *tracker, pid_t pid)
+{
+	process_attr_value value = {};
+
+	value.type = LTTNG_PROCESS_ATTR_VALUE_TYPE_PID;
+	value.value.pid = pid;
+	return process_attr_tracker_inclusion_set_add_value(tracker, &value);
+}
+
+process_attr_tracker_status remove_pid(process_attr_tracker *tracker, pid_t pid)
+{
+	process_attr_value value = {};
+
+	value.type = LTTNG_PROCESS_ATTR_VALUE_TYPE_PID;
+	value.value.pid = pid;
+	return process_attr_tracker_inclusion_set_remove_value(tracker, &value);
+}
+
+bool add_pids(process_attr_tracker *tracker, pid_t first, pid_t last)
+{
+	for (pid_t pid = first; pid <= last; pid++) {
+		if (add_pid(tracker, pid) != PROCESS_ATTR_TRACKER_STATUS_OK) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Check that the inclusion set holds exactly the expected PIDs, in order. */
+bool inclusion_set_is(const process_attr_tracker *tracker, const std::vector<pid_t>& expected)
+{
+	lttng_process_attr_values *values;
+	bool matches;
+
+	if (process_attr_tracker_get_inclusion_set(tracker, &values) !=
+	    PROCESS_ATTR_TRACKER_STATUS_OK) {
+		return false;
+	}
+
+	matches = _lttng_process_attr_values_get_count(values) == expected.size();
+	for (unsigned int i = 0; matches && i < expected.size(); i++) {
+		const process_attr_value *value =
+			lttng_process_attr_tracker_values_get_at_index(values, i);
+
+		matches = value->type == LTTNG_PROCESS_ATTR_VALUE_TYPE_PID &&
+			value->value.pid == expected[i];
+	}
+
+	lttng_process_attr_values_destroy(values);
+	return matches;
+}
+
+void test_ranges()
+{
+	process_attr_tracker *tracker = process_attr_tracker_create();
+
+	LTTNG_ASSERT(tracker);
+
+	ok(add_pid(tracker, 1) == PROCESS_ATTR_TRACKER_STATUS_INVALID_TRACKING_POLICY,
+	   "Adding a value requires the include set tracking policy");
+	ok(process_attr_tracker_set_tracking_policy(tracker, LTTNG_TRACKING_POLICY_INCLUDE_SET) ==
+		   0,
+	   "Set the include set tracking policy");
+
+	/* Out of order, to create ranges which are then merged. */
+	ok(add_pids(tracker, 10, 14) && add_pids(tracker, 20, 24) && add_pid(tracker, 16) ==
+		   PROCESS_ATTR_TRACKER_STATUS_OK &&
+		   add_pid(tracker, 15) == PROCESS_ATTR_TRACKER_STATUS_OK &&
+		   add_pids(tracker, 17, 19) && add_pid(tracker, 5) == PROCESS_ATTR_TRACKER_STATUS_OK,
+	   "Add values out of order");
+	ok(inclusion_set_is(tracker, { 5,  10, 11, 12, 13, 14, 15, 16,
+				       17, 18, 19, 20, 21, 22, 23, 24 }),
+	   "Inclusion set holds all the values, in order");
+
+	ok(add_pid(tracker, 10) == PROCESS_ATTR_TRACKER_STATUS_EXISTS &&
+		   add_pid(tracker, 17) == PROCESS_ATTR_TRACKER_STATUS_EXISTS &&
+		   add_pid(tracker, 24) == PROCESS_ATTR_TRACKER_STATUS_EXISTS,
+	   "Adding a value of a range reports that it exists");
+	ok(remove_pid(tracker, 4) == PROCESS_ATTR_TRACKER_STATUS_MISSING &&
+		   remove_pid(tracker, 6) == PROCESS_ATTR_TRACKER_STATUS_MISSING &&
+		   remove_pid(tracker, 25) == PROCESS_ATTR_TRACKER_STATUS_MISSING,
+	   "Removing a value outside of the ranges reports that it is missing");
+
+	ok(remove_pid(tracker, 17) == PROCESS_ATTR_TRACKER_STATUS_OK &&
+		   remove_pid(tracker, 10) == PROCESS_ATTR_TRACKER_STATUS_OK &&
+		   remove_pid(tracker, 24) == PROCESS_ATTR_TRACKER_STATUS_OK &&
+		   remove_pid(tracker, 5) == PROCESS_ATTR_TRACKER_STATUS_OK,
+	   "Remove values in the middle, at the start and at the end of ranges");
+	ok(inclusion_set_is(tracker, { 11, 12, 13, 14, 15, 16, 18, 19, 20, 21, 22, 23 }),
+	   "Inclusion set only holds the remaining values");
+	ok(remove_pid(tracker, 17) == PROCESS_ATTR_TRACKER_STATUS_MISSING,
+	   "Removing a value twice reports that it is missing");
+
+	ok(add_pid(tracker, 17) == PROCESS_ATTR_TRACKER_STATUS_OK &&
+		   inclusion_set_is(tracker,
+				    { 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23 }),
+	   "Adding back a removed value joins the ranges");
+
+	ok(process_attr_tracker_set_tracking_policy(tracker, LTTNG_TRACKING_POLICY_INCLUDE_ALL) ==
+			   0 &&
+		   process_attr_tracker_set_tracking_policy(
+			   tracker, LTTNG_TRACKING_POLICY_INCLUDE_SET) == 0 &&
+		   inclusion_set_is(tracker, {}),
+	   "Changing the tracking policy clears the inclusion set");
+
+	process_attr_tracker_destroy(tracker);
+}
+} /* namespace */
+
+int main()
+{
+	plan_tests(NUM_TESTS);
+
+	diag("Process attribute tracker unit tests");
+
+	rcu_register_thread();
+	test_ranges();
+	rcu_unregister_thread();
+
+	return exit_status();
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/readwrite.hpp>
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <tap/tap.h>
+#include <unistd.h>
+
+static const int TEST_COUNT = 7;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_writev_gather()
+{
+	int pipe_fds[2];
+	char header[] = "header";
+	char payload[] = "payload";
+	char result[sizeof(header) + sizeof(payload)] = {};
+	struct iovec iov[3];
+	ssize_t ret;
+
+	if (pipe(pipe_fds)) {
+		diag("Failed to create pipe");
+		skip(4, "Test requires a pipe");
+		return;
+	}
+
+	iov[0].iov_base = header;
+	iov[0].iov_len = sizeof(header);
+	/* Empty buffers are skipped. */
+	iov[1].iov_base = nullptr;
+	iov[1].iov_len = 0;
+	iov[2].iov_base = payload;
+	iov[2].iov_len = sizeof(payload);
+
+	ret = lttng_writev(pipe_fds[1], iov, 3);
+	ok(ret == sizeof(header) + sizeof(payload), "lttng_writev writes all buffers");
+
+	ret = lttng_read(pipe_fds[0], result, sizeof(result));
+	ok(ret == sizeof(result), "Gathered data can be read back");
+	ok(!memcmp(result, header, sizeof(header)) &&
+		   !memcmp(result + sizeof(header), payload, sizeof(payload)),
+	   "Gathered data is written in order");
+
+	ret = lttng_writev(pipe_fds[1], iov, 0);
+	ok(ret == 0, "lttng_writev of no buffers writes nothing");
+
+	(void) close(pipe_fds[0]);
+	(void) close(pipe_fds[1]);
+}
+
+static void test_writev_errors()
+{
+	char byte = 'a';
+	struct iovec iov[2];
+	ssize_t ret;
+
+	iov[0].iov_base = &byte;
+	iov[0].iov_len = sizeof(byte);
+
+	ret = lttng_writev(-1, iov, 1);
+	ok(ret == -1 && errno == EBADF, "lttng_writev fails on an invalid fd");
+
+	iov[1].iov_base = &byte;
+	iov[1].iov_len = SSIZE_MAX;
+	ret = lttng_writev(-1, iov, 2);
+	ok(ret == -EINVAL, "lttng_writev rejects a total length larger than SSIZE_MAX");
+
+	iov[0].iov_len = 0;
+	ret = lttng_writev(-1, iov, 1);
+	ok(ret == 0, "lttng_writev of an empty buffer writes nothing");
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	test_writev_gather();
+	test_writev_errors();
+
+	return exit_status();
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/slab-allocator.hpp>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <tap/tap.h>
+#include <vector>
+
+static const int TEST_COUNT = 8;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+struct test_object {
+	uint64_t values[8];
+};
+
+struct free_thread_data {
+	lttng::slab_allocator *allocator;
+	std::vector<test_object *> *objects;
+};
+
+void *free_objects_thread(void *_data)
+{
+	auto *data = static_cast<free_thread_data *>(_data);
+
+	for (auto object : *data->objects) {
+		data->allocator->free(object);
+	}
+
+	/* The objects left in the cache of this thread return to the depot on exit. */
+	return nullptr;
+}
+} /* namespace */
+
+static void test_reuse()
+{
+	static lttng::slab_allocator allocator("test_reuse", sizeof(test_object), 4, 64);
+	test_object *object, *reused;
+	bool zeroed = true;
+
+	object = allocator.zalloc<test_object>();
+	memset(object, 0xff, sizeof(*object));
+	allocator.free(object);
+	reused = allocator.zalloc<test_object>();
+
+	for (const auto value : reused->values) {
+		zeroed = zeroed && value == 0;
+	}
+
+	ok(reused == object, "Freed object is reused by the next allocation");
+	ok(zeroed, "Reused object is zeroed");
+
+	allocator.free(reused);
+	allocator.free(nullptr);
+
+	const auto stats = allocator.get_stats();
+	ok(stats.allocations == 2 && stats.frees == 2 && stats.system_allocations == 1 &&
+		   stats.system_frees == 0,
+	   "Statistics account for the reused object");
+}
+
+static void test_batches()
+{
+	static lttng::slab_allocator allocator("test_batches", sizeof(test_object), 4, 64);
+	std::vector<test_object *> objects;
+
+	for (unsigned int i = 0; i < 32; i++) {
+		objects.push_back(allocator.zalloc<test_object>());
+	}
+
+	for (auto object : objects) {
+		allocator.free(object);
+	}
+
+	objects.clear();
+	for (unsigned int i = 0; i < 32; i++) {
+		objects.push_back(allocator.zalloc<test_object>());
+	}
+
+	ok(allocator.get_stats().system_allocations == 32,
+	   "Objects flushed to the depot are reused by the same thread");
+
+	for (auto object : objects) {
+		allocator.free(object);
+	}
+}
+
+static void test_cross_thread()
+{
+	static lttng::slab_allocator allocator("test_cross_thread", sizeof(test_object), 8, 1024);
+	std::vector<test_object *> objects;
+	free_thread_data data = { &allocator, &objects };
+	pthread_t thread;
+
+	for (unsigned int i = 0; i < 100; i++) {
+		objects.push_back(allocator.zalloc<test_object>());
+	}
+
+	ok(pthread_create(&thread, nullptr, free_objects_thread, &data) == 0 &&
+		   pthread_join(thread, nullptr) == 0,
+	   "Objects freed by another thread");
+
+	objects.clear();
+	for (unsigned int i = 0; i < 100; i++) {
+		objects.push_back(allocator.zalloc<test_object>());
+	}
+
+	ok(allocator.get_stats().system_allocations == 100,
+	   "Objects freed by another thread are reused by the allocating thread");
+
+	for (auto object : objects) {
+		allocator.free(object);
+	}
+}
+
+static void test_depot_limit()
+{
+	static lttng::slab_allocator allocator("test_depot_limit", sizeof(test_object), 4, 16);
+	std::vector<test_object *> objects;
+
+	for (unsigned int i = 0; i < 64; i++) {
+		objects.push_back(allocator.zalloc<test_object>());
+	}
+
+	for (auto object : objects) {
+		allocator.free(object);
+	}
+
+	const auto stats = allocator.get_stats();
+	/* At most 16 objects in the depot and 2 * 4 - 1 in the thread cache. */
+	ok(stats.system_frees >= 64 - 16 - 7, "Objects in excess of the depot are freed");
+	ok(stats.frees == 64, "Every free is accounted for");
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	diag("Slab allocator unit tests");
+
+	test_reuse();
+	test_batches();
+	test_cross_thread();
+	test_depot_limit();
+
+	return exit_status();
+}
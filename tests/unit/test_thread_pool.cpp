@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/macros.hpp>
+#include <common/thread-pool.hpp>
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <tap/tap.h>
+#include <time.h>
+#include <urcu/uatomic.h>
+
+static const int TEST_COUNT = 9;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+namespace {
+const unsigned int work_count = 1000;
+/* Depth of the trees of works submitted by the works themselves. */
+const unsigned int fan_out_depth = 6;
+
+struct counting_work {
+	struct lttng_thread_pool_work work;
+	struct lttng_thread_pool *pool;
+	unsigned int *counter;
+	/* Works submitted by this work, two per level. */
+	unsigned int depth;
+};
+
+struct blocking_work {
+	struct lttng_thread_pool_work work;
+	struct lttng_thread_pool *pool;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool released;
+	bool timed_out;
+	struct lttng_thread_pool_work releasing_work;
+};
+
+void run_counting_work(struct lttng_thread_pool_work *_work)
+{
+	auto *work = lttng::utils::container_of(_work, &counting_work::work);
+
+	uatomic_inc(work->counter);
+	for (unsigned int i = 0; i < 2 && work->depth > 0; i++) {
+		auto *child = new counting_work(*work);
+
+		child->depth = work->depth - 1;
+		if (!lttng_thread_pool_submit(work->pool, &child->work)) {
+			delete child;
+		}
+	}
+
+	delete work;
+}
+
+void run_releasing_work(struct lttng_thread_pool_work *_work)
+{
+	auto *work = lttng::utils::container_of(_work, &blocking_work::releasing_work);
+
+	pthread_mutex_lock(&work->lock);
+	work->released = true;
+	pthread_cond_signal(&work->cond);
+	pthread_mutex_unlock(&work->lock);
+}
+
+/*
+ * Queue a work to the queue of the thread running this one, then wait for it
+ * to be run by another thread.
+ */
+void run_blocking_work(struct lttng_thread_pool_work *_work)
+{
+	auto *work = lttng::utils::container_of(_work, &blocking_work::work);
+	struct timespec deadline;
+
+	work->releasing_work.run = run_releasing_work;
+	(void) lttng_thread_pool_submit(work->pool, &work->releasing_work);
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += 10;
+	pthread_mutex_lock(&work->lock);
+	while (!work->released && !work->timed_out) {
+		work->timed_out = pthread_cond_timedwait(&work->cond, &work->lock, &deadline) != 0;
+	}
+	pthread_mutex_unlock(&work->lock);
+}
+
+struct lttng_thread_pool *create_pool(unsigned int thread_count)
+{
+	struct lttng_thread_pool_attr attr = {};
+
+	attr.name = "test";
+	attr.thread_count = thread_count;
+	return lttng_thread_pool_create(&attr);
+}
+
+void wait_for_completion(struct lttng_thread_pool *pool, uint64_t count)
+{
+	struct lttng_thread_pool_stats stats;
+
+	do {
+		lttng_thread_pool_get_stats(pool, &stats);
+	} while (stats.completed < count);
+}
+} /* namespace */
+
+static void test_run_submitted_works()
+{
+	struct lttng_thread_pool *pool = create_pool(4);
+	struct lttng_thread_pool_stats stats;
+	unsigned int counter = 0;
+	bool submitted = true;
+
+	ok(pool, "Thread pool created");
+	if (!pool) {
+		skip(3, "No thread pool");
+		return;
+	}
+
+	for (unsigned int i = 0; i < work_count; i++) {
+		auto *work = new counting_work();
+
+		work->work.run = run_counting_work;
+		work->pool = pool;
+		work->counter = &counter;
+		submitted = lttng_thread_pool_submit(pool, &work->work) && submitted;
+	}
+
+	ok(submitted, "Works submitted from outside the pool are accepted");
+	wait_for_completion(pool, work_count);
+	lttng_thread_pool_get_stats(pool, &stats);
+	ok(uatomic_read(&counter) == work_count, "All the submitted works ran");
+	ok(stats.submitted == work_count && stats.completed == work_count && stats.queued == 0 &&
+		   stats.max_queued >= 1,
+	   "Statistics account for the submitted works");
+	lttng_thread_pool_destroy(pool);
+}
+
+static void test_fan_out()
+{
+	struct lttng_thread_pool *pool = create_pool(3);
+	const unsigned int expected_count = (1U << (fan_out_depth + 1)) - 1;
+	unsigned int counter = 0;
+	auto *work = new counting_work();
+
+	work->work.run = run_counting_work;
+	work->pool = pool;
+	work->counter = &counter;
+	work->depth = fan_out_depth;
+	ok(lttng_thread_pool_submit(pool, &work->work), "Fan-out root work submitted");
+	wait_for_completion(pool, expected_count);
+	ok(uatomic_read(&counter) == expected_count,
+	   "Works submitted from the pool threads ran: count = %u",
+	   uatomic_read(&counter));
+	lttng_thread_pool_destroy(pool);
+}
+
+static void test_steal()
+{
+	struct lttng_thread_pool *pool = create_pool(2);
+	struct lttng_thread_pool_stats stats;
+	struct blocking_work work = {};
+
+	pthread_mutex_init(&work.lock, nullptr);
+	pthread_cond_init(&work.cond, nullptr);
+	work.work.run = run_blocking_work;
+	work.pool = pool;
+	ok(lttng_thread_pool_submit(pool, &work.work), "Blocking work submitted");
+	wait_for_completion(pool, 2);
+	lttng_thread_pool_get_stats(pool, &stats);
+	ok(work.released && !work.timed_out,
+	   "Work queued behind a blocked work is run by another thread");
+	ok(stats.stolen >= 1, "Stolen work is accounted for: stolen = %" PRIu64, stats.stolen);
+	lttng_thread_pool_destroy(pool);
+	pthread_cond_destroy(&work.cond);
+	pthread_mutex_destroy(&work.lock);
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+	diag("Thread pool unit tests");
+
+	test_run_submitted_works();
+	test_fan_out();
+	test_steal();
+
+	return exit_status();
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/timer-wheel.hpp>
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdlib.h>
+#include <tap/tap.h>
+#include <vector>
+
+static const int TEST_COUNT = 16;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_empty()
+{
+	lttng::timer_wheel wheel(10);
+	std::vector<lttng::timer_wheel::entry *> expired;
+
+	ok(wheel.empty() && wheel.next_tick() == UINT64_MAX, "New wheel is empty");
+
+	wheel.advance(1000, expired);
+	ok(expired.empty() && wheel.current_tick() == 1000, "Empty wheel advances to any tick");
+}
+
+static void test_schedule_cancel()
+{
+	lttng::timer_wheel wheel;
+	lttng::timer_wheel::entry first, second;
+	std::vector<lttng::timer_wheel::entry *> expired;
+
+	wheel.schedule(first, 5);
+	wheel.schedule(second, 7);
+	ok(wheel.next_tick() == 5, "Next tick is the earliest expiry");
+
+	wheel.advance(4, expired);
+	ok(expired.empty(), "No entry expires before its expiry tick");
+
+	wheel.cancel(first);
+	wheel.advance(6, expired);
+	ok(expired.empty() && !first.scheduled, "Cancelled entry does not expire");
+
+	wheel.advance(7, expired);
+	ok(expired.size() == 1 && expired[0] == &second && !second.scheduled && wheel.empty(),
+	   "Entry expires at its expiry tick");
+
+	expired.clear();
+	wheel.schedule(first, 3);
+	ok(first.expiry_tick == 8, "Expiry in the past is moved to the next tick");
+
+	wheel.schedule(first, 100);
+	wheel.advance(99, expired);
+	ok(expired.empty() && first.scheduled, "Rescheduled entry moves to its new expiry");
+	wheel.cancel(first);
+}
+
+static void test_coalescing()
+{
+	lttng::timer_wheel wheel;
+	std::vector<lttng::timer_wheel::entry> entries(1000);
+	std::vector<lttng::timer_wheel::entry *> expired;
+
+	for (auto& entry : entries) {
+		wheel.schedule(entry, 5000);
+	}
+
+	wheel.advance(4999, expired);
+	ok(expired.empty(), "Coalesced entries do not expire early");
+
+	wheel.advance(5000, expired);
+	ok(expired.size() == entries.size(), "Entries of the same tick expire together");
+}
+
+static bool expires_exactly_at(lttng::timer_wheel& wheel, uint64_t tick)
+{
+	lttng::timer_wheel::entry entry;
+	std::vector<lttng::timer_wheel::entry *> expired;
+
+	wheel.schedule(entry, tick);
+	if (wheel.next_tick() > tick) {
+		return false;
+	}
+
+	wheel.advance(tick - 1, expired);
+	if (!expired.empty()) {
+		return false;
+	}
+
+	wheel.advance(tick, expired);
+	return expired.size() == 1 && expired[0] == &entry;
+}
+
+static void test_levels()
+{
+	lttng::timer_wheel wheel(123);
+
+	ok(expires_exactly_at(wheel, 123 + 64), "Entry of the second level expires on time");
+	ok(expires_exactly_at(wheel, wheel.current_tick() + 300000),
+	   "Entry of a high level expires on time");
+	ok(expires_exactly_at(wheel, wheel.current_tick() + (UINT64_C(1) << 40) + 17),
+	   "Entry beyond the range of the wheel expires on time");
+}
+
+static void test_random()
+{
+	lttng::timer_wheel wheel(42);
+	std::vector<lttng::timer_wheel::entry> entries(5000);
+	std::vector<lttng::timer_wheel::entry *> expired;
+	std::vector<uint64_t> expiries(entries.size());
+	bool on_time = true, next_tick_ok = true;
+	size_t expired_count = 0, cancelled_count = 0;
+
+	srand(1234);
+	for (size_t i = 0; i < entries.size(); i++) {
+		expiries[i] = 43 + (uint64_t) rand() % 200000;
+		wheel.schedule(entries[i], expiries[i]);
+	}
+
+	for (size_t i = 0; i < entries.size(); i += 7) {
+		wheel.cancel(entries[i]);
+		cancelled_count++;
+	}
+
+	while (!wheel.empty()) {
+		const uint64_t previous_tick = wheel.current_tick();
+		uint64_t earliest = UINT64_MAX;
+
+		for (const auto& entry : entries) {
+			if (entry.scheduled) {
+				earliest = std::min(earliest, entry.expiry_tick);
+			}
+		}
+
+		next_tick_ok &= wheel.next_tick() <= earliest;
+
+		expired.clear();
+		wheel.advance(previous_tick + 1 + (uint64_t) rand() % 3000, expired);
+		for (const auto entry : expired) {
+			const size_t i = entry - entries.data();
+
+			on_time &= expiries[i] > previous_tick &&
+				expiries[i] <= wheel.current_tick() && i % 7 != 0;
+		}
+
+		expired_count += expired.size();
+	}
+
+	ok(on_time, "Random entries expire during the advance covering their expiry");
+	ok(next_tick_ok, "Next tick is never later than the earliest expiry");
+	ok(expired_count + cancelled_count == entries.size(),
+	   "Every entry either expires or is cancelled");
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	diag("Timer wheel unit tests");
+
+	test_empty();
+	test_schedule_cancel();
+	test_coalescing();
+	test_levels();
+	test_random();
+
+	return exit_status();
+}
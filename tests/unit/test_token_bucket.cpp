@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include "token-bucket.hpp"
+
+#include <common/time.hpp>
+
+#include <tap/tap.h>
+
+static const int TEST_COUNT = 5;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+/* Period of the coarse monotonic clock of a 250 Hz kernel. */
+static const uint64_t TICK_NS = 4000000;
+
+/* Arbitrary start time, the first refill fills the bucket. */
+static const uint64_t START_NS = NSEC_PER_SEC;
+
+static void test_first_refill()
+{
+	struct token_bucket bucket;
+
+	token_bucket_init(&bucket, 1000);
+	ok(token_bucket_refill_at(&bucket, START_NS) == 0 && bucket.tokens == 1000,
+	   "The first refill fills the bucket");
+}
+
+static void test_low_rate_refilled_every_tick()
+{
+	struct token_bucket bucket;
+	uint64_t now_ns = START_NS;
+
+	/* 100 tokens per second, that is 0.4 token per tick. */
+	token_bucket_init(&bucket, 100);
+	(void) token_bucket_refill_at(&bucket, now_ns);
+	token_bucket_consume(&bucket, 100);
+
+	for (unsigned int i = 0; i < 25; i++) {
+		now_ns += TICK_NS;
+		(void) token_bucket_refill_at(&bucket, now_ns);
+	}
+
+	ok(bucket.tokens == 10, "A low rate bucket refilled every tick gets 10 tokens in 100 ms");
+
+	for (unsigned int i = 0; i < 225; i++) {
+		now_ns += TICK_NS;
+		(void) token_bucket_refill_at(&bucket, now_ns);
+	}
+
+	ok(bucket.tokens == 100, "A low rate bucket refilled every tick is full after 1 s");
+}
+
+static void test_capacity()
+{
+	struct token_bucket bucket;
+
+	token_bucket_init(&bucket, 100);
+	(void) token_bucket_refill_at(&bucket, START_NS);
+	ok(token_bucket_refill_at(&bucket, START_NS + 10 * NSEC_PER_SEC) == NSEC_PER_SEC &&
+		   bucket.tokens == 100,
+	   "A bucket holds at most one second worth of tokens");
+}
+
+static void test_deficit()
+{
+	struct token_bucket bucket;
+
+	token_bucket_init(&bucket, 100);
+	(void) token_bucket_refill_at(&bucket, START_NS);
+	token_bucket_consume(&bucket, 102);
+	ok(token_bucket_deficit_ns(&bucket) == 20000000,
+	   "Two overspent tokens at 100 tokens per second take 20 ms to refill");
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	diag("Token bucket unit tests");
+
+	test_first_refill();
+	test_low_rate_refilled_every_tick();
+	test_capacity();
+	test_deficit();
+
+	return exit_status();
+}
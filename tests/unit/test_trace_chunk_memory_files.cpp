@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <common/compat/directory-handle.hpp>
+#include <common/fs-handle.hpp>
+#include <common/trace-chunk.hpp>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <tap/tap.h>
+#include <unistd.h>
+
+static const int TEST_COUNT = 7;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static const char file_content[] = "packet";
+
+static bool path_exists(const char *dir, const char *name)
+{
+	char path[PATH_MAX];
+	struct stat st;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	return stat(path, &st) == 0;
+}
+
+static void test_memory_files(struct lttng_trace_chunk *chunk, const char *dir)
+{
+	struct fs_handle *writer = nullptr, *reader = nullptr;
+	struct lttng_trace_chunk *copy;
+	char buf[sizeof(file_content)] = {};
+	enum lttng_trace_chunk_status status;
+
+	status = lttng_trace_chunk_create_subdirectory(chunk, "channel/index");
+	ok(status == LTTNG_TRACE_CHUNK_STATUS_OK && !path_exists(dir, "channel"),
+	   "Subdirectories of a chunk with memory files are not created");
+
+	status = lttng_trace_chunk_open_fs_handle(
+		chunk, "channel/stream_0", O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR, &writer, false);
+	ok(status == LTTNG_TRACE_CHUNK_STATUS_OK &&
+		   fs_handle_write(writer, file_content, sizeof(file_content)) ==
+			   sizeof(file_content) &&
+		   !path_exists(dir, "channel/stream_0"),
+	   "Files of a chunk with memory files are written in memory");
+
+	copy = lttng_trace_chunk_copy(chunk);
+	status = copy ? lttng_trace_chunk_open_fs_handle(
+				copy, "channel/stream_0", O_RDONLY, 0, &reader, false) :
+			LTTNG_TRACE_CHUNK_STATUS_ERROR;
+	ok(status == LTTNG_TRACE_CHUNK_STATUS_OK &&
+		   fs_handle_read(reader, buf, sizeof(buf)) == sizeof(buf) &&
+		   !memcmp(buf, file_content, sizeof(buf)),
+	   "Copies of a chunk read its memory files from the start");
+
+	ok(fs_handle_seek(writer, 0, SEEK_CUR) == sizeof(file_content),
+	   "Handles of a memory file have their own offset");
+
+	ok(lttng_trace_chunk_unlink_file(chunk, "channel/stream_0") == 0,
+	   "Unlink a memory file");
+
+	ok(fs_handle_seek(reader, 0, SEEK_SET) == 0 &&
+		   fs_handle_read(reader, buf, sizeof(buf)) == sizeof(buf),
+	   "Unlinked memory files remain readable through their handles");
+
+	if (reader) {
+		fs_handle_close(reader);
+		reader = nullptr;
+	}
+	status = copy ? lttng_trace_chunk_open_fs_handle(
+				copy, "channel/stream_0", O_RDONLY, 0, &reader, true) :
+			LTTNG_TRACE_CHUNK_STATUS_ERROR;
+	ok(status == LTTNG_TRACE_CHUNK_STATUS_NO_FILE, "Unlinked memory files can't be opened");
+
+	if (reader) {
+		fs_handle_close(reader);
+	}
+	if (writer) {
+		fs_handle_close(writer);
+	}
+	lttng_trace_chunk_put(copy);
+}
+
+int main()
+{
+	char tmpl[] = "/tmp/test-trace-chunk-XXXXXX";
+	const char *dir;
+	struct lttng_directory_handle *dir_handle = nullptr;
+	struct lttng_trace_chunk *chunk = nullptr;
+
+	plan_tests(TEST_COUNT);
+
+	diag("Trace chunk memory files tests");
+
+#ifndef HAVE_MEMFD_CREATE
+	skip(TEST_COUNT, "Memory files are not supported on this platform");
+	return exit_status();
+#endif /* HAVE_MEMFD_CREATE */
+
+	dir = mkdtemp(tmpl);
+	if (dir) {
+		dir_handle = lttng_directory_handle_create(dir);
+	}
+	chunk = lttng_trace_chunk_create_anonymous();
+	if (!dir_handle || !chunk ||
+	    lttng_trace_chunk_set_memory_files(chunk) != LTTNG_TRACE_CHUNK_STATUS_OK ||
+	    lttng_trace_chunk_set_credentials_current_user(chunk) != LTTNG_TRACE_CHUNK_STATUS_OK ||
+	    lttng_trace_chunk_set_as_owner(chunk, dir_handle) != LTTNG_TRACE_CHUNK_STATUS_OK) {
+		diag("Failed to create a trace chunk with memory files");
+		skip(TEST_COUNT, "Test requires a trace chunk");
+	} else {
+		test_memory_files(chunk, dir);
+	}
+
+	lttng_trace_chunk_put(chunk);
+	lttng_directory_handle_put(dir_handle);
+	if (dir && rmdir(dir)) {
+		diag("Failed to remove temporary directory");
+	}
+
+	return exit_status();
+}
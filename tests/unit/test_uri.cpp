@@ -16,7 +16,7 @@ int lttng_opt_verbose = 3;
 int lttng_opt_mi;
 
 /* Number of TAP tests in this file */
-#define NUM_TESTS 11
+#define NUM_TESTS 13
 
 static void test_uri_parsing()
 {
@@ -133,6 +133,25 @@ static void test_uri_parsing()
 		uri = nullptr;
 	}
 
+	s_uri1 = "unix:///run/lttng/relayd-control";
+
+	size = uri_parse(s_uri1, &uri);
+
+	ok(size == 1 && uri[0].dtype == LTTNG_DST_UNIX && uri[0].utype == LTTNG_URI_DST &&
+		   uri[0].proto == LTTNG_TCP && uri[0].port == 0 && strlen(uri[0].subdir) == 0 &&
+		   strcmp(uri[0].dst.path, "/run/lttng/relayd-control") == 0,
+	   "URI set to unix:///run/lttng/relayd-control");
+
+	if (uri) {
+		uri_free(uri);
+		uri = nullptr;
+	}
+
+	s_uri1 = "unix://run/lttng/relayd-control";
+	size = uri_parse(s_uri1, &uri);
+	ok(size == -1, "Bad URI set to unix://run/lttng/relayd-control");
+	LTTNG_ASSERT(!uri);
+
 	/* FIXME: Noisy on stdout */
 	s_uri1 = "file/my/test/path";
 	size = uri_parse(s_uri1, &uri);
@@ -29,7 +29,7 @@
 #define RANDOM_STRING_LEN 11
 
 /* Number of TAP tests in this file */
-#define NUM_TESTS 16
+#define NUM_TESTS 20
 
 LTTNG_EXPORT DEFINE_LTTNG_UST_SIGBUS_STATE();
 
@@ -260,6 +260,71 @@ static void test_create_ust_context()
 	free(uctx);
 }
 
+static void test_ust_setup_plan()
+{
+	struct ltt_ust_session *usess;
+	struct ltt_ust_channel *uchan;
+	struct ltt_ust_event *event;
+	struct lttng_channel attr;
+	struct lttng_channel_extended extended;
+	struct lttng_event ev;
+	const struct ltt_ust_setup_plan *plan;
+	const struct ltt_ust_setup_plan_channel *plan_channel;
+
+	usess = trace_ust_create_session(42);
+	memset(&attr, 0, sizeof(attr));
+	memset(&extended, 0, sizeof(extended));
+	attr.attr.extended.ptr = &extended;
+	strcpy(attr.name, "channel0");
+	uchan = usess ? trace_ust_create_channel(&attr, LTTNG_DOMAIN_UST) : nullptr;
+
+	memset(&ev, 0, sizeof(ev));
+	strcpy(ev.name, "event0");
+	ev.type = LTTNG_EVENT_TRACEPOINT;
+	ev.loglevel_type = LTTNG_EVENT_LOGLEVEL_ALL;
+	if (!uchan ||
+	    trace_ust_create_event(&ev, nullptr, nullptr, nullptr, false, &event) != LTTNG_OK) {
+		skip(4, "Failed to create the UST session objects");
+		goto end;
+	}
+
+	lttng_ht_add_unique_str(usess->domain_global.channels, &uchan->node);
+	plan = trace_ust_get_setup_plan(usess);
+	ok(plan && lttng_dynamic_array_get_count(&plan->channels) == 1,
+	   "Build UST session setup plan");
+
+	plan_channel = plan ? (const ltt_ust_setup_plan_channel *) lttng_dynamic_array_get_element(
+				      &plan->channels, 0) :
+			      nullptr;
+	ok(plan_channel && plan_channel->uchan == uchan &&
+		   lttng_dynamic_pointer_array_get_count(&plan_channel->events) == 0,
+	   "Validate UST session setup plan channel");
+
+	ok(trace_ust_get_setup_plan(usess) == plan, "Reuse UST session setup plan");
+
+	lttng_ht_add_str(uchan->events, &event->node);
+	trace_ust_invalidate_setup_plan(usess);
+	plan = trace_ust_get_setup_plan(usess);
+	plan_channel = plan ? (const ltt_ust_setup_plan_channel *) lttng_dynamic_array_get_element(
+				      &plan->channels, 0) :
+			      nullptr;
+	ok(plan_channel && lttng_dynamic_pointer_array_get_count(&plan_channel->events) == 1 &&
+		   lttng_dynamic_pointer_array_get_pointer(&plan_channel->events, 0) == event,
+	   "Rebuild invalidated UST session setup plan");
+
+	/* The session owns the channel and its event from then on. */
+	uchan = nullptr;
+end:
+	if (uchan) {
+		trace_ust_destroy_channel(uchan);
+	}
+
+	if (usess) {
+		trace_ust_destroy_session(usess);
+		trace_ust_free_session(usess);
+	}
+}
+
 int main()
 {
 	plan_tests(NUM_TESTS);
@@ -273,6 +338,7 @@ int main()
 	test_create_ust_event();
 	test_create_ust_context();
 	test_create_ust_event_exclusion();
+	test_ust_setup_plan();
 
 	rcu_unregister_thread();
 
@@ -44,7 +44,7 @@ int lttng_opt_mi;
 #define MAGIC_VALUE ((char) 0x5A)
 
 #ifdef HAVE_EPOLL
-#define NUM_TESTS 48
+#define NUM_TESTS 52
 #else
 #define NUM_TESTS 47
 #endif
@@ -64,6 +64,30 @@ static void test_epoll_compat()
 	 */
 	ok((int) LTTNG_CLOEXEC == (int) CLOE_VALUE, "epoll's CLOEXEC value");
 }
+
+static void test_edge_triggered()
+{
+	struct lttng_poll_event poll_events;
+	int fds[2];
+	char tbuf = MAGIC_VALUE;
+
+	lttng_poll_init(&poll_events);
+	LTTNG_ASSERT(pipe(fds) == 0);
+	LTTNG_ASSERT(lttng_poll_create(&poll_events, 1, 0) == 0);
+
+	ok(lttng_poll_add(&poll_events, fds[0], LPOLLIN | LPOLLET) == 0,
+	   "Add edge-triggered FD succeeds");
+	LTTNG_ASSERT(lttng_write(fds[1], &tbuf, 1) == 1);
+	ok(lttng_poll_wait(&poll_events, 0) == 1, "Edge-triggered FD is reported once ready");
+	ok(lttng_poll_wait(&poll_events, 0) == 0,
+	   "Edge-triggered FD is not reported again until it becomes ready again");
+	LTTNG_ASSERT(lttng_write(fds[1], &tbuf, 1) == 1);
+	ok(lttng_poll_wait(&poll_events, 0) == 1, "Edge-triggered FD is reported once ready again");
+
+	lttng_poll_clean(&poll_events);
+	(void) close(fds[0]);
+	(void) close(fds[1]);
+}
 #endif
 
 static void test_alloc()
@@ -344,6 +368,7 @@ int main()
 	plan_tests(NUM_TESTS);
 #ifdef HAVE_EPOLL
 	test_epoll_compat();
+	test_edge_triggered();
 #endif
 	test_func_def();
 	test_alloc();
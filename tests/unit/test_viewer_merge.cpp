@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 EfficiOS, inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include "viewer-merge.hpp"
+
+#include <common/compat/endian.hpp>
+
+#include <stdlib.h>
+#include <tap/tap.h>
+
+static const int TEST_COUNT = 5;
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static int push(struct viewer_merge *merge, uint64_t stream_id, uint64_t timestamp_begin)
+{
+	struct lttng_viewer_index index = {};
+
+	index.timestamp_begin = htobe64(timestamp_begin);
+	return viewer_merge_push(merge, stream_id, &index);
+}
+
+static void test_order()
+{
+	struct viewer_merge merge;
+	const uint64_t timestamps[] = { 40, 10, 30, 10, 50, 20, 0, 30 };
+	uint64_t previous_begin = 0, previous_stream = 0;
+	bool pushed = true, ordered = true;
+	unsigned int popped = 0;
+
+	viewer_merge_init(&merge);
+	for (unsigned int i = 0; i < sizeof(timestamps) / sizeof(timestamps[0]); i++) {
+		pushed &= push(&merge, i, timestamps[i]) == 0;
+	}
+	ok(pushed, "Push the heads of 8 streams");
+
+	while (const struct viewer_merge_head *top = viewer_merge_top(&merge)) {
+		const uint64_t begin = be64toh(top->index.timestamp_begin);
+
+		if (popped > 0 &&
+		    (begin < previous_begin ||
+		     (begin == previous_begin && top->stream_id < previous_stream))) {
+			ordered = false;
+		}
+
+		previous_begin = begin;
+		previous_stream = top->stream_id;
+		viewer_merge_pop(&merge);
+		popped++;
+	}
+
+	ok(ordered && popped == 8, "Pop the heads by beginning timestamp, then stream");
+	viewer_merge_fini(&merge);
+}
+
+static void test_has_head()
+{
+	struct viewer_merge merge;
+
+	viewer_merge_init(&merge);
+	ok(!viewer_merge_top(&merge), "Empty merge has no top");
+
+	(void) push(&merge, 3, 100);
+	(void) push(&merge, 7, 50);
+	ok(viewer_merge_has_head(&merge, 3) && viewer_merge_has_head(&merge, 7) &&
+		   !viewer_merge_has_head(&merge, 5),
+	   "Find the heads of the pushed streams");
+
+	viewer_merge_pop(&merge);
+	ok(viewer_merge_has_head(&merge, 3) && !viewer_merge_has_head(&merge, 7),
+	   "Pop the head which begins first");
+	viewer_merge_fini(&merge);
+}
+
+int main()
+{
+	plan_tests(TEST_COUNT);
+
+	diag("Viewer merge unit tests");
+
+	test_order();
+	test_has_head();
+	return exit_status();
+}